@@ -0,0 +1,49 @@
+#[=======================================================================[.rst:
+FindZstd
+--------
+
+Find the zstd compression library
+
+IMPORTED targets
+^^^^^^^^^^^^^^^^
+
+This module defines the following :prop_tgt:`IMPORTED` target:
+
+``Zstd::Zstd``
+
+Result variables
+^^^^^^^^^^^^^^^^
+
+This module will set the following variables if found:
+
+``ZSTD_INCLUDE_DIRS``
+  where to find zstd.h, etc.
+``ZSTD_LIBRARIES``
+  the libraries to link against to use zstd.
+``ZSTD_FOUND``
+  TRUE if found
+
+#]=======================================================================]
+
+# Look for the necessary header
+find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+mark_as_advanced(ZSTD_INCLUDE_DIR)
+
+# Look for the necessary library
+find_library(ZSTD_LIBRARY NAMES zstd)
+mark_as_advanced(ZSTD_LIBRARY)
+
+find_package_handle_standard_args(Zstd
+    REQUIRED_VARS ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+
+# Create the imported target
+if(ZSTD_FOUND)
+    set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+    set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+    if(NOT TARGET Zstd::Zstd)
+        add_library(Zstd::Zstd UNKNOWN IMPORTED)
+        set_target_properties(Zstd::Zstd PROPERTIES
+            IMPORTED_LOCATION             "${ZSTD_LIBRARY}"
+            INTERFACE_INCLUDE_DIRECTORIES "${ZSTD_INCLUDE_DIR}")
+    endif()
+endif()
@@ -40,11 +40,13 @@ enum class AggregateOp {
     USUM,
 
     COUNT,
+    COUNT_APPROX,
 };
 
 inline std::ostream& operator<<(std::ostream& os, AggregateOp op) {
     switch (op) {
         case AggregateOp::COUNT: return os << "count";
+        case AggregateOp::COUNT_APPROX: return os << "count_approx";
 
         case AggregateOp::MEAN: return os << "mean";
 
@@ -69,6 +71,7 @@ inline std::pair<uint8_t, uint8_t> aggregateArity(AggregateOp op) {
     switch (op) {
         case AggregateOp::COUNT: return {0, 0};
 
+        case AggregateOp::COUNT_APPROX:
         case AggregateOp::FMAX:
         case AggregateOp::FMIN:
         case AggregateOp::FSUM:
@@ -90,6 +93,7 @@ inline std::pair<uint8_t, uint8_t> aggregateArity(AggregateOp op) {
 inline TypeAttribute getTypeAttributeAggregate(const AggregateOp op) {
     switch (op) {
         case AggregateOp::COUNT:
+        case AggregateOp::COUNT_APPROX:
         case AggregateOp::MAX:
         case AggregateOp::MIN:
         case AggregateOp::SUM: return TypeAttribute::Signed;
@@ -114,7 +118,8 @@ inline bool isOverloadedAggregator(const AggregateOp op) {
         case AggregateOp::SUM: return true;
 
         case AggregateOp::MEAN:
-        case AggregateOp::COUNT: return false;
+        case AggregateOp::COUNT:
+        case AggregateOp::COUNT_APPROX: return false;
 
         default: return false;
     }
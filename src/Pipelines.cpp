@@ -0,0 +1,219 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Pipelines.cpp
+ *
+ * Defines the pipelines of AST and RAM transformers.
+ *
+ ***********************************************************************/
+
+#include "Pipelines.h"
+#include "Global.h"
+#include "ast/transform/AddNullariesToAtomlessAggregates.h"
+#include "ast/transform/ComponentChecker.h"
+#include "ast/transform/ComponentInstantiation.h"
+#include "ast/transform/Conditional.h"
+#include "ast/transform/ExecutionPlanChecker.h"
+#include "ast/transform/ExpandEqrels.h"
+#include "ast/transform/Fixpoint.h"
+#include "ast/transform/FlattenRecordAttributes.h"
+#include "ast/transform/FoldAnonymousRecords.h"
+#include "ast/transform/GroundWitnesses.h"
+#include "ast/transform/GroundedTermsChecker.h"
+#include "ast/transform/IOAttributes.h"
+#include "ast/transform/IODefaults.h"
+#include "ast/transform/IndexRecordFields.h"
+#include "ast/transform/InlineRelations.h"
+#include "ast/transform/MagicSet.h"
+#include "ast/transform/MaterializeAggregationQueries.h"
+#include "ast/transform/MaterializeSingletonAggregation.h"
+#include "ast/transform/MinimiseProgram.h"
+#include "ast/transform/NameUnnamedVariables.h"
+#include "ast/transform/NormaliseGenerators.h"
+#include "ast/transform/PartitionBodyLiterals.h"
+#include "ast/transform/ProfileGuidedRepresentation.h"
+#include "ast/transform/RecursiveAggregates.h"
+#include "ast/transform/ReduceExistentials.h"
+#include "ast/transform/RemoveBooleanConstraints.h"
+#include "ast/transform/RemoveEmptyRelations.h"
+#include "ast/transform/RemoveRedundantRelations.h"
+#include "ast/transform/RemoveRedundantSums.h"
+#include "ast/transform/RemoveRelationCopies.h"
+#include "ast/transform/ReorderLiterals.h"
+#include "ast/transform/ReplaceSingletonVariables.h"
+#include "ast/transform/ResolveAliases.h"
+#include "ast/transform/ResolveAnonymousRecordAliases.h"
+#include "ast/transform/SemanticChecker.h"
+#include "ast/transform/SimplifyAggregateTargetExpression.h"
+#include "ast/transform/SubsumptionQualifier.h"
+#include "ast/transform/UniqueAggregationVariables.h"
+#include "ram/transform/CollapseFilters.h"
+#include "ram/transform/Conditional.h"
+#include "ram/transform/DeltaVariants.h"
+#include "ram/transform/EliminateDuplicates.h"
+#include "ram/transform/ExpandFilter.h"
+#include "ram/transform/FuseSharedScans.h"
+#include "ram/transform/FuseStrata.h"
+#include "ram/transform/HoistAggregate.h"
+#include "ram/transform/HoistConditions.h"
+#include "ram/transform/HoistScans.h"
+#include "ram/transform/IfConversion.h"
+#include "ram/transform/IfExistsConversion.h"
+#include "ram/transform/InstrumentConditions.h"
+#include "ram/transform/IntersectConversion.h"
+#include "ram/transform/Loop.h"
+#include "ram/transform/MakeIndex.h"
+#include "ram/transform/MergeConversion.h"
+#include "ram/transform/Parallel.h"
+#include "ram/transform/RelaxSearch.h"
+#include "ram/transform/ReorderConditions.h"
+#include "ram/transform/ReorderFilterBreak.h"
+#include "ram/transform/ReportIndex.h"
+#include "ram/transform/SemiJoin.h"
+#include "ram/transform/Sequence.h"
+#include "ram/transform/TupleId.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+Own<ast::transform::PipelineTransformer> makeAstTransformer() {
+    // Equivalence pipeline
+    auto equivalencePipeline =
+            mk<ast::transform::PipelineTransformer>(mk<ast::transform::NameUnnamedVariablesTransformer>(),
+                    mk<ast::transform::FixpointTransformer>(mk<ast::transform::MinimiseProgramTransformer>()),
+                    mk<ast::transform::ReplaceSingletonVariablesTransformer>(),
+                    mk<ast::transform::RemoveRelationCopiesTransformer>(),
+                    mk<ast::transform::RemoveEmptyRelationsTransformer>(),
+                    mk<ast::transform::RemoveRedundantRelationsTransformer>());
+
+    // Magic-Set pipeline
+    auto magicPipeline = mk<ast::transform::PipelineTransformer>(mk<ast::transform::MagicSetTransformer>(),
+            mk<ast::transform::ResolveAliasesTransformer>(),
+            mk<ast::transform::RemoveRelationCopiesTransformer>(),
+            mk<ast::transform::RemoveEmptyRelationsTransformer>(),
+            mk<ast::transform::RemoveRedundantRelationsTransformer>(), clone(equivalencePipeline));
+
+    // Partitioning pipeline
+    auto partitionPipeline =
+            mk<ast::transform::PipelineTransformer>(mk<ast::transform::NameUnnamedVariablesTransformer>(),
+                    mk<ast::transform::PartitionBodyLiteralsTransformer>(),
+                    mk<ast::transform::ReplaceSingletonVariablesTransformer>());
+
+    // Provenance pipeline
+    auto provenancePipeline = mk<ast::transform::ConditionalTransformer>(Global::config().has("provenance"),
+            mk<ast::transform::PipelineTransformer>(mk<ast::transform::ExpandEqrelsTransformer>(),
+                    mk<ast::transform::NameUnnamedVariablesTransformer>()));
+
+    // Main pipeline
+    auto pipeline = mk<ast::transform::PipelineTransformer>(mk<ast::transform::ComponentChecker>(),
+            mk<ast::transform::ComponentInstantiationTransformer>(),
+            mk<ast::transform::IODefaultsTransformer>(),
+            mk<ast::transform::SimplifyAggregateTargetExpressionTransformer>(),
+            mk<ast::transform::UniqueAggregationVariablesTransformer>(),
+            mk<ast::transform::FixpointTransformer>(mk<ast::transform::PipelineTransformer>(
+                    mk<ast::transform::ResolveAnonymousRecordAliasesTransformer>(),
+                    mk<ast::transform::FoldAnonymousRecords>())),
+            mk<ast::transform::RecursiveAggregatesTransformer>(),
+            mk<ast::transform::SubsumptionQualifierTransformer>(), mk<ast::transform::SemanticChecker>(),
+            mk<ast::transform::ConditionalTransformer>(
+                    Global::config().has("profile-use") && !Global::config().has("provenance"),
+                    mk<ast::transform::ProfileGuidedRepresentationTransformer>()),
+            mk<ast::transform::GroundWitnessesTransformer>(),
+            mk<ast::transform::UniqueAggregationVariablesTransformer>(),
+            mk<ast::transform::MaterializeSingletonAggregationTransformer>(),
+            mk<ast::transform::FixpointTransformer>(
+                    mk<ast::transform::MaterializeAggregationQueriesTransformer>()),
+            mk<ast::transform::RemoveRedundantSumsTransformer>(),
+            mk<ast::transform::NormaliseGeneratorsTransformer>(),
+            mk<ast::transform::ResolveAliasesTransformer>(),
+            mk<ast::transform::RemoveBooleanConstraintsTransformer>(),
+            mk<ast::transform::ResolveAliasesTransformer>(), mk<ast::transform::MinimiseProgramTransformer>(),
+            mk<ast::transform::InlineMarkAutomaticTransform>(),
+            mk<ast::transform::InlineUnmarkExcludedTransform>(),
+            mk<ast::transform::InlineRelationsTransformer>(), mk<ast::transform::GroundedTermsChecker>(),
+            mk<ast::transform::ConditionalTransformer>(!Global::config().has("provenance"),
+                    mk<ast::transform::FlattenRecordAttributesTransformer>()),
+            mk<ast::transform::ResolveAliasesTransformer>(),
+            mk<ast::transform::RemoveRedundantRelationsTransformer>(),
+            mk<ast::transform::RemoveRelationCopiesTransformer>(),
+            mk<ast::transform::RemoveEmptyRelationsTransformer>(),
+            mk<ast::transform::ReplaceSingletonVariablesTransformer>(),
+            mk<ast::transform::FixpointTransformer>(mk<ast::transform::PipelineTransformer>(
+                    mk<ast::transform::ReduceExistentialsTransformer>(),
+                    mk<ast::transform::RemoveRedundantRelationsTransformer>())),
+            mk<ast::transform::RemoveRelationCopiesTransformer>(), std::move(partitionPipeline),
+            std::move(equivalencePipeline), mk<ast::transform::RemoveRelationCopiesTransformer>(),
+            std::move(magicPipeline), mk<ast::transform::ReorderLiteralsTransformer>(),
+            mk<ast::transform::RemoveEmptyRelationsTransformer>(),
+            mk<ast::transform::AddNullariesToAtomlessAggregatesTransformer>(),
+            mk<ast::transform::ReorderLiteralsTransformer>(),
+            mk<ast::transform::ConditionalTransformer>(!Global::config().has("provenance"),
+                    mk<ast::transform::IndexRecordFieldsTransformer>()),
+            mk<ast::transform::ExecutionPlanChecker>(), std::move(provenancePipeline),
+            mk<ast::transform::IOAttributesTransformer>());
+
+    // Disable unwanted transformations
+    if (Global::config().has("disable-transformers")) {
+        std::vector<std::string> givenTransformers =
+                splitString(Global::config().get("disable-transformers"), ',');
+        pipeline->disableTransformers(
+                std::set<std::string>(givenTransformers.begin(), givenTransformers.end()));
+    }
+    return pipeline;
+}
+
+Own<ram::transform::Transformer> makeRamTransformer() {
+    using namespace ram::transform;
+    return mk<TransformerSequence>(mk<FuseStrataTransformer>(),
+            mk<LoopTransformer>(mk<TransformerSequence>(mk<ExpandFilterTransformer>(),
+                    mk<HoistConditionsTransformer>(), mk<MakeIndexTransformer>())),
+            mk<IfConversionTransformer>(), mk<IfExistsConversionTransformer>(), mk<SemiJoinTransformer>(),
+            mk<CollapseFiltersTransformer>(), mk<TupleIdTransformer>(),
+            mk<LoopTransformer>(
+                    mk<TransformerSequence>(mk<HoistAggregateTransformer>(), mk<TupleIdTransformer>())),
+            mk<ExpandFilterTransformer>(), mk<HoistConditionsTransformer>(), mk<CollapseFiltersTransformer>(),
+            mk<EliminateDuplicatesTransformer>(), mk<HoistScansTransformer>(),
+            mk<ReorderConditionsTransformer>(),
+            mk<LoopTransformer>(mk<ReorderFilterBreak>()),
+            mk<ConditionalTransformer>(
+                    []() -> bool {
+                        return Global::config().has("profile") && Global::config().has("profile-frequency");
+                    },
+                    mk<InstrumentConditionsTransformer>()),
+            mk<ConditionalTransformer>([]() -> bool { return Global::config().has("delta-rule-variants"); },
+                    mk<DeltaVariantsTransformer>()),
+            mk<IntersectConversionTransformer>(),
+            mk<ConditionalTransformer>(
+                    []() -> bool {
+                        return Global::config().has("index-selection") &&
+                               Global::config().get("index-selection") == "cost";
+                    },
+                    mk<LoopTransformer>(mk<RelaxSearchTransformer>())),
+            mk<ConditionalTransformer>(
+                    // profiles, plans and adaptive join orders are reported per rule
+                    []() -> bool {
+                        return !Global::config().has("profile") && !Global::config().has("emit-plans") &&
+                               !Global::config().has("adaptive-join-order");
+                    },
+                    mk<FuseSharedScansTransformer>()),
+            mk<MergeConversionTransformer>(),
+            mk<ConditionalTransformer>(
+                    // job count of 0 means all cores are used.
+                    []() -> bool { return std::stoi(Global::config().get("jobs")) != 1; },
+                    mk<ParallelTransformer>()),
+            mk<ReportIndexTransformer>());
+}
+
+}  // namespace souffle
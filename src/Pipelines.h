@@ -0,0 +1,37 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Pipelines.h
+ *
+ * The pipelines of AST and RAM transformers, shared by souffle and the
+ * programs loaded by the interpreter at runtime.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ast/transform/Pipeline.h"
+#include "ram/transform/Transformer.h"
+#include "souffle/utility/MiscUtil.h"
+
+namespace souffle {
+
+/**
+ * Create the pipeline of AST transformers, checking and optimising the parsed program, without the
+ * transformers disabled by `--disable-transformers`.
+ */
+Own<ast::transform::PipelineTransformer> makeAstTransformer();
+
+/**
+ * Create the pipeline of RAM transformers, optimising the translated program.
+ */
+Own<ram::transform::Transformer> makeRamTransformer();
+
+}  // namespace souffle
@@ -35,7 +35,10 @@ enum class RelationTag {
     BRIE,          // use brie data-structure
     BTREE,         // use btree data-structure
     BTREE_DELETE,  // use btree_delete data-structure
+    COLUMNAR,      // use columnar data-structure
     EQREL,         // use union data-structure
+    SMALL,         // use inline arrays growing into btrees
+    SHARDED,       // use btrees sharded over the NUMA nodes
 };
 
 /** Space of qualifiers that a relation can have */
@@ -57,8 +60,13 @@ enum class RelationRepresentation {
     BRIE,          // use brie data-structure
     BTREE,         // use btree data-structure
     BTREE_DELETE,  // use btree_delete data-structure
+    COLUMNAR,      // use columnar data-structure
     EQREL,         // use union data-structure
     INFO,          // info relation for provenance
+    VECTOR,        // append-only vector of distinct tuples, for delta relations
+    SMALL,         // inline sorted arrays, moved into btrees once they grow
+    SHARDED,       // btrees hashed by the first attribute of their index into a shard per NUMA node
+    COUNTER,       // number of distinct tuples inserted, for relations only printed by their size
 };
 
 /**
@@ -69,7 +77,10 @@ inline bool isRelationRepresentationTag(const RelationTag& tag) {
         case RelationTag::BRIE:
         case RelationTag::BTREE:
         case RelationTag::BTREE_DELETE:
-        case RelationTag::EQREL: return true;
+        case RelationTag::COLUMNAR:
+        case RelationTag::EQREL:
+        case RelationTag::SMALL:
+        case RelationTag::SHARDED: return true;
         default: return false;
     }
 }
@@ -118,7 +129,10 @@ inline RelationRepresentation getRelationRepresentationFromTag(const RelationTag
         case RelationTag::BRIE: return RelationRepresentation::BRIE;
         case RelationTag::BTREE: return RelationRepresentation::BTREE;
         case RelationTag::BTREE_DELETE: return RelationRepresentation::BTREE_DELETE;
+        case RelationTag::COLUMNAR: return RelationRepresentation::COLUMNAR;
         case RelationTag::EQREL: return RelationRepresentation::EQREL;
+        case RelationTag::SMALL: return RelationRepresentation::SMALL;
+        case RelationTag::SHARDED: return RelationRepresentation::SHARDED;
         default: fatal("invalid relation tag");
     }
 
@@ -139,7 +153,10 @@ inline std::ostream& operator<<(std::ostream& os, RelationTag qualifier) {
         case RelationTag::BRIE: return os << "brie";
         case RelationTag::BTREE: return os << "btree";
         case RelationTag::BTREE_DELETE: return os << "btree_delete";
+        case RelationTag::COLUMNAR: return os << "columnar";
         case RelationTag::EQREL: return os << "eqrel";
+        case RelationTag::SMALL: return os << "small";
+        case RelationTag::SHARDED: return os << "sharded";
     }
 
     UNREACHABLE_BAD_CASE_ANALYSIS
@@ -166,8 +183,13 @@ inline std::ostream& operator<<(std::ostream& os, RelationRepresentation represe
         case RelationRepresentation::BTREE: return os << "btree";
         case RelationRepresentation::BTREE_DELETE: return os << "btree_delete";
         case RelationRepresentation::BRIE: return os << "brie";
+        case RelationRepresentation::COLUMNAR: return os << "columnar";
         case RelationRepresentation::EQREL: return os << "eqrel";
         case RelationRepresentation::INFO: return os << "info";
+        case RelationRepresentation::VECTOR: return os << "vector";
+        case RelationRepresentation::SMALL: return os << "small";
+        case RelationRepresentation::SHARDED: return os << "sharded";
+        case RelationRepresentation::COUNTER: return os << "counter";
         case RelationRepresentation::DEFAULT: return os;
     }
 
@@ -20,6 +20,7 @@
 #include "reports/ErrorReport.h"
 #include "souffle/utility/DynamicCasting.h"
 #include "souffle/utility/Types.h"
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <memory>
@@ -28,6 +29,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace souffle::detail {
 
@@ -82,13 +84,19 @@ struct TranslationUnitBase {
     A& getAnalysis() const {
         static_assert(std::is_same_v<char const* const, decltype(A::name)>,
                 "`name` member must be a static literal");
+        // the analysis being computed depends on the requested one
+        if (!running.empty()) {
+            dependencies[running.back()].insert(A::name);
+        }
         auto it = analyses.find(A::name);
         if (it == analyses.end()) {
             it = analyses.insert({A::name, mk<A>()}).first;
 
             auto& analysis = *it->second;
             assert(analysis.getName() == A::name && "must be same pointer");
+            running.push_back(A::name);
             analysis.run(static_cast<Impl const&>(*this));
+            running.pop_back();
             logAnalysis(analysis);
         }
 
@@ -107,6 +115,43 @@ struct TranslationUnitBase {
     /** @brief Invalidate all alive analyses of the translation unit */
     void invalidateAnalyses() {
         analyses.clear();
+        dependencies.clear();
+    }
+
+    /**
+     * @brief Invalidate the alive analyses of the translation unit but the preserved ones
+     *
+     * A preserved analysis is invalidated nevertheless if an analysis it used
+     * while it was computed is invalidated, since it may refer to its results.
+     */
+    void invalidateAnalyses(const std::set<std::string>& preserved) {
+        std::set<std::string> kept;
+        for (const auto& [name, analysis] : analyses) {
+            if (preserved.count(name) > 0) {
+                kept.insert(name);
+            }
+        }
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (auto it = kept.begin(); it != kept.end();) {
+                const auto& used = dependencies[*it];
+                if (std::all_of(used.begin(), used.end(),
+                            [&](const std::string& dep) { return kept.count(dep) > 0; })) {
+                    ++it;
+                } else {
+                    it = kept.erase(it);
+                    changed = true;
+                }
+            }
+        }
+        for (auto it = analyses.begin(); it != analyses.end();) {
+            if (kept.count(it->first) > 0) {
+                ++it;
+            } else {
+                dependencies.erase(it->first);
+                it = analyses.erase(it);
+            }
+        }
     }
 
     /** @brief Get the RAM Program of the translation unit  */
@@ -133,6 +178,12 @@ protected:
     //       Using `std::string` appears to suppress the issue (bug?).
     mutable std::map<std::string, Own<Analysis>> analyses;
 
+    /* Analyses used by each cached analysis while it was computed */
+    mutable std::map<std::string, std::set<std::string>> dependencies;
+
+    /* Analyses being computed, innermost last */
+    mutable std::vector<std::string> running;
+
     /* RAM program */
     Own<Program> program;
 
@@ -20,6 +20,7 @@ std::ostream& operator<<(std::ostream& os, DirectiveType e) {
         case DirectiveType::output: return os << "output";
         case DirectiveType::printsize: return os << "printsize";
         case DirectiveType::limitsize: return os << "limitsize";
+        case DirectiveType::goal: return os << "goal";
     }
 
     UNREACHABLE_BAD_CASE_ANALYSIS
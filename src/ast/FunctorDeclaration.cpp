@@ -18,13 +18,16 @@
 
 namespace souffle::ast {
 
-FunctorDeclaration::FunctorDeclaration(
-        std::string name, VecOwn<Attribute> params, Own<Attribute> returnType, bool stateful, SrcLocation loc)
+FunctorDeclaration::FunctorDeclaration(std::string name, VecOwn<Attribute> params, Own<Attribute> returnType,
+        bool stateful, bool threadLocal, bool cached, SrcLocation loc)
         : Node(std::move(loc)), name(std::move(name)), params(std::move(params)),
-          returnType(std::move(returnType)), stateful(stateful) {
+          returnType(std::move(returnType)), stateful(stateful), threadLocal(threadLocal),
+          cached(cached) {
     assert(this->name.length() > 0 && "functor name is empty");
     assert(allValidPtrs(this->params));
     assert(this->returnType != nullptr);
+    assert((stateful || !threadLocal) && "only stateful functors have thread-local contexts");
+    assert(!(threadLocal && cached) && "functors with thread-local contexts are not cached");
 }
 
 void FunctorDeclaration::print(std::ostream& out) const {
@@ -36,17 +39,24 @@ void FunctorDeclaration::print(std::ostream& out) const {
     if (stateful) {
         out << " stateful";
     }
+    if (threadLocal) {
+        out << " thread_local";
+    }
+    if (cached) {
+        out << " cached";
+    }
     out << std::endl;
 }
 
 bool FunctorDeclaration::equal(const Node& node) const {
     const auto& other = asAssert<FunctorDeclaration>(node);
     return name == other.name && params == other.params && returnType == other.returnType &&
-           stateful == other.stateful;
+           stateful == other.stateful && threadLocal == other.threadLocal && cached == other.cached;
 }
 
 FunctorDeclaration* FunctorDeclaration::cloning() const {
-    return new FunctorDeclaration(name, clone(params), clone(returnType), stateful, getSrcLoc());
+    return new FunctorDeclaration(
+            name, clone(params), clone(returnType), stateful, threadLocal, cached, getSrcLoc());
 }
 
 }  // namespace souffle::ast
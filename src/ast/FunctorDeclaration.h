@@ -37,7 +37,7 @@ namespace souffle::ast {
 class FunctorDeclaration : public Node {
 public:
     FunctorDeclaration(std::string name, VecOwn<Attribute> params, Own<Attribute> returnType, bool stateful,
-            SrcLocation loc = {});
+            bool threadLocal, bool cached, SrcLocation loc = {});
 
     /** Return name */
     const std::string& getName() const {
@@ -64,6 +64,16 @@ public:
         return stateful;
     }
 
+    /** Check whether a stateful functor keeps a context per thread */
+    bool isThreadLocal() const {
+        return threadLocal;
+    }
+
+    /** Check whether the results of the functor are cached by its arguments */
+    bool isCached() const {
+        return cached;
+    }
+
 protected:
     void print(std::ostream& out) const override;
 
@@ -84,6 +94,12 @@ private:
 
     /** Stateful flag */
     const bool stateful;
+
+    /** Thread-local context flag */
+    const bool threadLocal;
+
+    /** Result cache flag */
+    const bool cached;
 };
 
 }  // namespace souffle::ast
@@ -36,6 +36,14 @@ bool FunctorAnalysis::isStatefulFunctor(const UserDefinedFunctor& functor) const
     return getFunctorDeclaration(functor).isStateful();
 }
 
+bool FunctorAnalysis::isThreadLocalFunctor(const UserDefinedFunctor& functor) const {
+    return getFunctorDeclaration(functor).isThreadLocal();
+}
+
+bool FunctorAnalysis::isCachedFunctor(const UserDefinedFunctor& functor) const {
+    return getFunctorDeclaration(functor).isCached();
+}
+
 QualifiedName const& FunctorAnalysis::getFunctorReturnType(const UserDefinedFunctor& functor) const {
     return getFunctorDeclaration(functor).getReturnType().getTypeName();
 }
@@ -50,6 +50,8 @@ public:
     std::size_t getFunctorArity(UserDefinedFunctor const& functor) const;
     QualifiedName const& getFunctorReturnType(const UserDefinedFunctor& functor) const;
     bool isStatefulFunctor(const UserDefinedFunctor& functor) const;
+    bool isThreadLocalFunctor(const UserDefinedFunctor& functor) const;
+    bool isCachedFunctor(const UserDefinedFunctor& functor) const;
     const FunctorDeclaration& getFunctorDeclaration(const UserDefinedFunctor& functor) const;
 
     /** Return whether a UDF is stateful */
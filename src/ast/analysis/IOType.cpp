@@ -15,6 +15,7 @@
  ***********************************************************************/
 
 #include "ast/analysis/IOType.h"
+#include "Global.h"
 #include "ast/Directive.h"
 #include "ast/Program.h"
 #include "ast/QualifiedName.h"
@@ -23,8 +24,10 @@
 #include "ast/utility/Utils.h"
 #include "ast/utility/Visitor.h"
 #include "souffle/utility/StreamUtil.h"
+#include "souffle/utility/StringUtil.h"
 #include <cassert>
 #include <ostream>
+#include <string>
 #include <vector>
 
 namespace souffle::ast::analysis {
@@ -48,8 +51,23 @@ void IOTypeAnalysis::run(const TranslationUnit& translationUnit) {
                 assert(directive.hasParameter("n") && "limitsize has no n directive");
                 limitSize[relation] = stoi(directive.getParameter("n"));
                 break;
+            // goal relations are computed and kept like outputs, to be checked during the evaluation
+            case ast::DirectiveType::goal:
+                goalRelations.insert(relation);
+                outputRelations.insert(relation);
+                break;
         }
     });
+
+    // queried relations are computed and kept like outputs, for the queries after the evaluation
+    for (const auto& entry : splitString(Global::config().get("query-relations"), ',')) {
+        const std::string relationName = entry.substr(0, entry.find(':'));
+        auto* relation = program.getRelation(QualifiedName(splitString(relationName, '.')));
+        if (relation != nullptr) {
+            queriedRelations.insert(relation);
+            outputRelations.insert(relation);
+        }
+    }
 }
 
 void IOTypeAnalysis::print(std::ostream& os) const {
@@ -58,6 +76,8 @@ void IOTypeAnalysis::print(std::ostream& os) const {
     os << "output relations: {" << join(outputRelations, ", ", show) << "}\n";
     os << "printsize relations: {" << join(printSizeRelations, ", ", show) << "}\n";
     os << "limitsize relations: {" << join(limitSizeRelations, ", ", show) << "}\n";
+    os << "queried relations: {" << join(queriedRelations, ", ", show) << "}\n";
+    os << "goal relations: {" << join(goalRelations, ", ", show) << "}\n";
 }
 
 }  // namespace souffle::ast::analysis
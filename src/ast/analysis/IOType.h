@@ -64,6 +64,20 @@ public:
             return 0;
     }
 
+    /** Queried relations are kept resident after the evaluation, see `query-relations` */
+    bool isQueried(const Relation* relation) const {
+        return queriedRelations.count(relation) != 0;
+    }
+
+    /** Evaluation stops once any goal relation is non-empty, see `.goal` */
+    bool isGoal(const Relation* relation) const {
+        return goalRelations.count(relation) != 0;
+    }
+
+    bool hasGoals() const {
+        return !goalRelations.empty();
+    }
+
     bool isIO(const Relation* relation) const {
         return isInput(relation) || isOutput(relation) || isPrintSize(relation);
     }
@@ -73,6 +87,8 @@ private:
     std::set<const Relation*> outputRelations;
     std::set<const Relation*> printSizeRelations;
     std::set<const Relation*> limitSizeRelations;
+    std::set<const Relation*> queriedRelations;
+    std::set<const Relation*> goalRelations;
     std::map<const Relation*, std::size_t> limitSize;
 };
 
@@ -59,4 +59,11 @@ std::size_t ProfileUseAnalysis::getRelationSize(const QualifiedName& rel) const
     }
 }
 
+/**
+ * Get the profile of a relation
+ */
+const profile::Relation* ProfileUseAnalysis::getProfiledRelation(const QualifiedName& rel) const {
+    return programRun->getRelation(rel.toString());
+}
+
 }  // namespace souffle::ast::analysis
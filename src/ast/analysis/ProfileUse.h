@@ -20,6 +20,7 @@
 #include "ast/QualifiedName.h"
 #include "ast/TranslationUnit.h"
 #include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Relation.h"
 #include <cstddef>
 #include <iostream>
 #include <memory>
@@ -53,6 +54,12 @@ public:
     /** Return size of relation in the profile */
     std::size_t getRelationSize(const QualifiedName& rel) const;
 
+    /**
+     * Return the profile of a relation, holding the accesses of its indexes and the values of its
+     * columns, or nullptr if the relation is not in the profile
+     */
+    const profile::Relation* getProfiledRelation(const QualifiedName& rel) const;
+
 private:
     /** performance model of profile run */
     std::shared_ptr<profile::ProgramRun> programRun;
@@ -39,9 +39,10 @@ void RedundantRelationsAnalysis::run(const TranslationUnit& translationUnit) {
     Program& program = translationUnit.getProgram();
 
     const std::vector<Relation*>& relations = program.getRelations();
-    /* Add all output relations to the work set */
+    /* Add all output relations to the work set, or only the goal and queried relations if there are
+       goals, such that the relations the goals do not depend on are not computed */
     for (const Relation* r : relations) {
-        if (ioType.isOutput(r)) {
+        if (ioType.hasGoals() ? ioType.isGoal(r) || ioType.isQueried(r) : ioType.isOutput(r)) {
             work.insert(r);
         }
     }
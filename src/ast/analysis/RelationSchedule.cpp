@@ -18,9 +18,11 @@
 
 #include "ast/analysis/RelationSchedule.h"
 #include "GraphUtils.h"
+#include "ast/Program.h"
 #include "ast/QualifiedName.h"
 #include "ast/Relation.h"
 #include "ast/TranslationUnit.h"
+#include "ast/analysis/IOType.h"
 #include "ast/analysis/PrecedenceGraph.h"
 #include "ast/analysis/SCCGraph.h"
 #include "ast/analysis/TopologicallySortedSCCGraph.h"
@@ -37,6 +39,10 @@ void RelationScheduleAnalysisStep::print(std::ostream& os) const {
     for (const Relation* compRel : computed()) {
         os << compRel->getQualifiedName() << ", ";
     }
+    os << "\nread: ";
+    for (const Relation* readRel : read()) {
+        os << readRel->getQualifiedName() << ", ";
+    }
     os << "\nexpired: ";
     for (const Relation* compRel : expired()) {
         os << compRel->getQualifiedName() << ", ";
@@ -63,7 +69,15 @@ void RelationScheduleAnalysis::run(const TranslationUnit& translationUnit) {
         auto scc = topsortSCCGraphAnalysis->order()[i];
         const std::set<const Relation*> computedRelations =
                 translationUnit.getAnalysis<SCCGraphAnalysis>().getInternalRelations(scc);
-        relationSchedule.emplace_back(computedRelations, relationExpirySchedule[i],
+        std::set<const Relation*> readRelations;
+        for (const Relation* r : computedRelations) {
+            for (const Relation* predecessor : precedenceGraph->graph().predecessors(r)) {
+                if (computedRelations.count(predecessor) == 0) {
+                    readRelations.insert(predecessor);
+                }
+            }
+        }
+        relationSchedule.emplace_back(computedRelations, std::move(readRelations), relationExpirySchedule[i],
                 translationUnit.getAnalysis<SCCGraphAnalysis>().isRecursive(scc));
     }
 }
@@ -75,32 +89,47 @@ std::vector<std::set<const Relation*>> RelationScheduleAnalysis::computeRelation
        of evaluating the SCC the set of alive relations. */
     std::size_t numSCCs = topsortSCCGraphAnalysis->order().size();
 
-    /* Alive set for each step */
-    std::vector<std::set<const Relation*>> alive(numSCCs);
+    /* Alive set for each step, i.e., the relations read by the current and the subsequent steps */
+    std::vector<std::set<const Relation*>> alive(numSCCs + 1);
     /* Resize expired relations sets */
     relationExpirySchedule.resize(numSCCs);
     const auto& sccGraph = translationUnit.getAnalysis<SCCGraphAnalysis>();
+    const auto& ioType = translationUnit.getAnalysis<IOTypeAnalysis>();
+
+    /* Queried relations stay alive after the last step */
+    for (const Relation* r : translationUnit.getProgram().getRelations()) {
+        if (ioType.isQueried(r)) {
+            alive[0].insert(r);
+        }
+    }
 
     /* Compute all alive relations by iterating over all steps in reverse order
        determine the dependencies */
-    for (std::size_t orderedSCC = 1; orderedSCC < numSCCs; orderedSCC++) {
+    for (std::size_t orderedSCC = 1; orderedSCC <= numSCCs; orderedSCC++) {
         /* Add alive set of previous step */
         alive[orderedSCC].insert(alive[orderedSCC - 1].begin(), alive[orderedSCC - 1].end());
 
         /* Add predecessors of relations computed in this step */
-        auto scc = topsortSCCGraphAnalysis->order()[numSCCs - orderedSCC];
+        std::size_t step = numSCCs - orderedSCC;
+        auto scc = topsortSCCGraphAnalysis->order()[step];
         for (const Relation* r : sccGraph.getInternalRelations(scc)) {
             for (const Relation* predecessor : precedenceGraph->graph().predecessors(r)) {
                 alive[orderedSCC].insert(predecessor);
             }
         }
 
+        /* Relations computed in this step but never read expire right away, unless they are outputs */
+        for (const Relation* r : sccGraph.getInternalRelations(scc)) {
+            if (alive[orderedSCC].count(r) == 0 && !ioType.isOutput(r)) {
+                relationExpirySchedule[step].insert(r);
+            }
+        }
+
         /* Compute expired relations in reverse topological order using the set difference of the alive sets
            between steps. */
         std::set_difference(alive[orderedSCC].begin(), alive[orderedSCC].end(), alive[orderedSCC - 1].begin(),
                 alive[orderedSCC - 1].end(),
-                std::inserter(relationExpirySchedule[numSCCs - orderedSCC],
-                        relationExpirySchedule[numSCCs - orderedSCC].end()));
+                std::inserter(relationExpirySchedule[step], relationExpirySchedule[step].end()));
     }
 
     return relationExpirySchedule;
@@ -31,20 +31,26 @@
 namespace souffle::ast::analysis {
 
 /**
- * A single step in a relation schedule, consisting of the relations computed in the step
- * and the relations that are no longer required at that step.
+ * A single step in a relation schedule, consisting of the relations computed in the step,
+ * the relations read by the step, and the relations that are no longer required at that step.
  */
 class RelationScheduleAnalysisStep {
 public:
     RelationScheduleAnalysisStep(std::set<const Relation*> computedRelations,
-            std::set<const Relation*> expiredRelations, const bool isRecursive)
-            : computedRelations(std::move(computedRelations)), expiredRelations(std::move(expiredRelations)),
-              isRecursive(isRecursive) {}
+            std::set<const Relation*> readRelations, std::set<const Relation*> expiredRelations,
+            const bool isRecursive)
+            : computedRelations(std::move(computedRelations)), readRelations(std::move(readRelations)),
+              expiredRelations(std::move(expiredRelations)), isRecursive(isRecursive) {}
 
     const std::set<const Relation*>& computed() const {
         return computedRelations;
     }
 
+    /** Relations computed in previous steps that are read by this step */
+    const std::set<const Relation*>& read() const {
+        return readRelations;
+    }
+
     const std::set<const Relation*>& expired() const {
         return expiredRelations;
     }
@@ -63,6 +69,7 @@ public:
 
 private:
     std::set<const Relation*> computedRelations;
+    std::set<const Relation*> readRelations;
     std::set<const Relation*> expiredRelations;
     const bool isRecursive;
 };
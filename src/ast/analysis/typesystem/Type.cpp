@@ -56,6 +56,11 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace souffle::ast::analysis {
 
@@ -482,6 +487,19 @@ void TypeAnalysis::run(const TranslationUnit& translationUnit) {
     // Analyse user-defined functor types
     const Program& program = translationUnit.getProgram();
 
+    // Clauses are analysed independently, so large programs analyse them in parallel, unless the
+    // analysis of each clause is logged. The analyses used by the analysis of a clause are created
+    // beforehand, since creating an analysis is not thread-safe.
+    const std::string& jobs = Global::config().get("jobs");
+    int threads = isNumber(jobs.c_str()) ? std::stoi(jobs) : 1;
+#ifdef _OPENMP
+    if (threads == 0) {
+        threads = omp_get_max_threads();
+    }
+#endif
+    const bool parallel = threads > 1 && debugStream == nullptr;
+    translationUnit.getAnalysis<SumTypeBranchesAnalysis>();
+
     // Rest of the analysis done until fixpoint reached
     bool changed = true;
     while (changed) {
@@ -489,13 +507,20 @@ void TypeAnalysis::run(const TranslationUnit& translationUnit) {
         argumentTypes.clear();
 
         // Analyse general argument types, clause by clause.
-        for (const Clause* clause : program.getClauses()) {
-            auto clauseArgumentTypes = analyseTypes(translationUnit, *clause, debugStream);
-            argumentTypes.insert(clauseArgumentTypes.begin(), clauseArgumentTypes.end());
+        const auto clauses = program.getClauses();
+        std::vector<std::map<const Argument*, TypeSet>> clauseArgumentTypes(clauses.size());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) schedule(dynamic) if (parallel)
+#endif
+        for (std::size_t i = 0; i < clauses.size(); i++) {
+            clauseArgumentTypes[i] = analyseTypes(translationUnit, *clauses[i], debugStream);
+        }
+        for (std::size_t i = 0; i < clauses.size(); i++) {
+            argumentTypes.insert(clauseArgumentTypes[i].begin(), clauseArgumentTypes[i].end());
 
             if (debugStream != nullptr) {
                 // Store an annotated clause for printing purposes
-                annotatedClauses.emplace_back(createAnnotatedClause(clause, clauseArgumentTypes));
+                annotatedClauses.emplace_back(createAnnotatedClause(clauses[i], clauseArgumentTypes[i]));
             }
         }
 
@@ -232,16 +232,19 @@ void TypeConstraintsAnalysis::visit_(type_identity<BranchInit>, const BranchInit
 }
 
 void TypeConstraintsAnalysis::visit_(type_identity<Aggregator>, const Aggregator& agg) {
-    if (agg.getBaseOperator() == AggregateOp::COUNT) {
+    const AggregateOp op = agg.getBaseOperator();
+    if (op == AggregateOp::COUNT || op == AggregateOp::COUNT_APPROX) {
         addConstraint(isSubtypeOf(getVar(agg), typeEnv.getConstantType(TypeAttribute::Signed)));
-    } else if (agg.getBaseOperator() == AggregateOp::MEAN) {
+    } else if (op == AggregateOp::MEAN) {
         addConstraint(isSubtypeOf(getVar(agg), typeEnv.getConstantType(TypeAttribute::Float)));
     } else {
         addConstraint(hasSuperTypeInSet(getVar(agg), typeEnv.getConstantNumericTypes()));
     }
 
     // If there is a target expression - it should be of the same type as the aggregator.
-    if (auto expr = agg.getTargetExpression()) {
+    // The values counted approximately may be of any type.
+    auto expr = agg.getTargetExpression();
+    if (expr != nullptr && op != AggregateOp::COUNT_APPROX) {
         addConstraint(isSubtypeOf(getVar(expr), getVar(agg)));
         addConstraint(isSubtypeOf(getVar(agg), getVar(expr)));
     }
@@ -16,6 +16,8 @@
 
 #include "tests/test.h"
 
+#include "Global.h"
+#include "RelationTag.h"
 #include "ast/Clause.h"
 #include "ast/Node.h"
 #include "ast/Program.h"
@@ -23,8 +25,16 @@
 #include "ast/Relation.h"
 #include "ast/TranslationUnit.h"
 #include "ast/analysis/ClauseNormalisation.h"
+#include "ast/analysis/IOType.h"
+#include "ast/analysis/PrecedenceGraph.h"
+#include "ast/analysis/SCCGraph.h"
+#include "ast/analysis/typesystem/SumTypeBranches.h"
+#include "ast/analysis/typesystem/TypeEnvironment.h"
+#include "ast/transform/FlattenRecordAttributes.h"
+#include "ast/transform/IndexRecordFields.h"
 #include "ast/transform/MagicSet.h"
 #include "ast/transform/MinimiseProgram.h"
+#include "ast/transform/ProfileGuidedRepresentation.h"
 #include "ast/transform/RemoveRedundantRelations.h"
 #include "ast/transform/RemoveRelationCopies.h"
 #include "ast/transform/ResolveAliases.h"
@@ -32,8 +42,12 @@
 #include "parser/ParserDriver.h"
 #include "reports/DebugReport.h"
 #include "reports/ErrorReport.h"
+#include "souffle/profile/ProfileDatabase.h"
 #include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/FileUtil.h"
 #include "souffle/utility/StringUtil.h"
+#include <cstdio>
+#include <fstream>
 #include <map>
 #include <memory>
 #include <set>
@@ -148,6 +162,77 @@ TEST(Transformers, ResolveAliasesWithTermsInAtoms) {
             toString(*program.getClauses("p")[0]));
 }
 
+TEST(Transformers, IndexRecordFields) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    Own<TranslationUnit> tu = ParserDriver::parseTranslationUnit(
+            R"(
+                .type R = [a:number, b:number]
+                .decl r(x:R, y:number)
+                .decl s(b:number)
+                .decl t(y:number)
+
+                t(c) :- s(b), r([a,b],c).
+                t(c) :- r([a,b],c), s(b).
+                t(c) :- s(a), r([a,1],c).
+            )",
+            errorReport, debugReport);
+
+    Program& program = tu->getProgram();
+    mk<IndexRecordFieldsTransformer>()->apply(*tu);
+
+    // fields bound by preceding atoms are keyed, either by variables or constants
+    auto clauses = program.getClauses("t");
+    EXPECT_EQ(3, clauses.size());
+    EXPECT_EQ("t(c) :- \n   s(b),\n   @record_index_r([a,b],c,b).", toString(*clauses[0]));
+    EXPECT_EQ("t(c) :- \n   r([a,b],c),\n   s(b).", toString(*clauses[1]));
+    EXPECT_EQ("t(c) :- \n   s(a),\n   @record_index_r0([a,1],c,a,1).", toString(*clauses[2]));
+
+    EXPECT_EQ(5, program.getRelations().size());
+    EXPECT_EQ("@record_index_r([@f0_0,@f0_1],@x1,@f0_1) :- \n   r([@f0_0,@f0_1],@x1).",
+            toString(*program.getClauses("@record_index_r")[0]));
+}
+
+TEST(Transformers, FlattenRecordAttributes) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    Own<TranslationUnit> tu = ParserDriver::parseTranslationUnit(
+            R"(
+                .type Point = [x:number, y:number]
+                .type List = [head:number, tail:List]
+                .decl s(x:number, y:number)
+                .decl r(p:Point, c:number)
+                .decl q(p:Point)
+                .decl l(x:List)
+                .decl t(c:number, p:Point)
+                .output t
+
+                r([x, y], x) :- s(x, y).
+                q(p) :- r(p, _).
+                q(nil) :- s(_, _).
+                t(c, p) :- r(p, c), !q(p).
+                l([x, nil]) :- s(x, _).
+            )",
+            errorReport, debugReport);
+
+    Program& program = tu->getProgram();
+    EXPECT_TRUE(mk<FlattenRecordAttributesTransformer>()->apply(*tu));
+
+    // only r is flattened: q may hold nil, t is an output and l is recursive
+    const auto attributes = program.getRelation("r")->getAttributes();
+    EXPECT_EQ(3, attributes.size());
+    EXPECT_EQ("@p_0", attributes[0]->getName());
+    EXPECT_EQ("number", toString(attributes[1]->getTypeName()));
+    EXPECT_EQ(1, program.getRelation("q")->getAttributes().size());
+    EXPECT_EQ(1, program.getRelation("l")->getAttributes().size());
+
+    // records are packed from their fields where they are used otherwise
+    EXPECT_EQ("r(x,y,x) :- \n   s(x,y).", toString(*program.getClauses("r")[0]));
+    EXPECT_EQ("q(p) :- \n   r(@p_0,@p_1,_),\n   p = [@p_0,@p_1].", toString(*program.getClauses("q")[0]));
+    EXPECT_EQ("t(c,p) :- \n   r(@p_0,@p_1,c),\n   !q(p),\n   p = [@p_0,@p_1].",
+            toString(*program.getClauses("t")[0]));
+}
+
 /**
  * Test that copies of relations are removed by RemoveRelationCopiesTransformer
  *
@@ -238,6 +323,55 @@ TEST(Transformers, RemoveRelationCopiesOutput) {
     EXPECT_EQ(3, program.getRelations().size());
 }
 
+/**
+ * Test that analyses preserved by a transformer survive its changes, unless they were computed from
+ * invalidated analyses
+ */
+TEST(Transformers, PreservedAnalyses) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    Own<TranslationUnit> tu = ParserDriver::parseTranslationUnit(
+            R"(
+                .type D = number
+                .type T = A {} | B {x:D}
+                .decl a(a:D,b:D)
+                .decl b(a:D,b:D)
+                .decl c(a:D,b:D)
+                .output c
+
+                a(1,2).
+                b(x,y) :- a(x,y).
+                c(x,y) :- b(x,y).
+            )",
+            errorReport, debugReport);
+
+    auto getAliveNames = [&]() {
+        std::set<std::string> names;
+        for (const auto* analysis : tu->getAliveAnalyses()) {
+            names.insert(analysis->getName());
+        }
+        return names;
+    };
+
+    tu->getAnalysis<SumTypeBranchesAnalysis>();
+    tu->getAnalysis<SCCGraphAnalysis>();
+    EXPECT_TRUE(contains(getAliveNames(), TypeEnvironmentAnalysis::name));
+    EXPECT_TRUE(contains(getAliveNames(), PrecedenceGraphAnalysis::name));
+
+    // removing the copy b drops the analyses of the dependencies between relations only
+    EXPECT_TRUE(RemoveRelationCopiesTransformer().apply(*tu));
+    const auto alive = getAliveNames();
+    EXPECT_TRUE(contains(alive, SumTypeBranchesAnalysis::name));
+    EXPECT_TRUE(contains(alive, TypeEnvironmentAnalysis::name));
+    EXPECT_FALSE(contains(alive, SCCGraphAnalysis::name));
+    EXPECT_FALSE(contains(alive, PrecedenceGraphAnalysis::name));
+    EXPECT_FALSE(contains(alive, IOTypeAnalysis::name));
+
+    // the sum type branches refer to the type environment, hence do not outlive it
+    tu->invalidateAnalyses({SumTypeBranchesAnalysis::name});
+    EXPECT_TRUE(getAliveNames().empty());
+}
+
 /**
  * Test the equivalence (or lack of equivalence) of clauses using the MinimiseProgramTransfomer.
  */
@@ -783,4 +917,66 @@ TEST(Transformers, MagicSetComprehensive) {
     });
     checkRelMapEq(finalProgram, mappifyRelations(program));
 }
+
+TEST(Transformers, ProfileGuidedRepresentation) {
+    // the profile of a run holding the sizes of the relations and the values of their columns
+    profile::ProfileDatabase db;
+    db.addSizeEntry({"program", "relation", "eq", "num-tuples"}, 5000);
+    db.addSizeEntry({"program", "relation", "same", "num-tuples"}, 10);
+    db.addSizeEntry({"program", "relation", "dense", "num-tuples"}, 200000);
+    db.addSizeEntry({"program", "relation", "sparse", "num-tuples"}, 200000);
+    for (const std::string column : {"0", "1", "2"}) {
+        db.addSizeEntry({"program", "relation", "dense", "column", column, "distinct"}, 100);
+        db.addSizeEntry({"program", "relation", "dense", "column", column, "range"}, 100);
+        db.addSizeEntry({"program", "relation", "sparse", "column", column, "distinct"}, 100000);
+        db.addSizeEntry({"program", "relation", "sparse", "column", column, "range"}, 1000000);
+    }
+    const std::string fileName = tempFile();
+    {
+        std::ofstream file(fileName);
+        db.print(file);
+    }
+    Global::config().set("profile-use", fileName);
+
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    Own<TranslationUnit> tu = ParserDriver::parseTranslationUnit(
+            R"(
+                .decl e(a:number, b:number)
+                .decl eq(a:number, b:number)
+                eq(x,y) :- e(x,y).
+                eq(x,y) :- eq(y,x).
+                eq(x,z) :- eq(y,z), eq(x,y).
+                eq(x,x) :- eq(x,_).
+
+                .decl same(a:number, b:number)
+                same(x,y) :- e(x,y).
+                same(x,y) :- same(y,x).
+                same(x,z) :- same(x,y), same(y,z).
+
+                .decl dense(a:number, b:number, c:number)
+                dense(x,y,z) :- e(x,y), e(y,z).
+                .decl sparse(a:number, b:number, c:number)
+                sparse(x,y,z) :- e(x,y), e(y,z).
+                .decl fixed(a:number, b:number, c:number) btree
+                fixed(x,y,z) :- e(x,y), e(y,z).
+            )",
+            errorReport, debugReport);
+    Program& program = tu->getProgram();
+
+    EXPECT_TRUE(ProfileGuidedRepresentationTransformer().apply(*tu));
+    EXPECT_EQ(RelationRepresentation::EQREL, program.getRelation("eq")->getRepresentation());
+    EXPECT_EQ(RelationRepresentation::DEFAULT, program.getRelation("same")->getRepresentation());
+    EXPECT_EQ(RelationRepresentation::BRIE, program.getRelation("dense")->getRepresentation());
+    EXPECT_EQ(RelationRepresentation::DEFAULT, program.getRelation("sparse")->getRepresentation());
+    EXPECT_EQ(RelationRepresentation::BTREE, program.getRelation("fixed")->getRepresentation());
+
+    // the clauses implied by the eqrel are removed, unlike those of the small equivalence relation
+    EXPECT_EQ(1, program.getClauses("eq").size());
+    EXPECT_EQ(3, program.getClauses("same").size());
+
+    Global::config().unset("profile-use");
+    std::remove(fileName.c_str());
+}
+
 }  // namespace souffle::ast::transform::test
@@ -63,14 +63,12 @@ struct ComponentContent {
 
     void add(Own<ast::Type>& type, ErrorReport& report) {
         // add to result content (check existence first)
-        auto foundItem = std::find_if(types.begin(), types.end(), [&](const Own<ast::Type>& element) {
-            return (element->getQualifiedName() == type->getQualifiedName());
-        });
-        if (foundItem != types.end()) {
+        auto [foundItem, added] = typeIndex.emplace(type->getQualifiedName(), type.get());
+        if (!added) {
             Diagnostic err(Diagnostic::Type::ERROR,
                     DiagnosticMessage(
                             "Redefinition of type " + toString(type->getQualifiedName()), type->getSrcLoc()),
-                    {DiagnosticMessage("Previous definition", (*foundItem)->getSrcLoc())});
+                    {DiagnosticMessage("Previous definition", foundItem->second->getSrcLoc())});
             report.addDiagnostic(err);
         }
         types.push_back(std::move(type));
@@ -78,14 +76,12 @@ struct ComponentContent {
 
     void add(Own<Relation>& rel, ErrorReport& report) {
         // add to result content (check existence first)
-        auto foundItem = std::find_if(relations.begin(), relations.end(), [&](const Own<Relation>& element) {
-            return (element->getQualifiedName() == rel->getQualifiedName());
-        });
-        if (foundItem != relations.end()) {
+        auto [foundItem, added] = relationIndex.emplace(rel->getQualifiedName(), rel.get());
+        if (!added) {
             Diagnostic err(Diagnostic::Type::ERROR,
                     DiagnosticMessage("Redefinition of relation " + toString(rel->getQualifiedName()),
                             rel->getSrcLoc()),
-                    {DiagnosticMessage("Previous definition", (*foundItem)->getSrcLoc())});
+                    {DiagnosticMessage("Previous definition", foundItem->second->getSrcLoc())});
             report.addDiagnostic(err);
         }
         relations.push_back(std::move(rel));
@@ -97,25 +93,30 @@ struct ComponentContent {
 
     void add(Own<Directive>& newDirective, ErrorReport& report) {
         // Check if directive already exists
-        auto foundItem =
-                std::find_if(directives.begin(), directives.end(), [&](const Own<Directive>& directive) {
-                    return directive->getQualifiedName() == newDirective->getQualifiedName();
-                });
+        auto [foundItem, added] =
+                directiveIndex.emplace(newDirective->getQualifiedName(), newDirective.get());
         // if yes, add error
-        if (foundItem != directives.end()) {
-            auto type = (*foundItem)->getType();
+        if (!added) {
+            auto type = foundItem->second->getType();
             if (type == newDirective->getType() && newDirective->getType() != ast::DirectiveType::output) {
                 Diagnostic err(Diagnostic::Type::ERROR,
                         DiagnosticMessage(
                                 "Redefinition I/O operation " + toString(newDirective->getQualifiedName()),
                                 newDirective->getSrcLoc()),
-                        {DiagnosticMessage("Previous definition", (*foundItem)->getSrcLoc())});
+                        {DiagnosticMessage("Previous definition", foundItem->second->getSrcLoc())});
                 report.addDiagnostic(err);
             }
         }
         // if not, add it
         directives.push_back(std::move(newDirective));
     }
+
+private:
+    // the first definitions of each name, such that redefinitions are found without scanning the content;
+    // the names are those of the content as it is added, before it is renamed for its instance
+    std::map<QualifiedName, const ast::Type*> typeIndex;
+    std::map<QualifiedName, const Relation*> relationIndex;
+    std::map<QualifiedName, const Directive*> directiveIndex;
 };
 
 /**
@@ -299,9 +300,8 @@ void collectContent(Program& program, const Component& component, const TypeBind
         auto& cur = *iter;
         Relation* rel = index[cur->getHead()->getQualifiedName()];
         if (rel != nullptr) {
-            // add orphan to current instance and delete from orphan list
-            Own<Clause> instantiatedClause(clone(cur));
-            res.add(instantiatedClause, report);
+            // move orphan to current instance and delete from orphan list
+            res.add(cur, report);
             iter = orphans.erase(iter);
         } else {
             ++iter;
@@ -387,102 +387,67 @@ ComponentContent getInstantiatedContent(Program& program, const ComponentInit& c
         cur->setQualifiedName(newName);
     }
 
-    // create a helper function fixing type and relation references
+    // create a helper function fixing type and relation references, in a single pass over the node
     auto fixNames = [&](Node& node) {
-        // rename attribute types in headers
-        visit(node, [&](Attribute& attr) {
-            auto pos = typeNameMapping.find(attr.getTypeName());
+        auto rename = [&](const QualifiedName& name, auto&& set) {
+            auto pos = typeNameMapping.find(name);
             if (pos != typeNameMapping.end()) {
-                attr.setTypeName(pos->second);
-            }
-        });
-
-        // rename atoms in clauses
-        visit(node, [&](Atom& atom) {
-            auto pos = relationNameMapping.find(atom.getQualifiedName());
-            if (pos != relationNameMapping.end()) {
-                atom.setQualifiedName(pos->second);
+                set(pos->second);
             }
-        });
-
-        // rename directives
-        visit(node, [&](Directive& directive) {
-            auto pos = relationNameMapping.find(directive.getQualifiedName());
-            if (pos != relationNameMapping.end()) {
-                directive.setQualifiedName(pos->second);
-            }
-        });
-
-        // rename field types in records
-        visit(node, [&](ast::RecordType& recordType) {
-            auto&& fields = recordType.getFields();
-            for (std::size_t i = 0; i < fields.size(); i++) {
-                auto& field = fields[i];
-                auto pos = typeNameMapping.find(field->getTypeName());
-                if (pos != typeNameMapping.end()) {
-                    recordType.setFieldType(i, pos->second);
+        };
+        visit(node, [&](Node& cur) {
+            if (auto* attr = as<Attribute>(cur)) {
+                // rename attribute types in headers
+                rename(attr->getTypeName(), [&](const QualifiedName& name) { attr->setTypeName(name); });
+            } else if (auto* atom = as<Atom>(cur)) {
+                // rename atoms in clauses
+                auto pos = relationNameMapping.find(atom->getQualifiedName());
+                if (pos != relationNameMapping.end()) {
+                    atom->setQualifiedName(pos->second);
                 }
-            }
-        });
-
-        // rename branch name and field types in an ADT Branch
-        visit(node, [&](ast::BranchType& branchType) {
-            auto pos = typeNameMapping.find(branchType.getBranchName());
-            if (pos != typeNameMapping.end()) {
-                branchType.setBranchName(pos->second);
-            }
-            auto&& fields = branchType.getFields();
-            for (std::size_t i = 0; i < fields.size(); i++) {
-                auto& field = fields[i];
-                auto pos = typeNameMapping.find(field->getTypeName());
-                if (pos != typeNameMapping.end()) {
-                    branchType.setFieldType(i, pos->second);
+            } else if (auto* directive = as<Directive>(cur)) {
+                // rename directives
+                auto pos = relationNameMapping.find(directive->getQualifiedName());
+                if (pos != relationNameMapping.end()) {
+                    directive->setQualifiedName(pos->second);
                 }
-            }
-        });
-
-        // rename branch name in an ADT Branch Constructor
-        visit(node, [&](ast::BranchInit& branchInit) {
-            auto pos = typeNameMapping.find(branchInit.getBranchName());
-            if (pos != typeNameMapping.end()) {
-                branchInit.setBranchName(pos->second);
-            }
-        });
-
-        // rename variant types in unions
-        visit(node, [&](ast::UnionType& unionType) {
-            auto& variants = unionType.getTypes();
-            for (std::size_t i = 0; i < variants.size(); i++) {
-                auto pos = typeNameMapping.find(variants[i]);
-                if (pos != typeNameMapping.end()) {
-                    unionType.setType(i, pos->second);
+            } else if (auto* recordType = as<ast::RecordType>(cur)) {
+                // rename field types in records
+                auto&& fields = recordType->getFields();
+                for (std::size_t i = 0; i < fields.size(); i++) {
+                    rename(fields[i]->getTypeName(),
+                            [&](const QualifiedName& name) { recordType->setFieldType(i, name); });
                 }
-            }
-        });
-
-        // rename subset type
-        visit(node, [&](ast::SubsetType& subsetType) {
-            auto& baseType = subsetType.getBaseType();
-            auto pos = typeNameMapping.find(baseType);
-            if (pos != typeNameMapping.end()) {
-                subsetType.setBaseType(pos->second);
-            }
-        });
-
-        // rename alias type
-        visit(node, [&](ast::AliasType& aliasType) {
-            auto& alias = aliasType.getAliasType();
-            auto pos = typeNameMapping.find(alias);
-            if (pos != typeNameMapping.end()) {
-                aliasType.setAliasType(pos->second);
-            }
-        });
-
-        // rename type information in typecast
-        visit(node, [&](ast::TypeCast& cast) {
-            auto pos = typeNameMapping.find(cast.getType());
-            if (pos != typeNameMapping.end()) {
-                cast.setType(pos->second);
+            } else if (auto* branchType = as<ast::BranchType>(cur)) {
+                // rename branch name and field types in an ADT Branch
+                rename(branchType->getBranchName(),
+                        [&](const QualifiedName& name) { branchType->setBranchName(name); });
+                auto&& fields = branchType->getFields();
+                for (std::size_t i = 0; i < fields.size(); i++) {
+                    rename(fields[i]->getTypeName(),
+                            [&](const QualifiedName& name) { branchType->setFieldType(i, name); });
+                }
+            } else if (auto* branchInit = as<ast::BranchInit>(cur)) {
+                // rename branch name in an ADT Branch Constructor
+                rename(branchInit->getBranchName(),
+                        [&](const QualifiedName& name) { branchInit->setBranchName(name); });
+            } else if (auto* unionType = as<ast::UnionType>(cur)) {
+                // rename variant types in unions
+                auto& variants = unionType->getTypes();
+                for (std::size_t i = 0; i < variants.size(); i++) {
+                    rename(variants[i], [&](const QualifiedName& name) { unionType->setType(i, name); });
+                }
+            } else if (auto* subsetType = as<ast::SubsetType>(cur)) {
+                // rename subset type
+                rename(subsetType->getBaseType(),
+                        [&](const QualifiedName& name) { subsetType->setBaseType(name); });
+            } else if (auto* aliasType = as<ast::AliasType>(cur)) {
+                // rename alias type
+                rename(aliasType->getAliasType(),
+                        [&](const QualifiedName& name) { aliasType->setAliasType(name); });
+            } else if (auto* cast = as<ast::TypeCast>(cur)) {
+                // rename type information in typecast
+                rename(cast->getType(), [&](const QualifiedName& name) { cast->setType(name); });
             }
         });
     };
@@ -0,0 +1,287 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FlattenRecordAttributes.cpp
+ *
+ * Define the FlattenRecordAttributes transformer.
+ *
+ ***********************************************************************/
+
+#include "ast/transform/FlattenRecordAttributes.h"
+#include "RelationTag.h"
+#include "ast/Argument.h"
+#include "ast/Atom.h"
+#include "ast/Attribute.h"
+#include "ast/BinaryConstraint.h"
+#include "ast/Clause.h"
+#include "ast/Program.h"
+#include "ast/QualifiedName.h"
+#include "ast/RecordInit.h"
+#include "ast/Relation.h"
+#include "ast/SubsumptiveClause.h"
+#include "ast/TranslationUnit.h"
+#include "ast/UnnamedVariable.h"
+#include "ast/Variable.h"
+#include "ast/analysis/IOType.h"
+#include "ast/analysis/typesystem/TypeEnvironment.h"
+#include "ast/analysis/typesystem/TypeSystem.h"
+#include "ast/utility/NodeMapper.h"
+#include "ast/utility/Utils.h"
+#include "ast/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ast::transform {
+
+namespace {
+
+/** Flattened attributes with the number of their fields, by relation and attribute index */
+using Flattening = std::map<QualifiedName, std::map<std::size_t, std::size_t>>;
+
+/** Return the name of the variable holding a field of a record variable */
+std::string getFieldVariable(const std::string& variable, std::size_t field) {
+    return "@" + variable + "_" + toString(field);
+}
+
+/** Return the record type of the attribute, if it is not recursive */
+const analysis::RecordType* getRecordType(
+        const analysis::TypeEnvironment& typeEnv, const Attribute& attribute) {
+    const auto& typeName = attribute.getTypeName();
+    if (!typeEnv.isType(typeName)) {
+        return nullptr;
+    }
+    const auto* recordType = as<analysis::RecordType>(typeEnv.getType(typeName));
+    if (recordType == nullptr || recordType->getFields().empty()) {
+        return nullptr;
+    }
+
+    // search the record types of the fields for the type itself
+    std::set<const analysis::Type*> seen;
+    std::vector<const analysis::RecordType*> pending{recordType};
+    while (!pending.empty()) {
+        const auto* current = pending.back();
+        pending.pop_back();
+        for (const auto* field : current->getFields()) {
+            if (field == recordType) {
+                return nullptr;
+            }
+            if (const auto* fieldRecord = as<analysis::RecordType>(field)) {
+                if (seen.insert(fieldRecord).second) {
+                    pending.push_back(fieldRecord);
+                }
+            }
+        }
+    }
+    return recordType;
+}
+
+/** Return true if the representation of the relation may change */
+bool isFlattenable(const Relation& relation, const analysis::IOTypeAnalysis& ioTypes,
+        const std::set<QualifiedName>& subsumptiveRelations) {
+    switch (relation.getRepresentation()) {
+        case RelationRepresentation::BTREE_DELETE:
+        case RelationRepresentation::EQREL:
+        case RelationRepresentation::INFO: return false;
+        default: break;
+    }
+    return !ioTypes.isIO(&relation) && !ioTypes.isQueried(&relation) &&
+           relation.getFunctionalDependencies().empty() &&
+           !contains(subsumptiveRelations, relation.getQualifiedName());
+}
+
+/** Return the record variables bound by flattened attributes of atoms of the body, with their arity */
+std::map<std::string, std::size_t> getRecordVariables(const Clause& clause, const Flattening& flattening) {
+    std::map<std::string, std::size_t> variables;
+    for (const auto* atom : getBodyLiterals<Atom>(clause)) {
+        auto pos = flattening.find(atom->getQualifiedName());
+        if (pos == flattening.end()) {
+            continue;
+        }
+        const auto arguments = atom->getArguments();
+        for (const auto& [attribute, arity] : pos->second) {
+            if (const auto* var = as<Variable>(arguments[attribute])) {
+                variables[var->getName()] = arity;
+            }
+        }
+    }
+    return variables;
+}
+
+/**
+ * Return true if the argument of a flattened attribute can be replaced by its fields; any argument
+ * of an atom of the body binds its fields, elsewhere the fields must be known
+ */
+bool isFlattenable(const Argument& argument, std::size_t arity, bool isBodyAtom,
+        const std::map<std::string, std::size_t>& recordVariables) {
+    if (const auto* record = as<RecordInit>(argument)) {
+        return record->getArguments().size() == arity;
+    }
+    if (const auto* var = as<Variable>(argument)) {
+        return isBodyAtom || contains(recordVariables, var->getName());
+    }
+    return isA<UnnamedVariable>(argument);
+}
+
+/** Return the atom with the arguments of flattened attributes replaced by their fields */
+Own<Atom> flattenAtom(const Atom& atom, const std::map<std::size_t, std::size_t>& attributes) {
+    auto flattened = mk<Atom>(atom.getQualifiedName(), VecOwn<Argument>(), atom.getSrcLoc());
+    const auto arguments = atom.getArguments();
+    for (std::size_t i = 0; i < arguments.size(); ++i) {
+        auto pos = attributes.find(i);
+        if (pos == attributes.end()) {
+            flattened->addArgument(clone(arguments[i]));
+        } else if (const auto* record = as<RecordInit>(arguments[i])) {
+            for (const auto* field : record->getArguments()) {
+                flattened->addArgument(clone(field));
+            }
+        } else if (const auto* var = as<Variable>(arguments[i])) {
+            for (std::size_t j = 0; j < pos->second; ++j) {
+                flattened->addArgument(mk<Variable>(getFieldVariable(var->getName(), j)));
+            }
+        } else {
+            for (std::size_t j = 0; j < pos->second; ++j) {
+                flattened->addArgument(mk<UnnamedVariable>());
+            }
+        }
+    }
+    return flattened;
+}
+
+}  // namespace
+
+bool FlattenRecordAttributesTransformer::transform(TranslationUnit& translationUnit) {
+    Program& program = translationUnit.getProgram();
+    const auto& typeEnv =
+            translationUnit.getAnalysis<analysis::TypeEnvironmentAnalysis>().getTypeEnvironment();
+    const auto& ioTypes = translationUnit.getAnalysis<analysis::IOTypeAnalysis>();
+
+    // keep the structure of subsumptive clauses
+    std::set<QualifiedName> subsumptiveRelations;
+    for (const Clause* clause : program.getClauses()) {
+        if (isA<SubsumptiveClause>(clause)) {
+            visit(*clause, [&](const Atom& atom) { subsumptiveRelations.insert(atom.getQualifiedName()); });
+        }
+    }
+
+    // candidates are the non-recursive record attributes of relations whose representation may change
+    Flattening flattening;
+    for (const Relation* relation : program.getRelations()) {
+        if (!isFlattenable(*relation, ioTypes, subsumptiveRelations)) {
+            continue;
+        }
+        const auto attributes = relation->getAttributes();
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            if (const auto* recordType = getRecordType(typeEnv, *attributes[i])) {
+                flattening[relation->getQualifiedName()][i] = recordType->getFields().size();
+            }
+        }
+    }
+
+    // drop the attributes with occurrences that may not be records, until all remaining ones are
+    bool dropped = true;
+    while (dropped && !flattening.empty()) {
+        dropped = false;
+        for (const Clause* clause : program.getClauses()) {
+            const auto recordVariables = getRecordVariables(*clause, flattening);
+            const auto bodyAtoms = getBodyLiterals<Atom>(*clause);
+            const std::set<const Atom*> bodyAtomSet(bodyAtoms.begin(), bodyAtoms.end());
+            visit(*clause, [&](const Atom& atom) {
+                auto pos = flattening.find(atom.getQualifiedName());
+                if (pos == flattening.end()) {
+                    return;
+                }
+                const bool isBodyAtom = contains(bodyAtomSet, &atom);
+                const auto arguments = atom.getArguments();
+                auto& attributes = pos->second;
+                for (auto it = attributes.begin(); it != attributes.end();) {
+                    if (isFlattenable(*arguments[it->first], it->second, isBodyAtom, recordVariables)) {
+                        ++it;
+                    } else {
+                        it = attributes.erase(it);
+                        dropped = true;
+                    }
+                }
+            });
+        }
+        for (auto it = flattening.begin(); it != flattening.end();) {
+            it = it->second.empty() ? flattening.erase(it) : std::next(it);
+        }
+    }
+    if (flattening.empty()) {
+        return false;
+    }
+
+    // replace the arguments of the flattened attributes by their fields
+    for (Clause* clause : program.getClauses()) {
+        const auto recordVariables = getRecordVariables(*clause, flattening);
+        bool flattened = false;
+        mapChildPost(*clause, [&](Own<Atom> atom) -> Own<Atom> {
+            auto pos = flattening.find(atom->getQualifiedName());
+            if (pos == flattening.end()) {
+                return atom;
+            }
+            flattened = true;
+            return flattenAtom(*atom, pos->second);
+        });
+        if (!flattened) {
+            continue;
+        }
+
+        // records are packed from their fields where their variables are used otherwise
+        std::set<std::string> usedVariables;
+        visit(*clause, [&](const Variable& var) { usedVariables.insert(var.getName()); });
+        for (const auto& [variable, arity] : recordVariables) {
+            if (!contains(usedVariables, variable)) {
+                continue;
+            }
+            VecOwn<Argument> fields;
+            for (std::size_t j = 0; j < arity; ++j) {
+                fields.push_back(mk<Variable>(getFieldVariable(variable, j)));
+            }
+            clause->addToBody(mk<BinaryConstraint>(
+                    BinaryConstraintOp::EQ, mk<Variable>(variable), mk<RecordInit>(std::move(fields))));
+        }
+    }
+
+    // replace the flattened attributes by the attributes of their fields
+    for (Relation* relation : program.getRelations()) {
+        auto pos = flattening.find(relation->getQualifiedName());
+        if (pos == flattening.end()) {
+            continue;
+        }
+        VecOwn<Attribute> attributes;
+        const auto current = relation->getAttributes();
+        for (std::size_t i = 0; i < current.size(); ++i) {
+            if (!contains(pos->second, i)) {
+                attributes.push_back(clone(current[i]));
+                continue;
+            }
+            const auto* recordType = getRecordType(typeEnv, *current[i]);
+            const auto& fields = recordType->getFields();
+            for (std::size_t j = 0; j < fields.size(); ++j) {
+                attributes.push_back(mk<Attribute>(getFieldVariable(current[i]->getName(), j),
+                        fields[j]->getName(), current[i]->getSrcLoc()));
+            }
+        }
+        relation->setAttributes(std::move(attributes));
+    }
+    return true;
+}
+
+}  // namespace souffle::ast::transform
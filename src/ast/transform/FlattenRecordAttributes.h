@@ -0,0 +1,65 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FlattenRecordAttributes.h
+ *
+ * Transformation pass to store the fields of record attributes as
+ * columns of their relation.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ast/TranslationUnit.h"
+#include "ast/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ast::transform {
+
+/**
+ * Transformation pass to store the fields of record attributes as columns of their relation.
+ *
+ * A relation with an attribute of a non-recursive record type only keeps the
+ * references of its records, such that accessing a field unpacks the record and
+ * a join on a field scans the relation, e.g., for
+ *
+ *     .type Point = [x:number, y:number]
+ *     .decl r(p:Point, c:symbol)
+ *     r([x, y], c) :- s(x, y, c).
+ *     a(c) :- r(p, c), t(p), u(x), r([x, _], c).
+ *
+ * The attribute p is replaced by one attribute per field,
+ *
+ *     .decl r(@p_0:number, @p_1:number, c:symbol)
+ *     r(x, y, c) :- s(x, y, c).
+ *     a(c) :- r(@p_0, @p_1, c), t(p), u(x), r(x, _, c), p = [@p_0, @p_1].
+ *
+ * such that the fields are indexed, and records are only packed where their
+ * values are used otherwise. An attribute is flattened if the values of all
+ * its occurrences are known to be records, i.e., its occurrences in heads,
+ * negations and aggregates are records or variables of records bound by other
+ * flattened attributes; nil values prevent the flattening. Relations that are
+ * read, written or queried keep their records.
+ */
+class FlattenRecordAttributesTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "FlattenRecordAttributesTransformer";
+    }
+
+private:
+    FlattenRecordAttributesTransformer* cloning() const override {
+        return new FlattenRecordAttributesTransformer();
+    }
+
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
+}  // namespace souffle::ast::transform
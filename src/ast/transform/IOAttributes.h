@@ -17,15 +17,22 @@
 
 #pragma once
 
+#include "Global.h"
+#include "RelationTag.h"
+#include "ast/Aggregator.h"
 #include "ast/AlgebraicDataType.h"
+#include "ast/Atom.h"
 #include "ast/Attribute.h"
 #include "ast/Directive.h"
+#include "ast/NumericConstant.h"
 #include "ast/Program.h"
 #include "ast/QualifiedName.h"
 #include "ast/RecordType.h"
 #include "ast/Relation.h"
+#include "ast/StringConstant.h"
 #include "ast/TranslationUnit.h"
 #include "ast/Type.h"
+#include "ast/UnnamedVariable.h"
 #include "ast/analysis/typesystem/TypeEnvironment.h"
 #include "ast/analysis/typesystem/TypeSystem.h"
 #include "ast/transform/Transformer.h"
@@ -38,6 +45,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <map>
+#include <set>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -74,7 +82,7 @@ private:
         Program& program = translationUnit.getProgram();
 
         for (Directive* io : program.getDirectives()) {
-            if (io->getType() == ast::DirectiveType::limitsize) {
+            if (io->getType() == ast::DirectiveType::limitsize || io->getType() == ast::DirectiveType::goal) {
                 continue;
             }
             Relation* rel = program.getRelation(*io);
@@ -91,10 +99,17 @@ private:
             json11::Json relJson = json11::Json::object{{"arity", arity},
                     {"params", json11::Json::array(attributesParams.begin(), attributesParams.end())}};
 
-            json11::Json params = json11::Json::object{
+            json11::Json::object params{
                     {"relation", relJson}, {"records", getRecordsParams(translationUnit)}};
+            if (io->getType() == ast::DirectiveType::input && io->hasParameter("pushdown") &&
+                    io->getParameter("pushdown") == "true") {
+                json11::Json pushdown = getPushdown(translationUnit, *rel);
+                if (!pushdown.is_null()) {
+                    params.emplace("pushdown", std::move(pushdown));
+                }
+            }
 
-            io->addParameter("params", params.dump());
+            io->addParameter("params", json11::Json(params).dump());
             changed = true;
         }
         return changed;
@@ -104,7 +119,7 @@ private:
         bool changed = false;
         Program& program = translationUnit.getProgram();
         for (Directive* io : program.getDirectives()) {
-            if (io->getType() == ast::DirectiveType::limitsize) {
+            if (io->getType() == ast::DirectiveType::limitsize || io->getType() == ast::DirectiveType::goal) {
                 continue;
             }
             if (io->hasParameter("attributeNames")) {
@@ -158,6 +173,87 @@ private:
         return changed;
     }
 
+    /**
+     * Get the part of an input relation observed by the program, to be
+     * pushed down into the reader of the relation.
+     *
+     * The structure of JSON is:
+     * {"columns" : [used..], "filters" : [{"column" : ..., "values" : [constant..]}..]}
+     *
+     * A column is unused if no atom of the relation names it, and filtered
+     * if all atoms of the relation bind it to a symbol or an integer. The
+     * result is null if the program may observe tuples outside this part,
+     * i.e. if the relation is also derived or written, if its tuples are
+     * counted by aggregates, chosen by functional dependencies or closed by
+     * an equivalence relation, or if provenance is enabled.
+     */
+    json11::Json getPushdown(TranslationUnit& translationUnit, const Relation& rel) const {
+        Program& program = translationUnit.getProgram();
+        const auto& name = rel.getQualifiedName();
+
+        if (Global::config().has("provenance") || !program.getClauses(rel).empty() ||
+                !rel.getFunctionalDependencies().empty() ||
+                rel.getRepresentation() == RelationRepresentation::EQREL) {
+            return json11::Json();
+        }
+        for (const Directive* io : program.getDirectives()) {
+            const auto type = io->getType();
+            if (io->getQualifiedName() == name && type != ast::DirectiveType::input &&
+                    type != ast::DirectiveType::limitsize && type != ast::DirectiveType::goal) {
+                return json11::Json();
+            }
+        }
+        bool aggregated = false;
+        visit(program, [&](const Aggregator& aggregator) {
+            visit(aggregator, [&](const Atom& atom) { aggregated |= atom.getQualifiedName() == name; });
+        });
+        if (aggregated) {
+            return json11::Json();
+        }
+
+        auto& typeEnv = translationUnit.getAnalysis<analysis::TypeEnvironmentAnalysis>().getTypeEnvironment();
+        std::vector<char> types;
+        for (const auto* attribute : rel.getAttributes()) {
+            types.push_back(getTypeQualifier(typeEnv.getType(attribute->getTypeName()))[0]);
+        }
+
+        const std::size_t arity = rel.getArity();
+        std::vector<bool> used(arity, false);
+        std::vector<bool> bound(arity, true);
+        std::vector<std::set<std::string>> constants(arity);
+        bool observed = false;
+        visit(program.getClauses(), [&](const Atom& atom) {
+            if (atom.getQualifiedName() != name) {
+                return;
+            }
+            observed = true;
+            auto arguments = atom.getArguments();
+            for (std::size_t i = 0; i < arity; i++) {
+                used[i] = used[i] || !isA<UnnamedVariable>(arguments[i]);
+                if (types[i] == 's' && isA<StringConstant>(arguments[i])) {
+                    constants[i].insert(as<StringConstant>(arguments[i])->getConstant());
+                } else if ((types[i] == 'i' || types[i] == 'u') && isA<NumericConstant>(arguments[i])) {
+                    constants[i].insert(as<NumericConstant>(arguments[i])->getConstant());
+                } else {
+                    bound[i] = false;
+                }
+            }
+        });
+        if (!observed) {
+            return json11::Json();
+        }
+
+        std::vector<json11::Json> filters;
+        for (std::size_t i = 0; i < arity; i++) {
+            if (bound[i]) {
+                filters.push_back(json11::Json::object{{"column", static_cast<long long>(i)},
+                        {"values", json11::Json::array(constants[i].begin(), constants[i].end())}});
+            }
+        }
+        return json11::Json::object{{"columns", json11::Json::array(used.begin(), used.end())},
+                {"filters", std::move(filters)}};
+    }
+
     std::string getRelationName(const Directive* node) {
         return toString(join(node->getQualifiedName().getQualifiers(), "."));
     }
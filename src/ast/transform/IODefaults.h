@@ -71,7 +71,9 @@ private:
         for (Directive* io : program.getDirectives()) {
             // Don't do anything for a directive which
             // is not an I/O directive
-            if (io->getType() == ast::DirectiveType::limitsize) continue;
+            if (io->getType() == ast::DirectiveType::limitsize || io->getType() == ast::DirectiveType::goal) {
+                continue;
+            }
 
             // Set a default IO of file
             if (!io->hasParameter("IO")) {
@@ -0,0 +1,194 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IndexRecordFields.cpp
+ *
+ * Define the IndexRecordFields transformer.
+ *
+ ***********************************************************************/
+
+#include "ast/transform/IndexRecordFields.h"
+#include "RelationTag.h"
+#include "ast/Argument.h"
+#include "ast/Atom.h"
+#include "ast/Attribute.h"
+#include "ast/Clause.h"
+#include "ast/Constant.h"
+#include "ast/Program.h"
+#include "ast/QualifiedName.h"
+#include "ast/RecordInit.h"
+#include "ast/Relation.h"
+#include "ast/SubsumptiveClause.h"
+#include "ast/TranslationUnit.h"
+#include "ast/Variable.h"
+#include "ast/analysis/Aggregate.h"
+#include "ast/analysis/typesystem/TypeEnvironment.h"
+#include "ast/analysis/typesystem/TypeSystem.h"
+#include "ast/utility/Visitor.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ast::transform {
+
+namespace {
+
+/** A field inside a record argument of an atom, given by the argument and field index */
+using RecordField = std::pair<std::size_t, std::size_t>;
+
+/** Return true if the given term is known before the atom it occurs in is evaluated */
+bool isBound(const Argument& term, const std::set<std::string>& boundVariables) {
+    if (const auto* var = as<Variable>(term)) {
+        return contains(boundVariables, var->getName());
+    }
+    return isA<Constant>(term);
+}
+
+/** Return true if the records of the relation may be keyed by a copy of the relation */
+bool isIndexable(const Program& program, const Relation& relation) {
+    switch (relation.getRepresentation()) {
+        case RelationRepresentation::BTREE_DELETE:
+        case RelationRepresentation::INFO: return false;
+        default: break;
+    }
+    // subsumption removes tuples, which a copy would keep
+    for (const auto* clause : program.getClauses(relation)) {
+        if (isA<SubsumptiveClause>(clause)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool IndexRecordFieldsTransformer::transform(TranslationUnit& translationUnit) {
+    Program& program = translationUnit.getProgram();
+    const auto& typeEnv =
+            translationUnit.getAnalysis<analysis::TypeEnvironmentAnalysis>().getTypeEnvironment();
+
+    // relations keyed by record fields, by relation and keyed fields
+    std::map<std::pair<QualifiedName, std::vector<RecordField>>, QualifiedName> keyedRelations;
+
+    // create the relation keying the given fields of the relation
+    auto createKeyedRelation = [&](const Relation& relation, const std::vector<RecordField>& fields,
+                                       const std::vector<std::size_t>& arities) {
+        const auto& name = relation.getQualifiedName();
+        QualifiedName keyedName(
+                analysis::findUniqueRelationName(program, "@record_index_" + toString(name)));
+        auto keyedRelation = mk<Relation>(keyedName);
+        for (const auto* attribute : relation.getAttributes()) {
+            keyedRelation->addAttribute(clone(attribute));
+        }
+
+        // @record_index_r(x0, .., [f0, .., fm], .., xn, fields..) :- r(x0, .., [f0, .., fm], .., xn).
+        auto clause = mk<Clause>(keyedName);
+        auto atom = mk<Atom>(name);
+        const auto attributes = relation.getAttributes();
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            if (arities[i] == 0) {
+                const std::string variable = "@x" + toString(i);
+                clause->getHead()->addArgument(mk<Variable>(variable));
+                atom->addArgument(mk<Variable>(variable));
+                continue;
+            }
+            VecOwn<Argument> record;
+            for (std::size_t j = 0; j < arities[i]; ++j) {
+                record.push_back(mk<Variable>("@f" + toString(i) + "_" + toString(j)));
+            }
+            auto recordInit = mk<RecordInit>(std::move(record));
+            clause->getHead()->addArgument(clone(recordInit));
+            atom->addArgument(std::move(recordInit));
+        }
+        for (const auto& [argument, field] : fields) {
+            const auto* recordType =
+                    as<analysis::RecordType>(typeEnv.getType(attributes[argument]->getTypeName()));
+            const std::string suffix = toString(argument) + "_" + toString(field);
+            keyedRelation->addAttribute(
+                    mk<Attribute>("@key" + suffix, recordType->getFields()[field]->getName()));
+            clause->getHead()->addArgument(mk<Variable>("@f" + suffix));
+        }
+        clause->addToBody(std::move(atom));
+
+        program.addRelation(std::move(keyedRelation));
+        program.addClause(std::move(clause));
+        return keyedName;
+    };
+
+    bool changed = false;
+    for (Clause* clause : program.getClauses()) {
+        // keep fixed execution plans and the structure of subsumptive clauses
+        if (clause->getExecutionPlan() != nullptr || isA<SubsumptiveClause>(clause)) {
+            continue;
+        }
+
+        // variables bound by the atoms preceding the current one
+        std::set<std::string> boundVariables;
+        for (Literal* literal : clause->getBodyLiterals()) {
+            auto* atom = as<Atom>(literal);
+            if (atom == nullptr) {
+                continue;
+            }
+
+            const Relation* relation = program.getRelation(*atom);
+            if (relation != nullptr && isIndexable(program, *relation)) {
+                // collect the bound fields of the record arguments of known record type; only the
+                // records with bound fields are unpacked, the others may be nil
+                std::vector<RecordField> fields;
+                std::vector<std::size_t> arities(atom->getArity(), 0);
+                const auto attributes = relation->getAttributes();
+                const auto arguments = atom->getArguments();
+                for (std::size_t i = 0; i < arguments.size(); ++i) {
+                    const auto* record = as<RecordInit>(arguments[i]);
+                    const auto& typeName = attributes[i]->getTypeName();
+                    if (record == nullptr || !typeEnv.isType(typeName)) {
+                        continue;
+                    }
+                    const auto* recordType = as<analysis::RecordType>(typeEnv.getType(typeName));
+                    const auto operands = record->getArguments();
+                    if (recordType == nullptr || recordType->getFields().size() != operands.size()) {
+                        continue;
+                    }
+                    for (std::size_t j = 0; j < operands.size(); ++j) {
+                        if (isBound(*operands[j], boundVariables)) {
+                            fields.emplace_back(i, j);
+                            arities[i] = operands.size();
+                        }
+                    }
+                }
+
+                if (!fields.empty()) {
+                    auto key = std::make_pair(relation->getQualifiedName(), fields);
+                    auto pos = keyedRelations.find(key);
+                    if (pos == keyedRelations.end()) {
+                        auto keyedName = createKeyedRelation(*relation, fields, arities);
+                        pos = keyedRelations.emplace(key, keyedName).first;
+                    }
+                    atom->setQualifiedName(pos->second);
+                    for (const auto& [argument, field] : fields) {
+                        atom->addArgument(clone(as<RecordInit>(arguments[argument])->getArguments()[field]));
+                    }
+                    changed = true;
+                }
+            }
+
+            visit(*atom, [&](const Variable& var) { boundVariables.insert(var.getName()); });
+        }
+    }
+    return changed;
+}
+
+}  // namespace souffle::ast::transform
@@ -0,0 +1,58 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IndexRecordFields.h
+ *
+ * Transformation pass to make fields inside records available to
+ * index selection.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ast/TranslationUnit.h"
+#include "ast/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ast::transform {
+
+/**
+ * Transformation pass to make fields inside records available to index selection.
+ *
+ * Index selection only considers the top-level columns of a relation, hence an
+ * atom joining on a field inside a record, e.g. the atom on r in
+ *
+ *     a(c) :- s(b), r([a, b], c).
+ *
+ * scans r and unpacks each record to filter on its field. The atom is instead
+ * evaluated on a relation keeping the field as an additional column,
+ *
+ *     @record_index_r([f0, f1], y, f1) :- r([f0, f1], y).
+ *     a(c) :- s(b), @record_index_r([a, b], c, b).
+ *
+ * such that the join probes an index on the field. The transformation must be
+ * applied after the body literals are ordered, since only fields bound by
+ * preceding atoms are keyed.
+ */
+class IndexRecordFieldsTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "IndexRecordFieldsTransformer";
+    }
+
+private:
+    IndexRecordFieldsTransformer* cloning() const override {
+        return new IndexRecordFieldsTransformer();
+    }
+
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
+}  // namespace souffle::ast::transform
@@ -26,6 +26,7 @@
 #include "ast/Clause.h"
 #include "ast/Constant.h"
 #include "ast/Constraint.h"
+#include "ast/Counter.h"
 #include "ast/Functor.h"
 #include "ast/IntrinsicFunctor.h"
 #include "ast/Literal.h"
@@ -36,20 +37,26 @@
 #include "ast/QualifiedName.h"
 #include "ast/RecordInit.h"
 #include "ast/Relation.h"
+#include "ast/SubsumptiveClause.h"
 #include "ast/TranslationUnit.h"
 #include "ast/TypeCast.h"
 #include "ast/UnnamedVariable.h"
 #include "ast/UserDefinedFunctor.h"
 #include "ast/Variable.h"
+#include "ast/analysis/IOType.h"
+#include "ast/analysis/SCCGraph.h"
+#include "ast/analysis/TopologicallySortedSCCGraph.h"
 #include "ast/analysis/typesystem/PolymorphicObjects.h"
 #include "ast/utility/Utils.h"
 #include "ast/utility/Visitor.h"
 #include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/FunctionalUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -627,14 +634,15 @@ NullableVector<Argument*> getInlinedArgument(Program& program, const Argument* a
                             case AggregateOp::FSUM:
                             case AggregateOp::USUM:
                             case AggregateOp::COUNT: return "+";
-                            case AggregateOp::MEAN: fatal("no translation");
+                            case AggregateOp::MEAN:
+                            case AggregateOp::COUNT_APPROX: fatal("no translation");
                         }
 
                         UNREACHABLE_BAD_CASE_ANALYSIS
                     };
                     // Create the actual overall aggregator that ties the replacement aggregators together.
                     // example: min x : { a(x) }. <=> min ( min x : { a1(x) }, min x : { a2(x) }, ... )
-                    if (op != AggregateOp::MEAN) {
+                    if (op != AggregateOp::MEAN && op != AggregateOp::COUNT_APPROX) {
                         versions.push_back(combineAggregators(aggrVersions, aggregateToFunctor(op)));
                     }
                 }
@@ -1069,6 +1077,111 @@ bool InlineRelationsTransformer::transform(TranslationUnit& translationUnit) {
     return changed;
 }
 
+bool InlineMarkAutomaticTransform::transform(TranslationUnit& translationUnit) {
+    // provenance explains the tuples of the relations of the program as written
+    if (!Global::config().has("inline-auto") || Global::config().has("provenance")) {
+        return false;
+    }
+
+    // bounds on the clauses an inlined relation is replaced by, and on the versions of a clause using it
+    constexpr std::size_t maxInlinedClauses = 4;
+    constexpr std::size_t maxClauseVersions = 16;
+
+    bool changed = false;
+    Program& program = translationUnit.getProgram();
+    const auto& ioTypes = translationUnit.getAnalysis<analysis::IOTypeAnalysis>();
+    const auto& sccGraph = translationUnit.getAnalysis<analysis::SCCGraphAnalysis>();
+    const auto& sccOrder = translationUnit.getAnalysis<analysis::TopologicallySortedSCCGraphAnalysis>();
+    const auto excludedRelations = InlineRelationsTransformer::excluded();
+
+    auto isExcluded = [&](const Relation* rel) {
+        return contains(excludedRelations, rel->getQualifiedName()) ||
+               rel->hasQualifier(RelationQualifier::NO_INLINE) ||
+               rel->hasQualifier(RelationQualifier::NO_MAGIC);
+    };
+
+    // the atoms of the program using each relation, and whether all of them can be inlined
+    struct Use {
+        const Clause* clause;
+        const Atom* atom;
+    };
+    std::map<const Relation*, std::vector<Use>> uses;
+    std::set<const Relation*> pinned;
+    for (const auto* clause : program.getClauses()) {
+        std::set<const Atom*> guarded;
+        visit(*clause, [&](const Negation& negation) { guarded.insert(negation.getAtom()); });
+        visit(*clause, [&](const Aggregator& aggregator) {
+            visit(aggregator, [&](const Atom& atom) { guarded.insert(&atom); });
+        });
+        const Relation* user = program.getRelation(*clause);
+        const bool inlinable = user != nullptr && !isExcluded(user) && !isA<SubsumptiveClause>(clause);
+        for (const auto* literal : clause->getBodyLiterals()) {
+            visit(*literal, [&](const Atom& atom) {
+                const Relation* rel = program.getRelation(atom);
+                if (rel == nullptr) {
+                    return;
+                }
+                uses[rel].push_back({clause, &atom});
+                if (!inlinable || contains(guarded, &atom) ||
+                        visitExists(atom, [](const Counter&) { return true; })) {
+                    pinned.insert(rel);
+                }
+            });
+        }
+    }
+
+    // the clauses each relation is replaced by, and the versions of each clause, once inlined
+    std::map<const Relation*, std::size_t> inlinedClauses;
+    std::map<const Clause*, std::size_t> clauseVersions;
+    auto getClauseVersions = [&](const Clause* clause) {
+        auto it = clauseVersions.find(clause);
+        return it == clauseVersions.end() ? std::size_t(1) : it->second;
+    };
+
+    // relations precede their users, such that chains of inlined relations are bounded as a whole
+    for (std::size_t scc : sccOrder.order()) {
+        if (sccGraph.isRecursive(scc)) {
+            continue;
+        }
+        for (const Relation* rel : sccGraph.getInternalRelations(scc)) {
+            const auto& relUses = uses[rel];
+            if (relUses.size() != 1 || contains(pinned, rel) || isExcluded(rel) ||
+                    rel->hasQualifier(RelationQualifier::INLINE) || ioTypes.isIO(rel) ||
+                    ioTypes.isLimitSize(rel) || ioTypes.isQueried(rel) ||
+                    !program.getDirectives(rel->getQualifiedName()).empty() ||
+                    !rel->getFunctionalDependencies().empty() ||
+                    (rel->getRepresentation() != RelationRepresentation::DEFAULT &&
+                            rel->getRepresentation() != RelationRepresentation::BTREE)) {
+                continue;
+            }
+
+            const auto clauses = program.getClauses(*rel);
+            if (clauses.empty() || visitExists(clauses, [](const Aggregator&) { return true; }) ||
+                    visitExists(clauses, [](const Counter&) { return true; }) ||
+                    any_of(clauses, [](const Clause* clause) { return isA<SubsumptiveClause>(clause); })) {
+                continue;
+            }
+
+            // the clauses of the relation multiply with the relations inlined into them
+            std::size_t versions = 0;
+            for (const auto* clause : clauses) {
+                versions += getClauseVersions(clause);
+            }
+            const Use& use = relUses.front();
+            const std::size_t useVersions = getClauseVersions(use.clause) * versions;
+            if (versions > maxInlinedClauses || useVersions > maxClauseVersions) {
+                continue;
+            }
+
+            // the clauses of an inlined relation take its place in the clause using it
+            clauseVersions[use.clause] = useVersions;
+            program.getRelation(rel->getQualifiedName())->addQualifier(RelationQualifier::INLINE);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
 bool InlineUnmarkExcludedTransform::transform(TranslationUnit& translationUnit) {
     bool changed = false;
     Program& program = translationUnit.getProgram();
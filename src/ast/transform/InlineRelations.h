@@ -36,6 +36,10 @@ public:
         return "InlineRelationsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDeclarationAnalyses();
+    }
+
 private:
     InlineRelationsTransformer* cloning() const override {
         return new InlineRelationsTransformer();
@@ -44,6 +48,29 @@ private:
     bool transform(TranslationUnit& translationUnit) override;
 };
 
+/**
+ * Mark relations for inlining whose materialisation is not worth it, enabled by the
+ * `inline-auto` pragma (e.g. `-P inline-auto`).
+ *
+ * A relation is marked if it is used by a single positive atom outside of aggregates,
+ * and is neither recursive, IO, nor otherwise excluded from inlining. Since inlining
+ * multiplies the clauses using the relation by its clauses, a relation is only marked if
+ * it inlines into few clauses, and the clause using it does not grow beyond a bound.
+ */
+class InlineMarkAutomaticTransform : public Transformer {
+public:
+    std::string getName() const override {
+        return "InlineMarkAutomaticTransform";
+    }
+
+private:
+    InlineMarkAutomaticTransform* cloning() const override {
+        return new InlineMarkAutomaticTransform();
+    }
+
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
 class InlineUnmarkExcludedTransform : public Transformer {
 public:
     std::string getName() const override {
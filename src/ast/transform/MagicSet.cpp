@@ -33,6 +33,7 @@
 #include "ast/UnnamedVariable.h"
 #include "ast/analysis/IOType.h"
 #include "ast/analysis/PrecedenceGraph.h"
+#include "ast/analysis/ProfileUse.h"
 #include "ast/analysis/SCCGraph.h"
 #include "ast/analysis/typesystem/PolymorphicObjects.h"
 #include "ast/utility/BindingStore.h"
@@ -46,6 +47,7 @@
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include <algorithm>
+#include <deque>
 #include <optional>
 #include <utility>
 
@@ -114,9 +116,13 @@ std::set<QualifiedName> MagicSetTransformer::getWeaklyIgnoredRelations(const Tra
         }
     }
 
-    // Get the complement if not everything is magic'd
+    // Get the complement if not everything is magic'd; goals select the relations worth magic-setting
+    // unless the relations are given
     std::set<QualifiedName> includedRelations = specifiedRelations - weaklyIgnoredRelations;
-    if (!contains(includedRelations, "*")) {
+    const bool automatic = contains(includedRelations, "auto") ||
+                           (!Global::config().has("magic-transform") &&
+                                   tu.getAnalysis<analysis::IOTypeAnalysis>().hasGoals());
+    if (!contains(includedRelations, "*") && !automatic) {
         for (const Relation* rel : program.getRelations()) {
             if (!contains(specifiedRelations, rel->getQualifiedName())) {
                 weaklyIgnoredRelations.insert(rel->getQualifiedName());
@@ -218,9 +224,111 @@ std::set<QualifiedName> MagicSetTransformer::getWeaklyIgnoredRelations(const Tra
         });
     }
 
+    // - Any relation not worth magic-setting, unless specified explicitly
+    if (automatic) {
+        const auto& selectedRelations = getAutomaticallySelectedRelations(tu, weaklyIgnoredRelations);
+        for (const Relation* rel : program.getRelations()) {
+            const auto& relName = rel->getQualifiedName();
+            if (!contains(selectedRelations, relName) && !contains(specifiedRelations, relName)) {
+                weaklyIgnoredRelations.insert(relName);
+            }
+        }
+    }
+
     return weaklyIgnoredRelations;
 }
 
+std::set<QualifiedName> MagicSetTransformer::getAutomaticallySelectedRelations(
+        const TranslationUnit& tu, const std::set<QualifiedName>& ignoredRelations) {
+    // Relations with fewer tuples in a profile are cheaper to compute entirely than through magic sets
+    constexpr std::size_t smallRelationSize = 1024;
+
+    const auto& program = tu.getProgram();
+    const auto& ioTypes = tu.getAnalysis<analysis::IOTypeAnalysis>();
+    const auto& profileUse = tu.getAnalysis<analysis::ProfileUseAnalysis>();
+
+    // Output relations are computed entirely, and so is any relation used through them without bindings
+    std::set<QualifiedName> selectedRelations;
+    for (const auto* rel : program.getRelations()) {
+        const auto& relName = rel->getQualifiedName();
+        if (contains(ignoredRelations, relName) || ioTypes.isOutput(rel) || ioTypes.isPrintSize(rel)) {
+            continue;
+        }
+        if (profileUse.hasRelationSize(relName) && profileUse.getRelationSize(relName) < smallRelationSize) {
+            continue;
+        }
+        selectedRelations.insert(relName);
+    }
+
+    // Follow the adornment from the output relations, and drop the selected relations reached with an
+    // all-free adornment until none is left
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::set<std::pair<QualifiedName, std::string>> reached;
+        std::deque<std::pair<QualifiedName, std::string>> queue;
+        auto reach = [&](const QualifiedName& relName, const std::string& adornmentMarker) {
+            if (reached.insert({relName, adornmentMarker}).second) {
+                queue.emplace_back(relName, adornmentMarker);
+            }
+        };
+        for (const auto* rel : program.getRelations()) {
+            if (ioTypes.isOutput(rel) || ioTypes.isPrintSize(rel)) {
+                reach(rel->getQualifiedName(), "");
+            }
+        }
+
+        std::set<QualifiedName> unboundRelations;
+        while (!queue.empty()) {
+            const auto [relName, adornmentMarker] = queue.front();
+            queue.pop_front();
+            for (const auto* clause : program.getClauses(relName)) {
+                BindingStore variableBindings(clause);
+                const auto& headArgs = clause->getHead()->getArguments();
+                for (std::size_t i = 0; i < adornmentMarker.length() && i < headArgs.size(); i++) {
+                    const auto* var = as<ast::Variable>(headArgs[i]);
+                    if (var != nullptr && adornmentMarker[i] == 'b') {
+                        variableBindings.bindVariableWeakly(var->getName());
+                    }
+                }
+                for (const auto* lit : clause->getBodyLiterals()) {
+                    if (const auto* negation = as<Negation>(lit)) {
+                        reach(negation->getAtom()->getQualifiedName(), "");
+                    }
+                    const auto* atom = as<Atom>(lit);
+                    if (atom == nullptr) {
+                        continue;
+                    }
+                    const auto& atomName = atom->getQualifiedName();
+                    std::string atomAdornment;
+                    if (contains(selectedRelations, atomName)) {
+                        for (const auto* arg : atom->getArguments()) {
+                            const auto* var = as<ast::Variable>(arg);
+                            const bool bound = var != nullptr && variableBindings.isBound(var->getName());
+                            atomAdornment += bound ? 'b' : 'f';
+                        }
+                        if (atomAdornment.find('b') == std::string::npos) {
+                            unboundRelations.insert(atomName);
+                        }
+                    }
+                    reach(atomName, atomAdornment);
+                    for (const auto* arg : atom->getArguments()) {
+                        if (const auto* var = as<ast::Variable>(arg)) {
+                            variableBindings.bindVariableStrongly(var->getName());
+                        }
+                    }
+                }
+            }
+        }
+
+        for (const auto& relName : unboundRelations) {
+            changed |= selectedRelations.erase(relName) > 0;
+        }
+    }
+
+    return selectedRelations;
+}
+
 std::set<QualifiedName> MagicSetTransformer::getStronglyIgnoredRelations(const TranslationUnit& tu) {
     const auto& program = tu.getProgram();
     const auto& precedenceGraph = tu.getAnalysis<analysis::PrecedenceGraphAnalysis>().graph();
@@ -281,6 +389,7 @@ std::set<QualifiedName> MagicSetTransformer::getRelationsToNotLabel(const Transl
 bool MagicSetTransformer::shouldRun(const TranslationUnit& tu) {
     const Program& program = tu.getProgram();
     if (Global::config().has("magic-transform")) return true;
+    if (tu.getAnalysis<analysis::IOTypeAnalysis>().hasGoals()) return true;
     for (const auto* rel : program.getRelations()) {
         if (rel->hasQualifier(RelationQualifier::MAGIC)) return true;
     }
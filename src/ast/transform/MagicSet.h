@@ -89,6 +89,15 @@ private:
      */
     static std::set<QualifiedName> getWeaklyIgnoredRelations(const TranslationUnit& tu);
 
+    /**
+     * Gets the set of relations worth magic-setting, for `magic-transform` given as `auto`.
+     * A relation is selected if every use reached from the output relations binds some of its
+     * arguments, such that its magic-set version never computes the whole relation, and if it is
+     * not known to be small from a profile given by `profile-use`.
+     */
+    static std::set<QualifiedName> getAutomaticallySelectedRelations(
+            const TranslationUnit& tu, const std::set<QualifiedName>& ignoredRelations);
+
     /**
      * Gets the set of relations to strongly ignore during the MST process.
      * Strongly-ignored relations cannot be safely duplicated without affecting semantics.
@@ -273,6 +273,11 @@ bool MinimiseProgramTransformer::reduceLocallyEquivalentClauses(TranslationUnit&
                 const auto& normedClause = normalisations.getNormalisation(clause);
                 if (areBijectivelyEquivalent(normedRep, normedClause)) {
                     // clause belongs to an existing equivalence class, so delete it
+                    // (unless it carries the execution plan the representative lacks, e.g., one emitted
+                    // by a previous evaluation for the same clause)
+                    if (eqClass[0]->getExecutionPlan() == nullptr && clause->getExecutionPlan() != nullptr) {
+                        std::swap(eqClass[0], clause);
+                    }
                     eqClass.push_back(clause);
                     clausesToDelete.push_back(clause);
                     added = true;
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "ast/transform/Transformer.h"
+#include <set>
 
 namespace souffle::ast::transform {
 
@@ -28,6 +29,10 @@ public:
         return "NormaliseGeneratorsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDeclarationAnalyses();
+    }
+
 private:
     bool transform(TranslationUnit& translationUnit) override;
 
@@ -0,0 +1,243 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProfileGuidedRepresentation.cpp
+ *
+ * Define the transformation choosing the representation of relations
+ * from a profile.
+ *
+ ***********************************************************************/
+
+#include "ast/transform/ProfileGuidedRepresentation.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ast/Argument.h"
+#include "ast/Atom.h"
+#include "ast/Clause.h"
+#include "ast/Literal.h"
+#include "ast/Program.h"
+#include "ast/QualifiedName.h"
+#include "ast/Relation.h"
+#include "ast/SubsumptiveClause.h"
+#include "ast/TranslationUnit.h"
+#include "ast/UnnamedVariable.h"
+#include "ast/Variable.h"
+#include "ast/analysis/ProfileUse.h"
+#include "reports/DebugReport.h"
+#include "souffle/profile/Relation.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ast::transform {
+
+namespace {
+
+/** Smallest equivalence relation stored as an eqrel, below which its closure is cheap anyway */
+constexpr std::size_t MIN_EQUIVALENCE_SIZE = 1000;
+
+/** Smallest number of columns of a relation stored as a brie */
+constexpr std::size_t MIN_TRIE_ARITY = 3;
+
+/** Smallest relation stored as a brie */
+constexpr std::size_t MIN_TRIE_SIZE = 100000;
+
+/** The variables of a binary atom of the relation, where an unnamed variable is "_" */
+std::optional<std::pair<std::string, std::string>> getVariables(
+        const Literal* literal, const QualifiedName& name) {
+    const auto* atom = as<Atom>(literal);
+    if (atom == nullptr || atom->getQualifiedName() != name || atom->getArity() != 2) {
+        return std::nullopt;
+    }
+    std::vector<std::string> variables;
+    for (const auto* arg : atom->getArguments()) {
+        if (const auto* var = as<Variable>(arg)) {
+            variables.push_back(var->getName());
+        } else if (isA<UnnamedVariable>(arg)) {
+            variables.push_back("_");
+        } else {
+            return std::nullopt;
+        }
+    }
+    return std::make_pair(variables[0], variables[1]);
+}
+
+/** The variables of the head and of the body atoms of a clause whose atoms all are of the relation */
+std::optional<std::vector<std::pair<std::string, std::string>>> getClauseVariables(
+        const Clause& clause, const QualifiedName& name) {
+    if (isA<SubsumptiveClause>(clause)) {
+        return std::nullopt;
+    }
+    std::vector<std::pair<std::string, std::string>> res;
+    auto head = getVariables(clause.getHead(), name);
+    if (!head || head->first == "_" || head->second == "_") {
+        return std::nullopt;
+    }
+    res.push_back(*head);
+    for (const auto* literal : clause.getBodyLiterals()) {
+        auto atom = getVariables(literal, name);
+        if (!atom) {
+            return std::nullopt;
+        }
+        res.push_back(*atom);
+    }
+    return res;
+}
+
+/** Whether the clause is `r(x,y) :- r(y,x).` */
+bool isSymmetry(const std::vector<std::pair<std::string, std::string>>& atoms) {
+    const auto& [x, y] = atoms[0];
+    return atoms.size() == 2 && x != y && atoms[1] == std::make_pair(y, x);
+}
+
+/** Whether the clause is `r(x,z) :- r(x,y), r(y,z).`, with the body atoms in any order */
+bool isTransitivity(const std::vector<std::pair<std::string, std::string>>& atoms) {
+    if (atoms.size() != 3) {
+        return false;
+    }
+    const auto& [x, z] = atoms[0];
+    auto isChain = [&](const auto& first, const auto& second) {
+        const std::string& y = first.second;
+        return first.first == x && second.first == y && second.second == z && y != x && y != z && y != "_";
+    };
+    return x != z && (isChain(atoms[1], atoms[2]) || isChain(atoms[2], atoms[1]));
+}
+
+/** Whether the clause is `r(x,x) :- r(x,_).` or `r(x,x) :- r(_,x).`, implied by symmetry and transitivity */
+bool isReflexivity(const std::vector<std::pair<std::string, std::string>>& atoms) {
+    const auto& [x, y] = atoms[0];
+    return atoms.size() == 2 && x == y && (atoms[1].first == x || atoms[1].second == x);
+}
+
+}  // namespace
+
+ProfileGuidedRepresentationTransformer::Choice ProfileGuidedRepresentationTransformer::choose(
+        const Relation& rel, const profile::Relation& profile, bool isEquivalence) {
+    const std::size_t size = profile.size();
+    if (isEquivalence) {
+        if (size < MIN_EQUIVALENCE_SIZE) {
+            return {RelationRepresentation::DEFAULT,
+                    "an equivalence relation of only " + std::to_string(size) + " tuples"};
+        }
+        return {RelationRepresentation::EQREL, "its clauses make it an equivalence relation, whose " +
+                                                       std::to_string(size) +
+                                                       " tuples are stored as disjoint sets of values"};
+    }
+    if (rel.getArity() < MIN_TRIE_ARITY) {
+        return {RelationRepresentation::DEFAULT, "too few columns to share prefixes in a brie"};
+    }
+    if (size < MIN_TRIE_SIZE) {
+        return {RelationRepresentation::DEFAULT, "only " + std::to_string(size) + " tuples"};
+    }
+    const auto& columns = profile.getColumns();
+    if (columns.size() < rel.getArity()) {
+        return {RelationRepresentation::DEFAULT, "the values of its columns are not in the profile"};
+    }
+    double combinations = 1;
+    for (const auto& [position, column] : columns) {
+        if (column.distinct * 2 < column.range) {
+            return {RelationRepresentation::DEFAULT,
+                    "column " + std::to_string(position) + " holds " + std::to_string(column.distinct) +
+                            " values spread over a range of " + std::to_string(column.range)};
+        }
+        combinations *= static_cast<double>(column.distinct);
+    }
+    // a block of a brie holds the values of a column of 64 tuples sharing a prefix
+    const double coverage = static_cast<double>(size) / combinations;
+    const std::string percentage = std::to_string(static_cast<int>(coverage * 100)) + "%";
+    if (coverage * 64 < 1) {
+        return {RelationRepresentation::DEFAULT, "its " + std::to_string(size) + " tuples cover only " +
+                                                         percentage +
+                                                         " of the combinations of the values of its columns"};
+    }
+    return {RelationRepresentation::BRIE, "its " + std::to_string(size) + " tuples cover " + percentage +
+                                                  " of the combinations of the dense values of its columns"};
+}
+
+bool ProfileGuidedRepresentationTransformer::transform(TranslationUnit& translationUnit) {
+    bool changed = false;
+    Program& program = translationUnit.getProgram();
+    const auto& profileUse = translationUnit.getAnalysis<analysis::ProfileUseAnalysis>();
+
+    std::stringstream report;
+    for (auto* rel : program.getRelations()) {
+        // explicit representations, and the relations of functional dependencies, are kept
+        if (rel->getRepresentation() != RelationRepresentation::DEFAULT ||
+                !rel->getFunctionalDependencies().empty() || rel->hasQualifier(RelationQualifier::INLINE)) {
+            continue;
+        }
+        const auto* profile = profileUse.getProfiledRelation(rel->getQualifiedName());
+        if (profile == nullptr) {
+            continue;
+        }
+
+        // the clauses of an equivalence relation implied by its representation as an eqrel
+        std::vector<const Clause*> implied;
+        bool isSymmetric = false;
+        bool isTransitive = false;
+        const auto& attributes = rel->getAttributes();
+        if (rel->getArity() == 2 && attributes[0]->getTypeName() == attributes[1]->getTypeName()) {
+            for (const auto* clause : program.getClauses(*rel)) {
+                auto atoms = getClauseVariables(*clause, rel->getQualifiedName());
+                if (!atoms) {
+                    continue;
+                }
+                isSymmetric = isSymmetric || isSymmetry(*atoms);
+                isTransitive = isTransitive || isTransitivity(*atoms);
+                if (isSymmetry(*atoms) || isTransitivity(*atoms) || isReflexivity(*atoms)) {
+                    implied.push_back(clause);
+                }
+            }
+        }
+
+        const auto choice = choose(*rel, *profile, isSymmetric && isTransitive);
+        std::size_t inserts = 0;
+        std::size_t probes = 0;
+        std::size_t scans = 0;
+        for (const auto& [index, access] : profile->getIndexAccess()) {
+            inserts = std::max(inserts, access.inserts);
+            probes += access.probes;
+            scans += access.scans;
+        }
+        report << rel->getQualifiedName() << ": ";
+        if (choice.representation == RelationRepresentation::DEFAULT) {
+            report << "btree";
+        } else {
+            report << choice.representation;
+        }
+        report << ", " << choice.reason << " (" << inserts << " inserts, " << probes << " probes, " << scans
+               << " scans)\n";
+
+        if (choice.representation != RelationRepresentation::DEFAULT) {
+            rel->setRepresentation(choice.representation);
+            if (choice.representation == RelationRepresentation::EQREL) {
+                program.removeClauses(implied);
+            }
+            changed = true;
+        }
+    }
+
+    if (Global::config().has("show", "representations")) {
+        std::cout << report.str();
+    }
+    if (Global::config().has("debug-report")) {
+        translationUnit.getDebugReport().addSection(
+                "representations", "Representations chosen from the profile", report.str());
+    }
+    return changed;
+}
+
+}  // namespace souffle::ast::transform
@@ -0,0 +1,67 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProfileGuidedRepresentation.h
+ *
+ * Transformation choosing the representation of the relations without
+ * an explicit one from a profile given by `profile-use`.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "RelationTag.h"
+#include "ast/Relation.h"
+#include "ast/TranslationUnit.h"
+#include "ast/transform/Transformer.h"
+#include "souffle/profile/Relation.h"
+#include <string>
+
+namespace souffle::ast::transform {
+
+/**
+ * Choose the representation of the relations of the default representation from the sizes, the
+ * accesses of the indexes and the values of the columns of the relations recorded in a profile:
+ *
+ *  - a large relation whose clauses close it under symmetry and transitivity becomes an eqrel, and
+ *    the clauses implied by the eqrel are removed;
+ *  - a large relation of at least three columns, whose tuples densely cover the values of its
+ *    columns, becomes a brie, whose tries share the prefixes of the tuples.
+ *
+ * The choices and their reasons are listed by `--show=representations` and in the debug report.
+ */
+class ProfileGuidedRepresentationTransformer : public Transformer {
+public:
+    /** The representation chosen for a relation, where DEFAULT keeps the b-tree, and the reason */
+    struct Choice {
+        RelationRepresentation representation;
+        std::string reason;
+    };
+
+    std::string getName() const override {
+        return "ProfileGuidedRepresentationTransformer";
+    }
+
+    /**
+     * Choose the representation of a relation from its profile
+     *
+     * @param isEquivalence whether the clauses of the relation close it under symmetry and transitivity
+     */
+    static Choice choose(const Relation& rel, const profile::Relation& profile, bool isEquivalence);
+
+private:
+    ProfileGuidedRepresentationTransformer* cloning() const override {
+        return new ProfileGuidedRepresentationTransformer();
+    }
+
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
+}  // namespace souffle::ast::transform
@@ -0,0 +1,197 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RecursiveAggregates.cpp
+ *
+ ***********************************************************************/
+
+#include "ast/transform/RecursiveAggregates.h"
+#include "AggregateOp.h"
+#include "RelationTag.h"
+#include "ast/Aggregator.h"
+#include "ast/Argument.h"
+#include "ast/Atom.h"
+#include "ast/BinaryConstraint.h"
+#include "ast/Clause.h"
+#include "ast/Literal.h"
+#include "ast/Program.h"
+#include "ast/Relation.h"
+#include "ast/SubsumptiveClause.h"
+#include "ast/TranslationUnit.h"
+#include "ast/Variable.h"
+#include "ast/analysis/SCCGraph.h"
+#include "ast/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ast::transform {
+
+namespace {
+
+/** An aggregate `v = min e : { ... }` of a clause, whose variable v is a head argument */
+struct HeadAggregate {
+    const Clause* clause;
+    const Literal* binding;
+    const Aggregator* aggregator;
+    std::size_t position;
+};
+
+/** Find the only aggregate of a clause if it binds a head argument, and nothing else */
+std::optional<HeadAggregate> getHeadAggregate(const Clause& clause) {
+    std::size_t aggregates = 0;
+    visit(clause, [&](const Aggregator&) { aggregates++; });
+    if (aggregates != 1) {
+        return std::nullopt;
+    }
+
+    for (const auto* literal : clause.getBodyLiterals()) {
+        const auto* constraint = as<BinaryConstraint>(literal);
+        if (constraint == nullptr || constraint->getBaseOperator() != BinaryConstraintOp::EQ) {
+            continue;
+        }
+        const auto* variable = as<Variable>(constraint->getLHS());
+        const auto* aggregator = as<Aggregator>(constraint->getRHS());
+        if (variable == nullptr || aggregator == nullptr) {
+            variable = as<Variable>(constraint->getRHS());
+            aggregator = as<Aggregator>(constraint->getLHS());
+        }
+        if (variable == nullptr || aggregator == nullptr) {
+            continue;
+        }
+        const AggregateOp op = aggregator->getBaseOperator();
+        if ((op != AggregateOp::MIN && op != AggregateOp::MAX) ||
+                aggregator->getTargetExpression() == nullptr) {
+            return std::nullopt;
+        }
+
+        // the variable of the aggregate only occurs in the head besides its binding
+        std::size_t occurrences = 0;
+        visit(clause, [&](const Variable& var) {
+            if (var.getName() == variable->getName()) {
+                occurrences++;
+            }
+        });
+        const auto arguments = clause.getHead()->getArguments();
+        for (std::size_t i = 0; i < arguments.size(); i++) {
+            const auto* argument = as<Variable>(arguments[i]);
+            if (argument != nullptr && argument->getName() == variable->getName() && occurrences == 2) {
+                return HeadAggregate{&clause, literal, aggregator, i};
+            }
+        }
+        return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+/** Produce the candidate values of the group of an aggregate, rather than their best value */
+Own<Clause> flattenAggregate(const HeadAggregate& aggregate) {
+    const Clause& clause = *aggregate.clause;
+    const Atom* head = clause.getHead();
+
+    auto candidate = mk<Atom>(head->getQualifiedName(), VecOwn<Argument>{}, head->getSrcLoc());
+    const auto arguments = head->getArguments();
+    for (std::size_t i = 0; i < arguments.size(); i++) {
+        candidate->addArgument(i == aggregate.position ? clone(aggregate.aggregator->getTargetExpression())
+                                                       : clone(arguments[i]));
+    }
+
+    VecOwn<Literal> body;
+    for (const auto* literal : clause.getBodyLiterals()) {
+        if (literal != aggregate.binding) {
+            body.push_back(clone(literal));
+        }
+    }
+    for (const auto* literal : aggregate.aggregator->getBodyLiterals()) {
+        body.push_back(clone(literal));
+    }
+    return mk<Clause>(std::move(candidate), std::move(body), nullptr, clause.getSrcLoc());
+}
+
+/** Keep the best value of each group, e.g. `R(x0, v) <= R(x0, w) :- w <= v.` for minima */
+Own<Clause> createDominance(const Relation& relation, std::size_t position, bool minimal) {
+    auto atom = [&](const std::string& value) {
+        auto result = mk<Atom>(relation.getQualifiedName());
+        for (std::size_t i = 0; i < relation.getArity(); i++) {
+            result->addArgument(mk<Variable>(i == position ? value : "x" + std::to_string(i)));
+        }
+        return result;
+    };
+    auto dominance = mk<SubsumptiveClause>(atom("v"), relation.getSrcLoc());
+    dominance->addToBody(atom("v"));
+    dominance->addToBody(atom("w"));
+    dominance->addToBody(mk<BinaryConstraint>(minimal ? BinaryConstraintOp::LE : BinaryConstraintOp::GE,
+            mk<Variable>("w"), mk<Variable>("v")));
+    return dominance;
+}
+
+}  // namespace
+
+bool RecursiveAggregatesTransformer::transform(TranslationUnit& translationUnit) {
+    bool changed = false;
+    Program& program = translationUnit.getProgram();
+    const auto& sccGraph = translationUnit.getAnalysis<analysis::SCCGraphAnalysis>();
+
+    for (const auto* relation : program.getRelations()) {
+        // the best values are kept by subsumption, which needs the default representation
+        if (relation->getRepresentation() != RelationRepresentation::DEFAULT) {
+            continue;
+        }
+        const std::size_t scc = sccGraph.getSCC(relation);
+        std::vector<HeadAggregate> aggregates;
+        bool rewritable = true;
+        bool recursive = false;
+        for (const auto* clause : program.getClauses(*relation)) {
+            // other subsumptive clauses would mix with the dominance of the best values
+            if (isA<SubsumptiveClause>(clause)) {
+                rewritable = false;
+                break;
+            }
+            if (!visitExists(*clause, [](const Aggregator&) { return true; })) {
+                continue;
+            }
+            auto aggregate = getHeadAggregate(*clause);
+            if (!aggregate.has_value() ||
+                    (!aggregates.empty() &&
+                            (aggregate->position != aggregates.front().position ||
+                                    aggregate->aggregator->getBaseOperator() !=
+                                            aggregates.front().aggregator->getBaseOperator()))) {
+                rewritable = false;
+                break;
+            }
+            recursive |= visitExists(*aggregate->aggregator, [&](const Atom& atom) {
+                const auto* other = program.getRelation(atom);
+                return other != nullptr && sccGraph.getSCC(other) == scc;
+            });
+            aggregates.push_back(*aggregate);
+        }
+
+        // stratified aggregates are evaluated as they are
+        if (!rewritable || !recursive) {
+            continue;
+        }
+
+        const std::size_t position = aggregates.front().position;
+        const bool minimal = aggregates.front().aggregator->getBaseOperator() == AggregateOp::MIN;
+        for (const auto& aggregate : aggregates) {
+            program.addClause(flattenAggregate(aggregate));
+            program.removeClause(*aggregate.clause);
+        }
+        program.addClause(createDominance(*relation, position, minimal));
+        changed = true;
+    }
+    return changed;
+}
+
+}  // namespace souffle::ast::transform
@@ -0,0 +1,58 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RecursiveAggregates.h
+ *
+ * Transformation evaluating min and max aggregates through recursion as
+ * subsumption, keeping the best value of each group.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ast/TranslationUnit.h"
+#include "ast/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ast::transform {
+
+/**
+ * Rewrite the clauses of a relation aggregating over its own SCC, such as
+ *
+ *     dist(y, d) :- d = min d0 : { dist(x, d1), edge(x, y, w), d0 = d1 + w }.
+ *
+ * into clauses producing the candidate values of each group,
+ *
+ *     dist(y, d1 + w) :- dist(x, d1), edge(x, y, w).
+ *     dist(x0, v) <= dist(x0, w) :- w <= v.
+ *
+ * such that the relation keeps the best value of each group, and the
+ * seminaive evaluation only propagates the groups whose value improved.
+ *
+ * A relation is rewritten only if all of its aggregates are min (or all
+ * max) aggregates binding the same head attribute, which occurs nowhere
+ * else in their clauses; otherwise the recursion is left for the semantic
+ * checker to report.
+ */
+class RecursiveAggregatesTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "RecursiveAggregatesTransformer";
+    }
+
+private:
+    RecursiveAggregatesTransformer* cloning() const override {
+        return new RecursiveAggregatesTransformer();
+    }
+
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
+}  // namespace souffle::ast::transform
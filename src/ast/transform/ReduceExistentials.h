@@ -19,6 +19,7 @@
 
 #include "ast/TranslationUnit.h"
 #include "ast/transform/Transformer.h"
+#include <set>
 #include <string>
 
 namespace souffle::ast::transform {
@@ -33,6 +34,10 @@ public:
         return "ReduceExistentialsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDeclarationAnalyses();
+    }
+
 private:
     ReduceExistentialsTransformer* cloning() const override {
         return new ReduceExistentialsTransformer();
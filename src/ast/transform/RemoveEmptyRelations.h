@@ -17,6 +17,7 @@
 #include "ast/QualifiedName.h"
 #include "ast/TranslationUnit.h"
 #include "ast/transform/Transformer.h"
+#include <set>
 #include <string>
 
 namespace souffle::ast::transform {
@@ -30,6 +31,10 @@ public:
         return "RemoveEmptyRelationsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDeclarationAnalyses();
+    }
+
     /**
      * Eliminate all empty relations (and their uses) in the given program.
      *
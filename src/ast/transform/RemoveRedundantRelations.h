@@ -16,6 +16,7 @@
 
 #include "ast/TranslationUnit.h"
 #include "ast/transform/Transformer.h"
+#include <set>
 #include <string>
 
 namespace souffle::ast::transform {
@@ -29,6 +30,10 @@ public:
         return "RemoveRedundantRelationsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDeclarationAnalyses();
+    }
+
 private:
     RemoveRedundantRelationsTransformer* cloning() const override {
         return new RemoveRedundantRelationsTransformer();
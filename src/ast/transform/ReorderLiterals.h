@@ -19,6 +19,7 @@
 #include "ast/TranslationUnit.h"
 #include "ast/transform/Transformer.h"
 #include <functional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,10 @@ public:
         return "ReorderLiteralsTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDependencyAnalyses();
+    }
+
     /**
      * Reorder the clause based on a given SIPS function.
      * @param sipsFunction SIPS metric to use
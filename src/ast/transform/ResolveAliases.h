@@ -19,6 +19,7 @@
 #include "ast/transform/Transformer.h"
 #include "souffle/utility/ContainerUtil.h"
 #include <memory>
+#include <set>
 #include <string>
 
 namespace souffle::ast::transform {
@@ -34,6 +35,10 @@ public:
         return "ResolveAliasesTransformer";
     }
 
+    std::set<std::string> getPreservedAnalyses() const override {
+        return getDeclarationAnalyses();
+    }
+
     /**
      * ResolveAliasesTransformer cannot be disabled.
      */
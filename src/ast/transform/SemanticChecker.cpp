@@ -665,6 +665,27 @@ void SemanticCheckerImpl::checkIO() {
     for (const auto* directive : program.getDirectives()) {
         checkIO(directive);
     }
+
+    // queried relations are given as <relation>[:<pattern>], where the pattern binds (b) or frees (f)
+    // each column
+    for (const auto& entry : splitString(Global::config().get("query-relations"), ',')) {
+        const std::size_t colon = entry.find(':');
+        const std::string name = entry.substr(0, colon);
+        const auto* relation = program.getRelation(QualifiedName(splitString(name, '.')));
+        if (relation == nullptr) {
+            report.addError("Undefined queried relation " + name, {});
+            continue;
+        }
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string pattern = entry.substr(colon + 1);
+        if (pattern.size() != relation->getArity() ||
+                pattern.find_first_not_of("bf") != std::string::npos) {
+            report.addError("Invalid query pattern " + pattern + " of relation " + name,
+                    relation->getSrcLoc());
+        }
+    }
 }
 
 /**
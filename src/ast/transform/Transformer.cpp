@@ -16,7 +16,18 @@
 
 #include "ast/transform/Transformer.h"
 #include "ast/TranslationUnit.h"
+#include "ast/analysis/Functor.h"
+#include "ast/analysis/IOType.h"
+#include "ast/analysis/PrecedenceGraph.h"
+#include "ast/analysis/RedundantRelations.h"
+#include "ast/analysis/RelationSchedule.h"
+#include "ast/analysis/SCCGraph.h"
+#include "ast/analysis/TopologicallySortedSCCGraph.h"
+#include "ast/analysis/typesystem/SumTypeBranches.h"
+#include "ast/analysis/typesystem/TypeEnvironment.h"
+#include "ast/transform/Meta.h"
 #include "reports/ErrorReport.h"
+#include "souffle/utility/MiscUtil.h"
 
 namespace souffle::ast::transform {
 
@@ -24,8 +35,9 @@ bool Transformer::apply(TranslationUnit& translationUnit) {
     // invoke the transformation
     bool changed = transform(translationUnit);
 
-    if (changed) {
-        translationUnit.invalidateAnalyses();
+    // meta-transformers leave the invalidation to their sub-transformers
+    if (changed && !isA<MetaTransformer>(this)) {
+        translationUnit.invalidateAnalyses(getPreservedAnalyses());
     }
 
     /* Abort evaluation of the program if errors were encountered */
@@ -34,4 +46,17 @@ bool Transformer::apply(TranslationUnit& translationUnit) {
     return changed;
 }
 
+std::set<std::string> Transformer::getDeclarationAnalyses() {
+    return {analysis::FunctorAnalysis::name, analysis::SumTypeBranchesAnalysis::name,
+            analysis::TypeEnvironmentAnalysis::name};
+}
+
+std::set<std::string> Transformer::getDependencyAnalyses() {
+    std::set<std::string> res = getDeclarationAnalyses();
+    res.insert({analysis::IOTypeAnalysis::name, analysis::PrecedenceGraphAnalysis::name,
+            analysis::RedundantRelationsAnalysis::name, analysis::RelationScheduleAnalysis::name,
+            analysis::SCCGraphAnalysis::name, analysis::TopologicallySortedSCCGraphAnalysis::name});
+    return res;
+}
+
 }  // namespace souffle::ast::transform
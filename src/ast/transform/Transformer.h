@@ -18,6 +18,7 @@
 
 #include "ast/TranslationUnit.h"
 #include "souffle/utility/Types.h"
+#include <set>
 #include <string>
 
 namespace souffle::ast::transform {
@@ -33,6 +34,15 @@ public:
 
     virtual std::string getName() const = 0;
 
+    /**
+     * Names of the analyses that remain valid when the transformer changes the
+     * program. All other analyses are invalidated, as are preserved analyses
+     * computed from invalidated ones.
+     */
+    virtual std::set<std::string> getPreservedAnalyses() const {
+        return {};
+    }
+
     /**
      * Transformers can be disabled by command line
      * with --disable-transformer. Default behaviour
@@ -46,6 +56,16 @@ public:
         return Own<Transformer>(cloning());
     }
 
+protected:
+    /** Analyses of the declarations of types and functors, preserved by transformers rewriting clauses */
+    static std::set<std::string> getDeclarationAnalyses();
+
+    /**
+     * Analyses of the declarations and of the dependencies between relations, preserved by transformers
+     * rewriting clauses without changing their atoms
+     */
+    static std::set<std::string> getDependencyAnalyses();
+
 private:
     virtual Transformer* cloning() const = 0;
 };
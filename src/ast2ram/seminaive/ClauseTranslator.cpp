@@ -21,6 +21,7 @@
 #include "ast/BranchInit.h"
 #include "ast/Clause.h"
 #include "ast/Constant.h"
+#include "ast/ExecutionPlan.h"
 #include "ast/IntrinsicFunctor.h"
 #include "ast/NilConstant.h"
 #include "ast/NumericConstant.h"
@@ -49,6 +50,7 @@
 #include "ram/LogRelationTimer.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
+#include "ram/NoveltyInsert.h"
 #include "ram/Query.h"
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
@@ -59,7 +61,9 @@
 #include "ram/UnsignedConstant.h"
 #include "ram/utility/Utils.h"
 #include "souffle/utility/StringUtil.h"
+#include <algorithm>
 #include <map>
+#include <sstream>
 #include <vector>
 
 namespace souffle::ast2ram::seminaive {
@@ -184,6 +188,23 @@ std::string ClauseTranslator::getClauseAtomName(const ast::Clause& clause, const
     return getConcreteRelationName(atom->getQualifiedName());
 }
 
+std::string ClauseTranslator::getPlanAtomText(const ast::Clause& clause, const ast::Atom* atom) const {
+    const auto atoms = ast::getBodyLiterals<ast::Atom>(clause);
+    const std::size_t literal = std::find(atoms.begin(), atoms.end(), atom) - atoms.begin() + 1;
+    auto unplanned = clone(clause);
+    unplanned->clearExecutionPlan();
+    std::string plan = clause.getExecutionPlan() != nullptr ? toString(*clause.getExecutionPlan()) : "";
+
+    std::stringstream ss;
+    ss << "@plan-atom" << ';';
+    ss << version << ';';
+    ss << literal << ';';
+    ss << atoms.size() << ';';
+    ss << stringify(toString(*unplanned)) << ';';
+    ss << stringify(plan) << ';';
+    return ss.str();
+}
+
 Own<ram::Statement> ClauseTranslator::createRamFactQuery(const ast::Clause& clause) const {
     assert(isFact(clause) && "clause should be fact");
     assert(!isRecursive() && "recursive clauses cannot have facts");
@@ -244,6 +265,12 @@ Own<ram::Operation> ClauseTranslator::createInsertion(const ast::Clause& clause)
                 mk<ram::Insert>(headRelationName, std::move(values)));
     }
 
+    // Relations inserted directly record the tuples new to them in their new relation
+    if (isRecursive() && context.isInsertedDirectly(context.getProgram()->getRelation(*head))) {
+        return mk<ram::NoveltyInsert>(
+                getConcreteRelationName(head->getQualifiedName()), std::move(values), headRelationName);
+    }
+
     // Relations with functional dependency constraints
     if (auto guardedConditions = getFunctionalDependencies(clause)) {
         return mk<ram::GuardedInsert>(headRelationName, std::move(values), std::move(guardedConditions));
@@ -285,6 +312,9 @@ Own<ram::Operation> ClauseTranslator::addAtomScan(
             ss << stringify(toString(clause)) << ';';
             ss << curLevel << ';';
         }
+        if (Global::config().has("emit-plans") && !isA<ast::SubsumptiveClause>(clause)) {
+            ss << getPlanAtomText(clause, atom);
+        }
         op = mk<ram::Scan>(getClauseAtomName(clause, atom), curLevel, std::move(op), ss.str());
     }
 
@@ -304,7 +334,7 @@ Own<ram::Operation> ClauseTranslator::addRecordUnpack(
 
 Own<ram::Operation> ClauseTranslator::addAdtUnpack(
         Own<ram::Operation> op, const ast::BranchInit* adt, int curLevel) const {
-    assert(!context.isADTEnum(adt) && "ADT enums should not be unpacked");
+    assert(!context.isADTBranchUnboxed(adt) && "ADT branches without arguments should not be unpacked");
 
     std::vector<ast::Argument*> branchArguments;
 
@@ -343,6 +373,13 @@ Own<ram::Operation> ClauseTranslator::addAdtUnpack(
     // add an unpack level for main record
     op = mk<ram::UnpackRecord>(std::move(op), branchLevel, makeRamTupleElement(loc), 2);
 
+    // branches without arguments are no records to unpack
+    if (context.hasADTUnboxedBranches(adt)) {
+        op = mk<ram::Filter>(mk<ram::Constraint>(BinaryConstraintOp::GE, makeRamTupleElement(loc),
+                                     mk<ram::SignedConstant>(0)),
+                std::move(op));
+    }
+
     return op;
 }
 
@@ -543,9 +580,10 @@ Own<ram::Operation> ClauseTranslator::addBodyLiteralConstraints(
     }
 
     if (isRecursive()) {
-        if (clause.getHead()->getArity() > 0) {
+        const auto* head = clause.getHead();
+        if (head->getArity() > 0 && !context.isInsertedDirectly(context.getProgram()->getRelation(*head))) {
             // also negate the head
-            op = addNegatedAtom(std::move(op), clause, clause.getHead());
+            op = addNegatedAtom(std::move(op), clause, head);
         }
 
         // also add in prev stuff
@@ -609,9 +647,9 @@ Own<ram::Operation> ClauseTranslator::addConstantConstraints(
             auto rhs = translateConstant(*constant);
             op = addEqualityCheck(std::move(op), std::move(lhs), std::move(rhs), false);
         } else if (const auto* adt = as<ast::BranchInit>(argument)) {
-            if (context.isADTEnum(adt)) {
+            if (context.isADTBranchUnboxed(adt)) {
                 auto lhs = mk<ram::TupleElement>(curLevel, i);
-                auto rhs = mk<ram::SignedConstant>(context.getADTBranchId(adt));
+                auto rhs = mk<ram::SignedConstant>(context.getADTBranchValue(adt));
                 op = addEqualityCheck(std::move(op), std::move(lhs), std::move(rhs), false);
             }
         }
@@ -740,7 +778,7 @@ void ClauseTranslator::indexNodeArguments(int nodeLevel, const std::vector<ast::
 
         // check for nested ADT branches
         if (const auto* adt = as<ast::BranchInit>(arg)) {
-            if (!context.isADTEnum(adt)) {
+            if (!context.isADTBranchUnboxed(adt)) {
                 valueIndex->setAdtDefinition(*adt, nodeLevel, i);
                 auto unpackLevel = addOperatorLevel(adt);
 
@@ -69,6 +69,9 @@ protected:
 
     std::string getClauseAtomName(const ast::Clause& clause, const ast::Atom* atom) const;
 
+    /** Describe the position of an atom in the clause, for plans that are determined during evaluation */
+    std::string getPlanAtomText(const ast::Clause& clause, const ast::Atom* atom) const;
+
     virtual Own<ram::Operation> addNegatedAtom(
             Own<ram::Operation> op, const ast::Clause& clause, const ast::Atom* atom) const;
     virtual Own<ram::Operation> addNegatedDeltaAtom(Own<ram::Operation> op, const ast::Atom* atom) const;
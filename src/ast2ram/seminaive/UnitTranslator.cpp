@@ -17,17 +17,23 @@
 #include "LogStatement.h"
 #include "ast/Clause.h"
 #include "ast/Directive.h"
+#include "ast/NumericConstant.h"
 #include "ast/Relation.h"
+#include "ast/StringConstant.h"
 #include "ast/SubsumptiveClause.h"
 #include "ast/TranslationUnit.h"
+#include "ast/analysis/SCCGraph.h"
 #include "ast/analysis/TopologicallySortedSCCGraph.h"
 #include "ast/utility/Utils.h"
 #include "ast/utility/Visitor.h"
 #include "ast2ram/ClauseTranslator.h"
 #include "ast2ram/utility/TranslatorContext.h"
 #include "ast2ram/utility/Utils.h"
+#include "ram/AutoIncrement.h"
 #include "ram/Call.h"
+#include "ram/Checkpoint.h"
 #include "ram/Clear.h"
+#include "ram/CompactTables.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
 #include "ram/Constraint.h"
@@ -38,7 +44,9 @@
 #include "ram/Exit.h"
 #include "ram/Expression.h"
 #include "ram/Filter.h"
+#include "ram/Guard.h"
 #include "ram/IO.h"
+#include "ram/IndexScan.h"
 #include "ram/Insert.h"
 #include "ram/LogRelationTimer.h"
 #include "ram/LogSize.h"
@@ -55,24 +63,37 @@
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
 #include "ram/Statement.h"
+#include "ram/StratumCache.h"
+#include "ram/SubroutineArgument.h"
+#include "ram/SubroutineReturn.h"
 #include "ram/Swap.h"
 #include "ram/TranslationUnit.h"
 #include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
 #include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
 #include "reports/DebugReport.h"
 #include "reports/ErrorReport.h"
 #include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
 #include "souffle/TypeAttribute.h"
+#include "souffle/io/BinaryFormat.h"
+#include "souffle/io/Checkpoint.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/FunctionalUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/StringUtil.h"
+#include "souffle/utility/json11.h"
 #include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -81,6 +102,13 @@
 
 namespace souffle::ast2ram::seminaive {
 
+namespace {
+
+/** Minimal number of facts of a relation loaded from a table rather than inserted one by one */
+constexpr std::size_t FACT_TABLE_THRESHOLD = 256;
+
+}  // namespace
+
 UnitTranslator::UnitTranslator() : ast2ram::UnitTranslator() {}
 
 UnitTranslator::~UnitTranslator() = default;
@@ -94,16 +122,53 @@ Own<ram::Statement> UnitTranslator::generateClearRelation(const ast::Relation* r
     return mk<ram::Clear>(getConcreteRelationName(relation->getQualifiedName()));
 }
 
+std::map<std::string, std::string> UnitTranslator::getSpillDirectives(const ast::Relation* relation) const {
+    std::string ramRelationName = getConcreteRelationName(relation->getQualifiedName());
+    std::vector<json11::Json> attributeTypes;
+    for (const auto* attribute : relation->getAttributes()) {
+        attributeTypes.push_back(context->getAttributeTypeQualifier(attribute->getTypeName()));
+    }
+    json11::Json types = json11::Json::object{{"relation",
+            json11::Json::object{{"arity", static_cast<long long>(relation->getArity())},
+                    {"types", json11::Json::array(attributeTypes.begin(), attributeTypes.end())}}}};
+
+    std::map<std::string, std::string> directives;
+    directives["IO"] = "spill";
+    directives["name"] = ramRelationName;
+    directives["filename"] = Global::config().get("spill-dir") + "/" + ramRelationName + ".spill";
+    directives["types"] = types.dump();
+    addAuxiliaryArity(relation, directives);
+    return directives;
+}
+
+Own<ram::Statement> UnitTranslator::generateSpillRelation(const ast::Relation* relation) const {
+    auto directives = getSpillDirectives(relation);
+    directives["operation"] = "spill";
+    return mk<ram::Sequence>(mk<ram::IO>(getConcreteRelationName(relation->getQualifiedName()), directives),
+            generateClearRelation(relation));
+}
+
+Own<ram::Statement> UnitTranslator::generateRestoreRelation(const ast::Relation* relation) const {
+    auto directives = getSpillDirectives(relation);
+    directives["operation"] = "restore";
+    return mk<ram::IO>(getConcreteRelationName(relation->getQualifiedName()), directives);
+}
+
 Own<ram::Statement> UnitTranslator::generateNonRecursiveRelation(const ast::Relation& rel) const {
     VecOwn<ram::Statement> result;
 
     // Get relation names
     std::string mainRelation = getConcreteRelationName(rel.getQualifiedName());
 
+    // Load a large set of facts at once
+    std::set<const ast::Clause*> tabledFacts;
+    appendStmt(result, generateFactTable(rel, tabledFacts));
+
     // Iterate over all non-recursive clauses that belong to the relation
     for (auto&& clause : context->getProgram()->getClauses(rel)) {
-        // Skip recursive and subsumptive clauses
-        if (context->isRecursiveClause(clause) || isA<ast::SubsumptiveClause>(clause)) {
+        // Skip recursive and subsumptive clauses, and facts of the table
+        if (context->isRecursiveClause(clause) || isA<ast::SubsumptiveClause>(clause) ||
+                contains(tabledFacts, clause)) {
             continue;
         }
 
@@ -153,27 +218,116 @@ Own<ram::Statement> UnitTranslator::generateNonRecursiveRelation(const ast::Rela
     return mk<ram::Sequence>(std::move(result));
 }
 
-Own<ram::Statement> UnitTranslator::generateStratum(std::size_t scc) const {
+Own<ram::Statement> UnitTranslator::generateFactTable(
+        const ast::Relation& rel, std::set<const ast::Clause*>& tabledFacts) const {
+    // facts carrying provenance annotations or guarded by functional dependencies are inserted one by one
+    if (Global::config().has("provenance") || Global::config().has("incremental") || rel.getArity() == 0 ||
+            !rel.getFunctionalDependencies().empty() || context->getLatticeOrder(&rel).has_value()) {
+        return nullptr;
+    }
+    std::vector<std::string> attributeTypes;
+    for (const auto* attribute : rel.getAttributes()) {
+        attributeTypes.push_back(context->getAttributeTypeQualifier(attribute->getTypeName()));
+    }
+
+    // Write a fact as a line of tab-separated fields, if all its arguments are plain constants
+    auto writeFact = [&](const ast::Clause& clause, std::ostream& out) {
+        std::ostringstream line;
+        line << std::setprecision(std::numeric_limits<RamFloat>::max_digits10);
+        const auto args = clause.getHead()->getArguments();
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            line << (i > 0 ? "\t" : "");
+            if (const auto* str = as<ast::StringConstant>(args[i])) {
+                // tabs, line breaks and null characters do not fit into a line of the table
+                const std::string& symbol = str->getConstant();
+                const bool plain = symbol.find_first_of("\t\r\n", 0, 4) == std::string::npos;
+                if (attributeTypes[i][0] != 's' || !plain) {
+                    return false;
+                }
+                line << symbol;
+                continue;
+            }
+            const auto* num = as<ast::NumericConstant>(args[i]);
+            if (num == nullptr) {
+                return false;
+            }
+            switch (context->getInferredNumericConstantType(*num)) {
+                case ast::NumericConstant::Type::Int:
+                    if (attributeTypes[i][0] != 'i') {
+                        return false;
+                    }
+                    line << RamSignedFromString(num->getConstant(), nullptr, 0);
+                    break;
+                case ast::NumericConstant::Type::Uint:
+                    if (attributeTypes[i][0] != 'u') {
+                        return false;
+                    }
+                    line << RamUnsignedFromString(num->getConstant(), nullptr, 0);
+                    break;
+                case ast::NumericConstant::Type::Float:
+                    if (attributeTypes[i][0] != 'f') {
+                        return false;
+                    }
+                    line << RamFloatFromString(num->getConstant());
+                    break;
+            }
+        }
+        out << line.str() << '\n';
+        return true;
+    };
+
+    std::ostringstream data;
+    for (const auto* clause : context->getProgram()->getClauses(rel)) {
+        if (isFact(*clause) && !isA<ast::SubsumptiveClause>(clause) && writeFact(*clause, data)) {
+            tabledFacts.insert(clause);
+        }
+    }
+    if (tabledFacts.size() < FACT_TABLE_THRESHOLD) {
+        tabledFacts.clear();
+        return nullptr;
+    }
+
+    json11::Json types = json11::Json::object{{"relation",
+            json11::Json::object{{"arity", static_cast<long long>(rel.getArity())},
+                    {"types", json11::Json::array(attributeTypes.begin(), attributeTypes.end())}}}};
+
+    std::map<std::string, std::string> directives;
+    directives["IO"] = "inline";
+    directives["operation"] = "input";
+    directives["name"] = getConcreteRelationName(rel.getQualifiedName());
+    directives["types"] = types.dump();
+    directives["data"] = data.str();
+    addAuxiliaryArity(&rel, directives);
+    return mk<ram::IO>(getConcreteRelationName(rel.getQualifiedName()), std::move(directives));
+}
+
+Own<ram::Statement> UnitTranslator::generateStratum(
+        std::size_t step, std::size_t scc, const std::set<const ast::Relation*>& preloaded) const {
     // Make a new ram statement for the current SCC
     VecOwn<ram::Statement> current;
 
-    // Load all internal input relations from the facts dir with a .facts extension
+    // Load all internal input relations from the facts dir with a .facts extension, unless they are
+    // loaded before the first stratum
     for (const auto& relation : context->getInputRelationsInSCC(scc)) {
-        appendStmt(current, generateLoadRelation(relation));
+        if (!contains(preloaded, relation)) {
+            appendStmt(current, generateLoadRelation(relation));
+        }
     }
 
     // Compute the current stratum
+    VecOwn<ram::Statement> compute;
     const auto& sccRelations = context->getRelationsInSCC(scc);
     if (context->isRecursiveSCC(scc)) {
-        appendStmt(current, generateRecursiveStratum(sccRelations));
+        appendStmt(compute, generateRecursiveStratum(sccRelations));
     } else {
         assert(sccRelations.size() == 1 && "only one relation should exist in non-recursive stratum");
         const auto* rel = *sccRelations.begin();
-        appendStmt(current, generateNonRecursiveRelation(*rel));
+        appendStmt(compute, generateNonRecursiveRelation(*rel));
 
         // issue delete sequence for non-recursive subsumptions
-        appendStmt(current, generateNonRecursiveDelete(sccRelations));
+        appendStmt(compute, generateNonRecursiveDelete(sccRelations));
     }
+    appendStmt(current, generateStratumCache(step, scc, mk<ram::Sequence>(std::move(compute))));
 
     // Store all internal output relations to the output dir with a .csv extension
     for (const auto& relation : context->getOutputRelationsInSCC(scc)) {
@@ -183,6 +337,44 @@ Own<ram::Statement> UnitTranslator::generateStratum(std::size_t scc) const {
     return mk<ram::Sequence>(std::move(current));
 }
 
+Own<ram::Statement> UnitTranslator::generateStratumCache(
+        std::size_t step, std::size_t scc, Own<ram::Statement> compute) const {
+    if (!Global::config().has("stratum-cache")) {
+        return compute;
+    }
+
+    // Strata without rules, e.g., of input relations, are not worth caching. Auto-increment values
+    // differ between runs, and records cannot be stored in snapshots.
+    if (!visitExists(*compute, [](const ram::Query&) { return true; }) ||
+            visitExists(*compute, [](const ram::AutoIncrement&) { return true; })) {
+        return compute;
+    }
+    const auto& sccRelations = context->getRelationsInSCC(scc);
+    std::set<const ast::Relation*> read = context->getReadRelations(step);
+    read.insert(sccRelations.begin(), sccRelations.end());
+    for (const auto* relation : read) {
+        for (const auto* attribute : relation->getAttributes()) {
+            if (!binary_format::isSupported(context->getAttributeTypeQualifier(attribute->getTypeName()))) {
+                return compute;
+            }
+        }
+    }
+
+    auto getNames = [&](const std::set<const ast::Relation*>& relations) {
+        std::set<std::string> names;
+        for (const auto* relation : relations) {
+            names.insert(getConcreteRelationName(relation->getQualifiedName()));
+        }
+        return std::vector<std::string>(names.begin(), names.end());
+    };
+
+    // The key changes whenever the rules of the stratum change
+    std::stringstream key;
+    key << std::hex << std::hash<std::string>()(toString(*compute));
+    return mk<ram::StratumCache>(Global::config().get("stratum-cache"), "stratum_" + toString(step),
+            key.str(), getNames(read), getNames(sccRelations), std::move(compute));
+}
+
 Own<ram::Statement> UnitTranslator::generateClearExpiredRelations(
         const std::set<const ast::Relation*>& expiredRelations) const {
     VecOwn<ram::Statement> stmts;
@@ -232,6 +424,42 @@ Own<ram::Statement> UnitTranslator::generateMergeRelationsWithFilter(const ast::
     return stmt;
 }
 
+Own<ram::Statement> UnitTranslator::generateLatticeDelta(const ast::Relation* rel,
+        const std::string& destRelation, const std::string& srcRelation,
+        const std::string& latticeRelation) const {
+    const std::size_t arity = rel->getArity();
+    const BinaryConstraintOp better = *context->getLatticeOrder(rel);
+    auto tuple = [&]() {
+        VecOwn<ram::Expression> values;
+        for (std::size_t i = 0; i < arity; i++) {
+            values.push_back(mk<ram::TupleElement>(0, i));
+        }
+        return values;
+    };
+    auto key = [&]() {
+        VecOwn<ram::Expression> values;
+        for (std::size_t i = 0; i < arity - 1; i++) {
+            values.push_back(mk<ram::TupleElement>(0, i));
+        }
+        values.push_back(mk<ram::UndefValue>());
+        return values;
+    };
+
+    // insert the tuples better than the tuple of the lattice relation with their key
+    auto improving = mk<ram::Filter>(mk<ram::Constraint>(better, mk<ram::TupleElement>(0, arity - 1),
+                                             mk<ram::TupleElement>(1, arity - 1)),
+            mk<ram::Insert>(destRelation, tuple()));
+    auto improve = mk<ram::Query>(mk<ram::Scan>(srcRelation, 0,
+            mk<ram::IndexScan>(latticeRelation, 1, ram::RamPattern(key(), key()), std::move(improving))));
+
+    // insert the tuples whose key has no tuple in the lattice relation
+    auto fresh = mk<ram::Query>(mk<ram::Scan>(srcRelation, 0,
+            mk<ram::Filter>(mk<ram::Negation>(mk<ram::ExistenceCheck>(latticeRelation, key())),
+                    mk<ram::Insert>(destRelation, tuple()))));
+
+    return mk<ram::Sequence>(std::move(improve), std::move(fresh));
+}
+
 Own<ram::Statement> UnitTranslator::generateMergeRelations(
         const ast::Relation* rel, const std::string& destRelation, const std::string& srcRelation) const {
     VecOwn<ram::Expression> values;
@@ -259,6 +487,7 @@ Own<ram::Statement> UnitTranslator::translateRecursiveClauses(
         const std::set<const ast::Relation*>& scc, const ast::Relation* rel) const {
     assert(contains(scc, rel) && "relation should belong to scc");
     VecOwn<ram::Statement> code;
+    std::set<std::string> deltaRelations;
 
     // Translate each recursive clasue
     for (auto&& clause : context->getProgram()->getClauses(*rel)) {
@@ -272,9 +501,22 @@ Own<ram::Statement> UnitTranslator::translateRecursiveClauses(
         for (auto& clauseVersion : clauseVersions) {
             appendStmt(code, std::move(clauseVersion));
         }
+        for (const auto* atom : getSccAtoms(clause, scc)) {
+            deltaRelations.insert(getDeltaRelationName(atom->getQualifiedName()));
+        }
+    }
+    if (code.empty()) {
+        return mk<ram::Sequence>(std::move(code));
     }
 
-    return mk<ram::Sequence>(std::move(code));
+    // each version is driven by a delta relation, so the rules only fire if one of them changed
+    Own<ram::Condition> unchanged;
+    for (const auto& deltaRelation : deltaRelations) {
+        Own<ram::Condition> empty = mk<ram::EmptinessCheck>(deltaRelation);
+        unchanged = (unchanged == nullptr) ? std::move(empty)
+                                           : mk<ram::Conjunction>(std::move(unchanged), std::move(empty));
+    }
+    return mk<ram::Guard>(mk<ram::Negation>(std::move(unchanged)), mk<ram::Sequence>(std::move(code)));
 }
 
 Own<ram::Statement> UnitTranslator::translateSubsumptiveRecursiveClauses(
@@ -295,6 +537,14 @@ Own<ram::Statement> UnitTranslator::translateSubsumptiveRecursiveClauses(
     // old delta relation can be cleared
     appendStmt(code, mk<ram::Clear>(deltaRelation));
 
+    // lattice relations keep the best tuple of each key on insertion, so tuples are never erased and
+    // the new delta only holds the new tuples improving on the relation
+    if (context->getLatticeOrder(rel).has_value()) {
+        appendStmt(code, generateLatticeDelta(rel, deltaRelation, newRelation, mainRelation));
+        appendStmt(code, mk<ram::Clear>(newRelation));
+        return mk<ram::Sequence>(std::move(code));
+    }
+
     // compute reject set using the subsumptive clauses
     for (const auto* clause : context->getProgram()->getClauses(*rel)) {
         // Skip non-subsumptive clauses
@@ -380,7 +630,9 @@ Own<ram::Statement> UnitTranslator::generateNonRecursiveDelete(
 
     // Generate code for non-recursive subsumption
     for (const ast::Relation* rel : scc) {
-        if (!context->hasSubsumptiveClause(rel->getQualifiedName())) {
+        // lattice relations drop subsumed tuples on insertion
+        if (!context->hasSubsumptiveClause(rel->getQualifiedName()) ||
+                context->getLatticeOrder(rel).has_value()) {
             continue;
         }
 
@@ -467,7 +719,11 @@ Own<ram::Statement> UnitTranslator::generateStratumTableUpdates(
 
         // swap new and and delta relation and clear new relation afterwards (if not a subsumptive relation)
         Own<ram::Statement> updateRelTable;
-        if (!context->hasSubsumptiveClause(rel->getQualifiedName())) {
+        if (context->isInsertedDirectly(rel)) {
+            // the main relation holds the new tuples already
+            updateRelTable = mk<ram::Sequence>(
+                    mk<ram::Swap>(deltaRelation, newRelation), mk<ram::Clear>(newRelation));
+        } else if (!context->hasSubsumptiveClause(rel->getQualifiedName())) {
             updateRelTable = mk<ram::Sequence>(generateMergeRelations(rel, mainRelation, newRelation),
                     mk<ram::Swap>(deltaRelation, newRelation), mk<ram::Clear>(newRelation));
         } else {
@@ -551,6 +807,14 @@ Own<ram::Statement> UnitTranslator::generateStratumExitSequence(
         }
     }
 
+    // (3) if any goal relation is no longer empty
+    for (const ast::Relation* rel : scc) {
+        if (context->isGoal(rel)) {
+            appendStmt(exitConditions, mk<ram::Exit>(mk<ram::Negation>(mk<ram::EmptinessCheck>(
+                                               getConcreteRelationName(rel->getQualifiedName())))));
+        }
+    }
+
     return mk<ram::Sequence>(std::move(exitConditions));
 }
 
@@ -638,6 +902,25 @@ Own<ram::Relation> UnitTranslator::createRamRelation(
     if (representation == RelationRepresentation::BTREE_DELETE && ramRelationName[0] == '@') {
         representation = RelationRepresentation::DEFAULT;
     }
+    // the auxiliary relations of a sharded relation only live within its stratum, hence are not placed
+    if (representation == RelationRepresentation::SHARDED && ramRelationName[0] == '@') {
+        representation = RelationRepresentation::DEFAULT;
+    }
+    if (context->isSmall(baseRelation)) {
+        representation = RelationRepresentation::SMALL;
+    } else if (context->isCounted(baseRelation)) {
+        representation = RelationRepresentation::COUNTER;
+    }
+    // the delta and new relations of a relation inserted directly only ever receive distinct tuples
+    const auto& name = baseRelation->getQualifiedName();
+    if ((ramRelationName == getDeltaRelationName(name) || ramRelationName == getNewRelationName(name)) &&
+            context->isInsertedDirectly(baseRelation)) {
+        representation = RelationRepresentation::VECTOR;
+    }
+    std::optional<BinaryConstraintOp> latticeOp;
+    if (representation == RelationRepresentation::BTREE_DELETE) {
+        latticeOp = context->getLatticeOrder(baseRelation);
+    }
 
     std::vector<std::string> attributeNames;
     std::vector<std::string> attributeTypeQualifiers;
@@ -646,8 +929,8 @@ Own<ram::Relation> UnitTranslator::createRamRelation(
         attributeTypeQualifiers.push_back(context->getAttributeTypeQualifier(attribute->getTypeName()));
     }
 
-    return mk<ram::Relation>(
-            ramRelationName, arity, 0, attributeNames, attributeTypeQualifiers, representation);
+    return mk<ram::Relation>(ramRelationName, arity, 0, attributeNames, attributeTypeQualifiers,
+            representation, latticeOp);
 }
 
 VecOwn<ram::Relation> UnitTranslator::createRamRelations(const std::vector<std::size_t>& sccOrdering) const {
@@ -669,8 +952,9 @@ VecOwn<ram::Relation> UnitTranslator::createRamRelations(const std::vector<std::
                 std::string newName = getNewRelationName(rel->getQualifiedName());
                 ramRelations.push_back(createRamRelation(rel, newName));
 
-                // Add auxiliary relation for subsumption
-                if (context->hasSubsumptiveClause(rel->getQualifiedName())) {
+                // Add auxiliary relation for subsumption, except for lattice relations
+                if (context->hasSubsumptiveClause(rel->getQualifiedName()) &&
+                        !context->getLatticeOrder(rel).has_value()) {
                     // Add reject relation
                     std::string rejectName = getRejectRelationName(rel->getQualifiedName());
                     ramRelations.push_back(createRamRelation(rel, rejectName));
@@ -679,7 +963,8 @@ VecOwn<ram::Relation> UnitTranslator::createRamRelations(const std::vector<std::
                     std::string toEraseName = getDeleteRelationName(rel->getQualifiedName());
                     ramRelations.push_back(createRamRelation(rel, toEraseName));
                 }
-            } else if (context->hasSubsumptiveClause(rel->getQualifiedName())) {
+            } else if (context->hasSubsumptiveClause(rel->getQualifiedName()) &&
+                       !context->getLatticeOrder(rel).has_value()) {
                 // Add deletion relation for non recursive subsumptive relations
                 std::string toEraseName = getDeleteRelationName(rel->getQualifiedName());
                 ramRelations.push_back(createRamRelation(rel, toEraseName));
@@ -696,25 +981,248 @@ Own<ram::Sequence> UnitTranslator::generateProgram(const ast::TranslationUnit& t
     }
     const auto& sccOrdering =
             translationUnit.getAnalysis<ast::analysis::TopologicallySortedSCCGraphAnalysis>().order();
+    const auto& sccGraph = translationUnit.getAnalysis<ast::analysis::SCCGraphAnalysis>();
+
+    // With more than one thread, independent strata and the loads of input relations run in parallel
+    bool parallelStrata = Global::config().get("jobs") != "1" && !Global::config().has("profile");
+
+    // Input relations read from files are loaded concurrently before the first stratum, and then stay
+    // resident until they expire. Inputs read from the standard input or from streams keep their place,
+    // as do all inputs of resumed and incremental runs.
+    auto isFileLoad = [](const ast::Directive* load) {
+        const auto& parameters = load->getParameters();
+        auto io = parameters.find("IO");
+        return io == parameters.end() || (!isPrefix("stdin", io->second) && io->second != "stream");
+    };
+    std::set<const ast::Relation*> preloaded;
+    if (parallelStrata && !Global::config().has("resume-from") && !Global::config().has("incremental")) {
+        for (std::size_t scc : sccOrdering) {
+            for (const auto* rel : context->getInputRelationsInSCC(scc)) {
+                if (all_of(context->getLoadDirectives(rel->getQualifiedName()), isFileLoad)) {
+                    preloaded.insert(rel);
+                }
+            }
+        }
+    }
 
-    // Create subroutines for each SCC according to topological order
+    // Generate the main stratum code for each SCC according to topological order
+    VecOwn<ram::Statement> strata;
     for (std::size_t i = 0; i < sccOrdering.size(); i++) {
-        // Generate the main stratum code
-        auto stratum = generateStratum(sccOrdering.at(i));
+        strata.push_back(generateStratum(i, sccOrdering.at(i), preloaded));
+    }
 
-        // Clear expired relations
-        const auto& expiredRelations = context->getExpiredRelations(i);
-        stratum = mk<ram::Sequence>(std::move(stratum), generateClearExpiredRelations(expiredRelations));
+    // Partition the topological order into groups of consecutive, mutually independent strata.
+    // Strata printing to the standard output are kept on their own so that their output is not
+    // interleaved.
+    auto isConcurrent = [&](std::size_t i) {
+        return parallelStrata && !visitExists(*strata[i], [](const ram::IO& io) {
+            const auto& directives = io.getDirectives();
+            auto it = directives.find("IO");
+            return it != directives.end() && isPrefix("stdout", it->second);
+        });
+    };
+    std::vector<std::vector<std::size_t>> groups;
+    for (std::size_t i = 0; i < sccOrdering.size(); i++) {
+        const auto& predecessors = sccGraph.getPredecessorSCCs(sccOrdering.at(i));
+        bool joinsGroup = !groups.empty() && isConcurrent(i) && isConcurrent(groups.back().front()) &&
+                          none_of(groups.back(), [&](std::size_t j) {
+                              return contains(predecessors, sccOrdering.at(j));
+                          });
+        if (joinsGroup) {
+            groups.back().push_back(i);
+        } else {
+            groups.push_back({i});
+        }
+    }
 
-        // Add the subroutine
-        std::string stratumID = "stratum_" + toString(i);
-        addRamSubroutine(stratumID, std::move(stratum));
+    // Groups using each relation, in ascending order
+    std::map<const ast::Relation*, std::vector<std::size_t>> uses;
+    for (std::size_t g = 0; g < groups.size(); g++) {
+        for (std::size_t i : groups[g]) {
+            std::set<const ast::Relation*> used = context->getReadRelations(i);
+            for (const auto* rel : context->getRelationsInSCC(sccOrdering.at(i))) {
+                used.insert(rel);
+            }
+            for (const auto* rel : used) {
+                auto& relUses = uses[rel];
+                if (relUses.empty() || relUses.back() != g) {
+                    relUses.push_back(g);
+                }
+            }
+        }
+    }
+
+    // Spill relations to disk while they are not used by the strata in between, and restore them
+    // before the next stratum reading them
+    bool clearExpired = !Global::config().has("incremental");
+    std::vector<VecOwn<ram::Statement>> spills(groups.size());
+    std::vector<VecOwn<ram::Statement>> restores(groups.size());
+    if (clearExpired && Global::config().has("spill-dir") && !Global::config().has("provenance")) {
+        for (const auto& [rel, relUses] : uses) {
+            for (std::size_t k = 1; k < relUses.size(); k++) {
+                if (relUses[k] > relUses[k - 1] + 1) {
+                    appendStmt(spills[relUses[k - 1]], generateSpillRelation(rel));
+                    appendStmt(restores[relUses[k]], generateRestoreRelation(rel));
+                }
+            }
+        }
+    }
+
+    // Reclaim the records and symbols of expired relations between strata. Spilled relations keep their
+    // values on disk, which cannot be renumbered.
+    const bool compactTables = clearExpired && Global::config().has("compact-tables") &&
+                               !Global::config().has("provenance") && !Global::config().has("spill-dir");
+    const std::string typeDefinitions = compactTables ? context->getTypeDefinitions() : "";
+
+    // Relations held in memory after a group, i.e., created by it or before and not expired by its end
+    std::map<const ast::Relation*, std::size_t> expiries;
+    for (std::size_t g = 0; g < groups.size(); g++) {
+        for (std::size_t i : groups[g]) {
+            for (const auto* rel : context->getExpiredRelations(i)) {
+                expiries.emplace(rel, g);
+            }
+        }
     }
+    auto getResidentRelations = [&](std::size_t g) {
+        std::vector<const ast::Relation*> resident;
+        for (const auto& [rel, relUses] : uses) {
+            auto expiry = expiries.find(rel);
+            if (relUses.front() <= g && (expiry == expiries.end() || expiry->second > g)) {
+                resident.push_back(rel);
+            }
+        }
+        return resident;
+    };
+    auto getCheckpointIO = [&](const ast::Relation* rel, const std::string& directory, std::size_t g,
+                                   const std::string& operation) {
+        auto directives = getSpillDirectives(rel);
+        directives["filename"] = checkpoint::relationFile(directory, directives["name"], g);
+        directives["operation"] = operation;
+        return mk<ram::IO>(getConcreteRelationName(rel->getQualifiedName()), directives);
+    };
 
-    // Invoke all strata
+    // Skip the groups completed by the checkpoint to resume from, and restore the relations resident
+    // after them. The subroutines of the skipped strata are kept, such that the constants of the
+    // program are encoded as in the run that wrote the checkpoint.
     VecOwn<ram::Statement> res;
-    for (std::size_t i = 0; i < sccOrdering.size(); i++) {
-        appendStmt(res, mk<ram::Call>("stratum_" + toString(i)));
+    std::size_t resumedGroups = 0;
+    if (Global::config().has("resume-from")) {
+        const std::string& directory = Global::config().get("resume-from");
+        const auto marker = checkpoint::readMarker(directory);
+        if (!marker) {
+            fatal("no checkpoint to resume from in %s", directory);
+        }
+        if (marker->steps != groups.size() || marker->step + 1 >= groups.size()) {
+            fatal("checkpoint in %s was written by a different program", directory);
+        }
+        appendStmt(res, mk<ram::Checkpoint>(directory, marker->step));
+        for (const auto* rel : getResidentRelations(marker->step)) {
+            appendStmt(res, getCheckpointIO(rel, directory, marker->step, "restore"));
+        }
+        resumedGroups = marker->step + 1;
+    }
+    VecOwn<ram::Statement> loads;
+    for (std::size_t scc : sccOrdering) {
+        for (const auto* rel : context->getInputRelationsInSCC(scc)) {
+            if (contains(preloaded, rel)) {
+                appendStmt(loads, generateLoadRelation(rel));
+            }
+        }
+    }
+    if (loads.size() == 1) {
+        appendStmt(res, std::move(loads.front()));
+    } else if (!loads.empty()) {
+        appendStmt(res, mk<ram::Parallel>(std::move(loads)));
+    }
+
+    // The statements preceding the remaining strata, which are skipped once a goal is satisfied, with
+    // the condition of the goals computed by then being unsatisfied
+    std::vector<std::pair<VecOwn<ram::Statement>, Own<ram::Condition>>> guarded;
+
+    // Create subroutines for each SCC and invoke all strata
+    for (std::size_t g = 0; g < groups.size(); g++) {
+        const auto& group = groups[g];
+        if (g < resumedGroups) {
+            for (std::size_t i : group) {
+                addRamSubroutine("stratum_" + toString(i), std::move(strata[i]));
+            }
+            continue;
+        }
+        for (auto& restore : restores[g]) {
+            appendStmt(res, std::move(restore));
+        }
+        VecOwn<ram::Statement> calls;
+        std::set<const ast::Relation*> expiredRelations;
+        for (std::size_t i : group) {
+            auto stratum = std::move(strata[i]);
+            const auto& expired = context->getExpiredRelations(i);
+            if (!clearExpired) {
+                // Relations must stay resident for incremental re-evaluation
+            } else if (group.size() == 1) {
+                // Clear expired relations
+                stratum = mk<ram::Sequence>(std::move(stratum), generateClearExpiredRelations(expired));
+            } else {
+                // Relations may expire only once all strata of the group have completed
+                expiredRelations.insert(expired.begin(), expired.end());
+            }
+
+            // Add the subroutine
+            std::string stratumID = "stratum_" + toString(i);
+            addRamSubroutine(stratumID, std::move(stratum));
+            appendStmt(calls, mk<ram::Call>(stratumID));
+        }
+
+        if (group.size() == 1) {
+            appendStmt(res, std::move(calls.front()));
+        } else {
+            appendStmt(res, mk<ram::Parallel>(std::move(calls)));
+            if (!expiredRelations.empty()) {
+                appendStmt(res, generateClearExpiredRelations(expiredRelations));
+            }
+        }
+        for (auto& spill : spills[g]) {
+            appendStmt(res, std::move(spill));
+        }
+        if (compactTables && g + 1 < groups.size()) {
+            appendStmt(res, mk<ram::CompactTables>(typeDefinitions));
+        }
+
+        // Write the relations resident after the group, then the tables completing the checkpoint
+        if (Global::config().has("checkpoint-dir") && g + 1 < groups.size()) {
+            const std::string& directory = Global::config().get("checkpoint-dir");
+            std::vector<std::string> files;
+            for (const auto* rel : getResidentRelations(g)) {
+                auto io = getCheckpointIO(rel, directory, g, "spill");
+                files.push_back(io->getDirectives().at("filename"));
+                appendStmt(res, std::move(io));
+            }
+            appendStmt(res, mk<ram::Checkpoint>(directory, g, groups.size(), std::move(files)));
+        }
+
+        Own<ram::Condition> goalsUnsatisfied;
+        for (std::size_t i : group) {
+            for (const auto* rel : context->getRelationsInSCC(sccOrdering.at(i))) {
+                if (!context->isGoal(rel)) {
+                    continue;
+                }
+                Own<ram::Condition> empty =
+                        mk<ram::EmptinessCheck>(getConcreteRelationName(rel->getQualifiedName()));
+                if (goalsUnsatisfied != nullptr) {
+                    empty = mk<ram::Conjunction>(std::move(goalsUnsatisfied), std::move(empty));
+                }
+                goalsUnsatisfied = std::move(empty);
+            }
+        }
+        if (goalsUnsatisfied != nullptr && g + 1 < groups.size()) {
+            guarded.emplace_back(std::move(res), std::move(goalsUnsatisfied));
+            res.clear();
+        }
+    }
+    while (!guarded.empty()) {
+        auto [stmts, goalsUnsatisfied] = std::move(guarded.back());
+        guarded.pop_back();
+        appendStmt(stmts, mk<ram::Guard>(std::move(goalsUnsatisfied), mk<ram::Sequence>(std::move(res))));
+        res = std::move(stmts);
     }
 
     // Add main timer if profiling
@@ -728,6 +1236,53 @@ Own<ram::Sequence> UnitTranslator::generateProgram(const ast::TranslationUnit& t
     return mk<ram::Sequence>(std::move(res));
 }
 
+void UnitTranslator::generateQuerySubroutines() {
+    for (const auto& entry : splitString(Global::config().get("query-relations"), ',')) {
+        const auto separator = entry.find(':');
+        const std::string name = entry.substr(0, separator);
+        const auto* relation = context->getProgram()->getRelation(ast::QualifiedName(splitString(name, '.')));
+        assert(relation != nullptr && "undefined queried relation");
+        // without a pattern, all tuples of the relation are returned
+        std::string pattern(relation->getArity(), 'f');
+        if (separator != std::string::npos) {
+            pattern = entry.substr(separator + 1);
+        }
+        const std::string subroutineID = "query_" + getConcreteRelationName(relation->getQualifiedName());
+        if (!contains(ramSubroutines, subroutineID)) {
+            addRamSubroutine(subroutineID, generateQuerySubroutine(relation, pattern));
+        }
+    }
+}
+
+Own<ram::Statement> UnitTranslator::generateQuerySubroutine(
+        const ast::Relation* relation, const std::string& pattern) const {
+    // return the tuples of the relation agreeing with the arguments on the bound columns, in order
+    const auto attributes = relation->getAttributes();
+    VecOwn<ram::Expression> values;
+    for (std::size_t i = 0; i < attributes.size(); i++) {
+        values.push_back(mk<ram::TupleElement>(0, i));
+    }
+    Own<ram::Operation> op = mk<ram::SubroutineReturn>(std::move(values));
+
+    std::size_t argument = 0;
+    VecOwn<ram::Condition> constraints;
+    for (std::size_t i = 0; i < attributes.size(); i++) {
+        if (pattern[i] != 'b') {
+            continue;
+        }
+        const std::string type = context->getAttributeTypeQualifier(attributes[i]->getTypeName());
+        auto opEq = type[0] == 'f' ? BinaryConstraintOp::FEQ : BinaryConstraintOp::EQ;
+        constraints.push_back(mk<ram::Constraint>(
+                opEq, mk<ram::TupleElement>(0, i), mk<ram::SubroutineArgument>(argument++)));
+    }
+    if (!constraints.empty()) {
+        op = mk<ram::Filter>(ram::toCondition(constraints), std::move(op));
+    }
+
+    const std::string relationName = getConcreteRelationName(relation->getQualifiedName());
+    return mk<ram::Query>(mk<ram::Scan>(relationName, 0, std::move(op)));
+}
+
 Own<ram::TranslationUnit> UnitTranslator::translateUnit(ast::TranslationUnit& tu) {
     /* -- Set-up -- */
     auto ram_start = std::chrono::high_resolution_clock::now();
@@ -736,6 +1291,9 @@ Own<ram::TranslationUnit> UnitTranslator::translateUnit(ast::TranslationUnit& tu
     /* -- Translation -- */
     // Generate the RAM program code
     auto ramMain = generateProgram(tu);
+    if (Global::config().has("query-relations")) {
+        generateQuerySubroutines();
+    }
 
     // Create the relevant RAM relations
     const auto& sccOrdering = tu.getAnalysis<ast::analysis::TopologicallySortedSCCGraphAnalysis>().order();
@@ -66,14 +66,24 @@ protected:
     /** High-level relation translation */
     virtual Own<ram::Sequence> generateProgram(const ast::TranslationUnit& translationUnit);
     Own<ram::Statement> generateNonRecursiveRelation(const ast::Relation& rel) const;
+    Own<ram::Statement> generateFactTable(
+            const ast::Relation& rel, std::set<const ast::Clause*>& tabledFacts) const;
     Own<ram::Statement> generateRecursiveStratum(const std::set<const ast::Relation*>& scc) const;
 
     /** IO translation */
     Own<ram::Statement> generateStoreRelation(const ast::Relation* relation) const;
     Own<ram::Statement> generateLoadRelation(const ast::Relation* relation) const;
 
+    /** Query translation */
+    void generateQuerySubroutines();
+    Own<ram::Statement> generateQuerySubroutine(
+            const ast::Relation* relation, const std::string& pattern) const;
+
     /** Low-level stratum translation */
-    Own<ram::Statement> generateStratum(std::size_t scc) const;
+    Own<ram::Statement> generateStratum(
+            std::size_t step, std::size_t scc, const std::set<const ast::Relation*>& preloaded) const;
+    Own<ram::Statement> generateStratumCache(
+            std::size_t step, std::size_t scc, Own<ram::Statement> compute) const;
     Own<ram::Statement> generateStratumPreamble(const std::set<const ast::Relation*>& scc) const;
     Own<ram::Statement> generateNonRecursiveDelete(const std::set<const ast::Relation*>& scc) const;
     Own<ram::Statement> generateStratumPostamble(const std::set<const ast::Relation*>& scc) const;
@@ -85,11 +95,16 @@ protected:
     virtual Own<ram::Statement> generateClearExpiredRelations(
             const std::set<const ast::Relation*>& expiredRelations) const;
     Own<ram::Statement> generateClearRelation(const ast::Relation* relation) const;
+    Own<ram::Statement> generateSpillRelation(const ast::Relation* relation) const;
+    Own<ram::Statement> generateRestoreRelation(const ast::Relation* relation) const;
+    std::map<std::string, std::string> getSpillDirectives(const ast::Relation* relation) const;
     virtual Own<ram::Statement> generateMergeRelations(
             const ast::Relation* rel, const std::string& destRelation, const std::string& srcRelation) const;
     virtual Own<ram::Statement> generateMergeRelationsWithFilter(const ast::Relation* rel,
             const std::string& destRelation, const std::string& srcRelation,
             const std::string& filterRelation) const;
+    Own<ram::Statement> generateLatticeDelta(const ast::Relation* rel, const std::string& destRelation,
+            const std::string& srcRelation, const std::string& latticeRelation) const;
     virtual Own<ram::Statement> generateEraseTuples(
             const ast::Relation* rel, const std::string& destRelation, const std::string& srcRelation) const;
 
@@ -102,8 +102,8 @@ Own<ram::Expression> ValueTranslator::visit_(
     }
     auto returnType = context.getFunctorReturnTypeAttribute(udf);
     auto paramTypes = context.getFunctorParamTypeAtributes(udf);
-    return mk<ram::UserDefinedOperator>(
-            udf.getName(), paramTypes, returnType, context.isStatefulFunctor(udf), std::move(values));
+    return mk<ram::UserDefinedOperator>(udf.getName(), paramTypes, returnType, context.isStatefulFunctor(udf),
+            context.isThreadLocalFunctor(udf), context.isCachedFunctor(udf), std::move(values));
 }
 
 Own<ram::Expression> ValueTranslator::visit_(type_identity<ast::Counter>, const ast::Counter&) {
@@ -121,9 +121,9 @@ Own<ram::Expression> ValueTranslator::visit_(type_identity<ast::RecordInit>, con
 Own<ram::Expression> ValueTranslator::visit_(type_identity<ast::BranchInit>, const ast::BranchInit& adt) {
     auto branchId = context.getADTBranchId(&adt);
 
-    // Enums are straight forward
-    if (context.isADTEnum(&adt)) {
-        return mk<ram::SignedConstant>(branchId);
+    // Enums and branches without arguments are straight forward
+    if (context.isADTBranchUnboxed(&adt)) {
+        return mk<ram::SignedConstant>(context.getADTBranchValue(&adt));
     }
 
     // Otherwise, will be a record
@@ -15,11 +15,18 @@
 #include "ast2ram/utility/TranslatorContext.h"
 #include "Global.h"
 #include "ast/Atom.h"
+#include "ast/BinaryConstraint.h"
 #include "ast/BranchInit.h"
+#include "ast/Clause.h"
+#include "ast/Constant.h"
 #include "ast/Directive.h"
+#include "ast/Functor.h"
 #include "ast/QualifiedName.h"
+#include "ast/Relation.h"
 #include "ast/SubsumptiveClause.h"
 #include "ast/TranslationUnit.h"
+#include "ast/Type.h"
+#include "ast/Variable.h"
 #include "ast/analysis/Functor.h"
 #include "ast/analysis/IOType.h"
 #include "ast/analysis/RecursiveClauses.h"
@@ -32,6 +39,7 @@
 #include "ast/analysis/typesystem/TypeSystem.h"
 #include "ast/utility/SipsMetric.h"
 #include "ast/utility/Utils.h"
+#include "ast/utility/Visitor.h"
 #include "ast2ram/ClauseTranslator.h"
 #include "ast2ram/ConstraintTranslator.h"
 #include "ast2ram/ValueTranslator.h"
@@ -40,9 +48,15 @@
 #include "ram/Condition.h"
 #include "ram/Expression.h"
 #include "ram/Statement.h"
+#include "souffle/RecordTable.h"
+#include "souffle/datastructure/SmallSet.h"
 #include "souffle/utility/FunctionalUtil.h"
 #include "souffle/utility/StringUtil.h"
+#include "souffle/utility/json11.h"
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace souffle::ast2ram {
 
@@ -101,6 +115,39 @@ std::string TranslatorContext::getAttributeTypeQualifier(const ast::QualifiedNam
     return getTypeQualifier(typeEnv->getType(name));
 }
 
+std::string TranslatorContext::getTypeDefinitions() const {
+    std::map<std::string, json11::Json> records;
+    std::map<std::string, json11::Json> adts;
+    for (const ast::Type* astType : program->getTypes()) {
+        const auto& type = typeEnv->getType(*astType);
+        if (const auto* recordType = as<ast::analysis::RecordType>(type)) {
+            std::vector<json11::Json> fields;
+            for (const auto* field : recordType->getFields()) {
+                fields.push_back(getTypeQualifier(*field));
+            }
+            const auto arity = static_cast<long long>(fields.size());
+            records.emplace(getTypeQualifier(type),
+                    json11::Json::object{{"types", std::move(fields)}, {"arity", arity}});
+        } else if (const auto* sumType = as<ast::analysis::AlgebraicDataType>(type)) {
+            std::vector<json11::Json> branches;
+            for (const auto& branch : sumType->getBranches()) {
+                std::vector<json11::Json> fields;
+                for (const auto* field : branch.types) {
+                    fields.push_back(getTypeQualifier(*field));
+                }
+                branches.push_back(
+                        json11::Json::object{{"types", std::move(fields)}, {"name", branch.name.toString()}});
+            }
+            const auto arity = static_cast<long long>(branches.size());
+            const bool isEnum = ast::analysis::isADTEnum(*sumType);
+            adts.emplace(getTypeQualifier(type),
+                    json11::Json::object{
+                            {"branches", std::move(branches)}, {"arity", arity}, {"enum", isEnum}});
+        }
+    }
+    return json11::Json(json11::Json::object{{"records", records}, {"ADTs", adts}}).dump();
+}
+
 std::size_t TranslatorContext::getNumberOfSCCs() const {
     return sccGraph->getNumberOfSCCs();
 }
@@ -130,6 +177,74 @@ std::size_t TranslatorContext::getSizeLimit(const ast::Relation* relation) const
     return ioType->getLimitSize(relation);
 }
 
+bool TranslatorContext::isGoal(const ast::Relation* relation) const {
+    return ioType->isGoal(relation);
+}
+
+bool TranslatorContext::isSmall(const ast::Relation* relation) const {
+    // loaded relations and those derived by rules may grow to any size
+    const auto& name = relation->getQualifiedName();
+    if (Global::config().has("provenance") || relation->getArity() == 0 ||
+            relation->getRepresentation() != RelationRepresentation::DEFAULT ||
+            !getLoadDirectives(name).empty()) {
+        return false;
+    }
+    const auto clauses = getProgram()->getClauses(name);
+    return !clauses.empty() && clauses.size() <= small_set_capacity &&
+           all_of(clauses, [](const ast::Clause* clause) { return ast::isFact(*clause); });
+}
+
+bool TranslatorContext::isCounted(const ast::Relation* relation) const {
+    // the tuples of the relation are neither read nor written, and its insertions are not checked
+    const auto& config = Global::config();
+    if (config.has("provenance") || config.has("incremental") || config.has("stratum-cache") ||
+            config.has("spill-dir") || relation->getArity() == 0 || !ioType->isPrintSize(relation) ||
+            ioType->isOutput(relation) || ioType->isInput(relation) || ioType->isQueried(relation) ||
+            !relation->getFunctionalDependencies().empty()) {
+        return false;
+    }
+    switch (relation->getRepresentation()) {
+        case RelationRepresentation::DEFAULT:
+        case RelationRepresentation::BTREE: break;
+        default: return false;
+    }
+    const auto& name = relation->getQualifiedName();
+    for (const auto* clause : program->getClauses()) {
+        // including the aggregates of the head
+        auto reads = [&](const ast::Atom& atom) {
+            return &atom != clause->getHead() && atom.getQualifiedName() == name;
+        };
+        if (visitExists(*clause, reads)) {
+            return false;
+        }
+    }
+
+    // A single clause derives each tuple once if its head copies all variables of the atoms of its
+    // body: the atoms range over sets, so distinct matches of the body differ in some variable. The
+    // other literals only filter the matches or bind a single value, unless a functor has several.
+    const auto clauses = program->getClauses(name);
+    if (clauses.size() != 1 || isA<ast::SubsumptiveClause>(clauses[0])) {
+        return false;
+    }
+    std::set<std::string> headVariables;
+    for (const auto* arg : clauses[0]->getHead()->getArguments()) {
+        if (const auto* var = as<ast::Variable>(arg)) {
+            headVariables.insert(var->getName());
+        }
+    }
+    for (const auto* atom : ast::getBodyLiterals<ast::Atom>(*clauses[0])) {
+        for (const auto* arg : atom->getArguments()) {
+            const auto* var = as<ast::Variable>(arg);
+            if (var != nullptr ? !contains(headVariables, var->getName()) : !isA<ast::Constant>(arg)) {
+                return false;
+            }
+        }
+    }
+    return !visitExists(*clauses[0], [](const ast::Functor& functor) {
+        return ast::analysis::FunctorAnalysis::isMultiResult(functor);
+    });
+}
+
 std::set<const ast::Relation*> TranslatorContext::getRelationsInSCC(std::size_t scc) const {
     return sccGraph->getInternalRelations(scc);
 }
@@ -146,6 +261,10 @@ std::set<const ast::Relation*> TranslatorContext::getExpiredRelations(std::size_
     return relationSchedule->schedule().at(scc).expired();
 }
 
+std::set<const ast::Relation*> TranslatorContext::getReadRelations(std::size_t scc) const {
+    return relationSchedule->schedule().at(scc).read();
+}
+
 bool TranslatorContext::hasSubsumptiveClause(const ast::QualifiedName& name) const {
     for (const auto* clause : getProgram()->getClauses(name)) {
         if (isA<ast::SubsumptiveClause>(clause)) {
@@ -155,6 +274,123 @@ bool TranslatorContext::hasSubsumptiveClause(const ast::QualifiedName& name) con
     return false;
 }
 
+std::optional<BinaryConstraintOp> TranslatorContext::getLatticeOrder(const ast::Relation* relation) const {
+    // provenance needs the subsumed tuples to explain subsumption
+    std::size_t arity = relation->getArity();
+    if (Global::config().has("provenance") ||
+            relation->getRepresentation() != RelationRepresentation::BTREE_DELETE || arity < 2 ||
+            !hasSubsumptiveClause(relation->getQualifiedName())) {
+        return std::nullopt;
+    }
+    const std::string valueType =
+            getAttributeTypeQualifier(relation->getAttributes()[arity - 1]->getTypeName());
+    if (valueType[0] != 'i' && valueType[0] != 'u' && valueType[0] != 'f') {
+        return std::nullopt;
+    }
+
+    // whether smaller values are better, agreed on by all subsumptive clauses
+    std::optional<bool> minimal;
+    for (const auto* clause : getProgram()->getClauses(relation->getQualifiedName())) {
+        if (!isA<ast::SubsumptiveClause>(clause)) {
+            continue;
+        }
+        const auto& body = clause->getBodyLiterals();
+        if (body.size() != 3) {
+            return std::nullopt;
+        }
+        const auto* dominated = as<ast::Atom>(body[0]);
+        const auto* dominating = as<ast::Atom>(body[1]);
+        const auto* constraint = as<ast::BinaryConstraint>(body[2]);
+        if (dominated == nullptr || dominating == nullptr || constraint == nullptr) {
+            return std::nullopt;
+        }
+
+        // both atoms bind the key to the same distinct variables, and the values to two others
+        std::set<std::string> variables;
+        const auto dominatedArgs = dominated->getArguments();
+        const auto dominatingArgs = dominating->getArguments();
+        for (std::size_t i = 0; i < arity - 1; i++) {
+            const auto* key = as<ast::Variable>(dominatedArgs[i]);
+            const auto* other = as<ast::Variable>(dominatingArgs[i]);
+            if (key == nullptr || other == nullptr || key->getName() != other->getName() ||
+                    !variables.insert(key->getName()).second) {
+                return std::nullopt;
+            }
+        }
+        const auto* worse = as<ast::Variable>(dominatedArgs[arity - 1]);
+        const auto* better = as<ast::Variable>(dominatingArgs[arity - 1]);
+        if (worse == nullptr || better == nullptr || !variables.insert(worse->getName()).second ||
+                !variables.insert(better->getName()).second) {
+            return std::nullopt;
+        }
+
+        // the constraint orders the two values
+        const auto* lhs = as<ast::Variable>(constraint->getLHS());
+        const auto* rhs = as<ast::Variable>(constraint->getRHS());
+        if (lhs == nullptr || rhs == nullptr) {
+            return std::nullopt;
+        }
+        const BinaryConstraintOp op = getOverloadedBinaryConstraintOperator(*constraint);
+        const bool less = isLessThan(op) || isLessEqual(op);
+        if (!less && !isGreaterThan(op) && !isGreaterEqual(op)) {
+            return std::nullopt;
+        }
+        bool smaller;
+        if (lhs->getName() == better->getName() && rhs->getName() == worse->getName()) {
+            smaller = less;
+        } else if (lhs->getName() == worse->getName() && rhs->getName() == better->getName()) {
+            smaller = !less;
+        } else {
+            return std::nullopt;
+        }
+        if (minimal.has_value() && *minimal != smaller) {
+            return std::nullopt;
+        }
+        minimal = smaller;
+    }
+    return *minimal ? getLessThanConstraint(valueType) : getGreaterThanConstraint(valueType);
+}
+
+bool TranslatorContext::isInsertedDirectly(const ast::Relation* relation) const {
+    // provenance and functional dependencies check the relation before inserting into the new relation
+    if (Global::config().has("provenance") || relation->getArity() == 0 ||
+            !relation->getFunctionalDependencies().empty()) {
+        return false;
+    }
+    switch (relation->getRepresentation()) {
+        case RelationRepresentation::DEFAULT:
+        case RelationRepresentation::BTREE:
+        case RelationRepresentation::BRIE: break;
+        default: return false;
+    }
+
+    // a relation read in full by a recursive clause must not change during an iteration
+    const auto scc = sccGraph->getInternalRelations(sccGraph->getSCC(relation));
+    for (const auto* rel : scc) {
+        if (hasSubsumptiveClause(rel->getQualifiedName())) {
+            return false;
+        }
+        for (const auto* clause : program->getClauses(*rel)) {
+            if (!isRecursiveClause(clause)) {
+                continue;
+            }
+            std::size_t sccAtoms = 0;
+            bool readsRelation = false;
+            for (const auto* atom : ast::getBodyLiterals<ast::Atom>(*clause)) {
+                const auto* atomRelation = program->getRelation(*atom);
+                if (contains(scc, atomRelation)) {
+                    sccAtoms++;
+                    readsRelation = readsRelation || atomRelation == relation;
+                }
+            }
+            if (readsRelation && sccAtoms > 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 TypeAttribute TranslatorContext::getFunctorReturnTypeAttribute(const ast::Functor& functor) const {
     return typeAnalysis->getFunctorReturnTypeAttribute(functor);
 }
@@ -173,6 +409,14 @@ bool TranslatorContext::isStatefulFunctor(const ast::UserDefinedFunctor& udf) co
     return functorAnalysis->isStatefulFunctor(udf);
 }
 
+bool TranslatorContext::isThreadLocalFunctor(const ast::UserDefinedFunctor& udf) const {
+    return functorAnalysis->isThreadLocalFunctor(udf);
+}
+
+bool TranslatorContext::isCachedFunctor(const ast::UserDefinedFunctor& udf) const {
+    return functorAnalysis->isCachedFunctor(udf);
+}
+
 ast::NumericConstant::Type TranslatorContext::getInferredNumericConstantType(
         const ast::NumericConstant& nc) const {
     return polyAnalysis->getInferredType(nc);
@@ -212,6 +456,22 @@ bool TranslatorContext::isADTBranchSimple(const ast::BranchInit* adt) const {
     return arity <= 1;
 }
 
+bool TranslatorContext::isADTBranchUnboxed(const ast::BranchInit* adt) const {
+    // branches without arguments are encoded by a constant rather than a record
+    return adt->getArguments().empty();
+}
+
+RamDomain TranslatorContext::getADTBranchValue(const ast::BranchInit* adt) const {
+    assert(isADTBranchUnboxed(adt) && "only branches without arguments are constants");
+    RamDomain branchId = getADTBranchId(adt);
+    return isADTEnum(adt) ? branchId : packUnboxedBranch(branchId);
+}
+
+bool TranslatorContext::hasADTUnboxedBranches(const ast::BranchInit* adt) const {
+    const auto& type = sumTypeBranches->unsafeGetType(adt->getBranchName());
+    return any_of(type.getBranches(), [](auto& branch) { return branch.types.empty(); });
+}
+
 Own<ram::Statement> TranslatorContext::translateNonRecursiveClause(
         const ast::Clause& clause, TranslationMode mode) const {
     auto clauseTranslator = Own<ClauseTranslator>(translationStrategy->createClauseTranslator(*this, mode));
@@ -20,9 +20,11 @@
 #include "ast/analysis/typesystem/Type.h"
 #include "ast2ram/ClauseTranslator.h"
 #include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
 #include "souffle/TypeAttribute.h"
 #include "souffle/utility/ContainerUtil.h"
 #include <cstddef>
+#include <optional>
 #include <set>
 #include <vector>
 
@@ -79,11 +81,34 @@ public:
     std::vector<ast::Directive*> getStoreDirectives(const ast::QualifiedName& name) const;
     std::vector<ast::Directive*> getLoadDirectives(const ast::QualifiedName& name) const;
     std::string getAttributeTypeQualifier(const ast::QualifiedName& name) const;
+    /** The record and ADT types of the program as JSON, in the format of the "types" IO directive */
+    std::string getTypeDefinitions() const;
     bool hasSizeLimit(const ast::Relation* relation) const;
     std::size_t getSizeLimit(const ast::Relation* relation) const;
+    /** Evaluation stops once a goal relation is non-empty */
+    bool isGoal(const ast::Relation* relation) const;
+    /** Whether a relation of the default representation only holds a few facts, stored inline */
+    bool isSmall(const ast::Relation* relation) const;
+    /**
+     * Whether a relation is only printed by its size, and its single clause derives each tuple once,
+     * such that counting its insertions suffices
+     */
+    bool isCounted(const ast::Relation* relation) const;
 
     /** Clause methods */
     bool hasSubsumptiveClause(const ast::QualifiedName& name) const;
+    /**
+     * The lattice order of a relation whose subsumptive clauses only keep the best value of its last
+     * attribute for each key, i.e., are of the form `R(k..., x) <= R(k..., y) :- y <= x`.
+     * The order holds if its first value is better than its second.
+     */
+    std::optional<BinaryConstraintOp> getLatticeOrder(const ast::Relation* relation) const;
+    /**
+     * Whether the recursive clauses of a relation insert into the relation itself, recording the tuples
+     * new to it in its new relation, instead of merging the new relation into it after each iteration.
+     * This requires that the recursive clauses of its SCC only read the relation through its delta.
+     */
+    bool isInsertedDirectly(const ast::Relation* relation) const;
     bool isRecursiveClause(const ast::Clause* clause) const;
     std::size_t getClauseNum(const ast::Clause* clause) const;
 
@@ -91,6 +116,7 @@ public:
     std::size_t getNumberOfSCCs() const;
     bool isRecursiveSCC(std::size_t scc) const;
     std::set<const ast::Relation*> getExpiredRelations(std::size_t scc) const;
+    std::set<const ast::Relation*> getReadRelations(std::size_t scc) const;
     std::set<const ast::Relation*> getRelationsInSCC(std::size_t scc) const;
     std::set<const ast::Relation*> getInputRelationsInSCC(std::size_t scc) const;
     std::set<const ast::Relation*> getOutputRelationsInSCC(std::size_t scc) const;
@@ -100,11 +126,16 @@ public:
     TypeAttribute getFunctorParamTypeAtribute(const ast::Functor& functor, std::size_t idx) const;
     std::vector<TypeAttribute> getFunctorParamTypeAtributes(const ast::UserDefinedFunctor& udf) const;
     bool isStatefulFunctor(const ast::UserDefinedFunctor& functor) const;
+    bool isThreadLocalFunctor(const ast::UserDefinedFunctor& functor) const;
+    bool isCachedFunctor(const ast::UserDefinedFunctor& functor) const;
 
     /** ADT methods */
     bool isADTEnum(const ast::BranchInit* adt) const;
     int getADTBranchId(const ast::BranchInit* adt) const;
     bool isADTBranchSimple(const ast::BranchInit* adt) const;
+    bool isADTBranchUnboxed(const ast::BranchInit* adt) const;
+    RamDomain getADTBranchValue(const ast::BranchInit* adt) const;
+    bool hasADTUnboxedBranches(const ast::BranchInit* adt) const;
 
     /** Polymorphic objects methods */
     ast::NumericConstant::Type getInferredNumericConstantType(const ast::NumericConstant& nc) const;
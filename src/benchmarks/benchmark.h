@@ -0,0 +1,353 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file benchmark.h
+ *
+ * Simple microbenchmark infrastructure, the counterpart of tests/test.h
+ *
+ * A benchmark is declared by BENCHMARK(group, name) and measures any
+ * number of cases through the runner passed to it. Each case is run a
+ * number of times on freshly set up data, and its median time is reported
+ * on the console and, given --out=<file>, as JSON in the format of Google
+ * Benchmark, such that results can be tracked and compared by its tools.
+ *
+ * Options of a benchmark binary:
+ *   --filter=<text>       only run cases whose name contains the text
+ *   --out=<file>          write the results as JSON to the file
+ *   --repetitions=<n>     number of runs per case (default 5)
+ *   --size=<n>            number of elements per case (default 2^20)
+ *   --max-threads=<n>     largest thread count of parallel cases (default:
+ *                         number of cores, at most 64)
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace benchmark {
+
+/** The order and spread of generated values */
+enum class Distribution { Uniform, Skewed, Sorted };
+
+inline const std::vector<Distribution>& allDistributions() {
+    static const std::vector<Distribution> distributions = {
+            Distribution::Uniform, Distribution::Skewed, Distribution::Sorted};
+    return distributions;
+}
+
+inline std::string toString(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::Uniform: return "uniform";
+        case Distribution::Skewed: return "skewed";
+        case Distribution::Sorted: return "sorted";
+    }
+    return "unknown";
+}
+
+/**
+ * Generate values in [0, range) in random order; skewed values follow a
+ * power law, such that a few small values make up most of them, and
+ * sorted values are uniform values in ascending order.
+ */
+inline std::vector<souffle::RamDomain> generateValues(
+        std::size_t count, std::size_t range, Distribution distribution, unsigned seed = 3) {
+    std::mt19937_64 generator(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<souffle::RamDomain> values(count);
+    for (auto& value : values) {
+        double position = unit(generator);
+        if (distribution == Distribution::Skewed) {
+            position = std::pow(position, 4.0);
+        }
+        value = static_cast<souffle::RamDomain>(
+                std::min(static_cast<std::size_t>(position * static_cast<double>(range)), range - 1));
+    }
+    if (distribution == Distribution::Sorted) {
+        std::sort(values.begin(), values.end());
+    }
+    return values;
+}
+
+/**
+ * Generate tuples whose values each follow the distribution; sorted tuples
+ * are in lexicographic order.
+ */
+template <std::size_t Arity>
+std::vector<souffle::Tuple<souffle::RamDomain, Arity>> generateTuples(
+        std::size_t count, Distribution distribution, unsigned seed = 3) {
+    // a range per column such that tuples are mostly distinct
+    const auto range =
+            static_cast<std::size_t>(std::ceil(std::pow(static_cast<double>(count), 1.0 / Arity))) + 1;
+    std::vector<souffle::Tuple<souffle::RamDomain, Arity>> tuples(count);
+    const Distribution columns = distribution == Distribution::Sorted ? Distribution::Uniform : distribution;
+    for (std::size_t i = 0; i < Arity; ++i) {
+        const auto values = generateValues(count, Arity == 1 ? count : range, columns, seed + unsigned(i));
+        for (std::size_t j = 0; j < count; ++j) {
+            tuples[j][i] = values[j];
+        }
+    }
+    if (distribution == Distribution::Sorted) {
+        std::sort(tuples.begin(), tuples.end());
+    }
+    return tuples;
+}
+
+/**
+ * Run the function for each of the given number of contiguous slices of
+ * [0, count) on its own thread; the function is passed the slice as
+ * (thread, begin, end).
+ */
+template <typename Function>
+void runSlices(std::size_t threads, std::size_t count, const Function& function) {
+    if (threads <= 1) {
+        function(std::size_t(0), std::size_t(0), count);
+        return;
+    }
+    PARALLEL_START_THREADS(static_cast<int>(threads))
+    pfor(std::size_t thread = 0; thread < threads; ++thread) {
+        function(thread, thread * count / threads, (thread + 1) * count / threads);
+    }
+    PARALLEL_END
+}
+
+/** Keep a computed value alive, such that the computation is not optimised away */
+template <typename T>
+void keep(const T& value) {
+    static volatile std::size_t sink;
+    sink = sink + static_cast<std::size_t>(value);
+}
+
+/** The result of a case, as reported */
+struct Result {
+    std::string name;
+    std::size_t repetitions;
+    double realTime;  // median, in nanoseconds
+    double cpuTime;   // median, in nanoseconds
+    double itemsPerSecond;
+};
+
+/**
+ * Runs and reports the cases of the benchmarks.
+ */
+class Runner {
+public:
+    Runner(int argc, char** argv) {
+        std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        maxThreads = std::min<std::size_t>(cores, 64);
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto equals = arg.find('=');
+            const std::string key = arg.substr(0, equals);
+            const std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+            if (key == "--filter") {
+                filter = value;
+            } else if (key == "--out") {
+                out = value;
+            } else if (key == "--repetitions") {
+                repetitions = std::max<std::size_t>(1, std::stoul(value));
+            } else if (key == "--size") {
+                elements = std::max<std::size_t>(1, std::stoul(value));
+            } else if (key == "--max-threads") {
+                maxThreads = std::max<std::size_t>(1, std::stoul(value));
+            } else {
+                std::cerr << "Unknown option " << arg << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    /** Number of elements each case works on */
+    std::size_t size() const {
+        return elements;
+    }
+
+    /** Thread counts of parallel cases: powers of two up to the maximum */
+    std::vector<std::size_t> threadCounts() const {
+        std::vector<std::size_t> counts;
+        for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            counts.push_back(threads);
+        }
+        if (counts.back() != maxThreads) {
+            counts.push_back(maxThreads);
+        }
+        return counts;
+    }
+
+    /**
+     * Measure a case: each run sets up its data untimed, and then times the
+     * body on it.
+     *
+     * @param name the name of the case, e.g. group/operation/parameter:value
+     * @param items the number of items a run processes, for the throughput
+     * @param setup returns the data of a run
+     * @param body processes the data of a run
+     */
+    template <typename Setup, typename Body>
+    void measure(const std::string& name, std::size_t items, const Setup& setup, const Body& body) {
+        if (name.find(filter) == std::string::npos) {
+            return;
+        }
+        std::vector<double> realTimes;
+        std::vector<double> cpuTimes;
+        for (std::size_t i = 0; i < repetitions; ++i) {
+            auto data = setup();
+            const std::clock_t cpuStart = std::clock();
+            const auto start = std::chrono::steady_clock::now();
+            body(data);
+            const auto end = std::chrono::steady_clock::now();
+            const std::clock_t cpuEnd = std::clock();
+            realTimes.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+            cpuTimes.push_back(1e9 * static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC);
+        }
+        const double realTime = median(realTimes);
+        const double itemsPerSecond = realTime > 0 ? 1e9 * static_cast<double>(items) / realTime : 0;
+        results.push_back({name, repetitions, realTime, median(cpuTimes), itemsPerSecond});
+
+        std::cout << std::left << std::setw(64) << name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(3) << realTime / 1e6 << " ms" << std::setw(14) << std::setprecision(2)
+                  << itemsPerSecond / 1e6 << " M items/s" << std::endl;
+    }
+
+    /** Write the results as JSON, if requested */
+    void report() const {
+        if (out.empty()) {
+            return;
+        }
+        std::ofstream file(out);
+        file << "{\n  \"context\": {\n";
+        file << "    \"date\": \"" << now() << "\",\n";
+        file << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+        file << "    \"elements\": " << elements << ",\n";
+#ifdef NDEBUG
+        file << "    \"library_build_type\": \"release\"\n";
+#else
+        file << "    \"library_build_type\": \"debug\"\n";
+#endif
+        file << "  },\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const auto& result = results[i];
+            file << (i == 0 ? "\n" : ",\n");
+            file << "    {\"name\": \"" << result.name << "\", \"run_name\": \"" << result.name
+                 << "\", \"run_type\": \"iteration\", \"iterations\": " << result.repetitions
+                 << ", \"real_time\": " << std::setprecision(17) << result.realTime
+                 << ", \"cpu_time\": " << result.cpuTime << ", \"time_unit\": \"ns\""
+                 << ", \"items_per_second\": " << result.itemsPerSecond << "}";
+        }
+        file << "\n  ]\n}\n";
+        if (!file) {
+            std::cerr << "Cannot write results to " << out << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+private:
+    static double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    static std::string now() {
+        const std::time_t time = std::time(nullptr);
+        std::stringstream text;
+        text << std::put_time(std::localtime(&time), "%Y-%m-%dT%H:%M:%S");
+        return text.str();
+    }
+
+    std::string filter;
+    std::string out;
+    std::size_t repetitions = 5;
+    std::size_t elements = 1 << 20;
+    std::size_t maxThreads;
+    std::vector<Result> results;
+};
+
+}  // namespace benchmark
+
+/* singly linked list for linking benchmarks */
+
+static class Benchmark* benchmarks = nullptr;
+
+class Benchmark {
+private:
+    Benchmark* next;    // next benchmark (linked by constructor)
+    std::string group;  // group name of benchmark
+    std::string name;   // name of benchmark
+
+public:
+    Benchmark(std::string g, std::string n) : group(std::move(g)), name(std::move(n)) {
+        next = benchmarks;
+        benchmarks = this;
+    }
+    virtual ~Benchmark() = default;
+
+    /**
+     * Run method, measuring the cases of the benchmark
+     */
+    virtual void run(benchmark::Runner& runner) = 0;
+
+    Benchmark* nextBenchmark() {
+        return next;
+    }
+
+    const std::string& getGroup() const {
+        return group;
+    }
+
+    const std::string& getName() const {
+        return name;
+    }
+};
+
+#define BENCHMARK(a, b)                                                          \
+    class benchmark_##a##_##b : public Benchmark {                               \
+    public:                                                                      \
+        benchmark_##a##_##b(std::string g, std::string n) : Benchmark(g, n) {}   \
+        void run(benchmark::Runner& runner) override;                            \
+    } Benchmark_##a##_##b(#a, #b);                                               \
+    void benchmark_##a##_##b::run([[maybe_unused]] benchmark::Runner& runner)
+
+/**
+ * Main program of a benchmark
+ */
+int main(int argc, char** argv) {
+    benchmark::Runner runner(argc, argv);
+
+    // run the benchmarks in the order of their declaration
+    std::vector<Benchmark*> all;
+    for (Benchmark* p = benchmarks; p != nullptr; p = p->nextBenchmark()) {
+        all.push_back(p);
+    }
+    std::reverse(all.begin(), all.end());
+    for (Benchmark* p : all) {
+        std::cout << p->getGroup() << "/" << p->getName() << "\n";
+        p->run(runner);
+    }
+
+    runner.report();
+    return 0;
+}
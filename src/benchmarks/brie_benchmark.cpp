@@ -0,0 +1,149 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file brie_benchmark.cpp
+ *
+ * Microbenchmarks of the tries of brie relations.
+ *
+ ***********************************************************************/
+
+#include "benchmarks/benchmark.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/Brie.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::benchmarks {
+
+using namespace benchmark;
+
+template <std::size_t Arity>
+std::string caseName(const std::string& operation, Distribution distribution) {
+    return "brie/" + operation + "/arity:" + std::to_string(Arity) + "/" + toString(distribution);
+}
+
+template <std::size_t Arity>
+void insert(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto tuples = generateTuples<Arity>(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            auto insertSlice = [&](Trie<Arity>& trie, std::size_t begin, std::size_t end) {
+                typename Trie<Arity>::op_context ctxt;
+                for (std::size_t i = begin; i < end; ++i) {
+                    trie.insert(tuples[i], ctxt);
+                }
+            };
+            runner.measure(caseName<Arity>("insert", distribution) + "/threads:" + std::to_string(threads),
+                    tuples.size(), []() { return std::make_unique<Trie<Arity>>(); },
+                    [&](auto& trie) {
+                        runSlices(threads, tuples.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    insertSlice(*trie, begin, end);
+                                });
+                    });
+        }
+    }
+}
+
+/** Find the lower bounds of the queries of a slice */
+template <typename Relation, typename Queries>
+std::size_t lowerBounds(const Relation& trie, const Queries& queries, std::size_t begin, std::size_t end) {
+    typename Relation::op_context ctxt;
+    std::size_t found = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        found += trie.lower_bound(queries[i], ctxt) != trie.end() ? 1 : 0;
+    }
+    return found;
+}
+
+/** Scan the tuples sharing the first value of each query of a slice */
+template <typename Relation, typename Queries>
+std::size_t rangeScans(const Relation& trie, const Queries& queries, std::size_t begin, std::size_t end) {
+    typename Relation::op_context ctxt;
+    std::size_t scanned = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        for (const auto& tuple : trie.template getBoundaries<1>(queries[i], ctxt)) {
+            scanned += static_cast<std::size_t>(tuple.back());
+        }
+    }
+    return scanned;
+}
+
+template <std::size_t Arity>
+void lookup(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto tuples = generateTuples<Arity>(runner.size(), distribution);
+        Trie<Arity> trie;
+        for (const auto& tuple : tuples) {
+            trie.insert(tuple);
+        }
+        const auto queries = generateTuples<Arity>(runner.size(), distribution, 7);
+        for (std::size_t threads : runner.threadCounts()) {
+            const std::string suffix = "/threads:" + std::to_string(threads);
+            runner.measure(caseName<Arity>("lower_bound", distribution) + suffix, queries.size(),
+                    []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, queries.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    keep(lowerBounds(trie, queries, begin, end));
+                                });
+                    });
+            if (Arity == 1) {
+                continue;
+            }
+            runner.measure(caseName<Arity>("range_scan", distribution) + suffix, queries.size(),
+                    []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, queries.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    keep(rangeScans(trie, queries, begin, end));
+                                });
+                    });
+        }
+    }
+}
+
+template <std::size_t Arity>
+void insertAll(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto tuples = generateTuples<Arity>(runner.size(), distribution);
+        Trie<Arity> full;
+        Trie<Arity> delta;
+        for (std::size_t i = 0; i < tuples.size(); ++i) {
+            (i < tuples.size() / 2 ? full : delta).insert(tuples[i]);
+        }
+        runner.measure(caseName<Arity>("insert_all", distribution), delta.size(),
+                [&]() { return std::make_unique<Trie<Arity>>(full); },
+                [&](auto& trie) { trie->insertAll(delta); });
+    }
+}
+
+BENCHMARK(Brie, Insert) {
+    insert<1>(runner);
+    insert<2>(runner);
+    insert<4>(runner);
+}
+
+BENCHMARK(Brie, Lookup) {
+    lookup<1>(runner);
+    lookup<2>(runner);
+    lookup<4>(runner);
+}
+
+BENCHMARK(Brie, InsertAll) {
+    insertAll<1>(runner);
+    insertAll<2>(runner);
+    insertAll<4>(runner);
+}
+
+}  // namespace souffle::benchmarks
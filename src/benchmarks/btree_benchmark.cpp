@@ -0,0 +1,159 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file btree_benchmark.cpp
+ *
+ * Microbenchmarks of the B-tree sets indexing relations.
+ *
+ ***********************************************************************/
+
+#include "benchmarks/benchmark.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/BTree.h"
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::benchmarks {
+
+using namespace benchmark;
+
+template <std::size_t Arity>
+using tuple_set = btree_set<Tuple<RamDomain, Arity>>;
+
+template <std::size_t Arity>
+std::string caseName(const std::string& operation, Distribution distribution) {
+    return "btree/" + operation + "/arity:" + std::to_string(Arity) + "/" + toString(distribution);
+}
+
+template <std::size_t Arity>
+void insert(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto tuples = generateTuples<Arity>(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            auto insertSlice = [&](tuple_set<Arity>& set, std::size_t begin, std::size_t end) {
+                typename tuple_set<Arity>::operation_hints hints;
+                for (std::size_t i = begin; i < end; ++i) {
+                    set.insert(tuples[i], hints);
+                }
+            };
+            runner.measure(caseName<Arity>("insert", distribution) + "/threads:" + std::to_string(threads),
+                    tuples.size(), []() { return std::make_unique<tuple_set<Arity>>(); },
+                    [&](auto& set) {
+                        runSlices(threads, tuples.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    insertSlice(*set, begin, end);
+                                });
+                    });
+        }
+    }
+}
+
+/** Find the lower bounds of the queries of a slice */
+template <std::size_t Arity>
+std::size_t lowerBounds(const tuple_set<Arity>& set, const std::vector<Tuple<RamDomain, Arity>>& queries,
+        std::size_t begin, std::size_t end) {
+    typename tuple_set<Arity>::operation_hints hints;
+    std::size_t found = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        found += set.lower_bound(queries[i], hints) != set.end() ? 1 : 0;
+    }
+    return found;
+}
+
+/** Scan the tuples sharing the first value of each query of a slice */
+template <std::size_t Arity>
+std::size_t rangeScans(const tuple_set<Arity>& set, const std::vector<Tuple<RamDomain, Arity>>& queries,
+        std::size_t begin, std::size_t end) {
+    typename tuple_set<Arity>::operation_hints lower;
+    typename tuple_set<Arity>::operation_hints upper;
+    std::size_t scanned = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        Tuple<RamDomain, Arity> low;
+        Tuple<RamDomain, Arity> high;
+        low.fill(std::numeric_limits<RamDomain>::min());
+        high.fill(std::numeric_limits<RamDomain>::max());
+        low[0] = high[0] = queries[i][0];
+        const auto last = set.upper_bound(high, upper);
+        for (auto it = set.lower_bound(low, lower); it != last; ++it) {
+            scanned += static_cast<std::size_t>((*it)[Arity - 1]);
+        }
+    }
+    return scanned;
+}
+
+template <std::size_t Arity>
+void lookup(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto tuples = generateTuples<Arity>(runner.size(), distribution);
+        const tuple_set<Arity> set(tuples.begin(), tuples.end());
+        // queries of the same distribution, in their order, such that hints pay off for sorted queries
+        const auto queries = generateTuples<Arity>(runner.size(), distribution, 7);
+        for (std::size_t threads : runner.threadCounts()) {
+            const std::string suffix = "/threads:" + std::to_string(threads);
+            runner.measure(caseName<Arity>("lower_bound", distribution) + suffix, queries.size(),
+                    []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, queries.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    keep(lowerBounds(set, queries, begin, end));
+                                });
+                    });
+            if (Arity == 1) {
+                continue;
+            }
+            runner.measure(caseName<Arity>("range_scan", distribution) + suffix, queries.size(),
+                    []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, queries.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    keep(rangeScans(set, queries, begin, end));
+                                });
+                    });
+        }
+    }
+}
+
+template <std::size_t Arity>
+void insertAll(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto tuples = generateTuples<Arity>(runner.size(), distribution);
+        // merge a new half of the tuples into the other half, as a fixpoint merges new into full relations
+        const auto middle = tuples.begin() + static_cast<std::ptrdiff_t>(tuples.size() / 2);
+        const tuple_set<Arity> full(tuples.begin(), middle);
+        const tuple_set<Arity> delta(middle, tuples.end());
+        runner.measure(caseName<Arity>("insert_all", distribution), delta.size(),
+                [&]() { return std::make_unique<tuple_set<Arity>>(full); },
+                [&](auto& set) { set->insert(delta.begin(), delta.end()); });
+    }
+}
+
+BENCHMARK(BTree, Insert) {
+    insert<1>(runner);
+    insert<2>(runner);
+    insert<4>(runner);
+}
+
+BENCHMARK(BTree, Lookup) {
+    lookup<1>(runner);
+    lookup<2>(runner);
+    lookup<4>(runner);
+}
+
+BENCHMARK(BTree, InsertAll) {
+    insertAll<1>(runner);
+    insertAll<2>(runner);
+    insertAll<4>(runner);
+}
+
+}  // namespace souffle::benchmarks
@@ -0,0 +1,132 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file eqrel_benchmark.cpp
+ *
+ * Microbenchmarks of the equivalence relations of eqrel relations.
+ *
+ ***********************************************************************/
+
+#include "benchmarks/benchmark.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/EquivalenceRelation.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::benchmarks {
+
+using namespace benchmark;
+
+using eqrel = EquivalenceRelation<Tuple<RamDomain, 2>>;
+
+std::string caseName(const std::string& operation, Distribution distribution) {
+    return "eqrel/" + operation + "/" + toString(distribution);
+}
+
+/**
+ * Generate pairs of nearby values, such that the classes stay small as in
+ * typical equivalence relations instead of merging into one.
+ */
+std::vector<Tuple<RamDomain, 2>> generatePairs(
+        std::size_t count, Distribution distribution, unsigned seed = 3) {
+    const auto first = generateValues(count, 4 * count, distribution, seed);
+    const auto offset = generateValues(count, 4, Distribution::Uniform, seed + 1);
+    std::vector<Tuple<RamDomain, 2>> pairs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        pairs[i] = {first[i], first[i] + offset[i] + 1};
+    }
+    return pairs;
+}
+
+BENCHMARK(EquivalenceRelation, Insert) {
+    for (auto distribution : allDistributions()) {
+        const auto pairs = generatePairs(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            auto insertSlice = [&](eqrel& relation, std::size_t begin, std::size_t end) {
+                eqrel::operation_hints hints;
+                for (std::size_t i = begin; i < end; ++i) {
+                    relation.insert(pairs[i], hints);
+                }
+            };
+            runner.measure(caseName("insert", distribution) + "/threads:" + std::to_string(threads),
+                    pairs.size(), []() { return std::make_unique<eqrel>(); },
+                    [&](auto& relation) {
+                        runSlices(threads, pairs.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    insertSlice(*relation, begin, end);
+                                });
+                    });
+        }
+    }
+}
+
+BENCHMARK(EquivalenceRelation, Lookup) {
+    for (auto distribution : allDistributions()) {
+        eqrel relation;
+        for (const auto& pair : generatePairs(runner.size(), distribution)) {
+            relation.insert(pair);
+        }
+        const auto queries = generatePairs(runner.size(), distribution, 7);
+        // iterating the relation caches its classes; do so before lookups from several threads
+        keep(relation.size());
+        for (std::size_t threads : runner.threadCounts()) {
+            const std::string suffix = "/threads:" + std::to_string(threads);
+            runner.measure(caseName("contains", distribution) + suffix, queries.size(), []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, queries.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    std::size_t found = 0;
+                                    for (std::size_t i = begin; i < end; ++i) {
+                                        found += relation.contains(queries[i]) ? 1 : 0;
+                                    }
+                                    keep(found);
+                                });
+                    });
+            // scan the class of the first value of each query
+            runner.measure(caseName("range_scan", distribution) + suffix, queries.size(),
+                    []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, queries.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    std::size_t scanned = 0;
+                                    for (std::size_t i = begin; i < end; ++i) {
+                                        for (const auto& pair : relation.getBoundaries<1>(queries[i])) {
+                                            scanned += static_cast<std::size_t>(pair[1]);
+                                        }
+                                    }
+                                    keep(scanned);
+                                });
+                    });
+        }
+    }
+}
+
+BENCHMARK(EquivalenceRelation, InsertAll) {
+    for (auto distribution : allDistributions()) {
+        const auto pairs = generatePairs(runner.size(), distribution);
+        eqrel full;
+        eqrel delta;
+        for (std::size_t i = 0; i < pairs.size(); ++i) {
+            (i < pairs.size() / 2 ? full : delta).insert(pairs[i]);
+        }
+        runner.measure(caseName("insert_all", distribution), pairs.size() - pairs.size() / 2,
+                [&]() {
+                    auto relation = std::make_unique<eqrel>();
+                    relation->insertAll(full);
+                    return relation;
+                },
+                [&](auto& relation) { relation->insertAll(delta); });
+    }
+}
+
+}  // namespace souffle::benchmarks
@@ -0,0 +1,91 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file record_table_benchmark.cpp
+ *
+ * Microbenchmarks of packing and unpacking records.
+ *
+ ***********************************************************************/
+
+#include "benchmarks/benchmark.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::benchmarks {
+
+using namespace benchmark;
+
+using record_table = SpecializedRecordTable<2, 4>;
+
+template <std::size_t Arity>
+std::string caseName(const std::string& operation, Distribution distribution, std::size_t threads) {
+    return "record_table/" + operation + "/arity:" + std::to_string(Arity) + "/" + toString(distribution) +
+           "/threads:" + std::to_string(threads);
+}
+
+template <std::size_t Arity>
+void pack(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto records = generateTuples<Arity>(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            runner.measure(caseName<Arity>("pack", distribution, threads), records.size(),
+                    [&]() { return std::make_unique<record_table>(threads); },
+                    [&](auto& table) {
+                        runSlices(threads, records.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    for (std::size_t i = begin; i < end; ++i) {
+                                        keep(table->pack(records[i].data(), Arity));
+                                    }
+                                });
+                    });
+        }
+    }
+}
+
+template <std::size_t Arity>
+void unpack(Runner& runner) {
+    for (auto distribution : allDistributions()) {
+        const auto records = generateTuples<Arity>(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            record_table table(threads);
+            std::vector<RamDomain> references;
+            for (const auto& record : records) {
+                references.push_back(table.pack(record.data(), Arity));
+            }
+            runner.measure(caseName<Arity>("unpack", distribution, threads), references.size(),
+                    []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, references.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    for (std::size_t i = begin; i < end; ++i) {
+                                        keep(table.unpack(references[i], Arity)[Arity - 1]);
+                                    }
+                                });
+                    });
+        }
+    }
+}
+
+BENCHMARK(RecordTable, Pack) {
+    pack<2>(runner);
+    pack<4>(runner);
+}
+
+BENCHMARK(RecordTable, Unpack) {
+    unpack<2>(runner);
+    unpack<4>(runner);
+}
+
+}  // namespace souffle::benchmarks
@@ -0,0 +1,85 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file symbol_table_benchmark.cpp
+ *
+ * Microbenchmarks of interning symbols in the concurrent flyweight of the
+ * symbol table.
+ *
+ ***********************************************************************/
+
+#include "benchmarks/benchmark.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::benchmarks {
+
+using namespace benchmark;
+
+std::string caseName(const std::string& operation, Distribution distribution, std::size_t threads) {
+    return "symbol_table/" + operation + "/" + toString(distribution) + "/threads:" + std::to_string(threads);
+}
+
+/** Generate symbols of typical length, repeating as the values of the distribution */
+std::vector<std::string> generateSymbols(std::size_t count, Distribution distribution) {
+    std::vector<std::string> symbols;
+    symbols.reserve(count);
+    for (RamDomain value : generateValues(count, count, distribution)) {
+        symbols.push_back("symbol/" + std::to_string(value) + "/of/some/fact");
+    }
+    return symbols;
+}
+
+BENCHMARK(SymbolTable, Encode) {
+    for (auto distribution : allDistributions()) {
+        const auto symbols = generateSymbols(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            runner.measure(caseName("encode", distribution, threads), symbols.size(),
+                    [&]() { return std::make_unique<SymbolTable>(threads); },
+                    [&](auto& table) {
+                        runSlices(threads, symbols.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    for (std::size_t i = begin; i < end; ++i) {
+                                        keep(table->encode(symbols[i]));
+                                    }
+                                });
+                    });
+        }
+    }
+}
+
+BENCHMARK(SymbolTable, Decode) {
+    for (auto distribution : allDistributions()) {
+        const auto symbols = generateSymbols(runner.size(), distribution);
+        for (std::size_t threads : runner.threadCounts()) {
+            SymbolTable table(threads);
+            std::vector<RamDomain> indices;
+            for (const auto& symbol : symbols) {
+                indices.push_back(table.encode(symbol));
+            }
+            runner.measure(caseName("decode", distribution, threads), indices.size(), []() { return 0; },
+                    [&](int) {
+                        runSlices(threads, indices.size(),
+                                [&](std::size_t, std::size_t begin, std::size_t end) {
+                                    for (std::size_t i = begin; i < end; ++i) {
+                                        keep(table.decode(indices[i]).size());
+                                    }
+                                });
+                    });
+        }
+    }
+}
+
+}  // namespace souffle::benchmarks
@@ -20,6 +20,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <set>
+#include <sstream>
 #include <string>
 #include <getopt.h>
 #include <sys/stat.h>
@@ -62,10 +64,22 @@ protected:
      */
     std::size_t num_jobs;
 
+    /**
+     * socket of the fork server, or empty for a single run
+     */
+    std::string serve_socket;
+
+    /**
+     * relations computed by the run, or empty if all are
+     */
+    std::set<std::string> only_relations;
+
 public:
     // all argument constructor
-    CmdOptions(const char* s, const char* id, const char* od, bool pe, const char* pfn, std::size_t nj)
-            : src(s), input_dir(id), output_dir(od), profiling(pe), profile_name(pfn), num_jobs(nj) {}
+    CmdOptions(const char* s, const char* id, const char* od, bool pe, const char* pfn, std::size_t nj,
+            const char* only = "")
+            : src(s), input_dir(id), output_dir(od), profiling(pe), profile_name(pfn), num_jobs(nj),
+              only_relations(splitRelations(only)) {}
 
     /**
      * get source code name
@@ -109,6 +123,20 @@ public:
         return num_jobs;
     }
 
+    /**
+     * get socket of the fork server
+     */
+    const std::string& getServeSocket() const {
+        return serve_socket;
+    }
+
+    /**
+     * get relations computed by the run, or empty if all are
+     */
+    const std::set<std::string>& getOnlyRelations() const {
+        return only_relations;
+    }
+
     /**
      * Parses the given command line parameters, handles -h help requests or errors
      * and returns whether the parsing was successful or not.
@@ -127,6 +155,7 @@ public:
         // long options
         option longOptions[] = {{"facts", true, nullptr, 'F'}, {"output", true, nullptr, 'D'},
                 {"profile", true, nullptr, 'p'}, {"jobs", true, nullptr, 'j'}, {"index", true, nullptr, 'i'},
+                {"serve", true, nullptr, 'S'}, {"only", true, nullptr, 'O'},
                 // the terminal option -- needs to be null
                 {nullptr, false, nullptr, 0}};
 
@@ -134,7 +163,7 @@ public:
         bool ok = true;
 
         int c; /* command-line arguments processing */
-        while ((c = getopt_long(argc, argv, "D:F:hp:j:i:", longOptions, nullptr)) != EOF) {
+        while ((c = getopt_long(argc, argv, "D:F:hp:j:i:S:O:", longOptions, nullptr)) != EOF) {
             switch (c) {
                 /* Fact directories */
                 case 'F':
@@ -177,6 +206,10 @@ public:
                     std::cerr << "\nWarning: OpenMP was not enabled in compilation\n\n";
 #endif
                     break;
+                /* Socket of the fork server */
+                case 'S': serve_socket = optarg; break;
+                /* Relations computed by the run */
+                case 'O': only_relations = splitRelations(optarg); break;
                 default: printHelpPage(exec_name); return false;
             }
         }
@@ -215,6 +248,10 @@ private:
             std::cerr << "                                    (default: auto)\n";
         }
 #endif
+        std::cerr << "    -S <SOCK>, --serve=<SOCK>    -- Load the facts once and serve requests on a\n";
+        std::cerr << "                                    Unix domain socket by forked processes\n";
+        std::cerr << "    -O <RELS>, --only=<RELS>     -- Compute only the given comma-separated relations\n";
+        std::cerr << "                                    and the relations they depend on\n";
         std::cerr << "    -h                           -- prints this help page.\n";
         std::cerr << "--------------------------------------------------------------------\n";
         std::cout << " Copyright (c) 2016-20 The Souffle Developers." << std::endl;
@@ -223,6 +260,21 @@ private:
         std::cerr << "====================================================================\n";
     }
 
+    /**
+     * Split a comma-separated list of relations
+     */
+    static std::set<std::string> splitRelations(const std::string& list) {
+        std::set<std::string> res;
+        std::stringstream in(list);
+        std::string name;
+        while (std::getline(in, name, ',')) {
+            if (!name.empty()) {
+                res.insert(name);
+            }
+        }
+        return res;
+    }
+
     /**
      *  Check whether a file exists in the file system
      */
@@ -22,14 +22,22 @@
 #include "souffle/SouffleInterface.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/datastructure/BTreeDelete.h"
+#include "souffle/datastructure/BlockCounter.h"
+#include "souffle/datastructure/BloomFilter.h"
 #include "souffle/datastructure/Brie.h"
+#include "souffle/datastructure/ColumnTable.h"
 #include "souffle/datastructure/EquivalenceRelation.h"
+#include "souffle/datastructure/HashIndex.h"
+#include "souffle/datastructure/RetainedHints.h"
+#include "souffle/datastructure/ShardedSet.h"
+#include "souffle/datastructure/SmallSet.h"
 #include "souffle/datastructure/Table.h"
 #include "souffle/io/IOSystem.h"
 #include "souffle/io/WriteStream.h"
 #include "souffle/utility/EvaluatorUtil.h"
 #ifndef __EMBEDDED_SOUFFLE__
 #include "souffle/CompiledOptions.h"
+#include "souffle/ForkServer.h"
 #endif
 
 #if defined(_OPENMP)
@@ -44,6 +52,15 @@ inline souffle::SouffleProgram* getInstance(const char* p) {
 }
 }
 
+/** Whether a generated relation type finds its tuples by their primary attributes, e.g., for provenance */
+template <class RelType, typename = void>
+struct has_find_primary : std::false_type {};
+
+template <class RelType>
+struct has_find_primary<RelType, std::void_t<decltype(std::declval<const RelType&>().findPrimary(
+                                         std::declval<const typename RelType::t_tuple&>()))>>
+        : std::true_type {};
+
 /**
  * Relation wrapper used internally in the generated Datalog program
  */
@@ -115,6 +132,32 @@ public:
         }
         relation.insert(t);
     }
+    void insertBatch(span<const RamDomain> tuples, std::size_t n) override {
+        assert(tuples.size() >= n * Arity && "buffer too small");
+        auto ctxt = relation.createContext();
+        TupleType t;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::copy_n(tuples.data() + i * Arity, Arity, t.begin());
+            relation.insert(t, ctxt);
+        }
+    }
+    void scanBatch(const batch_callback& callback, std::size_t batchSize) const override {
+        assert(batchSize > 0 && "empty batches");
+        std::vector<RamDomain> buffer(batchSize * Arity);
+        std::size_t n = 0;
+        for (auto&& value : relation) {
+            for (std::size_t i = 0; i < Arity; i++) {
+                buffer[n * Arity + i] = value[i];
+            }
+            if (++n == batchSize) {
+                callback(buffer, n);
+                n = 0;
+            }
+        }
+        if (n > 0) {
+            callback(span<const RamDomain>(buffer.data(), n * Arity), n);
+        }
+    }
     bool contains(const tuple& arg) const override {
         TupleType t;
         assert(arg.size() == Arity && "wrong tuple arity");
@@ -123,6 +166,24 @@ public:
         }
         return relation.contains(t);
     }
+    bool findPrimary(span<RamDomain> t) const override {
+        if constexpr (has_find_primary<RelType>::value) {
+            assert(t.size() >= Arity && "buffer too small");
+            TupleType key;
+            std::copy_n(t.data(), Arity, key.begin());
+            auto pos = relation.findPrimary(key);
+            if (pos == relation.end()) {
+                return false;
+            }
+            auto&& value = *pos;
+            for (std::size_t i = 0; i < Arity; i++) {
+                t[i] = value[i];
+            }
+            return true;
+        } else {
+            return Relation::findPrimary(t);
+        }
+    }
     std::size_t size() const override {
         return relation.size();
     }
@@ -323,6 +384,60 @@ private:
     Lock insert_lock;
 };
 
+/**
+ * Relations only printed by their size, whose tuples are distinct when inserted. They count their
+ * insertions instead of storing the tuples, and are empty when iterated; thus the program interface
+ * does not provide them.
+ */
+template <Relation::arity_type Arity_>
+class t_counter {
+public:
+    static constexpr Relation::arity_type Arity = Arity_;
+
+    t_counter() = default;
+    using t_tuple = Tuple<RamDomain, Arity>;
+    struct context {};
+    context createContext() {
+        return context();
+    }
+    using iterator = const t_tuple*;
+    iterator begin() const {
+        return nullptr;
+    }
+    iterator end() const {
+        return nullptr;
+    }
+    bool insert(const t_tuple& /* t */) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    bool insert(const t_tuple& t, context& /* ctxt */) {
+        return insert(t);
+    }
+    void insert(const RamDomain* /* ramDomain */) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool contains(const t_tuple& /* t */) const {
+        return false;
+    }
+    bool contains(const t_tuple& /* t */, context& /* ctxt */) const {
+        return false;
+    }
+    std::size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+    bool empty() const {
+        return size() == 0;
+    }
+    void purge() {
+        count.store(0, std::memory_order_relaxed);
+    }
+    void printStatistics(std::ostream& /* o */) const {}
+
+private:
+    std::atomic<std::size_t> count{0};
+};
+
 /** Equivalence relations */
 struct t_eqrel {
     static constexpr Relation::arity_type Arity = 2;
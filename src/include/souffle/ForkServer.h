@@ -0,0 +1,134 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ForkServer.h
+ *
+ * Serves the requests to a compiled program by child processes forked
+ * from a process holding its pre-loaded input relations.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/CompiledOptions.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace souffle {
+
+/**
+ * Load the input relations of a program once and serve requests on a Unix domain socket, each by a
+ * child process forked from the loaded program.
+ *
+ * A client connects and writes a line holding the fact directory of its request, optionally followed
+ * by a tab and the output directory (by default the one given on the command line). The child inherits
+ * the loaded relations and tables copy-on-write, adds the facts of the request, evaluates the program
+ * and writes its output relations. Its standard output and error go to the client, which reads until
+ * the connection is closed. As in a regular run, a fact file missing from the directory of the request
+ * is reported; the relation keeps the tuples loaded at startup.
+ *
+ * The loaded b-trees are compacted, such that their nodes are full and allocated in order, and a child
+ * only copies the pages of the few nodes it inserts into. The input relations are loaded by a single
+ * thread, since the thread pool of OpenMP does not survive a fork.
+ *
+ * @return the exit code of the server, which runs until it fails or is killed
+ */
+template <class Program>
+int serveRequests(Program& prog, const CmdOptions& opt) {
+#if defined(_OPENMP)
+    const int numThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    prog.loadAll(opt.getInputFileDir());
+    prog.compactInputs();
+
+    const std::string& path = opt.getServeSocket();
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path " << path << " is too long\n";
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ::unlink(path.c_str());
+    const int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 || ::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(server, SOMAXCONN) != 0) {
+        std::cerr << "Cannot serve on socket " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // the children are reaped by the system
+    std::signal(SIGCHLD, SIG_IGN);
+    while (true) {
+        const int client = ::accept(server, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "Cannot accept requests: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+
+        // buffered output is not to be written by the children again
+        std::cout.flush();
+        std::fflush(nullptr);
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            std::cerr << "Cannot fork a child for a request: " << std::strerror(errno) << "\n";
+        } else if (pid == 0) {
+            ::close(server);
+            std::signal(SIGCHLD, SIG_DFL);
+            std::string request;
+            char c;
+            while (::read(client, &c, 1) == 1 && c != '\n') {
+                request += c;
+            }
+            ::dup2(client, STDOUT_FILENO);
+            ::dup2(client, STDERR_FILENO);
+            ::close(client);
+
+            const std::size_t tab = request.find('\t');
+            const std::string factDir = request.substr(0, tab);
+            const std::string outputDir =
+                    tab == std::string::npos ? opt.getOutputFileDir() : request.substr(tab + 1);
+#if defined(_OPENMP)
+            omp_set_num_threads(numThreads);
+#endif
+            int status = 0;
+            try {
+                prog.runAll(factDir, outputDir);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << "\n";
+                status = 1;
+            }
+            // the program is not destroyed, since the memory of the child is discarded anyway
+            std::cout.flush();
+            std::fflush(nullptr);
+            ::_exit(status);
+        }
+        ::close(client);
+    }
+}
+
+}  // end of namespace souffle
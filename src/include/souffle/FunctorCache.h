@@ -0,0 +1,126 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FunctorCache.h
+ *
+ * The result cache of user-defined functors declared `cached`.
+ *
+ * Such functors are assumed to return the same result whenever they are
+ * called with the same arguments, such that the result of a call may be
+ * reused by later calls of any rule, iteration or thread:
+ *
+ *     .functor normalise(s: symbol): symbol cached
+ *
+ * Symbols are cached by their identifiers in the symbol table, hence the
+ * functor is not called again for the same strings.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A concurrent cache of the results of a functor, keyed by its arguments.
+ *
+ * The cache is split into shards by the hash of the arguments, each with
+ * its own lock, such that threads calling the functor with different
+ * arguments rarely wait for each other. The functor is called without
+ * holding a lock, hence concurrent calls with the same arguments may both
+ * call it. A shard holding its share of the capacity is cleared before
+ * further results are added, which bounds the memory of functors called
+ * with unbounded arguments.
+ *
+ * @tparam Key the arguments, a sequence of RamDomain values, e.g., a
+ *             std::array for a fixed arity or a std::vector
+ */
+template <typename Key>
+class FunctorCache {
+    /** Number of shards, each with its own lock */
+    static constexpr std::size_t NUM_SHARDS = 64;
+
+public:
+    /** The default number of results kept per functor */
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16;
+
+    explicit FunctorCache(std::size_t capacity = DEFAULT_CAPACITY)
+            : shardCapacity(std::max<std::size_t>(1, capacity / NUM_SHARDS)), shards(NUM_SHARDS) {}
+
+    FunctorCache(const FunctorCache&) = delete;
+    FunctorCache& operator=(const FunctorCache&) = delete;
+
+    /**
+     * Get the result for the given arguments, calling compute(key) to obtain
+     * it if it is not cached.
+     */
+    template <typename F>
+    RamDomain lookup(const Key& key, F&& compute) {
+        const std::size_t h = Hash()(key);
+        Shard& shard = shards[h % NUM_SHARDS];
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            auto pos = shard.results.find(key);
+            if (pos != shard.results.end()) {
+                return pos->second;
+            }
+        }
+        const RamDomain result = compute(key);
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            if (shard.results.size() >= shardCapacity) {
+                shard.results.clear();
+            }
+            shard.results.emplace(key, result);
+        }
+        return result;
+    }
+
+    /** Return the number of cached results */
+    std::size_t size() const {
+        std::size_t res = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            res += shard.results.size();
+        }
+        return res;
+    }
+
+private:
+    struct Hash {
+        std::size_t operator()(const Key& key) const {
+            uint64_t h = 0xcbf29ce484222325ULL;
+            for (RamDomain value : key) {
+                h = (h ^ static_cast<uint64_t>(static_cast<RamUnsigned>(value))) * 0x100000001b3ULL;
+            }
+            return static_cast<std::size_t>(h ^ (h >> 29));
+        }
+    };
+
+    // shards are aligned to cache lines, such that threads locking different shards do not contend
+    struct alignas(64) Shard {
+        mutable std::mutex lock;
+        std::unordered_map<Key, RamDomain, Hash> results;
+    };
+
+    /** The number of results kept per shard */
+    const std::size_t shardCapacity;
+
+    std::vector<Shard> shards;
+};
+
+}  // namespace souffle
@@ -0,0 +1,96 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FunctorContexts.h
+ *
+ * The per-thread contexts of stateful functors declared `thread_local`.
+ *
+ * A library defining such a functor `f` also defines the hooks creating
+ * and destroying the context of a thread, which `f` receives after the
+ * symbol and record tables:
+ *
+ *     void* f_init();
+ *     void f_fini(void* context);
+ *     RamDomain f(SymbolTable*, RecordTable*, void* context, RamDomain...);
+ *
+ * The context of a thread is created by its first call of the functor and
+ * only passed to calls of that thread, such that functors may keep caches
+ * without synchronising their threads. All contexts are destroyed with the
+ * program.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+class FunctorContexts {
+public:
+    using Init = void* (*)();
+    using Fini = void (*)(void*);
+
+    FunctorContexts(Init init, Fini fini) : init(init), fini(fini), id(nextId()) {}
+
+    FunctorContexts(const FunctorContexts&) = delete;
+    FunctorContexts& operator=(const FunctorContexts&) = delete;
+
+    ~FunctorContexts() {
+        for (void* context : contexts) {
+            fini(context);
+        }
+    }
+
+    /** Get the context of the calling thread, creating it by the first call of the thread */
+    void* get() {
+        // contexts are keyed by the identifier of their functor, which is never reused, such that
+        // the entries of destroyed functors are never found again
+        thread_local std::pair<std::uint64_t, void*> last{0, nullptr};
+        thread_local std::unordered_map<std::uint64_t, void*> local;
+        if (last.first == id) {
+            return last.second;
+        }
+        auto pos = local.find(id);
+        if (pos == local.end()) {
+            void* context = init();
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                contexts.push_back(context);
+            }
+            pos = local.emplace(id, context).first;
+        }
+        last = *pos;
+        return pos->second;
+    }
+
+private:
+    const Init init;
+    const Fini fini;
+
+    /** Identifier of the functor, starting from 1 */
+    const std::uint64_t id;
+
+    /** Contexts created by all threads, destroyed with the functor */
+    std::vector<void*> contexts;
+    std::mutex lock;
+
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+};
+
+}  // namespace souffle
@@ -0,0 +1,61 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NativeStrata.h
+ *
+ * Declares the C interface of a shared library of synthesised strata,
+ * through which the interpreter evaluates them as native code.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <cstddef>
+
+/**
+ * A library of native strata is synthesised with `--native-strata` and holds the code of the selected
+ * strata of a program. The interpreter encodes the symbols of the constants of the library first, such
+ * that both agree on their indices, and shares its symbol and record tables with the library.
+ *
+ * The relations of the library are private copies, which the interpreter fills with the relations a
+ * stratum reads before running it, and from which it takes the relations the stratum derives.
+ */
+extern "C" {
+
+/** Return the symbol of the constant with the given index, or null past the last constant */
+const char* souffle_native_symbol(std::size_t index);
+
+/**
+ * Create the relations of the library, sharing the given symbol table and record table
+ *
+ * @param symbolTable a souffle::SymbolTable
+ * @param recordTable a souffle::RecordTable
+ */
+void* souffle_native_create(void* symbolTable, void* recordTable, const char* inputDirectory,
+        const char* outputDirectory, std::size_t numThreads);
+
+void souffle_native_destroy(void* program);
+
+/** Return non-zero if the library evaluates the stratum of the given name, e.g. "stratum_3" */
+int souffle_native_provides(const char* stratum);
+
+void souffle_native_run(void* program, const char* stratum);
+
+/** Insert count tuples, stored consecutively; return zero if the library has no such relation */
+int souffle_native_insert(void* program, const char* relation, const souffle::RamDomain* tuples,
+        std::size_t count);
+
+/** Pass each tuple of the relation to the visitor; return zero if the library has no such relation */
+int souffle_native_scan(void* program, const char* relation,
+        void (*visitor)(void* context, const souffle::RamDomain* tuple), void* context);
+
+void souffle_native_purge(void* program, const char* relation);
+}
@@ -0,0 +1,34 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProgramLibrary.h
+ *
+ * Declares the entry points of a program built as a shared library,
+ * through which an application creates instances of the program.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/SouffleInterface.h"
+
+/**
+ * A program synthesised with `--shared-library` is built as a shared library, which an application
+ * loads at run time, e.g. by dlopen(), and resolves the entry points of by dlsym(). Each instance owns
+ * its relations, symbol table and record table, hence several instances of the program may be evaluated
+ * concurrently by different threads.
+ */
+extern "C" {
+
+/** Create an instance of the program, to be released by souffle_program_destroy() */
+souffle::SouffleProgram* souffle_program_create();
+
+void souffle_program_destroy(souffle::SouffleProgram* program);
+}
@@ -18,12 +18,22 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
-#include "souffle/datastructure/ConcurrentFlyweight.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/span.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -40,13 +50,6 @@ constexpr void constexpr_for(F&& f) {
     }
 }
 
-/// @brief The data-type of RamDomain records of any size.
-using GenericRecord = std::vector<RamDomain>;
-
-/// @brief The data-type of RamDomain records of specialized size.
-template <std::size_t Arity>
-using SpecializedRecord = std::array<RamDomain, Arity>;
-
 /// @brief A view in a sequence of RamDomain value.
 // TODO: use a `span`.
 struct GenericRecordView {
@@ -67,24 +70,6 @@ struct GenericRecordView {
     }
 };
 
-template <std::size_t Arity>
-struct SpecializedRecordView {
-    explicit SpecializedRecordView(const RamDomain* Data) : Data(Data) {}
-    SpecializedRecordView(const SpecializedRecordView& Other) : Data(Other.Data) {}
-    SpecializedRecordView(SpecializedRecordView&& Other) : Data(Other.Data) {}
-
-    const RamDomain* const Data;
-
-    const RamDomain* data() const {
-        return Data;
-    }
-
-    const RamDomain& operator[](int I) const {
-        assert(I >= 0 && static_cast<std::size_t>(I) < Arity);
-        return Data[I];
-    }
-};
-
 /// @brief Hash function object for a RamDomain record.
 struct GenericRecordHash {
     explicit GenericRecordHash(const std::size_t Arity) : Arity(Arity) {}
@@ -250,89 +235,6 @@ struct SpecializedRecordCmp<0> {
     }
 };
 
-/// @brief Factory of RamDomain record.
-struct GenericRecordFactory {
-    using value_type = GenericRecord;
-    using pointer = GenericRecord*;
-    using reference = GenericRecord&;
-
-    explicit GenericRecordFactory(const std::size_t Arity) : Arity(Arity) {}
-    GenericRecordFactory(const GenericRecordFactory& Other) : Arity(Other.Arity) {}
-    GenericRecordFactory(GenericRecordFactory&& Other) : Arity(Other.Arity) {}
-
-    const std::size_t Arity;
-
-    reference replace(reference Place, const std::vector<RamDomain>& V) {
-        assert(V.size() == Arity);
-        Place = V;
-        return Place;
-    }
-
-    reference replace(reference Place, const GenericRecordView& V) {
-        Place.clear();
-        Place.insert(Place.begin(), V.data(), V.data() + Arity);
-        return Place;
-    }
-
-    reference replace(reference Place, const RamDomain* V) {
-        Place.clear();
-        Place.insert(Place.begin(), V, V + Arity);
-        return Place;
-    }
-};
-
-template <std::size_t Arity>
-struct SpecializedRecordFactory {
-    using value_type = SpecializedRecord<Arity>;
-    using pointer = SpecializedRecord<Arity>*;
-    using reference = SpecializedRecord<Arity>&;
-
-    explicit SpecializedRecordFactory() {}
-    SpecializedRecordFactory(const SpecializedRecordFactory&) {}
-    SpecializedRecordFactory(SpecializedRecordFactory&&) {}
-
-    reference replace(reference Place, const SpecializedRecord<Arity>& V) {
-        assert(V.size() == Arity);
-        Place = V;
-        return Place;
-    }
-
-    reference replace(reference Place, const SpecializedRecordView<Arity>& V) {
-        constexpr std::size_t Len = Arity * sizeof(RamDomain);
-        std::memcpy(Place.data(), V.data(), Len);
-        return Place;
-    }
-
-    reference replace(reference Place, const RamDomain* V) {
-        constexpr std::size_t Len = Arity * sizeof(RamDomain);
-        std::memcpy(Place.data(), V, Len);
-        return Place;
-    }
-};
-
-template <>
-struct SpecializedRecordFactory<0> {
-    using value_type = SpecializedRecord<0>;
-    using pointer = SpecializedRecord<0>*;
-    using reference = SpecializedRecord<0>&;
-
-    explicit SpecializedRecordFactory() {}
-    SpecializedRecordFactory(const SpecializedRecordFactory&) {}
-    SpecializedRecordFactory(SpecializedRecordFactory&&) {}
-
-    reference replace(reference Place, const SpecializedRecord<0>&) {
-        return Place;
-    }
-
-    reference replace(reference Place, const SpecializedRecordView<0>&) {
-        return Place;
-    }
-
-    reference replace(reference Place, const RamDomain*) {
-        return Place;
-    }
-};
-
 }  // namespace details
 
 /** @brief Interface of bidirectional mappping between records and record references. */
@@ -344,101 +246,216 @@ public:
     virtual RamDomain pack(const RamDomain* Tuple) = 0;
     virtual RamDomain pack(const std::initializer_list<RamDomain>& List) = 0;
     virtual const RamDomain* unpack(RamDomain index) const = 0;
+    virtual std::size_t size() const = 0;
+    virtual std::size_t getMemoryUsage() const = 0;
 };
 
-/** @brief Bidirectional mappping between records and record references, for any record arity. */
-class GenericRecordMap : public RecordMap,
-                         protected FlyweightImpl<details::GenericRecord, details::GenericRecordHash,
-                                 details::GenericRecordEqual, details::GenericRecordFactory> {
-    using Base = FlyweightImpl<details::GenericRecord, details::GenericRecordHash,
-            details::GenericRecordEqual, details::GenericRecordFactory>;
+/**
+ * @brief Bidirectional mapping between records and record references, storing the records in an arena.
+ *
+ * Records are stored contiguously in blocks of doubling capacity, such that the location of a record
+ * follows from its reference and blocks never move; unpacking a record is an indexed load. The reverse
+ * mapping consists of open-addressing hash tables of record references, each guarded by its own lock and
+ * selected by the hash of the record, such that concurrent packs of different records rarely contend.
+ * Reference 0 is reserved, the first record is assigned reference 1.
+ */
+template <class Hash, class Equal>
+class ArenaRecordMap : public RecordMap {
+    // capacity of the first block, in records
+    static constexpr std::size_t FirstBlockBits = 6;
+    static constexpr std::uint64_t FirstBlockSize = 1ULL << FirstBlockBits;
+
+    // enough blocks to address all non-negative references
+    static constexpr std::size_t MaxBlocks = 32;
+
+    // number of independently locked hash tables
+    static constexpr std::size_t ShardBits = 6;
+    static constexpr std::size_t ShardCount = 1 << ShardBits;
+
+    struct alignas(64) Shard {
+        SpinLock Lock;
+
+        // open-addressing table of record references, 0 marks an empty slot
+        std::vector<std::uint32_t> Table;
+
+        // log2 of the table size
+        std::size_t Bits = 0;
+
+        // number of records in the table
+        std::size_t Count = 0;
+    };
 
     const std::size_t Arity;
+    Hash Hasher;
+    Equal EqualTo;
 
-public:
-    explicit GenericRecordMap(const std::size_t lane_count, const std::size_t arity)
-            : Base(lane_count, 8, true, details::GenericRecordHash(arity), details::GenericRecordEqual(arity),
-                      details::GenericRecordFactory(arity)),
-              Arity(arity) {}
+    // the blocks of records, allocated on demand
+    std::atomic<RamDomain*> Blocks[MaxBlocks];
 
-    virtual ~GenericRecordMap() {}
+    std::unique_ptr<Shard[]> Shards;
+
+    // the reference assigned to the next new record
+    std::atomic<std::uint32_t> NextRef{1};
+
+public:
+    ArenaRecordMap(const std::size_t Arity, const Hash& hash, const Equal& equal)
+            : Arity(Arity), Hasher(hash), EqualTo(equal), Shards(std::make_unique<Shard[]>(ShardCount)) {
+        for (auto& Block : Blocks) {
+            Block.store(nullptr, std::memory_order_relaxed);
+        }
+    }
 
-    void setNumLanes(const std::size_t NumLanes) override {
-        Base::setNumLanes(NumLanes);
+    ~ArenaRecordMap() override {
+        for (auto& Block : Blocks) {
+            delete[] Block.load(std::memory_order_relaxed);
+        }
     }
 
+    void setNumLanes(const std::size_t) override {}
+
     /** @brief converts record to a record reference */
     RamDomain pack(const std::vector<RamDomain>& Vector) override {
-        return findOrInsert(Vector).first;
-    };
+        assert(Vector.size() == Arity);
+        return pack(Vector.data());
+    }
 
     /** @brief converts record to a record reference */
-    RamDomain pack(const RamDomain* Tuple) override {
-        details::GenericRecordView View{Tuple, Arity};
-        return findOrInsert(View).first;
+    RamDomain pack(const std::initializer_list<RamDomain>& List) override {
+        assert(List.size() == Arity);
+        return pack(std::data(List));
     }
 
     /** @brief converts record to a record reference */
-    RamDomain pack(const std::initializer_list<RamDomain>& List) override {
-        details::GenericRecordView View{std::data(List), Arity};
-        return findOrInsert(View).first;
+    RamDomain pack(const RamDomain* Tuple) override {
+        const details::GenericRecordView View{Tuple, Arity};
+        const std::uint64_t HashValue = mix(Hasher(View));
+        Shard& S = Shards[HashValue >> (64 - ShardBits)];
+        std::lock_guard<SpinLock> Guard(S.Lock);
+        if ((S.Count + 1) * 4 > S.Table.size() * 3) {
+            grow(S);
+        }
+        const std::size_t Mask = S.Table.size() - 1;
+        for (std::size_t Pos = position(HashValue, S.Bits);; Pos = (Pos + 1) & Mask) {
+            const std::uint32_t Ref = S.Table[Pos];
+            if (Ref == 0) {
+                const std::uint32_t NewRef = NextRef.fetch_add(1, std::memory_order_relaxed);
+                assert(NewRef <= static_cast<std::uint32_t>(std::numeric_limits<RamDomain>::max()) &&
+                        "record references exhausted");
+                std::memcpy(allocate(NewRef), Tuple, Arity * sizeof(RamDomain));
+                S.Table[Pos] = NewRef;
+                ++S.Count;
+                return static_cast<RamDomain>(NewRef);
+            }
+            if (EqualTo(View, details::GenericRecordView{locate(Ref), Arity})) {
+                return static_cast<RamDomain>(Ref);
+            }
+        }
     }
 
     /** @brief convert record reference to a record pointer */
     const RamDomain* unpack(RamDomain Index) const override {
-        return fetch(Index).data();
+        return locate(static_cast<std::uint32_t>(Index));
     }
-};
 
-/** @brief Bidirectional mappping between records and record references, specialized for a record arity. */
-template <std::size_t Arity>
-class SpecializedRecordMap
-        : public RecordMap,
-          protected FlyweightImpl<details::SpecializedRecord<Arity>, details::SpecializedRecordHash<Arity>,
-                  details::SpecializedRecordEqual<Arity>, details::SpecializedRecordFactory<Arity>> {
-    using Record = details::SpecializedRecord<Arity>;
-    using RecordView = details::SpecializedRecordView<Arity>;
-    using RecordHash = details::SpecializedRecordHash<Arity>;
-    using RecordEqual = details::SpecializedRecordEqual<Arity>;
-    using RecordFactory = details::SpecializedRecordFactory<Arity>;
-    using Base = FlyweightImpl<Record, RecordHash, RecordEqual, RecordFactory>;
+    /** @brief number of records */
+    std::size_t size() const override {
+        return NextRef.load(std::memory_order_relaxed) - 1;
+    }
 
-public:
-    SpecializedRecordMap(const std::size_t LaneCount)
-            : Base(LaneCount, 8, true, RecordHash(), RecordEqual(), RecordFactory()) {}
+    /** @brief number of bytes allocated by the records and the hash tables */
+    std::size_t getMemoryUsage() const override {
+        std::size_t res = sizeof(*this) + ShardCount * sizeof(Shard);
+        for (std::size_t Block = 0; Block < MaxBlocks; ++Block) {
+            if (Blocks[Block].load(std::memory_order_relaxed) != nullptr) {
+                res += (FirstBlockSize << Block) * Arity * sizeof(RamDomain);
+            }
+        }
+        for (std::size_t I = 0; I < ShardCount; ++I) {
+            res += Shards[I].Table.capacity() * sizeof(std::uint32_t);
+        }
+        return res;
+    }
 
-    virtual ~SpecializedRecordMap() {}
+private:
+    static std::uint64_t mix(const std::uint64_t HashValue) {
+        return HashValue * 0x9e3779b97f4a7c15ULL;
+    }
 
-    void setNumLanes(const std::size_t NumLanes) override {
-        Base::setNumLanes(NumLanes);
+    // the start of the probe sequence, using the hash bits below those selecting the shard
+    static std::size_t position(const std::uint64_t HashValue, const std::size_t Bits) {
+        return static_cast<std::size_t>((HashValue << ShardBits) >> (64 - Bits));
     }
 
-    /** @brief converts record to a record reference */
-    RamDomain pack(const std::vector<RamDomain>& Vector) override {
-        assert(Vector.size() == Arity);
-        RecordView View{Vector.data()};
-        return Base::findOrInsert(View).first;
-    };
+    // the block holding the given reference, and the position of the reference within the block
+    static std::pair<std::size_t, std::uint64_t> blockOf(const std::uint32_t Ref) {
+        const std::uint64_t Pos = Ref + FirstBlockSize;
+        const std::size_t Block = 63 - __builtin_clzll(Pos) - FirstBlockBits;
+        return {Block, Pos - (FirstBlockSize << Block)};
+    }
 
-    /** @brief converts record to a record reference */
-    RamDomain pack(const RamDomain* Tuple) override {
-        RecordView View{Tuple};
-        return Base::findOrInsert(View).first;
+    const RamDomain* locate(const std::uint32_t Ref) const {
+        const auto [Block, Offset] = blockOf(Ref);
+        return Blocks[Block].load(std::memory_order_acquire) + Offset * Arity;
     }
 
-    /** @brief converts record to a record reference */
-    RamDomain pack(const std::initializer_list<RamDomain>& List) override {
-        assert(List.size() == Arity);
-        RecordView View{std::data(List)};
-        return Base::findOrInsert(View).first;
+    // the location of a new record, allocating its block if necessary
+    RamDomain* allocate(const std::uint32_t Ref) {
+        const auto [Block, Offset] = blockOf(Ref);
+        RamDomain* Data = Blocks[Block].load(std::memory_order_acquire);
+        if (Data == nullptr) {
+            auto* Fresh = new RamDomain[(FirstBlockSize << Block) * Arity];
+            if (Blocks[Block].compare_exchange_strong(
+                        Data, Fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                Data = Fresh;
+            } else {
+                delete[] Fresh;
+            }
+        }
+        return Data + Offset * Arity;
     }
 
-    /** @brief convert record reference to a record pointer */
-    const RamDomain* unpack(RamDomain Index) const override {
-        return Base::fetch(Index).data();
+    // doubles the table of the given shard, which must be locked
+    void grow(Shard& S) {
+        const std::size_t Bits = std::max<std::size_t>(S.Bits + 1, 4);
+        std::vector<std::uint32_t> Table(std::size_t(1) << Bits, 0);
+        const std::size_t Mask = Table.size() - 1;
+        for (const std::uint32_t Ref : S.Table) {
+            if (Ref == 0) {
+                continue;
+            }
+            const std::uint64_t HashValue = mix(Hasher(details::GenericRecordView{locate(Ref), Arity}));
+            std::size_t Pos = position(HashValue, Bits);
+            while (Table[Pos] != 0) {
+                Pos = (Pos + 1) & Mask;
+            }
+            Table[Pos] = Ref;
+        }
+        S.Table.swap(Table);
+        S.Bits = Bits;
     }
 };
 
+/** @brief Bidirectional mappping between records and record references, for any record arity. */
+class GenericRecordMap : public ArenaRecordMap<details::GenericRecordHash, details::GenericRecordEqual> {
+    using Base = ArenaRecordMap<details::GenericRecordHash, details::GenericRecordEqual>;
+
+public:
+    explicit GenericRecordMap(const std::size_t /* lane_count */, const std::size_t arity)
+            : Base(arity, details::GenericRecordHash(arity), details::GenericRecordEqual(arity)) {}
+};
+
+/** @brief Bidirectional mappping between records and record references, specialized for a record arity. */
+template <std::size_t Arity>
+class SpecializedRecordMap : public ArenaRecordMap<details::SpecializedRecordHash<Arity>,
+                                     details::SpecializedRecordEqual<Arity>> {
+    using Hash = details::SpecializedRecordHash<Arity>;
+    using Equal = details::SpecializedRecordEqual<Arity>;
+    using Base = ArenaRecordMap<Hash, Equal>;
+
+public:
+    SpecializedRecordMap(const std::size_t /* LaneCount */) : Base(Arity, Hash(), Equal()) {}
+};
+
 /** Record map specialized for arity 0 */
 template <>
 class SpecializedRecordMap<0> : public RecordMap {
@@ -479,6 +496,16 @@ public:
         assert(Index == EmptyRecordIndex);
         return EmptyRecordData;
     }
+
+    /** @brief number of records; the empty record is not stored */
+    std::size_t size() const override {
+        return 0;
+    }
+
+    /** @brief number of bytes allocated by the records */
+    std::size_t getMemoryUsage() const override {
+        return sizeof(*this);
+    }
 };
 
 /** The interface of any Record Table. */
@@ -493,8 +520,41 @@ public:
     virtual RamDomain pack(const std::initializer_list<RamDomain>& List) = 0;
 
     virtual const RamDomain* unpack(const RamDomain Ref, const std::size_t Arity) const = 0;
+
+    /** @brief number of records of all arities */
+    virtual std::size_t size() const = 0;
+
+    /** @brief number of bytes allocated by the record table */
+    virtual std::size_t getMemoryUsage() const = 0;
+
+    /** @brief write the records of all arities to the given file, in the order of their references */
+    virtual void save(const std::string& fileName) const = 0;
+
+    /**
+     * @brief restore the records of the given file written by save(), keeping their references, e.g. to
+     * resume an evaluation from a checkpoint; the table must not hold other records
+     */
+    virtual void restore(const std::string& fileName) = 0;
 };
 
+/**
+ * The branches without arguments of an ADT that is not an enumeration are not stored in the record
+ * table, but encoded by negative values, which are never references of records.
+ */
+inline RamDomain packUnboxedBranch(RamDomain branchId) {
+    return -branchId - 1;
+}
+
+/** Whether a value of an ADT that is not an enumeration is a branch without arguments */
+inline bool isUnboxedBranch(RamDomain value) {
+    return value < 0;
+}
+
+/** The branch encoded by packUnboxedBranch */
+inline RamDomain unpackUnboxedBranch(RamDomain value) {
+    return -value - 1;
+}
+
 /** A concurrent Record Table with some specialized record maps. */
 template <std::size_t... SpecializedArities>
 class SpecializedRecordTable : public RecordTable {
@@ -548,6 +608,16 @@ public:
         }
     }
 
+    /**
+     * @brief Exchange the records of two tables, e.g. to replace the records of a table by a compacted
+     * copy.
+     * Not thread-safe, use only when neither table is being used.
+     */
+    void swap(SpecializedRecordTable& Other) {
+        std::swap(Size, Other.Size);
+        Maps.swap(Other.Maps);
+    }
+
     /** @brief convert tuple to record reference */
     virtual RamDomain pack(const RamDomain* Tuple, const std::size_t Arity) override {
         auto Guard = Lanes.guard();
@@ -566,7 +636,104 @@ public:
         return lookupMap(Arity).unpack(Ref);
     }
 
+    /** @brief number of records of all arities */
+    virtual std::size_t size() const override {
+        std::size_t res = 0;
+        for (const auto* Map : Maps) {
+            if (Map) {
+                res += Map->size();
+            }
+        }
+        return res;
+    }
+
+    /** @brief number of bytes allocated by the record table */
+    virtual std::size_t getMemoryUsage() const override {
+        std::size_t res = sizeof(*this) + Maps.capacity() * sizeof(RecordMap*);
+        for (const auto* Map : Maps) {
+            if (Map) {
+                res += Map->getMemoryUsage();
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief write the records of all arities to the given file
+     *
+     * The file consists of the magic "SOUFFLER", the number of arities and per arity the arity, the
+     * number of records and their fields in the order of their references, in native byte order.
+     */
+    void save(const std::string& fileName) const override {
+        std::ofstream out(fileName, std::ios::out | std::ios::binary);
+        if (!out.is_open()) {
+            throw std::invalid_argument("Cannot open record file " + fileName);
+        }
+        out.write(RECORD_FILE_MAGIC, sizeof(RECORD_FILE_MAGIC));
+        std::vector<std::size_t> arities;
+        for (std::size_t Arity = 0; Arity < Size; ++Arity) {
+            if (Maps[Arity] != nullptr && Maps[Arity]->size() > 0) {
+                arities.push_back(Arity);
+            }
+        }
+        writeUInt64(out, arities.size());
+        for (const std::size_t Arity : arities) {
+            const std::size_t Count = Maps[Arity]->size();
+            writeUInt64(out, Arity);
+            writeUInt64(out, Count);
+            // references of each arity are dense, starting at 1
+            for (std::size_t Ref = 1; Ref <= Count; ++Ref) {
+                out.write(reinterpret_cast<const char*>(Maps[Arity]->unpack(static_cast<RamDomain>(Ref))),
+                        static_cast<std::streamsize>(Arity * sizeof(RamDomain)));
+            }
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write record file " + fileName);
+        }
+    }
+
+    /** @brief restore the records of the given file written by save() */
+    void restore(const std::string& fileName) override {
+        std::ifstream in(fileName, std::ios::in | std::ios::binary);
+        if (!in.is_open()) {
+            throw std::invalid_argument("Cannot open record file " + fileName);
+        }
+        char Magic[sizeof(RECORD_FILE_MAGIC)];
+        if (!in.read(Magic, sizeof(Magic)) || std::memcmp(Magic, RECORD_FILE_MAGIC, sizeof(Magic)) != 0) {
+            throw std::invalid_argument("Invalid record file " + fileName);
+        }
+        std::vector<RamDomain> Record;
+        for (std::uint64_t Arities = readUInt64(in, fileName); Arities > 0; --Arities) {
+            const std::size_t Arity = readUInt64(in, fileName);
+            const std::uint64_t Count = readUInt64(in, fileName);
+            Record.resize(Arity);
+            for (std::uint64_t Ref = 1; Ref <= Count; ++Ref) {
+                if (!in.read(reinterpret_cast<char*>(Record.data()),
+                            static_cast<std::streamsize>(Arity * sizeof(RamDomain)))) {
+                    throw std::invalid_argument("Truncated record file " + fileName);
+                }
+                if (lookupMap(Arity).pack(Record.data()) != static_cast<RamDomain>(Ref)) {
+                    throw std::invalid_argument("Record file " + fileName + " does not match the table");
+                }
+            }
+        }
+    }
+
 private:
+    static constexpr char RECORD_FILE_MAGIC[8] = {'S', 'O', 'U', 'F', 'F', 'L', 'E', 'R'};
+
+    static void writeUInt64(std::ostream& out, std::uint64_t value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static std::uint64_t readUInt64(std::istream& in, const std::string& fileName) {
+        std::uint64_t value = 0;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+            throw std::invalid_argument("Truncated record file " + fileName);
+        }
+        return value;
+    }
+
     /** @brief lookup RecordMap for a given arity; the map for that arity must exist. */
     RecordMap& lookupMap(const std::size_t Arity) const {
         assert(Arity < Size && "Lookup for an arity while there is no record for that arity.");
@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include "souffle/utility/General.h"
 #include <atomic>
 #include <csignal>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -54,35 +56,21 @@ public:
     }
     // set signal message
     void setMsg(const char* m) {
-        if (logMessages && m != nullptr) {
-            static std::mutex outputMutex;
-            static bool sameLine = false;
-            std::lock_guard<std::mutex> guard(outputMutex);
-            if (msg != nullptr && strcmp(m, msg) == 0) {
-                std::cout << ".";
-                sameLine = true;
-            } else {
-                if (sameLine) {
-                    sameLine = false;
-                    std::cout << std::endl;
-                }
-                std::string outputMessage(m);
-                for (char& c : outputMessage) {
-                    if (c == '\n' || c == '\t') {
-                        c = ' ';
-                    }
-                }
-                std::cout << "Starting work on " << outputMessage << std::endl;
-            }
+        if (SOUFFLE_UNLIKELY(logMessages) && m != nullptr) {
+            logMsg(m);
         }
         msg = m;
     }
 
     /***
      * set signal handlers
+     *
+     * The handlers are shared by all programs of the process, hence they are installed by the
+     * first of the concurrently evaluated programs and kept until the last one resets them.
      */
     void set() {
-        if (!isSet && std::getenv("SOUFFLE_ALLOW_SIGNALS") == nullptr) {
+        std::lock_guard<std::mutex> guard(runsMutex);
+        if (activeRuns++ == 0 && std::getenv("SOUFFLE_ALLOW_SIGNALS") == nullptr) {
             // register signals
             // floating point exception
             if ((prevFpeHandler = signal(SIGFPE, handler)) == SIG_ERR) {
@@ -107,7 +95,8 @@ public:
      * reset signal handlers
      */
     void reset() {
-        if (isSet) {
+        std::lock_guard<std::mutex> guard(runsMutex);
+        if (activeRuns > 0 && --activeRuns == 0 && isSet) {
             // reset floating point exception
             if (signal(SIGFPE, prevFpeHandler) == SIG_ERR) {
                 perror("Failed to reset SIGFPE signal handler.");
@@ -131,7 +120,7 @@ public:
      * error handling routine that prints the rule context.
      */
 
-    void error(const std::string& error) {
+    SOUFFLE_COLD void error(const std::string& error) {
         if (msg != nullptr) {
             std::cerr << error << " in rule:\n" << msg << std::endl;
         } else {
@@ -141,6 +130,29 @@ public:
     }
 
 private:
+    // print the message being set, kept out of line of the evaluation
+    SOUFFLE_COLD void logMsg(const char* m) {
+        static std::mutex outputMutex;
+        static bool sameLine = false;
+        std::lock_guard<std::mutex> guard(outputMutex);
+        if (msg != nullptr && strcmp(m, msg) == 0) {
+            std::cout << ".";
+            sameLine = true;
+        } else {
+            if (sameLine) {
+                sameLine = false;
+                std::cout << std::endl;
+            }
+            std::string outputMessage(m);
+            for (char& c : outputMessage) {
+                if (c == '\n' || c == '\t') {
+                    c = ' ';
+                }
+            }
+            std::cout << "Starting work on " << outputMessage << std::endl;
+        }
+    }
+
     // signal context information
     std::atomic<const char*> msg;
     static_assert(decltype(msg)::is_always_lock_free, "cannot safely use in signal handler");
@@ -148,6 +160,10 @@ private:
     // state of signal handler
     bool isSet = false;
 
+    // the number of programs being evaluated, which share the signal handlers
+    std::size_t activeRuns = 0;
+    std::mutex runsMutex;
+
     bool logMessages = false;
 
     // previous signal handler routines
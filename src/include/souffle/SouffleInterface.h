@@ -20,15 +20,22 @@
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/span.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <initializer_list>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <optional>
+#include <set>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -291,6 +298,18 @@ public:
      */
     virtual void insert(const tuple& t) = 0;
 
+    /**
+     * Insert n tuples at once, whose elements are stored consecutively in the given buffer, i.e., the
+     * buffer holds n * getArity() elements. Symbols are given by their indices in the symbol table.
+     *
+     * Unlike insert(), the tuples are neither wrapped in tuple objects nor inserted by a virtual call
+     * each, which is the preferred way to load large amounts of facts.
+     *
+     * @param tuples The elements of the tuples
+     * @param n The number of tuples
+     */
+    virtual void insertBatch(span<const RamDomain> tuples, std::size_t n);
+
     /**
      * Check whether a tuple exists in a relation.
      * The definition of contains has to be defined by the child class of relation class.
@@ -300,6 +319,18 @@ public:
      */
     virtual bool contains(const tuple& t) const = 0;
 
+    /**
+     * Find the tuple whose primary attributes equal those of the given buffer, and complete the
+     * buffer by its auxiliary attributes, e.g., the provenance annotations of the tuple.
+     *
+     * The default implementation scans the relation; relations with an index ordered by the
+     * primary attributes find the tuple by a search of the index.
+     *
+     * @param t A buffer of getArity() elements, whose first getPrimaryArity() elements are given
+     * @return Boolean. True, if the tuple exists. False, otherwise
+     */
+    virtual bool findPrimary(span<RamDomain> t) const;
+
     /**
      * Return an iterator pointing to the first tuple of the relation.
      * This iterator is used to access the tuples of the relation.
@@ -315,6 +346,23 @@ public:
      */
     virtual iterator end() const = 0;
 
+    /**
+     * The callback of scanBatch(), receiving n tuples whose elements are stored consecutively.
+     */
+    using batch_callback = std::function<void(span<const RamDomain> tuples, std::size_t n)>;
+
+    /**
+     * Pass all tuples of the relation to the callback, in batches of up to batchSize tuples whose
+     * elements are stored consecutively. Symbols are given by their indices in the symbol table.
+     *
+     * The buffer of a batch is only valid during the call of the callback, which must not modify
+     * the relation.
+     *
+     * @param callback The callback receiving the batches
+     * @param batchSize The maximal number of tuples of a batch, at least 1
+     */
+    virtual void scanBatch(const batch_callback& callback, std::size_t batchSize) const;
+
     /**
      * Get the number of tuples in a relation.
      *
@@ -685,6 +733,46 @@ public:
     }
 };
 
+inline void Relation::insertBatch(span<const RamDomain> tuples, std::size_t n) {
+    const std::size_t arity = getArity();
+    assert(tuples.size() >= n * arity && "buffer too small");
+    tuple t(this);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::copy_n(tuples.data() + i * arity, arity, t.begin());
+        insert(t);
+    }
+}
+
+inline void Relation::scanBatch(const batch_callback& callback, std::size_t batchSize) const {
+    assert(batchSize > 0 && "empty batches");
+    const std::size_t arity = getArity();
+    std::vector<RamDomain> buffer(batchSize * arity);
+    std::size_t n = 0;
+    for (const tuple& t : *this) {
+        std::copy_n(t.data, arity, buffer.data() + n * arity);
+        if (++n == batchSize) {
+            callback(buffer, n);
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        callback(span<const RamDomain>(buffer.data(), n * arity), n);
+    }
+}
+
+inline bool Relation::findPrimary(span<RamDomain> t) const {
+    const std::size_t arity = getArity();
+    const std::size_t primaryArity = getPrimaryArity();
+    assert(t.size() >= arity && "buffer too small");
+    for (const tuple& cur : *this) {
+        if (std::equal(cur.data, cur.data + primaryArity, t.data())) {
+            std::copy_n(cur.data, arity, t.data());
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * Abstract base class for generated Datalog programs.
  */
@@ -733,6 +821,36 @@ protected:
      */
     bool pruneImdtRels = true;
 
+    /**
+     * The callback invoked when a stratum completes, see setStratumCallback()
+     */
+    std::function<void(std::size_t)> stratumCallback;
+
+    /**
+     * The relations computed by the runs, see setRequestedRelations(), or none if all are
+     */
+    std::set<std::string> requestedRelations;
+
+    /**
+     * Invoke the stratum callback, if any, for the completed stratum.
+     */
+    void completeStratum(std::size_t stratum) const {
+        if (stratumCallback) {
+            stratumCallback(stratum);
+        }
+    }
+
+    /**
+     * Whether the evaluation was cancelled by cancel(), see runAsync()
+     */
+    std::atomic<bool> cancelled{false};
+
+    /**
+     * Whether the evaluation is cancelled once the deadline passes
+     */
+    bool hasDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+
     /**
      * Add the relation to relationMap (with its name) and allRelations,
      * depends on the properties of the relation, if the relation is an input relation, it will be added to
@@ -778,6 +896,112 @@ public:
      */
     virtual void run() {}
 
+    /**
+     * Execute run() computing only the given relations and the relations they depend on, see
+     * setRequestedRelations().
+     */
+    void run(const std::set<std::string>& relations) {
+        setRequestedRelations(relations);
+        run();
+        requestedRelations.clear();
+    }
+
+    /**
+     * Restrict the following runs to the strata computing the given relations and, transitively, the
+     * relations read by these strata. The other strata are skipped with their loads and stores, such
+     * that their relations are left as they are. An empty set of relations selects all strata.
+     */
+    void setRequestedRelations(std::set<std::string> relations) {
+        for (const auto& name : relations) {
+            if (relationMap.find(name) == relationMap.end()) {
+                throw std::invalid_argument("Unknown relation " + name);
+            }
+        }
+        requestedRelations = std::move(relations);
+    }
+
+    /**
+     * Select the strata computing the requested relations, and those computing the relations read by
+     * selected strata.
+     *
+     * @param requested the requested relations
+     * @param reads the relations each stratum reads, which are computed by other strata
+     * @param writes the relations each stratum computes or loads
+     * @return whether each stratum is selected
+     */
+    static std::vector<bool> selectStrata(const std::set<std::string>& requested,
+            const std::vector<std::vector<std::string>>& reads,
+            const std::vector<std::vector<std::string>>& writes) {
+        std::vector<bool> selected(writes.size(), false);
+        std::set<std::string> needed = requested;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t i = 0; i < writes.size(); ++i) {
+                auto isNeeded = [&](const std::string& name) { return needed.count(name) > 0; };
+                if (selected[i] || std::none_of(writes[i].begin(), writes[i].end(), isNeeded)) {
+                    continue;
+                }
+                selected[i] = true;
+                needed.insert(reads[i].begin(), reads[i].end());
+                changed = true;
+            }
+        }
+        return selected;
+    }
+
+    /**
+     * Execute run() on a new thread, whose result is true if the evaluation completed and false if it
+     * was cancelled. The destructor of the future waits for the evaluation.
+     *
+     * The evaluation is cancelled cooperatively by cancel() or by passing the deadline: the current
+     * loop of a recursive stratum and the remaining rules and strata are skipped, which leaves the
+     * relations loaded before, e.g. the input relations, intact for further runs.
+     */
+    std::future<bool> runAsync() {
+        cancelled = false;
+        return std::async(std::launch::async, [this]() {
+            run();
+            return !isCancelled();
+        });
+    }
+
+    /**
+     * Return a copy of the program in its current state, or null if the program cannot be copied.
+     *
+     * Tuples inserted into the copy and its runs leave this program unchanged, and vice versa. Copies
+     * of programs evaluated incrementally share the tuples of the relations they have not changed, and
+     * their runs only re-evaluate the strata affected by their changes.
+     */
+    virtual std::unique_ptr<SouffleProgram> clone() {
+        return nullptr;
+    }
+
+    /**
+     * Cancel the current evaluation of runAsync()
+     */
+    void cancel() {
+        cancelled = true;
+    }
+
+    /**
+     * Cancel the evaluations of runAsync() that have not completed at the given time
+     */
+    void setDeadline(std::chrono::steady_clock::time_point time) {
+        deadline = time;
+        hasDeadline = true;
+    }
+
+    /**
+     * Return true if the evaluation is cancelled, which is checked at the boundaries of the iterations
+     * of loops and before each rule.
+     */
+    bool isCancelled() const {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        return hasDeadline && std::chrono::steady_clock::now() >= deadline;
+    }
+
     /**
      * Execute program, loading inputs and storing outputs as required.
      * File IO types can use the given directories to find their input file.
@@ -830,6 +1054,22 @@ public:
         return numThreads;
     }
 
+    /**
+     * Set a callback invoked by run() on the thread evaluating a stratum, right after the stratum
+     * completes, with the index of the stratum.
+     *
+     * From then on, the relations computed by the stratum are no longer modified, and may be read by
+     * other threads while the evaluation continues, e.g., to stream partial results to consumers.
+     * Relations that are neither outputs nor read by later strata are pruned when they expire, thus
+     * are to be copied by the callback. Relations of strata still being evaluated must not be read.
+     * Independent strata may complete concurrently, hence the callback must be thread-safe.
+     *
+     * @param callback The callback receiving the index of each completed stratum
+     */
+    void setStratumCallback(std::function<void(std::size_t stratum)> callback) {
+        stratumCallback = std::move(callback);
+    }
+
     /**
      * Get Relation by its name from relationMap, if relation not found, return a nullptr.
      *
@@ -18,15 +18,25 @@
 
 #include "souffle/RamTypes.h"
 #include "souffle/datastructure/ConcurrentFlyweight.h"
+#include "souffle/datastructure/FrontCodedFlyweight.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <deque>
+#include <fstream>
 #include <initializer_list>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -37,10 +47,23 @@ namespace souffle {
  * @class SymbolTable
  *
  * SymbolTable encodes symbols to numbers and decodes numbers to symbols.
+ *
+ * Symbols are looked up by string views, so that encoding a symbol which
+ * already exists does not construct a string, and decoding is lock-free.
+ *
+ * Builds defining USE_COMPRESSED_SYMBOLS store the symbols front coded,
+ * which saves memory for many symbols sharing prefixes, but serialises
+ * encoding, and decodes each symbol into a buffer of the decoding thread.
  */
-class SymbolTable : protected FlyweightImpl<std::string> {
+#ifdef USE_COMPRESSED_SYMBOLS
+class SymbolTable : protected FrontCodedFlyweight {
+private:
+    using Base = FrontCodedFlyweight;
+#else
+class SymbolTable : protected FlyweightImpl<std::string, std::hash<std::string_view>, std::equal_to<>> {
 private:
-    using Base = FlyweightImpl<std::string>;
+    using Base = FlyweightImpl<std::string, std::hash<std::string_view>, std::equal_to<>>;
+#endif
 
 public:
     using iterator = typename Base::iterator;
@@ -64,6 +87,23 @@ public:
         }
     }
 
+    /**
+     * @brief Construct a symbol table with the given symbols, indexed in their order, e.g. the string
+     * constants of a synthesised program, which are views of string literals. The table is reserved for
+     * the symbols, and no string is constructed for a symbol other than the one stored by the table.
+     */
+    SymbolTable(const std::string_view* symbols, const std::size_t count) : Base(1, count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            findOrInsert(symbols[i]);
+        }
+    }
+
+    ~SymbolTable() {
+        for (auto& block : sortKeys) {
+            delete[] block.load();
+        }
+    }
+
     /**
      * @brief Set the number of concurrent access lanes.
      * This function is not thread-safe, do not call when other threads are using the datastructure.
@@ -72,6 +112,34 @@ public:
         Base::setNumLanes(NumLanes);
     }
 
+    /**
+     * @brief Exchange the symbols of two tables with the same number of lanes, e.g. to replace the
+     * symbols of a table by a compacted copy.
+     *
+     * Both tables forget the symbol files they saved or attached to, since the indices changed.
+     * This function is not thread-safe, do not call when other threads are using either table.
+     */
+    void swap(SymbolTable& other) {
+        Base::swap(other);
+        for (std::size_t i = 0; i < sortKeys.size(); ++i) {
+            auto* keys = sortKeys[i].load();
+            sortKeys[i].store(other.sortKeys[i].load());
+            other.sortKeys[i].store(keys);
+        }
+        savedSizes.clear();
+        attached.clear();
+        other.savedSizes.clear();
+        other.attached.clear();
+    }
+
+    /**
+     * @brief Prepare the table for the given total number of symbols, e.g. before encoding the symbols
+     * of an input file, such that the table does not grow while encoding them.
+     */
+    void reserve(const std::size_t count) {
+        Base::reserve(count);
+    }
+
     /** @brief Return an iterator on the first symbol. */
     iterator begin() const {
         return Base::begin();
@@ -82,23 +150,81 @@ public:
         return Base::end();
     }
 
+    /** @brief Return the number of symbols. */
+    std::size_t size() const {
+        return Base::size();
+    }
+
+    /** @brief Return the number of bytes allocated by the symbol table, including its symbols. */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = Base::getMemoryUsage();
+#ifndef USE_COMPRESSED_SYMBOLS
+        // symbols that fit into a string object are not allocated separately
+        const std::size_t inlineCapacity = std::string().capacity();
+        for (const auto& symbol : *this) {
+            if (symbol.first.capacity() > inlineCapacity) {
+                res += symbol.first.capacity() + 1;
+            }
+        }
+#endif
+        return res;
+    }
+
     /** @brief Check if the given symbol exist. */
-    bool weakContains(const std::string& symbol) const {
+    bool weakContains(std::string_view symbol) const {
         return Base::weakContains(symbol);
     }
 
     /** @brief Encode a symbol to a symbol index. */
-    RamDomain encode(const std::string& symbol) {
+    RamDomain encode(std::string_view symbol) {
         return Base::findOrInsert(symbol).first;
     }
 
-    /** @brief Decode a symbol index to a symbol. */
+    /**
+     * @brief Encode the symbols of the range [first, last) and write their symbol indices to out.
+     *
+     * Cheaper than encoding the symbols one by one, e.g. when loading the symbols of an input file.
+     */
+    template <class InputIt, class OutputIt>
+    void encodeBatch(InputIt first, InputIt last, OutputIt out) {
+        Base::findOrInsertAll(first, last, out);
+    }
+
+    /**
+     * @brief Decode a symbol index to a symbol.
+     *
+     * The symbols of builds defining USE_COMPRESSED_SYMBOLS are decoded into buffers of the calling
+     * thread, which remain valid until the thread decodes FrontCodedFlyweight::DECODE_BUFFERS further
+     * symbols.
+     */
     const std::string& decode(const RamDomain index) const {
         return Base::fetch(index);
     }
 
+    /**
+     * @brief Compare the symbols of two indices in the order of their strings.
+     *
+     * The indices follow the order in which the symbols were encoded rather than the order of the
+     * symbols. Hence the symbols are ordered by sort keys holding their first bytes, which are cached
+     * per index, and only decoded and compared in full if their first bytes agree.
+     *
+     * @return a negative number, zero, or a positive number if the first symbol is less than, equal to,
+     * or greater than the second
+     */
+    int compare(const RamDomain lhs, const RamDomain rhs) const {
+        if (lhs == rhs) {
+            return 0;
+        }
+        const std::uint64_t lhsKey = sortKey(lhs);
+        const std::uint64_t rhsKey = sortKey(rhs);
+        if (lhsKey != rhsKey) {
+            return lhsKey < rhsKey ? -1 : 1;
+        }
+        return decode(lhs).compare(decode(rhs));
+    }
+
     /** @brief Encode a symbol to a symbol index; aliases encode. */
-    RamDomain unsafeEncode(const std::string& symbol) {
+    RamDomain unsafeEncode(std::string_view symbol) {
         return encode(symbol);
     }
 
@@ -113,10 +239,198 @@ public:
      * @return the symbol index and a boolean indicating if an insertion
      * happened.
      */
-    std::pair<RamDomain, bool> findOrInsert(const std::string& symbol) {
+    std::pair<RamDomain, bool> findOrInsert(std::string_view symbol) {
         auto Res = Base::findOrInsert(symbol);
         return std::make_pair(Res.first, Res.second);
     }
+
+    /**
+     * @brief Write the symbols and their indices to the given file, such that other programs can
+     * attach to the indices, e.g. of binary relation snapshots referring to the file.
+     *
+     * The file consists of the magic "SOUFFLES", the number of symbols and per symbol its index,
+     * its length and its bytes, all as uint64 in native byte order. It is not rewritten unless
+     * symbols have been added since this table last wrote it.
+     */
+    void save(const std::string& fileName) const {
+        std::lock_guard<std::mutex> guard(filesLock);
+        auto pos = savedSizes.find(fileName);
+        if (pos != savedSizes.end() && pos->second == size()) {
+            return;
+        }
+        std::ofstream out(fileName, std::ios::out | std::ios::binary);
+        if (!out.is_open()) {
+            throw std::invalid_argument("Cannot open symbol file " + fileName);
+        }
+        out.write(SYMBOL_FILE_MAGIC, sizeof(SYMBOL_FILE_MAGIC));
+        // the number of symbols is written once they are, since decoded symbols may not outlive the loop
+        const auto countPos = out.tellp();
+        writeUInt64(out, 0);
+        std::uint64_t count = 0;
+        for (const auto& symbol : *this) {
+            writeUInt64(out, symbol.second);
+            writeUInt64(out, symbol.first.size());
+            out.write(symbol.first.data(), static_cast<std::streamsize>(symbol.first.size()));
+            ++count;
+        }
+        out.seekp(countPos);
+        writeUInt64(out, count);
+        savedSizes[fileName] = count;
+    }
+
+    /**
+     * @brief Attach to the symbol indices of the given file written by save().
+     *
+     * The symbols of the file are encoded once per table; the returned translation maps each index
+     * of the file to the index of the symbol in this table, and unused indices to -1. A table that
+     * attaches to a file before encoding any symbol keeps the indices of the file.
+     */
+    const std::vector<RamDomain>& attach(const std::string& fileName) {
+        std::lock_guard<std::mutex> guard(filesLock);
+        auto pos = attached.find(fileName);
+        if (pos != attached.end()) {
+            return pos->second;
+        }
+        std::vector<std::uint64_t> indices;
+        std::vector<std::string> symbols;
+        read(fileName, indices, symbols);
+        const std::size_t count = symbols.size();
+        std::uint64_t maxIndex = 0;
+        for (std::uint64_t index : indices) {
+            maxIndex = std::max(maxIndex, index);
+        }
+        std::vector<RamDomain> encoded(count);
+        reserve(size() + count);
+        encodeBatch(symbols.begin(), symbols.end(), encoded.begin());
+        std::vector<RamDomain> translation(count == 0 ? 0 : maxIndex + 1, -1);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            translation[indices[i]] = encoded[i];
+        }
+        return attached.emplace(fileName, std::move(translation)).first->second;
+    }
+
+    /**
+     * @brief Restore the symbols of the given file written by save(), keeping their indices, e.g. to
+     * resume an evaluation from a checkpoint.
+     *
+     * The table must hold a prefix of the symbols of the file, such as the constants of the program
+     * which wrote the file.
+     */
+    void restore(const std::string& fileName) {
+        std::vector<std::uint64_t> indices;
+        std::vector<std::string> symbols;
+        read(fileName, indices, symbols);
+        std::vector<const std::string*> byIndex(symbols.size(), nullptr);
+        reserve(symbols.size());
+        for (std::size_t i = 0; i < symbols.size(); ++i) {
+            if (indices[i] >= symbols.size()) {
+                throw std::invalid_argument("Sparse symbol file " + fileName);
+            }
+            byIndex[indices[i]] = &symbols[i];
+        }
+        for (std::size_t i = 0; i < byIndex.size(); ++i) {
+            if (byIndex[i] == nullptr || encode(*byIndex[i]) != static_cast<RamDomain>(i)) {
+                throw std::invalid_argument("Symbol file " + fileName + " does not extend the symbol table");
+            }
+        }
+    }
+
+private:
+    static constexpr char SYMBOL_FILE_MAGIC[8] = {'S', 'O', 'U', 'F', 'F', 'L', 'E', 'S'};
+
+    /** Number of bytes of a symbol held by its sort key */
+    static constexpr std::size_t SORT_KEY_BYTES = 7;
+
+    /** Capacity of the first block of sort keys, the following blocks double in size */
+    static constexpr std::size_t SORT_KEY_FIRST_BLOCK_BITS = 10;
+
+    /**
+     * The sort key of a symbol: its first bytes, padded by zeros, followed by a byte holding the
+     * number of bytes plus one, such that no key is zero. The keys of two symbols are ordered like
+     * the symbols, unless they are equal, which leaves the order to the remaining bytes.
+     */
+    static std::uint64_t makeSortKey(const std::string& symbol) {
+        const std::size_t length = std::min(symbol.size(), SORT_KEY_BYTES);
+        std::uint64_t key = 0;
+        for (std::size_t i = 0; i < SORT_KEY_BYTES; ++i) {
+            key = (key << 8) | (i < length ? static_cast<unsigned char>(symbol[i]) : 0);
+        }
+        return (key << 8) | (length + 1);
+    }
+
+    /** Return the sort key of the symbol of an index, computed by its first comparison */
+    std::uint64_t sortKey(const RamDomain index) const {
+        const std::uint64_t pos = static_cast<std::uint64_t>(index) + (1ULL << SORT_KEY_FIRST_BLOCK_BITS);
+        const std::size_t block = 63 - __builtin_clzll(pos) - SORT_KEY_FIRST_BLOCK_BITS;
+        // a block starts at the position of its size
+        const std::uint64_t blockSize = std::uint64_t(1) << (block + SORT_KEY_FIRST_BLOCK_BITS);
+        std::atomic<std::uint64_t>* keys = sortKeys[block].load(std::memory_order_acquire);
+        if (keys == nullptr) {
+            // the keys are zero, i.e., not computed yet, until their first comparison
+            auto* fresh = new std::atomic<std::uint64_t>[blockSize]();
+            if (sortKeys[block].compare_exchange_strong(
+                        keys, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                keys = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+        auto& slot = keys[pos - blockSize];
+        std::uint64_t key = slot.load(std::memory_order_relaxed);
+        if (key == 0) {
+            // threads computing the key of the same symbol concurrently store the same key
+            key = makeSortKey(decode(index));
+            slot.store(key, std::memory_order_relaxed);
+        }
+        return key;
+    }
+
+    /** Read the indices and symbols of the given file written by save() */
+    static void read(const std::string& fileName, std::vector<std::uint64_t>& indices,
+            std::vector<std::string>& symbols) {
+        std::ifstream in(fileName, std::ios::in | std::ios::binary);
+        if (!in.is_open()) {
+            throw std::invalid_argument("Cannot open symbol file " + fileName);
+        }
+        char magic[sizeof(SYMBOL_FILE_MAGIC)];
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, SYMBOL_FILE_MAGIC, sizeof(magic)) != 0) {
+            throw std::invalid_argument("Invalid symbol file " + fileName);
+        }
+        const std::uint64_t count = readUInt64(in, fileName);
+        indices.resize(count);
+        symbols.resize(count);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            indices[i] = readUInt64(in, fileName);
+            symbols[i].resize(readUInt64(in, fileName));
+            if (!in.read(&symbols[i][0], static_cast<std::streamsize>(symbols[i].size()))) {
+                throw std::invalid_argument("Truncated symbol file " + fileName);
+            }
+        }
+    }
+
+    static void writeUInt64(std::ostream& out, std::uint64_t value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static std::uint64_t readUInt64(std::istream& in, const std::string& fileName) {
+        std::uint64_t value = 0;
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+            throw std::invalid_argument("Truncated symbol file " + fileName);
+        }
+        return value;
+    }
+
+    /** Guards the bookkeeping of saved and attached symbol files */
+    mutable std::mutex filesLock;
+
+    /** Number of symbols at the last save() to each file */
+    mutable std::map<std::string, std::size_t> savedSizes;
+
+    /** Index translations of the attached symbol files */
+    std::map<std::string, std::vector<RamDomain>> attached;
+
+    /** The blocks of the sort keys of the symbols by index, allocated by the first comparison of a symbol */
+    mutable std::array<std::atomic<std::atomic<std::uint64_t>*>, 64 - SORT_KEY_FIRST_BLOCK_BITS> sortKeys{};
 };
 
 }  // namespace souffle
@@ -18,20 +18,26 @@
 #pragma once
 
 #include "souffle/datastructure/BTreeUtil.h"
+#include "souffle/datastructure/NodePool.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <mutex>
+#include <new>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <typeinfo>
+#include <utility>
 #include <vector>
 
 namespace souffle {
@@ -163,6 +169,10 @@ protected:
 
     struct inner_node;
 
+    struct leaf_node;
+
+    struct node_reserve;
+
     /**
      * The actual, generic node implementation covering the operations
      * for both, inner and leaf nodes.
@@ -175,9 +185,12 @@ protected:
                 ((blockSize > sizeof(base)) ? blockSize - sizeof(base) : 0) / sizeof(Key);
 
         /**
-         * The actual number of keys/node corrected by functional requirements.
+         * The actual number of keys/node corrected by functional requirements,
+         * i.e., at least 3 and few enough for the positions of children to fit
+         * into a field index.
          */
-        static constexpr std::size_t maxKeys = (desiredNumKeys > 3) ? desiredNumKeys : 3;
+        static constexpr std::size_t maxKeys = std::min<std::size_t>(
+                std::max<std::size_t>(desiredNumKeys, 3), std::numeric_limits<field_index_type>::max() - 1);
 
         // the keys stored in this node
         Key keys[maxKeys];
@@ -276,6 +289,30 @@ protected:
             return sum;
         }
 
+        /**
+         * Re-computes the cached number of entries of all inner nodes of the
+         * sub-tree rooted by this node and returns the number of its entries.
+         */
+        size_type updateSubtreeEntries() {
+            if (this->isLeaf()) {
+                return this->numElements;
+            }
+            size_type sum = this->numElements;
+            for (unsigned i = 0; i <= this->numElements; ++i) {
+                sum += getChild(i)->updateSubtreeEntries();
+            }
+            asInnerNode().numSubtreeEntries = sum;
+            return sum;
+        }
+
+        /**
+         * Obtains the number of entries of the sub-tree rooted by this node
+         * as recorded by the last updateSubtreeEntries().
+         */
+        size_type getSubtreeEntries() const {
+            return (this->isLeaf()) ? this->numElements : asInnerNode().numSubtreeEntries;
+        }
+
         /**
          * Determines the amount of memory used by the sub-tree rooted
          * by this node.
@@ -344,17 +381,19 @@ protected:
          *
          * @param root .. a pointer to the root-pointer of the enclosing b-tree
          *                 (might have to be updated if the root-node needs to be split)
+         * @param reserve .. the retained nodes of the enclosing b-tree to create new nodes from
          * @param idx  .. the position of the insert causing the split
          */
 #ifdef IS_PARALLEL
-        void split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        void split(node** root, lock_type& root_lock, node_reserve& reserve, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void split(node** root, lock_type& root_lock, int idx) {
+        void split(node** root, lock_type& root_lock, node_reserve& reserve, int idx) {
 #endif
             assert(this->numElements == maxKeys);
 
@@ -362,8 +401,7 @@ protected:
             int split_point = getSplitPoint(idx);
 
             // create a new sibling node
-            node* sibling = (this->inner) ? static_cast<node*>(new inner_node())
-                                          : static_cast<node*>(new leaf_node());
+            node* sibling = reserve.make(this->inner);
 
 #ifdef IS_PARALLEL
             // lock sibling
@@ -393,9 +431,9 @@ protected:
 
             // update parent
 #ifdef IS_PARALLEL
-            grow_parent(root, root_lock, sibling, locked_nodes);
+            grow_parent(root, root_lock, reserve, sibling, locked_nodes);
 #else
-            grow_parent(root, root_lock, sibling);
+            grow_parent(root, root_lock, reserve, sibling);
 #endif
         }
 
@@ -408,18 +446,20 @@ protected:
          * of a split. The number of moved elements will be <= the given idx.
          *
          * @param root .. the root node of the b-tree being part of
+         * @param reserve .. the retained nodes of the enclosing b-tree
          * @param idx  .. the position of the insert triggering this operation
          */
         // TODO: remove root_lock ... no longer needed
 #ifdef IS_PARALLEL
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx, std::vector<node*>& locked_nodes) {
+        int rebalance_or_split(node** root, lock_type& root_lock, node_reserve& reserve, int idx,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        int rebalance_or_split(node** root, lock_type& root_lock, int idx) {
+        int rebalance_or_split(node** root, lock_type& root_lock, node_reserve& reserve, int idx) {
 #endif
 
             // this node is full ... and needs some space
@@ -437,7 +477,7 @@ protected:
                 // lock access to left sibling
                 if (!left->lock.try_start_write()) {
                     // left node is currently updated => skip balancing and split
-                    split(root, root_lock, idx, locked_nodes);
+                    split(root, root_lock, reserve, idx, locked_nodes);
                     return 0;
                 }
 #endif
@@ -510,9 +550,9 @@ protected:
 
             // Option B) split node
 #ifdef IS_PARALLEL
-            split(root, root_lock, idx, locked_nodes);
+            split(root, root_lock, reserve, idx, locked_nodes);
 #else
-            split(root, root_lock, idx);
+            split(root, root_lock, reserve, idx);
 #endif
             return 0;  // = no re-balancing
         }
@@ -524,24 +564,26 @@ protected:
          * use only)
          *
          * @param root .. a pointer to the root-pointer of the containing tree
+         * @param reserve .. the retained nodes of the containing tree
          * @param sibling .. the new right-sibling to be add to the parent node
          */
 #ifdef IS_PARALLEL
-        void grow_parent(node** root, lock_type& root_lock, node* sibling, std::vector<node*>& locked_nodes) {
+        void grow_parent(node** root, lock_type& root_lock, node_reserve& reserve, node* sibling,
+                std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(!this->parent || this->parent->lock.is_write_locked());
             assert((this->parent != nullptr) || root_lock.is_write_locked());
             assert(this->isLeaf() || souffle::contains(locked_nodes, this));
             assert(!this->parent || souffle::contains(locked_nodes, const_cast<node*>(this->parent)));
 #else
-        void grow_parent(node** root, lock_type& root_lock, node* sibling) {
+        void grow_parent(node** root, lock_type& root_lock, node_reserve& reserve, node* sibling) {
 #endif
 
             if (this->parent == nullptr) {
                 assert(*root == this);
 
                 // create a new root node
-                auto* new_root = new inner_node();
+                auto* new_root = reserve.make_inner();
                 new_root->numElements = 1;
                 new_root->keys[0] = keys[this->numElements];
 
@@ -563,9 +605,9 @@ protected:
 
 #ifdef IS_PARALLEL
                 parent->insert_inner(
-                        root, root_lock, pos, this, keys[this->numElements], sibling, locked_nodes);
+                        root, root_lock, reserve, pos, this, keys[this->numElements], sibling, locked_nodes);
 #else
-                parent->insert_inner(root, root_lock, pos, this, keys[this->numElements], sibling);
+                parent->insert_inner(root, root_lock, reserve, pos, this, keys[this->numElements], sibling);
 #endif
             }
         }
@@ -574,18 +616,19 @@ protected:
          * Inserts a new element into an inner node (for internal use only).
          *
          * @param root .. a pointer to the root-pointer of the containing tree
+         * @param reserve .. the retained nodes of the containing tree
          * @param pos  .. the position to insert the new key
          * @param key  .. the key to insert
          * @param newNode .. the new right-child of the inserted key
          */
 #ifdef IS_PARALLEL
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode, std::vector<node*>& locked_nodes) {
+        void insert_inner(node** root, lock_type& root_lock, node_reserve& reserve, unsigned pos,
+                node* predecessor, const Key& key, node* newNode, std::vector<node*>& locked_nodes) {
             assert(this->lock.is_write_locked());
             assert(souffle::contains(locked_nodes, this));
 #else
-        void insert_inner(node** root, lock_type& root_lock, unsigned pos, node* predecessor, const Key& key,
-                node* newNode) {
+        void insert_inner(node** root, lock_type& root_lock, node_reserve& reserve, unsigned pos,
+                node* predecessor, const Key& key, node* newNode) {
 #endif
 
             // check capacity
@@ -598,9 +641,9 @@ protected:
 
                 // split this node
 #ifdef IS_PARALLEL
-                pos -= rebalance_or_split(root, root_lock, pos, locked_nodes);
+                pos -= rebalance_or_split(root, root_lock, reserve, pos, locked_nodes);
 #else
-                pos -= rebalance_or_split(root, root_lock, pos);
+                pos -= rebalance_or_split(root, root_lock, reserve, pos);
 #endif
 
                 // complete insertion within new sibling if necessary
@@ -625,9 +668,10 @@ protected:
                     }
 
                     pos = (i > other->numElements) ? 0 : i;
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode, locked_nodes);
+                    other->insert_inner(
+                            root, root_lock, reserve, pos, predecessor, key, newNode, locked_nodes);
 #else
-                    other->insert_inner(root, root_lock, pos, predecessor, key, newNode);
+                    other->insert_inner(root, root_lock, reserve, pos, predecessor, key, newNode);
 #endif
                     return;
                 }
@@ -869,9 +913,22 @@ protected:
         // references to child nodes owned by this node
         node* children[node::maxKeys + 1];
 
+        // the number of entries in the sub-tree rooted by this node, see updateSubtreeEntries()
+        size_type numSubtreeEntries = 0;
+
         // a simple default constructor initializing member fields
         inner_node() : node(true) {}
 
+        // nodes are allocated from a pool shared by all trees with nodes of the same size
+        static void* operator new(std::size_t size) {
+            assert(size == sizeof(inner_node));
+            return NodePool<sizeof(inner_node), alignof(inner_node)>::allocate();
+        }
+
+        static void operator delete(void* ptr) {
+            NodePool<sizeof(inner_node), alignof(inner_node)>::deallocate(ptr);
+        }
+
         // clear up child nodes recursively
         ~inner_node() {
             for (unsigned i = 0; i <= this->numElements; ++i) {
@@ -893,6 +950,116 @@ protected:
     struct leaf_node : public node {
         // a simple default constructor initializing member fields
         leaf_node() : node(false) {}
+
+        // nodes are allocated from a pool shared by all trees with nodes of the same size
+        static void* operator new(std::size_t size) {
+            assert(size == sizeof(leaf_node));
+            return NodePool<sizeof(leaf_node), alignof(leaf_node)>::allocate();
+        }
+
+        static void operator delete(void* ptr) {
+            NodePool<sizeof(leaf_node), alignof(leaf_node)>::deallocate(ptr);
+        }
+    };
+
+    /**
+     * The memory of the nodes of a recycled tree, retained for the nodes
+     * created by subsequent insertions. Trees cleared and refilled over and
+     * over, e.g. in every iteration of a fixpoint computation, thereby keep
+     * their nodes instead of returning them to the allocator and obtaining
+     * them again.
+     */
+    struct node_reserve {
+        // a retained block of node memory
+        struct block {
+            block* next;
+        };
+
+        // the retained memory of inner and leaf nodes
+        std::atomic<block*> inner{nullptr};
+        std::atomic<block*> leaves{nullptr};
+
+        // synchronizes the creation of nodes by concurrent insertions
+        SpinLock lock;
+
+        node_reserve() = default;
+        node_reserve(const node_reserve&) = delete;
+        node_reserve& operator=(const node_reserve&) = delete;
+
+        ~node_reserve() {
+            release();
+        }
+
+        node* make(bool isInner) {
+            return isInner ? static_cast<node*>(make_inner()) : static_cast<node*>(make_leaf());
+        }
+
+        inner_node* make_inner() {
+            void* mem = take(inner);
+            return (mem != nullptr) ? ::new (mem) inner_node() : new inner_node();
+        }
+
+        leaf_node* make_leaf() {
+            void* mem = take(leaves);
+            return (mem != nullptr) ? ::new (mem) leaf_node() : new leaf_node();
+        }
+
+        /**
+         * Destroys the nodes of the given sub-tree and retains their memory. Must
+         * not run concurrently with the creation of nodes.
+         */
+        void retain(node* cur) {
+            if (cur->isLeaf()) {
+                auto* leaf = static_cast<leaf_node*>(cur);
+                leaf->~leaf_node();
+                put(leaves, leaf);
+                return;
+            }
+            auto* in = static_cast<inner_node*>(cur);
+            for (unsigned i = 0; i <= in->numElements; ++i) {
+                retain(in->children[i]);
+            }
+            // the children are gone already
+            std::fill(std::begin(in->children), std::end(in->children), nullptr);
+            in->~inner_node();
+            put(inner, in);
+        }
+
+        /**
+         * Returns all retained memory to the allocator.
+         */
+        void release() {
+            for (block* cur = inner.exchange(nullptr); cur != nullptr;) {
+                block* next = cur->next;
+                inner_node::operator delete(cur);
+                cur = next;
+            }
+            for (block* cur = leaves.exchange(nullptr); cur != nullptr;) {
+                block* next = cur->next;
+                leaf_node::operator delete(cur);
+                cur = next;
+            }
+        }
+
+    private:
+        void* take(std::atomic<block*>& list) {
+            if (list.load(std::memory_order_relaxed) == nullptr) {
+                return nullptr;
+            }
+            lock.lock();
+            block* res = list.load(std::memory_order_relaxed);
+            if (res != nullptr) {
+                list.store(res->next, std::memory_order_relaxed);
+            }
+            lock.unlock();
+            return res;
+        }
+
+        static void put(std::atomic<block*>& list, void* mem) {
+            auto* cur = static_cast<block*>(mem);
+            cur->next = list.load(std::memory_order_relaxed);
+            list.store(cur, std::memory_order_relaxed);
+        }
     };
 
     // ------------------- iterators ------------------------
@@ -980,6 +1147,21 @@ public:
             return *this;
         }
 
+        // the number of elements from this one on stored consecutively in the current node, up to an end
+        size_type getSpanLength(const iterator& end) const {
+            if (cur->isInner()) {
+                return 1;
+            }
+            return (end.cur == cur) ? end.pos - pos : cur->getNumElements() - pos;
+        }
+
+        // moves this iterator forward by the given number of elements of the current node
+        iterator& skip(size_type n) {
+            assert(n > 0);
+            pos += static_cast<field_index_type>(n - 1);
+            return ++(*this);
+        }
+
         // prints a textual representation of this iterator to the given stream (mainly for debugging)
         void print(std::ostream& out = std::cout) const {
             out << cur << "[" << (int)pos << "]";
@@ -1038,6 +1220,15 @@ protected:
     // a pointer to the left-most node of this tree (initial note for iteration)
     leaf_node* leftmost;
 
+    // the memory of recycled nodes, taken for new nodes before allocating any
+    node_reserve reserve;
+
+    // whether the sub-tree entry counts of the inner nodes are up to date
+    mutable std::atomic<bool> countsValid{false};
+
+    // a lock serializing the re-computation of the sub-tree entry counts
+    mutable SpinLock countsLock;
+
     /* -------------- operator hint statistics ----------------- */
 
     // an aggregation of statistical values of the hint utilization
@@ -1062,6 +1253,9 @@ public:
     // the maximum number of keys stored per node
     static constexpr std::size_t max_keys_per_node = node::maxKeys;
 
+    // the number of ancestors of the node of the last search a search may start at instead of the root
+    static constexpr unsigned finger_levels = 2;
+
     // -- ctors / dtors --
 
     // the default constructor creating an empty tree
@@ -1107,9 +1301,28 @@ public:
         return root == nullptr;
     }
 
-    // determines the number of elements in this tree
+    // determines the number of elements in this tree, without a traversal if the tree is frozen
     size_type size() const {
-        return (root) ? root->countEntries() : 0;
+        if (root == nullptr) {
+            return 0;
+        }
+        if (countsValid.load(std::memory_order_acquire)) {
+            return root->getSubtreeEntries();
+        }
+        return root->countEntries();
+    }
+
+    /**
+     * Freezes this tree once it is not going to be modified for a while, e.g., by the remaining
+     * strata of a program. Searches of a tree take no locks anyway; a frozen tree in addition
+     * answers size() and countRange() from the entry counts of its sub-trees instead of by a
+     * traversal. The next modification thaws the tree. Must not be called concurrently with
+     * modifications.
+     */
+    void freeze() const {
+        if (!empty()) {
+            updateCounts();
+        }
     }
 
     /**
@@ -1124,6 +1337,7 @@ public:
      * Inserts the given key into this tree.
      */
     bool insert(const Key& k, operation_hints& hints) {
+        invalidateCounts();
 #ifdef IS_PARALLEL
 
         // special handling for inserting first element
@@ -1142,7 +1356,7 @@ public:
             }
 
             // create new node
-            leftmost = new leaf_node();
+            leftmost = reserve.make_leaf();
             leftmost->numElements = 1;
             leftmost->keys[0] = k;
             root = leftmost;
@@ -1340,7 +1554,7 @@ public:
 
                 // split this node
                 auto old_root = root;
-                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, idx, parents);
+                idx -= cur->rebalance_or_split(const_cast<node**>(&root), root_lock, reserve, idx, parents);
 
                 // release parent lock
                 for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
@@ -1392,7 +1606,7 @@ public:
         // special handling for inserting first element
         if (empty()) {
             // create new node
-            leftmost = new leaf_node();
+            leftmost = reserve.make_leaf();
             leftmost->numElements = 1;
             leftmost->keys[0] = k;
             root = leftmost;
@@ -1467,7 +1681,7 @@ public:
 
             if (cur->numElements >= node::maxKeys) {
                 // split this node
-                idx -= cur->rebalance_or_split(&root, root_lock, static_cast<int>(idx));
+                idx -= cur->rebalance_or_split(&root, root_lock, reserve, static_cast<int>(idx));
 
                 // insert element in right fragment
                 if (((size_type)idx) > cur->numElements) {
@@ -1520,6 +1734,32 @@ public:
         return iterator();
     }
 
+    /**
+     * Applies the given operation to the elements of the range [a,b) in order, handing it the
+     * spans of elements stored consecutively as pairs of pointers (first, last). The spans are the
+     * runs of elements of the leaves, and the single elements of the inner nodes in between, such
+     * that loops over the spans are free of the node traversal of the iterators and may be
+     * vectorised by the compiler.
+     */
+    template <typename Op>
+    void forEachSpan(iterator a, const iterator& b, Op&& op) const {
+        while (a != b) {
+            const auto n = a.getSpanLength(b);
+            const Key* first = &*a;
+            op(first, first + n);
+            a.skip(n);
+        }
+    }
+
+    /**
+     * Applies the given operation to the spans of elements stored consecutively, covering all
+     * elements of this tree in order.
+     */
+    template <typename Op>
+    void forEachSpan(Op&& op) const {
+        forEachSpan(begin(), end(), std::forward<Op>(op));
+    }
+
     /**
      * Partitions the full range of this set into up to a given number of chunks.
      * The chunks will cover approximately the same number of elements. Also, the
@@ -1576,9 +1816,9 @@ public:
         node* cur = root;
 
         auto checkHints = [&](node* last_find_end) {
-            if (!last_find_end) return false;
-            if (!covers(last_find_end, k)) return false;
-            cur = last_find_end;
+            node* start = finger(last_find_end, [&](const node* n) { return covers(n, k); });
+            if (!start) return false;
+            cur = start;
             return true;
         };
 
@@ -1637,9 +1877,9 @@ public:
         node* cur = root;
 
         auto checkHints = [&](node* last_lower_bound_end) {
-            if (!last_lower_bound_end) return false;
-            if (!covers(last_lower_bound_end, k)) return false;
-            cur = last_lower_bound_end;
+            node* start = finger(last_lower_bound_end, [&](const node* n) { return covers(n, k); });
+            if (!start) return false;
+            cur = start;
             return true;
         };
 
@@ -1675,6 +1915,28 @@ public:
         }
     }
 
+    /**
+     * Requests the leaf node a lower_bound(k) would end in to be loaded into the cache,
+     * without waiting for it. Issued for the keys of upcoming probes, the inner nodes are
+     * traversed early and the load of the leaf overlaps with the work on the current probe.
+     */
+    void prefetch(const Key& k) const {
+        node* cur = root;
+        if (cur == nullptr) {
+            return;
+        }
+        while (cur->inner) {
+            auto a = &(cur->keys[0]);
+            auto b = &(cur->keys[cur->numElements]);
+            cur = cur->getChild(search.lower_bound(k, a, b, comp) - a);
+        }
+        const char* addr = reinterpret_cast<const char*>(cur);
+        constexpr std::size_t line = hardware_constructive_interference_size;
+        for (std::size_t offset = 0; offset < sizeof(leaf_node); offset += line) {
+            SOUFFLE_PREFETCH(addr + offset);
+        }
+    }
+
     /**
      * Obtains an upper boundary for the given key -- hence an iterator referencing
      * the first element that the given key is less than the referenced value. If
@@ -1698,9 +1960,10 @@ public:
         node* cur = root;
 
         auto checkHints = [&](node* last_upper_bound_end) {
-            if (!last_upper_bound_end) return false;
-            if (!coversUpperBound(last_upper_bound_end, k)) return false;
-            cur = last_upper_bound_end;
+            node* start =
+                    finger(last_upper_bound_end, [&](const node* n) { return coversUpperBound(n, k); });
+            if (!start) return false;
+            cur = start;
             return true;
         };
 
@@ -1732,6 +1995,23 @@ public:
         }
     }
 
+    /**
+     * Determines the number of elements in the range [lower, upper], i.e. the
+     * distance between lower_bound(lower) and upper_bound(upper), in time
+     * logarithmic in the size of the tree. The entry counts of the sub-trees
+     * are computed on the first call after a modification of the tree, so the
+     * tree must not be modified concurrently.
+     */
+    size_type countRange(const Key& lower, const Key& upper) const {
+        if (empty()) {
+            return 0;
+        }
+        updateCounts();
+        size_type end = rank(upper, true);
+        size_type begin = rank(lower, false);
+        return (end > begin) ? end - begin : 0;
+    }
+
     /**
      * Clears this tree.
      */
@@ -1745,6 +2025,51 @@ public:
         }
         root = nullptr;
         leftmost = nullptr;
+        reserve.release();
+        invalidateCounts();
+    }
+
+    /**
+     * Clears this tree, retaining the memory of its nodes for the elements
+     * inserted subsequently. The memory is released by clear() or when the
+     * tree is destroyed.
+     */
+    void recycle() {
+        if (root != nullptr) {
+            reserve.retain(root);
+        }
+        root = nullptr;
+        leftmost = nullptr;
+        invalidateCounts();
+    }
+
+    /**
+     * Rebuilds this tree such that its nodes are filled to capacity.
+     *
+     * Trees populated by individual insertions leave about a quarter of their
+     * node capacity unused. Compacting a tree that is not going to be modified
+     * any more reduces its memory footprint accordingly. The content is
+     * buffered in a sorted array while the tree is rebuilt. Iterators and
+     * operation hints referring to this tree are invalidated.
+     */
+    void compact() {
+        if (empty()) {
+            return;
+        }
+        std::vector<Key> keys(begin(), end());
+        clear();
+
+        // determine the lowest height of a tree holding all keys
+        std::size_t height = 1;
+        while (getCapacity(height) < keys.size()) {
+            height++;
+        }
+        root = buildDenseSubTree(keys.begin(), keys.size(), height);
+        node* first = root;
+        while (!first->isLeaf()) {
+            first = first->getChild(0);
+        }
+        leftmost = static_cast<leaf_node*>(first);
     }
 
     /**
@@ -1756,6 +2081,8 @@ public:
         // swap the content
         std::swap(root, other.root);
         std::swap(leftmost, other.leftmost);
+        invalidateCounts();
+        other.invalidateCounts();
     }
 
     // Implementation of the assignment operation for trees.
@@ -1765,6 +2092,8 @@ public:
             return *this;
         }
 
+        invalidateCounts();
+
         // create a deep-copy of the content of the other tree
         // shortcut for empty sets
         if (other.empty()) {
@@ -1831,6 +2160,11 @@ public:
         return sizeof(*this) + (empty() ? 0 : root->getMemoryUsage());
     }
 
+    // Determines the average fraction of the keys of the nodes of this tree in use
+    double getFillFactor() const {
+        return empty() ? 0.0 : (size() / (double)getNumNodes()) / node::maxKeys;
+    }
+
     /*
      * Prints a textual representation of this tree to the given
      * output stream (mostly for debugging and tuning).
@@ -1884,6 +2218,52 @@ public:
         return ok;
     }
 
+protected:
+    // marks the sub-tree entry counts as outdated, avoiding writes to a shared cache line if possible
+    void invalidateCounts() {
+        if (countsValid.load(std::memory_order_relaxed)) {
+            countsValid.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // re-computes the sub-tree entry counts if the tree has been modified since their last update
+    void updateCounts() const {
+        if (countsValid.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<SpinLock> guard(countsLock);
+        if (!countsValid.load(std::memory_order_relaxed)) {
+            root->updateSubtreeEntries();
+            countsValid.store(true, std::memory_order_release);
+        }
+    }
+
+    /**
+     * Determines the number of elements less than (or, if inclusive, not
+     * greater than) the given key based on the sub-tree entry counts.
+     */
+    size_type rank(const Key& k, bool inclusive) const {
+        size_type res = 0;
+        node* cur = root;
+        while (true) {
+            auto a = &(cur->keys[0]);
+            auto b = &(cur->keys[cur->numElements]);
+            auto pos = (inclusive) ? search.upper_bound(k, a, b, comp) : search.lower_bound(k, a, b, comp);
+            auto idx = static_cast<size_type>(pos - a);
+
+            if (!cur->inner) {
+                return res + idx;
+            }
+
+            // all entries of the sub-trees left of the position and their separating keys
+            for (size_type i = 0; i < idx; ++i) {
+                res += cur->getChild(i)->getSubtreeEntries() + 1;
+            }
+            cur = cur->getChild(idx);
+        }
+    }
+
+public:
     /**
      * A static member enabling the bulk-load of ordered data into an empty
      * tree. This function is much more efficient in creating a index over
@@ -1945,6 +2325,24 @@ protected:
     }
 
 private:
+    /**
+     * Obtains the node a search may start at instead of the root, given the node the last search
+     * ended in: that node or the closest of its ancestors covering the searched key. Consecutive
+     * searches for nearby keys, e.g., probes in the order of the index, thereby gallop from the last
+     * leaf to its neighbours in time logarithmic in their distance rather than in the size of the
+     * tree. Returns nullptr if none of the first few ancestors covers the key.
+     */
+    template <typename Covers>
+    static node* finger(node* last, const Covers& covers) {
+        for (unsigned level = 0; last != nullptr && level <= finger_levels; ++level) {
+            if (covers(last)) {
+                return last;
+            }
+            last = last->parent;
+        }
+        return nullptr;
+    }
+
     /**
      * Determines whether the range covered by this node covers
      * the upper bound of the given key.
@@ -1954,6 +2352,67 @@ private:
         return !node->isEmpty() && !less(k, node->keys[0]) && less(k, node->keys[node->numElements - 1]);
     }
 
+    // The number of keys a full tree of the given height is holding, for the compact operation.
+    static std::size_t getCapacity(std::size_t height) {
+        std::size_t res = node::maxKeys;
+        for (std::size_t i = 1; i < height; i++) {
+            res = res * (node::maxKeys + 1) + node::maxKeys;
+        }
+        return res;
+    }
+
+    /**
+     * Utility function for the compact operation above, building a tree of the given
+     * height from the given number of keys. All sub-trees but the two right-most ones
+     * of each node are full, thus only nodes along the right spine are partially filled.
+     */
+    template <typename Iter>
+    static node* buildDenseSubTree(const Iter& a, std::size_t length, std::size_t height) {
+        // terminal case: the keys fit into a leaf
+        if (height == 1) {
+            node* res = new leaf_node();
+            res->numElements = length;
+            for (std::size_t i = 0; i < length; ++i) {
+                res->keys[i] = a[i];
+            }
+            return res;
+        }
+
+        // use as few keys in this node as possible, the sub-trees exceed the capacity of a lower tree
+        const std::size_t capacity = getCapacity(height - 1);
+        const std::size_t numKeys = (length <= capacity) ? 1 : (length - capacity - 1) / (capacity + 1) + 1;
+
+        // all but the last two sub-trees are full, the last two share the remaining keys
+        const std::size_t remaining = length - numKeys - (numKeys - 1) * capacity;
+
+        node* res = new inner_node();
+        res->numElements = numKeys;
+
+        Iter c = a;
+        for (std::size_t i = 0; i <= numKeys; i++) {
+            std::size_t size = capacity;
+            if (i + 1 == numKeys) {
+                size = remaining - remaining / 2;
+            } else if (i == numKeys) {
+                size = remaining / 2;
+            }
+
+            auto child = buildDenseSubTree(c, size, height - 1);
+            child->parent = res;
+            child->position = i;
+            res->getChildren()[i] = child;
+            c = c + size;
+
+            // get dividing key
+            if (i < numKeys) {
+                res->keys[i] = *c;
+                c = c + 1;
+            }
+        }
+
+        return res;
+    }
+
     // Utility function for the load operation above.
     template <typename Iter>
     static node* buildSubTree(const Iter& a, const Iter& b) {
@@ -2032,7 +2491,7 @@ const SearchStrategy
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
         typename Allocator = std::allocator<Key>,  // is ignored so far
-        unsigned blockSize = 256,
+        unsigned blockSize = detail::default_block_size<Key>::value,
         typename SearchStrategy = typename souffle::detail::default_strategy<Key>::type,
         typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>>
 class btree_set : public souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy, true,
@@ -2094,7 +2553,7 @@ public:
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
         typename Allocator = std::allocator<Key>,  // is ignored so far
-        unsigned blockSize = 256,
+        unsigned blockSize = detail::default_block_size<Key>::value,
         typename SearchStrategy = typename souffle::detail::default_strategy<Key>::type,
         typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>>
 class btree_multiset : public souffle::detail::btree<Key, Comparator, Allocator, blockSize, SearchStrategy,
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "souffle/datastructure/BTreeUtil.h"
+#include "souffle/datastructure/NodePool.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
@@ -29,6 +30,7 @@
 #include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -176,9 +178,12 @@ protected:
                 ((blockSize > sizeof(base)) ? blockSize - sizeof(base) : 0) / sizeof(Key);
 
         /**
-         * The actual number of keys/node corrected by functional requirements.
+         * The actual number of keys/node corrected by functional requirements,
+         * i.e., at least 3 and few enough for the positions of children to fit
+         * into a field index.
          */
-        static constexpr std::size_t maxKeys = (desiredNumKeys > 3) ? desiredNumKeys : 3;
+        static constexpr std::size_t maxKeys = std::min<std::size_t>(
+                std::max<std::size_t>(desiredNumKeys, 3), std::numeric_limits<field_index_type>::max() - 1);
         static constexpr std::size_t split_point = std::min(3 * maxKeys / 4, maxKeys - 2);
         static constexpr std::size_t minKeys = std::min(maxKeys - (split_point + 1), split_point + 1);
 
@@ -875,6 +880,16 @@ protected:
         // a simple default constructor initializing member fields
         inner_node() : node(true) {}
 
+        // nodes are allocated from a pool shared by all trees with nodes of the same size
+        static void* operator new(std::size_t size) {
+            assert(size == sizeof(inner_node));
+            return NodePool<sizeof(inner_node), alignof(inner_node)>::allocate();
+        }
+
+        static void operator delete(void* ptr) {
+            NodePool<sizeof(inner_node), alignof(inner_node)>::deallocate(ptr);
+        }
+
         // clear up child nodes recursively
         ~inner_node() {
             for (unsigned i = 0; i <= this->numElements; ++i) {
@@ -896,6 +911,16 @@ protected:
     struct leaf_node : public node {
         // a simple default constructor initializing member fields
         leaf_node() : node(false) {}
+
+        // nodes are allocated from a pool shared by all trees with nodes of the same size
+        static void* operator new(std::size_t size) {
+            assert(size == sizeof(leaf_node));
+            return NodePool<sizeof(leaf_node), alignof(leaf_node)>::allocate();
+        }
+
+        static void operator delete(void* ptr) {
+            NodePool<sizeof(leaf_node), alignof(leaf_node)>::deallocate(ptr);
+        }
     };
 
     // ------------------- iterators ------------------------
@@ -1087,6 +1112,9 @@ protected:
     // a pointer to the left-most node of this tree (initial note for iteration)
     leaf_node* leftmost;
 
+    // the number of keys erased by batches since the tree was last rebuilt
+    size_type batchErasures = 0;
+
     /* -------------- operator hint statistics ----------------- */
 
     // an aggregation of statistical values of the hint utilization
@@ -1111,6 +1139,12 @@ public:
     // the maximum number of keys stored per node
     static constexpr std::size_t max_keys_per_node = node::maxKeys;
 
+    // batches erasing at least this fraction of the keys rebuild the tree from the remaining keys
+    static constexpr double bulk_erase_ratio = 0.25;
+
+    // the nodes are compacted once batches leave them filled below this fraction of their capacity
+    static constexpr double min_fill_factor = 0.5;
+
     // -- ctors / dtors --
 
     // the default constructor creating an empty tree
@@ -1662,7 +1696,7 @@ public:
                         root = iter.cur->getChild(0);
                         root->parent = nullptr;
                     }
-                    delete iter.cur;
+                    deleteDetachedNode(iter.cur);
                 }
                 break;
             }
@@ -1696,6 +1730,85 @@ public:
         // iter.cur->lock.end_write(); //@julienhenry
     }
 
+    /**
+     * Erase all keys within the given inclusive bounds from the tree.
+     * Return the number of erased keys.
+     *
+     * Ranges covering a large part of the tree are not erased key by key,
+     * which would merge and rebalance the nodes along the range repeatedly;
+     * the tree is rebuilt from the remaining keys instead.
+     */
+    size_type eraseRange(const Key& lower, const Key& upper) {
+        if (empty() || less(upper, lower)) {
+            return 0;
+        }
+        iterator a = internal_lower_bound(lower);
+        const iterator b = internal_upper_bound(upper);
+        const size_type count = distance(a, b);
+        if (count == 0) {
+            return 0;
+        }
+
+        const size_type total = size();
+        if (count < bulk_erase_ratio * total) {
+            for (size_type i = 0; i < count; i++) {
+                erase(a);
+            }
+            batchErasures += count;
+            compactIfSparse(total - count);
+            return count;
+        }
+
+        std::vector<Key> keys;
+        keys.reserve(total - count);
+        keys.insert(keys.end(), begin(), a);
+        keys.insert(keys.end(), b, end());
+        rebuild(keys);
+        return count;
+    }
+
+    /**
+     * Erase the keys of the given range, sorted in the order of the tree,
+     * from the tree. In multi-sets, all keys equal to an erased key are
+     * erased. Return the number of erased keys.
+     *
+     * Small batches are erased key by key. Batches covering a large part of
+     * the tree are merged with the content of the tree in a single pass, and
+     * the tree is rebuilt from the remaining keys.
+     */
+    template <typename Iter>
+    size_type eraseAll(const Iter& a, const Iter& b) {
+        if (empty() || a == b) {
+            return 0;
+        }
+        const size_type count = std::distance(a, b);
+        const size_type total = size();
+        if (count < bulk_erase_ratio * total) {
+            size_type erased = 0;
+            for (auto it = a; it != b; ++it) {
+                erased += erase(*it);
+            }
+            batchErasures += erased;
+            compactIfSparse(total - erased);
+            return erased;
+        }
+
+        std::vector<Key> keys;
+        keys.reserve(total);
+        Iter cur = a;
+        for (const auto& key : *this) {
+            while (cur != b && less(*cur, key)) {
+                ++cur;
+            }
+            if (cur == b || less(key, *cur)) {
+                keys.push_back(key);
+            }
+        }
+        const size_type erased = total - keys.size();
+        rebuild(keys);
+        return erased;
+    }
+
 private:
     /**
      * Find the given key in a non-empty tree.
@@ -1910,7 +2023,20 @@ private:
         left->numElements += right->getNumElements() + 1;
 
         // Delete the right node
-        delete right;
+        deleteDetachedNode(right);
+    }
+
+    /**
+     * Deletes a node whose children, if any, have been moved to other nodes.
+     */
+    static void deleteDetachedNode(node* n) {
+        if (n->isLeaf()) {
+            delete static_cast<leaf_node*>(n);
+            return;
+        }
+        auto* inner = static_cast<inner_node*>(n);
+        std::fill(std::begin(inner->children), std::end(inner->children), nullptr);
+        delete inner;
     }
 
     /**
@@ -2223,6 +2349,28 @@ public:
         }
     }
 
+    /**
+     * Requests the leaf node a lower_bound(k) would end in to be loaded into the cache,
+     * without waiting for it. Issued for the keys of upcoming probes, the inner nodes are
+     * traversed early and the load of the leaf overlaps with the work on the current probe.
+     */
+    void prefetch(const Key& k) const {
+        node* cur = root;
+        if (cur == nullptr) {
+            return;
+        }
+        while (cur->inner) {
+            auto a = &(cur->keys[0]);
+            auto b = &(cur->keys[cur->numElements]);
+            cur = cur->getChild(search.lower_bound(k, a, b, comp) - a);
+        }
+        const char* addr = reinterpret_cast<const char*>(cur);
+        constexpr std::size_t line = hardware_constructive_interference_size;
+        for (std::size_t offset = 0; offset < sizeof(leaf_node); offset += line) {
+            SOUFFLE_PREFETCH(addr + offset);
+        }
+    }
+
     /**
      * Obtains an upper boundary for the given key -- hence an iterator referencing
      * the first element that the given key is less than the referenced value. If
@@ -2293,8 +2441,66 @@ public:
         }
         root = nullptr;
         leftmost = nullptr;
+        batchErasures = 0;
+    }
+
+    /**
+     * Rebuilds this tree such that its nodes are filled to capacity.
+     *
+     * Trees populated by individual insertions leave about a quarter of their
+     * node capacity unused. Compacting a tree that is not going to be modified
+     * any more reduces its memory footprint accordingly. The content is
+     * buffered in a sorted array while the tree is rebuilt. Iterators and
+     * operation hints referring to this tree are invalidated.
+     */
+    void compact() {
+        if (empty()) {
+            return;
+        }
+        std::vector<Key> keys(begin(), end());
+        rebuild(keys);
+    }
+
+private:
+    /**
+     * Replaces the content of this tree by a dense tree of the given keys,
+     * sorted in the order of the tree.
+     */
+    void rebuild(const std::vector<Key>& keys) {
+        clear();
+        if (keys.empty()) {
+            return;
+        }
+
+        // determine the lowest height of a tree holding all keys
+        std::size_t height = 1;
+        while (getCapacity(height) < keys.size()) {
+            height++;
+        }
+        root = buildDenseSubTree(keys.begin(), keys.size(), height);
+        node* first = root;
+        while (!first->isLeaf()) {
+            first = first->getChild(0);
+        }
+        leftmost = static_cast<leaf_node*>(first);
     }
 
+    /**
+     * Compacts this tree holding the given number of keys once the keys
+     * erased by batches, whose nodes are merged and rebalanced only down to
+     * a quarter of their capacity, leave the nodes sparsely filled.
+     */
+    void compactIfSparse(size_type remaining) {
+        if (batchErasures < bulk_erase_ratio * remaining || empty()) {
+            return;
+        }
+        batchErasures = 0;
+        if (remaining < min_fill_factor * getNumNodes() * node::maxKeys) {
+            compact();
+        }
+    }
+
+public:
     /**
      * Swaps the content of this tree with the given tree. This
      * is a much more efficient operation than creating a copy and
@@ -2304,6 +2510,7 @@ public:
         // swap the content
         std::swap(root, other.root);
         std::swap(leftmost, other.leftmost);
+        std::swap(batchErasures, other.batchErasures);
     }
 
     // Implementation of the assignment operation for trees.
@@ -2379,6 +2586,11 @@ public:
         return sizeof(*this) + (empty() ? 0 : root->getMemoryUsage());
     }
 
+    // Determines the average fraction of the keys of the nodes of this tree in use
+    double getFillFactor() const {
+        return empty() ? 0.0 : (size() / (double)getNumNodes()) / node::maxKeys;
+    }
+
     /*
      * Prints a textual representation of this tree to the given
      * output stream (mostly for debugging and tuning).
@@ -2502,6 +2714,67 @@ private:
         return !node->isEmpty() && !less(k, node->keys[0]) && less(k, node->keys[node->numElements - 1]);
     }
 
+    // The number of keys a full tree of the given height is holding, for the compact operation.
+    static std::size_t getCapacity(std::size_t height) {
+        std::size_t res = node::maxKeys;
+        for (std::size_t i = 1; i < height; i++) {
+            res = res * (node::maxKeys + 1) + node::maxKeys;
+        }
+        return res;
+    }
+
+    /**
+     * Utility function for the compact operation above, building a tree of the given
+     * height from the given number of keys. All sub-trees but the two right-most ones
+     * of each node are full, thus only nodes along the right spine are partially filled.
+     */
+    template <typename Iter>
+    static node* buildDenseSubTree(const Iter& a, std::size_t length, std::size_t height) {
+        // terminal case: the keys fit into a leaf
+        if (height == 1) {
+            node* res = new leaf_node();
+            res->numElements = length;
+            for (std::size_t i = 0; i < length; ++i) {
+                res->keys[i] = a[i];
+            }
+            return res;
+        }
+
+        // use as few keys in this node as possible, the sub-trees exceed the capacity of a lower tree
+        const std::size_t capacity = getCapacity(height - 1);
+        const std::size_t numKeys = (length <= capacity) ? 1 : (length - capacity - 1) / (capacity + 1) + 1;
+
+        // all but the last two sub-trees are full, the last two share the remaining keys
+        const std::size_t remaining = length - numKeys - (numKeys - 1) * capacity;
+
+        node* res = new inner_node();
+        res->numElements = numKeys;
+
+        Iter c = a;
+        for (std::size_t i = 0; i <= numKeys; i++) {
+            std::size_t size = capacity;
+            if (i + 1 == numKeys) {
+                size = remaining - remaining / 2;
+            } else if (i == numKeys) {
+                size = remaining / 2;
+            }
+
+            auto child = buildDenseSubTree(c, size, height - 1);
+            child->parent = res;
+            child->position = i;
+            res->getChildren()[i] = child;
+            c = c + size;
+
+            // get dividing key
+            if (i < numKeys) {
+                res->keys[i] = *c;
+                c = c + 1;
+            }
+        }
+
+        return res;
+    }
+
     // Utility function for the load operation above.
     template <typename Iter>
     static node* buildSubTree(const Iter& a, const Iter& b) {
@@ -2580,7 +2853,7 @@ const SearchStrategy btree_delete<Key, Comparator, Allocator, blockSize, SearchS
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
         typename Allocator = std::allocator<Key>,  // is ignored so far
-        unsigned blockSize = 256,
+        unsigned blockSize = detail::default_block_size<Key>::value,
         typename SearchStrategy = typename souffle::detail::default_strategy<Key>::type,
         typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>>
 class btree_delete_set : public souffle::detail::btree_delete<Key, Comparator, Allocator, blockSize,
@@ -2643,7 +2916,7 @@ public:
  */
 template <typename Key, typename Comparator = detail::comparator<Key>,
         typename Allocator = std::allocator<Key>,  // is ignored so far
-        unsigned blockSize = 256,
+        unsigned blockSize = detail::default_block_size<Key>::value,
         typename SearchStrategy = typename souffle::detail::default_strategy<Key>::type,
         typename WeakComparator = Comparator, typename Updater = souffle::detail::updater<Key>>
 class btree_delete_multiset : public souffle::detail::btree_delete<Key, Comparator, Allocator, blockSize,
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <tuple>
+
 namespace souffle {
 
 namespace detail {
@@ -186,6 +189,99 @@ struct binary_search : public search_strategy {
     }
 };
 
+/**
+ * A search strategy for looking up tuples (std::array) in b-tree nodes,
+ * where the comparator orders tuples lexicographically in the natural
+ * order of their columns. Instead of branching on each comparison, the
+ * searched key is compared with all keys of the node at once and the
+ * smaller keys are counted, such that the comparisons of the columns are
+ * vectorised by the compiler (AVX2, AVX-512 or NEON, as enabled for the
+ * target). This is worthwhile for nodes of tuples of few columns.
+ */
+struct vector_search : public search_strategy {
+    /**
+     * Required user-defined default constructor.
+     */
+    vector_search() = default;
+
+    /**
+     * Obtains an iterator referencing an element equivalent to the
+     * given key in the given range. If no such element is present,
+     * a reference to the first element not less than the given key
+     * is returned.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter operator()(const Key& k, Iter a, Iter b, Comp& comp) const {
+        return lower_bound(k, a, b, comp);
+    }
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * is not less than the given key.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter lower_bound(const Key& k, Iter a, Iter b, Comp& /* comp */) const {
+        return a + count<false>(k, a, b - a);
+    }
+
+    /**
+     * Obtains a reference to the first element in the given range that
+     * such that the given key is less than the referenced element.
+     */
+    template <typename Key, typename Iter, typename Comp>
+    inline Iter upper_bound(const Key& k, Iter a, Iter b, Comp& /* comp */) const {
+        return a + count<true>(k, a, b - a);
+    }
+
+private:
+    /** Counts the keys less than (or equal to) the given key */
+    template <bool orEqual, typename Key>
+    static std::ptrdiff_t count(const Key& k, const Key* keys, std::ptrdiff_t n) {
+        constexpr std::size_t arity = std::tuple_size<Key>::value;
+        static_assert(arity > 0, "nullary tuples are not stored in b-trees");
+        std::ptrdiff_t res = 0;
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            const Key& cur = keys[i];
+            // evaluate the lexicographic order from the last column, without branches
+            bool less = orEqual ? cur[arity - 1] <= k[arity - 1] : cur[arity - 1] < k[arity - 1];
+            for (std::size_t c = arity - 1; c-- > 0;) {
+                less = (cur[c] < k[c]) | ((cur[c] == k[c]) & less);
+            }
+            res += less;
+        }
+        return res;
+    }
+};
+
+// ---------- node sizes --------------
+
+/**
+ * The size of a cache line, to which the nodes of b-trees are rounded.
+ */
+constexpr std::size_t cache_line_size = 64;
+
+/**
+ * The number of bytes per node of a b-tree over keys of the given size.
+ *
+ * Nodes are sized to hold about 64 keys, rounded to whole cache lines and
+ * bounded by a 4 KiB page. Across tuples of 1 to 12 columns this measured
+ * best for probes, insertions and scans alike, while a fixed node size
+ * leaves the nodes of narrow tuples too small and those of wide tuples
+ * with only a handful of keys.
+ */
+constexpr unsigned block_size_for(std::size_t keySize) {
+    const std::size_t bytes = (64 * keySize + cache_line_size - 1) / cache_line_size * cache_line_size;
+    return static_cast<unsigned>(bytes < 256 ? 256 : (bytes > 4096 ? 4096 : bytes));
+}
+
+/**
+ * The default node size of b-trees over the given key type.
+ */
+template <typename Key>
+struct default_block_size {
+    static constexpr unsigned value = block_size_for(sizeof(Key));
+};
+
 // ---------- search strategies selection --------------
 
 /**
@@ -0,0 +1,93 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BlockCounter.h
+ *
+ * The counter of the auto-increment values, handing out blocks of values
+ * to each thread.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+namespace souffle {
+
+/**
+ * A counter handing out unique values to concurrent threads.
+ *
+ * With a block size of one, the values are dense and in the order of the
+ * requests, each of which increments the shared counter. With larger
+ * blocks, a thread reserves a block of consecutive values at once and
+ * hands them out without touching the shared counter, such that threads
+ * requesting many values do not contend for its cache line. The values
+ * remain unique, but the values of blocks not used up are skipped, and
+ * the values of different threads interleave.
+ *
+ * A thread keeps the block of the last counter it used only, hence a
+ * thread alternating between counters reserves a new block each time.
+ */
+class BlockCounter {
+public:
+    explicit BlockCounter(RamDomain blockSize = 1) : blockSize(blockSize), id(nextId()) {}
+
+    BlockCounter(const BlockCounter&) = delete;
+    BlockCounter& operator=(const BlockCounter&) = delete;
+
+    /** Return the next value of the counter */
+    RamDomain next() {
+        if (blockSize == 1) {
+            return counter.fetch_add(1, std::memory_order_relaxed);
+        }
+        Block& block = getBlock();
+        if (block.owner != id || block.next == block.end) {
+            block.owner = id;
+            block.next = counter.fetch_add(blockSize, std::memory_order_relaxed);
+            block.end = block.next + blockSize;
+        }
+        return block.next++;
+    }
+
+    /** Return the number of values reserved so far, including the values of unused blocks */
+    RamDomain reserved() const {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Block {
+        std::size_t owner = std::numeric_limits<std::size_t>::max();
+        RamDomain next = 0;
+        RamDomain end = 0;
+    };
+
+    // the block of the current thread
+    static Block& getBlock() {
+        static thread_local Block block;
+        return block;
+    }
+
+    // ids are never reused, such that a new counter does not take over the block of a destroyed one
+    static std::size_t nextId() {
+        static std::atomic<std::size_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const RamDomain blockSize;
+
+    const std::size_t id;
+
+    std::atomic<RamDomain> counter{0};
+};
+
+}  // namespace souffle
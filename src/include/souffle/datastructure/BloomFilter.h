@@ -0,0 +1,137 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BloomFilter.h
+ *
+ * A Bloom filter over tuples, answering most existence checks of tuples
+ * not in a relation without searching its index.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace souffle {
+
+/**
+ * A blocked Bloom filter over tuples of RamDomain values.
+ *
+ * All bits of a tuple are set in a single 64-bit word, so a check loads
+ * one word. A filter is inactive until it is reset to the number of tuples
+ * it is going to hold; an inactive filter may contain any tuple.
+ *
+ * Insertions may run concurrently with each other, but not with reset()
+ * or clear(). Tuples cannot be removed; a filter holding more tuples than
+ * it was reset to remains correct, but filters fewer tuples.
+ */
+class BloomFilter {
+    /** Number of bits per expected tuple */
+    static constexpr std::size_t BITS_PER_TUPLE = 16;
+
+    /** Number of bits set per tuple */
+    static constexpr std::size_t NUM_HASHES = 4;
+
+public:
+    BloomFilter() = default;
+
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+
+    /** Check whether the filter is active, i.e., holds all tuples of its relation */
+    bool isActive() const {
+        return words != nullptr;
+    }
+
+    /** Activate the filter for the given number of tuples, removing all tuples of the filter */
+    void reset(std::size_t expected) {
+        std::size_t numWords = 1;
+        while (numWords * 64 < expected * BITS_PER_TUPLE) {
+            numWords <<= 1;
+        }
+        words = std::make_unique<std::atomic<uint64_t>[]>(numWords);
+        for (std::size_t i = 0; i < numWords; ++i) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+        mask = numWords - 1;
+    }
+
+    /** Deactivate the filter */
+    void clear() {
+        words.reset();
+        mask = 0;
+    }
+
+    /** Add a tuple to an active filter; tuples added to an inactive filter are ignored */
+    template <typename Tuple>
+    void insert(const Tuple& tuple) {
+        if (words == nullptr) {
+            return;
+        }
+        const uint64_t h = hash(tuple);
+        auto& word = words[h & mask];
+        const uint64_t bits = getBits(h);
+        if ((word.load(std::memory_order_relaxed) & bits) != bits) {
+            word.fetch_or(bits, std::memory_order_relaxed);
+        }
+    }
+
+    /** Check whether the tuple may be in the filter; false if it certainly is not */
+    template <typename Tuple>
+    bool mayContain(const Tuple& tuple) const {
+        if (words == nullptr) {
+            return true;
+        }
+        const uint64_t h = hash(tuple);
+        const uint64_t bits = getBits(h);
+        return (words[h & mask].load(std::memory_order_relaxed) & bits) == bits;
+    }
+
+    /** Swap the bits of two filters */
+    void swap(BloomFilter& other) {
+        words.swap(other.words);
+        std::swap(mask, other.mask);
+    }
+
+private:
+    /** The words of the filter; nullptr if the filter is inactive */
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+
+    /** The number of words of the filter minus one; the number of words is a power of two */
+    std::size_t mask = 0;
+
+    template <typename Tuple>
+    static uint64_t hash(const Tuple& tuple) {
+        uint64_t h = 0x9e3779b97f4a7c15ULL;
+        for (const auto& value : tuple) {
+            h ^= static_cast<uint64_t>(static_cast<RamUnsigned>(value));
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        return h ^ (h >> 29);
+    }
+
+    /** The bits within a word selected by the upper bits of the hash, six bits per selected bit */
+    static uint64_t getBits(uint64_t h) {
+        uint64_t bits = 0;
+        for (std::size_t i = 0; i < NUM_HASHES; ++i) {
+            bits |= static_cast<uint64_t>(1) << ((h >> (64 - 6 * (i + 1))) & 63);
+        }
+        return bits;
+    }
+};
+
+}  // namespace souffle
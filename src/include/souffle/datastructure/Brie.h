@@ -27,9 +27,11 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
+#include "souffle/datastructure/NodePool.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include "souffle/utility/span.h"
 #include <algorithm>
@@ -207,7 +209,7 @@ struct SparseArrayIter {
         int level = 1;
 
         // get current index on this level
-        x = SparseArray::getIndex(brie_element_type(value.first), level);
+        x = SparseArray::getIndex(value.first, level);
         x++;
 
         while (level > 0 && node) {
@@ -233,7 +235,7 @@ struct SparseArrayIter {
                 level++;
 
                 // get current index on this level
-                x = SparseArray::getIndex(brie_element_type(value.first), level);
+                x = SparseArray::getIndex(value.first, level);
                 x++;  // go one step further
             }
         }
@@ -371,6 +373,16 @@ private:
         const Node* parent;
         // the pointers to the child nodes (inner nodes) or the stored values (leaf nodes)
         Cell cell[NUM_CELLS];
+
+        // nodes are allocated from a pool shared by all tries with nodes of the same size
+        static void* operator new(std::size_t size) {
+            assert(size == sizeof(Node));
+            return NodePool<sizeof(Node), alignof(Node)>::allocate();
+        }
+
+        static void operator delete(void* ptr) {
+            NodePool<sizeof(Node), alignof(Node)>::deallocate(ptr);
+        }
     };
 
     /**
@@ -532,6 +544,22 @@ private:
         return res;
     }
 
+    /**
+     * Computes the number of nodes of the given sub-tree.
+     */
+    static std::size_t getNumNodes(const Node* node, int level) {
+        // support null-nodes
+        if (!node) return 0;
+
+        std::size_t res = 1;
+        if (level > 0) {
+            for (int i = 0; i < NUM_CELLS; i++) {
+                res += getNumNodes(node->cell[i].ptr, level - 1);
+            }
+        }
+        return res;
+    }
+
 public:
     /**
      * Computes the total memory usage of this data structure.
@@ -549,6 +577,13 @@ public:
         return res;
     }
 
+    /**
+     * Computes the number of nodes of this data structure.
+     */
+    std::size_t getNumNodes() const {
+        return getNumNodes(unsynced.root, unsynced.levels);
+    }
+
     /**
      * Resets the content of this array to default values for each contained
      * element.
@@ -838,7 +873,7 @@ private:
         unsigned level = info.levels;
         while (level != 0) {
             // get X coordinate
-            auto x = getIndex(brie_element_type(i), level);
+            auto x = getIndex(i, level);
 
             // decrease level counter
             --level;
@@ -955,7 +990,7 @@ public:
         unsigned level = unsynced.levels;
         while (level != 0) {
             // get X coordinate
-            auto x = getIndex(brie_element_type(i), level);
+            auto x = getIndex(i, level);
 
             // decrease level counter
             --level;
@@ -1019,6 +1054,69 @@ private:
         }
     }
 
+    /**
+     * The merge of a single sub-tree, as collected by collectMerges().
+     */
+    struct MergeTask {
+        const Node* parent;
+        Node** trg;
+        const Node* src;
+        int levels;
+    };
+
+    /**
+     * Collects the merges of the disjoint sub-trees found depth levels below the given nodes,
+     * which may be performed concurrently.
+     *
+     * @param parent the parent node of the current merge operation
+     * @param trg a reference to the pointer the merged node should be stored to
+     * @param src the node to be merged
+     * @param levels the height of the merged node
+     * @param depth the number of levels to descend before emitting merges
+     * @param tasks the list of merges to be extended
+     */
+    static void collectMerges(const Node* parent, Node*& trg, const Node* src, int levels, int depth,
+            std::vector<MergeTask>& tasks) {
+        // if other side is null => nothing to merge
+        if (src == nullptr) {
+            return;
+        }
+
+        // clones and leaf nodes are merged as a whole
+        if (trg == nullptr || levels == 0 || depth == 0) {
+            tasks.push_back({parent, &trg, src, levels});
+            return;
+        }
+
+        for (int i = 0; i < NUM_CELLS; ++i) {
+            collectMerges(trg, trg->cell[i].ptr, src->cell[i].ptr, levels - 1, depth - 1, tasks);
+        }
+    }
+
+    /**
+     * Merges the sub-trees of src into trg, distributing the merges of disjoint sub-trees
+     * among threads unless already running within a parallel region.
+     */
+    static void parallelMerge(const Node* parent, Node*& trg, const Node* src, int levels) {
+        bool parallel = false;
+#ifdef IS_PARALLEL
+        parallel = levels > 0 && MAX_THREADS > 1 && !omp_in_parallel();
+#endif
+        if (!parallel) {
+            merge(parent, trg, src, levels);
+            return;
+        }
+
+        // two levels yield up to NUM_CELLS^2 independent merges for load balancing
+        std::vector<MergeTask> tasks;
+        collectMerges(parent, trg, src, levels, 2, tasks);
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < tasks.size(); ++i) {
+            merge(tasks[i].parent, *tasks[i].trg, tasks[i].src, tasks[i].levels);
+        }
+        PARALLEL_END
+    }
+
 public:
     /**
      * Adds all the values stored in the given array to this array.
@@ -1046,7 +1144,7 @@ public:
         Node** node = &unsynced.root;
         while (level > other.unsynced.levels) {
             // get X coordinate
-            auto x = getIndex(brie_element_type(other.unsynced.offset), level);
+            auto x = getIndex(other.unsynced.offset, level);
 
             // decrease level counter
             --level;
@@ -1064,7 +1162,7 @@ public:
         }
 
         // merge sub-branches from here
-        merge((*node)->parent, *node, other.unsynced.root, level);
+        parallelMerge((*node)->parent, *node, other.unsynced.root, level);
 
         // update first
         if (unsynced.firstOffset > other.unsynced.firstOffset) {
@@ -1201,7 +1299,7 @@ public:
         unsigned level = unsynced.levels;
         while (true) {
             // get X coordinate
-            auto x = getIndex(brie_element_type(i), level);
+            auto x = getIndex(i, level);
 
             // check next node
             Node* next = node->cell[x].ptr;
@@ -1408,7 +1506,7 @@ private:
         node->parent = nullptr;
 
         // insert existing root as child
-        auto x = getIndex(brie_element_type(unsynced.offset), unsynced.levels + 1);
+        auto x = getIndex(unsynced.offset, unsynced.levels + 1);
         node->cell[x].ptr = unsynced.root;
 
         // swap the root
@@ -1435,7 +1533,7 @@ private:
         newRoot->parent = nullptr;
 
         // insert existing root as child
-        auto x = getIndex(brie_element_type(info.offset), info.levels + 1);
+        auto x = getIndex(info.offset, info.levels + 1);
         newRoot->cell[x].ptr = info.root;
 
         // exchange the root in the info struct
@@ -1479,7 +1577,7 @@ private:
      * Obtains the index within the arrays of cells of a given index on a given
      * level of the internally maintained tree.
      */
-    static index_type getIndex(brie_element_type a, unsigned level) {
+    static index_type getIndex(index_type a, unsigned level) {
         return (a & (INDEX_MASK << (level * BIT_PER_STEP))) >> (level * BIT_PER_STEP);
     }
 
@@ -1776,6 +1874,13 @@ public:
         return sizeof(*this) - sizeof(data_store_t) + store.getMemoryUsage();
     }
 
+    /**
+     * Computes the number of nodes of the underlying sparse array.
+     */
+    std::size_t getNumNodes() const {
+        return store.getNumNodes();
+    }
+
     /**
      * Sets all bits set in other to 1 within this bit map.
      */
@@ -1883,6 +1988,30 @@ public:
         return lower_bound(i + 1);
     }
 
+    /**
+     * Determines the number of bits set within the closed interval [lower, upper], counting
+     * a word of the bit map at a time instead of enumerating the bits.
+     */
+    std::size_t count(index_type lower, index_type upper) const {
+        if (upper < lower) return 0;
+
+        const index_type first = lower >> LEAF_INDEX_WIDTH;
+        const index_type last = upper >> LEAF_INDEX_WIDTH;
+
+        std::size_t res = 0;
+        for (auto it = store.lowerBound(first); !it.isEnd() && it->first <= last; ++it) {
+            uint64_t mask = toMask(it->second);
+            if (it->first == first) {
+                mask &= (~uint64_t(0)) << (lower & LEAF_INDEX_MASK);  // remove all bits before lower
+            }
+            if (it->first == last) {
+                mask &= (~uint64_t(0)) >> (LEAF_INDEX_MASK - (upper & LEAF_INDEX_MASK));  // and after upper
+            }
+            res += __builtin_popcountll(mask);
+        }
+        return res;
+    }
+
     /**
      * A debugging utility printing the internal structure of this map to the
      * given output stream.
@@ -2087,6 +2216,8 @@ public:
     //      bool upper_bound(const_entry_span_type tuple, op_context& ctxt) const;
     //      template <unsigned levels>
     //      range<iterator> getBoundaries(const_entry_span_type, op_context&) const;
+    //      template <unsigned levels>
+    //      std::size_t countBoundaries(const_entry_span_type, op_context&) const;
 
     // -- operation wrappers --
 
@@ -2096,6 +2227,22 @@ public:
         return impl().template getBoundaries<levels>(entry, ctxt);
     }
 
+    template <unsigned levels>
+    std::size_t countBoundaries(const_entry_span_type entry) const {
+        op_context ctxt;
+        return impl().template countBoundaries<levels>(entry, ctxt);
+    }
+
+    template <unsigned levels>
+    std::size_t countBoundaries(const entry_type& entry, op_context& ctxt) const {
+        return impl().template countBoundaries<levels>(const_entry_span_type(entry), ctxt);
+    }
+
+    template <unsigned levels>
+    std::size_t countBoundaries(const entry_type& entry) const {
+        return impl().template countBoundaries<levels>(const_entry_span_type(entry));
+    }
+
     template <unsigned levels>
     range<iterator> getBoundaries(const entry_type& entry, op_context& ctxt) const {
         return impl().template getBoundaries<levels>(const_entry_span_type(entry), ctxt);
@@ -2660,6 +2807,7 @@ public:
 
     using base::begin;
     using base::contains;
+    using base::countBoundaries;
     using base::empty;
     using base::end;
     using base::find;
@@ -2696,6 +2844,17 @@ public:
         return res;
     }
 
+    /**
+     * Computes the number of nodes of this level and its sub-levels.
+     */
+    std::size_t getNumNodes() const {
+        auto res = store.getNumNodes();
+        for (auto&& [_, v] : store)
+            res += v->getNumNodes();
+
+        return res;
+    }
+
     /**
      * Removes all entries within this trie.
      */
@@ -2782,6 +2941,30 @@ public:
         return next && next->contains(tail(tuple), ctxt.nestedCtxt);
     }
 
+    /**
+     * Determines the number of elements matching the prefix of the given entry up to levels
+     * elements, without enumerating them.
+     *
+     * @tparam levels the length of the matching prefix
+     * @param entry the entry to be looking for
+     * @param ctxt the operation context to be utilized
+     * @return the number of matching elements
+     */
+    template <unsigned levels>
+    std::size_t countBoundaries(const_entry_span_type entry, op_context& ctxt) const {
+        if constexpr (levels == 0) {
+            return size();
+        } else {
+            auto next = store.lookup(entry[0], ctxt.local);
+            if (next != ctxt.lastNested) {
+                ctxt.lastQuery = entry[0];
+                ctxt.lastNested = next;
+                ctxt.nestedCtxt = {};
+            }
+            return next ? next->template countBoundaries<levels - 1>(tail(entry), ctxt.nestedCtxt) : 0;
+        }
+    }
+
     /**
      * Obtains a range of elements matching the prefix of the given entry up to
      * levels elements. A operation context may be provided to exploit temporal
@@ -2932,6 +3115,7 @@ public:
 
     using base::begin;
     using base::contains;
+    using base::countBoundaries;
     using base::empty;
     using base::end;
     using base::find;
@@ -2955,6 +3139,13 @@ public:
         return sizeof(*this) - sizeof(store) + store.getMemoryUsage();
     }
 
+    /**
+     * Computes the number of nodes of the underlying bit map.
+     */
+    std::size_t getNumNodes() const {
+        return store.getNumNodes();
+    }
+
     /**
      * Removes all elements form this trie.
      */
@@ -3041,6 +3232,16 @@ public:
         return make_range(iterator(pos), iterator(next));
     }
 
+    /**
+     * Determines the number of elements matching the prefix of the given entry up to levels
+     * elements, i.e., whether the entry is present if levels is 1.
+     */
+    template <unsigned levels>
+    std::size_t countBoundaries(const_entry_span_type entry, op_context& ctxt) const {
+        if (levels == 0) return size();
+        return store.test(entry[0], ctxt) ? 1 : 0;
+    }
+
     iterator lower_bound(const_entry_span_type entry, op_context&) const {
         return iterator(store.lower_bound(entry[0]));
     }
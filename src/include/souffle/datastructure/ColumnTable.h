@@ -0,0 +1,251 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ColumnTable.h
+ *
+ * An append-only table storing each attribute of a relation in its own
+ * column. Rows are addressed by dense row ids, which are referenced by the
+ * indexes of columnar relations.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/utility/Iteration.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+template <std::size_t Arity>
+class ColumnTable {
+public:
+    using t_tuple = Tuple<RamDomain, Arity>;
+
+    /**
+     * The key type of indexes over this table.
+     *
+     * A key either refers to a row of the table or, with the lowest bit set, to
+     * a tuple outside of the table; the latter are used to probe the indexes.
+     */
+    using key_type = std::uintptr_t;
+
+    ColumnTable() = default;
+    ColumnTable(const ColumnTable&) = delete;
+    ColumnTable& operator=(const ColumnTable&) = delete;
+
+    ~ColumnTable() {
+        clear();
+    }
+
+    /** Obtain the key of a row */
+    static key_type rowKey(std::size_t row) {
+        return static_cast<key_type>(row) << 1;
+    }
+
+    /** Obtain the key of a tuple probing an index */
+    static key_type probeKey(const t_tuple& tuple) {
+        return reinterpret_cast<key_type>(&tuple) | 1;
+    }
+
+    /** Obtain the value of the given column of a key */
+    RamDomain get(key_type key, std::size_t column) const {
+        if ((key & 1) != 0) {
+            return (*reinterpret_cast<const t_tuple*>(key & ~static_cast<key_type>(1)))[column];
+        }
+        return at(key >> 1, column);
+    }
+
+    /** Assemble the tuple of a key */
+    t_tuple tuple(key_type key) const {
+        t_tuple res;
+        for (std::size_t i = 0; i < Arity; ++i) {
+            res[i] = get(key, i);
+        }
+        return res;
+    }
+
+    /**
+     * Append a row and return its row id.
+     *
+     * Appends must not run concurrently; rows already stored may be read
+     * while a row is appended.
+     */
+    std::size_t append(const t_tuple& tuple) {
+        const std::size_t row = rows.load(std::memory_order_relaxed);
+        const auto [block, offset] = locate(row);
+        if (blocks[block] == nullptr) {
+            blocks[block] = new RamDomain[blockSize(block) * Arity];
+        }
+        for (std::size_t i = 0; i < Arity; ++i) {
+            blocks[block][i * blockSize(block) + offset] = tuple[i];
+        }
+        rows.store(row + 1, std::memory_order_release);
+        return row;
+    }
+
+    /** The number of stored rows */
+    std::size_t size() const {
+        return rows.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void clear() {
+        for (auto& block : blocks) {
+            delete[] block;
+            block = nullptr;
+        }
+        rows.store(0, std::memory_order_release);
+    }
+
+    /**
+     * An iterator over the rows of the table in insertion order, assembling
+     * the tuples on access.
+     */
+    class iterator {
+        const ColumnTable* table = nullptr;
+        std::size_t row = 0;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = t_tuple;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const t_tuple*;
+        using reference = t_tuple;
+
+        iterator() = default;
+        iterator(const ColumnTable* table, std::size_t row) : table(table), row(row) {}
+
+        t_tuple operator*() const {
+            return table->tuple(rowKey(row));
+        }
+
+        iterator& operator++() {
+            ++row;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator res = *this;
+            ++row;
+            return res;
+        }
+
+        bool operator==(const iterator& other) const {
+            return row == other.row;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return row != other.row;
+        }
+    };
+
+    /**
+     * An iterator over the keys of an index, assembling the referenced
+     * tuples on access.
+     */
+    template <typename Iter>
+    class index_iterator {
+        const ColumnTable* table = nullptr;
+        Iter iter;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = t_tuple;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const t_tuple*;
+        using reference = t_tuple;
+
+        index_iterator() = default;
+        index_iterator(const ColumnTable* table, Iter iter) : table(table), iter(std::move(iter)) {}
+
+        t_tuple operator*() const {
+            return table->tuple(*iter);
+        }
+
+        index_iterator& operator++() {
+            ++iter;
+            return *this;
+        }
+
+        index_iterator operator++(int) {
+            index_iterator res = *this;
+            ++iter;
+            return res;
+        }
+
+        bool operator==(const index_iterator& other) const {
+            return iter == other.iter;
+        }
+
+        bool operator!=(const index_iterator& other) const {
+            return iter != other.iter;
+        }
+    };
+
+    iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    iterator end() const {
+        return iterator(this, size());
+    }
+
+    /** Split the rows into about the given number of consecutive ranges */
+    std::vector<range<iterator>> getChunks(std::size_t num) const {
+        std::vector<range<iterator>> res;
+        const std::size_t total = size();
+        const std::size_t step = total / num + 1;
+        for (std::size_t row = 0; row < total; row += step) {
+            res.push_back(make_range(iterator(this, row), iterator(this, std::min(row + step, total))));
+        }
+        return res;
+    }
+
+private:
+    /** Number of rows of the first block; each further block doubles in size */
+    static constexpr std::size_t FIRST_BLOCK_BITS = 10;
+
+    static constexpr std::size_t MAX_BLOCKS = 48;
+
+    static std::size_t blockSize(std::size_t block) {
+        return static_cast<std::size_t>(1) << (FIRST_BLOCK_BITS + block);
+    }
+
+    /** Obtain the block and the offset within the block of a row */
+    static std::pair<std::size_t, std::size_t> locate(std::size_t row) {
+        const auto n = static_cast<unsigned long long>(row + blockSize(0));
+        const std::size_t block = (63 - __builtin_clzll(n)) - FIRST_BLOCK_BITS;
+        return {block, row + blockSize(0) - blockSize(block)};
+    }
+
+    RamDomain at(std::size_t row, std::size_t column) const {
+        const auto [block, offset] = locate(row);
+        return blocks[block][column * blockSize(block) + offset];
+    }
+
+    /** Blocks holding the rows, with the columns of a block stored consecutively */
+    std::array<RamDomain*, MAX_BLOCKS> blocks{};
+
+    std::atomic<std::size_t> rows{0};
+};
+
+}  // namespace souffle
@@ -9,8 +9,12 @@
 
 #include "ConcurrentInsertOnlyHashMap.h"
 #include "souffle/utility/ParallelUtil.h"
+#include <array>
+#include <atomic>
 #include <cassert>
-#include <cstring>
+#include <cstdint>
+#include <memory>
+#include <utility>
 
 namespace souffle {
 
@@ -23,9 +27,12 @@ namespace souffle {
  * Access to the datastructure is lock-free between different lanes.
  * Concurrent accesses through the same lane is sequential.
  *
- * Growing the datastructure requires to temporarily lock all lanes to let a
- * single lane perform the growing operation. The global lock is amortized
- * thanks to an exponential growth strategy.
+ * Growing the datastructure never locks other lanes: the index of the keys is
+ * a split-ordered hash-map whose buckets split without moving any element,
+ * and the values are referenced from blocks of slots of doubling capacity
+ * that are allocated on demand and never move.
+ *
+ * Fetching the value of an index is lock-free.
  *
  */
 template <class LanesPolicy, class Key, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
@@ -136,13 +143,11 @@ public:
         }
 
         reference operator*() const {
-            const auto Guard = This->Lanes.guard(Lane);
-            return *This->Slots[index(Slot)];
+            return *This->slotAt(index(Slot));
         }
 
         pointer operator->() const {
-            const auto Guard = This->Lanes.guard(Lane);
-            return This->Slots[index(Slot)];
+            return This->slotAt(index(Slot));
         }
 
         Iterator& operator++() {
@@ -227,10 +232,12 @@ public:
             const KeyFactory& key_factory = KeyFactory())
             : Lanes(LaneCount), HandleCount(LaneCount),
               Mapping(LaneCount, InitialCapacity, hash, key_equal, key_factory) {
-        Slots = std::make_unique<const value_type*[]>(InitialCapacity);
+        for (auto& Block : Blocks) {
+            Block.store(nullptr, std::memory_order_relaxed);
+        }
         Handles = std::make_unique<Handle[]>(HandleCount);
         NextSlot = (ReserveFirst ? 1 : 0);
-        SlotCount = InitialCapacity;
+        reserveSlots(InitialCapacity);
     }
 
     /// Initialize the datastructure with a capacity of 8 elements.
@@ -250,6 +257,9 @@ public:
                 delete Handles[I].NextNode;
             }
         }
+        for (auto& Block : Blocks) {
+            delete[] Block.load(std::memory_order_relaxed);
+        }
     }
 
     /**
@@ -267,6 +277,46 @@ public:
         Lanes.setNumLanes(NumLanes);
     }
 
+    /**
+     * Exchange the values and indices of two datastructures with the same number of lanes.
+     * Do not use while threads are using either datastructure.
+     */
+    void swap(ConcurrentFlyweight& Other) {
+        assert(HandleCount == Other.HandleCount && "lanes must match");
+        Handles.swap(Other.Handles);
+        for (std::size_t B = 0; B < MaxBlocks; ++B) {
+            Blocks[B] = Other.Blocks[B].exchange(Blocks[B].load(std::memory_order_relaxed));
+        }
+        Mapping.swap(Other.Mapping);
+        NextSlot = Other.NextSlot.exchange(NextSlot.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Prepare the datastructure for the given total number of values, e.g. before inserting
+     * values known in advance, such that the index and the slots do not grow while inserting them.
+     */
+    void reserve(const std::size_t Count) {
+        Mapping.reserve(Count);
+        reserveSlots(Count);
+    }
+
+    /// Return the number of values of the datastructure.
+    std::size_t size() const {
+        return Mapping.size();
+    }
+
+    /// Return the number of bytes allocated by the datastructure, excluding the heap memory of the values.
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this) - sizeof(Mapping) + HandleCount * sizeof(Handle) +
+                          Mapping.getMemoryUsage();
+        for (std::size_t B = 0; B < MaxBlocks; ++B) {
+            if (Blocks[B].load(std::memory_order_relaxed) != nullptr) {
+                res += blockSize(B) * sizeof(const value_type*);
+            }
+        }
+        return res;
+    }
+
     /** Return a concurrent iterator on the first element. */
     Iterator begin(const lane_id H) const {
         return Iterator(this, H);
@@ -283,12 +333,11 @@ public:
         return Mapping.weakContains(H, X);
     }
 
-    /// Return the value associated with the given index.
+    /// Return the value associated with the given index, without locking any lane.
     /// Assumption: the index is mapped in the datastructure.
-    const Key& fetch(const lane_id H, const index_type Idx) const {
-        const auto Lane = Lanes.guard(H);
-        assert(Idx < SlotCount.load(std::memory_order_relaxed));
-        return Slots[Idx]->first;
+    const Key& fetch(const index_type Idx) const {
+        assert(Idx < NextSlot.load(std::memory_order_relaxed));
+        return slotAt(Idx)->first;
     }
 
     /// Return the pair of the index for the given value and a boolean
@@ -298,46 +347,20 @@ public:
     template <class... Args>
     std::pair<index_type, bool> findOrInsert(const lane_id H, Args&&... Xs) {
         const auto Lane = Lanes.guard(H);
-        node_type Node;
-
-        slot_type Slot = Handles[H].NextSlot;
-
-        // Getting the next insertion slot for the current lane may require
-        // more than one attempts if the datastructure must grow and other
-        // threads are waiting for the same lane @p H.
-        while (true) {
-            if (Slot == NONE) {
-                // Reserve a slot for the lane, the datastructure might need to
-                // grow before the slot memory location becomes available.
-                Slot = NextSlot++;
-                Handles[H].NextSlot = Slot;
-                Handles[H].NextNode = Mapping.node(static_cast<index_type>(Slot));
-            }
 
-            if (Slot >= SlotCount.load(std::memory_order_relaxed)) {
-                // The slot memory location is not yet available, try to
-                // grow the datastructure. Other threads in other lanes might
-                // be attempting to grow the datastructure concurrently.
-                //
-                // Anyway when this call returns the Slot memory location is
-                // available.
-                tryGrow(H);
-
-                // Reload the Slot for the current lane since another thread
-                // using the same lane may take-over the lane during tryGrow()
-                // and consume the slot before the current thread is
-                // rescheduled on the lane.
-                Slot = Handles[H].NextSlot;
-            } else {
-                // From here the slot is known, allocated and available.
-                break;
-            }
+        if (Handles[H].NextSlot == NONE) {
+            // Reserve a slot for the lane, allocating its block if no lane did yet.
+            const slot_type Slot = NextSlot++;
+            allocateSlot(Slot);
+            Handles[H].NextSlot = Slot;
+            Handles[H].NextNode = Mapping.node(static_cast<index_type>(Slot));
         }
 
-        Node = Handles[H].NextNode;
+        const slot_type Slot = Handles[H].NextSlot;
+        node_type Node = Handles[H].NextNode;
 
         // Insert key in the index in advance.
-        Slots[Slot] = &Node->value();
+        slotAt(Slot) = &Node->value();
 
         auto Res = Mapping.get(H, Node, std::forward<Args>(Xs)...);
         if (Res.second) {
@@ -352,7 +375,7 @@ public:
             // The reserved slot and node remains in the lane state so that
             // they can be consumed by the next insertion operation on this
             // lane.
-            Slots[Slot] = nullptr;
+            slotAt(Slot) = nullptr;
             return std::make_pair(Res.first->second, false);
         }
     }
@@ -376,14 +399,21 @@ protected:
     LanesPolicy Lanes;
 
 private:
+    // Capacity of the first block of slots, the following blocks double in size.
+    static constexpr std::size_t FirstBlockBits = 3;
+    static constexpr std::size_t FirstBlockSize = std::size_t(1) << FirstBlockBits;
+
+    // enough blocks to address all slots
+    static constexpr std::size_t MaxBlocks = 64 - FirstBlockBits;
+
     // Number of handles
     std::size_t HandleCount;
 
     // Handle for each concurrent lane.
     std::unique_ptr<Handle[]> Handles;
 
-    // Slots[I] points to the value associated with index I.
-    std::unique_ptr<const value_type*[]> Slots;
+    // The blocks of slots, allocated on demand; the slot of index I points to the value associated with I.
+    std::array<std::atomic<const value_type**>, MaxBlocks> Blocks;
 
     // The map from keys to index.
     map_type Mapping;
@@ -391,44 +421,41 @@ private:
     // Next available slot.
     std::atomic<slot_type> NextSlot;
 
-    // Number of slots.
-    std::atomic<slot_type> SlotCount;
-
-    /// Grow the datastructure if needed.
-    bool tryGrow(const lane_id H) {
-        // This call may release and re-acquire the lane to
-        // allow progress of a concurrent growing operation.
-        //
-        // It is possible that another thread is waiting to
-        // enter the same lane, and that other thread might
-        // take and leave the lane before the current thread
-        // re-acquires it.
-        Lanes.beforeLockAllBut(H);
-
-        if (NextSlot < SlotCount) {
-            // Current size is fine
-            Lanes.beforeUnlockAllBut(H);
-            return false;
-        }
+    // The block holding the given slot, and the position of the slot within the block.
+    static std::pair<std::size_t, std::size_t> blockOf(const slot_type S) {
+        const std::uint64_t Pos = static_cast<std::uint64_t>(S) + FirstBlockSize;
+        const std::size_t Block = 63 - __builtin_clzll(Pos) - FirstBlockBits;
+        return {Block, Pos - (FirstBlockSize << Block)};
+    }
 
-        Lanes.lockAllBut(H);
+    static std::size_t blockSize(const std::size_t Block) {
+        return FirstBlockSize << Block;
+    }
 
-        {  // safe section
-            const std::size_t CurrentSize = SlotCount;
-            std::size_t NewSize = (CurrentSize << 1);  // double size policy
-            while (NewSize < NextSlot) {
-                NewSize <<= 1;  // double size
+    /// Return the slot of the given index, whose block must be allocated.
+    const value_type*& slotAt(const slot_type S) const {
+        const auto [Block, Offset] = blockOf(S);
+        return Blocks[Block].load(std::memory_order_acquire)[Offset];
+    }
+
+    /// Allocate the block of the given slot if no lane did yet.
+    void allocateSlot(const slot_type S) {
+        const std::size_t Block = blockOf(S).first;
+        const value_type** Data = Blocks[Block].load(std::memory_order_acquire);
+        if (Data == nullptr) {
+            auto** Fresh = new const value_type*[blockSize(Block)]();
+            if (!Blocks[Block].compare_exchange_strong(
+                        Data, Fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                delete[] Fresh;
             }
-            std::unique_ptr<const value_type*[]> NewSlots = std::make_unique<const value_type*[]>(NewSize);
-            std::memcpy(NewSlots.get(), Slots.get(), sizeof(const value_type*) * CurrentSize);
-            Slots = std::move(NewSlots);
-            SlotCount = NewSize;
         }
+    }
 
-        Lanes.beforeUnlockAllBut(H);
-        Lanes.unlockAllBut(H);
-
-        return true;
+    /// Allocate the blocks of the first Count slots.
+    void reserveSlots(const std::size_t Count) {
+        for (std::size_t S = 0; S < Count; S += blockSize(blockOf(S).first)) {
+            allocateSlot(S);
+        }
     }
 };
 
@@ -456,19 +483,44 @@ public:
         return Base::end();
     }
 
+    std::size_t size() const {
+        return Base::size();
+    }
+
+    std::size_t getMemoryUsage() const {
+        return Base::getMemoryUsage();
+    }
+
+    void swap(OmpFlyweight& Other) {
+        Base::swap(Other);
+    }
+
+    void reserve(const std::size_t Count) {
+        Base::reserve(Count);
+    }
+
     template <typename K>
     bool weakContains(const K& X) const {
         return Base::weakContains(Base::Lanes.threadLane(), X);
     }
 
     const Key& fetch(const index_type Idx) const {
-        return Base::fetch(Base::Lanes.threadLane(), Idx);
+        return Base::fetch(Idx);
     }
 
     template <class... Args>
     std::pair<index_type, bool> findOrInsert(Args&&... Xs) {
         return Base::findOrInsert(Base::Lanes.threadLane(), std::forward<Args>(Xs)...);
     }
+
+    /// Insert each key of the range [First, Last) and write its index to Out, determining the lane once.
+    template <class InputIt, class OutputIt>
+    void findOrInsertAll(InputIt First, InputIt Last, OutputIt Out) {
+        const lane_id H = Base::Lanes.threadLane();
+        for (; First != Last; ++First, ++Out) {
+            *Out = Base::findOrInsert(H, *First).first;
+        }
+    }
 };
 #endif
 
@@ -499,19 +551,43 @@ public:
         return Base::end();
     }
 
+    std::size_t size() const {
+        return Base::size();
+    }
+
+    std::size_t getMemoryUsage() const {
+        return Base::getMemoryUsage();
+    }
+
+    void swap(SeqFlyweight& Other) {
+        Base::swap(Other);
+    }
+
+    void reserve(const std::size_t Count) {
+        Base::reserve(Count);
+    }
+
     template <typename K>
     bool weakContains(const K& X) const {
         return Base::weakContains(0, X);
     }
 
     const Key& fetch(const index_type Idx) const {
-        return Base::fetch(0, Idx);
+        return Base::fetch(Idx);
     }
 
     template <class... Args>
     std::pair<index_type, bool> findOrInsert(Args&&... Xs) {
         return Base::findOrInsert(0, std::forward<Args>(Xs)...);
     }
+
+    /// Insert each key of the range [First, Last) and write its index to Out.
+    template <class InputIt, class OutputIt>
+    void findOrInsertAll(InputIt First, InputIt Last, OutputIt Out) {
+        for (; First != Last; ++First, ++Out) {
+            *Out = Base::findOrInsert(0, *First).first;
+        }
+    }
 };
 
 #ifdef _OPENMP
@@ -13,47 +13,13 @@
 #include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <memory>
-#include <mutex>
-#include <vector>
+#include <utility>
 
 namespace souffle {
 namespace details {
 
-static const std::vector<std::pair<unsigned, unsigned>> ToPrime = {
-        // https://primes.utm.edu/lists/2small/0bit.html
-        // ((2^n) - k) is prime
-        // {n, k}
-        {4, 3},  // 2^4 - 3 = 13
-        {8, 5},  // 8^5 - 5 = 251
-        {9, 3}, {10, 3}, {11, 9}, {12, 3}, {13, 1}, {14, 3}, {15, 19}, {16, 15}, {17, 1}, {18, 5}, {19, 1},
-        {20, 3}, {21, 9}, {22, 3}, {23, 15}, {24, 3}, {25, 39}, {26, 5}, {27, 39}, {28, 57}, {29, 3},
-        {30, 35}, {31, 1}, {32, 5}, {33, 9}, {34, 41}, {35, 31}, {36, 5}, {37, 25}, {38, 45}, {39, 7},
-        {40, 87}, {41, 21}, {42, 11}, {43, 57}, {44, 17}, {45, 55}, {46, 21}, {47, 115}, {48, 59}, {49, 81},
-        {50, 27}, {51, 129}, {52, 47}, {53, 111}, {54, 33}, {55, 55}, {56, 5}, {57, 13}, {58, 27}, {59, 55},
-        {60, 93}, {61, 1}, {62, 57}, {63, 25}};
-
-// (2^64)-59 is the largest prime that fits in uint64_t
-static constexpr uint64_t LargestPrime64 = 18446744073709551557UL;
-
-// Return a prime greater or equal to the lower bound.
-// Return 0 if the next prime would not fit in 64 bits.
-static uint64_t GreaterOrEqualPrime(const uint64_t LowerBound) {
-    if (LowerBound > LargestPrime64) {
-        return 0;
-    }
-
-    for (std::size_t I = 0; I < ToPrime.size(); ++I) {
-        const uint64_t N = ToPrime[I].first;
-        const uint64_t K = ToPrime[I].second;
-        const uint64_t Prime = (1UL << N) - K;
-        if (Prime >= LowerBound) {
-            return Prime;
-        }
-    }
-    return LargestPrime64;
-}
-
 template <typename T>
 struct Factory {
     template <class... Args>
@@ -66,16 +32,21 @@ struct Factory {
 }  // namespace details
 
 /**
- * A concurrent, almost lock-free associative hash-map that can only grow.
+ * A concurrent, lock-free associative hash-map that can only grow.
  * Elements cannot be removed, the hash-map can only grow.
  *
- * The datastructures enables a configurable number of concurrent access lanes.
- * Access to the datastructure is lock-free between different lanes.
- * Concurrent accesses through the same lane is sequential.
+ * The elements form a single linked list in split order, i.e., ordered by
+ * the bit-reversed hash of their keys, and each bucket points to a dummy
+ * node of the list preceding the elements that fall into the bucket
+ * (Shalev and Shavit, "Split-ordered lists"). Doubling the number of
+ * buckets splits each bucket in two without moving any element, hence
+ * growing the map is a single atomic update of the bucket count. Buckets
+ * are initialized by the first lane that accesses them, and the bucket
+ * directory consists of segments that are allocated on demand and never
+ * move, such that lanes never wait for each other.
  *
- * Growing the datastructure requires to temporarily lock all lanes to let a
- * single lane perform the growing operation. The global lock is amortized
- * thanks to an exponential growth strategy.
+ * The access lanes of the interface are kept for the flyweight, which
+ * owns per-lane state; the map itself does not lock them.
  */
 template <class LanesPolicy, class Key, class T, class Hash = std::hash<Key>,
         class KeyEqual = std::equal_to<Key>, class KeyFactory = details::Factory<Key>>
@@ -102,11 +73,22 @@ public:
     };
 
 private:
-    // Each bucket of the hash-map is a linked list.
-    struct BucketList : Node {
+    // A node of the split-ordered list, either the dummy node of a bucket or an element.
+    struct ListNode {
+        explicit ListNode(const std::uint64_t K) : SoKey(K) {}
+
+        // The bit-reversed hash: odd for elements, even for the dummy nodes of buckets.
+        std::uint64_t SoKey;
+
+        // Points to the next node of the list, with an equal or greater split-order key.
+        std::atomic<ListNode*> Next{nullptr};
+    };
+
+    // An element of the map.
+    struct BucketList : Node, ListNode {
         virtual ~BucketList() {}
 
-        BucketList(const Key& K, const T& V, BucketList* N) : Value(K, V), Next(N) {}
+        BucketList(const Key& K, const T& V) : ListNode(1), Value(K, V) {}
 
         const value_type& value() const {
             return Value;
@@ -122,30 +104,35 @@ private:
 
         // Stores the couple of a key and its associated value.
         value_type Value;
-
-        // Points to next element of the map that falls into the same bucket.
-        BucketList* Next;
     };
 
+    // Buckets of the first segment of the bucket directory, the following segments double in size.
+    static constexpr std::size_t FirstSegmentBits = 6;
+    static constexpr std::size_t FirstSegmentSize = std::size_t(1) << FirstSegmentBits;
+
+    static constexpr std::size_t MaxSegments = 48;
+    static constexpr std::size_t MaxBucketCount = FirstSegmentSize << (MaxSegments - 1);
+
+    static constexpr std::uint64_t HighBit = std::uint64_t(1) << 63;
+
 public:
     /**
      * @brief Construct a hash-map with at least the given number of buckets.
      *
      * Load-factor is initialized to 1.0.
      */
-    ConcurrentInsertOnlyHashMap(const std::size_t LaneCount, const std::size_t Bucket_Count,
+    ConcurrentInsertOnlyHashMap(const std::size_t /* LaneCount */, const std::size_t Bucket_Count,
             const Hash& hash = Hash(), const KeyEqual& key_equal = KeyEqual(),
             const KeyFactory& key_factory = KeyFactory())
-            : Lanes(LaneCount), Hasher(hash), EqualTo(key_equal), Factory(key_factory) {
-        Size = 0;
-        BucketCount = details::GreaterOrEqualPrime(Bucket_Count);
-        if (BucketCount == 0) {
-            // Hopefuly this number of buckets is never reached.
-            BucketCount = std::numeric_limits<std::size_t>::max();
+            : Hasher(hash), EqualTo(key_equal), Factory(key_factory) {
+        for (auto& Segment : Segments) {
+            Segment.store(nullptr, std::memory_order_relaxed);
         }
+        Size = 0;
         LoadFactor = 1.0;
-        Buckets = std::make_unique<std::atomic<BucketList*>[]>(BucketCount);
-        MaxSizeBeforeGrow = std::ceil(LoadFactor * (double)BucketCount);
+        BucketCount = 1;
+        bucketSlot(0).store(new ListNode(0), std::memory_order_relaxed);
+        reserve(Bucket_Count);
     }
 
     ConcurrentInsertOnlyHashMap(const Hash& hash = Hash(), const KeyEqual& key_equal = KeyEqual(),
@@ -153,18 +140,80 @@ public:
             : ConcurrentInsertOnlyHashMap(8, hash, key_equal, key_factory) {}
 
     ~ConcurrentInsertOnlyHashMap() {
-        for (std::size_t Bucket = 0; Bucket < BucketCount; ++Bucket) {
-            BucketList* L = Buckets[Bucket].load(std::memory_order_relaxed);
-            while (L != nullptr) {
-                BucketList* BL = L;
-                L = L->Next;
-                delete (BL);
+        ListNode* L = loadBucket(0);
+        while (L != nullptr) {
+            ListNode* const Next = L->Next.load(std::memory_order_relaxed);
+            if (isElement(L)) {
+                delete static_cast<BucketList*>(L);
+            } else {
+                delete L;
             }
+            L = Next;
+        }
+        for (auto& Segment : Segments) {
+            delete[] Segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    /** @brief Accesses do not lock any lane, hence the number of lanes does not matter. */
+    void setNumLanes(const std::size_t) {}
+
+    /**
+     * @brief Prepare the map for the given number of elements, e.g. before loading them in parallel.
+     *
+     * The buckets are initialized on demand, but the directory is allocated upfront, and no
+     * lane grows the map until it holds more elements. Thread-safe.
+     */
+    void reserve(const std::size_t Count) {
+        std::size_t Needed = 1;
+        const double Target = std::ceil((double)Count / LoadFactor);
+        while ((double)Needed < Target && Needed < MaxBucketCount) {
+            Needed <<= 1;
+        }
+        std::size_t Current = BucketCount.load(std::memory_order_relaxed);
+        while (Current < Needed &&
+                !BucketCount.compare_exchange_weak(Current, Needed, std::memory_order_relaxed)) {
+        }
+        for (std::size_t B = 0; B < Needed; B += segmentSize(segmentOf(B).first)) {
+            bucketSlot(B);
+        }
+    }
+
+    /**
+     * @brief Exchange the elements of two maps with the same hash and equality functions.
+     *
+     * Not thread-safe, do not call while other threads are using either map.
+     */
+    void swap(ConcurrentInsertOnlyHashMap& Other) {
+        for (std::size_t S = 0; S < MaxSegments; ++S) {
+            Segments[S] = Other.Segments[S].exchange(Segments[S].load(std::memory_order_relaxed));
         }
+        BucketCount = Other.BucketCount.exchange(BucketCount.load(std::memory_order_relaxed));
+        Size = Other.Size.exchange(Size.load(std::memory_order_relaxed));
+        std::swap(LoadFactor, Other.LoadFactor);
     }
 
-    void setNumLanes(const std::size_t NumLanes) {
-        Lanes.setNumLanes(NumLanes);
+    /** @brief Return the number of elements of the map. */
+    std::size_t size() const {
+        return Size.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Return the number of bytes allocated by the map, excluding the heap memory of its keys. */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this) + size() * sizeof(BucketList);
+        for (std::size_t S = 0; S < MaxSegments; ++S) {
+            const std::atomic<ListNode*>* Segment = Segments[S].load(std::memory_order_relaxed);
+            if (Segment == nullptr) {
+                continue;
+            }
+            res += segmentSize(S) * sizeof(std::atomic<ListNode*>);
+            for (std::size_t I = 0; I < segmentSize(S); ++I) {
+                if (Segment[I].load(std::memory_order_relaxed) != nullptr) {
+                    res += sizeof(ListNode);
+                }
+            }
+        }
+        return res;
     }
 
     /** @brief Create a fresh node initialized with the given value and a
@@ -173,7 +222,7 @@ public:
      * The ownership of the returned node given to the caller.
      */
     node_type node(const T& V) {
-        BucketList* BL = new BucketList(Key{}, V, nullptr);
+        BucketList* BL = new BucketList(Key{}, V);
         return static_cast<node_type>(BL);
     }
 
@@ -185,18 +234,24 @@ public:
      * element when the search began.
      */
     template <class K>
-    bool weakContains(const lane_id H, const K& X) const {
-        const size_t HashValue = Hasher(X);
-        const auto Guard = Lanes.guard(H);
-        const size_t Bucket = HashValue % BucketCount;
+    bool weakContains(const lane_id, const K& X) const {
+        const std::uint64_t HashValue = mix(Hasher(X));
+        const std::uint64_t SoKey = elementKey(HashValue);
+
+        // start from the closest initialized bucket, without initializing the bucket of the key
+        std::size_t Bucket = HashValue & (BucketCount.load(std::memory_order_acquire) - 1);
+        ListNode* L = loadBucket(Bucket);
+        while (L == nullptr) {
+            Bucket = parent(Bucket);
+            L = loadBucket(Bucket);
+        }
 
-        BucketList* L = Buckets[Bucket].load(std::memory_order_acquire);
-        while (L != nullptr) {
-            if (EqualTo(L->Value.first, X)) {
+        while (L != nullptr && L->SoKey <= SoKey) {
+            if (L->SoKey == SoKey && EqualTo(static_cast<BucketList*>(L)->Value.first, X)) {
                 // found the key
                 return true;
             }
-            L = L->Next;
+            L = L->Next.load(std::memory_order_acquire);
         }
         return false;
     }
@@ -239,224 +294,220 @@ public:
      *
      */
     template <class... Args>
-    std::pair<const value_type*, bool> get(const lane_id H, const node_type N, Args&&... Xs) {
+    std::pair<const value_type*, bool> get(const lane_id, const node_type N, Args&&... Xs) {
         // At any time a concurrent lane may insert the key before this lane.
         //
         // The synchronisation point is the atomic compare-and-exchange of the
-        // head of the bucket list that must contain the inserted node.
+        // link of the list node that must precede the inserted node.
         //
         // The insertion algorithm is as follow:
         //
-        // 1) Compute the key hash from Xs.
-        //
-        // 2) Lock the lane, that also prevent concurrent lanes from growing of
-        // the datastructure.
-        //
-        // 3) Determine the bucket where the element must be inserted.
+        // 1) Compute the key hash from Xs, and its split-order key.
         //
-        // 4) Read the "last known head" of the bucket list. Other lanes
-        // inserting in the same bucket may update the bucket head
-        // concurrently.
+        // 2) Determine the bucket of the hash, initializing it if no lane
+        // accessed it yet, and start from the dummy node of the bucket.
         //
-        // 5) Search the bucket list for the key by comparing with Xs starting
-        // from the last known head. If it is not the first round of search,
-        // then stop searching where the previous round of search started.
+        // 3) Search the list for the key by comparing with Xs the elements
+        // with the same split-order key, until reaching a greater one.
         //
-        // 6) If the key is found return the couple of the value pointer and
+        // 4) If the key is found return the couple of the value pointer and
         // false (to indicate that this lane did not insert the node N).
         //
-        // 7) It the key is not found prepare N for insertion by updating its
-        // key with Xs and chaining the last known head.
+        // 5) If the key is not found prepare N for insertion by updating its
+        // key with Xs and chaining the first greater node.
         //
-        // 8) Try to exchange to last known head with N at the bucket head. The
-        // atomic compare and exchange operation guarantees that it only
-        // succeed if not other node was inserted in the bucket since we
-        // searched it, otherwise it fails when another lane has concurrently
-        // inserted a node in the same bucket.
+        // 6) Try to exchange the link of the preceding node with N. The atomic
+        // compare and exchange operation only succeeds if no other node was
+        // inserted at this position since we searched it.
         //
-        // 9) If the atomic compare and exchange succeeded, the node has just
-        // been inserted by this lane. From now-on other lanes can also see
-        // the node. Return the couple of a pointer to the inserted value and
-        // the true boolean.
+        // 7) If the atomic compare and exchange succeeded, the node has just
+        // been inserted by this lane. Return the couple of a pointer to the
+        // inserted value and the true boolean.
         //
-        // 10) If the atomic compare and exchange failed, another node has been
-        // inserted by a concurrent lane in the same bucket. A new round of
-        // search is required -> restart from step 4.
+        // 8) If the atomic compare and exchange failed, another node has been
+        // inserted concurrently after the preceding node. Nodes are never
+        // removed, hence the search resumes from the preceding node -> restart
+        // from step 3.
         //
         //
-        // The datastructure is optionaly grown after step 9) before returning.
-
-        const value_type* Value = nullptr;
-        bool Inserted = false;
-
-        size_t NewSize;
+        // The number of buckets is optionaly doubled after step 7) before returning.
 
         // 1)
-        const size_t HashValue = Hasher(std::forward<Args>(Xs)...);
+        const std::uint64_t HashValue = mix(Hasher(std::forward<Args>(Xs)...));
+        const std::uint64_t SoKey = elementKey(HashValue);
 
         // 2)
-        Lanes.lock(H);  // prevent the datastructure from growing
-
-        // 3)
-        const size_t Bucket = HashValue % BucketCount;
+        ListNode* Prev = bucket(HashValue & (BucketCount.load(std::memory_order_acquire) - 1));
 
-        // 4)
-        // the head of the bucket's list last time we checked
-        BucketList* LastKnownHead = Buckets[Bucket].load(std::memory_order_acquire);
-        // the head of the bucket's list we already searched from
-        BucketList* SearchedFrom = nullptr;
         // the node we want to insert
         BucketList* const Node = static_cast<BucketList*>(N);
+        bool KeyConstructed = false;
 
-        // Loop until either the node is inserted or the key is found in the bucket.
-        // Assuming bucket collisions are rare this loop is not executed more than once.
+        // Loop until either the node is inserted or the key is found.
+        // Assuming concurrent insertions next to each other are rare this loop is not executed more
+        // than once.
         while (true) {
-            // 5)
-            // search the key in the bucket, stop where we already search at a
-            // previous iteration.
-            BucketList* L = LastKnownHead;
-            while (L != SearchedFrom) {
-                if (EqualTo(L->Value.first, std::forward<Args>(Xs)...)) {
-                    // 6)
+            // 3)
+            ListNode* Cur = Prev->Next.load(std::memory_order_acquire);
+            while (Cur != nullptr && Cur->SoKey <= SoKey) {
+                if (Cur->SoKey == SoKey &&
+                        EqualTo(static_cast<BucketList*>(Cur)->Value.first, std::forward<Args>(Xs)...)) {
+                    // 4)
                     // Found the key, no need to insert.
                     // Although it's not strictly necessary, clear the node
                     // chaining to avoid leaving a dangling pointer there.
-                    Value = &(L->Value);
-                    Node->Next = nullptr;
-                    goto Done;
+                    Node->Next.store(nullptr, std::memory_order_relaxed);
+                    return std::make_pair(&(static_cast<BucketList*>(Cur)->Value), false);
                 }
-                L = L->Next;
+                Prev = Cur;
+                Cur = Cur->Next.load(std::memory_order_acquire);
             }
-            SearchedFrom = LastKnownHead;
-
-            // 7)
-            // Not found in bucket, prepare node chaining.
-            Node->Next = LastKnownHead;
-            // The factory step could be done only once, but assuming bucket collisions are
-            // rare this whole loop is not executed more than once.
-            Factory.replace(const_cast<key_type&>(Node->Value.first), std::forward<Args>(Xs)...);
-
-            // 8)
-            // Try to insert the key in front of the bucket's list.
-            // This operation also performs step 4) because LastKnownHead is
-            // updated in the process.
-            if (Buckets[Bucket].compare_exchange_strong(
-                        LastKnownHead, Node, std::memory_order_release, std::memory_order_relaxed)) {
-                // 9)
-                Inserted = true;
-                NewSize = ++Size;
-                Value = &(Node->Value);
-                goto AfterInserted;
+
+            // 5)
+            if (!KeyConstructed) {
+                Factory.replace(const_cast<key_type&>(Node->Value.first), std::forward<Args>(Xs)...);
+                Node->SoKey = SoKey;
+                KeyConstructed = true;
             }
+            Node->Next.store(Cur, std::memory_order_relaxed);
 
-            // 10) concurrent insertion detected in this bucket, new round required.
-        }
+            // 6)
+            if (Prev->Next.compare_exchange_strong(
+                        Cur, Node, std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
 
-    AfterInserted : {
-        if (NewSize > MaxSizeBeforeGrow) {
-            tryGrow(H);
+            // 8) concurrent insertion detected after the preceding node, new round required.
         }
-    }
-
-    Done:
-
-        Lanes.unlock(H);
 
-        // 6,9)
-        return std::make_pair(Value, Inserted);
+        // 7)
+        const std::size_t NewSize = ++Size;
+        std::size_t Count = BucketCount.load(std::memory_order_relaxed);
+        if ((double)NewSize > (double)Count * LoadFactor && Count < MaxBucketCount) {
+            // a concurrent lane may have grown the map already, in which case the exchange fails
+            BucketCount.compare_exchange_strong(Count, Count << 1, std::memory_order_release);
+        }
+        return std::make_pair(&(Node->Value), true);
     }
 
 private:
-    // The concurrent lanes manager.
-    LanesPolicy Lanes;
-
     /// Hash function.
     Hash Hasher;
 
-    /// Current number of buckets.
-    std::size_t BucketCount;
-
-    /// Atomic pointer to head bucket linked-list head.
-    std::unique_ptr<std::atomic<BucketList*>[]> Buckets;
-
     /// The Equal-to function.
     KeyEqual EqualTo;
 
     KeyFactory Factory;
 
+    /// Current number of buckets, a power of two.
+    std::atomic<std::size_t> BucketCount;
+
+    /// The segments of the bucket directory, each bucket points to its dummy node once initialized.
+    std::array<std::atomic<std::atomic<ListNode*>*>, MaxSegments> Segments;
+
     /// Current number of elements stored in the map.
     std::atomic<std::size_t> Size;
 
-    /// Maximum size before the map should grow.
-    std::size_t MaxSizeBeforeGrow;
-
     /// The load-factor of the map.
     double LoadFactor;
 
-    // Grow the datastructure.
-    // Must be called while owning lane H.
-    bool tryGrow(const lane_id H) {
-        Lanes.beforeLockAllBut(H);
+    // Spread the hash over all bits, since buckets are selected by its lowest bits.
+    static std::uint64_t mix(std::uint64_t H) {
+        H ^= H >> 33;
+        H *= 0xff51afd7ed558ccdULL;
+        H ^= H >> 33;
+        H *= 0xc4ceb9fe1a85ec53ULL;
+        H ^= H >> 33;
+        return H;
+    }
 
-        if (Size <= MaxSizeBeforeGrow) {
-            // Current size is fine
-            Lanes.beforeUnlockAllBut(H);
-            return false;
-        }
+    static std::uint64_t reverse(std::uint64_t X) {
+        X = ((X >> 1) & 0x5555555555555555ULL) | ((X & 0x5555555555555555ULL) << 1);
+        X = ((X >> 2) & 0x3333333333333333ULL) | ((X & 0x3333333333333333ULL) << 2);
+        X = ((X >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((X & 0x0f0f0f0f0f0f0f0fULL) << 4);
+        return __builtin_bswap64(X);
+    }
 
-        Lanes.lockAllBut(H);
-
-        {  // safe section
-
-            // Compute the new number of buckets:
-            // Chose a prime number of buckets that ensures the desired load factor
-            // given the current number of elements in the map.
-            const std::size_t CurrentSize = Size;
-            const std::size_t NeededBucketCount = std::ceil((double)CurrentSize / LoadFactor);
-            std::size_t NewBucketCount = NeededBucketCount;
-            for (std::size_t I = 0; I < details::ToPrime.size(); ++I) {
-                const uint64_t N = details::ToPrime[I].first;
-                const uint64_t K = details::ToPrime[I].second;
-                const uint64_t Prime = (1UL << N) - K;
-                if (Prime >= NeededBucketCount) {
-                    NewBucketCount = Prime;
-                    break;
-                }
-            }
+    // The split-order key of an element, odd such that it follows the dummy node of its bucket.
+    static std::uint64_t elementKey(const std::uint64_t HashValue) {
+        return reverse(HashValue | HighBit);
+    }
 
-            std::unique_ptr<std::atomic<BucketList*>[]> NewBuckets =
-                    std::make_unique<std::atomic<BucketList*>[]>(NewBucketCount);
-
-            // Rehash, this operation is costly because it requires to scan
-            // the existing elements, compute its hash to find its new bucket
-            // and insert in the new bucket.
-            //
-            // Maybe concurrent lanes could help using some job-stealing algorithm.
-            //
-            // Use relaxed memory ordering since the whole operation takes place
-            // in a critical section.
-            for (std::size_t B = 0; B < BucketCount; ++B) {
-                BucketList* L = Buckets[B].load(std::memory_order_relaxed);
-                while (L) {
-                    BucketList* const Elem = L;
-                    L = L->Next;
-
-                    const auto& Value = Elem->Value;
-                    std::size_t NewHash = Hasher(Value.first);
-                    const std::size_t NewBucket = NewHash % NewBucketCount;
-                    Elem->Next = NewBuckets[NewBucket].load(std::memory_order_relaxed);
-                    NewBuckets[NewBucket].store(Elem, std::memory_order_relaxed);
-                }
+    static bool isElement(const ListNode* L) {
+        return (L->SoKey & 1) != 0;
+    }
+
+    // The bucket that the given bucket was split from, i.e. without its most significant bit.
+    static std::size_t parent(const std::size_t Bucket) {
+        return Bucket & ~(HighBit >> __builtin_clzll(Bucket));
+    }
+
+    // The segment of the directory holding the given bucket, and the position within the segment.
+    static std::pair<std::size_t, std::size_t> segmentOf(const std::size_t Bucket) {
+        const std::uint64_t Pos = Bucket + FirstSegmentSize;
+        const std::size_t Segment = 63 - __builtin_clzll(Pos) - FirstSegmentBits;
+        return {Segment, Pos - (FirstSegmentSize << Segment)};
+    }
+
+    static std::size_t segmentSize(const std::size_t Segment) {
+        return FirstSegmentSize << Segment;
+    }
+
+    // The dummy node of the given bucket, or null if the bucket is not initialized.
+    ListNode* loadBucket(const std::size_t Bucket) const {
+        const auto [Segment, Offset] = segmentOf(Bucket);
+        const std::atomic<ListNode*>* Slots = Segments[Segment].load(std::memory_order_acquire);
+        return Slots == nullptr ? nullptr : Slots[Offset].load(std::memory_order_acquire);
+    }
+
+    // The directory entry of the given bucket, allocating its segment if necessary.
+    std::atomic<ListNode*>& bucketSlot(const std::size_t Bucket) {
+        const auto [Segment, Offset] = segmentOf(Bucket);
+        std::atomic<ListNode*>* Slots = Segments[Segment].load(std::memory_order_acquire);
+        if (Slots == nullptr) {
+            auto* Fresh = new std::atomic<ListNode*>[segmentSize(Segment)]();
+            if (Segments[Segment].compare_exchange_strong(
+                        Slots, Fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                Slots = Fresh;
+            } else {
+                delete[] Fresh;
             }
+        }
+        return Slots[Offset];
+    }
 
-            Buckets = std::move(NewBuckets);
-            BucketCount = NewBucketCount;
-            MaxSizeBeforeGrow = ((double)NewBucketCount * LoadFactor);
+    // The dummy node of the given bucket, initializing the bucket if necessary.
+    ListNode* bucket(const std::size_t Bucket) {
+        std::atomic<ListNode*>& Slot = bucketSlot(Bucket);
+        ListNode* Dummy = Slot.load(std::memory_order_acquire);
+        if (Dummy != nullptr) {
+            return Dummy;
         }
 
-        Lanes.beforeUnlockAllBut(H);
-        Lanes.unlockAllBut(H);
-        return true;
+        // insert the dummy node into the list of the parent bucket, which holds the elements of the bucket
+        ListNode* Prev = bucket(parent(Bucket));
+        ListNode* const Fresh = new ListNode(reverse(Bucket));
+        while (true) {
+            ListNode* Cur = Prev->Next.load(std::memory_order_acquire);
+            while (Cur != nullptr && Cur->SoKey < Fresh->SoKey) {
+                Prev = Cur;
+                Cur = Cur->Next.load(std::memory_order_acquire);
+            }
+            if (Cur != nullptr && Cur->SoKey == Fresh->SoKey) {
+                // a concurrent lane initialized the bucket
+                delete Fresh;
+                Dummy = Cur;
+                break;
+            }
+            Fresh->Next.store(Cur, std::memory_order_relaxed);
+            if (Prev->Next.compare_exchange_strong(
+                        Cur, Fresh, std::memory_order_release, std::memory_order_relaxed)) {
+                Dummy = Fresh;
+                break;
+            }
+        }
+        Slot.store(Dummy, std::memory_order_release);
+        return Dummy;
     }
 };
 
@@ -34,6 +34,7 @@
 #include <shared_mutex>
 #include <stdexcept>
 #include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -91,6 +92,16 @@ public:
         return insert(tuple[0], tuple[1], hints);
     };
 
+    /**
+     * Insert the tuple symbolically.
+     * @param tuple The tuple to be inserted
+     * @param hints the hints to where the pair should be inserted (not applicable atm)
+     * @return true if the tuple is new to the data structure
+     */
+    bool insert(const TupleType& tuple, operation_hints& hints) {
+        return insert(tuple[0], tuple[1], hints);
+    };
+
     /**
      * Insert the two values symbolically as a binary relation
      * @param x node to be added/paired
@@ -99,11 +110,27 @@ public:
      * @return true if the pair is new to the data structure
      */
     bool insert(value_type x, value_type y, operation_hints) {
+        // pairs already implied by the relation leave the cached partition intact
+        if (!sds.unionNodes(x, y)) {
+            return true;
+        }
         // indicate that iterators will have to generate on request
         this->statesMapStale.store(true, std::memory_order_relaxed);
-        bool retval = contains(x, y);
-        sds.unionNodes(x, y);
-        return retval;
+        return false;
+    }
+
+    /**
+     * Insert all the given pairs, uniting their elements in parallel.
+     * @param pairs the pairs to be inserted
+     */
+    void insertAll(const std::vector<std::pair<value_type, value_type>>& pairs) {
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < pairs.size(); ++i) {
+            this->sds.unionNodes(pairs[i].first, pairs[i].second);
+        }
+        PARALLEL_END
+        // invalidate iterators unconditionally
+        this->statesMapStale.store(true, std::memory_order_relaxed);
     }
 
     /**
@@ -114,8 +141,10 @@ public:
         other.genAllDisjointSetLists();
 
         // iterate over partitions at a time
-        for (typename StatesMap::chunk it : other.equivalencePartition.getChunks(MAX_THREADS)) {
-            for (auto& p : it) {
+        auto chunks = other.equivalencePartition.getChunks(MAX_THREADS);
+        PARALLEL_START
+        pfor(std::size_t c = 0; c < chunks.size(); ++c) {
+            for (auto& p : chunks[c]) {
                 value_type rep = p.first;
                 StatesList& pl = *p.second;
                 const std::size_t ksize = pl.size();
@@ -124,6 +153,7 @@ public:
                 }
             }
         }
+        PARALLEL_END
         // invalidate iterators unconditionally
         this->statesMapStale.store(true, std::memory_order_relaxed);
     }
@@ -136,23 +166,20 @@ public:
      * contains explicitly new knowledge. After this operation the "implicitly
      * new tuples" are now explicitly inserted this relation, and all of the new
      * tuples in this relation are inserted into the old relation.
+     *
+     * Only the sets of the old relation touched by the new knowledge are visited, through the
+     * cycles of their elements, hence the work is proportional to the new knowledge and the sets it
+     * changes rather than to the domain of the old relation. Many touched sets are added in parallel.
      */
     void extendAndInsert(EquivalenceRelation<TupleType>& other) {
-        if (other.size() == 0 && this->size() == 0) return;
+        if (other.empty() && this->empty()) return;
 
+        // The representatives of the sets of other touched by this relation, and the elements of
+        // this relation with their representatives, which get inserted into other after extending
+        // this relation by the touched sets.
         std::unordered_set<value_type> repsCovered;
-
-        // This vector holds all of the elements of this equivalence relation
-        // that aren't yet in other, which get inserted after extending this
-        // relation by other. These operations are interleaved for maximum
-        // efficiency - either extend or inserting first would make the other
-        // operation unnecessarily slow.
+        std::vector<value_type> touched;
         std::vector<std::pair<value_type, value_type>> toInsert;
-        auto size = std::distance(this->sds.sparseToDenseMap.begin(), this->sds.sparseToDenseMap.end());
-        toInsert.reserve(size);
-
-        // find all the disjoint sets that need to be added to this relation
-        // that exist in other (and exist in this)
         {
             auto it = this->sds.sparseToDenseMap.begin();
             auto end = this->sds.sparseToDenseMap.end();
@@ -161,40 +188,31 @@ public:
                 std::tie(el, std::ignore) = *it;
                 if (other.containsElement(el)) {
                     value_type rep = other.sds.findNode(el);
-                    if (repsCovered.count(rep) == 0) {
-                        repsCovered.emplace(rep);
+                    if (repsCovered.insert(rep).second) {
+                        touched.push_back(rep);
                     }
                 }
                 toInsert.emplace_back(el, this->sds.findNode(el));
             }
         }
-        assert(size >= 0);
-        assert(toInsert.size() == (std::size_t)size);
 
-        // add the intersecting dj sets into this one
-        {
-            value_type el;
-            value_type rep;
-            auto it = other.sds.sparseToDenseMap.begin();
-            auto end = other.sds.sparseToDenseMap.end();
-            for (; it != end; ++it) {
-                std::tie(el, std::ignore) = *it;
-                rep = other.sds.findNode(el);
-                if (repsCovered.count(rep) != 0) {
-                    this->insert(el, rep);
-                }
+        // add the touched sets of other into this one
+        if (touched.size() < MIN_PARALLEL_EXTEND_SETS) {
+            for (value_type rep : touched) {
+                other.sds.forEachInSet(rep, [&](value_type el) { this->sds.unionNodes(el, rep); });
+            }
+        } else {
+            PARALLEL_START
+            pfor(std::size_t i = 0; i < touched.size(); ++i) {
+                const value_type rep = touched[i];
+                other.sds.forEachInSet(rep, [&](value_type el) { this->sds.unionNodes(el, rep); });
             }
+            PARALLEL_END
         }
+        this->statesMapStale.store(true, std::memory_order_relaxed);
 
         // Insert all new tuples from this relation into the old relation
-        {
-            value_type el;
-            value_type rep;
-            for (std::pair<value_type, value_type> p : toInsert) {
-                std::tie(el, rep) = p;
-                other.insert(el, rep);
-            }
-        }
+        other.insertAll(toInsert);
     }
 
     /**
@@ -227,6 +245,7 @@ public:
         this->statesMapStale.store(true, std::memory_order_relaxed);
 
         equivalencePartition.clear();
+        cachedNodes = 0;
     }
 
     /**
@@ -613,7 +632,27 @@ public:
      * Check emptiness.
      */
     bool empty() const {
-        return this->size() == 0;
+        // every element is at least paired with itself
+        return sds.size() == 0;
+    }
+
+    /**
+     * Number of bytes allocated by the relation, i.e., by its disjoint set and by the lists of the
+     * elements of each disjoint set
+     */
+    std::size_t getMemoryUsage() const {
+        genAllDisjointSetLists();
+
+        statesLock.lock_shared();
+
+        std::size_t res = sizeof(*this) - sizeof(sds) - sizeof(equivalencePartition) + sds.getMemoryUsage() +
+                          equivalencePartition.getMemoryUsage();
+        for (auto& e : this->equivalencePartition) {
+            res += e.second->getMemoryUsage();
+        }
+
+        statesLock.unlock_shared();
+        return res;
     }
 
     /**
@@ -726,6 +765,9 @@ protected:
     }
 
 private:
+    // the number of touched sets from which extendAndInsert() adds the sets in parallel
+    static constexpr std::size_t MIN_PARALLEL_EXTEND_SETS = 256;
+
     // marked as mutable due to difficulties with the const enforcement via the Relation API
     // const operations *may* safely change internal state (i.e. collapse djset forest)
     mutable souffle::SparseDisjointSet<value_type> sds;
@@ -736,10 +778,16 @@ private:
     mutable StatesMap equivalencePartition;
     // whether the cache is stale
     mutable std::atomic<bool> statesMapStale;
+    // number of elements of the disjoint set covered by the cache
+    mutable std::size_t cachedNodes = 0;
 
     /**
      * Generate a cache of the sets such that they can be iterated over efficiently.
      * Each set is partitioned into a PiggyList.
+     *
+     * The cache is updated incrementally: the sets already cached are re-keyed by their current
+     * representative, merging sets that have been united since, and only the elements created
+     * since the last update are looked up and appended.
      */
     void genAllDisjointSetLists() const {
         statesLock.lock();
@@ -750,23 +798,48 @@ private:
             return;
         }
 
-        // btree version
-        emptyPartition();
+        // re-key the cached sets, appending the smaller of two merged sets to the larger one
+        std::unordered_map<value_type, StatesBucket> sets;
+        sets.reserve(equivalencePartition.size());
+        for (auto& p : equivalencePartition) {
+            auto res = sets.emplace(this->sds.findNode(p.first), p.second);
+            if (!res.second) {
+                StatesBucket into = res.first->second;
+                StatesBucket from = p.second;
+                if (into->size() < from->size()) {
+                    std::swap(into, from);
+                    res.first->second = into;
+                }
+                const std::size_t fsize = from->size();
+                for (std::size_t i = 0; i < fsize; ++i) {
+                    into->append(from->get(i));
+                }
+                delete from;
+            }
+        }
 
+        // add the elements created since the last update
         std::size_t dSetSize = this->sds.ds.a_blocks.size();
-        for (std::size_t i = 0; i < dSetSize; ++i) {
+        for (std::size_t i = cachedNodes; i < dSetSize; ++i) {
             typename TupleType::value_type sparseVal = this->sds.toSparse(i);
-            parent_t rep = this->sds.findNode(sparseVal);
+            StatesBucket& mapList = sets[this->sds.findNode(sparseVal)];
+            if (mapList == nullptr) {
+                mapList = new StatesList(1);
+            }
+            mapList->append(sparseVal);
+        }
 
-            StorePair p = {static_cast<value_type>(rep), nullptr};
-            StatesList* mapList = equivalencePartition.insert(p, [&](StorePair& sp) {
-                auto* r = new StatesList(1);
-                sp.second = r;
-                return r;
+        // btree version
+        equivalencePartition.clear();
+        for (auto& set : sets) {
+            StorePair p = {set.first, nullptr};
+            equivalencePartition.insert(p, [&](StorePair& sp) {
+                sp.second = set.second;
+                return set.second;
             });
-            mapList->append(sparseVal);
         }
 
+        cachedNodes = dSetSize;
         statesMapStale.store(false, std::memory_order_release);
         statesLock.unlock();
     }
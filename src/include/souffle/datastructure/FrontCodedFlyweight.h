@@ -0,0 +1,435 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FrontCodedFlyweight.h
+ *
+ * A flyweight of strings storing them front coded, a compact alternative
+ * to the concurrent flyweight of the symbol table for many strings
+ * sharing prefixes, e.g., paths and URLs.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Assigns consecutive indices to the strings inserted into it, storing the strings front coded.
+ *
+ * The strings are coded in buckets of consecutive indices: the first string of a bucket is stored
+ * in full, each following string as the length of the prefix it shares with its predecessor and
+ * its remaining suffix. The buckets are stored contiguously in pages which never move, and the
+ * position of each bucket in an index of blocks of doubling size. The indices of the strings are
+ * found by an open-addressing hash table of indices, which decodes the candidates it compares.
+ *
+ * Fetching a string is lock-free and decodes it into a buffer of the calling thread, which remains
+ * valid until the thread fetches DECODE_BUFFERS further strings. Insertions and lookups are
+ * serialised by a lock.
+ */
+class FrontCodedFlyweight {
+public:
+    using index_type = std::size_t;
+
+    /** Number of strings of a bucket */
+    static constexpr std::size_t BUCKET_SIZE = 16;
+
+    /** Number of buffers of a thread holding the strings it fetched */
+    static constexpr std::size_t DECODE_BUFFERS = 16;
+
+    /** Iterator on the strings and their indices */
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string, index_type>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        Iterator(const FrontCodedFlyweight* flyweight, index_type index)
+                : flyweight(flyweight), index(index) {}
+
+        value_type operator*() const {
+            return {flyweight->fetch(index), index};
+        }
+
+        Iterator& operator++() {
+            ++index;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator res = *this;
+            ++index;
+            return res;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index == other.index;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return index != other.index;
+        }
+
+    private:
+        const FrontCodedFlyweight* flyweight;
+        index_type index;
+    };
+
+    using iterator = Iterator;
+
+    /** Create a flyweight for the given number of strings; the lanes are ignored since writers lock */
+    explicit FrontCodedFlyweight(const std::size_t /* laneCount */, const std::size_t initialCapacity = 8)
+            : pages(std::make_unique<std::atomic<char*>[]>(MAX_PAGES)),
+              pageSizes(std::make_unique<std::size_t[]>(MAX_PAGES)) {
+        for (std::size_t i = 0; i < MAX_PAGES; ++i) {
+            pages[i].store(nullptr, std::memory_order_relaxed);
+        }
+        for (auto& block : buckets) {
+            block.store(nullptr, std::memory_order_relaxed);
+        }
+        reserve(initialCapacity);
+    }
+
+    FrontCodedFlyweight(const FrontCodedFlyweight&) = delete;
+    FrontCodedFlyweight& operator=(const FrontCodedFlyweight&) = delete;
+
+    ~FrontCodedFlyweight() {
+        for (std::size_t i = 0; i < pageCount; ++i) {
+            delete[] pages[i].load(std::memory_order_relaxed);
+        }
+        for (auto& block : buckets) {
+            delete[] block.load(std::memory_order_relaxed);
+        }
+    }
+
+    /** The strings are inserted under a lock rather than by lanes */
+    void setNumLanes(const std::size_t) {}
+
+    iterator begin() const {
+        return Iterator(this, 0);
+    }
+
+    iterator end() const {
+        return Iterator(this, size());
+    }
+
+    std::size_t size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+    /** Return the number of bytes allocated by the flyweight, including its strings */
+    std::size_t getMemoryUsage() const {
+        std::lock_guard<std::mutex> guard(lock);
+        std::size_t res = sizeof(*this) + MAX_PAGES * (sizeof(std::atomic<char*>) + sizeof(std::size_t)) +
+                          table.capacity() * sizeof(std::uint64_t) + last.capacity();
+        for (std::size_t i = 0; i < pageCount; ++i) {
+            res += pageSizes[i];
+        }
+        for (std::size_t b = 0; b < buckets.size(); ++b) {
+            if (buckets[b].load(std::memory_order_relaxed) != nullptr) {
+                res += (FIRST_BLOCK_SIZE << b) * sizeof(std::uint64_t);
+            }
+        }
+        return res;
+    }
+
+    /** Exchange the strings of two flyweights; do not use while threads are using either flyweight */
+    void swap(FrontCodedFlyweight& other) {
+        pages.swap(other.pages);
+        pageSizes.swap(other.pageSizes);
+        std::swap(pageCount, other.pageCount);
+        std::swap(pageUsed, other.pageUsed);
+        for (std::size_t b = 0; b < buckets.size(); ++b) {
+            buckets[b] = other.buckets[b].exchange(buckets[b].load(std::memory_order_relaxed));
+        }
+        std::swap(bucketBegin, other.bucketBegin);
+        std::swap(bucketBytes, other.bucketBytes);
+        last.swap(other.last);
+        count = other.count.exchange(count.load(std::memory_order_relaxed));
+        table.swap(other.table);
+    }
+
+    /** Prepare the hash table for the given total number of strings */
+    void reserve(const std::size_t capacity) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::size_t slots = 16;
+        while (slots < 2 * capacity) {
+            slots *= 2;
+        }
+        if (slots > table.size()) {
+            rehash(slots);
+        }
+    }
+
+    bool weakContains(std::string_view str) const {
+        std::lock_guard<std::mutex> guard(lock);
+        return find(str, fragment(str)).second;
+    }
+
+    /** Return the string of the given index, decoded into a buffer of the calling thread */
+    const std::string& fetch(const index_type index) const {
+        thread_local std::array<std::string, DECODE_BUFFERS> buffers;
+        thread_local std::size_t next = 0;
+        std::string& buffer = buffers[next++ % DECODE_BUFFERS];
+        decode(index, buffer);
+        return buffer;
+    }
+
+    /**
+     * Return the index of the given string and whether the string was inserted by this call, inserting
+     * the string with the next index if it is not in the flyweight yet.
+     */
+    std::pair<index_type, bool> findOrInsert(std::string_view str) {
+        std::lock_guard<std::mutex> guard(lock);
+        return insert(str);
+    }
+
+    /** Insert each string of the range [first, last) and write its index to out, taking the lock once */
+    template <class InputIt, class OutputIt>
+    void findOrInsertAll(InputIt first, InputIt last, OutputIt out) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (; first != last; ++first, ++out) {
+            *out = insert(std::string_view(*first)).first;
+        }
+    }
+
+private:
+    /** Size of the first pages, which double in size up to the size of the following pages */
+    static constexpr std::size_t FIRST_PAGE_SIZE = std::size_t(1) << 16;
+    static constexpr std::size_t MAX_PAGE_SIZE = std::size_t(1) << 24;
+
+    /** Number of pages, enough for 64GiB of coded strings */
+    static constexpr std::size_t MAX_PAGES = std::size_t(1) << 12;
+
+    /** Number of bits of a position holding the offset within its page */
+    static constexpr std::size_t OFFSET_BITS = 40;
+
+    /** Number of buckets of the first block of the index of the buckets, the following blocks double */
+    static constexpr std::size_t FIRST_BLOCK_BITS = 8;
+    static constexpr std::size_t FIRST_BLOCK_SIZE = std::size_t(1) << FIRST_BLOCK_BITS;
+
+    /** The fragment of the hash of a string stored in its entry of the table, which locates the entry */
+    static std::uint32_t fragment(std::string_view str) {
+        const std::uint64_t hash = std::hash<std::string_view>()(str);
+        return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+    }
+
+    /** Return the index of a string, or the position of the free entry of the table if not found */
+    std::pair<std::size_t, bool> find(std::string_view str, std::uint32_t hash) const {
+        thread_local std::string buffer;
+        const std::size_t mask = table.size() - 1;
+        for (std::size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+            const std::uint64_t entry = table[pos];
+            if (entry == 0) {
+                return {pos, false};
+            }
+            const index_type index = static_cast<index_type>(entry & 0xffffffff) - 1;
+            if ((entry >> 32) == hash) {
+                decode(index, buffer);
+                if (buffer == str) {
+                    return {index, true};
+                }
+            }
+        }
+    }
+
+    /** Find or insert a string while holding the lock */
+    std::pair<index_type, bool> insert(std::string_view str) {
+        const std::uint32_t hash = fragment(str);
+        const auto [pos, found] = find(str, hash);
+        if (found) {
+            return {pos, false};
+        }
+        const index_type index = count.load(std::memory_order_relaxed);
+        if (index >= 0xffffffff) {
+            throw std::length_error("too many strings in front coded flyweight");
+        }
+        append(index, str);
+        table[pos] = (static_cast<std::uint64_t>(hash) << 32) | (index + 1);
+        count.store(index + 1, std::memory_order_release);
+        if (2 * (index + 1) > table.size()) {
+            rehash(2 * table.size());
+        }
+        return {index, true};
+    }
+
+    /** Move the entries of the table to a table of the given number of entries */
+    void rehash(const std::size_t slots) {
+        std::vector<std::uint64_t> fresh(slots, 0);
+        const std::size_t mask = slots - 1;
+        for (const std::uint64_t entry : table) {
+            if (entry != 0) {
+                std::size_t pos = (entry >> 32) & mask;
+                while (fresh[pos] != 0) {
+                    pos = (pos + 1) & mask;
+                }
+                fresh[pos] = entry;
+            }
+        }
+        table.swap(fresh);
+    }
+
+    /** Code the string of the given index after the string of the previous index */
+    void append(const index_type index, std::string_view str) {
+        const bool first = index % BUCKET_SIZE == 0;
+        std::size_t shared = 0;
+        if (!first) {
+            const std::size_t limit = std::min(last.size(), str.size());
+            while (shared < limit && last[shared] == str[shared]) {
+                ++shared;
+            }
+        }
+        char header[20];
+        std::size_t headerSize = writeVarint(header, shared);
+        headerSize += writeVarint(header + headerSize, str.size() - shared);
+        const std::size_t recordSize = headerSize + str.size() - shared;
+
+        if (first) {
+            bucketBegin = allocate(recordSize);
+            bucketBytes = 0;
+        } else if (pageUsed + recordSize > pageSizes[pageCount - 1]) {
+            // the bucket moves to a fresh page, readers of the old copy are not disturbed
+            const std::uint64_t moved = allocate(bucketBytes + recordSize);
+            std::memcpy(address(moved), address(bucketBegin), bucketBytes);
+            bucketBegin = moved;
+        } else {
+            pageUsed += recordSize;
+        }
+        char* record = address(bucketBegin) + bucketBytes;
+        std::memcpy(record, header, headerSize);
+        std::memcpy(record + headerSize, str.data() + shared, str.size() - shared);
+        bucketBytes += recordSize;
+        setBucket(index / BUCKET_SIZE, bucketBegin);
+        last.assign(str.data(), str.size());
+    }
+
+    /** Reserve the given number of bytes in the current page, or in a fresh page if it is full */
+    std::uint64_t allocate(const std::size_t bytes) {
+        if (pageCount == 0 || pageUsed + bytes > pageSizes[pageCount - 1]) {
+            if (pageCount == MAX_PAGES) {
+                throw std::length_error("too many pages in front coded flyweight");
+            }
+            const std::size_t size = std::max(
+                    pageCount == 0 ? FIRST_PAGE_SIZE : std::min(2 * pageSizes[pageCount - 1], MAX_PAGE_SIZE),
+                    bytes);
+            pageSizes[pageCount] = size;
+            pages[pageCount].store(new char[size], std::memory_order_release);
+            ++pageCount;
+            pageUsed = 0;
+        }
+        const std::uint64_t position = (static_cast<std::uint64_t>(pageCount - 1) << OFFSET_BITS) | pageUsed;
+        pageUsed += bytes;
+        return position;
+    }
+
+    char* address(const std::uint64_t position) const {
+        char* page = pages[position >> OFFSET_BITS].load(std::memory_order_acquire);
+        return page + (position & ((std::uint64_t(1) << OFFSET_BITS) - 1));
+    }
+
+    /** The block of the index of the buckets holding a bucket, and the position of the bucket in it */
+    static std::pair<std::size_t, std::size_t> blockOf(const std::size_t bucket) {
+        const std::uint64_t pos = static_cast<std::uint64_t>(bucket) + FIRST_BLOCK_SIZE;
+        const std::size_t block = 63 - __builtin_clzll(pos) - FIRST_BLOCK_BITS;
+        return {block, pos - (FIRST_BLOCK_SIZE << block)};
+    }
+
+    void setBucket(const std::size_t bucket, const std::uint64_t position) {
+        const auto [block, offset] = blockOf(bucket);
+        std::atomic<std::uint64_t>* positions = buckets[block].load(std::memory_order_relaxed);
+        if (positions == nullptr) {
+            positions = new std::atomic<std::uint64_t>[FIRST_BLOCK_SIZE << block]();
+            buckets[block].store(positions, std::memory_order_release);
+        }
+        positions[offset].store(position, std::memory_order_release);
+    }
+
+    /** Decode the string of the given index into the buffer by the strings preceding it in its bucket */
+    void decode(const index_type index, std::string& buffer) const {
+        const auto [block, offset] = blockOf(index / BUCKET_SIZE);
+        const std::atomic<std::uint64_t>* positions = buckets[block].load(std::memory_order_acquire);
+        assert(positions != nullptr && "index of no string");
+        const char* record = address(positions[offset].load(std::memory_order_acquire));
+        buffer.clear();
+        for (std::size_t i = index - index % BUCKET_SIZE; i <= index; ++i) {
+            const std::size_t shared = readVarint(record);
+            const std::size_t suffix = readVarint(record);
+            buffer.resize(shared);
+            buffer.append(record, suffix);
+            record += suffix;
+        }
+    }
+
+    static std::size_t writeVarint(char* out, std::size_t value) {
+        std::size_t size = 0;
+        while (value >= 0x80) {
+            out[size++] = static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out[size++] = static_cast<char>(value);
+        return size;
+    }
+
+    static std::size_t readVarint(const char*& in) {
+        std::size_t value = 0;
+        for (std::size_t shift = 0;; shift += 7) {
+            const auto byte = static_cast<unsigned char>(*in++);
+            value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                return value;
+            }
+        }
+    }
+
+    /** Serialises insertions and lookups */
+    mutable std::mutex lock;
+
+    /** The pages of the coded strings and their sizes */
+    std::unique_ptr<std::atomic<char*>[]> pages;
+    std::unique_ptr<std::size_t[]> pageSizes;
+    std::size_t pageCount = 0;
+
+    /** Number of bytes used of the last page */
+    std::size_t pageUsed = 0;
+
+    /** The positions of the buckets, in blocks allocated on demand */
+    std::array<std::atomic<std::atomic<std::uint64_t>*>, 64 - FIRST_BLOCK_BITS> buckets;
+
+    /** The position and number of bytes of the last bucket, and the last string inserted */
+    std::uint64_t bucketBegin = 0;
+    std::size_t bucketBytes = 0;
+    std::string last;
+
+    /** Number of strings, which are indexed consecutively from zero */
+    std::atomic<std::size_t> count{0};
+
+    /** The hash table of the strings: fragments of their hashes and their indices plus one, zero if free */
+    std::vector<std::uint64_t> table;
+};
+
+}  // namespace souffle
@@ -0,0 +1,246 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HashIndex.h
+ *
+ * A hash-based secondary index for relations that are only ever searched
+ * with equality constraints on a fixed set of attributes.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/Iteration.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <ostream>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A hash multiset of tuples grouped by the attributes covered by the index.
+ *
+ * The hash covers the indexed attributes of a tuple and the comparator's
+ * equal() decides whether two tuples agree on them. Lookups return all
+ * stored tuples agreeing with the given tuple, in no particular order.
+ *
+ * The index is split into shards, each guarded by its own lock, such that
+ * concurrent insertions rarely contend. Lookups do not lock and must not
+ * run concurrently with insertions.
+ */
+template <typename T, typename Hash, typename Comparator>
+class HashIndex {
+    struct Node {
+        T value;
+        std::size_t hash;
+        const Node* next;
+    };
+
+    struct Shard {
+        SpinLock lock;
+        std::deque<Node> nodes;
+        std::vector<const Node*> buckets;
+    };
+
+    static constexpr std::size_t SHARD_BITS = 6;
+    static constexpr std::size_t NUM_SHARDS = static_cast<std::size_t>(1) << SHARD_BITS;
+    static constexpr std::size_t MIN_BUCKETS = 16;
+
+public:
+    using element_type = T;
+
+    /** Nothing to remember between operations; retained for interface compatibility with btrees */
+    struct operation_hints {
+        void clear() {}
+    };
+
+    /** An iterator over the tuples agreeing with a probe tuple */
+    class iterator {
+        const HashIndex* index = nullptr;
+        const Node* node = nullptr;
+        T key{};
+        std::size_t hash = 0;
+
+        void skip() {
+            while (node != nullptr && !(node->hash == hash && index->comp.equal(node->value, key))) {
+                node = node->next;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() = default;
+
+        iterator(const HashIndex* index, const Node* node, const T& key, std::size_t hash)
+                : index(index), node(node), key(key), hash(hash) {
+            skip();
+        }
+
+        const T& operator*() const {
+            return node->value;
+        }
+
+        const T* operator->() const {
+            return &node->value;
+        }
+
+        iterator& operator++() {
+            node = node->next;
+            skip();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator res = *this;
+            ++(*this);
+            return res;
+        }
+
+        bool operator==(const iterator& other) const {
+            return node == other.node;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return node != other.node;
+        }
+    };
+
+    HashIndex(const Hash& hasher = Hash(), const Comparator& comp = Comparator())
+            : hasher(hasher), comp(comp) {}
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    /** Add a tuple; the owning relation has already made sure it is new */
+    void insert(const T& t) {
+        const std::size_t h = hashOf(t);
+        Shard& shard = shards[shardOf(h)];
+        shard.lock.lock();
+        if (shard.nodes.size() >= shard.buckets.size()) {
+            grow(shard);
+        }
+        auto& head = shard.buckets[bucketOf(h, shard.buckets.size())];
+        shard.nodes.push_back(Node{t, h, head});
+        head = &shard.nodes.back();
+        shard.lock.unlock();
+    }
+
+    void insert(const T& t, operation_hints& /* hints */) {
+        insert(t);
+    }
+
+    /** Obtain the tuples agreeing with the given tuple on the indexed attributes */
+    range<iterator> equal_range(const T& t) const {
+        const std::size_t h = hashOf(t);
+        const Shard& shard = shards[shardOf(h)];
+        if (shard.buckets.empty()) {
+            return make_range(end(), end());
+        }
+        return make_range(iterator(this, shard.buckets[bucketOf(h, shard.buckets.size())], t, h), end());
+    }
+
+    range<iterator> equal_range(const T& t, operation_hints& /* hints */) const {
+        return equal_range(t);
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    std::size_t size() const {
+        std::size_t res = 0;
+        for (const auto& shard : shards) {
+            res += shard.nodes.size();
+        }
+        return res;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            shard.nodes.clear();
+            shard.buckets.clear();
+        }
+    }
+
+    void printStats(std::ostream& out) const {
+        std::size_t buckets = 0;
+        std::size_t used = 0;
+        for (const auto& shard : shards) {
+            buckets += shard.buckets.size();
+            for (const auto* head : shard.buckets) {
+                used += (head != nullptr) ? 1 : 0;
+            }
+        }
+        out << " ---------------------------------\n";
+        out << "  Hash-Index Statistics\n";
+        out << " ---------------------------------\n";
+        out << "  Size of element:         " << sizeof(T) << " bytes\n";
+        out << "  Number of elements:      " << size() << "\n";
+        out << "  Number of shards:        " << NUM_SHARDS << "\n";
+        out << "  Number of buckets:       " << buckets << "\n";
+        out << "  Number of used buckets:  " << used << "\n";
+        out << " ---------------------------------\n";
+    }
+
+private:
+    /** Scramble the hash of a tuple, such that all of its bits select shards and buckets alike */
+    std::size_t hashOf(const T& t) const {
+        auto h = static_cast<std::uint64_t>(hasher(t));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+
+    static std::size_t shardOf(std::size_t hash) {
+        return hash & (NUM_SHARDS - 1);
+    }
+
+    /** The buckets of a shard are addressed by the hash bits not used for selecting the shard */
+    static std::size_t bucketOf(std::size_t hash, std::size_t numBuckets) {
+        return (hash >> SHARD_BITS) & (numBuckets - 1);
+    }
+
+    /** Double the number of buckets of a shard, keeping one bucket per element on average */
+    static void grow(Shard& shard) {
+        std::vector<const Node*> buckets(std::max(MIN_BUCKETS, shard.buckets.size() * 2), nullptr);
+        for (auto& node : shard.nodes) {
+            auto& head = buckets[bucketOf(node.hash, buckets.size())];
+            node.next = head;
+            head = &node;
+        }
+        shard.buckets.swap(buckets);
+    }
+
+    Hash hasher;
+
+    Comparator comp;
+
+    std::array<Shard, NUM_SHARDS> shards;
+};
+
+}  // namespace souffle
@@ -0,0 +1,433 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NodePool.h
+ *
+ * A thread-caching pool allocator for the nodes of the tree data structures.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace souffle {
+
+/**
+ * The registry of the node pools of all sizes, such that the memory they
+ * retain can be returned to the system, e.g., once relations got dropped.
+ *
+ * The registry also provides the slabs of the pools. If the environment
+ * variable SOUFFLE_HUGE_PAGES is set, the slabs are carved from arenas
+ * mapped in multiples of the huge page size and advised to be backed by
+ * transparent huge pages, such that the nodes of large relations need
+ * few TLB entries. Slabs released to such an arena are kept for the
+ * pools rather than returned to the system, so clearing and refilling
+ * relations does not fragment the heap.
+ */
+class NodePools {
+public:
+    /** The memory held by the pools */
+    struct Statistics {
+        // the bytes obtained from the system
+        std::size_t reserved = 0;
+        // the bytes of the slabs in use by the pools
+        std::size_t used = 0;
+        // the number of slabs in use by the pools
+        std::size_t slabs = 0;
+        // whether the slabs are backed by huge pages
+        bool hugePages = false;
+    };
+
+    /** Release the slabs of all pools none of whose blocks are in use */
+    static void trim() {
+        std::lock_guard<std::mutex> guard(lock());
+        for (auto trimPool : pools()) {
+            trimPool();
+        }
+    }
+
+    /** Register the trim function of a pool */
+    static void add(void (*trimPool)()) {
+        std::lock_guard<std::mutex> guard(lock());
+        pools().push_back(trimPool);
+    }
+
+    /** Whether the slabs are carved from arenas backed by huge pages */
+    static bool useHugePages() {
+#ifdef MADV_HUGEPAGE
+        static const bool res = [] {
+            const char* value = std::getenv("SOUFFLE_HUGE_PAGES");
+            return value != nullptr && std::strcmp(value, "") != 0 && std::strcmp(value, "0") != 0;
+        }();
+        return res;
+#else
+        return false;
+#endif
+    }
+
+    /** Obtain a slab of the given size for a pool */
+    static void* allocateSlab(std::size_t bytes, std::size_t alignment) {
+        Arena& a = arena();
+        std::lock_guard<std::mutex> guard(a.lock);
+        a.stats.used += bytes;
+        a.stats.slabs++;
+        if (!fromArena(alignment)) {
+            a.stats.reserved += bytes;
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        const std::size_t units = (bytes + SLAB_UNIT - 1) / SLAB_UNIT;
+        auto& free = a.free[units];
+        if (!free.empty()) {
+            void* res = free.back();
+            free.pop_back();
+            return res;
+        }
+        if (a.end - a.next < static_cast<std::ptrdiff_t>(units * SLAB_UNIT)) {
+            // keep the rest of the current region for slabs of its size
+            if (a.next != a.end) {
+                a.free[static_cast<std::size_t>(a.end - a.next) / SLAB_UNIT].push_back(a.next);
+            }
+            const std::size_t size = std::max(ARENA_REGION, units * SLAB_UNIT);
+            a.next = mapRegion(size);
+            a.end = a.next + size;
+            a.stats.reserved += size;
+        }
+        void* res = a.next;
+        a.next += units * SLAB_UNIT;
+        return res;
+    }
+
+    /** Return a slab of a pool */
+    static void releaseSlab(void* slab, std::size_t bytes, std::size_t alignment) {
+        Arena& a = arena();
+        std::lock_guard<std::mutex> guard(a.lock);
+        a.stats.used -= bytes;
+        a.stats.slabs--;
+        if (!fromArena(alignment)) {
+            a.stats.reserved -= bytes;
+            ::operator delete(slab, std::align_val_t(alignment));
+            return;
+        }
+        a.free[(bytes + SLAB_UNIT - 1) / SLAB_UNIT].push_back(slab);
+    }
+
+    /** Return the memory held by the pools */
+    static Statistics getStatistics() {
+        Arena& a = arena();
+        std::lock_guard<std::mutex> guard(a.lock);
+        Statistics res = a.stats;
+        res.hugePages = useHugePages();
+        return res;
+    }
+
+private:
+    static constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20;
+
+    /** The granularity of the slabs carved from an arena */
+    static constexpr std::size_t SLAB_UNIT = std::size_t(1) << 16;
+
+    /** The size of the regions an arena maps at once */
+    static constexpr std::size_t ARENA_REGION = 16 * HUGE_PAGE_SIZE;
+
+    struct Arena {
+        std::mutex lock;
+        // the unused part of the current region
+        char* next = nullptr;
+        char* end = nullptr;
+        // the released slabs by their number of units
+        std::map<std::size_t, std::vector<void*>> free;
+        Statistics stats;
+    };
+
+    static std::mutex& lock() {
+        static std::mutex res;
+        return res;
+    }
+
+    static std::vector<void (*)()>& pools() {
+        static std::vector<void (*)()> res;
+        return res;
+    }
+
+    /** The arena is never destroyed, such that the nodes of static objects stay valid */
+    static Arena& arena() {
+        static Arena* res = new Arena();
+        return *res;
+    }
+
+    static bool fromArena(std::size_t alignment) {
+        return useHugePages() && alignment <= SLAB_UNIT;
+    }
+
+    /** Map a region of the given size, a multiple of the slab unit, aligned to a huge page */
+    static char* mapRegion(std::size_t size) {
+#ifdef MADV_HUGEPAGE
+        const std::size_t mapped = size + HUGE_PAGE_SIZE;
+        void* ptr = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        // unmap the parts before and after the aligned region
+        char* start = static_cast<char*>(ptr);
+        char* res = reinterpret_cast<char*>(
+                (reinterpret_cast<std::uintptr_t>(start) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+        if (res != start) {
+            munmap(start, static_cast<std::size_t>(res - start));
+        }
+        const std::size_t tail = mapped - static_cast<std::size_t>(res - start) - size;
+        if (tail != 0) {
+            munmap(res + size, tail);
+        }
+        madvise(res, size, MADV_HUGEPAGE);
+        return res;
+#else
+        (void)size;
+        throw std::bad_alloc();
+#endif
+    }
+};
+
+/**
+ * A pool of fixed-size memory blocks, shared by all node types of the
+ * given size and alignment.
+ *
+ * Each thread carves its blocks from slabs it allocated itself and keeps
+ * released blocks in a thread-local free list. Allocations and releases
+ * thus neither synchronise between threads nor call into the global
+ * allocator in the common case, and the memory of the nodes a thread
+ * creates is first touched by this thread, i.e., it is placed in the
+ * NUMA domain the thread is running on.
+ *
+ * Surplus released blocks, as well as the blocks of terminated threads,
+ * are moved to a global depot from which other threads refill their free
+ * lists. Memory released by a relation is retained for the nodes created
+ * subsequently, e.g., in the next iteration of a fixpoint computation.
+ * Slabs are only released by trim(), once all their blocks are free, to
+ * the system or to the huge page arena of the registry.
+ */
+template <std::size_t Size, std::size_t Alignment>
+class NodePool {
+    struct Block {
+        Block* next;
+    };
+
+    static constexpr std::size_t ALIGNMENT = std::max(Alignment, alignof(Block));
+    static constexpr std::size_t BLOCK_SIZE =
+            (std::max(Size, sizeof(Block)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    /** The number of blocks of a slab, and of a batch of blocks exchanged with the depot */
+    static constexpr std::size_t SLAB_BLOCKS = std::max<std::size_t>(16, (1 << 16) / BLOCK_SIZE);
+
+    static constexpr std::size_t SLAB_SIZE = SLAB_BLOCKS * BLOCK_SIZE;
+
+    /** The store of surplus blocks owning all slabs */
+    struct Depot {
+        std::mutex lock;
+        Block* free = nullptr;
+        std::size_t numFree = 0;
+        std::vector<void*> slabs;
+    };
+
+    /** The blocks available to a single thread */
+    struct Cache {
+        Block* free = nullptr;
+        std::size_t numFree = 0;
+        // the unused part of the current slab
+        char* next = nullptr;
+        char* end = nullptr;
+        // set once the thread is terminating and the cache got returned to the depot
+        bool retired = false;
+    };
+
+    /** Hands the cache of a terminating thread back to the depot */
+    struct Retirer {
+        ~Retirer() {
+            Cache& c = cache();
+            for (; c.next != c.end; c.next += BLOCK_SIZE) {
+                release(c, reinterpret_cast<Block*>(c.next));
+            }
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lease(d.lock);
+            while (c.free != nullptr) {
+                Block* b = c.free;
+                c.free = b->next;
+                b->next = d.free;
+                d.free = b;
+                d.numFree++;
+            }
+            c.numFree = 0;
+            c.retired = true;
+        }
+    };
+
+    /** The depot is never destroyed, such that the nodes of static objects stay valid */
+    static Depot& depot() {
+        static Depot* res = [] {
+            NodePools::add(&trim);
+            return new Depot();
+        }();
+        return *res;
+    }
+
+    static Cache& cache() {
+        static thread_local Cache res;
+        // destroyed before the cache, which is trivially destructible and thus stays accessible
+        static thread_local Retirer retirer;
+        (void)retirer;
+        return res;
+    }
+
+    static void release(Cache& c, Block* b) {
+        b->next = c.free;
+        c.free = b;
+        c.numFree++;
+    }
+
+    /** Move a batch of blocks between the given free list and the one of the depot */
+    static void transfer(Block*& from, std::size_t& numFrom, Block*& to, std::size_t& numTo) {
+        for (std::size_t i = 0; i < SLAB_BLOCKS && from != nullptr; ++i) {
+            Block* b = from;
+            from = b->next;
+            b->next = to;
+            to = b;
+            numFrom--;
+            numTo++;
+        }
+    }
+
+    /** Refill the free list of a thread from the depot, or start a new slab if the depot is empty */
+    static void refill(Cache& c) {
+        Depot& d = depot();
+        std::lock_guard<std::mutex> lease(d.lock);
+        if (d.free != nullptr) {
+            transfer(d.free, d.numFree, c.free, c.numFree);
+            return;
+        }
+        void* slab = NodePools::allocateSlab(SLAB_SIZE, ALIGNMENT);
+        d.slabs.push_back(slab);
+        c.next = static_cast<char*>(slab);
+        c.end = c.next + SLAB_SIZE;
+    }
+
+public:
+    /** Obtain a block of memory for a node */
+    static void* allocate() {
+        Cache& c = cache();
+        // prefer blocks of this thread's own slabs
+        if (c.free == nullptr && c.next == c.end) {
+            refill(c);
+        }
+        if (c.free != nullptr) {
+            Block* b = c.free;
+            c.free = b->next;
+            c.numFree--;
+            return b;
+        }
+        void* res = c.next;
+        c.next += BLOCK_SIZE;
+        return res;
+    }
+
+    /**
+     * Return the slabs whose blocks are all free to the system
+     *
+     * The blocks of the calling thread are handed to the depot first; the
+     * blocks cached by other threads keep their slabs alive.
+     */
+    static void trim() {
+        Cache& c = cache();
+        Depot& d = depot();
+        std::lock_guard<std::mutex> lease(d.lock);
+        if (!c.retired) {
+            for (; c.next != c.end; c.next += BLOCK_SIZE) {
+                release(c, reinterpret_cast<Block*>(c.next));
+            }
+            while (c.free != nullptr) {
+                transfer(c.free, c.numFree, d.free, d.numFree);
+            }
+        }
+
+        // count the free blocks of each slab
+        std::sort(d.slabs.begin(), d.slabs.end(), std::less<void*>());
+        auto slabOf = [&](Block* b) {
+            auto it = std::upper_bound(
+                    d.slabs.begin(), d.slabs.end(), static_cast<void*>(b), std::less<void*>());
+            return static_cast<std::size_t>(it - d.slabs.begin()) - 1;
+        };
+        std::vector<std::size_t> numFree(d.slabs.size(), 0);
+        for (Block* b = d.free; b != nullptr; b = b->next) {
+            numFree[slabOf(b)]++;
+        }
+
+        // unlink the blocks of entirely free slabs and release these slabs
+        Block** link = &d.free;
+        while (*link != nullptr) {
+            if (numFree[slabOf(*link)] == SLAB_BLOCKS) {
+                *link = (*link)->next;
+                d.numFree--;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < d.slabs.size(); ++i) {
+            if (numFree[i] == SLAB_BLOCKS) {
+                NodePools::releaseSlab(d.slabs[i], SLAB_SIZE, ALIGNMENT);
+            } else {
+                d.slabs[kept++] = d.slabs[i];
+            }
+        }
+        d.slabs.resize(kept);
+    }
+
+    /** Return the number of slabs allocated by the pool */
+    static std::size_t getNumSlabs() {
+        Depot& d = depot();
+        std::lock_guard<std::mutex> lease(d.lock);
+        return d.slabs.size();
+    }
+
+    /** Return the block of a destroyed node to the pool */
+    static void deallocate(void* ptr) {
+        Cache& c = cache();
+        if (c.retired) {
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lease(d.lock);
+            auto* b = static_cast<Block*>(ptr);
+            b->next = d.free;
+            d.free = b;
+            d.numFree++;
+            return;
+        }
+        release(c, static_cast<Block*>(ptr));
+        // keep the memory of the free list bounded, other threads may need the blocks
+        if (c.numFree > 2 * SLAB_BLOCKS) {
+            Depot& d = depot();
+            std::lock_guard<std::mutex> lease(d.lock);
+            transfer(c.free, c.numFree, d.free, d.numFree);
+        }
+    }
+};
+
+}  // namespace souffle
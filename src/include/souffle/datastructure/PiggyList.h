@@ -1,5 +1,6 @@
 #pragma once
 
+#include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
 #include <array>
 #include <atomic>
@@ -8,23 +9,6 @@
 #include <iostream>
 #include <iterator>
 
-#ifdef _WIN32
-/**
- * Some versions of MSVC do not provide a builtin for counting leading zeroes
- * like gcc, so we have to implement it ourselves.
- */
-#if defined(_MSC_VER)
-unsigned long __inline __builtin_clzll(unsigned long long value) {
-    unsigned long msb = 0;
-
-    if (_BitScanReverse64(&msb, value))
-        return 63 - msb;
-    else
-        return 64;
-}
-#endif  // _MSC_VER
-#endif  // _WIN32
-
 using std::size_t;
 namespace souffle {
 
@@ -76,6 +60,17 @@ public:
         return numElements.load();
     }
 
+    /** Return the number of bytes allocated by this list */
+    std::size_t getMemoryUsage() const {
+        std::size_t res = sizeof(*this);
+        for (std::size_t i = 0; i < maxContainers; ++i) {
+            if (blockLookupTable[i].load() != nullptr) {
+                res += (INITIALBLOCKSIZE << i) * sizeof(T);
+            }
+        }
+        return res;
+    }
+
     inline T* getBlock(std::size_t blockNum) const {
         return blockLookupTable[blockNum];
     }
@@ -182,6 +177,11 @@ public:
         return m_size.load();
     };
 
+    /** Return the number of bytes allocated by this list */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) + container_size.load() * sizeof(T);
+    }
+
     inline T* getBlock(std::size_t blocknum) const {
         return this->blockLookupTable[blocknum];
     }
@@ -0,0 +1,88 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RetainedHints.h
+ *
+ * Operation hints of a relation retained by each thread across the
+ * operation contexts of consecutive queries.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <unordered_map>
+
+namespace souffle {
+
+/**
+ * Keeps the operation hints a thread used last on a relation, such that
+ * the next context the thread creates for the relation starts where the
+ * last one ended, e.g., in the next iteration of a fixpoint, rather than
+ * at the roots of the indexes.
+ *
+ * Hints refer to nodes of the indexes. Any operation freeing nodes, e.g.,
+ * clearing or compacting the relation, must invalidate the retained hints
+ * of all threads, which is done by advancing a generation counter; hints
+ * retained in an earlier generation are not restored.
+ */
+template <typename Hints>
+class RetainedHints {
+public:
+    RetainedHints() : id(nextId()) {}
+    RetainedHints(const RetainedHints&) = delete;
+    RetainedHints& operator=(const RetainedHints&) = delete;
+
+    /** Initialises the given hints with the hints retained by this thread, if still valid */
+    void restore(Hints& hints) const {
+        auto& slots = getSlots();
+        auto pos = slots.find(id);
+        if (pos != slots.end() && pos->second.generation == generation.load(std::memory_order_acquire)) {
+            hints = pos->second.hints;
+        }
+    }
+
+    /** Retains the given hints for the next context of this thread */
+    void retain(const Hints& hints) {
+        Slot& slot = getSlots()[id];
+        slot.generation = generation.load(std::memory_order_acquire);
+        slot.hints = hints;
+    }
+
+    /** Discards the hints retained by all threads */
+    void invalidate() {
+        generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+private:
+    struct Slot {
+        std::size_t generation = 0;
+        Hints hints;
+    };
+
+    // the retained hints of the current thread, by the id of the relation
+    static std::unordered_map<std::size_t, Slot>& getSlots() {
+        static thread_local std::unordered_map<std::size_t, Slot> slots;
+        return slots;
+    }
+
+    // ids are never reused, such that a new relation does not restore hints of a destroyed one
+    static std::size_t nextId() {
+        static std::atomic<std::size_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::size_t id;
+
+    std::atomic<std::size_t> generation{0};
+};
+
+}  // namespace souffle
@@ -0,0 +1,440 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ShardedSet.h
+ *
+ * Sets and multisets partitioned by the hash of a column into b-trees,
+ * one per NUMA node, each stored in the memory of its node.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/datastructure/BTree.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/NumaUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/** The largest number of shards of a sharded set, nodes beyond it share their shards */
+constexpr std::size_t sharded_set_max_shards = 8;
+
+namespace detail {
+
+/**
+ * A set or multiset partitioned into one b-tree, its shard, per NUMA node of the machine. An
+ * element is stored in the shard selected by the hash of its value in a given column, hence the
+ * elements of a given value in that column, e.g., all the tuples a search binding the column
+ * visits, are in a single shard.
+ *
+ * The nodes of b-trees are allocated by the threads inserting into them. Once the set is complete,
+ * place() rebuilds each shard on a thread running on its node, which allocates its nodes in the
+ * memory of that node; the chunks of getNodeChunks() hand the threads the elements of their own
+ * node first. On machines of a single node, the set is a single b-tree.
+ *
+ * The elements of different shards are not ordered: iterators visit the shards one after another,
+ * each in the order of its b-tree. Like the b-trees, insertions may be concurrent, but searches must
+ * not run concurrently with insertions.
+ *
+ * @tparam Key    .. the element type to be stored in this set
+ * @tparam Tree   .. the b-tree set or multiset storing the elements of a shard
+ * @tparam column .. the column of the elements selecting their shard
+ */
+template <typename Key, typename Tree, std::size_t column>
+class sharded_btree {
+    using tree_iterator = typename Tree::iterator;
+
+    /** The bounds of the elements of a range in each shard */
+    using shard_bounds = std::vector<std::pair<tree_iterator, tree_iterator>>;
+
+public:
+    using key_type = Key;
+    using element_type = Key;
+
+    /** The hints of the operations on each shard */
+    struct operation_hints {
+        typename Tree::operation_hints shard[sharded_set_max_shards];
+    };
+
+    /**
+     * An iterator over the elements of a single shard, or over the elements of all the shards, which
+     * continues in the next non-empty shard once it reaches the end of the elements of a shard
+     */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Key;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Key*;
+        using reference = const Key&;
+
+        iterator() = default;
+
+        iterator(tree_iterator cur, tree_iterator last, std::size_t shard, const sharded_btree* set = nullptr,
+                std::shared_ptr<const shard_bounds> bounds = nullptr)
+                : cur(std::move(cur)), last(std::move(last)), shard(shard), set(set),
+                  bounds(std::move(bounds)) {}
+
+        bool operator==(const iterator& other) const {
+            return shard == other.shard && cur == other.cur;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const Key& operator*() const {
+            return *cur;
+        }
+
+        const Key* operator->() const {
+            return &*cur;
+        }
+
+        iterator& operator++() {
+            ++cur;
+            if (cur == last && (set != nullptr || bounds != nullptr)) {
+                next();
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator res = *this;
+            ++*this;
+            return res;
+        }
+
+        /** Move to the first element of the next non-empty shard, or to the end of all shards */
+        iterator& next() {
+            const std::size_t numShards = set != nullptr ? set->numShards : bounds->size();
+            for (++shard; shard < numShards; ++shard) {
+                if (set != nullptr) {
+                    cur = set->shards[shard].begin();
+                    last = set->shards[shard].end();
+                } else {
+                    std::tie(cur, last) = (*bounds)[shard];
+                }
+                if (cur != last) {
+                    return *this;
+                }
+            }
+            cur = tree_iterator();
+            last = tree_iterator();
+            shard = sharded_set_max_shards;
+            return *this;
+        }
+
+    private:
+        // the position in the current shard, and the end of the elements to visit in it
+        tree_iterator cur;
+        tree_iterator last;
+
+        // the current shard, or sharded_set_max_shards at the end of all shards
+        std::size_t shard = sharded_set_max_shards;
+
+        // the set whose shards are visited in full, if any
+        const sharded_btree* set = nullptr;
+
+        // the bounds of the elements to visit in each shard, if visiting a range of all shards
+        std::shared_ptr<const shard_bounds> bounds;
+    };
+
+    using const_iterator = iterator;
+    using chunk = range<iterator>;
+
+    /**
+     * The chunks of a set, grouped by the node of their shard, which the threads take from their
+     * own node first, and from the other nodes once their node has none left
+     */
+    class node_chunks {
+    public:
+        explicit node_chunks(std::vector<std::vector<chunk>> chunks) : chunks(std::move(chunks)) {
+            for (const auto& cur : this->chunks) {
+                total += cur.size();
+            }
+        }
+
+        node_chunks(const node_chunks&) = delete;
+        node_chunks& operator=(const node_chunks&) = delete;
+
+        /** The number of chunks, each of which is to be taken exactly once */
+        std::size_t size() const {
+            return total;
+        }
+
+        /** Take a chunk not yet taken, of the node of the calling thread if there is one left */
+        chunk take() {
+            const std::size_t first = NumaTopology::instance().getCurrentNode() % chunks.size();
+            for (std::size_t i = 0; i < chunks.size(); ++i) {
+                const std::size_t shard = (first + i) % chunks.size();
+                while (next[shard].load(std::memory_order_relaxed) < chunks[shard].size()) {
+                    const std::size_t pos = next[shard].fetch_add(1, std::memory_order_relaxed);
+                    if (pos < chunks[shard].size()) {
+                        return chunks[shard][pos];
+                    }
+                }
+            }
+            // more chunks were taken than there are
+            return chunk(iterator(), iterator());
+        }
+
+    private:
+        std::vector<std::vector<chunk>> chunks;
+        std::size_t total = 0;
+
+        // the next chunk to be taken of each shard
+        std::atomic<std::size_t> next[sharded_set_max_shards] = {};
+    };
+
+    /** Create an empty set of a shard per NUMA node, or of the given number of shards */
+    explicit sharded_btree(std::size_t numShards = NumaTopology::instance().getNumNodes())
+            : numShards(std::min(std::max<std::size_t>(numShards, 1), sharded_set_max_shards)) {}
+
+    /** Return the number of shards, i.e., the number of nodes the elements are spread over */
+    std::size_t getNumShards() const {
+        return numShards;
+    }
+
+    bool empty() const {
+        for (std::size_t i = 0; i < numShards; ++i) {
+            if (!shards[i].empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t size() const {
+        std::size_t res = 0;
+        for (std::size_t i = 0; i < numShards; ++i) {
+            res += shards[i].size();
+        }
+        return res;
+    }
+
+    bool insert(const Key& k) {
+        operation_hints hints;
+        return insert(k, hints);
+    }
+
+    bool insert(const Key& k, operation_hints& hints) {
+        const std::size_t i = getShard(k);
+        return shards[i].insert(k, hints.shard[i]);
+    }
+
+    template <typename Iter>
+    void insert(const Iter& a, const Iter& b) {
+        operation_hints hints;
+        for (auto it = a; it != b; ++it) {
+            insert(*it, hints);
+        }
+    }
+
+    bool contains(const Key& k) const {
+        operation_hints hints;
+        return contains(k, hints);
+    }
+
+    bool contains(const Key& k, operation_hints& hints) const {
+        const std::size_t i = getShard(k);
+        return shards[i].contains(k, hints.shard[i]);
+    }
+
+    iterator find(const Key& k) const {
+        operation_hints hints;
+        return find(k, hints);
+    }
+
+    /** Find an element, from which iterating continues over the following elements of all shards */
+    iterator find(const Key& k, operation_hints& hints) const {
+        const std::size_t i = getShard(k);
+        auto pos = shards[i].find(k, hints.shard[i]);
+        if (pos == shards[i].end()) {
+            return end();
+        }
+        return iterator(pos, shards[i].end(), i, this);
+    }
+
+    /**
+     * Return the elements between the lower bound of the first and the upper bound of the second key,
+     * which are in a single shard if the keys agree on the column selecting the shards
+     */
+    range<iterator> lower_upper_range(const Key& lower, const Key& upper, operation_hints& hintsLower,
+            operation_hints& hintsUpper) const {
+        if (lower[column] == upper[column]) {
+            const std::size_t i = getShard(lower);
+            auto first = shards[i].lower_bound(lower, hintsLower.shard[i]);
+            auto last = shards[i].upper_bound(upper, hintsUpper.shard[i]);
+            return make_range(iterator(first, last, i), iterator(last, last, i));
+        }
+        auto bounds = std::make_shared<shard_bounds>();
+        for (std::size_t i = 0; i < numShards; ++i) {
+            bounds->emplace_back(shards[i].lower_bound(lower, hintsLower.shard[i]),
+                    shards[i].upper_bound(upper, hintsUpper.shard[i]));
+        }
+        iterator first(bounds->front().first, bounds->front().second, 0, nullptr, bounds);
+        if (bounds->front().first == bounds->front().second) {
+            first.next();
+        }
+        return make_range(first, end());
+    }
+
+    /** Count the elements between the lower bound of the first and the upper bound of the second key */
+    std::size_t countRange(const Key& lower, const Key& upper) const {
+        if (lower[column] == upper[column]) {
+            return shards[getShard(lower)].countRange(lower, upper);
+        }
+        std::size_t res = 0;
+        for (std::size_t i = 0; i < numShards; ++i) {
+            res += shards[i].countRange(lower, upper);
+        }
+        return res;
+    }
+
+    void prefetch(const Key& k) const {
+        shards[getShard(k)].prefetch(k);
+    }
+
+    iterator begin() const {
+        iterator res(shards[0].begin(), shards[0].end(), 0, this);
+        if (shards[0].empty()) {
+            res.next();
+        }
+        return res;
+    }
+
+    iterator end() const {
+        return iterator();
+    }
+
+    /** Partition the elements into about the given number of chunks, each of a single shard */
+    std::vector<chunk> getChunks(std::size_t num) const {
+        std::vector<chunk> res;
+        for (auto& cur : getShardChunks(num)) {
+            res.insert(res.end(), cur.begin(), cur.end());
+        }
+        return res;
+    }
+
+    std::vector<chunk> partition(std::size_t num) const {
+        return getChunks(num);
+    }
+
+    /** Partition the elements into about the given number of chunks, grouped by the node of their shard */
+    std::unique_ptr<node_chunks> getNodeChunks(std::size_t num) const {
+        return std::make_unique<node_chunks>(getShardChunks(num));
+    }
+
+    /**
+     * Rebuild each shard on a thread running on its node, such that its nodes are allocated in the
+     * memory of that node; the shards of nodes none of the threads runs on are rebuilt by the caller
+     */
+    void place() {
+        if (numShards == 1) {
+            return;
+        }
+        std::atomic<bool> placed[sharded_set_max_shards] = {};
+        PARALLEL_START
+            const std::size_t i = NumaTopology::instance().getCurrentNode();
+            if (i < numShards && !placed[i].exchange(true)) {
+                rebuild(i);
+            }
+        PARALLEL_END
+        for (std::size_t i = 0; i < numShards; ++i) {
+            if (!placed[i].load()) {
+                rebuild(i);
+            }
+        }
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < numShards; ++i) {
+            shards[i].clear();
+        }
+    }
+
+    void freeze() const {
+        for (std::size_t i = 0; i < numShards; ++i) {
+            shards[i].freeze();
+        }
+    }
+
+    void compact() {
+        for (std::size_t i = 0; i < numShards; ++i) {
+            shards[i].compact();
+        }
+    }
+
+    void swap(sharded_btree& other) {
+        for (std::size_t i = 0; i < sharded_set_max_shards; ++i) {
+            shards[i].swap(other.shards[i]);
+        }
+        std::swap(numShards, other.numShards);
+    }
+
+    void printStats(std::ostream& out = std::cout) const {
+        for (std::size_t i = 0; i < numShards; ++i) {
+            out << "  Shard " << i << " of " << numShards << ":\n";
+            shards[i].printStats(out);
+        }
+    }
+
+private:
+    /** Return the shard of an element, by the hash of its value in the column */
+    std::size_t getShard(const Key& k) const {
+        const auto value = static_cast<std::uint64_t>(static_cast<std::uint32_t>(k[column]));
+        return ((value * 0x9e3779b97f4a7c15ULL) >> 32) % numShards;
+    }
+
+    /** Partition the elements of each shard into chunks, about the given number in total */
+    std::vector<std::vector<chunk>> getShardChunks(std::size_t num) const {
+        std::vector<std::vector<chunk>> res(numShards);
+        const std::size_t perShard = std::max<std::size_t>(num / numShards, 1);
+        for (std::size_t i = 0; i < numShards; ++i) {
+            for (const auto& cur : shards[i].getChunks(perShard)) {
+                res[i].emplace_back(iterator(cur.begin(), cur.end(), i), iterator(cur.end(), cur.end(), i));
+            }
+        }
+        return res;
+    }
+
+    /** Rebuild a shard from its elements, allocating its nodes by the calling thread */
+    void rebuild(std::size_t i) {
+        const std::vector<Key> elements(shards[i].begin(), shards[i].end());
+        auto loaded = Tree::load(elements.begin(), elements.end());
+        shards[i].swap(loaded);
+    }
+
+    std::size_t numShards;
+
+    Tree shards[sharded_set_max_shards];
+};
+
+}  // namespace detail
+
+/**
+ * A set or multiset, as its b-trees, partitioned by the hash of a column into one b-tree per NUMA node.
+ */
+template <typename Key, typename Tree, std::size_t column>
+using sharded_set = detail::sharded_btree<Key, Tree, column>;
+
+}  // namespace souffle
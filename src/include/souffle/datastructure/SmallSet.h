@@ -0,0 +1,332 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SmallSet.h
+ *
+ * Sets and multisets of a few elements, stored in a sorted inline array
+ * until they outgrow it and move into a b-tree.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/datastructure/BTree.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace souffle {
+
+/** The number of elements a small set stores inline before it moves them into a b-tree */
+constexpr std::size_t small_set_capacity = 32;
+
+namespace detail {
+
+/**
+ * A set or multiset storing up to a given number of elements in a sorted inline array, which
+ * moves its elements into a b-tree of the same order once it outgrows the array. Searching a
+ * few elements is a binary search over contiguous memory, rather than a descent through the
+ * nodes of a tree.
+ *
+ * Insertions may be concurrent; those into the array take a lock. Like for the relations using
+ * it, searches must not run concurrently with insertions.
+ *
+ * @tparam Key        .. the element type to be stored in this set
+ * @tparam Comparator .. a class defining an order on the stored elements
+ * @tparam Tree       .. the b-tree set or multiset of the same order storing large sets
+ * @tparam isSet      .. true = set, false = multiset
+ * @tparam capacity   .. the number of elements stored inline
+ */
+template <typename Key, typename Comparator, typename Tree, bool isSet, std::size_t capacity>
+class small_btree {
+public:
+    using key_type = Key;
+    using element_type = Key;
+    using operation_hints = typename Tree::operation_hints;
+
+    /** An iterator over the inline array or over the b-tree, once the elements moved into it */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Key;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Key*;
+        using reference = const Key&;
+
+        iterator() = default;
+
+        explicit iterator(const Key* pos) : pos(pos) {}
+
+        explicit iterator(typename Tree::iterator cur) : cur(std::move(cur)) {}
+
+        bool operator==(const iterator& other) const {
+            return pos == other.pos && cur == other.cur;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+        const Key& operator*() const {
+            return pos != nullptr ? *pos : *cur;
+        }
+
+        const Key* operator->() const {
+            return &**this;
+        }
+
+        iterator& operator++() {
+            if (pos != nullptr) {
+                ++pos;
+            } else {
+                ++cur;
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator res = *this;
+            ++*this;
+            return res;
+        }
+
+    private:
+        // the position in the inline array, or null if the elements are in the b-tree
+        const Key* pos = nullptr;
+
+        // the position in the b-tree
+        typename Tree::iterator cur;
+    };
+
+    using const_iterator = iterator;
+    using chunk = range<iterator>;
+
+    small_btree(const Comparator& comp = Comparator()) : comp(comp), tree(comp) {}
+
+    bool empty() const {
+        return isLarge() ? tree.empty() : count == 0;
+    }
+
+    std::size_t size() const {
+        return isLarge() ? tree.size() : count;
+    }
+
+    bool insert(const Key& k) {
+        operation_hints hints;
+        return insert(k, hints);
+    }
+
+    bool insert(const Key& k, operation_hints& hints) {
+        if (!isLarge()) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!large.load(std::memory_order_relaxed)) {
+                return insertInline(k);
+            }
+        }
+        return tree.insert(k, hints);
+    }
+
+    template <typename Iter>
+    void insert(const Iter& a, const Iter& b) {
+        operation_hints hints;
+        for (auto it = a; it != b; ++it) {
+            insert(*it, hints);
+        }
+    }
+
+    bool contains(const Key& k) const {
+        operation_hints hints;
+        return contains(k, hints);
+    }
+
+    bool contains(const Key& k, operation_hints& hints) const {
+        return find(k, hints) != end();
+    }
+
+    iterator find(const Key& k) const {
+        operation_hints hints;
+        return find(k, hints);
+    }
+
+    iterator find(const Key& k, operation_hints& hints) const {
+        if (isLarge()) {
+            return iterator(tree.find(k, hints));
+        }
+        const Key* pos = lowerBound(k);
+        return pos != keys + count && comp.equal(*pos, k) ? iterator(pos) : end();
+    }
+
+    iterator lower_bound(const Key& k) const {
+        operation_hints hints;
+        return lower_bound(k, hints);
+    }
+
+    iterator lower_bound(const Key& k, operation_hints& hints) const {
+        return isLarge() ? iterator(tree.lower_bound(k, hints)) : iterator(lowerBound(k));
+    }
+
+    iterator upper_bound(const Key& k) const {
+        operation_hints hints;
+        return upper_bound(k, hints);
+    }
+
+    iterator upper_bound(const Key& k, operation_hints& hints) const {
+        return isLarge() ? iterator(tree.upper_bound(k, hints)) : iterator(upperBound(k));
+    }
+
+    /** Count the elements between the lower bound of the first and the upper bound of the second key */
+    std::size_t countRange(const Key& lower, const Key& upper) const {
+        if (isLarge()) {
+            return tree.countRange(lower, upper);
+        }
+        const Key* first = lowerBound(lower);
+        const Key* last = upperBound(upper);
+        return last > first ? last - first : 0;
+    }
+
+    void prefetch(const Key& k) const {
+        // the inline array is searched without following any pointer
+        if (isLarge()) {
+            tree.prefetch(k);
+        }
+    }
+
+    iterator begin() const {
+        return isLarge() ? iterator(tree.begin()) : iterator(keys);
+    }
+
+    iterator end() const {
+        return isLarge() ? iterator(tree.end()) : iterator(keys + count);
+    }
+
+    std::vector<chunk> getChunks(std::size_t num) const {
+        std::vector<chunk> res;
+        if (isLarge()) {
+            for (const auto& cur : tree.getChunks(num)) {
+                res.emplace_back(iterator(cur.begin()), iterator(cur.end()));
+            }
+            return res;
+        }
+        const std::size_t step = std::max<std::size_t>(count / std::max<std::size_t>(num, 1), 1);
+        for (std::size_t i = 0; i < count; i += step) {
+            res.emplace_back(iterator(keys + i), iterator(keys + std::min(count, i + step)));
+        }
+        return res;
+    }
+
+    std::vector<chunk> partition(std::size_t num) const {
+        return getChunks(num);
+    }
+
+    /** Clear this set, which stores its elements inline again */
+    void clear() {
+        tree.clear();
+        count = 0;
+        large.store(false, std::memory_order_relaxed);
+    }
+
+    void freeze() const {
+        if (isLarge()) {
+            tree.freeze();
+        }
+    }
+
+    void compact() {
+        if (isLarge()) {
+            tree.compact();
+        }
+    }
+
+    void printStats(std::ostream& out = std::cout) const {
+        if (isLarge()) {
+            tree.printStats(out);
+            return;
+        }
+        out << "---------------------------------\n";
+        out << "  Inline Array Statistics\n";
+        out << "---------------------------------\n";
+        out << "  Size of inline array: " << count << " of " << capacity << "\n";
+        out << "---------------------------------\n";
+    }
+
+private:
+    bool isLarge() const {
+        return large.load(std::memory_order_acquire);
+    }
+
+    const Key* lowerBound(const Key& k) const {
+        return std::lower_bound(
+                keys, keys + count, k, [&](const Key& a, const Key& b) { return comp.less(a, b); });
+    }
+
+    const Key* upperBound(const Key& k) const {
+        return std::upper_bound(
+                keys, keys + count, k, [&](const Key& a, const Key& b) { return comp.less(a, b); });
+    }
+
+    /** Insert into the inline array, moving the elements into the b-tree if the array is full */
+    bool insertInline(const Key& k) {
+        // elements of a multiset equal to the inserted one keep the order of their insertion
+        Key* pos = const_cast<Key*>(isSet ? lowerBound(k) : upperBound(k));
+        if (isSet && pos != keys + count && comp.equal(*pos, k)) {
+            return false;
+        }
+        if (count == capacity) {
+            const Key* first = keys;
+            auto loaded = Tree::load(first, first + count);
+            tree.swap(loaded);
+            tree.insert(k);
+            large.store(true, std::memory_order_release);
+            return true;
+        }
+        std::move_backward(pos, keys + count, keys + count + 1);
+        *pos = k;
+        ++count;
+        return true;
+    }
+
+    Comparator comp;
+
+    // the elements while there are at most capacity many, in the order of the comparator
+    Key keys[capacity];
+    std::size_t count = 0;
+
+    // whether the elements were moved into the b-tree
+    std::atomic<bool> large{false};
+
+    // serialises the insertions into the inline array
+    std::mutex lock;
+
+    Tree tree;
+};
+
+}  // namespace detail
+
+/**
+ * A set of a few elements, stored inline until it outgrows its capacity and moves into a b-tree set.
+ */
+template <typename Key, typename Comparator = detail::comparator<Key>,
+        typename Tree = btree_set<Key, Comparator>, std::size_t capacity = small_set_capacity>
+using small_set = detail::small_btree<Key, Comparator, Tree, true, capacity>;
+
+/**
+ * A multiset of a few elements, stored inline until it outgrows its capacity and moves into a b-tree
+ * multiset.
+ */
+template <typename Key, typename Comparator = detail::comparator<Key>,
+        typename Tree = btree_multiset<Key, Comparator>, std::size_t capacity = small_set_capacity>
+using small_multiset = detail::small_btree<Key, Comparator, Tree, false, capacity>;
+
+}  // namespace souffle
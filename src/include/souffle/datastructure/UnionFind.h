@@ -19,6 +19,7 @@
 #include "souffle/datastructure/LambdaBTree.h"
 #include "souffle/datastructure/PiggyList.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -52,6 +53,10 @@ class DisjointSet {
 
     PiggyList<std::atomic<block_t>> a_blocks;
 
+    // the nodes of each set form a cycle through their successors, spliced by the unions
+    RandomInsertPiggyList<parent_t> a_next;
+    SpinLock nextLock;
+
 public:
     DisjointSet() = default;
 
@@ -73,6 +78,12 @@ public:
         return sz;
     };
 
+    /** Return the number of bytes allocated by this disjoint set */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(a_blocks) - sizeof(a_next) + a_blocks.getMemoryUsage() +
+               a_next.getMemoryUsage();
+    }
+
     /**
      * Yield reference to the node by its node index
      * @param node node to be searched
@@ -86,21 +97,31 @@ public:
     /**
      * Equivalent to the find() function in union/find
      * Find the highest ancestor of the provided node - flattening as we go
+     *
+     * The path is flattened by path splitting: every node on the path is pointed to its grandparent
+     * by a single compare-and-swap that is not retried, so that the walk is wait-free and concurrent
+     * finds on the same path never wait for each other.
+     *
      * @param x the node to find the parent of, whilst flattening its set-tree
      * @return The parent of x
      */
     parent_t findNode(parent_t x) {
+        block_t xState = get(x).load(std::memory_order_acquire);
         // while x's parent is not itself
-        while (x != b2p(get(x))) {
-            block_t xState = get(x);
+        while (x != b2p(xState)) {
+            parent_t parent = b2p(xState);
+            block_t parentState = get(parent).load(std::memory_order_acquire);
             // yield x's parent's parent
-            parent_t newParent = b2p(get(b2p(xState)));
-            // construct block out of the original rank and the new parent
-            block_t newState = pr2b(newParent, b2r(xState));
-
-            this->get(x).compare_exchange_strong(xState, newState);
+            parent_t grandParent = b2p(parentState);
+            if (grandParent != parent) {
+                // construct block out of the original rank and the new parent
+                block_t newState = pr2b(grandParent, b2r(xState));
+                get(x).compare_exchange_weak(xState, newState, std::memory_order_release,
+                        std::memory_order_relaxed);
+            }
 
-            x = newParent;
+            x = parent;
+            xState = parentState;
         }
         return x;
     }
@@ -127,6 +148,16 @@ private:
         return this->get(x).compare_exchange_strong(oldState, newVal);
     }
 
+    /**
+     * Splice the cycles of the nodes of two sets just united. The links of the unions form a forest,
+     * hence the cycles of x and y are distinct whatever the order of concurrent splices.
+     */
+    void spliceSets(const parent_t x, const parent_t y) {
+        nextLock.lock();
+        std::swap(a_next.get(x), a_next.get(y));
+        nextLock.unlock();
+    }
+
 public:
     /**
      * Clears the DisjointSet of all nodes
@@ -134,6 +165,7 @@ public:
      */
     void clear() {
         a_blocks.clear();
+        a_next.clear();
     }
 
     /**
@@ -156,14 +188,15 @@ public:
      * Union the two specified index nodes
      * @param x node to be unioned
      * @param y node to be unioned
+     * @return whether the two nodes were in different sets
      */
-    void unionNodes(parent_t x, parent_t y) {
+    bool unionNodes(parent_t x, parent_t y) {
         while (true) {
             x = findNode(x);
             y = findNode(y);
 
             // no need to union if both already in same set
-            if (x == y) return;
+            if (x == y) return false;
 
             rank_t xrank = b2r(get(x));
             rank_t yrank = b2r(get(y));
@@ -178,11 +211,12 @@ public:
             if (!updateRoot(x, xrank, y, yrank)) {
                 continue;
             }
+            spliceSets(x, y);
             // make sure that the ranks are orderable
             if (xrank == yrank) {
                 updateRoot(y, yrank, y, yrank + 1);
             }
-            break;
+            return true;
         }
     }
 
@@ -194,11 +228,27 @@ public:
         // make node and find out where we've added it
         std::size_t nodeDetails = a_blocks.createNode();
 
+        a_next.insertAt(nodeDetails, nodeDetails);
         a_blocks.get(nodeDetails).store(pr2b(nodeDetails, 0));
 
         return a_blocks.get(nodeDetails).load();
     };
 
+    /**
+     * Visit the nodes of the set of the given node, in time proportional to the size of the set.
+     * Unions must not run concurrently.
+     * @param x a node of the set
+     * @param f the function called for each node
+     */
+    template <typename F>
+    void forEachInSet(const parent_t x, F&& f) const {
+        parent_t node = x;
+        do {
+            f(node);
+            node = a_next.get(node);
+        } while (node != x);
+    }
+
     /**
      * Extract parent from block
      * @param inblock the block to be masked
@@ -274,13 +324,26 @@ public:
      * @return the corresponding dense value
      */
     parent_t toDense(const SparseDomain in) {
+        bool created;
+        return toDense(in, created);
+    }
+
+    /**
+     * Retrieve dense encoding, adding it in if non-existent
+     * @param in the sparse value
+     * @param created set to whether the dense value has been created by this call
+     * @return the corresponding dense value
+     */
+    parent_t toDense(const SparseDomain in, bool& created) {
         // insert into the mapping - if the key doesn't exist (in), the function will be called
         // and a dense value will be created for it
         PairStore p = {in, -1};
+        created = false;
         return sparseToDenseMap.insert(p, [&](PairStore& p) {
             parent_t c2 = DisjointSet::b2p(this->ds.makeNode());
             this->denseToSparseMap.insertAt(c2, p.first);
             p.second = c2;
+            created = true;
             return c2;
         });
     }
@@ -318,15 +381,31 @@ public:
     inline SparseDomain findNode(SparseDomain x) {
         return toSparse(ds.findNode(toDense(x)));
     };
-    /* union the nodes, add if not existing */
-    inline void unionNodes(SparseDomain x, SparseDomain y) {
-        ds.unionNodes(toDense(x), toDense(y));
+    /* union the nodes, add if not existing; returns whether any node was added or any sets merged */
+    inline bool unionNodes(SparseDomain x, SparseDomain y) {
+        bool xCreated;
+        bool yCreated;
+        parent_t dx = toDense(x, xCreated);
+        parent_t dy = toDense(y, yCreated);
+        return ds.unionNodes(dx, dy) || xCreated || yCreated;
     };
 
     inline std::size_t size() {
         return ds.size();
     };
 
+    /* visits the elements of the set of the given existing element; unions must not run concurrently */
+    template <typename F>
+    void forEachInSet(SparseDomain x, F&& f) {
+        ds.forEachInSet(toDense(x), [&](parent_t node) { f(toSparse(node)); });
+    }
+
+    /** Return the number of bytes allocated by this disjoint set and its mappings */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(ds) - sizeof(sparseToDenseMap) - sizeof(denseToSparseMap) +
+               ds.getMemoryUsage() + sparseToDenseMap.getMemoryUsage() + denseToSparseMap.getMemoryUsage();
+    }
+
     /**
      * Remove all elements from this disjoint set
      */
@@ -0,0 +1,130 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file AsyncOutput.h
+ *
+ * Writes output relations by background threads while evaluation
+ * continues.
+ *
+ * Output relations are final once their stratum has been computed, and
+ * later strata only read them, such that they can be written concurrently
+ * to the evaluation. A relation must only be changed again, e.g. cleared
+ * once it expired, after waiting for its writes; the symbol and record
+ * tables must only be renumbered after waiting for all writes.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+class AsyncOutput {
+public:
+    /** Create the writer, whose threads are started by the first write */
+    explicit AsyncOutput(std::size_t numThreads) : numThreads(numThreads == 0 ? 1 : numThreads) {}
+
+    AsyncOutput(const AsyncOutput&) = delete;
+    AsyncOutput& operator=(const AsyncOutput&) = delete;
+
+    ~AsyncOutput() {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            stopping = true;
+        }
+        available.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /** Write a relation in the background; a failing write terminates the program like a foreground one */
+    void submit(const void* relation, std::function<void()> write) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            if (workers.empty()) {
+                for (std::size_t i = 0; i < numThreads; i++) {
+                    workers.emplace_back([this]() { work(); });
+                }
+            }
+            queue.emplace_back(relation, std::move(write));
+            ++pending[relation];
+        }
+        available.notify_one();
+    }
+
+    /** Wait for the writes of a relation, before the relation is changed */
+    void wait(const void* relation) {
+        std::unique_lock<std::mutex> guard(lock);
+        completed.wait(guard, [&]() { return pending.count(relation) == 0; });
+    }
+
+    /** Wait for all writes */
+    void wait() {
+        std::unique_lock<std::mutex> guard(lock);
+        completed.wait(guard, [&]() { return pending.empty(); });
+    }
+
+private:
+    void work() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            available.wait(guard, [&]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            auto [relation, write] = std::move(queue.front());
+            queue.pop_front();
+
+            guard.unlock();
+            try {
+                write();
+            } catch (std::exception& e) {
+                std::cerr << e.what();
+                exit(EXIT_FAILURE);
+            }
+            guard.lock();
+
+            if (--pending[relation] == 0) {
+                pending.erase(relation);
+            }
+            completed.notify_all();
+        }
+    }
+
+    const std::size_t numThreads;
+
+    std::mutex lock;
+    std::condition_variable available;
+    std::condition_variable completed;
+
+    /** Writes not started yet, with their relation */
+    std::deque<std::pair<const void*, std::function<void()>>> queue;
+
+    /** Number of writes of each relation not completed yet */
+    std::unordered_map<const void*, std::size_t> pending;
+
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+}  // namespace souffle
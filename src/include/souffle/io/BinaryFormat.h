@@ -0,0 +1,104 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file BinaryFormat.h
+ *
+ * Layout of the binary relation snapshots written by WriteFileBinary
+ * and loaded by ReadFileBinary.
+ *
+ * A snapshot consists of a fixed header, a block of raw tuples and a
+ * trailing symbol section:
+ *
+ *   magic      8 bytes  "SOUFFLEB"
+ *   version    uint32
+ *   arity      uint32   number of stored columns
+ *   domain     uint32   sizeof(RamDomain) of the writer
+ *   flags      uint32
+ *   tuples     uint64   number of stored tuples
+ *   symbols    uint64   file offset of the symbol section
+ *   data       tuples * arity RamDomain values
+ *   symbol section: uint64 count, then per symbol a uint64 length
+ *   followed by the bytes of the symbol
+ *
+ * Symbol columns do not store symbol table indices of the writer but the
+ * position of the symbol in the trailing symbol section, so that a
+ * snapshot can be loaded by any program regardless of its symbol table.
+ *
+ * Spilled relations (IO type `spill`) are snapshots of the RAM values
+ * themselves, without a symbol section, such that only the writing
+ * process can load them again.
+ *
+ * Snapshots with the IO option `symbols=<file>` store the symbol table
+ * indices of the writer instead of a symbol section, and the writer saves
+ * its symbol table to the given file (see SymbolTable::save). Readers
+ * attach to the symbol file once and translate indices by table lookup,
+ * such that chained programs exchange relations without converting
+ * symbols per relation.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace souffle {
+
+namespace binary_format {
+
+constexpr char MAGIC[8] = {'S', 'O', 'U', 'F', 'F', 'L', 'E', 'B'};
+constexpr std::uint32_t VERSION = 1;
+
+/** The snapshot stores RAM values of the writing process */
+constexpr std::uint32_t FLAG_RAW = 1;
+
+/** The symbol columns of the snapshot refer to the indices of a symbol file */
+constexpr std::uint32_t FLAG_SHARED_SYMBOLS = 2;
+
+/** Offset of the tuple count within the header */
+constexpr std::streamoff TUPLE_COUNT_OFFSET = 24;
+
+/** Size of the header, and hence the offset of the first tuple */
+constexpr std::streamoff HEADER_SIZE = 40;
+
+/** Number of tuples read or written per block */
+constexpr std::size_t BLOCK_SIZE = 4096;
+
+template <typename T>
+void write(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T read(std::istream& in) {
+    T value{};
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::invalid_argument("unexpected end of binary file");
+    }
+    return value;
+}
+
+/** Check whether a column of the given type attribute can be stored in a snapshot */
+inline bool isSupported(const std::string& typeAttribute) {
+    switch (typeAttribute[0]) {
+        case 'i':
+        case 'u':
+        case 'f':
+        case 's': return true;
+        default: return false;
+    }
+}
+
+}  // namespace binary_format
+
+}  // namespace souffle
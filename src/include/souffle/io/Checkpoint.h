@@ -0,0 +1,134 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Checkpoint.h
+ *
+ * Layout of the checkpoints of an evaluation, written between strata
+ * with `--checkpoint-dir` and resumed with `--resume-from`.
+ *
+ * A checkpoint of a step, i.e., of a group of strata, consists of the
+ * relations needed by later steps, spilled as RAM values (see
+ * BinaryFormat.h), and of the symbol table and record table they refer
+ * to. Restoring both tables with their indices makes the spilled values
+ * valid in a new process of the same program.
+ *
+ * The marker file `checkpoint` names the last completed step, the number
+ * of steps of the program and the files of the checkpoint, one per line.
+ * It is replaced once all files are written, such that a crash while
+ * writing a checkpoint leaves the previous one intact.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace checkpoint {
+
+/** The last completed checkpoint of a directory */
+struct Marker {
+    /** Index of the completed step */
+    std::size_t step = 0;
+
+    /** Number of steps of the program */
+    std::size_t steps = 0;
+
+    /** Files of the checkpoint */
+    std::vector<std::string> files;
+};
+
+inline std::string markerFile(const std::string& directory) {
+    return directory + "/checkpoint";
+}
+
+/** The file of a relation at the given step, written by a spill IO statement */
+inline std::string relationFile(const std::string& directory, const std::string& relation, std::size_t step) {
+    return directory + "/" + relation + "." + std::to_string(step) + ".checkpoint";
+}
+
+inline std::string symbolFile(const std::string& directory, std::size_t step) {
+    return directory + "/@symbols." + std::to_string(step) + ".checkpoint";
+}
+
+inline std::string recordFile(const std::string& directory, std::size_t step) {
+    return directory + "/@records." + std::to_string(step) + ".checkpoint";
+}
+
+/** Read the marker of the directory, if it holds a checkpoint */
+inline std::optional<Marker> readMarker(const std::string& directory) {
+    std::ifstream in(markerFile(directory));
+    Marker marker;
+    if (!(in >> marker.step >> marker.steps)) {
+        return std::nullopt;
+    }
+    std::string file;
+    while (in >> file) {
+        marker.files.push_back(file);
+    }
+    return marker;
+}
+
+/**
+ * Complete the checkpoint of a step, whose relations are written to the given files already: save the
+ * tables, replace the marker, and remove the files of the previous checkpoint.
+ */
+inline void save(const std::string& directory, std::size_t step, std::size_t steps,
+        std::vector<std::string> files, const SymbolTable& symbolTable, const RecordTable& recordTable) {
+    const auto previous = readMarker(directory);
+    files.push_back(symbolFile(directory, step));
+    symbolTable.save(files.back());
+    files.push_back(recordFile(directory, step));
+    recordTable.save(files.back());
+
+    const std::string temporary = markerFile(directory) + ".tmp";
+    {
+        std::ofstream out(temporary);
+        out << step << " " << steps << "\n";
+        for (const auto& file : files) {
+            out << file << "\n";
+        }
+        if (!out) {
+            throw std::runtime_error("Cannot write checkpoint marker " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), markerFile(directory).c_str()) != 0) {
+        throw std::runtime_error("Cannot write checkpoint marker " + markerFile(directory));
+    }
+
+    if (previous) {
+        for (const auto& file : previous->files) {
+            if (std::find(files.begin(), files.end(), file) == files.end()) {
+                std::remove(file.c_str());
+            }
+        }
+    }
+}
+
+/** Restore the tables of the checkpoint of a step, before its relations are restored */
+inline void restore(
+        const std::string& directory, std::size_t step, SymbolTable& symbolTable, RecordTable& recordTable) {
+    symbolTable.restore(symbolFile(directory, step));
+    recordTable.restore(recordFile(directory, step));
+}
+
+}  // namespace checkpoint
+
+}  // namespace souffle
@@ -18,17 +18,30 @@
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/io/ReadStream.h"
+#include "souffle/io/ReadStreamBinary.h"
 #include "souffle/io/ReadStreamCSV.h"
 #include "souffle/io/ReadStreamJSON.h"
 #include "souffle/io/WriteStream.h"
+#include "souffle/io/WriteStreamBinary.h"
 #include "souffle/io/WriteStreamCSV.h"
 #include "souffle/io/WriteStreamJSON.h"
+#include "souffle/io/WriteStreamPartitioned.h"
 
 #ifdef USE_SQLITE
 #include "souffle/io/ReadStreamSQLite.h"
 #include "souffle/io/WriteStreamSQLite.h"
 #endif
 
+#ifdef USE_ARROW
+#include "souffle/io/ReadStreamArrow.h"
+#include "souffle/io/WriteStreamArrow.h"
+#endif
+
+#ifdef USE_CURL
+#include "souffle/io/ReadStreamObject.h"
+#include "souffle/io/WriteStreamObject.h"
+#endif
+
 #include <map>
 #include <memory>
 #include <stdexcept>
@@ -60,6 +73,9 @@ public:
         if (outputFactories.count(ioType) == 0) {
             throw std::invalid_argument("Requested output type <" + ioType + "> is not supported.");
         }
+        if (rwOperation.count("partitions") > 0) {
+            return mk<WritePartitioned>(rwOperation, symbolTable, recordTable, *outputFactories.at(ioType));
+        }
         return outputFactories.at(ioType)->getWriter(rwOperation, symbolTable, recordTable);
     }
     /**
@@ -79,16 +95,32 @@ private:
     IOSystem() {
         registerReadStreamFactory(std::make_shared<ReadFileCSVFactory>());
         registerReadStreamFactory(std::make_shared<ReadCinCSVFactory>());
+        registerReadStreamFactory(std::make_shared<ReadBatchCSVFactory>());
+        registerReadStreamFactory(std::make_shared<ReadInlineCSVFactory>());
         registerReadStreamFactory(std::make_shared<ReadFileJSONFactory>());
         registerReadStreamFactory(std::make_shared<ReadCinJSONFactory>());
+        registerReadStreamFactory(std::make_shared<ReadFileBinaryFactory>());
+        registerReadStreamFactory(std::make_shared<ReadFileSpillFactory>());
         registerWriteStreamFactory(std::make_shared<WriteFileCSVFactory>());
         registerWriteStreamFactory(std::make_shared<WriteCoutCSVFactory>());
         registerWriteStreamFactory(std::make_shared<WriteCoutPrintSizeFactory>());
         registerWriteStreamFactory(std::make_shared<WriteFileJSONFactory>());
         registerWriteStreamFactory(std::make_shared<WriteCoutJSONFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteFileBinaryFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteFileSpillFactory>());
 #ifdef USE_SQLITE
         registerReadStreamFactory(std::make_shared<ReadSQLiteFactory>());
         registerWriteStreamFactory(std::make_shared<WriteSQLiteFactory>());
+#endif
+#ifdef USE_ARROW
+        registerReadStreamFactory(std::make_shared<ReadParquetFactory>());
+        registerReadStreamFactory(std::make_shared<ReadArrowFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteParquetFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteArrowFactory>());
+#endif
+#ifdef USE_CURL
+        registerReadStreamFactory(std::make_shared<ReadObjectCSVFactory>());
+        registerWriteStreamFactory(std::make_shared<WriteObjectCSVFactory>());
 #endif
     };
     std::map<std::string, std::shared_ptr<WriteStreamFactory>> outputFactories;
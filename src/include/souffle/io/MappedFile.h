@@ -0,0 +1,84 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MappedFile.h
+ *
+ * A read-only memory mapping of a regular file, such that readers can
+ * tokenise its bytes in place instead of copying them through a stream.
+ *
+ * Files that cannot be mapped, e.g. pipes, empty files, or any file on
+ * platforms without mmap, are left unmapped; readers then fall back to
+ * their streams.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace souffle {
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifndef _WIN32
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                ::madvise(address, size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(address);
+                length = size;
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (data != nullptr) {
+            ::munmap(const_cast<char*>(data), length);
+        }
+#endif
+    }
+
+    bool isMapped() const {
+        return data != nullptr;
+    }
+
+    /** The bytes of the file; empty if it is not mapped */
+    std::string_view view() const {
+        return {data, length};
+    }
+
+private:
+    const char* data = nullptr;
+    std::size_t length = 0;
+};
+
+} /* namespace souffle */
@@ -0,0 +1,732 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ObjectStorage.h
+ *
+ * Reading and writing objects of S3, Google Cloud Storage and HTTP servers
+ * without staging them on a local disk.
+ *
+ * Objects are named by URLs:
+ *  - `s3://bucket/key` is read from the virtual host of the bucket, or
+ *    from `$AWS_ENDPOINT_URL/bucket/key` if set, e.g., for compatible
+ *    servers. Requests are signed with the credentials of
+ *    `AWS_ACCESS_KEY_ID` and `AWS_SECRET_ACCESS_KEY`, if set.
+ *  - `gs://bucket/key` is read from the XML API of Google Cloud Storage,
+ *    with the token of `GOOGLE_OAUTH_ACCESS_TOKEN`, if set.
+ *  - `http://` and `https://` URLs are read as they are, e.g., presigned
+ *    URLs of either.
+ *
+ * Objects are read by range requests for consecutive parts, several of
+ * which are downloaded concurrently ahead of the reader. Objects are
+ * written in parts uploaded concurrently while later parts are written,
+ * by the multipart upload protocol of S3 (also served by the XML API of
+ * Google Cloud Storage). Objects written to HTTP URLs, and objects of a
+ * single part, are uploaded by a single request.
+ *
+ * Objects compressed by gzip or zstd are decompressed while they are read.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <curl/curl.h>
+#ifdef USE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace souffle {
+
+namespace object {
+
+/** Default size of the parts objects are read and written in */
+constexpr std::size_t DEFAULT_PART_SIZE = 8 << 20;
+
+/** Smallest size of the parts of a multipart upload but the last, as required by S3 */
+constexpr std::size_t MIN_UPLOAD_PART_SIZE = 5 << 20;
+
+/** Default number of parts downloaded or uploaded concurrently */
+constexpr std::size_t DEFAULT_PARALLEL_PARTS = 4;
+
+/** Compression of an object */
+enum class Codec { Plain, GZip, Zstd };
+
+/** Return whether the name refers to an object, rather than to a local file */
+inline bool isObjectUrl(const std::string& name) {
+    return name.find("://") != std::string::npos;
+}
+
+/** Return the size given by the option, e.g., the size of parts, or the default if it is not given */
+inline std::size_t getSize(const std::map<std::string, std::string>& rwOperation, const std::string& option,
+        std::size_t fallback) {
+    auto it = rwOperation.find(option);
+    return it == rwOperation.end() ? fallback : std::stoull(it->second);
+}
+
+/** The answer to a request */
+struct Response {
+    long status = 0;
+    std::string body;
+    std::string etag;
+
+    /** The value of the Content-Range header of the answer to a range request */
+    std::string contentRange;
+};
+
+/** A request for an object, as passed to a transport */
+struct Request {
+    std::string method;
+
+    /** The URL of the object, including the query string */
+    std::string url;
+
+    /** The requested range of bytes, or empty */
+    std::string range;
+
+    const std::string_view* payload = nullptr;
+};
+
+/**
+ * A function performing a request in place of libcurl, e.g., to serve objects from memory in
+ * tests. It fills in the response and returns true, or sets the error and returns false if the
+ * request could not be sent.
+ */
+using Transport = std::function<bool(const Request&, Response&, std::string&)>;
+
+/**
+ * The location of an object, as the URL of its HTTP endpoint and the
+ * credentials requests for it are signed with.
+ */
+class Location {
+public:
+    explicit Location(const std::string& uri) : uri(uri) {
+        const std::size_t schemeEnd = uri.find("://");
+        const std::string scheme = uri.substr(0, schemeEnd);
+        if (scheme == "http" || scheme == "https") {
+            kind = Kind::HTTP;
+            url = uri;
+            return;
+        }
+        if (scheme != "s3" && scheme != "gs") {
+            throw std::invalid_argument("Unsupported object URL " + uri);
+        }
+        const std::string path = uri.substr(schemeEnd + 3);
+        const std::size_t bucketEnd = path.find('/');
+        if (bucketEnd == 0 || bucketEnd == std::string::npos || bucketEnd + 1 == path.size()) {
+            throw std::invalid_argument("Object URL " + uri + " does not name a bucket and a key");
+        }
+        const std::string bucket = path.substr(0, bucketEnd);
+        const std::string key = encodeKey(path.substr(bucketEnd + 1));
+        if (scheme == "gs") {
+            kind = Kind::GCS;
+            url = "https://storage.googleapis.com/" + bucket + "/" + key;
+            return;
+        }
+        kind = Kind::S3;
+        region = getEnv("AWS_REGION", getEnv("AWS_DEFAULT_REGION", "us-east-1"));
+        const std::string endpoint = getEnv("AWS_ENDPOINT_URL", "");
+        if (!endpoint.empty()) {
+            url = endpoint + (endpoint.back() == '/' ? "" : "/") + bucket + "/" + key;
+        } else {
+            url = "https://" + bucket + ".s3." + region + ".amazonaws.com/" + key;
+        }
+    }
+
+    /** Return the URL the object was named by */
+    const std::string& getUri() const {
+        return uri;
+    }
+
+    /** Return whether objects at the location are uploaded in parts */
+    bool hasMultipartUpload() const {
+        return kind != Kind::HTTP;
+    }
+
+    /**
+     * Perform a request for the object, retrying failed connections and
+     * server errors a few times.
+     *
+     * @param method the HTTP method
+     * @param query the query string, without the leading `?`
+     * @param range the requested range of bytes, e.g., `0-1023`, or empty
+     * @param payload the body of the request, or null
+     */
+    Response perform(const std::string& method, const std::string& query, const std::string& range,
+            const std::string_view* payload) const {
+        constexpr int attempts = 4;
+        std::string error;
+        for (int attempt = 0; attempt < attempts; ++attempt) {
+            if (attempt > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100 << attempt));
+            }
+            Response response;
+            const Transport& transport = getTransport();
+            bool sent = false;
+            if (transport) {
+                sent = transport({method, query.empty() ? url : url + "?" + query, range, payload}, response,
+                        error);
+            } else {
+                sent = performOnce(method, query, range, payload, response, error) == CURLE_OK;
+            }
+            if (sent && response.status < 500 && response.status != 429) {
+                return response;
+            }
+            if (sent) {
+                error = "status " + std::to_string(response.status);
+            }
+        }
+        throw std::runtime_error("Request for object " + uri + " failed: " + error);
+    }
+
+    /** Perform the requests of all locations by the transport, or by libcurl if it is empty */
+    static void setTransport(Transport transport) {
+        getTransport() = std::move(transport);
+    }
+
+private:
+    enum class Kind { S3, GCS, HTTP };
+
+    static Transport& getTransport() {
+        static Transport transport;
+        return transport;
+    }
+
+    static std::string getEnv(const char* name, const std::string& fallback) {
+        const char* value = std::getenv(name);
+        return value == nullptr ? fallback : value;
+    }
+
+    /** Percent-encode the characters of a key other than unreserved characters and slashes */
+    static std::string encodeKey(const std::string& key) {
+        static const char* digits = "0123456789ABCDEF";
+        std::string res;
+        for (const unsigned char c : key) {
+            if (std::isalnum(c) != 0 || c == '-' || c == '_' || c == '.' || c == '~' || c == '/') {
+                res += static_cast<char>(c);
+            } else {
+                res += '%';
+                res += digits[c >> 4];
+                res += digits[c & 15];
+            }
+        }
+        return res;
+    }
+
+    static std::size_t onBody(char* data, std::size_t size, std::size_t count, void* target) {
+        static_cast<Response*>(target)->body.append(data, size * count);
+        return size * count;
+    }
+
+    static std::size_t onHeader(char* data, std::size_t size, std::size_t count, void* target) {
+        auto& response = *static_cast<Response*>(target);
+        std::string_view line(data, size * count);
+        const std::size_t colon = line.find(':');
+        if (colon != std::string_view::npos) {
+            std::string name(line.substr(0, colon));
+            std::transform(
+                    name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front())) != 0) {
+                value.remove_prefix(1);
+            }
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back())) != 0) {
+                value.remove_suffix(1);
+            }
+            if (name == "etag") {
+                response.etag = value;
+            } else if (name == "content-range") {
+                response.contentRange = value;
+            }
+        }
+        return size * count;
+    }
+
+    CURLcode performOnce(const std::string& method, const std::string& query, const std::string& range,
+            const std::string_view* payload, Response& response, std::string& error) const {
+        // the library is initialised once, before the first request of any thread
+        static const CURLcode initialised = curl_global_init(CURL_GLOBAL_DEFAULT);
+        if (initialised != CURLE_OK) {
+            error = curl_easy_strerror(initialised);
+            return initialised;
+        }
+        CURL* curl = curl_easy_init();
+        if (curl == nullptr) {
+            error = "cannot create a connection";
+            return CURLE_FAILED_INIT;
+        }
+        const std::string target = query.empty() ? url : url + "?" + query;
+        curl_slist* headers = nullptr;
+        curl_easy_setopt(curl, CURLOPT_URL, target.c_str());
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onBody);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, onHeader);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+        if (method != "GET") {
+            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+        }
+        if (!range.empty()) {
+            curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+        }
+        if (payload != nullptr) {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload->data());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(payload->size()));
+            headers = curl_slist_append(headers, "Content-Type: application/octet-stream");
+        }
+
+        // credentials
+        const std::string region = this->region;
+        const std::string sigv4 = "aws:amz:" + region + ":s3";
+        const std::string accessKey = getEnv("AWS_ACCESS_KEY_ID", "");
+        const std::string secretKey = getEnv("AWS_SECRET_ACCESS_KEY", "");
+        const std::string sessionToken = getEnv("AWS_SESSION_TOKEN", "");
+        const std::string bearer = getEnv("GOOGLE_OAUTH_ACCESS_TOKEN", "");
+        if (kind == Kind::S3 && !accessKey.empty()) {
+            curl_easy_setopt(curl, CURLOPT_AWS_SIGV4, sigv4.c_str());
+            curl_easy_setopt(curl, CURLOPT_USERNAME, accessKey.c_str());
+            curl_easy_setopt(curl, CURLOPT_PASSWORD, secretKey.c_str());
+            if (!sessionToken.empty()) {
+                headers = curl_slist_append(headers, ("x-amz-security-token: " + sessionToken).c_str());
+            }
+        } else if (kind == Kind::GCS && !bearer.empty()) {
+            headers = curl_slist_append(headers, ("Authorization: Bearer " + bearer).c_str());
+        }
+        if (headers != nullptr) {
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        }
+
+        const CURLcode result = curl_easy_perform(curl);
+        if (result == CURLE_OK) {
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+        } else {
+            error = curl_easy_strerror(result);
+        }
+        curl_slist_free_all(headers);
+        curl_easy_cleanup(curl);
+        return result;
+    }
+
+    const std::string uri;
+    std::string url;
+    std::string region;
+    Kind kind = Kind::HTTP;
+};
+
+/**
+ * A stream buffer reading an object in parts, several of which are
+ * downloaded ahead of the reader, and decompressing it if it is
+ * compressed.
+ */
+class ReadBuffer : public std::streambuf {
+public:
+    ReadBuffer(const std::string& uri, std::size_t partSize, std::size_t parallelParts)
+            : location(uri), partSize(std::max<std::size_t>(partSize, 1)),
+              parallelParts(std::max<std::size_t>(parallelParts, 1)) {}
+
+    ReadBuffer(const ReadBuffer&) = delete;
+    ReadBuffer& operator=(const ReadBuffer&) = delete;
+
+    ~ReadBuffer() override {
+        // parts still downloading refer to the location
+        for (auto& part : pending) {
+            part.wait();
+        }
+        release();
+    }
+
+    /**
+     * Request the first part of the object, which tells its size, and
+     * start downloading the following parts.
+     *
+     * @return false if the object does not exist
+     */
+    bool open() {
+        Response response = location.perform("GET", "", range(0), nullptr);
+        if (response.status == 404) {
+            return false;
+        }
+        // ranges of empty objects cannot be satisfied
+        if (response.status == 416) {
+            started = true;
+            return true;
+        }
+        check(response);
+        // servers ignoring the range answer with the whole object
+        std::size_t size = response.body.size();
+        const std::size_t slash = response.contentRange.rfind('/');
+        if (response.status == 206 && slash != std::string::npos && response.contentRange[slash + 1] != '*') {
+            size = std::stoull(response.contentRange.substr(slash + 1));
+        }
+        parts = response.status == 206 ? (size + partSize - 1) / partSize : 1;
+        nextPart = 1;
+        schedule();
+        setPart(std::move(response.body));
+        return true;
+    }
+
+protected:
+    int_type underflow() override {
+        while (gptr() == egptr()) {
+            if (!fill()) {
+                return traits_type::eof();
+            }
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    std::string range(std::size_t part) const {
+        return std::to_string(part * partSize) + "-" + std::to_string((part + 1) * partSize - 1);
+    }
+
+    void check(const Response& response) const {
+        if (response.status >= 300) {
+            throw std::runtime_error("Cannot read object " + location.getUri() + ": status " +
+                                     std::to_string(response.status));
+        }
+    }
+
+    /** Keep the configured number of parts downloading */
+    void schedule() {
+        while (pending.size() < parallelParts && nextPart < parts) {
+            const std::string partRange = range(nextPart++);
+            pending.push_back(std::async(std::launch::async, [this, partRange]() {
+                Response response = location.perform("GET", "", partRange, nullptr);
+                check(response);
+                return std::move(response.body);
+            }));
+        }
+    }
+
+    /** Continue with the given part of the object, detecting the compression from the first part */
+    void setPart(std::string part) {
+        raw = std::move(part);
+        rawPosition = 0;
+        if (!started) {
+            started = true;
+            if (raw.size() >= 2 && raw.compare(0, 2, "\x1f\x8b") == 0) {
+#ifdef USE_LIBZ
+                codec = Codec::GZip;
+                gzipStream = z_stream{};
+                if (inflateInit2(&gzipStream, 15 + 32) != Z_OK) {
+                    throw std::runtime_error("Cannot decompress object " + location.getUri());
+                }
+#else
+                throw std::runtime_error("gzip compression is not supported by this build");
+#endif
+            } else if (raw.size() >= 4 && raw.compare(0, 4, "\x28\xb5\x2f\xfd") == 0) {
+#ifdef USE_ZSTD
+                codec = Codec::Zstd;
+                zstdStream = ZSTD_createDStream();
+                ZSTD_initDStream(zstdStream);
+#else
+                throw std::runtime_error("zstd compression is not supported by this build");
+#endif
+            }
+        }
+        if (codec == Codec::Plain) {
+            setg(&raw[0], &raw[0], &raw[0] + raw.size());
+        } else {
+            setg(nullptr, nullptr, nullptr);
+        }
+    }
+
+    /** Fetch the next downloaded part, waiting for it if needed */
+    bool fetch() {
+        if (pending.empty()) {
+            return false;
+        }
+        std::string part = pending.front().get();
+        pending.pop_front();
+        schedule();
+        setPart(std::move(part));
+        return true;
+    }
+
+    /** Make more of the object available to the reader; the available bytes may remain empty */
+    bool fill() {
+        if (codec == Codec::Plain) {
+            return fetch();
+        }
+        if (rawPosition == raw.size() && !fetch()) {
+            return false;
+        }
+        data.resize(DECODED_SIZE);
+        std::size_t produced = 0;
+#ifdef USE_LIBZ
+        if (codec == Codec::GZip) {
+            gzipStream.next_in = reinterpret_cast<Bytef*>(&raw[rawPosition]);
+            gzipStream.avail_in = static_cast<uInt>(raw.size() - rawPosition);
+            gzipStream.next_out = reinterpret_cast<Bytef*>(data.data());
+            gzipStream.avail_out = static_cast<uInt>(data.size());
+            const int result = inflate(&gzipStream, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+                throw std::runtime_error("Cannot decompress object " + location.getUri());
+            }
+            rawPosition = raw.size() - gzipStream.avail_in;
+            produced = data.size() - gzipStream.avail_out;
+            // concatenated members are decompressed one after another
+            if (result == Z_STREAM_END) {
+                inflateReset(&gzipStream);
+            }
+        }
+#endif
+#ifdef USE_ZSTD
+        if (codec == Codec::Zstd) {
+            ZSTD_inBuffer input = {raw.data(), raw.size(), rawPosition};
+            ZSTD_outBuffer output = {data.data(), data.size(), 0};
+            if (ZSTD_isError(ZSTD_decompressStream(zstdStream, &output, &input))) {
+                throw std::runtime_error("Cannot decompress object " + location.getUri());
+            }
+            rawPosition = input.pos;
+            produced = output.pos;
+        }
+#endif
+        setg(data.data(), data.data(), data.data() + produced);
+        return true;
+    }
+
+    void release() {
+#ifdef USE_LIBZ
+        if (codec == Codec::GZip) {
+            inflateEnd(&gzipStream);
+        }
+#endif
+#ifdef USE_ZSTD
+        if (codec == Codec::Zstd) {
+            ZSTD_freeDStream(zstdStream);
+        }
+#endif
+    }
+
+    /** Size of the blocks decompressed at once */
+    static constexpr std::size_t DECODED_SIZE = 1 << 20;
+
+    const Location location;
+    const std::size_t partSize;
+    const std::size_t parallelParts;
+
+    /** Number of parts of the object, and the next part to download */
+    std::size_t parts = 0;
+    std::size_t nextPart = 0;
+
+    /** Parts being downloaded, in order */
+    std::deque<std::future<std::string>> pending;
+
+    /** The current part, of which the bytes up to the position were decompressed */
+    std::string raw;
+    std::size_t rawPosition = 0;
+    bool started = false;
+
+    Codec codec = Codec::Plain;
+    std::vector<char> data;
+#ifdef USE_LIBZ
+    z_stream gzipStream{};
+#endif
+#ifdef USE_ZSTD
+    ZSTD_DStream* zstdStream = nullptr;
+#endif
+};
+
+/**
+ * An upload of an object, compressing the written bytes if requested and
+ * uploading the complete parts concurrently while later parts are written.
+ */
+class Upload {
+public:
+    Upload(const std::string& uri, Codec codec, std::size_t partSize, std::size_t parallelParts)
+            : location(uri), codec(codec), partSize(std::max(partSize, MIN_UPLOAD_PART_SIZE)),
+              parallelParts(std::max<std::size_t>(parallelParts, 1)) {
+#ifdef USE_LIBZ
+        if (codec == Codec::GZip && deflateInit2(&gzipStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                                            Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("Cannot compress object " + uri);
+        }
+#endif
+#ifdef USE_ZSTD
+        if (codec == Codec::Zstd) {
+            zstdStream = ZSTD_createCStream();
+            ZSTD_initCStream(zstdStream, ZSTD_CLEVEL_DEFAULT);
+        }
+#endif
+    }
+
+    Upload(const Upload&) = delete;
+    Upload& operator=(const Upload&) = delete;
+
+    ~Upload() {
+        for (auto& part : pending) {
+            part.wait();
+        }
+#ifdef USE_LIBZ
+        if (codec == Codec::GZip) {
+            deflateEnd(&gzipStream);
+        }
+#endif
+#ifdef USE_ZSTD
+        if (codec == Codec::Zstd) {
+            ZSTD_freeCStream(zstdStream);
+        }
+#endif
+    }
+
+    /** Write the bytes to the object */
+    void write(const char* bytes, std::size_t size) {
+        encode(bytes, size, false);
+        // objects that cannot be uploaded in parts are uploaded at once when they are complete
+        while (location.hasMultipartUpload() && part.size() >= partSize) {
+            submit(part.substr(0, partSize));
+            part.erase(0, partSize);
+        }
+    }
+
+    /** Upload the rest of the object and complete it */
+    void close() {
+        encode(nullptr, 0, true);
+        if (partNumber == 0) {
+            const std::string_view payload(part);
+            check(location.perform("PUT", "", "", &payload), "upload");
+            return;
+        }
+        submit(std::move(part));
+        std::vector<std::string> etags;
+        while (!pending.empty()) {
+            etags.push_back(pending.front().get());
+            pending.pop_front();
+        }
+        std::string body = "<CompleteMultipartUpload>";
+        for (std::size_t i = 0; i < etags.size(); ++i) {
+            body += "<Part><PartNumber>" + std::to_string(i + 1) + "</PartNumber><ETag>" + etags[i] +
+                    "</ETag></Part>";
+        }
+        body += "</CompleteMultipartUpload>";
+        const std::string_view payload(body);
+        check(location.perform("POST", "uploadId=" + uploadId, "", &payload), "complete the upload of");
+    }
+
+private:
+    void check(const Response& response, const std::string& action) const {
+        // completing an upload may fail after the status was sent
+        if (response.status >= 300 || response.body.find("<Error>") != std::string::npos) {
+            throw std::runtime_error("Cannot " + action + " object " + location.getUri() + ": status " +
+                                     std::to_string(response.status));
+        }
+    }
+
+    /** Append the bytes to the current part, compressed if requested */
+    void encode(const char* bytes, std::size_t size, bool finish) {
+        if (codec == Codec::Plain) {
+            part.append(bytes, size);
+            return;
+        }
+        constexpr std::size_t chunk = 1 << 16;
+#ifdef USE_LIBZ
+        if (codec == Codec::GZip) {
+            gzipStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(bytes));
+            gzipStream.avail_in = static_cast<uInt>(size);
+            int result = Z_OK;
+            do {
+                const std::size_t used = part.size();
+                part.resize(used + chunk);
+                gzipStream.next_out = reinterpret_cast<Bytef*>(&part[used]);
+                gzipStream.avail_out = static_cast<uInt>(chunk);
+                result = deflate(&gzipStream, finish ? Z_FINISH : Z_NO_FLUSH);
+                part.resize(used + chunk - gzipStream.avail_out);
+            } while (gzipStream.avail_in > 0 || (finish && result != Z_STREAM_END));
+        }
+#endif
+#ifdef USE_ZSTD
+        if (codec == Codec::Zstd) {
+            ZSTD_inBuffer input = {bytes, size, 0};
+            std::size_t remaining = 0;
+            do {
+                const std::size_t used = part.size();
+                part.resize(used + chunk);
+                ZSTD_outBuffer output = {&part[used], chunk, 0};
+                remaining = ZSTD_compressStream2(
+                        zstdStream, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+                if (ZSTD_isError(remaining)) {
+                    throw std::runtime_error("Cannot compress object " + location.getUri());
+                }
+                part.resize(used + output.pos);
+            } while (input.pos < input.size || (finish && remaining != 0));
+        }
+#endif
+    }
+
+    /** Upload the next part, waiting for the oldest part if too many are uploading */
+    void submit(std::string bytes) {
+        if (partNumber == 0) {
+            const Response response = location.perform("POST", "uploads", "", nullptr);
+            check(response, "start the upload of");
+            const std::size_t begin = response.body.find("<UploadId>");
+            const std::size_t end = response.body.find("</UploadId>");
+            if (begin == std::string::npos || end == std::string::npos) {
+                throw std::runtime_error("Cannot start the upload of object " + location.getUri());
+            }
+            uploadId = response.body.substr(begin + 10, end - begin - 10);
+        }
+        if (pending.size() >= parallelParts) {
+            // the futures are kept to collect the tags of the parts in order
+            pending[pending.size() - parallelParts].wait();
+        }
+        const std::string query = "partNumber=" + std::to_string(++partNumber) + "&uploadId=" + uploadId;
+        pending.push_back(std::async(std::launch::async, [this, query, bytes = std::move(bytes)]() {
+            const std::string_view payload(bytes);
+            const Response response = location.perform("PUT", query, "", &payload);
+            check(response, "upload a part of");
+            return response.etag;
+        }));
+    }
+
+    const Location location;
+    const Codec codec;
+    const std::size_t partSize;
+    const std::size_t parallelParts;
+
+    /** The bytes of the part being written */
+    std::string part;
+
+    std::size_t partNumber = 0;
+    std::string uploadId;
+
+    /** Parts being uploaded, in order, returning their tags */
+    std::deque<std::future<std::string>> pending;
+
+#ifdef USE_LIBZ
+    z_stream gzipStream{};
+#endif
+#ifdef USE_ZSTD
+    ZSTD_CStream* zstdStream = nullptr;
+#endif
+};
+
+}  // namespace object
+
+}  // namespace souffle
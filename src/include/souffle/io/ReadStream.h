@@ -22,6 +22,7 @@
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include "souffle/utility/json11.h"
+#include <algorithm>
 #include <cctype>
 #include <cstddef>
 #include <map>
@@ -29,6 +30,7 @@
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace souffle {
@@ -37,15 +39,37 @@ class ReadStream : public SerialisationStream<false> {
 protected:
     ReadStream(
             const std::map<std::string, std::string>& rwOperation, SymbolTable& symTab, RecordTable& recTab)
-            : SerialisationStream(symTab, recTab, rwOperation) {}
+            : SerialisationStream(symTab, recTab, rwOperation) {
+        readPushdown();
+    }
 
 public:
+    /**
+     * Insert the tuples of the input into the given relation.
+     *
+     * Tuples are read a block at a time into a buffer, such that readers
+     * neither allocate nor are called per tuple.
+     */
     template <typename T>
     void readAll(T& relation) {
-        while (const auto next = readNextTuple()) {
-            const RamDomain* ramDomain = next.get();
-            relation.insert(ramDomain);
-        }
+        const std::size_t width = typeAttributes.size();
+        std::vector<RamDomain> tuples(std::max<std::size_t>(TUPLE_BLOCK_SIZE * width, 1));
+        std::size_t count = 0;
+        do {
+            count = readNextTuples(tuples.data(), TUPLE_BLOCK_SIZE);
+            for (std::size_t i = 0; i < count; ++i) {
+                relation.insert(&tuples[i * width]);
+            }
+        } while (count == TUPLE_BLOCK_SIZE);
+    }
+
+    /**
+     * Check whether further batches follow the batch read by readAll.
+     *
+     * Streaming inputs are read a batch at a time, all other inputs at once.
+     */
+    virtual bool hasMoreBatches() const {
+        return false;
     }
 
 protected:
@@ -175,10 +199,7 @@ protected:
             if (adtInfo["enum"].bool_value()) {
                 return branchIdx;
             }
-
-            RamDomain emptyArgs = recordTable.pack(toVector<RamDomain>().data(), 0);
-            const RamDomain record[] = {branchIdx, emptyArgs};
-            return recordTable.pack(record, 2);
+            return packUnboxedBranch(branchIdx);
         }
 
         consumeChar(source, '(', pos);
@@ -380,7 +401,80 @@ protected:
         }
     }
 
-    virtual Own<RamDomain[]> readNextTuple() = 0;
+    /**
+     * Check whether a symbol passes the filter pushed down for its column.
+     */
+    bool acceptsSymbol(std::size_t column, std::string_view text) const {
+        const auto& accepted = symbolFilters[column];
+        return accepted.empty() || std::find(accepted.begin(), accepted.end(), text) != accepted.end();
+    }
+
+    /**
+     * Check whether a number passes the filter pushed down for its column.
+     */
+    bool acceptsNumber(std::size_t column, RamDomain value) const {
+        const auto& accepted = numberFilters[column];
+        return accepted.empty() || std::find(accepted.begin(), accepted.end(), value) != accepted.end();
+    }
+
+    /** Number of tuples read at a time by readAll */
+    static constexpr std::size_t TUPLE_BLOCK_SIZE = 1024;
+
+    /**
+     * Read up to the given number of tuples into the given buffer, one after
+     * the other, each of typeAttributes.size() values. Values which are not
+     * read, e.g. of columns unused by the program, are zero.
+     *
+     * @return the number of tuples read, which is less than the capacity only
+     * at the end of the input, or of the current batch of a streaming input
+     */
+    virtual std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) = 0;
+
+    /** Columns observed by the program; other columns may be left zero */
+    std::vector<bool> usedColumns;
+
+    /** Symbols each symbol column is restricted to; empty if unrestricted */
+    std::vector<std::vector<std::string>> symbolFilters;
+
+    /** Numbers each number column is restricted to; empty if unrestricted */
+    std::vector<std::vector<RamDomain>> numberFilters;
+
+private:
+    /**
+     * Read the part of the relation observed by the program from the
+     * "pushdown" parameters, see IOAttributesTransformer::getPushdown.
+     * Readers may skip the unused columns and the rows outside the filters.
+     */
+    void readPushdown() {
+        usedColumns.assign(arity, true);
+        symbolFilters.resize(arity);
+        numberFilters.resize(arity);
+        auto&& pushdown = params["pushdown"];
+        if (pushdown.is_null() || auxiliaryArity > 0) {
+            return;
+        }
+        auto&& used = pushdown["columns"].array_items();
+        for (std::size_t column = 0; column < arity && column < used.size(); column++) {
+            usedColumns[column] = used[column].bool_value();
+        }
+        for (auto&& filter : pushdown["filters"].array_items()) {
+            const auto column = static_cast<std::size_t>(filter["column"].long_value());
+            for (auto&& value : filter["values"].array_items()) {
+                switch (typeAttributes.at(column)[0]) {
+                    case 's': symbolFilters[column].push_back(value.string_value()); break;
+                    case 'i':
+                        numberFilters[column].push_back(
+                                RamSignedFromString(value.string_value(), nullptr, 0));
+                        break;
+                    case 'u':
+                        numberFilters[column].push_back(
+                                ramBitCast(RamUnsignedFromString(value.string_value(), nullptr, 0)));
+                        break;
+                    default: break;
+                }
+            }
+        }
+    }
 };
 
 class ReadStreamFactory {
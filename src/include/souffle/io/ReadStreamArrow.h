@@ -0,0 +1,333 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ReadStreamArrow.h
+ *
+ * Reads relations from the columns of Parquet and Arrow IPC files.
+ *
+ * Attributes are read from the columns of the same name, and only these
+ * columns are read from the file. Numbers are read from numeric columns,
+ * symbols from string columns, preferably dictionary-encoded, and records
+ * and ADTs from string columns in the syntax of the CSV format.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/ReadStream.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/properties.h>
+#include <parquet/schema.h>
+
+namespace souffle {
+
+class ReadStreamArrow : public ReadStream {
+protected:
+    ReadStreamArrow(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable, const std::string& extension)
+            : ReadStream(rwOperation, symbolTable, recordTable),
+              fileName(getFileName(rwOperation, extension)), columns(arity), dictionaries(arity) {
+        for (const auto& name : params["relation"]["params"].array_items()) {
+            columnNames.push_back(name.string_value());
+        }
+        if (columnNames.size() != arity) {
+            throw std::invalid_argument("Missing attribute names to read " + fileName);
+        }
+    }
+
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        const std::size_t width = arity + auxiliaryArity;
+        std::size_t count = 0;
+        while (count < capacity) {
+            if (row == rows) {
+                if (!readNextBatch()) {
+                    break;
+                }
+                continue;
+            }
+            // the values are stored by column, and copied into the tuples row by row
+            const std::size_t n = std::min(capacity - count, rows - row);
+            std::fill_n(&tuples[count * width], n * width, 0);
+            for (std::size_t column = 0; column < arity; column++) {
+                const RamDomain* values = &columns[column][row];
+                for (std::size_t i = 0; i < n; i++) {
+                    tuples[(count + i) * width + column] = values[i];
+                }
+            }
+            row += n;
+            count += n;
+        }
+        return count;
+    }
+
+    /** Read the next batch of rows, or return null at the end of the file */
+    virtual std::shared_ptr<arrow::RecordBatch> readBatch() = 0;
+
+    /** Check the index of the column of an attribute, which is negative if the file has no such column */
+    int checkColumn(int index, std::size_t column) const {
+        if (index < 0) {
+            throw std::invalid_argument("Missing column " + columnNames[column] + " in " + fileName);
+        }
+        return index;
+    }
+
+    void check(const arrow::Status& status) const {
+        if (!status.ok()) {
+            throw std::invalid_argument("Cannot read " + fileName + ": " + status.ToString());
+        }
+    }
+
+    template <typename T>
+    T check(arrow::Result<T> result) const {
+        check(result.status());
+        return std::move(result).ValueOrDie();
+    }
+
+    /**
+     * Return given filename or construct from relation name.
+     * Default name is [configured path]/[relation name][extension]
+     *
+     * @param rwOperation map of IO configuration options
+     * @return input filename
+     */
+    static std::string getFileName(
+            const std::map<std::string, std::string>& rwOperation, const std::string& extension) {
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + extension);
+        if (name.front() != '/') {
+            name = getOr(rwOperation, "fact-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    const std::string fileName;
+
+    /** Names of the columns of the attributes */
+    std::vector<std::string> columnNames;
+
+private:
+    bool readNextBatch() {
+        auto batch = readBatch();
+        if (batch == nullptr) {
+            return false;
+        }
+        rows = static_cast<std::size_t>(batch->num_rows());
+        row = 0;
+        for (std::size_t column = 0; column < arity; column++) {
+            convertColumn(*batch->GetColumnByName(columnNames[column]), column, columns[column]);
+        }
+        return true;
+    }
+
+    /** Convert the values of a column into the RAM domain */
+    void convertColumn(const arrow::Array& array, std::size_t column, std::vector<RamDomain>& values) {
+        if (array.null_count() > 0) {
+            throw std::invalid_argument("Null value in column " + columnNames[column] + " of " + fileName);
+        }
+        values.resize(static_cast<std::size_t>(array.length()));
+        switch (array.type_id()) {
+            case arrow::Type::INT8: return convertNumbers<arrow::Int8Array>(array, column, values);
+            case arrow::Type::INT16: return convertNumbers<arrow::Int16Array>(array, column, values);
+            case arrow::Type::INT32: return convertNumbers<arrow::Int32Array>(array, column, values);
+            case arrow::Type::INT64: return convertNumbers<arrow::Int64Array>(array, column, values);
+            case arrow::Type::UINT8: return convertNumbers<arrow::UInt8Array>(array, column, values);
+            case arrow::Type::UINT16: return convertNumbers<arrow::UInt16Array>(array, column, values);
+            case arrow::Type::UINT32: return convertNumbers<arrow::UInt32Array>(array, column, values);
+            case arrow::Type::UINT64: return convertNumbers<arrow::UInt64Array>(array, column, values);
+            case arrow::Type::FLOAT: return convertNumbers<arrow::FloatArray>(array, column, values);
+            case arrow::Type::DOUBLE: return convertNumbers<arrow::DoubleArray>(array, column, values);
+            case arrow::Type::STRING: return convertStrings<arrow::StringArray>(array, column, values);
+            case arrow::Type::LARGE_STRING:
+                return convertStrings<arrow::LargeStringArray>(array, column, values);
+            case arrow::Type::DICTIONARY:
+                return convertDictionary(static_cast<const arrow::DictionaryArray&>(array), column, values);
+            default:
+                throw std::invalid_argument("Unsupported type " + array.type()->ToString() + " of column " +
+                                            columnNames[column] + " in " + fileName);
+        }
+    }
+
+    template <typename Array>
+    void convertNumbers(const arrow::Array& array, std::size_t column, std::vector<RamDomain>& values) {
+        const auto& numbers = static_cast<const Array&>(array);
+        const char type = typeAttributes[column][0];
+        for (std::size_t i = 0; i < values.size(); i++) {
+            const auto value = numbers.Value(static_cast<int64_t>(i));
+            switch (type) {
+                case 'i': values[i] = static_cast<RamSigned>(value); break;
+                case 'u': values[i] = ramBitCast(static_cast<RamUnsigned>(value)); break;
+                case 'f': values[i] = ramBitCast(static_cast<RamFloat>(value)); break;
+                default:
+                    throw std::invalid_argument("Expected " + typeAttributes[column] + " in column " +
+                                                columnNames[column] + " of " + fileName + ", got numbers");
+            }
+        }
+    }
+
+    template <typename Array>
+    void convertStrings(const arrow::Array& array, std::size_t column, std::vector<RamDomain>& values) {
+        const auto& strings = static_cast<const Array&>(array);
+        const std::string& type = typeAttributes[column];
+        for (std::size_t i = 0; i < values.size(); i++) {
+            const std::string element = strings.GetString(static_cast<int64_t>(i));
+            try {
+                switch (type[0]) {
+                    case 's': values[i] = symbolTable.encode(element); break;
+                    case 'i': values[i] = RamSignedFromString(element); break;
+                    case 'u': values[i] = ramBitCast(RamUnsignedFromString(element)); break;
+                    case 'f': values[i] = ramBitCast(RamFloatFromString(element)); break;
+                    case 'r': values[i] = readRecord(element, type); break;
+                    case '+': values[i] = readADT(element, type); break;
+                    default: fatal("invalid type attribute: `%c`", type[0]);
+                }
+            } catch (...) {
+                throw std::invalid_argument("Error converting <" + element + "> in column " +
+                                            columnNames[column] + " of " + fileName);
+            }
+        }
+    }
+
+    /** Convert a dictionary-encoded column, converting each entry of the dictionary once */
+    void convertDictionary(
+            const arrow::DictionaryArray& array, std::size_t column, std::vector<RamDomain>& values) {
+        auto& dictionary = dictionaries[column];
+        if (dictionary.first != array.dictionary()) {
+            dictionary.first = array.dictionary();
+            convertColumn(*dictionary.first, column, dictionary.second);
+        }
+        for (std::size_t i = 0; i < values.size(); i++) {
+            values[i] = dictionary.second[array.GetValueIndex(static_cast<int64_t>(i))];
+        }
+    }
+
+    /** Values of the current batch, by column */
+    std::vector<std::vector<RamDomain>> columns;
+
+    /** Last dictionary of each column, and its entries converted into the RAM domain */
+    std::vector<std::pair<std::shared_ptr<arrow::Array>, std::vector<RamDomain>>> dictionaries;
+
+    std::size_t rows = 0;
+    std::size_t row = 0;
+};
+
+class ReadStreamParquet : public ReadStreamArrow {
+public:
+    ReadStreamParquet(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStreamArrow(rwOperation, symbolTable, recordTable, ".parquet") {
+        parquet::arrow::FileReaderBuilder builder;
+        check(builder.OpenFile(fileName));
+
+        const parquet::SchemaDescriptor& schema = *builder.raw_reader()->metadata()->schema();
+        parquet::ArrowReaderProperties properties;
+        std::vector<int> leaves;
+        for (std::size_t column = 0; column < arity; column++) {
+            leaves.push_back(checkColumn(schema.ColumnIndex(columnNames[column]), column));
+            // symbols are read dictionary-encoded, such that each distinct string is encoded once
+            if (typeAttributes[column][0] == 's') {
+                properties.set_read_dictionary(leaves.back(), true);
+            }
+        }
+        check(builder.properties(properties)->Build(&reader));
+
+        // only the column chunks of the attributes are read and decoded
+        std::vector<int> rowGroups(reader->num_row_groups());
+        std::iota(rowGroups.begin(), rowGroups.end(), 0);
+        check(reader->GetRecordBatchReader(rowGroups, leaves, &batches));
+    }
+
+protected:
+    std::shared_ptr<arrow::RecordBatch> readBatch() override {
+        std::shared_ptr<arrow::RecordBatch> batch;
+        check(batches->ReadNext(&batch));
+        return batch;
+    }
+
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    std::unique_ptr<arrow::RecordBatchReader> batches;
+};
+
+class ReadStreamArrowIPC : public ReadStreamArrow {
+public:
+    ReadStreamArrowIPC(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStreamArrow(rwOperation, symbolTable, recordTable, ".arrow") {
+        auto input = check(arrow::io::ReadableFile::Open(fileName));
+        auto schema = check(arrow::ipc::RecordBatchFileReader::Open(input))->schema();
+
+        // only the buffers of the attributes are read
+        auto options = arrow::ipc::IpcReadOptions::Defaults();
+        for (std::size_t column = 0; column < arity; column++) {
+            int field = checkColumn(schema->GetFieldIndex(columnNames[column]), column);
+            options.included_fields.push_back(field);
+        }
+        reader = check(arrow::ipc::RecordBatchFileReader::Open(input, options));
+    }
+
+protected:
+    std::shared_ptr<arrow::RecordBatch> readBatch() override {
+        if (nextBatch == reader->num_record_batches()) {
+            return nullptr;
+        }
+        return check(reader->ReadRecordBatch(nextBatch++));
+    }
+
+    std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader;
+    int nextBatch = 0;
+};
+
+class ReadParquetFactory : public ReadStreamFactory {
+public:
+    Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable) override {
+        return mk<ReadStreamParquet>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "parquet";
+        return name;
+    }
+    ~ReadParquetFactory() override = default;
+};
+
+class ReadArrowFactory : public ReadStreamFactory {
+public:
+    Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable) override {
+        return mk<ReadStreamArrowIPC>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "arrow";
+        return name;
+    }
+    ~ReadArrowFactory() override = default;
+};
+
+} /* namespace souffle */
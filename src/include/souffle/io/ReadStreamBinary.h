@@ -0,0 +1,242 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ReadStreamBinary.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/BinaryFormat.h"
+#include "souffle/io/ReadStream.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/FileUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Reads a relation from a binary snapshot (see BinaryFormat.h).
+ *
+ * The symbol section is loaded up-front and each symbol is encoded once;
+ * tuples are then read in blocks without any parsing. Spilled relations
+ * are loaded without translating their values, and their file is removed
+ * once it has been read. Snapshots referring to a symbol file are translated
+ * by the symbol table's attachment to that file instead.
+ */
+class ReadFileBinary : public ReadStream {
+public:
+    ReadFileBinary(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStream(rwOperation, symbolTable, recordTable), raw(rwOperation.at("IO") == "spill"),
+              symbolFile(getSymbolFileName(rwOperation)), fileName(getFileName(rwOperation)),
+              baseName(souffle::baseName(fileName)), file(fileName, std::ios::in | std::ios::binary) {
+        if (!file.is_open()) {
+            // suppress error message in case file cannot be open when flag -w is set
+            if (getOr(rwOperation, "no-warn", "false") != "true") {
+                throw std::invalid_argument("Cannot open binary file " + baseName + "\n");
+            }
+            return;
+        }
+        try {
+            readHeader();
+            readSymbols();
+        } catch (std::exception& e) {
+            throw std::invalid_argument(std::string(e.what()) + " in binary file " + baseName + "\n");
+        }
+    }
+
+    ~ReadFileBinary() override {
+        if (raw && file.is_open()) {
+            file.close();
+            std::remove(fileName.c_str());
+        }
+    }
+
+protected:
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        const std::size_t width = typeAttributes.size();
+        const std::size_t count = std::min<std::uint64_t>(remaining, capacity);
+        std::fill_n(tuples, count * width, 0);
+        for (std::size_t i = 0; i < count && arity > 0; ++i) {
+            if (position == buffered) {
+                fillBuffer();
+            }
+            RamDomain* tuple = &tuples[i * width];
+            std::memcpy(tuple, &buffer[position * arity], arity * sizeof(RamDomain));
+            for (std::size_t col = 0; col < arity; ++col) {
+                if (typeAttributes[col][0] == 's' && !raw) {
+                    tuple[col] = symbolAt(tuple[col]);
+                }
+            }
+            ++position;
+        }
+        remaining -= count;
+        return count;
+    }
+
+    void readHeader() {
+        char magic[sizeof(binary_format::MAGIC)];
+        if (!file.read(magic, sizeof(magic)) ||
+                std::memcmp(magic, binary_format::MAGIC, sizeof(magic)) != 0) {
+            throw std::invalid_argument("invalid header");
+        }
+        if (binary_format::read<std::uint32_t>(file) != binary_format::VERSION) {
+            throw std::invalid_argument("unsupported version");
+        }
+        if (binary_format::read<std::uint32_t>(file) != arity) {
+            throw std::invalid_argument("arity mismatch");
+        }
+        if (binary_format::read<std::uint32_t>(file) != sizeof(RamDomain)) {
+            throw std::invalid_argument("RamDomain size mismatch");
+        }
+        const auto flags = binary_format::read<std::uint32_t>(file);
+        if ((flags == binary_format::FLAG_RAW) != raw) {
+            throw std::invalid_argument(raw ? "not a spilled relation" : "spilled relation");
+        }
+        if ((flags == binary_format::FLAG_SHARED_SYMBOLS) != (!raw && !symbolFile.empty())) {
+            throw std::invalid_argument(symbolFile.empty() ? "symbols refer to a symbol file"
+                                                           : "symbols do not refer to a symbol file");
+        }
+        remaining = binary_format::read<std::uint64_t>(file);
+        symbolOffset = binary_format::read<std::uint64_t>(file);
+        for (std::size_t i = 0; i < arity && !raw; ++i) {
+            if (!binary_format::isSupported(typeAttributes[i])) {
+                throw std::invalid_argument("unsupported attribute type " + typeAttributes[i]);
+            }
+        }
+    }
+
+    void readSymbols() {
+        if (!raw && !symbolFile.empty()) {
+            symbolMap = &symbolTable.attach(symbolFile);
+            return;
+        }
+        file.seekg(static_cast<std::streamoff>(symbolOffset));
+        const auto count = binary_format::read<std::uint64_t>(file);
+        std::vector<std::string> names(count);
+        for (auto& symbol : names) {
+            symbol.resize(binary_format::read<std::uint64_t>(file));
+            if (!file.read(&symbol[0], static_cast<std::streamsize>(symbol.size()))) {
+                throw std::invalid_argument("truncated symbol section");
+            }
+        }
+        symbols.resize(count);
+        symbolTable.encodeBatch(names.begin(), names.end(), symbols.begin());
+        file.seekg(binary_format::HEADER_SIZE);
+    }
+
+    void fillBuffer() {
+        const std::size_t count = std::min<std::uint64_t>(remaining, binary_format::BLOCK_SIZE);
+        buffer.resize(count * arity);
+        if (!file.read(reinterpret_cast<char*>(buffer.data()),
+                    static_cast<std::streamsize>(buffer.size() * sizeof(RamDomain)))) {
+            throw std::invalid_argument("Truncated binary file " + baseName + "\n");
+        }
+        buffered = count;
+        position = 0;
+    }
+
+    RamDomain symbolAt(RamDomain local) const {
+        if (local < 0 || static_cast<std::size_t>(local) >= symbolMap->size() || (*symbolMap)[local] < 0) {
+            throw std::invalid_argument("Invalid symbol reference in binary file " + baseName + "\n");
+        }
+        return (*symbolMap)[local];
+    }
+
+    /**
+     * Return given filename or construct from relation name.
+     * Default name is [configured path]/[relation name].bin
+     * Spilled relations are named by the translator, independent of the fact directory.
+     *
+     * @param rwOperation map of IO configuration options
+     * @return input filename
+     */
+    static std::string getFileName(const std::map<std::string, std::string>& rwOperation) {
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + ".bin");
+        if (name.front() != '/' && rwOperation.at("IO") != "spill") {
+            name = getOr(rwOperation, "fact-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    /** Return the symbol file given by the `symbols` option, relative to the fact directory. */
+    static std::string getSymbolFileName(const std::map<std::string, std::string>& rwOperation) {
+        auto name = getOr(rwOperation, "symbols", "");
+        if (!name.empty() && name.front() != '/') {
+            name = getOr(rwOperation, "fact-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    /** Values are loaded as they are, i.e., the snapshot is a spilled relation */
+    const bool raw;
+
+    /** The symbol file the symbol columns refer to, if any */
+    const std::string symbolFile;
+
+    std::string fileName;
+    std::string baseName;
+    std::ifstream file;
+
+    /** Symbol section, translated to indices of the symbol table */
+    std::vector<RamDomain> symbols;
+
+    /** Translation of the symbol references, either the symbol section or the attached symbol file */
+    const std::vector<RamDomain>* symbolMap = &symbols;
+
+    /** Current block of tuples */
+    std::vector<RamDomain> buffer;
+    std::size_t buffered = 0;
+    std::size_t position = 0;
+
+    std::uint64_t remaining = 0;
+    std::uint64_t symbolOffset = 0;
+};
+
+class ReadFileBinaryFactory : public ReadStreamFactory {
+public:
+    Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable) override {
+        return mk<ReadFileBinary>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "binary";
+        return name;
+    }
+
+    ~ReadFileBinaryFactory() override = default;
+};
+
+class ReadFileSpillFactory : public ReadFileBinaryFactory {
+public:
+    const std::string& getName() const override {
+        static const std::string name = "spill";
+        return name;
+    }
+
+    ~ReadFileSpillFactory() override = default;
+};
+
+} /* namespace souffle */
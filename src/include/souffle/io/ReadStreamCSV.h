@@ -17,27 +17,32 @@
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
+#include "souffle/io/MappedFile.h"
 #include "souffle/io/ReadStream.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/FileUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StringUtil.h"
 
 #ifdef USE_LIBZ
 #include "souffle/io/gzfstream.h"
-#else
-#include <fstream>
 #endif
 
 #include <algorithm>
 #include <cassert>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 namespace souffle {
@@ -49,7 +54,8 @@ public:
             : ReadStream(rwOperation, symbolTable, recordTable),
               rfc4180(getOr(rwOperation, "rfc4180", "false") == std::string("true")),
               delimiter(getOr(rwOperation, "delimiter", (rfc4180 ? "," : "\t"))), file(file), lineNumber(0),
-              inputMap(getInputColumnMap(rwOperation, static_cast<unsigned int>(arity))) {
+              inputMap(getInputColumnMap(rwOperation, static_cast<unsigned int>(arity))),
+              parallel(isParallelisable()) {
         if (rfc4180 && delimiter.find('"') != std::string::npos) {
             std::stringstream errorMessage;
             errorMessage << "CSV delimiter cannot contain '\"' character when rfc4180 is enabled.";
@@ -63,82 +69,183 @@ public:
     }
 
 protected:
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        if (parallel) {
+            return readParsedTuples(tuples, capacity);
+        }
+        const std::size_t width = typeAttributes.size();
+        std::size_t count = 0;
+        if (mapped.data() != nullptr) {
+            std::string_view line;
+            while (count < capacity && nextMappedLine(line)) {
+                if (parseLine(line, &tuples[count * width])) {
+                    ++count;
+                }
+            }
+            return count;
+        }
+        std::string line;
+        while (count < capacity && getline(file, line)) {
+            if (parseLine(line, &tuples[count * width])) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
     /**
-     * Read and return the next tuple.
+     * Read the input from the given bytes, e.g. a mapped file, instead of
+     * the stream.
+     */
+    void useMappedInput(std::string_view text) {
+        mapped = text;
+        mappedPosition = 0;
+    }
+
+    /**
+     * Advance to the next line of the mapped input.
      *
-     * Returns nullptr if no tuple was readable.
-     * @return
+     * @return false at the end of the input
      */
-    Own<RamDomain[]> readNextTuple() override {
-        if (file.eof()) {
-            return nullptr;
+    bool nextMappedLine(std::string_view& line) {
+        if (mappedPosition >= mapped.size()) {
+            return false;
         }
-        std::string line;
-        Own<RamDomain[]> tuple = mk<RamDomain[]>(typeAttributes.size());
+        const char* begin = mapped.data() + mappedPosition;
+        const auto* newline =
+                static_cast<const char*>(std::memchr(begin, '\n', mapped.size() - mappedPosition));
+        const std::size_t end =
+                newline == nullptr ? mapped.size() : static_cast<std::size_t>(newline - mapped.data());
+        line = mapped.substr(mappedPosition, end - mappedPosition);
+        mappedPosition = end + 1;
+        return true;
+    }
 
-        if (!getline(file, line)) {
-            return nullptr;
-        }
+    /**
+     * Convert a line of the input into the given tuple.
+     *
+     * Columns unused by the program are left zero.
+     *
+     * @return false if the line is outside the filters pushed down by the program
+     */
+    bool parseLine(std::string_view line, RamDomain* tuple) {
         // Handle Windows line endings on non-Windows systems
         if (!line.empty() && line.back() == '\r') {
-            line = line.substr(0, line.length() - 1);
+            line.remove_suffix(1);
         }
         ++lineNumber;
 
+        std::fill_n(tuple, typeAttributes.size(), 0);
+        return parseFields(line, tuple, lineNumber, lastSymbols);
+    }
+
+    /** The last symbol encoded per column, since consecutive lines frequently share symbols */
+    struct SymbolCache {
+        std::vector<std::string> symbols;
+        std::vector<RamDomain> indices;
+    };
+
+    /**
+     * Convert the fields of a line into the given tuple, tokenising the line
+     * in place; only quoted fields and records are copied.
+     *
+     * @return false if the line is outside the filters pushed down by the program
+     */
+    bool parseFields(std::string_view line, RamDomain* tuple, std::size_t lineNo, SymbolCache& cache) {
+        if (cache.indices.size() != arity) {
+            cache.symbols.assign(arity, {});
+            cache.indices.assign(arity, -1);
+        }
+        std::string quoted;
         std::size_t start = 0;
         std::size_t columnsFilled = 0;
         for (uint32_t column = 0; columnsFilled < arity; column++) {
-            std::size_t charactersRead = 0;
-            std::string element = nextElement(line, start);
-            if (inputMap.count(column) == 0) {
+            std::string_view element;
+            if (rfc4180) {
+                quoted = nextElement(line, start, lineNo);
+                element = quoted;
+            } else {
+                element = nextField(line, start, lineNo);
+            }
+            auto target = inputMap.find(column);
+            if (target == inputMap.end()) {
                 continue;
             }
             ++columnsFilled;
 
+            const std::size_t col = target->second;
+            if (!usedColumns[col]) {
+                continue;
+            }
+            const auto& ty = typeAttributes[col];
             try {
-                auto&& ty = typeAttributes.at(inputMap[column]);
-                switch (ty[0]) {
-                    case 's': {
-                        tuple[inputMap[column]] = symbolTable.encode(element);
-                        charactersRead = element.size();
-                        break;
-                    }
-                    case 'r': {
-                        tuple[inputMap[column]] = readRecord(element, ty, 0, &charactersRead);
-                        break;
-                    }
-                    case '+': {
-                        tuple[inputMap[column]] = readADT(element, ty, 0, &charactersRead);
-                        break;
-                    }
-                    case 'i': {
-                        tuple[inputMap[column]] = RamSignedFromString(element, &charactersRead);
-                        break;
+                if (!acceptsSymbol(col, element)) {
+                    return false;
+                }
+                if (ty[0] == 's') {
+                    if (cache.indices[col] == -1 || cache.symbols[col] != element) {
+                        cache.symbols[col].assign(element.data(), element.size());
+                        cache.indices[col] = symbolTable.encode(element);
                     }
-                    case 'u': {
-                        tuple[inputMap[column]] = ramBitCast(readRamUnsigned(element, charactersRead));
-                        break;
+                    tuple[col] = cache.indices[col];
+                } else {
+                    if (!convertInPlace(element, ty, tuple[col])) {
+                        tuple[col] = convertElement(std::string(element), ty);
                     }
-                    case 'f': {
-                        tuple[inputMap[column]] = ramBitCast(RamFloatFromString(element, &charactersRead));
-                        break;
+                    if (!acceptsNumber(col, tuple[col])) {
+                        return false;
                     }
-                    default: fatal("invalid type attribute: `%c`", ty[0]);
-                }
-                // Check if everything was read.
-                if (charactersRead != element.size()) {
-                    throw std::invalid_argument(
-                            "Expected: " + delimiter + " or \\n. Got: " + element[charactersRead]);
                 }
             } catch (...) {
                 std::stringstream errorMessage;
-                errorMessage << "Error converting <" + element + "> in column " << column + 1 << " in line "
-                             << lineNumber << "; ";
+                errorMessage << "Error converting <" << element << "> in column " << column + 1 << " in line "
+                             << lineNo << "; ";
                 throw std::invalid_argument(errorMessage.str());
             }
         }
+        return true;
+    }
 
-        return tuple;
+    /**
+     * Convert an element of a line to a value of the given type attribute.
+     */
+    RamDomain convertElement(const std::string& element, const std::string& ty) {
+        std::size_t charactersRead = 0;
+        RamDomain value = 0;
+        switch (ty[0]) {
+            case 's': {
+                value = symbolTable.encode(element);
+                charactersRead = element.size();
+                break;
+            }
+            case 'r': {
+                value = readRecord(element, ty, 0, &charactersRead);
+                break;
+            }
+            case '+': {
+                value = readADT(element, ty, 0, &charactersRead);
+                break;
+            }
+            case 'i': {
+                value = RamSignedFromString(element, &charactersRead);
+                break;
+            }
+            case 'u': {
+                value = ramBitCast(readRamUnsigned(element, charactersRead));
+                break;
+            }
+            case 'f': {
+                value = ramBitCast(RamFloatFromString(element, &charactersRead));
+                break;
+            }
+            default: fatal("invalid type attribute: `%c`", ty[0]);
+        }
+        // Check if everything was read.
+        if (charactersRead != element.size()) {
+            throw std::invalid_argument(
+                    "Expected: " + delimiter + " or \\n. Got: " + element[charactersRead]);
+        }
+        return value;
     }
 
     /**
@@ -162,11 +269,15 @@ protected:
         return value;
     }
 
-    std::string nextElement(const std::string& line, std::size_t& start) {
+    /**
+     * Return the next field of a line, starting at the given position, with
+     * the quotes of a quoted field removed.
+     */
+    std::string nextElement(std::string_view line, std::size_t& start, std::size_t lineNo) const {
         std::string element;
 
         if (rfc4180) {
-            if (line[start] == '"') {
+            if (start < line.length() && line[start] == '"') {
                 // quoted field
                 const std::size_t end = line.length();
                 std::size_t pos = start + 1;
@@ -188,7 +299,7 @@ protected:
                 if (!foundEndQuote) {
                     // missing closing quote
                     std::stringstream errorMessage;
-                    errorMessage << "Unbalanced field quote in line " << lineNumber << "; ";
+                    errorMessage << "Unbalanced field quote in line " << lineNo << "; ";
                     throw std::invalid_argument(errorMessage.str());
                 }
 
@@ -198,7 +309,7 @@ protected:
                     if (nextDelimiter != pos) {
                         std::stringstream errorMessage;
                         errorMessage << "Separator expected immediately after quoted field in line "
-                                     << lineNumber << "; ";
+                                     << lineNo << "; ";
                         throw std::invalid_argument(errorMessage.str());
                     }
                 }
@@ -215,6 +326,13 @@ protected:
             }
         }
 
+        return std::string(nextField(line, start, lineNo));
+    }
+
+    /**
+     * Return the next non-quoted field of a line, starting at the given position.
+     */
+    std::string_view nextField(std::string_view line, std::size_t& start, std::size_t lineNo) const {
         std::size_t end = start;
         // Handle record/tuple delimiter coincidence.
         if (delimiter.find(',') != std::string::npos) {
@@ -222,7 +340,8 @@ protected:
             std::size_t next_delimiter = line.find(delimiter, start);
 
             // Find first delimiter after the record.
-            while (end < std::min(next_delimiter, line.length()) || record_parens != 0) {
+            while ((end < std::min(next_delimiter, line.length()) || record_parens != 0) &&
+                    end < line.length()) {
                 // Track the number of parenthesis.
                 if (line[end] == '[') {
                     ++record_parens;
@@ -247,7 +366,7 @@ protected:
             // Handle the end-of-the-line case where parenthesis are unbalanced.
             if (record_parens != 0) {
                 std::stringstream errorMessage;
-                errorMessage << "Unbalanced record parenthesis in line " << lineNumber << "; ";
+                errorMessage << "Unbalanced record parenthesis in line " << lineNo << "; ";
                 throw std::invalid_argument(errorMessage.str());
             }
         } else {
@@ -257,16 +376,253 @@ protected:
         // Check for missing value.
         if (start > end) {
             std::stringstream errorMessage;
-            errorMessage << "Values missing in line " << lineNumber << "; ";
+            errorMessage << "Values missing in line " << lineNo << "; ";
             throw std::invalid_argument(errorMessage.str());
         }
 
-        element = line.substr(start, end - start);
+        std::string_view element = line.substr(start, end - start);
         start = end + delimiter.size();
 
         return element;
     }
 
+    /** Number of bytes read per parallel block */
+    static constexpr std::size_t PARALLEL_BLOCK_SIZE = 64 << 20;
+
+    /** Number of chunks a block is split into per thread */
+    static constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+    /** A newline-aligned range of the current block and its parsed tuples */
+    struct ParsedChunk {
+        std::size_t begin;
+        std::size_t end;
+        std::size_t firstLine;
+        std::vector<RamDomain> rows;
+        std::string error;
+    };
+
+    /**
+     * Check whether lines can be parsed concurrently.
+     *
+     * Quoted fields may span lines and records/ADTs are packed in order, so
+     * only plain numeric and symbol columns are read in parallel; unused
+     * columns are not converted and may be of any type.
+     */
+    bool isParallelisable() const {
+#ifdef IS_PARALLEL
+        if (MAX_THREADS <= 1 || rfc4180 || arity == 0) {
+            return false;
+        }
+        for (std::size_t i = 0; i < arity; ++i) {
+            if (!usedColumns[i]) {
+                continue;
+            }
+            switch (typeAttributes[i][0]) {
+                case 'i':
+                case 'u':
+                case 'f':
+                case 's': break;
+                default: return false;
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Copy the next tuples of the current block, parsing further blocks when
+     * it is exhausted.
+     */
+    std::size_t readParsedTuples(RamDomain* tuples, std::size_t capacity) {
+        const std::size_t width = typeAttributes.size();
+        std::size_t count = 0;
+        while (count < capacity) {
+            if (currentChunk == chunks.size()) {
+                if (!parseNextBlock()) {
+                    break;
+                }
+                continue;
+            }
+            const auto& rows = chunks[currentChunk].rows;
+            if (chunkPosition == rows.size()) {
+                ++currentChunk;
+                chunkPosition = 0;
+                continue;
+            }
+            const std::size_t n = std::min(capacity - count, (rows.size() - chunkPosition) / width);
+            std::copy_n(&rows[chunkPosition], n * width, &tuples[count * width]);
+            chunkPosition += n * width;
+            count += n;
+        }
+        return count;
+    }
+
+    /**
+     * Read the next block of complete lines from the input and parse it in
+     * newline-aligned chunks, one chunk per task.
+     *
+     * @return false if the input is exhausted
+     */
+    bool parseNextBlock() {
+        chunks.clear();
+        currentChunk = 0;
+        chunkPosition = 0;
+        if (!(mapped.data() != nullptr ? nextMappedBlock() : readNextBlock())) {
+            return false;
+        }
+        splitBlock();
+
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < chunks.size(); ++i) {
+            parseChunk(chunks[i]);
+        }
+        PARALLEL_END
+
+        lineNumber += static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+        for (const auto& chunk : chunks) {
+            if (!chunk.error.empty()) {
+                throw std::invalid_argument(chunk.error);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Take the next block of complete lines of the mapped input, without
+     * copying it.
+     *
+     * @return false if the input is exhausted
+     */
+    bool nextMappedBlock() {
+        if (mappedPosition >= mapped.size()) {
+            return false;
+        }
+        std::size_t end = std::min(mappedPosition + PARALLEL_BLOCK_SIZE, mapped.size());
+        if (end < mapped.size()) {
+            end = mapped.find('\n', end);
+            end = (end == std::string_view::npos) ? mapped.size() : end + 1;
+        }
+        text = mapped.substr(mappedPosition, end - mappedPosition);
+        mappedPosition = end;
+        return true;
+    }
+
+    /**
+     * Read the next block of complete lines from the stream.
+     *
+     * @return false if the input is exhausted
+     */
+    bool readNextBlock() {
+        while (true) {
+            // prepend the incomplete last line of the previous block
+            block.swap(carry);
+            carry.clear();
+            const std::size_t offset = block.size();
+            block.resize(offset + PARALLEL_BLOCK_SIZE);
+            file.read(&block[offset], PARALLEL_BLOCK_SIZE);
+            block.resize(offset + static_cast<std::size_t>(file.gcount()));
+            if (file) {
+                const std::size_t last = block.rfind('\n');
+                if (last == std::string::npos) {
+                    block.swap(carry);
+                    continue;
+                }
+                carry.assign(block, last + 1, std::string::npos);
+                block.resize(last + 1);
+            } else if (block.empty()) {
+                return false;
+            }
+            text = block;
+            return true;
+        }
+    }
+
+    /**
+     * Split the current block into newline-aligned chunks.
+     */
+    void splitBlock() {
+        const std::size_t count = static_cast<std::size_t>(MAX_THREADS) * CHUNKS_PER_THREAD;
+        std::size_t begin = 0;
+        std::size_t firstLine = lineNumber;
+        for (std::size_t i = 1; i <= count && begin < text.size(); ++i) {
+            std::size_t end = text.size();
+            if (i < count) {
+                end = text.find('\n', std::max(begin, text.size() / count * i));
+                end = (end == std::string_view::npos) ? text.size() : end + 1;
+            }
+            chunks.push_back({begin, end, firstLine, {}, {}});
+            firstLine += static_cast<std::size_t>(std::count(text.begin() + begin, text.begin() + end, '\n'));
+            begin = end;
+        }
+    }
+
+    /**
+     * Parse the lines of a chunk; errors are recorded in the chunk since
+     * exceptions cannot leave a parallel region.
+     */
+    void parseChunk(ParsedChunk& chunk) {
+        const std::size_t width = typeAttributes.size();
+        SymbolCache cache;
+        std::size_t lineNo = chunk.firstLine;
+        std::size_t pos = chunk.begin;
+        try {
+            while (pos < chunk.end) {
+                std::size_t lineEnd = text.find('\n', pos);
+                lineEnd = std::min(lineEnd, chunk.end);
+                std::string_view line = text.substr(pos, lineEnd - pos);
+                // Handle Windows line endings on non-Windows systems
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                pos = lineEnd + 1;
+                ++lineNo;
+
+                chunk.rows.resize(chunk.rows.size() + width, 0);
+                if (!parseFields(line, &chunk.rows[chunk.rows.size() - width], lineNo, cache)) {
+                    chunk.rows.resize(chunk.rows.size() - width);
+                }
+            }
+        } catch (std::exception& e) {
+            chunk.error = e.what();
+        }
+    }
+
+    /**
+     * Convert plain decimal numbers without creating a string.
+     *
+     * @return false if the element needs the general conversion
+     */
+    static bool convertInPlace(std::string_view element, const std::string& ty, RamDomain& value) {
+        const char* first = element.data();
+        const char* last = first + element.size();
+        switch (ty[0]) {
+            case 'i': {
+                RamSigned result;
+                auto [ptr, ec] = std::from_chars(first, last, result);
+                if (ec != std::errc() || ptr != last || first == last) {
+                    return false;
+                }
+                value = result;
+                return true;
+            }
+            case 'u': {
+                RamUnsigned result;
+                if (element.size() > 1 && element[0] == '0' && (element[1] == 'b' || element[1] == 'x')) {
+                    return false;
+                }
+                auto [ptr, ec] = std::from_chars(first, last, result);
+                if (ec != std::errc() || ptr != last || first == last) {
+                    return false;
+                }
+                value = ramBitCast(result);
+                return true;
+            }
+            default: return false;
+        }
+    }
+
     std::map<int, int> getInputColumnMap(
             const std::map<std::string, std::string>& rwOperation, const unsigned arity_) const {
         std::string columnString = getOr(rwOperation, "columns", "");
@@ -296,6 +652,23 @@ protected:
     std::istream& file;
     std::size_t lineNumber;
     std::map<int, int> inputMap;
+
+    /** Last symbols encoded by the serial reader */
+    SymbolCache lastSymbols;
+
+    /** Input bytes read in place, if the input is mapped, and the position of the next line */
+    std::string_view mapped;
+    std::size_t mappedPosition = 0;
+
+    const bool parallel;
+
+    /** Lines of the current parallel block, in the mapped input or in the block read from the stream */
+    std::string_view text;
+    std::string block;
+    std::string carry;
+    std::vector<ParsedChunk> chunks;
+    std::size_t currentChunk = 0;
+    std::size_t chunkPosition = 0;
 };
 
 class ReadFileCSV : public ReadStreamCSV {
@@ -304,29 +677,33 @@ public:
             RecordTable& recordTable)
             : ReadStreamCSV(fileHandle, rwOperation, symbolTable, recordTable),
               baseName(souffle::baseName(getFileName(rwOperation))),
-              fileHandle(getFileName(rwOperation), std::ios::in | std::ios::binary) {
+              fileHandle(getFileName(rwOperation), std::ios::in | std::ios::binary),
+              mappedFile(getFileName(rwOperation)) {
         if (!fileHandle.is_open()) {
             // suppress error message in case file cannot be open when flag -w is set
             if (getOr(rwOperation, "no-warn", "false") != "true") {
                 throw std::invalid_argument("Cannot open fact file " + baseName + "\n");
             }
         }
+        // plain files are tokenised in place; compressed files are inflated by the stream
+        if (mappedFile.isMapped() && mappedFile.view().substr(0, 2) != "\x1f\x8b") {
+            useMappedInput(mappedFile.view());
+        }
         // Strip headers if we're using them
         if (getOr(rwOperation, "headers", "false") == "true") {
+            std::string_view header;
             std::string line;
-            getline(file, line);
+            if (mapped.data() != nullptr) {
+                nextMappedLine(header);
+            } else {
+                getline(file, line);
+            }
         }
     }
 
-    /**
-     * Read and return the next tuple.
-     *
-     * Returns nullptr if no tuple was readable.
-     * @return
-     */
-    Own<RamDomain[]> readNextTuple() override {
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
         try {
-            return ReadStreamCSV::readNextTuple();
+            return ReadStreamCSV::readNextTuples(tuples, capacity);
         } catch (std::exception& e) {
             std::stringstream errorMessage;
             errorMessage << e.what();
@@ -359,6 +736,121 @@ protected:
 #else
     std::ifstream fileHandle;
 #endif
+    MappedFile mappedFile;
+};
+
+/**
+ * Reads the lines of a named pipe or of the standard input in batches, while
+ * the program is evaluated.
+ *
+ * A line equal to the batch marker, by default an empty line, ends a batch;
+ * the end of the input ends the last batch.
+ */
+class ReadBatchCSV : public ReadStreamCSV {
+public:
+    ReadBatchCSV(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStreamCSV(getInput(rwOperation, fileHandle), rwOperation, symbolTable, recordTable),
+              marker(getOr(rwOperation, "batch-marker", "")) {
+        if (contains(rwOperation, "filename")) {
+            fileHandle.open(getFileName(rwOperation), std::ios::in | std::ios::binary);
+            if (!fileHandle.is_open()) {
+                throw std::invalid_argument("Cannot open input stream " + getFileName(rwOperation) + "\n");
+            }
+        }
+    }
+
+    ~ReadBatchCSV() override = default;
+
+    bool hasMoreBatches() const override {
+        return !closed;
+    }
+
+protected:
+    /**
+     * Read the next tuples of the current batch, stopping at the end of the batch.
+     */
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        const std::size_t width = typeAttributes.size();
+        std::size_t count = 0;
+        std::string line;
+        while (count < capacity) {
+            if (closed || !getline(file, line)) {
+                closed = true;
+                break;
+            }
+            // Handle Windows line endings on non-Windows systems
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line == marker) {
+                ++lineNumber;
+                break;
+            }
+            if (parseLine(line, &tuples[count * width])) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Return the stream to read, the given file or the standard input.
+     */
+    static std::istream& getInput(
+            const std::map<std::string, std::string>& rwOperation, std::ifstream& file) {
+        if (contains(rwOperation, "filename")) {
+            return file;
+        }
+        return std::cin;
+    }
+
+    static std::string getFileName(const std::map<std::string, std::string>& rwOperation) {
+        auto name = rwOperation.at("filename");
+        if (name.front() != '/') {
+            name = getOr(rwOperation, "fact-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    std::ifstream fileHandle;
+    const std::string marker;
+    bool closed = false;
+};
+
+/**
+ * Reads the facts of a relation given by the "data" directive, one tuple per
+ * line with tab-separated fields.
+ *
+ * Large sets of facts of a program are translated into such a table, which
+ * is tokenised in place, rather than into a statement per fact.
+ */
+class ReadInlineCSV : public ReadStreamCSV {
+public:
+    ReadInlineCSV(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStreamCSV(emptyStream, rwOperation, symbolTable, recordTable),
+              relationName(rwOperation.at("name")), data(rwOperation.at("data")) {
+        useMappedInput(data);
+    }
+
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        try {
+            return ReadStreamCSV::readNextTuples(tuples, capacity);
+        } catch (std::exception& e) {
+            std::stringstream errorMessage;
+            errorMessage << e.what();
+            errorMessage << "cannot parse facts of relation " << relationName << "!\n";
+            throw std::invalid_argument(errorMessage.str());
+        }
+    }
+
+    ~ReadInlineCSV() override = default;
+
+protected:
+    std::istringstream emptyStream;
+    const std::string relationName;
+    const std::string data;
 };
 
 class ReadCinCSVFactory : public ReadStreamFactory {
@@ -375,6 +867,34 @@ public:
     ~ReadCinCSVFactory() override = default;
 };
 
+class ReadBatchCSVFactory : public ReadStreamFactory {
+public:
+    Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable) override {
+        return mk<ReadBatchCSV>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "stream";
+        return name;
+    }
+    ~ReadBatchCSVFactory() override = default;
+};
+
+class ReadInlineCSVFactory : public ReadStreamFactory {
+public:
+    Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable) override {
+        return mk<ReadInlineCSV>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "inline";
+        return name;
+    }
+    ~ReadInlineCSVFactory() override = default;
+};
+
 class ReadFileCSVFactory : public ReadStreamFactory {
 public:
     Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
@@ -20,21 +20,29 @@
 #include "souffle/io/ReadStream.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/FileUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StringUtil.h"
 
 #include <algorithm>
-#include <cassert>
+#include <charconv>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
-#include <queue>
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <tuple>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace souffle {
@@ -46,273 +54,500 @@ template <typename... T>
     throw std::runtime_error(out.str());
 }
 
+/**
+ * Reads tuples from JSON text.
+ *
+ * The input is either an array of tuples, or, with ndjson=true, a tuple
+ * per line. Tuples are arrays of their attributes, or objects of them by
+ * name. Records are arrays or objects of their fields, and null for nil;
+ * ADTs are objects of a branch name and the array of the arguments of the
+ * branch, e.g. {"Cons": [1, {"Nil": []}]}, or just the name of a branch
+ * without arguments.
+ *
+ * The text is parsed straight into RamDomain values, without building
+ * JSON values first. Lines are read in blocks, which are split into chunks
+ * of lines parsed in parallel.
+ */
 class ReadStreamJSON : public ReadStream {
 public:
     ReadStreamJSON(std::istream& file, const std::map<std::string, std::string>& rwOperation,
             SymbolTable& symbolTable, RecordTable& recordTable)
-            : ReadStream(rwOperation, symbolTable, recordTable), file(file), pos(0), isInitialized(false) {
-        std::string err;
-        params = Json::parse(rwOperation.at("params"), err);
-        if (err.length() > 0) {
-            throwError("cannot get internal params: ", err);
+            : ReadStream(rwOperation, symbolTable, recordTable), file(file),
+              ndjson(getOr(rwOperation, "ndjson", "false") == "true") {
+        auto&& names = params["relation"]["params"].array_items();
+        for (std::size_t i = 0; i < names.size() && i < arity; ++i) {
+            columns.emplace(names[i].string_value(), i);
+        }
+        for (auto&& [name, recordInfo] : types["records"].object_items()) {
+            Fields& fields = records[name];
+            auto&& fieldNames = params["records"][name.substr(2)]["params"];
+            for (std::size_t i = 0; i < recordInfo["types"].array_items().size(); ++i) {
+                fields.types.push_back(recordInfo["types"][i].string_value());
+                fields.index.emplace(fieldNames[i].string_value(), i);
+            }
+        }
+        for (auto&& [name, adtInfo] : types["ADTs"].object_items()) {
+            ADT& adt = adts[name];
+            adt.isEnum = adtInfo["enum"].bool_value();
+            for (auto&& branch : adtInfo["branches"].array_items()) {
+                Fields fields;
+                for (auto&& argType : branch["types"].array_items()) {
+                    fields.types.push_back(argType.string_value());
+                }
+                adt.index.emplace(branch["name"].string_value(), adt.branches.size());
+                adt.branches.push_back(std::move(fields));
+            }
         }
     }
 
 protected:
+    /** Types and positions by name of the fields of a record, or of the arguments of an ADT branch */
+    struct Fields {
+        std::vector<std::string> types;
+        std::unordered_map<std::string, std::size_t> index;
+    };
+
+    struct ADT {
+        bool isEnum = false;
+        std::vector<Fields> branches;
+        std::unordered_map<std::string, std::size_t> index;
+    };
+
     std::istream& file;
-    std::size_t pos;
-    Json jsonSource;
-    Json params;
-    bool isInitialized;
-    bool useObjects;
-    std::map<const std::string, const std::size_t> paramIndex;
-
-    Own<RamDomain[]> readNextTuple() override {
-        // for some reasons we cannot initalized our json objects in constructor
-        // otherwise it will segfault, so we initialize in the first call
-        if (!isInitialized) {
-            isInitialized = true;
-            std::string error = "";
-            std::string source(std::istreambuf_iterator<char>(file), {});
 
-            jsonSource = Json::parse(source, error);
-            // it should be wrapped by an extra array
-            if (error.length() > 0 || !jsonSource.is_array()) {
-                throwError("cannot deserialize json because ", error, ":\n", source);
-            }
+    /** Tuples are read one per line, rather than as the elements of an array */
+    const bool ndjson;
 
-            if (jsonSource.array_items().empty()) {
-                // No tuples defined
-                return nullptr;
-            }
+    /** Text being parsed, and the position of the next tuple in it */
+    std::string text;
+    std::size_t pos = 0;
+    bool isInitialized = false;
+
+    /** Tuples parsed from the current block of lines, by chunk */
+    std::vector<std::vector<RamDomain>> parsed;
+    std::size_t chunk = 0;
+    std::size_t next = 0;
+
+    /** Attribute positions by name, for the object format */
+    std::unordered_map<std::string, std::size_t> columns;
+
+    std::map<std::string, Fields> records;
+    std::map<std::string, ADT> adts;
 
-            // we only check the first one, since there are extra checks
-            // in readNextTupleObject/readNextTupleList
-            if (jsonSource[0].is_array()) {
-                useObjects = false;
-            } else if (jsonSource[0].is_object()) {
-                useObjects = true;
-                std::size_t index_pos = 0;
-                for (auto param : params["relation"]["params"].array_items()) {
-                    paramIndex.insert(std::make_pair(param.string_value(), index_pos));
-                    index_pos++;
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        const std::size_t width = typeAttributes.size();
+        std::size_t count = 0;
+        if (ndjson) {
+            while (count < capacity) {
+                if (chunk == parsed.size()) {
+                    if (!readBlock()) {
+                        break;
+                    }
+                    continue;
+                }
+                if (next == parsed[chunk].size()) {
+                    ++chunk;
+                    next = 0;
+                    continue;
                 }
-            } else {
-                throwError("the input is neither list nor object format");
+                const std::size_t n = std::min(capacity - count, (parsed[chunk].size() - next) / width);
+                std::copy_n(&parsed[chunk][next], n * width, &tuples[count * width]);
+                next += n * width;
+                count += n;
             }
+            return count;
         }
 
-        if (useObjects) {
-            return readNextTupleObject();
-        } else {
-            return readNextTupleList();
+        while (count < capacity && nextElement()) {
+            // attributes missing from objects are left zero
+            RamDomain* tuple = &tuples[count * width];
+            std::fill_n(tuple, width, 0);
+            readTuple(text, pos, tuple);
+            ++count;
         }
+        return count;
     }
 
-    Own<RamDomain[]> readNextTupleList() {
-        if (pos >= jsonSource.array_items().size()) {
-            return nullptr;
+    /**
+     * Advance to the next tuple of the array.
+     *
+     * @return false at the end of the array
+     */
+    bool nextElement() {
+        if (!isInitialized) {
+            isInitialized = true;
+            text.assign(std::istreambuf_iterator<char>(file), {});
+            skipWhiteSpace(text, pos);
+            consume(text, pos, '[');
+            skipWhiteSpace(text, pos);
+            if (pos < text.size() && text[pos] == ']') {
+                // No tuples defined
+                pos = text.size();
+                return false;
+            }
+        } else if (pos < text.size()) {
+            skipWhiteSpace(text, pos);
+            if (text[pos] == ']') {
+                pos = text.size();
+                return false;
+            }
+            consume(text, pos, ',');
         }
+        return pos < text.size();
+    }
 
-        Own<RamDomain[]> tuple = mk<RamDomain[]>(typeAttributes.size());
-        const Json& jsonObj = jsonSource[pos];
-        assert(jsonObj.is_array() && "the input is not json array");
-        pos++;
-        for (std::size_t i = 0; i < typeAttributes.size(); ++i) {
+    /**
+     * Read the next block of lines and parse its chunks in parallel.
+     *
+     * @return false at the end of the input
+     */
+    bool readBlock() {
+        // keep the incomplete last line of the previous block
+        text.erase(0, pos);
+        pos = 0;
+        const std::size_t kept = text.size();
+        text.resize(kept + BLOCK_SIZE);
+        file.read(text.data() + kept, BLOCK_SIZE);
+        text.resize(kept + static_cast<std::size_t>(file.gcount()));
+        if (text.empty()) {
+            return false;
+        }
+        std::size_t end = text.size();
+        if (file) {
+            end = text.rfind('\n');
+            if (end == std::string::npos) {
+                // a line longer than a block is read with the next block
+                pos = 0;
+                parsed.clear();
+                chunk = next = 0;
+                return true;
+            }
+            ++end;
+        }
+
+        // split the block into chunks of whole lines
+        const std::size_t count = std::max<std::size_t>(MAX_THREADS, 1) * 4;
+        std::vector<std::size_t> bounds = {0};
+        for (std::size_t i = 1; i < count; ++i) {
+            const std::size_t bound = text.find('\n', std::max(bounds.back(), end * i / count));
+            bounds.push_back(bound == std::string::npos || bound >= end ? end : bound + 1);
+        }
+        bounds.push_back(end);
+
+        parsed.assign(count, {});
+        std::vector<std::string> errors(count);
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < count; ++i) {
             try {
-                auto&& ty = typeAttributes.at(i);
-                switch (ty[0]) {
-                    case 's': {
-                        tuple[i] = symbolTable.encode(jsonObj[i].string_value());
-                        break;
-                    }
-                    case 'r': {
-                        tuple[i] = readNextElementList(jsonObj[i], ty);
-                        break;
-                    }
-                    case 'i': {
-                        tuple[i] = jsonObj[i].int_value();
-                        break;
-                    }
-                    case 'u': {
-                        tuple[i] = jsonObj[i].int_value();
-                        break;
-                    }
-                    case 'f': {
-                        tuple[i] = static_cast<RamDomain>(jsonObj[i].number_value());
-                        break;
-                    }
-                    default: throwError("invalid type attribute: '", ty[0], "'");
-                }
-            } catch (...) {
-                std::stringstream errorMessage;
-                if (jsonObj.is_array() && i < jsonObj.array_items().size()) {
-                    errorMessage << "Error converting: " << jsonObj[i].dump();
-                } else {
-                    errorMessage << "Invalid index: " << i;
-                }
-                throw std::invalid_argument(errorMessage.str());
+                parseLines(bounds[i], bounds[i + 1], parsed[i]);
+            } catch (std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+        PARALLEL_END
+        for (const auto& error : errors) {
+            if (!error.empty()) {
+                throw std::invalid_argument(error);
             }
         }
 
-        return tuple;
+        pos = end;
+        chunk = next = 0;
+        return true;
     }
 
-    RamDomain readNextElementList(const Json& source, const std::string& recordTypeName) {
-        auto&& recordInfo = types["records"][recordTypeName];
-
-        if (recordInfo.is_null()) {
-            throw std::invalid_argument("Missing record type information: " + recordTypeName);
+    void parseLines(std::size_t begin, std::size_t end, std::vector<RamDomain>& tuples) const {
+        const std::string_view lines(text.data(), end);
+        std::size_t cur = begin;
+        while (true) {
+            skipWhiteSpace(lines, cur);
+            if (cur >= end) {
+                return;
+            }
+            const std::size_t size = tuples.size();
+            tuples.resize(size + typeAttributes.size());
+            readTuple(lines, cur, &tuples[size]);
         }
+    }
 
-        // Handle null case
-        if (source.is_null()) {
-            return 0;
+    void readTuple(std::string_view source, std::size_t& cur, RamDomain* tuple) const {
+        skipWhiteSpace(source, cur);
+        if (cur < source.size() && source[cur] == '{') {
+            ++cur;
+            readMembers(source, cur, [&](const std::string& name) {
+                auto column = columns.find(name);
+                if (column == columns.end()) {
+                    throwError("invalid parameter: ", name);
+                }
+                tuple[column->second] = readValue(source, cur, typeAttributes[column->second]);
+            });
+            return;
         }
+        consume(source, cur, '[');
+        for (std::size_t i = 0; i < typeAttributes.size(); ++i) {
+            if (i > 0) {
+                consume(source, cur, ',');
+            }
+            tuple[i] = readValue(source, cur, typeAttributes[i]);
+        }
+        consume(source, cur, ']');
+    }
 
-        assert(source.is_array() && "the input is not json array");
-        auto&& recordTypes = recordInfo["types"];
-        const std::size_t recordArity = recordInfo["arity"].long_value();
-        std::vector<RamDomain> recordValues(recordArity);
-        for (std::size_t i = 0; i < recordArity; ++i) {
-            const std::string& recordType = recordTypes[i].string_value();
-            switch (recordType[0]) {
-                case 's': {
-                    recordValues[i] = symbolTable.encode(source[i].string_value());
-                    break;
-                }
-                case 'r': {
-                    recordValues[i] = readNextElementList(source[i], recordType);
-                    break;
-                }
-                case 'i': {
-                    recordValues[i] = source[i].int_value();
-                    break;
-                }
-                case 'u': {
-                    recordValues[i] = source[i].int_value();
-                    break;
-                }
-                case 'f': {
-                    recordValues[i] = static_cast<RamDomain>(source[i].number_value());
-                    break;
-                }
-                default: throwError("invalid type attribute");
+    RamDomain readValue(std::string_view source, std::size_t& cur, const std::string& type) const {
+        skipWhiteSpace(source, cur);
+        switch (type[0]) {
+            case 's': {
+                std::string buffer;
+                return symbolTable.encode(readString(source, cur, buffer));
             }
+            case 'i': return readNumber<RamSigned>(source, cur);
+            case 'u': return ramBitCast(readNumber<RamUnsigned>(source, cur));
+            case 'f': return ramBitCast(readNumber<RamFloat>(source, cur));
+            case 'r': return readRecord(source, cur, type);
+            case '+': return readADT(source, cur, type);
+            default: throwError("invalid type attribute: '", type[0], "'");
         }
+    }
 
+    RamDomain readRecord(std::string_view source, std::size_t& cur, const std::string& type) const {
+        auto record = records.find(type);
+        if (record == records.end()) {
+            throw std::invalid_argument("Missing record type information: " + type);
+        }
+        const Fields& fields = record->second;
+        if (source.compare(cur, 4, "null") == 0) {
+            cur += 4;
+            return 0;
+        }
+        std::vector<RamDomain> recordValues(fields.types.size());
+        readFields(source, cur, fields, recordValues.data());
         return recordTable.pack(recordValues.data(), recordValues.size());
     }
 
-    Own<RamDomain[]> readNextTupleObject() {
-        if (pos >= jsonSource.array_items().size()) {
-            return nullptr;
+    RamDomain readADT(std::string_view source, std::size_t& cur, const std::string& type) const {
+        auto adt = adts.find(type);
+        if (adt == adts.end()) {
+            throw std::invalid_argument("Missing ADT information: " + type);
+        }
+        std::string buffer;
+        const bool hasArgs = cur < source.size() && source[cur] == '{';
+        if (hasArgs) {
+            ++cur;
+            skipWhiteSpace(source, cur);
+        }
+        const std::string name(readString(source, cur, buffer));
+        auto branch = adt->second.index.find(name);
+        if (branch == adt->second.index.end()) {
+            throw std::invalid_argument("Missing branch information: " + name);
+        }
+        const auto branchIdx = static_cast<RamDomain>(branch->second);
+        const Fields& fields = adt->second.branches[branch->second];
+
+        std::vector<RamDomain> branchArgs(fields.types.size());
+        if (hasArgs) {
+            consume(source, cur, ':');
+            skipWhiteSpace(source, cur);
+            readFields(source, cur, fields, branchArgs.data());
+            consume(source, cur, '}');
+        } else if (!fields.types.empty()) {
+            throw std::invalid_argument("Missing arguments of branch " + name);
         }
 
-        Own<RamDomain[]> tuple = mk<RamDomain[]>(typeAttributes.size());
-        const Json& jsonObj = jsonSource[pos];
-        assert(jsonObj.is_object() && "the input is not json object");
-        pos++;
-        for (auto p : jsonObj.object_items()) {
-            try {
-                // get the corresponding position by parameter name
-                if (paramIndex.find(p.first) == paramIndex.end()) {
-                    throwError("invalid parameter: ", p.first);
-                }
-                std::size_t i = paramIndex.at(p.first);
-                auto&& ty = typeAttributes.at(i);
-                switch (ty[0]) {
-                    case 's': {
-                        tuple[i] = symbolTable.encode(p.second.string_value());
-                        break;
-                    }
-                    case 'r': {
-                        tuple[i] = readNextElementObject(p.second, ty);
-                        break;
-                    }
-                    case 'i': {
-                        tuple[i] = p.second.int_value();
-                        break;
-                    }
-                    case 'u': {
-                        tuple[i] = p.second.int_value();
-                        break;
-                    }
-                    case 'f': {
-                        tuple[i] = static_cast<RamDomain>(p.second.number_value());
-                        break;
-                    }
-                    default: throwError("invalid type attribute: '", ty[0], "'");
+        // encoded as branchIdx for enumerations, by packUnboxedBranch for branches without
+        // arguments, and as [branchIdx, branchValue] or [branchIdx, [branchValues...]] otherwise
+        if (adt->second.isEnum) {
+            return branchIdx;
+        }
+        if (branchArgs.empty()) {
+            return packUnboxedBranch(branchIdx);
+        }
+        const RamDomain args = branchArgs.size() == 1
+                                       ? branchArgs[0]
+                                       : recordTable.pack(branchArgs.data(), branchArgs.size());
+        const RamDomain record[] = {branchIdx, args};
+        return recordTable.pack(record, 2);
+    }
+
+    /** Read the fields of a record or ADT branch, from an array of them or an object of them by name */
+    void readFields(
+            std::string_view source, std::size_t& cur, const Fields& fields, RamDomain* values) const {
+        if (cur < source.size() && source[cur] == '{') {
+            ++cur;
+            readMembers(source, cur, [&](const std::string& name) {
+                auto field = fields.index.find(name);
+                if (field == fields.index.end()) {
+                    throwError("invalid parameter: ", name);
                 }
-            } catch (...) {
-                std::stringstream errorMessage;
-                errorMessage << "Error converting: " << p.second.dump();
-                throw std::invalid_argument(errorMessage.str());
+                values[field->second] = readValue(source, cur, fields.types[field->second]);
+            });
+            return;
+        }
+        consume(source, cur, '[');
+        for (std::size_t i = 0; i < fields.types.size(); ++i) {
+            if (i > 0) {
+                consume(source, cur, ',');
             }
+            values[i] = readValue(source, cur, fields.types[i]);
         }
-
-        return tuple;
+        consume(source, cur, ']');
     }
 
-    RamDomain readNextElementObject(const Json& source, const std::string& recordTypeName) {
-        auto&& recordInfo = types["records"][recordTypeName];
-        const std::string recordName = recordTypeName.substr(2);
-        std::map<const std::string, const std::size_t> recordIndex;
-
-        std::size_t index_pos = 0;
-        for (auto param : params["records"][recordName]["params"].array_items()) {
-            recordIndex.insert(std::make_pair(param.string_value(), index_pos));
-            index_pos++;
+    /** Read the members of an object after its opening brace, reading each value by the given function */
+    template <typename ReadMember>
+    void readMembers(std::string_view source, std::size_t& cur, const ReadMember& readMember) const {
+        std::string buffer;
+        skipWhiteSpace(source, cur);
+        if (cur < source.size() && source[cur] == '}') {
+            ++cur;
+            return;
+        }
+        while (true) {
+            skipWhiteSpace(source, cur);
+            const std::string name(readString(source, cur, buffer));
+            consume(source, cur, ':');
+            readMember(name);
+            skipWhiteSpace(source, cur);
+            if (cur < source.size() && source[cur] == ',') {
+                ++cur;
+                continue;
+            }
+            consume(source, cur, '}');
+            return;
         }
+    }
 
-        if (recordInfo.is_null()) {
-            throw std::invalid_argument("Missing record type information: " + recordTypeName);
+    template <typename T>
+    T readNumber(std::string_view source, std::size_t& cur) const {
+        const char* first = source.data() + cur;
+        const char* last = source.data() + source.size();
+        T value{};
+        std::from_chars_result result{first, std::errc::invalid_argument};
+        if constexpr (std::is_floating_point_v<T>) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            result = std::from_chars(first, last, value);
+#else
+            // strtod stops at the end of the number, which is followed by a delimiter within the text
+            char* end = nullptr;
+            value = static_cast<T>(std::strtod(first, &end));
+            result = {end, end == first ? std::errc::invalid_argument : std::errc()};
+#endif
+        } else {
+            result = std::from_chars(first, last, value);
+            if (result.ec == std::errc() && result.ptr < last &&
+                    (*result.ptr == '.' || *result.ptr == 'e' || *result.ptr == 'E')) {
+                // integral numbers written as floats
+                double number = 0;
+                char* end = nullptr;
+                number = std::strtod(first, &end);
+                value = static_cast<T>(number);
+                result.ptr = end;
+            }
         }
+        if (result.ec != std::errc()) {
+            throwError("Error converting number at: ", source.substr(cur, 32));
+        }
+        cur = result.ptr - source.data();
+        return value;
+    }
 
-        // Handle null case
-        if (source.is_null()) {
-            return 0;
+    /**
+     * Read a string, and return it unescaped.
+     *
+     * A string without escapes is returned as part of the source, others
+     * are unescaped into the given buffer.
+     */
+    static std::string_view readString(std::string_view source, std::size_t& cur, std::string& buffer) {
+        consume(source, cur, '"');
+        const std::size_t begin = cur;
+        while (cur < source.size() && source[cur] != '"' && source[cur] != '\\') {
+            ++cur;
+        }
+        if (cur < source.size() && source[cur] == '"') {
+            return source.substr(begin, cur++ - begin);
         }
 
-        assert(source.is_object() && "the input is not json object");
-        auto&& recordTypes = recordInfo["types"];
-        const std::size_t recordArity = recordInfo["arity"].long_value();
-        std::vector<RamDomain> recordValues(recordArity);
-        recordValues.reserve(recordIndex.size());
-        for (auto readParam : source.object_items()) {
-            // get the corresponding position by parameter name
-            if (recordIndex.find(readParam.first) == recordIndex.end()) {
-                throwError("invalid parameter: ", readParam.first);
+        buffer.assign(source.substr(begin, cur - begin));
+        while (cur < source.size() && source[cur] != '"') {
+            if (source[cur] != '\\') {
+                buffer += source[cur++];
+                continue;
             }
-            std::size_t i = recordIndex.at(readParam.first);
-            auto&& type = recordTypes[i].string_value();
-            switch (type[0]) {
-                case 's': {
-                    recordValues[i] = symbolTable.encode(readParam.second.string_value());
-                    break;
-                }
-                case 'r': {
-                    recordValues[i] = readNextElementObject(readParam.second, type);
-                    break;
-                }
-                case 'i': {
-                    recordValues[i] = readParam.second.int_value();
-                    break;
-                }
+            if (++cur >= source.size()) {
+                break;
+            }
+            switch (source[cur++]) {
+                case '"': buffer += '"'; break;
+                case '\\': buffer += '\\'; break;
+                case '/': buffer += '/'; break;
+                case 'b': buffer += '\b'; break;
+                case 'f': buffer += '\f'; break;
+                case 'n': buffer += '\n'; break;
+                case 'r': buffer += '\r'; break;
+                case 't': buffer += '\t'; break;
                 case 'u': {
-                    recordValues[i] = readParam.second.int_value();
-                    break;
-                }
-                case 'f': {
-                    recordValues[i] = static_cast<RamDomain>(readParam.second.number_value());
+                    std::uint32_t code = readHex(source, cur);
+                    if (code >= 0xd800 && code < 0xdc00 && source.compare(cur, 2, "\\u") == 0) {
+                        // a surrogate pair
+                        cur += 2;
+                        code = 0x10000 + ((code - 0xd800) << 10) + (readHex(source, cur) - 0xdc00);
+                    }
+                    appendUTF8(buffer, code);
                     break;
                 }
-                default: throwError("invalid type attribute: '", type[0], "'");
+                default: throwError("invalid escape in string: ", source.substr(begin, cur - begin));
             }
         }
+        consume(source, cur, '"');
+        return buffer;
+    }
 
-        return recordTable.pack(recordValues.data(), recordValues.size());
+    static std::uint32_t readHex(std::string_view source, std::size_t& cur) {
+        std::uint32_t code = 0;
+        if (cur + 4 > source.size() ||
+                std::from_chars(source.data() + cur, source.data() + cur + 4, code, 16).ptr !=
+                        source.data() + cur + 4) {
+            throwError("invalid unicode escape: ", source.substr(cur, 4));
+        }
+        cur += 4;
+        return code;
     }
+
+    static void appendUTF8(std::string& buffer, std::uint32_t code) {
+        if (code < 0x80) {
+            buffer += static_cast<char>(code);
+        } else if (code < 0x800) {
+            buffer += static_cast<char>(0xc0 | (code >> 6));
+            buffer += static_cast<char>(0x80 | (code & 0x3f));
+        } else if (code < 0x10000) {
+            buffer += static_cast<char>(0xe0 | (code >> 12));
+            buffer += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            buffer += static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+            buffer += static_cast<char>(0xf0 | (code >> 18));
+            buffer += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            buffer += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            buffer += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    static void skipWhiteSpace(std::string_view source, std::size_t& cur) {
+        while (cur < source.size() &&
+                (source[cur] == ' ' || source[cur] == '\t' || source[cur] == '\n' || source[cur] == '\r')) {
+            ++cur;
+        }
+    }
+
+    /** Consume the given character, after white space */
+    static void consume(std::string_view source, std::size_t& cur, char expected) {
+        skipWhiteSpace(source, cur);
+        if (cur >= source.size() || source[cur] != expected) {
+            throwError("cannot deserialize json: expected '", expected, "' at: ", source.substr(cur, 32));
+        }
+        ++cur;
+    }
+
+    /** Size of the blocks of lines read at once */
+    static constexpr std::size_t BLOCK_SIZE = 1 << 24;
 };
 
 class ReadFileJSON : public ReadStreamJSON {
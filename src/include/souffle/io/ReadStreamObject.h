@@ -0,0 +1,110 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ReadStreamObject.h
+ *
+ * Reads relations in the CSV format from objects of S3, Google Cloud
+ * Storage and HTTP servers (see ObjectStorage.h), e.g.,
+ *
+ *     .input edge(IO=object, filename="s3://bucket/facts/edge.facts")
+ *
+ * Relative file names are resolved against the fact directory, which may
+ * be the URL of a prefix of objects as well.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/ObjectStorage.h"
+#include "souffle/io/ReadStream.h"
+#include "souffle/io/ReadStreamCSV.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <istream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace souffle {
+
+class ReadObjectCSV : public ReadStreamCSV {
+public:
+    ReadObjectCSV(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable)
+            : ReadStreamCSV(objectStream, rwOperation, symbolTable, recordTable),
+              uri(getUri(rwOperation)),
+              buffer(uri, object::getSize(rwOperation, "part-size", object::DEFAULT_PART_SIZE),
+                      object::getSize(rwOperation, "parallel-parts", object::DEFAULT_PARALLEL_PARTS)),
+              objectStream(&buffer) {
+        // failed downloads are reported by the reader rather than ending the input
+        objectStream.exceptions(std::ios::badbit);
+        if (!buffer.open()) {
+            // suppress error message in case the object does not exist when flag -w is set
+            if (getOr(rwOperation, "no-warn", "false") != "true") {
+                throw std::invalid_argument("Cannot open fact object " + uri + "\n");
+            }
+        }
+        // Strip headers if we're using them
+        if (getOr(rwOperation, "headers", "false") == "true") {
+            std::string line;
+            getline(file, line);
+        }
+    }
+
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        try {
+            return ReadStreamCSV::readNextTuples(tuples, capacity);
+        } catch (std::exception& e) {
+            std::stringstream errorMessage;
+            errorMessage << e.what();
+            errorMessage << "cannot parse fact object " << uri << "!\n";
+            throw std::invalid_argument(errorMessage.str());
+        }
+    }
+
+    ~ReadObjectCSV() override = default;
+
+protected:
+    /**
+     * Return the URL of the object, given or constructed from the relation name.
+     * Default name is [configured path]/[relation name].facts
+     */
+    static std::string getUri(const std::map<std::string, std::string>& rwOperation) {
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + ".facts");
+        if (!object::isObjectUrl(name)) {
+            name = getOr(rwOperation, "fact-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    const std::string uri;
+    object::ReadBuffer buffer;
+    std::istream objectStream;
+};
+
+class ReadObjectCSVFactory : public ReadStreamFactory {
+public:
+    Own<ReadStream> getReader(const std::map<std::string, std::string>& rwOperation, SymbolTable& symbolTable,
+            RecordTable& recordTable) override {
+        return mk<ReadObjectCSV>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "object";
+        return name;
+    }
+
+    ~ReadObjectCSVFactory() override = default;
+};
+
+} /* namespace souffle */
@@ -19,14 +19,18 @@
 #include "souffle/SymbolTable.h"
 #include "souffle/io/ReadStream.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
 #include "souffle/utility/StringUtil.h"
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 #include <sqlite3.h>
 
@@ -49,26 +53,38 @@ public:
     }
 
 protected:
-    /**
-     * Read and return the next tuple.
-     *
-     * Returns nullptr if no tuple was readable.
-     * @return
-     */
-    Own<RamDomain[]> readNextTuple() override {
-        if (sqlite3_step(selectStatement) != SQLITE_ROW) {
-            return nullptr;
+    std::size_t readNextTuples(RamDomain* tuples, std::size_t capacity) override {
+        const std::size_t width = arity + auxiliaryArity;
+        std::size_t count = 0;
+        while (count < capacity && sqlite3_step(selectStatement) == SQLITE_ROW) {
+            readRow(&tuples[count * width]);
+            ++count;
         }
+        return count;
+    }
+
+    /** Convert the current row of the query into the given tuple */
+    void readRow(RamDomain* tuple) {
+        // columns projected away are left zero
+        std::fill_n(tuple, arity + auxiliaryArity, 0);
 
-        Own<RamDomain[]> tuple = mk<RamDomain[]>(arity + auxiliaryArity);
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            const std::size_t column = columns[i];
+            const int index = static_cast<int>(i);
+            auto&& ty = typeAttributes.at(column);
+
+            // integers are taken as stored rather than converted from their text
+            const bool integer = sqlite3_column_type(selectStatement, index) == SQLITE_INTEGER;
+            if ((ty[0] == 'i' || ty[0] == 'u') && integer) {
+                tuple[column] = static_cast<RamDomain>(sqlite3_column_int64(selectStatement, index));
+                continue;
+            }
 
-        uint32_t column;
-        for (column = 0; column < arity; column++) {
             std::string element;
-            if (0 == sqlite3_column_bytes(selectStatement, column)) {
+            if (0 == sqlite3_column_bytes(selectStatement, index)) {
                 element = "n/a";
             } else {
-                element = reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, column));
+                element = reinterpret_cast<const char*>(sqlite3_column_text(selectStatement, index));
 
                 if (element.empty()) {
                     element = "n/a";
@@ -76,7 +92,6 @@ protected:
             }
 
             try {
-                auto&& ty = typeAttributes.at(column);
                 switch (ty[0]) {
                     case 's': tuple[column] = symbolTable.encode(element); break;
                     case 'f': tuple[column] = ramBitCast(RamFloatFromString(element)); break;
@@ -91,8 +106,6 @@ protected:
                 throw std::invalid_argument(errorMessage.str());
             }
         }
-
-        return tuple;
     }
 
     void executeSQL(const std::string& sql) {
@@ -117,15 +130,108 @@ protected:
         throw std::invalid_argument(error.str());
     }
 
+    /**
+     * Prepare the query of the relation.
+     *
+     * If the program observes only part of an input relation, the part is
+     * given by the "pushdown" parameters: the columns it uses, and the
+     * constants it binds columns to. The query then only selects the used
+     * columns of the rows with these constants.
+     */
     void prepareSelectStatement() {
         std::stringstream selectSQL;
         selectSQL << "SELECT * FROM '" << relationName << "'";
+        prepare(selectSQL.str());
+
+        auto&& pushdown = params["pushdown"];
+        if (pushdown.is_null() || auxiliaryArity > 0) {
+            for (std::size_t column = 0; column < arity; column++) {
+                columns.push_back(column);
+            }
+            return;
+        }
+
+        // name the columns of the relation as the table or view does
+        if (sqlite3_column_count(selectStatement) < static_cast<int>(arity)) {
+            throw std::invalid_argument("Missing columns in " + dbFilename + " for relation " + relationName);
+        }
+        std::vector<std::string> names;
+        for (std::size_t column = 0; column < arity; column++) {
+            names.push_back(quote(sqlite3_column_name(selectStatement, static_cast<int>(column))));
+        }
+        sqlite3_finalize(selectStatement);
+
+        auto&& used = pushdown["columns"].array_items();
+        std::vector<std::string> projection;
+        for (std::size_t column = 0; column < arity; column++) {
+            if (used.at(column).bool_value()) {
+                columns.push_back(column);
+                projection.push_back(names[column]);
+            }
+        }
+
+        std::vector<std::pair<std::size_t, std::string>> bindings;
+        std::vector<std::string> selection;
+        for (auto&& filter : pushdown["filters"].array_items()) {
+            const auto column = static_cast<std::size_t>(filter["column"].long_value());
+            std::vector<std::string> placeholders;
+            for (auto&& value : filter["values"].array_items()) {
+                bindings.emplace_back(column, value.string_value());
+                placeholders.emplace_back("?");
+            }
+            selection.push_back(names[column] + " IN (" + toString(join(placeholders, ",")) + ")");
+        }
+
+        selectSQL.str("");
+        // a query without used columns still yields a row per matching row
+        selectSQL << "SELECT " << (projection.empty() ? "1" : toString(join(projection, ",")));
+        selectSQL << " FROM '" << relationName << "'";
+        if (!selection.empty()) {
+            selectSQL << " WHERE " << join(selection, " AND ");
+        }
+        prepare(selectSQL.str());
+
+        for (std::size_t i = 0; i < bindings.size(); i++) {
+            const auto& [column, value] = bindings[i];
+            const int position = static_cast<int>(i) + 1;
+            int rc;
+            switch (typeAttributes.at(column)[0]) {
+                case 'i':
+                    rc = sqlite3_bind_int64(
+                            selectStatement, position, RamSignedFromString(value, nullptr, 0));
+                    break;
+                case 'u':
+                    rc = sqlite3_bind_int64(
+                            selectStatement, position, RamUnsignedFromString(value, nullptr, 0));
+                    break;
+                default:
+                    rc = sqlite3_bind_text(selectStatement, position, value.c_str(), -1, SQLITE_TRANSIENT);
+                    break;
+            }
+            if (rc != SQLITE_OK) {
+                throwError("SQLite error in sqlite3_bind: ");
+            }
+        }
+    }
+
+    void prepare(const std::string& sql) {
         const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, selectSQL.str().c_str(), -1, &selectStatement, &tail) != SQLITE_OK) {
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &selectStatement, &tail) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_prepare_v2: ");
         }
     }
 
+    static std::string quote(const std::string& name) {
+        std::string quoted = "\"";
+        for (char c : name) {
+            quoted += c;
+            if (c == '"') {
+                quoted += c;
+            }
+        }
+        return quoted + "\"";
+    }
+
     void openDB() {
         if (sqlite3_open(dbFilename.c_str(), &db) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_open: ");
@@ -179,6 +285,10 @@ protected:
 
     const std::string dbFilename;
     const std::string relationName;
+
+    /** Columns of the relation selected by the query, in the order of the query */
+    std::vector<std::size_t> columns;
+
     sqlite3_stmt* selectStatement = nullptr;
     sqlite3* db = nullptr;
 };
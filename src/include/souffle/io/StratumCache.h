@@ -0,0 +1,164 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file StratumCache.h
+ *
+ * Layout of the cache of strata across runs, enabled with
+ * `--stratum-cache`.
+ *
+ * The cache holds one entry per stratum: the relations computed by the
+ * stratum, as binary snapshots (see BinaryFormat.h), and the marker file
+ * `<stratum>.fingerprint`, naming the fingerprint of the evaluation that
+ * computed them. The fingerprint combines the key of the stratum with the
+ * contents of the relations it reads, such that a later run reading the
+ * same relations loads the snapshots instead of evaluating the stratum.
+ *
+ * Symbols are fingerprinted and stored by their strings, so entries are
+ * valid across runs with different symbol tables. The marker is removed
+ * before the snapshots are replaced and written after, such that a crash
+ * while writing an entry leaves no entry behind.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/json11.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace stratum_cache {
+
+inline std::string markerFile(const std::string& directory, const std::string& stratum) {
+    return directory + "/" + stratum + ".fingerprint";
+}
+
+inline std::string snapshotFile(
+        const std::string& directory, const std::string& stratum, const std::string& relation) {
+    return directory + "/" + stratum + "." + relation + ".bin";
+}
+
+/** The IO directives of the snapshot of a relation computed by a stratum */
+inline std::map<std::string, std::string> snapshotDirectives(const std::string& directory,
+        const std::string& stratum, const std::string& relation, const std::vector<std::string>& types) {
+    json11::Json typesJson = json11::Json::object{
+            {"relation", json11::Json::object{{"arity", static_cast<long long>(types.size())},
+                                 {"types", json11::Json::array(types.begin(), types.end())}}}};
+    std::map<std::string, std::string> directives;
+    directives["IO"] = "binary";
+    directives["name"] = relation;
+    directives["filename"] = snapshotFile(directory, stratum, relation);
+    directives["types"] = typesJson.dump();
+    return directives;
+}
+
+/**
+ * The fingerprint of an evaluation of a stratum.
+ *
+ * Tuples are hashed independently of the order they are visited in, so
+ * relations with the same tuples have the same fingerprint regardless of
+ * their representation.
+ */
+class Fingerprint {
+public:
+    explicit Fingerprint(const std::string& key) : state(hash(key)) {}
+
+    /** Add the contents of a relation with the given attribute types */
+    template <typename Relation>
+    void add(const std::string& name, const Relation& relation, const std::vector<std::string>& types,
+            const SymbolTable& symbolTable) {
+        uint64_t sum = 0;
+        for (const auto& tuple : relation) {
+            uint64_t h = 0;
+            for (std::size_t i = 0; i < types.size(); ++i) {
+                const RamDomain value = tuple[i];
+                h = mix(h ^ (types[i][0] == 's' ? hash(symbolTable.decode(value))
+                                                 : static_cast<uint64_t>(static_cast<RamUnsigned>(value))));
+            }
+            sum += mix(h);
+        }
+        state = mix(state ^ hash(name));
+        state = mix(state ^ static_cast<uint64_t>(relation.size()));
+        state = mix(state ^ sum);
+    }
+
+    /** The fingerprint as a hexadecimal string */
+    std::string str() const {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << state;
+        return out.str();
+    }
+
+private:
+    uint64_t state;
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb53fe1a85ec5ULL;
+        return h ^ (h >> 33);
+    }
+
+    /** FNV-1a, which is stable across platforms and builds */
+    static uint64_t hash(const std::string& text) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : text) {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+};
+
+/** Check whether the cache holds the relations computed by the stratum for the fingerprint */
+inline bool isCached(
+        const std::string& directory, const std::string& stratum, const Fingerprint& fingerprint) {
+    std::ifstream in(markerFile(directory, stratum));
+    std::string cached;
+    return (in >> cached) && cached == fingerprint.str();
+}
+
+/** Remove the entry of the stratum, before its snapshots are replaced */
+inline void invalidate(const std::string& directory, const std::string& stratum) {
+    std::remove(markerFile(directory, stratum).c_str());
+}
+
+/** Complete the entry of the stratum, whose snapshots are written already */
+inline void markCached(
+        const std::string& directory, const std::string& stratum, const Fingerprint& fingerprint) {
+    const std::string marker = markerFile(directory, stratum);
+    const std::string temporary = marker + ".tmp";
+    {
+        std::ofstream out(temporary);
+        out << fingerprint.str() << "\n";
+        if (!out) {
+            throw std::runtime_error("Cannot write stratum cache marker " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), marker.c_str()) != 0) {
+        throw std::runtime_error("Cannot write stratum cache marker " + marker);
+    }
+}
+
+}  // namespace stratum_cache
+
+}  // namespace souffle
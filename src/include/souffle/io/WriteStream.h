@@ -22,18 +22,29 @@
 #include "souffle/utility/json11.h"
 #include <cassert>
 #include <cstddef>
+#include <functional>
 #include <iomanip>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace souffle {
 
 using json11::Json;
 
+class WritePartitioned;
+
 class WriteStream : public SerialisationStream<true> {
+    friend class WritePartitioned;
+
 public:
+    /** Scan of a part of a relation, passing each tuple to the given function */
+    using Scan = std::function<void(const std::function<void(const RamDomain*)>&)>;
+
     WriteStream(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : SerialisationStream(symbolTable, recordTable, rwOperation),
@@ -50,6 +61,11 @@ public:
             }
             return;
         }
+        if (const std::size_t count = getScanCount(); count > 0) {
+            std::vector<Scan> scans;
+            addScans(scans, relation, count, PartitionedRelation());
+            return writeScans(scans);
+        }
         for (const auto& current : relation) {
             writeNext(current);
         }
@@ -69,6 +85,16 @@ protected:
         fatal("attempting to print size of a write operation");
     }
 
+    /** Number of parts to scan a relation in for writeScans, or 0 to write its tuples by writeNextTuple */
+    virtual std::size_t getScanCount() const {
+        return 0;
+    }
+
+    /** Write a relation given by the scans of its consecutive parts, in order */
+    virtual void writeScans(const std::vector<Scan>& /* scans */) {
+        fatal("attempting to write parts of a relation to a sequential stream");
+    }
+
     template <typename Tuple>
     void writeNext(const Tuple tuple) {
         using tcb::make_span;
@@ -126,9 +152,10 @@ protected:
         assert(!adtInfo.is_null() && "Missing adt type information");
         assert(adtInfo["arity"].long_value() > 0);
 
-        // adt is encoded in one of three possible ways:
-        // [branchID, [branch_args]] when |branch_args| != 1
+        // adt is encoded in one of four possible ways:
+        // [branchID, [branch_args]] when |branch_args| > 1
         // [branchID, arg] when a branch takes a single argument.
+        // packUnboxedBranch(branchID) when a branch takes no arguments.
         // branchID when ADT is an enumeration.
         bool isEnum = adtInfo["enum"].bool_value();
 
@@ -137,7 +164,10 @@ protected:
         json11::Json branchInfo;
         json11::Json::array branchTypes;
 
-        if (!isEnum) {
+        if (!isEnum && isUnboxedBranch(value)) {
+            branchId = unpackUnboxedBranch(value);
+            branchInfo = adtInfo["branches"][branchId];
+        } else if (!isEnum) {
             const RamDomain* tuplePtr = recordTable.unpack(value, 2);
 
             branchId = tuplePtr[0];
@@ -185,6 +215,64 @@ protected:
             destination << ")";
         }
     }
+
+private:
+    /** Tags of the overloads of addScans, of which the most derived applicable one is chosen */
+    struct AnySequence {};
+    struct SynthesisedRelation : AnySequence {};
+    struct PartitionedRelation : SynthesisedRelation {};
+
+    template <typename Iterator>
+    void addScan(std::vector<Scan>& scans, Iterator begin, Iterator end) {
+        scans.push_back([begin, end](const std::function<void(const RamDomain*)>& visit) {
+            for (auto cur = begin; cur != end; ++cur) {
+                visit(getData(*cur));
+            }
+        });
+    }
+
+    static const RamDomain* getData(const RamDomain* tuple) {
+        return tuple;
+    }
+
+    template <typename Tuple>
+    static const RamDomain* getData(const Tuple& tuple) {
+        return tcb::make_span(tuple).data();
+    }
+
+    /** Relations of the interpreter and B-trees are split by the requested number of parts */
+    template <typename T>
+    auto addScans(std::vector<Scan>& scans, const T& relation, std::size_t count, PartitionedRelation)
+            -> decltype(relation.partition(count), void()) {
+        for (auto&& chunk : relation.partition(count)) {
+            addScan(scans, chunk.begin(), chunk.end());
+        }
+    }
+
+    /** Relations of synthesised programs are split as for their parallel scans */
+    template <typename T>
+    auto addScans(std::vector<Scan>& scans, const T& relation, std::size_t /* count */, SynthesisedRelation)
+            -> decltype(relation.partition(), void()) {
+        for (auto&& chunk : relation.partition()) {
+            addScan(scans, chunk.begin(), chunk.end());
+        }
+    }
+
+    /** Sequences are split into equal parts if they are random access, and not split otherwise */
+    template <typename T>
+    void addScans(std::vector<Scan>& scans, const T& relation, std::size_t count, AnySequence) {
+        using Iterator = decltype(relation.begin());
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                              typename std::iterator_traits<Iterator>::iterator_category>) {
+            const std::size_t size = relation.end() - relation.begin();
+            for (std::size_t i = 0; i < count; ++i) {
+                auto begin = relation.begin();
+                addScan(scans, begin + size * i / count, begin + size * (i + 1) / count);
+            }
+        } else {
+            addScan(scans, relation.begin(), relation.end());
+        }
+    }
 };
 
 class WriteStreamFactory {
@@ -0,0 +1,304 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamArrow.h
+ *
+ * Writes relations as the columns of Parquet and Arrow IPC files.
+ *
+ * Each attribute is written to a column of its name, of the width of the
+ * RAM domain for numbers and dictionary-encoded for symbols; records and
+ * ADTs are written as strings in the syntax of the CSV format. Tuples are
+ * written in batches of BATCH_SIZE rows.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/WriteStream.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+namespace souffle {
+
+class WriteStreamArrow : public WriteStream {
+protected:
+    WriteStreamArrow(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable, const std::string& extension)
+            : WriteStream(rwOperation, symbolTable, recordTable),
+              fileName(getFileName(rwOperation, extension)), columns(arity), dictionaries(arity) {
+        auto&& names = params["relation"]["params"].array_items();
+        if (names.size() != arity) {
+            throw std::invalid_argument("Missing attribute names to write " + fileName);
+        }
+        arrow::FieldVector fields;
+        for (std::size_t column = 0; column < arity; column++) {
+            fields.push_back(arrow::field(names[column].string_value(), getType(column), false));
+            columns[column].reserve(BATCH_SIZE);
+        }
+        schema = arrow::schema(std::move(fields));
+    }
+
+    void writeNullary() override {
+        rows = 1;
+    }
+
+    void writeNextTuple(const RamDomain* tuple) override {
+        for (std::size_t column = 0; column < arity; column++) {
+            columns[column].push_back(tuple[column]);
+        }
+        if (++rows == BATCH_SIZE) {
+            flush();
+        }
+    }
+
+    /** Write a batch of rows to the file */
+    virtual void writeBatch(const arrow::RecordBatch& batch) = 0;
+
+    /** Write the buffered tuples as a batch */
+    void flush() {
+        if (rows == 0) {
+            return;
+        }
+        arrow::ArrayVector arrays;
+        for (std::size_t column = 0; column < arity; column++) {
+            arrays.push_back(makeArray(column));
+            columns[column].clear();
+        }
+        writeBatch(*arrow::RecordBatch::Make(schema, static_cast<int64_t>(rows), std::move(arrays)));
+        rows = 0;
+    }
+
+    void check(const arrow::Status& status) const {
+        if (!status.ok()) {
+            throw std::invalid_argument("Cannot write " + fileName + ": " + status.ToString());
+        }
+    }
+
+    template <typename T>
+    T check(arrow::Result<T> result) const {
+        check(result.status());
+        return std::move(result).ValueOrDie();
+    }
+
+    /**
+     * Return given filename or construct from relation name.
+     * Default name is [configured path]/[relation name][extension]
+     *
+     * @param rwOperation map of IO configuration options
+     * @return output filename
+     */
+    static std::string getFileName(
+            const std::map<std::string, std::string>& rwOperation, const std::string& extension) {
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + extension);
+        if (name.front() != '/') {
+            name = getOr(rwOperation, "output-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    /** Number of tuples written per batch */
+    static constexpr std::size_t BATCH_SIZE = 1 << 16;
+
+    const std::string fileName;
+    std::shared_ptr<arrow::Schema> schema;
+
+private:
+    std::shared_ptr<arrow::DataType> getType(std::size_t column) const {
+        switch (typeAttributes[column][0]) {
+            case 'i': return arrow::CTypeTraits<RamSigned>::type_singleton();
+            case 'u': return arrow::CTypeTraits<RamUnsigned>::type_singleton();
+            case 'f': return arrow::CTypeTraits<RamFloat>::type_singleton();
+            case 's': return arrow::dictionary(arrow::int32(), arrow::utf8());
+            case 'r':
+            case '+': return arrow::utf8();
+            default: fatal("unsupported type attribute: `%c`", typeAttributes[column][0]);
+        }
+    }
+
+    std::shared_ptr<arrow::Array> makeArray(std::size_t column) {
+        const auto& values = columns[column];
+        const std::string& type = typeAttributes[column];
+        switch (type[0]) {
+            case 'i': return makeNumbers<RamSigned>(values);
+            case 'u': return makeNumbers<RamUnsigned>(values);
+            case 'f': return makeNumbers<RamFloat>(values);
+            case 's': return makeSymbols(column);
+            case 'r':
+            case '+': {
+                arrow::StringBuilder builder;
+                for (RamDomain value : values) {
+                    std::stringstream destination;
+                    if (type[0] == 'r') {
+                        outputRecord(destination, value, type);
+                    } else {
+                        outputADT(destination, value, type);
+                    }
+                    check(builder.Append(destination.str()));
+                }
+                return check(builder.Finish());
+            }
+            default: fatal("unsupported type attribute: `%c`", type[0]);
+        }
+    }
+
+    template <typename T>
+    std::shared_ptr<arrow::Array> makeNumbers(const std::vector<RamDomain>& values) {
+        typename arrow::CTypeTraits<T>::BuilderType builder;
+        check(builder.Reserve(static_cast<int64_t>(values.size())));
+        for (RamDomain value : values) {
+            builder.UnsafeAppend(ramBitCast<T>(value));
+        }
+        return check(builder.Finish());
+    }
+
+    /**
+     * Encode the symbols of a column by a dictionary of the column
+     *
+     * The dictionary of a column only grows, such that each batch refers
+     * to an extension of the dictionary of the previous batch.
+     */
+    std::shared_ptr<arrow::Array> makeSymbols(std::size_t column) {
+        auto& dictionary = dictionaries[column];
+        arrow::Int32Builder indices;
+        check(indices.Reserve(static_cast<int64_t>(columns[column].size())));
+        for (RamDomain symbol : columns[column]) {
+            auto pos = dictionary.codes.find(symbol);
+            if (pos == dictionary.codes.end()) {
+                pos = dictionary.codes.emplace(symbol, static_cast<int32_t>(dictionary.symbols.size())).first;
+                dictionary.symbols.push_back(symbol);
+            }
+            indices.UnsafeAppend(pos->second);
+        }
+
+        if (dictionary.entries == nullptr ||
+                static_cast<std::size_t>(dictionary.entries->length()) < dictionary.symbols.size()) {
+            arrow::StringBuilder entries;
+            for (RamDomain symbol : dictionary.symbols) {
+                check(entries.Append(symbolTable.decode(symbol)));
+            }
+            dictionary.entries = check(entries.Finish());
+        }
+        return check(arrow::DictionaryArray::FromArrays(
+                schema->field(static_cast<int>(column))->type(), check(indices.Finish()), dictionary.entries));
+    }
+
+    /** Dictionary of a column of symbols */
+    struct Dictionary {
+        std::unordered_map<RamDomain, int32_t> codes;
+        std::vector<RamDomain> symbols;
+        std::shared_ptr<arrow::Array> entries;
+    };
+
+    /** Buffered tuples, by column */
+    std::vector<std::vector<RamDomain>> columns;
+    std::vector<Dictionary> dictionaries;
+    std::size_t rows = 0;
+};
+
+class WriteStreamParquet : public WriteStreamArrow {
+public:
+    WriteStreamParquet(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable)
+            : WriteStreamArrow(rwOperation, symbolTable, recordTable, ".parquet") {
+        output = check(arrow::io::FileOutputStream::Open(fileName));
+        // the schema is stored such that symbols are read back dictionary-encoded
+        writer = check(parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(), output,
+                parquet::default_writer_properties(),
+                parquet::ArrowWriterProperties::Builder().store_schema()->build()));
+    }
+
+    ~WriteStreamParquet() override {
+        flush();
+        check(writer->Close());
+        check(output->Close());
+    }
+
+protected:
+    void writeBatch(const arrow::RecordBatch& batch) override {
+        check(writer->WriteRecordBatch(batch));
+    }
+
+    std::shared_ptr<arrow::io::FileOutputStream> output;
+    std::unique_ptr<parquet::arrow::FileWriter> writer;
+};
+
+class WriteStreamArrowIPC : public WriteStreamArrow {
+public:
+    WriteStreamArrowIPC(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable)
+            : WriteStreamArrow(rwOperation, symbolTable, recordTable, ".arrow") {
+        output = check(arrow::io::FileOutputStream::Open(fileName));
+        // the dictionaries of later batches are written as deltas of the dictionaries of earlier ones
+        auto options = arrow::ipc::IpcWriteOptions::Defaults();
+        options.emit_dictionary_deltas = true;
+        writer = check(arrow::ipc::MakeFileWriter(output, schema, options));
+    }
+
+    ~WriteStreamArrowIPC() override {
+        flush();
+        check(writer->Close());
+        check(output->Close());
+    }
+
+protected:
+    void writeBatch(const arrow::RecordBatch& batch) override {
+        check(writer->WriteRecordBatch(batch));
+    }
+
+    std::shared_ptr<arrow::io::FileOutputStream> output;
+    std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+};
+
+class WriteParquetFactory : public WriteStreamFactory {
+public:
+    Own<WriteStream> getWriter(const std::map<std::string, std::string>& rwOperation,
+            const SymbolTable& symbolTable, const RecordTable& recordTable) override {
+        return mk<WriteStreamParquet>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "parquet";
+        return name;
+    }
+    ~WriteParquetFactory() override = default;
+};
+
+class WriteArrowFactory : public WriteStreamFactory {
+public:
+    Own<WriteStream> getWriter(const std::map<std::string, std::string>& rwOperation,
+            const SymbolTable& symbolTable, const RecordTable& recordTable) override {
+        return mk<WriteStreamArrowIPC>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "arrow";
+        return name;
+    }
+    ~WriteArrowFactory() override = default;
+};
+
+} /* namespace souffle */
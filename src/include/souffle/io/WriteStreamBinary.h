@@ -0,0 +1,200 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamBinary.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/BinaryFormat.h"
+#include "souffle/io/WriteStream.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * Writes a relation as a binary snapshot (see BinaryFormat.h).
+ *
+ * Tuples are buffered and written in blocks; the tuple count and the symbol
+ * section are completed when the stream is destroyed. Spilled relations
+ * are written without translating their values, and so are symbols of
+ * snapshots referring to a symbol file.
+ */
+class WriteFileBinary : public WriteStream {
+public:
+    WriteFileBinary(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable)
+            : WriteStream(rwOperation, symbolTable, recordTable), raw(rwOperation.at("IO") == "spill"),
+              symbolFile(getSymbolFileName(rwOperation)),
+              file(getFileName(rwOperation), std::ios::out | std::ios::binary) {
+        if (!file.is_open()) {
+            throw std::invalid_argument("Cannot open binary file " + getFileName(rwOperation));
+        }
+        for (std::size_t i = 0; i < arity && !raw; ++i) {
+            if (!binary_format::isSupported(typeAttributes[i])) {
+                throw std::invalid_argument("Binary IO does not support attributes of type " +
+                                            typeAttributes[i] + " in relation " + rwOperation.at("name"));
+            }
+        }
+        file.write(binary_format::MAGIC, sizeof(binary_format::MAGIC));
+        binary_format::write<std::uint32_t>(file, binary_format::VERSION);
+        binary_format::write<std::uint32_t>(file, static_cast<std::uint32_t>(arity));
+        binary_format::write<std::uint32_t>(file, sizeof(RamDomain));
+        binary_format::write<std::uint32_t>(file, getFlags());
+        // tuple count and symbol offset are patched on completion
+        binary_format::write<std::uint64_t>(file, 0);
+        binary_format::write<std::uint64_t>(file, 0);
+        buffer.reserve(binary_format::BLOCK_SIZE * arity);
+
+        // the relation only holds symbols which the symbol table contains already
+        if (!raw && !symbolFile.empty()) {
+            symbolTable.save(symbolFile);
+        }
+    }
+
+    ~WriteFileBinary() override {
+        flush();
+        const std::uint64_t symbolOffset = static_cast<std::uint64_t>(file.tellp());
+        binary_format::write<std::uint64_t>(file, symbols.size());
+        for (const auto& symbol : symbols) {
+            binary_format::write<std::uint64_t>(file, symbol.size());
+            file.write(symbol.data(), static_cast<std::streamsize>(symbol.size()));
+        }
+        file.seekp(binary_format::TUPLE_COUNT_OFFSET);
+        binary_format::write<std::uint64_t>(file, tupleCount);
+        binary_format::write<std::uint64_t>(file, symbolOffset);
+    }
+
+protected:
+    /** Values are stored as they are, i.e., the snapshot is a spilled relation */
+    const bool raw;
+
+    /** The symbol file the symbol columns refer to, if any */
+    const std::string symbolFile;
+
+    std::ofstream file;
+
+    /** Tuples not yet written to the file */
+    std::vector<RamDomain> buffer;
+
+    /** Symbols of the snapshot, in order of first occurrence */
+    std::vector<std::string> symbols;
+
+    /** Symbol table index to position in symbols */
+    std::unordered_map<RamDomain, RamDomain> symbolIndex;
+
+    std::uint64_t tupleCount = 0;
+
+    void writeNullary() override {
+        tupleCount = 1;
+    }
+
+    void writeNextTuple(const RamDomain* tuple) override {
+        for (std::size_t col = 0; col < arity; ++col) {
+            if (typeAttributes[col][0] == 's' && getFlags() == 0) {
+                buffer.push_back(localSymbol(tuple[col]));
+            } else {
+                buffer.push_back(tuple[col]);
+            }
+        }
+        ++tupleCount;
+        if (buffer.size() >= binary_format::BLOCK_SIZE * arity) {
+            flush();
+        }
+    }
+
+    void flush() {
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                static_cast<std::streamsize>(buffer.size() * sizeof(RamDomain)));
+        buffer.clear();
+    }
+
+    std::uint32_t getFlags() const {
+        if (raw) {
+            return binary_format::FLAG_RAW;
+        }
+        return symbolFile.empty() ? 0 : binary_format::FLAG_SHARED_SYMBOLS;
+    }
+
+    RamDomain localSymbol(RamDomain index) {
+        auto pos = symbolIndex.find(index);
+        if (pos != symbolIndex.end()) {
+            return pos->second;
+        }
+        const auto local = static_cast<RamDomain>(symbols.size());
+        symbols.push_back(symbolTable.decode(index));
+        symbolIndex.emplace(index, local);
+        return local;
+    }
+
+    /**
+     * Return given filename or construct from relation name.
+     * Default name is [configured path]/[relation name].bin
+     * Spilled relations are named by the translator, independent of the output directory.
+     *
+     * @param rwOperation map of IO configuration options
+     * @return output filename
+     */
+    static std::string getFileName(const std::map<std::string, std::string>& rwOperation) {
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + ".bin");
+        if (name.front() != '/' && rwOperation.at("IO") != "spill") {
+            name = getOr(rwOperation, "output-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    /** Return the symbol file given by the `symbols` option, relative to the output directory. */
+    static std::string getSymbolFileName(const std::map<std::string, std::string>& rwOperation) {
+        auto name = getOr(rwOperation, "symbols", "");
+        if (!name.empty() && name.front() != '/') {
+            name = getOr(rwOperation, "output-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+};
+
+class WriteFileBinaryFactory : public WriteStreamFactory {
+public:
+    Own<WriteStream> getWriter(const std::map<std::string, std::string>& rwOperation,
+            const SymbolTable& symbolTable, const RecordTable& recordTable) override {
+        return mk<WriteFileBinary>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "binary";
+        return name;
+    }
+
+    ~WriteFileBinaryFactory() override = default;
+};
+
+class WriteFileSpillFactory : public WriteFileBinaryFactory {
+public:
+    const std::string& getName() const override {
+        static const std::string name = "spill";
+        return name;
+    }
+
+    ~WriteFileSpillFactory() override = default;
+};
+
+} /* namespace souffle */
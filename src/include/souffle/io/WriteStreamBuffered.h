@@ -0,0 +1,103 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamBuffered.h
+ *
+ * Base of the text writers, which format tuples into a buffer that is
+ * written to the destination in large blocks.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/WriteStream.h"
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace souffle {
+
+class WriteStreamBuffered : public WriteStream {
+protected:
+    WriteStreamBuffered(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable)
+            : WriteStream(rwOperation, symbolTable, recordTable), buffer(BUFFER_SIZE) {}
+
+    /** Write a block of formatted output to the destination */
+    virtual void writeBlock(const char* data, std::size_t size) = 0;
+
+    /** Write the buffered output; to be called by the destructors of the writers */
+    void flush() {
+        if (used > 0) {
+            writeBlock(buffer.data(), used);
+            used = 0;
+        }
+    }
+
+    void put(char ch) {
+        if (used == BUFFER_SIZE) {
+            flush();
+        }
+        buffer[used++] = ch;
+    }
+
+    void put(std::string_view text) {
+        if (text.size() > BUFFER_SIZE - used) {
+            flush();
+            if (text.size() >= BUFFER_SIZE) {
+                writeBlock(text.data(), text.size());
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    template <typename T>
+    void putNumber(T value) {
+        // large enough for any integer and for floats of max_digits10 significant digits
+        constexpr std::size_t maxLength = 64;
+        if (BUFFER_SIZE - used < maxLength) {
+            flush();
+        }
+        char* first = buffer.data() + used;
+        char* last = first + maxLength;
+        if constexpr (std::is_floating_point_v<T>) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            // the shortest general format of max_digits10 digits, as printed by streams before
+            const int precision = std::numeric_limits<T>::max_digits10;
+            used += std::to_chars(first, last, value, std::chars_format::general, precision).ptr - first;
+#else
+            used += std::snprintf(first, maxLength, "%.*g", std::numeric_limits<T>::max_digits10,
+                    static_cast<double>(value));
+#endif
+        } else {
+            used += std::to_chars(first, last, value).ptr - first;
+        }
+    }
+
+private:
+    /** Size of the output buffer, and of the blocks written to the destination */
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+    std::vector<char> buffer;
+    std::size_t used = 0;
+};
+
+}  // namespace souffle
@@ -18,6 +18,7 @@
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/io/WriteStream.h"
+#include "souffle/io/WriteStreamBuffered.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
@@ -25,22 +26,36 @@
 #include "souffle/io/gzfstream.h"
 #endif
 
+#include <algorithm>
+#include <cerrno>
 #include <cstddef>
-#include <fstream>
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <ostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#include <sys/stat.h>
+#endif
 
 namespace souffle {
 
-class WriteStreamCSV : public WriteStream {
+class WriteStreamCSV : public WriteStreamBuffered {
 protected:
     WriteStreamCSV(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
-            : WriteStream(rwOperation, symbolTable, recordTable),
+            : WriteStreamBuffered(rwOperation, symbolTable, recordTable),
               rfc4180(getOr(rwOperation, "rfc4180", "false") == std::string("true")),
               delimiter(getOr(rwOperation, "delimiter", (rfc4180 ? "," : "\t"))) {
         if (rfc4180 && delimiter.find('"') != std::string::npos) {
@@ -48,24 +63,25 @@ protected:
             errorMessage << "CSV delimiter cannot contain '\"' character when rfc4180 is enabled.";
             throw std::invalid_argument(errorMessage.str());
         }
+        nested << std::setprecision(std::numeric_limits<RamFloat>::max_digits10);
     };
 
     const bool rfc4180;
 
     const std::string delimiter;
 
-    void writeNextTupleCSV(std::ostream& destination, const RamDomain* tuple) {
-        writeNextTupleElement(destination, typeAttributes.at(0), tuple[0]);
+    void writeNextTupleCSV(const RamDomain* tuple) {
+        writeNextTupleElement(typeAttributes[0], tuple[0]);
 
         for (std::size_t col = 1; col < arity; ++col) {
-            destination << delimiter;
-            writeNextTupleElement(destination, typeAttributes.at(col), tuple[col]);
+            put(delimiter);
+            writeNextTupleElement(typeAttributes[col], tuple[col]);
         }
 
-        destination << "\n";
+        put('\n');
     }
 
-    virtual void outputSymbol(std::ostream& destination, const std::string& value) {
+    void outputSymbol(std::ostream& destination, const std::string& value) override {
         outputSymbol(destination, value, false);
     }
 
@@ -95,58 +111,117 @@ protected:
         }
     }
 
-    void writeNextTupleElement(std::ostream& destination, const std::string& type, RamDomain value) {
+    /** Write a symbol field straight from the storage of the symbol table */
+    void putSymbol(const std::string& value) {
+        if (!rfc4180) {
+            put(value);
+            return;
+        }
+        put('"');
+        std::size_t begin = 0;
+        for (std::size_t pos = value.find('"'); pos != std::string::npos; pos = value.find('"', pos + 1)) {
+            put(std::string_view(value).substr(begin, pos - begin));
+            put("\\\"");
+            begin = pos;
+        }
+        put(std::string_view(value).substr(begin));
+        put('"');
+    }
+
+    void writeNextTupleElement(const std::string& type, RamDomain value) {
         switch (type[0]) {
-            case 's': outputSymbol(destination, symbolTable.decode(value), true); break;
-            case 'i': destination << value; break;
-            case 'u': destination << ramBitCast<RamUnsigned>(value); break;
-            case 'f': destination << ramBitCast<RamFloat>(value); break;
+            case 's': putSymbol(symbolTable.decode(value)); break;
+            case 'i': putNumber(value); break;
+            case 'u': putNumber(ramBitCast<RamUnsigned>(value)); break;
+            case 'f': putNumber(ramBitCast<RamFloat>(value)); break;
             case 'r':
-                if (rfc4180) {
-                    destination << '"';
-                }
-                outputRecord(destination, value, type);
-                if (rfc4180) {
-                    destination << '"';
-                }
-                break;
             case '+':
+                // records and ADTs are formatted by the streams of the base class
+                nested.str("");
                 if (rfc4180) {
-                    destination << '"';
+                    nested << '"';
+                }
+                if (type[0] == 'r') {
+                    outputRecord(nested, value, type);
+                } else {
+                    outputADT(nested, value, type);
                 }
-                outputADT(destination, value, type);
                 if (rfc4180) {
-                    destination << '"';
+                    nested << '"';
                 }
+                put(nested.str());
                 break;
             default: fatal("unsupported type attribute: `%c`", type[0]);
         }
     }
+
+private:
+    /** Stream formatting records and ADTs */
+    std::stringstream nested;
 };
 
 class WriteFileCSV : public WriteStreamCSV {
 public:
     WriteFileCSV(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
-            : WriteStreamCSV(rwOperation, symbolTable, recordTable),
-              file(getFileName(rwOperation), std::ios::out | std::ios::binary) {
-        if (getOr(rwOperation, "headers", "false") == "true") {
-            file << rwOperation.at("attributeNames") << std::endl;
+            : WriteStreamCSV(rwOperation, symbolTable, recordTable), fileName(getFileName(rwOperation)) {
+        // appending continues the output of earlier batches of a streaming evaluation
+        const bool append = getOr(rwOperation, "append", "false") == "true";
+#ifndef _WIN32
+        file = ::open(fileName.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0666);
+#else
+        file = ::_open(fileName.c_str(), _O_WRONLY | _O_CREAT | (append ? _O_APPEND : _O_TRUNC) | _O_BINARY,
+                _S_IREAD | _S_IWRITE);
+#endif
+        if (file < 0) {
+            throw std::invalid_argument("Cannot open output file " + fileName);
+        }
+        if (!append && getOr(rwOperation, "headers", "false") == "true") {
+            put(rwOperation.at("attributeNames"));
+            put('\n');
         }
-        file << std::setprecision(std::numeric_limits<RamFloat>::max_digits10);
     }
 
-    ~WriteFileCSV() override = default;
+    ~WriteFileCSV() override {
+        flush();
+#ifndef _WIN32
+        ::close(file);
+#else
+        ::_close(file);
+#endif
+    }
 
 protected:
-    std::ofstream file;
+    const std::string fileName;
+
+    /** Descriptor of the output file */
+    int file;
 
     void writeNullary() override {
-        file << "()\n";
+        put("()\n");
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        writeNextTupleCSV(file, tuple);
+        writeNextTupleCSV(tuple);
+    }
+
+    void writeBlock(const char* data, std::size_t size) override {
+        while (size > 0) {
+#ifndef _WIN32
+            auto written = ::write(file, data, size);
+#else
+            auto written = ::_write(file, data, static_cast<unsigned>(std::min<std::size_t>(size, 1 << 30)));
+#endif
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(
+                        "Cannot write output file " + fileName + ": " + std::strerror(errno));
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
     }
 
     /**
@@ -171,22 +246,28 @@ public:
     WriteGZipFileCSV(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : WriteStreamCSV(rwOperation, symbolTable, recordTable),
-              file(getFileName(rwOperation), std::ios::out | std::ios::binary) {
+              file(getFileName(rwOperation), std::ios::out | std::ios::binary, getFormat(rwOperation)) {
         if (getOr(rwOperation, "headers", "false") == "true") {
-            file << rwOperation.at("attributeNames") << std::endl;
+            put(rwOperation.at("attributeNames"));
+            put('\n');
         }
-        file << std::setprecision(std::numeric_limits<RamFloat>::max_digits10);
     }
 
-    ~WriteGZipFileCSV() override = default;
+    ~WriteGZipFileCSV() override {
+        flush();
+    }
 
 protected:
     void writeNullary() override {
-        file << "()\n";
+        put("()\n");
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        writeNextTupleCSV(file, tuple);
+        writeNextTupleCSV(tuple);
+    }
+
+    void writeBlock(const char* data, std::size_t size) override {
+        file.write(data, static_cast<std::streamsize>(size));
     }
 
     /**
@@ -197,13 +278,28 @@ protected:
      * @return input filename
      */
     static std::string getFileName(const std::map<std::string, std::string>& rwOperation) {
-        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + ".csv.gz");
+        const bool zstd = getFormat(rwOperation) == gzfstream::Format::Zstd;
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + (zstd ? ".csv.zst" : ".csv.gz"));
         if (name.front() != '/') {
             name = getOr(rwOperation, "output-dir", ".") + "/" + name;
         }
         return name;
     }
 
+    /**
+     * Return the compression format, zstd for compress=zstd and gzip otherwise.
+     */
+    static gzfstream::Format getFormat(const std::map<std::string, std::string>& rwOperation) {
+        if (getOr(rwOperation, "compress", "") != "zstd") {
+            return gzfstream::Format::GZip;
+        }
+#ifdef USE_ZSTD
+        return gzfstream::Format::Zstd;
+#else
+        throw std::invalid_argument("zstd compression is not supported by this build");
+#endif
+    }
+
     gzfstream::ogzfstream file;
 };
 #endif
@@ -218,20 +314,24 @@ public:
             std::cout << "\n" << rwOperation.at("attributeNames");
         }
         std::cout << "\n===============\n";
-        std::cout << std::setprecision(std::numeric_limits<RamFloat>::max_digits10);
     }
 
     ~WriteCoutCSV() override {
+        flush();
         std::cout << "===============\n";
     }
 
 protected:
     void writeNullary() override {
-        std::cout << "()\n";
+        put("()\n");
     }
 
     void writeNextTuple(const RamDomain* tuple) override {
-        writeNextTupleCSV(std::cout, tuple);
+        writeNextTupleCSV(tuple);
+    }
+
+    void writeBlock(const char* data, std::size_t size) override {
+        std::cout.write(data, static_cast<std::streamsize>(size));
     }
 };
 
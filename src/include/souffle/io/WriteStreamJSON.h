@@ -15,210 +15,284 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
-#include "souffle/io/WriteStream.h"
+#include "souffle/io/WriteStreamBuffered.h"
 #include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/json11.h"
 
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
 #include <map>
-#include <ostream>
-#include <queue>
-#include <stack>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace souffle {
 
-class WriteStreamJSON : public WriteStream {
+class WriteStreamJSON : public WriteStreamBuffered {
 protected:
     WriteStreamJSON(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
-            : WriteStream(rwOperation, symbolTable, recordTable),
-              useObjects(getOr(rwOperation, "format", "list") == "object") {
-        if (useObjects) {
-            std::string err;
-            params = Json::parse(rwOperation.at("params"), err);
-            if (err.length() > 0) {
-                fatal("cannot get internal param names: %s", err);
-            }
+            : WriteStreamBuffered(rwOperation, symbolTable, recordTable),
+              useObjects(getOr(rwOperation, "format", "list") == "object"),
+              ndjson(getOr(rwOperation, "ndjson", "false") == "true") {
+        for (std::size_t col = 0; col < arity; ++col) {
+            columnNames.push_back(quote(params["relation"]["params"][col].string_value()) + ": ");
         }
     };
 
     const bool useObjects;
-    Json params;
 
-    void writeNextTupleJSON(std::ostream& destination, const RamDomain* tuple) {
-        std::vector<Json> result;
+    /** Tuples are written one per line, rather than as the elements of an array */
+    const bool ndjson;
+
+    /** Write the start of the output */
+    void writeBegin() {
+        if (!ndjson) {
+            put('[');
+        }
+    }
+
+    /** Write the end of the output; to be called by the destructors of the writers */
+    void writeEnd() {
+        if (!ndjson) {
+            put("]\n");
+        }
+        flush();
+    }
+
+    void writeNullary() override {
+        put("null\n");
+    }
 
-        if (useObjects)
-            destination << "{";
-        else
-            destination << "[";
+    void writeNextTuple(const RamDomain* tuple) override {
+        if (!ndjson && !isFirst) {
+            put(",\n");
+        }
+        isFirst = false;
+        writeNextTupleJSON(tuple);
+        if (ndjson) {
+            put('\n');
+        }
+    }
 
+    void writeNextTupleJSON(const RamDomain* tuple) {
+        put(useObjects ? '{' : '[');
         for (std::size_t col = 0; col < arity; ++col) {
             if (col > 0) {
-                destination << ", ";
+                put(", ");
             }
-
             if (useObjects) {
-                destination << params["relation"]["params"][col].dump() << ": ";
-                writeNextTupleObject(destination, typeAttributes.at(col), tuple[col]);
-            } else {
-                writeNextTupleList(destination, typeAttributes.at(col), tuple[col]);
+                put(columnNames[col]);
             }
+            writeValue(typeAttributes[col], tuple[col]);
         }
-
-        if (useObjects)
-            destination << "}";
-        else
-            destination << "]";
+        put(useObjects ? '}' : ']');
     }
 
-    void writeNextTupleList(std::ostream& destination, const std::string& name, const RamDomain value) {
-        using ValueTuple = std::pair<const std::string, const RamDomain>;
-        std::stack<std::variant<ValueTuple, std::string>> worklist;
-        worklist.push(std::make_pair(name, value));
-
-        // the Json11 output is not tail recursive, therefore highly inefficient for recursive record
-        // in addition the JSON object is immutable, so has memory overhead
-        while (!worklist.empty()) {
-            std::variant<ValueTuple, std::string> curr = worklist.top();
-            worklist.pop();
-
-            if (std::holds_alternative<std::string>(curr)) {
-                destination << std::get<std::string>(curr);
+    /**
+     * Write a value of the given type.
+     *
+     * Records are written as arrays, or as objects of their fields in the
+     * object format, and null for nil. ADTs are written as an object of
+     * their branch name and the array of the arguments of the branch, e.g.
+     * {"Cons": [1, {"Nil": []}]}. Nested values are written iteratively,
+     * such that deep values do not exhaust the stack.
+     */
+    void writeValue(const std::string& type, RamDomain value) {
+        const std::size_t bottom = frames.size();
+        writeElement(type, value);
+        while (frames.size() > bottom) {
+            Frame& frame = frames.back();
+            if (frame.next == frame.types->size()) {
+                put(frame.close);
+                frames.pop_back();
                 continue;
             }
+            if (frame.next > 0) {
+                put(", ");
+            }
+            if (frame.names != nullptr) {
+                put((*frame.names)[frame.next]);
+            }
+            const std::size_t next = frame.next++;
+            // the frame may be moved by pushing the frame of a nested value
+            writeElement((*frame.types)[next], frame.values[next]);
+        }
+    }
+
+private:
+    /** Types and quoted names of the fields of a record, or of the arguments of an ADT branch */
+    struct Fields {
+        std::vector<std::string> types;
+        std::vector<std::string> names;
+    };
 
-            const std::string& currType = std::get<ValueTuple>(curr).first;
-            const RamDomain currValue = std::get<ValueTuple>(curr).second;
-            assert(currType.length() > 2 && "Invalid type length");
-            switch (currType[0]) {
-                // since some strings may need to be escaped, we use dump here
-                case 's': destination << Json(symbolTable.decode(currValue)).dump(); break;
-                case 'i': destination << currValue; break;
-                case 'u': destination << (int)ramBitCast<RamUnsigned>(currValue); break;
-                case 'f': destination << ramBitCast<RamFloat>(currValue); break;
-                case 'r': {
-                    auto&& recordInfo = types["records"][currType];
-                    assert(!recordInfo.is_null() && "Missing record type information");
-                    if (currValue == 0) {
-                        destination << "null";
-                        break;
-                    }
-
-                    auto&& recordTypes = recordInfo["types"];
-                    const std::size_t recordArity = recordInfo["arity"].long_value();
-                    const RamDomain* tuplePtr = recordTable.unpack(currValue, recordArity);
-                    worklist.push("]");
-                    for (auto i = (long long)(recordArity - 1); i >= 0; --i) {
-                        if (i != (long long)(recordArity - 1)) {
-                            worklist.push(", ");
-                        }
-                        const std::string& recordType = recordTypes[i].string_value();
-                        const RamDomain recordValue = tuplePtr[i];
-                        worklist.push(std::make_pair(recordType, recordValue));
-                    }
-
-                    worklist.push("[");
+    /** Record or branch of an ADT whose fields are being written */
+    struct Frame {
+        const std::vector<std::string>* types;
+        const std::vector<std::string>* names;
+        const RamDomain* values;
+        std::size_t next;
+        std::string_view close;
+    };
+
+    /** Write a value, starting the frame of a record or ADT */
+    void writeElement(const std::string& type, RamDomain value) {
+        switch (type[0]) {
+            case 's': putString(symbolTable.decode(value)); break;
+            case 'i': putNumber(value); break;
+            case 'u': putNumber(ramBitCast<RamUnsigned>(value)); break;
+            case 'f': putNumber(ramBitCast<RamFloat>(value)); break;
+            case 'r': {
+                if (value == 0) {
+                    put("null");
                     break;
                 }
-                default: fatal("unsupported type attribute: `%c`", currType[0]);
+                const Fields& fields = getRecord(type);
+                const RamDomain* values = recordTable.unpack(value, fields.types.size());
+                put(useObjects ? '{' : '[');
+                frames.push_back({&fields.types, useObjects ? &fields.names : nullptr, values, 0,
+                        useObjects ? "}" : "]"});
+                break;
+            }
+            case '+': {
+                const auto& [isEnum, branches] = getADT(type);
+                RamDomain branch = value;
+                const RamDomain* args = nullptr;
+                if (!isEnum && isUnboxedBranch(value)) {
+                    branch = unpackUnboxedBranch(value);
+                } else if (!isEnum) {
+                    const RamDomain* tuple = recordTable.unpack(value, 2);
+                    branch = tuple[0];
+                    const std::size_t argCount = branches[branch].second.types.size();
+                    args = argCount > 1 ? recordTable.unpack(tuple[1], argCount) : &tuple[1];
+                }
+                put('{');
+                put(branches[branch].first);
+                put(": [");
+                frames.push_back({&branches[branch].second.types, nullptr, args, 0, "]}"});
+                break;
             }
+            default: fatal("unsupported type attribute: `%c`", type[0]);
         }
     }
 
-    void writeNextTupleObject(std::ostream& destination, const std::string& name, const RamDomain value) {
-        using ValueTuple = std::pair<const std::string, const RamDomain>;
-        std::stack<std::variant<ValueTuple, std::string>> worklist;
-        worklist.push(std::make_pair(name, value));
-
-        // the Json11 output is not tail recursive, therefore highly inefficient for recursive record
-        // in addition the JSON object is immutable, so has memory overhead
-        while (!worklist.empty()) {
-            std::variant<ValueTuple, std::string> curr = worklist.top();
-            worklist.pop();
-
-            if (std::holds_alternative<std::string>(curr)) {
-                destination << std::get<std::string>(curr);
+    /** Write a string, escaped as by json11 */
+    void putString(const std::string& value) {
+        put('"');
+        std::size_t begin = 0;
+        for (std::size_t pos = 0; pos < value.size(); ++pos) {
+            const auto ch = static_cast<unsigned char>(value[pos]);
+            const bool separator = ch == 0xe2 && pos + 2 < value.size() &&
+                                   static_cast<unsigned char>(value[pos + 1]) == 0x80 &&
+                                   (static_cast<unsigned char>(value[pos + 2]) & 0xfe) == 0xa8;
+            if (ch >= 0x20 && ch != '"' && ch != '\\' && !separator) {
                 continue;
             }
-
-            const std::string& currType = std::get<ValueTuple>(curr).first;
-            const RamDomain currValue = std::get<ValueTuple>(curr).second;
-            const std::string& typeName = currType.substr(2);
-            assert(currType.length() > 2 && "Invalid type length");
-            switch (currType[0]) {
-                // since some strings may need to be escaped, we use dump here
-                case 's': destination << Json(symbolTable.decode(currValue)).dump(); break;
-                case 'i': destination << currValue; break;
-                case 'u': destination << (int)ramBitCast<RamUnsigned>(currValue); break;
-                case 'f': destination << ramBitCast<RamFloat>(currValue); break;
-                case 'r': {
-                    auto&& recordInfo = types["records"][currType];
-                    assert(!recordInfo.is_null() && "Missing record type information");
-                    if (currValue == 0) {
-                        destination << "null";
-                        break;
-                    }
-
-                    auto&& recordTypes = recordInfo["types"];
-                    const std::size_t recordArity = recordInfo["arity"].long_value();
-                    const RamDomain* tuplePtr = recordTable.unpack(currValue, recordArity);
-                    worklist.push("}");
-                    for (auto i = (long long)(recordArity - 1); i >= 0; --i) {
-                        if (i != (long long)(recordArity - 1)) {
-                            worklist.push(", ");
-                        }
-                        const std::string& recordType = recordTypes[i].string_value();
-                        const RamDomain recordValue = tuplePtr[i];
-                        worklist.push(std::make_pair(recordType, recordValue));
-                        worklist.push(": ");
-
-                        auto&& recordParam = params["records"][typeName]["params"][i];
-                        assert(recordParam.is_string());
-                        worklist.push(recordParam.dump());
-                    }
-
-                    worklist.push("{");
-                    break;
+            put(std::string_view(value).substr(begin, pos - begin));
+            switch (ch) {
+                case '"': put("\\\""); break;
+                case '\\': put("\\\\"); break;
+                case '\b': put("\\b"); break;
+                case '\f': put("\\f"); break;
+                case '\n': put("\\n"); break;
+                case '\r': put("\\r"); break;
+                case '\t': put("\\t"); break;
+                default: {
+                    // control characters, and the line and paragraph separators of JavaScript
+                    char escaped[8];
+                    const unsigned code =
+                            separator ? 0x2028u + (static_cast<unsigned char>(value[pos + 2]) & 1) : ch;
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", code);
+                    put(escaped);
+                    pos += separator ? 2 : 0;
                 }
-                default: fatal("unsupported type attribute: `%c`", currType[0]);
             }
+            begin = pos + 1;
+        }
+        put(std::string_view(value).substr(begin));
+        put('"');
+    }
+
+    static std::string quote(const std::string& value) {
+        return Json(value).dump();
+    }
+
+    const Fields& getRecord(const std::string& type) {
+        auto pos = records.find(type);
+        if (pos != records.end()) {
+            return pos->second;
+        }
+        auto&& recordInfo = types["records"][type];
+        assert(!recordInfo.is_null() && "Missing record type information");
+        Fields fields;
+        const std::size_t recordArity = recordInfo["arity"].long_value();
+        for (std::size_t i = 0; i < recordArity; ++i) {
+            fields.types.push_back(recordInfo["types"][i].string_value());
+            auto&& name = params["records"][type.substr(2)]["params"][i];
+            fields.names.push_back(quote(name.string_value()) + ": ");
+        }
+        return records.emplace(type, std::move(fields)).first->second;
+    }
+
+    /** Return whether an ADT is an enumeration, and the quoted names and arguments of its branches */
+    const std::pair<bool, std::vector<std::pair<std::string, Fields>>>& getADT(const std::string& type) {
+        auto pos = adts.find(type);
+        if (pos != adts.end()) {
+            return pos->second;
+        }
+        auto&& adtInfo = types["ADTs"][type];
+        assert(!adtInfo.is_null() && "Missing adt type information");
+        std::vector<std::pair<std::string, Fields>> branches;
+        for (auto&& branch : adtInfo["branches"].array_items()) {
+            Fields fields;
+            for (auto&& argType : branch["types"].array_items()) {
+                fields.types.push_back(argType.string_value());
+            }
+            branches.emplace_back(quote(branch["name"].string_value()), std::move(fields));
         }
+        return adts.emplace(type, std::make_pair(adtInfo["enum"].bool_value(), std::move(branches)))
+                .first->second;
     }
+
+    /** Quoted attribute names followed by a colon, for the object format */
+    std::vector<std::string> columnNames;
+
+    std::map<std::string, Fields> records;
+    std::map<std::string, std::pair<bool, std::vector<std::pair<std::string, Fields>>>> adts;
+
+    /** Records and ADTs being written, innermost last */
+    std::vector<Frame> frames;
+
+    bool isFirst = true;
 };
 
 class WriteFileJSON : public WriteStreamJSON {
 public:
     WriteFileJSON(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
-            : WriteStreamJSON(rwOperation, symbolTable, recordTable), isFirst(true),
+            : WriteStreamJSON(rwOperation, symbolTable, recordTable),
               file(getFileName(rwOperation), std::ios::out | std::ios::binary) {
-        file << "[";
+        writeBegin();
     }
 
     ~WriteFileJSON() override {
-        file << "]\n";
+        writeEnd();
         file.close();
     }
 
 protected:
-    bool isFirst;
     std::ofstream file;
 
-    void writeNullary() override {
-        file << "null\n";
-    }
-
-    void writeNextTuple(const RamDomain* tuple) override {
-        if (!isFirst) {
-            file << ",\n";
-        } else {
-            isFirst = false;
-        }
-        writeNextTupleJSON(file, tuple);
+    void writeBlock(const char* data, std::size_t size) override {
+        file.write(data, static_cast<std::streamsize>(size));
     }
 
     /**
@@ -241,28 +315,17 @@ class WriteCoutJSON : public WriteStreamJSON {
 public:
     WriteCoutJSON(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
-            : WriteStreamJSON(rwOperation, symbolTable, recordTable), isFirst(true) {
-        std::cout << "[";
+            : WriteStreamJSON(rwOperation, symbolTable, recordTable) {
+        writeBegin();
     }
 
     ~WriteCoutJSON() override {
-        std::cout << "]\n";
+        writeEnd();
     };
 
 protected:
-    bool isFirst;
-
-    void writeNullary() override {
-        std::cout << "null\n";
-    }
-
-    void writeNextTuple(const RamDomain* tuple) override {
-        if (!isFirst) {
-            std::cout << ",\n";
-        } else {
-            isFirst = false;
-        }
-        writeNextTupleJSON(std::cout, tuple);
+    void writeBlock(const char* data, std::size_t size) override {
+        std::cout.write(data, static_cast<std::streamsize>(size));
     }
 };
 
@@ -0,0 +1,140 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamObject.h
+ *
+ * Writes relations in the CSV format to objects of S3, Google Cloud
+ * Storage and HTTP servers (see ObjectStorage.h), e.g.,
+ *
+ *     .output path(IO=object, filename="s3://bucket/out/path.csv.gz", compress=gzip)
+ *
+ * Relative file names are resolved against the output directory, which
+ * may be the URL of a prefix of objects as well.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/ObjectStorage.h"
+#include "souffle/io/WriteStream.h"
+#include "souffle/io/WriteStreamCSV.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace souffle {
+
+class WriteObjectCSV : public WriteStreamCSV {
+public:
+    WriteObjectCSV(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable)
+            : WriteStreamCSV(rwOperation, symbolTable, recordTable),
+              upload(getUri(rwOperation), getCodec(rwOperation),
+                      object::getSize(rwOperation, "part-size", object::DEFAULT_PART_SIZE),
+                      object::getSize(rwOperation, "parallel-parts", object::DEFAULT_PARALLEL_PARTS)),
+              uri(getUri(rwOperation)) {
+        if (getOr(rwOperation, "headers", "false") == "true") {
+            put(rwOperation.at("attributeNames"));
+            put('\n');
+        }
+    }
+
+    ~WriteObjectCSV() override {
+        // an incomplete object must not pass for the output of the relation
+        try {
+            flush();
+            upload.close();
+        } catch (std::exception& e) {
+            std::cerr << "Error writing " << uri << ": " << e.what() << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+protected:
+    void writeNullary() override {
+        put("()\n");
+    }
+
+    void writeNextTuple(const RamDomain* tuple) override {
+        writeNextTupleCSV(tuple);
+    }
+
+    void writeBlock(const char* data, std::size_t size) override {
+        upload.write(data, size);
+    }
+
+    /**
+     * Return the URL of the object, given or constructed from the relation name.
+     * Default name is [configured path]/[relation name].csv, with the extension of the compression
+     */
+    static std::string getUri(const std::map<std::string, std::string>& rwOperation) {
+        std::string extension = ".csv";
+        switch (getCodec(rwOperation)) {
+            case object::Codec::GZip: extension += ".gz"; break;
+            case object::Codec::Zstd: extension += ".zst"; break;
+            default: break;
+        }
+        auto name = getOr(rwOperation, "filename", rwOperation.at("name") + extension);
+        if (!object::isObjectUrl(name)) {
+            name = getOr(rwOperation, "output-dir", ".") + "/" + name;
+        }
+        return name;
+    }
+
+    /**
+     * Return the compression of the object, zstd for compress=zstd and gzip for any other value.
+     */
+    static object::Codec getCodec(const std::map<std::string, std::string>& rwOperation) {
+        if (!contains(rwOperation, "compress")) {
+            return object::Codec::Plain;
+        }
+        if (rwOperation.at("compress") != "zstd") {
+#ifdef USE_LIBZ
+            return object::Codec::GZip;
+#else
+            throw std::invalid_argument("gzip compression is not supported by this build");
+#endif
+        }
+#ifdef USE_ZSTD
+        return object::Codec::Zstd;
+#else
+        throw std::invalid_argument("zstd compression is not supported by this build");
+#endif
+    }
+
+    object::Upload upload;
+    const std::string uri;
+};
+
+class WriteObjectCSVFactory : public WriteStreamFactory {
+public:
+    Own<WriteStream> getWriter(const std::map<std::string, std::string>& rwOperation,
+            const SymbolTable& symbolTable, const RecordTable& recordTable) override {
+        return mk<WriteObjectCSV>(rwOperation, symbolTable, recordTable);
+    }
+
+    const std::string& getName() const override {
+        static const std::string name = "object";
+        return name;
+    }
+
+    ~WriteObjectCSVFactory() override = default;
+};
+
+} /* namespace souffle */
@@ -0,0 +1,225 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file WriteStreamPartitioned.h
+ *
+ * Writes a relation to several files in parallel, given by the
+ * `partitions=N` option of an output directive.
+ *
+ * The files are written by the writers of the IO type of the directive,
+ * and named by the file name of the directive with the number of the
+ * partition appended to its stem, e.g. `path-00003.parquet`.
+ *
+ * Without `partition_by`, the relation is range-partitioned: the
+ * consecutive parts a relation is scanned in by parallel loops are assigned
+ * to the files in order, such that each file holds a range of the relation
+ * in the order of its primary index. With `partition_by=attribute`, the
+ * relation is hash-partitioned by the given attribute, e.g. for joins by
+ * the attribute with other partitioned data: the parts are scanned in
+ * parallel into a bucket per file, and the buckets of each file then
+ * written in parallel. Symbols are hashed by their text, such that they
+ * are partitioned alike across programs; records and ADTs are hashed by
+ * their numbers.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/WriteStream.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+class WritePartitioned : public WriteStream {
+public:
+    WritePartitioned(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
+            const RecordTable& recordTable, WriteStreamFactory& factory)
+            : WriteStream(rwOperation, symbolTable, recordTable),
+              partitionColumn(getPartitionColumn(rwOperation)) {
+        const std::size_t count = std::stoul(rwOperation.at("partitions"));
+        if (count == 0) {
+            throw std::invalid_argument(
+                    "Cannot write relation " + rwOperation.at("name") + " to no partitions");
+        }
+        const std::string name = getFileName(rwOperation);
+        // the stem ends at the first dot of the last path component, such that `r.csv.gz` gives `r-0.csv.gz`
+        const std::size_t base = name.find_last_of('/') == std::string::npos ? 0 : name.find_last_of('/') + 1;
+        const std::size_t dot = std::min(name.find('.', base), name.size());
+
+        for (std::size_t i = 0; i < count; i++) {
+            std::stringstream partitionName;
+            partitionName << name.substr(0, dot) << "-" << std::setw(5) << std::setfill('0') << i
+                          << name.substr(dot);
+            auto partition = rwOperation;
+            partition.erase("partitions");
+            partition["filename"] = partitionName.str();
+            writers.push_back(factory.getWriter(partition, symbolTable, recordTable));
+        }
+    }
+
+protected:
+    void writeNullary() override {
+        writers[0]->writeNullary();
+    }
+
+    void writeNextTuple(const RamDomain* tuple) override {
+        writers[getPartition(tuple)]->writeNextTuple(tuple);
+    }
+
+    std::size_t getScanCount() const override {
+        // more parts than threads balance the load of hash partitioning
+        return partitionColumn < 0 ? writers.size() : std::max<std::size_t>(writers.size(), MAX_THREADS) * 4;
+    }
+
+    void writeScans(const std::vector<Scan>& scans) override {
+        if (partitionColumn < 0) {
+            writeRanges(scans);
+        } else {
+            writeHashed(scans);
+        }
+    }
+
+private:
+    /** Write each file from the parts assigned to it in order */
+    void writeRanges(const std::vector<Scan>& scans) {
+        const std::size_t count = writers.size();
+        runParallel(count, [&](std::size_t file) {
+            for (std::size_t i = file * scans.size() / count; i < (file + 1) * scans.size() / count; i++) {
+                scans[i]([&](const RamDomain* tuple) { writers[file]->writeNextTuple(tuple); });
+            }
+        });
+    }
+
+    /** Scan the parts into a bucket per part and file, then write each file from its buckets */
+    void writeHashed(const std::vector<Scan>& scans) {
+        const std::size_t count = writers.size();
+        std::vector<std::vector<std::vector<RamDomain>>> buckets(
+                scans.size(), std::vector<std::vector<RamDomain>>(count));
+        runParallel(scans.size(), [&](std::size_t part) {
+            scans[part]([&](const RamDomain* tuple) {
+                auto& bucket = buckets[part][getPartition(tuple)];
+                bucket.insert(bucket.end(), tuple, tuple + arity);
+            });
+        });
+        runParallel(count, [&](std::size_t file) {
+            for (auto& part : buckets) {
+                const auto& bucket = part[file];
+                for (std::size_t i = 0; i < bucket.size(); i += arity) {
+                    writers[file]->writeNextTuple(&bucket[i]);
+                }
+                part[file] = {};
+            }
+        });
+    }
+
+    /** Run the given function for each index in parallel, passing on the first exception thrown */
+    template <typename Function>
+    void runParallel(std::size_t count, const Function& function) {
+        std::exception_ptr error;
+        std::mutex lock;
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < count; ++i) {
+            try {
+                function(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        PARALLEL_END
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::size_t getPartition(const RamDomain* tuple) const {
+        if (partitionColumn < 0) {
+            return 0;
+        }
+        const RamDomain value = tuple[partitionColumn];
+        std::uint64_t hash = static_cast<std::uint64_t>(static_cast<RamUnsigned>(value));
+        if (typeAttributes[partitionColumn][0] == 's') {
+            // FNV-1a of the text of the symbol
+            hash = 14695981039346656037ull;
+            for (unsigned char c : symbolTable.decode(value)) {
+                hash = (hash ^ c) * 1099511628211ull;
+            }
+        }
+        // mix the bits, such that consecutive numbers spread over all files
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        return static_cast<std::size_t>(hash % writers.size());
+    }
+
+    /** Return the position of the attribute named or numbered by the `partition_by` option, or -1 */
+    int getPartitionColumn(const std::map<std::string, std::string>& rwOperation) const {
+        if (rwOperation.count("partition_by") == 0) {
+            return -1;
+        }
+        const std::string& attribute = rwOperation.at("partition_by");
+        auto&& names = params["relation"]["params"].array_items();
+        for (std::size_t i = 0; i < names.size() && i < arity; i++) {
+            if (names[i].string_value() == attribute) {
+                return static_cast<int>(i);
+            }
+        }
+        if (!attribute.empty() && std::all_of(attribute.begin(), attribute.end(), ::isdigit) &&
+                std::stoul(attribute) < arity) {
+            return static_cast<int>(std::stoul(attribute));
+        }
+        throw std::invalid_argument(
+                "Cannot partition relation " + rwOperation.at("name") + " by unknown attribute " + attribute);
+    }
+
+    /**
+     * Return given filename or construct from relation name and the extension of the IO type.
+     * Default name is [relation name][extension]
+     *
+     * @param rwOperation map of IO configuration options
+     * @return output filename, of which the partition names are derived
+     */
+    static std::string getFileName(const std::map<std::string, std::string>& rwOperation) {
+        static const std::map<std::string, std::string> extensions = {{"file", ".csv"}, {"jsonfile", ".json"},
+                {"binary", ".bin"}, {"parquet", ".parquet"}, {"arrow", ".arrow"}};
+        const std::string& io = rwOperation.at("IO");
+        if (extensions.count(io) == 0) {
+            throw std::invalid_argument("Output type <" + io + "> cannot be partitioned");
+        }
+        // the writers of the partitions resolve the names relative to the output directory
+        return getOr(rwOperation, "filename", rwOperation.at("name") + extensions.at(io));
+    }
+
+    /** Position of the attribute to hash-partition by, or -1 to range-partition */
+    const int partitionColumn;
+
+    /** Writers of the files, by partition */
+    std::vector<Own<WriteStream>> writers;
+};
+
+} /* namespace souffle */
@@ -18,6 +18,8 @@
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/io/WriteStream.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -37,7 +39,8 @@ public:
     WriteStreamSQLite(const std::map<std::string, std::string>& rwOperation, const SymbolTable& symbolTable,
             const RecordTable& recordTable)
             : WriteStream(rwOperation, symbolTable, recordTable), dbFilename(getFileName(rwOperation)),
-              relationName(rwOperation.at("name")) {
+              relationName(rwOperation.at("name")),
+              durable(getOr(rwOperation, "durable", "false") == "true") {
         openDB();
         createTables();
         prepareStatements();
@@ -45,6 +48,7 @@ public:
     }
 
     ~WriteStreamSQLite() override {
+        flush();
         executeSQL("COMMIT", db);
         sqlite3_finalize(insertStatement);
         sqlite3_finalize(symbolInsertStatement);
@@ -56,30 +60,59 @@ protected:
     void writeNullary() override {}
 
     void writeNextTuple(const RamDomain* tuple) override {
-        for (std::size_t i = 0; i < arity; i++) {
-            RamDomain value = 0;  // Silence warning
+        buffer.insert(buffer.end(), tuple, tuple + arity);
+        if (buffer.size() == rowsPerInsert * arity) {
+            flush();
+        }
+    }
+
+private:
+    /**
+     * Insert the buffered tuples.
+     *
+     * The symbols of the tuples are resolved first, a batch at a time, and
+     * the tuples are then inserted by rowsPerInsert rows per statement.
+     */
+    void flush() {
+        if (buffer.empty()) {
+            return;
+        }
+        resolveSymbols();
 
-            switch (typeAttributes.at(i)[0]) {
-                case 's': value = getSymbolTableID(tuple[i]); break;
-                default: value = tuple[i]; break;
+        const std::size_t rows = buffer.size() / arity;
+        sqlite3_stmt* statement = insertStatement;
+        if (rows < rowsPerInsert) {
+            statement = prepareInsertStatement(rows);
+        }
+        for (std::size_t i = 0; i < buffer.size(); i++) {
+            RamDomain value = buffer[i];
+            if (typeAttributes.at(i % arity)[0] == 's') {
+                value = static_cast<RamDomain>(dbSymbolTable.at(value));
             }
+            bind(statement, static_cast<int>(i) + 1, value);
+        }
+        if (sqlite3_step(statement) != SQLITE_DONE) {
+            throwError("SQLite error in sqlite3_step: ");
+        }
+        if (statement == insertStatement) {
+            sqlite3_clear_bindings(statement);
+            sqlite3_reset(statement);
+        } else {
+            sqlite3_finalize(statement);
+        }
+        buffer.clear();
+    }
 
+    void bind(sqlite3_stmt* statement, int position, RamDomain value) {
 #if RAM_DOMAIN_SIZE == 64
-            if (sqlite3_bind_int64(insertStatement, i + 1, value) != SQLITE_OK) {
+        if (sqlite3_bind_int64(statement, position, value) != SQLITE_OK) {
 #else
-            if (sqlite3_bind_int(insertStatement, i + 1, value) != SQLITE_OK) {
+        if (sqlite3_bind_int(statement, position, value) != SQLITE_OK) {
 #endif
-                throwError("SQLite error in sqlite3_bind_text: ");
-            }
+            throwError("SQLite error in sqlite3_bind_int: ");
         }
-        if (sqlite3_step(insertStatement) != SQLITE_DONE) {
-            throwError("SQLite error in sqlite3_step: ");
-        }
-        sqlite3_clear_bindings(insertStatement);
-        sqlite3_reset(insertStatement);
     }
 
-private:
     void executeSQL(const std::string& sql, sqlite3* db) {
         assert(db && "Database connection is closed");
 
@@ -102,89 +135,150 @@ private:
         throw std::invalid_argument(error.str());
     }
 
-    uint64_t getSymbolTableIDFromDB(int index) {
-        if (sqlite3_bind_text(symbolSelectStatement, 1, symbolTable.decode(index).c_str(), -1,
-                    SQLITE_TRANSIENT) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_bind_text: ");
-        }
-        if (sqlite3_step(symbolSelectStatement) != SQLITE_ROW) {
-            throwError("SQLite error in sqlite3_step: ");
-        }
-        uint64_t rowid = sqlite3_column_int64(symbolSelectStatement, 0);
-        sqlite3_clear_bindings(symbolSelectStatement);
-        sqlite3_reset(symbolSelectStatement);
-        return rowid;
-    }
-    uint64_t getSymbolTableID(int index) {
-        if (dbSymbolTable.count(index) != 0) {
-            return dbSymbolTable[index];
+    /**
+     * Look up the row ids of the symbols of the buffered tuples.
+     *
+     * Symbols seen before are cached; the others are inserted unless the
+     * database already holds them and their row ids are then selected, both
+     * by symbolsPerStatement symbols per statement.
+     */
+    void resolveSymbols() {
+        std::vector<RamDomain> missing;
+        for (std::size_t i = 0; i < buffer.size(); i++) {
+            if (typeAttributes.at(i % arity)[0] == 's' && dbSymbolTable.count(buffer[i]) == 0) {
+                // reserve the entry such that each symbol is only looked up once
+                dbSymbolTable[buffer[i]] = 0;
+                missing.push_back(buffer[i]);
+            }
         }
 
-        if (sqlite3_bind_text(symbolInsertStatement, 1, symbolTable.decode(index).c_str(), -1,
-                    SQLITE_TRANSIENT) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_bind_text: ");
-        }
-        // Either the insert succeeds and we have a new row id or it already exists and a select is needed.
-        uint64_t rowid;
-        if (sqlite3_step(symbolInsertStatement) != SQLITE_DONE) {
-            // The symbol already exists so select it.
-            rowid = getSymbolTableIDFromDB(index);
-        } else {
-            rowid = sqlite3_last_insert_rowid(db);
-        }
-        sqlite3_clear_bindings(symbolInsertStatement);
-        sqlite3_reset(symbolInsertStatement);
+        std::unordered_map<std::string, RamDomain> indices;
+        for (std::size_t begin = 0; begin < missing.size(); begin += symbolsPerStatement) {
+            const std::size_t count = std::min(symbolsPerStatement, missing.size() - begin);
+            sqlite3_stmt* insert = symbolInsertStatement;
+            sqlite3_stmt* select = symbolSelectStatement;
+            if (count < symbolsPerStatement) {
+                insert = prepareSymbolInsertStatement(count);
+                select = prepareSymbolSelectStatement(count);
+            }
 
-        dbSymbolTable[index] = rowid;
-        return rowid;
+            indices.clear();
+            for (std::size_t i = 0; i < count; i++) {
+                const std::string& symbol = symbolTable.decode(missing[begin + i]);
+                indices[symbol] = missing[begin + i];
+                // the symbol table outlives the statements, such that its strings need not be copied
+                if (sqlite3_bind_text(insert, static_cast<int>(i) + 1, symbol.c_str(), -1, SQLITE_STATIC) !=
+                                SQLITE_OK ||
+                        sqlite3_bind_text(select, static_cast<int>(i) + 1, symbol.c_str(), -1,
+                                SQLITE_STATIC) != SQLITE_OK) {
+                    throwError("SQLite error in sqlite3_bind_text: ");
+                }
+            }
+
+            if (sqlite3_step(insert) != SQLITE_DONE) {
+                throwError("SQLite error in sqlite3_step: ");
+            }
+            int rc;
+            while ((rc = sqlite3_step(select)) == SQLITE_ROW) {
+                const auto* symbol = reinterpret_cast<const char*>(sqlite3_column_text(select, 1));
+                dbSymbolTable[indices.at(symbol)] = sqlite3_column_int64(select, 0);
+            }
+            if (rc != SQLITE_DONE) {
+                throwError("SQLite error in sqlite3_step: ");
+            }
+
+            if (count < symbolsPerStatement) {
+                sqlite3_finalize(insert);
+                sqlite3_finalize(select);
+            } else {
+                sqlite3_clear_bindings(insert);
+                sqlite3_reset(insert);
+                sqlite3_clear_bindings(select);
+                sqlite3_reset(select);
+            }
+        }
     }
 
+    /**
+     * Open the database.
+     *
+     * Databases are scratch databases by default, which are written without
+     * syncing and with an in-memory journal. Durable databases are written
+     * with a write-ahead log instead.
+     */
     void openDB() {
         if (sqlite3_open(dbFilename.c_str(), &db) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_open");
         }
         sqlite3_extended_result_codes(db, 1);
-        executeSQL("PRAGMA synchronous = OFF", db);
-        executeSQL("PRAGMA journal_mode = MEMORY", db);
+        // relations written concurrently to the same database wait for each other
+        sqlite3_busy_timeout(db, BUSY_TIMEOUT);
+        if (durable) {
+            executeSQL("PRAGMA journal_mode = WAL", db);
+            executeSQL("PRAGMA synchronous = NORMAL", db);
+        } else {
+            executeSQL("PRAGMA journal_mode = MEMORY", db);
+            executeSQL("PRAGMA synchronous = OFF", db);
+        }
+        executeSQL("PRAGMA temp_store = MEMORY", db);
+        executeSQL("PRAGMA cache_size = -" + std::to_string(CACHE_SIZE), db);
+
+        // bind as many rows per statement as the variable limit of the library allows
+        const auto variables = static_cast<std::size_t>(sqlite3_limit(db, SQLITE_LIMIT_VARIABLE_NUMBER, -1));
+        symbolsPerStatement = std::max<std::size_t>(1, std::min(variables, MAX_ROWS_PER_INSERT));
+        rowsPerInsert = std::max<std::size_t>(1, std::min(variables / std::max<std::size_t>(arity, 1),
+                                                         MAX_ROWS_PER_INSERT));
+        buffer.reserve(rowsPerInsert * arity);
     }
 
     void prepareStatements() {
-        prepareInsertStatement();
-        prepareSymbolInsertStatement();
-        prepareSymbolSelectStatement();
+        insertStatement = prepareInsertStatement(rowsPerInsert);
+        symbolInsertStatement = prepareSymbolInsertStatement(symbolsPerStatement);
+        symbolSelectStatement = prepareSymbolSelectStatement(symbolsPerStatement);
     }
-    void prepareSymbolInsertStatement() {
-        std::stringstream insertSQL;
-        insertSQL << "INSERT INTO " << symbolTableName;
-        insertSQL << " VALUES(null,@V0);";
+
+    sqlite3_stmt* prepare(const std::string& sql) {
+        sqlite3_stmt* statement = nullptr;
         const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, insertSQL.str().c_str(), -1, &symbolInsertStatement, &tail) != SQLITE_OK) {
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, &tail) != SQLITE_OK) {
             throwError("SQLite error in sqlite3_prepare_v2: ");
         }
+        return statement;
     }
 
-    void prepareSymbolSelectStatement() {
+    sqlite3_stmt* prepareSymbolInsertStatement(std::size_t count) {
+        std::stringstream insertSQL;
+        insertSQL << "INSERT OR IGNORE INTO " << symbolTableName << "(symbol) VALUES ";
+        for (std::size_t i = 0; i < count; i++) {
+            insertSQL << (i == 0 ? "(?)" : ",(?)");
+        }
+        insertSQL << ";";
+        return prepare(insertSQL.str());
+    }
+
+    sqlite3_stmt* prepareSymbolSelectStatement(std::size_t count) {
         std::stringstream selectSQL;
-        selectSQL << "SELECT id FROM " << symbolTableName;
-        selectSQL << " WHERE symbol = @V0;";
-        const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, selectSQL.str().c_str(), -1, &symbolSelectStatement, &tail) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_prepare_v2: ");
+        selectSQL << "SELECT id, symbol FROM " << symbolTableName;
+        selectSQL << " WHERE symbol IN (";
+        for (std::size_t i = 0; i < count; i++) {
+            selectSQL << (i == 0 ? "?" : ",?");
         }
+        selectSQL << ");";
+        return prepare(selectSQL.str());
     }
 
-    void prepareInsertStatement() {
+    sqlite3_stmt* prepareInsertStatement(std::size_t rows) {
         std::stringstream insertSQL;
         insertSQL << "INSERT INTO '_" << relationName << "' VALUES ";
-        insertSQL << "(@V0";
-        for (unsigned int i = 1; i < arity; i++) {
-            insertSQL << ",@V" << i;
-        }
-        insertSQL << ");";
-        const char* tail = nullptr;
-        if (sqlite3_prepare_v2(db, insertSQL.str().c_str(), -1, &insertStatement, &tail) != SQLITE_OK) {
-            throwError("SQLite error in sqlite3_prepare_v2: ");
+        for (std::size_t row = 0; row < rows; row++) {
+            insertSQL << (row == 0 ? "(?" : ",(?");
+            for (std::size_t i = 1; i < arity; i++) {
+                insertSQL << ",?";
+            }
+            insertSQL << ")";
         }
+        insertSQL << ";";
+        return prepare(insertSQL.str());
     }
 
     void createTables() {
@@ -279,6 +373,22 @@ private:
     const std::string dbFilename;
     const std::string relationName;
     const std::string symbolTableName = "__SymbolTable";
+    const bool durable;
+
+    /** Maximal number of rows inserted, or symbols looked up, per statement */
+    static constexpr std::size_t MAX_ROWS_PER_INSERT = 512;
+
+    /** Size of the page cache in KiB */
+    static constexpr std::size_t CACHE_SIZE = 64 * 1024;
+
+    /** Time to wait for a locked database in milliseconds */
+    static constexpr int BUSY_TIMEOUT = 60 * 1000;
+
+    std::size_t rowsPerInsert = 1;
+    std::size_t symbolsPerStatement = 1;
+
+    /** Tuples not inserted yet */
+    std::vector<RamDomain> buffer;
 
     std::unordered_map<uint64_t, uint64_t> dbSymbolTable;
     sqlite3_stmt* insertStatement = nullptr;
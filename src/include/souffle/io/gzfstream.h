@@ -9,22 +9,44 @@
 /************************************************************************
  *
  * @file gzfstream.h
- * A simple zlib wrapper to provide gzip file streams.
+ * A simple zlib wrapper to provide gzip (and zstd) file streams.
+ *
+ * Files are written as a sequence of independently compressed blocks, such
+ * that batches of blocks are compressed and decompressed by concurrent
+ * threads:
+ *  - a gzip block is a gzip member whose extra field `SZ` holds the size of
+ *    the member, like the `BC` field of BGZF files, which are read alike;
+ *  - a zstd block is a zstd frame preceded by a skippable frame holding its
+ *    compressed and decompressed sizes.
+ * Both are read by the gzip and zstd tools as usual. Files compressed by
+ * other tools are decompressed by a single thread, and files that are not
+ * compressed are read as they are.
  *
  ***********************************************************************/
 
 #pragma once
 
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <zlib.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 namespace souffle {
 
 namespace gzfstream {
 
+/** Compression format of written files */
+enum class Format { GZip, Zstd };
+
 namespace internal {
 
 class gzfstreambuf : public std::streambuf {
@@ -36,9 +58,7 @@ public:
 
     gzfstreambuf(const gzfstreambuf&) = delete;
 
-    gzfstreambuf(gzfstreambuf&& old) = default;
-
-    gzfstreambuf* open(const std::string& filename, std::ios_base::openmode mode) {
+    gzfstreambuf* open(const std::string& filename, std::ios_base::openmode mode, Format format) {
         if (is_open()) {
             return nullptr;
         }
@@ -47,10 +67,16 @@ public:
         }
 
         this->mode = mode;
-        std::string gzmode((mode & std::ios::in) != 0 ? "rb" : "wb");
-        fileHandle = gzopen(filename.c_str(), gzmode.c_str());
-
-        if (fileHandle == nullptr) {
+        this->format = format;
+        if ((mode & std::ios::out) != 0) {
+            file = std::fopen(filename.c_str(), "wb");
+            if (file == nullptr) {
+                return nullptr;
+            }
+            kind = Kind::Blocks;
+            blocks.resize(batchSize());
+            startBlock();
+        } else if (openInput(filename) == nullptr) {
             return nullptr;
         }
         isOpen = true;
@@ -59,14 +85,33 @@ public:
     }
 
     gzfstreambuf* close() {
-        if (is_open()) {
-            sync();
-            isOpen = false;
-            if (gzclose(fileHandle) == Z_OK) {
-                return this;
-            }
+        if (!is_open()) {
+            return nullptr;
+        }
+        bool ok = true;
+        if ((mode & std::ios::out) != 0) {
+            // end with an empty block, like BGZF files
+            ok = sync() == 0;
+            blocks[0].data.clear();
+            ok = writeBlocks(1) && ok;
+        }
+        if (file != nullptr) {
+            ok = std::fclose(file) == 0 && ok;
+            file = nullptr;
+        }
+        if (fileHandle != nullptr) {
+            ok = gzclose(fileHandle) == Z_OK && ok;
+            fileHandle = nullptr;
         }
-        return nullptr;
+#ifdef USE_ZSTD
+        if (zstdStream != nullptr) {
+            ZSTD_freeDStream(zstdStream);
+            zstdStream = nullptr;
+        }
+#endif
+        blocks.clear();
+        isOpen = false;
+        return ok ? this : nullptr;
     }
 
     bool is_open() const {
@@ -87,17 +132,21 @@ protected:
             return EOF;
         }
 
+        // the put area is the current block, which is complete
+        blocks[current].data.resize(pptr() - pbase());
+        if (++current == blocks.size()) {
+            if (!writeBlocks(current)) {
+                return EOF;
+            }
+            current = 0;
+        }
+        startBlock();
+
         if (c != EOF) {
             *pptr() = c;
             pbump(1);
         }
-        int toWrite = pptr() - pbase();
-        if (gzwrite(fileHandle, pbase(), toWrite) != toWrite) {
-            return EOF;
-        }
-        pbump(-toWrite);
-
-        return c;
+        return traits_type::not_eof(c);
     }
 
     int_type underflow() override {
@@ -108,6 +157,14 @@ protected:
             return traits_type::to_int_type(*gptr());
         }
 
+        switch (kind) {
+            case Kind::Blocks: return underflowBlocks();
+#ifdef USE_ZSTD
+            case Kind::ZstdStream: return underflowZstd();
+#endif
+            default: break;
+        }
+
         unsigned charsPutBack = gptr() - eback();
         if (charsPutBack > reserveSize) {
             charsPutBack = reserveSize;
@@ -125,24 +182,358 @@ protected:
     }
 
     int sync() override {
-        if ((pptr() != nullptr) && pptr() > pbase()) {
-            int toWrite = pptr() - pbase();
-            if (gzwrite(fileHandle, pbase(), toWrite) != toWrite) {
-                return -1;
+        if ((mode & std::ios::out) == 0 || !isOpen) {
+            return 0;
+        }
+        // compress the complete blocks and the filled part of the current one
+        blocks[current].data.resize(pptr() - pbase());
+        const std::size_t filled = current + (blocks[current].data.empty() ? 0 : 1);
+        current = 0;
+        const bool ok = filled == 0 || writeBlocks(filled);
+        startBlock();
+        return ok ? 0 : -1;
+    }
+
+private:
+    /** How the file is read or written */
+    enum class Kind { GZipStream, ZstdStream, Blocks };
+
+    /** A block of the file, compressed and decompressed by one thread */
+    struct Block {
+        std::string compressed;
+        std::string data;
+        bool failed = false;
+    };
+
+    /**
+     * Open a file for reading, detecting its format from its first bytes.
+     */
+    gzfstreambuf* openInput(const std::string& filename) {
+        file = std::fopen(filename.c_str(), "rb");
+        if (file == nullptr) {
+            return nullptr;
+        }
+        unsigned char header[64] = {};
+        const std::size_t size = std::fread(header, 1, sizeof(header), file);
+        if (std::fseek(file, 0, SEEK_SET) == 0) {
+            if (size >= 12 && isGZipBlock(header) && 12 + readLE(header + 10, 2) <= size &&
+                    gzipBlockSize(header) != 0) {
+                kind = Kind::Blocks;
+                format = Format::GZip;
+                blocks.resize(batchSize());
+                return this;
+            }
+#ifdef USE_ZSTD
+            if (size >= 8 && isZstdBlock(header)) {
+                kind = Kind::Blocks;
+                format = Format::Zstd;
+                blocks.resize(batchSize());
+                return this;
+            }
+            if (size >= 4 && readLE(header, 4) == ZSTD_MAGICNUMBER) {
+                kind = Kind::ZstdStream;
+                zstdStream = ZSTD_createDStream();
+                ZSTD_initDStream(zstdStream);
+                return this;
+            }
+#endif
+        }
+        // plain gzip files and uncompressed files
+        std::fclose(file);
+        file = nullptr;
+        kind = Kind::GZipStream;
+        fileHandle = gzopen(filename.c_str(), "rb");
+        return fileHandle == nullptr ? nullptr : this;
+    }
+
+    /** Number of blocks compressed or decompressed concurrently */
+    static std::size_t batchSize() {
+        return static_cast<std::size_t>(std::max(MAX_THREADS, 1));
+    }
+
+    /** Continue writing with the block at the current position */
+    void startBlock() {
+        auto& data = blocks[current].data;
+        data.resize(blockSize);
+        setp(&data[0], &data[0] + blockSize);
+    }
+
+    /** Compress the first blocks concurrently and write them in order */
+    bool writeBlocks(std::size_t count) {
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < count; ++i) {
+            if (format == Format::GZip) {
+                compressGZip(blocks[i]);
+            } else {
+                compressZstd(blocks[i]);
+            }
+        }
+        PARALLEL_END
+
+        bool ok = true;
+        for (std::size_t i = 0; i < count; ++i) {
+            auto& block = blocks[i];
+            ok = ok && !block.failed &&
+                 std::fwrite(block.compressed.data(), 1, block.compressed.size(), file) ==
+                         block.compressed.size();
+            block.data.clear();
+            block.failed = false;
+        }
+        return ok;
+    }
+
+    /** Read and decompress the next batch of blocks */
+    int_type underflowBlocks() {
+        while (true) {
+            if (current + 1 < count) {
+                ++current;
+            } else {
+                count = 0;
+                current = 0;
+                while (count < blocks.size() && readBlock(blocks[count])) {
+                    ++count;
+                }
+                if (count == 0) {
+                    return EOF;
+                }
+                PARALLEL_START
+                pfor(std::size_t i = 0; i < count; ++i) {
+                    if (format == Format::GZip) {
+                        decompressGZip(blocks[i]);
+                    } else {
+                        decompressZstd(blocks[i]);
+                    }
+                }
+                PARALLEL_END
+            }
+            auto& block = blocks[current];
+            if (block.failed) {
+                // corrupt input ends the stream, as for gzread
+                count = 0;
+                return EOF;
+            }
+            if (!block.data.empty()) {
+                char* data = &block.data[0];
+                setg(data, data, data + block.data.size());
+                return traits_type::to_int_type(*gptr());
             }
-            pbump(-toWrite);
+        }
+    }
+
+    /** Read the compressed bytes of the next block of the file */
+    bool readBlock(Block& block) {
+        auto& bytes = block.compressed;
+        block.failed = false;
+        std::size_t headerSize = (format == Format::GZip) ? 12 : 16;
+        bytes.resize(headerSize);
+        if (std::fread(&bytes[0], 1, headerSize, file) != headerSize) {
+            return false;
+        }
+        std::size_t size = 0;
+        if (format == Format::GZip) {
+            auto* header = reinterpret_cast<const unsigned char*>(bytes.data());
+            if (!isGZipBlock(header)) {
+                return false;
+            }
+            const std::size_t extraSize = readLE(header + 10, 2);
+            bytes.resize(headerSize + extraSize);
+            if (std::fread(&bytes[headerSize], 1, extraSize, file) != extraSize) {
+                return false;
+            }
+            size = gzipBlockSize(reinterpret_cast<const unsigned char*>(bytes.data()));
+            if (size < bytes.size() + 8) {
+                return false;
+            }
+        } else {
+            auto* header = reinterpret_cast<const unsigned char*>(bytes.data());
+            if (!isZstdBlock(header)) {
+                return false;
+            }
+            size = headerSize + readLE(header + 8, 4);
+        }
+        const std::size_t offset = bytes.size();
+        bytes.resize(size);
+        return std::fread(&bytes[offset], 1, size - offset, file) == size - offset;
+    }
+
+    /** Compress a block into a gzip member whose extra field holds the size of the member */
+    static void compressGZip(Block& block) {
+        const unsigned char header[] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 8, 0, 'S', 'Z', 4, 0};
+        constexpr std::size_t headerSize = sizeof(header) + 4;
+
+        z_stream stream{};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) !=
+                Z_OK) {
+            block.failed = true;
+            return;
+        }
+        auto& bytes = block.compressed;
+        bytes.resize(headerSize + deflateBound(&stream, static_cast<uLong>(block.data.size())) + 8);
+        std::memcpy(&bytes[0], header, sizeof(header));
+
+        stream.next_in = reinterpret_cast<Bytef*>(block.data.data());
+        stream.avail_in = static_cast<uInt>(block.data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&bytes[headerSize]);
+        stream.avail_out = static_cast<uInt>(bytes.size() - headerSize);
+        block.failed = deflate(&stream, Z_FINISH) != Z_STREAM_END;
+        const std::size_t size = headerSize + stream.total_out + 8;
+        deflateEnd(&stream);
+
+        const uLong checksum = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(block.data.data()),
+                static_cast<uInt>(block.data.size()));
+        writeLE(&bytes[sizeof(header)], size, 4);
+        writeLE(&bytes[size - 8], checksum, 4);
+        writeLE(&bytes[size - 4], block.data.size(), 4);
+        bytes.resize(size);
+    }
+
+    /** Decompress a gzip member read by readBlock */
+    static void decompressGZip(Block& block) {
+        auto* bytes = reinterpret_cast<const unsigned char*>(block.compressed.data());
+        const std::size_t size = block.compressed.size();
+        const std::size_t headerSize = 12 + readLE(bytes + 10, 2);
+        block.data.resize(readLE(bytes + size - 4, 4));
+
+        z_stream stream{};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            block.failed = true;
+            return;
+        }
+        stream.next_in = const_cast<Bytef*>(bytes + headerSize);
+        stream.avail_in = static_cast<uInt>(size - headerSize - 8);
+        stream.next_out = reinterpret_cast<Bytef*>(block.data.data());
+        stream.avail_out = static_cast<uInt>(block.data.size());
+        block.failed = inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.total_out != block.data.size();
+        inflateEnd(&stream);
+
+        const uLong checksum = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(block.data.data()),
+                static_cast<uInt>(block.data.size()));
+        block.failed = block.failed || checksum != readLE(bytes + size - 8, 4);
+    }
+
+#ifdef USE_ZSTD
+    /** Compress a block into a zstd frame preceded by a skippable frame holding its sizes */
+    static void compressZstd(Block& block) {
+        auto& bytes = block.compressed;
+        bytes.resize(16 + ZSTD_compressBound(block.data.size()));
+        const std::size_t size = ZSTD_compress(
+                &bytes[16], bytes.size() - 16, block.data.data(), block.data.size(), ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(size)) {
+            block.failed = true;
+            return;
+        }
+        writeLE(&bytes[0], zstdBlockMagic, 4);
+        writeLE(&bytes[4], 8, 4);
+        writeLE(&bytes[8], size, 4);
+        writeLE(&bytes[12], block.data.size(), 4);
+        bytes.resize(16 + size);
+    }
+
+    /** Decompress a zstd frame read by readBlock */
+    static void decompressZstd(Block& block) {
+        auto* bytes = reinterpret_cast<const unsigned char*>(block.compressed.data());
+        block.data.resize(readLE(bytes + 12, 4));
+        const std::size_t size = ZSTD_decompress(
+                block.data.data(), block.data.size(), bytes + 16, block.compressed.size() - 16);
+        block.failed = ZSTD_isError(size) || size != block.data.size();
+    }
+
+    /** Decompress zstd files of other writers by a single thread */
+    int_type underflowZstd() {
+        ZSTD_outBuffer output{buffer, bufferSize, 0};
+        while (output.pos == 0) {
+            if (zstdInput.pos == zstdInput.size) {
+                zstdInputBuffer.resize(ZSTD_DStreamInSize());
+                const std::size_t size =
+                        std::fread(zstdInputBuffer.data(), 1, zstdInputBuffer.size(), file);
+                if (size == 0) {
+                    return EOF;
+                }
+                zstdInput = {zstdInputBuffer.data(), size, 0};
+            }
+            if (ZSTD_isError(ZSTD_decompressStream(zstdStream, &output, &zstdInput))) {
+                return EOF;
+            }
+        }
+        setg(buffer, buffer, buffer + output.pos);
+        return traits_type::to_int_type(*gptr());
+    }
+#else
+    static void compressZstd(Block& block) {
+        block.failed = true;
+    }
+
+    static void decompressZstd(Block& block) {
+        block.failed = true;
+    }
+#endif
+
+    /** Check for the header of a gzip member holding its size */
+    static bool isGZipBlock(const unsigned char* header) {
+        return header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && header[3] == 4;
+    }
+
+    /** Return the size of a gzip member given its header, or 0 if it is not recorded */
+    static std::size_t gzipBlockSize(const unsigned char* header) {
+        const std::size_t extraSize = readLE(header + 10, 2);
+        for (std::size_t pos = 12; pos + 4 <= 12 + extraSize;) {
+            const std::size_t fieldSize = readLE(header + pos + 2, 2);
+            if (header[pos] == 'S' && header[pos + 1] == 'Z' && fieldSize == 4) {
+                return readLE(header + pos + 4, 4);
+            }
+            if (header[pos] == 'B' && header[pos + 1] == 'C' && fieldSize == 2) {
+                return readLE(header + pos + 4, 2) + 1;
+            }
+            pos += 4 + fieldSize;
         }
         return 0;
     }
 
-private:
+    static bool isZstdBlock(const unsigned char* header) {
+        return readLE(header, 4) == zstdBlockMagic && readLE(header + 4, 4) == 8;
+    }
+
+    static std::size_t readLE(const unsigned char* bytes, std::size_t size) {
+        std::size_t value = 0;
+        for (std::size_t i = size; i > 0; --i) {
+            value = (value << 8) | bytes[i - 1];
+        }
+        return value;
+    }
+
+    static void writeLE(char* bytes, std::size_t value, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
     static constexpr unsigned int bufferSize = 65536;
     static constexpr unsigned int reserveSize = 16;
 
+    /** Number of uncompressed bytes of a written block */
+    static constexpr std::size_t blockSize = 1 << 20;
+
+    /** Magic number of the skippable frames preceding zstd blocks */
+    static constexpr std::size_t zstdBlockMagic = 0x184D2A5A;
+
     char buffer[bufferSize] = {};
     gzFile fileHandle = {};
+    std::FILE* file = nullptr;
     bool isOpen = false;
     std::ios_base::openmode mode = std::ios_base::in;
+    Format format = Format::GZip;
+    Kind kind = Kind::GZipStream;
+
+    /** Blocks of the current batch, with the position of the current one and the number read */
+    std::vector<Block> blocks;
+    std::size_t current = 0;
+    std::size_t count = 0;
+
+#ifdef USE_ZSTD
+    ZSTD_DStream* zstdStream = nullptr;
+    std::vector<char> zstdInputBuffer;
+    ZSTD_inBuffer zstdInput{nullptr, 0, 0};
+#endif
 };
 
 class gzfstream : virtual public std::ios {
@@ -151,9 +542,9 @@ public:
         init(&buf);
     }
 
-    gzfstream(const std::string& filename, std::ios_base::openmode mode) {
+    gzfstream(const std::string& filename, std::ios_base::openmode mode, Format format = Format::GZip) {
         init(&buf);
-        open(filename, mode);
+        open(filename, mode, format);
     }
 
     gzfstream(const gzfstream&) = delete;
@@ -162,8 +553,8 @@ public:
 
     ~gzfstream() override = default;
 
-    void open(const std::string& filename, std::ios_base::openmode mode) {
-        if (buf.open(filename, mode) == nullptr) {
+    void open(const std::string& filename, std::ios_base::openmode mode, Format format = Format::GZip) {
+        if (buf.open(filename, mode, format) == nullptr) {
             clear(rdstate() | std::ios::badbit);
         }
     }
@@ -214,8 +605,9 @@ class ogzfstream : public internal::gzfstream, public std::ostream {
 public:
     ogzfstream() : std::ostream(&buf) {}
 
-    explicit ogzfstream(const std::string& filename, std::ios_base::openmode mode = std::ios::out)
-            : internal::gzfstream(filename, mode), std::ostream(&buf) {}
+    explicit ogzfstream(const std::string& filename, std::ios_base::openmode mode = std::ios::out,
+            Format format = Format::GZip)
+            : internal::gzfstream(filename, mode, format), std::ostream(&buf) {}
 
     ogzfstream(const ogzfstream&) = delete;
 
@@ -225,8 +617,9 @@ public:
         return internal::gzfstream::rdbuf();
     }
 
-    void open(const std::string& filename, std::ios_base::openmode mode = std::ios::out) {
-        internal::gzfstream::open(filename, mode);
+    void open(const std::string& filename, std::ios_base::openmode mode = std::ios::out,
+            Format format = Format::GZip) {
+        internal::gzfstream::open(filename, mode, format);
     }
 };
 
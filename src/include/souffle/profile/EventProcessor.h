@@ -28,6 +28,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace souffle {
@@ -390,7 +391,6 @@ public:
         microseconds end = va_arg(args, microseconds);
         std::size_t startMaxRSS = va_arg(args, std::size_t);
         std::size_t endMaxRSS = va_arg(args, std::size_t);
-        va_arg(args, std::size_t);
         std::string iteration = std::to_string(va_arg(args, std::size_t));
         db.addSizeEntry(
                 {"program", "relation", relation, "iteration", iteration, "maxRSS", "pre"}, startMaxRSS);
@@ -423,6 +423,255 @@ public:
     }
 } relationIOTimingProcessor;
 
+/**
+ * Hardware Counter Profile Event Processor
+ */
+const class HardwareCounterProcessor : public EventProcessor {
+public:
+    HardwareCounterProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@hw-nonrecursive-rule", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@hw-recursive-rule", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@hw-nonrecursive-relation", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@hw-recursive-relation", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& kind = signature[0];
+        const std::string& relation = signature[1];
+        const std::string counter = va_arg(args, const char*);
+        std::uint64_t count = va_arg(args, std::uint64_t);
+        std::string iteration = std::to_string(va_arg(args, std::size_t));
+        // the counters are stored next to the runtime of the timing event
+        std::vector<std::string> path;
+        if (kind == "@hw-nonrecursive-rule") {
+            path = {"program", "relation", relation, "non-recursive-rule", signature[3]};
+        } else if (kind == "@hw-recursive-rule") {
+            path = {"program", "relation", relation, "iteration", iteration, "recursive-rule", signature[4],
+                    signature[2]};
+        } else if (kind == "@hw-nonrecursive-relation") {
+            path = {"program", "relation", relation};
+        } else {
+            path = {"program", "relation", relation, "iteration", iteration};
+        }
+        path.push_back("counters");
+        path.push_back(counter);
+        db.addSizeEntry(path, count);
+    }
+} hardwareCounterProcessor;
+
+/**
+ * Thread Utilisation Profile Event Processor
+ */
+const class ThreadUtilisationProcessor : public EventProcessor {
+public:
+    ThreadUtilisationProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@thread-nonrecursive-rule", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@thread-recursive-rule", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& kind = signature[0];
+        const std::string& relation = signature[1];
+        std::string thread = std::to_string(va_arg(args, std::size_t));
+        microseconds busy = va_arg(args, microseconds);
+        std::size_t chunks = va_arg(args, std::size_t);
+        using Timeline = std::vector<std::pair<microseconds, microseconds>>;
+        const auto* timeline = va_arg(args, const Timeline*);
+        std::string iteration = std::to_string(va_arg(args, std::size_t));
+        // the threads are stored next to the runtime of the timing event
+        std::vector<std::string> path;
+        if (kind == "@thread-nonrecursive-rule") {
+            path = {"program", "relation", relation, "non-recursive-rule", signature[3]};
+        } else {
+            path = {"program", "relation", relation, "iteration", iteration, "recursive-rule", signature[4],
+                    signature[2]};
+        }
+        path.push_back("threads");
+        path.push_back(thread);
+        path.push_back("busy");
+        db.addSizeEntry(path, busy.count());
+        path.back() = "chunks";
+        db.addSizeEntry(path, chunks);
+        path.back() = "timeline";
+        path.emplace_back();
+        for (std::size_t i = 0; i < timeline->size(); ++i) {
+            path.back() = std::to_string(i);
+            db.addDurationEntry(path, (*timeline)[i].first, (*timeline)[i].second);
+        }
+    }
+} threadUtilisationProcessor;
+
+/**
+ * Operator Profile Event Processor
+ */
+const class OperatorProfileProcessor : public EventProcessor {
+public:
+    OperatorProfileProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@operator-nonrecursive-rule", this);
+        EventProcessorSingleton::instance().registerEventProcessor("@operator-recursive-rule", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& kind = signature[0];
+        const std::string& relation = signature[1];
+        std::size_t depth = va_arg(args, std::size_t);
+        std::string text = va_arg(args, char*);
+        std::size_t calls = va_arg(args, std::size_t);
+        std::chrono::nanoseconds time = va_arg(args, std::chrono::nanoseconds);
+        std::string iteration = std::to_string(va_arg(args, std::size_t));
+        // the operators are stored next to the runtime of the timing event, by their position
+        std::vector<std::string> path;
+        if (kind == "@operator-nonrecursive-rule") {
+            path = {"program", "relation", relation, "non-recursive-rule", signature[3], "operators",
+                    signature[4]};
+        } else {
+            path = {"program", "relation", relation, "iteration", iteration, "recursive-rule", signature[4],
+                    signature[2], "operators", signature[5]};
+        }
+        path.push_back("depth");
+        db.addSizeEntry(path, depth);
+        path.back() = "text";
+        db.addTextEntry(path, text);
+        path.back() = "calls";
+        db.addSizeEntry(path, calls);
+        path.back() = "nanoseconds";
+        db.addSizeEntry(path, time.count());
+    }
+} operatorProfileProcessor;
+
+/**
+ * Index Memory Profile Event Processor
+ */
+const class IndexMemoryProcessor : public EventProcessor {
+public:
+    IndexMemoryProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@memory-index", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& index = signature[2];
+        std::size_t bytes = va_arg(args, std::size_t);
+        std::size_t nodes = va_arg(args, std::size_t);
+        std::size_t fill = va_arg(args, std::size_t);
+        db.addSizeEntry({"program", "relation", relation, "memory", index, "bytes"}, bytes);
+        db.addSizeEntry({"program", "relation", relation, "memory", index, "nodes"}, nodes);
+        db.addSizeEntry({"program", "relation", relation, "memory", index, "fill"}, fill);
+    }
+} indexMemoryProcessor;
+
+/**
+ * Index Access Profile Event Processor
+ */
+const class IndexAccessProcessor : public EventProcessor {
+public:
+    IndexAccessProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@index-access", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& index = signature[2];
+        std::size_t probes = va_arg(args, std::size_t);
+        std::size_t scans = va_arg(args, std::size_t);
+        std::size_t tuples = va_arg(args, std::size_t);
+        std::size_t inserts = va_arg(args, std::size_t);
+        db.addSizeEntry({"program", "relation", relation, "index-access", index, "probes"}, probes);
+        db.addSizeEntry({"program", "relation", relation, "index-access", index, "scans"}, scans);
+        db.addSizeEntry({"program", "relation", relation, "index-access", index, "tuples"}, tuples);
+        db.addSizeEntry({"program", "relation", relation, "index-access", index, "inserts"}, inserts);
+    }
+} indexAccessProcessor;
+
+/**
+ * Column Profile Event Processor
+ */
+const class ColumnProcessor : public EventProcessor {
+public:
+    ColumnProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@column", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& relation = signature[1];
+        const std::string& column = signature[2];
+        std::size_t distinct = va_arg(args, std::size_t);
+        std::size_t range = va_arg(args, std::size_t);
+        db.addSizeEntry({"program", "relation", relation, "column", column, "distinct"}, distinct);
+        db.addSizeEntry({"program", "relation", relation, "column", column, "range"}, range);
+    }
+} columnProcessor;
+
+/**
+ * Table Memory Profile Event Processor
+ */
+const class TableMemoryProcessor : public EventProcessor {
+public:
+    TableMemoryProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@memory-table", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& table = signature[1];
+        std::size_t bytes = va_arg(args, std::size_t);
+        std::size_t size = va_arg(args, std::size_t);
+        db.addSizeEntry({"program", "memory", table, "bytes"}, bytes);
+        db.addSizeEntry({"program", "memory", table, "size"}, size);
+    }
+} tableMemoryProcessor;
+
+/**
+ * Lock Contention Event Processor
+ */
+const class LockProcessor : public EventProcessor {
+public:
+    LockProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@lock", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        const std::string& site = signature[1];
+        const std::string& kind = signature[2];
+        std::size_t acquisitions = va_arg(args, std::size_t);
+        std::size_t failures = va_arg(args, std::size_t);
+        std::size_t spins = va_arg(args, std::size_t);
+        std::size_t wait = va_arg(args, std::size_t);
+        db.addSizeEntry({"program", "lock", site, kind, "acquisitions"}, acquisitions);
+        db.addSizeEntry({"program", "lock", site, kind, "failures"}, failures);
+        db.addSizeEntry({"program", "lock", site, kind, "spins"}, spins);
+        db.addSizeEntry({"program", "lock", site, kind, "wait"}, wait);
+    }
+} lockProcessor;
+
+/**
+ * Condition Frequency Processor
+ *
+ * A filter of an instrumented conjunction counts the tuples passing its condition, which are the
+ * tuples the next condition is evaluated on. Its signature names both conditions, either of which
+ * is empty at the ends of the conjunction.
+ */
+const class ConditionFrequencyProcessor : public EventProcessor {
+public:
+    ConditionFrequencyProcessor() {
+        EventProcessorSingleton::instance().registerEventProcessor("@frequency-condition", this);
+    }
+    /** process event input */
+    void process(ProfileDatabase& db, const std::vector<std::string>& signature, va_list& args) override {
+        std::size_t number = va_arg(args, std::size_t);
+        // the counters of each iteration are accumulated
+        auto add = [&](const std::string& condition, const std::string& key) {
+            if (condition.empty()) {
+                return;
+            }
+            std::vector<std::string> path{"program", "condition", condition, key};
+            const auto* entry = as<SizeEntry>(db.lookupEntry(path));
+            db.addSizeEntry(path, number + (entry == nullptr ? 0 : entry->getSize()));
+        };
+        add(signature.size() > 1 ? signature[1] : "", "passed");
+        add(signature.size() > 2 ? signature[2] : "", "evaluated");
+    }
+} conditionFrequencyProcessor;
+
 /**
  * Program Run Event Processor
  */
@@ -11,6 +11,7 @@
 #include "souffle/profile/Rule.h"
 #include <chrono>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -30,6 +31,7 @@ private:
     std::size_t numTuples = 0;
     std::chrono::microseconds copytime{};
     std::string locator = "";
+    std::map<std::string, std::size_t> counters;
 
     std::unordered_map<std::string, std::shared_ptr<Rule>> rules;
 
@@ -96,6 +98,15 @@ public:
         return locator;
     }
 
+    void addCounter(const std::string& counter, std::size_t count) {
+        counters[counter] += count;
+    }
+
+    /** Return the hardware counters of the iteration, indexed by name */
+    const std::map<std::string, std::size_t>& getCounters() const {
+        return counters;
+    }
+
     void setLocator(std::string locator) {
         this->locator = locator;
     }
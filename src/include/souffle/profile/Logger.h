@@ -17,12 +17,20 @@
 
 #pragma once
 
+#include "souffle/profile/PerfCounters.h"
 #include "souffle/profile/ProfileEvent.h"
 #include "souffle/utility/MiscUtil.h"
+#include <chrono>
 #include <cstddef>
 #include <functional>
+#include <map>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace souffle {
 
@@ -52,9 +60,15 @@ public:
 #endif  // WIN32
         // Assume that if we are logging the progress of an event then we care about usage during that time.
         ProfileEventSingleton::instance().resetTimerInterval();
+        if (PerfCounters* counters = ProfileEventSingleton::instance().getCounters()) {
+            startCounters = counters->read();
+        }
+        enclosing = currentLogger();
+        currentLogger() = this;
     }
 
     ~Logger() {
+        currentLogger() = enclosing;
 #ifdef WIN32
         HANDLE hProcess = GetCurrentProcess();
         PROCESS_MEMORY_COUNTERS processMemoryCounters;
@@ -67,14 +81,92 @@ public:
 #endif  // WIN32
         ProfileEventSingleton::instance().makeTimingEvent(
                 label, start, now(), startMaxRSS, endMaxRSS, size() - preSize, iteration);
+        if (PerfCounters* counters = ProfileEventSingleton::instance().getCounters()) {
+            ProfileEventSingleton::instance().makeCounterEvent(
+                    label, startCounters, counters->read(), iteration);
+        }
+        for (const auto& [thread, usage] : threads) {
+            ProfileEventSingleton::instance().makeThreadEvent(
+                    label, thread, usage.busy, usage.chunks, usage.timeline, iteration);
+        }
     }
 
+    /** Return the logger of the innermost timed part the current thread evaluates, or nullptr */
+    static Logger* current() {
+        return currentLogger();
+    }
+
+    /** Record that a thread evaluated a chunk, i.e., a partition, of a parallel loop of the timed part */
+    void addChunk(std::size_t thread, time_point chunkStart, time_point chunkEnd) {
+        const auto start = std::chrono::duration_cast<microseconds>(chunkStart.time_since_epoch());
+        const auto end = std::chrono::duration_cast<microseconds>(chunkEnd.time_since_epoch());
+        std::lock_guard<std::mutex> guard(threadsLock);
+        auto& usage = threads[thread];
+        usage.busy += end - start;
+        ++usage.chunks;
+        // chunks a thread evaluates back to back are one interval of its timeline
+        if (!usage.timeline.empty() && start - usage.timeline.back().second <= MERGE_GAP) {
+            usage.timeline.back().second = end;
+        } else {
+            usage.timeline.emplace_back(start, end);
+        }
+    }
+
+    /**
+     * Times a chunk of a parallel loop for the logger of the timed part containing the loop, which
+     * is obtained by current() before the threads of the loop start.
+     */
+    class ChunkTimer {
+    public:
+        ChunkTimer(Logger* logger) : logger(logger) {
+            if (logger != nullptr) {
+                start = now();
+            }
+        }
+
+        ~ChunkTimer() {
+            if (logger != nullptr) {
+#ifdef _OPENMP
+                logger->addChunk(static_cast<std::size_t>(omp_get_thread_num()), start, now());
+#else
+                logger->addChunk(0, start, now());
+#endif
+            }
+        }
+
+    private:
+        Logger* logger;
+        time_point start;
+    };
+
 private:
+    /** gaps between the chunks of a thread up to which they are merged in its timeline */
+    static constexpr microseconds MERGE_GAP{100};
+
+    /** Time a thread spent in the chunks of parallel loops, and the intervals it did */
+    struct ThreadUsage {
+        microseconds busy{};
+        std::size_t chunks = 0;
+        std::vector<std::pair<microseconds, microseconds>> timeline;
+    };
+
+    static Logger*& currentLogger() {
+        thread_local Logger* logger = nullptr;
+        return logger;
+    }
+
     std::string label;
     time_point start;
     std::size_t startMaxRSS;
     std::size_t iteration;
     std::function<std::size_t()> size;
     std::size_t preSize;
+    PerfCounters::Values startCounters{};
+
+    /** logger of the timed part containing this one on the same thread */
+    Logger* enclosing = nullptr;
+
+    std::mutex threadsLock;
+    std::map<std::size_t, ThreadUsage> threads;
 };
 }  // end of namespace souffle
@@ -11,12 +11,16 @@
 #include "souffle/profile/Cell.h"
 #include "souffle/profile/CellInterface.h"
 #include "souffle/profile/Iteration.h"
+#include "souffle/profile/PerfCounters.h"
 #include "souffle/profile/ProgramRun.h"
 #include "souffle/profile/Relation.h"
 #include "souffle/profile/Row.h"
 #include "souffle/profile/Rule.h"
 #include "souffle/profile/Table.h"
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <map>
 #include <memory>
 #include <ratio>
 #include <set>
@@ -55,6 +59,19 @@ public:
     Table getVersions(std::string strRel, std::string strRul) const;
 
     Table getVersionAtoms(std::string strRel, std::string strRul, int version) const;
+
+    Table getCounterTable() const;
+
+    Table getIndexMemoryTable() const;
+
+    Table getIndexAccessTable() const;
+
+    Table getThreadTable() const;
+
+    std::vector<std::pair<std::string, std::shared_ptr<Rule>>> getThreadExecutions(
+            const std::string& id) const;
+
+    std::vector<std::pair<std::size_t, std::shared_ptr<Rule>>> getPlanExecutions(const std::string& id) const;
 };
 
 /*
@@ -377,5 +394,248 @@ Table inline OutputProcessor::getVersionAtoms(std::string strRel, std::string sr
     return table;
 }
 
+/*
+ * counter table :
+ * ROW[0] = ID
+ * ROW[1] = NAME
+ * ROW[2] = INSTRUCTIONS
+ * ROW[3] = LLC MISSES
+ * ROW[4] = DTLB MISSES
+ * ROW[5] = BRANCH MISSES
+ * ROW[6] = LLC MISSES PER 1000 INSTRUCTIONS
+ *
+ * Relations and rules without hardware counters are left out.
+ */
+Table inline OutputProcessor::getCounterTable() const {
+    const std::unordered_map<std::string, std::shared_ptr<Relation>>& relationMap =
+            programRun->getRelationMap();
+
+    // counters of the recursive rules are summed over their iterations and versions
+    std::map<std::pair<std::string, std::string>, std::map<std::string, std::size_t>> counters;
+    for (auto& rel : relationMap) {
+        counters[{rel.second->getId(), rel.second->getName()}] = rel.second->getCounters();
+        for (auto& current : rel.second->getRuleMap()) {
+            counters[{current.second->getId(), current.second->getName()}] = current.second->getCounters();
+        }
+        for (auto& iter : rel.second->getIterations()) {
+            for (auto& current : iter->getRules()) {
+                auto& ruleCounters = counters[{current.second->getId(), current.second->getName()}];
+                for (auto& counter : current.second->getCounters()) {
+                    ruleCounters[counter.first] += counter.second;
+                }
+            }
+        }
+    }
+
+    Table table;
+    for (auto& current : counters) {
+        if (current.second.empty()) {
+            continue;
+        }
+        Row row(7);
+        row[0] = std::make_shared<Cell<std::string>>(current.first.first);
+        row[1] = std::make_shared<Cell<std::string>>(current.first.second);
+        for (std::size_t i = 0; i < PerfCounters::SIZE; ++i) {
+            row[2 + i] = std::make_shared<Cell<long>>(current.second[PerfCounters::getNames()[i]]);
+        }
+        const long instructions = row[2]->getLongVal();
+        row[6] = std::make_shared<Cell<double>>(
+                instructions == 0 ? 0.0 : row[3]->getLongVal() * 1000.0 / instructions);
+        table.addRow(std::make_shared<Row>(row));
+    }
+    return table;
+}
+
+/*
+ * index memory table :
+ * ROW[0] = ID
+ * ROW[1] = NAME
+ * ROW[2] = INDEX
+ * ROW[3] = BYTES
+ * ROW[4] = NODES
+ * ROW[5] = FILL FACTOR (%)
+ *
+ * Relations without a recorded memory usage are left out.
+ */
+Table inline OutputProcessor::getIndexMemoryTable() const {
+    Table table;
+    for (auto& rel : programRun->getRelationMap()) {
+        for (auto& index : rel.second->getIndexMemory()) {
+            Row row(6);
+            row[0] = std::make_shared<Cell<std::string>>(rel.second->getId());
+            row[1] = std::make_shared<Cell<std::string>>(rel.second->getName());
+            row[2] = std::make_shared<Cell<std::string>>(index.first);
+            row[3] = std::make_shared<Cell<long>>(index.second.bytes);
+            row[4] = std::make_shared<Cell<long>>(index.second.nodes);
+            row[5] = std::make_shared<Cell<double>>(index.second.fill / 10.0);
+            table.addRow(std::make_shared<Row>(row));
+        }
+    }
+    return table;
+}
+
+/*
+ * index access table :
+ * ROW[0] = ID
+ * ROW[1] = NAME
+ * ROW[2] = INDEX
+ * ROW[3] = PROBES
+ * ROW[4] = SCANS
+ * ROW[5] = TUPLES
+ * ROW[6] = INSERTS
+ * ROW[7] = ACCESSES PER INSERT
+ *
+ * The accesses are the probes and scans of an index, and the inserts its
+ * maintenance, which every index of the relation pays alike.
+ */
+Table inline OutputProcessor::getIndexAccessTable() const {
+    Table table;
+    for (auto& rel : programRun->getRelationMap()) {
+        for (auto& index : rel.second->getIndexAccess()) {
+            const auto& access = index.second;
+            Row row(8);
+            row[0] = std::make_shared<Cell<std::string>>(rel.second->getId());
+            row[1] = std::make_shared<Cell<std::string>>(rel.second->getName());
+            row[2] = std::make_shared<Cell<std::string>>(index.first);
+            row[3] = std::make_shared<Cell<long>>(access.probes);
+            row[4] = std::make_shared<Cell<long>>(access.scans);
+            row[5] = std::make_shared<Cell<long>>(access.tuples);
+            row[6] = std::make_shared<Cell<long>>(access.inserts);
+            const auto accesses = static_cast<double>(access.probes + access.scans);
+            row[7] = std::make_shared<Cell<double>>(accesses / std::max<std::size_t>(access.inserts, 1));
+            table.addRow(std::make_shared<Row>(row));
+        }
+    }
+    return table;
+}
+
+/*
+ * thread table :
+ * ROW[0] = ID
+ * ROW[1] = NAME
+ * ROW[2] = THREADS
+ * ROW[3] = BUSY TIME
+ * ROW[4] = IDLE TIME
+ * ROW[5] = SKEW
+ *
+ * The skew is the time the parallel loops of a rule took, i.e., the busy
+ * time of their busiest thread, relative to the time they took if the
+ * threads were equally busy, summed over the iterations of recursive
+ * rules. Rules without parallel loops are left out.
+ */
+Table inline OutputProcessor::getThreadTable() const {
+    struct Usage {
+        std::string name;
+        std::size_t threads = 0;
+        std::chrono::microseconds busy{};
+        std::chrono::microseconds idle{};
+        double slowest = 0;
+        double balanced = 0;
+    };
+    std::map<std::string, Usage> usages;
+    auto add = [&](const Rule& rule) {
+        if (rule.getThreads().empty()) {
+            return;
+        }
+        auto& usage = usages[rule.getId()];
+        usage.name = rule.getName();
+        usage.threads = std::max(usage.threads, rule.getThreads().size());
+        usage.busy += rule.getBusytime();
+        usage.idle += rule.getIdletime();
+        usage.slowest += rule.getMaxBusytime().count();
+        usage.balanced += static_cast<double>(rule.getBusytime().count()) / rule.getThreads().size();
+    };
+    for (auto& rel : programRun->getRelationMap()) {
+        for (auto& current : rel.second->getRuleMap()) {
+            add(*current.second);
+        }
+        for (auto& iter : rel.second->getIterations()) {
+            for (auto& current : iter->getRules()) {
+                add(*current.second);
+            }
+        }
+    }
+
+    Table table;
+    for (auto& current : usages) {
+        Row row(6);
+        row[0] = std::make_shared<Cell<std::string>>(current.first);
+        row[1] = std::make_shared<Cell<std::string>>(current.second.name);
+        row[2] = std::make_shared<Cell<long>>(current.second.threads);
+        row[3] = std::make_shared<Cell<std::chrono::microseconds>>(current.second.busy);
+        row[4] = std::make_shared<Cell<std::chrono::microseconds>>(current.second.idle);
+        row[5] = std::make_shared<Cell<double>>(
+                current.second.balanced == 0 ? 1.0 : current.second.slowest / current.second.balanced);
+        table.addRow(std::make_shared<Row>(row));
+    }
+    return table;
+}
+
+/*
+ * The evaluations of the rule with the given id that have parallel loops,
+ * labelled by their iteration and version if the rule is recursive, in
+ * the order of the time their threads were idle, longest first.
+ */
+std::vector<std::pair<std::string, std::shared_ptr<Rule>>> inline OutputProcessor::getThreadExecutions(
+        const std::string& id) const {
+    std::vector<std::pair<std::string, std::shared_ptr<Rule>>> executions;
+    for (auto& rel : programRun->getRelationMap()) {
+        for (auto& current : rel.second->getRuleMap()) {
+            if (current.second->getId() == id && !current.second->getThreads().empty()) {
+                executions.emplace_back("", current.second);
+            }
+        }
+        // the iterations are numbered in the order they were evaluated
+        auto iterations = rel.second->getIterations();
+        std::sort(iterations.begin(), iterations.end(),
+                [](const std::shared_ptr<Iteration>& a, const std::shared_ptr<Iteration>& b) {
+                    return a->getStarttime() < b->getStarttime();
+                });
+        for (std::size_t i = 0; i < iterations.size(); ++i) {
+            for (auto& current : iterations[i]->getRules()) {
+                if (current.second->getId() == id && !current.second->getThreads().empty()) {
+                    executions.emplace_back("iteration " + std::to_string(i) + " version " +
+                                                    std::to_string(current.second->getVersion()),
+                            current.second);
+                }
+            }
+        }
+    }
+    std::stable_sort(executions.begin(), executions.end(), [](const auto& a, const auto& b) {
+        return a.second->getIdletime() > b.second->getIdletime();
+    });
+    return executions;
+}
+
+/*
+ * The evaluations of the rule with the given id whose operators were
+ * profiled, with the number of their iteration if the rule is recursive,
+ * in the order they were evaluated.
+ */
+std::vector<std::pair<std::size_t, std::shared_ptr<Rule>>> inline OutputProcessor::getPlanExecutions(
+        const std::string& id) const {
+    std::vector<std::pair<std::size_t, std::shared_ptr<Rule>>> executions;
+    for (auto& rel : programRun->getRelationMap()) {
+        for (auto& current : rel.second->getRuleMap()) {
+            if (current.second->getId() == id && !current.second->getOperators().empty()) {
+                executions.emplace_back(0, current.second);
+            }
+        }
+        auto iterations = rel.second->getIterations();
+        std::sort(iterations.begin(), iterations.end(),
+                [](const std::shared_ptr<Iteration>& a, const std::shared_ptr<Iteration>& b) {
+                    return a->getStarttime() < b->getStarttime();
+                });
+        for (std::size_t i = 0; i < iterations.size(); ++i) {
+            for (auto& current : iterations[i]->getRules()) {
+                if (current.second->getId() == id && !current.second->getOperators().empty()) {
+                    executions.emplace_back(i, current.second);
+                }
+            }
+        }
+    }
+    return executions;
+}
+
 }  // namespace profile
 }  // namespace souffle
@@ -0,0 +1,186 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file PerfCounters.h
+ *
+ * Hardware performance counters read around the timed parts of a
+ * profiled program.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#ifdef __linux__
+#include <cstring>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace souffle {
+
+/**
+ * Counters of hardware events of the threads of the program
+ *
+ * The counters are opened with perf_event_open on Linux, and count the
+ * events in user space of each thread of the process; threads started after
+ * the counters are opened are picked up on the next read. Counters that are
+ * not supported by the processor or the kernel, e.g., in virtual machines,
+ * are not available.
+ */
+class PerfCounters {
+public:
+    /** Number of counters */
+    static constexpr std::size_t SIZE = 4;
+
+    /** Values of the counters */
+    using Values = std::array<std::uint64_t, SIZE>;
+
+    /** Return the names of the counters, as stored in the profile database */
+    static const std::array<const char*, SIZE>& getNames() {
+        static const std::array<const char*, SIZE> names{
+                "instructions", "llc-misses", "dtlb-misses", "branch-misses"};
+        return names;
+    }
+
+    PerfCounters() {
+        refresh();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (const auto& thread : threads) {
+            for (int fd : thread.second) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        }
+#endif
+    }
+
+    /** Return whether the given counter is available */
+    bool isAvailable(std::size_t counter) const {
+        return available[counter];
+    }
+
+    /** Return whether any counter is available */
+    bool isAvailable() const {
+        for (bool counter : available) {
+            if (counter) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Read the counters, summed over the threads of the program */
+    Values read() {
+        std::lock_guard<std::mutex> guard(lock);
+        refresh();
+        Values values{};
+#ifdef __linux__
+        for (const auto& thread : threads) {
+            for (std::size_t i = 0; i < SIZE; ++i) {
+                std::uint64_t value = 0;
+                const int fd = thread.second[i];
+                if (fd >= 0 && ::read(fd, &value, sizeof(value)) == sizeof(value)) {
+                    values[i] += value;
+                }
+            }
+        }
+#endif
+        return values;
+    }
+
+private:
+    /** Open the counters of the threads started since the last refresh */
+    void refresh() {
+#ifdef __linux__
+        DIR* tasks = opendir("/proc/self/task");
+        if (tasks == nullptr) {
+            return;
+        }
+        while (dirent* task = readdir(tasks)) {
+            if (task->d_name[0] == '.') {
+                continue;
+            }
+            const auto tid = static_cast<pid_t>(std::strtol(task->d_name, nullptr, 10));
+            if (threads.find(tid) != threads.end()) {
+                continue;
+            }
+            // counters found missing on the first thread are not tried again
+            const bool first = threads.empty();
+            auto& fds = threads[tid];
+            for (std::size_t i = 0; i < SIZE; ++i) {
+                fds[i] = (first || available[i]) ? open(tid, i) : -1;
+                if (first) {
+                    available[i] = fds[i] >= 0;
+                }
+            }
+        }
+        closedir(tasks);
+#endif
+    }
+
+#ifdef __linux__
+    /** Open a counter of a thread, returning its file descriptor or -1 if it is not supported */
+    static int open(pid_t tid, std::size_t counter) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        const std::uint64_t readMiss =
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (counter) {
+            case 0:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case 1:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | readMiss;
+                break;
+            case 2:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | readMiss;
+                break;
+            default:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+        }
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+    }
+
+    /** file descriptors of the counters of each thread; -1 if a counter is not available */
+    std::map<pid_t, std::array<int, SIZE>> threads;
+#else
+    std::map<int, std::array<int, SIZE>> threads;
+#endif
+
+    /** counters opened for the first thread */
+    std::array<bool, SIZE> available{};
+
+    std::mutex lock;
+};
+
+}  // namespace souffle
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "souffle/io/MappedFile.h"
+#include "souffle/profile/ProfileLog.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
-#include "souffle/utility/json11.h"
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -15,6 +19,7 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -296,6 +301,13 @@ class ProfileDatabase {
 private:
     Own<DirectoryEntry> root;
 
+    /** binary log the entries are appended to, if any */
+    Own<ProfileLog> log;
+
+    /** strings defined by the binary log read so far, and the offset after its last record read */
+    std::vector<std::string> logStrings;
+    std::size_t logOffset = 0;
+
 protected:
     /**
      * Find path: if directories along the path do not exist, create them.
@@ -314,51 +326,308 @@ protected:
         return dir;
     }
 
-    void parseJson(const json11::Json& json, Own<DirectoryEntry>& node) {
-        for (auto& cur : json.object_items()) {
-            if (cur.second.is_object()) {
-                std::string err;
-                // Duration entries are also maps
-                if (cur.second.has_shape(
-                            {{"start", json11::Json::NUMBER}, {"end", json11::Json::NUMBER}}, err)) {
-                    auto start = std::chrono::microseconds(cur.second["start"].long_value());
-                    auto end = std::chrono::microseconds(cur.second["end"].long_value());
-                    node->writeEntry(mk<DurationEntry>(cur.first, start, end));
-                } else if (cur.second.has_shape({{"time", json11::Json::NUMBER}}, err)) {
-                    auto time = std::chrono::microseconds(cur.second["time"].long_value());
-                    node->writeEntry(mk<TimeEntry>(cur.first, time));
+    /**
+     * Parser of the JSON text of a profile, writing the entries of its root directory into the
+     * database as it reads them instead of building a document first.
+     */
+    class JsonParser {
+    public:
+        JsonParser(std::string_view text) : text(text) {}
+
+        void parse(DirectoryEntry& root) {
+            expect('{');
+            if (!consume('}')) {
+                do {
+                    if (parseString() == "root") {
+                        expect(':');
+                        parseObject(root);
+                    } else {
+                        expect(':');
+                        skipValue();
+                    }
+                } while (consume(','));
+                expect('}');
+            }
+        }
+
+    private:
+        std::string_view text;
+        std::size_t pos = 0;
+
+        [[noreturn]] void fail(const std::string& message) const {
+            throw std::runtime_error("Parse error: " + message + " at offset " + std::to_string(pos));
+        }
+
+        void skipSpace() {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\t' ||
+                                                text[pos] == '\r')) {
+                ++pos;
+            }
+        }
+
+        bool consume(char c) {
+            skipSpace();
+            if (pos < text.size() && text[pos] == c) {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c) {
+            if (!consume(c)) {
+                fail(std::string("expected '") + c + "'");
+            }
+        }
+
+        std::string parseString() {
+            expect('"');
+            std::string result;
+            while (pos < text.size() && text[pos] != '"') {
+                const std::size_t end = text.find_first_of("\"\\", pos);
+                if (end == std::string_view::npos) {
+                    break;
+                }
+                result.append(text.substr(pos, end - pos));
+                pos = end;
+                if (text[pos] == '\\' && pos + 1 < text.size()) {
+                    const char escaped = text[pos + 1];
+                    pos += 2;
+                    switch (escaped) {
+                        case 'n': result += '\n'; break;
+                        case 't': result += '\t'; break;
+                        case 'r': result += '\r'; break;
+                        case 'b': result += '\b'; break;
+                        case 'f': result += '\f'; break;
+                        case 'u': appendCodePoint(result); break;
+                        default: result += escaped;
+                    }
+                }
+            }
+            expect('"');
+            return result;
+        }
+
+        /** Append the UTF-8 encoding of the code point of a \\u escape */
+        void appendCodePoint(std::string& result) {
+            if (text.size() - pos < 4) {
+                fail("incomplete escape");
+            }
+            const auto codePoint = std::strtoul(std::string(text.substr(pos, 4)).c_str(), nullptr, 16);
+            pos += 4;
+            if (codePoint < 0x80) {
+                result += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                result += static_cast<char>(0xc0 | (codePoint >> 6));
+                result += static_cast<char>(0x80 | (codePoint & 0x3f));
+            } else {
+                result += static_cast<char>(0xe0 | (codePoint >> 12));
+                result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+                result += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+        }
+
+        /** Parse a number, truncated to an integer, as the database only holds integral values */
+        long parseNumber() {
+            const std::size_t start = pos;
+            static constexpr std::string_view digits = "+-0123456789.eE";
+            while (pos < text.size() && digits.find(text[pos]) != std::string_view::npos) {
+                ++pos;
+            }
+            const std::string number(text.substr(start, pos - start));
+            char* end = nullptr;
+            const double value = std::strtod(number.c_str(), &end);
+            if (number.empty() || end != number.c_str() + number.size()) {
+                fail("invalid number");
+            }
+            return static_cast<long>(value);
+        }
+
+        /** Parse the members of an object into the directory */
+        void parseObject(DirectoryEntry& dir) {
+            expect('{');
+            if (consume('}')) {
+                return;
+            }
+            do {
+                std::string key = parseString();
+                expect(':');
+                parseValue(dir, std::move(key));
+            } while (consume(','));
+            expect('}');
+        }
+
+        void parseValue(DirectoryEntry& dir, std::string key) {
+            skipSpace();
+            const char c = pos < text.size() ? text[pos] : '\0';
+            if (c == '{') {
+                auto sub = mk<DirectoryEntry>(key);
+                parseObject(*sub);
+                // durations and times are objects of numbers too
+                auto* start = as<SizeEntry>(sub->readEntry("start"));
+                auto* end = as<SizeEntry>(sub->readEntry("end"));
+                auto* time = as<SizeEntry>(sub->readEntry("time"));
+                if (start != nullptr && end != nullptr) {
+                    dir.writeEntry(mk<DurationEntry>(key, toTime(start->getSize()), toTime(end->getSize())));
+                } else if (time != nullptr) {
+                    dir.writeEntry(mk<TimeEntry>(key, toTime(time->getSize())));
                 } else {
-                    auto dir = mk<DirectoryEntry>(cur.first);
-                    parseJson(cur.second, dir);
-                    node->writeEntry(std::move(dir));
+                    dir.writeEntry(std::move(sub));
                 }
-            } else if (cur.second.is_string()) {
-                node->writeEntry(mk<TextEntry>(cur.first, cur.second.string_value()));
-            } else if (cur.second.is_number()) {
-                node->writeEntry(mk<SizeEntry>(cur.first, cur.second.long_value()));
+            } else if (c == '"') {
+                dir.writeEntry(mk<TextEntry>(key, parseString()));
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                dir.writeEntry(mk<SizeEntry>(key, static_cast<std::size_t>(parseNumber())));
             } else {
-                std::string err;
-                cur.second.dump(err);
-                std::cerr << "Unknown types in profile log: " << cur.first << ": " << err << std::endl;
+                const std::size_t start = pos;
+                skipValue();
+                std::cerr << "Unknown types in profile log: " << key << ": "
+                          << text.substr(start, pos - start) << std::endl;
             }
         }
+
+        static microseconds toTime(std::size_t value) {
+            return microseconds(static_cast<long>(value));
+        }
+
+        /** Skip a value of any type */
+        void skipValue() {
+            skipSpace();
+            const char c = pos < text.size() ? text[pos] : '\0';
+            if (c == '"') {
+                parseString();
+            } else if (c == '{' || c == '[') {
+                const char close = c == '{' ? '}' : ']';
+                ++pos;
+                if (consume(close)) {
+                    return;
+                }
+                do {
+                    if (c == '{') {
+                        parseString();
+                        expect(':');
+                    }
+                    skipValue();
+                } while (consume(','));
+                expect(close);
+            } else {
+                const std::size_t start = pos;
+                static constexpr std::string_view ends = ",:]} \n\t\r";
+                while (pos < text.size() && ends.find(text[pos]) == std::string_view::npos) {
+                    ++pos;
+                }
+                if (pos == start) {
+                    fail("expected a value");
+                }
+            }
+        }
+    };
+
+    /** Replay the records of a binary log not read yet */
+    void readLog(std::string_view contents) {
+        // consecutive records mostly share their directory, e.g., the entries of a rule in an iteration
+        std::vector<std::string> dirPath;
+        DirectoryEntry* dir = nullptr;
+        auto write = [&](const std::vector<std::string>& path, Own<Entry> entry) {
+            if (path.empty()) {
+                throw std::runtime_error("Corrupt profile log: empty path");
+            }
+            if (dir == nullptr || dirPath.size() + 1 != path.size() ||
+                    !std::equal(dirPath.begin(), dirPath.end(), path.begin())) {
+                dirPath.assign(path.begin(), path.end() - 1);
+                dir = lookupPath(dirPath);
+            }
+            dir->writeEntry(std::move(entry));
+        };
+        logOffset = ProfileLog::read(
+                contents, std::max(logOffset, ProfileLog::MAGIC.size()), logStrings,
+                [&](const auto& path, std::size_t size) {
+                    write(path, mk<SizeEntry>(path.back(), size));
+                },
+                [&](const auto& path, const std::string& text) {
+                    write(path, mk<TextEntry>(path.back(), text));
+                },
+                [&](const auto& path, std::int64_t start, std::int64_t end) {
+                    write(path, mk<DurationEntry>(path.back(), microseconds(start), microseconds(end)));
+                },
+                [&](const auto& path, std::int64_t time) {
+                    write(path, mk<TimeEntry>(path.back(), microseconds(time)));
+                });
+    }
+
+    /** Write the entries of the directory, at the given path, to the log */
+    void logEntries(const DirectoryEntry& dir, std::vector<std::string>& path) {
+        for (const auto& key : dir.getKeys()) {
+            Entry* entry = dir.readEntry(key);
+            path.push_back(key);
+            if (auto* sub = as<DirectoryEntry>(entry)) {
+                logEntries(*sub, path);
+            } else if (auto* size = as<SizeEntry>(entry)) {
+                log->writeSize(path, size->getSize());
+            } else if (auto* text = as<TextEntry>(entry)) {
+                log->writeText(path, text->getText());
+            } else if (auto* duration = as<DurationEntry>(entry)) {
+                log->writeDuration(path, duration->getStart().count(), duration->getEnd().count());
+            } else if (auto* time = as<TimeEntry>(entry)) {
+                log->writeTime(path, time->getTime().count());
+            }
+            path.pop_back();
+        }
     }
 
 public:
     ProfileDatabase() : root(mk<DirectoryEntry>("root")) {}
 
+    /** Read a profile, written as a JSON file or as a binary log */
     ProfileDatabase(const std::string& filename) : root(mk<DirectoryEntry>("root")) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            throw std::runtime_error("Log file could not be opened.");
+        MappedFile mapped(filename);
+        std::string contents;
+        std::string_view text = mapped.view();
+        if (!mapped.isMapped()) {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open()) {
+                throw std::runtime_error("Log file could not be opened.");
+            }
+            contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            text = contents;
         }
-        std::string jsonString((std::istreambuf_iterator<char>(file)), (std::istreambuf_iterator<char>()));
-        std::string error;
-        json11::Json json = json11::Json::parse(jsonString, error);
-        if (!error.empty()) {
-            throw std::runtime_error("Parse error: " + error);
+        if (ProfileLog::isLog(text)) {
+            readLog(text);
+        } else {
+            JsonParser(text).parse(*root);
+        }
+    }
+
+    /**
+     * Read the records appended to the binary log of the profile since it was read, e.g., by a
+     * running program. Return whether there were any.
+     */
+    bool update(const std::string& filename) {
+        MappedFile mapped(filename);
+        if (!mapped.isMapped() || !ProfileLog::isLog(mapped.view())) {
+            return false;
+        }
+        const std::size_t offset = logOffset;
+        readLog(mapped.view());
+        return logOffset != offset;
+    }
+
+    /** Append the entries of the database, and all entries added later, to a binary log */
+    void startLog(const std::string& filename) {
+        log = mk<ProfileLog>(filename);
+        std::vector<std::string> path;
+        logEntries(*root, path);
+    }
+
+    bool isLogging() const {
+        return log != nullptr;
+    }
+
+    /** Write the records of the log buffered so far to its file */
+    void flushLog() {
+        if (log != nullptr) {
+            log->flush();
         }
-        parseJson(json["root"], root);
     }
 
     // add size entry
@@ -370,6 +639,9 @@ public:
         const std::string& key = qualifier.back();
         Own<SizeEntry> entry = mk<SizeEntry>(key, size);
         dir->writeEntry(std::move(entry));
+        if (log != nullptr) {
+            log->writeSize(qualifier, size);
+        }
     }
 
     // add text entry
@@ -381,6 +653,9 @@ public:
         const std::string& key = qualifier.back();
         Own<TextEntry> entry = mk<TextEntry>(key, text);
         dir->writeEntry(std::move(entry));
+        if (log != nullptr) {
+            log->writeText(qualifier, text);
+        }
     }
 
     // add duration entry
@@ -392,6 +667,9 @@ public:
         const std::string& key = qualifier.back();
         Own<DurationEntry> entry = mk<DurationEntry>(key, start, end);
         dir->writeEntry(std::move(entry));
+        if (log != nullptr) {
+            log->writeDuration(qualifier, start.count(), end.count());
+        }
     }
 
     // add time entry
@@ -403,6 +681,9 @@ public:
         const std::string& key = qualifier.back();
         Own<TimeEntry> entry = mk<TimeEntry>(key, time);
         dir->writeEntry(std::move(entry));
+        if (log != nullptr) {
+            log->writeTime(qualifier, time.count());
+        }
     }
 
     // compute sum
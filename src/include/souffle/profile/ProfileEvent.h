@@ -16,19 +16,36 @@
 
 #pragma once
 
+#include "souffle/datastructure/NodePool.h"
 #include "souffle/profile/EventProcessor.h"
+#include "souffle/profile/PerfCounters.h"
 #include "souffle/profile/ProfileDatabase.h"
+#include "souffle/profile/ProfileLog.h"
+#include "souffle/utility/AllocatorUtil.h"
+#include "souffle/utility/LockProfile.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include "souffle/utility/Types.h"
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <ctime>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #ifdef WIN32
 #include <Psapi.h>
 #else
@@ -76,13 +93,261 @@ public:
             std::size_t endMaxRSS, std::size_t size, std::size_t iteration) {
         microseconds start_ms = std::chrono::duration_cast<microseconds>(start.time_since_epoch());
         microseconds end_ms = std::chrono::duration_cast<microseconds>(end.time_since_epoch());
-        profile::EventProcessorSingleton::instance().process(
-                database, txt.c_str(), start_ms, end_ms, startMaxRSS, endMaxRSS, size, iteration);
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(
+                    db, txt.c_str(), start_ms, end_ms, startMaxRSS, endMaxRSS, size, iteration);
+        });
+        if (streaming) {
+            const auto runtime = (end_ms - start_ms).count();
+            std::stringstream ss;
+            ss << R"_("event": "timing", )_" << getStreamLabel(txt) << R"_(, "iteration": )_" << iteration
+               << R"_(, "runtime": )_" << runtime << R"_(, "tuples": )_" << size
+               << R"_(, "tuples-per-second": )_" << (runtime == 0 ? 0.0 : size * 1000000.0 / runtime)
+               << R"_(, "maxRSS": )_" << endMaxRSS;
+            stream(ss.str());
+        }
     }
 
     /** create quantity event */
     void makeQuantityEvent(const std::string& txt, std::size_t number, int iteration) {
-        profile::EventProcessorSingleton::instance().process(database, txt.c_str(), number, iteration);
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(db, txt.c_str(), number, iteration);
+        });
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "quantity", )_" << getStreamLabel(txt) << R"_(, "iteration": )_" << iteration
+               << R"_(, "number": )_" << number;
+            stream(ss.str());
+        }
+    }
+
+    /**
+     * Create an event for the memory usage of an index of a relation, given
+     * by the number of bytes, the number of nodes of its tree and the
+     * average fill factor of its b-tree nodes
+     */
+    void makeIndexMemoryEvent(const std::string& relation, const std::string& index, std::size_t bytes,
+            std::size_t nodes, double fillFactor) {
+        const std::string txt = "@memory-index;" + relation + ";" + index;
+        // the fill factor is stored in thousandths, as the database only holds integral sizes
+        const auto fill = static_cast<std::size_t>(fillFactor * 1000);
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(db, txt.c_str(), bytes, nodes, fill);
+        });
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "memory", "relation": ")_" << escapeJSONstring(relation)
+               << R"_(", "index": ")_" << escapeJSONstring(index) << R"_(", "bytes": )_" << bytes
+               << R"_(, "nodes": )_" << nodes << R"_(, "fill": )_" << fillFactor;
+            stream(ss.str());
+        }
+    }
+
+    /**
+     * Create an event for the accesses of an index of a relation: the
+     * number of existence checks, range scans and tuples returned by the
+     * scans, and the number of tuples inserted into the relation, which are
+     * inserted into each of its indexes
+     */
+    void makeIndexAccessEvent(const std::string& relation, const std::string& index, std::size_t probes,
+            std::size_t scans, std::size_t tuples, std::size_t inserts) {
+        const std::string txt = "@index-access;" + relation + ";" + index;
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(
+                    db, txt.c_str(), probes, scans, tuples, inserts);
+        });
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "index-access", "relation": ")_" << escapeJSONstring(relation)
+               << R"_(", "index": ")_" << escapeJSONstring(index) << R"_(", "probes": )_" << probes
+               << R"_(, "scans": )_" << scans << R"_(, "tuples": )_" << tuples << R"_(, "inserts": )_"
+               << inserts;
+            stream(ss.str());
+        }
+    }
+
+    /**
+     * Create an event for the values of a column of a relation: the
+     * estimated number of distinct values, and the number of values between
+     * the smallest and the largest value of the column
+     */
+    void makeColumnEvent(
+            const std::string& relation, std::size_t column, std::size_t distinct, std::size_t range) {
+        const std::string txt = "@column;" + relation + ";" + std::to_string(column);
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(db, txt.c_str(), distinct, range);
+        });
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "column", "relation": ")_" << escapeJSONstring(relation)
+               << R"_(", "column": )_" << column << R"_(, "distinct": )_" << distinct << R"_(, "range": )_"
+               << range;
+            stream(ss.str());
+        }
+    }
+
+    /** Create an event for the memory usage of a table of the program, e.g., the symbol table */
+    void makeTableMemoryEvent(const std::string& table, std::size_t bytes, std::size_t size) {
+        const std::string txt = "@memory-table;" + table;
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(db, txt.c_str(), bytes, size);
+        });
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "memory", "table": ")_" << escapeJSONstring(table) << R"_(", "bytes": )_"
+               << bytes << R"_(, "size": )_" << size;
+            stream(ss.str());
+        }
+    }
+
+    /**
+     * Create the events of the memory held by the allocators: the slabs of the node pools, which
+     * are counted as their size, and the heap, whose resident bytes are counted as its size
+     */
+    void makeAllocatorEvents() {
+        const auto pools = NodePools::getStatistics();
+        makeTableMemoryEvent(pools.hugePages ? "node-pools (huge pages)" : "node-pools", pools.reserved,
+                pools.slabs);
+        const auto heap = getHeapStatistics();
+        if (heap.allocated != 0 || heap.resident != 0) {
+            makeTableMemoryEvent("heap (" + heap.allocator + ")", heap.allocated, heap.resident);
+        }
+    }
+
+    /**
+     * Create an event for the contention of a kind of locks at a site, given
+     * by the number of acquisitions, failed validations and attempts, spins
+     * and the nanoseconds waited
+     */
+    void makeLockEvent(const std::string& site, const std::string& kind, std::size_t acquisitions,
+            std::size_t failures, std::size_t spins, std::size_t wait) {
+        const std::string txt = "@lock;" + site + ";" + kind;
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(
+                    db, txt.c_str(), acquisitions, failures, spins, wait);
+        });
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "lock", "site": ")_" << escapeJSONstring(site) << R"_(", "kind": ")_" << kind
+               << R"_(", "acquisitions": )_" << acquisitions << R"_(, "failures": )_" << failures
+               << R"_(, "spins": )_" << spins << R"_(, "wait": )_" << wait;
+            stream(ss.str());
+        }
+    }
+
+    /** Create the events of the contention of the locks, recorded by builds defining USE_LOCK_PROFILING */
+    void makeLockEvents() {
+        LockProfile::forEachSite([&](const LockSite& site) {
+            for (std::size_t i = 0; i < NUM_LOCK_KINDS; ++i) {
+                const auto kind = static_cast<LockKind>(i);
+                const auto totals = site.getTotals(kind);
+                if (totals.acquisitions != 0 || totals.failures != 0) {
+                    makeLockEvent(site.getName(), getLockKindName(kind), totals.acquisitions,
+                            totals.failures, totals.spins, static_cast<std::size_t>(totals.wait.count()));
+                }
+            }
+        });
+    }
+
+    /** create an event for entering a stratum; only streamed */
+    void makeStratumEvent(const std::string& stratum) {
+        if (streaming) {
+            stream(R"_("event": "stratum", "stratum": ")_" + escapeJSONstring(stratum) + '"');
+        }
+    }
+
+    /**
+     * Create the hardware counter events of a timing event, i.e., the
+     * events counted between the start and the end of the timed part
+     */
+    void makeCounterEvent(const std::string& txt, const PerfCounters::Values& start,
+            const PerfCounters::Values& end, std::size_t iteration) {
+        // only the counters of relations and rules are recorded
+        static const std::array<std::string, 4> kinds{
+                "nonrecursive-rule", "recursive-rule", "nonrecursive-relation", "recursive-relation"};
+        const std::string kind = txt.substr(0, txt.find(';'));
+        if (kind.rfind("@t-", 0) != 0 ||
+                std::find(kinds.begin(), kinds.end(), kind.substr(3)) == kinds.end()) {
+            return;
+        }
+        const std::string label = "@hw-" + txt.substr(3);
+        for (std::size_t i = 0; i < PerfCounters::SIZE; ++i) {
+            if (counters->isAvailable(i)) {
+                // counters of threads that ended may be gone
+                const std::uint64_t count = end[i] > start[i] ? end[i] - start[i] : 0;
+                const char* name = PerfCounters::getNames()[i];
+                record([=](profile::ProfileDatabase& db) {
+                    profile::EventProcessorSingleton::instance().process(
+                            db, label.c_str(), name, count, iteration);
+                });
+            }
+        }
+    }
+
+    /**
+     * Create the event of a thread of the parallel loops of a timed rule, given by the time the
+     * thread was busy in their chunks, the number of chunks, and the intervals it was busy in
+     */
+    void makeThreadEvent(const std::string& txt, std::size_t thread, microseconds busy, std::size_t chunks,
+            const std::vector<std::pair<microseconds, microseconds>>& timeline, std::size_t iteration) {
+        const std::string kind = txt.substr(0, txt.find(';'));
+        if (kind != "@t-nonrecursive-rule" && kind != "@t-recursive-rule") {
+            return;
+        }
+        const std::string label = "@thread-" + txt.substr(3);
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(
+                    db, label.c_str(), thread, busy, chunks, &timeline, iteration);
+        });
+    }
+
+    /**
+     * Create the event of an operator of the plan of a timed rule, given by its position in the
+     * plan, the number of operators it is nested in, its text, the number of tuples entering it, and
+     * its time including the time of the operators nested in it
+     */
+    void makeOperatorEvent(const std::string& txt, std::size_t position, std::size_t depth,
+            const std::string& text, std::size_t calls, std::chrono::nanoseconds time,
+            std::size_t iteration) {
+        const std::string kind = txt.substr(0, txt.find(';'));
+        if (kind != "@t-nonrecursive-rule" && kind != "@t-recursive-rule") {
+            return;
+        }
+        const std::string label = "@operator-" + txt.substr(3) + ";" + std::to_string(position);
+        record([=](profile::ProfileDatabase& db) {
+            profile::EventProcessorSingleton::instance().process(
+                    db, label.c_str(), depth, text.c_str(), calls, time, iteration);
+        });
+    }
+
+    /** Count hardware events in the timed parts of the program, if the counters are available */
+    void enableCounters() {
+        if (counters == nullptr) {
+            counters = mk<PerfCounters>();
+            if (!counters->isAvailable()) {
+                std::cerr << "Warning: hardware performance counters are not available" << std::endl;
+            }
+        }
+    }
+
+    /** Return the hardware counters, or nullptr if none is available */
+    PerfCounters* getCounters() {
+        return counters != nullptr && counters->isAvailable() ? counters.get() : nullptr;
+    }
+
+    /** Record the buffered timing and quantity events in the database, e.g., at the end of a stratum */
+    void flush() {
+        for (auto& buffer : buffers) {
+            std::vector<std::function<void(profile::ProfileDatabase&)>> events;
+            {
+                std::lock_guard<std::mutex> guard(buffer.lock);
+                events.swap(buffer.events);
+            }
+            for (const auto& event : events) {
+                event(database);
+            }
+        }
+        database.flushLog();
     }
 
     /** create utilisation event */
@@ -123,14 +388,46 @@ public:
 
         profile::EventProcessorSingleton::instance().process(
                 database, txt.c_str(), time, systemTime, userTime, maxRSS);
+        if (streaming) {
+            std::stringstream ss;
+            ss << R"_("event": "utilisation", "system": )_" << systemTime << R"_(, "user": )_" << userTime
+               << R"_(, "maxRSS": )_" << maxRSS;
+            stream(ss.str());
+        }
     }
 
+    /**
+     * Set the file the profile is written to. A file named `*.bin` is a binary log, which is
+     * appended to while the program runs, instead of a JSON file written at its end.
+     */
     void setOutputFile(std::string outputFilename) {
         filename = outputFilename;
+        if (profile::ProfileLog::isLogName(filename)) {
+            try {
+                database.startLog(filename);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+    }
+
+    /**
+     * Append the timing, quantity, utilisation and stratum events to a file
+     * while the program runs, as one JSON object per line, e.g., for
+     * monitoring a run without a terminal.
+     */
+    void setStreamFile(const std::string& streamFilename) {
+        std::lock_guard<std::mutex> guard(streamLock);
+        streamFile.open(streamFilename, std::ios::app);
+        if (!streamFile.is_open()) {
+            std::cerr << "Cannot open profile stream file <" + streamFilename + ">" << std::endl;
+        }
+        streaming = streamFile.is_open();
     }
     /** Dump all events */
     void dump() {
-        if (!filename.empty()) {
+        flush();
+        if (!filename.empty() && !database.isLogging()) {
             std::ofstream os(filename);
             if (!os.is_open()) {
                 std::cerr << "Cannot open profile log file <" + filename + ">";
@@ -161,7 +458,67 @@ public:
         database = profile::ProfileDatabase(databaseFilename);
     }
 
+    /** Read the events appended to a binary profile log since it was read; return whether there were any */
+    bool updateDBFromFile(const std::string& databaseFilename) {
+        return database.update(databaseFilename);
+    }
+
 private:
+    /** Number of buffers of the events of the threads */
+    static constexpr std::size_t NUM_BUFFERS = 64;
+
+    /**
+     * Events of a thread not yet recorded in the database
+     *
+     * The events of the threads of parallel loops are buffered so that they
+     * do not serialise on the locks of the database. Threads may share a
+     * buffer, which is hence locked, but mostly by a single thread.
+     */
+    struct alignas(64) EventBuffer {
+        std::mutex lock;
+        std::vector<std::function<void(profile::ProfileDatabase&)>> events;
+    };
+
+    std::array<EventBuffer, NUM_BUFFERS> buffers;
+
+    /** file the events are streamed to, if streaming */
+    std::ofstream streamFile;
+    std::mutex streamLock;
+    std::atomic<bool> streaming{false};
+
+    /** Append an event, given by the members of its JSON object, to the stream */
+    void stream(const std::string& members) {
+        const auto time = std::chrono::duration_cast<microseconds>(now().time_since_epoch()).count();
+        std::lock_guard<std::mutex> guard(streamLock);
+        streamFile << R"_({"time": )_" << time << ", " << members << "}" << std::endl;
+    }
+
+    /** Return the JSON members with the kind, relation and full label of an event */
+    static std::string getStreamLabel(const std::string& txt) {
+        const std::size_t kindEnd = txt.find(';');
+        const std::string kind = txt.substr(0, kindEnd);
+        std::string relation;
+        if (kindEnd != std::string::npos) {
+            relation = txt.substr(kindEnd + 1, txt.find(';', kindEnd + 1) - kindEnd - 1);
+        }
+        return R"_("kind": ")_" + escapeJSONstring(kind) + R"_(", "relation": ")_" +
+               escapeJSONstring(relation) + R"_(", "label": ")_" + escapeJSONstring(txt) + '"';
+    }
+
+    /** hardware counters; only set if they are enabled */
+    Own<PerfCounters> counters;
+
+    /** Buffer an event of the current thread */
+    void record(std::function<void(profile::ProfileDatabase&)> event) {
+#ifdef _OPENMP
+        EventBuffer& buffer = buffers[static_cast<std::size_t>(omp_get_thread_num()) % NUM_BUFFERS];
+#else
+        EventBuffer& buffer = buffers[0];
+#endif
+        std::lock_guard<std::mutex> guard(buffer.lock);
+        buffer.events.push_back(std::move(event));
+    }
+
     /**  Profile Timer */
     class ProfileTimer {
     private:
@@ -0,0 +1,239 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProfileLog.h
+ *
+ * A compact binary log of the entries of a profile database, which is
+ * appended to while the program runs, and replayed by readers without
+ * parsing a JSON document.
+ *
+ * The log starts with a magic line, followed by records of a kind byte
+ * and numbers in unsigned LEB128:
+ *
+ *   string    <length> <bytes>        defines the next string number
+ *   size      <path> <size>
+ *   text      <path> <string>
+ *   duration  <path> <start> <end>
+ *   time      <path> <time>
+ *
+ * where a path is the number of its keys followed by their string
+ * numbers, and times are zigzag-encoded microseconds. Keys and texts,
+ * e.g., relations, rules and iteration numbers, repeat across many
+ * entries, so each is written once. A log cut short, e.g., of a running
+ * or crashed program, is read up to its last complete record.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace souffle {
+namespace profile {
+
+class ProfileLog {
+public:
+    enum Kind : char { String = 0, Size = 1, Text = 2, Duration = 3, Time = 4 };
+
+    static constexpr std::string_view MAGIC = "SOUFFLE-PROFILE-LOG 1\n";
+
+    /** Whether a profile file name selects the binary log instead of a JSON file */
+    static bool isLogName(const std::string& filename) {
+        return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0;
+    }
+
+    /** Whether the contents of a profile file are a binary log */
+    static bool isLog(std::string_view contents) {
+        return contents.substr(0, MAGIC.size()) == MAGIC;
+    }
+
+    explicit ProfileLog(const std::string& filename) : file(filename, std::ios::binary | std::ios::trunc) {
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open profile log file <" + filename + ">");
+        }
+        file << MAGIC;
+    }
+
+    void writeSize(const std::vector<std::string>& path, std::size_t size) {
+        std::lock_guard<std::mutex> guard(lock);
+        writeRecord(Size, path);
+        writeNumber(size);
+    }
+
+    void writeText(const std::vector<std::string>& path, const std::string& text) {
+        std::lock_guard<std::mutex> guard(lock);
+        const std::uint64_t id = intern(text);
+        writeRecord(Text, path);
+        writeNumber(id);
+    }
+
+    void writeDuration(const std::vector<std::string>& path, std::int64_t start, std::int64_t end) {
+        std::lock_guard<std::mutex> guard(lock);
+        writeRecord(Duration, path);
+        writeNumber(zigzag(start));
+        writeNumber(zigzag(end));
+    }
+
+    void writeTime(const std::vector<std::string>& path, std::int64_t time) {
+        std::lock_guard<std::mutex> guard(lock);
+        writeRecord(Time, path);
+        writeNumber(zigzag(time));
+    }
+
+    /** Write the buffered records to the file, such that readers see them */
+    void flush() {
+        std::lock_guard<std::mutex> guard(lock);
+        file.flush();
+    }
+
+    /**
+     * Replay the records of a log, starting at the given offset past its magic line, by calling
+     * the handler of their kind: size(path, size), text(path, text), duration(path, start, end)
+     * and time(path, time). The strings defined before the offset are passed in and extended.
+     *
+     * @return the offset after the last complete record
+     */
+    template <typename OnSize, typename OnText, typename OnDuration, typename OnTime>
+    static std::size_t read(std::string_view log, std::size_t offset, std::vector<std::string>& strings,
+            const OnSize& size, const OnText& text, const OnDuration& duration, const OnTime& time) {
+        std::vector<std::string> path;
+        while (offset < log.size()) {
+            std::size_t pos = offset;
+            const auto kind = static_cast<Kind>(log[pos++]);
+            std::uint64_t value = 0;
+            if (kind == String) {
+                if (!readNumber(log, pos, value) || log.size() - pos < value) {
+                    break;
+                }
+                strings.emplace_back(log.substr(pos, value));
+                offset = pos + value;
+                continue;
+            }
+            if (!readPath(log, pos, strings, path)) {
+                break;
+            }
+            std::uint64_t second = 0;
+            if (kind == Size) {
+                if (!readNumber(log, pos, value)) break;
+                size(path, static_cast<std::size_t>(value));
+            } else if (kind == Text) {
+                if (!readNumber(log, pos, value)) break;
+                if (value >= strings.size()) {
+                    throw std::runtime_error("Corrupt profile log: unknown string");
+                }
+                text(path, strings[value]);
+            } else if (kind == Duration) {
+                if (!readNumber(log, pos, value) || !readNumber(log, pos, second)) break;
+                duration(path, unzigzag(value), unzigzag(second));
+            } else if (kind == Time) {
+                if (!readNumber(log, pos, value)) break;
+                time(path, unzigzag(value));
+            } else {
+                throw std::runtime_error("Corrupt profile log: unknown record");
+            }
+            offset = pos;
+        }
+        return offset;
+    }
+
+private:
+    std::ofstream file;
+    std::mutex lock;
+
+    /** number of each string written so far */
+    std::unordered_map<std::string, std::uint64_t> ids;
+
+    std::uint64_t intern(const std::string& string) {
+        auto it = ids.find(string);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        file.put(String);
+        writeNumber(string.size());
+        file.write(string.data(), static_cast<std::streamsize>(string.size()));
+        return ids.emplace(string, ids.size()).first->second;
+    }
+
+    void writeRecord(Kind kind, const std::vector<std::string>& path) {
+        // the strings of the path are defined before the record
+        std::vector<std::uint64_t> keys;
+        keys.reserve(path.size());
+        for (const auto& key : path) {
+            keys.push_back(intern(key));
+        }
+        file.put(kind);
+        writeNumber(keys.size());
+        for (auto key : keys) {
+            writeNumber(key);
+        }
+    }
+
+    void writeNumber(std::uint64_t value) {
+        char bytes[10];
+        std::size_t count = 0;
+        do {
+            bytes[count++] = static_cast<char>((value & 0x7f) | (value > 0x7f ? 0x80 : 0));
+            value >>= 7;
+        } while (value != 0);
+        file.write(bytes, static_cast<std::streamsize>(count));
+    }
+
+    static std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    static std::int64_t unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    /** Read a number at the position, advancing it; return false if the log ends before it does */
+    static bool readNumber(std::string_view log, std::size_t& pos, std::uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; pos < log.size() && shift < 64; shift += 7) {
+            const auto byte = static_cast<unsigned char>(log[pos++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool readPath(std::string_view log, std::size_t& pos, const std::vector<std::string>& strings,
+            std::vector<std::string>& path) {
+        std::uint64_t length = 0;
+        if (!readNumber(log, pos, length) || length > log.size() - pos) {
+            return false;
+        }
+        path.resize(length);
+        for (auto& key : path) {
+            std::uint64_t id = 0;
+            if (!readNumber(log, pos, id)) {
+                return false;
+            }
+            if (id >= strings.size()) {
+                throw std::runtime_error("Corrupt profile log: unknown string");
+            }
+            key = strings[id];
+        }
+        return true;
+    }
+};
+
+}  // namespace profile
+}  // namespace souffle
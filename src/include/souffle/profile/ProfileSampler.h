@@ -0,0 +1,168 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ProfileSampler.h
+ *
+ * A sampler estimating the times of the profiled parts of a program from
+ * the parts running when it takes a sample.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/profile/ProfileEvent.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace souffle {
+
+/**
+ * The sampling counterpart of the Logger.
+ *
+ * Instead of timing each part of the program, the evaluation only announces
+ * the parts it enters and leaves. A background thread periodically samples
+ * the parts currently entered, and the time of a part in an iteration is
+ * estimated as the number of its samples times the sampling interval. The
+ * estimates are reported as the timing events of the Logger, such that the
+ * profile database reads as usual; the numbers of tuples derived by rules
+ * are not counted though.
+ *
+ * Parts may be nested in each other, and are announced by a single thread.
+ */
+class ProfileSampler {
+public:
+    /** A part of the program entered until the scope is left */
+    class Scope {
+    public:
+        Scope(ProfileSampler& sampler, const std::string& label, std::size_t iteration) : sampler(sampler) {
+            sampler.enter(label, iteration);
+        }
+        ~Scope() {
+            sampler.leave();
+        }
+
+    private:
+        ProfileSampler& sampler;
+    };
+
+    /** @param interval the sampling interval in microseconds */
+    ProfileSampler(std::size_t interval) : interval(std::max<std::size_t>(interval, 1)) {}
+
+    ~ProfileSampler() {
+        stop();
+    }
+
+    /** Start sampling on the thread th */
+    void start() {
+        if (running) {
+            return;
+        }
+        running = true;
+        th = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(samplerMutex);
+            while (running) {
+                conditionVariable.wait_for(lock, std::chrono::microseconds(interval));
+                sample();
+            }
+        });
+    }
+
+    /** Stop sampling */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(samplerMutex);
+            running = false;
+        }
+        conditionVariable.notify_all();
+        if (th.joinable()) {
+            th.join();
+        }
+    }
+
+    /** Report the estimated times of the sampled parts as timing events */
+    void dump() const {
+        // parts of the same label are reported together
+        std::map<std::pair<std::string, std::size_t>, std::pair<time_point, std::size_t>> events;
+        for (const auto& [part, samples] : parts) {
+            auto pos = events.emplace(std::make_pair(*part.first, part.second), samples);
+            if (!pos.second) {
+                pos.first->second.first = std::min(pos.first->second.first, samples.first);
+                pos.first->second.second += samples.second;
+            }
+        }
+        const auto length = std::chrono::microseconds(interval);
+        for (const auto& [event, samples] : events) {
+            ProfileEventSingleton::instance().makeTimingEvent(event.first, samples.first,
+                    samples.first + samples.second * length, 0, 0, 0, event.second);
+        }
+    }
+
+private:
+    /** Maximal nesting of the parts that are sampled */
+    static constexpr std::size_t MAX_DEPTH = 32;
+
+    void enter(const std::string& label, std::size_t iteration) {
+        const std::size_t cur = depth.load(std::memory_order_relaxed);
+        if (cur < MAX_DEPTH) {
+            labels[cur].store(&label, std::memory_order_relaxed);
+            iterations[cur].store(iteration, std::memory_order_relaxed);
+        }
+        depth.store(cur + 1, std::memory_order_release);
+    }
+
+    void leave() {
+        depth.store(depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+    }
+
+    /** Count a sample for each part currently entered */
+    void sample() {
+        const std::size_t cur = std::min(depth.load(std::memory_order_acquire), MAX_DEPTH);
+        const time_point time = now();
+        for (std::size_t i = 0; i < cur; ++i) {
+            auto pos = parts.emplace(std::make_pair(labels[i].load(std::memory_order_relaxed),
+                                             iterations[i].load(std::memory_order_relaxed)),
+                                    std::make_pair(time, std::size_t{0}))
+                               .first;
+            ++pos->second.second;
+        }
+    }
+
+    /** sampling interval in microseconds */
+    const std::size_t interval;
+
+    /** parts currently entered */
+    std::array<std::atomic<const std::string*>, MAX_DEPTH> labels{};
+    std::array<std::atomic<std::size_t>, MAX_DEPTH> iterations{};
+    std::atomic<std::size_t> depth{0};
+
+    /** time of the first sample and number of samples of each part and iteration */
+    std::map<std::pair<const std::string*, std::size_t>, std::pair<time_point, std::size_t>> parts;
+
+    /** sampler is running */
+    bool running{false};
+
+    /** thread sampler runs on */
+    std::thread th;
+
+    std::condition_variable conditionVariable;
+    std::mutex samplerMutex;
+};
+
+}  // namespace souffle
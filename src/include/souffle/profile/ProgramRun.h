@@ -13,6 +13,7 @@
 #include "souffle/profile/Table.h"
 #include <chrono>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <set>
 #include <sstream>
@@ -29,10 +30,26 @@ namespace profile {
  * ProgramRun -> Relations -> Iterations/Rules
  */
 class ProgramRun {
+public:
+    /** Contention of a kind of locks at a site */
+    struct LockContention {
+        std::size_t acquisitions = 0;
+        /** optimistic reads invalidated by writers, and failed attempts to take a lock */
+        std::size_t failures = 0;
+        std::size_t spins = 0;
+        std::chrono::nanoseconds wait{};
+    };
+
 private:
     std::unordered_map<std::string, std::shared_ptr<Relation>> relationMap;
     std::chrono::microseconds startTime{0};
     std::chrono::microseconds endTime{0};
+    /** bytes and number of elements of the tables of the program, e.g., the symbol table */
+    std::map<std::string, std::pair<std::size_t, std::size_t>> tableMemory;
+    /** number of tuples each instrumented condition was evaluated on and passed, by condition key */
+    std::map<std::string, std::pair<std::size_t, std::size_t>> conditionFrequencies;
+    /** contention of the locks by site and kind */
+    std::map<std::pair<std::string, std::string>, LockContention> lockContention;
 
 public:
     ProgramRun() : relationMap() {}
@@ -62,6 +79,31 @@ public:
         return relationMap;
     }
 
+    void setTableMemory(const std::string& table, std::size_t bytes, std::size_t size) {
+        tableMemory[table] = {bytes, size};
+    }
+
+    const std::map<std::string, std::pair<std::size_t, std::size_t>>& getTableMemory() const {
+        return tableMemory;
+    }
+
+    void setConditionFrequency(const std::string& condition, std::size_t evaluated, std::size_t passed) {
+        conditionFrequencies[condition] = {evaluated, passed};
+    }
+
+    const std::map<std::string, std::pair<std::size_t, std::size_t>>& getConditionFrequencies() const {
+        return conditionFrequencies;
+    }
+
+    void setLockContention(
+            const std::string& site, const std::string& kind, const LockContention& contention) {
+        lockContention[{site, kind}] = contention;
+    }
+
+    const std::map<std::pair<std::string, std::string>, LockContention>& getLockContention() const {
+        return lockContention;
+    }
+
     std::string getRuntime() const {
         if (startTime == endTime) {
             return "--";
@@ -24,6 +24,7 @@
 #include <memory>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -54,10 +55,79 @@ public:
             base.setNumTuples(size.getSize());
         }
     }
-    void visit(DirectoryEntry& /* ruleEntry */) override {}
+    void visit(DirectoryEntry& directory) override {
+        if (directory.getKey() == "counters") {
+            for (const auto& key : directory.getKeys()) {
+                if (auto* count = as<SizeEntry>(directory.readEntry(key))) {
+                    base.addCounter(key, count->getSize());
+                }
+            }
+        } else if constexpr (std::is_same_v<T, Rule>) {
+            if (directory.getKey() == "threads") {
+                visitThreads(directory);
+            } else if (directory.getKey() == "operators") {
+                visitOperators(directory);
+            }
+        }
+    }
 
 protected:
     T& base;
+
+    /**
+     * Read the threads of the parallel loops of a rule.
+     * threads: {thread: {busy: num, chunks: num, timeline: {n: {start, end}}}}
+     */
+    void visitThreads(DirectoryEntry& threads) {
+        for (const auto& key : threads.getKeys()) {
+            auto* thread = threads.readDirectoryEntry(key);
+            if (thread == nullptr) {
+                continue;
+            }
+            ThreadUsage usage;
+            if (auto* busy = as<SizeEntry>(thread->readEntry("busy"))) {
+                usage.busy = std::chrono::microseconds(busy->getSize());
+            }
+            if (auto* chunks = as<SizeEntry>(thread->readEntry("chunks"))) {
+                usage.chunks = chunks->getSize();
+            }
+            if (auto* timeline = thread->readDirectoryEntry("timeline")) {
+                for (const auto& interval : timeline->getKeys()) {
+                    if (auto* duration = as<DurationEntry>(timeline->readEntry(interval))) {
+                        usage.timeline.emplace_back(duration->getStart(), duration->getEnd());
+                    }
+                }
+            }
+            base.addThread(std::stoul(key), std::move(usage));
+        }
+    }
+
+    /**
+     * Read the operators of the plan of a rule.
+     * operators: {position: {depth: num, text: text, calls: num, nanoseconds: num}}
+     */
+    void visitOperators(DirectoryEntry& operators) {
+        for (const auto& key : operators.getKeys()) {
+            auto* op = operators.readDirectoryEntry(key);
+            if (op == nullptr) {
+                continue;
+            }
+            OperatorUsage usage;
+            if (auto* depth = as<SizeEntry>(op->readEntry("depth"))) {
+                usage.depth = depth->getSize();
+            }
+            if (auto* text = as<TextEntry>(op->readEntry("text"))) {
+                usage.text = text->getText();
+            }
+            if (auto* calls = as<SizeEntry>(op->readEntry("calls"))) {
+                usage.calls = calls->getSize();
+            }
+            if (auto* time = as<SizeEntry>(op->readEntry("nanoseconds"))) {
+                usage.time = std::chrono::nanoseconds(time->getSize());
+            }
+            base.addOperator(std::stoul(key), std::move(usage));
+        }
+    }
 };
 
 /**
@@ -98,6 +168,7 @@ public:
                 directory.readDirectoryEntry(key)->accept(atomFrequenciesVisitor);
             }
         }
+        DSNVisitor::visit(directory);
     }
 };
 
@@ -143,6 +214,7 @@ public:
                 directory.readDirectoryEntry(key)->accept(atomFrequenciesVisitor);
             }
         }
+        DSNVisitor::visit(directory);
     }
 };
 
@@ -193,6 +265,7 @@ public:
             relation.setPreMaxRSS(preMaxRSS->getSize());
             relation.setPostMaxRSS(postMaxRSS->getSize());
         }
+        DSNVisitor::visit(directory);
     }
 
 protected:
@@ -252,7 +325,65 @@ public:
             auto* postMaxRSS = as<SizeEntry>(directory.readEntry("post"));
             base.setPreMaxRSS(preMaxRSS->getSize());
             base.setPostMaxRSS(postMaxRSS->getSize());
+        } else if (directory.getKey() == "memory") {
+            // memory: {index: {bytes, nodes, fill}, ...}
+            for (const auto& key : directory.getKeys()) {
+                auto* index = as<DirectoryEntry>(directory.readEntry(key));
+                if (index == nullptr) {
+                    continue;
+                }
+                Relation::IndexMemory memory;
+                if (auto* bytes = as<SizeEntry>(index->readEntry("bytes"))) {
+                    memory.bytes = bytes->getSize();
+                }
+                if (auto* nodes = as<SizeEntry>(index->readEntry("nodes"))) {
+                    memory.nodes = nodes->getSize();
+                }
+                if (auto* fill = as<SizeEntry>(index->readEntry("fill"))) {
+                    memory.fill = fill->getSize();
+                }
+                base.setIndexMemory(key, memory);
+            }
+        } else if (directory.getKey() == "index-access") {
+            // index-access: {index: {probes, scans, tuples, inserts}, ...}
+            for (const auto& key : directory.getKeys()) {
+                auto* index = as<DirectoryEntry>(directory.readEntry(key));
+                if (index == nullptr) {
+                    continue;
+                }
+                Relation::IndexAccess access;
+                if (auto* probes = as<SizeEntry>(index->readEntry("probes"))) {
+                    access.probes = probes->getSize();
+                }
+                if (auto* scans = as<SizeEntry>(index->readEntry("scans"))) {
+                    access.scans = scans->getSize();
+                }
+                if (auto* tuples = as<SizeEntry>(index->readEntry("tuples"))) {
+                    access.tuples = tuples->getSize();
+                }
+                if (auto* inserts = as<SizeEntry>(index->readEntry("inserts"))) {
+                    access.inserts = inserts->getSize();
+                }
+                base.setIndexAccess(key, access);
+            }
+        } else if (directory.getKey() == "column") {
+            // column: {position: {distinct, range}, ...}
+            for (const auto& key : directory.getKeys()) {
+                auto* column = as<DirectoryEntry>(directory.readEntry(key));
+                if (column == nullptr) {
+                    continue;
+                }
+                Relation::Column values;
+                if (auto* distinct = as<SizeEntry>(column->readEntry("distinct"))) {
+                    values.distinct = distinct->getSize();
+                }
+                if (auto* range = as<SizeEntry>(column->readEntry("range"))) {
+                    values.range = range->getSize();
+                }
+                base.setColumn(std::stoul(key), values);
+            }
         }
+        DSNVisitor::visit(directory);
     }
     void visit(SizeEntry& size) override {
         if (size.getKey() == "reads") {
@@ -291,6 +422,14 @@ public:
     }
 
     Reader(std::shared_ptr<ProgramRun> run) : run(std::move(run)) {}
+
+    /**
+     * Read the events appended to the profile since it was read, if it is the binary log of a
+     * running program. Return whether there were any, such that the file is processed again.
+     */
+    bool update() {
+        return !file_loc.empty() && ProfileEventSingleton::instance().updateDBFromFile(file_loc);
+    }
     /**
      * Read the contents from file into the class
      */
@@ -311,6 +450,50 @@ public:
             online = false;
         }
 
+        if (auto tables = as<DirectoryEntry>(db.lookupEntry({"program", "memory"}))) {
+            for (const auto& table : tables->getKeys()) {
+                auto bytes = as<SizeEntry>(db.lookupEntry({"program", "memory", table, "bytes"}));
+                auto size = as<SizeEntry>(db.lookupEntry({"program", "memory", table, "size"}));
+                if (bytes != nullptr && size != nullptr) {
+                    run->setTableMemory(table, bytes->getSize(), size->getSize());
+                }
+            }
+        }
+
+        if (auto conditions = as<DirectoryEntry>(db.lookupEntry({"program", "condition"}))) {
+            for (const auto& condition : conditions->getKeys()) {
+                auto* entry = conditions->readDirectoryEntry(condition);
+                auto evaluated = as<SizeEntry>(entry->readEntry("evaluated"));
+                auto passed = as<SizeEntry>(entry->readEntry("passed"));
+                if (evaluated != nullptr && passed != nullptr) {
+                    run->setConditionFrequency(condition, evaluated->getSize(), passed->getSize());
+                }
+            }
+        }
+
+        if (auto sites = as<DirectoryEntry>(db.lookupEntry({"program", "lock"}))) {
+            for (const auto& site : sites->getKeys()) {
+                auto* kinds = sites->readDirectoryEntry(site);
+                for (const auto& kind : kinds->getKeys()) {
+                    auto* entry = kinds->readDirectoryEntry(kind);
+                    ProgramRun::LockContention contention;
+                    if (auto* acquisitions = as<SizeEntry>(entry->readEntry("acquisitions"))) {
+                        contention.acquisitions = acquisitions->getSize();
+                    }
+                    if (auto* failures = as<SizeEntry>(entry->readEntry("failures"))) {
+                        contention.failures = failures->getSize();
+                    }
+                    if (auto* spins = as<SizeEntry>(entry->readEntry("spins"))) {
+                        contention.spins = spins->getSize();
+                    }
+                    if (auto* wait = as<SizeEntry>(entry->readEntry("wait"))) {
+                        contention.wait = std::chrono::nanoseconds(wait->getSize());
+                    }
+                    run->setLockContention(site, kind, contention);
+                }
+            }
+        }
+
         auto relations = as<DirectoryEntry>(db.lookupEntry({"program", "relation"}));
         if (relations == nullptr) {
             // Souffle hasn't generated any profiling information yet
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -27,6 +28,31 @@ namespace profile {
  * Stores the iterations and rules of a given relation
  */
 class Relation {
+public:
+    /** Memory usage of an index of the relation */
+    struct IndexMemory {
+        std::size_t bytes = 0;
+        std::size_t nodes = 0;
+        /** average fill factor of the b-tree nodes in thousandths */
+        std::size_t fill = 0;
+    };
+
+    /** Accesses of an index of the relation, and the tuples inserted into it */
+    struct IndexAccess {
+        std::size_t probes = 0;
+        std::size_t scans = 0;
+        std::size_t tuples = 0;
+        std::size_t inserts = 0;
+    };
+
+    /** Values of a column of the relation */
+    struct Column {
+        /** estimated number of distinct values */
+        std::size_t distinct = 0;
+        /** number of values between the smallest and the largest value */
+        std::size_t range = 0;
+    };
+
 private:
     const std::string name;
     std::chrono::microseconds starttime{};
@@ -41,6 +67,10 @@ private:
     int ruleId = 0;
     int recursiveId = 0;
     std::size_t tuplesRead = 0;
+    std::map<std::string, std::size_t> counters;
+    std::map<std::string, IndexMemory> indexMemory;
+    std::map<std::string, IndexAccess> indexAccess;
+    std::map<std::size_t, Column> columns;
 
     std::vector<std::shared_ptr<Iteration>> iterations;
 
@@ -248,6 +278,57 @@ public:
     void addReads(std::size_t tuplesRead) {
         this->tuplesRead += tuplesRead;
     }
+
+    void addCounter(const std::string& counter, std::size_t count) {
+        counters[counter] += count;
+    }
+
+    /** Return the hardware counters of the relation including its iterations, indexed by name */
+    std::map<std::string, std::size_t> getCounters() const {
+        std::map<std::string, std::size_t> result = counters;
+        for (auto& iter : iterations) {
+            for (auto& counter : iter->getCounters()) {
+                result[counter.first] += counter.second;
+            }
+        }
+        return result;
+    }
+
+    void setIndexMemory(const std::string& index, const IndexMemory& memory) {
+        indexMemory[index] = memory;
+    }
+
+    /** Return the memory usage of the indexes of the relation, indexed by their order */
+    const std::map<std::string, IndexMemory>& getIndexMemory() const {
+        return indexMemory;
+    }
+
+    void setIndexAccess(const std::string& index, const IndexAccess& access) {
+        indexAccess[index] = access;
+    }
+
+    /** Return the accesses of the indexes of the relation, indexed by their order */
+    const std::map<std::string, IndexAccess>& getIndexAccess() const {
+        return indexAccess;
+    }
+
+    void setColumn(std::size_t column, const Column& values) {
+        columns[column] = values;
+    }
+
+    /** Return the values of the columns of the relation, indexed by their position */
+    const std::map<std::size_t, Column>& getColumns() const {
+        return columns;
+    }
+
+    /** Return the number of bytes allocated by all indexes of the relation */
+    std::size_t getMemoryUsage() const {
+        std::size_t result = 0;
+        for (auto& index : indexMemory) {
+            result += index.second.bytes;
+        }
+        return result;
+    }
 };
 
 }  // namespace profile
@@ -8,12 +8,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <map>
 #include <set>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 namespace souffle {
 namespace profile {
@@ -41,6 +45,30 @@ public:
     }
 };
 
+/*
+ * Class to hold the time a thread spent in the chunks of the parallel loops of a rule
+ */
+class ThreadUsage {
+public:
+    std::chrono::microseconds busy{};
+    std::size_t chunks = 0;
+    /** intervals the thread was busy in, in the order of their start */
+    std::vector<std::pair<std::chrono::microseconds, std::chrono::microseconds>> timeline;
+};
+
+/*
+ * Class to hold the tuples entering an operator of the plan of a rule, and its time including the
+ * operators nested in it
+ */
+class OperatorUsage {
+public:
+    /** number of operators the operator is nested in */
+    std::size_t depth = 0;
+    std::string text;
+    std::size_t calls = 0;
+    std::chrono::nanoseconds time{};
+};
+
 /*
  * Class to hold information about souffle Rule profile information
  */
@@ -53,6 +81,9 @@ protected:
     std::string identifier;
     std::string locator{};
     std::set<Atom> atoms;
+    std::map<std::string, std::size_t> counters;
+    std::map<std::size_t, ThreadUsage> threads;
+    std::map<std::size_t, OperatorUsage> operators;
 
 private:
     bool recursive = false;
@@ -104,6 +135,74 @@ public:
     const std::set<Atom>& getAtoms() const {
         return atoms;
     }
+
+    void addCounter(const std::string& counter, std::size_t count) {
+        counters[counter] += count;
+    }
+
+    /** Return the hardware counters of the rule, indexed by name */
+    const std::map<std::string, std::size_t>& getCounters() const {
+        return counters;
+    }
+
+    void addThread(std::size_t thread, ThreadUsage usage) {
+        std::sort(usage.timeline.begin(), usage.timeline.end());
+        threads[thread] = std::move(usage);
+    }
+
+    /** Return the usage of the threads of the parallel loops of the rule, indexed by thread number */
+    const std::map<std::size_t, ThreadUsage>& getThreads() const {
+        return threads;
+    }
+
+    void addOperator(std::size_t position, OperatorUsage usage) {
+        operators[position] = std::move(usage);
+    }
+
+    /** Return the operators of the plan of the rule, indexed by their position in pre-order */
+    const std::map<std::size_t, OperatorUsage>& getOperators() const {
+        return operators;
+    }
+
+    /** Return the time the threads took from the start of the first chunk to the end of the last */
+    std::pair<std::chrono::microseconds, std::chrono::microseconds> getThreadSpan() const {
+        std::pair<std::chrono::microseconds, std::chrono::microseconds> span{
+                std::chrono::microseconds::max(), std::chrono::microseconds::min()};
+        for (const auto& thread : threads) {
+            if (!thread.second.timeline.empty()) {
+                span.first = std::min(span.first, thread.second.timeline.front().first);
+                span.second = std::max(span.second, thread.second.timeline.back().second);
+            }
+        }
+        return span.first <= span.second ? span : std::make_pair(starttime, starttime);
+    }
+
+    /** Return the busy time of the threads, summed over the threads */
+    std::chrono::microseconds getBusytime() const {
+        std::chrono::microseconds busy{};
+        for (const auto& thread : threads) {
+            busy += thread.second.busy;
+        }
+        return busy;
+    }
+
+    /** Return the time the threads waited for the others to finish, summed over the threads */
+    std::chrono::microseconds getIdletime() const {
+        const auto span = getThreadSpan();
+        const auto threadCount = static_cast<std::chrono::microseconds::rep>(threads.size());
+        const auto idle = (span.second - span.first) * threadCount - getBusytime();
+        return std::max(idle, std::chrono::microseconds{});
+    }
+
+    /** Return the busy time of the busiest thread, i.e., the time the parallel loops took */
+    std::chrono::microseconds getMaxBusytime() const {
+        std::chrono::microseconds busy{};
+        for (const auto& thread : threads) {
+            busy = std::max(busy, thread.second.busy);
+        }
+        return busy;
+    }
+
     std::string getName() const {
         return name;
     }
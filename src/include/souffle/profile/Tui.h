@@ -68,6 +68,8 @@ private:
     InputReader linereader;
     /// Limit results shown. Default value chosen to approximate unlimited
     std::size_t resultLimit = 20000;
+    /// Number of evaluations of a rule whose thread timelines are shown
+    static constexpr std::size_t THREAD_TIMELINES = 5;
 
     struct Usage {
         std::chrono::microseconds time;
@@ -137,6 +139,10 @@ public:
             ruleTable = out.getRulTable();
             relationTable = out.getRelTable();
 
+            setupTabCompletion();
+        } else if (reader->update()) {
+            // the binary log of a running program grows while it is viewed
+            updateDB();
             setupTabCompletion();
         }
 
@@ -184,6 +190,28 @@ public:
             }
         } else if (c[0] == "memory") {
             memoryUsage();
+        } else if (c[0] == "counters") {
+            counters(resultLimit);
+        } else if (c[0] == "threads") {
+            if (c.size() == 2) {
+                threadTimeline(c[1]);
+            } else if (c.size() == 1) {
+                threads(resultLimit);
+            } else {
+                std::cout << "Invalid parameters to threads command.\n";
+            }
+        } else if (c[0] == "plan") {
+            if (c.size() == 2 || c.size() == 3) {
+                plan(c[1], c.size() == 3 ? c[2] : "");
+            } else {
+                std::cout << "Invalid parameters to plan command.\n";
+            }
+        } else if (c[0] == "indexes") {
+            indexes(resultLimit);
+        } else if (c[0] == "index-access") {
+            indexAccess(resultLimit);
+        } else if (c[0] == "locks") {
+            locks(resultLimit);
         } else if (c[0] == "usage") {
             if (c.size() > 1) {
                 if (c[1][0] == 'R') {
@@ -608,6 +636,122 @@ public:
         return ss;
     }
 
+    std::stringstream& genJsonCounters(std::stringstream& ss) {
+        auto comma = [&ss](bool& first, const std::string& delimiter = ", ") {
+            if (!first) {
+                ss << delimiter;
+            } else {
+                first = false;
+            }
+        };
+
+        // counters of relations and rules by id, in the order of PerfCounters::getNames()
+        ss << R"_("counters": {)_";
+        bool firstRow = true;
+        for (auto& row : out.getCounterTable().rows) {
+            comma(firstRow, ", \n");
+            ss << '"' << (*row)[0]->getStringVal() << R"_(": [)_";
+            bool firstCol = true;
+            for (std::size_t i = 2; i < 6; ++i) {
+                comma(firstCol);
+                ss << (*row)[i]->getLongVal();
+            }
+            ss << ']';
+        }
+        ss << '}';
+        return ss;
+    }
+
+    std::stringstream& genJsonThreads(std::stringstream& ss) {
+        auto comma = [&ss](bool& first, const std::string& delimiter = ", ") {
+            if (!first) {
+                ss << delimiter;
+            } else {
+                first = false;
+            }
+        };
+        auto seconds = [](std::chrono::microseconds time) { return time.count() / 1000000.0; };
+
+        // thread utilisation of rules by id, as [threads, busy, idle, skew], and the timelines of
+        // their evaluations with the most idle time, as [label, span, [[thread, busy, chunks,
+        // [[start, end], ...]], ...]] with times relative to the start of the span
+        ss << R"_("threads": {)_";
+        bool firstRow = true;
+        for (auto& row : out.getThreadTable().rows) {
+            const std::string id = (*row)[0]->getStringVal();
+            comma(firstRow, ", \n");
+            ss << '"' << id << R"_(": {"summary": [)_" << (*row)[2]->getLongVal() << ", "
+               << (*row)[3]->getDoubleVal() << ", " << (*row)[4]->getDoubleVal() << ", "
+               << (*row)[5]->getDoubleVal() << R"_(], "timelines": [)_";
+            const auto executions = out.getThreadExecutions(id);
+            bool firstExecution = true;
+            for (std::size_t i = 0; i < executions.size() && i < THREAD_TIMELINES; ++i) {
+                const Rule& rule = *executions[i].second;
+                const auto span = rule.getThreadSpan();
+                comma(firstExecution);
+                ss << R"_([")_" << executions[i].first << R"_(", )_" << seconds(span.second - span.first)
+                   << ", [";
+                bool firstThread = true;
+                for (const auto& [thread, usage] : rule.getThreads()) {
+                    comma(firstThread);
+                    ss << '[' << thread << ", " << seconds(usage.busy) << ", " << usage.chunks << ", [";
+                    bool firstInterval = true;
+                    for (const auto& interval : usage.timeline) {
+                        comma(firstInterval);
+                        ss << '[' << seconds(interval.first - span.first) << ", "
+                           << seconds(interval.second - span.first) << ']';
+                    }
+                    ss << "]]";
+                }
+                ss << "]]";
+            }
+            ss << "]}";
+        }
+        ss << '}';
+        return ss;
+    }
+
+    std::stringstream& genJsonMemory(std::stringstream& ss) {
+        auto comma = [&ss](bool& first, const std::string& delimiter = ", ") {
+            if (!first) {
+                ss << delimiter;
+            } else {
+                first = false;
+            }
+        };
+
+        // indexes of relations by id, as [index, bytes, nodes, fill factor]
+        std::map<std::string, std::vector<std::shared_ptr<Row>>> indexes;
+        for (auto& row : out.getIndexMemoryTable().rows) {
+            indexes[(*row)[0]->getStringVal()].push_back(row);
+        }
+        ss << R"_("memory": {)_";
+        bool firstRel = true;
+        for (auto& rel : indexes) {
+            comma(firstRel, ", \n");
+            ss << '"' << rel.first << R"_(": [)_";
+            bool firstIndex = true;
+            for (auto& row : rel.second) {
+                comma(firstIndex);
+                ss << R"_([")_" << (*row)[2]->getStringVal() << R"_(", )_" << (*row)[3]->getLongVal() << ", "
+                   << (*row)[4]->getLongVal() << ", " << (*row)[5]->getDoubleVal() << ']';
+            }
+            ss << ']';
+        }
+        ss << "},\n";
+
+        // tables of the program by name, as [bytes, size]
+        ss << R"_("tables": {)_";
+        bool firstTable = true;
+        for (auto& table : out.getProgramRun()->getTableMemory()) {
+            comma(firstTable);
+            ss << '"' << table.first << R"_(": [)_" << table.second.first << ", " << table.second.second
+               << ']';
+        }
+        ss << '}';
+        return ss;
+    }
+
     std::string genJson() {
         std::stringstream ss;
 
@@ -626,6 +770,12 @@ public:
         genJsonConfiguration(ss);
         ss << ",\n";
         genJsonAtoms(ss);
+        ss << ",\n";
+        genJsonCounters(ss);
+        ss << ",\n";
+        genJsonThreads(ss);
+        ss << ",\n";
+        genJsonMemory(ss);
         ss << '\n';
 
         ss << "};\n";
@@ -702,6 +852,17 @@ public:
         std::printf("  %-30s%-5s %s\n", "usage [relation id|rule id]", "-",
                 "display CPU usage graphs for a relation or rule.");
         std::printf("  %-30s%-5s %s\n", "memory", "-", "display memory usage.");
+        std::printf("  %-30s%-5s %s\n", "counters", "-",
+                "display hardware counters of relations and rules.");
+        std::printf("  %-30s%-5s %s\n", "threads", "-", "display thread utilisation of parallel rules.");
+        std::printf("  %-30s%-5s %s\n", "threads <rule id>", "-",
+                "display thread timelines of the evaluations of a rule.");
+        std::printf("  %-30s%-5s %s\n", "plan <rule id> [iteration]", "-",
+                "display the plan of a rule with the tuples and times of its operators.");
+        std::printf("  %-30s%-5s %s\n", "indexes", "-", "display memory usage of indexes and tables.");
+        std::printf("  %-30s%-5s %s\n", "index-access", "-",
+                "display indexes by their accesses per inserted tuple.");
+        std::printf("  %-30s%-5s %s\n", "locks", "-", "display the contention of locks by their wait time.");
         std::printf("  %-30s%-5s %s\n", "help", "-", "print this.");
 
         std::cout << "\nInteractive mode only commands:" << std::endl;
@@ -991,6 +1152,12 @@ public:
         linereader.appendTabCompletion("usage");
         linereader.appendTabCompletion("limit ");
         linereader.appendTabCompletion("memory");
+        linereader.appendTabCompletion("counters");
+        linereader.appendTabCompletion("threads");
+        linereader.appendTabCompletion("plan ");
+        linereader.appendTabCompletion("indexes");
+        linereader.appendTabCompletion("index-access");
+        linereader.appendTabCompletion("locks");
         linereader.appendTabCompletion("configuration");
 
         // add rel tab completes after the rest so users can see all commands first
@@ -1074,6 +1241,274 @@ public:
         usage(10);
     }
 
+    void counters(std::size_t limit) {
+        Table counterTable = out.getCounterTable();
+        if (counterTable.getRows().empty()) {
+            std::cout << "No hardware counters recorded. Use --profile-counters to record them.\n";
+            return;
+        }
+        std::sort(counterTable.rows.begin(), counterTable.rows.end(),
+                [](const std::shared_ptr<Row>& a, const std::shared_ptr<Row>& b) {
+                    return (*a)[2]->getLongVal() > (*b)[2]->getLongVal();
+                });
+        std::cout << " ----- Hardware Counter Table -----\n";
+        std::printf("%10s%10s%10s%10s%10s%8s %s\n\n", "INSTR", "LLC_M", "DTLB_M", "BR_M", "LLC/KI", "ID",
+                "NAME");
+        std::size_t count = 0;
+        for (auto& row : Tools::formatTable(counterTable, precision)) {
+            if (++count > limit) {
+                std::cout << (counterTable.getRows().size() - limit) << " rows not shown" << std::endl;
+                break;
+            }
+            std::printf("%10s%10s%10s%10s%10s%8s %s\n", row[2].c_str(), row[3].c_str(), row[4].c_str(),
+                    row[5].c_str(), row[6].c_str(), row[0].c_str(), row[1].c_str());
+        }
+    }
+
+    void threads(std::size_t limit) {
+        Table threadTable = out.getThreadTable();
+        if (threadTable.getRows().empty()) {
+            std::cout << "No thread utilisation recorded. Profile the program with more than one thread.\n";
+            return;
+        }
+        // the rules whose threads waited the longest first
+        std::sort(threadTable.rows.begin(), threadTable.rows.end(),
+                [](const std::shared_ptr<Row>& a, const std::shared_ptr<Row>& b) {
+                    return (*a)[4]->getDoubleVal() > (*b)[4]->getDoubleVal();
+                });
+        std::cout << " ----- Thread Utilisation Table -----\n";
+        std::printf("%8s%10s%10s%8s%8s %s\n\n", "THREADS", "BUSY", "IDLE", "SKEW", "ID", "NAME");
+        std::size_t count = 0;
+        for (auto& row : Tools::formatTable(threadTable, precision)) {
+            if (++count > limit) {
+                std::cout << (threadTable.getRows().size() - limit) << " rows not shown" << std::endl;
+                break;
+            }
+            std::printf("%8s%10s%10s%8s%8s %s\n", row[2].c_str(), row[3].c_str(), row[4].c_str(),
+                    row[5].c_str(), row[0].c_str(), row[1].c_str());
+        }
+    }
+
+    void threadTimeline(const std::string& id) {
+        const auto executions = out.getThreadExecutions(id);
+        if (executions.empty()) {
+            std::cout << "No thread utilisation recorded for rule " << id << ".\n";
+            return;
+        }
+        std::cout << " ----- Thread Timeline of " << id << " -----\n";
+        std::cout << executions.front().second->getName() << "\n";
+        const std::size_t shown = std::min(executions.size(), THREAD_TIMELINES);
+        for (std::size_t i = 0; i < shown; ++i) {
+            const Rule& rule = *executions[i].second;
+            const auto span = rule.getThreadSpan();
+            std::cout << "\n"
+                      << (executions[i].first.empty() ? "" : executions[i].first + ": ")
+                      << "parallel loops took " << Tools::formatTime(span.second - span.first) << ", idle "
+                      << Tools::formatTime(rule.getIdletime()) << "\n";
+            for (const auto& [thread, usage] : rule.getThreads()) {
+                std::printf("%8zu |%s| %8s busy %6zu chunks\n", thread, timelineBar(usage, span).c_str(),
+                        Tools::formatTime(usage.busy).c_str(), usage.chunks);
+            }
+        }
+        if (executions.size() > shown) {
+            std::cout << "\n"
+                      << (executions.size() - shown) << " evaluations with less idle time not shown\n";
+        }
+    }
+
+    /**
+     * Display the plan of a rule; the plans of a recursive rule are shown for each version, summed
+     * over its iterations unless an iteration is given.
+     */
+    void plan(const std::string& id, const std::string& iteration) {
+        const auto executions = out.getPlanExecutions(id);
+        if (executions.empty()) {
+            std::cout << "No operators recorded for rule " << id
+                      << ". Use --profile-operators to record them.\n";
+            return;
+        }
+        std::cout << " ----- Plan of " << id << " -----\n";
+        std::cout << executions.front().second->getName() << "\n";
+        if (!executions.front().second->isRecursive()) {
+            printPlan(executions.front().second->getOperators());
+            return;
+        }
+        std::map<int, std::map<std::size_t, OperatorUsage>> versions;
+        std::map<int, std::size_t> evaluations;
+        for (const auto& [number, rule] : executions) {
+            if (!iteration.empty() && std::to_string(number) != iteration) {
+                continue;
+            }
+            auto& operators = versions[rule->getVersion()];
+            ++evaluations[rule->getVersion()];
+            for (const auto& [position, usage] : rule->getOperators()) {
+                auto& total = operators[position];
+                total.depth = usage.depth;
+                total.text = usage.text;
+                total.calls += usage.calls;
+                total.time += usage.time;
+            }
+        }
+        if (versions.empty()) {
+            std::cout << "Rule " << id << " was not evaluated in iteration " << iteration << ".\n";
+            return;
+        }
+        for (const auto& [version, operators] : versions) {
+            std::cout << "\nversion " << version;
+            if (iteration.empty()) {
+                std::cout << ", summed over " << evaluations[version] << " iterations";
+            } else {
+                std::cout << " in iteration " << iteration;
+            }
+            std::cout << "\n";
+            printPlan(operators);
+        }
+    }
+
+    /**
+     * Print the operators of a plan with the tuples entering them and leaving them, i.e., entering
+     * the operators nested in them, and their times with and without the nested operators. The
+     * times of the operators of parallel loops are summed over the threads.
+     */
+    void printPlan(const std::map<std::size_t, OperatorUsage>& plan) const {
+        std::vector<const OperatorUsage*> operators;
+        for (const auto& entry : plan) {
+            operators.push_back(&entry.second);
+        }
+        auto format = [](std::chrono::nanoseconds time) {
+            return Tools::formatTime(std::chrono::duration_cast<std::chrono::microseconds>(time));
+        };
+        std::printf("%10s%10s%10s%10s  %s\n", "IN", "OUT", "TIME", "SELF", "OPERATOR");
+        for (std::size_t i = 0; i < operators.size(); ++i) {
+            const auto& op = *operators[i];
+            bool leaf = true;
+            std::size_t tuplesOut = 0;
+            std::chrono::nanoseconds nested{};
+            for (std::size_t j = i + 1; j < operators.size() && operators[j]->depth > op.depth; ++j) {
+                if (operators[j]->depth == op.depth + 1) {
+                    leaf = false;
+                    tuplesOut += operators[j]->calls;
+                    nested += operators[j]->time;
+                }
+            }
+            const auto self = std::max(op.time - nested, std::chrono::nanoseconds{});
+            std::printf("%10s%10s%10s%10s  %s%s\n", Tools::formatNum(precision, op.calls).c_str(),
+                    leaf ? "-" : Tools::formatNum(precision, tuplesOut).c_str(), format(op.time).c_str(),
+                    format(self).c_str(), std::string(2 * op.depth, ' ').c_str(), op.text.c_str());
+        }
+    }
+
+    void indexes(std::size_t limit) {
+        const auto& tables = out.getProgramRun()->getTableMemory();
+        Table memoryTable = out.getIndexMemoryTable();
+        if (memoryTable.getRows().empty() && tables.empty()) {
+            std::cout << "No memory usage recorded. Profile the program with the interpreter to record it.\n";
+            return;
+        }
+        if (!tables.empty()) {
+            std::cout << " ----- Table Memory -----\n";
+            std::printf("%10s%10s %s\n\n", "BYTES", "SIZE", "NAME");
+            for (auto& table : tables) {
+                std::printf("%10s%10s %s\n", Tools::formatNum(precision, table.second.first).c_str(),
+                        Tools::formatNum(precision, table.second.second).c_str(), table.first.c_str());
+            }
+            std::cout << "\n";
+        }
+        std::sort(memoryTable.rows.begin(), memoryTable.rows.end(),
+                [](const std::shared_ptr<Row>& a, const std::shared_ptr<Row>& b) {
+                    return (*a)[3]->getLongVal() > (*b)[3]->getLongVal();
+                });
+        std::cout << " ----- Index Memory Table -----\n";
+        std::printf("%10s%10s%8s%8s %s\n\n", "BYTES", "NODES", "FILL%", "ID", "NAME");
+        std::size_t count = 0;
+        for (auto& row : Tools::formatTable(memoryTable, precision)) {
+            if (++count > limit) {
+                std::cout << (memoryTable.getRows().size() - limit) << " rows not shown" << std::endl;
+                break;
+            }
+            std::printf("%10s%10s%8s%8s %s %s\n", row[3].c_str(), row[4].c_str(), row[5].c_str(),
+                    row[0].c_str(), row[1].c_str(), row[2].c_str());
+        }
+    }
+
+    void indexAccess(std::size_t limit) {
+        Table accessTable = out.getIndexAccessTable();
+        if (accessTable.getRows().empty()) {
+            std::cout << "No index accesses recorded. Profile the program with --profile-frequency to record "
+                         "them.\n";
+            return;
+        }
+        // an index can only be dropped if its relation keeps another one
+        std::map<std::string, std::size_t> indexCount;
+        for (auto& row : accessTable.getRows()) {
+            ++indexCount[(*row)[0]->getStringVal()];
+        }
+        auto& rows = accessTable.rows;
+        rows.erase(std::remove_if(rows.begin(), rows.end(),
+                           [&](const std::shared_ptr<Row>& row) {
+                               return indexCount[(*row)[0]->getStringVal()] < 2;
+                           }),
+                rows.end());
+        // the indexes accessed least for their maintenance first
+        std::sort(rows.begin(), rows.end(), [](const std::shared_ptr<Row>& a, const std::shared_ptr<Row>& b) {
+            if ((*a)[7]->getDoubleVal() != (*b)[7]->getDoubleVal()) {
+                return (*a)[7]->getDoubleVal() < (*b)[7]->getDoubleVal();
+            }
+            return (*a)[6]->getLongVal() > (*b)[6]->getLongVal();
+        });
+        std::cout << " ----- Index Access Table -----\n";
+        std::printf("%10s%10s%10s%10s%10s%8s %s\n\n", "ACC/INS", "PROBES", "SCANS", "TUPLES", "INSERTS", "ID",
+                "NAME");
+        std::size_t count = 0;
+        for (auto& row : rows) {
+            if (++count > limit) {
+                std::cout << (rows.size() - limit) << " rows not shown" << std::endl;
+                break;
+            }
+            auto cell = [&](std::size_t i) { return (*row)[i]->toString(precision); };
+            const bool unused = (*row)[3]->getLongVal() == 0 && (*row)[4]->getLongVal() == 0;
+            std::printf("%10s%10s%10s%10s%10s%8s %s %s%s\n", cell(7).c_str(), cell(3).c_str(),
+                    cell(4).c_str(), cell(5).c_str(), cell(6).c_str(), cell(0).c_str(), cell(1).c_str(),
+                    cell(2).c_str(), unused ? " (unused)" : "");
+        }
+    }
+
+    void locks(std::size_t limit) {
+        using Contention = std::pair<std::pair<std::string, std::string>, ProgramRun::LockContention>;
+        const auto& contention = out.getProgramRun()->getLockContention();
+        if (contention.empty()) {
+            std::cout << "No lock contention recorded. Build souffle with SOUFFLE_PROFILE_LOCKS to record "
+                         "it.\n";
+            return;
+        }
+        std::vector<Contention> rows(contention.begin(), contention.end());
+        std::sort(rows.begin(), rows.end(), [](const Contention& a, const Contention& b) {
+            if (a.second.wait != b.second.wait) {
+                return a.second.wait > b.second.wait;
+            }
+            return a.second.acquisitions > b.second.acquisitions;
+        });
+        std::cout << " ----- Lock Contention Table -----\n";
+        std::printf("%10s%10s%10s%10s%8s %-28s %s\n\n", "WAIT", "ACQUIRED", "FAILED", "SPINS", "SPIN%",
+                "KIND", "SITE");
+        std::size_t count = 0;
+        for (const auto& [key, lock] : rows) {
+            if (++count > limit) {
+                std::cout << (rows.size() - limit) << " rows not shown" << std::endl;
+                break;
+            }
+            // the spins per hundred acquisitions
+            const double spinRate =
+                    lock.acquisitions == 0 ? 0 : 100.0 * lock.spins / static_cast<double>(lock.acquisitions);
+            const auto wait = std::chrono::duration_cast<std::chrono::microseconds>(lock.wait);
+            std::printf("%10s%10s%10s%10s%8.1f %-28s %s\n", Tools::formatTime(wait).c_str(),
+                    Tools::formatNum(precision, lock.acquisitions).c_str(),
+                    Tools::formatNum(precision, lock.failures).c_str(),
+                    Tools::formatNum(precision, lock.spins).c_str(), spinRate, key.second.c_str(),
+                    key.first.c_str());
+        }
+    }
+
     void setResultLimit(std::size_t limit) {
         resultLimit = limit;
     }
@@ -1470,6 +1905,27 @@ protected:
         relationTable = out.getRelTable();
     }
 
+    /**
+     * Draw the timeline of a thread over the span of the parallel loops of a rule, marking the
+     * parts of the span in which the thread evaluated chunks.
+     */
+    static std::string timelineBar(const ThreadUsage& usage,
+            const std::pair<std::chrono::microseconds, std::chrono::microseconds>& span,
+            std::size_t width = 50) {
+        using Rep = std::chrono::microseconds::rep;
+        const Rep cells = static_cast<Rep>(width);
+        const Rep length = std::max((span.second - span.first).count(), Rep{1});
+        std::string bar(width, '.');
+        for (const auto& interval : usage.timeline) {
+            const Rep first = (interval.first - span.first).count() * cells / length;
+            const Rep last = ((interval.second - span.first).count() * cells - 1) / length;
+            for (Rep i = std::max(first, Rep{0}); i <= last && i < cells; ++i) {
+                bar[i] = '#';
+            }
+        }
+        return bar;
+    }
+
     uint32_t getTermWidth() {
         struct winsize w {};
         ioctl(0, TIOCGWINSZ, &w);
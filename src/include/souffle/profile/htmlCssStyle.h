@@ -663,6 +663,31 @@ button {
     list-style:decimal;
     width: 60px;
 }
+
+.timeline_row {
+    display: flex;
+    align-items: center;
+    margin: 2px 0;
+}
+
+.timeline_label {
+    width: 80px;
+    color: #666;
+}
+
+.timeline_track {
+    position: relative;
+    flex: 1;
+    height: 14px;
+    background: #EEE;
+}
+
+.timeline_bar {
+    position: absolute;
+    top: 0;
+    height: 100%;
+    background: #5B8DB8;
+}
 )___";
 }
 }  // namespace profile
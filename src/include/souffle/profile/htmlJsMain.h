@@ -16,6 +16,8 @@ function changeSelectedRel(id) {
     selected.rel = id;
     highlightRow();
     genRulesOfRelations();
+    genCounters(selected.rel, "relcounters");
+    genMemory(selected.rel);
 }
 
 function changeSelectedRul(id) {
@@ -23,6 +25,8 @@ function changeSelectedRul(id) {
     highlightRow();
     genRulVer();
     genAtomVer();
+    genCounters(selected.rul, "rulcounters");
+    genThreads(selected.rul, "rulthreads");
 }
 
 function highlightRow() {
@@ -474,6 +478,96 @@ function genAtomVer() {
     document.getElementById("atoms").style.display = "block";
 }
 
+function genCounters(id, div) {
+    var names = ["Instructions", "LLC misses", "dTLB misses", "Branch misses"];
+    var counters = data.counters === undefined ? undefined : data.counters[id];
+    if (counters === undefined) {
+        document.getElementById(div).style.display = "none";
+        return;
+    }
+    var table_body = document.getElementById(div + '_body');
+    table_body.innerHTML = "";
+
+    for (var i = 0; i < counters.length; ++i) {
+        var row = document.createElement("tr");
+        row.appendChild(create_cell("text", names[i]));
+        row.appendChild(create_cell("int", counters[i]));
+        if (i === 0 || counters[0] === 0) {
+            row.appendChild(create_cell("text", '--'));
+        } else {
+            row.appendChild(create_cell("text", (counters[i] * 1000 / counters[0]).toFixed(2)));
+        }
+        table_body.appendChild(row);
+    }
+    document.getElementById(div).style.display = "block";
+}
+
+function genThreads(id, div) {
+    var threads = data.threads === undefined ? undefined : data.threads[id];
+    if (threads === undefined) {
+        document.getElementById(div).style.display = "none";
+        return;
+    }
+    var summary = threads.summary;
+    document.getElementById(div + '_summary').innerHTML = summary[0] + " threads, busy " +
+        humanise_time(summary[1]) + ", idle " + humanise_time(summary[2]) + ", skew " +
+        summary[3].toFixed(2) + " (the time of the parallel loops relative to equally busy threads)";
+
+    // a row per thread, with a bar per interval the thread evaluated chunks in
+    var timelines = document.getElementById(div + '_timelines');
+    timelines.innerHTML = "";
+    for (var i = 0; i < threads.timelines.length; ++i) {
+        var timeline = threads.timelines[i];
+        var title = document.createElement("h4");
+        title.innerHTML = (timeline[0] === "" ? "" : timeline[0] + ": ") + "parallel loops took " +
+            humanise_time(timeline[1]);
+        timelines.appendChild(title);
+        for (var j = 0; j < timeline[2].length; ++j) {
+            var thread = timeline[2][j];
+            var row = document.createElement("div");
+            row.className = "timeline_row";
+            var label = document.createElement("span");
+            label.className = "timeline_label";
+            label.innerHTML = "thread " + thread[0];
+            row.appendChild(label);
+            var track = document.createElement("div");
+            track.className = "timeline_track";
+            track.title = "busy " + humanise_time(thread[1]) + " in " + thread[2] + " chunks";
+            for (var k = 0; k < thread[3].length; ++k) {
+                var bar = document.createElement("div");
+                bar.className = "timeline_bar";
+                var span = timeline[1] > 0 ? timeline[1] : 1;
+                bar.style.left = (100 * thread[3][k][0] / span) + "%";
+                bar.style.width = Math.max(100 * (thread[3][k][1] - thread[3][k][0]) / span, 0.2) + "%";
+                track.appendChild(bar);
+            }
+            row.appendChild(track);
+            timelines.appendChild(row);
+        }
+    }
+    document.getElementById(div).style.display = "block";
+}
+
+function genMemory(id) {
+    var indexes = data.memory === undefined ? undefined : data.memory[id];
+    if (indexes === undefined) {
+        document.getElementById("relmemory").style.display = "none";
+        return;
+    }
+    var table_body = document.getElementById("relmemory_body");
+    table_body.innerHTML = "";
+
+    for (var i = 0; i < indexes.length; ++i) {
+        var row = document.createElement("tr");
+        row.appendChild(create_cell("text", indexes[i][0]));
+        row.appendChild(create_cell("int", indexes[i][1]));
+        row.appendChild(create_cell("int", indexes[i][2]));
+        row.appendChild(create_cell("text", indexes[i][3].toFixed(1)));
+        table_body.appendChild(row);
+    }
+    document.getElementById("relmemory").style.display = "block";
+}
+
 function genConfig() {
     var table = document.createElement("table");
     {
@@ -155,6 +155,39 @@ std::string htmlBodyTop = R"___(
             </table>
         </div>
     </div>
+    <div id="relcounters" style="display:none;">
+        <h3>Hardware Counters</h3>
+        <div class="table_wrapper">
+            <table id='relcounterstable'>
+                <thead>
+                <tr>
+                    <th data-sort-method="text">Counter</th>
+                    <th data-sort-method="number">Events</th>
+                    <th data-sort-method="number">Per 1000 Instructions</th>
+                </tr>
+                </thead>
+                <tbody id="relcounters_body">
+                </tbody>
+            </table>
+        </div>
+    </div>
+    <div id="relmemory" style="display:none;">
+        <h3>Index Memory</h3>
+        <div class="table_wrapper">
+            <table id='relmemorytable'>
+                <thead>
+                <tr>
+                    <th data-sort-method="text">Index</th>
+                    <th data-sort-method="number">Bytes</th>
+                    <th data-sort-method="number">Nodes</th>
+                    <th data-sort-method="number">Fill %</th>
+                </tr>
+                </thead>
+                <tbody id="relmemory_body">
+                </tbody>
+            </table>
+        </div>
+    </div>
 </div>
 <div id="Rules" class="tabcontent">
     <h3>Rules table</h3>
@@ -219,6 +252,28 @@ std::string htmlBodyTop = R"___(
             </table>
         </div>
     </div>
+    <div id="rulcounters" style="display:none;">
+        <h3>Hardware Counters</h3>
+        <div class="table_wrapper">
+            <table id='rulcounterstable'>
+                <thead>
+                <tr>
+                    <th data-sort-method="text">Counter</th>
+                    <th data-sort-method="number">Events</th>
+                    <th data-sort-method="number">Per 1000 Instructions</th>
+                </tr>
+                </thead>
+                <tbody id="rulcounters_body">
+                </tbody>
+            </table>
+        </div>
+    </div>
+    <div id="rulthreads" style="display:none;">
+        <h3>Thread Utilisation</h3>
+        <p id="rulthreads_summary"></p>
+        <div id="rulthreads_timelines">
+        </div>
+    </div>
 </div>
 <div id="Chart" class="tabcontent">
     <button onclick="goBack(event)">Go Back</button>
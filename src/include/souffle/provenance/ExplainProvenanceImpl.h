@@ -33,6 +33,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -108,6 +109,7 @@ public:
             tuple.push_back(levelNum);
 
             // find if subproof exists already
+            std::lock_guard<std::mutex> guard(cacheMutex);
             std::size_t idx = 0;
             auto it = std::find(subproofs.begin(), subproofs.end(), tuple);
             if (it != subproofs.end()) {
@@ -125,11 +127,9 @@ public:
         auto internalNode =
                 mk<InnerNode>(relName + "(" + joinedArgsStr + ")", "(R" + std::to_string(ruleNum) + ")");
 
-        // make return vector pointer
-        std::vector<RamDomain> ret;
-
-        // execute subroutine to get subproofs
-        prog.executeSubroutine(relName + "_" + std::to_string(ruleNum) + "_subproof", tuple, ret);
+        // execute subroutine to get subproofs, once per tuple
+        const std::vector<RamDomain>& ret =
+                getSubproof(relName + "_" + std::to_string(ruleNum) + "_subproof", tuple);
 
         // recursively get nodes for subproofs
         std::size_t tupleCurInd = 0;
@@ -232,6 +232,44 @@ public:
         return explain(relName, tuple, ruleNum, levelNum, depthLimit);
     }
 
+    /**
+     * Explain the given tuples in parallel, e.g. to extract the proofs of many output tuples at once.
+     * The subproofs of tuples shared by several proofs are computed once.
+     *
+     * @param queries The relation names and arguments of the tuples
+     * @param depthLimit The depth beyond which the proof trees are cut as for explain()
+     * @return The proof trees, in the order of the queries
+     */
+    VecOwn<TreeNode> explainAll(
+            const std::vector<std::pair<std::string, std::vector<std::string>>>& queries,
+            std::size_t depthLimit) {
+        VecOwn<TreeNode> trees(queries.size());
+        const auto numQueries = static_cast<std::ptrdiff_t>(queries.size());
+#pragma omp parallel for schedule(dynamic) num_threads(prog.getNumThreads())
+        for (std::ptrdiff_t i = 0; i < numQueries; i++) {
+            const auto& [relName, args] = queries[i];
+            trees[i] = explain(relName, args, depthLimit);
+        }
+        return trees;
+    }
+
+    /**
+     * Print the proof trees of explainAll() as a JSON array.
+     */
+    void printProofsJSON(std::ostream& os,
+            const std::vector<std::pair<std::string, std::vector<std::string>>>& queries,
+            std::size_t depthLimit) {
+        auto trees = explainAll(queries, depthLimit);
+        os << "[\n";
+        for (std::size_t i = 0; i < trees.size(); i++) {
+            if (i > 0) {
+                os << ",\n";
+            }
+            trees[i]->printJSON(os, 1);
+        }
+        os << "\n]\n";
+    }
+
     Own<TreeNode> explainSubproof(
             std::string relName, RamDomain subproofNum, std::size_t depthLimit) override {
         if (subproofNum >= (int)subproofs.size()) {
@@ -661,7 +699,7 @@ public:
                                       << std::endl;
                             return;
                         }
-                        rd = prog.getSymbolTable().encode(argsMatcher[1]);
+                        rd = prog.getSymbolTable().encode(argsMatcher.str(1));
                         break;
                     case 'f':
                         if (!canBeParsedAsRamFloat(rel.second[j])) {
@@ -737,6 +775,30 @@ private:
     std::map<std::pair<std::string, std::size_t>, std::vector<std::string>> info;
     std::map<std::pair<std::string, std::size_t>, std::string> rules;
     std::vector<std::vector<RamDomain>> subproofs;
+
+    /** Results of the subproof subroutines by subroutine and arguments, shared by the nodes of proofs */
+    std::map<std::pair<std::string, std::vector<RamDomain>>, std::vector<RamDomain>> subproofCache;
+
+    /** Guards the caches, which are shared by the threads of explainAll() */
+    std::mutex cacheMutex;
+
+    const std::vector<RamDomain>& getSubproof(
+            const std::string& subroutine, const std::vector<RamDomain>& args) {
+        auto key = std::make_pair(subroutine, args);
+        {
+            std::lock_guard<std::mutex> guard(cacheMutex);
+            auto pos = subproofCache.find(key);
+            if (pos != subproofCache.end()) {
+                return pos->second;
+            }
+        }
+        // the subroutine is executed without holding the lock; entries of the map are never replaced
+        std::vector<RamDomain> ret;
+        prog.executeSubroutine(subroutine, args, ret);
+        std::lock_guard<std::mutex> guard(cacheMutex);
+        return subproofCache.emplace(std::move(key), std::move(ret)).first->second;
+    }
+
     std::vector<std::string> constraintList = {
             "=", "!=", "<", "<=", ">=", ">", "match", "contains", "not_match", "not_contains"};
 
@@ -755,46 +817,11 @@ private:
             return std::make_tuple(-1, -1);
         }
 
-        // find correct tuple
-        for (auto& tuple : *rel) {
-            bool match = true;
-            std::vector<RamDomain> currentTuple;
-
-            for (arity_type i = 0; i < rel->getPrimaryArity(); i++) {
-                RamDomain n;
-                if (*rel->getAttrType(i) == 's') {
-                    std::string s;
-                    tuple >> s;
-                    n = lookupExisting(s);
-                } else if (*rel->getAttrType(i) == 'f') {
-                    RamFloat element;
-                    tuple >> element;
-                    n = ramBitCast(element);
-                } else if (*rel->getAttrType(i) == 'u') {
-                    RamUnsigned element;
-                    tuple >> element;
-                    n = ramBitCast(element);
-                } else {
-                    tuple >> n;
-                }
-
-                currentTuple.push_back(n);
-
-                if (n != tup[i]) {
-                    match = false;
-                    break;
-                }
-            }
-
-            if (match) {
-                RamDomain ruleNum;
-                tuple >> ruleNum;
-
-                RamDomain levelNum;
-                tuple >> levelNum;
-
-                return std::make_tuple(ruleNum, levelNum);
-            }
+        // find correct tuple by its primary attributes, which complete it by its annotations
+        const std::size_t primaryArity = rel->getPrimaryArity();
+        tup.resize(rel->getArity());
+        if (rel->findPrimary(tup)) {
+            return std::make_tuple(tup[primaryArity], tup[primaryArity + 1]);
         }
 
         // if no tuple exists
@@ -17,8 +17,11 @@
 #pragma once
 
 #include "souffle/SouffleInterface.h"
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 /**
  * Abstract base class for generated Datalog programs
@@ -77,6 +80,97 @@ public:
     void dumpOutputs() {
         program->dumpOutputs();
     }
+
+    /**
+     * Return the number of tuples of the relation, or 0 if there is no such relation
+     */
+    std::size_t getSize(const std::string& relationName) {
+        const auto* relation = program->getRelation(relationName);
+        return relation == nullptr ? 0 : relation->size();
+    }
+
+    /**
+     * Return the arity of the relation, or 0 if there is no such relation
+     */
+    std::size_t getArity(const std::string& relationName) {
+        const auto* relation = program->getRelation(relationName);
+        return relation == nullptr ? 0 : relation->getPrimaryArity();
+    }
+
+    /**
+     * Return the attribute types of the relation, e.g. "s:symbol", from which the columns holding
+     * symbols are known
+     */
+    std::vector<std::string> getAttributeTypes(const std::string& relationName) {
+        std::vector<std::string> types;
+        if (const auto* relation = program->getRelation(relationName)) {
+            for (std::size_t i = 0; i < relation->getPrimaryArity(); ++i) {
+                types.push_back(relation->getAttrType(i));
+            }
+        }
+        return types;
+    }
+
+    /**
+     * Return the size in bytes of the elements written by exportColumns, i.e., of a souffle::RamDomain
+     */
+    std::size_t getElementSize() {
+        return sizeof(souffle::RamDomain);
+    }
+
+    /**
+     * Write the relation into a buffer of the caller as contiguous columns, i.e., column i of the
+     * n tuples starts at element i * n. The buffer is a bytearray or NumPy array in Python and a
+     * direct ByteBuffer in Java, and must hold getSize() * getArity() elements of getElementSize()
+     * bytes. Symbol columns hold the indices of the symbols returned by getSymbols().
+     *
+     * Unlike iterating the tuples, the elements are not marshalled one by one.
+     *
+     * @return the number of tuples written, or 0 if there is no such relation or the buffer is too small
+     */
+    std::size_t exportColumns(const std::string& relationName, void* buffer, std::size_t size) {
+        const auto* relation = program->getRelation(relationName);
+        if (relation == nullptr) {
+            return 0;
+        }
+        const std::size_t n = relation->size();
+        const std::size_t arity = relation->getPrimaryArity();
+        const std::size_t fullArity = relation->getArity();
+        if (size < n * arity * sizeof(souffle::RamDomain)) {
+            return 0;
+        }
+        auto* columns = static_cast<char*>(buffer);
+        std::size_t row = 0;
+        relation->scanBatch(
+                [&](souffle::span<const souffle::RamDomain> tuples, std::size_t count) {
+                    for (std::size_t t = 0; t < count; ++t, ++row) {
+                        for (std::size_t i = 0; i < arity; ++i) {
+                            // buffers from the host language need not be aligned
+                            std::memcpy(columns + (i * n + row) * sizeof(souffle::RamDomain),
+                                    &tuples[t * fullArity + i], sizeof(souffle::RamDomain));
+                        }
+                    }
+                },
+                exportBatchSize);
+        return row;
+    }
+
+    /**
+     * Return the symbols of the program, where the symbol of index i is at position i
+     */
+    std::vector<std::string> getSymbols() {
+        auto& symbolTable = program->getSymbolTable();
+        std::vector<std::string> symbols;
+        symbols.reserve(symbolTable.size());
+        for (std::size_t i = 0; i < symbolTable.size(); ++i) {
+            symbols.push_back(symbolTable.decode(static_cast<souffle::RamDomain>(i)));
+        }
+        return symbols;
+    }
+
+private:
+    /** The number of tuples exported per batch of souffle::Relation::scanBatch */
+    static constexpr std::size_t exportBatchSize = 1024;
 };
 
 /**
@@ -21,8 +21,24 @@
 %include<std_vector.i>
 namespace std {
     %template(map_string_string) map<string, string>;
+    %template(vector_string) vector<string>;
 }
 
+// exportColumns writes into a buffer of the host language, without copying through SWIG wrappers
+#if defined(SWIGPYTHON)
+%include "pybuffer.i"
+%pybuffer_mutable_binary(void* buffer, std::size_t size);
+#elif defined(SWIGJAVA)
+%typemap(jni) (void* buffer, std::size_t size) "jobject"
+%typemap(jtype) (void* buffer, std::size_t size) "java.nio.ByteBuffer"
+%typemap(jstype) (void* buffer, std::size_t size) "java.nio.ByteBuffer"
+%typemap(javain) (void* buffer, std::size_t size) "$javainput"
+%typemap(in) (void* buffer, std::size_t size) {
+    $1 = jenv->GetDirectBufferAddress($input);
+    $2 = $1 == nullptr ? 0 : static_cast<std::size_t>(jenv->GetDirectBufferCapacity($input));
+}
+#endif
+
 %{
 #include "SwigInterface.h"
 #include <iostream>
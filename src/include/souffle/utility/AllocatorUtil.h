@@ -0,0 +1,78 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file AllocatorUtil.h
+ *
+ * @brief Statistics of the memory allocator the program is linked with,
+ * i.e., jemalloc or mimalloc if selected by SOUFFLE_ALLOCATOR, and the
+ * allocator of the C library otherwise.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(USE_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(USE_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace souffle {
+
+/** The memory of the heap */
+struct HeapStatistics {
+    // the name of the allocator
+    std::string allocator;
+    // the bytes allocated by the program
+    std::size_t allocated = 0;
+    // the bytes of the heap resident in physical memory
+    std::size_t resident = 0;
+};
+
+/** Obtain the statistics of the heap; both sizes are zero if the allocator does not provide them */
+inline HeapStatistics getHeapStatistics() {
+    HeapStatistics res;
+#if defined(USE_JEMALLOC)
+    res.allocator = "jemalloc";
+    // the statistics are cached by jemalloc until the epoch is advanced
+    std::uint64_t epoch = 1;
+    std::size_t length = sizeof(epoch);
+    mallctl("epoch", &epoch, &length, &epoch, length);
+    length = sizeof(std::size_t);
+    mallctl("stats.allocated", &res.allocated, &length, nullptr, 0);
+    mallctl("stats.resident", &res.resident, &length, nullptr, 0);
+#elif defined(USE_MIMALLOC)
+    res.allocator = "mimalloc";
+    std::size_t elapsed = 0;
+    std::size_t user = 0;
+    std::size_t system = 0;
+    std::size_t peakResident = 0;
+    std::size_t peakCommitted = 0;
+    std::size_t pageFaults = 0;
+    mi_process_info(&elapsed, &user, &system, &res.resident, &peakResident, &res.allocated, &peakCommitted,
+            &pageFaults);
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    res.allocator = "glibc";
+    const struct mallinfo2 info = mallinfo2();
+    res.allocated = info.uordblks + info.hblkhd;
+    res.resident = info.arena + info.hblkhd;
+#else
+    res.allocator = "unknown";
+#endif
+    return res;
+}
+
+}  // namespace souffle
@@ -19,10 +19,22 @@
 #include "souffle/RamTypes.h"
 #include "souffle/utility/StringUtil.h"
 #include "souffle/utility/tinyformat.h"
+#include <algorithm>
+#include <charconv>
 #include <csignal>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace souffle::evaluator {
 
+/** The default step of a range without one */
+template <typename A>
+A rangeStep(A from, A to) {
+    return A(from <= to ? 1 : -1);
+}
+
 template <typename A, typename F /* Tuple<RamDomain,1> -> void */>
 void runRange(A from, A to, A step, F&& go) {
 #define GO(x) go(Tuple<RamDomain, 1>{ramBitCast(x)})
@@ -43,7 +55,45 @@ void runRange(A from, A to, A step, F&& go) {
 
 template <typename A, typename F /* Tuple<RamDomain,1> -> void */>
 void runRange(A from, A to, F&& go) {
-    return runRange(from, to, A(from <= to ? 1 : -1), std::forward<F>(go));
+    return runRange(from, to, rangeStep(from, to), std::forward<F>(go));
+}
+
+/** The number of parts a range is split into at most, balancing the load of the threads running them */
+constexpr std::size_t RANGE_PARTS = 1024;
+
+/** The number of values of an integer range, i.e., the number of iterations of runRange */
+template <typename A>
+std::size_t rangeSize(A from, A to, A step) {
+    static_assert(std::is_integral_v<A>, "only integer ranges are sized");
+    using U = std::make_unsigned_t<A>;
+    if (0 < step) {
+        return from < to ? std::size_t((U(to) - U(from) - 1) / U(step)) + 1 : 0;
+    } else if (step < 0) {
+        return to < from ? std::size_t((U(from) - U(to) - 1) / (U(0) - U(step))) + 1 : 0;
+    }
+    return from != to ? 1 : 0;
+}
+
+/** The number of parts an integer range of the given size is split into */
+inline std::size_t rangePartCount(std::size_t size) {
+    return std::min(size, RANGE_PARTS);
+}
+
+/**
+ * Runs the values of a part of an integer range, i.e., the values of runRange
+ * whose positions fall into the given part of the parts of similar size.
+ */
+template <typename A, typename F /* Tuple<RamDomain,1> -> void */>
+void runRangePart(A from, A step, std::size_t size, std::size_t part, std::size_t parts, F&& go) {
+    static_assert(std::is_integral_v<A>, "only integer ranges are split");
+    using U = std::make_unsigned_t<A>;
+    const std::size_t begin = part * (size / parts) + std::min(part, size % parts);
+    const std::size_t end = begin + size / parts + (part < size % parts ? 1 : 0);
+    // the values are computed modulo the width of the type, as the steps of runRange would
+    A x = A(U(from) + U(begin) * U(step));
+    for (std::size_t i = begin; i < end; ++i, x = A(U(x) + U(step))) {
+        go(Tuple<RamDomain, 1>{ramBitCast(x)});
+    }
 }
 
 template <typename A>
@@ -66,6 +116,60 @@ A symbol2numeric(const std::string& src) {
     }
 };
 
+/**
+ * Builds the result of a string functor in a buffer of the calling thread.
+ *
+ * The buffer keeps its capacity across calls, hence building a string does
+ * not allocate once the buffer has grown to the size of the results, and
+ * the result is viewed rather than copied when it is encoded. Builders may
+ * nest, e.g., if an argument of a concatenation is a substring of another
+ * concatenation: each builder appends to the buffer after the content of
+ * the enclosing builders, and truncates the buffer when it is destroyed.
+ */
+class StringBuilder {
+public:
+    StringBuilder() : buffer(getBuffer()), start(buffer.size()) {}
+    StringBuilder(const StringBuilder&) = delete;
+    StringBuilder& operator=(const StringBuilder&) = delete;
+
+    ~StringBuilder() {
+        buffer.resize(start);
+    }
+
+    /** Appends the given string */
+    StringBuilder& append(std::string_view str) {
+        buffer.append(str);
+        return *this;
+    }
+
+    /** Appends the decimal representation of the given number, as std::to_string */
+    template <typename A>
+    StringBuilder& appendNumber(A value) {
+        if constexpr (std::is_integral_v<A> && !std::is_same_v<A, bool>) {
+            char digits[24];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            buffer.append(digits, result.ptr);
+        } else {
+            buffer.append(std::to_string(value));
+        }
+        return *this;
+    }
+
+    /** The string built so far, valid until the next change of this builder */
+    std::string_view view() const {
+        return std::string_view(buffer).substr(start);
+    }
+
+private:
+    static std::string& getBuffer() {
+        static thread_local std::string buffer;
+        return buffer;
+    }
+
+    std::string& buffer;
+    const std::size_t start;
+};
+
 template <typename A>
 bool lxor(A x, A y) {
     return (x || y) && (!x != !y);
@@ -18,10 +18,20 @@
 
 #if defined(_MSC_VER)
 #define SOUFFLE_ALWAYS_INLINE /* TODO: MSVC equiv */
+#define SOUFFLE_HOT
+#define SOUFFLE_COLD __declspec(noinline)
+#define SOUFFLE_UNLIKELY(x) (x)
+#define SOUFFLE_PREFETCH(addr) ((void)(addr))
 #else
 // clang / gcc recognize this attribute
 // NB: GCC will only inline when optimisation is on, and will warn about it.
 //     Adding `inline` (even though the KW nominally has nothing to do with
 //     inlining) will force it to inline in all cases. Lovely.
 #define SOUFFLE_ALWAYS_INLINE [[gnu::always_inline]] inline
+// hot functions are grouped together, cold functions are kept out of line and away from them
+#define SOUFFLE_HOT [[gnu::hot]]
+#define SOUFFLE_COLD [[gnu::cold, gnu::noinline]]
+#define SOUFFLE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+// requests the cache line holding the address for reading, without waiting for it
+#define SOUFFLE_PREFETCH(addr) __builtin_prefetch(addr)
 #endif
@@ -0,0 +1,285 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LockProfile.h
+ *
+ * Counters of the contention of the locks of ParallelUtil.h, recorded in
+ * builds defining USE_LOCK_PROFILING.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/** The kinds of locks of ParallelUtil.h */
+enum class LockKind { Mutex, SpinLock, ReadWriteLock, OptimisticReadWriteLock, Lanes };
+
+/** Number of kinds of locks */
+constexpr std::size_t NUM_LOCK_KINDS = 5;
+
+inline const char* getLockKindName(LockKind kind) {
+    switch (kind) {
+        case LockKind::Mutex: return "mutex";
+        case LockKind::SpinLock: return "spin-lock";
+        case LockKind::ReadWriteLock: return "read-write-lock";
+        case LockKind::OptimisticReadWriteLock: return "optimistic-read-write-lock";
+        case LockKind::Lanes: return "lanes";
+    }
+    return "";
+}
+
+/**
+ * A site of locks, e.g., the nodes of an index of a relation.
+ *
+ * The threads count their operations on the locks of a site in counters of
+ * their own, which share no cache line with the counters of other threads,
+ * such that counting does not add to the contention it measures.
+ */
+class LockSite {
+public:
+    /** The operations of the threads on the locks of a kind */
+    struct Totals {
+        // the number of times a lock was taken
+        std::size_t acquisitions = 0;
+        // the number of optimistic reads invalidated by a writer, and of failed attempts to take a lock
+        std::size_t failures = 0;
+        // the number of iterations spent spinning for a lock, or blocking on a mutex
+        std::size_t spins = 0;
+        // the time spent waiting for the locks
+        std::chrono::nanoseconds wait{};
+    };
+
+    /** The counters of a thread for a kind of locks */
+    struct alignas(64) Counters {
+        std::atomic<std::size_t> acquisitions{0};
+        std::atomic<std::size_t> failures{0};
+        std::atomic<std::size_t> spins{0};
+        std::atomic<std::size_t> waitNanos{0};
+
+        /** Add to a counter, which only its thread writes unless more threads than slots ever ran */
+        static void add(std::atomic<std::size_t>& counter, std::size_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+
+    explicit LockSite(std::string name)
+            : name(std::move(name)), slots(std::max(2 * std::thread::hardware_concurrency(), 64U)) {}
+
+    const std::string& getName() const {
+        return name;
+    }
+
+    /** Return the counters of the calling thread for a kind of locks */
+    Counters& getCounters(LockKind kind) {
+        static std::atomic<std::size_t> nextSlot{0};
+        thread_local const std::size_t slot = nextSlot++;
+        return slots[slot % slots.size()][static_cast<std::size_t>(kind)];
+    }
+
+    /** Return the operations of all threads on the locks of a kind */
+    Totals getTotals(LockKind kind) const {
+        Totals res;
+        for (const auto& slot : slots) {
+            const auto& counters = slot[static_cast<std::size_t>(kind)];
+            res.acquisitions += counters.acquisitions.load(std::memory_order_relaxed);
+            res.failures += counters.failures.load(std::memory_order_relaxed);
+            res.spins += counters.spins.load(std::memory_order_relaxed);
+            res.wait += std::chrono::nanoseconds(counters.waitNanos.load(std::memory_order_relaxed));
+        }
+        return res;
+    }
+
+private:
+    std::string name;
+
+    std::vector<std::array<Counters, NUM_LOCK_KINDS>> slots;
+};
+
+/**
+ * The registry of the lock sites.
+ *
+ * A thread attributes the locks it takes to its current site, set by a
+ * LockSiteScope, e.g., while inserting into an index of a relation. The
+ * locks taken outside of any scope, e.g., of the symbol table, are
+ * attributed to the site "(untagged)", and are told apart by their kind.
+ */
+class LockProfile {
+public:
+    /** Whether the locks are instrumented by this build */
+#ifdef USE_LOCK_PROFILING
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    /** Return the site of the given name, created by its first use, or nullptr if not instrumented */
+    static LockSite* getSite(const std::string& name) {
+        if constexpr (!enabled) {
+            return nullptr;
+        }
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        auto& site = r.sites[name];
+        if (!site) {
+            site = std::make_unique<LockSite>(name);
+        }
+        return site.get();
+    }
+
+    /** Return the site of the locks the calling thread takes */
+    static LockSite& getCurrentSite() {
+        LockSite* site = current();
+        if (site == nullptr) {
+            static LockSite* untagged = getSite("(untagged)");
+            return *untagged;
+        }
+        return *site;
+    }
+
+    /** Visit the sites recorded so far */
+    static void forEachSite(const std::function<void(const LockSite&)>& visitor) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        for (const auto& site : r.sites) {
+            visitor(*site.second);
+        }
+    }
+
+    /** The site of the calling thread, or nullptr outside of any scope */
+    static LockSite*& current() {
+        thread_local LockSite* site = nullptr;
+        return site;
+    }
+
+private:
+    struct Registry {
+        std::mutex lock;
+        // the sites are never freed, such that the data structures may hold on to them
+        std::map<std::string, std::unique_ptr<LockSite>> sites;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+};
+
+/**
+ * Attribute the locks taken by the calling thread to a site during the
+ * lifetime of the scope. A null site keeps the current one.
+ */
+class LockSiteScope {
+public:
+#ifdef USE_LOCK_PROFILING
+    explicit LockSiteScope(LockSite* site) : previous(LockProfile::current()) {
+        if (site != nullptr) {
+            LockProfile::current() = site;
+        }
+    }
+
+    ~LockSiteScope() {
+        LockProfile::current() = previous;
+    }
+
+private:
+    LockSite* previous;
+#else
+    explicit LockSiteScope(LockSite*) {}
+#endif
+
+public:
+    LockSiteScope(const LockSiteScope&) = delete;
+    LockSiteScope& operator=(const LockSiteScope&) = delete;
+};
+
+/**
+ * Record the acquisition of a lock at the current site: the iterations
+ * the thread waited for the lock, and the time it waited, whose clock is
+ * only read once the lock turned out to be contended.
+ */
+class LockAcquisition {
+public:
+#ifdef USE_LOCK_PROFILING
+    explicit LockAcquisition(LockKind kind) : counters(LockProfile::getCurrentSite().getCounters(kind)) {}
+
+    ~LockAcquisition() {
+        LockSite::Counters::add(counters.acquisitions, 1);
+        if (spins != 0) {
+            const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start);
+            LockSite::Counters::add(counters.spins, spins);
+            LockSite::Counters::add(counters.waitNanos, static_cast<std::size_t>(wait.count()));
+        }
+    }
+
+    /** Count an iteration of waiting for the lock */
+    void wait() {
+        if (spins++ == 0) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    /** Count a lock taken at once, e.g., by a successful attempt */
+    static void acquired(LockKind kind) {
+        LockSite::Counters::add(LockProfile::getCurrentSite().getCounters(kind).acquisitions, 1);
+    }
+
+    /** Count an optimistic read invalidated by a writer, or a failed attempt to take a lock */
+    static void failed(LockKind kind) {
+        LockSite::Counters::add(LockProfile::getCurrentSite().getCounters(kind).failures, 1);
+    }
+
+private:
+    LockSite::Counters& counters;
+    std::size_t spins = 0;
+    std::chrono::steady_clock::time_point start{};
+#else
+    explicit LockAcquisition(LockKind) {}
+    void wait() {}
+    static void acquired(LockKind) {}
+    static void failed(LockKind) {}
+#endif
+
+public:
+    LockAcquisition(const LockAcquisition&) = delete;
+    LockAcquisition& operator=(const LockAcquisition&) = delete;
+};
+
+/** Take a mutex, counting a contended acquisition as a single iteration of waiting */
+template <class Mutex>
+void lockMeasured(Mutex& mutex, LockKind kind) {
+#ifdef USE_LOCK_PROFILING
+    LockAcquisition acquisition(kind);
+    if (mutex.try_lock()) {
+        return;
+    }
+    acquisition.wait();
+#else
+    (void)kind;
+#endif
+    mutex.lock();
+}
+
+}  // namespace souffle
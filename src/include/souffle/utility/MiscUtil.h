@@ -71,6 +71,16 @@ inline unsigned long __builtin_ctzll(unsigned long long value) {
         return 64;
     }
 }
+
+inline unsigned long __builtin_clzll(unsigned long long value) {
+    unsigned long msb = 0;
+
+    if (_BitScanReverse64(&msb, value)) {
+        return 63 - msb;
+    } else {
+        return 64;
+    }
+}
 #endif  // _MSC_VER
 #endif  // _WIN32
 
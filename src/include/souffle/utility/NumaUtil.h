@@ -0,0 +1,104 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NumaUtil.h
+ *
+ * The NUMA nodes of the machine and of the processors the threads run on.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace souffle {
+
+/**
+ * The NUMA nodes of the processors of the machine, as listed by sysfs on Linux. Other systems, and
+ * machines without NUMA, are treated as a single node.
+ */
+class NumaTopology {
+public:
+    /** Return the topology of the machine, read once */
+    static const NumaTopology& instance() {
+        static const NumaTopology topology;
+        return topology;
+    }
+
+    /** Return the number of nodes, numbered from 0 in the order of their identifiers */
+    std::size_t getNumNodes() const {
+        return numNodes;
+    }
+
+    /** Return the node of the processor the calling thread runs on */
+    std::size_t getCurrentNode() const {
+#ifdef __linux__
+        const int cpu = sched_getcpu();
+        if (cpu >= 0 && static_cast<std::size_t>(cpu) < nodeOfCpu.size()) {
+            return nodeOfCpu[cpu];
+        }
+#endif
+        return 0;
+    }
+
+private:
+    NumaTopology() {
+#ifdef __linux__
+        std::size_t node = 0;
+        for (int id : readList("/sys/devices/system/node/online")) {
+            for (int cpu : readList("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist")) {
+                if (nodeOfCpu.size() <= static_cast<std::size_t>(cpu)) {
+                    nodeOfCpu.resize(cpu + 1, 0);
+                }
+                nodeOfCpu[cpu] = node;
+            }
+            ++node;
+        }
+        numNodes = std::max<std::size_t>(node, 1);
+#endif
+    }
+
+    /** Read a list of ranges of numbers, e.g., `0-3,8-11`, or an empty list if the file is missing */
+    static std::vector<int> readList(const std::string& path) {
+        std::vector<int> res;
+        std::ifstream in(path);
+        std::string range;
+        while (std::getline(in, range, ',')) {
+            int first = 0;
+            int last = 0;
+            char dash = 0;
+            std::stringstream ss(range);
+            if (!(ss >> first)) {
+                continue;
+            }
+            last = (ss >> dash >> last) && dash == '-' ? last : first;
+            for (int i = first; i <= last; ++i) {
+                res.push_back(i);
+            }
+        }
+        return res;
+    }
+
+    std::size_t numNodes = 1;
+
+    // the node of each processor
+    std::vector<std::size_t> nodeOfCpu;
+};
+
+}  // namespace souffle
@@ -13,15 +13,25 @@
  * A set of utilities abstracting from the underlying parallel library.
  * Currently supported APIs: OpenMP and Cilk
  *
+ * Builds defining USE_LOCK_PROFILING count the acquisitions, the failed
+ * validations, the spins and the waiting time of the locks, see
+ * LockProfile.h.
+ *
  ***********************************************************************/
 
 #pragma once
 
+#include "souffle/utility/LockProfile.h"
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <deque>
 #include <memory>
 #include <new>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // https://bugs.llvm.org/show_bug.cgi?id=41423
 #if defined(__cpp_lib_hardware_interference_size) && (__cpp_lib_hardware_interference_size != 201703L)
@@ -54,6 +64,10 @@ constexpr std::size_t hardware_destructive_interference_size = 2 * sizeof(max_al
 #define PARALLEL_START _Pragma("omp parallel") {
 #define PARALLEL_END }
 
+// support for a parallel region of at most N threads
+#define SOUFFLE_PRAGMA(x) _Pragma(#x)
+#define PARALLEL_START_THREADS(N) SOUFFLE_PRAGMA(omp parallel num_threads(N)) {
+
 // support for parallel loops
 #define pfor _Pragma("omp for schedule(dynamic)") for
 
@@ -73,6 +87,13 @@ constexpr std::size_t hardware_destructive_interference_size = 2 * sizeof(max_al
 #define SECTION_START {
 #define SECTION_END }
 
+// sections of independent subroutines (e.g. strata) that run concurrently; loops inside a
+// section are not parallelised further unless nested parallelism is enabled, see NestedParallelism
+#define PARALLEL_SECTIONS_START _Pragma("omp parallel sections") {
+#define PARALLEL_SECTIONS_END }
+#define PARALLEL_SECTION_START _Pragma("omp section") {
+#define PARALLEL_SECTION_END }
+
 // a macro to create an operation context
 #define CREATE_OP_CONTEXT(NAME, INIT) [[maybe_unused]] auto NAME = INIT;
 #define READ_OP_CONTEXT(NAME) NAME
@@ -82,6 +103,7 @@ constexpr std::size_t hardware_destructive_interference_size = 2 * sizeof(max_al
 // support for a parallel region => sequential execution
 #define PARALLEL_START {
 #define PARALLEL_END }
+#define PARALLEL_START_THREADS(N) {
 
 // support for parallel loops => simple sequential loop
 #define pfor for
@@ -98,6 +120,12 @@ constexpr std::size_t hardware_destructive_interference_size = 2 * sizeof(max_al
 #define SECTION_START {
 #define SECTION_END }
 
+// parallel sections are processed sequentially
+#define PARALLEL_SECTIONS_START {
+#define PARALLEL_SECTIONS_END }
+#define PARALLEL_SECTION_START {
+#define PARALLEL_SECTION_END }
+
 // a macro to create an operation context
 #define CREATE_OP_CONTEXT(NAME, INIT) [[maybe_unused]] auto NAME = INIT;
 #define READ_OP_CONTEXT(NAME) NAME
@@ -182,7 +210,7 @@ class Lock {
 public:
     struct Lease {
         Lease(std::mutex& mux) : mux(&mux) {
-            mux.lock();
+            lockMeasured(mux, LockKind::Mutex);
         }
         Lease(Lease&& other) : mux(other.mux) {
             other.mux = nullptr;
@@ -204,7 +232,7 @@ public:
     }
 
     void lock() {
-        mux.lock();
+        lockMeasured(mux, LockKind::Mutex);
     }
 
     bool try_lock() {
@@ -260,20 +288,32 @@ public:
     SpinLock() = default;
 
     void lock() {
+        LockAcquisition acquisition(LockKind::SpinLock);
         detail::Waiter wait;
-        while (!try_lock()) {
+        while (!try_acquire()) {
+            acquisition.wait();
             wait();
         }
     }
 
     bool try_lock() {
-        int should = 0;
-        return lck.compare_exchange_weak(should, 1, std::memory_order_acquire);
+        if (!try_acquire()) {
+            LockAcquisition::failed(LockKind::SpinLock);
+            return false;
+        }
+        LockAcquisition::acquired(LockKind::SpinLock);
+        return true;
     }
 
     void unlock() {
         lck.store(0, std::memory_order_release);
     }
+
+private:
+    bool try_acquire() {
+        int should = 0;
+        return lck.compare_exchange_weak(should, 1, std::memory_order_acquire);
+    }
 };
 
 /**
@@ -299,6 +339,8 @@ public:
     ReadWriteLock() = default;
 
     void start_read() {
+        LockAcquisition acquisition(LockKind::ReadWriteLock);
+
         // add reader
         auto r = lck.fetch_add(4, std::memory_order_acquire);
 
@@ -309,6 +351,7 @@ public:
             end_read();
 
             // wait a bit
+            acquisition.wait();
             wait();
 
             // apply as a reader again
@@ -322,11 +365,13 @@ public:
     }
 
     void start_write() {
+        LockAcquisition acquisition(LockKind::ReadWriteLock);
         detail::Waiter wait;
 
         // set wait-for-write bit
         auto stat = lck.fetch_or(2, std::memory_order_acquire);
         while (stat & 0x2) {
+            acquisition.wait();
             wait();
             stat = lck.fetch_or(2, std::memory_order_acquire);
         }
@@ -335,6 +380,7 @@ public:
         int should = 2;
         while (!lck.compare_exchange_strong(
                 should, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            acquisition.wait();
             wait();
             should = 2;
         }
@@ -342,7 +388,14 @@ public:
 
     bool try_write() {
         int should = 0;
-        return lck.compare_exchange_strong(should, 1, std::memory_order_acquire, std::memory_order_relaxed);
+        const bool res =
+                lck.compare_exchange_strong(should, 1, std::memory_order_acquire, std::memory_order_relaxed);
+        if (res) {
+            LockAcquisition::acquired(LockKind::ReadWriteLock);
+        } else {
+            LockAcquisition::failed(LockKind::ReadWriteLock);
+        }
+        return res;
     }
 
     void end_write() {
@@ -351,7 +404,12 @@ public:
 
     bool try_upgrade_to_write() {
         int should = 4;
-        return lck.compare_exchange_strong(should, 1, std::memory_order_acquire, std::memory_order_relaxed);
+        const bool res =
+                lck.compare_exchange_strong(should, 1, std::memory_order_acquire, std::memory_order_relaxed);
+        if (!res) {
+            LockAcquisition::failed(LockKind::ReadWriteLock);
+        }
+        return res;
     }
 
     void downgrade_to_read() {
@@ -400,6 +458,7 @@ public:
      * concurrent modifications took place.
      */
     Lease start_read() {
+        LockAcquisition acquisition(LockKind::OptimisticReadWriteLock);
         detail::Waiter wait;
 
         // get a snapshot of the lease version
@@ -408,6 +467,7 @@ public:
         // spin while there is a write in progress
         while ((v & 0x1) == 1) {
             // wait for a moment
+            acquisition.wait();
             wait();
             // get an updated version
             v = version.load(std::memory_order_acquire);
@@ -426,7 +486,11 @@ public:
     bool validate(const Lease& lease) {
         // check whether version number has changed in the mean-while
         std::atomic_thread_fence(std::memory_order_acquire);
-        return lease.version == version.load(std::memory_order_relaxed);
+        if (lease.version != version.load(std::memory_order_relaxed)) {
+            LockAcquisition::failed(LockKind::OptimisticReadWriteLock);
+            return false;
+        }
+        return true;
     }
 
     /**
@@ -445,6 +509,7 @@ public:
      * and invalidating any existing read lease.
      */
     void start_write() {
+        LockAcquisition acquisition(LockKind::OptimisticReadWriteLock);
         detail::Waiter wait;
 
         // set last bit => make it odd
@@ -453,6 +518,7 @@ public:
         // check for concurrent writes
         while ((v & 0x1) == 1) {
             // wait for a moment
+            acquisition.wait();
             wait();
             // get an updated version
             v = version.fetch_or(0x1, std::memory_order_acquire);
@@ -469,7 +535,12 @@ public:
      */
     bool try_start_write() {
         auto v = version.fetch_or(0x1, std::memory_order_acquire);
-        return !(v & 0x1);
+        if (v & 0x1) {
+            LockAcquisition::failed(LockKind::OptimisticReadWriteLock);
+            return false;
+        }
+        LockAcquisition::acquired(LockKind::OptimisticReadWriteLock);
+        return true;
     }
 
     /**
@@ -484,13 +555,18 @@ public:
         auto v = version.fetch_or(0x1, std::memory_order_acquire);
 
         // check whether write privileges have been gained
-        if (v & 0x1) return false;  // there is another writer already
+        if (v & 0x1) {
+            // there is another writer already
+            LockAcquisition::failed(LockKind::OptimisticReadWriteLock);
+            return false;
+        }
 
         // check whether there was no write since the gain of the read lock
         if (lease.version == v) return true;
 
         // if there was, undo write update
         abort_write();
+        LockAcquisition::failed(LockKind::OptimisticReadWriteLock);
 
         // operation failed
         return false;
@@ -562,13 +638,14 @@ struct MutexConcurrentLanes {
     }
 
     unique_lock_type guard(const lane_id Lane) const {
-        return unique_lock_type(Lanes[Lane].Access);
+        lockMeasured(Lanes[Lane].Access, LockKind::Lanes);
+        return unique_lock_type(Lanes[Lane].Access, std::adopt_lock);
     }
 
     // Lock the given lane.
     // Must eventually be followed by unlock(Lane).
     void lock(const lane_id Lane) const {
-        Lanes[Lane].Access.lock();
+        lockMeasured(Lanes[Lane].Access, LockKind::Lanes);
     }
 
     // Unlock the given lane.
@@ -588,8 +665,10 @@ struct MutexConcurrentLanes {
             // So we release our lane lock to let the concurrent operation
             // progress.
             unlock(Lane);
-            BeforeLockAll.lock();
+            lockMeasured(BeforeLockAll, LockKind::Lanes);
             lock(Lane);
+        } else {
+            LockAcquisition::acquired(LockKind::Lanes);
         }
     }
 
@@ -609,7 +688,7 @@ struct MutexConcurrentLanes {
     void lockAllBut(const lane_id Lane) const {
         for (std::size_t I = 0; I < Size; ++I) {
             if (I != Lane) {
-                Lanes[I].Access.lock();
+                lockMeasured(Lanes[I].Access, LockKind::Lanes);
             }
         }
     }
@@ -855,6 +934,257 @@ struct ConcurrentLanes : protected SeqConcurrentLanes {
 
 #endif
 
+/**
+ * Sorts the given random-access range utilizing all available threads.
+ *
+ * The range is split into one slice per thread, the slices are sorted
+ * concurrently and then merged pairwise.
+ */
+template <typename Iter, typename Compare>
+void parallelSort(Iter begin, Iter end, Compare comp) {
+    const auto length = static_cast<std::size_t>(end - begin);
+    const std::size_t slices = std::min(static_cast<std::size_t>(MAX_THREADS), length / 4096 + 1);
+    if (slices <= 1) {
+        std::sort(begin, end, comp);
+        return;
+    }
+
+    std::vector<std::size_t> bounds(slices + 1);
+    for (std::size_t i = 0; i <= slices; ++i) {
+        bounds[i] = length * i / slices;
+    }
+
+    PARALLEL_START
+    pfor(std::size_t i = 0; i < slices; ++i) {
+        std::sort(begin + bounds[i], begin + bounds[i + 1], comp);
+    }
+    PARALLEL_END
+
+    for (std::size_t width = 1; width < slices; width *= 2) {
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < slices - width; i += 2 * width) {
+            std::inplace_merge(begin + bounds[i], begin + bounds[i + width],
+                    begin + bounds[std::min(i + 2 * width, slices)], comp);
+        }
+        PARALLEL_END
+    }
+}
+
+/**
+ * Minimal number of tuples of a relation per thread of a parallel operation on the relation; smaller
+ * relations are processed by fewer threads, as forking and joining would outweigh the work.
+ */
+constexpr std::size_t MIN_TUPLES_PER_THREAD = 1024;
+
+/**
+ * Returns the number of threads of a parallel operation on a relation of the given size, or the given
+ * number of threads if it is not zero.
+ */
+inline std::size_t parallel_threads(std::size_t size, std::size_t threads = 0) {
+    if (threads > 0) {
+        return threads;
+    }
+    return std::min(static_cast<std::size_t>(MAX_THREADS), size / MIN_TUPLES_PER_THREAD + 1);
+}
+
+/**
+ * Allows the threads of a parallel region to start parallel regions of their own while in scope, and
+ * divides the given number of threads among the tasks of the region, e.g. strata evaluated concurrently.
+ * Otherwise the parallel operations of each task would run on the thread of the task alone.
+ */
+class NestedParallelism {
+public:
+    NestedParallelism(std::size_t threads, std::size_t tasks)
+            : threads(std::max<std::size_t>(threads, 1)),
+              tasks(std::max<std::size_t>(std::min(threads, tasks), 1)) {
+#ifdef _OPENMP
+        levels = omp_get_max_active_levels();
+        omp_set_max_active_levels(std::max(levels, 2));
+#endif
+    }
+
+    NestedParallelism(const NestedParallelism&) = delete;
+    NestedParallelism& operator=(const NestedParallelism&) = delete;
+
+    ~NestedParallelism() {
+#ifdef _OPENMP
+        omp_set_max_active_levels(levels);
+#endif
+    }
+
+    /** Limit the parallel regions started by the calling thread to the share of the given task */
+    void budget([[maybe_unused]] std::size_t task) const {
+#ifdef _OPENMP
+        const std::size_t share = threads / tasks + (task % tasks < threads % tasks ? 1 : 0);
+        omp_set_num_threads(static_cast<int>(share));
+#endif
+    }
+
+private:
+    std::size_t threads;
+    std::size_t tasks;
+    [[maybe_unused]] int levels = 1;
+};
+
+/**
+ * Returns whether the threads of a parallel operation over the given number of tuples collect the
+ * tuples they insert into a relation of the given size, rather than inserting them directly. The
+ * threads inserting into a relation that is small compared to their output contend for the same
+ * nodes, and split them over and over, whereas the collected tuples are merged in one pass.
+ */
+inline bool deferInserts(std::size_t threads, std::size_t scanned, std::size_t target) {
+    return threads > 1 && target <= scanned;
+}
+
+/**
+ * Merges the sorted runs of tuples collected by the threads of a parallel operation, and passes the
+ * distinct tuples in consecutive chunks to the given insertion. The runs are merged pairwise, and the
+ * chunks are inserted by concurrent threads, each into the region of the target of its range of
+ * tuples. The runs are emptied.
+ */
+template <typename T, typename Insert>
+void mergeRuns(std::vector<std::vector<T>>& runs, Insert&& insert) {
+    std::vector<std::size_t> bounds{0};
+    for (const auto& run : runs) {
+        bounds.push_back(bounds.back() + run.size());
+    }
+    if (bounds.back() == 0) {
+        return;
+    }
+    std::vector<T> merged;
+    merged.reserve(bounds.back());
+    for (auto& run : runs) {
+        merged.insert(merged.end(), run.begin(), run.end());
+        run.clear();
+    }
+
+    const std::size_t count = runs.size();
+    for (std::size_t width = 1; width < count; width *= 2) {
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < count - width; i += 2 * width) {
+            std::inplace_merge(merged.begin() + bounds[i], merged.begin() + bounds[i + width],
+                    merged.begin() + bounds[std::min(i + 2 * width, count)]);
+        }
+        PARALLEL_END
+    }
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+    const std::size_t chunks = parallel_threads(merged.size());
+    PARALLEL_START
+    pfor(std::size_t i = 0; i < chunks; ++i) {
+        const auto begin = merged.begin();
+        insert(begin + merged.size() * i / chunks, begin + merged.size() * (i + 1) / chunks);
+    }
+    PARALLEL_END
+}
+
+/**
+ * Queues of the items processed by a team of threads, where processing an item may produce further
+ * items, e.g. the worklist of a fixpoint computation. Each thread queues the items it produces in a
+ * queue of its own and takes the latest of them first; a thread whose queue is empty takes the oldest
+ * item of another queue. The items are exhausted once none is queued nor being processed. Since the
+ * items produced by an item are queued before the item is done, the threads only wait for each other
+ * when there is no item left to take.
+ */
+template <typename T>
+class WorkQueues {
+public:
+    explicit WorkQueues(std::size_t threads) : queues(std::max<std::size_t>(threads, 1)) {}
+
+    /** Queues an item in the queue of the given thread */
+    void push(std::size_t thread, T item) {
+        ++pending;
+        Queue& queue = queues[thread];
+        queue.lock.lock();
+        queue.items.push_back(std::move(item));
+        queue.lock.unlock();
+    }
+
+    /**
+     * Takes an item for the given thread, which marks it as done once it has queued the items produced
+     * by it. Returns false once all items are done, or the processing was stopped.
+     */
+    bool pop(std::size_t thread, T& item) {
+        while (!stopped) {
+            for (std::size_t i = 0; i < queues.size(); ++i) {
+                const std::size_t owner = (thread + i) % queues.size();
+                if (take(queues[owner], owner == thread, item)) {
+                    return true;
+                }
+            }
+            if (pending == 0) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    /** Marks an item taken by a thread as done */
+    void done() {
+        --pending;
+    }
+
+    /** Stops the processing, such that the threads take no further items */
+    void stop() {
+        stopped = true;
+    }
+
+private:
+    struct Queue {
+        alignas(hardware_destructive_interference_size) Lock lock;
+        std::deque<T> items;
+    };
+
+    /** Takes the latest item of the queue of the thread, or the oldest item of the queue of another */
+    static bool take(Queue& queue, bool own, T& item) {
+        queue.lock.lock();
+        const bool found = !queue.items.empty();
+        if (found && own) {
+            item = std::move(queue.items.back());
+            queue.items.pop_back();
+        } else if (found) {
+            item = std::move(queue.items.front());
+            queue.items.pop_front();
+        }
+        queue.lock.unlock();
+        return found;
+    }
+
+    std::vector<Queue> queues;
+    /** Number of items queued or being processed */
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool> stopped{false};
+};
+
+/**
+ * Binds the threads of the thread pool to the processors available to the process, spreading them
+ * evenly. The pool keeps its threads, hence each thread stays on its NUMA node, where the memory
+ * it touches first, e.g. the b-tree nodes it inserts, is allocated.
+ */
+inline void pin_threads() {
+#if defined(_OPENMP) && defined(__linux__)
+    cpu_set_t available;
+    if (sched_getaffinity(0, sizeof(available), &available) != 0) {
+        return;
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &available)) {
+            cpus.push_back(cpu);
+        }
+    }
+    PARALLEL_START
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+        const auto threads = static_cast<std::size_t>(omp_get_num_threads());
+        cpu_set_t cpu;
+        CPU_ZERO(&cpu);
+        CPU_SET(cpus[thread * cpus.size() / threads], &cpu);
+        sched_setaffinity(0, sizeof(cpu), &cpu);
+    PARALLEL_END
+#endif
+}
+
 /**
  * Obtains a reference to the lock synchronizing output operations.
  */
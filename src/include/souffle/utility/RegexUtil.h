@@ -0,0 +1,66 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RegexUtil.h
+ *
+ * Defines the compiled regular expressions of the match constraints, used
+ * by synthesised and interpreter code.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <regex>
+#include <string>
+#include <unordered_map>
+
+namespace souffle::evaluator {
+
+/** A compiled regular expression, or none if its pattern is malformed */
+using CompiledRegex = std::optional<std::regex>;
+
+/** The number of patterns cached per thread, beyond which the cache is cleared */
+constexpr std::size_t REGEX_CACHE_SIZE = 1024;
+
+/**
+ * Compiles the given pattern for repeated matching.
+ */
+inline CompiledRegex compileRegex(const std::string& pattern) {
+    try {
+        return std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+/**
+ * Obtains the compiled regular expression of the given pattern.
+ *
+ * Compiling a pattern costs far more than matching it, and the patterns of a
+ * program are usually few, hence they are compiled once per thread and kept
+ * in a cache of the thread, which needs no synchronisation. The result is
+ * valid until the next call of the thread.
+ */
+inline const CompiledRegex& getCachedRegex(const std::string& pattern) {
+    static thread_local std::unordered_map<std::string, CompiledRegex> cache;
+    auto pos = cache.find(pattern);
+    if (pos != cache.end()) {
+        return pos->second;
+    }
+    // patterns computed at runtime may be unbounded in number
+    if (cache.size() >= REGEX_CACHE_SIZE) {
+        cache.clear();
+    }
+    return cache.emplace(pattern, compileRegex(pattern)).first->second;
+}
+
+}  // namespace souffle::evaluator
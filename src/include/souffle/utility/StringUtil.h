@@ -445,10 +445,18 @@ inline std::string escape(
 }
 
 inline std::string escape(const std::string& inputString) {
-    std::string escaped = escape(inputString, "\"", "\\\"");
-    escaped = escape(escaped, "\t", "\\t");
-    escaped = escape(escaped, "\r", "\\r");
-    escaped = escape(escaped, "\n", "\\n");
+    // a single pass, since the directives of facts given inline may be large
+    std::string escaped;
+    escaped.reserve(inputString.size());
+    for (char c : inputString) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\t': escaped += "\\t"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\n': escaped += "\\n"; break;
+            default: escaped += c;
+        }
+    }
     return escaped;
 }
 
@@ -21,13 +21,23 @@
 
 namespace souffle::interpreter {
 
-#define CREATE_BTREE_DELETE_REL(Structure, Arity, ...)                                               \
-    case (Arity): {                                                                                  \
-        return mk<BtreeDeleteRelation<Arity>>(id.getAuxiliaryArity(), id.getName(), indexSelection); \
+#define CREATE_BTREE_DELETE_REL(Structure, Arity, ...)                                                   \
+    case (Arity): {                                                                                      \
+        auto rel = mk<BtreeDeleteRelation<Arity>>(id.getAuxiliaryArity(), id.getName(), indexSelection); \
+        if (id.isLattice()) {                                                                            \
+            rel->setLattice(id.getLatticeOp(), indexSelection.getLexOrderNum(latticeKey));               \
+        }                                                                                                \
+        return rel;                                                                                      \
     }
 
 Own<RelationWrapper> createBTreeDeleteRelation(
         const ram::Relation& id, const ram::analysis::IndexCluster& indexSelection) {
+    // lattice relations search their key, i.e., all attributes but the last, on insertion
+    ram::analysis::SearchSignature latticeKey(id.getArity());
+    for (std::size_t i = 0; i + 1 < id.getArity(); ++i) {
+        latticeKey[i] = ram::analysis::AttributeConstraint::Equal;
+    }
+
     switch (id.getArity()) {
         FOR_EACH_BTREE_DELETE(CREATE_BTREE_DELETE_REL);
 
@@ -36,4 +36,10 @@ Own<RelationWrapper> createBTreeRelation(
     }
 }
 
+Own<RelationWrapper> createDynamicRelation(
+        const ram::Relation& id, const ram::analysis::IndexCluster& indexSelection) {
+    return mk<Relation<Dynamic, interpreter::Btree>>(
+            id.getArity(), id.getAuxiliaryArity(), id.getName(), indexSelection);
+}
+
 }  // namespace souffle::interpreter
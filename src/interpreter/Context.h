@@ -19,6 +19,7 @@
 #include "interpreter/Index.h"
 #include "interpreter/Relation.h"
 #include "souffle/RamTypes.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <memory>
@@ -52,6 +53,12 @@ public:
         return data[index];
     }
 
+    /** @brief Return a tuple bound before, without the bounds check of the binding */
+    const RamDomain* getTuple(std::size_t index) const {
+        assert(index < data.size() && "tuple not bound");
+        return data[index];
+    }
+
     /** @brief Allocate a tuple.
      *  allocatedDataContainer has the ownership of those tuples. */
     RamDomain* allocateNewTuple(std::size_t size) {
@@ -94,22 +101,101 @@ public:
         return (*args)[i];
     }
 
-    /** @brief Create a view in the environment */
+    /**
+     * @brief Create a view in the environment
+     *
+     * The view of a previous execution of the query is reused, with its hints, if it is on the
+     * same index. Each slot also keeps the view of the relation it was on before, since the
+     * relations of a fixpoint loop are swapped in every iteration.
+     */
     void createView(const RelationWrapper& rel, std::size_t indexPos, std::size_t viewPos) {
-        ViewPtr view;
         if (views.size() < viewPos + 1) {
             views.resize(viewPos + 1);
+            previousViews.resize(viewPos + 1);
+        }
+        ViewSlot& slot = views[viewPos];
+        if (slot.reuse(rel, indexPos)) {
+            return;
+        }
+        std::swap(slot, previousViews[viewPos]);
+        if (slot.reuse(rel, indexPos)) {
+            return;
         }
-        views[viewPos] = rel.createView(indexPos);
+        slot = {&rel, indexPos, rel.createView(indexPos)};
     }
 
     /** @brief Return a view */
     ViewWrapper* getView(std::size_t id) {
         assert(id < views.size());
-        return views[id].get();
+        return views[id].view.get();
+    }
+
+    /**
+     * @brief Make sure that contexts for the given number of threads exist
+     *
+     * Must be called before the threads of a parallel operation are started.
+     */
+    void reserveThreadContexts(std::size_t threads) {
+        while (threadContexts.size() < std::max<std::size_t>(threads, 1)) {
+            threadContexts.push_back(mk<Context>());
+        }
+    }
+
+    /**
+     * @brief Return the context of a thread of a parallel operation
+     *
+     * The contexts are retained across parallel operations, such that their views and the hints
+     * of these views are reused. Only the subroutine values of this context are passed on.
+     */
+    Context& getThreadContext(std::size_t thread) {
+        assert(thread < threadContexts.size() && "thread contexts not reserved");
+        Context& res = *threadContexts[thread];
+        res.returnValues = returnValues;
+        res.args = args;
+        res.allocatedDataContainer.clear();
+        return res;
+    }
+
+    /**
+     * @brief Collect the tuples of the given deferred insertion in a buffer of this context, rather
+     * than inserting them into their relation
+     */
+    void deferInserts(std::size_t id) {
+        if (insertBuffers.size() < id + 1) {
+            insertBuffers.resize(id + 1);
+        }
+        insertBuffers[id].active = true;
+    }
+
+    /**
+     * @brief Return the buffer collecting the tuples of the given deferred insertion, or nullptr if
+     * the insertion inserts its tuples directly
+     */
+    std::vector<RamDomain>* getInsertBuffer(std::size_t id) {
+        if (id >= insertBuffers.size() || !insertBuffers[id].active) {
+            return nullptr;
+        }
+        return &insertBuffers[id].tuples;
+    }
+
+    /** @brief Let the given deferred insertion insert its tuples directly again, dropping its buffer */
+    void resetInsertBuffer(std::size_t id) {
+        insertBuffers[id].active = false;
+        insertBuffers[id].tuples.clear();
     }
 
 private:
+    /** A view together with the index it is on */
+    struct ViewSlot {
+        const RelationWrapper* rel = nullptr;
+        std::size_t indexPos = 0;
+        ViewPtr view;
+
+        bool reuse(const RelationWrapper& r, std::size_t pos) const {
+            return rel == &r && indexPos == pos && r.reuseView(*view, pos);
+        }
+    };
+
     /** @brief Run-time value */
     std::vector<const RamDomain*> data;
     /** @brief Subroutine return value */
@@ -119,7 +205,17 @@ private:
     /** @bref Allocated data */
     VecOwn<RamDomain[]> allocatedDataContainer;
     /** @brief Views */
-    VecOwn<ViewWrapper> views;
+    std::vector<ViewSlot> views;
+    /** @brief Views on the relations the view slots were on before */
+    std::vector<ViewSlot> previousViews;
+    /** @brief Contexts of the threads of parallel operations */
+    VecOwn<Context> threadContexts;
+    /** @brief Buffers of the tuples of deferred insertions, by insertion */
+    struct InsertBuffer {
+        bool active = false;
+        std::vector<RamDomain> tuples;
+    };
+    std::vector<InsertBuffer> insertBuffers;
 };
 
 }  // namespace souffle::interpreter
@@ -0,0 +1,84 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file EmbeddedProgram.cpp
+ *
+ * Define the EmbeddedProgram class.
+ ***********************************************************************/
+
+#include "interpreter/EmbeddedProgram.h"
+#include "Global.h"
+#include "Pipelines.h"
+#include "ast/Program.h"
+#include "ast/transform/PragmaChecker.h"
+#include "ast2ram/TranslationStrategy.h"
+#include "ast2ram/UnitTranslator.h"
+#include "ast2ram/provenance/TranslationStrategy.h"
+#include "ast2ram/seminaive/TranslationStrategy.h"
+#include "ast2ram/utility/TranslatorContext.h"
+#include "parser/ParserDriver.h"
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+namespace souffle::interpreter {
+
+Own<EmbeddedProgram> EmbeddedProgram::fromFile(const std::string& filename) {
+    auto state = makeState();
+    FILE* in = std::fopen(filename.c_str(), "r");
+    if (in == nullptr) {
+        throw std::runtime_error("Cannot open program " + filename);
+    }
+    auto unit = ParserDriver::parseTranslationUnit(filename, in, *state.errReport, *state.debugReport);
+    std::fclose(in);
+    return build(std::move(state), std::move(unit));
+}
+
+Own<EmbeddedProgram> EmbeddedProgram::fromSource(const std::string& source) {
+    auto state = makeState();
+    auto unit = ParserDriver::parseTranslationUnit(source, *state.errReport, *state.debugReport);
+    return build(std::move(state), std::move(unit));
+}
+
+detail::EmbeddedProgramState EmbeddedProgram::makeState() {
+    detail::EmbeddedProgramState state;
+    state.errReport = mk<ErrorReport>(Global::config().has("no-warn"));
+    // a program with errors must not end the process loading it
+    state.errReport->setThrowing(true);
+    state.debugReport = mk<DebugReport>();
+    return state;
+}
+
+Own<EmbeddedProgram> EmbeddedProgram::build(
+        detail::EmbeddedProgramState state, Own<ast::TranslationUnit> unit) {
+    state.errReport->exitIfErrors();
+
+    // the options souffle defaults to, and the incremental evaluation of the runs after the first
+    if (!Global::config().has("jobs")) {
+        Global::config().set("jobs", "1");
+    }
+    Global::config().set("incremental");
+
+    mk<ast::transform::PragmaChecker>()->apply(*unit);
+    makeAstTransformer()->apply(*unit);
+
+    auto translationStrategy =
+            Global::config().has("provenance")
+                    ? mk<ast2ram::TranslationStrategy, ast2ram::provenance::TranslationStrategy>()
+                    : mk<ast2ram::TranslationStrategy, ast2ram::seminaive::TranslationStrategy>();
+    auto unitTranslator = Own<ast2ram::UnitTranslator>(translationStrategy->createUnitTranslator());
+    state.ramTranslationUnit = unitTranslator->translateUnit(*unit);
+    makeRamTransformer()->apply(*state.ramTranslationUnit);
+
+    state.interpreter = mk<Engine>(*state.ramTranslationUnit);
+    return Own<EmbeddedProgram>(new EmbeddedProgram(std::move(state)));
+}
+
+}  // namespace souffle::interpreter
@@ -0,0 +1,74 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file EmbeddedProgram.h
+ *
+ * Declares the EmbeddedProgram class, a program loaded from its Datalog
+ * source at runtime and evaluated by the interpreter.
+ ***********************************************************************/
+
+#pragma once
+
+#include "ast/TranslationUnit.h"
+#include "interpreter/Engine.h"
+#include "interpreter/ProgInterface.h"
+#include "ram/TranslationUnit.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/utility/MiscUtil.h"
+#include <string>
+#include <utility>
+
+namespace souffle::interpreter {
+
+namespace detail {
+/** The translated program and the engine evaluating it, which outlive the interface to them */
+struct EmbeddedProgramState {
+    Own<ErrorReport> errReport;
+    Own<DebugReport> debugReport;
+    Own<ram::TranslationUnit> ramTranslationUnit;
+    Own<Engine> interpreter;
+};
+}  // namespace detail
+
+/**
+ * @class EmbeddedProgram
+ * @brief A program loaded at runtime, evaluated by the interpreter as often as needed
+ *
+ * The program is parsed, transformed and translated once, as by souffle itself; the RAM program,
+ * the tree of interpreter nodes generated from it and the relations stay alive between runs. The
+ * program is evaluated incrementally: the first run reads the inputs of the program, and the
+ * following runs only re-evaluate the strata depending on the relations changed through the
+ * interface since, e.g. by purging an input and inserting new facts into it.
+ *
+ * The options of the evaluation, e.g. `jobs`, `fact-dir` and `output-dir`, are taken from the
+ * global configuration, with a single thread unless given. Errors in the program are thrown as
+ * std::runtime_error. The copies made by clone() must not outlive the program.
+ */
+class EmbeddedProgram : private detail::EmbeddedProgramState, public ProgInterface {
+public:
+    /** Load the program of the given file, which is not pre-processed */
+    static Own<EmbeddedProgram> fromFile(const std::string& filename);
+
+    /** Load the program of the given source */
+    static Own<EmbeddedProgram> fromSource(const std::string& source);
+
+private:
+    explicit EmbeddedProgram(detail::EmbeddedProgramState state)
+            : detail::EmbeddedProgramState(std::move(state)), ProgInterface(*interpreter) {}
+
+    /** Create the reports of a program to be loaded */
+    static detail::EmbeddedProgramState makeState();
+
+    /** Transform and translate the parsed program, and set up the engine evaluating it */
+    static Own<EmbeddedProgram> build(detail::EmbeddedProgramState state, Own<ast::TranslationUnit> unit);
+};
+
+}  // namespace souffle::interpreter
@@ -21,11 +21,16 @@
 #include "interpreter/Index.h"
 #include "interpreter/Node.h"
 #include "interpreter/Relation.h"
+#include "interpreter/TableCompactor.h"
 #include "interpreter/ViewContext.h"
+#include "ram/AbstractExistenceCheck.h"
 #include "ram/Aggregate.h"
 #include "ram/AutoIncrement.h"
+#include "ram/BinRelationStatement.h"
+#include "ram/Branches.h"
 #include "ram/Break.h"
 #include "ram/Call.h"
+#include "ram/Checkpoint.h"
 #include "ram/Clear.h"
 #include "ram/Conjunction.h"
 #include "ram/Constraint.h"
@@ -36,10 +41,12 @@
 #include "ram/Exit.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Guard.h"
 #include "ram/IO.h"
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
+#include "ram/IndexIntersect.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
@@ -58,15 +65,18 @@
 #include "ram/ParallelIndexAggregate.h"
 #include "ram/ParallelIndexIfExists.h"
 #include "ram/ParallelIndexScan.h"
+#include "ram/ParallelNestedIntrinsicOperator.h"
 #include "ram/ParallelScan.h"
 #include "ram/Program.h"
 #include "ram/ProvenanceExistenceCheck.h"
 #include "ram/Query.h"
 #include "ram/Relation.h"
+#include "ram/RelationOperation.h"
 #include "ram/RelationSize.h"
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
 #include "ram/Statement.h"
+#include "ram/StratumCache.h"
 #include "ram/StringConstant.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -77,38 +87,56 @@
 #include "ram/TupleOperation.h"
 #include "ram/UnpackRecord.h"
 #include "ram/UserDefinedOperator.h"
+#include "ram/utility/Utils.h"
 #include "ram/utility/Visitor.h"
 #include "souffle/BinaryConstraintOps.h"
+#include "souffle/NativeStrata.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SignalHandler.h"
+#include "souffle/SouffleInterface.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/TypeAttribute.h"
+#include "souffle/datastructure/HyperLogLog.h"
+#include "souffle/datastructure/NodePool.h"
+#include "souffle/io/Checkpoint.h"
 #include "souffle/io/IOSystem.h"
 #include "souffle/io/ReadStream.h"
+#include "souffle/io/StratumCache.h"
 #include "souffle/io/WriteStream.h"
 #include "souffle/profile/Logger.h"
 #include "souffle/profile/ProfileEvent.h"
+#include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/EvaluatorUtil.h"
+#include "souffle/utility/FunctionalUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/RegexUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <deque>
+#include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <dlfcn.h>
@@ -123,22 +151,77 @@ namespace souffle::interpreter {
 #define dynamicLibSuffix ".so";
 #endif
 
-// Aliases for foreign function interface.
-#if RAM_DOMAIN_SIZE == 64
-#define FFI_RamSigned ffi_type_sint64
-#define FFI_RamUnsigned ffi_type_uint64
-#define FFI_RamFloat ffi_type_double
-#else
-#define FFI_RamSigned ffi_type_sint32
-#define FFI_RamUnsigned ffi_type_uint32
-#define FFI_RamFloat ffi_type_float
-#endif
-
-#define FFI_Symbol ffi_type_pointer
+/** A function of the library of native strata, typed as declared in souffle/NativeStrata.h */
+#define NATIVE_FUNCTION(name) reinterpret_cast<decltype(&name)>(getNativeFunction(#name))
 
 namespace {
 constexpr RamDomain RAM_BIT_SHIFT_MASK = RAM_DOMAIN_SIZE - 1;
 
+/**
+ * Number of partitions per thread of a parallel operation. Idle threads pick up the remaining
+ * partitions, so over-partitioning balances the load of skewed relations.
+ */
+constexpr std::size_t PARTITIONS_PER_THREAD = 64;
+
+/**
+ * Maximal number of tuples of the relation of a grouped aggregate per scanned tuple, for which the
+ * aggregate is computed for all groups in one pass over its relation. Beyond it, most groups of the
+ * relation are likely not scanned, and are aggregated per scanned tuple instead.
+ */
+constexpr std::size_t GROUPED_AGGREGATE_FANOUT = 8;
+
+/**
+ * Maximal number of tuples of a block of a worklist. The tuples derived from a block are split into
+ * blocks of their own, which idle threads take from the queue of the deriving thread.
+ */
+constexpr std::size_t WORKLIST_BLOCK_SIZE = 256;
+
+/** Tuples of a worklist, for which the rules driven by their delta relation are evaluated */
+struct WorklistBlock {
+    /** Position of the delta relation in the loop */
+    std::size_t delta = 0;
+    std::vector<RamDomain> tuples;
+};
+
+/**
+ * Call a user-defined functor taking and returning numbers of the domain directly, passing the
+ * leading arguments ahead of the given arity of numbers.
+ */
+template <typename... Leading>
+RamDomain callFunctor(void (*functor)(), std::size_t arity, const RamDomain* args, Leading... leading) {
+    using D = RamDomain;
+    switch (arity) {
+        case 0: return reinterpret_cast<D (*)(Leading...)>(functor)(leading...);
+        case 1: return reinterpret_cast<D (*)(Leading..., D)>(functor)(leading..., args[0]);
+        case 2: return reinterpret_cast<D (*)(Leading..., D, D)>(functor)(leading..., args[0], args[1]);
+        case 3:
+            return reinterpret_cast<D (*)(Leading..., D, D, D)>(functor)(
+                    leading..., args[0], args[1], args[2]);
+        case 4:
+            return reinterpret_cast<D (*)(Leading..., D, D, D, D)>(functor)(
+                    leading..., args[0], args[1], args[2], args[3]);
+    }
+    fatal("user-defined operator of %d arguments cannot be called directly", arity);
+}
+
+/** Return the number of the calling thread within its parallel region */
+std::size_t thread_number() {
+#ifdef _OPENMP
+    return static_cast<std::size_t>(omp_get_thread_num());
+#else
+    return 0;
+#endif
+}
+
+/** Return the number of threads of the parallel regions started by the calling thread */
+std::size_t thread_budget() {
+#ifdef _OPENMP
+    return static_cast<std::size_t>(omp_get_max_threads());
+#else
+    return 1;
+#endif
+}
+
 #ifdef _OPENMP
 std::size_t number_of_threads(const std::size_t user_specified) {
     if (user_specified > 0) {
@@ -159,10 +242,58 @@ std::size_t number_of_threads(const std::size_t) {
 Engine::Engine(ram::TranslationUnit& tUnit)
         : profileEnabled(Global::config().has("profile")),
           frequencyCounterEnabled(Global::config().has("profile-frequency")),
+          operatorProfileEnabled(
+                  Global::config().has("profile") && Global::config().has("profile-operators")),
           isProvenance(Global::config().has("provenance")),
-          numOfThreads(number_of_threads(std::stoi(Global::config().get("jobs")))), tUnit(tUnit),
-          isa(tUnit.getAnalysis<ram::analysis::IndexAnalysis>()), recordTable(numOfThreads),
-          symbolTable(numOfThreads) {}
+          incremental(Global::config().has("incremental")),
+          compactRelations(Global::config().has("compact-relations")),
+          bloomFilters(Global::config().has("bloom-filters") && !Global::config().has("provenance")),
+          memoryLimit(Global::config().has("memory-limit") ? std::stoull(Global::config().get("memory-limit"))
+                                                           : 0),
+          adaptiveJoinOrder(
+                  Global::config().has("adaptive-join-order") || Global::config().has("emit-plans")),
+          emitPlans(Global::config().has("emit-plans")),
+          asyncFixpoint(Global::config().has("async-fixpoint")),
+          ruleStatisticsEnabled(Global::config().has("verbose")),
+          numOfThreads(number_of_threads(std::stoi(Global::config().get("jobs")))),
+          counter(std::make_shared<BlockCounter>(Global::config().has("autoinc-block")
+                                                         ? std::stoi(Global::config().get("autoinc-block"))
+                                                         : 1)),
+          tUnit(tUnit), isa(tUnit.getAnalysis<ram::analysis::IndexAnalysis>()),
+          recordTable(std::make_shared<RecordTableImpl>(numOfThreads)),
+          symbolTable(std::make_shared<SymbolTable>(numOfThreads)) {
+    if (profileEnabled && Global::config().has("profile-sampling")) {
+        sampler = mk<ProfileSampler>(std::stoul(Global::config().get("profile-sampling")));
+    }
+    if (Global::config().has("native-library")) {
+        loadNativeStrata();
+    }
+    if (Global::config().has("only-relations")) {
+        for (const auto& name : splitString(Global::config().get("only-relations"), ',')) {
+            requestedRelations.insert(name);
+        }
+    }
+    if (Global::config().has("relation-threads")) {
+        for (const auto& entry : splitString(Global::config().get("relation-threads"), ',')) {
+            auto pos = entry.find('=');
+            // an entry without relation selects the number of threads of all relations
+            std::string relation = pos == std::string::npos ? "" : entry.substr(0, pos);
+            relationThreads.emplace(relation, std::stoul(entry.substr(pos + 1)));
+        }
+    }
+    if (Global::config().has("async-output") && !Global::config().has("native-library")) {
+        asyncOutput = mk<AsyncOutput>(std::stoul(Global::config().get("async-output")));
+    }
+    if (Global::config().has("pin-threads")) {
+        pin_threads();
+    }
+}
+
+Engine::~Engine() {
+    if (nativeProgram != nullptr) {
+        NATIVE_FUNCTION(souffle_native_destroy)(nativeProgram);
+    }
+}
 
 Engine::RelationHandle& Engine::getRelationHandle(const std::size_t idx) {
     return *relations[idx];
@@ -174,12 +305,171 @@ void Engine::swapRelation(const std::size_t ramRel1, const std::size_t ramRel2)
     std::swap(rel1, rel2);
 }
 
+bool Engine::isConcurrent(const ram::Parallel& parallel) const {
+    const auto stmts = parallel.getStatements();
+    if (numOfThreads == 1 || stmts.size() < 2) {
+        return false;
+    }
+    // the loads of distinct input relations are independent, and read their files concurrently
+    if (all_of(stmts, [](const ram::Statement* stmt) { return ram::isInputOnly(*stmt); })) {
+        return true;
+    }
+    // the strata called by a block are independent, but the profile, the rule statistics, the
+    // incremental evaluation, the memory limit, native strata and the stratum callback are maintained
+    // by one thread at a time
+    return all_of(stmts, [](const ram::Statement* stmt) { return isA<ram::Call>(stmt); }) &&
+           !profileEnabled && !ruleStatisticsEnabled && sampler == nullptr && !incremental &&
+           memoryLimit == 0 && nativeSubroutines.empty() && !stratumCallback;
+}
+
 int Engine::incCounter() {
-    return counter++;
+    return counter->next();
+}
+
+std::size_t Engine::getPartitionCount() const {
+    return numOfThreads == 1 ? 1 : numOfThreads * PARTITIONS_PER_THREAD;
+}
+
+std::size_t Engine::getThreadCount(const std::string& relation, std::size_t size) const {
+    if (numOfThreads == 1) {
+        return 1;
+    }
+    // auxiliary relations, e.g. @delta_path, are processed as their relation
+    std::string name = relation;
+    if (name[0] == '@') {
+        name = name.substr(name.find('_') + 1);
+    }
+    auto pos = relationThreads.find(name);
+    if (pos == relationThreads.end()) {
+        pos = relationThreads.find("");
+    }
+    const std::size_t threads = pos == relationThreads.end() ? 0 : pos->second;
+    // the statements of a parallel block share the threads
+    return std::min({numOfThreads, thread_budget(), parallel_threads(size, threads)});
+}
+
+void Engine::deferInserts(
+        const AbstractParallel& scan, std::size_t scanned, std::size_t threads, Context& ctxt) {
+    for (const Insert* insert : scan.getDeferrableInserts()) {
+        if (!souffle::deferInserts(threads, scanned, insert->getRelation()->size())) {
+            continue;
+        }
+        for (std::size_t i = 0; i < threads; ++i) {
+            ctxt.getThreadContext(i).deferInserts(*insert->getBufferId());
+        }
+    }
+}
+
+void Engine::mergeInsertBuffers(const AbstractParallel& scan, std::size_t threads, Context& ctxt) {
+    for (const Insert* insert : scan.getDeferrableInserts()) {
+        const std::size_t id = *insert->getBufferId();
+        std::vector<const std::vector<RamDomain>*> buffers;
+        for (std::size_t i = 0; i < threads; ++i) {
+            if (const auto* buffer = ctxt.getThreadContext(i).getInsertBuffer(id)) {
+                buffers.push_back(buffer);
+            }
+        }
+        if (buffers.empty()) {
+            continue;
+        }
+        insert->getRelation()->insertBuffers(buffers);
+        for (std::size_t i = 0; i < threads; ++i) {
+            ctxt.getThreadContext(i).resetInsertBuffer(id);
+        }
+    }
+}
+
+RamDomain Engine::evalWorklist(const Worklist& shadow, Context& ctxt) {
+    const auto& deltas = shadow.getDeltas();
+    const auto& buffers = shadow.getBuffers();
+    std::vector<std::size_t> arities;
+    for (const auto* delta : deltas) {
+        arities.push_back((*delta)->getArity());
+    }
+
+    // the rules whose conditions on other relations fail are not evaluated at all
+    std::vector<std::vector<const Worklist::Rule*>> rules(deltas.size());
+    for (const auto& rule : shadow.getRules()) {
+        for (const auto& info : rule.viewContext->getOnDemandIndexes()) {
+            getRelationHandle(info[0])->buildIndex(info[1]);
+        }
+        if (std::all_of(rule.conditions.begin(), rule.conditions.end(),
+                    [&](const auto& condition) { return execute(condition.get(), ctxt); })) {
+            rules[rule.delta].push_back(&rule);
+        }
+    }
+
+    // the tuples are queued in blocks, such that idle threads can take a share of a large output
+    const std::size_t threads = std::min(numOfThreads, thread_budget());
+    WorkQueues<WorklistBlock> queues(threads);
+    auto enqueue = [&](std::size_t thread, std::size_t delta, std::vector<RamDomain>& tuples) {
+        const std::size_t blockSize = WORKLIST_BLOCK_SIZE * arities[delta];
+        for (std::size_t i = 0; i < tuples.size(); i += blockSize) {
+            const auto begin = tuples.begin() + i;
+            const auto end = tuples.begin() + std::min(i + blockSize, tuples.size());
+            queues.push((thread + i / blockSize) % threads, WorklistBlock{delta, {begin, end}});
+        }
+        tuples.clear();
+    };
+
+    // the first items are the tuples derived before the loop, which the delta relations hold
+    for (std::size_t i = 0; i < deltas.size(); ++i) {
+        auto& delta = **deltas[i];
+        std::vector<RamDomain> tuples;
+        tuples.reserve(delta.size() * arities[i]);
+        for (const RamDomain* tuple : delta) {
+            tuples.insert(tuples.end(), tuple, tuple + arities[i]);
+        }
+        delta.purge();
+        enqueue(i % threads, i, tuples);
+    }
+
+    // each thread evaluates the rules for the blocks it takes, and queues the tuples new to their
+    // relations, until no thread has a block left
+    resetIterationNumber();
+    ctxt.reserveThreadContexts(threads);
+    PARALLEL_START_THREADS(threads)
+        const std::size_t thread = thread_number();
+        Context& threadCtxt = ctxt.getThreadContext(thread);
+        for (const auto& rule : shadow.getRules()) {
+            for (const auto& info : rule.viewContext->getViewInfoForNested()) {
+                threadCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+            }
+        }
+        for (const auto& buffer : buffers) {
+            threadCtxt.deferInserts(buffer.first);
+        }
+        WorklistBlock block;
+        while (queues.pop(thread, block)) {
+            if (isCancelled()) {
+                queues.stop();
+            }
+            const std::size_t arity = arities[block.delta];
+            for (const auto* rule : rules[block.delta]) {
+                for (std::size_t i = 0; i < block.tuples.size() && !isCancelled(); i += arity) {
+                    threadCtxt[rule->tupleId] = &block.tuples[i];
+                    if (!execute(rule->operation.get(), threadCtxt)) {
+                        break;
+                    }
+                }
+            }
+            for (const auto& buffer : buffers) {
+                enqueue(thread, buffer.second, *threadCtxt.getInsertBuffer(buffer.first));
+            }
+            queues.done();
+        }
+        for (const auto& buffer : buffers) {
+            threadCtxt.resetInsertBuffer(buffer.first);
+        }
+    PARALLEL_END
+    if (memoryLimit != 0) {
+        checkMemoryLimit(false);
+    }
+    return true;
 }
 
 RecordTable& Engine::getRecordTable() {
-    return recordTable;
+    return *recordTable;
 }
 
 ram::TranslationUnit& Engine::getTranslationUnit() {
@@ -197,6 +487,8 @@ void* Engine::getMethodHandle(const std::string& method) {
 }
 
 VecOwn<Engine::RelationHandle>& Engine::getRelationMap() {
+    // the relations are created with the nodes accessing them
+    generateIR();
     return relations;
 }
 
@@ -204,7 +496,10 @@ void Engine::createRelation(const ram::Relation& id, const std::size_t idx) {
     if (relations.size() < idx + 1) {
         relations.resize(idx + 1);
     }
+    relations[idx] = mk<RelationHandle>(newRelation(id));
+}
 
+Engine::RelationHandle Engine::newRelation(const ram::Relation& id) {
     RelationHandle res;
 
     if (id.getRepresentation() == RelationRepresentation::EQREL) {
@@ -213,10 +508,56 @@ void Engine::createRelation(const ram::Relation& id, const std::size_t idx) {
         res = createBTreeDeleteRelation(id, isa.getIndexSelection(id.getName()));
     } else if (isProvenance) {
         res = createProvenanceRelation(id, isa.getIndexSelection(id.getName()));
+    } else if (id.getArity() > MAX_FIXED_ARITY) {
+        res = createDynamicRelation(id, isa.getIndexSelection(id.getName()));
+    } else if (id.getRepresentation() == RelationRepresentation::BRIE) {
+        res = createBrieRelation(id, isa.getIndexSelection(id.getName()));
     } else {
         res = createBTreeRelation(id, isa.getIndexSelection(id.getName()));
     }
-    relations[idx] = mk<RelationHandle>(std::move(res));
+    return res;
+}
+
+void Engine::unshareRelation(RelationHandle& handle, bool keepTuples) {
+    if (handle.use_count() == 1) {
+        return;
+    }
+    const auto& decls = tUnit.getProgram().getRelations();
+    auto decl = std::find_if(
+            decls.begin(), decls.end(), [&](const auto* rel) { return rel->getName() == handle->getName(); });
+    assert(decl != decls.end() && "relation without declaration");
+    RelationHandle res = newRelation(**decl);
+    if (keepTuples) {
+        for (const RamDomain* tuple : *handle) {
+            res->insert(tuple);
+        }
+    }
+    res->setModified(handle->isModified());
+    res->copyKept(*handle);
+    handle = std::move(res);
+}
+
+Own<Engine> Engine::clone() {
+    if (!incremental || !evaluated || streaming || nativeProgram != nullptr) {
+        return nullptr;
+    }
+    auto copy = mk<Engine>(tUnit);
+    // the symbols of the constants of the program are encoded when its nodes are generated
+    copy->symbolTable = symbolTable;
+    copy->recordTable = recordTable;
+    copy->counter = counter;
+    copy->generateIR();
+    assert(copy->relations.size() == relations.size() && "relations of copies differ");
+    for (std::size_t i = 0; i < relations.size(); ++i) {
+        if (relations[i] != nullptr) {
+            *copy->relations[i] = *relations[i];
+        }
+    }
+    copy->pinnedSymbols = pinnedSymbols;
+    copy->staleSubroutines = staleSubroutines;
+    copy->unloadedSubroutines = unloadedSubroutines;
+    copy->evaluated = true;
+    return copy;
 }
 
 const std::vector<void*>& Engine::loadDLL() {
@@ -264,16 +605,266 @@ const std::vector<void*>& Engine::loadDLL() {
     return dll;
 }
 
+void Engine::loadNativeStrata() {
+    const std::string& path = Global::config().get("native-library");
+    nativeLibrary = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (nativeLibrary == nullptr) {
+        fatal("cannot load native strata: %s", dlerror());
+    }
+
+    // the constants of the library keep their indices, since no symbol is encoded yet
+    assert(symbolTable->size() == 0 && "symbols encoded before loading the native strata");
+    auto symbol = NATIVE_FUNCTION(souffle_native_symbol);
+    for (std::size_t i = 0; symbol(i) != nullptr; ++i) {
+        symbolTable->encode(symbol(i));
+    }
+
+    const std::string outputDir = Global::config().get("output-dir");
+    auto create = NATIVE_FUNCTION(souffle_native_create);
+    nativeProgram = create(symbolTable.get(), static_cast<RecordTable*>(recordTable.get()),
+            Global::config().get("fact-dir").c_str(), outputDir == "-" ? "" : outputDir.c_str(),
+            numOfThreads);
+
+    auto provides = NATIVE_FUNCTION(souffle_native_provides);
+    for (const auto& sub : tUnit.getProgram().getSubroutines()) {
+        nativeSubroutines.push_back(provides(sub.first.c_str()) != 0);
+    }
+}
+
+void* Engine::getNativeFunction(const char* name) const {
+    void* function = dlsym(nativeLibrary, name);
+    if (function == nullptr) {
+        fatal("library of native strata lacks function %s", name);
+    }
+    return function;
+}
+
+void Engine::executeNative(const std::size_t subroutineId, const std::string& name) {
+    const auto& dependencies = stratumDependencies[subroutineId];
+    auto insert = NATIVE_FUNCTION(souffle_native_insert);
+    auto scan = NATIVE_FUNCTION(souffle_native_scan);
+    auto purge = NATIVE_FUNCTION(souffle_native_purge);
+    auto run = NATIVE_FUNCTION(souffle_native_run);
+
+    // temporary relations are local to the stratum, the library has no copies of them
+    std::vector<RamDomain> tuples;
+    auto copyToLibrary = [&](std::size_t id) {
+        const auto& rel = *getRelationHandle(id);
+        const std::size_t arity = rel.getArity();
+        tuples.clear();
+        tuples.reserve(rel.size() * arity);
+        for (const RamDomain* tuple : rel) {
+            tuples.insert(tuples.end(), tuple, tuple + arity);
+        }
+        insert(nativeProgram, rel.getName().c_str(), tuples.data(), rel.size());
+    };
+    for (std::size_t id : dependencies.reads) {
+        copyToLibrary(id);
+    }
+    for (std::size_t id : dependencies.writes) {
+        copyToLibrary(id);
+    }
+
+    run(nativeProgram, name.c_str());
+
+    struct Collector {
+        std::vector<RamDomain>& tuples;
+        std::size_t arity;
+    };
+    auto collect = [](void* context, const RamDomain* tuple) {
+        auto& collector = *static_cast<Collector*>(context);
+        collector.tuples.insert(collector.tuples.end(), tuple, tuple + collector.arity);
+    };
+    for (std::size_t id : dependencies.writes) {
+        auto& rel = *getRelationHandle(id);
+        const std::size_t arity = rel.getArity();
+        Collector collector{tuples, arity};
+        tuples.clear();
+        if (scan(nativeProgram, rel.getName().c_str(), collect, &collector) == 0) {
+            continue;
+        }
+        rel.purge();
+        for (std::size_t offset = 0; offset < tuples.size(); offset += arity) {
+            rel.insert(tuples.data() + offset);
+        }
+    }
+    for (std::size_t id : dependencies.reads) {
+        purge(nativeProgram, getRelationHandle(id)->getName().c_str());
+    }
+    for (std::size_t id : dependencies.writes) {
+        purge(nativeProgram, getRelationHandle(id)->getName().c_str());
+    }
+}
+
 std::size_t Engine::getIterationNumber() const {
     return iteration;
 }
 void Engine::incIterationNumber() {
+    flushFrequencies();
     ++iteration;
 }
 void Engine::resetIterationNumber() {
+    flushFrequencies();
     iteration = 0;
 }
 
+bool Engine::isCancelled() const {
+    return cancellationCheck && cancellationCheck();
+}
+
+std::size_t Engine::getFrequencyIndex(const std::string& label) {
+    auto pos = frequencyIndexes.emplace(label, frequencyLabels.size());
+    if (pos.second) {
+        frequencyLabels.push_back(label);
+        // labels of re-generated operations are registered while counting
+        if (!threadFrequencies.empty()) {
+            frequencies.emplace_back(1, 0);
+            for (auto& thread : threadFrequencies) {
+                thread.counts.push_back(0);
+            }
+        }
+    }
+    return pos.first->second;
+}
+
+void Engine::flushFrequencies() {
+    for (auto& thread : threadFrequencies) {
+        for (std::size_t i = 0; i < thread.counts.size(); ++i) {
+            if (thread.counts[i] == 0) {
+                continue;
+            }
+            auto& current = frequencies[i];
+            if (current.size() <= iteration) {
+                current.resize(iteration + 1, 0);
+            }
+            current[iteration] += thread.counts[i];
+            thread.counts[i] = 0;
+        }
+    }
+    for (auto& thread : threadOperators) {
+        for (std::size_t i = 0; i < thread.counts.size(); ++i) {
+            if (thread.counts[i].calls == 0) {
+                continue;
+            }
+            auto& current = operatorStatistics[i];
+            if (current.size() <= iteration) {
+                current.resize(iteration + 1);
+            }
+            current[iteration].calls += thread.counts[i].calls;
+            current[iteration].time += thread.counts[i].time;
+            thread.counts[i] = {};
+        }
+    }
+}
+
+std::size_t Engine::getOperatorIndex(
+        const std::string& rule, std::size_t position, std::size_t depth, const std::string& text) {
+    profiledOperators.push_back({rule, position, depth, text});
+    return profiledOperators.size() - 1;
+}
+
+void Engine::profileOperators() {
+    // the iterations in which each recursive rule was evaluated, such that its plan in an iteration
+    // lists the operators no tuple entered, too
+    std::map<std::string, std::set<std::size_t>> evaluations;
+    for (std::size_t i = 0; i < profiledOperators.size(); ++i) {
+        for (std::size_t j = 0; j < operatorStatistics[i].size(); ++j) {
+            if (operatorStatistics[i][j].calls != 0) {
+                evaluations[profiledOperators[i].rule].insert(j);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < profiledOperators.size(); ++i) {
+        const auto& op = profiledOperators[i];
+        const auto& statistics = operatorStatistics[i];
+        if (op.rule.rfind("@t-recursive-rule;", 0) != 0) {
+            // non-recursive rules are evaluated outside of loops, and reported once
+            OperatorStatistics total;
+            for (const auto& current : statistics) {
+                total.calls += current.calls;
+                total.time += current.time;
+            }
+            ProfileEventSingleton::instance().makeOperatorEvent(
+                    op.rule, op.position, op.depth, op.text, total.calls, total.time, 0);
+            continue;
+        }
+        for (std::size_t j : evaluations[op.rule]) {
+            const auto current = j < statistics.size() ? statistics[j] : OperatorStatistics{};
+            ProfileEventSingleton::instance().makeOperatorEvent(
+                    op.rule, op.position, op.depth, op.text, current.calls, current.time, j);
+        }
+    }
+}
+
+std::size_t Engine::getAccessIndex(const std::string& relation, std::size_t indexPos) {
+    auto pos = accessIndexes.emplace(std::make_pair(relation, indexPos), accessIndexes.size());
+    // indexes of re-generated operations are registered while counting
+    if (pos.second) {
+        for (auto& thread : threadIndexAccesses) {
+            thread.counts.emplace_back();
+        }
+    }
+    return pos.first->second;
+}
+
+void Engine::countProbe(const IndexAccessOperation& op) {
+    if (profileEnabled && frequencyCounterEnabled) {
+        auto& counts = threadIndexAccesses[thread_number() % threadIndexAccesses.size()].counts;
+        ++counts[op.getAccessIndex()].probes;
+    }
+}
+
+void Engine::countScan(const IndexAccessOperation& op) {
+    if (profileEnabled && frequencyCounterEnabled) {
+        auto& counts = threadIndexAccesses[thread_number() % threadIndexAccesses.size()].counts;
+        ++counts[op.getAccessIndex()].scans;
+    }
+}
+
+void Engine::countTuples(const IndexAccessOperation& op, std::size_t tuples) {
+    if (profileEnabled && frequencyCounterEnabled) {
+        auto& counts = threadIndexAccesses[thread_number() % threadIndexAccesses.size()].counts;
+        counts[op.getAccessIndex()].tuples += tuples;
+    }
+}
+
+void Engine::countInserts(const IndexAccessOperation& op, std::size_t tuples) {
+    if (profileEnabled && frequencyCounterEnabled) {
+        auto& counts = threadIndexAccesses[thread_number() % threadIndexAccesses.size()].counts;
+        counts[op.getAccessIndex()].inserts += tuples;
+    }
+}
+
+void Engine::profileIndexAccesses() {
+    std::vector<IndexAccesses> total(accessIndexes.size());
+    for (auto& thread : threadIndexAccesses) {
+        for (std::size_t i = 0; i < thread.counts.size(); ++i) {
+            total[i].probes += thread.counts[i].probes;
+            total[i].scans += thread.counts[i].scans;
+            total[i].tuples += thread.counts[i].tuples;
+            total[i].inserts += thread.counts[i].inserts;
+        }
+    }
+    // every index is reported, such that the indexes never accessed show up
+    for (const auto& handle : relations) {
+        if (!handle) {
+            continue;
+        }
+        const auto& rel = **handle;
+        auto accesses = [&](std::size_t indexPos) {
+            auto pos = accessIndexes.find(std::make_pair(rel.getName(), indexPos));
+            return pos == accessIndexes.end() ? IndexAccesses{} : total[pos->second];
+        };
+        // the tuples are inserted into the first index, and into the others if they are new
+        const std::size_t inserts = accesses(0).inserts;
+        for (std::size_t i = 0; i < rel.getNumIndexes(); ++i) {
+            const auto access = accesses(i);
+            ProfileEventSingleton::instance().makeIndexAccessEvent(rel.getName(),
+                    toString(rel.getIndexOrder(i)), access.probes, access.scans, access.tuples, inserts);
+        }
+    }
+}
+
 void Engine::executeMain() {
     SignalHandler::instance()->set();
     if (Global::config().has("verbose")) {
@@ -282,6 +873,8 @@ void Engine::executeMain() {
 
     generateIR();
     assert(main != nullptr && "Executing an empty program");
+    selectSubroutines();
+    pinnedSymbols = symbolTable->size();
 
     loadDLL();
 
@@ -290,16 +883,38 @@ void Engine::executeMain() {
     if (!profileEnabled) {
         Context ctxt;
         execute(main.get(), ctxt);
+        if (asyncOutput != nullptr) {
+            asyncOutput->wait();
+        }
     } else {
         ProfileEventSingleton::instance().setOutputFile(Global::config().get("profile"));
+        if (Global::config().has("profile-counters")) {
+            ProfileEventSingleton::instance().enableCounters();
+        }
+        if (Global::config().has("profile-stream")) {
+            ProfileEventSingleton::instance().setStreamFile(Global::config().get("profile-stream"));
+        }
         // Prepare the frequency table for threaded use
         const ram::Program& program = tUnit.getProgram();
         visit(program, [&](const ram::TupleOperation& node) {
             if (!node.getProfileText().empty()) {
-                frequencies.emplace(node.getProfileText(), std::deque<std::atomic<std::size_t>>());
-                frequencies[node.getProfileText()].emplace_back(0);
+                getFrequencyIndex(node.getProfileText());
             }
         });
+        frequencies.assign(frequencyLabels.size(), std::vector<std::size_t>(1, 0));
+        threadFrequencies.resize(numOfThreads);
+        for (auto& thread : threadFrequencies) {
+            thread.counts.assign(frequencyLabels.size(), 0);
+        }
+        threadIndexAccesses.resize(numOfThreads);
+        for (auto& thread : threadIndexAccesses) {
+            thread.counts.resize(accessIndexes.size());
+        }
+        threadOperators.resize(numOfThreads);
+        for (auto& thread : threadOperators) {
+            thread.counts.resize(profiledOperators.size());
+        }
+        operatorStatistics.resize(profiledOperators.size());
         // Enable profiling for execution of main
         ProfileEventSingleton::instance().startTimer();
         ProfileEventSingleton::instance().makeTimeEvent("@time;starttime");
@@ -324,31 +939,552 @@ void Engine::executeMain() {
         ProfileEventSingleton::instance().makeConfigRecord("ruleCount", std::to_string(ruleCount));
 
         Context ctxt;
+        if (sampler != nullptr) {
+            sampler->start();
+        }
         execute(main.get(), ctxt);
+        if (asyncOutput != nullptr) {
+            asyncOutput->wait();
+        }
+        if (sampler != nullptr) {
+            sampler->stop();
+            sampler->dump();
+        }
         ProfileEventSingleton::instance().stopTimer();
-        for (auto const& cur : frequencies) {
-            for (std::size_t i = 0; i < cur.second.size(); ++i) {
-                ProfileEventSingleton::instance().makeQuantityEvent(cur.first, cur.second[i], i);
+        flushFrequencies();
+        for (std::size_t label = 0; label < frequencies.size(); ++label) {
+            for (std::size_t i = 0; i < frequencies[label].size(); ++i) {
+                ProfileEventSingleton::instance().makeQuantityEvent(
+                        frequencyLabels[label], frequencies[label][i], i);
             }
         }
         for (auto const& cur : reads) {
             ProfileEventSingleton::instance().makeQuantityEvent(
                     "@relation-reads;" + cur.first, cur.second, 0);
         }
+        if (frequencyCounterEnabled) {
+            profileIndexAccesses();
+        }
+        if (operatorProfileEnabled) {
+            profileOperators();
+        }
+        // the tables grow until the end of the program, unlike the relations of completed strata
+        ProfileEventSingleton::instance().makeTableMemoryEvent(
+                "symbol-table", symbolTable->getMemoryUsage(), symbolTable->size());
+        ProfileEventSingleton::instance().makeTableMemoryEvent(
+                "record-table", recordTable->getMemoryUsage(), recordTable->size());
+        ProfileEventSingleton::instance().makeAllocatorEvents();
+        ProfileEventSingleton::instance().makeLockEvents();
+    }
+
+    if (ruleStatisticsEnabled) {
+        reportHotRules();
+    }
+
+    if (emitPlans && joinPlanner != nullptr) {
+        std::ofstream os(Global::config().get("emit-plans"));
+        joinPlanner->emitPlans(os);
+    }
+
+    if (incremental) {
+        // All changes are incorporated, subsequent runs only refresh strata touched in between; the
+        // changes of relations shared with a copy of the engine are still to be incorporated by the copy
+        for (auto& rel : relations) {
+            if (rel != nullptr && (*rel)->isModified()) {
+                unshareRelation(*rel, true);
+                (*rel)->setModified(false);
+            }
+        }
+        evaluated = true;
     }
     SignalHandler::instance()->reset();
 }
 
+bool Engine::readNextBatch() {
+    if (streams.empty()) {
+        return false;
+    }
+    for (auto it = streams.begin(); it != streams.end();) {
+        auto& [rel, reader] = *it;
+        const std::size_t size = rel->size();
+        try {
+            rel->load(*reader);
+        } catch (std::exception& e) {
+            std::cerr << "Error loading " << rel->getName() << " data: " << e.what() << "\n";
+        }
+        if (rel->size() != size) {
+            rel->setModified(true);
+        }
+        it = reader->hasMoreBatches() ? std::next(it) : streams.erase(it);
+    }
+    return true;
+}
+
+void Engine::writeDelta(const std::map<std::string, std::string>& directive, const RelationWrapper& rel) {
+    // the tuples are flattened and sorted, such that the delta is the difference of sorted sequences;
+    // tuples of nullary relations are represented by a single value
+    const std::size_t width = std::max<std::size_t>(rel.getArity(), 1);
+    std::vector<RamDomain> tuples;
+    tuples.reserve(rel.size() * width);
+    for (const RamDomain* tuple : rel) {
+        if (rel.getArity() == 0) {
+            tuples.push_back(0);
+        } else {
+            tuples.insert(tuples.end(), tuple, tuple + width);
+        }
+    }
+    const std::size_t count = tuples.size() / width;
+    std::vector<std::size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    auto row = [&](const std::vector<RamDomain>& values, std::size_t i) { return values.data() + i * width; };
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return std::lexicographical_compare(row(tuples, a), row(tuples, a) + width, row(tuples, b),
+                row(tuples, b) + width);
+    });
+    std::vector<RamDomain> sorted;
+    sorted.reserve(tuples.size());
+    for (std::size_t i : order) {
+        sorted.insert(sorted.end(), row(tuples, i), row(tuples, i) + width);
+    }
+
+    auto write = [&](const std::map<std::string, std::string>& target,
+                         const std::vector<const RamDomain*>& delta) {
+        IOSystem::getInstance().getWriter(target, getSymbolTable(), getRecordTable())->writeAll(delta);
+    };
+    auto previous = emitted.find(&rel);
+    if (previous == emitted.end()) {
+        IOSystem::getInstance().getWriter(directive, getSymbolTable(), getRecordTable())->writeAll(rel);
+        emitted[&rel] = std::move(sorted);
+        return;
+    }
+
+    std::vector<const RamDomain*> added;
+    std::vector<const RamDomain*> removed;
+    const auto& before = previous->second;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < count || j < before.size() / width) {
+        if (j == before.size() / width ||
+                (i < count && std::lexicographical_compare(row(sorted, i), row(sorted, i) + width,
+                                      row(before, j), row(before, j) + width))) {
+            added.push_back(row(sorted, i++));
+        } else if (i == count || std::lexicographical_compare(row(before, j), row(before, j) + width,
+                                         row(sorted, i), row(sorted, i) + width)) {
+            removed.push_back(row(before, j++));
+        } else {
+            ++i;
+            ++j;
+        }
+    }
+
+    auto target = directive;
+    target["append"] = "true";
+    if (!added.empty()) {
+        write(target, added);
+    }
+    if (!removed.empty()) {
+        target["name"] += ".retracted";
+        if (contains(target, "filename")) {
+            target["filename"] += ".retracted";
+        }
+        write(target, removed);
+    }
+    previous->second = std::move(sorted);
+}
+
 void Engine::generateIR() {
     const ram::Program& program = tUnit.getProgram();
-    NodeGenerator generator(*this);
+    if (generator == nullptr) {
+        generator = mk<NodeGenerator>(*this);
+    }
     if (subroutine.empty()) {
         for (const auto& sub : program.getSubroutines()) {
-            subroutine.push_back(generator.generateTree(*sub.second));
+            subroutine.push_back(generator->generateTree(*sub.second));
         }
     }
     if (main == nullptr) {
-        main = generator.generateTree(program.getMain());
+        main = generator->generateTree(program.getMain());
+    }
+    if (adaptiveJoinOrder && !isProvenance && joinPlanner == nullptr) {
+        joinPlanner = mk<JoinPlanner>(*this);
+    }
+    if (incremental && !evaluated) {
+        visit(program, [&](const ram::IO& io) {
+            streaming = streaming ||
+                        (io.get("operation") == "input" && getOr(io.getDirectives(), "IO", "") == "stream");
+        });
+    }
+    // the relations written by a stratum are frozen once it completes
+    if (stratumDependencies.empty()) {
+        computeStratumDependencies();
+        staleSubroutines.assign(stratumDependencies.size(), false);
+        unloadedSubroutines.assign(stratumDependencies.size(), false);
+        // re-runs purge the tuples derived by the strata, but not those inserted through the interface
+        for (const auto& dependencies : stratumDependencies) {
+            for (std::size_t id : dependencies.writes) {
+                if (incremental && !contains(dependencies.inputs, id)) {
+                    getRelationHandle(id)->setKeepInserted(true);
+                }
+            }
+        }
+    }
+}
+
+void Engine::reportHotRules() const {
+    constexpr std::size_t maxReportedRules = 10;
+    std::vector<std::pair<const ram::DebugInfo*, RuleStatistics>> rules(
+            ruleStatistics.begin(), ruleStatistics.end());
+    std::sort(rules.begin(), rules.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.second.time > rhs.second.time; });
+    if (rules.size() > maxReportedRules) {
+        rules.resize(maxReportedRules);
+    }
+
+    // These rules are the candidates that benefit most from compilation with -c
+    std::cerr << "Hot rules:\n";
+    for (const auto& [info, stats] : rules) {
+        const std::string& message = info->getMessage();
+        std::cerr << "  " << stats.time / 1000 << "ms in " << stats.executions << " evaluation(s): "
+                  << message.substr(0, message.find('\n')) << "\n";
+    }
+}
+
+void Engine::computeStratumDependencies() {
+    // Only temporary relations are swapped, hence the slots of all other relations are stable.
+    std::map<std::string, std::size_t> relationIds;
+    for (std::size_t i = 0; i < relations.size(); ++i) {
+        if (relations[i] != nullptr) {
+            relationIds[(*relations[i])->getName()] = i;
+        }
+    }
+    auto toIds = [&](const std::set<std::string>& names) {
+        std::vector<std::size_t> ids;
+        for (const auto& name : names) {
+            auto it = relationIds.find(name);
+            if (it != relationIds.end()) {
+                ids.push_back(it->second);
+            }
+        }
+        return ids;
+    };
+
+    for (const auto& sub : tUnit.getProgram().getSubroutines()) {
+        StratumDependencies dependencies;
+        if (isPrefix("stratum_", sub.first)) {
+            std::set<std::string> read;
+            std::set<std::string> written;
+            std::set<std::string> loaded;
+            const ram::Statement& stratum = *sub.second;
+            visit(stratum, [&](const ram::RelationOperation& op) { read.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::AbstractExistenceCheck& op) { read.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::EmptinessCheck& op) { read.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::RelationSize& op) { read.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::Insert& op) { written.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::Erase& op) { written.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::Clear& op) { written.insert(op.getRelation()); });
+            visit(stratum, [&](const ram::BinRelationStatement& op) {
+                written.insert(op.getFirstRelation());
+                written.insert(op.getSecondRelation());
+            });
+            visit(stratum, [&](const ram::IO& io) {
+                if (io.get("operation") == "input") {
+                    loaded.insert(io.getRelation());
+                    written.insert(io.getRelation());
+                }
+            });
+            for (const auto& name : written) {
+                read.erase(name);
+            }
+            dependencies.reads = toIds(read);
+            dependencies.writes = toIds(written);
+            dependencies.inputs = toIds(loaded);
+        }
+        stratumDependencies.push_back(std::move(dependencies));
+    }
+}
+
+bool Engine::prepareSubroutine(const std::size_t subroutineId) {
+    if (!evaluated || unloadedSubroutines[subroutineId]) {
+        return true;
+    }
+    const auto& dependencies = stratumDependencies[subroutineId];
+    auto isModified = [&](std::size_t id) { return getRelationHandle(id)->isModified(); };
+    if (!staleSubroutines[subroutineId] && none_of(dependencies.reads, isModified) &&
+            none_of(dependencies.writes, isModified)) {
+        return dependencies.reads.empty() && dependencies.writes.empty();
+    }
+    for (std::size_t id : dependencies.writes) {
+        // relations shared with a copy of the engine are replaced instead of changed
+        auto& handle = getRelationHandle(id);
+        const bool input = contains(dependencies.inputs, id);
+        unshareRelation(handle, input);
+        if (!input) {
+            handle->purgeDerived();
+        }
+        handle->setModified(true);
+    }
+    return true;
+}
+
+void Engine::selectSubroutines() {
+    selectedSubroutines.clear();
+    if (requestedRelations.empty()) {
+        return;
+    }
+    auto toNames = [&](const std::vector<std::size_t>& ids) {
+        std::vector<std::string> names;
+        for (std::size_t id : ids) {
+            names.push_back(getRelationHandle(id)->getName());
+        }
+        return names;
+    };
+    std::vector<std::vector<std::string>> reads;
+    std::vector<std::vector<std::string>> writes;
+    for (const auto& dependencies : stratumDependencies) {
+        reads.push_back(toNames(dependencies.reads));
+        writes.push_back(toNames(dependencies.writes));
+    }
+    selectedSubroutines = SouffleProgram::selectStrata(requestedRelations, reads, writes);
+
+    // the subroutines other than strata, e.g., of the provenance, are always evaluated
+    std::size_t i = 0;
+    for (const auto& sub : tUnit.getProgram().getSubroutines()) {
+        if (!isPrefix("stratum_", sub.first)) {
+            selectedSubroutines[i] = true;
+        }
+        ++i;
+    }
+}
+
+void Engine::compactSubroutine(const std::size_t subroutineId) {
+    for (std::size_t id : stratumDependencies[subroutineId].writes) {
+        auto& rel = *getRelationHandle(id);
+        // temporary relations are cleared before the stratum ends
+        if (rel.getName()[0] != '@') {
+            rel.compact();
+        }
+    }
+}
+
+void Engine::buildIndexes(const std::size_t subroutineId) {
+    for (std::size_t id : stratumDependencies[subroutineId].reads) {
+        getRelationHandle(id)->buildIndexes();
+    }
+}
+
+void Engine::freezeSubroutine(const std::size_t subroutineId) {
+    for (std::size_t id : stratumDependencies[subroutineId].writes) {
+        getRelationHandle(id)->freeze();
+    }
+}
+
+void Engine::buildFilters(const std::size_t subroutineId) {
+    for (std::size_t id : stratumDependencies[subroutineId].writes) {
+        getRelationHandle(id)->buildFilter();
+    }
+}
+
+RamDomain Engine::evalStratumCache(const ram::StratumCache& cur, const StratumCache& shadow, Context& ctxt) {
+    const std::string& directory = cur.getDirectory();
+    const std::string& name = cur.getName();
+    stratum_cache::Fingerprint fingerprint(cur.getKey());
+    for (const auto& [handle, relation] : shadow.getInputs()) {
+        fingerprint.add(relation->getName(), **handle, relation->getAttributeTypes(), getSymbolTable());
+    }
+
+    auto getDirectives = [&](const ram::Relation& relation) {
+        return stratum_cache::snapshotDirectives(
+                directory, name, relation.getName(), relation.getAttributeTypes());
+    };
+
+    if (stratum_cache::isCached(directory, name, fingerprint)) {
+        try {
+            for (const auto& [handle, relation] : shadow.getOutputs()) {
+                auto reader = IOSystem::getInstance().getReader(
+                        getDirectives(*relation), getSymbolTable(), getRecordTable());
+                (*handle)->load(*reader);
+            }
+            return true;
+        } catch (std::exception&) {
+            // an incomplete entry is evaluated again
+            for (const auto& [handle, relation] : shadow.getOutputs()) {
+                (*handle)->purge();
+            }
+        }
+    }
+
+    stratum_cache::invalidate(directory, name);
+    const RamDomain result = execute(shadow.getChild(), ctxt);
+    if (isCancelled()) {
+        return result;
+    }
+    try {
+        for (const auto& [handle, relation] : shadow.getOutputs()) {
+            IOSystem::getInstance()
+                    .getWriter(getDirectives(*relation), getSymbolTable(), getRecordTable())
+                    ->writeAll(**handle);
+        }
+        stratum_cache::markCached(directory, name, fingerprint);
+    } catch (std::exception& e) {
+        std::cerr << "Warning: cannot cache " << name << ": " << e.what() << "\n";
+    }
+    return result;
+}
+
+void Engine::compactTables(const ram::CompactTables& cur, const CompactTables& shadow) {
+    // the tables shared with copies of the engine are referred to by the relations of the copies
+    if (symbolTable->size() + recordTable->size() < compactionThreshold || symbolTable.use_count() > 1) {
+        return;
+    }
+
+    // the symbols of constants are encoded in the nodes of the program and keep their indices
+    SymbolTable newSymbols(numOfThreads);
+    for (std::size_t i = 0; i < pinnedSymbols; ++i) {
+        [[maybe_unused]] const RamDomain index = newSymbols.encode(symbolTable->decode(i));
+        assert(static_cast<std::size_t>(index) == i && "symbols of constants are not dense");
+    }
+    RecordTableImpl newRecords(numOfThreads);
+    TableCompactor compactor(cur.getTypes(), *symbolTable, *recordTable, newSymbols, newRecords);
+
+    for (const auto& [handle, relation] : shadow.getRelations()) {
+        auto& rel = **handle;
+        if (rel.size() == 0) {
+            continue;
+        }
+        const std::size_t arity = rel.getArity();
+        std::vector<TableCompactor::ValueType*> types;
+        for (const auto& type : relation->getAttributeTypes()) {
+            types.push_back(&compactor.getType(type));
+        }
+        std::vector<RamDomain> tuples;
+        tuples.reserve(rel.size() * arity);
+        for (const RamDomain* tuple : rel) {
+            for (std::size_t i = 0; i < arity; ++i) {
+                tuples.push_back(compactor.translate(tuple[i], *types[i]));
+            }
+        }
+        rel.purge();
+        for (std::size_t offset = 0; offset < tuples.size(); offset += arity) {
+            rel.insert(tuples.data() + offset);
+        }
+    }
+
+    symbolTable->swap(newSymbols);
+    recordTable->swap(newRecords);
+    compactionThreshold =
+            std::max(MIN_COMPACTION_THRESHOLD, 2 * (symbolTable->size() + recordTable->size()));
+}
+
+std::size_t Engine::getMemoryUsage() const {
+    std::size_t bytes = symbolTable->getMemoryUsage() + recordTable->getMemoryUsage();
+    for (const auto& handle : relations) {
+        if (handle) {
+            for (std::size_t i = 0; i < (*handle)->getNumIndexes(); ++i) {
+                bytes += (*handle)->getIndexMemory(i).bytes;
+            }
+        }
+    }
+    return bytes;
+}
+
+void Engine::checkMemoryLimit(bool stratumEnd) {
+    // react once the usage exceeds 90% of the budget
+    std::size_t usage = getMemoryUsage();
+    if (usage < memoryLimit / 10 * 9) {
+        return;
+    }
+    for (auto& handle : relations) {
+        if (handle) {
+            usage -= std::min(usage, (*handle)->releaseIndexes());
+        }
+    }
+    if (stratumEnd) {
+        // the background output iterates over relations being compacted otherwise
+        if (asyncOutput != nullptr) {
+            asyncOutput->wait();
+        }
+        for (auto& handle : relations) {
+            if (handle && (*handle)->getName()[0] != '@') {
+                (*handle)->compact();
+            }
+        }
+        compactionThreshold = 0;
+        usage = getMemoryUsage();
+    }
+    if (usage <= memoryLimit) {
+        return;
+    }
+
+    std::vector<std::pair<std::size_t, std::string>> largest;
+    for (const auto& handle : relations) {
+        if (handle) {
+            std::size_t bytes = 0;
+            for (std::size_t i = 0; i < (*handle)->getNumIndexes(); ++i) {
+                bytes += (*handle)->getIndexMemory(i).bytes;
+            }
+            largest.emplace_back(bytes, (*handle)->getName());
+        }
+    }
+    std::sort(largest.rbegin(), largest.rend());
+    auto megabytes = [](std::size_t bytes) { return std::to_string(bytes >> 20) + "MB"; };
+    std::cerr << "Error: the relations and tables use " << megabytes(usage)
+              << ", exceeding the memory limit of " << megabytes(memoryLimit) << "\nLargest relations:\n";
+    for (std::size_t i = 0; i < largest.size() && i < 5; ++i) {
+        std::cerr << std::setw(10) << megabytes(largest[i].first) << "  " << largest[i].second << "\n";
+    }
+    std::cerr << "symbol table " << megabytes(symbolTable->getMemoryUsage()) << ", record table "
+              << megabytes(recordTable->getMemoryUsage()) << "\n";
+    if (Global::config().has("checkpoint-dir")) {
+        std::cerr << "The evaluation can be resumed from the last checkpoint with --resume-from="
+                  << Global::config().get("checkpoint-dir") << "\n";
+    }
+    exit(EXIT_FAILURE);
+}
+
+void Engine::profileSubroutineMemory(const std::size_t subroutineId) {
+    auto& profile = ProfileEventSingleton::instance();
+    for (std::size_t id : stratumDependencies[subroutineId].writes) {
+        const auto& rel = *getRelationHandle(id);
+        // temporary relations are cleared before the stratum ends
+        if (rel.getName()[0] == '@') {
+            continue;
+        }
+        for (std::size_t i = 0; i < rel.getNumIndexes(); ++i) {
+            const auto memory = rel.getIndexMemory(i);
+            profile.makeIndexMemoryEvent(rel.getName(), toString(rel.getIndexOrder(i)), memory.bytes,
+                    memory.nodes, memory.fillFactor);
+        }
+        // the columns are scanned when the frequencies are profiled, as for the accesses of indexes
+        if (frequencyCounterEnabled) {
+            profileColumns(rel);
+        }
+    }
+}
+
+void Engine::profileColumns(const RelationWrapper& rel) {
+    const std::size_t arity = rel.getArity() - rel.getAuxiliaryArity();
+    if (arity == 0 || rel.size() == 0) {
+        return;
+    }
+    std::vector<HyperLogLog> distinct(arity);
+    std::vector<RamDomain> low(arity, std::numeric_limits<RamDomain>::max());
+    std::vector<RamDomain> high(arity, std::numeric_limits<RamDomain>::min());
+    for (const RamDomain* tuple : rel) {
+        for (std::size_t i = 0; i < arity; ++i) {
+            distinct[i].insert(tuple[i]);
+            low[i] = std::min(low[i], tuple[i]);
+            high[i] = std::max(high[i], tuple[i]);
+        }
+    }
+    for (std::size_t i = 0; i < arity; ++i) {
+        // the difference of the bounds fits into an unsigned value, unless a column spans all values
+        const auto span = static_cast<RamUnsigned>(high[i]) - static_cast<RamUnsigned>(low[i]);
+        const std::size_t range = span < std::numeric_limits<std::size_t>::max()
+                                          ? static_cast<std::size_t>(span) + 1
+                                          : std::numeric_limits<std::size_t>::max();
+        // the estimate of the sketch may slightly exceed the exact bounds
+        const auto count = std::min({static_cast<std::size_t>(distinct[i].estimate()), range, rel.size()});
+        ProfileEventSingleton::instance().makeColumnEvent(rel.getName(), i, count, range);
     }
 }
 
@@ -426,7 +1562,7 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         ESAC(StringConstant)
 
         CASE(TupleElement)
-            return ctxt[shadow.getTupleId()][shadow.getElement()];
+            return ctxt.getTuple(shadow.getTupleId())[shadow.getElement()];
         ESAC(TupleElement)
 
         CASE(AutoIncrement)
@@ -486,7 +1622,8 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         return ramBitCast(func(x)); \
     }
 #define CONV_TO_STRING(op, ty)                                                             \
-    case FunctorOp::op: return getSymbolTable().encode(std::to_string(EVAL_CHILD(ty, 0)));
+    case FunctorOp::op: return getSymbolTable().encode(                                    \
+        evaluator::StringBuilder().appendNumber(EVAL_CHILD(ty, 0)).view());
 #define CONV_FROM_STRING(op, ty)                              \
     case FunctorOp::op: return evaluator::symbol2numeric<ty>( \
         getSymbolTable().decode(EVAL_CHILD(RamDomain, 0)));
@@ -592,11 +1729,12 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
                     // clang-format on
 
                 case FunctorOp::CAT: {
-                    std::stringstream ss;
-                    for (std::size_t i = 0; i < args.size(); i++) {
-                        ss << getSymbolTable().decode(execute(shadow.getChild(i), ctxt));
+                    // the arguments of nested concatenations are fused by the generator
+                    evaluator::StringBuilder builder;
+                    for (const auto& child : shadow.getChildren()) {
+                        builder.append(getSymbolTable().decode(execute(child.get(), ctxt)));
                     }
-                    return getSymbolTable().encode(ss.str());
+                    return getSymbolTable().encode(builder.view());
                 }
                 /** Ternary Functor Operators */
                 case FunctorOp::SUBSTR: {
@@ -604,9 +1742,9 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
                     const std::string& str = getSymbolTable().decode(symbol);
                     auto idx = execute(shadow.getChild(1), ctxt);
                     auto len = execute(shadow.getChild(2), ctxt);
-                    std::string sub_str;
+                    std::string_view sub_str;
                     try {
-                        sub_str = str.substr(idx, len);
+                        sub_str = std::string_view(str).substr(idx, len);
                     } catch (...) {
                         std::cerr << "warning: wrong index position provided by substr(\"";
                         std::cerr << str << "\"," << (int32_t)idx << "," << (int32_t)len << ") functor.\n";
@@ -658,126 +1796,38 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 #undef RUN_RANGE
         ESAC(NestedIntrinsicOperator)
 
-        CASE(UserDefinedOperator)
-            const std::string& name = cur.getName();
-
-            auto userFunctor = reinterpret_cast<void (*)()>(getMethodHandle(name));
-            if (userFunctor == nullptr) fatal("cannot find user-defined operator `%s`", name);
-            std::size_t arity = cur.getArguments().size();
+        CASE(ParallelNestedIntrinsicOperator)
+            switch (cur.getFunction()) {
+                case ram::NestedIntrinsicOp::RANGE: return evalParallelRange<RamSigned>(cur, shadow, ctxt);
+                case ram::NestedIntrinsicOp::URANGE: return evalParallelRange<RamUnsigned>(cur, shadow, ctxt);
+                case ram::NestedIntrinsicOp::FRANGE: fatal("ICE: float ranges are not run in parallel");
+            }
 
-            if (cur.isStateful()) {
-                // prepare dynamic call environment
-                ffi_cif cif;
-                ffi_type* args[arity + 2];
-                void* values[arity + 2];
-                RamDomain intVal[arity];
-                ffi_arg rc;
-
-                /* Initialize arguments for ffi-call */
-                args[0] = args[1] = &ffi_type_pointer;
-                void* symbolTable = (void*)&getSymbolTable();
-                values[0] = &symbolTable;
-                void* recordTable = (void*)&getRecordTable();
-                values[1] = &recordTable;
-                for (std::size_t i = 0; i < arity; i++) {
-                    intVal[i] = execute(shadow.getChild(i), ctxt);
-                    args[i + 2] = &FFI_RamSigned;
-                    values[i + 2] = &intVal[i];
-                }
+            { UNREACHABLE_BAD_CASE_ANALYSIS }
+        ESAC(ParallelNestedIntrinsicOperator)
 
-                // Set codomain.
-                auto codomain = &FFI_RamSigned;
+        CASE(UserDefinedOperator)
+            if (shadow.getFunctor() == nullptr) {
+                fatal("cannot find user-defined operator `%s`", cur.getName());
+            }
+            std::size_t arity = cur.getArguments().size();
 
-                // Call the external function.
-                const auto prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity + 2, codomain, args);
-                if (prepStatus != FFI_OK) {
-                    fatal("Failed to prepare CIF for user-defined operator `%s`; error code = %d", name,
-                            prepStatus);
-                }
-                ffi_call(&cif, userFunctor, &rc, values);
-                return static_cast<RamDomain>(rc);
-            } else {
-                const std::vector<TypeAttribute>& types = cur.getArgsTypes();
-
-                // prepare dynamic call environment
-                ffi_cif cif;
-                ffi_type* args[arity];
-                void* values[arity];
-                RamDomain intVal[arity];
-                RamUnsigned uintVal[arity];
-                RamFloat floatVal[arity];
-                const char* strVal[arity];
-
-                /* Initialize arguments for ffi-call */
+            // functors declared `cached` are called once per arguments, unless their results are evicted
+            if (auto* cache = shadow.getCache()) {
+                std::vector<RamDomain> key(arity);
                 for (std::size_t i = 0; i < arity; i++) {
-                    RamDomain arg = execute(shadow.getChild(i), ctxt);
-                    switch (types[i]) {
-                        case TypeAttribute::Symbol:
-                            args[i] = &FFI_Symbol;
-                            strVal[i] = getSymbolTable().decode(arg).c_str();
-                            values[i] = &strVal[i];
-                            break;
-                        case TypeAttribute::Signed:
-                            args[i] = &FFI_RamSigned;
-                            intVal[i] = arg;
-                            values[i] = &intVal[i];
-                            break;
-                        case TypeAttribute::Unsigned:
-                            args[i] = &FFI_RamUnsigned;
-                            uintVal[i] = ramBitCast<RamUnsigned>(arg);
-                            values[i] = &uintVal[i];
-                            break;
-                        case TypeAttribute::Float:
-                            args[i] = &FFI_RamFloat;
-                            floatVal[i] = ramBitCast<RamFloat>(arg);
-                            values[i] = &floatVal[i];
-                            break;
-                        case TypeAttribute::ADT: fatal("ADT support is not implemented");
-                        case TypeAttribute::Record: fatal("Record support is not implemented");
-                    }
-                }
-
-                // Get codomain.
-                auto codomain = &FFI_RamSigned;
-                switch (cur.getReturnType()) {
-                    case TypeAttribute::Symbol: codomain = &FFI_Symbol; break;
-                    case TypeAttribute::Signed: codomain = &FFI_RamSigned; break;
-                    case TypeAttribute::Unsigned: codomain = &FFI_RamUnsigned; break;
-                    case TypeAttribute::Float: codomain = &FFI_RamFloat; break;
-                    case TypeAttribute::ADT: fatal("Not implemented");
-                    case TypeAttribute::Record: fatal("Not implemented");
-                }
-
-                // Call the external function.
-                const auto prepStatus = ffi_prep_cif(&cif, FFI_DEFAULT_ABI, arity, codomain, args);
-                if (prepStatus != FFI_OK) {
-                    fatal("Failed to prepare CIF for user-defined operator `%s`; error code = %d", name,
-                            prepStatus);
-                }
-
-                // Call †he functor and return
-                // Float return type needs special treatment, see https://stackoverflow.com/q/61577543
-                if (cur.getReturnType() == TypeAttribute::Float) {
-                    RamFloat rvalue;
-                    ffi_call(&cif, userFunctor, &rvalue, values);
-                    return ramBitCast(rvalue);
-                } else {
-                    ffi_arg rvalue;
-                    ffi_call(&cif, userFunctor, &rvalue, values);
-
-                    switch (cur.getReturnType()) {
-                        case TypeAttribute::Signed: return static_cast<RamDomain>(rvalue);
-                        case TypeAttribute::Symbol:
-                            return getSymbolTable().encode(reinterpret_cast<const char*>(rvalue));
-                        case TypeAttribute::Unsigned: return ramBitCast(static_cast<RamUnsigned>(rvalue));
-                        case TypeAttribute::Float: fatal("Floats must be handled seperately");
-                        case TypeAttribute::ADT: fatal("Not implemented");
-                        case TypeAttribute::Record: fatal("Not implemented");
-                    }
-                    fatal("Unsupported user defined operator");
+                    key[i] = execute(shadow.getChild(i), ctxt);
                 }
+                return cache->lookup(key, [&](const std::vector<RamDomain>& args) {
+                    return callUserDefinedOperator(cur, shadow, args.data());
+                });
             }
 
+            RamDomain args[arity];
+            for (std::size_t i = 0; i < arity; i++) {
+                args[i] = execute(shadow.getChild(i), ctxt);
+            }
+            return callUserDefinedOperator(cur, shadow, args);
         ESAC(UserDefinedOperator)
 
         CASE(PackRecord)
@@ -803,11 +1853,16 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         ESAC(False)
 
         CASE(Conjunction)
-            return execute(shadow.getLhs(), ctxt) && execute(shadow.getRhs(), ctxt);
+            for (const auto& child : shadow.getChildren()) {
+                if (!evalCondition(child.get(), ctxt)) {
+                    return false;
+                }
+            }
+            return true;
         ESAC(Conjunction)
 
         CASE(Negation)
-            return !execute(shadow.getChild(), ctxt);
+            return !evalCondition(shadow.getChild(), ctxt);
         ESAC(Negation)
 
 #define EMPTINESS_CHECK(Structure, Arity, ...)                          \
@@ -845,97 +1900,30 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 #undef PROVENANCE_EXISTENCE_CHECK
 
         CASE(Constraint)
-        // clang-format off
-#define COMPARE_NUMERIC(ty, op) return EVAL_LEFT(ty) op EVAL_RIGHT(ty)
-#define COMPARE_STRING(op)                                        \
-    return (getSymbolTable().decode(EVAL_LEFT(RamDomain)) op \
-            getSymbolTable().decode(EVAL_RIGHT(RamDomain)))
-#define COMPARE_EQ_NE(opCode, op)                                         \
-    case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamDomain  , op); \
-    case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op);
-#define COMPARE(opCode, op)                                               \
-    case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamSigned  , op); \
-    case BinaryConstraintOp::U##opCode: COMPARE_NUMERIC(RamUnsigned, op); \
-    case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op); \
-    case BinaryConstraintOp::S##opCode: COMPARE_STRING(op);
-            // clang-format on
-
-            switch (cur.getOperator()) {
-                COMPARE_EQ_NE(EQ, ==)
-                COMPARE_EQ_NE(NE, !=)
-
-                COMPARE(LT, <)
-                COMPARE(LE, <=)
-                COMPARE(GT, >)
-                COMPARE(GE, >=)
-
-                case BinaryConstraintOp::MATCH: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().decode(left);
-                    const std::string& text = getSymbolTable().decode(right);
-                    bool result = false;
-                    try {
-                        result = std::regex_match(text, std::regex(pattern));
-                    } catch (...) {
-                        std::cerr << "warning: wrong pattern provided for match(\"" << pattern << "\",\""
-                                  << text << "\").\n";
-                    }
-                    return result;
-                }
-                case BinaryConstraintOp::NOT_MATCH: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().decode(left);
-                    const std::string& text = getSymbolTable().decode(right);
-                    bool result = false;
-                    try {
-                        result = !std::regex_match(text, std::regex(pattern));
-                    } catch (...) {
-                        std::cerr << "warning: wrong pattern provided for !match(\"" << pattern << "\",\""
-                                  << text << "\").\n";
-                    }
-                    return result;
-                }
-                case BinaryConstraintOp::CONTAINS: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().decode(left);
-                    const std::string& text = getSymbolTable().decode(right);
-                    return text.find(pattern) != std::string::npos;
-                }
-                case BinaryConstraintOp::NOT_CONTAINS: {
-                    RamDomain left = execute(shadow.getLhs(), ctxt);
-                    RamDomain right = execute(shadow.getRhs(), ctxt);
-                    const std::string& pattern = getSymbolTable().decode(left);
-                    const std::string& text = getSymbolTable().decode(right);
-                    return text.find(pattern) == std::string::npos;
-                }
-            }
-
-            { UNREACHABLE_BAD_CASE_ANALYSIS }
-
-#undef COMPARE_NUMERIC
-#undef COMPARE_STRING
-#undef COMPARE
-#undef COMPARE_EQ_NE
+            return evalConstraint(shadow, ctxt);
         ESAC(Constraint)
 
         CASE(TupleOperation)
             bool result = execute(shadow.getChild(), ctxt);
 
-            auto& currentFrequencies = frequencies[cur.getProfileText()];
-            while (currentFrequencies.size() <= getIterationNumber()) {
-#ifdef _OPENMP
-#pragma omp critical(frequencies)
-#endif
-                currentFrequencies.emplace_back(0);
-            }
-            frequencies[cur.getProfileText()][getIterationNumber()]++;
+            ++threadFrequencies[thread_number() % threadFrequencies.size()]
+                      .counts[shadow.getFrequencyIndex()];
 
             return result;
         ESAC(TupleOperation)
 
+        case I_ProfiledOperation: {
+            // there is no RAM node of the wrapper; its shadow is the operation it profiles
+            const auto& shadow = *static_cast<const ProfiledOperation*>(node);
+            const auto start = std::chrono::steady_clock::now();
+            const RamDomain result = execute(shadow.getChild(), ctxt);
+            auto& statistics = threadOperators[thread_number() % threadOperators.size()]
+                                       .counts[shadow.getOperatorIndex()];
+            ++statistics.calls;
+            statistics.time += std::chrono::steady_clock::now() - start;
+            return result;
+        }
+
 #define SCAN(Structure, Arity, ...)                                     \
     CASE(Scan, Structure, Arity)                                        \
         const auto& rel = *static_cast<RelType*>(shadow.getRelation()); \
@@ -961,6 +1949,15 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         FOR_EACH(INDEX_SCAN)
 #undef INDEX_SCAN
 
+#define INDEX_INTERSECT(Structure, Arity, ...)                 \
+    CASE(IndexIntersect, Structure, Arity)                     \
+        return evalIndexIntersect<RelType>(cur, shadow, ctxt); \
+    ESAC(IndexIntersect)
+
+        FOR_EACH_BTREE(INDEX_INTERSECT)
+        FOR_EACH_BTREE_DYNAMIC(INDEX_INTERSECT)
+#undef INDEX_INTERSECT
+
 #define PARALLEL_INDEX_SCAN(Structure, Arity, ...)                      \
     CASE(ParallelIndexScan, Structure, Arity)                           \
         const auto& rel = *static_cast<RelType*>(shadow.getRelation()); \
@@ -1043,9 +2040,10 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         FOR_EACH(AGGREGATE)
 #undef AGGREGATE
 
-#define PARALLEL_INDEX_AGGREGATE(Structure, Arity, ...)                \
-    CASE(ParallelIndexAggregate, Structure, Arity)                     \
-        return evalParallelIndexAggregate<RelType>(cur, shadow, ctxt); \
+#define PARALLEL_INDEX_AGGREGATE(Structure, Arity, ...)                 \
+    CASE(ParallelIndexAggregate, Structure, Arity)                      \
+        const auto& rel = *static_cast<RelType*>(shadow.getRelation()); \
+        return evalParallelIndexAggregate(rel, cur, shadow, ctxt);      \
     ESAC(ParallelIndexAggregate)
 
         FOR_EACH(PARALLEL_INDEX_AGGREGATE)
@@ -1061,7 +2059,7 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 
         CASE(Break)
             // check condition
-            if (execute(shadow.getCondition(), ctxt)) {
+            if (evalCondition(shadow.getCondition(), ctxt)) {
                 return false;
             }
             return execute(shadow.getNestedOperation(), ctxt);
@@ -1070,18 +2068,15 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         CASE(Filter)
             bool result = true;
             // check condition
-            if (execute(shadow.getCondition(), ctxt)) {
+            if (evalCondition(shadow.getCondition(), ctxt)) {
+                // count the tuples passing the condition
+                if (profileEnabled && frequencyCounterEnabled && !cur.getProfileText().empty()) {
+                    ++threadFrequencies[thread_number() % threadFrequencies.size()]
+                              .counts[shadow.getFrequencyIndex()];
+                }
                 // process nested
                 result = execute(shadow.getNestedOperation(), ctxt);
             }
-
-            if (profileEnabled && frequencyCounterEnabled && !cur.getProfileText().empty()) {
-                auto& currentFrequencies = frequencies[cur.getProfileText()];
-                while (currentFrequencies.size() <= getIterationNumber()) {
-                    currentFrequencies.emplace_back(0);
-                }
-                frequencies[cur.getProfileText()][getIterationNumber()]++;
-            }
             return result;
         ESAC(Filter)
 
@@ -1103,6 +2098,16 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         FOR_EACH(INSERT)
 #undef INSERT
 
+#define NOVELTY_INSERT(Structure, Arity, ...)                           \
+    CASE(NoveltyInsert, Structure, Arity)                               \
+        auto& rel = *static_cast<RelType*>(shadow.getRelation());       \
+        auto& newRel = *static_cast<RelType*>(shadow.getNewRelation()); \
+        return evalNoveltyInsert(rel, newRel, shadow, ctxt);            \
+    ESAC(NoveltyInsert)
+
+        FOR_EACH(NOVELTY_INSERT)
+#undef NOVELTY_INSERT
+
 #define ERASE(Structure, Arity, ...)                                                 \
     CASE(Erase, Structure, Arity)                                                    \
         void(static_cast<RelType*>(shadow.getRelation()));                           \
@@ -1124,6 +2129,14 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
             return true;
         ESAC(SubroutineReturn)
 
+        CASE(Branches)
+            // branches do not break the enclosing loop
+            for (const auto& child : shadow.getChildren()) {
+                execute(child.get(), ctxt);
+            }
+            return true;
+        ESAC(Branches)
+
         CASE(Sequence)
             for (const auto& child : shadow.getChildren()) {
                 if (!execute(child.get(), ctxt)) {
@@ -1134,7 +2147,25 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         ESAC(Sequence)
 
         CASE(Parallel)
-            for (const auto& child : shadow.getChildren()) {
+            const auto& children = shadow.getChildren();
+            if (isConcurrent(cur)) {
+                // each statement runs on a context of its own, and the threads are divided among the
+                // statements being executed for their parallel operations
+                const std::size_t tasks = std::min(numOfThreads, children.size());
+                ctxt.reserveThreadContexts(children.size());
+                std::atomic<bool> proceed{true};
+                NestedParallelism nested(numOfThreads, tasks);
+                PARALLEL_START_THREADS(tasks)
+                    nested.budget(thread_number());
+                    pfor(std::size_t i = 0; i < children.size(); ++i) {
+                        if (!execute(children[i].get(), ctxt.getThreadContext(i))) {
+                            proceed = false;
+                        }
+                    }
+                PARALLEL_END
+                return proceed;
+            }
+            for (const auto& child : children) {
                 if (!execute(child.get(), ctxt)) {
                     return false;
                 }
@@ -1144,37 +2175,80 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 
         CASE(Loop)
             resetIterationNumber();
-            while (execute(shadow.getChild(), ctxt)) {
+            while (true) {
+                // the sizes of the relations change in each iteration
+                if (joinPlanner != nullptr) {
+                    joinPlanner->invalidateSizes();
+                }
+                if (isCancelled()) {
+                    break;
+                }
+                if (!execute(shadow.getChild(), ctxt)) {
+                    break;
+                }
                 incIterationNumber();
+                if (memoryLimit != 0) {
+                    checkMemoryLimit(false);
+                }
             }
             resetIterationNumber();
             return true;
         ESAC(Loop)
 
+        case I_Worklist:
+            // there is no RAM node of the worklist; its shadow is the loop it evaluates
+            return evalWorklist(*static_cast<const Worklist*>(node), ctxt);
+
         CASE(Exit)
             return !execute(shadow.getChild(), ctxt);
         ESAC(Exit)
 
         CASE(LogRelationTimer)
+            if (sampler != nullptr) {
+                ProfileSampler::Scope scope(*sampler, cur.getMessage(), getIterationNumber());
+                return execute(shadow.getChild(), ctxt);
+            }
             Logger logger(cur.getMessage(), getIterationNumber(),
                     std::bind(&RelationWrapper::size, shadow.getRelation()));
             return execute(shadow.getChild(), ctxt);
         ESAC(LogRelationTimer)
 
         CASE(LogTimer)
+            if (sampler != nullptr) {
+                ProfileSampler::Scope scope(*sampler, cur.getMessage(), getIterationNumber());
+                return execute(shadow.getChild(), ctxt);
+            }
             Logger logger(cur.getMessage(), getIterationNumber());
             return execute(shadow.getChild(), ctxt);
         ESAC(LogTimer)
 
         CASE(DebugInfo)
             SignalHandler::instance()->setMsg(cur.getMessage().c_str());
-            return execute(shadow.getChild(), ctxt);
+            if (!ruleStatisticsEnabled) {
+                return execute(shadow.getChild(), ctxt);
+            }
+            time_point start = now();
+            RamDomain result = execute(shadow.getChild(), ctxt);
+            auto& stats = ruleStatistics[&cur];
+            ++stats.executions;
+            stats.time += duration_in_us(start, now());
+            return result;
         ESAC(DebugInfo)
 
 #define CLEAR(Structure, Arity, ...)                              \
     CASE(Clear, Structure, Arity)                                 \
+        if (asyncOutput != nullptr) {                             \
+            asyncOutput->wait(shadow.getRelation());              \
+        }                                                         \
         auto& rel = *static_cast<RelType*>(shadow.getRelation()); \
-        rel.__purge();                                            \
+        if (shadow.retainsStorage()) {                            \
+            rel.__recycle();                                      \
+        } else {                                                  \
+            rel.__purge();                                        \
+        }                                                         \
+        if (shadow.dropsRelation()) {                             \
+            NodePools::trim();                                    \
+        }                                                         \
         return true;                                              \
     ESAC(Clear)
 
@@ -1182,10 +2256,94 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 #undef CLEAR
 
         CASE(Call)
-            execute(subroutine[shadow.getSubroutineId()].get(), ctxt);
+            if (isCancelled() ||
+                    (!selectedSubroutines.empty() && !selectedSubroutines[shadow.getSubroutineId()])) {
+                // the relations of a skipped or cancelled stratum are brought up to date by the next run
+                // evaluating it
+                if (incremental) {
+                    staleSubroutines[shadow.getSubroutineId()] = true;
+                    if (!evaluated) {
+                        unloadedSubroutines[shadow.getSubroutineId()] = true;
+                    }
+                }
+                return true;
+            }
+            if (incremental) {
+                loadInputs = !evaluated || unloadedSubroutines[shadow.getSubroutineId()];
+                if (!prepareSubroutine(shadow.getSubroutineId())) {
+                    return true;
+                }
+                staleSubroutines[shadow.getSubroutineId()] = false;
+                unloadedSubroutines[shadow.getSubroutineId()] = false;
+            }
+            if (joinPlanner != nullptr) {
+                joinPlanner->invalidateSizes();
+            }
+            if (profileEnabled) {
+                ProfileEventSingleton::instance().makeStratumEvent(cur.getName());
+            }
+            if (!nativeSubroutines.empty() && nativeSubroutines[shadow.getSubroutineId()]) {
+                executeNative(shadow.getSubroutineId(), cur.getName());
+            } else {
+                // the indexes not maintained while their relations were computed are built at once
+                buildIndexes(shadow.getSubroutineId());
+                execute(subroutine[shadow.getSubroutineId()].get(), ctxt);
+            }
+            if (profileEnabled) {
+                profileSubroutineMemory(shadow.getSubroutineId());
+                // record the events buffered by the threads at the end of each stratum
+                ProfileEventSingleton::instance().flush();
+            }
+            if (compactRelations) {
+                compactSubroutine(shadow.getSubroutineId());
+            }
+            freezeSubroutine(shadow.getSubroutineId());
+            if (bloomFilters) {
+                buildFilters(shadow.getSubroutineId());
+            }
+            if (memoryLimit != 0) {
+                checkMemoryLimit(true);
+            }
+            if (incremental && isCancelled()) {
+                // the evaluation of the stratum may have been cut short
+                staleSubroutines[shadow.getSubroutineId()] = true;
+            }
+            if (stratumCallback && isPrefix("stratum_", cur.getName()) && !isCancelled()) {
+                stratumCallback(std::stoul(cur.getName().substr(8)));
+            }
             return true;
         ESAC(Call)
 
+        CASE(CompactTables)
+            if (asyncOutput != nullptr) {
+                asyncOutput->wait();
+            }
+            compactTables(cur, shadow);
+            return true;
+        ESAC(CompactTables)
+
+        CASE(Checkpoint)
+            if (cur.isResume()) {
+                checkpoint::restore(cur.getDirectory(), cur.getStep(), getSymbolTable(), getRecordTable());
+            } else if (!isCancelled()) {
+                // the strata of a cancelled evaluation may be incomplete, thus the previous checkpoint stays
+                checkpoint::save(cur.getDirectory(), cur.getStep(), cur.getSteps(), cur.getFiles(),
+                        getSymbolTable(), getRecordTable());
+            }
+            return true;
+        ESAC(Checkpoint)
+
+        CASE(StratumCache)
+            return evalStratumCache(cur, shadow, ctxt);
+        ESAC(StratumCache)
+
+        CASE(Guard)
+            if (!execute(shadow.getLhs(), ctxt)) {
+                return true;
+            }
+            return execute(shadow.getRhs(), ctxt);
+        ESAC(Guard)
+
         CASE(LogSize)
             const auto& rel = *shadow.getRelation();
             ProfileEventSingleton::instance().makeQuantityEvent(
@@ -1198,16 +2356,46 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
             const std::string& op = cur.get("operation");
             auto& rel = *shadow.getRelation();
 
-            if (op == "input") {
+            if (op == "input" || op == "restore") {
+                if (evaluated && op == "input" && !loadInputs) {
+                    // Facts of an incremental re-run are supplied through the program interface
+                    return true;
+                }
                 try {
-                    IOSystem::getInstance()
-                            .getReader(directive, getSymbolTable(), getRecordTable())
-                            ->readAll(rel);
+                    auto reader = IOSystem::getInstance().getReader(
+                            directive, getSymbolTable(), getRecordTable());
+                    rel.load(*reader);
+                    if (reader->hasMoreBatches() && incremental) {
+                        // the further batches are read by readNextBatch, one per run
+                        streams.emplace_back(&rel, std::move(reader));
+                    } else {
+                        while (reader->hasMoreBatches()) {
+                            rel.load(*reader);
+                        }
+                    }
                 } catch (std::exception& e) {
                     std::cerr << "Error loading " << rel.getName() << " data: " << e.what() << "\n";
                 }
                 return true;
-            } else if (op == "output" || op == "printsize") {
+            } else if (op == "output" && streaming) {
+                try {
+                    writeDelta(directive, rel);
+                } catch (std::exception& e) {
+                    std::cerr << e.what();
+                    exit(EXIT_FAILURE);
+                }
+                return true;
+            } else if (op == "output" && asyncOutput != nullptr &&
+                       directive.at("IO").compare(0, 6, "stdout") != 0) {
+                // the relation is final, and written while later strata are evaluated; writes to the
+                // standard output stay in order
+                asyncOutput->submit(&rel, [this, &directive, &rel]() {
+                    IOSystem::getInstance()
+                            .getWriter(directive, getSymbolTable(), getRecordTable())
+                            ->writeAll(rel);
+                });
+                return true;
+            } else if (op == "output" || op == "printsize" || op == "spill") {
                 try {
                     IOSystem::getInstance()
                             .getWriter(directive, getSymbolTable(), getRecordTable())
@@ -1224,8 +2412,22 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
         ESAC(IO)
 
         CASE(Query)
+            if (isCancelled()) {
+                return true;
+            }
+            if (joinPlanner != nullptr) {
+                if (const Node* plan = joinPlanner->getPlan(shadow)) {
+                    return execute(plan, ctxt);
+                }
+            }
+            JoinPlanner::Measurement measurement(emitPlans ? joinPlanner.get() : nullptr, shadow);
             ViewContext* viewContext = shadow.getViewContext();
 
+            // Build the indexes searched for the first time since their relation became stable.
+            for (auto& info : viewContext->getOnDemandIndexes()) {
+                getRelationHandle(info[0])->buildIndex(info[1]);
+            }
+
             // Execute view-free operations in outer filter if any.
             auto& viewFreeOps = viewContext->getOuterFilterViewFreeOps();
             for (auto& op : viewFreeOps) {
@@ -1272,6 +2474,34 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
             swapRelation(shadow.getSourceId(), shadow.getTargetId());
             return true;
         ESAC(Swap)
+
+// The shadows of bulk insertions and erasures are ram::Query nodes, hence the cases are spelt out.
+#define BULK_INSERT(Structure, Arity, ...)                                                                \
+    case (I_BulkInsert_##Structure##_##Arity): {                                                          \
+        const auto& shadow = *static_cast<const interpreter::BulkInsert*>(node);                          \
+        using RelType = Relation<Arity, interpreter::Structure>;                                          \
+        const auto& src = *static_cast<RelType*>(getRelationHandle(shadow.getSourceId()).get());          \
+        auto& trg = *static_cast<RelType*>(getRelationHandle(shadow.getTargetId()).get());                \
+        trg.insert(src);                                                                                  \
+        countInserts(shadow, src.size());                                                                 \
+        return true;                                                                                      \
+    }
+
+        FOR_EACH(BULK_INSERT)
+#undef BULK_INSERT
+
+#define BULK_ERASE(Structure, Arity, ...)                                                                 \
+    case (I_BulkErase_##Structure##_##Arity): {                                                           \
+        const auto& shadow = *static_cast<const interpreter::BulkErase*>(node);                           \
+        using RelType = BtreeDeleteRelation<Arity>;                                                       \
+        const auto& src = *getRelationHandle(shadow.getSourceId());                                       \
+        auto& trg = *static_cast<RelType*>(getRelationHandle(shadow.getTargetId()).get());                \
+        trg.eraseAll(src);                                                                                \
+        return true;                                                                                      \
+    }
+
+        FOR_EACH_BTREE_DELETE(BULK_ERASE)
+#undef BULK_ERASE
     }
 
     UNREACHABLE_BAD_CASE_ANALYSIS
@@ -1280,19 +2510,115 @@ RamDomain Engine::execute(const Node* node, Context& ctxt) {
 #undef DEBUG
 }
 
+RamDomain Engine::evalOperand(const Constraint::Operand& operand, const Node* expr, Context& ctxt) {
+    switch (operand.kind) {
+        case Constraint::Operand::Constant: return operand.constant;
+        case Constraint::Operand::Element: return ctxt[operand.tupleId][operand.element];
+        case Constraint::Operand::Expression: break;
+    }
+    return execute(expr, ctxt);
+}
+
+RamDomain Engine::evalConstraint(const Constraint& shadow, Context& ctxt) {
+    const auto& cur = *static_cast<const ram::Constraint*>(shadow.getShadow());
+// clang-format off
+#define EVAL_OPERAND(ty, side) \
+    ramBitCast<ty>(evalOperand(shadow.get##side##Operand(), shadow.get##side(), ctxt))
+#define COMPARE_NUMERIC(ty, op) return EVAL_OPERAND(ty, Lhs) op EVAL_OPERAND(ty, Rhs)
+#define COMPARE_STRING(op)                                                                   \
+    return (getSymbolTable().compare(EVAL_OPERAND(RamDomain, Lhs), EVAL_OPERAND(RamDomain, Rhs)) op 0)
+#define COMPARE_EQ_NE(opCode, op)                                         \
+    case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamDomain  , op); \
+    case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op);
+#define COMPARE(opCode, op)                                               \
+    case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamSigned  , op); \
+    case BinaryConstraintOp::U##opCode: COMPARE_NUMERIC(RamUnsigned, op); \
+    case BinaryConstraintOp::F##opCode: COMPARE_NUMERIC(RamFloat   , op); \
+    case BinaryConstraintOp::S##opCode: COMPARE_STRING(op);
+    // clang-format on
+
+    switch (cur.getOperator()) {
+        COMPARE_EQ_NE(EQ, ==)
+        COMPARE_EQ_NE(NE, !=)
+
+        COMPARE(LT, <)
+        COMPARE(LE, <=)
+        COMPARE(GT, >)
+        COMPARE(GE, >=)
+
+        case BinaryConstraintOp::MATCH:
+        case BinaryConstraintOp::NOT_MATCH: {
+            const bool negated = cur.getOperator() == BinaryConstraintOp::NOT_MATCH;
+            RamDomain left = EVAL_OPERAND(RamDomain, Lhs);
+            RamDomain right = EVAL_OPERAND(RamDomain, Rhs);
+            const std::string& text = getSymbolTable().decode(right);
+            // constant patterns are compiled by the generator, others are cached per thread
+            const evaluator::CompiledRegex* regex = shadow.getRegex();
+            if (regex == nullptr) {
+                regex = &evaluator::getCachedRegex(getSymbolTable().decode(left));
+            }
+            bool valid = regex->has_value();
+            bool matched = false;
+            if (valid) {
+                try {
+                    matched = std::regex_match(text, **regex);
+                } catch (...) {
+                    valid = false;
+                }
+            }
+            if (!valid) {
+                std::cerr << "warning: wrong pattern provided for " << (negated ? "!" : "") << "match(\""
+                          << getSymbolTable().decode(left) << "\",\"" << text << "\").\n";
+                return false;
+            }
+            return matched != negated;
+        }
+        case BinaryConstraintOp::CONTAINS: {
+            RamDomain left = execute(shadow.getLhs(), ctxt);
+            RamDomain right = execute(shadow.getRhs(), ctxt);
+            const std::string& pattern = getSymbolTable().decode(left);
+            const std::string& text = getSymbolTable().decode(right);
+            return text.find(pattern) != std::string::npos;
+        }
+        case BinaryConstraintOp::NOT_CONTAINS: {
+            RamDomain left = execute(shadow.getLhs(), ctxt);
+            RamDomain right = execute(shadow.getRhs(), ctxt);
+            const std::string& pattern = getSymbolTable().decode(left);
+            const std::string& text = getSymbolTable().decode(right);
+            return text.find(pattern) == std::string::npos;
+        }
+    }
+
+    { UNREACHABLE_BAD_CASE_ANALYSIS }
+
+#undef COMPARE_NUMERIC
+#undef COMPARE_STRING
+#undef COMPARE
+#undef COMPARE_EQ_NE
+#undef EVAL_OPERAND
+}
+
+bool Engine::evalCondition(const Node* cond, Context& ctxt) {
+    // the most frequent conditions are comparisons, which are evaluated without a dispatch
+    if (cond->getType() == I_Constraint) {
+        return evalConstraint(*static_cast<const Constraint*>(cond), ctxt);
+    }
+    return execute(cond, ctxt);
+}
+
 template <typename Rel>
 RamDomain Engine::evalExistenceCheck(const ExistenceCheck& shadow, Context& ctxt) {
-    constexpr std::size_t Arity = Rel::Arity;
     std::size_t viewPos = shadow.getViewId();
 
     if (profileEnabled && !shadow.isTemp()) {
         reads[shadow.getRelationName()]++;
     }
+    countProbe(shadow);
 
     const auto& superInfo = shadow.getSuperInst();
     // for total we use the exists test
     if (shadow.isTotalSearch()) {
-        souffle::Tuple<RamDomain, Arity> tuple;
+        auto tuple = Rel::makeTuple(superInfo.first.size());
         TUPLE_COPY_FROM(tuple, superInfo.first);
         /* TupleElement */
         for (const auto& tupleElement : superInfo.tupleFirst) {
@@ -1302,12 +2628,17 @@ RamDomain Engine::evalExistenceCheck(const ExistenceCheck& shadow, Context& ctxt
         for (const auto& expr : superInfo.exprFirst) {
             tuple[expr.first] = execute(expr.second.get(), ctxt);
         }
+        // most tuples not in the relation are rejected by its filter without descending the index
+        if (shadow.isFiltered() &&
+                !static_cast<const Rel*>(shadow.getRelation())->mayContain(shadow.getIndexPos(), tuple)) {
+            return false;
+        }
         return Rel::castView(ctxt.getView(viewPos))->contains(tuple);
     }
 
     // for partial we search for lower and upper boundaries
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     TUPLE_COPY_FROM(low, superInfo.first);
     TUPLE_COPY_FROM(high, superInfo.second);
 
@@ -1357,6 +2688,7 @@ RamDomain Engine::evalProvenanceExistenceCheck(const ProvenanceExistenceCheck& s
 
     // obtain view
     std::size_t viewPos = shadow.getViewId();
+    countProbe(shadow);
 
     // get an equalRange
     auto equalRange = Rel::castView(ctxt.getView(viewPos))->range(low, high);
@@ -1386,76 +2718,296 @@ RamDomain Engine::evalParallelScan(
         const Rel& rel, const ram::ParallelScan& cur, const ParallelScan& shadow, Context& ctxt) {
     auto viewContext = shadow.getViewContext();
 
-    auto pStream = rel.partitionScan(numOfThreads);
+    auto pStream = rel.partitionScan(getPartitionCount());
 
-    PARALLEL_START
-        Context newCtxt(ctxt);
-        auto viewInfo = viewContext->getViewInfoForNested();
-        for (const auto& info : viewInfo) {
+    // the aggregate of each scanned tuple is looked up if it was computed for all groups at once
+    AggregateGroups groups;
+    const IndexAggregate* grouped = shadow.getGroupedAggregate();
+    if (grouped != nullptr && !accumulateGroups(shadow, rel.size(), groups, ctxt)) {
+        grouped = nullptr;
+    }
+
+    // the chunks of the threads are timed for the profile of the rule, if it is profiled
+    Logger* logger = Logger::current();
+    const std::size_t threads = getThreadCount(cur.getRelation(), rel.size());
+    ctxt.reserveThreadContexts(threads);
+    deferInserts(shadow, rel.size(), threads, ctxt);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
+        for (const auto& info : viewContext->getViewInfoForNested()) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
+        std::vector<RamDomain> key(grouped != nullptr ? grouped->getSuperInst().tupleFirst.size() : 0);
         pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+            Logger::ChunkTimer chunkTimer(logger);
             for (const auto& tuple : *it) {
                 newCtxt[cur.getTupleId()] = tuple.data();
-                if (!execute(shadow.getNestedOperation(), newCtxt)) {
+                const bool proceed = grouped != nullptr ? finishGroup(*grouped, groups, key, newCtxt)
+                                                        : execute(shadow.getNestedOperation(), newCtxt);
+                if (!proceed) {
                     break;
                 }
             }
         }
     PARALLEL_END
+    mergeInsertBuffers(shadow, threads, ctxt);
+    return true;
+}
+
+RamDomain Engine::callUserDefinedOperator(
+        const ram::UserDefinedOperator& cur, const UserDefinedOperator& shadow, const RamDomain* args) {
+    auto userFunctor = shadow.getFunctor();
+    std::size_t arity = cur.getArguments().size();
+
+    if (shadow.isDirect()) {
+        if (cur.isStateful()) {
+            void* symbolTable = (void*)&getSymbolTable();
+            void* recordTable = (void*)&getRecordTable();
+            if (auto* contexts = shadow.getContexts()) {
+                void* context = contexts->get();
+                return callFunctor(userFunctor, arity, args, symbolTable, recordTable, context);
+            }
+            return callFunctor(userFunctor, arity, args, symbolTable, recordTable);
+        }
+        return callFunctor(userFunctor, arity, args);
+    }
+
+    if (cur.isStateful()) {
+        // prepare dynamic call environment
+        void* values[arity + 3];
+        RamDomain intVal[arity];
+        ffi_arg rc;
+
+        /* Initialize arguments for ffi-call */
+        std::size_t leading = 0;
+        void* symbolTable = (void*)&getSymbolTable();
+        values[leading++] = &symbolTable;
+        void* recordTable = (void*)&getRecordTable();
+        values[leading++] = &recordTable;
+        void* context = nullptr;
+        if (auto* contexts = shadow.getContexts()) {
+            context = contexts->get();
+            values[leading++] = &context;
+        }
+        for (std::size_t i = 0; i < arity; i++) {
+            intVal[i] = args[i];
+            values[i + leading] = &intVal[i];
+        }
+
+        // Call the external function.
+        ffi_call(shadow.getCallInterface(), userFunctor, &rc, values);
+        return static_cast<RamDomain>(rc);
+    } else {
+        const std::vector<TypeAttribute>& types = cur.getArgsTypes();
+
+        // prepare dynamic call environment
+        void* values[arity];
+        RamDomain intVal[arity];
+        RamUnsigned uintVal[arity];
+        RamFloat floatVal[arity];
+        const char* strVal[arity];
+
+        /* Initialize arguments for ffi-call */
+        for (std::size_t i = 0; i < arity; i++) {
+            RamDomain arg = args[i];
+            switch (types[i]) {
+                case TypeAttribute::Symbol:
+                    strVal[i] = getSymbolTable().decode(arg).c_str();
+                    values[i] = &strVal[i];
+                    break;
+                case TypeAttribute::Signed:
+                    intVal[i] = arg;
+                    values[i] = &intVal[i];
+                    break;
+                case TypeAttribute::Unsigned:
+                    uintVal[i] = ramBitCast<RamUnsigned>(arg);
+                    values[i] = &uintVal[i];
+                    break;
+                case TypeAttribute::Float:
+                    floatVal[i] = ramBitCast<RamFloat>(arg);
+                    values[i] = &floatVal[i];
+                    break;
+                case TypeAttribute::ADT: fatal("ADT support is not implemented");
+                case TypeAttribute::Record: fatal("Record support is not implemented");
+            }
+        }
+
+        // Call †he functor and return
+        // Float return type needs special treatment, see https://stackoverflow.com/q/61577543
+        if (cur.getReturnType() == TypeAttribute::Float) {
+            RamFloat rvalue;
+            ffi_call(shadow.getCallInterface(), userFunctor, &rvalue, values);
+            return ramBitCast(rvalue);
+        } else {
+            ffi_arg rvalue;
+            ffi_call(shadow.getCallInterface(), userFunctor, &rvalue, values);
+
+            switch (cur.getReturnType()) {
+                case TypeAttribute::Signed: return static_cast<RamDomain>(rvalue);
+                case TypeAttribute::Symbol:
+                    return getSymbolTable().encode(reinterpret_cast<const char*>(rvalue));
+                case TypeAttribute::Unsigned: return ramBitCast(static_cast<RamUnsigned>(rvalue));
+                case TypeAttribute::Float: fatal("Floats must be handled seperately");
+                case TypeAttribute::ADT: fatal("Not implemented");
+                case TypeAttribute::Record: fatal("Not implemented");
+            }
+            fatal("Unsupported user defined operator");
+        }
+    }
+}
+
+template <typename A>
+RamDomain Engine::evalParallelRange(const ram::ParallelNestedIntrinsicOperator& cur,
+        const ParallelNestedIntrinsicOperator& shadow, Context& ctxt) {
+    auto viewContext = shadow.getViewContext();
+
+    const std::size_t numArgs = cur.getArguments().size();
+    const auto from = ramBitCast<A>(execute(shadow.getChild(0), ctxt));
+    const auto to = ramBitCast<A>(execute(shadow.getChild(1), ctxt));
+    const A step =
+            numArgs == 3 ? ramBitCast<A>(execute(shadow.getChild(2), ctxt)) : evaluator::rangeStep(from, to);
+    const std::size_t size = evaluator::rangeSize(from, to, step);
+    const std::size_t parts = evaluator::rangePartCount(size);
+
+    // the chunks of the threads are timed for the profile of the rule, if it is profiled
+    Logger* logger = Logger::current();
+    const std::size_t threads = getThreadCount("", size);
+    ctxt.reserveThreadContexts(threads);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
+        for (const auto& info : viewContext->getViewInfoForNested()) {
+            newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+        }
+        pfor(std::size_t part = 0; part < parts; ++part) {
+            Logger::ChunkTimer chunkTimer(logger);
+            evaluator::runRangePart(from, step, size, part, parts, [&](auto&& tuple) {
+                newCtxt[cur.getTupleId()] = tuple.data();
+                execute(shadow.getChild(numArgs), newCtxt);
+            });
+        }
+    PARALLEL_END
     return true;
 }
 
 template <typename Rel>
 RamDomain Engine::evalIndexScan(const ram::IndexScan& cur, const IndexScan& shadow, Context& ctxt) {
-    constexpr std::size_t Arity = Rel::Arity;
     // create pattern tuple for range query
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     CAL_SEARCH_BOUND(superInfo, low, high);
 
     std::size_t viewId = shadow.getViewId();
     auto view = Rel::castView(ctxt.getView(viewId));
+    countScan(shadow);
+    std::size_t tuples = 0;
     // conduct range query
     for (const auto& tuple : view->range(low, high)) {
+        ++tuples;
         ctxt[cur.getTupleId()] = tuple.data();
         if (!execute(shadow.getNestedOperation(), ctxt)) {
             break;
         }
     }
+    countTuples(shadow, tuples);
     return true;
 }
 
+template <typename Rel>
+RamDomain Engine::evalIndexIntersect(
+        const ram::IndexIntersect& cur, const IndexIntersect& shadow, Context& ctxt) {
+    constexpr std::size_t Arity = Rel::Arity;
+    if constexpr (Arity == 0) {
+        fatal("ICE: index intersection of nullary relation `%s`", cur.getRelation());
+    } else {
+        // create pattern tuples for the range queries of both relations
+        const auto& superInfo = shadow.getSuperInst();
+        auto low = Rel::makeTuple(superInfo.first.size());
+        auto high = Rel::makeTuple(superInfo.first.size());
+        CAL_SEARCH_BOUND(superInfo, low, high);
+        const auto& partnerInfo = shadow.getPartnerSuperInst();
+        auto partnerLow = Rel::makeTuple(partnerInfo.first.size());
+        auto partnerHigh = Rel::makeTuple(partnerInfo.first.size());
+        CAL_SEARCH_BOUND(partnerInfo, partnerLow, partnerHigh);
+
+        auto view = Rel::castView(ctxt.getView(shadow.getViewId()));
+        auto partnerView = Rel::castView(ctxt.getView(shadow.getPartnerViewId()));
+        const std::size_t element = shadow.getElement();
+        const std::size_t partnerElement = shadow.getPartnerElement();
+
+        countScan(shadow);
+        std::size_t tuples = 0;
+        auto range = view->range(low, high);
+        auto it = range.begin();
+        while (it != range.end()) {
+            // seek the least value of the partner not below the current value
+            const RamDomain value = (*it)[element];
+            partnerLow[partnerElement] = value;
+            auto partners = partnerView->range(partnerLow, partnerHigh);
+            if (partners.empty()) {
+                break;
+            }
+            const RamDomain next = (*partners.begin())[partnerElement];
+
+            // leapfrog over the values absent in the partner
+            if (next != value) {
+                low[element] = next;
+                it = view->range(low, high).begin();
+                continue;
+            }
+
+            for (; it != range.end() && (*it)[element] == value; ++it) {
+                ++tuples;
+                ctxt[cur.getTupleId()] = (*it).data();
+                if (!execute(shadow.getNestedOperation(), ctxt)) {
+                    countTuples(shadow, tuples);
+                    return true;
+                }
+            }
+        }
+        countTuples(shadow, tuples);
+        return true;
+    }
+}
+
 template <typename Rel>
 RamDomain Engine::evalParallelIndexScan(
         const Rel& rel, const ram::ParallelIndexScan& cur, const ParallelIndexScan& shadow, Context& ctxt) {
     auto viewContext = shadow.getViewContext();
 
     // create pattern tuple for range query
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     CAL_SEARCH_BOUND(superInfo, low, high);
 
     std::size_t indexPos = shadow.getViewId();
-    auto pStream = rel.partitionRange(indexPos, low, high, numOfThreads);
-    PARALLEL_START
-        Context newCtxt(ctxt);
-        auto viewInfo = viewContext->getViewInfoForNested();
-        for (const auto& info : viewInfo) {
+    auto pStream = rel.partitionRange(indexPos, low, high, getPartitionCount());
+    countScan(shadow);
+    Logger* logger = Logger::current();
+    const std::size_t threads = getThreadCount(cur.getRelation(), rel.size());
+    ctxt.reserveThreadContexts(threads);
+    // the range is bounded by the size of the scanned relation
+    deferInserts(shadow, rel.size(), threads, ctxt);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
+        for (const auto& info : viewContext->getViewInfoForNested()) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
         pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+            Logger::ChunkTimer chunkTimer(logger);
+            std::size_t tuples = 0;
             for (const auto& tuple : *it) {
+                ++tuples;
                 newCtxt[cur.getTupleId()] = tuple.data();
                 if (!execute(shadow.getNestedOperation(), newCtxt)) {
                     break;
                 }
             }
+            countTuples(shadow, tuples);
         }
     PARALLEL_END
+    mergeInsertBuffers(shadow, threads, ctxt);
     return true;
 }
 
@@ -1465,7 +3017,7 @@ RamDomain Engine::evalIfExists(
     // use simple iterator
     for (const auto& tuple : rel.scan()) {
         ctxt[cur.getTupleId()] = tuple.data();
-        if (execute(shadow.getCondition(), ctxt)) {
+        if (evalCondition(shadow.getCondition(), ctxt)) {
             execute(shadow.getNestedOperation(), ctxt);
             break;
         }
@@ -1478,17 +3030,21 @@ RamDomain Engine::evalParallelIfExists(
         const Rel& rel, const ram::ParallelIfExists& cur, const ParallelIfExists& shadow, Context& ctxt) {
     auto viewContext = shadow.getViewContext();
 
-    auto pStream = rel.partitionScan(numOfThreads);
-    auto viewInfo = viewContext->getViewInfoForNested();
-    PARALLEL_START
-        Context newCtxt(ctxt);
+    auto pStream = rel.partitionScan(getPartitionCount());
+    const auto& viewInfo = viewContext->getViewInfoForNested();
+    Logger* logger = Logger::current();
+    const std::size_t threads = getThreadCount(cur.getRelation(), rel.size());
+    ctxt.reserveThreadContexts(threads);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
         for (const auto& info : viewInfo) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
         pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+            Logger::ChunkTimer chunkTimer(logger);
             for (const auto& tuple : *it) {
                 newCtxt[cur.getTupleId()] = tuple.data();
-                if (execute(shadow.getCondition(), newCtxt)) {
+                if (evalCondition(shadow.getCondition(), newCtxt)) {
                     execute(shadow.getNestedOperation(), newCtxt);
                     break;
                 }
@@ -1501,22 +3057,25 @@ RamDomain Engine::evalParallelIfExists(
 template <typename Rel>
 RamDomain Engine::evalIndexIfExists(
         const ram::IndexIfExists& cur, const IndexIfExists& shadow, Context& ctxt) {
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     CAL_SEARCH_BOUND(superInfo, low, high);
 
     std::size_t viewId = shadow.getViewId();
     auto view = Rel::castView(ctxt.getView(viewId));
+    countScan(shadow);
+    std::size_t tuples = 0;
 
     for (const auto& tuple : view->range(low, high)) {
+        ++tuples;
         ctxt[cur.getTupleId()] = tuple.data();
-        if (execute(shadow.getCondition(), ctxt)) {
+        if (evalCondition(shadow.getCondition(), ctxt)) {
             execute(shadow.getNestedOperation(), ctxt);
             break;
         }
     }
+    countTuples(shadow, tuples);
     return true;
 }
 
@@ -1525,202 +3084,394 @@ RamDomain Engine::evalParallelIndexIfExists(const Rel& rel, const ram::ParallelI
         const ParallelIndexIfExists& shadow, Context& ctxt) {
     auto viewContext = shadow.getViewContext();
 
-    auto viewInfo = viewContext->getViewInfoForNested();
+    const auto& viewInfo = viewContext->getViewInfoForNested();
 
     // create pattern tuple for range query
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     CAL_SEARCH_BOUND(superInfo, low, high);
 
     std::size_t indexPos = shadow.getViewId();
-    auto pStream = rel.partitionRange(indexPos, low, high, numOfThreads);
-
-    PARALLEL_START
-        Context newCtxt(ctxt);
+    auto pStream = rel.partitionRange(indexPos, low, high, getPartitionCount());
+    countScan(shadow);
+
+    Logger* logger = Logger::current();
+    const std::size_t threads = getThreadCount(cur.getRelation(), rel.size());
+    ctxt.reserveThreadContexts(threads);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
         for (const auto& info : viewInfo) {
             newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
         }
         pfor(auto it = pStream.begin(); it < pStream.end(); it++) {
+            Logger::ChunkTimer chunkTimer(logger);
+            std::size_t tuples = 0;
             for (const auto& tuple : *it) {
+                ++tuples;
                 newCtxt[cur.getTupleId()] = tuple.data();
-                if (execute(shadow.getCondition(), newCtxt)) {
+                if (evalCondition(shadow.getCondition(), newCtxt)) {
                     execute(shadow.getNestedOperation(), newCtxt);
                     break;
                 }
             }
+            countTuples(shadow, tuples);
         }
     PARALLEL_END
 
     return true;
 }
 
-template <typename Aggregate, typename Iter>
-RamDomain Engine::evalAggregate(const Aggregate& aggregate, const Node& filter, const Node* expression,
-        const Node& nestedOperation, const Iter& ranges, Context& ctxt) {
-    bool shouldRunNested = false;
-
-    // initialize result
-    RamDomain res = 0;
-
-    // Use for calculating mean.
-    std::pair<RamFloat, RamFloat> accumulateMean;
+Engine::AggregateState Engine::initAggregate(AggregateOp function) {
+    AggregateState state;
 
-    switch (aggregate.getFunction()) {
-        case AggregateOp::MIN: res = ramBitCast(MAX_RAM_SIGNED); break;
-        case AggregateOp::UMIN: res = ramBitCast(MAX_RAM_UNSIGNED); break;
-        case AggregateOp::FMIN: res = ramBitCast(MAX_RAM_FLOAT); break;
+    switch (function) {
+        case AggregateOp::MIN: state.res = ramBitCast(MAX_RAM_SIGNED); break;
+        case AggregateOp::UMIN: state.res = ramBitCast(MAX_RAM_UNSIGNED); break;
+        case AggregateOp::FMIN: state.res = ramBitCast(MAX_RAM_FLOAT); break;
 
-        case AggregateOp::MAX: res = ramBitCast(MIN_RAM_SIGNED); break;
-        case AggregateOp::UMAX: res = ramBitCast(MIN_RAM_UNSIGNED); break;
-        case AggregateOp::FMAX: res = ramBitCast(MIN_RAM_FLOAT); break;
+        case AggregateOp::MAX: state.res = ramBitCast(MIN_RAM_SIGNED); break;
+        case AggregateOp::UMAX: state.res = ramBitCast(MIN_RAM_UNSIGNED); break;
+        case AggregateOp::FMAX: state.res = ramBitCast(MIN_RAM_FLOAT); break;
 
         case AggregateOp::SUM:
-            res = ramBitCast(static_cast<RamSigned>(0));
-            shouldRunNested = true;
+            state.res = ramBitCast(static_cast<RamSigned>(0));
+            state.shouldRunNested = true;
             break;
         case AggregateOp::USUM:
-            res = ramBitCast(static_cast<RamUnsigned>(0));
-            shouldRunNested = true;
+            state.res = ramBitCast(static_cast<RamUnsigned>(0));
+            state.shouldRunNested = true;
             break;
         case AggregateOp::FSUM:
-            res = ramBitCast(static_cast<RamFloat>(0));
-            shouldRunNested = true;
+            state.res = ramBitCast(static_cast<RamFloat>(0));
+            state.shouldRunNested = true;
             break;
 
-        case AggregateOp::MEAN:
-            res = 0;
-            accumulateMean = {0, 0};
-            break;
+        case AggregateOp::MEAN: state.res = 0; break;
 
         case AggregateOp::COUNT:
-            res = 0;
-            shouldRunNested = true;
+            state.res = 0;
+            state.shouldRunNested = true;
+            break;
+        case AggregateOp::COUNT_APPROX:
+            state.res = 0;
+            state.sketch.emplace();
+            state.shouldRunNested = true;
+            break;
+    }
+    return state;
+}
+
+void Engine::accumulateTuple(
+        AggregateOp function, const Node* expression, Context& ctxt, AggregateState& state) {
+    RamDomain& res = state.res;
+    state.shouldRunNested = true;
+
+    // count is a special case.
+    if (function == AggregateOp::COUNT) {
+        ++res;
+        return;
+    }
+
+    // eval target expression
+    assert(expression);  // only case where this is null is `COUNT`
+    RamDomain val = execute(expression, ctxt);
+
+    switch (function) {
+        case AggregateOp::MIN: res = std::min(res, val); break;
+        case AggregateOp::FMIN:
+            res = ramBitCast(std::min(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
+            break;
+        case AggregateOp::UMIN:
+            res = ramBitCast(std::min(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
+            break;
+
+        case AggregateOp::MAX: res = std::max(res, val); break;
+        case AggregateOp::FMAX:
+            res = ramBitCast(std::max(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
+            break;
+        case AggregateOp::UMAX:
+            res = ramBitCast(std::max(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
+            break;
+
+        case AggregateOp::SUM: res += val; break;
+        case AggregateOp::FSUM:
+            res = ramBitCast(ramBitCast<RamFloat>(res) + ramBitCast<RamFloat>(val));
             break;
+        case AggregateOp::USUM:
+            res = ramBitCast(ramBitCast<RamUnsigned>(res) + ramBitCast<RamUnsigned>(val));
+            break;
+
+        case AggregateOp::MEAN:
+            state.accumulateMean.first += ramBitCast<RamFloat>(val);
+            state.accumulateMean.second++;
+            break;
+
+        case AggregateOp::COUNT_APPROX: state.sketch->insert(val); break;
+
+        case AggregateOp::COUNT: fatal("This should never be executed");
     }
+}
 
+template <typename Aggregate, typename Iter>
+void Engine::accumulateAggregate(const Aggregate& aggregate, const Node& filter, const Node* expression,
+        const Iter& ranges, Context& ctxt, AggregateState& state) {
     for (const auto& tuple : ranges) {
         ctxt[aggregate.getTupleId()] = tuple.data();
 
-        if (!execute(&filter, ctxt)) {
+        if (!evalCondition(&filter, ctxt)) {
             continue;
         }
 
-        shouldRunNested = true;
-
-        // count is a special case.
-        if (aggregate.getFunction() == AggregateOp::COUNT) {
-            ++res;
-            continue;
-        }
+        accumulateTuple(aggregate.getFunction(), expression, ctxt, state);
+    }
+}
 
-        // eval target expression
-        assert(expression);  // only case where this is null is `COUNT`
-        RamDomain val = execute(expression, ctxt);
+void Engine::combineAggregate(AggregateOp function, AggregateState& state, const AggregateState& partial) {
+    RamDomain& res = state.res;
+    const RamDomain val = partial.res;
 
-        switch (aggregate.getFunction()) {
-            case AggregateOp::MIN: res = std::min(res, val); break;
-            case AggregateOp::FMIN:
-                res = ramBitCast(std::min(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
-                break;
-            case AggregateOp::UMIN:
-                res = ramBitCast(std::min(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
-                break;
+    switch (function) {
+        case AggregateOp::MIN: res = std::min(res, val); break;
+        case AggregateOp::FMIN:
+            res = ramBitCast(std::min(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
+            break;
+        case AggregateOp::UMIN:
+            res = ramBitCast(std::min(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
+            break;
 
-            case AggregateOp::MAX: res = std::max(res, val); break;
-            case AggregateOp::FMAX:
-                res = ramBitCast(std::max(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
-                break;
-            case AggregateOp::UMAX:
-                res = ramBitCast(std::max(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
-                break;
+        case AggregateOp::MAX: res = std::max(res, val); break;
+        case AggregateOp::FMAX:
+            res = ramBitCast(std::max(ramBitCast<RamFloat>(res), ramBitCast<RamFloat>(val)));
+            break;
+        case AggregateOp::UMAX:
+            res = ramBitCast(std::max(ramBitCast<RamUnsigned>(res), ramBitCast<RamUnsigned>(val)));
+            break;
 
-            case AggregateOp::SUM: res += val; break;
-            case AggregateOp::FSUM:
-                res = ramBitCast(ramBitCast<RamFloat>(res) + ramBitCast<RamFloat>(val));
-                break;
-            case AggregateOp::USUM:
-                res = ramBitCast(ramBitCast<RamUnsigned>(res) + ramBitCast<RamUnsigned>(val));
-                break;
+        case AggregateOp::COUNT:
+        case AggregateOp::SUM: res += val; break;
+        case AggregateOp::FSUM:
+            res = ramBitCast(ramBitCast<RamFloat>(res) + ramBitCast<RamFloat>(val));
+            break;
+        case AggregateOp::USUM:
+            res = ramBitCast(ramBitCast<RamUnsigned>(res) + ramBitCast<RamUnsigned>(val));
+            break;
 
-            case AggregateOp::MEAN:
-                accumulateMean.first += ramBitCast<RamFloat>(val);
-                accumulateMean.second++;
-                break;
+        case AggregateOp::MEAN:
+            state.accumulateMean.first += partial.accumulateMean.first;
+            state.accumulateMean.second += partial.accumulateMean.second;
+            break;
 
-            case AggregateOp::COUNT: fatal("This should never be executed");
-        }
+        case AggregateOp::COUNT_APPROX: state.sketch->merge(*partial.sketch); break;
     }
+    state.shouldRunNested = state.shouldRunNested || partial.shouldRunNested;
+}
 
-    if (aggregate.getFunction() == AggregateOp::MEAN && accumulateMean.second != 0) {
-        res = ramBitCast(accumulateMean.first / accumulateMean.second);
+template <typename Aggregate>
+RamDomain Engine::finishAggregate(
+        const Aggregate& aggregate, const Node& nestedOperation, AggregateState& state, Context& ctxt) {
+    if (aggregate.getFunction() == AggregateOp::MEAN && state.accumulateMean.second != 0) {
+        state.res = ramBitCast(state.accumulateMean.first / state.accumulateMean.second);
+    }
+    if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+        state.res = state.sketch->estimate();
     }
 
     // write result to environment
     souffle::Tuple<RamDomain, 1> tuple;
-    tuple[0] = res;
+    tuple[0] = state.res;
     ctxt[aggregate.getTupleId()] = tuple.data();
 
-    if (!shouldRunNested) {
+    if (!state.shouldRunNested) {
         return true;
     } else {
         return execute(&nestedOperation, ctxt);
     }
 }
-template <typename Rel>
-RamDomain Engine::evalParallelAggregate(
-        const Rel& rel, const ram::ParallelAggregate& cur, const ParallelAggregate& shadow, Context& ctxt) {
-    // TODO (rdowavic): make parallel
-    auto viewContext = shadow.getViewContext();
 
-    Context newCtxt(ctxt);
-    auto viewInfo = viewContext->getViewInfoForNested();
-    for (const auto& info : viewInfo) {
-        newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+template <typename Aggregate, typename Iter>
+RamDomain Engine::evalAggregate(const Aggregate& aggregate, const Node& filter, const Node* expression,
+        const Node& nestedOperation, const Iter& ranges, Context& ctxt) {
+    AggregateState state = initAggregate(aggregate.getFunction());
+    accumulateAggregate(aggregate, filter, expression, ranges, ctxt, state);
+    return finishAggregate(aggregate, nestedOperation, state, ctxt);
+}
+
+bool Engine::accumulateGroups(
+        const ParallelScan& scan, std::size_t groupCount, AggregateGroups& groups, Context& ctxt) {
+    switch (scan.getGroupedAggregate()->getType()) {
+#define ACCUMULATE_GROUPS(Structure, Arity, ...)                                            \
+    case I_IndexAggregate_##Structure##_##Arity: {                                          \
+        using RelType = Relation<Arity, interpreter::Structure>;                            \
+        const auto* rel = static_cast<RelType*>(scan.getGroupedAggregate()->getRelation()); \
+        return accumulateGroups(*rel, scan, groupCount, groups, ctxt);                      \
+    }
+
+        FOR_EACH(ACCUMULATE_GROUPS)
+#undef ACCUMULATE_GROUPS
+        default: fatal("unhandled relation of a grouped aggregate");
     }
-    return evalAggregate(
-            cur, *shadow.getCondition(), shadow.getExpr(), *shadow.getNestedOperation(), rel.scan(), newCtxt);
 }
 
 template <typename Rel>
-RamDomain Engine::evalParallelIndexAggregate(
-        const ram::ParallelIndexAggregate& cur, const ParallelIndexAggregate& shadow, Context& ctxt) {
-    // TODO (rdowavic): make parallel
-    auto viewContext = shadow.getViewContext();
+bool Engine::accumulateGroups(const Rel& rel, const ParallelScan& scan, std::size_t groupCount,
+        AggregateGroups& groups, Context& ctxt) {
+    const auto& aggregate = *scan.getGroupedAggregate();
+    const auto& cur = *static_cast<const ram::IndexAggregate*>(aggregate.getShadow());
+    const std::size_t threads = getThreadCount(cur.getRelation(), rel.size());
+    if (threads < 2 || rel.size() > groupCount * GROUPED_AGGREGATE_FANOUT) {
+        return false;
+    }
+
+    // the elements of a group are the first of the tuples in the order of the scanned index
+    const auto& superInfo = aggregate.getSuperInst();
+    const std::size_t keySize = superInfo.tupleFirst.size();
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
+    std::fill(low.begin(), low.end(), MIN_RAM_SIGNED);
+    std::fill(high.begin(), high.end(), MAX_RAM_SIGNED);
+    auto partitions = rel.partitionRange(scan.getGroupedIndexPos(), low, high, getPartitionCount());
+    countScan(aggregate);
+
+    // each thread aggregates the partitions it picks into groups of its own
+    std::vector<AggregateGroups> partials(threads, AggregateGroups(threads));
+    auto viewContext = scan.getViewContext();
+    Logger* logger = Logger::current();
+    ctxt.reserveThreadContexts(threads);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
+        for (const auto& info : viewContext->getViewInfoForNested()) {
+            newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+        }
+        AggregateGroups& partial = partials[thread_number()];
+        std::vector<RamDomain> key(keySize);
+        pfor(auto it = partitions.begin(); it < partitions.end(); it++) {
+            Logger::ChunkTimer chunkTimer(logger);
+            for (const auto& tuple : *it) {
+                newCtxt[cur.getTupleId()] = tuple.data();
+                if (!evalCondition(aggregate.getCondition(), newCtxt)) {
+                    continue;
+                }
+                std::copy_n(tuple.data(), keySize, key.begin());
+                auto& shard = partial[GroupKeyHash()(key) % threads];
+                auto group = shard.find(key);
+                if (group == shard.end()) {
+                    group = shard.emplace(key, initAggregate(cur.getFunction())).first;
+                }
+                accumulateTuple(cur.getFunction(), aggregate.getExpr(), newCtxt, group->second);
+            }
+        }
+    PARALLEL_END
+
+    // the partial groups are merged per shard, which are independent of each other
+    groups.assign(threads, {});
+    PARALLEL_START_THREADS(threads)
+        pfor(std::size_t shard = 0; shard < threads; ++shard) {
+            auto& merged = groups[shard];
+            for (auto& partial : partials) {
+                if (merged.empty()) {
+                    merged = std::move(partial[shard]);
+                    continue;
+                }
+                for (const auto& [key, state] : partial[shard]) {
+                    auto [group, inserted] = merged.emplace(key, state);
+                    if (!inserted) {
+                        combineAggregate(cur.getFunction(), group->second, state);
+                    }
+                }
+            }
+        }
+    PARALLEL_END
+    return true;
+}
 
-    Context newCtxt(ctxt);
-    auto viewInfo = viewContext->getViewInfoForNested();
-    for (const auto& info : viewInfo) {
-        newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+RamDomain Engine::finishGroup(const IndexAggregate& aggregate, const AggregateGroups& groups,
+        std::vector<RamDomain>& key, Context& ctxt) {
+    const auto& cur = *static_cast<const ram::IndexAggregate*>(aggregate.getShadow());
+    for (const auto& element : aggregate.getSuperInst().tupleFirst) {
+        key[element[0]] = ctxt[element[1]][element[2]];
     }
+    const auto& shard = groups[GroupKeyHash()(key) % groups.size()];
+    auto group = shard.find(key);
+    // a group without tuples has the initial result
+    AggregateState state = group != shard.end() ? group->second : initAggregate(cur.getFunction());
+    return finishAggregate(cur, *aggregate.getNestedOperation(), state, ctxt);
+}
+
+template <typename Aggregate, typename Shadow, typename Partitions>
+RamDomain Engine::evalPartitionedAggregate(const Aggregate& aggregate, const Shadow& shadow,
+        const Partitions& partitions, std::size_t threads, Context& ctxt) {
+    auto viewContext = shadow.getViewContext();
+    auto createViews = [&](Context& newCtxt) {
+        for (const auto& info : viewContext->getViewInfoForNested()) {
+            newCtxt.createView(*getRelationHandle(info[0]), info[1], info[2]);
+        }
+    };
+
+    // each thread aggregates the partitions it picks, and the partial results are combined
+    AggregateState state = initAggregate(aggregate.getFunction());
+    std::mutex stateLock;
+    Logger* logger = Logger::current();
+    ctxt.reserveThreadContexts(threads);
+    PARALLEL_START_THREADS(threads)
+        Context& newCtxt = ctxt.getThreadContext(thread_number());
+        createViews(newCtxt);
+        AggregateState partial = initAggregate(aggregate.getFunction());
+        pfor(auto it = partitions.begin(); it < partitions.end(); it++) {
+            Logger::ChunkTimer chunkTimer(logger);
+            accumulateAggregate(aggregate, *shadow.getCondition(), shadow.getExpr(), *it, newCtxt, partial);
+        }
+        std::lock_guard<std::mutex> guard(stateLock);
+        combineAggregate(aggregate.getFunction(), state, partial);
+    PARALLEL_END
+
+    Context& newCtxt = ctxt.getThreadContext(0);
+    createViews(newCtxt);
+    return finishAggregate(aggregate, *shadow.getNestedOperation(), state, newCtxt);
+}
+
+template <typename Rel>
+RamDomain Engine::evalParallelAggregate(
+        const Rel& rel, const ram::ParallelAggregate& cur, const ParallelAggregate& shadow, Context& ctxt) {
+    return evalPartitionedAggregate(cur, shadow, rel.partitionScan(getPartitionCount()),
+            getThreadCount(cur.getRelation(), rel.size()), ctxt);
+}
+
+template <typename Rel>
+RamDomain Engine::evalParallelIndexAggregate(const Rel& rel, const ram::ParallelIndexAggregate& cur,
+        const ParallelIndexAggregate& shadow, Context& ctxt) {
     // init temporary tuple for this level
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
     // get lower and upper boundaries for iteration
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     CAL_SEARCH_BOUND(superInfo, low, high);
 
-    std::size_t viewId = shadow.getViewId();
-    auto view = Rel::castView(newCtxt.getView(viewId));
-
-    return evalAggregate(cur, *shadow.getCondition(), shadow.getExpr(), *shadow.getNestedOperation(),
-            view->range(low, high), newCtxt);
+    std::size_t indexPos = shadow.getViewId();
+    countScan(shadow);
+    return evalPartitionedAggregate(cur, shadow, rel.partitionRange(indexPos, low, high, getPartitionCount()),
+            getThreadCount(cur.getRelation(), rel.size()), ctxt);
 }
 
 template <typename Rel>
 RamDomain Engine::evalIndexAggregate(
         const ram::IndexAggregate& cur, const IndexAggregate& shadow, Context& ctxt) {
     // init temporary tuple for this level
-    const std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> low;
-    souffle::Tuple<RamDomain, Arity> high;
+    auto low = Rel::makeTuple(superInfo.first.size());
+    auto high = Rel::makeTuple(superInfo.first.size());
     CAL_SEARCH_BOUND(superInfo, low, high);
 
     std::size_t viewId = shadow.getViewId();
     auto view = Rel::castView(ctxt.getView(viewId));
+    countScan(shadow);
+
+    // unconditional counts are answered by the index without enumerating the range
+    if (cur.getFunction() == AggregateOp::COUNT && shadow.getCondition()->getType() == I_True) {
+        AggregateState state = initAggregate(AggregateOp::COUNT);
+        state.res = static_cast<RamDomain>(view->count(low, high));
+        return finishAggregate(cur, *shadow.getNestedOperation(), state, ctxt);
+    }
 
     return evalAggregate(cur, *shadow.getCondition(), shadow.getExpr(), *shadow.getNestedOperation(),
             view->range(low, high), ctxt);
@@ -1728,9 +3479,8 @@ RamDomain Engine::evalIndexAggregate(
 
 template <typename Rel>
 RamDomain Engine::evalInsert(Rel& rel, const Insert& shadow, Context& ctxt) {
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> tuple;
+    auto tuple = Rel::makeTuple(superInfo.first.size());
     TUPLE_COPY_FROM(tuple, superInfo.first);
 
     /* TupleElement */
@@ -1742,16 +3492,54 @@ RamDomain Engine::evalInsert(Rel& rel, const Insert& shadow, Context& ctxt) {
         tuple[expr.first] = execute(expr.second.get(), ctxt);
     }
 
+    // the threads of a parallel scan may collect the tuples, which are merged at the end of the scan
+    if (const auto& id = shadow.getBufferId()) {
+        if (auto* buffer = ctxt.getInsertBuffer(*id)) {
+            buffer->insert(buffer->end(), tuple.begin(), tuple.end());
+            countInserts(shadow, 1);
+            return true;
+        }
+    }
+
     // insert in target relation
-    rel.insert(tuple);
+    insertTuple(rel, tuple);
+    countInserts(shadow, 1);
+    return true;
+}
+
+template <typename Rel>
+RamDomain Engine::evalNoveltyInsert(Rel& rel, Rel& newRel, const NoveltyInsert& shadow, Context& ctxt) {
+    const auto& superInfo = shadow.getSuperInst();
+    auto tuple = Rel::makeTuple(superInfo.first.size());
+    TUPLE_COPY_FROM(tuple, superInfo.first);
+
+    /* TupleElement */
+    for (const auto& tupleElement : superInfo.tupleFirst) {
+        tuple[tupleElement[0]] = ctxt[tupleElement[1]][tupleElement[2]];
+    }
+    /* Generic */
+    for (const auto& expr : superInfo.exprFirst) {
+        tuple[expr.first] = execute(expr.second.get(), ctxt);
+    }
+
+    // the insertion into the target relation reports whether the tuple is new to it; the tuples new
+    // to the relations of a worklist are queued by the thread instead
+    if (insertTuple(rel, tuple)) {
+        auto* buffer = shadow.getBufferId() ? ctxt.getInsertBuffer(*shadow.getBufferId()) : nullptr;
+        if (buffer != nullptr) {
+            buffer->insert(buffer->end(), tuple.begin(), tuple.end());
+        } else {
+            newRel.insert(tuple);
+        }
+    }
+    countInserts(shadow, 1);
     return true;
 }
 
 template <typename Rel>
 RamDomain Engine::evalErase(Rel& rel, const Erase& shadow, Context& ctxt) {
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> tuple;
+    auto tuple = Rel::makeTuple(superInfo.first.size());
     TUPLE_COPY_FROM(tuple, superInfo.first);
 
     /* TupleElement */
@@ -1770,13 +3558,14 @@ RamDomain Engine::evalErase(Rel& rel, const Erase& shadow, Context& ctxt) {
 
 template <typename Rel>
 RamDomain Engine::evalGuardedInsert(Rel& rel, const GuardedInsert& shadow, Context& ctxt) {
-    if (!execute(shadow.getCondition(), ctxt)) {
+    // Threads of a parallel query must not interleave between checking the guard and inserting
+    auto lease = shadow.getLock().acquire();
+    if (!evalCondition(shadow.getCondition(), ctxt)) {
         return true;
     }
 
-    constexpr std::size_t Arity = Rel::Arity;
     const auto& superInfo = shadow.getSuperInst();
-    souffle::Tuple<RamDomain, Arity> tuple;
+    auto tuple = Rel::makeTuple(superInfo.first.size());
     TUPLE_COPY_FROM(tuple, superInfo.first);
 
     /* TupleElement */
@@ -1789,7 +3578,8 @@ RamDomain Engine::evalGuardedInsert(Rel& rel, const GuardedInsert& shadow, Conte
     }
 
     // insert in target relation
-    rel.insert(tuple);
+    insertTuple(rel, tuple);
+    countInserts(shadow, 1);
     return true;
 }
 
@@ -16,24 +16,39 @@
 
 #pragma once
 
+#include "AggregateOp.h"
 #include "Global.h"
 #include "interpreter/Context.h"
 #include "interpreter/Generator.h"
 #include "interpreter/Index.h"
+#include "interpreter/JoinPlanner.h"
 #include "interpreter/Node.h"
 #include "interpreter/Relation.h"
+#include "ram/DebugInfo.h"
+#include "ram/Parallel.h"
 #include "ram/TranslationUnit.h"
 #include "ram/analysis/Index.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
 #include "souffle/SymbolTable.h"
+#include "souffle/datastructure/BlockCounter.h"
+#include "souffle/datastructure/HyperLogLog.h"
+#include "souffle/io/AsyncOutput.h"
+#include "souffle/io/ReadStream.h"
+#include "souffle/profile/ProfileSampler.h"
 #include "souffle/utility/ContainerUtil.h"
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #ifdef _OPENMP
 #include <omp.h>
@@ -42,37 +57,130 @@
 namespace souffle::interpreter {
 
 class ProgInterface;
+class RelInterface;
 
 /**
  * @class Engine
  * @brief This class translate the RAM Program into executable format and interpreter it.
  */
 class Engine {
-    using RelationHandle = Own<RelationWrapper>;
+    using RelationHandle = std::shared_ptr<RelationWrapper>;
     friend ProgInterface;
+    friend RelInterface;
     friend NodeGenerator;
+    friend JoinPlanner;
 
 public:
     Engine(ram::TranslationUnit& tUnit);
+    ~Engine();
 
     /** @brief Execute the main program */
     void executeMain();
+    /**
+     * @brief Read the next batch of each streaming input.
+     *
+     * In incremental mode streaming inputs are read a batch per run, such that re-executing the main
+     * program after each batch re-evaluates the strata affected by the batch.
+     *
+     * @return false once all streaming inputs are closed
+     */
+    bool readNextBatch();
     /** @brief Execute the subroutine program */
     void executeSubroutine(
             const std::string& name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret);
+    /**
+     * @brief Return a copy of the engine in its current state, or null if it cannot be copied.
+     *
+     * Only engines evaluated in incremental mode, without streaming inputs or native strata, are copied.
+     * The copy shares the relations of this engine until either changes them, and the symbol and record
+     * tables and the auto-increment counter for good, hence an engine and its copies must not be
+     * evaluated concurrently.
+     */
+    Own<Engine> clone();
 
 private:
     /** @brief Generate intermediate representation from RAM */
     void generateIR();
+    /**
+     * @brief Write the tuples of an output relation added and removed since its last output.
+     *
+     * Added tuples are appended to the output of the relation and removed ones to the output of
+     * `<relation>.retracted`; the first output of a relation is written in full.
+     */
+    void writeDelta(const std::map<std::string, std::string>& directive, const RelationWrapper& rel);
+    /** @brief Collect the relations read and written by each stratum subroutine */
+    void computeStratumDependencies();
+    /**
+     * @brief Return true if the given subroutine has to be (re-)executed.
+     *
+     * In incremental mode a stratum that already ran is only re-evaluated if one of its relations
+     * was modified since the last evaluation. Its derived relations are purged before they are
+     * recomputed and marked as modified so dependent strata are refreshed too.
+     */
+    bool prepareSubroutine(const std::size_t subroutineId);
+    /** @brief Select the subroutines needed for the requested relations, see SouffleProgram::selectStrata */
+    void selectSubroutines();
+    /** @brief Load the library of native strata given by `native-library`, see souffle/NativeStrata.h */
+    void loadNativeStrata();
+    /** @brief Return the given function of the library of native strata */
+    void* getNativeFunction(const char* name) const;
+    /**
+     * @brief Evaluate a stratum subroutine by the library of native strata.
+     *
+     * The relations read and derived by the stratum are copied into the library before and the derived
+     * relations are copied back after its evaluation, after which the copies of the library are purged.
+     */
+    void executeNative(const std::size_t subroutineId, const std::string& name);
+    /** @brief Compact the persistent relations derived by the given subroutine */
+    void compactSubroutine(const std::size_t subroutineId);
+    /** @brief Build the indexes built on demand of the relations read by the given subroutine */
+    void buildIndexes(const std::size_t subroutineId);
+    /** @brief Freeze the relations written by the given subroutine, which the remaining strata only read */
+    void freezeSubroutine(const std::size_t subroutineId);
+    /** @brief Fill the Bloom filters of the relations written by the given subroutine */
+    void buildFilters(const std::size_t subroutineId);
+    /**
+     * @brief Reclaim the symbols and records no relation refers to, once the tables doubled in size
+     * since the last compaction.
+     */
+    void compactTables(const ram::CompactTables& cur, const CompactTables& shadow);
+    /**
+     * @brief Load the relations computed by a cached body if the cache holds them for the contents of the
+     * relations it reads, and otherwise evaluate the body and store its relations in the cache.
+     */
+    RamDomain evalStratumCache(const ram::StratumCache& cur, const StratumCache& shadow, Context& ctxt);
+    /** @brief Return the bytes allocated by the indexes of the relations and the symbol and record tables */
+    std::size_t getMemoryUsage() const;
+    /**
+     * @brief React to the memory usage nearing the budget given by `memory-limit`.
+     *
+     * The indexes built on demand are freed, and at the end of a stratum the relations are compacted
+     * and the tables are compacted at their next compaction. If the usage still exceeds the budget, the
+     * evaluation is aborted, reporting the largest relations.
+     */
+    void checkMemoryLimit(bool stratumEnd);
+    /** @brief Record the memory usage of the indexes of the relations derived by the given subroutine */
+    void profileSubroutineMemory(const std::size_t subroutineId);
+    /** @brief Record the distinct values and the range of values of the columns of a relation */
+    void profileColumns(const RelationWrapper& rel);
+    /** @brief Print the rules that took most of the evaluation time */
+    void reportHotRules() const;
     /** @brief Remove a relation from the environment */
     void dropRelation(const std::size_t relId);
     /** @brief Swap the content of two relations */
     void swapRelation(const std::size_t ramRel1, const std::size_t ramRel2);
     /** @brief Return a reference to the relation on the given index */
     RelationHandle& getRelationHandle(const std::size_t idx);
+    /**
+     * @brief Replace a relation shared with a copy of the engine by a relation of this engine only,
+     * which holds the tuples of the shared relation if they are to be kept, and is empty otherwise.
+     */
+    void unshareRelation(RelationHandle& handle, bool keepTuples);
+    /** @brief Create an empty relation of the given declaration */
+    RelationHandle newRelation(const ram::Relation& id);
     /** @brief Return the string symbol table */
     SymbolTable& getSymbolTable() {
-        return symbolTable;
+        return *symbolTable;
     }
     /** @brief Return the record table */
     RecordTable& getRecordTable();
@@ -80,6 +188,12 @@ private:
     ram::TranslationUnit& getTranslationUnit();
     /** @brief Execute the program */
     RamDomain execute(const Node*, Context&);
+    /** @brief Evaluate a condition, comparing without a dispatch if it is a constraint */
+    bool evalCondition(const Node* cond, Context& ctxt);
+    /** @brief Evaluate a constraint */
+    RamDomain evalConstraint(const Constraint& shadow, Context& ctxt);
+    /** @brief Evaluate an operand of a constraint, executing its node only if it is not decoded */
+    RamDomain evalOperand(const Constraint::Operand& operand, const Node* expr, Context& ctxt);
     /** @brief Return method handler */
     void* getMethodHandle(const std::string& method);
     /** @brief Load DLL */
@@ -90,6 +204,52 @@ private:
     void incIterationNumber();
     /** @brief Reset iteration number */
     void resetIterationNumber();
+    /** @brief Return true if the program interface cancelled the evaluation */
+    bool isCancelled() const;
+    /** @brief Return true if the statements of a parallel block are executed concurrently */
+    bool isConcurrent(const ram::Parallel& parallel) const;
+    /** @brief Return the index of the frequency counter of a profiled operation, registering its label */
+    std::size_t getFrequencyIndex(const std::string& label);
+    /** @brief Add the frequencies and operator statistics counted by the threads to the current iteration */
+    void flushFrequencies();
+    /**
+     * @brief Return the index of the counters of an operator of a profiled rule, registering it.
+     *
+     * The operator is identified by the label of the timer of its rule and its position in the plan
+     * of the rule, in which it is nested in the given depth of operators.
+     */
+    std::size_t getOperatorIndex(
+            const std::string& rule, std::size_t position, std::size_t depth, const std::string& text);
+    /** @brief Record the tuples and times of the operators of the profiled rules in the profile */
+    void profileOperators();
+    /** @brief Return the index of the access counter of an index of a relation, registering it */
+    std::size_t getAccessIndex(const std::string& relation, std::size_t indexPos);
+    /** @brief Count an existence check of the index of an operation, if the index accesses are profiled */
+    void countProbe(const IndexAccessOperation& op);
+    /** @brief Count a range scan of the index of an operation, if the index accesses are profiled */
+    void countScan(const IndexAccessOperation& op);
+    /** @brief Count the tuples returned by range scans of the index of an operation */
+    void countTuples(const IndexAccessOperation& op, std::size_t tuples);
+    /** @brief Count tuples inserted into the relation of an operation */
+    void countInserts(const IndexAccessOperation& op, std::size_t tuples);
+    /** @brief Record the accesses of the indexes of all relations in the profile */
+    void profileIndexAccesses();
+    /** @brief Return the number of partitions of a parallel operation */
+    std::size_t getPartitionCount() const;
+    /** @brief Return the number of threads of a parallel operation on a relation of the given size */
+    std::size_t getThreadCount(const std::string& relation, std::size_t size) const;
+    /**
+     * @brief Let the threads of a parallel scan over the given number of tuples collect the tuples of
+     * the deferrable insertions into relations that are small compared to the scan
+     */
+    void deferInserts(const AbstractParallel& scan, std::size_t scanned, std::size_t threads, Context& ctxt);
+    /** @brief Merge the tuples collected by the threads of a parallel scan into their relations */
+    void mergeInsertBuffers(const AbstractParallel& scan, std::size_t threads, Context& ctxt);
+    /** @brief Evaluate the rules of a fixpoint loop for the tuples they derive, until none is new */
+    RamDomain evalWorklist(const Worklist& shadow, Context& ctxt);
+    /** @brief Call the user-defined functor of an operator with the evaluated arguments */
+    RamDomain callUserDefinedOperator(
+            const ram::UserDefinedOperator& cur, const UserDefinedOperator& shadow, const RamDomain* args);
     /** @brief Increment the counter */
     int incCounter();
     /** @brief Return the relation map. */
@@ -111,9 +271,16 @@ private:
     RamDomain evalParallelScan(
             const Rel& rel, const ram::ParallelScan& cur, const ParallelScan& shadow, Context& ctxt);
 
+    template <typename A>
+    RamDomain evalParallelRange(const ram::ParallelNestedIntrinsicOperator& cur,
+            const ParallelNestedIntrinsicOperator& shadow, Context& ctxt);
+
     template <typename Rel>
     RamDomain evalIndexScan(const ram::IndexScan& cur, const IndexScan& shadow, Context& ctxt);
 
+    template <typename Rel>
+    RamDomain evalIndexIntersect(const ram::IndexIntersect& cur, const IndexIntersect& shadow, Context& ctxt);
+
     template <typename Rel>
     RamDomain evalParallelIndexScan(const Rel& rel, const ram::ParallelIndexScan& cur,
             const ParallelIndexScan& shadow, Context& ctxt);
@@ -132,17 +299,78 @@ private:
     RamDomain evalParallelIndexIfExists(const Rel& rel, const ram::ParallelIndexIfExists& cur,
             const ParallelIndexIfExists& shadow, Context& ctxt);
 
+    /** Partial result of an aggregate over some of the tuples of a relation */
+    struct AggregateState {
+        RamDomain res = 0;
+        std::pair<RamFloat, RamFloat> accumulateMean = {0, 0};
+        /** The sketch of an approximate count */
+        std::optional<HyperLogLog> sketch;
+        bool shouldRunNested = false;
+    };
+
+    AggregateState initAggregate(AggregateOp function);
+
+    /** Accumulate the tuple of an aggregate, which passed its filter */
+    void accumulateTuple(AggregateOp function, const Node* expression, Context& ctxt, AggregateState& state);
+
+    template <typename Aggregate, typename Iter>
+    void accumulateAggregate(const Aggregate& aggregate, const Node& filter, const Node* expression,
+            const Iter& ranges, Context& ctxt, AggregateState& state);
+
+    void combineAggregate(AggregateOp function, AggregateState& state, const AggregateState& partial);
+
+    template <typename Aggregate>
+    RamDomain finishAggregate(
+            const Aggregate& aggregate, const Node& nestedOperation, AggregateState& state, Context& ctxt);
+
     template <typename Aggregate, typename Iter>
     RamDomain evalAggregate(const Aggregate& aggregate, const Node& filter, const Node* expression,
             const Node& nestedOperation, const Iter& ranges, Context& ctxt);
 
+    /** Hash of the elements a group of an aggregate is keyed by */
+    struct GroupKeyHash {
+        std::size_t operator()(const std::vector<RamDomain>& key) const {
+            std::size_t seed = key.size();
+            for (RamDomain value : key) {
+                seed ^= std::hash<RamDomain>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
+    /** Partial results of an aggregate per group, in shards selected by the hash of their keys */
+    using AggregateGroups =
+            std::vector<std::unordered_map<std::vector<RamDomain>, AggregateState, GroupKeyHash>>;
+
+    /**
+     * Compute the grouped aggregate of a parallel scan for all groups in one parallel pass over its
+     * relation, with partial results of each thread that are merged per shard.
+     *
+     * @return false, leaving the aggregate to be computed per group, if its relation is small or
+     * much larger than the scanned relation, of which only some groups would be needed
+     */
+    bool accumulateGroups(const ParallelScan& scan, std::size_t groupCount, AggregateGroups& groups,
+            Context& ctxt);
+
+    template <typename Rel>
+    bool accumulateGroups(const Rel& rel, const ParallelScan& scan, std::size_t groupCount,
+            AggregateGroups& groups, Context& ctxt);
+
+    /** Finish the grouped aggregate for the group of the scanned tuple */
+    RamDomain finishGroup(const IndexAggregate& aggregate, const AggregateGroups& groups,
+            std::vector<RamDomain>& key, Context& ctxt);
+
+    template <typename Aggregate, typename Shadow, typename Partitions>
+    RamDomain evalPartitionedAggregate(const Aggregate& aggregate, const Shadow& shadow,
+            const Partitions& partitions, std::size_t threads, Context& ctxt);
+
     template <typename Rel>
     RamDomain evalParallelAggregate(const Rel& rel, const ram::ParallelAggregate& cur,
             const ParallelAggregate& shadow, Context& ctxt);
 
     template <typename Rel>
-    RamDomain evalParallelIndexAggregate(
-            const ram::ParallelIndexAggregate& cur, const ParallelIndexAggregate& shadow, Context& ctxt);
+    RamDomain evalParallelIndexAggregate(const Rel& rel, const ram::ParallelIndexAggregate& cur,
+            const ParallelIndexAggregate& shadow, Context& ctxt);
 
     template <typename Rel>
     RamDomain evalIndexAggregate(const ram::IndexAggregate& cur, const IndexAggregate& shadow, Context& ctxt);
@@ -153,40 +381,179 @@ private:
     template <typename Rel>
     RamDomain evalInsert(Rel& rel, const Insert& shadow, Context& ctxt);
 
+    template <typename Rel>
+    RamDomain evalNoveltyInsert(Rel& rel, Rel& newRel, const NoveltyInsert& shadow, Context& ctxt);
+
     template <typename Rel>
     RamDomain evalErase(Rel& rel, const Erase& shadow, Context& ctxt);
 
     /** If profile is enable in this program */
     const bool profileEnabled;
     const bool frequencyCounterEnabled;
+    /** If the tuples entering the operators of rules and their times are profiled */
+    const bool operatorProfileEnabled;
+    /** Sampler of the profiled parts of the program; only set if the profile is sampled */
+    Own<ProfileSampler> sampler;
+    /** Writer of output relations in the background; only set if selected by `async-output` */
+    Own<AsyncOutput> asyncOutput;
     /** If running a provenance program */
     const bool isProvenance;
+    /** If relations stay resident and unaffected strata are skipped on re-execution */
+    const bool incremental;
+    /** If the b-trees of relations are rebuilt densely once their stratum is evaluated */
+    const bool compactRelations;
+    /** If Bloom filters of relations are built at the end of their strata */
+    const bool bloomFilters;
+    /** Budget of the memory of the relations and tables in bytes; zero if unlimited */
+    const std::size_t memoryLimit;
+    /** If the main program was evaluated at least once in incremental mode */
+    bool evaluated = false;
+    /** If the program reads streaming inputs in incremental mode, and writes its outputs as deltas */
+    bool streaming = false;
+    /** Open streaming inputs with their relations */
+    std::vector<std::pair<RelationWrapper*, Own<ReadStream>>> streams;
+    /** Tuples of each output relation at its last output, in lexicographical order; only used
+     * if streaming */
+    std::map<const RelationWrapper*, std::vector<RamDomain>> emitted;
+    /** Callback of the program interface invoked with the index of each completed stratum */
+    std::function<void(std::size_t)> stratumCallback;
+    /** Check of the program interface whether the evaluation is cancelled */
+    std::function<bool()> cancellationCheck;
+    /** Relations of a stratum subroutine */
+    struct StratumDependencies {
+        /** Relations computed by other strata */
+        std::vector<std::size_t> reads;
+        /** Relations derived by the stratum */
+        std::vector<std::size_t> writes;
+        /** Relations loaded by the stratum */
+        std::vector<std::size_t> inputs;
+    };
+    /** Dependencies of each subroutine, indexed as subroutine */
+    std::vector<StratumDependencies> stratumDependencies;
+    /** Relations requested by `only-relations` or the program interface, or none if all are */
+    std::set<std::string> requestedRelations;
+    /** Whether each subroutine is evaluated for the requested relations; empty if all are */
+    std::vector<bool> selectedSubroutines;
+    /** Whether each stratum was skipped since it was last evaluated in incremental mode */
+    std::vector<bool> staleSubroutines;
+    /** Whether each stratum was skipped by the first evaluation, thus never loaded its inputs */
+    std::vector<bool> unloadedSubroutines;
+    /** Whether the inputs of the current stratum are loaded in incremental mode */
+    bool loadInputs = true;
+    /** Execution statistics of a rule */
+    struct RuleStatistics {
+        std::size_t executions = 0;
+        /** Accumulated evaluation time in microseconds */
+        long time = 0;
+    };
+    /** If the join order of queries is re-planned from the sizes of their relations */
+    const bool adaptiveJoinOrder;
+    /** If the fastest join orders measured are emitted as execution plans */
+    const bool emitPlans;
+    /** If fixpoint loops are evaluated asynchronously, from worklists of the derived tuples */
+    const bool asyncFixpoint;
+    /** If rule statistics are collected to report hot rules */
+    const bool ruleStatisticsEnabled;
+    /** Statistics of each rule, identified by its debug info */
+    std::map<const ram::DebugInfo*, RuleStatistics> ruleStatistics;
+    /** Generator of the node trees, kept to generate re-planned queries */
+    Own<NodeGenerator> generator;
+    /** Planner of the join orders; only set in adaptive mode or if plans are emitted */
+    Own<JoinPlanner> joinPlanner;
     /** subroutines */
     VecOwn<Node> subroutine;
     /** main program */
     Own<Node> main;
     /** Number of threads enabled for this program */
     std::size_t numOfThreads;
-    /** Profile counter */
-    std::atomic<RamDomain> counter{0};
-    /** Loop iteration counter */
-    std::size_t iteration = 0;
-    /** Profile for rule frequencies */
-    std::map<std::string, std::deque<std::atomic<std::size_t>>> frequencies;
+    /** Number of threads of the parallel operations on a relation selected by --relation-threads */
+    std::map<std::string, std::size_t> relationThreads;
+    /** Counter of the auto-increment values, shared with the copies of the engine */
+    std::shared_ptr<BlockCounter> counter;
+    /** Loop iteration counter, shared by the loops of the statements of a parallel block */
+    std::atomic<std::size_t> iteration{0};
+    /** Labels of the frequency counters, and the index of each label */
+    std::vector<std::string> frequencyLabels;
+    std::map<std::string, std::size_t> frequencyIndexes;
+    /** Frequencies counted by a thread in the current iteration, indexed as the labels */
+    struct alignas(64) ThreadFrequencies {
+        std::vector<std::size_t> counts;
+    };
+    /**
+     * Frequencies of the threads; each thread only increments its own
+     * counters, which are added up at the end of each iteration.
+     */
+    std::vector<ThreadFrequencies> threadFrequencies;
+    /** Profile for rule frequencies, indexed as the labels and then by iteration */
+    std::vector<std::vector<std::size_t>> frequencies;
     /** Profile for relation reads */
     std::map<std::string, std::atomic<std::size_t>> reads;
+    /** Accesses of an index: existence checks, range scans, tuples returned and inserted tuples */
+    struct IndexAccesses {
+        std::size_t probes = 0;
+        std::size_t scans = 0;
+        std::size_t tuples = 0;
+        std::size_t inserts = 0;
+    };
+    /** Index of the access counter of each index, by relation and index position */
+    std::map<std::pair<std::string, std::size_t>, std::size_t> accessIndexes;
+    /** Accesses counted by a thread, indexed as the access counters */
+    struct alignas(64) ThreadIndexAccesses {
+        std::vector<IndexAccesses> counts;
+    };
+    /** Index accesses of the threads, which are added up at the end of the program */
+    std::vector<ThreadIndexAccesses> threadIndexAccesses;
+    /** Operator of a profiled rule */
+    struct ProfiledOperator {
+        /** label of the timer of the rule */
+        std::string rule;
+        /** position in the pre-order of the operators of the rule */
+        std::size_t position;
+        /** number of operators the operator is nested in */
+        std::size_t depth;
+        /** first line of the RAM of the operator */
+        std::string text;
+    };
+    /** Operators of the profiled rules, indexed as their counters */
+    std::vector<ProfiledOperator> profiledOperators;
+    /** Number of tuples entering an operator, and its time including its nested operators */
+    struct OperatorStatistics {
+        std::size_t calls = 0;
+        std::chrono::nanoseconds time{};
+    };
+    /** Statistics counted by a thread in the current iteration, indexed as the operators */
+    struct alignas(64) ThreadOperatorStatistics {
+        std::vector<OperatorStatistics> counts;
+    };
+    std::vector<ThreadOperatorStatistics> threadOperators;
+    /** Statistics of the operators, indexed as the operators and then by iteration */
+    std::vector<std::vector<OperatorStatistics>> operatorStatistics;
     /** DLL */
     std::vector<void*> dll;
+    /** Library of native strata; only set if given by `native-library` */
+    void* nativeLibrary = nullptr;
+    /** Relations of the library of native strata */
+    void* nativeProgram = nullptr;
+    /** If a subroutine is evaluated by the library of native strata, indexed as subroutine */
+    std::vector<bool> nativeSubroutines;
     /** Program */
     ram::TranslationUnit& tUnit;
     /** IndexAnalysis */
     ram::analysis::IndexAnalysis& isa;
     /** Record Table Implementation*/
-    SpecializedRecordTable<0, 1, 2, 3, 4, 5, 6, 7, 8, 9> recordTable;
+    using RecordTableImpl = SpecializedRecordTable<0, 1, 2, 3, 4, 5, 6, 7, 8, 9>;
+    /** Record table, shared with the copies of the engine */
+    std::shared_ptr<RecordTableImpl> recordTable;
     /** Symbol table for relations */
     VecOwn<RelationHandle> relations;
-    /** Symbol table */
-    SymbolTable symbolTable;
+    /** Symbol table, shared with the copies of the engine */
+    std::shared_ptr<SymbolTable> symbolTable;
+    /** Number of symbols encoded by the program itself, which keep their indices in compactions */
+    std::size_t pinnedSymbols = 0;
+    /** Compacting smaller tables is not worth the effort */
+    static constexpr std::size_t MIN_COMPACTION_THRESHOLD = 1 << 16;
+    /** Number of symbols and records from which on the tables are compacted */
+    std::size_t compactionThreshold = MIN_COMPACTION_THRESHOLD;
 };
 
 }  // namespace souffle::interpreter
@@ -15,12 +15,27 @@
 
 #include "interpreter/Generator.h"
 #include "interpreter/Engine.h"
+#include <functional>
+#include <ffi.h>
 
 namespace souffle::interpreter {
 
+// Aliases for foreign function interface.
+#if RAM_DOMAIN_SIZE == 64
+#define FFI_RamSigned ffi_type_sint64
+#define FFI_RamUnsigned ffi_type_uint64
+#define FFI_RamFloat ffi_type_double
+#else
+#define FFI_RamSigned ffi_type_sint32
+#define FFI_RamUnsigned ffi_type_uint32
+#define FFI_RamFloat ffi_type_float
+#endif
+
+#define FFI_Symbol ffi_type_pointer
+
 using NodePtr = Own<Node>;
 using NodePtrVec = std::vector<NodePtr>;
-using RelationHandle = Own<RelationWrapper>;
+using RelationHandle = std::shared_ptr<RelationWrapper>;
 
 NodeGenerator::NodeGenerator(Engine& engine) : engine(engine) {
     visit(engine.tUnit.getProgram(), [&](const ram::Relation& relation) {
@@ -72,9 +87,19 @@ NodePtr NodeGenerator::visit_(type_identity<ram::AutoIncrement>, const ram::Auto
 
 NodePtr NodeGenerator::visit_(type_identity<ram::IntrinsicOperator>, const ram::IntrinsicOperator& op) {
     NodePtrVec children;
-    for (const auto& arg : op.getArguments()) {
-        children.push_back(dispatch(*arg));
-    }
+    // the arguments of nested concatenations are concatenated at once, without encoding the inner results
+    std::function<void(const ram::IntrinsicOperator&)> addArguments = [&](const ram::IntrinsicOperator& cur) {
+        for (const auto& arg : cur.getArguments()) {
+            const auto* nested = as<ram::IntrinsicOperator>(arg);
+            if (op.getOperator() == FunctorOp::CAT && nested != nullptr &&
+                    nested->getOperator() == FunctorOp::CAT) {
+                addArguments(*nested);
+            } else {
+                children.push_back(dispatch(*arg));
+            }
+        }
+    };
+    addArguments(op);
     return mk<IntrinsicOperator>(I_IntrinsicOperator, &op, std::move(children));
 }
 
@@ -83,7 +108,56 @@ NodePtr NodeGenerator::visit_(type_identity<ram::UserDefinedOperator>, const ram
     for (const auto& arg : op.getArguments()) {
         children.push_back(dispatch(*arg));
     }
-    return mk<UserDefinedOperator>(I_UserDefinedOperator, &op, std::move(children));
+
+    auto ffiType = [&](TypeAttribute type) -> ffi_type* {
+        switch (type) {
+            case TypeAttribute::Symbol: return &FFI_Symbol;
+            case TypeAttribute::Signed: return &FFI_RamSigned;
+            case TypeAttribute::Unsigned: return &FFI_RamUnsigned;
+            case TypeAttribute::Float: return &FFI_RamFloat;
+            case TypeAttribute::ADT: fatal("ADT support is not implemented");
+            case TypeAttribute::Record: fatal("Record support is not implemented");
+        }
+        UNREACHABLE_BAD_CASE_ANALYSIS
+    };
+
+    // stateful functors take the symbol and record tables, and thread-local ones also their context,
+    // ahead of their arguments
+    std::vector<ffi_type*> argTypes;
+    ffi_type* returnType = &FFI_RamSigned;
+    bool direct = children.size() <= UserDefinedOperator::MaxDirectArity;
+    if (op.isStateful()) {
+        argTypes.assign(op.isThreadLocal() ? 3 : 2, &ffi_type_pointer);
+        argTypes.insert(argTypes.end(), children.size(), &FFI_RamSigned);
+    } else {
+        for (TypeAttribute type : op.getArgsTypes()) {
+            argTypes.push_back(ffiType(type));
+            direct = direct && type == TypeAttribute::Signed;
+        }
+        returnType = ffiType(op.getReturnType());
+        direct = direct && op.getReturnType() == TypeAttribute::Signed;
+    }
+
+    engine.loadDLL();
+    auto functor = reinterpret_cast<UserDefinedOperator::Functor>(engine.getMethodHandle(op.getName()));
+    Own<FunctorContexts> contexts;
+    if (op.isThreadLocal() && functor != nullptr) {
+        auto init = reinterpret_cast<FunctorContexts::Init>(engine.getMethodHandle(op.getName() + "_init"));
+        auto fini = reinterpret_cast<FunctorContexts::Fini>(engine.getMethodHandle(op.getName() + "_fini"));
+        if (init == nullptr || fini == nullptr) {
+            fatal("cannot find the context hooks `%s_init` and `%s_fini` of user-defined operator `%s`",
+                    op.getName(), op.getName(), op.getName());
+        }
+        contexts = mk<FunctorContexts>(init, fini);
+    }
+    Own<UserDefinedOperator::Cache> cache;
+    if (op.isCached()) {
+        cache = mk<UserDefinedOperator::Cache>(Global::config().has("functor-cache")
+                                                       ? std::stoul(Global::config().get("functor-cache"))
+                                                       : UserDefinedOperator::Cache::DEFAULT_CAPACITY);
+    }
+    return mk<UserDefinedOperator>(I_UserDefinedOperator, &op, std::move(children), functor,
+            std::move(argTypes), returnType, direct, std::move(contexts), std::move(cache));
 }
 
 NodePtr NodeGenerator::visit_(
@@ -98,6 +172,21 @@ NodePtr NodeGenerator::visit_(
     return mk<NestedIntrinsicOperator>(I_NestedIntrinsicOperator, &op, std::move(children));
 }
 
+NodePtr NodeGenerator::visit_(type_identity<ram::ParallelNestedIntrinsicOperator>,
+        const ram::ParallelNestedIntrinsicOperator& op) {
+    auto arity = op.getArguments().size();
+    orderingContext.addNewTuple(op.getTupleId(), arity);
+    NodePtrVec children;
+    for (auto&& arg : op.getArguments()) {
+        children.push_back(dispatch(*arg));
+    }
+    children.push_back(visit_(type_identity<ram::TupleOperation>(), op));
+    auto res = mk<ParallelNestedIntrinsicOperator>(
+            I_ParallelNestedIntrinsicOperator, &op, std::move(children));
+    res->setViewContext(parentQueryViewContext);
+    return res;
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::PackRecord>, const ram::PackRecord& pr) {
     NodePtrVec children;
     for (const auto& arg : pr.getArguments()) {
@@ -120,7 +209,21 @@ NodePtr NodeGenerator::visit_(type_identity<ram::False>, const ram::False& lfals
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Conjunction>, const ram::Conjunction& conj) {
-    return mk<Conjunction>(I_Conjunction, &conj, dispatch(conj.getLHS()), dispatch(conj.getRHS()));
+    // Flatten the binary conjunction tree into a linear list of terms, preserving their order,
+    // so that the engine evaluates them in a loop instead of recursing once per term.
+    NodePtrVec children;
+    std::vector<const ram::Condition*> pending{&conj.getRHS(), &conj.getLHS()};
+    while (!pending.empty()) {
+        const ram::Condition* cond = pending.back();
+        pending.pop_back();
+        if (const auto* nested = as<ram::Conjunction>(cond)) {
+            pending.push_back(&nested->getRHS());
+            pending.push_back(&nested->getLHS());
+        } else {
+            children.push_back(dispatch(*cond));
+        }
+    }
+    return mk<Conjunction>(I_Conjunction, &conj, std::move(children));
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Negation>, const ram::Negation& neg) {
@@ -152,20 +255,35 @@ NodePtr NodeGenerator::visit_(type_identity<ram::ExistenceCheck>, const ram::Exi
     }
     const auto& ramRelation = lookup(exists.getRelation());
     NodeType type = constructNodeType("ExistenceCheck", ramRelation);
-    return mk<ExistenceCheck>(type, &exists, isTotal, encodeView(&exists), std::move(superOp),
-            ramRelation.isTemp(), ramRelation.getName());
+    bool isFiltered = isTotal && engine.isa.getIndexSelection(ramRelation.getName()).isFiltered();
+    const std::size_t indexPos = encodeIndexPos(exists);
+    return withAccessCounter(mk<ExistenceCheck>(type, &exists, isTotal, encodeView(&exists),
+                                     std::move(superOp), ramRelation.isTemp(), ramRelation.getName(),
+                                     getRelationHandle(encodeRelation(exists.getRelation())), indexPos,
+                                     isFiltered),
+            exists.getRelation(), indexPos);
 }
 
 NodePtr NodeGenerator::visit_(
         type_identity<ram::ProvenanceExistenceCheck>, const ram::ProvenanceExistenceCheck& provExists) {
     SuperInstruction superOp = getExistenceSuperInstInfo(provExists);
     NodeType type = constructNodeType("ProvenanceExistenceCheck", lookup(provExists.getRelation()));
-    return mk<ProvenanceExistenceCheck>(type, &provExists, dispatch(*(--provExists.getChildNodes().end())),
-            encodeView(&provExists), std::move(superOp));
+    return withAccessCounter(mk<ProvenanceExistenceCheck>(type, &provExists,
+                                     dispatch(*(--provExists.getChildNodes().end())),
+                                     encodeView(&provExists), std::move(superOp)),
+            provExists.getRelation(), indexTable[&provExists]);
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Constraint>, const ram::Constraint& relOp) {
-    return mk<Constraint>(I_Constraint, &relOp, dispatch(relOp.getLHS()), dispatch(relOp.getRHS()));
+    Own<evaluator::CompiledRegex> regex;
+    const auto op = relOp.getOperator();
+    if (op == BinaryConstraintOp::MATCH || op == BinaryConstraintOp::NOT_MATCH) {
+        if (const auto* pattern = as<ram::StringConstant>(relOp.getLHS())) {
+            regex = mk<evaluator::CompiledRegex>(evaluator::compileRegex(pattern->getConstant()));
+        }
+    }
+    return mk<Constraint>(I_Constraint, &relOp, dispatch(relOp.getLHS()), dispatch(relOp.getRHS()),
+            getConstraintOperand(relOp.getLHS()), getConstraintOperand(relOp.getRHS()), std::move(regex));
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::NestedOperation>, const ram::NestedOperation& nested) {
@@ -174,7 +292,8 @@ NodePtr NodeGenerator::visit_(type_identity<ram::NestedOperation>, const ram::Ne
 
 NodePtr NodeGenerator::visit_(type_identity<ram::TupleOperation>, const ram::TupleOperation& search) {
     if (engine.profileEnabled && engine.frequencyCounterEnabled && !search.getProfileText().empty()) {
-        return mk<TupleOperation>(I_TupleOperation, &search, dispatch(search.getOperation()));
+        return mk<TupleOperation>(I_TupleOperation, &search, dispatch(search.getOperation()),
+                engine.getFrequencyIndex(search.getProfileText()));
     }
     return dispatch(search.getOperation());
 }
@@ -192,8 +311,17 @@ NodePtr NodeGenerator::visit_(type_identity<ram::ParallelScan>, const ram::Paral
     std::size_t relId = encodeRelation(pScan.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("ParallelScan", lookup(pScan.getRelation()));
+    encodeDeferrableInserts(pScan);
     auto res = mk<ParallelScan>(type, &pScan, rel, visit_(type_identity<ram::TupleOperation>(), pScan));
     res->setViewContext(parentQueryViewContext);
+    addDeferrableInserts(*res);
+    // an aggregate grouped by elements of the scanned tuples may be computed for all groups at once
+    const auto* aggregate = as<ram::IndexAggregate>(pScan.getOperation());
+    const Node* nested = res->getNestedOperation();
+    if (aggregate != nullptr && nested->getShadow() == aggregate &&
+            isGroupedAggregate(pScan, *aggregate, *static_cast<const IndexAggregate*>(nested))) {
+        res->setGroupedAggregate(static_cast<const IndexAggregate*>(nested), indexTable[aggregate]);
+    }
     return res;
 }
 
@@ -201,8 +329,10 @@ NodePtr NodeGenerator::visit_(type_identity<ram::IndexScan>, const ram::IndexSca
     orderingContext.addTupleWithIndexOrder(iScan.getTupleId(), iScan);
     SuperInstruction indexOperation = getIndexSuperInstInfo(iScan);
     NodeType type = constructNodeType("IndexScan", lookup(iScan.getRelation()));
-    return mk<IndexScan>(type, &iScan, nullptr, visit_(type_identity<ram::TupleOperation>(), iScan),
-            encodeView(&iScan), std::move(indexOperation));
+    return withAccessCounter(mk<IndexScan>(type, &iScan, nullptr,
+                                     visit_(type_identity<ram::TupleOperation>(), iScan), encodeView(&iScan),
+                                     std::move(indexOperation)),
+            iScan.getRelation(), indexTable[&iScan]);
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::ParallelIndexScan>, const ram::ParallelIndexScan& piscan) {
@@ -211,12 +341,50 @@ NodePtr NodeGenerator::visit_(type_identity<ram::ParallelIndexScan>, const ram::
     std::size_t relId = encodeRelation(piscan.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("ParallelIndexScan", lookup(piscan.getRelation()));
+    encodeDeferrableInserts(piscan);
     auto res = mk<ParallelIndexScan>(type, &piscan, rel, visit_(type_identity<ram::TupleOperation>(), piscan),
             encodeIndexPos(piscan), std::move(indexOperation));
     res->setViewContext(parentQueryViewContext);
+    addDeferrableInserts(*res);
+    res = withAccessCounter(std::move(res), piscan.getRelation(), indexTable[&piscan]);
     return res;
 }
 
+NodePtr NodeGenerator::visit_(type_identity<ram::IndexIntersect>, const ram::IndexIntersect& intersect) {
+    orderingContext.addTupleWithIndexOrder(intersect.getTupleId(), intersect);
+    SuperInstruction indexOperation = getIndexSuperInstInfo(intersect);
+    const auto& rel = lookup(intersect.getRelation());
+    auto order = (*getRelationHandle(encodeRelation(rel.getName())))->getIndexOrder(indexTable[&intersect]);
+
+    // the partner is searched for all values of the shared attribute, which are then leapfrogged
+    const ram::ExistenceCheck& partner = intersect.getPartner();
+    auto values = partner.getValues();
+    ram::UndefValue undef;
+    values[intersect.getPartnerElement()] = &undef;
+    auto partnerIndexId = encodeIndexPos(partner);
+    SuperInstruction partnerOperation =
+            getIndexSuperInstInfo(partner.getRelation(), partnerIndexId, values, values);
+    auto partnerOrder =
+            (*getRelationHandle(encodeRelation(partner.getRelation())))->getIndexOrder(partnerIndexId);
+
+    // the encoded position of the shared attribute in both indexes
+    std::size_t element = 0;
+    while (order[element] != intersect.getElement()) {
+        element++;
+    }
+    std::size_t partnerElement = 0;
+    while (partnerOrder[partnerElement] != intersect.getPartnerElement()) {
+        partnerElement++;
+    }
+
+    NodeType type = constructNodeType("IndexIntersect", rel);
+    return withAccessCounter(mk<IndexIntersect>(type, &intersect,
+                                     visit_(type_identity<ram::TupleOperation>(), intersect),
+                                     encodeView(&intersect), std::move(indexOperation), element,
+                                     encodeView(&partner), std::move(partnerOperation), partnerElement),
+            intersect.getRelation(), indexTable[&intersect]);
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::IfExists>, const ram::IfExists& ifexists) {
     orderingContext.addTupleWithDefaultOrder(ifexists.getTupleId(), ifexists);
     std::size_t relId = encodeRelation(ifexists.getRelation());
@@ -241,9 +409,10 @@ NodePtr NodeGenerator::visit_(type_identity<ram::IndexIfExists>, const ram::Inde
     orderingContext.addTupleWithIndexOrder(iIfExists.getTupleId(), iIfExists);
     SuperInstruction indexOperation = getIndexSuperInstInfo(iIfExists);
     NodeType type = constructNodeType("IndexIfExists", lookup(iIfExists.getRelation()));
-    return mk<IndexIfExists>(type, &iIfExists, nullptr, dispatch(iIfExists.getCondition()),
-            visit_(type_identity<ram::TupleOperation>(), iIfExists), encodeView(&iIfExists),
-            std::move(indexOperation));
+    return withAccessCounter(mk<IndexIfExists>(type, &iIfExists, nullptr, dispatch(iIfExists.getCondition()),
+                                     visit_(type_identity<ram::TupleOperation>(), iIfExists),
+                                     encodeView(&iIfExists), std::move(indexOperation)),
+            iIfExists.getRelation(), indexTable[&iIfExists]);
 }
 
 NodePtr NodeGenerator::visit_(
@@ -256,6 +425,7 @@ NodePtr NodeGenerator::visit_(
     auto res = mk<ParallelIndexIfExists>(type, &piIfExists, rel, dispatch(piIfExists.getCondition()),
             dispatch(piIfExists.getOperation()), encodeIndexPos(piIfExists), std::move(indexOperation));
     res->setViewContext(parentQueryViewContext);
+    res = withAccessCounter(std::move(res), piIfExists.getRelation(), indexTable[&piIfExists]);
     return res;
 }
 
@@ -308,8 +478,9 @@ NodePtr NodeGenerator::visit_(type_identity<ram::IndexAggregate>, const ram::Ind
     std::size_t relId = encodeRelation(iAggregate.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("IndexAggregate", lookup(iAggregate.getRelation()));
-    return mk<IndexAggregate>(type, &iAggregate, rel, std::move(expr), std::move(cond), std::move(nested),
-            encodeView(&iAggregate), std::move(indexOperation));
+    return withAccessCounter(mk<IndexAggregate>(type, &iAggregate, rel, std::move(expr), std::move(cond),
+                                     std::move(nested), encodeView(&iAggregate), std::move(indexOperation)),
+            iAggregate.getRelation(), indexTable[&iAggregate]);
 }
 
 NodePtr NodeGenerator::visit_(
@@ -326,6 +497,7 @@ NodePtr NodeGenerator::visit_(
     auto res = mk<ParallelIndexAggregate>(type, &piAggregate, rel, std::move(expr), std::move(cond),
             std::move(nested), encodeView(&piAggregate), std::move(indexOperation));
     res->setViewContext(parentQueryViewContext);
+    res = withAccessCounter(std::move(res), piAggregate.getRelation(), indexTable[&piAggregate]);
     return res;
 }
 
@@ -334,7 +506,12 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Break>, const ram::Break& break
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Filter>, const ram::Filter& filter) {
-    return mk<Filter>(I_Filter, &filter, dispatch(filter.getCondition()), dispatch(filter.getOperation()));
+    std::size_t frequencyIndex = 0;
+    if (engine.profileEnabled && engine.frequencyCounterEnabled && !filter.getProfileText().empty()) {
+        frequencyIndex = engine.getFrequencyIndex(filter.getProfileText());
+    }
+    return mk<Filter>(I_Filter, &filter, dispatch(filter.getCondition()), dispatch(filter.getOperation()),
+            frequencyIndex);
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::GuardedInsert>, const ram::GuardedInsert& guardedInsert) {
@@ -343,7 +520,9 @@ NodePtr NodeGenerator::visit_(type_identity<ram::GuardedInsert>, const ram::Guar
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("GuardedInsert", lookup(guardedInsert.getRelation()));
     auto condition = guardedInsert.getCondition();
-    return mk<GuardedInsert>(type, &guardedInsert, rel, std::move(superOp), dispatch(*condition));
+    return withAccessCounter(
+            mk<GuardedInsert>(type, &guardedInsert, rel, std::move(superOp), dispatch(*condition)),
+            guardedInsert.getRelation(), 0);
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Insert>, const ram::Insert& insert) {
@@ -351,7 +530,29 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Insert>, const ram::Insert& ins
     std::size_t relId = encodeRelation(insert.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("Insert", lookup(insert.getRelation()));
-    return mk<Insert>(type, &insert, rel, std::move(superOp));
+    auto res = withAccessCounter(mk<Insert>(type, &insert, rel, std::move(superOp)), insert.getRelation(), 0);
+    auto buffer = insertBuffers.find(&insert);
+    if (buffer != insertBuffers.end()) {
+        res->setBufferId(buffer->second);
+        deferrableInserts.push_back(res.get());
+    }
+    return res;
+}
+
+NodePtr NodeGenerator::visit_(type_identity<ram::NoveltyInsert>, const ram::NoveltyInsert& insert) {
+    SuperInstruction superOp = getInsertSuperInstInfo(insert);
+    auto rel = getRelationHandle(encodeRelation(insert.getRelation()));
+    auto newRel = getRelationHandle(encodeRelation(insert.getNewRelation()));
+    NodeType type = constructNodeType("NoveltyInsert", lookup(insert.getRelation()));
+    assert(type == constructNodeType("NoveltyInsert", lookup(insert.getNewRelation())) &&
+            "new relation must have the structure of the target relation");
+    auto res = withAccessCounter(
+            mk<NoveltyInsert>(type, &insert, rel, newRel, std::move(superOp)), insert.getRelation(), 0);
+    auto buffer = insertBuffers.find(&insert);
+    if (buffer != insertBuffers.end()) {
+        res->setBufferId(buffer->second);
+    }
+    return res;
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Erase>, const ram::Erase& erase) {
@@ -370,10 +571,26 @@ NodePtr NodeGenerator::visit_(type_identity<ram::SubroutineReturn>, const ram::S
     return mk<SubroutineReturn>(I_SubroutineReturn, &ret, std::move(children));
 }
 
+NodePtr NodeGenerator::visit_(type_identity<ram::Branches>, const ram::Branches& branches) {
+    NodePtrVec children;
+    for (const auto* branch : branches.getBranches()) {
+        children.push_back(dispatch(*branch));
+    }
+    return mk<Branches>(I_Branches, &branches, std::move(children));
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::Sequence>, const ram::Sequence& seq) {
+    // Nested sequences are inlined, a sequence stops at the first failing statement either way.
     NodePtrVec children;
     for (const auto& value : seq.getStatements()) {
-        children.push_back(dispatch(*value));
+        if (const auto* nested = as<ram::Sequence>(value)) {
+            auto inner = visit_(type_identity<ram::Sequence>(), *nested);
+            for (auto& child : static_cast<Sequence&>(*inner).releaseChildren()) {
+                children.push_back(std::move(child));
+            }
+        } else {
+            children.push_back(dispatch(*value));
+        }
     }
     return mk<Sequence>(I_Sequence, &seq, std::move(children));
 }
@@ -388,7 +605,15 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Parallel>, const ram::Parallel&
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Loop>, const ram::Loop& loop) {
-    return mk<Loop>(I_Loop, &loop, dispatch(loop.getBody()));
+    if (engine.asyncFixpoint) {
+        if (auto worklist = generateWorklist(loop)) {
+            return worklist;
+        }
+    }
+    loopDepth++;
+    auto body = dispatch(loop.getBody());
+    loopDepth--;
+    return mk<Loop>(I_Loop, &loop, std::move(body));
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::Exit>, const ram::Exit& exit) {
@@ -406,14 +631,77 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Call>, const ram::Call& call) {
     return mk<Call>(I_Call, &call, subroutineId);
 }
 
+NodePtr NodeGenerator::visit_(type_identity<ram::CompactTables>, const ram::CompactTables& compact) {
+    // only relations with symbols, records or ADTs are renumbered
+    CompactTables::Relations relations;
+    for (const auto& [name, relation] : relationMap) {
+        const auto& types = relation->getAttributeTypes();
+        if (any_of(types, [](const std::string& type) {
+                return type[0] == 's' || type[0] == 'r' || type[0] == '+';
+            })) {
+            relations.emplace_back(getRelationHandle(encodeRelation(name)), relation);
+        }
+    }
+    return mk<CompactTables>(I_CompactTables, &compact, std::move(relations));
+}
+
+NodePtr NodeGenerator::visit_(type_identity<ram::Checkpoint>, const ram::Checkpoint& checkpoint) {
+    return mk<Checkpoint>(I_Checkpoint, &checkpoint);
+}
+
+NodePtr NodeGenerator::visit_(type_identity<ram::StratumCache>, const ram::StratumCache& cache) {
+    auto getRelations = [&](const std::vector<std::string>& names) {
+        StratumCache::Relations relations;
+        for (const auto& name : names) {
+            relations.emplace_back(getRelationHandle(encodeRelation(name)), relationMap.at(name));
+        }
+        return relations;
+    };
+    return mk<StratumCache>(I_StratumCache, &cache, dispatch(cache.getBody()),
+            getRelations(cache.getInputs()), getRelations(cache.getOutputs()));
+}
+
+NodePtr NodeGenerator::visit_(type_identity<ram::Guard>, const ram::Guard& guard) {
+    return mk<Guard>(I_Guard, &guard, dispatch(guard.getCondition()), dispatch(guard.getStatement()));
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::LogRelationTimer>, const ram::LogRelationTimer& timer) {
     std::size_t relId = encodeRelation(timer.getRelation());
     auto rel = getRelationHandle(relId);
-    return mk<LogRelationTimer>(I_LogRelationTimer, &timer, dispatch(timer.getStatement()), rel);
+    return mk<LogRelationTimer>(I_LogRelationTimer, &timer, generateTimed(timer), rel);
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::LogTimer>, const ram::LogTimer& timer) {
-    return mk<LogTimer>(I_LogTimer, &timer, dispatch(timer.getStatement()));
+    return mk<LogTimer>(I_LogTimer, &timer, generateTimed(timer));
+}
+
+NodePtr NodeGenerator::generateTimed(const ram::AbstractLog& timer) {
+    const std::string& label = timer.getMessage();
+    const std::string kind = label.substr(0, label.find(';'));
+    if (!engine.operatorProfileEnabled || (kind != "@t-nonrecursive-rule" && kind != "@t-recursive-rule")) {
+        return dispatch(timer.getStatement());
+    }
+    profiledRule = label;
+    operatorPosition = 0;
+    auto res = dispatch(timer.getStatement());
+    profiledRule.clear();
+    return res;
+}
+
+NodePtr NodeGenerator::dispatch(const ram::Node& node) {
+    if (profiledRule.empty() || !isA<ram::Operation>(node)) {
+        return ram::Visitor<NodePtr>::dispatch(node);
+    }
+    // the operations are numbered in pre-order, such that the plan of the rule lists them in order
+    const std::size_t position = operatorPosition++;
+    const std::size_t depth = operatorDepth++;
+    auto res = ram::Visitor<NodePtr>::dispatch(node);
+    --operatorDepth;
+    std::string text = toString(node);
+    text = text.substr(0, text.find('\n'));
+    text.erase(0, text.find_first_not_of(" \t"));
+    return mk<ProfiledOperation>(I_ProfiledOperation, &node, std::move(res),
+            engine.getOperatorIndex(profiledRule, position, depth, text));
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::DebugInfo>, const ram::DebugInfo& dbg) {
@@ -424,7 +712,10 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Clear>, const ram::Clear& clear
     std::size_t relId = encodeRelation(clear.getRelation());
     auto rel = getRelationHandle(relId);
     NodeType type = constructNodeType("Clear", lookup(clear.getRelation()));
-    return mk<Clear>(type, &clear, rel);
+    // relations cleared within a fixpoint loop are refilled in the next iteration, while other
+    // persistent relations are only cleared once they expired
+    bool drop = loopDepth == 0 && !lookup(clear.getRelation()).isTemp();
+    return mk<Clear>(type, &clear, rel, loopDepth > 0, drop);
 }
 
 NodePtr NodeGenerator::visit_(type_identity<ram::LogSize>, const ram::LogSize& size) {
@@ -439,7 +730,31 @@ NodePtr NodeGenerator::visit_(type_identity<ram::IO>, const ram::IO& io) {
     return mk<IO>(I_IO, &io, rel);
 }
 
+void NodeGenerator::encodeDeferrableInserts(const ram::TupleOperation& scan) {
+    // the order of the tuples of a provenance relation matters for the heights of their proofs
+    if (engine.isProvenance) {
+        return;
+    }
+    for (const ram::Insert* insert : ram::getDeferrableInserts(scan.getOperation())) {
+        insertBuffers.emplace(insert, insertBuffers.size());
+    }
+}
+
+void NodeGenerator::addDeferrableInserts(AbstractParallel& scan) {
+    for (const Insert* insert : deferrableInserts) {
+        scan.addDeferrableInsert(insert);
+    }
+    deferrableInserts.clear();
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::Query>, const ram::Query& query) {
+    if (auto bulkInsert = generateBulkInsert(query)) {
+        return bulkInsert;
+    }
+    if (auto bulkErase = generateBulkErase(query)) {
+        return bulkErase;
+    }
+
     std::shared_ptr<ViewContext> viewContext = std::make_shared<ViewContext>();
     parentQueryViewContext = viewContext;
     // split terms of conditions of outer-most filter operation
@@ -478,6 +793,16 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Query>, const ram::Query& query
         };
     });
 
+    // indexes built on demand are built before the views on them are created
+    visit(query, [&](const ram::Node& node) {
+        if (requireView(&node)) {
+            const auto& rel = getViewRelation(&node);
+            if (engine.isa.getIndexSelection(rel).isOnDemand(indexTable[&node])) {
+                viewContext->addOnDemandIndex(encodeRelation(rel), indexTable[&node]);
+            }
+        }
+    });
+
     viewContext->isParallel =
             visitExists(*next, [&](const Node& n) { return as<ram::AbstractParallel, AllowCrossCast>(n); });
 
@@ -492,6 +817,225 @@ NodePtr NodeGenerator::visit_(type_identity<ram::MergeExtend>, const ram::MergeE
     return mk<MergeExtend>(I_MergeExtend, &extend, src, target);
 }
 
+NodePtr NodeGenerator::generateBulkInsert(const ram::Query& query) {
+    // Match FOR t IN src INSERT (t.0, ..., t.n) INTO trg, e.g. the merges of the semi-naive evaluation
+    const auto* scan = as<ram::Scan>(query.getOperation());
+    if (scan == nullptr || !scan->getProfileText().empty()) {
+        return nullptr;
+    }
+    const auto& insert = scan->getOperation();
+    if (typeid(insert) != typeid(ram::Insert)) {
+        return nullptr;
+    }
+    const auto& values = static_cast<const ram::Insert&>(insert).getValues();
+    const ram::Relation& src = lookup(scan->getRelation());
+    const ram::Relation& trg = lookup(static_cast<const ram::Insert&>(insert).getRelation());
+    // lattice relations drop the inserted tuples worse than the tuples they hold
+    if (&src == &trg || src.getArity() != trg.getArity() || values.size() != trg.getArity() ||
+            trg.isLattice()) {
+        return nullptr;
+    }
+    NodeType type = constructNodeType("BulkInsert", src);
+    if (type != constructNodeType("BulkInsert", trg)) {
+        return nullptr;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        const auto* element = as<ram::TupleElement>(values[i]);
+        if (element == nullptr || element->getTupleId() != scan->getTupleId() || element->getElement() != i) {
+            return nullptr;
+        }
+    }
+    return withAccessCounter(
+            mk<BulkInsert>(type, &query, encodeRelation(src.getName()), encodeRelation(trg.getName())),
+            trg.getName(), 0);
+}
+
+NodePtr NodeGenerator::generateBulkErase(const ram::Query& query) {
+    // Match FOR t IN src ERASE (t.0, ..., t.n) FROM trg, e.g. the subsumed tuples of an iteration
+    const auto* scan = as<ram::Scan>(query.getOperation());
+    if (scan == nullptr || !scan->getProfileText().empty()) {
+        return nullptr;
+    }
+    const auto& erase = scan->getOperation();
+    if (typeid(erase) != typeid(ram::Erase)) {
+        return nullptr;
+    }
+    const auto& values = static_cast<const ram::Erase&>(erase).getValues();
+    const ram::Relation& src = lookup(scan->getRelation());
+    const ram::Relation& trg = lookup(static_cast<const ram::Erase&>(erase).getRelation());
+    if (&src == &trg || src.getArity() != trg.getArity() || values.size() != trg.getArity() ||
+            trg.getRepresentation() != RelationRepresentation::BTREE_DELETE) {
+        return nullptr;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        const auto* element = as<ram::TupleElement>(values[i]);
+        if (element == nullptr || element->getTupleId() != scan->getTupleId() || element->getElement() != i) {
+            return nullptr;
+        }
+    }
+    return mk<BulkErase>(constructNodeType("BulkErase", trg), &query, encodeRelation(src.getName()),
+            encodeRelation(trg.getName()));
+}
+
+NodePtr NodeGenerator::generateWorklist(const ram::Loop& loop) {
+    // Match the loop of a recursive stratum whose relations are inserted directly: its rules are
+    // guarded by checks of their delta relations, it exits once the new relations are empty, and it
+    // swaps the delta and new relations
+    std::vector<const ram::Query*> queries;
+    std::vector<const ram::Condition*> guards;
+    std::vector<const ram::Condition*> exits;
+    std::map<std::string, std::string> deltaOf;
+    std::set<std::string> cleared;
+    bool matches = true;
+    std::function<void(const ram::Statement&)> collect = [&](const ram::Statement& stmt) {
+        if (const auto* seq = as<ram::Sequence>(stmt)) {
+            for (const auto* cur : seq->getStatements()) {
+                collect(*cur);
+            }
+        } else if (const auto* guard = as<ram::Guard>(stmt)) {
+            guards.push_back(&guard->getCondition());
+            collect(guard->getStatement());
+        } else if (const auto* dbg = as<ram::DebugInfo>(stmt)) {
+            collect(dbg->getStatement());
+        } else if (const auto* query = as<ram::Query>(stmt)) {
+            queries.push_back(query);
+        } else if (const auto* exit = as<ram::Exit>(stmt)) {
+            exits.push_back(&exit->getCondition());
+        } else if (const auto* swap = as<ram::Swap>(stmt)) {
+            deltaOf[swap->getSecondRelation()] = swap->getFirstRelation();
+        } else if (const auto* clear = as<ram::Clear>(stmt)) {
+            cleared.insert(clear->getRelation());
+        } else {
+            matches = false;
+        }
+    };
+    collect(loop.getBody());
+    if (!matches || queries.empty() || deltaOf.empty() || exits.empty()) {
+        return nullptr;
+    }
+
+    std::map<std::string, std::size_t> deltas;
+    for (const auto& [newRelation, delta] : deltaOf) {
+        deltas.emplace(delta, deltas.size());
+    }
+    auto isNewRelation = [&](const std::string& rel) { return contains(deltaOf, rel); };
+    auto checksEmptiness = [&](const ram::Condition& condition, auto&& isChecked, bool negated) {
+        return !visitExists(condition, [&](const ram::Node& node) {
+            if (const auto* check = as<ram::EmptinessCheck>(node)) {
+                return !isChecked(check->getRelation());
+            }
+            return !isA<ram::Conjunction>(node) && !(negated && isA<ram::Negation>(node));
+        });
+    };
+    for (const auto& rel : cleared) {
+        matches = matches && isNewRelation(rel);
+    }
+    auto isDelta = [&](const std::string& rel) { return contains(deltas, rel); };
+    for (const auto* guard : guards) {
+        matches = matches && checksEmptiness(*guard, isDelta, true);
+    }
+    for (const auto* exit : exits) {
+        matches = matches && checksEmptiness(*exit, isNewRelation, false);
+    }
+    if (!matches) {
+        return nullptr;
+    }
+
+    // Each rule must scan a delta relation in its outermost operation, and otherwise only insert the
+    // tuples it derives into the relations of the loop, such that it can be evaluated for any subset
+    // of the tuples of the delta relation at any time
+    std::set<std::string> loopRelations;
+    for (const auto& [newRelation, delta] : deltaOf) {
+        loopRelations.insert(newRelation);
+        loopRelations.insert(delta);
+    }
+    for (const auto* query : queries) {
+        visit(*query, [&](const ram::NoveltyInsert& insert) { loopRelations.insert(insert.getRelation()); });
+    }
+    auto accessesLoop = [&](const ram::Node& root) {
+        return visitExists(root, [&](const ram::Node& node) {
+            if (const auto* op = as<ram::RelationOperation>(node)) {
+                return contains(loopRelations, op->getRelation());
+            } else if (const auto* check = as<ram::AbstractExistenceCheck>(node)) {
+                return contains(loopRelations, check->getRelation());
+            } else if (const auto* check = as<ram::EmptinessCheck>(node)) {
+                return contains(loopRelations, check->getRelation());
+            } else if (const auto* size = as<ram::RelationSize>(node)) {
+                return contains(loopRelations, size->getRelation());
+            } else if (const auto* insert = as<ram::NoveltyInsert>(node)) {
+                return !isNewRelation(insert->getNewRelation());
+            }
+            return isA<ram::Insert>(node) || isA<ram::Erase>(node) ||
+                   as<ram::AbstractParallel, AllowCrossCast>(node) != nullptr;
+        });
+    };
+    std::vector<std::pair<const ram::Scan*, std::vector<const ram::Condition*>>> scans;
+    for (const auto* query : queries) {
+        const ram::Operation* op = &query->getOperation();
+        std::vector<const ram::Condition*> conditions;
+        while (const auto* filter = as<ram::Filter>(op)) {
+            for (const auto* term : findConjunctiveTerms(&filter->getCondition())) {
+                conditions.push_back(term);
+            }
+            op = &filter->getOperation();
+        }
+        const auto* scan = as<ram::Scan>(op);
+        if (scan == nullptr || !contains(deltas, scan->getRelation()) || accessesLoop(scan->getOperation())) {
+            return nullptr;
+        }
+
+        // the delta relation is not empty while there are tuples to evaluate the rule for
+        std::vector<const ram::Condition*> independent;
+        for (const auto* term : conditions) {
+            const auto* negation = as<ram::Negation>(term);
+            const auto* check =
+                    negation != nullptr ? as<ram::EmptinessCheck>(negation->getOperand()) : nullptr;
+            if (check != nullptr && check->getRelation() == scan->getRelation()) {
+                continue;
+            }
+            auto needsView = [&](const ram::Node& node) { return requireView(&node); };
+            if (accessesLoop(*term) || visitExists(*term, needsView)) {
+                return nullptr;
+            }
+            independent.push_back(term);
+        }
+        scans.emplace_back(scan, std::move(independent));
+    }
+
+    std::vector<RelationHandle*> deltaRelations(deltas.size());
+    for (const auto& [delta, pos] : deltas) {
+        deltaRelations[pos] = getRelationHandle(encodeRelation(delta));
+    }
+    std::vector<Worklist::Rule> rules;
+    std::vector<std::pair<std::size_t, std::size_t>> buffers;
+    for (const auto& [scan, conditions] : scans) {
+        VecOwn<Node> conditionNodes;
+        for (const auto* condition : conditions) {
+            conditionNodes.push_back(dispatch(*condition));
+        }
+        visit(scan->getOperation(), [&](const ram::NoveltyInsert& insert) {
+            buffers.emplace_back(insertBuffers.size(), deltas.at(deltaOf.at(insert.getNewRelation())));
+            insertBuffers.emplace(&insert, insertBuffers.size());
+        });
+
+        auto viewContext = std::make_shared<ViewContext>();
+        parentQueryViewContext = viewContext;
+        visit(scan->getOperation(), [&](const ram::Node& node) {
+            if (requireView(&node)) {
+                const auto& rel = getViewRelation(&node);
+                viewContext->addViewInfoForNested(encodeRelation(rel), indexTable[&node], encodeView(&node));
+                if (engine.isa.getIndexSelection(rel).isOnDemand(indexTable[&node])) {
+                    viewContext->addOnDemandIndex(encodeRelation(rel), indexTable[&node]);
+                }
+            }
+        });
+        orderingContext.addTupleWithDefaultOrder(scan->getTupleId(), *scan);
+        rules.push_back({deltas.at(scan->getRelation()), static_cast<std::size_t>(scan->getTupleId()),
+                std::move(conditionNodes), visit_(type_identity<ram::TupleOperation>(), *scan), viewContext});
+    }
+    return mk<Worklist>(I_Worklist, &loop, std::move(deltaRelations), std::move(rules), std::move(buffers));
+}
+
 NodePtr NodeGenerator::visit_(type_identity<ram::Swap>, const ram::Swap& swap) {
     std::size_t src = encodeRelation(swap.getFirstRelation());
     std::size_t target = encodeRelation(swap.getSecondRelation());
@@ -508,7 +1052,6 @@ NodePtr NodeGenerator::visit_(type_identity<ram::Node>, const ram::Node& node) {
 
 void NodeGenerator::newQueryBlock() {
     viewTable.clear();
-    viewId = 0;
 }
 
 std::size_t NodeGenerator::getNewRelId() {
@@ -532,6 +1075,14 @@ std::size_t NodeGenerator::encodeIndexPos(RamNode& node) {
     return i;
 };
 
+template <class Op>
+Own<Op> NodeGenerator::withAccessCounter(Own<Op> op, const std::string& relation, std::size_t indexPos) {
+    if (engine.profileEnabled && engine.frequencyCounterEnabled) {
+        op->setAccessIndex(engine.getAccessIndex(relation, indexPos));
+    }
+    return op;
+}
+
 std::size_t NodeGenerator::encodeView(const ram::Node* node) {
     auto pos = viewTable.find(node);
     if (pos != viewTable.end()) {
@@ -588,12 +1139,17 @@ const std::string& NodeGenerator::getViewRelation(const ram::Node* node) {
 }
 
 SuperInstruction NodeGenerator::getIndexSuperInstInfo(const ram::IndexOperation& ramIndex) {
-    std::size_t arity = getArity(ramIndex.getRelation());
-    auto interpreterRel = encodeRelation(ramIndex.getRelation());
-    auto indexId = encodeIndexPos(ramIndex);
+    const auto pattern = ramIndex.getRangePattern();
+    return getIndexSuperInstInfo(
+            ramIndex.getRelation(), encodeIndexPos(ramIndex), pattern.first, pattern.second);
+}
+
+SuperInstruction NodeGenerator::getIndexSuperInstInfo(const std::string& relName, std::size_t indexId,
+        const std::vector<ram::Expression*>& first, const std::vector<ram::Expression*>& second) {
+    std::size_t arity = getArity(relName);
+    auto interpreterRel = encodeRelation(relName);
     auto order = (*getRelationHandle(interpreterRel))->getIndexOrder(indexId);
     SuperInstruction indexOperation(arity);
-    const auto& first = ramIndex.getRangePattern().first;
     for (std::size_t i = 0; i < arity; ++i) {
         // Note: unlike orderingContext::mapOrder, where we try to decode the order,
         // here we have to encode the order.
@@ -624,7 +1180,6 @@ SuperInstruction NodeGenerator::getIndexSuperInstInfo(const ram::IndexOperation&
         // Generic expression
         indexOperation.exprFirst.push_back(std::pair<std::size_t, Own<Node>>(i, dispatch(*low)));
     }
-    const auto& second = ramIndex.getRangePattern().second;
     for (std::size_t i = 0; i < arity; ++i) {
         auto& hig = second[order[i]];
 
@@ -731,6 +1286,51 @@ SuperInstruction NodeGenerator::getInsertSuperInstInfo(const ram::Insert& exist)
     return superOp;
 }
 
+bool NodeGenerator::isGroupedAggregate(
+        const ram::ParallelScan& scan, const ram::IndexAggregate& aggregate, const IndexAggregate& node) {
+    // the aggregate searches for the tuples with some elements equal to elements of the scanned tuple
+    const auto [lower, upper] = aggregate.getRangePattern();
+    bool grouped = false;
+    for (std::size_t i = 0; i < lower.size(); ++i) {
+        if (isUndefValue(lower[i]) && isUndefValue(upper[i])) {
+            continue;
+        }
+        const auto* low = as<ram::TupleElement>(lower[i]);
+        const auto* high = as<ram::TupleElement>(upper[i]);
+        if (low == nullptr || high == nullptr || low->getTupleId() != scan.getTupleId() || *low != *high) {
+            return false;
+        }
+        grouped = true;
+    }
+
+    // the filter and the aggregated expression only depend on the tuples of the aggregate
+    auto isLocal = [&](const ram::TupleElement& element) {
+        grouped = grouped && element.getTupleId() == aggregate.getTupleId();
+    };
+    visit(aggregate.getCondition(), isLocal);
+    visit(aggregate.getExpression(), isLocal);
+
+    // the elements of a group are the first of the order of the index
+    const auto& elements = node.getSuperInst().tupleFirst;
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+        grouped = grouped && elements[i][0] == i;
+    }
+    return grouped;
+}
+
+Constraint::Operand NodeGenerator::getConstraintOperand(const ram::Expression& expr) {
+    Constraint::Operand operand;
+    if (const auto* constant = as<ram::NumericConstant>(expr)) {
+        operand.kind = Constraint::Operand::Constant;
+        operand.constant = constant->getConstant();
+    } else if (const auto* tuple = as<ram::TupleElement>(expr)) {
+        operand.kind = Constraint::Operand::Element;
+        operand.tupleId = tuple->getTupleId();
+        operand.element = orderingContext.mapOrder(operand.tupleId, tuple->getElement());
+    }
+    return operand;
+}
+
 SuperInstruction NodeGenerator::getEraseSuperInstInfo(const ram::Erase& exist) {
     std::size_t arity = getArity(exist.getRelation());
     SuperInstruction superOp(arity);
@@ -23,26 +23,33 @@
 #include "interpreter/Relation.h"
 #include "interpreter/ViewContext.h"
 #include "ram/AbstractExistenceCheck.h"
+#include "ram/AbstractLog.h"
 #include "ram/AbstractParallel.h"
 #include "ram/Aggregate.h"
 #include "ram/AutoIncrement.h"
+#include "ram/Branches.h"
 #include "ram/Break.h"
 #include "ram/Call.h"
+#include "ram/Checkpoint.h"
 #include "ram/Clear.h"
+#include "ram/CompactTables.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
 #include "ram/Constraint.h"
 #include "ram/DebugInfo.h"
 #include "ram/EmptinessCheck.h"
+#include "ram/Erase.h"
 #include "ram/ExistenceCheck.h"
 #include "ram/Exit.h"
 #include "ram/Expression.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Guard.h"
 #include "ram/IO.h"
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
+#include "ram/IndexIntersect.h"
 #include "ram/IndexOperation.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
@@ -56,6 +63,7 @@
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/NestedOperation.h"
 #include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
 #include "ram/NumericConstant.h"
 #include "ram/Operation.h"
 #include "ram/PackRecord.h"
@@ -65,15 +73,18 @@
 #include "ram/ParallelIndexAggregate.h"
 #include "ram/ParallelIndexIfExists.h"
 #include "ram/ParallelIndexScan.h"
+#include "ram/ParallelNestedIntrinsicOperator.h"
 #include "ram/ParallelScan.h"
 #include "ram/Program.h"
 #include "ram/ProvenanceExistenceCheck.h"
 #include "ram/Query.h"
 #include "ram/Relation.h"
+#include "ram/RelationOperation.h"
 #include "ram/RelationSize.h"
 #include "ram/Scan.h"
 #include "ram/Sequence.h"
 #include "ram/Statement.h"
+#include "ram/StratumCache.h"
 #include "ram/StringConstant.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -85,6 +96,7 @@
 #include "ram/UnpackRecord.h"
 #include "ram/UserDefinedOperator.h"
 #include "ram/analysis/Index.h"
+#include "ram/utility/DeferredInserts.h"
 #include "ram/utility/Utils.h"
 #include "ram/utility/Visitor.h"
 #include "souffle/RamTypes.h"
@@ -97,6 +109,7 @@
 #include <map>
 #include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <typeinfo>
 #include <unordered_map>
@@ -113,7 +126,7 @@ class Engine;
 class NodeGenerator : public ram::Visitor<Own<Node>> {
     using NodePtr = Own<Node>;
     using NodePtrVec = std::vector<NodePtr>;
-    using RelationHandle = Own<RelationWrapper>;
+    using RelationHandle = std::shared_ptr<RelationWrapper>;
     using ram::Visitor<Own<Node>>::visit_;
 
 public:
@@ -125,6 +138,12 @@ public:
      */
     NodePtr generateTree(const ram::Node& root);
 
+    /** @brief Encode and create the relation, return the relation id */
+    std::size_t encodeRelation(const std::string& relName);
+
+    /** @brief Generate a node, wrapped into a ProfiledOperation if it is an operation of a profiled rule */
+    NodePtr dispatch(const ram::Node& node) override;
+
     NodePtr visit_(type_identity<ram::NumericConstant>, const ram::NumericConstant& num) override;
 
     NodePtr visit_(type_identity<ram::StringConstant>, const ram::StringConstant& num) override;
@@ -140,6 +159,9 @@ public:
     NodePtr visit_(
             type_identity<ram::NestedIntrinsicOperator>, const ram::NestedIntrinsicOperator& op) override;
 
+    NodePtr visit_(type_identity<ram::ParallelNestedIntrinsicOperator>,
+            const ram::ParallelNestedIntrinsicOperator& op) override;
+
     NodePtr visit_(type_identity<ram::PackRecord>, const ram::PackRecord& pr) override;
 
     NodePtr visit_(type_identity<ram::SubroutineArgument>, const ram::SubroutineArgument& arg) override;
@@ -173,6 +195,8 @@ public:
 
     NodePtr visit_(type_identity<ram::IndexScan>, const ram::IndexScan& iScan) override;
 
+    NodePtr visit_(type_identity<ram::IndexIntersect>, const ram::IndexIntersect& intersect) override;
+
     NodePtr visit_(type_identity<ram::ParallelIndexScan>, const ram::ParallelIndexScan& piscan) override;
 
     NodePtr visit_(type_identity<ram::IfExists>, const ram::IfExists& ifexists) override;
@@ -202,11 +226,14 @@ public:
     NodePtr visit_(type_identity<ram::GuardedInsert>, const ram::GuardedInsert& guardedPorject) override;
 
     NodePtr visit_(type_identity<ram::Insert>, const ram::Insert& insert) override;
+    NodePtr visit_(type_identity<ram::NoveltyInsert>, const ram::NoveltyInsert& insert) override;
 
     NodePtr visit_(type_identity<ram::Erase>, const ram::Erase& erase) override;
 
     NodePtr visit_(type_identity<ram::SubroutineReturn>, const ram::SubroutineReturn& ret) override;
 
+    NodePtr visit_(type_identity<ram::Branches>, const ram::Branches& branches) override;
+
     NodePtr visit_(type_identity<ram::Sequence>, const ram::Sequence& seq) override;
 
     NodePtr visit_(type_identity<ram::Parallel>, const ram::Parallel& parallel) override;
@@ -217,6 +244,14 @@ public:
 
     NodePtr visit_(type_identity<ram::Call>, const ram::Call& call) override;
 
+    NodePtr visit_(type_identity<ram::CompactTables>, const ram::CompactTables& compact) override;
+
+    NodePtr visit_(type_identity<ram::Checkpoint>, const ram::Checkpoint& checkpoint) override;
+
+    NodePtr visit_(type_identity<ram::StratumCache>, const ram::StratumCache& cache) override;
+
+    NodePtr visit_(type_identity<ram::Guard>, const ram::Guard& guard) override;
+
     NodePtr visit_(type_identity<ram::LogRelationTimer>, const ram::LogRelationTimer& timer) override;
 
     NodePtr visit_(type_identity<ram::LogTimer>, const ram::LogTimer& timer) override;
@@ -281,7 +316,10 @@ private:
     };
 
 private:
-    /** @brief Reset view allocation system, since view's life time is within each query. */
+    /**
+     * @brief Start the views of a new query. The view ids are not reused by later queries, such
+     * that the contexts retain the views of each query, and their hints, across its executions.
+     */
     void newQueryBlock();
 
     /** @brief Get a valid relation id for encoding */
@@ -297,14 +335,30 @@ private:
     /** @brief Encode and return the View id of an operation. */
     std::size_t encodeView(const ram::Node* node);
 
+    /** @brief Set the access counter of an operation on an index, if the index accesses are profiled */
+    template <class Op>
+    Own<Op> withAccessCounter(Own<Op> op, const std::string& relation, std::size_t indexPos);
+
     /** @brief get arity of relation */
     const ram::Relation& lookup(const std::string& relName);
 
     /** @brief get arity of relation */
     std::size_t getArity(const std::string& relName);
 
-    /** @brief Encode and create the relation, return the relation id */
-    std::size_t encodeRelation(const std::string& relName);
+    /** @brief Generate the statement of a timer, profiling its operations if it times a rule */
+    NodePtr generateTimed(const ram::AbstractLog& timer);
+
+    /** @brief Return a bulk insertion if the query copies one relation into another, nullptr otherwise */
+    NodePtr generateBulkInsert(const ram::Query& query);
+
+    /** @brief Return a bulk erasure if the query erases one relation from another, nullptr otherwise */
+    NodePtr generateBulkErase(const ram::Query& query);
+
+    /**
+     * @brief Return a worklist evaluating the rules of the loop for the tuples they derive, if the rules
+     * are driven by delta relations of relations inserted directly, nullptr otherwise
+     */
+    NodePtr generateWorklist(const ram::Loop& loop);
 
     /* @brief Get a relation instance from engine */
     RelationHandle* getRelationHandle(const std::size_t idx);
@@ -325,6 +379,13 @@ private:
      */
     SuperInstruction getIndexSuperInstInfo(const ram::IndexOperation& ramIndex);
 
+    /**
+     * @brief Encode and return the super-instruction information about a range search,
+     * given the lower and upper bounds of each attribute.
+     */
+    SuperInstruction getIndexSuperInstInfo(const std::string& relName, std::size_t indexId,
+            const std::vector<ram::Expression*>& first, const std::vector<ram::Expression*>& second);
+
     /**
      * @brief Encode and return the super-instruction information about an existence check operation
      */
@@ -339,6 +400,25 @@ private:
     SuperInstruction getInsertSuperInstInfo(const ram::Insert& exist);
     SuperInstruction getEraseSuperInstInfo(const ram::Erase& exist);
 
+    /**
+     * @brief Return whether the aggregate nested in a parallel scan is grouped by elements of the
+     * scanned tuple, such that it can be computed for all groups in one pass over its relation.
+     */
+    bool isGroupedAggregate(
+            const ram::ParallelScan& scan, const ram::IndexAggregate& aggregate, const IndexAggregate& node);
+
+    /**
+     * @brief Encode the buffers of the insertions nested in a parallel scan whose tuples the threads
+     * may collect and insert at the end of the scan
+     */
+    void encodeDeferrableInserts(const ram::TupleOperation& scan);
+
+    /** @brief Record the insertions generated for the encoded buffers in the parallel scan */
+    void addDeferrableInserts(AbstractParallel& scan);
+
+    /** @brief Decode an operand of a constraint that is read without executing its node */
+    Constraint::Operand getConstraintOperand(const ram::Expression& expr);
+
     /** Environment encoding, store a mapping from ram::Node to its operation index id. */
     std::unordered_map<const ram::Node*, std::size_t> indexTable;
     /** Points to the current viewContext during the generation.
@@ -349,6 +429,17 @@ private:
     std::size_t viewId = 0;
     /** Next available location to encode a relation */
     std::size_t relId = 0;
+    /** Number of loops enclosing the currently generated node */
+    std::size_t loopDepth = 0;
+    /** Label of the timer of the rule whose operations are profiled; empty outside of rules */
+    std::string profiledRule;
+    /** Number of operations of the profiled rule generated so far, and enclosing the current node */
+    std::size_t operatorPosition = 0;
+    std::size_t operatorDepth = 0;
+    /** Buffers of the insertions which the threads of parallel scans may defer, by insertion */
+    std::unordered_map<const ram::Insert*, std::size_t> insertBuffers;
+    /** Insertions generated for the buffers of the current parallel scan */
+    std::vector<const Insert*> deferrableInserts;
     /** Environment encoding, store a mapping from ram::Node to its View id. */
     std::unordered_map<const ram::Node*, std::size_t> viewTable;
     /** Environment encoding, store a mapping from ram::Relation to its id */
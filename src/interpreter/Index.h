@@ -21,15 +21,20 @@
 #include "souffle/datastructure/UnionFind.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StreamUtil.h"
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iosfwd>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -109,6 +114,30 @@ public:
         return res;
     }
 
+    /**
+     * Encode a tuple of any arity, e.g., a tuple of a relation of a dynamic arity, with order
+     */
+    template <typename Entry>
+    std::vector<RamDomain> encode(const Entry& entry) const {
+        std::vector<RamDomain> res(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            res[i] = entry[order[i]];
+        }
+        return res;
+    }
+
+    /**
+     * Decode a tuple of any arity, e.g., a row of a relation of a dynamic arity, by order
+     */
+    template <typename Entry>
+    std::vector<RamDomain> decode(const Entry& entry) const {
+        std::vector<RamDomain> res(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            res[order[i]] = entry[i];
+        }
+        return res;
+    }
+
     const AttributeOrder& getOrder() const {
         return this->order;
     }
@@ -139,6 +168,25 @@ struct ViewWrapper {
     virtual ~ViewWrapper() = default;
 };
 
+/**
+ * Determines whether a data structure can count the elements of a range
+ * without enumerating them.
+ */
+template <typename Data, typename = void>
+struct has_count_range : std::false_type {};
+
+template <typename Data>
+struct has_count_range<Data, std::void_t<decltype(std::declval<const Data&>().countRange(
+                                     std::declval<const typename Data::element_type&>(),
+                                     std::declval<const typename Data::element_type&>()))>>
+        : std::true_type {};
+
+/** The number of elements of an index, from which they are inserted into another index in parallel */
+constexpr std::size_t PARALLEL_INSERT_SIZE = 1 << 14;
+
+/** The number of partitions of an index inserted in parallel, picked up by idle threads */
+constexpr std::size_t INSERT_PARTITIONS = 256;
+
 /**
  * An index is an abstraction of a data structure
  */
@@ -159,6 +207,72 @@ protected:
     Data data;
     Comparator cmp;
 
+    // incremented whenever nodes of the data structure may be released, invalidating the hints of views
+    std::atomic<std::size_t> generation{0};
+
+    /**
+     * Tries order their elements by the unsigned values of their columns, hence they are not searched
+     * for the bounds of a range, but for the prefix of the columns bound to a single value. The
+     * searches of tries only bind such prefixes, the remaining columns range over all values.
+     */
+    static constexpr bool isTrie = std::is_same_v<Data, Brie<Arity>>;
+
+    /** Whether the data structure is a b-tree, which is built bottom-up from sorted elements */
+    static constexpr bool isBtree =
+            std::is_same_v<Data, Btree<Arity>> || std::is_same_v<Data, BtreeDelete<Arity>>;
+
+    /** Obtains the number of leading columns bound to a single value by the given range */
+    static std::size_t getPrefixLength(const Tuple& low, const Tuple& high) {
+        std::size_t levels = 0;
+        while (levels < Arity && low[levels] == high[levels]) {
+            ++levels;
+        }
+        return levels;
+    }
+
+    /** Obtains the elements of a trie whose prefix of the given length matches the given entry */
+    template <std::size_t... Levels>
+    static souffle::range<iterator> getPrefixRange(const Data& data, const Tuple& entry, std::size_t levels,
+            Hints& hints, std::index_sequence<Levels...>) {
+        souffle::range<iterator> res{data.end(), data.end()};
+        ((Levels == levels && (res = data.template getBoundaries<Levels>(entry, hints), true)) || ...);
+        return res;
+    }
+
+    /** Counts the elements of a trie whose prefix of the given length matches the given entry */
+    template <std::size_t... Levels>
+    static std::size_t countPrefix(const Data& data, const Tuple& entry, std::size_t levels, Hints& hints,
+            std::index_sequence<Levels...>) {
+        std::size_t res = 0;
+        ((Levels == levels && (res = data.template countBoundaries<Levels>(entry, hints), true)) || ...);
+        return res;
+    }
+
+    /** Encodes the elements of the given index into the order of this index */
+    std::vector<Tuple> encodeAll(const Index& src) const {
+        std::vector<Tuple> res;
+        res.reserve(src.size());
+        for (const auto& tuple : src) {
+            res.push_back(order.encode(src.order.decode(tuple)));
+        }
+        return res;
+    }
+
+    /**
+     * Merges the given sorted elements, in the order of this index, with the elements of this index and
+     * rebuilds its b-tree bottom-up from the union.
+     */
+    template <typename Iter>
+    void merge(const Iter& begin, const Iter& end, std::size_t count) {
+        std::vector<Tuple> merged;
+        merged.reserve(data.size() + count);
+        std::set_union(data.begin(), data.end(), begin, end, std::back_inserter(merged),
+                [&](const Tuple& a, const Tuple& b) { return cmp.less(a, b); });
+        Data rebuilt = Data::load(merged.begin(), merged.end());
+        data.swap(rebuilt);
+        ++generation;
+    }
+
 public:
     /**
      * A view on a relation caching local access patterns (not thread safe!).
@@ -169,9 +283,26 @@ public:
         mutable Hints hints;
         const Data& data;
         Comparator cmp;
+        std::size_t generation;
 
     public:
-        View(const Data& data) : data(data) {}
+        View(const Data& data, std::size_t generation) : data(data), generation(generation) {}
+
+        /**
+         * Prepare this view for another query, keeping its hints unless the nodes they refer to may
+         * have been released since. Returns false if the view is not on the given index.
+         */
+        bool reuse(const Index& index) {
+            if (&index.data != &data) {
+                return false;
+            }
+            const std::size_t current = index.generation.load(std::memory_order_relaxed);
+            if (generation != current) {
+                hints = Hints();
+                generation = current;
+            }
+            return true;
+        }
 
         /** Tests whether the given entry is contained in this index. */
         bool contains(const Tuple& entry) {
@@ -188,7 +319,28 @@ public:
             if (cmp(low, high) > 0) {
                 return {data.end(), data.end()};
             }
-            return {data.lower_bound(low, hints), data.upper_bound(high, hints)};
+            if constexpr (isTrie) {
+                return getPrefixRange(data, low, getPrefixLength(low, high), hints,
+                        std::make_index_sequence<Arity + 1>());
+            } else {
+                return {data.lower_bound(low, hints), data.upper_bound(high, hints)};
+            }
+        }
+
+        /** Counts the elements in the given range within this index. */
+        std::size_t count(const Tuple& low, const Tuple& high) {
+            if (cmp(low, high) > 0) {
+                return 0;
+            }
+            if constexpr (has_count_range<Data>::value) {
+                return data.countRange(low, high);
+            } else if constexpr (isTrie) {
+                return countPrefix(data, low, getPrefixLength(low, high), hints,
+                        std::make_index_sequence<Arity + 1>());
+            } else {
+                auto r = range(low, high);
+                return std::distance(r.begin(), r.end());
+            }
         }
     };
 
@@ -197,7 +349,7 @@ public:
      * Requests the creation of a view on this index.
      */
     View createView() {
-        return View(this->data);
+        return View(this->data, generation.load(std::memory_order_relaxed));
     }
 
     iterator begin() const {
@@ -238,10 +390,198 @@ public:
 
     /**
      * Inserts all elements of the given index.
+     *
+     * The elements arrive in the order of the source index, hence the hints exploit the locality
+     * of consecutive insertions if both indexes share the same order.
      */
     void insert(const Index<Arity, Structure>& src) {
+        // tries of the same order are merged node by node
+        if constexpr (isTrie) {
+            if (order == src.order) {
+                data.insertAll(src.data);
+                return;
+            }
+        }
+        const bool reorder = order != src.order;
+        if constexpr (isBtree) {
+            // a source as large as this index is merged with it into a tree built bottom-up
+            if (!src.empty() && src.size() >= data.size()) {
+                std::vector<Tuple> sorted;
+                if (reorder) {
+                    sorted = encodeAll(src);
+                    parallelSort(sorted.begin(), sorted.end(),
+                            [&](const Tuple& a, const Tuple& b) { return cmp.less(a, b); });
+                    merge(sorted.begin(), sorted.end(), sorted.size());
+                } else {
+                    merge(src.begin(), src.end(), src.size());
+                }
+                return;
+            }
+        }
+        if constexpr (std::is_same_v<Data, Btree<Arity>>) {
+            // the partitions of a large source are inserted by concurrent threads, each into the region
+            // of the tree of its range of keys if both indexes share the same order
+            if (src.size() >= PARALLEL_INSERT_SIZE) {
+                auto chunks = src.data.partition(INSERT_PARTITIONS);
+                PARALLEL_START
+                    Hints hints;
+                    pfor(std::size_t i = 0; i < chunks.size(); ++i) {
+                        for (const auto& tuple : chunks[i]) {
+                            data.insert(reorder ? order.encode(src.order.decode(tuple)) : tuple, hints);
+                        }
+                    }
+                PARALLEL_END
+                return;
+            }
+        }
+        Hints hints;
         for (const auto& tuple : src) {
-            this->insert(tuple);
+            data.insert(order.encode(src.order.decode(tuple)), hints);
+        }
+    }
+
+    /**
+     * Inserts the given tuples, collected by the threads of a parallel query.
+     *
+     * The tuples are sorted into the order of this index. A b-tree merges them with its elements if
+     * they are as many, and otherwise consecutive chunks of them are inserted by concurrent threads,
+     * each into the region of the tree of its range of keys.
+     */
+    void insertAll(const std::vector<Tuple>& tuples) {
+        if constexpr (isBtree) {
+            std::vector<Tuple> sorted(tuples.size());
+            PARALLEL_START
+            pfor(std::size_t i = 0; i < tuples.size(); ++i) {
+                sorted[i] = order.encode(tuples[i]);
+            }
+            PARALLEL_END
+            parallelSort(sorted.begin(), sorted.end(),
+                    [&](const Tuple& a, const Tuple& b) { return cmp.less(a, b); });
+            sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                                 [&](const Tuple& a, const Tuple& b) { return cmp.equal(a, b); }),
+                    sorted.end());
+            if (sorted.size() >= data.size()) {
+                merge(sorted.begin(), sorted.end(), sorted.size());
+                return;
+            }
+            if constexpr (std::is_same_v<Data, Btree<Arity>>) {
+                if (sorted.size() >= PARALLEL_INSERT_SIZE) {
+                    PARALLEL_START
+                        Hints hints;
+                        pfor(std::size_t i = 0; i < INSERT_PARTITIONS; ++i) {
+                            const std::size_t end = sorted.size() * (i + 1) / INSERT_PARTITIONS;
+                            for (std::size_t j = sorted.size() * i / INSERT_PARTITIONS; j < end; ++j) {
+                                data.insert(sorted[j], hints);
+                            }
+                        }
+                    PARALLEL_END
+                    return;
+                }
+            }
+            Hints hints;
+            for (const auto& tuple : sorted) {
+                data.insert(tuple, hints);
+            }
+            return;
+        }
+        Hints hints;
+        for (const auto& tuple : tuples) {
+            data.insert(order.encode(tuple), hints);
+        }
+    }
+
+    /**
+     * Loads the given tuples into this index.
+     *
+     * B-trees are empty when loaded from an input, so the tuples are sorted into the order of
+     * this index and the tree is built bottom-up, rather than descending from the root for each
+     * tuple. Other structures insert the tuples one by one.
+     */
+    void load(const std::vector<Tuple>& tuples) {
+        if constexpr (isBtree) {
+            if (data.empty()) {
+                std::vector<Tuple> sorted(tuples.size());
+                PARALLEL_START
+                pfor(std::size_t i = 0; i < tuples.size(); ++i) {
+                    sorted[i] = order.encode(tuples[i]);
+                }
+                PARALLEL_END
+                parallelSort(sorted.begin(), sorted.end(),
+                        [&](const Tuple& a, const Tuple& b) { return cmp.less(a, b); });
+                sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                                     [&](const Tuple& a, const Tuple& b) { return cmp.equal(a, b); }),
+                        sorted.end());
+                Data loaded = Data::load(sorted.begin(), sorted.end());
+                data.swap(loaded);
+                ++generation;
+                return;
+            }
+        }
+        Hints hints;
+        for (const auto& tuple : tuples) {
+            data.insert(order.encode(tuple), hints);
+        }
+    }
+
+    /**
+     * Loads all elements of the given index into this index, which is built in bulk if it is empty.
+     */
+    void load(const Index<Arity, Structure>& src) {
+        std::vector<Tuple> tuples;
+        for (const auto& tuple : src) {
+            tuples.push_back(src.order.decode(tuple));
+        }
+        load(tuples);
+    }
+
+    /**
+     * Obtains the number of bytes allocated by this index.
+     */
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(Data) + data.getMemoryUsage();
+    }
+
+    /**
+     * Obtains the number of nodes of the tree of this index; equivalence relations have no nodes.
+     */
+    std::size_t getNumNodes() const {
+        if constexpr (std::is_same_v<Data, Eqrel<Arity>>) {
+            return 0;
+        } else {
+            return data.getNumNodes();
+        }
+    }
+
+    /**
+     * Obtains the average fraction of the keys of the b-tree nodes of this index in use, or 0 if the
+     * index is not a b-tree.
+     */
+    double getFillFactor() const {
+        if constexpr (std::is_same_v<Data, Eqrel<Arity>> || std::is_same_v<Data, Brie<Arity>>) {
+            return 0.0;
+        } else {
+            return data.getFillFactor();
+        }
+    }
+
+    /**
+     * Rebuilds the b-tree of this index with densely filled nodes. Equivalence relations and tries
+     * are left as they are.
+     */
+    void compact() {
+        if constexpr (!std::is_same_v<Data, Eqrel<Arity>> && !isTrie) {
+            data.compact();
+            ++generation;
+        }
+    }
+
+    /**
+     * Freezes a b-tree index not modified by the remaining strata, such that its size is known
+     * without a traversal. Other data structures are left as they are.
+     */
+    void freeze() {
+        if constexpr (std::is_same_v<Data, Btree<Arity>>) {
+            data.freeze();
         }
     }
 
@@ -273,7 +613,13 @@ public:
         if (cmp(low, high) > 0) {
             return {data.end(), data.end()};
         }
-        return {data.lower_bound(low), data.upper_bound(high)};
+        if constexpr (isTrie) {
+            Hints hints;
+            return getPrefixRange(
+                    data, low, getPrefixLength(low, high), hints, std::make_index_sequence<Arity + 1>());
+        } else {
+            return {data.lower_bound(low), data.upper_bound(high)};
+        }
     }
 
     /**
@@ -309,6 +655,19 @@ public:
      */
     void clear() {
         data.clear();
+        ++generation;
+    }
+
+    /**
+     * Clears the content of this index, retaining the memory of b-tree nodes for subsequent insertions.
+     */
+    void recycle() {
+        if constexpr (std::is_same_v<Data, Btree<Arity>>) {
+            data.recycle();
+        } else {
+            data.clear();
+        }
+        ++generation;
     }
 };
 
@@ -371,6 +730,10 @@ public:
     public:
         View(const std::atomic<bool>& data) : data(data) {}
 
+        bool reuse(const Index& index) const {
+            return &index.data == &data;
+        }
+
         bool contains(const Tuple& /* t */) const {
             return data;
         }
@@ -382,6 +745,10 @@ public:
         souffle::range<iterator> range(const Tuple& /* l */, const Tuple& /* h */) const {
             return {iterator(data), iterator()};
         }
+
+        std::size_t count(const Tuple& /* l */, const Tuple& /* h */) const {
+            return data ? 1 : 0;
+        }
     };
 
 public:
@@ -406,7 +773,39 @@ public:
     }
 
     void insert(const Index& src) {
-        data = src.data;
+        if (src.data) {
+            data = true;
+        }
+    }
+
+    void insertAll(const std::vector<Tuple>& tuples) {
+        load(tuples);
+    }
+
+    void load(const std::vector<Tuple>& tuples) {
+        if (!tuples.empty()) {
+            data = true;
+        }
+    }
+
+    void load(const Index& src) {
+        insert(src);
+    }
+
+    void compact() {}
+
+    void freeze() {}
+
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this);
+    }
+
+    std::size_t getNumNodes() const {
+        return 0;
+    }
+
+    double getFillFactor() const {
+        return 0.0;
     }
 
     bool contains(const Tuple& /* t */) const {
@@ -439,6 +838,316 @@ public:
     void clear() {
         data = false;
     }
+
+    void recycle() {
+        data = false;
+    }
+};
+
+/**
+ * The rows of an index of a dynamic arity.
+ *
+ * Rows are appended to segments of doubling sizes, such that a row never moves once it is written, and
+ * concurrent insertions only synchronise on the allocation of a segment.
+ */
+class RowStore {
+    // the number of rows of the first segment; each further segment holds as many rows as all before it
+    static constexpr std::size_t FIRST_ROWS = 256;
+    static constexpr std::size_t MAX_SEGMENTS = 48;
+
+public:
+    explicit RowStore(std::size_t arity) : stride(std::max<std::size_t>(arity, 1)) {}
+    RowStore(const RowStore&) = delete;
+    RowStore& operator=(const RowStore&) = delete;
+
+    ~RowStore() {
+        clear();
+    }
+
+    /** Store a copy of the given values, returning the row holding them */
+    const RamDomain* append(const RamDomain* values) {
+        const std::size_t pos = count.fetch_add(1, std::memory_order_relaxed);
+        const std::size_t bucket = pos / FIRST_ROWS + 1;
+        const std::size_t segment = sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(bucket);
+        assert(segment < MAX_SEGMENTS && "too many rows");
+        RamDomain* rows = segments[segment].load(std::memory_order_acquire);
+        if (rows == nullptr) {
+            std::lock_guard<std::mutex> guard(lock);
+            rows = segments[segment].load(std::memory_order_relaxed);
+            if (rows == nullptr) {
+                rows = new RamDomain[(FIRST_ROWS << segment) * stride];
+                segments[segment].store(rows, std::memory_order_release);
+            }
+        }
+        RamDomain* row = rows + (pos - FIRST_ROWS * ((std::size_t(1) << segment) - 1)) * stride;
+        std::copy_n(values, stride, row);
+        return row;
+    }
+
+    /** Release all rows */
+    void clear() {
+        for (auto& segment : segments) {
+            delete[] segment.exchange(nullptr);
+        }
+        count = 0;
+    }
+
+    /** Discard all rows, retaining the segments for subsequent rows */
+    void recycle() {
+        count = 0;
+    }
+
+    /** Obtains the number of bytes of the allocated segments */
+    std::size_t getMemoryUsage() const {
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < MAX_SEGMENTS; ++i) {
+            if (segments[i].load(std::memory_order_relaxed) != nullptr) {
+                bytes += (FIRST_ROWS << i) * stride * sizeof(RamDomain);
+            }
+        }
+        return bytes;
+    }
+
+private:
+    // the number of values of a row
+    const std::size_t stride;
+
+    // the number of rows handed out
+    std::atomic<std::size_t> count{0};
+
+    std::array<std::atomic<RamDomain*>, MAX_SEGMENTS> segments{};
+
+    // serialises the allocation of segments
+    std::mutex lock;
+};
+
+/**
+ * A partial specialize template for indexes of a dynamic arity.
+ *
+ * The tuples are stored as rows in the order of the index, and are ordered by a b-tree of references to
+ * the rows. All operations on them are instantiated once for all arities, rather than for each one.
+ */
+template <template <std::size_t> typename Structure>
+class Index<Dynamic, Structure> {
+public:
+    static constexpr std::size_t Arity = Dynamic;
+    using Data = DynamicBtree;
+    using Tuple = std::vector<RamDomain>;
+    using iterator = typename Data::iterator;
+    using Hints = typename Data::operation_hints;
+
+    Index(Order order) : order(std::move(order)), cmp{this->order.size()}, rows(cmp.arity), data(cmp, cmp) {}
+
+protected:
+    Order order;
+    DynamicComparator cmp;
+    RowStore rows;
+    Data data;
+
+    // incremented whenever nodes of the data structure may be released, invalidating the hints of views
+    std::atomic<std::size_t> generation{0};
+
+    /** Inserts the given values, encoded in the order of this index */
+    bool insertRow(const RamDomain* values, Hints& hints) {
+        if (data.contains(DynamicRow{values}, hints)) {
+            return false;
+        }
+        // if threads insert the same tuple at once, the rows of all but one of them are left unused
+        return data.insert(DynamicRow{rows.append(values)}, hints);
+    }
+
+public:
+    /**
+     * A view on a relation caching local access patterns (not thread safe!).
+     */
+    class View : public ViewWrapper {
+        mutable Hints hints;
+        const Data& data;
+        DynamicComparator cmp;
+        std::size_t generation;
+
+    public:
+        View(const Data& data, DynamicComparator cmp, std::size_t generation)
+                : data(data), cmp(cmp), generation(generation) {}
+
+        bool reuse(const Index& index) {
+            if (&index.data != &data) {
+                return false;
+            }
+            const std::size_t current = index.generation.load(std::memory_order_relaxed);
+            if (generation != current) {
+                hints = Hints();
+                generation = current;
+            }
+            return true;
+        }
+
+        bool contains(const Tuple& entry) {
+            return data.contains(DynamicRow{entry.data()}, hints);
+        }
+
+        bool contains(const Tuple& low, const Tuple& high) {
+            return !range(low, high).empty();
+        }
+
+        souffle::range<iterator> range(const Tuple& low, const Tuple& high) {
+            if (cmp(DynamicRow{low.data()}, DynamicRow{high.data()}) > 0) {
+                return {data.end(), data.end()};
+            }
+            return {data.lower_bound(DynamicRow{low.data()}, hints),
+                    data.upper_bound(DynamicRow{high.data()}, hints)};
+        }
+
+        std::size_t count(const Tuple& low, const Tuple& high) {
+            if (cmp(DynamicRow{low.data()}, DynamicRow{high.data()}) > 0) {
+                return 0;
+            }
+            return data.countRange(DynamicRow{low.data()}, DynamicRow{high.data()});
+        }
+    };
+
+    View createView() {
+        return View(data, cmp, generation.load(std::memory_order_relaxed));
+    }
+
+    iterator begin() const {
+        return data.begin();
+    }
+
+    iterator end() const {
+        return data.end();
+    }
+
+    Order getOrder() const {
+        return order;
+    }
+
+    bool empty() const {
+        return data.empty();
+    }
+
+    std::size_t size() const {
+        return data.size();
+    }
+
+    bool insert(const Tuple& tuple) {
+        Hints hints;
+        return insertRow(order.encode(tuple).data(), hints);
+    }
+
+    /**
+     * Inserts all elements of the given index; the rows of an index of the same order are copied as they
+     * are.
+     */
+    void insert(const Index& src) {
+        const bool reorder = order != src.order;
+        auto insertAll = [&](const auto& rows, Hints& hints) {
+            for (const auto& row : rows) {
+                if (reorder) {
+                    insertRow(order.encode(src.order.decode(row)).data(), hints);
+                } else {
+                    insertRow(row.data(), hints);
+                }
+            }
+        };
+        // the partitions of a large source are inserted by concurrent threads
+        if (src.size() >= PARALLEL_INSERT_SIZE) {
+            auto chunks = src.data.partition(INSERT_PARTITIONS);
+            PARALLEL_START
+                Hints hints;
+                pfor(std::size_t i = 0; i < chunks.size(); ++i) {
+                    insertAll(chunks[i], hints);
+                }
+            PARALLEL_END
+            return;
+        }
+        Hints hints;
+        insertAll(src, hints);
+    }
+
+    void insertAll(const std::vector<Tuple>& tuples) {
+        load(tuples);
+    }
+
+    void load(const std::vector<Tuple>& tuples) {
+        Hints hints;
+        for (const auto& tuple : tuples) {
+            insertRow(order.encode(tuple).data(), hints);
+        }
+    }
+
+    void load(const Index& src) {
+        insert(src);
+    }
+
+    std::size_t getMemoryUsage() const {
+        return sizeof(*this) - sizeof(Data) + data.getMemoryUsage() + rows.getMemoryUsage();
+    }
+
+    std::size_t getNumNodes() const {
+        return data.getNumNodes();
+    }
+
+    double getFillFactor() const {
+        return data.getFillFactor();
+    }
+
+    void compact() {
+        data.compact();
+        ++generation;
+    }
+
+    void freeze() {
+        data.freeze();
+    }
+
+    bool contains(const Tuple& tuple) const {
+        return data.contains(DynamicRow{tuple.data()});
+    }
+
+    bool contains(const Tuple& low, const Tuple& high) const {
+        return !range(low, high).empty();
+    }
+
+    souffle::range<iterator> scan() const {
+        return {data.begin(), data.end()};
+    }
+
+    souffle::range<iterator> range(const Tuple& low, const Tuple& high) const {
+        if (cmp(DynamicRow{low.data()}, DynamicRow{high.data()}) > 0) {
+            return {data.end(), data.end()};
+        }
+        return {data.lower_bound(DynamicRow{low.data()}), data.upper_bound(DynamicRow{high.data()})};
+    }
+
+    std::vector<souffle::range<iterator>> partitionScan(int partitionCount) const {
+        std::vector<souffle::range<iterator>> res;
+        for (const auto& cur : data.partition(partitionCount)) {
+            res.push_back({cur.begin(), cur.end()});
+        }
+        return res;
+    }
+
+    std::vector<souffle::range<iterator>> partitionRange(
+            const Tuple& low, const Tuple& high, int partitionCount) const {
+        std::vector<souffle::range<iterator>> res;
+        for (const auto& cur : this->range(low, high).partition(partitionCount)) {
+            res.push_back({cur.begin(), cur.end()});
+        }
+        return res;
+    }
+
+    void clear() {
+        data.clear();
+        rows.clear();
+        ++generation;
+    }
+
+    void recycle() {
+        data.recycle();
+        rows.recycle();
+        ++generation;
+    }
 };
 
 /**
@@ -461,6 +1170,8 @@ public:
      */
     void extendAndInsert(EqrelIndex* otherIndex) {
         this->data.extendAndInsert(otherIndex->data);
+        ++this->generation;
+        ++otherIndex->generation;
     }
 };
 
@@ -473,14 +1184,36 @@ public:
     using Index<_Arity, BtreeDelete>::Index;
     using Index<_Arity, BtreeDelete>::data;
     using Index<_Arity, BtreeDelete>::order;
+    using Index<_Arity, BtreeDelete>::generation;
+    using Index<_Arity, BtreeDelete>::cmp;
     using Tuple = typename souffle::Tuple<RamDomain, _Arity>;
 
     /**
      * Erase a tuple from this index.
      */
     bool erase(const Tuple& tuple) {
+        // the erasure may merge and release nodes
+        ++generation;
         return data.erase(order.encode(tuple)) > 0;
     }
+
+    /**
+     * Erase the given tuples from this index.
+     *
+     * The tuples are sorted into the order of this index, such that the tree erases them in a
+     * single batch and rebuilds itself from the remaining tuples if the batch is large.
+     */
+    std::size_t eraseAll(const std::vector<Tuple>& tuples) {
+        std::vector<Tuple> sorted(tuples.size());
+        for (std::size_t i = 0; i < tuples.size(); ++i) {
+            sorted[i] = order.encode(tuples[i]);
+        }
+        parallelSort(sorted.begin(), sorted.end(),
+                [&](const Tuple& a, const Tuple& b) { return cmp.less(a, b); });
+        // the erasure may merge, rebuild and release nodes
+        ++generation;
+        return data.eraseAll(sorted.begin(), sorted.end());
+    }
 };
 
 }  // namespace souffle::interpreter
@@ -0,0 +1,465 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file JoinPlanner.cpp
+ *
+ * Define the JoinPlanner class.
+ ***********************************************************************/
+
+#include "interpreter/JoinPlanner.h"
+#include "interpreter/Engine.h"
+#include "ram/Constraint.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Negation.h"
+#include "ram/analysis/Complexity.h"
+#include "ram/analysis/Index.h"
+#include "ram/analysis/Relation.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/StringUtil.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace souffle::interpreter {
+
+namespace {
+
+/** Number of tuples sampled to estimate the distinct values of the attributes of a relation */
+constexpr std::size_t SAMPLE_SIZE = 1024;
+
+/** Largest number of atoms whose orders are all enumerated; larger nests are ordered greedily */
+constexpr std::size_t MAX_ENUMERATED_ATOMS = 7;
+
+/** Factor by which a new order has to be cheaper than the current one to be adopted */
+constexpr double IMPROVEMENT = 0.8;
+
+/** Lower bound of estimated selectivities, keeping the estimates of subsequent atoms meaningful */
+constexpr double MIN_SELECTIVITY = 0.01;
+
+/** Return the number of bits of the binary representation of a size */
+std::size_t getSizeClass(std::size_t size) {
+    std::size_t res = 0;
+    for (; size > 0; size >>= 1) {
+        ++res;
+    }
+    return res;
+}
+
+/** Position of an atom in the clause it stems from, as described by the profile text of its scan */
+struct PlanAtom {
+    std::size_t version;
+    /** Number of the atom in the body of the clause, starting at one */
+    std::size_t literal;
+    std::size_t numAtoms;
+    std::string clause;
+    /** Execution plan of the clause */
+    std::string plan;
+};
+
+/** Split a profile text into its fields, removing their escapes */
+std::vector<std::string> splitFields(const std::string& text) {
+    std::vector<std::string> res(1);
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            const char escaped = text[++i];
+            res.back() += (escaped == 'n') ? '\n' : (escaped == 't') ? '\t' : escaped;
+        } else if (text[i] == ';') {
+            res.emplace_back();
+        } else {
+            res.back() += text[i];
+        }
+    }
+    return res;
+}
+
+std::optional<PlanAtom> getPlanAtom(const std::string& profileText) {
+    const auto pos = profileText.find("@plan-atom;");
+    if (pos == std::string::npos) {
+        return std::nullopt;
+    }
+    const auto fields = splitFields(profileText.substr(pos));
+    if (fields.size() < 6) {
+        return std::nullopt;
+    }
+    return PlanAtom{
+            std::stoul(fields[1]), std::stoul(fields[2]), std::stoul(fields[3]), fields[4], fields[5]};
+}
+
+/** Parse the orders of each version of an execution plan, e.g., ` .plan 0:(1,2), 1:(2,1)` */
+std::map<std::size_t, std::vector<std::size_t>> parsePlan(const std::string& text) {
+    std::map<std::size_t, std::vector<std::size_t>> res;
+    std::vector<std::size_t>* order = nullptr;
+    std::size_t version = 0;
+    std::size_t number = 0;
+    bool digits = false;
+    for (char c : text) {
+        if (std::isdigit(static_cast<unsigned char>(c)) != 0) {
+            number = number * 10 + (c - '0');
+            digits = true;
+            continue;
+        }
+        if (digits && c == ':') {
+            version = number;
+        } else if (c == '(') {
+            order = &res[version];
+        } else if (digits && order != nullptr && (c == ',' || c == ')')) {
+            order->push_back(number);
+        }
+        if (c == ')') {
+            order = nullptr;
+        }
+        number = 0;
+        digits = false;
+    }
+    return res;
+}
+
+}  // namespace
+
+std::size_t JoinPlanner::getSize(const std::string& relation) {
+    auto pos = sizes.find(relation);
+    if (pos == sizes.end()) {
+        const RelationWrapper& rel = *engine.getRelationHandle(engine.generator->encodeRelation(relation));
+        pos = sizes.emplace(relation, rel.size()).first;
+    }
+    return pos->second;
+}
+
+void JoinPlanner::refreshStatistics(const std::string& relation) {
+    const std::size_t size = getSize(relation);
+    auto pos = statistics.find(relation);
+    if (pos != statistics.end() && pos->second.sizeClass == getSizeClass(size)) {
+        return;
+    }
+
+    const RelationWrapper& rel = *engine.getRelationHandle(engine.generator->encodeRelation(relation));
+    Statistics& stats = statistics[relation];
+    stats.sizeClass = getSizeClass(size);
+    stats.size = size;
+    stats.distinct.assign(rel.getArity(), 1.0);
+
+    // count the occurrences of the values of each attribute in the sample
+    std::vector<std::unordered_map<RamDomain, std::size_t>> occurrences(rel.getArity());
+    std::size_t sampled = 0;
+    rel.sample(SAMPLE_SIZE, [&](const RamDomain* tuple) {
+        for (std::size_t i = 0; i < occurrences.size(); ++i) {
+            occurrences[i][tuple[i]]++;
+        }
+        ++sampled;
+    });
+    if (sampled == 0) {
+        return;
+    }
+
+    // values seen once in the sample account for the unseen ones (guaranteed-error estimator)
+    const double scale = std::sqrt(static_cast<double>(size) / sampled);
+    for (std::size_t i = 0; i < occurrences.size(); ++i) {
+        std::size_t singletons = 0;
+        for (const auto& entry : occurrences[i]) {
+            singletons += (entry.second == 1) ? 1 : 0;
+        }
+        const double seen = static_cast<double>(occurrences[i].size());
+        const double estimate = (sampled == size) ? seen : scale * singletons + (seen - singletons);
+        stats.distinct[i] = std::clamp(estimate, std::max(seen, 1.0), static_cast<double>(size));
+    }
+}
+
+double JoinPlanner::getSelectivity(const ram::Condition& condition) {
+    double res = 0.5;
+    if (const auto* exists = as<ram::ExistenceCheck>(condition)) {
+        const Statistics& stats = statistics.at(exists->getRelation());
+        double expected = static_cast<double>(stats.size);
+        const auto values = exists->getValues();
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (!ram::isUndefValue(values[i])) {
+                expected /= stats.distinct[i];
+            }
+        }
+        res = expected;
+    } else if (const auto* negation = as<ram::Negation>(condition)) {
+        res = 1.0 - getSelectivity(negation->getOperand());
+    } else if (isA<ram::EmptinessCheck>(condition)) {
+        res = 1.0;
+    } else if (const auto* constraint = as<ram::Constraint>(condition)) {
+        const BinaryConstraintOp op = constraint->getOperator();
+        if (op == BinaryConstraintOp::EQ || op == BinaryConstraintOp::FEQ) {
+            res = 0.1;
+        } else if (op == BinaryConstraintOp::NE || op == BinaryConstraintOp::FNE) {
+            res = 0.9;
+        } else {
+            res = 1.0 / 3;
+        }
+    }
+    return std::clamp(res, MIN_SELECTIVITY, 1.0);
+}
+
+std::vector<std::size_t> JoinPlanner::selectIndex(
+        const std::string& relation, const std::vector<std::size_t>& bound) {
+    // only the searches of the program are mapped to indexes
+    return engine.isa.getIndexSelection(relation).getLargestEqualitySearch(bound);
+}
+
+double JoinPlanner::getCost(const ram::LoopNest& nest, const std::vector<std::size_t>& order) {
+    const auto& complexity = engine.tUnit.getAnalysis<ram::analysis::ComplexityAnalysis>();
+    std::vector<bool> outer(nest.size(), false);
+    double rows = 1.0;
+    double cost = 0.0;
+    for (std::size_t atom : order) {
+        const Statistics& stats = statistics.at(nest.getRelation(atom));
+        const auto bound = nest.getBoundElements(atom, outer);
+        const auto indexed = bound.empty() ? bound : selectIndex(nest.getRelation(atom), bound);
+
+        // the tuples enumerated by the search, and the ones matching all bound attributes
+        double scanned = static_cast<double>(stats.size);
+        double matched = scanned;
+        for (std::size_t i : bound) {
+            matched /= stats.distinct[i];
+            if (contains(indexed, i)) {
+                scanned /= stats.distinct[i];
+            }
+        }
+        double filterCost = static_cast<double>(bound.size() - indexed.size());
+        for (const auto* cond : nest.getConditions(atom, outer)) {
+            filterCost += 1.0 + complexity.getComplexity(cond);
+            matched *= getSelectivity(*cond);
+        }
+
+        const double probe = indexed.empty() ? 1.0 : std::log2(stats.size + 2.0);
+        cost += rows * (probe + scanned * (1.0 + filterCost));
+        rows *= matched;
+        outer[atom] = true;
+    }
+    return cost;
+}
+
+std::vector<std::size_t> JoinPlanner::findOrder(const ram::LoopNest& nest) {
+    std::vector<std::size_t> order(nest.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if (nest.size() <= MAX_ENUMERATED_ATOMS) {
+        std::vector<std::size_t> best = order;
+        double bestCost = getCost(nest, order);
+        while (std::next_permutation(order.begin(), order.end())) {
+            const double cost = getCost(nest, order);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = order;
+            }
+        }
+        return best;
+    }
+
+    // extend the order by the atom leading to the cheapest prefix
+    std::vector<std::size_t> prefix;
+    std::vector<std::size_t> remaining = order;
+    while (!remaining.empty()) {
+        auto best = remaining.begin();
+        double bestCost = 0.0;
+        for (auto cur = remaining.begin(); cur != remaining.end(); ++cur) {
+            prefix.push_back(*cur);
+            const double cost = getCost(nest, prefix);
+            prefix.pop_back();
+            if (cur == remaining.begin() || cost < bestCost) {
+                bestCost = cost;
+                best = cur;
+            }
+        }
+        prefix.push_back(*best);
+        remaining.erase(best);
+    }
+    return prefix;
+}
+
+const Node* JoinPlanner::getPlan(const Node& query) {
+    std::lock_guard<std::mutex> guard(planLock);
+    const auto& ramQuery = static_cast<const ram::Query&>(*query.getShadow());
+
+    auto pos = plans.find(&ramQuery);
+    if (pos == plans.end()) {
+        Plan& plan = plans[&ramQuery];
+        plan.nest = ram::LoopNest::flatten(
+                ramQuery, engine.tUnit.getAnalysis<ram::analysis::RelationAnalysis>());
+        if (plan.nest != nullptr) {
+            for (std::size_t i = 0; i < plan.nest->size(); ++i) {
+                plan.sizeClasses[plan.nest->getRelation(i)] = 0;
+            }
+            visit(ramQuery, [&](const ram::ExistenceCheck& exists) {
+                plan.sizeClasses[exists.getRelation()] = 0;
+            });
+        }
+        pos = plans.find(&ramQuery);
+    }
+
+    Plan& plan = pos->second;
+    if (plan.nest == nullptr) {
+        return nullptr;
+    }
+
+    // revisit the order only once the size of a relation changed substantially
+    bool changed = false;
+    for (auto& [relation, sizeClass] : plan.sizeClasses) {
+        const std::size_t current = getSizeClass(getSize(relation));
+        changed = changed || current != sizeClass;
+        sizeClass = current;
+    }
+    if (!changed) {
+        return plan.node.get();
+    }
+    for (const auto& cur : plan.sizeClasses) {
+        refreshStatistics(cur.first);
+    }
+
+    // queries over empty relations are hardly evaluated, so their runtime is not attributed to an order
+    std::vector<std::size_t> original(plan.nest->size());
+    std::iota(original.begin(), original.end(), 0);
+    bool empty = false;
+    for (std::size_t i = 0; i < plan.nest->size(); ++i) {
+        empty = empty || getSize(plan.nest->getRelation(i)) == 0;
+    }
+    plan.referenceCost = empty ? 0.0 : getCost(*plan.nest, original);
+
+    const std::vector<std::size_t> current = plan.order.empty() ? original : plan.order;
+    std::vector<std::size_t> best = findOrder(*plan.nest);
+    if (best == current || getCost(*plan.nest, best) >= IMPROVEMENT * getCost(*plan.nest, current)) {
+        return plan.node.get();
+    }
+
+    // re-planned queries have no plan of their own and are evaluated as they are
+    if (plan.query != nullptr) {
+        plans.erase(plan.query.get());
+    }
+    if (std::is_sorted(best.begin(), best.end())) {
+        plan.order.clear();
+        plan.node = nullptr;
+        plan.query = nullptr;
+        return nullptr;
+    }
+    plan.order = best;
+    plan.query = plan.nest->reorder(best, [&](std::size_t atom, const std::vector<std::size_t>& bound) {
+        return selectIndex(plan.nest->getRelation(atom), bound);
+    });
+    plans[plan.query.get()].source = &ramQuery;
+    plan.node = engine.generator->generateTree(*plan.query);
+    return plan.node.get();
+}
+
+void JoinPlanner::addRuntime(const Node& query, long time) {
+    std::lock_guard<std::mutex> guard(planLock);
+    auto pos = plans.find(query.getShadow());
+    if (pos != plans.end() && pos->second.source != nullptr) {
+        pos = plans.find(pos->second.source);
+    }
+    if (pos == plans.end() || pos->second.nest == nullptr || pos->second.referenceCost <= 0.0) {
+        return;
+    }
+
+    Plan& plan = pos->second;
+    std::vector<std::size_t> order = plan.order;
+    if (order.empty()) {
+        order.resize(plan.nest->size());
+        std::iota(order.begin(), order.end(), 0);
+    }
+    Runtime& runtime = plan.runtimes[order];
+    runtime.time += time;
+    runtime.work += plan.referenceCost;
+}
+
+void JoinPlanner::emitPlans(std::ostream& os) const {
+    /** Orders of the versions of a clause */
+    struct ClausePlan {
+        std::map<std::size_t, std::vector<std::size_t>> given;
+        /** Fastest order measured for each version, and its time per estimated work */
+        std::map<std::size_t, std::pair<double, std::vector<std::size_t>>> measured;
+    };
+    std::map<std::string, ClausePlan> clauses;
+
+    for (const auto& [query, plan] : plans) {
+        if (plan.nest == nullptr) {
+            continue;
+        }
+
+        // the order spending the least time on the estimated work of the query
+        const std::vector<std::size_t>* best = nullptr;
+        double bestScore = 0.0;
+        for (const auto& [order, runtime] : plan.runtimes) {
+            const double score = runtime.time / runtime.work;
+            if (best == nullptr || score < bestScore) {
+                best = &order;
+                bestScore = score;
+            }
+        }
+        if (best == nullptr) {
+            continue;
+        }
+
+        // map the atoms to the literals of their clause
+        std::vector<PlanAtom> atoms;
+        for (std::size_t i = 0; i < plan.nest->size(); ++i) {
+            auto atom = getPlanAtom(plan.nest->getProfileText(i));
+            if (!atom.has_value() || (!atoms.empty() && (atom->clause != atoms[0].clause ||
+                                                               atom->version != atoms[0].version))) {
+                break;
+            }
+            atoms.push_back(std::move(*atom));
+        }
+        if (atoms.size() != plan.nest->size()) {
+            continue;
+        }
+        std::vector<std::size_t> literals;
+        for (std::size_t atom : *best) {
+            literals.push_back(atoms[atom].literal);
+        }
+        // atoms not scanned by the query are checked where their values are bound
+        for (std::size_t i = 1; i <= atoms[0].numAtoms; ++i) {
+            if (!contains(literals, i)) {
+                literals.push_back(i);
+            }
+        }
+
+        ClausePlan& clausePlan = clauses[atoms[0].clause];
+        clausePlan.given = parsePlan(atoms[0].plan);
+        auto pos = clausePlan.measured.find(atoms[0].version);
+        if (pos == clausePlan.measured.end() || bestScore < pos->second.first) {
+            clausePlan.measured[atoms[0].version] = std::make_pair(bestScore, std::move(literals));
+        }
+    }
+
+    bool first = true;
+    for (const auto& [clause, clausePlan] : clauses) {
+        auto orders = clausePlan.given;
+        for (const auto& [version, measured] : clausePlan.measured) {
+            const auto& literals = measured.second;
+            if (contains(orders, version) || !std::is_sorted(literals.begin(), literals.end())) {
+                orders[version] = literals;
+            }
+        }
+        if (orders == clausePlan.given) {
+            continue;
+        }
+        if (first) {
+            os << "// execution plans of the fastest join orders measured\n\n";
+            first = false;
+        }
+        os << clause << " .plan ";
+        os << join(orders, ", ", [](std::ostream& out, const auto& cur) {
+            out << cur.first << ":(" << join(cur.second, ",") << ")";
+        });
+        os << "\n\n";
+    }
+}
+
+}  // namespace souffle::interpreter
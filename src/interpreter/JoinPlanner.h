@@ -0,0 +1,160 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file JoinPlanner.h
+ *
+ * Declares the JoinPlanner class, choosing the join order of queries
+ * from statistics of the relations collected during the evaluation.
+ ***********************************************************************/
+
+#pragma once
+
+#include "interpreter/Node.h"
+#include "ram/Condition.h"
+#include "ram/Query.h"
+#include "ram/utility/LoopNest.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace souffle::interpreter {
+
+class Engine;
+
+/**
+ * @class JoinPlanner
+ * @brief Re-plans the join order of queries whenever the cardinalities of
+ * their relations changed substantially
+ *
+ * The order chosen by the static SIPS heuristics may be arbitrarily bad for
+ * the data at hand. The planner flattens the loop nest of each query and
+ * estimates the costs of its orders from the sizes of the relations and the
+ * distinct values of their attributes, which are estimated from a sample of
+ * the tuples. The costs of the filters are weighted by their complexity.
+ *
+ * A query is re-planned before its evaluation if the size of one of its
+ * relations changed by at least a factor of two since it was planned last.
+ * The sizes are re-read before evaluating a stratum or an iteration of a
+ * fixpoint loop, since counting the tuples of a relation is not free. The
+ * cheapest order is only adopted if it is clearly cheaper than the current
+ * one, so as not to regenerate the query for marginal gains.
+ *
+ * The planner may also measure the time spent on the orders of each query,
+ * relative to the estimated cost of its original order, and emit the orders
+ * measured fastest as execution plans of the clauses they stem from.
+ */
+class JoinPlanner {
+public:
+    JoinPlanner(Engine& engine) : engine(engine) {}
+
+    /** Measures the evaluation of a query in its current order until it goes out of scope */
+    class Measurement {
+    public:
+        Measurement(JoinPlanner* planner, const Node& query)
+                : planner(planner), query(query), start(planner != nullptr ? now() : time_point()) {}
+
+        ~Measurement() {
+            if (planner != nullptr) {
+                planner->addRuntime(query, duration_in_us(start, now()));
+            }
+        }
+
+    private:
+        JoinPlanner* planner;
+        const Node& query;
+        time_point start;
+    };
+
+    /**
+     * @brief Return the node evaluating the given query in its currently best join order
+     * @result nullptr if the query is evaluated in its original order
+     */
+    const Node* getPlan(const Node& query);
+
+    /** @brief Record the time spent on evaluating a query in its current order */
+    void addRuntime(const Node& query, long time);
+
+    /** @brief Write the fastest orders measured as execution plans of their clauses */
+    void emitPlans(std::ostream& os) const;
+
+    /** @brief Forget the sizes of the relations, which are re-read when a query is planned next */
+    void invalidateSizes() {
+        std::lock_guard<std::mutex> guard(planLock);
+        sizes.clear();
+    }
+
+private:
+    /** Statistics of a relation */
+    struct Statistics {
+        /** Size class of the relation when the statistics were collected */
+        std::size_t sizeClass = 0;
+        std::size_t size = 0;
+        /** Estimated number of distinct values of each attribute */
+        std::vector<double> distinct;
+    };
+
+    /** Time spent on an order of a query */
+    struct Runtime {
+        /** Accumulated evaluation time in microseconds */
+        long time = 0;
+        /** Accumulated estimated cost of the original order of the evaluated query */
+        double work = 0.0;
+    };
+
+    /** The evaluation plan of a query */
+    struct Plan {
+        Own<ram::LoopNest> nest;
+        /** Relations of the query and their size classes when it was planned last */
+        std::map<std::string, std::size_t> sizeClasses;
+        /** The order of the atoms; empty for the original order */
+        std::vector<std::size_t> order;
+        Own<ram::Query> query;
+        Own<Node> node;
+        /** The original query of a re-planned query */
+        const ram::Query* source = nullptr;
+        /** Estimated cost of the original order when the plan was revisited last */
+        double referenceCost = 0.0;
+        /** Time spent on each order, identified by its atoms */
+        std::map<std::vector<std::size_t>, Runtime> runtimes;
+    };
+
+    /** @brief Return the size of a relation since the sizes were invalidated last */
+    std::size_t getSize(const std::string& relation);
+
+    /** @brief Refresh the statistics of a relation if its size class changed */
+    void refreshStatistics(const std::string& relation);
+
+    /** @brief Estimate the fraction of tuples satisfying a condition */
+    double getSelectivity(const ram::Condition& condition);
+
+    /** @brief Return the largest set of bound attributes of a relation searched on one of its indexes */
+    std::vector<std::size_t> selectIndex(const std::string& relation, const std::vector<std::size_t>& bound);
+
+    /** @brief Estimate the cost of evaluating a loop nest in the given order */
+    double getCost(const ram::LoopNest& nest, const std::vector<std::size_t>& order);
+
+    /** @brief Return the order of the loop nest with the lowest estimated cost */
+    std::vector<std::size_t> findOrder(const ram::LoopNest& nest);
+
+    Engine& engine;
+    /** Serialises the planning of queries evaluated in parallel */
+    std::mutex planLock;
+    /** Plans of the queries, identified by their original RAM node */
+    std::map<const ram::Node*, Plan> plans;
+    std::map<std::string, Statistics> statistics;
+    std::map<std::string, std::size_t> sizes;
+};
+
+}  // namespace souffle::interpreter
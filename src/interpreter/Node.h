@@ -25,17 +25,23 @@
 
 #include "interpreter/Util.h"
 #include "ram/Relation.h"
+#include "souffle/FunctorCache.h"
+#include "souffle/FunctorContexts.h"
 #include "souffle/RamTypes.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/RegexUtil.h"
 #include <array>
 #include <cassert>
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include <ffi.h>
 
 namespace souffle {
 namespace ram {
@@ -60,6 +66,7 @@ struct RelationWrapper;
     Forward(IntrinsicOperator)\
     Forward(UserDefinedOperator)\
     Forward(NestedIntrinsicOperator)\
+    Forward(ParallelNestedIntrinsicOperator)\
     Forward(PackRecord)\
     Forward(SubroutineArgument)\
     Forward(True)\
@@ -72,10 +79,13 @@ struct RelationWrapper;
     FOR_EACH_PROVENANCE(Expand, ProvenanceExistenceCheck)\
     Forward(Constraint)\
     Forward(TupleOperation)\
+    Forward(ProfiledOperation)\
     FOR_EACH(Expand, Scan)\
     FOR_EACH(Expand, ParallelScan)\
     FOR_EACH(Expand, IndexScan)\
     FOR_EACH(Expand, ParallelIndexScan)\
+    FOR_EACH_BTREE(Expand, IndexIntersect)\
+    FOR_EACH_BTREE_DYNAMIC(Expand, IndexIntersect)\
     FOR_EACH(Expand, IfExists)\
     FOR_EACH(Expand, ParallelIfExists)\
     FOR_EACH(Expand, IndexIfExists)\
@@ -88,12 +98,15 @@ struct RelationWrapper;
     Forward(Break)\
     Forward(Filter)\
     FOR_EACH(Expand, GuardedInsert)\
+    FOR_EACH(Expand, NoveltyInsert)\
     FOR_EACH(Expand, Insert)\
     FOR_EACH_BTREE_DELETE(Expand, Erase)\
     Forward(SubroutineReturn)\
+    Forward(Branches)\
     Forward(Sequence)\
     Forward(Parallel)\
     Forward(Loop)\
+    Forward(Worklist)\
     Forward(Exit)\
     Forward(LogRelationTimer)\
     Forward(LogTimer)\
@@ -104,7 +117,13 @@ struct RelationWrapper;
     Forward(Query)\
     Forward(MergeExtend)\
     Forward(Swap)\
-    Forward(Call)
+    FOR_EACH(Expand, BulkInsert)\
+    FOR_EACH_BTREE_DELETE(Expand, BulkErase)\
+    Forward(Call)\
+    Forward(CompactTables)\
+    Forward(Checkpoint)\
+    Forward(StratumCache)\
+    Forward(Guard)
 
 #define SINGLE_TOKEN(tok) I_##tok,
 
@@ -147,6 +166,10 @@ inline NodeType constructNodeType(std::string tokBase, const ram::Relation& rel)
         return map.at("I_" + tokBase + "_BtreeDelete_" + arity);
     } else if (isProvenance) {
         return map.at("I_" + tokBase + "_Provenance_" + arity);
+    } else if (rel.getArity() > MAX_FIXED_ARITY) {
+        return map.at("I_" + tokBase + "_Btree_Dynamic");
+    } else if (rel.getRepresentation() == RelationRepresentation::BRIE) {
+        return map.at("I_" + tokBase + "_Brie_" + arity);
     } else  {
         return map.at("I_" + tokBase + "_Btree_" + arity);
     }
@@ -208,6 +231,11 @@ public:
         return children;
     }
 
+    /** @brief take ownership of all children */
+    NodePtrVec releaseChildren() {
+        return std::move(children);
+    }
+
 protected:
     NodePtrVec children;
 };
@@ -300,6 +328,8 @@ protected:
     const SuperInstruction superInst;
 };
 
+class Insert;
+
 /**
  * @class AbstractParallel
  * @brief  node that utilizes parallel execution should inherit from this class.
@@ -317,8 +347,39 @@ public:
         viewContext = v;
     }
 
+    /** @brief get the nested insertions whose tuples the threads may collect and insert at the end */
+    inline const std::vector<const Insert*>& getDeferrableInserts() const {
+        return deferrableInserts;
+    }
+
+    /** @brief add a nested insertion whose tuples the threads may collect and insert at the end */
+    inline void addDeferrableInsert(const Insert* insert) {
+        deferrableInserts.push_back(insert);
+    }
+
 protected:
     std::shared_ptr<ViewContext> viewContext = nullptr;
+    std::vector<const Insert*> deferrableInserts;
+};
+
+/**
+ * @class IndexAccessOperation
+ * @brief  operation that is counted in the index access profile should inherit from this class.
+ *        The counter is only set if the index accesses are profiled.
+ */
+class IndexAccessOperation {
+public:
+    /** @brief Return the index of the access counter of the operation */
+    inline std::size_t getAccessIndex() const {
+        return accessIndex;
+    }
+
+    inline void setAccessIndex(std::size_t index) {
+        accessIndex = index;
+    }
+
+protected:
+    std::size_t accessIndex = 0;
 };
 
 /**
@@ -326,7 +387,7 @@ protected:
  * @brief  operation that utilizes the index view from underlying relation should inherit from this
  *        class.
  */
-class ViewOperation {
+class ViewOperation : public IndexAccessOperation {
 public:
     ViewOperation(std::size_t id) : viewId(id) {}
 
@@ -398,7 +459,7 @@ protected:
  */
 class RelationalOperation {
 public:
-    using RelationHandle = Own<RelationWrapper>;
+    using RelationHandle = std::shared_ptr<RelationWrapper>;
     RelationalOperation(RelationHandle* relHandle) : relHandle(relHandle) {}
 
     /** @brief get relation from handle */
@@ -470,9 +531,78 @@ class IntrinsicOperator : public CompoundNode {
 
 /**
  * @class UserDefinedOperator
+ *
+ * Holds the functor, resolved in the loaded libraries when the node is
+ * generated, and the call interface prepared for its signature, such that
+ * calls neither look up the functor nor prepare a call interface. Functors
+ * taking and returning numbers of the domain only, and stateful functors, of
+ * at most MaxDirectArity arguments are called directly through a function
+ * pointer of their signature instead of the call interface. The node owns
+ * the per-thread contexts of functors declared thread-local, and the result
+ * cache of functors declared cached.
  */
 class UserDefinedOperator : public CompoundNode {
-    using CompoundNode::CompoundNode;
+public:
+    using Functor = void (*)();
+    using Cache = FunctorCache<std::vector<RamDomain>>;
+
+    /** The maximal number of arguments of functors called directly */
+    static constexpr std::size_t MaxDirectArity = 4;
+
+    UserDefinedOperator(enum NodeType ty, const ram::Node* sdw, VecOwn<Node> children, Functor functor,
+            std::vector<ffi_type*> argTypes, ffi_type* returnType, bool direct, Own<FunctorContexts> contexts,
+            Own<Cache> cache)
+            : CompoundNode(ty, sdw, std::move(children)), functor(functor), argTypes(std::move(argTypes)),
+              direct(direct), contexts(std::move(contexts)), cache(std::move(cache)) {
+        if (functor != nullptr) {
+            const auto status = ffi_prep_cif(
+                    &cif, FFI_DEFAULT_ABI, this->argTypes.size(), returnType, this->argTypes.data());
+            if (status != FFI_OK) {
+                fatal("failed to prepare the call interface of a user-defined operator; error code = %d",
+                        status);
+            }
+        }
+    }
+
+    /** @brief Get the functor, or null if no library defines it */
+    Functor getFunctor() const {
+        return functor;
+    }
+
+    /** @brief Get the call interface of the functor */
+    ffi_cif* getCallInterface() const {
+        return &cif;
+    }
+
+    /** @brief Check whether the functor is called directly rather than through its call interface */
+    bool isDirect() const {
+        return direct;
+    }
+
+    /** @brief Get the per-thread contexts of the functor, or null if it is not thread-local */
+    FunctorContexts* getContexts() const {
+        return contexts.get();
+    }
+
+    /** @brief Get the result cache of the functor, or null if it is not cached */
+    Cache* getCache() const {
+        return cache.get();
+    }
+
+private:
+    const Functor functor;
+
+    /** Types of the arguments, referred to by the call interface */
+    std::vector<ffi_type*> argTypes;
+
+    /** Call interface, which is only read by calls and hence shared by all threads */
+    mutable ffi_cif cif;
+
+    const bool direct;
+
+    const Own<FunctorContexts> contexts;
+
+    const Own<Cache> cache;
 };
 
 /**
@@ -482,6 +612,13 @@ class NestedIntrinsicOperator : public CompoundNode {
     using CompoundNode::CompoundNode;
 };
 
+/**
+ * @class ParallelNestedIntrinsicOperator
+ */
+class ParallelNestedIntrinsicOperator : public NestedIntrinsicOperator, public AbstractParallel {
+    using NestedIntrinsicOperator::NestedIntrinsicOperator;
+};
+
 /**
  * @class PackRecord
  */
@@ -512,9 +649,10 @@ class False : public Node {
 
 /**
  * @class Conjunction
+ * @brief A flattened conjunction, the terms are evaluated from left to right.
  */
-class Conjunction : public BinaryNode {
-    using BinaryNode::BinaryNode;
+class Conjunction : public CompoundNode {
+    using CompoundNode::CompoundNode;
 };
 
 /**
@@ -545,17 +683,32 @@ public:
 /**
  * @class ExistenceCheck
  */
-class ExistenceCheck : public Node, public SuperOperation, public ViewOperation {
+class ExistenceCheck : public Node,
+                       public SuperOperation,
+                       public ViewOperation,
+                       public RelationalOperation {
 public:
     ExistenceCheck(enum NodeType ty, const ram::Node* sdw, bool totalSearch, std::size_t viewId,
-            SuperInstruction superInst, bool tempRelation, std::string relationName)
+            SuperInstruction superInst, bool tempRelation, std::string relationName,
+            RelationHandle* relHandle, std::size_t indexPos, bool filtered)
             : Node(ty, sdw), SuperOperation(std::move(superInst)), ViewOperation(viewId),
-              totalSearch(totalSearch), tempRelation(tempRelation), relationName(std::move(relationName)) {}
+              RelationalOperation(relHandle), totalSearch(totalSearch), tempRelation(tempRelation),
+              relationName(std::move(relationName)), indexPos(indexPos), filtered(filtered) {}
 
     bool isTotalSearch() const {
         return totalSearch;
     }
 
+    /** @brief Whether a total search is checked against the Bloom filter of the relation first */
+    bool isFiltered() const {
+        return filtered;
+    }
+
+    /** @brief The position of the index the tuple of the search is encoded for */
+    std::size_t getIndexPos() const {
+        return indexPos;
+    }
+
     bool isTemp() const {
         return tempRelation;
     }
@@ -568,6 +721,8 @@ private:
     const bool totalSearch;
     const bool tempRelation;
     const std::string relationName;
+    const std::size_t indexPos;
+    const bool filtered;
 };
 
 /**
@@ -583,16 +738,84 @@ public:
 
 /**
  * @class Constraint
+ * @brief Comparison of two expressions. Operands that are constants or tuple elements
+ *        are decoded when the node is generated, and are read without executing their nodes.
+ *        Constant patterns of match constraints are compiled when the node is generated.
  */
 class Constraint : public BinaryNode {
-    using BinaryNode::BinaryNode;
+public:
+    /** @brief An operand of the comparison */
+    struct Operand {
+        enum Kind { Expression, Constant, Element };
+        Kind kind = Expression;
+        /** @brief value of a constant */
+        RamDomain constant = 0;
+        /** @brief tuple and encoded element of a tuple element */
+        std::size_t tupleId = 0;
+        std::size_t element = 0;
+    };
+
+    Constraint(enum NodeType ty, const ram::Node* sdw, Own<Node> lhs, Own<Node> rhs, Operand lhsOperand,
+            Operand rhsOperand, Own<evaluator::CompiledRegex> regex = nullptr)
+            : BinaryNode(ty, sdw, std::move(lhs), std::move(rhs)), lhsOperand(lhsOperand),
+              rhsOperand(rhsOperand), regex(std::move(regex)) {}
+
+    /** @brief get the decoded left operand */
+    inline const Operand& getLhsOperand() const {
+        return lhsOperand;
+    }
+
+    /** @brief get the decoded right operand */
+    inline const Operand& getRhsOperand() const {
+        return rhsOperand;
+    }
+
+    /** @brief get the compiled pattern of a match constraint, if the pattern is a constant */
+    inline const evaluator::CompiledRegex* getRegex() const {
+        return regex.get();
+    }
+
+private:
+    const Operand lhsOperand;
+    const Operand rhsOperand;
+    const Own<evaluator::CompiledRegex> regex;
 };
 
 /**
  * @class TupleOperation
  */
 class TupleOperation : public UnaryNode {
-    using UnaryNode::UnaryNode;
+public:
+    TupleOperation(enum NodeType ty, const ram::Node* sdw, Own<Node> child, std::size_t frequencyIndex)
+            : UnaryNode(ty, sdw, std::move(child)), frequencyIndex(frequencyIndex) {}
+
+    /** @brief Return the index of the frequency counter of the operation */
+    std::size_t getFrequencyIndex() const {
+        return frequencyIndex;
+    }
+
+protected:
+    const std::size_t frequencyIndex;
+};
+
+/**
+ * @class ProfiledOperation
+ *
+ * Counts the tuples entering an operation of a profiled rule and times it;
+ * its shadow is the RAM operation of its child.
+ */
+class ProfiledOperation : public UnaryNode {
+public:
+    ProfiledOperation(enum NodeType ty, const ram::Node* sdw, Own<Node> child, std::size_t operatorIndex)
+            : UnaryNode(ty, sdw, std::move(child)), operatorIndex(operatorIndex) {}
+
+    /** @brief Return the index of the counters of the operation */
+    std::size_t getOperatorIndex() const {
+        return operatorIndex;
+    }
+
+protected:
+    const std::size_t operatorIndex;
 };
 
 /**
@@ -604,11 +827,36 @@ public:
             : Node(ty, sdw), NestedOperation(std::move(nested)), RelationalOperation(relHandle) {}
 };
 
+class IndexAggregate;
+
 /**
  * @class ParallelScan
+ * @brief Parallel scan, which may compute the aggregate nested in it for all groups at once
+ *        if the aggregate is grouped by elements of the scanned tuples.
  */
 class ParallelScan : public Scan, public AbstractParallel {
+public:
     using Scan::Scan;
+
+    /** @brief get the nested aggregate grouped by elements of the scanned tuples, or nullptr */
+    inline const IndexAggregate* getGroupedAggregate() const {
+        return groupedAggregate;
+    }
+
+    /** @brief get the index scanned by the grouped aggregate */
+    inline std::size_t getGroupedIndexPos() const {
+        return groupedIndexPos;
+    }
+
+    /** @brief set the nested aggregate grouped by elements of the scanned tuples */
+    inline void setGroupedAggregate(const IndexAggregate* aggregate, std::size_t indexPos) {
+        groupedAggregate = aggregate;
+        groupedIndexPos = indexPos;
+    }
+
+protected:
+    const IndexAggregate* groupedAggregate = nullptr;
+    std::size_t groupedIndexPos = 0;
 };
 
 /**
@@ -630,6 +878,45 @@ public:
     using IndexScan::IndexScan;
 };
 
+/**
+ * @class IndexIntersect
+ */
+class IndexIntersect : public Scan, public SuperOperation, public ViewOperation {
+public:
+    IndexIntersect(enum NodeType ty, const ram::Node* sdw, Own<Node> nested, std::size_t viewId,
+            SuperInstruction superInst, std::size_t element, std::size_t partnerViewId,
+            SuperInstruction partnerInst, std::size_t partnerElement)
+            : Scan(ty, sdw, nullptr, std::move(nested)), SuperOperation(std::move(superInst)),
+              ViewOperation(viewId), element(element), partnerViewId(partnerViewId),
+              partnerInst(std::move(partnerInst)), partnerElement(partnerElement) {}
+
+    /** @brief get the position of the shared attribute in the encoded tuple */
+    std::size_t getElement() const {
+        return element;
+    }
+
+    /** @brief get the view on the index of the partner */
+    std::size_t getPartnerViewId() const {
+        return partnerViewId;
+    }
+
+    /** @brief get the bounds of the partner, leaving the shared attribute unbounded */
+    const SuperInstruction& getPartnerSuperInst() const {
+        return partnerInst;
+    }
+
+    /** @brief get the position of the shared attribute in the encoded partner tuple */
+    std::size_t getPartnerElement() const {
+        return partnerElement;
+    }
+
+private:
+    const std::size_t element;
+    const std::size_t partnerViewId;
+    const SuperInstruction partnerInst;
+    const std::size_t partnerElement;
+};
+
 /**
  * @class IfExists
  */
@@ -745,17 +1032,40 @@ public:
  */
 class Filter : public Node, public ConditionalOperation, public NestedOperation {
 public:
-    Filter(enum NodeType ty, const ram::Node* sdw, Own<Node> cond, Own<Node> nested)
-            : Node(ty, sdw), ConditionalOperation(std::move(cond)), NestedOperation(std::move(nested)) {}
+    Filter(enum NodeType ty, const ram::Node* sdw, Own<Node> cond, Own<Node> nested,
+            std::size_t frequencyIndex = 0)
+            : Node(ty, sdw), ConditionalOperation(std::move(cond)), NestedOperation(std::move(nested)),
+              frequencyIndex(frequencyIndex) {}
+
+    /** @brief Return the index of the frequency counter of the operation; only set if it is profiled */
+    std::size_t getFrequencyIndex() const {
+        return frequencyIndex;
+    }
+
+protected:
+    const std::size_t frequencyIndex;
 };
 
 /**
  * @class Insert
  */
-class Insert : public Node, public SuperOperation, public RelationalOperation {
+class Insert : public Node, public SuperOperation, public RelationalOperation, public IndexAccessOperation {
 public:
     Insert(enum NodeType ty, const ram::Node* sdw, RelationHandle* relHandle, SuperInstruction superInst)
             : Node(ty, sdw), SuperOperation(std::move(superInst)), RelationalOperation(relHandle) {}
+
+    /** @brief get the buffer of the tuples of the insertion if the threads may defer it */
+    inline const std::optional<std::size_t>& getBufferId() const {
+        return bufferId;
+    }
+
+    /** @brief set the buffer of the tuples of the insertion, which the threads may defer */
+    inline void setBufferId(std::size_t id) {
+        bufferId = id;
+    }
+
+protected:
+    std::optional<std::size_t> bufferId;
 };
 
 /**
@@ -775,6 +1085,33 @@ public:
     GuardedInsert(enum NodeType ty, const ram::Node* sdw, RelationHandle* relHandle,
             SuperInstruction superInst, Own<Node> condition)
             : Insert(ty, sdw, relHandle, std::move(superInst)), ConditionalOperation(std::move(condition)) {}
+
+    /** @brief lock making the check of the guard and the insertion atomic in parallel queries */
+    Lock& getLock() const {
+        return lock;
+    }
+
+protected:
+    mutable Lock lock;
+};
+
+/**
+ * @class NoveltyInsert
+ */
+class NoveltyInsert : public Insert {
+public:
+    NoveltyInsert(enum NodeType ty, const ram::Node* sdw, RelationHandle* relHandle,
+            RelationHandle* newRelHandle, SuperInstruction superInst)
+            : Insert(ty, sdw, relHandle, std::move(superInst)), newRelHandle(newRelHandle) {}
+
+    /** @brief get the relation recording the tuples new to the target relation */
+    RelationWrapper* getNewRelation() const {
+        assert(newRelHandle && "No relation cached\n");
+        return (*newRelHandle).get();
+    }
+
+private:
+    RelationHandle* const newRelHandle;
 };
 
 /**
@@ -784,6 +1121,13 @@ class SubroutineReturn : public CompoundNode {
     using CompoundNode::CompoundNode;
 };
 
+/**
+ * @class Branches
+ */
+class Branches : public CompoundNode {
+    using CompoundNode::CompoundNode;
+};
+
 /**
  * @class Sequence
  */
@@ -805,6 +1149,55 @@ class Loop : public UnaryNode {
     using UnaryNode::UnaryNode;
 };
 
+/**
+ * @class Worklist
+ * @brief A fixpoint loop whose rules are evaluated for each tuple as soon as the rules derive it,
+ *        instead of in iterations over the delta relations
+ */
+class Worklist : public Node {
+public:
+    using RelationHandle = std::shared_ptr<RelationWrapper>;
+
+    /** A rule driven by the tuples of a delta relation */
+    struct Rule {
+        /** Position of the delta relation in the loop */
+        std::size_t delta;
+        /** Tuple to which the delta tuples are bound */
+        std::size_t tupleId;
+        /** Conditions of the rule independent of the relations of the loop */
+        VecOwn<Node> conditions;
+        /** Operation evaluated for each delta tuple */
+        Own<Node> operation;
+        /** Views of the operation */
+        std::shared_ptr<ViewContext> viewContext;
+    };
+
+    Worklist(enum NodeType ty, const ram::Node* sdw, std::vector<RelationHandle*> deltas,
+            std::vector<Rule> rules, std::vector<std::pair<std::size_t, std::size_t>> buffers)
+            : Node(ty, sdw), deltas(std::move(deltas)), rules(std::move(rules)),
+              buffers(std::move(buffers)) {}
+
+    /** @brief get the delta relations, which hold the tuples derived before the loop */
+    const std::vector<RelationHandle*>& getDeltas() const {
+        return deltas;
+    }
+
+    /** @brief get the rules of the loop */
+    const std::vector<Rule>& getRules() const {
+        return rules;
+    }
+
+    /** @brief get the buffers of the tuples new to the relations, with the position of their delta */
+    const std::vector<std::pair<std::size_t, std::size_t>>& getBuffers() const {
+        return buffers;
+    }
+
+private:
+    const std::vector<RelationHandle*> deltas;
+    const std::vector<Rule> rules;
+    const std::vector<std::pair<std::size_t, std::size_t>> buffers;
+};
+
 /**
  * @class Exit
  */
@@ -840,8 +1233,22 @@ class DebugInfo : public UnaryNode {
  */
 class Clear : public Node, public RelationalOperation {
 public:
-    Clear(enum NodeType ty, const ram::Node* sdw, RelationHandle* handle)
-            : Node(ty, sdw), RelationalOperation(handle) {}
+    Clear(enum NodeType ty, const ram::Node* sdw, RelationHandle* handle, bool retain, bool drop)
+            : Node(ty, sdw), RelationalOperation(handle), retain(retain), drop(drop) {}
+
+    /** The relation is refilled subsequently, i.e., its storage is worth to be retained */
+    bool retainsStorage() const {
+        return retain;
+    }
+
+    /** The relation is not used any more, i.e., its storage is to be returned to the system */
+    bool dropsRelation() const {
+        return drop;
+    }
+
+protected:
+    const bool retain;
+    const bool drop;
 };
 
 /**
@@ -860,6 +1267,69 @@ private:
     const std::size_t subroutineId;
 };
 
+/**
+ * @class CompactTables
+ */
+class CompactTables : public Node {
+public:
+    using RelationHandle = std::shared_ptr<RelationWrapper>;
+
+    /** Relations holding symbols or records, along with their RAM relations giving the attribute types */
+    using Relations = std::vector<std::pair<RelationHandle*, const ram::Relation*>>;
+
+    CompactTables(enum NodeType ty, const ram::Node* sdw, Relations relations)
+            : Node(ty, sdw), relations(std::move(relations)) {}
+
+    const Relations& getRelations() const {
+        return relations;
+    }
+
+private:
+    const Relations relations;
+};
+
+/**
+ * @class Checkpoint
+ */
+class Checkpoint : public Node {
+    using Node::Node;
+};
+
+/**
+ * @class StratumCache
+ */
+class StratumCache : public UnaryNode {
+public:
+    using RelationHandle = std::shared_ptr<RelationWrapper>;
+
+    /** Relations along with their RAM relations giving the attribute types */
+    using Relations = std::vector<std::pair<RelationHandle*, const ram::Relation*>>;
+
+    StratumCache(enum NodeType ty, const ram::Node* sdw, Own<Node> child, Relations inputs, Relations outputs)
+            : UnaryNode(ty, sdw, std::move(child)), inputs(std::move(inputs)), outputs(std::move(outputs)) {}
+
+    /** Relations read by the cached body */
+    const Relations& getInputs() const {
+        return inputs;
+    }
+
+    /** Relations computed by the cached body */
+    const Relations& getOutputs() const {
+        return outputs;
+    }
+
+private:
+    const Relations inputs;
+    const Relations outputs;
+};
+
+/**
+ * @class Guard
+ */
+class Guard : public BinaryNode {
+    using BinaryNode::BinaryNode;
+};
+
 /**
  * @class LogSize
  */
@@ -903,5 +1373,29 @@ public:
             : Node(ty, sdw), BinRelOperation(src, target) {}
 };
 
+/**
+ * @class BulkInsert
+ * @brief Replaces a query that copies all tuples of the source relation into the target relation.
+ *
+ * The shadow node is the original ram::Query.
+ */
+class BulkInsert : public Node, public BinRelOperation, public IndexAccessOperation {
+public:
+    BulkInsert(enum NodeType ty, const ram::Node* sdw, std::size_t src, std::size_t target)
+            : Node(ty, sdw), BinRelOperation(src, target) {}
+};
+
+/**
+ * @class BulkErase
+ * @brief Replaces a query that erases all tuples of the source relation from the target relation.
+ *
+ * The shadow node is the original ram::Query.
+ */
+class BulkErase : public Node, public BinRelOperation {
+public:
+    BulkErase(enum NodeType ty, const ram::Node* sdw, std::size_t src, std::size_t target)
+            : Node(ty, sdw), BinRelOperation(src, target) {}
+};
+
 }  // namespace interpreter
 }  // namespace souffle
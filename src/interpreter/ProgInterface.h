@@ -29,10 +29,12 @@
 #include "souffle/SouffleInterface.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/span.h"
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <iosfwd>
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
@@ -49,28 +51,72 @@ class RelInterface : public souffle::Relation {
 public:
     RelInterface(RelationWrapper& r, SymbolTable& s, std::string n, std::vector<std::string> t,
             std::vector<std::string> an, uint32_t i)
-            : relation(r), symTable(s), name(std::move(n)), types(std::move(t)), attrNames(std::move(an)),
+            : wrapped(&r), symTable(s), name(std::move(n)), types(std::move(t)), attrNames(std::move(an)),
               id(i) {}
+
+    /** Wrap the relation of an engine on the given index, which changes once it is no longer shared */
+    RelInterface(Engine& e, std::size_t relId, SymbolTable& s, std::string n, std::vector<std::string> t,
+            std::vector<std::string> an, uint32_t i)
+            : engine(&e), relId(relId), symTable(s), name(std::move(n)), types(std::move(t)),
+              attrNames(std::move(an)), id(i) {}
     ~RelInterface() override = default;
 
     /** Insert tuple */
     void insert(const tuple& t) override {
-        relation.insert(t.data);
+        auto& relation = getWritableRelation();
+        relation.insertKept(t.data);
+        relation.setModified(true);
+    }
+
+    /** Insert consecutively stored tuples */
+    void insertBatch(span<const RamDomain> tuples, std::size_t n) override {
+        auto& relation = getWritableRelation();
+        const std::size_t arity = relation.getArity();
+        assert(tuples.size() >= n * arity && "buffer too small");
+        for (std::size_t i = 0; i < n; ++i) {
+            relation.insertKept(tuples.data() + i * arity);
+        }
+        relation.setModified(true);
     }
 
     /** Check whether tuple exists */
     bool contains(const tuple& t) const override {
-        return relation.contains(t.data);
+        return getRelation().contains(t.data);
+    }
+
+    /** Find a tuple by its primary attributes */
+    bool findPrimary(span<RamDomain> t) const override {
+        assert(t.size() >= getRelation().getArity() && "buffer too small");
+        return getRelation().findPrimary(t.data());
     }
 
     /** Iterator to first tuple */
     iterator begin() const override {
-        return RelInterface::iterator(mk<RelInterface::iterator_base>(id, this, relation.begin()));
+        return RelInterface::iterator(mk<RelInterface::iterator_base>(id, this, getRelation().begin()));
     }
 
     /** Iterator to last tuple */
     iterator end() const override {
-        return RelInterface::iterator(mk<RelInterface::iterator_base>(id, this, relation.end()));
+        return RelInterface::iterator(mk<RelInterface::iterator_base>(id, this, getRelation().end()));
+    }
+
+    /** Pass batches of consecutively stored tuples to the callback */
+    void scanBatch(const batch_callback& callback, std::size_t batchSize) const override {
+        assert(batchSize > 0 && "empty batches");
+        const auto& relation = getRelation();
+        const std::size_t arity = relation.getArity();
+        std::vector<RamDomain> buffer(batchSize * arity);
+        std::size_t n = 0;
+        for (auto it = relation.begin(), end = relation.end(); it != end; ++it) {
+            std::copy_n(*it, arity, buffer.data() + n * arity);
+            if (++n == batchSize) {
+                callback(buffer, n);
+                n = 0;
+            }
+        }
+        if (n > 0) {
+            callback(span<const RamDomain>(buffer.data(), n * arity), n);
+        }
     }
 
     /** Get name */
@@ -80,12 +126,12 @@ public:
 
     /** Get arity */
     arity_type getArity() const override {
-        return relation.getArity();
+        return getRelation().getArity();
     }
 
     /** Get arity */
     arity_type getAuxiliaryArity() const override {
-        return relation.getAuxiliaryArity();
+        return getRelation().getAuxiliaryArity();
     }
 
     /** Get symbol table */
@@ -107,12 +153,14 @@ public:
 
     /** Get number of tuples in relation */
     std::size_t size() const override {
-        return relation.size();
+        return getRelation().size();
     }
 
     /** Eliminate all the tuples in relation*/
     void purge() override {
-        relation.purge();
+        auto& relation = getWritableRelation();
+        relation.purgeKept();
+        relation.setModified(true);
     }
 
 protected:
@@ -180,8 +228,25 @@ protected:
     };
 
 private:
-    /** Wrapped interpreter relation */
-    RelationWrapper& relation;
+    /** Return the wrapped relation */
+    RelationWrapper& getRelation() const {
+        return engine != nullptr ? *engine->getRelationHandle(relId) : *wrapped;
+    }
+
+    /** Return the wrapped relation, which no longer shares its tuples with a copy of the engine */
+    RelationWrapper& getWritableRelation() {
+        if (engine != nullptr) {
+            engine->unshareRelation(engine->getRelationHandle(relId), true);
+        }
+        return getRelation();
+    }
+
+    /** Wrapped interpreter relation, unless it is a relation of an engine */
+    RelationWrapper* wrapped = nullptr;
+
+    /** Engine of the wrapped relation, and its index */
+    Engine* engine = nullptr;
+    std::size_t relId = 0;
 
     /** Symbol table */
     SymbolTable& symTable;
@@ -214,12 +279,13 @@ public:
         visit(prog, [&](const ram::Relation& rel) { map[rel.getName()] = &rel; });
 
         // Build wrapper relations for Souffle's interface
-        for (auto& relHandler : exec.getRelationMap()) {
-            if (relHandler == nullptr) {
+        auto& relationMap = exec.getRelationMap();
+        for (std::size_t relId = 0; relId < relationMap.size(); ++relId) {
+            if (relationMap[relId] == nullptr) {
                 // Skip droped relation.
                 continue;
             }
-            auto& interpreterRel = **relHandler;
+            auto& interpreterRel = **relationMap[relId];
             auto& name = interpreterRel.getName();
             assert(map[name]);
             const ram::Relation& rel = *map[name];
@@ -228,7 +294,7 @@ public:
             std::vector<std::string> types = rel.getAttributeTypes();
             std::vector<std::string> attrNames = rel.getAttributeNames();
 
-            auto* interface = new RelInterface(interpreterRel, symTable, rel.getName(), types, attrNames, id);
+            auto* interface = new RelInterface(exec, relId, symTable, rel.getName(), types, attrNames, id);
             interfaces.push_back(interface);
             bool input = false;
             bool output = false;
@@ -254,8 +320,22 @@ public:
         }
     }
 
-    /** Run program instance: not implemented */
-    void run() override {}
+    using SouffleProgram::run;
+
+    /**
+     * Run program instance, i.e., evaluate its main program.
+     *
+     * Each run evaluates the program again, with the tuples inserted through the interface. Note
+     * that earlier versions did nothing here, as runAll() still does. With --incremental the
+     * relations stay resident between runs, so only the strata affected by tuples inserted or
+     * purged through the interface since the last run are re-evaluated.
+     */
+    void run() override {
+        exec.requestedRelations = requestedRelations;
+        exec.stratumCallback = stratumCallback;
+        exec.cancellationCheck = [this]() { return isCancelled(); };
+        exec.executeMain();
+    }
 
     /** Load data, run program instance, store data: not implemented */
     void runAll(std::string, std::string, bool, bool) override {}
@@ -272,6 +352,23 @@ public:
     /** Dump outputs: not implemented */
     void dumpOutputs() override {}
 
+    /**
+     * Copy the program instance in its current state, which takes constant time per relation.
+     *
+     * The copy shares the relations of this instance until either changes them, and the symbol and
+     * record tables for good. The instance and its copies must be run one at a time.
+     */
+    std::unique_ptr<SouffleProgram> clone() override {
+        auto engine = exec.clone();
+        if (engine == nullptr) {
+            return nullptr;
+        }
+        auto copy = mk<ProgInterface>(*engine);
+        copy->engine = std::move(engine);
+        copy->setNumThreads(getNumThreads());
+        return copy;
+    }
+
     /** Run subroutine */
     void executeSubroutine(
             std::string name, const std::vector<RamDomain>& args, std::vector<RamDomain>& ret) override {
@@ -293,6 +390,8 @@ private:
     SymbolTable& symTable;
     RecordTable& recordTable;
     std::vector<RelInterface*> interfaces;
+    /** Engine of a copy of a program instance, which the copy owns */
+    Own<Engine> engine;
 };
 
 }  // namespace souffle::interpreter
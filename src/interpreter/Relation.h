@@ -18,16 +18,27 @@
 
 #include "interpreter/Index.h"
 #include "ram/analysis/Index.h"
+#include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
 #include "souffle/SouffleInterface.h"
+#include "souffle/datastructure/BloomFilter.h"
+#include "souffle/io/ReadStream.h"
+#include "souffle/utility/LockProfile.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/StringUtil.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -107,12 +118,66 @@ public:
 
     virtual void insert(const RamDomain*) = 0;
 
+    /**
+     * Insert the tuples collected by the threads of a parallel query, given as the consecutive values
+     * of the tuples of each thread.
+     */
+    virtual void insertBuffers(const std::vector<const std::vector<RamDomain>*>& buffers) = 0;
+
+    /** Insert all tuples of the given input stream */
+    virtual void load(ReadStream& reader) = 0;
+
+    /** Reduce the memory footprint of a relation that is not going to be modified any more */
+    virtual void compact() = 0;
+
+    /** Memory usage of an index */
+    struct IndexMemory {
+        /** number of bytes allocated by the index */
+        std::size_t bytes;
+        /** number of nodes of the tree of the index */
+        std::size_t nodes;
+        /** average fraction of the keys of the b-tree nodes in use */
+        double fillFactor;
+    };
+
+    /** Return the number of indexes of the relation */
+    virtual std::size_t getNumIndexes() const = 0;
+
+    /** Return the memory usage of the index at the given position */
+    virtual IndexMemory getIndexMemory(std::size_t idx) const = 0;
+
     virtual bool contains(const RamDomain*) const = 0;
 
+    /**
+     * Find the tuple whose primary attributes equal those of the given tuple, and complete the given
+     * tuple by its auxiliary attributes. By default, the relation is scanned.
+     */
+    virtual bool findPrimary(RamDomain* data) const {
+        const std::size_t primaryArity = arity - auxiliaryArity;
+        for (auto it = begin(), end = this->end(); it != end; ++it) {
+            const RamDomain* tuple = *it;
+            if (std::equal(tuple, tuple + primaryArity, data)) {
+                std::copy_n(tuple, arity, data);
+                return true;
+            }
+        }
+        return false;
+    }
+
     virtual std::size_t size() const = 0;
 
     virtual void purge() = 0;
 
+    /**
+     * Visit a sample of at most the given number of tuples, spread over the whole relation.
+     */
+    virtual void sample(std::size_t count, const std::function<void(const RamDomain*)>& visitor) const = 0;
+
+    /**
+     * Split the relation into about the given number of consecutive parts, to be scanned in parallel.
+     */
+    virtual std::vector<souffle::range<Iterator>> partition(std::size_t count) const = 0;
+
     const std::string& getName() const {
         return relName;
     }
@@ -125,6 +190,56 @@ public:
         return auxiliaryArity;
     }
 
+    /**
+     * Record whether the relation was changed since the last incremental evaluation.
+     */
+    void setModified(bool value) {
+        modified = value;
+    }
+
+    bool isModified() const {
+        return modified;
+    }
+
+    /**
+     * Keep the tuples inserted through the program interface from now on, such that purging the
+     * tuples derived by an incremental evaluation leaves them in the relation.
+     */
+    void setKeepInserted(bool value) {
+        keepInserted = value;
+    }
+
+    /** Insert a tuple through the program interface */
+    void insertKept(const RamDomain* tuple) {
+        insert(tuple);
+        if (keepInserted) {
+            inserted.insert(inserted.end(), tuple, tuple + arity);
+            ++numInserted;
+        }
+    }
+
+    /** Purge the relation through the program interface, which forgets the tuples it inserted */
+    void purgeKept() {
+        purge();
+        inserted.clear();
+        numInserted = 0;
+    }
+
+    /** Purge the tuples derived by an evaluation, keeping the tuples inserted through the interface */
+    void purgeDerived() {
+        purge();
+        for (std::size_t i = 0; i < numInserted; ++i) {
+            insert(inserted.data() + i * arity);
+        }
+    }
+
+    /** Keep the tuples the given relation keeps, which has the same arity */
+    void copyKept(const RelationWrapper& other) {
+        keepInserted = other.keepInserted;
+        inserted = other.inserted;
+        numInserted = other.numInserted;
+    }
+
     // -- Defines methods and interfaces for Interpreter execution. --
 public:
     using IndexViewPtr = Own<ViewWrapper>;
@@ -134,6 +249,42 @@ public:
      */
     virtual Order getIndexOrder(std::size_t) const = 0;
 
+    /**
+     * Build the index at the given position if it is built on demand and has not been built yet.
+     *
+     * Once built, the index is maintained on insertion like any other index. Must not be called
+     * while tuples are inserted into the relation.
+     */
+    virtual void buildIndex(std::size_t idx) = 0;
+
+    /**
+     * Build all indexes built on demand which have not been built yet, each index by a thread of its
+     * own. Must not be called while tuples are inserted into the relation.
+     */
+    virtual void buildIndexes() = 0;
+
+    /**
+     * Free the indexes built on demand, which are built again by their next search.
+     *
+     * @return the number of bytes the indexes allocated
+     */
+    virtual std::size_t releaseIndexes() = 0;
+
+    /**
+     * Fill the Bloom filter of a filtered relation with the tuples of the relation.
+     *
+     * Once built, the filter is maintained on insertion until the relation is purged. Must not
+     * be called while the relation is accessed otherwise.
+     */
+    virtual void buildFilter() = 0;
+
+    /**
+     * Freeze the indexes of a relation which the remaining strata do not modify.
+     *
+     * Modifying the relation afterwards is allowed, but must not happen concurrently.
+     */
+    virtual void freeze() = 0;
+
     /**
      * Obtains a view on an index of this relation, facilitating hint-supported accesses.
      *
@@ -141,11 +292,26 @@ public:
      */
     virtual IndexViewPtr createView(const std::size_t&) const = 0;
 
+    /**
+     * Prepare a view created by this relation on the index at the given position for another query,
+     * keeping its hints where they are still valid. Returns false if the view has to be created anew.
+     */
+    virtual bool reuseView(ViewWrapper& view, std::size_t indexPos) const = 0;
+
 protected:
     std::string relName;
 
     arity_type arity;
     arity_type auxiliaryArity;
+
+    bool modified = false;
+
+    /** Whether the tuples inserted through the program interface are kept, see setKeepInserted() */
+    bool keepInserted = false;
+
+    /** The tuples inserted through the program interface, stored consecutively */
+    std::vector<RamDomain> inserted;
+    std::size_t numInserted = 0;
 };
 
 /**
@@ -158,16 +324,27 @@ public:
     using Attribute = uint32_t;
     using AttributeSet = std::set<Attribute>;
     using Index = interpreter::Index<Arity, Structure>;
-    using Tuple = souffle::Tuple<RamDomain, Arity>;
+    using Tuple = typename Index::Tuple;
     using View = typename Index::View;
     using iterator = typename Index::iterator;
 
+    /**
+     * Construct a tuple of the given arity; the arity of relations of a fixed arity is implied.
+     */
+    static Tuple makeTuple([[maybe_unused]] std::size_t arity) {
+        if constexpr (Arity == Dynamic) {
+            return Tuple(arity);
+        } else {
+            return Tuple{};
+        }
+    }
+
     /**
      * Construct a typed tuple from a raw data.
      */
-    static Tuple constructTuple(const RamDomain* data) {
-        Tuple tuple{};
-        std::copy_n(data, Arity, tuple.begin());
+    Tuple constructTuple(const RamDomain* data) const {
+        Tuple tuple = makeTuple(getArity());
+        std::copy_n(data, getArity(), tuple.begin());
         return tuple;
     }
 
@@ -183,7 +360,16 @@ public:
      */
     Relation(std::size_t auxiliaryArity, const std::string& name,
             const ram::analysis::IndexCluster& indexSelection)
-            : RelationWrapper(Arity, auxiliaryArity, name) {
+            : Relation(Arity, auxiliaryArity, name, indexSelection) {}
+
+    /**
+     * Creates a relation of the given arity, build all necessary indexes. Only relations of a dynamic
+     * arity are not of the arity of their type.
+     */
+    Relation(std::size_t arity, std::size_t auxiliaryArity, const std::string& name,
+            const ram::analysis::IndexCluster& indexSelection)
+            : RelationWrapper(arity, auxiliaryArity, name), filtered(indexSelection.isFiltered()) {
+        assert((Arity == Dynamic || arity == Arity) && "arity of relation does not match its type");
         for (const auto& order : indexSelection.getAllOrders()) {
             ram::analysis::LexOrder fullOrder = order;
             // Expand the order to a total order
@@ -198,7 +384,11 @@ public:
             }
 
             indexes.push_back(mk<Index>(fullOrder));
+            onDemand.push_back(indexSelection.isOnDemand(indexes.size() - 1));
+            lockSites.push_back(LockProfile::getSite(name + " " + toString(fullOrder)));
         }
+        built = onDemand;
+        built.flip();
 
         // Use the first index as default main index
         main = indexes[0].get();
@@ -217,30 +407,203 @@ public:
         insert(constructTuple(data));
     }
 
+    void insertBuffers(const std::vector<const std::vector<RamDomain>*>& buffers) override {
+        insertAll(collectBuffers(buffers));
+    }
+
+    void load(ReadStream& reader) override {
+        // gather the input so that each index can be built in bulk
+        struct Buffer {
+            const Relation& rel;
+            std::vector<Tuple> tuples;
+            void insert(const RamDomain* data) {
+                tuples.push_back(rel.constructTuple(data));
+            }
+        } buffer{*this, {}};
+        reader.readAll(buffer);
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            if (built[i]) {
+                indexes[i]->load(buffer.tuples);
+            }
+        }
+        if (filter.isActive()) {
+            for (const auto& tuple : buffer.tuples) {
+                filter.insert(tuple);
+            }
+        }
+    }
+
+    void compact() override {
+        for (auto& index : indexes) {
+            index->compact();
+        }
+    }
+
     bool contains(const RamDomain* data) const override {
         return contains(constructTuple(data));
     }
 
+    bool findPrimary(RamDomain* data) const override {
+        const std::size_t primaryArity = getArity() - getAuxiliaryArity();
+        if (primaryArity == getArity()) {
+            return contains(data);
+        }
+        if constexpr (Arity != Dynamic) {
+            // an index ordered by the primary attributes first holds the tuple of the given primary
+            // attributes in the range of all auxiliary attributes
+            for (std::size_t i = 0; i < indexes.size(); ++i) {
+                const auto& order = indexes[i]->getOrder().getOrder();
+                if (!built[i] || !std::all_of(order.begin(), order.begin() + primaryArity,
+                                         [&](auto attr) { return attr < primaryArity; })) {
+                    continue;
+                }
+                Tuple low = constructTuple(data);
+                Tuple high = low;
+                for (std::size_t j = primaryArity; j < Arity; ++j) {
+                    low[j] = MIN_RAM_SIGNED;
+                    high[j] = MAX_RAM_SIGNED;
+                }
+                const Order& encoding = indexes[i]->getOrder();
+                for (const auto& entry : indexes[i]->range(encoding.encode(low), encoding.encode(high))) {
+                    const Tuple tuple = encoding.decode(entry);
+                    std::copy_n(tuple.begin(), Arity, data);
+                    return true;
+                }
+                return false;
+            }
+        }
+        return RelationWrapper::findPrimary(data);
+    }
+
+    void buildIndex(std::size_t idx) override {
+        if (!onDemand[idx]) {
+            return;
+        }
+        // strata evaluated in parallel may search the same relation
+        std::lock_guard<std::mutex> guard(buildLock);
+        if (!built[idx]) {
+            indexes[idx]->load(*main);
+            built[idx] = true;
+        }
+    }
+
+    void buildIndexes() override {
+        std::lock_guard<std::mutex> guard(buildLock);
+        std::vector<std::size_t> pending;
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            if (!built[i]) {
+                pending.push_back(i);
+            }
+        }
+        if (pending.empty()) {
+            return;
+        }
+        // the indexes are independent of each other, all of them are loaded from the main index
+        PARALLEL_START
+        pfor(std::size_t i = 0; i < pending.size(); ++i) {
+            indexes[pending[i]]->load(*main);
+        }
+        PARALLEL_END
+        for (std::size_t idx : pending) {
+            built[idx] = true;
+        }
+    }
+
+    std::size_t releaseIndexes() override {
+        std::lock_guard<std::mutex> guard(buildLock);
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            if (onDemand[i] && built[i]) {
+                bytes += indexes[i]->getMemoryUsage();
+                indexes[i]->clear();
+                built[i] = false;
+            }
+        }
+        return bytes;
+    }
+
+    void buildFilter() override {
+        if constexpr (Arity > 0) {
+            if (!filtered) {
+                return;
+            }
+            filter.reset(main->size());
+            const auto& order = main->getOrder();
+            for (const auto& tuple : main->scan()) {
+                filter.insert(order.decode(tuple));
+            }
+        }
+    }
+
+    void freeze() override {
+        for (auto& index : indexes) {
+            index->freeze();
+        }
+    }
+
     IndexViewPtr createView(const std::size_t& indexPos) const override {
         return mk<View>(indexes[indexPos]->createView());
     }
 
+    bool reuseView(ViewWrapper& view, std::size_t indexPos) const override {
+        return castView(&view)->reuse(*indexes[indexPos]);
+    }
+
     std::size_t size() const override {
         return __size();
     }
 
+    void sample(std::size_t count, const std::function<void(const RamDomain*)>& visitor) const override {
+        if constexpr (Arity > 0) {
+            const Order& order = main->getOrder();
+            Tuple data = makeTuple(getArity());
+            auto decode = [&](const auto& tuple) {
+                for (std::size_t i = 0; i < order.size(); ++i) {
+                    data[order[i]] = tuple[i];
+                }
+                visitor(data.data());
+            };
+            if (size() <= count) {
+                for (const auto& tuple : scan()) {
+                    decode(tuple);
+                }
+                return;
+            }
+            // take the first tuple of each chunk; neighbouring tuples share the prefix of the order
+            std::size_t visited = 0;
+            for (const auto& chunk : partitionScan(count)) {
+                if (visited == count) {
+                    break;
+                }
+                if (chunk.begin() != chunk.end()) {
+                    decode(*chunk.begin());
+                    ++visited;
+                }
+            }
+        }
+    }
+
     Order getIndexOrder(std::size_t idx) const override {
         return indexes[idx]->getOrder();
     }
 
+    std::size_t getNumIndexes() const override {
+        return indexes.size();
+    }
+
+    IndexMemory getIndexMemory(std::size_t idx) const override {
+        const Index& index = *indexes[idx];
+        return {index.getMemoryUsage(), index.getNumNodes(), index.getFillFactor()};
+    }
+
     class iterator_base : public RelationWrapper::iterator_base {
         iterator iter;
         Order order;
-        RamDomain data[Arity];
+        Tuple data;
 
     public:
         iterator_base(typename Index::iterator iter, Order order)
-                : iter(std::move(iter)), order(std::move(order)) {}
+                : iter(std::move(iter)), order(std::move(order)), data(makeTuple(this->order.size())) {}
 
         iterator_base& operator++() override {
             ++iter;
@@ -253,7 +616,7 @@ public:
             for (std::size_t i = 0; i < order.size(); ++i) {
                 data[order[i]] = tuple[i];
             }
-            return data;
+            return data.data();
         }
 
         iterator_base* clone() const override {
@@ -276,6 +639,15 @@ public:
         return Iterator(new iterator_base(main->end(), main->getOrder()));
     }
 
+    std::vector<souffle::range<Iterator>> partition(std::size_t count) const override {
+        std::vector<souffle::range<Iterator>> res;
+        for (const auto& chunk : main->partitionScan(static_cast<int>(count))) {
+            res.push_back({Iterator(new iterator_base(chunk.begin(), main->getOrder())),
+                    Iterator(new iterator_base(chunk.end(), main->getOrder()))});
+        }
+        return res;
+    }
+
     // -----
     // Following section defines and implement interfaces for interpreter execution.
     //
@@ -287,21 +659,64 @@ public:
      * Add the given tuple to this relation.
      */
     bool insert(const Tuple& tuple) {
-        if (!(main->insert(tuple))) {
-            return false;
+        {
+            LockSiteScope scope(lockSites[0]);
+            if (!(main->insert(tuple))) {
+                return false;
+            }
         }
         for (std::size_t i = 1; i < indexes.size(); ++i) {
-            indexes[i]->insert(tuple);
+            if (built[i]) {
+                LockSiteScope scope(lockSites[i]);
+                indexes[i]->insert(tuple);
+            }
         }
+        filter.insert(tuple);
         return true;
     }
 
     /**
      * Add all entries of the given relation to this relation.
+     *
+     * Each index is filled in bulk from the main index of the other relation.
      */
     void insert(const Relation<Arity, Structure>& other) {
-        for (const auto& tuple : other.scan()) {
-            this->insert(tuple);
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            if (built[i]) {
+                LockSiteScope scope(lockSites[i]);
+                indexes[i]->insert(*other.main);
+            }
+        }
+        if constexpr (Arity > 0) {
+            if (filter.isActive()) {
+                const auto& order = other.main->getOrder();
+                for (const auto& tuple : other.main->scan()) {
+                    filter.insert(order.decode(tuple));
+                }
+            }
+        }
+    }
+
+    /**
+     * Add the given tuples to this relation.
+     *
+     * Each index inserts the tuples as a batch, sorted into its order, such that the threads of a
+     * parallel query do not contend for the nodes of the indexes inserting their tuples one by one.
+     */
+    void insertAll(const std::vector<Tuple>& tuples) {
+        if (tuples.empty()) {
+            return;
+        }
+        for (std::size_t i = 0; i < indexes.size(); ++i) {
+            if (built[i]) {
+                LockSiteScope scope(lockSites[i]);
+                indexes[i]->insertAll(tuples);
+            }
+        }
+        if (filter.isActive()) {
+            for (const auto& tuple : tuples) {
+                filter.insert(tuple);
+            }
         }
     }
 
@@ -312,6 +727,17 @@ public:
         return main->contains(tuple);
     }
 
+    /**
+     * Tests whether this relation may contain the given tuple, encoded in the order of the given index,
+     * by its Bloom filter. Relations without an active filter may contain any tuple.
+     */
+    bool mayContain(const std::size_t& indexPos, const Tuple& entry) const {
+        if (!filter.isActive()) {
+            return true;
+        }
+        return filter.mayContain(indexes[indexPos]->getOrder().decode(entry));
+    }
+
     /**
      * Tests whether this relation contains any element between the given boundaries.
      */
@@ -356,6 +782,9 @@ public:
      */
     void swap(Relation<Arity, Structure>& other) {
         indexes.swap(other.indexes);
+        onDemand.swap(other.onDemand);
+        built.swap(other.built);
+        filter.swap(other.filter);
     }
 
     /**
@@ -379,6 +808,21 @@ public:
         for (auto& idx : indexes) {
             idx->clear();
         }
+        built = onDemand;
+        built.flip();
+        filter.clear();
+    }
+
+    /**
+     * Clear all indexes, retaining their storage for refilling the relation
+     */
+    void __recycle() {
+        for (auto& idx : indexes) {
+            idx->recycle();
+        }
+        built = onDemand;
+        built.flip();
+        filter.clear();
     }
 
     /**
@@ -389,7 +833,20 @@ public:
     }
 
     Index* getIndex(std::size_t idx) {
-        return indexes[idx];
+        return indexes[idx].get();
+    }
+
+protected:
+    /** Construct the tuples of the given buffers of consecutive values */
+    std::vector<Tuple> collectBuffers(const std::vector<const std::vector<RamDomain>*>& buffers) const {
+        std::vector<Tuple> tuples;
+        const std::size_t arity = getArity();
+        for (const auto* buffer : buffers) {
+            for (std::size_t i = 0; i < buffer->size(); i += arity) {
+                tuples.push_back(constructTuple(buffer->data() + i));
+            }
+        }
+        return tuples;
     }
 
 protected:
@@ -401,6 +858,24 @@ protected:
 
     // a pointer to the main index within the managed index
     Index* main;
+
+    // whether the indexes are built on demand, by the first search on them
+    std::vector<bool> onDemand;
+
+    // whether the indexes hold all tuples of the relation, i.e., are not waiting to be built
+    std::vector<bool> built;
+
+    // serialises building indexes on demand
+    std::mutex buildLock;
+
+    // the sites the locks of the indexes are counted at, null unless the locks are instrumented
+    std::vector<LockSite*> lockSites;
+
+    // whether total existence checks consult a Bloom filter before the main index
+    bool filtered;
+
+    // the Bloom filter of a filtered relation, active from the end of the stratum computing the relation
+    BloomFilter filter;
 };
 
 template <std::size_t _Arity>
@@ -409,6 +884,7 @@ public:
     using Relation<_Arity, BtreeDelete>::Relation;
     using Relation<_Arity, BtreeDelete>::main;
     using Relation<_Arity, BtreeDelete>::indexes;
+    using Relation<_Arity, BtreeDelete>::built;
     using Tuple = souffle::Tuple<RamDomain, _Arity>;
 
     /**
@@ -420,12 +896,134 @@ public:
             return false;
         }
         for (std::size_t i = 1; i < indexes.size(); ++i) {
-            static_cast<DeleteIndex*>(indexes[i].get())->erase(tuple);
+            if (built[i]) {
+                static_cast<DeleteIndex*>(indexes[i].get())->erase(tuple);
+            }
         }
         return true;
     }
+
+    /**
+     * Erase all tuples of the given relation from this relation.
+     *
+     * Each index erases the tuples as a batch, rather than merging and rebalancing its nodes for
+     * each tuple, which is the common case of the tuples subsumed in an iteration.
+     */
+    void eraseAll(const RelationWrapper& src) {
+        using DeleteIndex = BtreeDeleteIndex<_Arity>;
+        std::vector<Tuple> tuples;
+        tuples.reserve(src.size());
+        for (const RamDomain* data : src) {
+            tuples.push_back(this->constructTuple(data));
+        }
+        static_cast<DeleteIndex*>(main)->eraseAll(tuples);
+        for (std::size_t i = 1; i < indexes.size(); ++i) {
+            if (built[i]) {
+                static_cast<DeleteIndex*>(indexes[i].get())->eraseAll(tuples);
+            }
+        }
+    }
+
+    void insert(const RamDomain* data) override {
+        insertTuple(this->constructTuple(data));
+    }
+
+    void insertBuffers(const std::vector<const std::vector<RamDomain>*>& buffers) override {
+        if (!isLattice()) {
+            Relation<_Arity, BtreeDelete>::insertBuffers(buffers);
+            return;
+        }
+        for (const auto& tuple : this->collectBuffers(buffers)) {
+            insertTuple(tuple);
+        }
+    }
+
+    void load(ReadStream& reader) override {
+        if (!isLattice()) {
+            Relation<_Arity, BtreeDelete>::load(reader);
+            return;
+        }
+        reader.readAll(*this);
+    }
+
+    /**
+     * Make this relation a lattice relation, keeping the best tuple of each key with respect to the
+     * given order. The key is searched on the index at the given position, which starts with it.
+     */
+    void setLattice(BinaryConstraintOp op, std::size_t indexPos) {
+        latticeOp = op;
+        latticeIndex = indexPos;
+    }
+
+    /**
+     * Check whether this relation is a lattice relation.
+     */
+    bool isLattice() const {
+        return latticeOp.has_value();
+    }
+
+    /**
+     * Add the given tuple to this relation, replacing the tuple with the same key of a lattice
+     * relation if the given tuple is better, and dropping the given tuple otherwise.
+     */
+    bool insertTuple(const Tuple& tuple) {
+        if (!isLattice()) {
+            return Relation<_Arity, BtreeDelete>::insert(tuple);
+        }
+        // parallel insertions must not interleave between the search and the replacement
+        std::lock_guard<std::mutex> guard(latticeLock);
+        const auto& index = *indexes[latticeIndex];
+        Tuple low = index.getOrder().encode(tuple);
+        Tuple high = low;
+        low[_Arity - 1] = MIN_RAM_SIGNED;
+        high[_Arity - 1] = MAX_RAM_SIGNED;
+        const auto current = index.range(low, high);
+        if (!current.empty()) {
+            const Tuple old = index.getOrder().decode(*current.begin());
+            if (!isBetter(tuple[_Arity - 1], old[_Arity - 1])) {
+                return false;
+            }
+            erase(old);
+        }
+        return Relation<_Arity, BtreeDelete>::insert(tuple);
+    }
+
+protected:
+    /** Whether the first value is better than the second one with respect to the lattice order */
+    bool isBetter(RamDomain a, RamDomain b) const {
+        switch (*latticeOp) {
+            case BinaryConstraintOp::LT: return a < b;
+            case BinaryConstraintOp::ULT: return ramBitCast<RamUnsigned>(a) < ramBitCast<RamUnsigned>(b);
+            case BinaryConstraintOp::FLT: return ramBitCast<RamFloat>(a) < ramBitCast<RamFloat>(b);
+            case BinaryConstraintOp::GT: return a > b;
+            case BinaryConstraintOp::UGT: return ramBitCast<RamUnsigned>(a) > ramBitCast<RamUnsigned>(b);
+            case BinaryConstraintOp::FGT: return ramBitCast<RamFloat>(a) > ramBitCast<RamFloat>(b);
+            default: fatal("unsupported lattice order");
+        }
+    }
+
+    // the order of the last attribute of a lattice relation
+    std::optional<BinaryConstraintOp> latticeOp;
+
+    // the position of the index starting with the key of a lattice relation
+    std::size_t latticeIndex = 0;
+
+    // serialises insertions into a lattice relation
+    std::mutex latticeLock;
 };
 
+/**
+ * Add the given tuple to the given relation, keeping the best tuple of each key of lattice relations.
+ */
+template <typename Rel>
+bool insertTuple(Rel& rel, const typename Rel::Tuple& tuple) {
+    if constexpr (std::is_same_v<Rel, Relation<Rel::Arity, BtreeDelete>>) {
+        return static_cast<BtreeDeleteRelation<Rel::Arity>&>(rel).insertTuple(tuple);
+    } else {
+        return rel.insert(tuple);
+    }
+}
+
 class EqrelRelation : public Relation<2, Eqrel> {
 public:
     using Relation<2, Eqrel>::Relation;
@@ -457,6 +1055,10 @@ Own<RelationWrapper> createProvenanceRelation(
 Own<RelationWrapper> createBrieRelation(
         const ram::Relation& id, const ram::analysis::IndexCluster& indexSelection);
 
+// A factory for b-tree relations of a dynamic arity, for relations too wide for a relation of a fixed arity.
+Own<RelationWrapper> createDynamicRelation(
+        const ram::Relation& id, const ram::analysis::IndexCluster& indexSelection);
+
 // A factory for Eqrel index.
 Own<RelationWrapper> createEqrelRelation(
         const ram::Relation& id, const ram::analysis::IndexCluster& indexSelection);
@@ -0,0 +1,168 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TableCompactor.cpp
+ *
+ * Define the TableCompactor class.
+ ***********************************************************************/
+
+#include "interpreter/TableCompactor.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cassert>
+#include <utility>
+
+namespace souffle::interpreter {
+
+TableCompactor::TableCompactor(const std::string& types, const SymbolTable& symbols,
+        const RecordTable& records, SymbolTable& newSymbols, RecordTable& newRecords)
+        : symbols(symbols), records(records), newSymbols(newSymbols), newRecords(newRecords) {
+    std::string error;
+    this->types = json11::Json::parse(types, error);
+    if (!error.empty()) {
+        fatal("invalid type definitions: %s", error);
+    }
+}
+
+TableCompactor::ValueType& TableCompactor::getType(const std::string& qualifier) {
+    auto pos = namedTypes.find(qualifier);
+    if (pos != namedTypes.end()) {
+        return pos->second;
+    }
+    // register the type before its fields, which may refer to it
+    ValueType& type = namedTypes[qualifier];
+    switch (qualifier[0]) {
+        case 's': type.kind = ValueType::Symbol; break;
+        case 'r': {
+            type.kind = ValueType::Record;
+            const auto& recordInfo = types["records"][qualifier];
+            if (recordInfo.is_null()) {
+                fatal("missing record type information: %s", qualifier);
+            }
+            for (const auto& field : recordInfo["types"].array_items()) {
+                type.fields.push_back(&getType(field.string_value()));
+            }
+            break;
+        }
+        case '+': {
+            type.kind = ValueType::ADT;
+            const auto& adtInfo = types["ADTs"][qualifier];
+            if (adtInfo.is_null()) {
+                fatal("missing ADT information: %s", qualifier);
+            }
+            type.isEnum = adtInfo["enum"].bool_value();
+            for (const auto& branch : adtInfo["branches"].array_items()) {
+                const auto& arguments = branch["types"].array_items();
+                if (arguments.size() == 1) {
+                    type.branches.push_back(&getType(arguments[0].string_value()));
+                    continue;
+                }
+                ValueType& argumentsType = branchTypes.emplace_back();
+                argumentsType.kind = ValueType::Record;
+                for (const auto& argument : arguments) {
+                    argumentsType.fields.push_back(&getType(argument.string_value()));
+                }
+                type.branches.push_back(&argumentsType);
+            }
+            break;
+        }
+        default: break;
+    }
+    return type;
+}
+
+std::size_t TableCompactor::arityOf(const ValueType& type) {
+    // a branch of an ADT is represented by the record [branch index, payload]
+    return type.kind == ValueType::ADT ? 2 : type.fields.size();
+}
+
+TableCompactor::ValueType& TableCompactor::fieldType(
+        const ValueType& type, std::size_t field, const RamDomain* data) {
+    if (type.kind == ValueType::Record) {
+        return *type.fields[field];
+    }
+    if (field == 0) {
+        return plainType;
+    }
+    assert(static_cast<std::size_t>(data[0]) < type.branches.size() && "invalid ADT branch");
+    return *type.branches[data[0]];
+}
+
+bool TableCompactor::isReference(RamDomain value, const ValueType& type) {
+    // references 0 are nil records, and branches of ADTs without arguments are not records
+    return (type.kind == ValueType::Record && value != 0) ||
+           (type.kind == ValueType::ADT && !type.isEnum && !isUnboxedBranch(value));
+}
+
+RamDomain TableCompactor::translateScalar(RamDomain value, const ValueType& type) {
+    if (type.kind != ValueType::Symbol) {
+        return value;
+    }
+    const auto index = static_cast<std::size_t>(value);
+    if (index >= translatedSymbols.size()) {
+        translatedSymbols.resize(index + 1, -1);
+    }
+    RamDomain& translation = translatedSymbols[index];
+    if (translation == -1) {
+        translation = newSymbols.encode(symbols.decode(value));
+    }
+    return translation;
+}
+
+void TableCompactor::push(RamDomain ref, ValueType& type) {
+    const std::size_t arity = arityOf(type);
+    frames.push_back({&type, ref, records.unpack(ref, arity), arity, 0, values.size()});
+}
+
+RamDomain TableCompactor::translate(RamDomain value, ValueType& type) {
+    if (!isReference(value, type)) {
+        return translateScalar(value, type);
+    }
+    auto pos = type.translated.find(value);
+    if (pos != type.translated.end()) {
+        return pos->second;
+    }
+
+    push(value, type);
+    RamDomain result = 0;
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.next == frame.arity) {
+            // all fields are translated
+            result = newRecords.pack(values.data() + frame.offset, frame.arity);
+            frame.type->translated.emplace(frame.ref, result);
+            values.resize(frame.offset);
+            frames.pop_back();
+            if (!frames.empty()) {
+                values.push_back(result);
+                ++frames.back().next;
+            }
+            continue;
+        }
+
+        const RamDomain field = frame.data[frame.next];
+        ValueType& type = fieldType(*frame.type, frame.next, frame.data);
+        if (!isReference(field, type)) {
+            values.push_back(translateScalar(field, type));
+            ++frame.next;
+            continue;
+        }
+        auto pos = type.translated.find(field);
+        if (pos != type.translated.end()) {
+            values.push_back(pos->second);
+            ++frame.next;
+        } else {
+            // invalidates the frame reference
+            push(field, type);
+        }
+    }
+    return result;
+}
+
+}  // namespace souffle::interpreter
@@ -0,0 +1,126 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TableCompactor.h
+ *
+ * Declares the TableCompactor class, copying the symbols and records
+ * reachable from the relations into fresh tables.
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/json11.h"
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace souffle::interpreter {
+
+/**
+ * @class TableCompactor
+ * @brief Translates values into fresh symbol and record tables
+ *
+ * Symbols are encoded in the fresh symbol table, and records are packed in
+ * the fresh record table once their fields are translated, such that the
+ * fresh tables only hold what the translated values refer to. Records are
+ * traversed with an explicit stack, since recursive types such as lists nest
+ * arbitrarily deep. The translations of records are memoised per type, since
+ * the same record may be referred to through different types.
+ */
+class TableCompactor {
+public:
+    /** The type of a value, determining how it is translated */
+    struct ValueType {
+        enum Kind { Plain, Symbol, Record, ADT };
+
+        Kind kind = Plain;
+
+        /** Types of the fields of a record */
+        std::vector<ValueType*> fields;
+
+        /** Types of the payload of each branch of an ADT: its argument, or the record of its arguments */
+        std::vector<ValueType*> branches;
+
+        /** An ADT of branches without arguments is represented by the branch index */
+        bool isEnum = false;
+
+        /** Translated references of the records of this type */
+        std::unordered_map<RamDomain, RamDomain> translated;
+    };
+
+    /**
+     * @param types record and ADT types, in the format of the "types" IO directive
+     */
+    TableCompactor(const std::string& types, const SymbolTable& symbols, const RecordTable& records,
+            SymbolTable& newSymbols, RecordTable& newRecords);
+
+    /** Return the type of the given type qualifier, e.g. "r:List" */
+    ValueType& getType(const std::string& qualifier);
+
+    /** Return the value translated into the fresh tables */
+    RamDomain translate(RamDomain value, ValueType& type);
+
+private:
+    /** A record whose fields are being translated */
+    struct Frame {
+        ValueType* type;
+        RamDomain ref;
+        const RamDomain* data;
+        std::size_t arity;
+        /** Index of the next field to translate */
+        std::size_t next;
+        /** Offset of the translated fields in the values stack */
+        std::size_t offset;
+    };
+
+    /** Return the number of fields of a record of the given type */
+    static std::size_t arityOf(const ValueType& type);
+
+    /** Return the type of a field of a record of the given type */
+    ValueType& fieldType(const ValueType& type, std::size_t field, const RamDomain* data);
+
+    /** Return true if a value of the given type refers to a record */
+    static bool isReference(RamDomain value, const ValueType& type);
+
+    /** Return the translation of a value not referring to a record */
+    RamDomain translateScalar(RamDomain value, const ValueType& type);
+
+    /** Push the record of the given reference onto the stack of records being translated */
+    void push(RamDomain ref, ValueType& type);
+
+    json11::Json types;
+    const SymbolTable& symbols;
+    const RecordTable& records;
+    SymbolTable& newSymbols;
+    RecordTable& newRecords;
+
+    /** Types by qualifier */
+    std::map<std::string, ValueType> namedTypes;
+
+    /** Types of the argument records of ADT branches */
+    std::deque<ValueType> branchTypes;
+
+    ValueType plainType;
+
+    /** Translated symbol indices, -1 if not yet translated */
+    std::vector<RamDomain> translatedSymbols;
+
+    std::vector<Frame> frames;
+
+    std::vector<RamDomain> values;
+};
+
+}  // namespace souffle::interpreter
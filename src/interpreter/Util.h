@@ -23,6 +23,11 @@
 #include "souffle/datastructure/EquivalenceRelation.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <type_traits>
 
 namespace souffle::interpreter {
 // clang-format off
@@ -58,7 +63,8 @@ namespace souffle::interpreter {
     func(Provenance, 29, __VA_ARGS__)  \
     func(Provenance, 30, __VA_ARGS__)
 
-
+// Operations on b-trees and tries are instantiated for the small arities of most relations only; wider
+// relations are b-trees of a dynamic arity, whose operations are instantiated once (see MAX_FIXED_ARITY).
 #define FOR_EACH_BTREE(func, ...)\
     func(Btree, 0, __VA_ARGS__) \
     func(Btree, 1, __VA_ARGS__) \
@@ -68,19 +74,10 @@ namespace souffle::interpreter {
     func(Btree, 5, __VA_ARGS__) \
     func(Btree, 6, __VA_ARGS__) \
     func(Btree, 7, __VA_ARGS__) \
-    func(Btree, 8, __VA_ARGS__) \
-    func(Btree, 9, __VA_ARGS__) \
-    func(Btree, 10, __VA_ARGS__) \
-    func(Btree, 11, __VA_ARGS__) \
-    func(Btree, 12, __VA_ARGS__) \
-    func(Btree, 13, __VA_ARGS__) \
-    func(Btree, 14, __VA_ARGS__) \
-    func(Btree, 15, __VA_ARGS__) \
-    func(Btree, 16, __VA_ARGS__) \
-    func(Btree, 17, __VA_ARGS__) \
-    func(Btree, 18, __VA_ARGS__) \
-    func(Btree, 19, __VA_ARGS__) \
-    func(Btree, 20, __VA_ARGS__)
+    func(Btree, 8, __VA_ARGS__)
+
+#define FOR_EACH_BTREE_DYNAMIC(func, ...)\
+    func(Btree, Dynamic, __VA_ARGS__)
 
 #define FOR_EACH_BTREE_DELETE(func, ...)\
     func(BtreeDelete, 1, __VA_ARGS__) \
@@ -104,35 +101,23 @@ namespace souffle::interpreter {
     func(BtreeDelete, 19, __VA_ARGS__) \
     func(BtreeDelete, 20, __VA_ARGS__)
 
-// Brie is disabled for now.
-#define FOR_EACH_BRIE(func, ...)
-    /* func(Brie, 0, __VA_ARGS__) \ */
-    /* func(Brie, 1, __VA_ARGS__) \ */
-    /* func(Brie, 2, __VA_ARGS__) \ */
-    /* func(Brie, 3, __VA_ARGS__) \ */
-    /* func(Brie, 4, __VA_ARGS__) \ */
-    /* func(Brie, 5, __VA_ARGS__) \ */
-    /* func(Brie, 6, __VA_ARGS__) \ */
-    /* func(Brie, 7, __VA_ARGS__) \ */
-    /* func(Brie, 8, __VA_ARGS__) \ */
-    /* func(Brie, 9, __VA_ARGS__) \ */
-    /* func(Brie, 10, __VA_ARGS__) \ */
-    /* func(Brie, 11, __VA_ARGS__) \ */
-    /* func(Brie, 12, __VA_ARGS__) \ */
-    /* func(Brie, 13, __VA_ARGS__) \ */
-    /* func(Brie, 14, __VA_ARGS__) \ */
-    /* func(Brie, 15, __VA_ARGS__) \ */
-    /* func(Brie, 16, __VA_ARGS__) \ */
-    /* func(Brie, 17, __VA_ARGS__) \ */
-    /* func(Brie, 18, __VA_ARGS__) \ */
-    /* func(Brie, 19, __VA_ARGS__) \ */
-    /* func(Brie, 20, __VA_ARGS__)   */
+#define FOR_EACH_BRIE(func, ...)\
+    func(Brie, 0, __VA_ARGS__) \
+    func(Brie, 1, __VA_ARGS__) \
+    func(Brie, 2, __VA_ARGS__) \
+    func(Brie, 3, __VA_ARGS__) \
+    func(Brie, 4, __VA_ARGS__) \
+    func(Brie, 5, __VA_ARGS__) \
+    func(Brie, 6, __VA_ARGS__) \
+    func(Brie, 7, __VA_ARGS__) \
+    func(Brie, 8, __VA_ARGS__)
 
 #define FOR_EACH_EQREL(func, ...)\
     func(Eqrel, 2, __VA_ARGS__)
 
 #define FOR_EACH(func, ...)                 \
     FOR_EACH_BTREE(func, __VA_ARGS__)       \
+    FOR_EACH_BTREE_DYNAMIC(func, __VA_ARGS__)       \
     FOR_EACH_BTREE_DELETE(func, __VA_ARGS__)       \
     FOR_EACH_BRIE(func, __VA_ARGS__)        \
     FOR_EACH_PROVENANCE(func, __VA_ARGS__)  \
@@ -140,6 +125,12 @@ namespace souffle::interpreter {
 
 // clang-format on
 
+/** The largest arity of b-tree and trie relations whose tuples are of a fixed size at compile time */
+constexpr std::size_t MAX_FIXED_ARITY = 8;
+
+/** The arity of relations whose tuples are rows of the arity of the relation, only known at runtime */
+constexpr std::size_t Dynamic = std::numeric_limits<std::size_t>::max();
+
 /**
  * A namespace enclosing utilities required by indices.
  */
@@ -244,13 +235,62 @@ using comparator = typename index_utils::get_full_index<Arity>::type::comparator
 template <std::size_t Arity>
 using prov_comparator = typename index_utils::get_full_prov_index<Arity>::type::comparator;
 
+// The search strategy for B-tree nodes: nodes of narrow tuples are searched with vectorised
+// comparisons, as the comparator orders tuples in the natural order of their columns.
+template <std::size_t Arity>
+using search_strategy =
+        std::conditional_t<(Arity > 0 && Arity <= 4), detail::vector_search, detail::binary_search>;
+
 // Alias for btree_set
 template <std::size_t Arity>
-using Btree = btree_set<t_tuple<Arity>, comparator<Arity>>;
+using Btree = btree_set<t_tuple<Arity>, comparator<Arity>, std::allocator<t_tuple<Arity>>,
+        detail::default_block_size<t_tuple<Arity>>::value, search_strategy<Arity>>;
+
+/**
+ * A tuple of a relation of a dynamic arity, referring to the row of its values held by its index.
+ */
+struct DynamicRow {
+    const RamDomain* values = nullptr;
+
+    const RamDomain* data() const {
+        return values;
+    }
+
+    RamDomain operator[](std::size_t i) const {
+        return values[i];
+    }
+};
+
+/**
+ * The comparator of the rows of an index of a dynamic arity. The rows are stored in the order of their
+ * index, hence they are compared column by column.
+ */
+struct DynamicComparator {
+    std::size_t arity = 0;
+
+    int operator()(const DynamicRow& a, const DynamicRow& b) const {
+        for (std::size_t i = 0; i < arity; ++i) {
+            if (a.values[i] != b.values[i]) {
+                return a.values[i] < b.values[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+    bool less(const DynamicRow& a, const DynamicRow& b) const {
+        return (*this)(a, b) < 0;
+    }
+    bool equal(const DynamicRow& a, const DynamicRow& b) const {
+        return std::equal(a.values, a.values + arity, b.values);
+    }
+};
+
+// Alias for the btree_set of the rows of an index of a dynamic arity
+using DynamicBtree = btree_set<DynamicRow, DynamicComparator>;
 
 // Alias for btree_set
 template <std::size_t Arity>
-using BtreeDelete = btree_delete_set<t_tuple<Arity>, comparator<Arity>>;
+using BtreeDelete = btree_delete_set<t_tuple<Arity>, comparator<Arity>, std::allocator<t_tuple<Arity>>,
+        detail::default_block_size<t_tuple<Arity>>::value, search_strategy<Arity>>;
 
 // Alias for Trie
 template <std::size_t Arity>
@@ -267,7 +307,8 @@ struct ProvenanceUpdater {
 
 // Alias for Provenance
 template <std::size_t Arity>
-using Provenance = btree_set<t_tuple<Arity>, prov_comparator<Arity>, std::allocator<t_tuple<Arity>>, 256,
+using Provenance = btree_set<t_tuple<Arity>, prov_comparator<Arity>, std::allocator<t_tuple<Arity>>,
+        detail::default_block_size<t_tuple<Arity>>::value,
         typename detail::default_strategy<t_tuple<Arity>>::type, comparator<Arity - 2>,
         ProvenanceUpdater<Arity>>;
 
@@ -81,6 +81,16 @@ public:
         viewInfoForNested.push_back({relId, indexPos, viewPos});
     }
 
+    /** @brief Return the indexes built on demand that are searched by the query */
+    std::vector<std::array<std::size_t, 2>>& getOnDemandIndexes() {
+        return onDemandIndexes;
+    }
+
+    /** @brief Add an index built on demand that is searched by the query */
+    void addOnDemandIndex(std::size_t relId, std::size_t indexPos) {
+        onDemandIndexes.push_back({relId, indexPos});
+    }
+
     /** If this context has information for parallel operation.  */
     bool isParallel = false;
 
@@ -95,6 +105,8 @@ private:
     std::vector<std::array<std::size_t, 3>> viewInfoForFilter;
     /** Vector of View information in nested operations */
     std::vector<std::array<std::size_t, 3>> viewInfoForNested;
+    /** Vector of relations and positions of the indexes built on demand */
+    std::vector<std::array<std::size_t, 2>> onDemandIndexes;
 };
 
 }  // namespace souffle::interpreter
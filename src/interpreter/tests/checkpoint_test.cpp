@@ -0,0 +1,151 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file checkpoint_test.cpp
+ *
+ * Tests the checkpoints written between strata, and the evaluations resumed from them.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "Pipelines.h"
+#include "ast/Program.h"
+#include "ast/TranslationUnit.h"
+#include "ast/transform/PragmaChecker.h"
+#include "ast2ram/TranslationStrategy.h"
+#include "ast2ram/UnitTranslator.h"
+#include "ast2ram/seminaive/TranslationStrategy.h"
+#include "ast2ram/utility/TranslatorContext.h"
+#include "interpreter/Engine.h"
+#include "interpreter/ProgInterface.h"
+#include "parser/ParserDriver.h"
+#include "ram/TranslationUnit.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/SouffleInterface.h"
+#include "souffle/io/Checkpoint.h"
+#include "souffle/utility/FileUtil.h"
+#include <cstddef>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <utility>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+// the symbols and records of the later strata are created by the earlier ones
+const std::string program = R"(
+    .decl edge(x:symbol, y:symbol)
+    edge(cat("n", to_string(i)), cat("n", to_string(i + 1))) :- i = range(0, 40).
+
+    .decl path(x:symbol, y:symbol)
+    path(x, y) :- edge(x, y).
+    path(x, z) :- path(x, y), edge(y, z).
+
+    .type Pair = [x:symbol, y:symbol]
+    .decl pair(p:Pair)
+    pair([x, y]) :- path(x, y), strlen(x) = strlen(y).
+
+    .decl reach(x:symbol, n:number)
+    .output reach(IO=file, filename="/dev/null")
+    reach(x, n) :- pair([x, _]), n = count : { pair([x, _]) }.
+)";
+
+/** A program translated as by souffle, and the engine evaluating it */
+class Program {
+public:
+    Program() {
+        auto unit = ParserDriver::parseTranslationUnit(program, errReport, debugReport);
+        mk<ast::transform::PragmaChecker>()->apply(*unit);
+        makeAstTransformer()->apply(*unit);
+        auto translationStrategy =
+                mk<ast2ram::TranslationStrategy, ast2ram::seminaive::TranslationStrategy>();
+        auto unitTranslator = Own<ast2ram::UnitTranslator>(translationStrategy->createUnitTranslator());
+        ramTranslationUnit = unitTranslator->translateUnit(*unit);
+        makeRamTransformer()->apply(*ramTranslationUnit);
+        engine = mk<Engine>(*ramTranslationUnit);
+        prog = mk<ProgInterface>(*engine);
+    }
+
+    /** The tuples of reach */
+    std::set<std::pair<std::string, RamDomain>> getReach() {
+        std::set<std::pair<std::string, RamDomain>> res;
+        for (auto& t : *prog->getRelation("reach")) {
+            std::string x;
+            RamDomain n;
+            t >> x >> n;
+            res.emplace(x, n);
+        }
+        return res;
+    }
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    Own<ram::TranslationUnit> ramTranslationUnit;
+    Own<Engine> engine;
+    Own<ProgInterface> prog;
+};
+
+}  // namespace
+
+TEST(Checkpoint, Resume) {
+    Global::config().set("jobs", "1");
+    std::set<std::pair<std::string, RamDomain>> expected;
+    {
+        Program full;
+        full.prog->run();
+        expected = full.getReach();
+    }
+    EXPECT_EQ(40, expected.size());
+
+    const std::string dir = tempFile();
+    std::remove(dir.c_str());
+    EXPECT_TRUE(mkdir(dir.c_str(), 0755) == 0);
+
+    // the evaluation is cancelled after the second stratum, keeping the checkpoint of the strata
+    // completed until then
+    Global::config().set("checkpoint-dir", dir);
+    {
+        Program cancelled;
+        std::size_t strata = 0;
+        cancelled.prog->setStratumCallback([&](std::size_t) {
+            if (++strata == 2) {
+                cancelled.prog->cancel();
+            }
+        });
+        cancelled.prog->run();
+        EXPECT_EQ(0, cancelled.getReach().size());
+    }
+    Global::config().unset("checkpoint-dir");
+    const auto marker = checkpoint::readMarker(dir);
+    EXPECT_TRUE(marker.has_value());
+    EXPECT_TRUE(marker->step + 1 < marker->steps);
+    for (const std::string& file : marker->files) {
+        EXPECT_TRUE(existFile(file));
+    }
+
+    // a new process restores the tables and the relations, and evaluates the remaining strata
+    Global::config().set("resume-from", dir);
+    {
+        Program resumed;
+        resumed.prog->run();
+        EXPECT_TRUE(expected == resumed.getReach());
+    }
+    Global::config().unset("resume-from");
+
+    execStdOut(("rm -rf '" + dir + "'").c_str());
+}
+
+}  // namespace souffle::interpreter::test
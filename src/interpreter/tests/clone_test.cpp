@@ -0,0 +1,143 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file clone_test.cpp
+ *
+ * Tests the copies of incremental interpreter programs.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "RelationTag.h"
+#include "interpreter/Engine.h"
+#include "interpreter/ProgInterface.h"
+#include "ram/Call.h"
+#include "ram/Expression.h"
+#include "ram/Insert.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SouffleInterface.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+Own<ram::Relation> makeRelation(const std::string& name) {
+    return mk<ram::Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE);
+}
+
+/** A program copying the edges into the paths in a stratum of its own */
+Own<ram::TranslationUnit> makeProgram(ErrorReport& errReport, DebugReport& debugReport) {
+    VecOwn<ram::Relation> rels;
+    rels.push_back(makeRelation("edge"));
+    rels.push_back(makeRelation("path"));
+
+    VecOwn<ram::Expression> values;
+    values.push_back(mk<ram::TupleElement>(0, 0));
+    values.push_back(mk<ram::TupleElement>(0, 1));
+    std::map<std::string, Own<ram::Statement>> subs;
+    subs["stratum_0"] = mk<ram::Sequence>(
+            mk<ram::Query>(mk<ram::Scan>("edge", 0, mk<ram::Insert>("path", std::move(values)))));
+
+    return mk<ram::TranslationUnit>(
+            mk<ram::Program>(std::move(rels), mk<ram::Sequence>(mk<ram::Call>("stratum_0")), std::move(subs)),
+            errReport, debugReport);
+}
+
+void insertEdge(SouffleProgram& prog, RamDomain from, RamDomain to) {
+    souffle::Relation* edge = prog.getRelation("edge");
+    tuple t(edge);
+    t << from << to;
+    edge->insert(t);
+}
+
+std::size_t countPaths(SouffleProgram& prog) {
+    return prog.getRelation("path")->size();
+}
+
+}  // namespace
+
+TEST(Clone, Independent) {
+    Global::config().set("jobs", "1");
+    Global::config().set("incremental");
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto translationUnit = makeProgram(errReport, debugReport);
+    Engine engine(*translationUnit);
+    engine.executeMain();
+    ProgInterface prog(engine);
+
+    insertEdge(prog, 1, 2);
+    insertEdge(prog, 2, 3);
+    prog.run();
+    EXPECT_EQ(2, countPaths(prog));
+
+    auto copy = prog.clone();
+    EXPECT_TRUE(copy != nullptr);
+    EXPECT_EQ(2, countPaths(*copy));
+
+    // the changes of the copy are not visible to the original
+    insertEdge(*copy, 3, 4);
+    copy->run();
+    EXPECT_EQ(3, countPaths(*copy));
+    EXPECT_EQ(2, countPaths(prog));
+
+    // and vice versa
+    insertEdge(prog, 5, 6);
+    insertEdge(prog, 6, 7);
+    prog.run();
+    EXPECT_EQ(4, countPaths(prog));
+    EXPECT_EQ(3, countPaths(*copy));
+    EXPECT_EQ(3, copy->getRelation("edge")->size());
+
+    // copies of copies share the relations as well
+    auto copyOfCopy = copy->clone();
+    EXPECT_TRUE(copyOfCopy != nullptr);
+    prog.getRelation("edge")->purge();
+    prog.run();
+    EXPECT_EQ(0, countPaths(prog));
+    EXPECT_EQ(3, countPaths(*copy));
+    EXPECT_EQ(3, countPaths(*copyOfCopy));
+
+    Global::config().unset("incremental");
+}
+
+TEST(Clone, NotIncremental) {
+    Global::config().set("jobs", "1");
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto translationUnit = makeProgram(errReport, debugReport);
+    Engine engine(*translationUnit);
+    engine.executeMain();
+    ProgInterface prog(engine);
+    EXPECT_TRUE(prog.clone() == nullptr);
+}
+
+}  // namespace souffle::interpreter::test
@@ -0,0 +1,150 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file embedded_program_test.cpp
+ *
+ * Tests the programs loaded by the interpreter at runtime.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "interpreter/EmbeddedProgram.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SouffleInterface.h"
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+const std::string transitiveClosure = R"(
+    .decl edge(x:number, y:number)
+    .input edge(IO=file, filename="/dev/null")
+    .decl path(x:number, y:number)
+    .output path(IO=file, filename="/dev/null")
+    path(x, y) :- edge(x, y).
+    path(x, z) :- path(x, y), edge(y, z).
+)";
+
+void insertEdge(SouffleProgram& prog, RamDomain from, RamDomain to) {
+    souffle::Relation* edge = prog.getRelation("edge");
+    tuple t(edge);
+    t << from << to;
+    edge->insert(t);
+}
+
+std::size_t countPaths(SouffleProgram& prog) {
+    return prog.getRelation("path")->size();
+}
+
+}  // namespace
+
+TEST(EmbeddedProgram, Rerun) {
+    auto prog = EmbeddedProgram::fromSource(transitiveClosure);
+    EXPECT_TRUE(prog->getRelation("edge") != nullptr);
+    prog->run();
+    EXPECT_EQ(0, countPaths(*prog));
+
+    insertEdge(*prog, 1, 2);
+    insertEdge(*prog, 2, 3);
+    prog->run();
+    EXPECT_EQ(3, countPaths(*prog));
+
+    // the facts of the next request replace those of the last
+    prog->getRelation("edge")->purge();
+    insertEdge(*prog, 3, 4);
+    prog->run();
+    EXPECT_EQ(1, countPaths(*prog));
+
+    Global::config().unset("incremental");
+}
+
+TEST(EmbeddedProgram, OnlyRelations) {
+    auto prog = EmbeddedProgram::fromSource(transitiveClosure + R"(
+        .decl source(x:number)
+        source(x) :- edge(x, _), !edge(_, x).
+    )");
+    insertEdge(*prog, 1, 2);
+    insertEdge(*prog, 2, 3);
+
+    // the stratum of source is skipped until a run needs it
+    prog->run({"path"});
+    EXPECT_EQ(3, countPaths(*prog));
+    EXPECT_EQ(0, prog->getRelation("source")->size());
+    prog->run();
+    EXPECT_EQ(1, prog->getRelation("source")->size());
+
+    bool thrown = false;
+    try {
+        prog->run({"unknown"});
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    Global::config().unset("incremental");
+}
+
+TEST(EmbeddedProgram, Cancel) {
+    auto prog = EmbeddedProgram::fromSource(transitiveClosure);
+    for (RamDomain i = 0; i < 100; ++i) {
+        insertEdge(*prog, i, i + 1);
+    }
+
+    // the evaluation is cancelled once the edges are loaded, before their paths are derived
+    prog->setStratumCallback([&](std::size_t) { prog->cancel(); });
+    EXPECT_FALSE(prog->runAsync().get());
+    EXPECT_EQ(100, prog->getRelation("edge")->size());
+    EXPECT_EQ(0, countPaths(*prog));
+
+    // the strata skipped by a cancelled evaluation are evaluated by the next run
+    prog->setStratumCallback(nullptr);
+    EXPECT_TRUE(prog->runAsync().get());
+    EXPECT_EQ(5050, countPaths(*prog));
+
+    insertEdge(*prog, 100, 101);
+    prog->setDeadline(std::chrono::steady_clock::now());
+    EXPECT_FALSE(prog->runAsync().get());
+    EXPECT_EQ(101, prog->getRelation("edge")->size());
+    EXPECT_EQ(5050, countPaths(*prog));
+
+    prog->setDeadline(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    EXPECT_TRUE(prog->runAsync().get());
+    EXPECT_EQ(5151, countPaths(*prog));
+
+    Global::config().unset("incremental");
+}
+
+TEST(EmbeddedProgram, Errors) {
+    bool thrown = false;
+    try {
+        EmbeddedProgram::fromSource(".decl r(x:number)\n r(x) :- s(x).\n");
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    thrown = false;
+    try {
+        EmbeddedProgram::fromFile("/nonexistent/program.dl");
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    Global::config().unset("incremental");
+}
+
+}  // namespace souffle::interpreter::test
@@ -0,0 +1,158 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file incremental_test.cpp
+ *
+ * Tests the re-runs of the interpreter in incremental mode.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "RelationTag.h"
+#include "interpreter/Engine.h"
+#include "interpreter/ProgInterface.h"
+#include "ram/Call.h"
+#include "ram/Expression.h"
+#include "ram/Insert.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SouffleInterface.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+Own<ram::Relation> makeRelation(const std::string& name) {
+    return mk<ram::Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE);
+}
+
+/** A stratum copying the relation into another */
+Own<ram::Statement> makeCopy(const std::string& from, const std::string& to) {
+    VecOwn<ram::Expression> values;
+    values.push_back(mk<ram::TupleElement>(0, 0));
+    values.push_back(mk<ram::TupleElement>(0, 1));
+    return mk<ram::Sequence>(mk<ram::Query>(mk<ram::Scan>(from, 0, mk<ram::Insert>(to, std::move(values)))));
+}
+
+/** A program of two strata, copying a into copyA and b into copyB */
+Own<ram::TranslationUnit> makeProgram(ErrorReport& errReport, DebugReport& debugReport) {
+    VecOwn<ram::Relation> rels;
+    for (const std::string name : {"a", "b", "copyA", "copyB"}) {
+        rels.push_back(makeRelation(name));
+    }
+    std::map<std::string, Own<ram::Statement>> subs;
+    subs["stratum_0"] = makeCopy("a", "copyA");
+    subs["stratum_1"] = makeCopy("b", "copyB");
+    return mk<ram::TranslationUnit>(mk<ram::Program>(std::move(rels),
+                                            mk<ram::Sequence>(mk<ram::Call>("stratum_0"),
+                                                    mk<ram::Call>("stratum_1")),
+                                            std::move(subs)),
+            errReport, debugReport);
+}
+
+void insertPair(SouffleProgram& prog, const std::string& name, RamDomain x, RamDomain y) {
+    souffle::Relation* rel = prog.getRelation(name);
+    tuple t(rel);
+    t << x << y;
+    rel->insert(t);
+}
+
+}  // namespace
+
+TEST(Incremental, Rerun) {
+    Global::config().set("jobs", "1");
+    Global::config().set("incremental");
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto translationUnit = makeProgram(errReport, debugReport);
+    Engine engine(*translationUnit);
+    ProgInterface prog(engine);
+    prog.run();
+    EXPECT_EQ(0, prog.getRelation("copyA")->size());
+
+    // each run derives the tuples of the relations changed since the last one
+    insertPair(prog, "a", 1, 2);
+    prog.run();
+    EXPECT_EQ(1, prog.getRelation("copyA")->size());
+    EXPECT_EQ(0, prog.getRelation("copyB")->size());
+
+    insertPair(prog, "b", 3, 4);
+    insertPair(prog, "b", 5, 6);
+    prog.run();
+    EXPECT_EQ(1, prog.getRelation("copyA")->size());
+    EXPECT_EQ(2, prog.getRelation("copyB")->size());
+
+    // the tuples derived from purged ones are purged as well
+    prog.getRelation("a")->purge();
+    insertPair(prog, "a", 7, 8);
+    prog.run();
+    EXPECT_EQ(1, prog.getRelation("copyA")->size());
+    EXPECT_TRUE(prog.getRelation("copyA")->contains(tuple(prog.getRelation("copyA"), {7, 8})));
+    EXPECT_EQ(2, prog.getRelation("copyB")->size());
+
+    Global::config().unset("incremental");
+}
+
+TEST(Incremental, Inserted) {
+    Global::config().set("jobs", "1");
+    Global::config().set("incremental");
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto translationUnit = makeProgram(errReport, debugReport);
+    Engine engine(*translationUnit);
+    ProgInterface prog(engine);
+    souffle::Relation* copyA = prog.getRelation("copyA");
+
+    // the tuples inserted into a derived relation are kept when its stratum is evaluated again
+    insertPair(prog, "copyA", 9, 9);
+    insertPair(prog, "a", 1, 2);
+    prog.run();
+    EXPECT_EQ(2, copyA->size());
+
+    insertPair(prog, "a", 3, 4);
+    prog.run();
+    EXPECT_EQ(3, copyA->size());
+    EXPECT_TRUE(copyA->contains(tuple(copyA, {9, 9})));
+
+    prog.getRelation("a")->purge();
+    prog.run();
+    EXPECT_EQ(1, copyA->size());
+    EXPECT_TRUE(copyA->contains(tuple(copyA, {9, 9})));
+
+    // until the relation is purged through the interface
+    copyA->purge();
+    insertPair(prog, "a", 5, 6);
+    prog.run();
+    EXPECT_EQ(1, copyA->size());
+    EXPECT_TRUE(copyA->contains(tuple(copyA, {5, 6})));
+
+    Global::config().unset("incremental");
+}
+
+}  // namespace souffle::interpreter::test
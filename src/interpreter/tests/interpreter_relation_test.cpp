@@ -16,14 +16,21 @@
 
 #include "tests/test.h"
 
+#include "interpreter/Context.h"
 #include "interpreter/ProgInterface.h"
 #include "interpreter/Relation.h"
 #include "ram/analysis/Index.h"
 #include "souffle/SouffleInterface.h"
 #include "souffle/SymbolTable.h"
+#include "souffle/io/ReadStreamCSV.h"
+#include <algorithm>
 #include <iosfwd>
+#include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace souffle::interpreter::test {
 
@@ -146,6 +153,50 @@ TEST(Basic, Iteration) {
     EXPECT_EQ(4, count);
 }
 
+TEST(Batch, InsertScan) {
+    SymbolTable symbolTable;
+
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(2);
+    SearchSet searches = {existenceCheck};
+    LexOrder fullOrder = {0, 1};
+    OrderCollection orders = {fullOrder};
+    mapping.insert({existenceCheck, fullOrder});
+    IndexCluster indexSelection(mapping, searches, orders);
+
+    Relation<2, interpreter::Btree> rel(0, "test", indexSelection);
+    RelInterface relInt(rel, symbolTable, "test", {"i", "i"}, {"x", "y"}, 0);
+
+    // insert the tuples (i, 2i), with a duplicate
+    const std::size_t N = 1000;
+    std::vector<RamDomain> tuples;
+    for (std::size_t i = 0; i < N; ++i) {
+        tuples.push_back(RamDomain(i));
+        tuples.push_back(RamDomain(2 * i));
+    }
+    tuples.push_back(0);
+    tuples.push_back(0);
+    relInt.insertBatch(tuples, N + 1);
+    EXPECT_EQ(N, relInt.size());
+    EXPECT_TRUE(relInt.contains(tuple(&relInt, {7, 14})));
+
+    // scan in batches of 300 tuples, the last one partial
+    std::vector<std::size_t> sizes;
+    std::size_t next = 0;
+    relInt.scanBatch(
+            [&](span<const RamDomain> batch, std::size_t n) {
+                EXPECT_EQ(2 * n, batch.size());
+                for (std::size_t i = 0; i < n; ++i, ++next) {
+                    EXPECT_EQ(RamDomain(next), batch[2 * i]);
+                    EXPECT_EQ(RamDomain(2 * next), batch[2 * i + 1]);
+                }
+                sizes.push_back(n);
+            },
+            300);
+    EXPECT_EQ(N, next);
+    EXPECT_EQ((std::vector<std::size_t>{300, 300, 300, 100}), sizes);
+}
+
 TEST(Independence, Iteration) {
     // create a table
     SymbolTable symbolTable;
@@ -287,4 +338,501 @@ TEST(Reordering, Iteration) {
     }
 }
 
+TEST(BulkInsert, Reordering) {
+    // copy a relation into a relation with a different index order
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(3);
+    SearchSet searches = {existenceCheck};
+    LexOrder defaultOrder = {0, 1, 2};
+    LexOrder reverseOrder = {2, 1, 0};
+    OrderCollection defaultOrders = {defaultOrder};
+    OrderCollection reverseOrders = {reverseOrder, defaultOrder};
+    IndexCluster defaultSelection(mapping, searches, defaultOrders);
+    IndexCluster reverseSelection(mapping, searches, reverseOrders);
+
+    Relation<3, interpreter::Btree> src(0, "src", defaultSelection);
+    Relation<3, interpreter::Btree> trg(0, "trg", reverseSelection);
+    for (RamDomain i = 0; i < 100; ++i) {
+        src.insert(souffle::Tuple<RamDomain, 3>{i, i + 1, i % 7});
+    }
+    trg.insert(souffle::Tuple<RamDomain, 3>{5, 6, 5});
+    trg.insert(souffle::Tuple<RamDomain, 3>{-1, -1, -1});
+
+    trg.insert(src);
+    EXPECT_EQ(101, trg.size());
+    EXPECT_EQ(101, trg.getIndex(1)->size());
+
+    // For-each should give decoded tuples.
+    std::size_t matches = 0;
+    for (const RamDomain* t : static_cast<RelationWrapper&>(trg)) {
+        if (t[0] < 0 || (t[1] == t[0] + 1 && t[2] == t[0] % 7)) {
+            ++matches;
+        }
+    }
+    EXPECT_EQ(101, matches);
+}
+
+TEST(BulkInsert, LargeMerge) {
+    // merge sources smaller and larger than the target, into indexes of the same and of another order
+    SignatureOrderMap mapping;
+    SearchSet searches = {SearchSignature::getFullSearchSignature(2)};
+    OrderCollection orders = {LexOrder{0, 1}, LexOrder{1, 0}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    using Rel = Relation<2, interpreter::Btree>;
+
+    Rel trg(0, "trg", indexSelection);
+    for (RamDomain i = 0; i < 50000; ++i) {
+        trg.insert(souffle::Tuple<RamDomain, 2>{i, -i});
+    }
+    // a smaller source, half of which is in the target
+    Rel small(0, "small", indexSelection);
+    for (RamDomain i = 40000; i < 60000; ++i) {
+        small.insert(souffle::Tuple<RamDomain, 2>{i, -i});
+    }
+    trg.insert(small);
+    EXPECT_EQ(60000, trg.size());
+    EXPECT_EQ(60000, trg.getIndex(1)->size());
+
+    // a larger source, which interleaves with the target
+    Rel large(0, "large", indexSelection);
+    for (RamDomain i = 0; i < 100000; ++i) {
+        large.insert(souffle::Tuple<RamDomain, 2>{i, i % 2 == 0 ? -i : i});
+    }
+    trg.insert(large);
+    EXPECT_EQ(130000, trg.size());
+    EXPECT_EQ(130000, trg.getIndex(1)->size());
+    EXPECT_TRUE(trg.contains(souffle::Tuple<RamDomain, 2>{59999, -59999}));
+    EXPECT_TRUE(trg.contains(souffle::Tuple<RamDomain, 2>{99999, 99999}));
+    EXPECT_FALSE(trg.contains(souffle::Tuple<RamDomain, 2>{100000, -100000}));
+
+    // both indexes enumerate their tuples in their order
+    std::size_t sorted = 0;
+    for (std::size_t idx = 0; idx < 2; ++idx) {
+        const auto& index = *trg.getIndex(idx);
+        sorted += std::is_sorted(index.begin(), index.end(), [](const auto& a, const auto& b) {
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+        });
+    }
+    EXPECT_EQ(2, sorted);
+}
+
+TEST(BulkInsert, Buffers) {
+    // insert the buffers of threads into an empty relation, and smaller and larger batches of them into
+    // a relation that is not empty, into indexes of the same and of another order
+    SignatureOrderMap mapping;
+    SearchSet searches = {SearchSignature::getFullSearchSignature(2)};
+    OrderCollection orders = {LexOrder{0, 1}, LexOrder{1, 0}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    using Rel = Relation<2, interpreter::Btree>;
+
+    Rel rel(0, "rel", indexSelection);
+    for (RamDomain count : {1000, 500, 40000, 20000}) {
+        // the buffers of the threads overlap
+        std::vector<std::vector<RamDomain>> buffers(4);
+        for (RamDomain i = 0; i < count; ++i) {
+            auto& buffer = buffers[i % 3];
+            buffer.push_back(count - i);
+            buffer.push_back(-i);
+            buffers[3].push_back(count - i);
+            buffers[3].push_back(-i);
+        }
+        std::vector<const std::vector<RamDomain>*> pointers;
+        for (const auto& buffer : buffers) {
+            pointers.push_back(&buffer);
+        }
+        static_cast<RelationWrapper&>(rel).insertBuffers(pointers);
+    }
+    EXPECT_EQ(61500, rel.size());
+    EXPECT_EQ(61500, rel.getIndex(1)->size());
+    EXPECT_TRUE(rel.contains(souffle::Tuple<RamDomain, 2>{500, 0}));
+    EXPECT_TRUE(rel.contains(souffle::Tuple<RamDomain, 2>{1, -39999}));
+    EXPECT_TRUE(rel.contains(souffle::Tuple<RamDomain, 2>{1, -19999}));
+    EXPECT_FALSE(rel.contains(souffle::Tuple<RamDomain, 2>{0, 0}));
+
+    std::size_t sorted = 0;
+    for (std::size_t idx = 0; idx < 2; ++idx) {
+        const auto& index = *rel.getIndex(idx);
+        sorted += std::is_sorted(index.begin(), index.end(), [](const auto& a, const auto& b) {
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+        });
+    }
+    EXPECT_EQ(2, sorted);
+}
+
+TEST(BulkErase, Reordering) {
+    // erase small and large batches from a relation with two index orders
+    SignatureOrderMap mapping;
+    SearchSet searches = {SearchSignature::getFullSearchSignature(2)};
+    OrderCollection orders = {LexOrder{0, 1}, LexOrder{1, 0}};
+    IndexCluster indexSelection(mapping, searches, orders);
+
+    BtreeDeleteRelation<2> trg(0, "trg", indexSelection);
+    for (RamDomain i = 0; i < 10000; ++i) {
+        const souffle::Tuple<RamDomain, 2> tuple{i, -i};
+        trg.insert(tuple.data());
+    }
+
+    // a small batch, some of which is not in the target
+    Relation<2, interpreter::Btree> small(0, "small", indexSelection);
+    for (RamDomain i = 9990; i < 10010; ++i) {
+        small.insert(souffle::Tuple<RamDomain, 2>{i, -i});
+    }
+    trg.eraseAll(small);
+    EXPECT_EQ(9990, trg.size());
+    EXPECT_EQ(9990, trg.getIndex(1)->size());
+
+    // a large batch of every other tuple
+    Relation<2, interpreter::Btree> large(0, "large", indexSelection);
+    for (RamDomain i = 0; i < 10000; i += 2) {
+        large.insert(souffle::Tuple<RamDomain, 2>{i, -i});
+    }
+    trg.eraseAll(large);
+    EXPECT_EQ(4995, trg.size());
+    EXPECT_EQ(4995, trg.getIndex(1)->size());
+    EXPECT_TRUE(trg.contains(souffle::Tuple<RamDomain, 2>{1, -1}));
+    EXPECT_FALSE(trg.contains(souffle::Tuple<RamDomain, 2>{2, -2}));
+    EXPECT_FALSE(trg.contains(souffle::Tuple<RamDomain, 2>{9991, -9991}));
+
+    std::size_t matches = 0;
+    for (const RamDomain* t : static_cast<RelationWrapper&>(trg)) {
+        if (t[0] % 2 == 1 && t[1] == -t[0]) {
+            ++matches;
+        }
+    }
+    EXPECT_EQ(4995, matches);
+}
+
+TEST(Load, SortedBuild) {
+    // load unordered input with duplicates into a relation with two index orders
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(3);
+    SearchSet searches = {existenceCheck};
+    LexOrder reverseOrder = {2, 1, 0};
+    LexOrder defaultOrder = {0, 1, 2};
+    OrderCollection orders = {reverseOrder, defaultOrder};
+    IndexCluster indexSelection(mapping, searches, orders);
+    Relation<3, interpreter::Btree> rel(0, "rel", indexSelection);
+
+    const RamDomain N = 10000;
+    std::stringstream input;
+    for (RamDomain i = 0; i < N; ++i) {
+        const RamDomain x = (i * 7919) % N;
+        input << x << "\t" << x + 1 << "\t" << x % 7 << "\n";
+        if (i % 10 == 0) {
+            input << x << "\t" << x + 1 << "\t" << x % 7 << "\n";
+        }
+    }
+    std::map<std::string, std::string> rwOperation = {
+            {"types", R"({"relation": {"arity": 3, "types": ["i:number", "i:number", "i:number"]}})"}};
+    SymbolTable symbolTable;
+    SpecializedRecordTable<0> recordTable;
+    ReadStreamCSV reader(input, rwOperation, symbolTable, recordTable);
+    rel.load(reader);
+
+    EXPECT_EQ(N, rel.size());
+    EXPECT_EQ(N, rel.getIndex(1)->size());
+
+    // the main index is ordered by the last column first
+    RamDomain previous = -1;
+    std::size_t matches = 0;
+    for (const RamDomain* t : static_cast<RelationWrapper&>(rel)) {
+        EXPECT_TRUE(previous <= t[2]);
+        previous = t[2];
+        if (t[1] == t[0] + 1 && t[2] == t[0] % 7) {
+            ++matches;
+        }
+    }
+    EXPECT_EQ(N, matches);
+}
+
+TEST(OnDemand, BuildIndex) {
+    // the second index is only built by the first search on it
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(3);
+    SearchSet searches = {existenceCheck};
+    LexOrder defaultOrder = {0, 1, 2};
+    LexOrder reverseOrder = {2, 1, 0};
+    OrderCollection orders = {defaultOrder, reverseOrder};
+    IndexCluster indexSelection(mapping, searches, orders);
+    indexSelection.setOnDemand(1);
+    Relation<3, interpreter::Btree> rel(0, "rel", indexSelection);
+
+    for (RamDomain i = 0; i < 100; ++i) {
+        rel.insert(souffle::Tuple<RamDomain, 3>{i, i + 1, i % 7});
+    }
+    EXPECT_EQ(100, rel.size());
+    EXPECT_EQ(0, rel.getIndex(1)->size());
+
+    rel.buildIndex(1);
+    EXPECT_EQ(100, rel.getIndex(1)->size());
+    EXPECT_TRUE(rel.contains(1, {5, 6, 5}, {5, 6, 5}));
+
+    // once built, the index is maintained on insertion
+    rel.insert(souffle::Tuple<RamDomain, 3>{-1, -1, -1});
+    EXPECT_EQ(101, rel.getIndex(1)->size());
+    EXPECT_TRUE(rel.contains(1, {-1, -1, -1}, {-1, -1, -1}));
+
+    // until the relation is purged
+    rel.purge();
+    rel.insert(souffle::Tuple<RamDomain, 3>{1, 2, 3});
+    EXPECT_EQ(1, rel.size());
+    EXPECT_EQ(0, rel.getIndex(1)->size());
+}
+
+TEST(OnDemand, ReleaseIndexes) {
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(2);
+    SearchSet searches = {existenceCheck};
+    OrderCollection orders = {LexOrder{0, 1}, LexOrder{1, 0}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    indexSelection.setOnDemand(1);
+    Relation<2, interpreter::Btree> rel(0, "rel", indexSelection);
+    for (RamDomain i = 0; i < 1000; ++i) {
+        rel.insert(souffle::Tuple<RamDomain, 2>{i, -i});
+    }
+    EXPECT_EQ(0, rel.releaseIndexes());
+
+    rel.buildIndex(1);
+    const std::size_t bytes = rel.getIndexMemory(1).bytes;
+    EXPECT_EQ(bytes, rel.releaseIndexes());
+    EXPECT_EQ(0, rel.getIndex(1)->size());
+    EXPECT_LT(rel.getIndexMemory(1).bytes, bytes);
+
+    // the index is not maintained until it is built again, with all tuples
+    rel.insert(souffle::Tuple<RamDomain, 2>{-1, 1});
+    EXPECT_EQ(0, rel.getIndex(1)->size());
+    rel.buildIndex(1);
+    EXPECT_EQ(1001, rel.getIndex(1)->size());
+    EXPECT_EQ(1001, rel.size());
+}
+
+TEST(OnDemand, BuildIndexes) {
+    // all indexes built on demand are built at once, by concurrent threads
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(3);
+    SearchSet searches = {existenceCheck};
+    OrderCollection orders = {LexOrder{0, 1, 2}, LexOrder{2, 1, 0}, LexOrder{1, 0, 2}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    indexSelection.setOnDemand(1);
+    indexSelection.setOnDemand(2);
+    Relation<3, interpreter::Btree> rel(0, "rel", indexSelection);
+    for (RamDomain i = 0; i < 1000; ++i) {
+        rel.insert(souffle::Tuple<RamDomain, 3>{i, i % 13, -i});
+    }
+    EXPECT_EQ(0, rel.getIndex(1)->size());
+    EXPECT_EQ(0, rel.getIndex(2)->size());
+
+    rel.buildIndexes();
+    EXPECT_EQ(1000, rel.getIndex(1)->size());
+    EXPECT_EQ(1000, rel.getIndex(2)->size());
+    // the bounds of a search are encoded in the order of the index
+    EXPECT_TRUE(rel.contains(1, {-5, 5, 5}, {-5, 5, 5}));
+    EXPECT_TRUE(rel.contains(2, {5, 5, -5}, {5, 5, -5}));
+
+    // building them again has no effect, and the built indexes are maintained on insertion
+    rel.buildIndexes();
+    rel.insert(souffle::Tuple<RamDomain, 3>{-1, -1, -1});
+    EXPECT_EQ(1001, rel.getIndex(1)->size());
+    EXPECT_EQ(1001, rel.getIndex(2)->size());
+}
+
+TEST(FindPrimary, Annotations) {
+    SymbolTable symbolTable;
+
+    // a relation of two primary and two auxiliary attributes, e.g., provenance annotations
+    for (const LexOrder& fullOrder : {LexOrder{1, 0, 3, 2}, LexOrder{2, 0, 1, 3}}) {
+        SignatureOrderMap mapping;
+        SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(4);
+        SearchSet searches = {existenceCheck};
+        OrderCollection orders = {fullOrder};
+        mapping.insert({existenceCheck, fullOrder});
+        IndexCluster indexSelection(mapping, searches, orders);
+
+        Relation<4, interpreter::Btree> rel(2, "test", indexSelection);
+        for (const auto& tuple : std::vector<souffle::Tuple<RamDomain, 4>>{
+                     {5, 6, 1, 2}, {5, 7, 3, 4}, {6, 6, 0, 1}, {-5, -7, -1, -2}}) {
+            rel.insert(tuple);
+        }
+
+        // the first order finds tuples by a search of the index, the second one by a scan
+        RelInterface relInt(rel, symbolTable, "test", {"i", "i", "i", "i"}, {"a", "b", "c", "d"}, 0);
+        std::vector<RamDomain> buffer = {5, 7, 0, 0};
+        EXPECT_TRUE(relInt.findPrimary(buffer));
+        EXPECT_EQ((std::vector<RamDomain>{5, 7, 3, 4}), buffer);
+
+        buffer = {-5, -7, 0, 0};
+        EXPECT_TRUE(relInt.findPrimary(buffer));
+        EXPECT_EQ((std::vector<RamDomain>{-5, -7, -1, -2}), buffer);
+
+        buffer = {6, 5, 0, 0};
+        EXPECT_FALSE(relInt.findPrimary(buffer));
+        buffer = {7, 7, 0, 0};
+        EXPECT_FALSE(relInt.findPrimary(buffer));
+    }
+}
+
+TEST(Dynamic, Relation) {
+    constexpr std::size_t arity = 12;
+    SignatureOrderMap mapping;
+    SearchSet searches = {SearchSignature::getFullSearchSignature(arity)};
+    OrderCollection orders = {
+            LexOrder{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, LexOrder{11, 1, 0, 2, 3, 4, 5, 6, 7, 8, 9, 10}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    using Rel = Relation<Dynamic, interpreter::Btree>;
+    Rel rel(arity, 0, "rel", indexSelection);
+    EXPECT_EQ(arity, rel.getArity());
+
+    std::vector<RamDomain> tuple(arity);
+    for (RamDomain i = 0; i < 1000; ++i) {
+        for (std::size_t j = 0; j < arity; ++j) {
+            tuple[j] = i * static_cast<RamDomain>(j);
+        }
+        tuple[arity - 1] = i % 10;
+        rel.insert(tuple.data());
+        // duplicates are not stored again
+        rel.insert(tuple.data());
+    }
+    EXPECT_EQ(1000, rel.size());
+    EXPECT_TRUE(rel.contains(tuple.data()));
+    tuple[1] = -1;
+    EXPECT_FALSE(rel.contains(tuple.data()));
+
+    // the second index is ordered by the last column first
+    auto view = rel.createView(1);
+    auto& index = *Rel::castView(view.get());
+    auto low = Rel::makeTuple(arity);
+    auto high = Rel::makeTuple(arity);
+    std::fill(low.begin(), low.end(), MIN_RAM_SIGNED);
+    std::fill(high.begin(), high.end(), MAX_RAM_SIGNED);
+    low[0] = high[0] = 3;
+    std::size_t count = 0;
+    for (const auto& row : index.range(low, high)) {
+        EXPECT_EQ(3, row[0]);
+        EXPECT_EQ(0, row[1] % 10 - 3);
+        ++count;
+    }
+    EXPECT_EQ(100, count);
+    EXPECT_EQ(100, index.count(low, high));
+
+    // tuples are decoded into the order of their attributes
+    std::size_t scanned = 0;
+    for (const RamDomain* cur : rel) {
+        EXPECT_EQ(cur[1] % 10, cur[arity - 1]);
+        ++scanned;
+    }
+    EXPECT_EQ(1000, scanned);
+
+    std::size_t partitioned = 0;
+    for (const auto& part : rel.partitionScan(8)) {
+        partitioned += std::distance(part.begin(), part.end());
+    }
+    EXPECT_EQ(1000, partitioned);
+
+    Rel copy(arity, 0, "copy", indexSelection);
+    copy.insert(rel);
+    EXPECT_EQ(1000, copy.size());
+    EXPECT_EQ(100, Rel::castView(copy.createView(1).get())->count(low, high));
+
+    rel.__recycle();
+    EXPECT_TRUE(rel.empty());
+    rel.insert(tuple.data());
+    EXPECT_EQ(1, rel.size());
+}
+
+TEST(Brie, PrefixSearch) {
+    SignatureOrderMap mapping;
+    SearchSet searches = {SearchSignature::getFullSearchSignature(3)};
+    OrderCollection orders = {LexOrder{0, 1, 2}, LexOrder{2, 0, 1}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    using Rel = Relation<3, interpreter::Brie>;
+    Rel rel(0, "rel", indexSelection);
+    for (RamDomain i = -50; i < 50; ++i) {
+        for (RamDomain j = 0; j < 10; ++j) {
+            rel.insert(souffle::Tuple<RamDomain, 3>{i, j, i * j}.data());
+        }
+    }
+    EXPECT_EQ(1000, rel.size());
+    auto countAll = [](const auto& range) { return std::distance(range.begin(), range.end()); };
+
+    // negative values are not ordered before positive ones by tries, so only prefixes are searched
+    auto view = rel.createView(0);
+    auto& trie = *Rel::castView(view.get());
+    souffle::Tuple<RamDomain, 3> low{-3, MIN_RAM_SIGNED, MIN_RAM_SIGNED};
+    souffle::Tuple<RamDomain, 3> high{-3, MAX_RAM_SIGNED, MAX_RAM_SIGNED};
+    std::size_t count = 0;
+    for (const auto& tuple : trie.range(low, high)) {
+        EXPECT_EQ(-3, tuple[0]);
+        ++count;
+    }
+    EXPECT_EQ(10, count);
+    EXPECT_EQ(10, trie.count(low, high));
+    low[1] = high[1] = 4;
+    EXPECT_EQ(1, trie.count(low, high));
+    EXPECT_TRUE(trie.contains(souffle::Tuple<RamDomain, 3>{-3, 4, -12}));
+    EXPECT_FALSE(trie.contains(souffle::Tuple<RamDomain, 3>{-3, 4, 12}));
+
+    // the second index is ordered by the last column first
+    souffle::Tuple<RamDomain, 3> zero{0, MIN_RAM_SIGNED, MIN_RAM_SIGNED};
+    souffle::Tuple<RamDomain, 3> zeroHigh{0, MAX_RAM_SIGNED, MAX_RAM_SIGNED};
+    EXPECT_EQ(109, countAll(rel.getIndex(1)->range(zero, zeroHigh)));
+
+    std::size_t scanned = 0;
+    for (const auto& part : rel.partitionScan(8)) {
+        scanned += countAll(part);
+    }
+    EXPECT_EQ(1000, scanned);
+
+    // bulk insertions merge the tries
+    Rel copy(0, "copy", indexSelection);
+    copy.insert(rel);
+    EXPECT_EQ(1000, copy.size());
+    EXPECT_EQ(109, countAll(copy.getIndex(1)->range(zero, zeroHigh)));
+}
+
+TEST(Context, ReuseViews) {
+    SignatureOrderMap mapping;
+    SearchSignature existenceCheck = SearchSignature::getFullSearchSignature(2);
+    SearchSet searches = {existenceCheck};
+    OrderCollection orders = {LexOrder{0, 1}};
+    IndexCluster indexSelection(mapping, searches, orders);
+    using Rel = Relation<2, interpreter::Btree>;
+    Rel current(0, "rel", indexSelection);
+    Rel next(0, "new_rel", indexSelection);
+    for (RamDomain i = 0; i < 1000; ++i) {
+        current.insert(souffle::Tuple<RamDomain, 2>{i, -i});
+    }
+
+    Context ctxt;
+    ctxt.createView(current, 0, 3);
+    ViewWrapper* view = ctxt.getView(3);
+    EXPECT_TRUE(Rel::castView(view)->contains(souffle::Tuple<RamDomain, 2>{5, -5}));
+
+    // the views of both relations of a slot are kept, as for the relations swapped by a fixpoint
+    ctxt.createView(current, 0, 3);
+    EXPECT_EQ(view, ctxt.getView(3));
+    ctxt.createView(next, 0, 3);
+    EXPECT_NE(view, ctxt.getView(3));
+    EXPECT_FALSE(Rel::castView(ctxt.getView(3))->contains(souffle::Tuple<RamDomain, 2>{5, -5}));
+    ctxt.createView(current, 0, 3);
+    EXPECT_EQ(view, ctxt.getView(3));
+
+    // a view outlives the nodes it searched, with its hints dropped
+    current.purge();
+    current.insert(souffle::Tuple<RamDomain, 2>{7, -7});
+    ctxt.createView(current, 0, 3);
+    EXPECT_EQ(view, ctxt.getView(3));
+    EXPECT_FALSE(Rel::castView(view)->contains(souffle::Tuple<RamDomain, 2>{5, -5}));
+    EXPECT_TRUE(Rel::castView(view)->contains(souffle::Tuple<RamDomain, 2>{7, -7}));
+
+    // the contexts of threads are retained with their views
+    ctxt.reserveThreadContexts(2);
+    Context& thread = ctxt.getThreadContext(1);
+    thread.createView(current, 0, 0);
+    view = thread.getView(0);
+    ctxt.reserveThreadContexts(2);
+    EXPECT_EQ(&thread, &ctxt.getThreadContext(1));
+    thread.createView(current, 0, 0);
+    EXPECT_EQ(view, thread.getView(0));
+}
+
 }  // namespace souffle::interpreter::test
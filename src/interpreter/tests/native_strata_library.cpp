@@ -0,0 +1,121 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file native_strata_library.cpp
+ *
+ * A library of native strata as loaded by native_strata_test, evaluating
+ * the stratum of path(x, y) :- edge(x, y), x != "skip" and its transitive
+ * closure by hand.
+ *
+ ***********************************************************************/
+
+#include "souffle/NativeStrata.h"
+#include "souffle/RamTypes.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+
+namespace {
+
+using Pair = std::array<souffle::RamDomain, 2>;
+
+/** The relations of the library, by their names */
+struct Program {
+    std::map<std::string, std::set<Pair>> relations{{"edge", {}}, {"path", {}}};
+};
+
+/** The number of strata run by all programs */
+std::size_t runs = 0;
+
+}  // namespace
+
+extern "C" {
+
+const char* souffle_native_symbol(std::size_t index) {
+    return index == 0 ? "skip" : nullptr;
+}
+
+void* souffle_native_create(void*, void*, const char*, const char*, std::size_t) {
+    return new Program();
+}
+
+void souffle_native_destroy(void* program) {
+    delete static_cast<Program*>(program);
+}
+
+/** The strata of the edges, the paths and the further relations follow in this order */
+int souffle_native_provides(const char* stratum) {
+    return std::strcmp(stratum, "stratum_1") == 0 ? 1 : 0;
+}
+
+void souffle_native_run(void* program, const char*) {
+    auto& prog = *static_cast<Program*>(program);
+    ++runs;
+    auto& path = prog.relations["path"];
+    // the constant "skip" is encoded by the interpreter first
+    for (const Pair& edge : prog.relations["edge"]) {
+        if (edge[0] != 0) {
+            path.insert(edge);
+        }
+    }
+    for (std::size_t size = 0; size != path.size();) {
+        size = path.size();
+        for (const Pair& left : std::set<Pair>(path)) {
+            for (const Pair& right : prog.relations["edge"]) {
+                if (left[1] == right[0]) {
+                    path.insert({left[0], right[1]});
+                }
+            }
+        }
+    }
+}
+
+int souffle_native_insert(
+        void* program, const char* relation, const souffle::RamDomain* tuples, std::size_t count) {
+    auto& prog = *static_cast<Program*>(program);
+    auto it = prog.relations.find(relation);
+    if (it == prog.relations.end()) {
+        return 0;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        it->second.insert({tuples[2 * i], tuples[2 * i + 1]});
+    }
+    return 1;
+}
+
+int souffle_native_scan(void* program, const char* relation,
+        void (*visitor)(void* context, const souffle::RamDomain* tuple), void* context) {
+    auto& prog = *static_cast<Program*>(program);
+    auto it = prog.relations.find(relation);
+    if (it == prog.relations.end()) {
+        return 0;
+    }
+    for (const Pair& tuple : it->second) {
+        visitor(context, tuple.data());
+    }
+    return 1;
+}
+
+void souffle_native_purge(void* program, const char* relation) {
+    auto& prog = *static_cast<Program*>(program);
+    auto it = prog.relations.find(relation);
+    if (it != prog.relations.end()) {
+        it->second.clear();
+    }
+}
+
+/** Return the number of strata run by all programs, for the test loading the library */
+std::size_t native_strata_test_runs() {
+    return runs;
+}
+}
@@ -0,0 +1,123 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file native_strata_test.cpp
+ *
+ * Tests the evaluation of strata by a library of native strata, which is
+ * built from native_strata_library.cpp.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "Pipelines.h"
+#include "ast/Program.h"
+#include "ast/TranslationUnit.h"
+#include "ast/transform/PragmaChecker.h"
+#include "ast2ram/TranslationStrategy.h"
+#include "ast2ram/UnitTranslator.h"
+#include "ast2ram/seminaive/TranslationStrategy.h"
+#include "ast2ram/utility/TranslatorContext.h"
+#include "interpreter/Engine.h"
+#include "interpreter/ProgInterface.h"
+#include "parser/ParserDriver.h"
+#include "ram/TranslationUnit.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/SouffleInterface.h"
+#include <cstddef>
+#include <dlfcn.h>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+// the library evaluates the stratum of path, the interpreter the others
+const std::string program = R"(
+    .decl edge(x:symbol, y:symbol)
+    edge("a", "b").
+    edge("b", "c").
+    edge("c", "skip").
+    edge("skip", "d").
+
+    .decl path(x:symbol, y:symbol)
+    path(x, y) :- edge(x, y), x != "skip".
+    path(x, z) :- path(x, y), edge(y, z).
+
+    .decl far(x:symbol)
+    far(x) :- path(x, "d").
+)";
+
+/** The tuples of path and far */
+struct Result {
+    std::set<std::pair<std::string, std::string>> path;
+    std::set<std::string> far;
+
+    bool operator==(const Result& other) const {
+        return path == other.path && far == other.far;
+    }
+};
+
+Result derive() {
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto unit = ParserDriver::parseTranslationUnit(program, errReport, debugReport);
+    mk<ast::transform::PragmaChecker>()->apply(*unit);
+    makeAstTransformer()->apply(*unit);
+    auto translationStrategy = mk<ast2ram::TranslationStrategy, ast2ram::seminaive::TranslationStrategy>();
+    auto unitTranslator = Own<ast2ram::UnitTranslator>(translationStrategy->createUnitTranslator());
+    auto ramTranslationUnit = unitTranslator->translateUnit(*unit);
+    makeRamTransformer()->apply(*ramTranslationUnit);
+    Engine engine(*ramTranslationUnit);
+    ProgInterface prog(engine);
+    prog.run();
+
+    Result res;
+    for (auto& t : *prog.getRelation("path")) {
+        std::string x;
+        std::string y;
+        t >> x >> y;
+        res.path.emplace(x, y);
+    }
+    for (auto& t : *prog.getRelation("far")) {
+        std::string x;
+        t >> x;
+        res.far.insert(x);
+    }
+    return res;
+}
+
+}  // namespace
+
+TEST(NativeStrata, Library) {
+    Global::config().set("jobs", "1");
+    const Result expected = derive();
+    EXPECT_EQ(9, expected.path.size());
+    EXPECT_EQ(3, expected.far.size());
+
+    void* library = dlopen(NATIVE_STRATA_LIBRARY, RTLD_NOW | RTLD_LOCAL);
+    EXPECT_TRUE(library != nullptr);
+    auto runs = reinterpret_cast<std::size_t (*)()>(dlsym(library, "native_strata_test_runs"));
+    EXPECT_TRUE(runs != nullptr);
+
+    // the paths are derived by the library, with the symbols encoded by the interpreter
+    Global::config().set("native-library", NATIVE_STRATA_LIBRARY);
+    EXPECT_TRUE(expected == derive());
+    EXPECT_EQ(1, runs());
+    Global::config().unset("native-library");
+
+    dlclose(library);
+}
+
+}  // namespace souffle::interpreter::test
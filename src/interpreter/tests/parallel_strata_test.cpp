@@ -0,0 +1,300 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file parallel_strata_test.cpp
+ *
+ * Tests the evaluation of independent strata and of the loads of input relations by the threads of
+ * the interpreter, and the report of the rules they evaluated.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "Pipelines.h"
+#include "RelationTag.h"
+#include "ast/Program.h"
+#include "ast/TranslationUnit.h"
+#include "ast/transform/PragmaChecker.h"
+#include "ast2ram/TranslationStrategy.h"
+#include "ast2ram/UnitTranslator.h"
+#include "ast2ram/seminaive/TranslationStrategy.h"
+#include "ast2ram/utility/TranslatorContext.h"
+#include "interpreter/Engine.h"
+#include "interpreter/ProgInterface.h"
+#include "parser/ParserDriver.h"
+#include "ram/Call.h"
+#include "ram/DebugInfo.h"
+#include "ram/Expression.h"
+#include "ram/IO.h"
+#include "ram/Insert.h"
+#include "ram/Parallel.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/RamTypes.h"
+#include "souffle/SouffleInterface.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/FileUtil.h"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+constexpr RamDomain numEdges = 1000;
+
+Own<ram::Relation> makeRelation(const std::string& name) {
+    return mk<ram::Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE);
+}
+
+std::string copyName(std::size_t i) {
+    return "copy" + std::to_string(i);
+}
+
+/** A program copying the edges into a relation per stratum, whose strata are called by one block */
+Own<ram::TranslationUnit> makeProgram(
+        std::size_t numStrata, ErrorReport& errReport, DebugReport& debugReport) {
+    VecOwn<ram::Relation> rels;
+    rels.push_back(makeRelation("edge"));
+    VecOwn<ram::Statement> calls;
+    std::map<std::string, Own<ram::Statement>> subs;
+    for (std::size_t i = 0; i < numStrata; ++i) {
+        rels.push_back(makeRelation(copyName(i)));
+
+        VecOwn<ram::Expression> values;
+        values.push_back(mk<ram::TupleElement>(0, 0));
+        values.push_back(mk<ram::TupleElement>(0, 1));
+        auto query =
+                mk<ram::Query>(mk<ram::Scan>("edge", 0, mk<ram::Insert>(copyName(i), std::move(values))));
+        const std::string message = copyName(i) + "(x,y) :- \n   edge(x,y).\nin file test.dl [1:1-1:1]";
+        const std::string stratum = "stratum_" + std::to_string(i);
+        subs[stratum] = mk<ram::Sequence>(mk<ram::DebugInfo>(std::move(query), message));
+        calls.push_back(mk<ram::Call>(stratum));
+    }
+
+    return mk<ram::TranslationUnit>(
+            mk<ram::Program>(std::move(rels), mk<ram::Parallel>(std::move(calls)), std::move(subs)),
+            errReport, debugReport);
+}
+
+/** The sizes of the copies after an evaluation, and what it reported on the standard error */
+struct Result {
+    std::vector<std::size_t> sizes;
+    std::string report;
+};
+
+Result runStrata(std::size_t numStrata, bool verbose) {
+    Global::config().set("jobs", "4");
+    if (verbose) {
+        Global::config().set("verbose");
+    }
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto translationUnit = makeProgram(numStrata, errReport, debugReport);
+    Engine engine(*translationUnit);
+    ProgInterface prog(engine);
+    souffle::Relation* edge = prog.getRelation("edge");
+    for (RamDomain i = 0; i < numEdges; ++i) {
+        tuple t(edge);
+        t << i << i + 1;
+        edge->insert(t);
+    }
+
+    std::stringstream err;
+    auto* buf = std::cerr.rdbuf(err.rdbuf());
+    engine.executeMain();
+    std::cerr.rdbuf(buf);
+
+    Result result;
+    for (std::size_t i = 0; i < numStrata; ++i) {
+        result.sizes.push_back(prog.getRelation(copyName(i))->size());
+    }
+    result.report = err.str();
+
+    Global::config().unset("verbose");
+    Global::config().set("jobs", "1");
+    return result;
+}
+
+// the inputs read from files are loaded before the first stratum, the streamed one by its stratum
+const std::string loadingProgram = R"(
+    .decl a(x:symbol, y:symbol)
+    .input a
+    .decl b(x:symbol, y:symbol)
+    .input b
+    .decl c(x:symbol)
+    .input c
+    .decl d(x:symbol)
+    .input d(IO=stream, filename="d.facts")
+
+    .decl joined(x:symbol, z:symbol)
+    joined(x, z) :- a(x, y), b(y, z).
+    .decl both(x:symbol)
+    both(x) :- a(x, _), c(x), d(x).
+)";
+
+/** The relations loaded by each parallel block of the main program loading any, and the derived tuples */
+struct Loads {
+    std::vector<std::set<std::string>> parallel;
+    std::set<std::string> joined;
+    std::set<std::string> both;
+};
+
+Loads loadInputs(const std::string& jobs, const std::string& factDir) {
+    Global::config().set("jobs", jobs);
+    Global::config().set("fact-dir", factDir);
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto unit = ParserDriver::parseTranslationUnit(loadingProgram, errReport, debugReport);
+    mk<ast::transform::PragmaChecker>()->apply(*unit);
+    makeAstTransformer()->apply(*unit);
+    auto translationStrategy = mk<ast2ram::TranslationStrategy, ast2ram::seminaive::TranslationStrategy>();
+    auto unitTranslator = Own<ast2ram::UnitTranslator>(translationStrategy->createUnitTranslator());
+    auto ramTranslationUnit = unitTranslator->translateUnit(*unit);
+    makeRamTransformer()->apply(*ramTranslationUnit);
+
+    Loads loads;
+    visit(ramTranslationUnit->getProgram().getMain(), [&](const ram::Parallel& parallel) {
+        std::set<std::string> loaded;
+        visit(parallel, [&](const ram::IO& io) {
+            if (io.get("operation") == "input") {
+                loaded.insert(io.getRelation());
+            }
+        });
+        if (!loaded.empty()) {
+            loads.parallel.push_back(loaded);
+        }
+    });
+
+    Engine engine(*ramTranslationUnit);
+    ProgInterface prog(engine);
+    prog.run();
+    for (auto& t : *prog.getRelation("joined")) {
+        std::string x;
+        std::string z;
+        t >> x >> z;
+        loads.joined.insert(x + "," + z);
+    }
+    for (auto& t : *prog.getRelation("both")) {
+        std::string x;
+        t >> x;
+        loads.both.insert(x);
+    }
+
+    Global::config().unset("fact-dir");
+    Global::config().set("jobs", "1");
+    return loads;
+}
+
+}  // namespace
+
+TEST(ParallelStrata, Evaluation) {
+    for (int run = 0; run < 20; ++run) {
+        const auto result = runStrata(8, false);
+        for (std::size_t size : result.sizes) {
+            EXPECT_EQ(static_cast<std::size_t>(numEdges), size);
+        }
+    }
+}
+
+TEST(ParallelStrata, RuleStatistics) {
+    // the statistics of the rules are collected by one thread at a time, such that none is lost
+    for (int run = 0; run < 20; ++run) {
+        const auto result = runStrata(8, true);
+        for (std::size_t i = 0; i < 8; ++i) {
+            EXPECT_EQ(static_cast<std::size_t>(numEdges), result.sizes[i]);
+            const std::string line = " 1 evaluation(s): " + copyName(i) + "(x,y) :- \n";
+            EXPECT_TRUE(result.report.find(line) != std::string::npos);
+        }
+    }
+}
+
+TEST(ParallelStrata, HotRules) {
+    const auto result = runStrata(12, true);
+    const std::size_t start = result.report.find("Hot rules:\n");
+    EXPECT_TRUE(start != std::string::npos);
+
+    // the ten rules taking the most time are reported, in descending order of their time
+    std::stringstream lines(result.report.substr(start));
+    std::string line;
+    std::getline(lines, line);
+    std::size_t reported = 0;
+    long last = std::numeric_limits<long>::max();
+    while (std::getline(lines, line) && line.find("ms in 1 evaluation(s): copy") != std::string::npos) {
+        long time = std::stol(line);
+        EXPECT_TRUE(time <= last);
+        last = time;
+        ++reported;
+    }
+    EXPECT_EQ(10, reported);
+}
+
+TEST(ParallelStrata, Loads) {
+    const std::string dir = tempFile();
+    std::remove(dir.c_str());
+    EXPECT_TRUE(mkdir(dir.c_str(), 0755) == 0);
+    {
+        // the files share their symbols, which are encoded by the loading threads concurrently
+        std::ofstream a(dir + "/a.facts");
+        std::ofstream b(dir + "/b.facts");
+        std::ofstream c(dir + "/c.facts");
+        std::ofstream d(dir + "/d.facts");
+        for (int i = 0; i < 20000; ++i) {
+            a << "s" << i << "\tt" << i % 1000 << "\n";
+            if (i < 1000) {
+                b << "t" << i << "\ts" << i * 20 << "\n";
+            }
+            if (i % 2 == 0) {
+                c << "s" << i << "\n";
+            }
+            if (i % 3 == 0) {
+                d << "s" << i << "\n";
+            }
+        }
+    }
+
+    const Loads sequential = loadInputs("1", dir);
+    EXPECT_TRUE(sequential.parallel.empty());
+    EXPECT_EQ(20000, sequential.joined.size());
+    EXPECT_EQ(3334, sequential.both.size());
+
+    const Loads parallel = loadInputs("4", dir);
+    EXPECT_EQ(1, parallel.parallel.size());
+    EXPECT_TRUE(std::set<std::string>({"a", "b", "c"}) == parallel.parallel.front());
+    EXPECT_TRUE(sequential.joined == parallel.joined);
+    EXPECT_TRUE(sequential.both == parallel.both);
+
+    execStdOut(("rm -rf '" + dir + "'").c_str());
+}
+
+}  // namespace souffle::interpreter::test
@@ -19,6 +19,7 @@
 #include "Global.h"
 #include "RelationTag.h"
 #include "interpreter/Engine.h"
+#include "ram/Clear.h"
 #include "ram/Expression.h"
 #include "ram/IO.h"
 #include "ram/Insert.h"
@@ -38,6 +39,7 @@
 #include "souffle/utility/json11.h"
 #include <algorithm>
 #include <cstddef>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -375,6 +377,80 @@ TEST(IO_store, MixedTypes) {
     EXPECT_EQ(expected.str(), sout.str());
 }
 
+TEST(IO_spill, MixedTypes) {
+    Global::config().set("jobs", "1");
+
+    VecOwn<ram::Relation> rels;
+
+    std::vector<std::string> attribs{"t", "o", "f", "a"};
+
+    std::vector<std::string> attribsTypes{"i", "u", "f", "s"};
+
+    Own<ram::Relation> myrel =
+            mk<ram::Relation>("test", 4, 0, attribs, attribsTypes, RelationRepresentation::BTREE);
+
+    Json types = Json::object{
+            {"relation", Json::object{{"arity", static_cast<long long>(attribsTypes.size())},
+                                 {"types", Json::array(attribsTypes.begin(), attribsTypes.end())}}}};
+
+    std::map<std::string, std::string> spillDirs = {{"operation", "spill"}, {"IO", "spill"},
+            {"auxArity", "0"}, {"filename", "test.spill"}, {"name", "test"}, {"types", types.dump()}};
+    std::map<std::string, std::string> restoreDirs(spillDirs);
+    restoreDirs["operation"] = "restore";
+    std::map<std::string, std::string> writeDirs = {{"operation", "output"}, {"IO", "stdout"},
+            {"auxArity", "0"}, {"attributeNames", "x\ty"}, {"name", "test"}, {"types", types.dump()}};
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+
+    VecOwn<Expression> exprs;
+    RamFloat floatValue = 27.75;
+    exprs.push_back(mk<SignedConstant>(-3));
+    exprs.push_back(mk<SignedConstant>(ramBitCast(static_cast<RamUnsigned>(27))));
+    exprs.push_back(mk<SignedConstant>(ramBitCast(static_cast<RamFloat>(floatValue))));
+    exprs.push_back(mk<ram::StringConstant>("meow"));
+
+    Own<ram::Statement> main = mk<ram::Sequence>(mk<ram::Query>(mk<ram::Insert>("test", std::move(exprs))),
+            mk<ram::IO>("test", spillDirs), mk<ram::Clear>("test"), mk<ram::IO>("test", restoreDirs),
+            mk<ram::IO>("test", writeDirs));
+
+    rels.push_back(std::move(myrel));
+    std::map<std::string, Own<Statement>> subs;
+    Own<Program> prog = mk<Program>(std::move(rels), std::move(main), std::move(subs));
+
+    TranslationUnit translationUnit(std::move(prog), errReport, debugReport);
+
+    // configure and execute interpreter
+    Own<Engine> interpreter = mk<Engine>(translationUnit);
+
+    std::streambuf* oldCoutStreambuf = std::cout.rdbuf();
+    std::ostringstream sout;
+    std::cout.rdbuf(sout.rdbuf());
+
+    interpreter->executeMain();
+
+    std::cout.rdbuf(oldCoutStreambuf);
+
+    std::stringstream expected;
+    expected << std::setprecision(std::numeric_limits<RamFloat>::max_digits10);
+    expected << "---------------"
+             << "\n"
+             << "test"
+             << "\n"
+             << "==============="
+             << "\n"
+             << -3 << "\t" << 27 << "\t" << floatValue << "\t"
+             << "meow"
+             << "\n"
+             << "==============="
+             << "\n";
+
+    EXPECT_EQ(expected.str(), sout.str());
+
+    // the spill file is removed once the relation is restored
+    EXPECT_FALSE(std::ifstream("test.spill").good());
+}
+
 TEST(IO_load, Signed) {
     std::streambuf* backupCin = std::cin.rdbuf();
     std::istringstream testInput("5	3");
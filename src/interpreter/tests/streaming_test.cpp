@@ -0,0 +1,134 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file streaming_test.cpp
+ *
+ * Tests the evaluation of streaming inputs batch by batch, writing the changes of the outputs.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "Pipelines.h"
+#include "ast/Program.h"
+#include "ast/TranslationUnit.h"
+#include "ast/transform/PragmaChecker.h"
+#include "ast2ram/TranslationStrategy.h"
+#include "ast2ram/UnitTranslator.h"
+#include "ast2ram/seminaive/TranslationStrategy.h"
+#include "ast2ram/utility/TranslatorContext.h"
+#include "interpreter/Engine.h"
+#include "parser/ParserDriver.h"
+#include "ram/TranslationUnit.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/utility/FileUtil.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace souffle::interpreter::test {
+
+namespace {
+
+// sinks are retracted once the stream adds edges leaving them
+const std::string program = R"(
+    .decl edge(x:number, y:number)
+    .input edge(IO=stream, filename="edge.facts", batch-marker="--")
+
+    .decl path(x:number, y:number)
+    .output path
+    path(x, y) :- edge(x, y).
+    path(x, z) :- path(x, y), edge(y, z).
+
+    .decl sink(x:number)
+    .output sink
+    sink(y) :- edge(_, y), !edge(y, _).
+)";
+
+/** The sorted lines of a file, none if it does not exist */
+std::vector<std::string> readLines(const std::string& file) {
+    std::vector<std::string> res;
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line)) {
+        res.push_back(line);
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+}  // namespace
+
+TEST(Streaming, Batches) {
+    const std::string dir = tempFile();
+    std::remove(dir.c_str());
+    EXPECT_TRUE(mkdir(dir.c_str(), 0755) == 0);
+    {
+        // the last batch is ended by the end of the input
+        std::ofstream facts(dir + "/edge.facts");
+        facts << "1\t2\n--\n2\t3\n--\n--\n3\t1";
+    }
+    Global::config().set("jobs", "1");
+    Global::config().set("incremental");
+    Global::config().set("fact-dir", dir);
+    Global::config().set("output-dir", dir);
+
+    ErrorReport errReport;
+    DebugReport debugReport;
+    auto unit = ParserDriver::parseTranslationUnit(program, errReport, debugReport);
+    mk<ast::transform::PragmaChecker>()->apply(*unit);
+    makeAstTransformer()->apply(*unit);
+    auto translationStrategy = mk<ast2ram::TranslationStrategy, ast2ram::seminaive::TranslationStrategy>();
+    auto unitTranslator = Own<ast2ram::UnitTranslator>(translationStrategy->createUnitTranslator());
+    auto ramTranslationUnit = unitTranslator->translateUnit(*unit);
+    makeRamTransformer()->apply(*ramTranslationUnit);
+    Engine engine(*ramTranslationUnit);
+
+    using Lines = std::vector<std::string>;
+
+    // the first run reads the first batch, and writes the outputs in full
+    engine.executeMain();
+    EXPECT_TRUE(Lines({"1\t2"}) == readLines(dir + "/path.csv"));
+    EXPECT_TRUE(Lines({"2"}) == readLines(dir + "/sink.csv"));
+
+    // the added tuples are appended, and the removed ones written to the retracted outputs
+    EXPECT_TRUE(engine.readNextBatch());
+    engine.executeMain();
+    EXPECT_TRUE(Lines({"1\t2", "1\t3", "2\t3"}) == readLines(dir + "/path.csv"));
+    EXPECT_TRUE(Lines({"2", "3"}) == readLines(dir + "/sink.csv"));
+    EXPECT_TRUE(Lines({"2"}) == readLines(dir + "/sink.csv.retracted"));
+    EXPECT_TRUE(Lines() == readLines(dir + "/path.csv.retracted"));
+
+    // an empty batch changes nothing
+    EXPECT_TRUE(engine.readNextBatch());
+    engine.executeMain();
+    EXPECT_EQ(3, readLines(dir + "/path.csv").size());
+    EXPECT_EQ(2, readLines(dir + "/sink.csv").size());
+
+    EXPECT_TRUE(engine.readNextBatch());
+    engine.executeMain();
+    EXPECT_EQ(9, readLines(dir + "/path.csv").size());
+    EXPECT_TRUE(Lines({"2", "3"}) == readLines(dir + "/sink.csv.retracted"));
+
+    // the stream is closed by its last batch
+    EXPECT_FALSE(engine.readNextBatch());
+
+    for (const char* key : {"jobs", "incremental", "fact-dir", "output-dir"}) {
+        Global::config().unset(key);
+    }
+    execStdOut(("rm -rf '" + dir + "'").c_str());
+}
+
+}  // namespace souffle::interpreter::test
@@ -0,0 +1,111 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file table_compactor_test.cpp
+ *
+ * Tests the translation of values into compacted tables
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "interpreter/TableCompactor.h"
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include <string>
+#include <vector>
+
+namespace souffle::interpreter::test {
+
+namespace {
+const std::string types = R"({
+    "records": {
+        "r:List": {"types": ["s:symbol", "r:List"], "arity": 2},
+        "r:Pair": {"types": ["i:number", "i:number"], "arity": 2}
+    },
+    "ADTs": {
+        "+:Color": {"branches": [{"types": [], "name": "Blue"}, {"types": [], "name": "Red"}],
+            "arity": 2, "enum": true},
+        "+:Expr": {"branches": [
+                {"types": ["+:Expr", "+:Expr"], "name": "Add"},
+                {"types": [], "name": "Nil"},
+                {"types": ["s:symbol"], "name": "Var"}],
+            "arity": 3, "enum": false}
+    }
+})";
+}  // namespace
+
+TEST(TableCompactor, Records) {
+    SymbolTable symbols;
+    SpecializedRecordTable<0, 2> records;
+    const RamDomain dead = records.pack({symbols.encode("dead"), 0});
+    RamDomain list = 0;
+    for (int i = 0; i < 10000; ++i) {
+        list = records.pack({symbols.encode(std::to_string(i)), list});
+    }
+    const RamDomain pair = records.pack({1, 2});
+    EXPECT_NE(dead, pair);
+
+    SymbolTable newSymbols;
+    SpecializedRecordTable<0, 2> newRecords;
+    TableCompactor compactor(types, symbols, records, newSymbols, newRecords);
+
+    // deep lists are translated without recursion
+    const RamDomain newList = compactor.translate(list, compactor.getType("r:List"));
+    EXPECT_EQ(10000, newRecords.size());
+    EXPECT_EQ(10000, newSymbols.size());
+    EXPECT_FALSE(newSymbols.weakContains("dead"));
+    RamDomain cur = newList;
+    for (int i = 9999; i >= 0; --i) {
+        const RamDomain* fields = newRecords.unpack(cur, 2);
+        EXPECT_EQ(std::to_string(i), newSymbols.decode(fields[0]));
+        cur = fields[1];
+    }
+    EXPECT_EQ(0, cur);
+
+    // translations are memoised, and plain records keep their fields
+    EXPECT_EQ(newList, compactor.translate(list, compactor.getType("r:List")));
+    const RamDomain newPair = compactor.translate(pair, compactor.getType("r:Pair"));
+    EXPECT_EQ(1, newRecords.unpack(newPair, 2)[0]);
+    EXPECT_EQ(2, newRecords.unpack(newPair, 2)[1]);
+    EXPECT_EQ(42, compactor.translate(42, compactor.getType("i:number")));
+    EXPECT_EQ(0, compactor.translate(0, compactor.getType("r:List")));
+}
+
+TEST(TableCompactor, ADTs) {
+    SymbolTable symbols({"unused", "x"});
+    SpecializedRecordTable<0, 2> records;
+    const RamDomain nil = packUnboxedBranch(1);
+    const RamDomain var = records.pack({2, symbols.encode("x")});
+    const RamDomain add = records.pack({0, records.pack({var, nil})});
+
+    SymbolTable newSymbols;
+    SpecializedRecordTable<0, 2> newRecords;
+    TableCompactor compactor(types, symbols, records, newSymbols, newRecords);
+
+    const RamDomain newAdd = compactor.translate(add, compactor.getType("+:Expr"));
+    EXPECT_EQ(1, newSymbols.size());
+    const RamDomain* branch = newRecords.unpack(newAdd, 2);
+    EXPECT_EQ(0, branch[0]);
+    const RamDomain* arguments = newRecords.unpack(branch[1], 2);
+    const RamDomain* newVar = newRecords.unpack(arguments[0], 2);
+    EXPECT_EQ(2, newVar[0]);
+    EXPECT_EQ("x", newSymbols.decode(newVar[1]));
+
+    // branches without arguments are not records
+    EXPECT_EQ(packUnboxedBranch(1), arguments[1]);
+    EXPECT_EQ(packUnboxedBranch(1), compactor.translate(nil, compactor.getType("+:Expr")));
+
+    // enumerations are plain values
+    EXPECT_EQ(1, compactor.translate(1, compactor.getType("+:Color")));
+}
+
+}  // namespace souffle::interpreter::test
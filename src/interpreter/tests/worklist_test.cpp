@@ -0,0 +1,160 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file worklist_test.cpp
+ *
+ * Tests the asynchronous evaluation of fixpoint loops by the Interpreter.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "RelationTag.h"
+#include "interpreter/Engine.h"
+#include "ram/Clear.h"
+#include "ram/Condition.h"
+#include "ram/Constraint.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/Exit.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/Guard.h"
+#include "ram/IO.h"
+#include "ram/Insert.h"
+#include "ram/Loop.h"
+#include "ram/Negation.h"
+#include "ram/NoveltyInsert.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/Statement.h"
+#include "ram/Swap.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/json11.h"
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::interpreter::test {
+
+using json11::Json;
+
+namespace {
+
+Own<ram::Relation> makeRelation(const std::string& name) {
+    return mk<ram::Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+            std::vector<std::string>{"i", "i"}, RelationRepresentation::BTREE);
+}
+
+VecOwn<ram::Expression> makeValues(
+        std::size_t lhs, std::size_t lhsElement, std::size_t rhs, std::size_t rhsElement) {
+    VecOwn<ram::Expression> values;
+    values.push_back(mk<ram::TupleElement>(lhs, lhsElement));
+    values.push_back(mk<ram::TupleElement>(rhs, rhsElement));
+    return values;
+}
+
+/**
+ * Evaluate the transitive closure of a graph, as translated for a linear recursive rule, and return
+ * the printed relation
+ */
+std::string evaluateClosure(RamDomain nodes, bool async, const std::string& jobs) {
+    Global::config().set("jobs", jobs);
+    if (async) {
+        Global::config().set("async-fixpoint");
+    }
+
+    VecOwn<ram::Relation> rels;
+    for (const auto* name : {"edge", "path", "@delta_path", "@new_path"}) {
+        rels.push_back(makeRelation(name));
+    }
+
+    // a chain with shortcuts, whose paths are derived over many iterations
+    VecOwn<ram::Statement> main;
+    for (RamDomain i = 0; i + 1 < nodes; ++i) {
+        for (RamDomain j : {i + 1, (i * 7) % nodes}) {
+            VecOwn<ram::Expression> values;
+            values.push_back(mk<ram::SignedConstant>(i));
+            values.push_back(mk<ram::SignedConstant>(j));
+            main.push_back(mk<ram::Query>(mk<ram::Insert>("edge", std::move(values))));
+        }
+    }
+    main.push_back(
+            mk<ram::Query>(mk<ram::Scan>("edge", 0, mk<ram::Insert>("path", makeValues(0, 0, 0, 1)))));
+    main.push_back(mk<ram::Query>(
+            mk<ram::Scan>("path", 0, mk<ram::Insert>("@delta_path", makeValues(0, 0, 0, 1)))));
+
+    // path(x, z) :- path(x, y), edge(y, z).
+    auto join = mk<ram::Constraint>(
+            BinaryConstraintOp::EQ, mk<ram::TupleElement>(1, 0), mk<ram::TupleElement>(0, 1));
+    auto insert = mk<ram::NoveltyInsert>("path", makeValues(0, 0, 1, 1), "@new_path");
+    auto edges = mk<ram::Scan>("edge", 1, mk<ram::Filter>(std::move(join), std::move(insert)));
+    auto rule = mk<ram::Query>(mk<ram::Filter>(mk<ram::Negation>(mk<ram::EmptinessCheck>("@delta_path")),
+            mk<ram::Scan>("@delta_path", 0, std::move(edges))));
+    main.push_back(mk<ram::Loop>(mk<ram::Sequence>(
+            mk<ram::Guard>(mk<ram::Negation>(mk<ram::EmptinessCheck>("@delta_path")),
+                    mk<ram::Sequence>(std::move(rule))),
+            mk<ram::Exit>(mk<ram::EmptinessCheck>("@new_path")), mk<ram::Swap>("@delta_path", "@new_path"),
+            mk<ram::Clear>("@new_path"))));
+    main.push_back(mk<ram::Clear>("@delta_path"));
+    main.push_back(mk<ram::Clear>("@new_path"));
+
+    Json types = Json::object{
+            {"relation", Json::object{{"arity", 2LL}, {"types", Json::array{"i", "i"}}}}};
+    std::map<std::string, std::string> directives = {{"operation", "output"}, {"IO", "stdout"},
+            {"attributeNames", "x\ty"}, {"name", "path"}, {"auxArity", "0"}, {"types", types.dump()}};
+    main.push_back(mk<ram::IO>("path", directives));
+
+    std::map<std::string, Own<ram::Statement>> subs;
+    ErrorReport errReport;
+    DebugReport debugReport;
+    ram::TranslationUnit translationUnit(
+            mk<ram::Program>(std::move(rels), mk<ram::Sequence>(std::move(main)), std::move(subs)),
+            errReport, debugReport);
+    Engine engine(translationUnit);
+
+    std::streambuf* oldCoutStreambuf = std::cout.rdbuf();
+    std::ostringstream sout;
+    std::cout.rdbuf(sout.rdbuf());
+    engine.executeMain();
+    std::cout.rdbuf(oldCoutStreambuf);
+    if (async) {
+        Global::config().unset("async-fixpoint");
+    }
+    return sout.str();
+}
+
+}  // namespace
+
+TEST(Worklist, TransitiveClosure) {
+    const std::string expected = evaluateClosure(300, false, "1");
+    EXPECT_LT(300 * 2, expected.size());
+    for (const auto* jobs : {"1", "4"}) {
+        EXPECT_EQ(expected, evaluateClosure(300, true, jobs));
+    }
+}
+
+}  // namespace souffle::interpreter::test
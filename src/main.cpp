@@ -15,48 +15,24 @@
  ***********************************************************************/
 
 #include "Global.h"
+#include "Pipelines.h"
+#include "ast/Atom.h"
+#include "ast/Clause.h"
+#include "ast/Counter.h"
+#include "ast/Directive.h"
 #include "ast/Node.h"
 #include "ast/Program.h"
+#include "ast/QualifiedName.h"
+#include "ast/Relation.h"
 #include "ast/TranslationUnit.h"
 #include "ast/analysis/PrecedenceGraph.h"
 #include "ast/analysis/SCCGraph.h"
 #include "ast/analysis/typesystem/Type.h"
-#include "ast/transform/AddNullariesToAtomlessAggregates.h"
-#include "ast/transform/ComponentChecker.h"
-#include "ast/transform/ComponentInstantiation.h"
-#include "ast/transform/Conditional.h"
-#include "ast/transform/ExecutionPlanChecker.h"
-#include "ast/transform/ExpandEqrels.h"
-#include "ast/transform/Fixpoint.h"
-#include "ast/transform/FoldAnonymousRecords.h"
-#include "ast/transform/GroundWitnesses.h"
-#include "ast/transform/GroundedTermsChecker.h"
 #include "ast/transform/IOAttributes.h"
 #include "ast/transform/IODefaults.h"
-#include "ast/transform/InlineRelations.h"
-#include "ast/transform/MagicSet.h"
-#include "ast/transform/MaterializeAggregationQueries.h"
-#include "ast/transform/MaterializeSingletonAggregation.h"
-#include "ast/transform/MinimiseProgram.h"
-#include "ast/transform/NameUnnamedVariables.h"
-#include "ast/transform/NormaliseGenerators.h"
-#include "ast/transform/PartitionBodyLiterals.h"
 #include "ast/transform/Pipeline.h"
 #include "ast/transform/PragmaChecker.h"
-#include "ast/transform/ReduceExistentials.h"
-#include "ast/transform/RemoveBooleanConstraints.h"
-#include "ast/transform/RemoveEmptyRelations.h"
-#include "ast/transform/RemoveRedundantRelations.h"
-#include "ast/transform/RemoveRedundantSums.h"
-#include "ast/transform/RemoveRelationCopies.h"
-#include "ast/transform/ReorderLiterals.h"
-#include "ast/transform/ReplaceSingletonVariables.h"
-#include "ast/transform/ResolveAliases.h"
-#include "ast/transform/ResolveAnonymousRecordAliases.h"
-#include "ast/transform/SemanticChecker.h"
-#include "ast/transform/SimplifyAggregateTargetExpression.h"
-#include "ast/transform/SubsumptionQualifier.h"
-#include "ast/transform/UniqueAggregationVariables.h"
+#include "ast/utility/Visitor.h"
 #include "ast2ram/TranslationStrategy.h"
 #include "ast2ram/UnitTranslator.h"
 #include "ast2ram/provenance/TranslationStrategy.h"
@@ -68,27 +44,14 @@
 #include "interpreter/Engine.h"
 #include "interpreter/ProgInterface.h"
 #include "parser/ParserDriver.h"
+#include "parser/Preprocessor.h"
 #include "ram/Node.h"
 #include "ram/Program.h"
 #include "ram/TranslationUnit.h"
-#include "ram/transform/CollapseFilters.h"
-#include "ram/transform/Conditional.h"
-#include "ram/transform/EliminateDuplicates.h"
-#include "ram/transform/ExpandFilter.h"
-#include "ram/transform/HoistAggregate.h"
-#include "ram/transform/HoistConditions.h"
-#include "ram/transform/IfConversion.h"
-#include "ram/transform/IfExistsConversion.h"
-#include "ram/transform/Loop.h"
-#include "ram/transform/MakeIndex.h"
-#include "ram/transform/Parallel.h"
-#include "ram/transform/ReorderConditions.h"
-#include "ram/transform/ReorderFilterBreak.h"
-#include "ram/transform/ReportIndex.h"
-#include "ram/transform/Sequence.h"
-#include "ram/transform/Transformer.h"
-#include "ram/transform/TupleId.h"
+#include "ram/utility/Serialisation.h"
+#include "reports/ConfigurationTuner.h"
 #include "reports/DebugReport.h"
+#include "reports/EngineComparison.h"
 #include "reports/ErrorReport.h"
 #include "souffle/RamTypes.h"
 #include "souffle/profile/Tui.h"
@@ -99,30 +62,476 @@
 #include "souffle/utility/StreamUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include "souffle/utility/SubProcess.h"
+#include "souffle/utility/json11.h"
 #include "synthesiser/Synthesiser.h"
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <optional>
 #include <memory>
+#include <poll.h>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 
 namespace souffle {
 
+/**
+ * Wait for input on the standard input without consuming it, such that a child process may read it.
+ * Return false if the input ends instead.
+ */
+bool waitForInput() {
+    pollfd input{STDIN_FILENO, POLLIN, 0};
+    if (poll(&input, 1, -1) <= 0) {
+        return false;
+    }
+    int available = 0;
+    return ioctl(STDIN_FILENO, FIONREAD, &available) == 0 && available > 0;
+}
+
+/**
+ * Read the remaining contents of a stream.
+ */
+std::string readAll(FILE* in) {
+    std::string contents;
+    char buffer[4096];
+    std::size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        contents.append(buffer, count);
+    }
+    return contents;
+}
+
+/**
+ * The key of the RAM program cache of `--ram-cache`: the pre-processed program and the options it
+ * is translated with. Options only read by the evaluation of the program are left out, such that
+ * they may differ between runs sharing the cache.
+ */
+json11::Json ramCacheKey(const std::string& source) {
+    json11::Json::object options;
+    for (auto&& [option, values] : Global::config().data()) {
+        if (option.empty() || option == "fact-dir" || option == "output-dir" || option == "ram-cache" ||
+                option == "verbose") {
+            continue;
+        }
+        options[option] = json11::Json::array(values.begin(), values.end());
+    }
+    return json11::Json::object{{"options", options}, {"source", source}};
+}
+
+/**
+ * Load the RAM program cached for the key, and set the pragmas of the Datalog program it was
+ * translated from. Return null if the cache holds no program for the key.
+ *
+ * The cache holds a line with a JSON object naming the key and the pragmas, followed by the
+ * serialised program.
+ */
+Own<ram::Program> loadRamCache(const std::string& filename, const json11::Json& key) {
+    std::ifstream in(filename, std::ios::binary);
+    std::string line;
+    if (!std::getline(in, line)) {
+        return nullptr;
+    }
+    std::string error;
+    json11::Json header = json11::Json::parse(line, error);
+    if (!error.empty() || header["key"] != key) {
+        return nullptr;
+    }
+    Own<ram::Program> program;
+    try {
+        program = ram::deserialise(in);
+    } catch (std::runtime_error&) {
+        return nullptr;
+    }
+    ast::transform::PragmaChecker::Merger merger;
+    for (auto&& pragma : header["pragmas"].array_items()) {
+        merger(pragma[0].string_value(), pragma[1].string_value());
+    }
+    return program;
+}
+
+/**
+ * Store the RAM program translated from the Datalog program in the cache for the key.
+ */
+void storeRamCache(const std::string& filename, const json11::Json& key, const ast::Program& source,
+        const ram::Program& program) {
+    json11::Json::array pragmas;
+    for (auto&& pragma : source.getPragmaDirectives()) {
+        auto&& [k, v] = pragma->getkvp();
+        pragmas.push_back(json11::Json::array{k, v});
+    }
+    // written next to the cache and renamed, such that concurrent runs never read a partial program
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << json11::Json(json11::Json::object{{"key", key}, {"pragmas", pragmas}}).dump() << "\n";
+        ram::serialise(out, program);
+        if (!out) {
+            throw std::runtime_error("Cannot write RAM cache " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        throw std::runtime_error("Cannot write RAM cache " + filename);
+    }
+}
+
+/**
+ * Specialise the program for its inputs marked `static=true`, which do not change between runs.
+ *
+ * The relations depending solely on static inputs are evaluated by the interpreter while the program is
+ * compiled. Those read by the remaining rules or written by the program are replaced by inline tables of
+ * their tuples, loaded by the compiled program instead of their inputs and rules; the others are removed.
+ * Rules calling user-defined functors or generating values by `autoinc()` are evaluated at runtime.
+ */
+void specialise(ast::TranslationUnit& translationUnit, ErrorReport& errReport, DebugReport& debugReport) {
+    ast::Program& program = translationUnit.getProgram();
+
+    // a relation is static if its inputs are static and its rules only read static relations
+    std::set<ast::QualifiedName> staticRelations;
+    for (const auto* rel : program.getRelations()) {
+        staticRelations.insert(rel->getQualifiedName());
+    }
+    auto isDynamic = [&](const ast::Relation& rel) {
+        for (const auto* io : program.getDirectives(rel)) {
+            if (io->getType() == ast::DirectiveType::input &&
+                    (!io->hasParameter("static") || io->getParameter("static") != "true")) {
+                return true;
+            }
+        }
+        for (const auto* clause : program.getClauses(rel)) {
+            bool dynamic = false;
+            visit(*clause, [&](const ast::Atom& atom) {
+                dynamic |= !contains(staticRelations, atom.getQualifiedName());
+            });
+            visit(*clause, [&](const ast::UserDefinedFunctor&) { dynamic = true; });
+            visit(*clause, [&](const ast::Counter&) { dynamic = true; });
+            if (dynamic) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto* rel : program.getRelations()) {
+            if (contains(staticRelations, rel->getQualifiedName()) && isDynamic(*rel)) {
+                staticRelations.erase(rel->getQualifiedName());
+                changed = true;
+            }
+        }
+    }
+
+    // static relations read by dynamic rules or written by the program are embedded
+    std::set<ast::QualifiedName> embedded;
+    for (const auto* rel : program.getRelations()) {
+        if (!contains(staticRelations, rel->getQualifiedName())) {
+            for (const auto* clause : program.getClauses(*rel)) {
+                visit(*clause, [&](const ast::Atom& atom) {
+                    if (contains(staticRelations, atom.getQualifiedName())) {
+                        embedded.insert(atom.getQualifiedName());
+                    }
+                });
+            }
+        }
+        for (const auto* io : program.getDirectives(*rel)) {
+            const auto type = io->getType();
+            if (contains(staticRelations, rel->getQualifiedName()) &&
+                    (type == ast::DirectiveType::output || type == ast::DirectiveType::printsize)) {
+                embedded.insert(rel->getQualifiedName());
+            }
+        }
+    }
+    if (embedded.empty()) {
+        return;
+    }
+
+    // evaluate the static relations by a program of their own, writing the embedded relations to files
+    auto staticUnit = mk<ast::TranslationUnit>(clone(program), errReport, debugReport);
+    ast::Program& staticProgram = staticUnit->getProgram();
+    for (const auto* rel : program.getRelations()) {
+        if (!contains(staticRelations, rel->getQualifiedName())) {
+            staticProgram.removeRelation(rel->getQualifiedName());
+        }
+    }
+    for (const auto* io : staticProgram.getDirectives()) {
+        if (io->getType() == ast::DirectiveType::output || io->getType() == ast::DirectiveType::printsize) {
+            staticProgram.removeDirective(*io);
+        }
+    }
+    std::map<ast::QualifiedName, std::string> files;
+    for (const auto& name : embedded) {
+        files[name] = tempFile();
+        auto io = mk<ast::Directive>(ast::DirectiveType::output, name);
+        io->addParameter("IO", "file");
+        io->addParameter("operation", "output");
+        io->addParameter("filename", files[name]);
+        staticProgram.addDirective(std::move(io));
+    }
+    ast::transform::IODefaultsTransformer().apply(*staticUnit);
+    ast::transform::IOAttributesTransformer().apply(*staticUnit);
+
+    // options of the runtime, e.g. profiles, checkpoints and caches, do not apply to the evaluation
+    const MainConfig config = Global::config();
+    for (const char* option : {"profile", "live-profile", "profile-stream", "emit-plans", "checkpoint-dir",
+                 "resume-from", "stratum-cache", "spill-dir", "compact-tables"}) {
+        Global::config().unset(option);
+    }
+    {
+        auto unitTranslator = Own<ast2ram::UnitTranslator>(
+                ast2ram::seminaive::TranslationStrategy().createUnitTranslator());
+        auto ramTranslationUnit = unitTranslator->translateUnit(*staticUnit);
+        makeRamTransformer()->apply(*ramTranslationUnit);
+        interpreter::Engine(*ramTranslationUnit).executeMain();
+    }
+    Global::config() = config;
+
+    // the tables are given by directives, which may not hold sequences of their escapes
+    std::map<ast::QualifiedName, std::string> tables;
+    for (const auto& [name, file] : files) {
+        std::ifstream in(file, std::ios::binary);
+        std::stringstream data;
+        data << in.rdbuf();
+        std::remove(file.c_str());
+        tables[name] = data.str();
+        for (const char* sequence : {"\\\"", "\\t", "\\r", "\\n", ")_\""}) {
+            if (tables[name].find(sequence) != std::string::npos) {
+                std::cerr << "Warning: relation " << name << " cannot be embedded, the program is not "
+                          << "specialised\n";
+                return;
+            }
+        }
+    }
+
+    // replace the static relations by their tables
+    for (const auto& name : staticRelations) {
+        if (!contains(embedded, name)) {
+            program.removeRelation(name);
+            continue;
+        }
+        for (const auto* clause : program.getClauses(name)) {
+            program.removeClause(*clause);
+        }
+        for (const auto* io : program.getDirectives(name)) {
+            if (io->getType() == ast::DirectiveType::input) {
+                program.removeDirective(*io);
+            }
+        }
+        auto io = mk<ast::Directive>(ast::DirectiveType::input, name);
+        io->addParameter("IO", "inline");
+        io->addParameter("data", tables[name]);
+        program.addDirective(std::move(io));
+    }
+    translationUnit.invalidateAnalyses();
+    ast::transform::IODefaultsTransformer().apply(translationUnit);
+    ast::transform::IOAttributesTransformer().apply(translationUnit);
+}
+
+/**
+ * Evaluate the RAM program by the interpreter.
+ */
+void interpret(ram::TranslationUnit& ramTranslationUnit, const std::string& souffleExecutable, int argc,
+        char** argv) {
+    std::thread profiler;
+    // Start up profiler if needed
+    if (Global::config().has("live-profile")) {
+        profiler = std::thread([]() { profile::Tui().runProf(); });
+    }
+
+    // configure and execute interpreter
+    Own<interpreter::Engine> interpreter(mk<interpreter::Engine>(ramTranslationUnit));
+    interpreter->executeMain();
+    // with --incremental, each batch of the streaming inputs re-evaluates the strata it affects
+    while (interpreter->readNextBatch()) {
+        interpreter->executeMain();
+    }
+    // If the profiler was started, join back here once it exits.
+    if (profiler.joinable()) {
+        profiler.join();
+    }
+    if (Global::config().has("lazy-provenance") && waitForInput()) {
+        // re-evaluate the program with provenance in a new process, which reads the commands
+        std::vector<std::string> args(argv + 1, argv + argc);
+        args.push_back("--provenance=explain");
+        auto status = execute(souffleExecutable, args);
+        std::exit(status ? *status : EXIT_FAILURE);
+    }
+    if (Global::config().has("provenance")) {
+        // only run explain interface if interpreted
+        interpreter::ProgInterface interface(*interpreter);
+        if (Global::config().get("provenance") == "explain") {
+            explain(interface, false);
+        } else if (Global::config().get("provenance") == "explore") {
+            explain(interface, true);
+        }
+    }
+}
+
+/**
+ * Run the program in each configuration of `--bench` by a new process, then check that their outputs
+ * agree, and compare the runtimes of their rules as given by their profiles.
+ */
+int benchmark(const std::string& souffleExecutable, int argc, char** argv) {
+    const auto configurations = EngineConfiguration::parseAll(Global::config().get("bench"));
+
+    // the runs are given the arguments of this one, but for the configurations
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--bench" || arg == "-b") {
+            ++i;
+        } else if (arg.rfind("--bench=", 0) != 0 && arg.rfind("-b", 0) != 0) {
+            args.push_back(arg);
+        }
+    }
+
+    // the outputs and profiles of the runs are kept, such that they can be inspected by souffleprof
+    char workTemplate[] = "./souffle-bench-XXXXXX";
+    if (mkdtemp(workTemplate) == nullptr) {
+        throw std::runtime_error("failed to create a directory for --bench");
+    }
+    const std::string workDir = workTemplate;
+
+    EngineComparison comparison;
+    for (std::size_t i = 0; i < configurations.size(); ++i) {
+        const auto& configuration = configurations[i];
+        const std::string outputDir = workDir + "/" + std::to_string(i + 1);
+        const std::string profile = outputDir + ".json";
+        if (mkdir(outputDir.c_str(), 0755) != 0) {
+            throw std::runtime_error("failed to create output directory " + outputDir);
+        }
+
+        std::vector<std::string> runArgs = configuration.options;
+        runArgs.insert(runArgs.end(), {"-D", outputDir, "-p", profile});
+        if (configuration.compiled) {
+            runArgs.push_back("-c");
+        }
+        runArgs.insert(runArgs.end(), args.begin(), args.end());
+
+        std::cout << "Running " << configuration.name << std::endl;
+        auto status = execute(souffleExecutable, runArgs);
+        if (!status || *status != 0) {
+            throw std::runtime_error("the run in configuration " + configuration.name + " failed");
+        }
+        comparison.addRun(configuration.name, outputDir, profile);
+    }
+
+    std::cout << "\n";
+    const bool agree = comparison.checkOutputs(std::cout);
+    comparison.print(std::cout);
+    std::cout << "\nOutputs and profiles are kept in " << workDir << "\n";
+    return agree ? 0 : EXIT_FAILURE;
+}
+
+/**
+ * Search the options under which the program runs fastest on its facts by runs of new processes, as
+ * given by `--tune`, checking that their outputs agree with the run of the untuned program, and write
+ * the fastest options as pragmas.
+ */
+int tune(const std::string& souffleExecutable, int argc, char** argv) {
+    const std::string pragmaFile = Global::config().get("tune");
+
+    // the runs are given the arguments of this one, but for the tuning and the number of threads
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--tune" || arg == "-T" || arg == "--jobs" || arg == "-j") {
+            ++i;
+        } else if (arg.rfind("--tune=", 0) != 0 && arg.rfind("-T", 0) != 0 && arg.rfind("--jobs=", 0) != 0 &&
+                   arg.rfind("-j", 0) != 0) {
+            args.push_back(arg);
+        }
+    }
+
+    // the outputs and profiles of the runs are kept, such that they can be inspected by souffleprof
+    char workTemplate[] = "./souffle-tune-XXXXXX";
+    if (mkdtemp(workTemplate) == nullptr) {
+        throw std::runtime_error("failed to create a directory for --tune");
+    }
+    const std::string workDir = workTemplate;
+
+    // the literal orders of the profile of the untuned program are tried by `profile-use`, which
+    // refers to the profile kept next to the pragmas
+    const std::string profileUse = pragmaFile + ".profile.json";
+    std::string baselineDir;
+    std::size_t count = 0;
+    auto runner = [&](const ConfigurationTuner::Settings& settings) -> std::optional<TuningRun> {
+        const std::string outputDir = workDir + "/" + std::to_string(++count);
+        const std::string profile = outputDir + ".json";
+        if (mkdir(outputDir.c_str(), 0755) != 0) {
+            throw std::runtime_error("failed to create output directory " + outputDir);
+        }
+
+        std::vector<std::string> runArgs = args;
+        runArgs.insert(runArgs.end(), {"-D", outputDir, "-p", profile});
+        for (const auto& [option, value] : settings) {
+            if (option == "jobs") {
+                runArgs.push_back("--jobs=" + value);
+            } else if (!value.empty()) {
+                runArgs.push_back("--pragma=" + option + ":" + value);
+            }
+        }
+        auto status = execute(souffleExecutable, runArgs);
+        if (!status || *status != 0) {
+            return std::nullopt;
+        }
+
+        if (baselineDir.empty()) {
+            baselineDir = outputDir;
+            std::ifstream in(profile, std::ios::binary);
+            std::ofstream(profileUse, std::ios::binary) << in.rdbuf();
+        }
+        EngineComparison comparison;
+        comparison.addRun("run 1", baselineDir, profileUse);
+        comparison.addRun("run " + std::to_string(count), outputDir, profile);
+        if (!comparison.checkOutputs(std::cout)) {
+            return std::nullopt;
+        }
+        return TuningRun{comparison.getRuntime(1), comparison.getRuleTime(1)};
+    };
+
+    // options given on the command line are kept, but for the number of threads
+    std::string jobs = Global::config().get("jobs");
+    jobs = jobs == "0" ? "auto" : jobs;
+    auto dimensions = ConfigurationTuner::getDefaultDimensions(
+            jobs, std::max(1U, std::thread::hardware_concurrency()), profileUse);
+    dimensions.erase(std::remove_if(dimensions.begin(), dimensions.end(),
+                             [](const auto& dimension) {
+                                 return dimension.option != "jobs" &&
+                                        Global::config().state(dimension.option) == MainConfig::State::set;
+                             }),
+            dimensions.end());
+
+    ConfigurationTuner tuner(std::move(dimensions), runner);
+    const auto settings = tuner.search(std::cout);
+    if (!contains(settings, "profile-use")) {
+        std::remove(profileUse.c_str());
+    }
+    std::ofstream out(pragmaFile);
+    ConfigurationTuner::writePragmas(out, settings);
+    std::cout << "\nThe options are written to " << pragmaFile << ", the outputs and profiles of the runs "
+              << "are kept in " << workDir << "\n";
+    return out ? 0 : EXIT_FAILURE;
+}
+
 /**
  * Executes a binary file.
  */
-[[noreturn]] void executeBinaryAndExit(const std::string& binaryFilename) {
+[[noreturn]] void executeBinaryAndExit(
+        const std::string& binaryFilename, const std::vector<std::string>& sourceFilenames) {
     assert(!binaryFilename.empty() && "binary filename cannot be blank");
 
     std::map<char const*, std::string> env;
@@ -141,20 +550,38 @@ namespace souffle {
 
     if (!Global::config().has("dl-program")) {
         remove(binaryFilename.c_str());
-        remove((binaryFilename + ".cpp").c_str());
+        for (const auto& sourceFilename : sourceFilenames) {
+            remove(sourceFilename.c_str());
+        }
     }
 
     std::exit(exit ? *exit : EXIT_FAILURE);
 }
 
 /**
- * Compiles the given source file to a binary file.
+ * Compiles the given source files to a binary file, named after the first one.
  */
-void compileToBinary(const std::string& command, std::string_view sourceFilename) {
+void compileToBinary(const std::string& command, const std::vector<std::string>& sourceFilenames) {
     std::vector<std::string> argv;
     if (Global::config().has("swig")) {
         argv.push_back("-s");
         argv.push_back(Global::config().get("swig"));
+    } else {
+        if (Global::config().has("compile-cache")) {
+            argv.push_back("-C");
+            argv.push_back(Global::config().get("compile-cache"));
+        }
+        if (Global::config().has("pgo-train")) {
+            argv.push_back("-T");
+            argv.push_back(Global::config().get("pgo-train"));
+        }
+        if (Global::config().has("pgo-profile")) {
+            argv.push_back("-P");
+            argv.push_back(Global::config().get("pgo-profile"));
+        }
+        if (Global::config().has("native-strata") || Global::config().has("shared-library")) {
+            argv.push_back("-S");
+        }
     }
 
     for (auto&& path : Global::config().getMany("library-dir")) {
@@ -172,12 +599,12 @@ void compileToBinary(const std::string& command, std::string_view sourceFilename
         argv.push_back(tfm::format("-l%s", library));
     }
 
-    argv.push_back(std::string(sourceFilename));
+    argv.insert(argv.end(), sourceFilenames.begin(), sourceFilenames.end());
 
     auto exit = execute(command, argv);
     if (!exit) throw std::invalid_argument(tfm::format("unable to execute tool <%s>", command));
     if (exit != 0)
-        throw std::invalid_argument(tfm::format("failed to compile C++ source <%s>", sourceFilename));
+        throw std::invalid_argument(tfm::format("failed to compile C++ source <%s>", sourceFilenames[0]));
 }
 
 int main(int argc, char** argv) {
@@ -230,11 +657,18 @@ int main(int argc, char** argv) {
                 {"no-warn", 'w', "", "", false, "Disable warnings."},
                 {"magic-transform", 'm', "RELATIONS", "", false,
                         "Enable magic set transformation changes on the given relations, use '*' "
-                        "for all."},
+                        "for all, or 'auto' for the relations whose uses bind some of their arguments."},
                 {"magic-transform-exclude", '\x8', "RELATIONS", "", false,
                         "Disable magic set transformation changes on the given relations. Overrides "
                         "`magic-transform`. Implies `inline-exclude` for the given relations."},
                 {"macro", 'M', "MACROS", "", false, "Set macro definitions for the pre-processor"},
+                {"preprocessor", 'x', "[ mcpp | builtin ]", "", false,
+                        "Pre-process the program by the external mcpp, the default, or by the built-in "
+                        "pre-processor, which caches the expansion of each file, and whose included files "
+                        "are parsed in parallel by the threads of `jobs`."},
+                {"preprocessor-cache", 'y', "DIR", "", false,
+                        "Keep the expansions of the files of the built-in pre-processor in <DIR>, reusing "
+                        "them in later runs for the same contents and macros."},
                 {"disable-transformers", 'z', "TRANSFORMERS", "", false,
                         "Disable the given AST transformers."},
                 {"dl-program", 'o', "FILE", "", false,
@@ -244,11 +678,141 @@ int main(int argc, char** argv) {
                 {"profile", 'p', "FILE", "", false, "Enable profiling, and write profile data to <FILE>."},
                 {"profile-use", 'u', "FILE", "", false,
                         "Use profile log-file <FILE> for profile-guided optimization."},
-                {"profile-frequency", '\2', "", "", false, "Enable the frequency counter in the profiler."},
+                {"profile-frequency", '\2', "", "", false,
+                        "Enable the frequency and index access counters in the profiler, and the "
+                        "statistics of the values of the columns of relations in the interpreter."},
+                {"profile-operators", 'E', "", "", false,
+                        "Record the tuples entering and leaving each operator of the rules and its time in "
+                        "the interpreter, such that the profiler shows the annotated plans of the rules."},
+                {"profile-sampling", '\xe', "INTERVAL", "", false,
+                        "Estimate the times of the profile in the interpreter by sampling the running rules "
+                        "every <INTERVAL> microseconds, instead of timing each rule."},
+                {"profile-counters", '\xf', "", "", false,
+                        "Record hardware performance counters of relations and rules in the profiler."},
+                {"profile-stream", '\x10', "FILE", "", false,
+                        "Append the profile events to <FILE> as JSON lines while the program runs."},
                 {"debug-report", 'r', "FILE", "", false, "Write HTML debug report to <FILE>."},
                 {"pragma", 'P', "OPTIONS", "", true, "Set pragma options."},
-                {"provenance", 't', "[ none | explain | explore ]", "", false,
-                        "Enable provenance instrumentation and interaction."},
+                {"provenance", 't', "[ none | explain | explore | lazy ]", "", false,
+                        "Enable provenance instrumentation and interaction. With `lazy`, the program is "
+                        "evaluated without instrumentation, and only re-evaluated with it once a command "
+                        "is entered into the explain interface."},
+                {"incremental", '\x9', "", "", false,
+                        "Keep relations resident in the interpreter so that re-running the program only "
+                        "re-evaluates strata affected by changed relations. Streaming inputs (IO=stream) are "
+                        "then evaluated batch by batch, writing the changes of the outputs."},
+                {"compact-relations", '\xa', "", "", false,
+                        "Rebuild the b-trees of relations densely once their stratum is evaluated, reducing "
+                        "their memory footprint."},
+                {"on-demand-indexes", '\x7f', "", "", false,
+                        "Build the secondary indexes of relations that are only searched by later strata "
+                        "concurrently from the primary index before the first stratum reading them, instead "
+                        "of maintaining them on insertion."},
+                {"btree-node-size", '\x12', "SIZES", "", false,
+                        "Set the node size in bytes of the b-trees of compiled relations, given as a "
+                        "comma-separated list of <relation>=<bytes> entries, where an entry without a "
+                        "relation applies to all other relations. By default, nodes hold about 64 tuples."},
+                {"narrow-columns", 'n', "", "", false,
+                        "Store the attributes of compiled b-tree relations in 8 or 16 bits if all their "
+                        "values fit, i.e., if they only take constants of the program or values of such "
+                        "attributes. Inserting other values through the program interface aborts the "
+                        "program, hence code generated by `generate` or `swig` keeps the relations of the "
+                        "interface at full width."},
+                {"spill-dir", '\x11', "DIR", "", false,
+                        "Write relations to <DIR> while no stratum reads them, and load them again before "
+                        "they are read, reducing the memory footprint of the program."},
+                {"compact-tables", '\x13', "", "", false,
+                        "Reclaim the records and symbols no relation refers to anymore between strata of "
+                        "the interpreter, renumbering them in the relations."},
+                {"compile-units", '\x14', "N", "", false,
+                        "Split the generated C++ code into a header and up to <N> translation units "
+                        "defining the strata, which are compiled in parallel."},
+                {"compile-cache", '\x15', "DIR", "", false,
+                        "Cache the objects of compiled translation units in <DIR>, reusing them when "
+                        "neither their code nor the compiler flags changed."},
+                {"pgo-train", '\x16', "DIR", "", false,
+                        "Optimise the compiled program with the profile of a run of an instrumented build on "
+                        "the facts in <DIR>."},
+                {"pgo-profile", '\x17', "DIR", "", false,
+                        "Keep the profile of `pgo-train` in <DIR>, and optimise later builds with it "
+                        "when they are not trained."},
+                {"native-strata", '\x18', "STRATA", "", false,
+                        "Generate the given comma-separated strata, e.g. `0,3`, as a library of native code "
+                        "for `native-library`, which is built by `dl-program`."},
+                {"native-library", '\x19', "FILE", "", false,
+                        "Evaluate the strata of the library <FILE>, built with `native-strata` for the same "
+                        "program, by its native code in the interpreter."},
+                {"shared-library", '\x1a', "", "", false,
+                        "Build the program by `dl-program` as a shared library <FILE>.so, whose entry point "
+                        "souffle_program_create() creates instances that may be evaluated concurrently."},
+                {"query-relations", '\x1b', "RELATIONS", "", false,
+                        "Keep the given comma-separated relations resident after the evaluation, and "
+                        "generate a subroutine query_<relation> for each, e.g. `path:bf` returns the "
+                        "tuples of path whose first column equals the argument."},
+                {"only-relations", 'Q', "RELATIONS", "", false,
+                        "Evaluate only the strata computing the given comma-separated relations and the "
+                        "relations they depend on, skipping the loads, rules and stores of the others."},
+                {"checkpoint-dir", '\x1c', "DIR", "", false,
+                        "Write the relations, symbols and records needed by the remaining strata to <DIR> "
+                        "after each group of strata, replacing the previous checkpoint."},
+                {"resume-from", '\x1d', "DIR", "", false,
+                        "Resume the evaluation from the last checkpoint in <DIR>, written with "
+                        "`checkpoint-dir` by the same program, skipping the strata it completed."},
+                {"memory-limit", 'K', "SIZE", "", false,
+                        "Limit the memory of the relations, symbols and records in the interpreter to <SIZE> "
+                        "bytes, with an optional K, M or G suffix. Near the limit, the indexes built on "
+                        "demand are freed and the relations compacted; beyond it, the evaluation is aborted, "
+                        "reporting the largest relations."},
+                {"relation-threads", '\x1e', "THREADS", "", false,
+                        "Set the number of threads of parallel operations on relations, given as a "
+                        "comma-separated list of <relation>=<threads> entries, where an entry without a "
+                        "relation applies to all other relations. By default, it is chosen by their size."},
+                {"pin-threads", '\x1f', "", "", false,
+                        "Bind the threads to the processors available to the program, such that each "
+                        "thread keeps the memory it allocates local to its NUMA node."},
+                {"autoinc-block", 'N', "N", "", false,
+                        "Let each thread reserve the values of `autoinc()` in blocks of <N>, such that "
+                        "parallel rules generating values do not contend for a shared counter. The values "
+                        "remain unique, but are no longer dense nor in the order of their generation."},
+                {"functor-cache", 'U', "N", "", false,
+                        "Keep up to <N> results of each user-defined functor declared `cached`, reusing "
+                        "them for later calls with the same arguments. By default, 65536 results are kept."},
+                {"adaptive-join-order", '\xb', "", "", false,
+                        "Re-plan the join order of rules in the interpreter whenever the sizes of their "
+                        "relations change substantially."},
+                {"async-fixpoint", 'W', "", "", false,
+                        "Evaluate the recursive rules of the interpreter for the tuples they derive as "
+                        "soon as they are derived, from worklists of the threads, rather than in "
+                        "iterations. Applies to the strata whose rules each read a single relation of their "
+                        "stratum."},
+                {"delta-rule-variants", '\xc', "", "", false,
+                        "Compile the rules of recursive strata in several join orders, of which the order "
+                        "driven by the smallest relation is evaluated in each iteration."},
+                {"emit-plans", '\xd', "FILE", "", false,
+                        "Re-plan the join order of rules in the interpreter, and write the fastest orders "
+                        "measured as execution plans of their clauses to <FILE>."},
+                {"async-output", 'A', "N", "", false,
+                        "Write output relations to files by <N> background threads, while the strata "
+                        "after theirs are evaluated."},
+                {"ram-cache", 'R', "FILE", "", false,
+                        "Store the optimised RAM program of the interpreter in <FILE>, and load it "
+                        "instead of translating the Datalog program again in later runs with the same "
+                        "program and options."},
+                {"stratum-cache", 'C', "DIR", "", false,
+                        "Store the relations computed by each stratum in <DIR>, and load them instead of "
+                        "evaluating the stratum in later runs whose stratum reads the same relations."},
+                {"specialise", 'S', "", "", false,
+                        "Evaluate the relations depending solely on inputs marked `static=true` while the "
+                        "program is compiled, and embed their tuples in the generated code."},
+                {"bench", 'b', "CONFIGS", "", false,
+                        "Run the program in each of the `;`-separated configurations, e.g. "
+                        "`interpreter;compiled;compiled:-z MagicSetTransformer`, check that their outputs "
+                        "agree, and compare the runtimes of their rules."},
+                {"tune", 'T', "FILE", "", false,
+                        "Run the program on its facts under the values of options changing its evaluation, "
+                        "i.e., the SIPS heuristic, the literal orders of its profile, magic sets, inlining "
+                        "and the number of threads, searching one option at a time, and write the options of "
+                        "the fastest run whose outputs agree with the untuned run as pragmas to <FILE>."},
                 {"verbose", 'v', "", "", false, "Verbose output."},
                 {"version", '\3', "", "", false, "Version."},
                 {"show", '\4', "[ <see-list> ]", "", true,
@@ -259,6 +823,7 @@ int main(int argc, char** argv) {
                         "\tparse-errors\n"
                         "\tprecedence-graph\n"
                         "\tprecedence-graph-text\n"
+                        "\trepresentations\n"
                         "\tscc-graph\n"
                         "\tscc-graph-text\n"
                         "\ttransformed-ast\n"
@@ -335,6 +900,13 @@ int main(int argc, char** argv) {
         }
 #endif
 
+        /* the writers of output relations are counted by a positive number */
+        if (Global::config().has("async-output") &&
+                (!isNumber(Global::config().get("async-output").c_str()) ||
+                        std::stoi(Global::config().get("async-output")) < 1)) {
+            throw std::runtime_error("--async-output may only be set to an integer greater than 0.");
+        }
+
         /* if an output directory is given, check it exists */
         if (Global::config().has("output-dir") && !Global::config().has("output-dir", "-") &&
                 !existDir(Global::config().get("output-dir")) &&
@@ -344,6 +916,190 @@ int main(int argc, char** argv) {
                     "output directory " + Global::config().get("output-dir") + " does not exists");
         }
 
+        /* check the selected b-tree node sizes */
+        if (Global::config().has("btree-node-size")) {
+            for (const auto& entry : splitString(Global::config().get("btree-node-size"), ',')) {
+                std::string size = entry.substr(entry.find('=') + 1);
+                if (!isNumber(size.c_str()) || std::stoi(size) < 64) {
+                    throw std::runtime_error("invalid b-tree node size `" + entry + "`");
+                }
+            }
+        }
+
+        /* check the selected numbers of threads */
+        if (Global::config().has("relation-threads")) {
+            for (const auto& entry : splitString(Global::config().get("relation-threads"), ',')) {
+                std::string threads = entry.substr(entry.find('=') + 1);
+                if (!isNumber(threads.c_str()) || std::stoi(threads) < 1) {
+                    throw std::runtime_error("invalid number of threads `" + entry + "`");
+                }
+            }
+        }
+
+        /* check the blocks of auto-increment values */
+        if (Global::config().has("autoinc-block")) {
+            const std::string& block = Global::config().get("autoinc-block");
+            if (!isNumber(block.c_str()) || std::stoi(block) < 1) {
+                throw std::runtime_error("--autoinc-block may only be set to an integer greater than 0.");
+            }
+        }
+
+        /* check the capacity of the caches of functors */
+        if (Global::config().has("functor-cache")) {
+            const std::string& capacity = Global::config().get("functor-cache");
+            if (!isNumber(capacity.c_str()) || std::stoi(capacity) < 1) {
+                throw std::runtime_error("--functor-cache may only be set to an integer greater than 0.");
+            }
+        }
+
+        /* check the number of translation units of the generated code */
+        if (Global::config().has("compile-units")) {
+            const std::string& units = Global::config().get("compile-units");
+            if (!isNumber(units.c_str()) || std::stoi(units) < 1) {
+                throw std::runtime_error("--compile-units may only be set to an integer greater than 0.");
+            }
+        }
+
+        /* lazy provenance evaluates the program without instrumentation first */
+        if (Global::config().get("provenance") == "lazy") {
+            for (const char* option : {"compile", "dl-program", "generate", "swig"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(
+                            std::string("--provenance=lazy cannot be used with --") + option);
+                }
+            }
+            Global::config().unset("provenance");
+            Global::config().set("lazy-provenance");
+        }
+
+        /* check the strata of a library of native code, which is built but not run */
+        if (Global::config().has("native-strata")) {
+            for (const auto& stratum : splitString(Global::config().get("native-strata"), ',')) {
+                if (!isNumber(stratum.c_str())) {
+                    throw std::runtime_error("invalid stratum `" + stratum + "` in --native-strata");
+                }
+            }
+            for (const char* option : {"compile", "compile-units", "swig", "profile", "provenance"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--native-strata cannot be used with --") + option);
+                }
+            }
+        }
+        if (Global::config().has("shared-library")) {
+            for (const char* option : {"swig", "profile", "pgo-train", "native-strata"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--shared-library cannot be used with --") + option);
+                }
+            }
+        }
+        if (Global::config().has("native-library")) {
+            for (const char* option : {"incremental", "provenance"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--native-library cannot be used with --") + option);
+                }
+            }
+        }
+
+        for (const char* checkpointOption : {"checkpoint-dir", "resume-from"}) {
+            if (!Global::config().has(checkpointOption)) {
+                continue;
+            }
+            for (const char* option : {"incremental", "spill-dir"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(
+                            std::string("--") + checkpointOption + " cannot be used with --" + option);
+                }
+            }
+        }
+        if (Global::config().has("checkpoint-dir") && !existDir(Global::config().get("checkpoint-dir")) &&
+                !(Global::config().has("generate") ||
+                        (Global::config().has("dl-program") && !Global::config().has("compile")))) {
+            throw std::runtime_error(
+                    "checkpoint directory " + Global::config().get("checkpoint-dir") + " does not exist");
+        }
+
+        if (Global::config().has("stratum-cache")) {
+            for (const char* option : {"incremental", "provenance"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--stratum-cache cannot be used with --") + option);
+                }
+            }
+            if (!existDir(Global::config().get("stratum-cache")) &&
+                    !(Global::config().has("generate") ||
+                            (Global::config().has("dl-program") && !Global::config().has("compile")))) {
+                throw std::runtime_error("stratum cache directory " + Global::config().get("stratum-cache") +
+                                         " does not exist");
+            }
+        }
+
+        if (Global::config().has("preprocessor") && !Global::config().has("preprocessor", "mcpp") &&
+                !Global::config().has("preprocessor", "builtin")) {
+            throw std::runtime_error("--preprocessor may only be set to 'mcpp' or 'builtin'.");
+        }
+        if (Global::config().has("preprocessor-cache")) {
+            if (!Global::config().has("preprocessor", "builtin")) {
+                throw std::runtime_error("--preprocessor-cache requires --preprocessor=builtin");
+            }
+            if (!existDir(Global::config().get("preprocessor-cache"))) {
+                throw std::runtime_error("pre-processor cache directory " +
+                                         Global::config().get("preprocessor-cache") + " does not exist");
+            }
+        }
+
+        if (Global::config().has("ram-cache")) {
+            for (const char* option : {"compile", "dl-program", "generate", "swig", "show"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--ram-cache cannot be used with --") + option);
+                }
+            }
+        }
+
+        if (Global::config().has("specialise")) {
+            if (!Global::config().has("compile") && !Global::config().has("dl-program") &&
+                    !Global::config().has("generate") && !Global::config().has("swig")) {
+                throw std::runtime_error("--specialise requires a compiled program, by -c, -o, -g or -s");
+            }
+            for (const char* option : {"incremental", "provenance", "lazy-provenance"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--specialise cannot be used with --") + option);
+                }
+            }
+        }
+
+        if (Global::config().has("bench")) {
+            EngineConfiguration::parseAll(Global::config().get("bench"));
+            // each run writes its outputs and profile to a directory of its own
+            if (Global::config().state("output-dir") == MainConfig::State::set) {
+                throw std::runtime_error("--bench cannot be used with --output-dir");
+            }
+            for (const char* option : {"compile", "dl-program", "generate", "swig", "show", "profile",
+                         "live-profile", "profile-stream", "provenance", "lazy-provenance"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--bench cannot be used with --") + option);
+                }
+            }
+        }
+
+        if (Global::config().has("tune")) {
+            if (Global::config().state("output-dir") == MainConfig::State::set) {
+                throw std::runtime_error("--tune cannot be used with --output-dir");
+            }
+            for (const char* option : {"bench", "dl-program", "generate", "swig", "show", "profile",
+                         "live-profile", "profile-stream", "provenance", "lazy-provenance"}) {
+                if (Global::config().has(option)) {
+                    throw std::runtime_error(std::string("--tune cannot be used with --") + option);
+                }
+            }
+        }
+
+        /* if a spill directory is given, check it exists */
+        if (Global::config().has("spill-dir") && !existDir(Global::config().get("spill-dir")) &&
+                !(Global::config().has("generate") ||
+                        (Global::config().has("dl-program") && !Global::config().has("compile")))) {
+            throw std::runtime_error(
+                    "spill directory " + Global::config().get("spill-dir") + " does not exists");
+        }
+
         /* verify all input directories exist (racey, but gives nicer error messages for common mistakes) */
         for (auto&& dir : Global::config().getMany("include-dir")) {
             if (!existDir(dir)) throw std::runtime_error("include directory `" + dir + "` does not exist");
@@ -366,9 +1122,48 @@ int main(int argc, char** argv) {
             Global::config().set("macro", allMacros);
         }
 
-        if (Global::config().has("live-profile") && !Global::config().has("profile")) {
+        if ((Global::config().has("live-profile") || Global::config().has("profile-stream")) &&
+                !Global::config().has("profile")) {
             Global::config().set("profile");
         }
+
+        if (Global::config().has("profile-sampling")) {
+            if (!Global::config().has("profile")) {
+                throw std::runtime_error("--profile-sampling requires a profile to be written by --profile.");
+            }
+            if (!isNumber(Global::config().get("profile-sampling").c_str())) {
+                throw std::runtime_error(
+                        "--profile-sampling must be set to a sampling interval in microseconds.");
+            }
+        }
+
+        if (Global::config().has("profile-counters") && !Global::config().has("profile")) {
+            throw std::runtime_error("--profile-counters requires a profile to be written by --profile.");
+        }
+
+        if (Global::config().has("memory-limit")) {
+            // the engine is given the limit in bytes
+            const std::string limit = Global::config().get("memory-limit");
+            std::size_t pos = 0;
+            unsigned long long bytes = 0;
+            try {
+                bytes = std::stoull(limit, &pos);
+            } catch (std::exception&) {
+                pos = 0;
+            }
+            const std::string suffix = pos == 0 ? limit : limit.substr(pos);
+            const std::map<std::string, unsigned long long> units = {
+                    {"", 1}, {"K", 1ULL << 10}, {"M", 1ULL << 20}, {"G", 1ULL << 30}};
+            if (pos == 0 || bytes == 0 || units.count(suffix) == 0) {
+                throw std::runtime_error(
+                        "--memory-limit must be set to a positive number of bytes, e.g. 2048M or 2G.");
+            }
+            Global::config().set("memory-limit", std::to_string(bytes * units.at(suffix)));
+        }
+
+        if (Global::config().has("profile-operators") && !Global::config().has("profile")) {
+            throw std::runtime_error("--profile-operators requires a profile to be written by --profile.");
+        }
     } catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         exit(EXIT_FAILURE);
@@ -389,40 +1184,125 @@ int main(int argc, char** argv) {
         throw std::runtime_error("failed to determine souffle executable path");
     }
 
-    /* Create the pipe to establish a communication between cpp and souffle */
-    std::string cmd = which("mcpp");
+    if (Global::config().has("bench")) {
+        try {
+            return benchmark(souffleExecutable, argc, argv);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
 
-    if (!isExecutable(cmd)) {
-        throw std::runtime_error("failed to locate mcpp pre-processor");
+    if (Global::config().has("tune")) {
+        try {
+            return tune(souffleExecutable, argc, argv);
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
     }
 
-    cmd += " -e utf8 -W0 ";
-    cmd += toString(join(Global::config().getMany("include-dir"), " ",
-            [&](auto&& os, auto&& dir) { tfm::format(os, "'-I%s'", dir); }));
-    if (Global::config().has("macro")) {
-        cmd += " " + Global::config().get("macro");
+    const bool builtinPreprocessor = Global::config().has("preprocessor", "builtin");
+
+    /* Create the pipe to establish a communication between cpp and souffle */
+    FILE* in = nullptr;
+    if (!builtinPreprocessor) {
+        std::string cmd = which("mcpp");
+
+        if (!isExecutable(cmd)) {
+            throw std::runtime_error("failed to locate mcpp pre-processor");
+        }
+
+        cmd += " -e utf8 -W0 ";
+        cmd += toString(join(Global::config().getMany("include-dir"), " ",
+                [&](auto&& os, auto&& dir) { tfm::format(os, "'-I%s'", dir); }));
+        if (Global::config().has("macro")) {
+            cmd += " " + Global::config().get("macro");
+        }
+        // Add RamDomain size as a macro
+        cmd += " -DRAM_DOMAIN_SIZE=" + std::to_string(RAM_DOMAIN_SIZE);
+        cmd += " '" + Global::config().get("") + "'";
+        in = popen(cmd.c_str(), "r");
     }
-    // Add RamDomain size as a macro
-    cmd += " -DRAM_DOMAIN_SIZE=" + std::to_string(RAM_DOMAIN_SIZE);
-    cmd += " '" + Global::config().get("") + "'";
-    FILE* in = popen(cmd.c_str(), "r");
 
     /* Time taking for parsing */
     auto parser_start = std::chrono::high_resolution_clock::now();
 
-    // ------- parse program -------------
-
-    // parse file
     ErrorReport errReport(Global::config().has("no-warn"));
     DebugReport debugReport;
-    Own<ast::TranslationUnit> astTranslationUnit =
-            ParserDriver::parseTranslationUnit("<stdin>", in, errReport, debugReport);
 
-    // close input pipe
-    int preprocessor_status = pclose(in);
-    if (preprocessor_status == -1) {
-        perror(nullptr);
-        throw std::runtime_error("failed to close pre-processor pipe");
+    // the built-in pre-processor expands the program into fragments, which are parsed in parallel
+    std::vector<std::string> fragments;
+    if (builtinPreprocessor) {
+        try {
+            Preprocessor preprocessor(
+                    Global::config().getMany("include-dir"), Global::config().get("preprocessor-cache"));
+            if (Global::config().has("macro")) {
+                preprocessor.defineAll(Global::config().get("macro"));
+            }
+            preprocessor.define("RAM_DOMAIN_SIZE=" + std::to_string(RAM_DOMAIN_SIZE));
+            fragments = preprocessor.process(Global::config().get(""));
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    // ------- load cached program -------------
+
+    // the pre-processed program is read at once to look it up in the cache, and parsed from memory
+    std::string source;
+    std::optional<json11::Json> ramCache;
+    if (Global::config().has("ram-cache")) {
+        if (builtinPreprocessor) {
+            for (const std::string& fragment : fragments) {
+                source += fragment;
+            }
+        } else {
+            source = readAll(in);
+            if (pclose(in) == -1) {
+                perror(nullptr);
+                throw std::runtime_error("failed to close pre-processor pipe");
+            }
+        }
+        ramCache = ramCacheKey(source);
+        if (auto cached = loadRamCache(Global::config().get("ram-cache"), *ramCache)) {
+            if (Global::config().has("verbose")) {
+                auto load_end = std::chrono::high_resolution_clock::now();
+                std::cout << "RAM cache load time: "
+                          << std::chrono::duration<double>(load_end - parser_start).count() << "sec\n";
+            }
+            auto ramTranslationUnit = mk<ram::TranslationUnit>(std::move(cached), errReport, debugReport);
+            try {
+                interpret(*ramTranslationUnit, souffleExecutable, argc, argv);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            return 0;
+        }
+        if (!builtinPreprocessor) {
+            in = fmemopen(source.data(), source.size(), "r");
+        }
+    }
+
+    // ------- parse program -------------
+
+    Own<ast::TranslationUnit> astTranslationUnit;
+    if (builtinPreprocessor) {
+        const std::string& jobs = Global::config().get("jobs");
+        astTranslationUnit = ParserDriver::parseTranslationUnit(
+                fragments, isNumber(jobs.c_str()) ? std::stoul(jobs) : 1, errReport, debugReport);
+    } else {
+        // parse file
+        astTranslationUnit = ParserDriver::parseTranslationUnit("<stdin>", in, errReport, debugReport);
+
+        // close input pipe
+        int preprocessor_status = ramCache ? fclose(in) : pclose(in);
+        if (preprocessor_status == -1) {
+            perror(nullptr);
+            throw std::runtime_error("failed to close pre-processor pipe");
+        }
     }
 
     /* Report run-time of the parser if verbose flag is set */
@@ -460,79 +1340,7 @@ int main(int argc, char** argv) {
     }
 
     /* construct the transformation pipeline */
-
-    // Equivalence pipeline
-    auto equivalencePipeline =
-            mk<ast::transform::PipelineTransformer>(mk<ast::transform::NameUnnamedVariablesTransformer>(),
-                    mk<ast::transform::FixpointTransformer>(mk<ast::transform::MinimiseProgramTransformer>()),
-                    mk<ast::transform::ReplaceSingletonVariablesTransformer>(),
-                    mk<ast::transform::RemoveRelationCopiesTransformer>(),
-                    mk<ast::transform::RemoveEmptyRelationsTransformer>(),
-                    mk<ast::transform::RemoveRedundantRelationsTransformer>());
-
-    // Magic-Set pipeline
-    auto magicPipeline = mk<ast::transform::PipelineTransformer>(mk<ast::transform::MagicSetTransformer>(),
-            mk<ast::transform::ResolveAliasesTransformer>(),
-            mk<ast::transform::RemoveRelationCopiesTransformer>(),
-            mk<ast::transform::RemoveEmptyRelationsTransformer>(),
-            mk<ast::transform::RemoveRedundantRelationsTransformer>(), clone(equivalencePipeline));
-
-    // Partitioning pipeline
-    auto partitionPipeline =
-            mk<ast::transform::PipelineTransformer>(mk<ast::transform::NameUnnamedVariablesTransformer>(),
-                    mk<ast::transform::PartitionBodyLiteralsTransformer>(),
-                    mk<ast::transform::ReplaceSingletonVariablesTransformer>());
-
-    // Provenance pipeline
-    auto provenancePipeline = mk<ast::transform::ConditionalTransformer>(Global::config().has("provenance"),
-            mk<ast::transform::PipelineTransformer>(mk<ast::transform::ExpandEqrelsTransformer>(),
-                    mk<ast::transform::NameUnnamedVariablesTransformer>()));
-
-    // Main pipeline
-    auto pipeline = mk<ast::transform::PipelineTransformer>(mk<ast::transform::ComponentChecker>(),
-            mk<ast::transform::ComponentInstantiationTransformer>(),
-            mk<ast::transform::IODefaultsTransformer>(),
-            mk<ast::transform::SimplifyAggregateTargetExpressionTransformer>(),
-            mk<ast::transform::UniqueAggregationVariablesTransformer>(),
-            mk<ast::transform::FixpointTransformer>(mk<ast::transform::PipelineTransformer>(
-                    mk<ast::transform::ResolveAnonymousRecordAliasesTransformer>(),
-                    mk<ast::transform::FoldAnonymousRecords>())),
-            mk<ast::transform::SubsumptionQualifierTransformer>(), mk<ast::transform::SemanticChecker>(),
-            mk<ast::transform::GroundWitnessesTransformer>(),
-            mk<ast::transform::UniqueAggregationVariablesTransformer>(),
-            mk<ast::transform::MaterializeSingletonAggregationTransformer>(),
-            mk<ast::transform::FixpointTransformer>(
-                    mk<ast::transform::MaterializeAggregationQueriesTransformer>()),
-            mk<ast::transform::RemoveRedundantSumsTransformer>(),
-            mk<ast::transform::NormaliseGeneratorsTransformer>(),
-            mk<ast::transform::ResolveAliasesTransformer>(),
-            mk<ast::transform::RemoveBooleanConstraintsTransformer>(),
-            mk<ast::transform::ResolveAliasesTransformer>(), mk<ast::transform::MinimiseProgramTransformer>(),
-            mk<ast::transform::InlineUnmarkExcludedTransform>(),
-            mk<ast::transform::InlineRelationsTransformer>(), mk<ast::transform::GroundedTermsChecker>(),
-            mk<ast::transform::ResolveAliasesTransformer>(),
-            mk<ast::transform::RemoveRedundantRelationsTransformer>(),
-            mk<ast::transform::RemoveRelationCopiesTransformer>(),
-            mk<ast::transform::RemoveEmptyRelationsTransformer>(),
-            mk<ast::transform::ReplaceSingletonVariablesTransformer>(),
-            mk<ast::transform::FixpointTransformer>(mk<ast::transform::PipelineTransformer>(
-                    mk<ast::transform::ReduceExistentialsTransformer>(),
-                    mk<ast::transform::RemoveRedundantRelationsTransformer>())),
-            mk<ast::transform::RemoveRelationCopiesTransformer>(), std::move(partitionPipeline),
-            std::move(equivalencePipeline), mk<ast::transform::RemoveRelationCopiesTransformer>(),
-            std::move(magicPipeline), mk<ast::transform::ReorderLiteralsTransformer>(),
-            mk<ast::transform::RemoveEmptyRelationsTransformer>(),
-            mk<ast::transform::AddNullariesToAtomlessAggregatesTransformer>(),
-            mk<ast::transform::ReorderLiteralsTransformer>(), mk<ast::transform::ExecutionPlanChecker>(),
-            std::move(provenancePipeline), mk<ast::transform::IOAttributesTransformer>());
-
-    // Disable unwanted transformations
-    if (Global::config().has("disable-transformers")) {
-        std::vector<std::string> givenTransformers =
-                splitString(Global::config().get("disable-transformers"), ',');
-        pipeline->disableTransformers(
-                std::set<std::string>(givenTransformers.begin(), givenTransformers.end()));
-    }
+    auto pipeline = makeAstTransformer();
 
     // Set up the debug report if necessary
     if (Global::config().has("debug-report")) {
@@ -605,6 +1413,13 @@ int main(int argc, char** argv) {
     // bail if we've nothing else left to show
     if (Global::config().has("show") && !hasShowOpt("initial-ram", "transformed-ram")) return 0;
 
+    // ------- specialisation -------------
+    if (Global::config().has("specialise")) {
+        debugReport.startSection();
+        specialise(*astTranslationUnit, errReport, debugReport);
+        debugReport.endSection("specialisation", "Specialise for static inputs");
+    }
+
     // ------- execution -------------
     /* translate AST to RAM */
     debugReport.startSection();
@@ -623,26 +1438,7 @@ int main(int argc, char** argv) {
     }
 
     // Apply RAM transforms
-    {
-        using namespace ram::transform;
-        Own<Transformer> ramTransform = mk<TransformerSequence>(
-                mk<LoopTransformer>(mk<TransformerSequence>(mk<ExpandFilterTransformer>(),
-                        mk<HoistConditionsTransformer>(), mk<MakeIndexTransformer>())),
-                mk<IfConversionTransformer>(), mk<IfExistsConversionTransformer>(),
-                mk<CollapseFiltersTransformer>(), mk<TupleIdTransformer>(),
-                mk<LoopTransformer>(
-                        mk<TransformerSequence>(mk<HoistAggregateTransformer>(), mk<TupleIdTransformer>())),
-                mk<ExpandFilterTransformer>(), mk<HoistConditionsTransformer>(),
-                mk<CollapseFiltersTransformer>(), mk<EliminateDuplicatesTransformer>(),
-                mk<ReorderConditionsTransformer>(), mk<LoopTransformer>(mk<ReorderFilterBreak>()),
-                mk<ConditionalTransformer>(
-                        // job count of 0 means all cores are used.
-                        []() -> bool { return std::stoi(Global::config().get("jobs")) != 1; },
-                        mk<ParallelTransformer>()),
-                mk<ReportIndexTransformer>());
-
-        ramTransform->apply(*ramTranslationUnit);
-    }
+    makeRamTransformer()->apply(*ramTranslationUnit);
 
     if (ramTranslationUnit->getErrorReport().getNumIssues() != 0) {
         std::cerr << ramTranslationUnit->getErrorReport();
@@ -666,29 +1462,11 @@ int main(int argc, char** argv) {
     try {
         if (must_interpret) {
             // ------- interpreter -------------
-
-            std::thread profiler;
-            // Start up profiler if needed
-            if (Global::config().has("live-profile")) {
-                profiler = std::thread([]() { profile::Tui().runProf(); });
-            }
-
-            // configure and execute interpreter
-            Own<interpreter::Engine> interpreter(mk<interpreter::Engine>(*ramTranslationUnit));
-            interpreter->executeMain();
-            // If the profiler was started, join back here once it exits.
-            if (profiler.joinable()) {
-                profiler.join();
-            }
-            if (Global::config().has("provenance")) {
-                // only run explain interface if interpreted
-                interpreter::ProgInterface interface(*interpreter);
-                if (Global::config().get("provenance") == "explain") {
-                    explain(interface, false);
-                } else if (Global::config().get("provenance") == "explore") {
-                    explain(interface, true);
-                }
+            if (ramCache) {
+                storeRamCache(Global::config().get("ram-cache"), *ramCache, astTranslationUnit->getProgram(),
+                        ramTranslationUnit->getProgram());
             }
+            interpret(*ramTranslationUnit, souffleExecutable, argc, argv);
         } else {
             // ------- compiler -------------
             // int jobs = std::stoi(Global::config().get("jobs"));
@@ -718,12 +1496,30 @@ int main(int argc, char** argv) {
             std::string baseIdentifier = identifier(simpleName(baseFilename));
             std::string sourceFilename = baseFilename + ".cpp";
 
+            // generated files, of which the first defines the entry points of the program
+            std::vector<std::string> sourceFilenames{sourceFilename};
+
             bool withSharedLibrary;
             auto synthesisStart = std::chrono::high_resolution_clock::now();
             const bool emitToStdOut = Global::config().has("generate", "-");
             if (emitToStdOut)
                 synthesiser->generateCode(std::cout, baseIdentifier, withSharedLibrary);
-            else {
+            else if (Global::config().has("compile-units") && !Global::config().has("swig")) {
+                // the SWIG interface is built from a single translation unit
+                synthesiser::SplitSources split;
+                split.headerName = simpleName(baseFilename) + ".h";
+                split.count = std::stoi(Global::config().get("compile-units"));
+                {
+                    std::ofstream os{sourceFilename};
+                    synthesiser->generateCode(os, baseIdentifier, withSharedLibrary, &split);
+                }
+                std::ofstream{baseFilename + ".h"} << split.header;
+                for (std::size_t i = 0; i < split.units.size(); ++i) {
+                    sourceFilenames.push_back(baseFilename + "_" + std::to_string(i) + ".cpp");
+                    std::ofstream{sourceFilenames.back()} << split.units[i];
+                }
+                sourceFilenames.push_back(baseFilename + ".h");
+            } else {
                 std::ofstream os{sourceFilename};
                 synthesiser->generateCode(os, baseIdentifier, withSharedLibrary);
             }
@@ -749,7 +1545,8 @@ int main(int argc, char** argv) {
                     throw std::runtime_error("failed to locate souffle-compile");
 
                 auto t_bgn = std::chrono::high_resolution_clock::now();
-                compileToBinary(souffle_compile, sourceFilename);
+                auto isSource = [](const std::string& name) { return endsWith(name, ".cpp"); };
+                compileToBinary(souffle_compile, filter(sourceFilenames, isSource));
                 auto t_end = std::chrono::high_resolution_clock::now();
 
                 if (Global::config().has("verbose")) {
@@ -760,7 +1557,7 @@ int main(int argc, char** argv) {
 
             // run compiled C++ program if requested.
             if (must_execute) {
-                executeBinaryAndExit(baseFilename);
+                executeBinaryAndExit(baseFilename, sourceFilenames);
             }
         }
     } catch (std::exception& e) {
@@ -33,6 +33,7 @@
 #include "reports/ErrorReport.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/FunctionalUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include "souffle/utility/tinyformat.h"
@@ -94,6 +95,63 @@ Own<ast::TranslationUnit> ParserDriver::parseTranslationUnit(
     return parser.parse(code, errorReport, debugReport);
 }
 
+Own<ast::TranslationUnit> ParserDriver::parse(const std::vector<std::string>& fragments, std::size_t jobs,
+        ErrorReport& errorReport, DebugReport& debugReport) {
+    // each fragment is parsed into a program of its own, reporting to a copy of the error report
+    std::vector<Own<ast::TranslationUnit>> units(fragments.size());
+    std::vector<ErrorReport> reports(fragments.size(), errorReport);
+    const std::size_t threads = jobs == 0 ? MAX_THREADS : jobs;
+    PARALLEL_START_THREADS(threads)
+        pfor(std::size_t i = 0; i < fragments.size(); ++i) {
+            ParserDriver driver;
+            units[i] = driver.parse(fragments[i], reports[i], debugReport);
+        }
+    PARALLEL_END
+
+    // merged in their order, the redefinitions across fragments are reported as by a single parse
+    translationUnit = mk<ast::TranslationUnit>(mk<ast::Program>(), errorReport, debugReport);
+    for (std::size_t i = 0; i < fragments.size(); ++i) {
+        errorReport.addDiagnostics(reports[i]);
+        addProgram(units[i]->getProgram());
+    }
+    return std::move(translationUnit);
+}
+
+Own<ast::TranslationUnit> ParserDriver::parseTranslationUnit(const std::vector<std::string>& fragments,
+        std::size_t jobs, ErrorReport& errorReport, DebugReport& debugReport) {
+    ParserDriver parser;
+    return parser.parse(fragments, jobs, errorReport, debugReport);
+}
+
+void ParserDriver::addProgram(ast::Program& program) {
+    for (auto& type : program.types) {
+        addType(std::move(type));
+    }
+    for (auto& functor : program.functors) {
+        addFunctorDeclaration(std::move(functor));
+    }
+    for (auto& [name, info] : program.relations) {
+        for (auto& decl : info.decls) {
+            addRelation(std::move(decl));
+        }
+        for (auto& clause : info.clauses) {
+            addClause(std::move(clause));
+        }
+        for (auto& directive : info.directives) {
+            addDirective(std::move(directive));
+        }
+    }
+    for (auto& component : program.components) {
+        addComponent(std::move(component));
+    }
+    for (auto& instantiation : program.instantiations) {
+        addInstantiation(std::move(instantiation));
+    }
+    for (auto& pragma : program.pragmas) {
+        addPragma(std::move(pragma));
+    }
+}
+
 void ParserDriver::addPragma(Own<ast::Pragma> p) {
     ast::Program& program = translationUnit->getProgram();
     program.addPragma(std::move(p));
@@ -128,25 +186,13 @@ void ParserDriver::addRelation(Own<ast::Relation> r) {
 
 void ParserDriver::addDirective(Own<ast::Directive> directive) {
     ast::Program& program = translationUnit->getProgram();
-    if (directive->getType() == ast::DirectiveType::printsize) {
-        for (const auto& cur : program.getDirectives()) {
-            if (cur->getQualifiedName() == directive->getQualifiedName() &&
-                    cur->getType() == ast::DirectiveType::printsize) {
-                Diagnostic err(Diagnostic::Type::ERROR,
-                        DiagnosticMessage("Redefinition of printsize directives for relation " +
-                                                  toString(directive->getQualifiedName()),
-                                directive->getSrcLoc()),
-                        {DiagnosticMessage("Previous definition", cur->getSrcLoc())});
-                translationUnit->getErrorReport().addDiagnostic(err);
-                return;
-            }
-        }
-    } else if (directive->getType() == ast::DirectiveType::limitsize) {
+    const auto type = directive->getType();
+    if (type == ast::DirectiveType::printsize || type == ast::DirectiveType::limitsize ||
+            type == ast::DirectiveType::goal) {
         for (const auto& cur : program.getDirectives()) {
-            if (cur->getQualifiedName() == directive->getQualifiedName() &&
-                    cur->getType() == ast::DirectiveType::limitsize) {
+            if (cur->getQualifiedName() == directive->getQualifiedName() && cur->getType() == type) {
                 Diagnostic err(Diagnostic::Type::ERROR,
-                        DiagnosticMessage("Redefinition of limitsize directives for relation " +
+                        DiagnosticMessage("Redefinition of " + toString(type) + " directives for relation " +
                                                   toString(directive->getQualifiedName()),
                                 directive->getSrcLoc()),
                         {DiagnosticMessage("Previous definition", cur->getSrcLoc())});
@@ -31,6 +31,7 @@
 #include "ast/Type.h"
 #include "parser/SrcLocation.h"
 #include "reports/DebugReport.h"
+#include <cstddef>
 #include <cstdio>
 #include <memory>
 #include <set>
@@ -77,6 +78,18 @@ public:
     static Own<ast::TranslationUnit> parseTranslationUnit(
             const std::string& code, ErrorReport& errorReport, DebugReport& debugReport);
 
+    /**
+     * Parse the fragments of a program, e.g., of the built-in pre-processor, by up to the given number
+     * of threads, or the system default for 0, and merge them in their order.
+     */
+    Own<ast::TranslationUnit> parse(const std::vector<std::string>& fragments, std::size_t jobs,
+            ErrorReport& errorReport, DebugReport& debugReport);
+    static Own<ast::TranslationUnit> parseTranslationUnit(const std::vector<std::string>& fragments,
+            std::size_t jobs, ErrorReport& errorReport, DebugReport& debugReport);
+
+    /** Add the items of a program parsed separately, checking them as items of the parsed program */
+    void addProgram(ast::Program& program);
+
     void warning(const SrcLocation& loc, const std::string& msg);
     void error(const SrcLocation& loc, const std::string& msg);
     void error(const std::string& msg);
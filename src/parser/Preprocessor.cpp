@@ -0,0 +1,1166 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Preprocessor.cpp
+ *
+ * Implements the built-in pre-processor.
+ *
+ ***********************************************************************/
+
+#include "parser/Preprocessor.h"
+#include "souffle/utility/FileUtil.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace souffle {
+
+namespace {
+
+/** The nesting of included files beyond which the inclusion is taken to be recursive */
+constexpr std::size_t maxIncludeDepth = 200;
+
+/** The number of skipped lines beyond which the output continues at a linemarker */
+constexpr std::size_t maxBlankLines = 8;
+
+/** FNV-1a, which is stable across platforms and builds */
+uint64_t hash(const std::string& text, uint64_t h = 0xcbf29ce484222325ULL) {
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+struct Token {
+    enum class Kind { Identifier, Number, String, Punctuator, Space, Newline, Placemarker };
+
+    Kind kind;
+    std::string text;
+
+    // the macros whose expansion resulted in the token, which are not expanded in it again
+    std::set<std::string> hidden;
+};
+
+using Tokens = std::vector<Token>;
+
+bool isIdentifierStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+bool isSpace(char c) {
+    return c != '\n' && std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+/** Split a text into pre-processing tokens, keeping its white space */
+Tokens tokenize(const std::string& text) {
+    Tokens tokens;
+    const std::size_t n = text.size();
+    std::size_t i = 0;
+    while (i < n) {
+        const std::size_t start = i;
+        const char c = text[i];
+        Token::Kind kind = Token::Kind::Punctuator;
+        if (c == '\n') {
+            ++i;
+            kind = Token::Kind::Newline;
+        } else if (isSpace(c)) {
+            while (i < n && isSpace(text[i])) {
+                ++i;
+            }
+            kind = Token::Kind::Space;
+        } else if (isIdentifierStart(c)) {
+            while (i < n && isIdentifierChar(text[i])) {
+                ++i;
+            }
+            kind = Token::Kind::Identifier;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) != 0) {
+            // a pre-processing number, e.g., 0x1F, 1.5e-3 or 192.168.0.1
+            for (++i; i < n; ++i) {
+                const char d = text[i];
+                const char prev = text[i - 1];
+                if (!isIdentifierChar(d) && d != '.' &&
+                        !((d == '+' || d == '-') && (prev == 'e' || prev == 'E'))) {
+                    break;
+                }
+            }
+            kind = Token::Kind::Number;
+        } else if (c == '"') {
+            for (++i; i < n && text[i] != '"' && text[i] != '\n'; ++i) {
+                if (text[i] == '\\' && i + 1 < n && text[i + 1] != '\n') {
+                    ++i;
+                }
+            }
+            if (i < n && text[i] == '"') {
+                ++i;
+            }
+            kind = Token::Kind::String;
+        } else if (text.compare(i, 2, "##") == 0) {
+            i += 2;
+        } else if (text.compare(i, 3, "...") == 0) {
+            i += 3;
+        } else {
+            ++i;
+        }
+        tokens.push_back({kind, text.substr(start, i - start), {}});
+    }
+    return tokens;
+}
+
+bool isBlank(const Token& token) {
+    return token.kind == Token::Kind::Space || token.kind == Token::Kind::Newline;
+}
+
+/** Remove the leading and trailing white space of tokens */
+Tokens trim(Tokens tokens) {
+    auto end = std::find_if_not(tokens.rbegin(), tokens.rend(), isBlank).base();
+    tokens.erase(end, tokens.end());
+    tokens.erase(tokens.begin(), std::find_if_not(tokens.begin(), tokens.end(), isBlank));
+    return tokens;
+}
+
+/** The string literal of the # operator for a macro argument */
+Token stringify(const Tokens& argument) {
+    std::string text = "\"";
+    bool space = false;
+    for (const Token& token : trim(argument)) {
+        if (isBlank(token)) {
+            space = true;
+            continue;
+        }
+        if (space) {
+            text += ' ';
+            space = false;
+        }
+        if (token.kind != Token::Kind::String) {
+            text += token.text;
+            continue;
+        }
+        for (char c : token.text) {
+            if (c == '"' || c == '\\') {
+                text += '\\';
+            }
+            text += c;
+        }
+    }
+    return {Token::Kind::String, text + "\"", {}};
+}
+
+/**
+ * Replace the comments of a text by a space, keeping the line breaks of block comments such that
+ * the lines of the text remain in place.
+ */
+std::string stripComments(const std::string& text, const std::string& path) {
+    std::string res;
+    res.reserve(text.size());
+    const std::size_t n = text.size();
+    std::size_t i = 0;
+    while (i < n) {
+        const char c = text[i];
+        if (c == '"') {
+            // copy string literals, which may contain comment delimiters
+            const std::size_t start = i;
+            for (++i; i < n && text[i] != '"' && text[i] != '\n'; ++i) {
+                if (text[i] == '\\' && i + 1 < n && text[i + 1] != '\n') {
+                    ++i;
+                }
+            }
+            if (i < n && text[i] == '"') {
+                ++i;
+            }
+            res.append(text, start, i - start);
+        } else if (text.compare(i, 2, "//") == 0) {
+            i = std::min(text.find('\n', i), n);
+            res += ' ';
+        } else if (text.compare(i, 2, "/*") == 0) {
+            const std::size_t end = text.find("*/", i + 2);
+            if (end == std::string::npos) {
+                throw std::runtime_error(path + ": error: unterminated comment");
+            }
+            res += ' ';
+            res.append(std::count(text.begin() + i, text.begin() + end, '\n'), '\n');
+            i = end + 2;
+        } else {
+            res += c;
+            ++i;
+        }
+    }
+    return res;
+}
+
+/** The value of an integer constant of a #if expression, or false if it is malformed */
+bool parseInteger(std::string text, long long& value) {
+    while (!text.empty() && std::strchr("uUlL", text.back()) != nullptr) {
+        text.pop_back();
+    }
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = static_cast<long long>(std::strtoull(text.c_str(), &end, 0));
+    return *end == '\0';
+}
+
+void writeString(std::ostream& out, const std::string& text) {
+    out << text.size() << ' ' << text << '\n';
+}
+
+bool readString(std::istream& in, std::string& text) {
+    std::size_t size = 0;
+    if (!(in >> size) || in.get() != ' ') {
+        return false;
+    }
+    text.resize(size);
+    return in.read(text.data(), size) && in.get() == '\n';
+}
+
+}  // namespace
+
+/**
+ * The state of the expansion of a file: the macros, the open conditionals and the piece of output
+ * being written.
+ */
+class Preprocessor::FileState {
+public:
+    FileState(Preprocessor& pp, std::string path, const MacroMap& macros, const std::set<std::string>& once,
+            std::size_t level)
+            : pp(pp), path(std::move(path)), level(level) {
+        result.macros = macros;
+        result.once = once;
+        startPiece(1);
+    }
+
+    /** Expand the contents of the file */
+    Expansion run(const std::string& contents, uint64_t contentHash) {
+        addDependency(path, contentHash);
+        const std::string text = stripComments(contents, path);
+        std::size_t pos = 0;
+        std::size_t line = 1;
+        while (pos < text.size()) {
+            // a logical line, joining the lines continued by a backslash
+            std::string logical;
+            std::size_t lines = 0;
+            while (pos < text.size()) {
+                const std::size_t end = std::min(text.find('\n', pos), text.size());
+                ++lines;
+                logical.append(text, pos, end - pos);
+                pos = end + 1;
+                if (logical.empty() || logical.back() != '\\') {
+                    break;
+                }
+                logical.pop_back();
+            }
+            processLine(logical, line, lines);
+            line += lines;
+        }
+        flush();
+        if (!conditionals.empty()) {
+            error(conditionals.back().line, "unterminated conditional directive");
+        }
+        endPiece();
+        return std::move(result);
+    }
+
+private:
+    struct Conditional {
+        // whether the enclosing group, this group, or any of the previous groups are included
+        bool enclosing;
+        bool active;
+        bool taken;
+
+        bool hasElse;
+        std::size_t line;
+    };
+
+    Preprocessor& pp;
+
+    const std::string path;
+
+    const std::size_t level;
+
+    Expansion result;
+
+    std::set<std::string> dependencies;
+
+    std::vector<Conditional> conditionals;
+
+    // the piece of output being written, and the line of the file its next line of output is at
+    Piece piece;
+    std::size_t outLine = 1;
+
+    // the lines of text not yet expanded, and the line they start at
+    std::string block;
+    std::size_t blockLine = 0;
+
+    [[noreturn]] void error(std::size_t line, const std::string& message) const {
+        throw std::runtime_error(path + ":" + std::to_string(line) + ": error: " + message);
+    }
+
+    bool active() const {
+        return conditionals.empty() || conditionals.back().active;
+    }
+
+    void addDependency(const std::string& file, uint64_t contentHash) {
+        if (dependencies.insert(file).second) {
+            result.dependencies.emplace_back(file, contentHash);
+        }
+    }
+
+    std::string linemarker(std::size_t line) const {
+        return "# " + std::to_string(line) + " \"" + path + "\"\n";
+    }
+
+    void startPiece(std::size_t line) {
+        piece = Piece();
+        piece.files = {path};
+        piece.text = linemarker(line);
+        outLine = line;
+    }
+
+    void endPiece() {
+        result.pieces.push_back(std::move(piece));
+    }
+
+    void processLine(const std::string& text, std::size_t line, std::size_t lines) {
+        const std::size_t first = text.find_first_not_of(" \t\r\v\f");
+        if (first != std::string::npos && text[first] == '#') {
+            flush();
+            directive(text.substr(first + 1), line, line + lines);
+        } else if (active()) {
+            if (block.empty()) {
+                blockLine = line;
+            }
+            block += text;
+            block.append(lines, '\n');
+        }
+    }
+
+    /** Expand the pending lines into the output */
+    void flush() {
+        if (block.empty()) {
+            return;
+        }
+        const Tokens tokens = expand(tokenize(block), blockLine);
+        block.clear();
+
+        // continue at the line of the block, by blank lines or a linemarker
+        if (blockLine > outLine && blockLine - outLine <= maxBlankLines) {
+            piece.text.append(blockLine - outLine, '\n');
+        } else if (blockLine != outLine) {
+            piece.text += linemarker(blockLine);
+        }
+        outLine = blockLine;
+
+        for (const Token& token : tokens) {
+            piece.text += token.text;
+            if (token.kind == Token::Kind::Newline) {
+                ++outLine;
+            }
+            if (isBlank(token) || token.kind == Token::Kind::Placemarker) {
+                continue;
+            }
+            if (token.text == "(" || token.text == "[" || token.text == "{") {
+                ++piece.depthChange;
+            } else if (token.text == ")" || token.text == "]" || token.text == "}") {
+                --piece.depthChange;
+            }
+            piece.last = token.text == "." || token.text == ")" || token.text == "}" ? token.text[0] : '?';
+        }
+    }
+
+    void directive(const std::string& text, std::size_t line, std::size_t nextLine) {
+        Tokens tokens = trim(tokenize(text));
+        if (tokens.empty()) {
+            return;
+        }
+        const std::string name = tokens.front().text;
+        const Tokens operands = trim(Tokens(tokens.begin() + 1, tokens.end()));
+        const std::string rest = text.substr(text.find(name) + name.size());
+
+        if (name == "if" || name == "ifdef" || name == "ifndef") {
+            const bool enclosing = active();
+            bool condition = false;
+            if (enclosing && name == "if") {
+                condition = evaluate(operands, line);
+            } else if (enclosing) {
+                if (operands.empty() || operands.front().kind != Token::Kind::Identifier) {
+                    error(line, "#" + name + " expects a macro name");
+                }
+                condition = (result.macros.count(operands.front().text) > 0) == (name == "ifdef");
+            }
+            conditionals.push_back({enclosing, condition, condition, false, line});
+        } else if (name == "elif") {
+            if (conditionals.empty() || conditionals.back().hasElse) {
+                error(line, "#elif without #if");
+            }
+            Conditional& cond = conditionals.back();
+            cond.active = cond.enclosing && !cond.taken && evaluate(operands, line);
+            cond.taken = cond.taken || cond.active;
+        } else if (name == "else") {
+            if (conditionals.empty() || conditionals.back().hasElse) {
+                error(line, "#else without #if");
+            }
+            Conditional& cond = conditionals.back();
+            cond.active = cond.enclosing && !cond.taken;
+            cond.taken = true;
+            cond.hasElse = true;
+        } else if (name == "endif") {
+            if (conditionals.empty()) {
+                error(line, "#endif without #if");
+            }
+            conditionals.pop_back();
+        } else if (!active()) {
+            return;
+        } else if (name == "include") {
+            include(operands, line, nextLine);
+        } else if (name == "define") {
+            std::string macroName;
+            Macro macro;
+            if (!parseMacro(rest, macroName, macro)) {
+                error(line, "malformed #define");
+            }
+            result.macros[macroName] = std::move(macro);
+        } else if (name == "undef") {
+            if (operands.empty() || operands.front().kind != Token::Kind::Identifier) {
+                error(line, "#undef expects a macro name");
+            }
+            result.macros.erase(operands.front().text);
+        } else if (name == "error") {
+            error(line, "#error" + rest);
+        } else if (name == "warning") {
+            std::cerr << path << ":" << line << ": warning: #warning" << rest << std::endl;
+        } else if (name == "pragma") {
+            if (!operands.empty() && operands.front().text == "once") {
+                result.once.insert(path);
+            }
+        } else {
+            error(line, "unknown directive #" + name);
+        }
+    }
+
+    void include(const Tokens& operands, std::size_t line, std::size_t nextLine) {
+        Tokens name = operands;
+        if (name.empty() || (name.front().kind != Token::Kind::String && name.front().text != "<")) {
+            name = trim(expand(operands, line));
+        }
+        std::string file;
+        bool quoted = false;
+        if (!name.empty() && name.front().kind == Token::Kind::String && name.front().text.size() >= 2) {
+            file = name.front().text.substr(1, name.front().text.size() - 2);
+            quoted = true;
+        } else if (!name.empty() && name.front().text == "<" && name.back().text == ">") {
+            for (std::size_t i = 1; i + 1 < name.size(); ++i) {
+                file += name[i].text;
+            }
+        } else {
+            error(line, "#include expects \"FILENAME\" or <FILENAME>");
+        }
+        if (level + 1 >= maxIncludeDepth) {
+            error(line, "#include nested too deeply");
+        }
+        const std::string target = pp.locate(file, quoted, path);
+        if (target.empty()) {
+            error(line, "cannot find include file " + file);
+        }
+        if (result.once.count(target) > 0) {
+            return;
+        }
+
+        // the included file starts pieces of its own, which are nested in this file
+        endPiece();
+        const Expansion& included = pp.expand(target, result.macros, result.once, level + 1);
+        for (const Piece& nested : included.pieces) {
+            result.pieces.push_back(nested);
+            result.pieces.back().files.insert(result.pieces.back().files.begin(), path);
+        }
+        result.macros = included.macros;
+        result.once = included.once;
+        for (const auto& [dependency, contentHash] : included.dependencies) {
+            addDependency(dependency, contentHash);
+        }
+        startPiece(nextLine);
+    }
+
+    /**
+     * Expand the macros of tokens, rescanning the result of each expansion with the tokens
+     * following it, where the tokens resulting from a macro are not expanded by that macro again.
+     */
+    Tokens expand(const Tokens& tokens, std::size_t line) {
+        std::deque<Token> input(tokens.begin(), tokens.end());
+        Tokens output;
+
+        // the line breaks of the arguments of invocations, which follow the line of the invocation
+        std::size_t newlines = 0;
+        while (!input.empty()) {
+            Token token = std::move(input.front());
+            input.pop_front();
+            if (token.kind == Token::Kind::Newline) {
+                output.insert(output.end(), newlines, token);
+                newlines = 0;
+            }
+            auto it = token.kind == Token::Kind::Identifier && token.hidden.count(token.text) == 0
+                              ? result.macros.find(token.text)
+                              : result.macros.end();
+            if (it == result.macros.end()) {
+                output.push_back(std::move(token));
+                continue;
+            }
+            const Macro& macro = it->second;
+            std::set<std::string> hidden = token.hidden;
+            hidden.insert(token.text);
+            if (!macro.functionLike) {
+                const Tokens replacement = substitute(macro, {}, hidden, line);
+                input.insert(input.begin(), replacement.begin(), replacement.end());
+                continue;
+            }
+
+            // a function-like macro is only invoked if followed by a parenthesis
+            std::size_t pos = 0;
+            while (pos < input.size() && isBlank(input[pos])) {
+                ++pos;
+            }
+            if (pos == input.size() || input[pos].text != "(") {
+                output.push_back(std::move(token));
+                continue;
+            }
+
+            // collect the arguments, which may span lines, replacing their line breaks by blanks
+            std::vector<Tokens> args(1);
+            newlines += std::count_if(input.begin(), input.begin() + pos,
+                    [](const Token& t) { return t.kind == Token::Kind::Newline; });
+            int depth = 0;
+            for (++pos; pos < input.size(); ++pos) {
+                Token arg = input[pos];
+                if (arg.kind == Token::Kind::Newline) {
+                    ++newlines;
+                    arg = {Token::Kind::Space, " ", {}};
+                } else if (arg.text == "(") {
+                    ++depth;
+                } else if (arg.text == ")" && depth == 0) {
+                    break;
+                } else if (arg.text == ")") {
+                    --depth;
+                } else if (arg.text == "," && depth == 0 &&
+                           !(macro.variadic && args.size() == macro.params.size())) {
+                    args.emplace_back();
+                    continue;
+                }
+                args.back().push_back(std::move(arg));
+            }
+            if (pos == input.size()) {
+                error(line, "unterminated argument list invoking macro " + token.text);
+            }
+            std::set<std::string> common;
+            std::set_intersection(token.hidden.begin(), token.hidden.end(), input[pos].hidden.begin(),
+                    input[pos].hidden.end(), std::inserter(common, common.end()));
+            common.insert(token.text);
+            input.erase(input.begin(), input.begin() + pos + 1);
+
+            const std::size_t expected = macro.params.size();
+            if (expected == 0 && args.size() == 1 && trim(args[0]).empty()) {
+                args.clear();
+            } else if (macro.variadic && args.size() + 1 == expected) {
+                args.emplace_back();
+            }
+            if (args.size() != expected) {
+                error(line, "macro " + token.text + " expects " + std::to_string(expected) +
+                                    " arguments, but " + std::to_string(args.size()) + " were given");
+            }
+
+            const Tokens replacement = substitute(macro, args, common, line);
+            input.insert(input.begin(), replacement.begin(), replacement.end());
+        }
+        output.insert(output.end(), newlines, Token{Token::Kind::Newline, "\n", {}});
+        return output;
+    }
+
+    /** Replace the parameters of the body of a macro by its arguments, applying # and ## */
+    Tokens substitute(const Macro& macro, const std::vector<Tokens>& args,
+            const std::set<std::string>& hidden, std::size_t line) {
+        const Tokens body = tokenize(macro.body);
+        auto param = [&](const Token& token) -> int {
+            if (token.kind != Token::Kind::Identifier) {
+                return -1;
+            }
+            auto it = std::find(macro.params.begin(), macro.params.end(), token.text);
+            return it == macro.params.end() ? -1 : static_cast<int>(it - macro.params.begin());
+        };
+        auto next = [&](std::size_t i) {
+            for (++i; i < body.size() && isBlank(body[i]); ++i) {
+            }
+            return i;
+        };
+
+        Tokens res;
+        for (std::size_t i = 0; i < body.size(); ++i) {
+            const Token& token = body[i];
+            const std::size_t following = next(i);
+            if (macro.functionLike && token.text == "#" && following < body.size() &&
+                    param(body[following]) >= 0) {
+                res.push_back(stringify(args[param(body[following])]));
+                i = following;
+            } else if (token.text == "##") {
+                if (res.empty() || following == body.size()) {
+                    error(line, "'##' cannot appear at either end of a macro expansion");
+                }
+                while (isBlank(res.back())) {
+                    res.pop_back();
+                }
+                const int p = param(body[following]);
+                Tokens rhs = p >= 0 ? trim(args[p]) : Tokens{body[following]};
+                if (res.back().kind == Token::Kind::Placemarker) {
+                    res.pop_back();
+                } else if (!rhs.empty()) {
+                    const Tokens pasted = tokenize(res.back().text + rhs.front().text);
+                    res.pop_back();
+                    rhs.erase(rhs.begin());
+                    rhs.insert(rhs.begin(), pasted.begin(), pasted.end());
+                }
+                if (rhs.empty()) {
+                    rhs.push_back({Token::Kind::Placemarker, "", {}});
+                }
+                res.insert(res.end(), rhs.begin(), rhs.end());
+                i = following;
+            } else if (param(token) >= 0) {
+                // arguments are expanded before substitution, unless they are operands of ##
+                const Tokens& arg = args[param(token)];
+                const Tokens value = following < body.size() && body[following].text == "##"
+                                             ? trim(arg)
+                                             : expand(trim(arg), line);
+                res.insert(res.end(), value.begin(), value.end());
+                if (value.empty()) {
+                    res.push_back({Token::Kind::Placemarker, "", {}});
+                }
+            } else {
+                res.push_back(token);
+            }
+        }
+
+        res.erase(std::remove_if(res.begin(), res.end(),
+                          [](const Token& t) { return t.kind == Token::Kind::Placemarker; }),
+                res.end());
+        for (Token& token : res) {
+            token.hidden.insert(hidden.begin(), hidden.end());
+        }
+        return res;
+    }
+
+    /** Evaluate the controlling expression of a #if or #elif */
+    bool evaluate(const Tokens& tokens, std::size_t line) {
+        // the defined operator is applied before the expansion of macros
+        Tokens replaced;
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens[i].text != "defined") {
+                replaced.push_back(tokens[i]);
+                continue;
+            }
+            std::size_t j = i + 1;
+            while (j < tokens.size() && isBlank(tokens[j])) {
+                ++j;
+            }
+            const bool parenthesised = j < tokens.size() && tokens[j].text == "(";
+            if (parenthesised) {
+                for (++j; j < tokens.size() && isBlank(tokens[j]); ++j) {
+                }
+            }
+            if (j == tokens.size() || tokens[j].kind != Token::Kind::Identifier) {
+                error(line, "operator \"defined\" requires an identifier");
+            }
+            const bool isDefined = result.macros.count(tokens[j].text) > 0;
+            if (parenthesised) {
+                for (++j; j < tokens.size() && isBlank(tokens[j]); ++j) {
+                }
+                if (j == tokens.size() || tokens[j].text != ")") {
+                    error(line, "missing ')' after \"defined\"");
+                }
+            }
+            replaced.push_back({Token::Kind::Number, isDefined ? "1" : "0", {}});
+            i = j;
+        }
+
+        // join adjacent characters of operators, and read the remaining identifiers as 0
+        std::vector<std::string> terms;
+        const Tokens expanded = expand(replaced, line);
+        for (std::size_t i = 0; i < expanded.size(); ++i) {
+            const Token& token = expanded[i];
+            if (isBlank(token)) {
+                continue;
+            }
+            if (token.kind == Token::Kind::Identifier) {
+                terms.push_back("0");
+                continue;
+            }
+            if (token.kind == Token::Kind::Punctuator && i + 1 < expanded.size()) {
+                const std::string pair = token.text + expanded[i + 1].text;
+                if (pair == "||" || pair == "&&" || pair == "==" || pair == "!=" || pair == "<=" ||
+                        pair == ">=" || pair == "<<" || pair == ">>") {
+                    terms.push_back(pair);
+                    ++i;
+                    continue;
+                }
+            }
+            terms.push_back(token.text);
+        }
+
+        Evaluator evaluator{*this, terms, 0, line};
+        const long long value = evaluator.conditional();
+        if (evaluator.pos != terms.size()) {
+            error(line, "malformed #if expression at '" + terms[evaluator.pos] + "'");
+        }
+        return value != 0;
+    }
+
+    /** A recursive descent evaluation of integer expressions */
+    struct Evaluator {
+        const FileState& state;
+        const std::vector<std::string>& terms;
+        std::size_t pos;
+        std::size_t line;
+
+        const std::string& peek() const {
+            static const std::string end;
+            return pos < terms.size() ? terms[pos] : end;
+        }
+
+        long long conditional() {
+            const long long cond = binary(0);
+            if (peek() != "?") {
+                return cond;
+            }
+            ++pos;
+            const long long then = conditional();
+            if (peek() != ":") {
+                state.error(line, "expected ':' in #if expression");
+            }
+            ++pos;
+            const long long otherwise = conditional();
+            return cond != 0 ? then : otherwise;
+        }
+
+        static int precedence(const std::string& op) {
+            static const std::map<std::string, int> precedences{{"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4},
+                    {"&", 5}, {"==", 6}, {"!=", 6}, {"<", 7}, {">", 7}, {"<=", 7}, {">=", 7}, {"<<", 8},
+                    {">>", 8}, {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10}};
+            auto it = precedences.find(op);
+            return it == precedences.end() ? -1 : it->second;
+        }
+
+        long long binary(int minPrecedence) {
+            long long lhs = unary();
+            while (precedence(peek()) > minPrecedence) {
+                const std::string op = terms[pos++];
+                const long long rhs = binary(precedence(op));
+                if ((op == "/" || op == "%") && rhs == 0) {
+                    state.error(line, "division by zero in #if expression");
+                }
+                lhs = op == "||"   ? (lhs != 0 || rhs != 0)
+                      : op == "&&" ? (lhs != 0 && rhs != 0)
+                      : op == "|"  ? lhs | rhs
+                      : op == "^"  ? lhs ^ rhs
+                      : op == "&"  ? lhs & rhs
+                      : op == "==" ? lhs == rhs
+                      : op == "!=" ? lhs != rhs
+                      : op == "<"  ? lhs < rhs
+                      : op == ">"  ? lhs > rhs
+                      : op == "<=" ? lhs <= rhs
+                      : op == ">=" ? lhs >= rhs
+                      : op == "<<" ? lhs << rhs
+                      : op == ">>" ? lhs >> rhs
+                      : op == "+"  ? lhs + rhs
+                      : op == "-"  ? lhs - rhs
+                      : op == "*"  ? lhs * rhs
+                      : op == "/"  ? lhs / rhs
+                                   : lhs % rhs;
+            }
+            return lhs;
+        }
+
+        long long unary() {
+            const std::string op = peek();
+            if (op == "+" || op == "-" || op == "!" || op == "~") {
+                ++pos;
+                const long long value = unary();
+                return op == "+" ? value : op == "-" ? -value : op == "!" ? value == 0 : ~value;
+            }
+            if (op == "(") {
+                ++pos;
+                const long long value = conditional();
+                if (peek() != ")") {
+                    state.error(line, "missing ')' in #if expression");
+                }
+                ++pos;
+                return value;
+            }
+            long long value = 0;
+            if (!parseInteger(op, value)) {
+                state.error(line, op.empty() ? "#if with no expression" : "invalid integer '" + op + "'");
+            }
+            ++pos;
+            return value;
+        }
+    };
+};
+
+Preprocessor::Preprocessor(std::vector<std::string> includeDirs, std::string cacheDir)
+        : includeDirs(std::move(includeDirs)), cacheDir(std::move(cacheDir)) {}
+
+bool Preprocessor::parseMacro(const std::string& text, std::string& name, Macro& macro) {
+    const Tokens tokens = tokenize(text);
+    std::size_t i = 0;
+    while (i < tokens.size() && isBlank(tokens[i])) {
+        ++i;
+    }
+    if (i == tokens.size() || tokens[i].kind != Token::Kind::Identifier) {
+        return false;
+    }
+    name = tokens[i++].text;
+    macro = Macro();
+
+    // the parameters of a function-like macro follow its name without a blank
+    if (i < tokens.size() && tokens[i].text == "(") {
+        macro.functionLike = true;
+        bool expectParam = true;
+        for (++i; i < tokens.size() && tokens[i].text != ")"; ++i) {
+            const Token& token = tokens[i];
+            if (isBlank(token)) {
+                continue;
+            }
+            if (expectParam && token.kind == Token::Kind::Identifier && !macro.variadic) {
+                macro.params.push_back(token.text);
+            } else if (expectParam && token.text == "..." && !macro.variadic) {
+                macro.params.push_back("__VA_ARGS__");
+                macro.variadic = true;
+            } else if (expectParam || token.text != ",") {
+                return false;
+            }
+            expectParam = !expectParam;
+        }
+        if (i == tokens.size() || (expectParam && !macro.params.empty())) {
+            return false;
+        }
+        ++i;
+    }
+
+    for (const Token& token : trim(Tokens(tokens.begin() + i, tokens.end()))) {
+        macro.body += token.text;
+    }
+    return true;
+}
+
+void Preprocessor::define(const std::string& definition) {
+    const std::size_t eq = definition.find('=');
+    const std::string text = eq == std::string::npos
+                                     ? definition + " 1"
+                                     : definition.substr(0, eq) + " " + definition.substr(eq + 1);
+    std::string name;
+    Macro macro;
+    if (!parseMacro(text, name, macro)) {
+        throw std::runtime_error("malformed macro definition " + definition);
+    }
+    predefined[name] = std::move(macro);
+}
+
+void Preprocessor::undefine(const std::string& name) {
+    predefined.erase(name);
+}
+
+void Preprocessor::defineAll(const std::string& options) {
+    // split the options into words as the shell does, e.g., `-DNAME='a b'`
+    std::vector<std::string> words;
+    std::string word;
+    bool inWord = false;
+    char quote = 0;
+    for (std::size_t i = 0; i < options.size(); ++i) {
+        const char c = options[i];
+        if (quote != 0 && c == quote) {
+            quote = 0;
+        } else if (quote == 0 && (c == '\'' || c == '"')) {
+            quote = c;
+            inWord = true;
+        } else if (quote != '\'' && c == '\\' && i + 1 < options.size()) {
+            word += options[++i];
+            inWord = true;
+        } else if (quote == 0 && std::isspace(static_cast<unsigned char>(c)) != 0) {
+            if (inWord) {
+                words.push_back(word);
+            }
+            word.clear();
+            inWord = false;
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    if (inWord) {
+        words.push_back(word);
+    }
+
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        const std::string option = words[i].substr(0, 2);
+        if (option != "-D" && option != "-U") {
+            throw std::runtime_error("unsupported pre-processor option " + words[i]);
+        }
+        std::string value = words[i].substr(2);
+        if (value.empty() && i + 1 < words.size()) {
+            value = words[++i];
+        }
+        if (option == "-D") {
+            define(value);
+        } else {
+            undefine(value);
+        }
+    }
+}
+
+std::vector<std::string> Preprocessor::process(const std::string& filename) {
+    if (!existFile(filename) || existDir(filename)) {
+        throw std::runtime_error("cannot open file " + filename);
+    }
+    const Expansion& expansion = expand(filename, predefined, {}, 0);
+
+    // a new fragment starts at a piece entered between two items of the program, i.e., outside
+    // of any parentheses, brackets and braces, and after a clause, declaration or component
+    std::vector<std::string> fragments;
+    bool hasTokens = false;
+    int depth = 0;
+    char last = 0;
+    for (const Piece& piece : expansion.pieces) {
+        if (fragments.empty() || (hasTokens && depth == 0 && last != '?')) {
+            // enter the files including the piece, such that the parser tracks the stack of files
+            fragments.emplace_back();
+            for (std::size_t i = 0; i + 1 < piece.files.size(); ++i) {
+                fragments.back() += "# 1 \"" + piece.files[i] + "\"\n";
+            }
+            hasTokens = false;
+        }
+        fragments.back() += piece.text;
+        depth += piece.depthChange;
+        if (piece.last != 0) {
+            last = piece.last;
+            hasTokens = true;
+        }
+    }
+    return fragments;
+}
+
+const Preprocessor::Expansion& Preprocessor::expand(const std::string& path, const MacroMap& macros,
+        const std::set<std::string>& once, std::size_t level) {
+    std::string contents;
+    if (!readFile(path, contents)) {
+        throw std::runtime_error("cannot read file " + path);
+    }
+    const uint64_t contentHash = hash(contents);
+
+    // the key covers the file, the state it is expanded in, and where its includes are found
+    std::string key = path + '\0' + std::to_string(contentHash) + '\0' +
+                      std::to_string(hashState(macros, once));
+    for (const std::string& dir : includeDirs) {
+        key += '\0' + dir;
+    }
+    const uint64_t keyHash = hash(key);
+
+    auto it = expansions.find(keyHash);
+    if (it != expansions.end()) {
+        return it->second;
+    }
+    Expansion expansion;
+    if (cacheDir.empty() || !load(keyHash, expansion)) {
+        expansion = FileState(*this, path, macros, once, level).run(contents, contentHash);
+        if (!cacheDir.empty()) {
+            store(keyHash, expansion);
+        }
+    }
+    return expansions.emplace(keyHash, std::move(expansion)).first->second;
+}
+
+std::string Preprocessor::locate(const std::string& name, bool quoted, const std::string& includer) const {
+    auto isFile = [](const std::string& file) { return existFile(file) && !existDir(file); };
+    if (!name.empty() && name[0] == '/') {
+        return isFile(name) ? name : "";
+    }
+    if (quoted) {
+        const std::string dir = dirName(includer);
+        const std::string file = dir == "." ? name : dir + "/" + name;
+        if (isFile(file)) {
+            return file;
+        }
+    }
+    for (const std::string& dir : includeDirs) {
+        const std::string file = dir == "." ? name : dir + "/" + name;
+        if (isFile(file)) {
+            return file;
+        }
+    }
+    return "";
+}
+
+uint64_t Preprocessor::hashState(const MacroMap& macros, const std::set<std::string>& once) {
+    std::string state;
+    for (const auto& [name, macro] : macros) {
+        state += name;
+        if (macro.functionLike) {
+            state += '(';
+            for (const std::string& param : macro.params) {
+                state += param + ',';
+            }
+            state += ')';
+        }
+        state += '\0' + macro.body + '\0';
+    }
+    for (const std::string& file : once) {
+        state += '\1' + file;
+    }
+    return hash(state);
+}
+
+namespace {
+
+std::string cacheFile(const std::string& dir, uint64_t key) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return dir + "/" + name + ".pp";
+}
+
+/** The header of the files of the cache, changed along with their format */
+const char* const cacheFormat = "souffle-preprocessor-cache 1";
+
+}  // namespace
+
+bool Preprocessor::load(uint64_t key, Expansion& expansion) const {
+    std::ifstream in(cacheFile(cacheDir, key), std::ios::binary);
+    std::string header;
+    if (!std::getline(in, header) || header != cacheFormat) {
+        return false;
+    }
+
+    // the entry is stale if any of the files read by the expansion changed
+    std::size_t count = 0;
+    in >> count;
+    for (std::size_t i = 0; i < count; ++i) {
+        uint64_t contentHash = 0;
+        std::string file;
+        std::string contents;
+        if (!(in >> contentHash) || !readString(in, file) || !readFile(file, contents) ||
+                hash(contents) != contentHash) {
+            return false;
+        }
+        expansion.dependencies.emplace_back(file, contentHash);
+    }
+
+    in >> count;
+    expansion.pieces.resize(count);
+    for (Piece& piece : expansion.pieces) {
+        std::size_t files = 0;
+        in >> files;
+        piece.files.resize(files);
+        for (std::string& file : piece.files) {
+            readString(in, file);
+        }
+        int last = 0;
+        in >> piece.depthChange >> last;
+        piece.last = static_cast<char>(last);
+        readString(in, piece.text);
+    }
+
+    in >> count;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string name;
+        std::size_t params = 0;
+        Macro macro;
+        readString(in, name);
+        in >> macro.functionLike >> macro.variadic >> params;
+        macro.params.resize(params);
+        for (std::string& param : macro.params) {
+            readString(in, param);
+        }
+        readString(in, macro.body);
+        expansion.macros[name] = std::move(macro);
+    }
+
+    in >> count;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string file;
+        readString(in, file);
+        expansion.once.insert(file);
+    }
+
+    if (!in) {
+        expansion = Expansion();
+        return false;
+    }
+    return true;
+}
+
+void Preprocessor::store(uint64_t key, const Expansion& expansion) const {
+    // entries are written aside and then renamed, such that they are never read partially
+    const std::string file = cacheFile(cacheDir, key);
+    const std::string temporary = file + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << cacheFormat << '\n';
+        out << expansion.dependencies.size() << '\n';
+        for (const auto& [dependency, contentHash] : expansion.dependencies) {
+            out << contentHash << ' ';
+            writeString(out, dependency);
+        }
+        out << expansion.pieces.size() << '\n';
+        for (const Piece& piece : expansion.pieces) {
+            out << piece.files.size() << '\n';
+            for (const std::string& f : piece.files) {
+                writeString(out, f);
+            }
+            out << piece.depthChange << ' ' << static_cast<int>(piece.last) << '\n';
+            writeString(out, piece.text);
+        }
+        out << expansion.macros.size() << '\n';
+        for (const auto& [name, macro] : expansion.macros) {
+            writeString(out, name);
+            out << macro.functionLike << ' ' << macro.variadic << ' ' << macro.params.size() << '\n';
+            for (const std::string& param : macro.params) {
+                writeString(out, param);
+            }
+            writeString(out, macro.body);
+        }
+        out << expansion.once.size() << '\n';
+        for (const std::string& f : expansion.once) {
+            writeString(out, f);
+        }
+        if (!out) {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    // the cache is an optimisation only, a failure to store an entry is not an error
+    if (std::rename(temporary.c_str(), file.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,131 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Preprocessor.h
+ *
+ * Defines the built-in pre-processor, an alternative to the external mcpp.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A C pre-processor for Datalog programs, supporting #include, object-like and function-like
+ * macros with # and ##, conditional compilation, #error, #warning and #pragma once. Its output
+ * carries linemarkers as the output of mcpp does, such that the parser locates the clauses in the
+ * original files.
+ *
+ * The expansion of each file is cached for the contents of the file and the macros defined before
+ * it, in memory and, if a cache directory is given, on disk for later runs. The output is split
+ * into fragments at the boundaries of included files between the items of the program, which may
+ * then be parsed independently.
+ *
+ * Errors, e.g., missing files or unterminated conditionals, are thrown as std::runtime_error.
+ */
+class Preprocessor {
+public:
+    Preprocessor(std::vector<std::string> includeDirs, std::string cacheDir = "");
+
+    /** Define a macro as the -D option of mcpp does, i.e., `NAME`, `NAME=BODY` or `NAME(ARGS)=BODY` */
+    void define(const std::string& definition);
+
+    /** Remove the definition of a macro */
+    void undefine(const std::string& name);
+
+    /** Define and remove the macros of the -D and -U options of a string, i.e., the `macro` option */
+    void defineAll(const std::string& options);
+
+    /** Expand the file, split into fragments each starting at a linemarker */
+    std::vector<std::string> process(const std::string& filename);
+
+private:
+    struct Macro {
+        bool functionLike = false;
+        bool variadic = false;
+        std::vector<std::string> params;
+        std::string body;
+    };
+
+    using MacroMap = std::map<std::string, Macro>;
+
+    /** The output between two boundaries of included files */
+    struct Piece {
+        // the stack of files the piece is in, starting at the expanded file
+        std::vector<std::string> files;
+
+        // the text, starting with a linemarker
+        std::string text;
+
+        // the change of the nesting of parentheses, brackets and braces by the text
+        int depthChange = 0;
+
+        // the last of its tokens, if it may end an item, i.e., '.', ')' or '}', '?' for any other
+        // token, or 0 if it has none
+        char last = 0;
+    };
+
+    /** The expansion of a file for the macros defined before it */
+    struct Expansion {
+        std::vector<Piece> pieces;
+
+        // the macros, and the files including `#pragma once`, after the file
+        MacroMap macros;
+        std::set<std::string> once;
+
+        // the files read, and the hashes of their contents
+        std::vector<std::pair<std::string, uint64_t>> dependencies;
+    };
+
+    class FileState;
+
+    /** Return the expansion of the file, from the cache if its contents and the macros are unchanged */
+    const Expansion& expand(const std::string& path, const MacroMap& macros,
+            const std::set<std::string>& once, std::size_t level);
+
+    /** Expand the file for the macros */
+    Expansion expandFile(const std::string& path, const std::string& contents, const MacroMap& macros,
+            const std::set<std::string>& once, std::size_t level);
+
+    /** Locate an included file, first in the directory of the including file for quoted names */
+    std::string locate(const std::string& name, bool quoted, const std::string& includer) const;
+
+    /** Load an expansion from the cache directory, if present and its dependencies are unchanged */
+    bool load(uint64_t key, Expansion& expansion) const;
+
+    /** Store an expansion in the cache directory */
+    void store(uint64_t key, const Expansion& expansion) const;
+
+    /** Parse the name and the definition of a macro following a #define, or return false */
+    static bool parseMacro(const std::string& text, std::string& name, Macro& macro);
+
+    /** The hash of the macros and files with `#pragma once` an expansion starts with */
+    static uint64_t hashState(const MacroMap& macros, const std::set<std::string>& once);
+
+    std::vector<std::string> includeDirs;
+
+    std::string cacheDir;
+
+    // the macros defined by options
+    MacroMap predefined;
+
+    // the expansions of this run
+    std::map<uint64_t, Expansion> expansions;
+};
+
+}  // end of namespace souffle
@@ -133,7 +133,10 @@
 %token BRIE_QUALIFIER            "BRIE datastructure qualifier"
 %token BTREE_QUALIFIER           "BTREE datastructure qualifier"
 %token BTREE_DELETE_QUALIFIER    "BTREE_DELETE datastructure qualifier"
+%token COLUMNAR_QUALIFIER        "COLUMNAR datastructure qualifier"
 %token EQREL_QUALIFIER           "equivalence relation qualifier"
+%token SMALL_QUALIFIER           "SMALL datastructure qualifier"
+%token SHARDED_QUALIFIER         "SHARDED datastructure qualifier"
 %token OVERRIDABLE_QUALIFIER     "relation qualifier overidable"
 %token INLINE_QUALIFIER          "relation qualifier inline"
 %token NO_INLINE_QUALIFIER       "relation qualifier no_inline"
@@ -142,6 +145,8 @@
 %token TMATCH                    "match predicate"
 %token TCONTAINS                 "checks whether substring is contained in a string"
 %token STATEFUL                  "stateful functor"
+%token THREAD_LOCAL              "thread-local functor context"
+%token CACHED                    "cached functor results"
 %token CAT                       "concatenation of strings"
 %token ORD                       "ordinal number of a string"
 %token RANGE                     "range"
@@ -151,6 +156,7 @@
 %token MIN                       "min aggregator"
 %token MAX                       "max aggregator"
 %token COUNT                     "count aggregator"
+%token COUNT_APPROX              "approximate count aggregator"
 %token SUM                       "sum aggregator"
 %token TRUE                      "true literal constraint"
 %token FALSE                     "false literal constraint"
@@ -163,6 +169,7 @@
 %token OUTPUT_DECL               "output directives declaration"
 %token PRINTSIZE_DECL            "printsize directives declaration"
 %token LIMITSIZE_DECL            "limitsize directives declaration"
+%token GOAL_DECL                 "goal directives declaration"
 %token OVERRIDE                  "override rules of super-component"
 %token TYPE                      "type declaration"
 %token COMPONENT                 "component declaration"
@@ -571,10 +578,22 @@ relation_tags
     {
       $$ = driver.addReprTag(RelationTag::BTREE_DELETE, @2, $1);
     }
+  | relation_tags COLUMNAR_QUALIFIER
+    {
+      $$ = driver.addReprTag(RelationTag::COLUMNAR, @2, $1);
+    }
   | relation_tags EQREL_QUALIFIER
     {
       $$ = driver.addReprTag(RelationTag::EQREL, @2, $1);
     }
+  | relation_tags SMALL_QUALIFIER
+    {
+      $$ = driver.addReprTag(RelationTag::SMALL, @2, $1);
+    }
+  | relation_tags SHARDED_QUALIFIER
+    {
+      $$ = driver.addReprTag(RelationTag::SHARDED, @2, $1);
+    }
   /* Deprecated Qualifiers */
   | relation_tags OUTPUT_QUALIFIER
     {
@@ -957,6 +976,7 @@ arg
       auto agg_2_func = [](AggregateOp op) -> char const* {
         switch (op) {
           case AggregateOp::COUNT : return {};
+          case AggregateOp::COUNT_APPROX : return {};
           case AggregateOp::MAX   : return "max";
           case AggregateOp::MEAN  : return {};
           case AggregateOp::MIN   : return "min";
@@ -1120,6 +1140,10 @@ aggregate_func
     {
       $$ = AggregateOp::COUNT;
     }
+  | COUNT_APPROX
+    {
+      $$ = AggregateOp::COUNT_APPROX;
+    }
   | MAX
     {
       $$ = AggregateOp::MAX;
@@ -1345,11 +1369,23 @@ component_init
 functor_decl
   : FUNCTOR IDENT LPAREN functor_arg_type_list[args] RPAREN COLON qualified_name
     {
-      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), false, @$);
+      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), false, false, false, @$);
+    }
+  | FUNCTOR IDENT LPAREN functor_arg_type_list[args] RPAREN COLON qualified_name CACHED
+    {
+      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), false, false, true, @$);
     }
   | FUNCTOR IDENT LPAREN functor_arg_type_list[args] RPAREN COLON qualified_name STATEFUL
     {
-      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), true, @$);
+      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), true, false, false, @$);
+    }
+  | FUNCTOR IDENT LPAREN functor_arg_type_list[args] RPAREN COLON qualified_name STATEFUL CACHED
+    {
+      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), true, false, true, @$);
+    }
+  | FUNCTOR IDENT LPAREN functor_arg_type_list[args] RPAREN COLON qualified_name STATEFUL THREAD_LOCAL
+    {
+      $$ = mk<ast::FunctorDeclaration>($IDENT, $args, mk<ast::Attribute>("return_type", $qualified_name, @qualified_name), true, true, false, @$);
     }
   ;
 
@@ -1435,6 +1471,10 @@ directive_head_decl
     {
       $$ = ast::DirectiveType::limitsize;
     }
+  | GOAL_DECL
+    {
+      $$ = ast::DirectiveType::goal;
+    }
   ;
 
 /**
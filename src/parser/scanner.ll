@@ -86,6 +86,7 @@ WS [ \t\r\v\f]
 ".output"/{WS}                        { return yy::parser::make_OUTPUT_DECL(yylloc); }
 ".printsize"/{WS}                     { return yy::parser::make_PRINTSIZE_DECL(yylloc); }
 ".limitsize"/{WS}                     { return yy::parser::make_LIMITSIZE_DECL(yylloc); }
+".goal"/{WS}                          { return yy::parser::make_GOAL_DECL(yylloc); }
 ".type"/{WS}                          { return yy::parser::make_TYPE(yylloc); }
 ".comp"/{WS}                          { return yy::parser::make_COMPONENT(yylloc); }
 ".init"/{WS}                          { return yy::parser::make_INSTANTIATE(yylloc); }
@@ -114,6 +115,8 @@ WS [ \t\r\v\f]
 "strlen"                              { return yy::parser::make_STRLEN(yylloc); }
 "substr"                              { return yy::parser::make_SUBSTR(yylloc); }
 "stateful"                            { return yy::parser::make_STATEFUL(yylloc); }
+"thread_local"                        { return yy::parser::make_THREAD_LOCAL(yylloc); }
+"cached"                              { return yy::parser::make_CACHED(yylloc); }
 "contains"                            { return yy::parser::make_TCONTAINS(yylloc); }
 "output"                              { return yy::parser::make_OUTPUT_QUALIFIER(yylloc); }
 "input"                               { return yy::parser::make_INPUT_QUALIFIER(yylloc); }
@@ -127,12 +130,16 @@ WS [ \t\r\v\f]
 "brie"                                { return yy::parser::make_BRIE_QUALIFIER(yylloc); }
 "btree_delete"                        { return yy::parser::make_BTREE_DELETE_QUALIFIER(yylloc); }
 "btree"                               { return yy::parser::make_BTREE_QUALIFIER(yylloc); }
+"columnar"                            { return yy::parser::make_COLUMNAR_QUALIFIER(yylloc); }
+"small"                               { return yy::parser::make_SMALL_QUALIFIER(yylloc); }
+"sharded"                             { return yy::parser::make_SHARDED_QUALIFIER(yylloc); }
 "min"                                 { return yy::parser::make_MIN(yylloc); }
 "max"                                 { return yy::parser::make_MAX(yylloc); }
 "as"                                  { return yy::parser::make_AS(yylloc); }
 "nil"                                 { return yy::parser::make_NIL(yylloc); }
 "_"                                   { return yy::parser::make_UNDERSCORE(yylloc); }
 "count"                               { return yy::parser::make_COUNT(yylloc); }
+"count_approx"                        { return yy::parser::make_COUNT_APPROX(yylloc); }
 "sum"                                 { return yy::parser::make_SUM(yylloc); }
 "true"                                { return yy::parser::make_TRUE(yylloc); }
 "false"                               { return yy::parser::make_FALSE(yylloc); }
@@ -0,0 +1,90 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Branches.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class Branches
+ * @brief Evaluate several operations on the tuples of the enclosing loop nest
+ *
+ * Branches let the rules sharing the outer scan of their queries share a
+ * single pass over the scanned relation. The branches are evaluated in
+ * order and may not break the enclosing loop.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * QUERY
+ *  FOR t0 IN edge
+ *   BRANCH
+ *    INSERT (t0.0) INTO a
+ *   BRANCH
+ *    FOR t1 IN b
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class Branches : public Operation {
+public:
+    Branches(VecOwn<Operation> branches) : branches(std::move(branches)) {
+        assert(allValidPtrs(this->branches));
+    }
+
+    /** @brief Get the branches */
+    std::vector<Operation*> getBranches() const {
+        return toPtrVector(branches);
+    }
+
+    Branches* cloning() const override {
+        return new Branches(clone(branches));
+    }
+
+    void apply(const NodeMapper& map) override {
+        for (auto& branch : branches) {
+            branch = map(std::move(branch));
+        }
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        for (const auto& branch : branches) {
+            os << times(" ", tabpos) << "BRANCH" << std::endl;
+            Operation::print(branch.get(), os, tabpos + 1);
+        }
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<Branches>(node);
+        return equal_targets(branches, other.branches);
+    }
+
+    NodeVec getChildren() const override {
+        return toPtrVector<Node const>(branches);
+    }
+
+    /** Branches */
+    VecOwn<Operation> branches;
+};
+
+}  // namespace souffle::ram
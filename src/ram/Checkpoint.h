@@ -0,0 +1,109 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Checkpoint.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Statement.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class Checkpoint
+ * @brief Complete or resume the checkpoint of a step of the evaluation
+ *
+ * Completing a checkpoint saves the symbol table and record table, once
+ * the relations needed by later steps are spilled to the given files, and
+ * marks the step as completed (see souffle/io/Checkpoint.h). Resuming a
+ * checkpoint restores both tables, before the relations are restored.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * CHECKPOINT 3 TO "dir"
+ * RESUME 3 FROM "dir"
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class Checkpoint : public Statement {
+public:
+    /** Complete the checkpoint of a step */
+    Checkpoint(std::string directory, std::size_t step, std::size_t steps, std::vector<std::string> files)
+            : directory(std::move(directory)), step(step), steps(steps), files(std::move(files)),
+              resume(false) {}
+
+    /** Resume the checkpoint of a step */
+    Checkpoint(std::string directory, std::size_t step)
+            : directory(std::move(directory)), step(step), steps(0), resume(true) {}
+
+    const std::string& getDirectory() const {
+        return directory;
+    }
+
+    /** @brief Get the index of the step */
+    std::size_t getStep() const {
+        return step;
+    }
+
+    /** @brief Get the number of steps of the program */
+    std::size_t getSteps() const {
+        return steps;
+    }
+
+    /** @brief Get the files of the relations of the checkpoint */
+    const std::vector<std::string>& getFiles() const {
+        return files;
+    }
+
+    bool isResume() const {
+        return resume;
+    }
+
+    Checkpoint* cloning() const override {
+        return resume ? new Checkpoint(directory, step) : new Checkpoint(directory, step, steps, files);
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << (resume ? "RESUME " : "CHECKPOINT ") << step
+           << (resume ? " FROM \"" : " TO \"") << directory << "\"" << std::endl;
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<Checkpoint>(node);
+        return directory == other.directory && step == other.step && steps == other.steps &&
+               files == other.files && resume == other.resume;
+    }
+
+    /** Checkpoint directory */
+    const std::string directory;
+
+    /** Index of the step */
+    const std::size_t step;
+
+    /** Number of steps */
+    const std::size_t steps;
+
+    /** Files of the relations */
+    const std::vector<std::string> files;
+
+    /** Whether the checkpoint is resumed */
+    const bool resume;
+};
+
+}  // namespace souffle::ram
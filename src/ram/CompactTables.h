@@ -0,0 +1,67 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompactTables.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Statement.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace souffle::ram {
+
+/**
+ * @class CompactTables
+ * @brief Reclaim the records and symbols that no relation refers to
+ *
+ * The records and symbols reachable from the relations are renumbered
+ * densely, and so are the values of the relations. The types of records and
+ * ADTs are given as JSON, in the format of the "types" directive of IO
+ * statements, to find the records and symbols nested in records.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * COMPACT TABLES
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class CompactTables : public Statement {
+public:
+    CompactTables(std::string types) : types(std::move(types)) {}
+
+    /** @brief Get the record and ADT types, as JSON */
+    const std::string& getTypes() const {
+        return types;
+    }
+
+    CompactTables* cloning() const override {
+        return new CompactTables(types);
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "COMPACT TABLES" << std::endl;
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<CompactTables>(node);
+        return types == other.types;
+    }
+
+    /** Record and ADT types */
+    const std::string types;
+};
+
+}  // namespace souffle::ram
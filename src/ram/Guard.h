@@ -0,0 +1,95 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Guard.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Condition.h"
+#include "ram/Node.h"
+#include "ram/Statement.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class Guard
+ * @brief Evaluate a statement only if a condition holds
+ *
+ * Guards skip the rules of a fixpoint loop whose delta relations are all
+ * empty, without setting up any of their queries.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * GUARD (NOT ((@delta_A = ∅) AND (@delta_B = ∅)))
+ *   ...
+ * END GUARD
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class Guard : public Statement {
+public:
+    Guard(Own<Condition> condition, Own<Statement> statement)
+            : condition(std::move(condition)), statement(std::move(statement)) {
+        assert(this->condition != nullptr && "condition is a nullptr");
+        assert(this->statement != nullptr && "guarded statement is a nullptr");
+    }
+
+    /** @brief Get the condition under which the statement is evaluated */
+    const Condition& getCondition() const {
+        return *condition;
+    }
+
+    /** @brief Get the guarded statement */
+    const Statement& getStatement() const {
+        return *statement;
+    }
+
+    Guard* cloning() const override {
+        return new Guard(clone(condition), clone(statement));
+    }
+
+    void apply(const NodeMapper& map) override {
+        condition = map(std::move(condition));
+        statement = map(std::move(statement));
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "GUARD " << getCondition() << std::endl;
+        Statement::print(statement.get(), os, tabpos + 1);
+        os << times(" ", tabpos) << "END GUARD" << std::endl;
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<Guard>(node);
+        return equal_ptr(condition, other.condition) && equal_ptr(statement, other.statement);
+    }
+
+    NodeVec getChildren() const override {
+        return {condition.get(), statement.get()};
+    }
+
+    /** Condition under which the statement is evaluated */
+    Own<Condition> condition;
+
+    /** Guarded statement */
+    Own<Statement> statement;
+};
+
+}  // namespace souffle::ram
@@ -0,0 +1,134 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IndexIntersect.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/IndexOperation.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Relation.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class IndexIntersect
+ * @brief Search for tuples of a relation matching a criteria, whose value of
+ * one attribute is found in another relation as well
+ *
+ * The operation is equivalent to an index scan followed by a filter
+ * checking the existence of a partner tuple. The partner tuple agrees with
+ * the tuple of the scan on a single attribute; all its other attributes are
+ * bound by outer operations or left unspecified. Instead of checking the
+ * partner tuple for each tuple of the scan, both indexes are traversed in
+ * the order of the shared attribute, leapfrogging over the values absent
+ * in the other index. Hence, the operation takes time proportional to the
+ * smaller of both ranges rather than to the range of the scan.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *	 FOR t1 IN A ON INDEX t1.0 = t0.1 INTERSECT t1.1 WITH (t0.0,t1.1) IN A
+ *	 ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class IndexIntersect : public IndexOperation {
+public:
+    IndexIntersect(std::string rel, int ident, RamPattern queryPattern, std::size_t element,
+            Own<ExistenceCheck> partner, std::size_t partnerElement, Own<Operation> nested,
+            std::string profileText = "")
+            : IndexOperation(rel, ident, std::move(queryPattern), std::move(nested), std::move(profileText)),
+              element(element), partner(std::move(partner)), partnerElement(partnerElement) {
+        assert(this->partner != nullptr && "partner not set");
+        assert(element < getRangePattern().first.size() && "element out of range");
+        assert(partnerElement < this->partner->getValues().size() && "partner element out of range");
+    }
+
+    /** @brief Get the attribute of the scanned tuple shared with the partner */
+    std::size_t getElement() const {
+        return element;
+    }
+
+    /** @brief Get the existence check of the partner tuple */
+    const ExistenceCheck& getPartner() const {
+        return *partner;
+    }
+
+    /** @brief Get the attribute of the partner tuple shared with the scanned tuple */
+    std::size_t getPartnerElement() const {
+        return partnerElement;
+    }
+
+    void apply(const NodeMapper& map) override {
+        IndexOperation::apply(map);
+        partner = map(std::move(partner));
+    }
+
+    IndexIntersect* cloning() const override {
+        RamPattern resQueryPattern;
+        for (const auto& i : queryPattern.first) {
+            resQueryPattern.first.emplace_back(i->cloning());
+        }
+        for (const auto& i : queryPattern.second) {
+            resQueryPattern.second.emplace_back(i->cloning());
+        }
+        return new IndexIntersect(relation, getTupleId(), std::move(resQueryPattern), element, clone(partner),
+                partnerElement, clone(getOperation()), getProfileText());
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "FOR t" << getTupleId() << " IN " << relation;
+        printIndex(os);
+        os << " INTERSECT t" << getTupleId() << "." << element << " WITH " << *partner;
+        os << std::endl;
+        IndexOperation::print(os, tabpos + 1);
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<IndexIntersect>(node);
+        return IndexOperation::equal(other) && element == other.element &&
+               equal_ptr(partner, other.partner) && partnerElement == other.partnerElement;
+    }
+
+    NodeVec getChildren() const override {
+        auto res = IndexOperation::getChildren();
+        res.push_back(partner.get());
+        return res;
+    }
+
+    /** Attribute of the scanned tuple shared with the partner */
+    const std::size_t element;
+
+    /** Existence check of the partner tuple */
+    Own<ExistenceCheck> partner;
+
+    /** Attribute of the partner tuple shared with the scanned tuple */
+    const std::size_t partnerElement;
+};
+
+}  // namespace souffle::ram
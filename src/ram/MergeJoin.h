@@ -0,0 +1,102 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MergeJoin.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/IndexOperation.h"
+#include "ram/IndexScan.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class MergeJoin
+ * @brief Outer loop of a sort-merge join: search for tuples of a relation
+ * matching a criteria in the order of the join attribute
+ *
+ * The nested operation is an index scan of the inner relation, whose only
+ * value depending on the scanned tuple is an equality with the join
+ * attribute. Since the scanned tuples arrive in the order of the join
+ * attribute, the inner index is probed with non-decreasing keys. Each
+ * probe starts at the position of the previous one, such that both
+ * indexes are traversed in lockstep rather than by a descent from the
+ * root for each scanned tuple.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *	 FOR t0 IN A MERGE ON t0.1
+ *	  FOR t1 IN B ON INDEX t1.0 = t0.1
+ *	   ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class MergeJoin : public IndexScan {
+public:
+    MergeJoin(std::string rel, int ident, RamPattern queryPattern, std::size_t element, Own<Operation> nested,
+            std::string profileText = "")
+            : IndexScan(std::move(rel), ident, std::move(queryPattern), std::move(nested),
+                      std::move(profileText)),
+              element(element) {
+        assert(element < getRangePattern().first.size() && "element out of range");
+    }
+
+    /** @brief Get the join attribute of the scanned tuple */
+    std::size_t getElement() const {
+        return element;
+    }
+
+    MergeJoin* cloning() const override {
+        RamPattern resQueryPattern;
+        for (const auto& i : queryPattern.first) {
+            resQueryPattern.first.emplace_back(i->cloning());
+        }
+        for (const auto& i : queryPattern.second) {
+            resQueryPattern.second.emplace_back(i->cloning());
+        }
+        return new MergeJoin(relation, getTupleId(), std::move(resQueryPattern), element,
+                clone(getOperation()), getProfileText());
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "FOR t" << getTupleId() << " IN " << relation;
+        printIndex(os);
+        os << " MERGE ON t" << getTupleId() << "." << element;
+        os << std::endl;
+        IndexOperation::print(os, tabpos + 1);
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<MergeJoin>(node);
+        return IndexOperation::equal(other) && element == other.element;
+    }
+
+    /** Join attribute of the scanned tuple */
+    const std::size_t element;
+};
+
+}  // namespace souffle::ram
@@ -0,0 +1,81 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file NoveltyInsert.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Expression.h"
+#include "ram/Insert.h"
+#include "ram/Node.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class NoveltyInsert
+ * @brief Insert a tuple into the target relation, and also into the new
+ * relation if the tuple was not in the target relation before.
+ *
+ * The novelty of the tuple is reported by the insertion into the target
+ * relation itself, such that the recursive rules of a relation only read
+ * through its delta relation need neither check the relation before
+ * inserting into the new relation, nor merge the new relation into the
+ * relation after each iteration.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FOR t0 IN @delta_X
+ *   ...
+ *     INSERT (t0.a, t0.b) INTO X RECORDING NEW IN @new_X
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class NoveltyInsert : public Insert {
+public:
+    NoveltyInsert(std::string rel, VecOwn<Expression> expressions, std::string newRel)
+            : Insert(std::move(rel), std::move(expressions)), newRelation(std::move(newRel)) {}
+
+    /** @brief Get the relation recording the tuples new to the target relation */
+    const std::string& getNewRelation() const {
+        return newRelation;
+    }
+
+    NoveltyInsert* cloning() const override {
+        VecOwn<Expression> newValues;
+        for (auto& expr : expressions) {
+            newValues.emplace_back(expr->cloning());
+        }
+        return new NoveltyInsert(relation, std::move(newValues), newRelation);
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "INSERT (" << join(expressions, ", ", print_deref<Own<Expression>>()) << ") INTO " << relation
+           << " RECORDING NEW IN " << newRelation << std::endl;
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<NoveltyInsert>(node);
+        return Insert::equal(other) && newRelation == other.newRelation;
+    }
+
+    /** Relation recording the tuples new to the target relation */
+    std::string newRelation;
+};
+
+}  // namespace souffle::ram
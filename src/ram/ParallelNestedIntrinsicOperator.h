@@ -0,0 +1,62 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ParallelNestedIntrinsicOperator.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/AbstractParallel.h"
+#include "ram/Expression.h"
+#include "ram/NestedIntrinsicOperator.h"
+#include "ram/Operation.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <utility>
+
+namespace souffle::ram {
+
+/**
+ * @class ParallelNestedIntrinsicOperator
+ * @brief Run the values of an integer range in parallel
+ *
+ * The positions of the values are split into parts, which the threads
+ * run independently of each other.
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   PARALLEL RANGE(0, 100000000) INTO t0
+ *    ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class ParallelNestedIntrinsicOperator : public NestedIntrinsicOperator, public AbstractParallel {
+public:
+    using NestedIntrinsicOperator::NestedIntrinsicOperator;
+
+    ParallelNestedIntrinsicOperator* cloning() const override {
+        return new ParallelNestedIntrinsicOperator(op, clone(args), clone(getOperation()), getTupleId());
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos);
+        os << "PARALLEL " << op << "(" << join(args, ",", print_deref<Own<Expression>>()) << ") INTO t"
+           << getTupleId() << "\n";
+        NestedOperation::print(os, tabpos + 1);
+    }
+};
+
+}  // namespace souffle::ram
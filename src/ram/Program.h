@@ -69,6 +69,11 @@ public:
         return toPtrVector(relations);
     }
 
+    /** @brief Add a relation, e.g., a temporary relation introduced by a transformer */
+    void addRelation(Own<Relation> rel) {
+        relations.push_back(std::move(rel));
+    }
+
     /** @brief Get all subroutines of a RAM program */
     const std::map<std::string, Statement*> getSubroutines() const {
         std::map<std::string, Statement*> subroutineRefs;
@@ -17,11 +17,13 @@
 
 #include "RelationTag.h"
 #include "ram/Node.h"
+#include "souffle/BinaryConstraintOps.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include <cassert>
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -32,21 +34,27 @@ namespace souffle::ram {
 /**
  * @class Relation
  * @brief A RAM Relation in the RAM intermediate representation.
+ *
+ * A lattice relation keeps a single tuple for each key, i.e., for each
+ * value of all attributes but the last. Inserting a tuple replaces the
+ * tuple with the same key if the inserted value is better than the stored
+ * one with respect to the lattice order, and is dropped otherwise.
  */
 class Relation : public Node {
 public:
     Relation(std::string name, std::size_t arity, std::size_t auxiliaryArity,
             std::vector<std::string> attributeNames, std::vector<std::string> attributeTypes,
-            RelationRepresentation representation)
+            RelationRepresentation representation, std::optional<BinaryConstraintOp> latticeOp = {})
             : representation(representation), name(std::move(name)), arity(arity),
               auxiliaryArity(auxiliaryArity), attributeNames(std::move(attributeNames)),
-              attributeTypes(std::move(attributeTypes)) {
+              attributeTypes(std::move(attributeTypes)), latticeOp(latticeOp) {
         assert(this->attributeNames.size() == arity && "arity mismatch for attributes");
         assert(this->attributeTypes.size() == arity && "arity mismatch for types");
         for (std::size_t i = 0; i < arity; i++) {
             assert(!this->attributeNames[i].empty() && "no attribute name specified");
             assert(!this->attributeTypes[i].empty() && "no attribute type specified");
         }
+        assert((!latticeOp || arity > 1) && "lattice relation without key");
     }
 
     /** @brief Get name */
@@ -79,6 +87,17 @@ public:
         return name.at(0) == '@';
     }
 
+    /** @brief Is lattice relation, keeping the best tuple for each key */
+    bool isLattice() const {
+        return latticeOp.has_value();
+    }
+
+    /** @brief Get the order of a lattice relation, holding if the first value is better than the second */
+    BinaryConstraintOp getLatticeOp() const {
+        assert(isLattice() && "not a lattice relation");
+        return *latticeOp;
+    }
+
     /** @brief Get arity of relation */
     unsigned getArity() const {
         return arity;
@@ -95,7 +114,8 @@ public:
     }
 
     Relation* cloning() const override {
-        return new Relation(name, arity, auxiliaryArity, attributeNames, attributeTypes, representation);
+        return new Relation(
+                name, arity, auxiliaryArity, attributeNames, attributeTypes, representation, latticeOp);
     }
 
 protected:
@@ -112,6 +132,9 @@ protected:
             }
             out << ")";
             out << " " << representation;
+            if (latticeOp) {
+                out << " lattice(" << *latticeOp << ")";
+            }
         } else {
             out << " nullary";
         }
@@ -121,7 +144,7 @@ protected:
         const auto& other = asAssert<Relation>(node);
         return representation == other.representation && name == other.name && arity == other.arity &&
                auxiliaryArity == other.auxiliaryArity && attributeNames == other.attributeNames &&
-               attributeTypes == other.attributeTypes;
+               attributeTypes == other.attributeTypes && latticeOp == other.latticeOp;
     }
 
 protected:
@@ -142,6 +165,9 @@ protected:
 
     /** Type of attributes */
     const std::vector<std::string> attributeTypes;
+
+    /** Order of the last attribute of a lattice relation */
+    const std::optional<BinaryConstraintOp> latticeOp;
 };
 
 }  // namespace souffle::ram
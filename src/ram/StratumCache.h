@@ -0,0 +1,135 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file StratumCache.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Node.h"
+#include "ram/Statement.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <cassert>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class StratumCache
+ * @brief Evaluate the body of a stratum, or load its result from a cache
+ * across runs
+ *
+ * The fingerprint of the evaluation combines the key of the body with the
+ * contents of the relations the body reads. If the cache directory holds
+ * the result of an evaluation with the same fingerprint, the relations
+ * computed by the body are loaded from it instead of evaluating the body.
+ * Otherwise, the body is evaluated and the computed relations are stored
+ * in the cache (see souffle/io/StratumCache.h).
+ *
+ * For example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * CACHE stratum_3 IN "dir" KEY 2f0c... READING (A,B) COMPUTING (C)
+ *   ...
+ * END CACHE
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class StratumCache : public Statement {
+public:
+    StratumCache(std::string directory, std::string name, std::string key, std::vector<std::string> inputs,
+            std::vector<std::string> outputs, Own<Statement> body)
+            : directory(std::move(directory)), name(std::move(name)), key(std::move(key)),
+              inputs(std::move(inputs)), outputs(std::move(outputs)), body(std::move(body)) {
+        assert(this->body != nullptr && "Cached body is a null-pointer");
+    }
+
+    /** @brief Get the cache directory */
+    const std::string& getDirectory() const {
+        return directory;
+    }
+
+    /** @brief Get the name of the cache entry, i.e., of the stratum */
+    const std::string& getName() const {
+        return name;
+    }
+
+    /** @brief Get the key of the body, which changes whenever the body changes */
+    const std::string& getKey() const {
+        return key;
+    }
+
+    /** @brief Get the relations read by the body, and hence fingerprinted */
+    const std::vector<std::string>& getInputs() const {
+        return inputs;
+    }
+
+    /** @brief Get the relations computed by the body, and hence stored in the cache */
+    const std::vector<std::string>& getOutputs() const {
+        return outputs;
+    }
+
+    /** @brief Get the cached body */
+    const Statement& getBody() const {
+        return *body;
+    }
+
+    StratumCache* cloning() const override {
+        return new StratumCache(directory, name, key, inputs, outputs, clone(body));
+    }
+
+    void apply(const NodeMapper& map) override {
+        body = map(std::move(body));
+    }
+
+protected:
+    void print(std::ostream& os, int tabpos) const override {
+        os << times(" ", tabpos) << "CACHE " << name << " IN \"" << directory << "\" KEY " << key
+           << " READING (" << join(inputs, ",") << ") COMPUTING (" << join(outputs, ",") << ")"
+           << std::endl;
+        Statement::print(body.get(), os, tabpos + 1);
+        os << times(" ", tabpos) << "END CACHE" << std::endl;
+    }
+
+    bool equal(const Node& node) const override {
+        const auto& other = asAssert<StratumCache>(node);
+        return directory == other.directory && name == other.name && key == other.key &&
+               inputs == other.inputs && outputs == other.outputs && equal_ptr(body, other.body);
+    }
+
+    NodeVec getChildren() const override {
+        return {body.get()};
+    }
+
+    /** Cache directory */
+    const std::string directory;
+
+    /** Name of the cache entry */
+    const std::string name;
+
+    /** Key of the body */
+    const std::string key;
+
+    /** Relations read by the body */
+    const std::vector<std::string> inputs;
+
+    /** Relations computed by the body */
+    const std::vector<std::string> outputs;
+
+    /** Cached body */
+    Own<Statement> body;
+};
+
+}  // namespace souffle::ram
@@ -38,10 +38,12 @@ namespace souffle::ram {
 class UserDefinedOperator : public AbstractOperator {
 public:
     UserDefinedOperator(std::string n, std::vector<TypeAttribute> argsTypes, TypeAttribute returnType,
-            bool stateful, VecOwn<Expression> args)
+            bool stateful, bool threadLocal, bool cached, VecOwn<Expression> args)
             : AbstractOperator(std::move(args)), name(std::move(n)), argsTypes(std::move(argsTypes)),
-              returnType(returnType), stateful(stateful) {
+              returnType(returnType), stateful(stateful), threadLocal(threadLocal), cached(cached) {
         assert(argsTypes.size() == args.size());
+        assert((stateful || !threadLocal) && "only stateful functors have thread-local contexts");
+        assert(!(threadLocal && cached) && "functors with thread-local contexts are not cached");
     }
 
     /** @brief Get operator name */
@@ -64,8 +66,18 @@ public:
         return stateful;
     }
 
+    /** @brief Does the functor receive a context per thread? */
+    bool isThreadLocal() const {
+        return threadLocal;
+    }
+
+    /** @brief Are the results of the functor cached by its arguments? */
+    bool isCached() const {
+        return cached;
+    }
+
     UserDefinedOperator* cloning() const override {
-        auto* res = new UserDefinedOperator(name, argsTypes, returnType, stateful, {});
+        auto* res = new UserDefinedOperator(name, argsTypes, returnType, stateful, threadLocal, cached, {});
         for (auto& cur : arguments) {
             Expression* arg = cur->cloning();
             res->arguments.emplace_back(arg);
@@ -80,6 +92,12 @@ protected:
         if (stateful) {
             os << "_stateful";
         }
+        if (threadLocal) {
+            os << "_thread_local";
+        }
+        if (cached) {
+            os << "_cached";
+        }
         os << "(" << join(arguments, ",", [](std::ostream& out, const Own<Expression>& arg) { out << *arg; })
            << ")";
     }
@@ -87,7 +105,8 @@ protected:
     bool equal(const Node& node) const override {
         const auto& other = asAssert<UserDefinedOperator>(node);
         return AbstractOperator::equal(node) && name == other.name && argsTypes == other.argsTypes &&
-               returnType == other.returnType && stateful == other.stateful;
+               returnType == other.returnType && stateful == other.stateful &&
+               threadLocal == other.threadLocal && cached == other.cached;
     }
 
     /** Name of user-defined operator */
@@ -101,5 +120,11 @@ protected:
 
     /** Stateful */
     const bool stateful;
+
+    /** Thread-local context */
+    const bool threadLocal;
+
+    /** Results cached by the arguments */
+    const bool cached;
 };
 }  // namespace souffle::ram
@@ -15,6 +15,7 @@
  ***********************************************************************/
 
 #include "ram/analysis/Complexity.h"
+#include "Global.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
 #include "ram/EmptinessCheck.h"
@@ -25,10 +26,57 @@
 #include "ram/ProvenanceExistenceCheck.h"
 #include "ram/Relation.h"
 #include "ram/utility/Visitor.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/utility/StringUtil.h"
 #include <cassert>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
 
 namespace souffle::ram::analysis {
 
+void ComplexityAnalysis::run(const TranslationUnit& tUnit) {
+    ra = &tUnit.getAnalysis<RelationAnalysis>();
+    if (Global::config().has("profile-use")) {
+        auto run = std::make_shared<profile::ProgramRun>();
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+        conditionFrequencies = run->getConditionFrequencies();
+        profiled = !conditionFrequencies.empty();
+    }
+}
+
+double ComplexityAnalysis::getRank(const Condition* condition) const {
+    const int complexity = getComplexity(condition);
+    if (!profiled) {
+        return complexity;
+    }
+    // conditions missing from the profile are assumed to reject half of the tuples
+    double selectivity = 0.5;
+    auto pos = conditionFrequencies.find(getProfileKey(*condition));
+    if (pos != conditionFrequencies.end() && pos->second.first > 0) {
+        selectivity = static_cast<double>(pos->second.second) / static_cast<double>(pos->second.first);
+    }
+    if (selectivity >= 1) {
+        return std::numeric_limits<double>::max();
+    }
+    // conditions of complexity 0 still differ in their selectivity
+    return (complexity + 1) / (1 - selectivity);
+}
+
+std::string ComplexityAnalysis::getProfileKey(const Condition& condition) {
+    // the printed condition may contain any character, hence its FNV-1a hash is the key
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : toString(condition)) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
 int ComplexityAnalysis::getComplexity(const Node* node) const {
     // visitor
     class ValueComplexityVisitor : public Visitor<int> {
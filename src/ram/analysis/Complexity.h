@@ -13,13 +13,22 @@
  * Get the complexity of an expression/condition in terms of
  * database operations. The complexity of an expression/condition is a
  * weighted sum. The weights express the complexity of the terms.
+ *
+ * With `--profile-use`, the complexity of a condition is combined with
+ * the fraction of tuples passing it, as counted by the conditions
+ * instrumented in a profiled run.
  ***********************************************************************/
 
 #pragma once
 
+#include "ram/Condition.h"
 #include "ram/Node.h"
 #include "ram/TranslationUnit.h"
 #include "ram/analysis/Relation.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
 
 namespace souffle::ram::analysis {
 
@@ -36,17 +45,34 @@ public:
 
     static constexpr const char* name = "complexity-analysis";
 
-    void run(const TranslationUnit& tUnit) override {
-        ra = &tUnit.getAnalysis<RelationAnalysis>();
-    }
+    void run(const TranslationUnit& tUnit) override;
 
     /**
      * @brief Get complexity of a RAM expression/condition
      */
     int getComplexity(const Node* value) const;
 
+    /**
+     * @brief Get the rank of a condition of a conjunction, which is evaluated before the conditions
+     * of higher rank
+     *
+     * Without profile, the rank is the complexity of the condition. Otherwise, it is the expected
+     * cost of rejecting a tuple, i.e., the cost of the condition divided by the fraction of tuples
+     * it rejects.
+     */
+    double getRank(const Condition* condition) const;
+
+    /** @brief Get the key identifying the condition in the profile */
+    static std::string getProfileKey(const Condition& condition);
+
 protected:
     RelationAnalysis* ra{nullptr};
+
+    /** Number of tuples each condition was evaluated on and passed in the profile, by key */
+    std::map<std::string, std::pair<std::size_t, std::size_t>> conditionFrequencies;
+
+    /** Whether the conditions are ranked by the profile */
+    bool profiled = false;
 };
 
 }  // namespace souffle::ram::analysis
@@ -17,22 +17,48 @@
 #include "ram/analysis/Index.h"
 #include "Global.h"
 #include "RelationTag.h"
+#include "ram/AbstractAggregate.h"
+#include "ram/BinRelationStatement.h"
+#include "ram/Erase.h"
 #include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IO.h"
+#include "ram/IndexIntersect.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/MergeExtend.h"
+#include "ram/MergeJoin.h"
 #include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
+#include "ram/ParallelMergeJoin.h"
 #include "ram/Program.h"
+#include "ram/Query.h"
 #include "ram/Relation.h"
+#include "ram/RelationOperation.h"
+#include "ram/SignedConstant.h"
 #include "ram/Swap.h"
 #include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UnsignedConstant.h"
 #include "ram/analysis/Relation.h"
 #include "ram/utility/Utils.h"
 #include "ram/utility/Visitor.h"
+#include "souffle/RamTypes.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/StreamUtil.h"
+#include "souffle/utility/StringUtil.h"
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <iterator>
+#include <optional>
 #include <queue>
+#include <typeinfo>
 
 namespace souffle::ram::analysis {
 
@@ -377,6 +403,98 @@ const ChainOrderMap MinIndexSelectionStrategy::getChainsFromMatching(const MaxMa
     return chainToOrder;
 }
 
+bool CostIndexSelectionStrategy::relaxes(const SearchSignature& search, const SearchSignature& other) {
+    if (search == other || other.empty()) {
+        return false;
+    }
+    // the other search may only leave out equalities of the search
+    for (std::size_t i = 0; i < search.arity(); ++i) {
+        if (other[i] != search[i] &&
+                (other[i] != AttributeConstraint::None || search[i] != AttributeConstraint::Equal)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double CostIndexSelectionStrategy::getMatches(const SearchSignature& search) const {
+    // each equality is assumed to select the same fraction of the tuples, an inequality half of it
+    double constrained = 0;
+    for (auto constraint : search) {
+        if (constraint == AttributeConstraint::Equal) {
+            constrained += 1;
+        } else if (constraint == AttributeConstraint::Inequal) {
+            constrained += 0.5;
+        }
+    }
+    return std::pow(size, 1 - constrained / static_cast<double>(search.arity()));
+}
+
+std::size_t CostIndexSelectionStrategy::getNumIndexes(const SearchSet& searches) const {
+    return MinIndexSelectionStrategy::solve(searches).getAllOrders().size();
+}
+
+IndexCluster CostIndexSelectionStrategy::solve(const SearchSet& searches) const {
+    // an index is updated on each insertion and occupies memory for each tuple
+    const double indexCost = size * (1 + std::log2(size));
+    auto getWeight = [&](const SearchSignature& search) {
+        auto pos = weights.find(search);
+        return pos != weights.end() ? pos->second : 1.0;
+    };
+
+    // the rarest searches are the first to give up their indexes
+    std::vector<SearchSignature> candidates;
+    for (const auto& search : searches) {
+        if (contains(relaxable, search)) {
+            candidates.push_back(search);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+            [&](const auto& lhs, const auto& rhs) { return getWeight(lhs) < getWeight(rhs); });
+
+    SearchSet kept = searches;
+    SignatureMap relaxations;
+    for (const auto& search : candidates) {
+        // relax to the remaining search matching the fewest tuples
+        std::optional<SearchSignature> target;
+        for (const auto& other : kept) {
+            if (relaxes(search, other) && (!target || getMatches(other) < getMatches(*target))) {
+                target = other;
+            }
+        }
+        if (!target) {
+            continue;
+        }
+        SearchSet rest = kept;
+        rest.erase(search);
+        const double saved = static_cast<double>(getNumIndexes(kept) - getNumIndexes(rest)) * indexCost;
+        const double penalty = getWeight(search) * (getMatches(*target) - getMatches(search));
+        if (penalty < saved) {
+            kept = std::move(rest);
+            relaxations.insert({search, *target});
+        }
+    }
+
+    IndexCluster cover = MinIndexSelectionStrategy::solve(kept);
+    if (relaxations.empty()) {
+        return cover;
+    }
+
+    // a search may have been relaxed to a search that is relaxed later
+    for (auto& relaxation : relaxations) {
+        while (relaxations.count(relaxation.second) > 0) {
+            relaxation.second = relaxations.at(relaxation.second);
+        }
+    }
+
+    SignatureOrderMap indexSelection;
+    for (const auto& search : searches) {
+        auto pos = relaxations.find(search);
+        indexSelection.insert({search, cover.getLexOrder(pos != relaxations.end() ? pos->second : search)});
+    }
+    return IndexCluster(indexSelection, searches, cover.getAllOrders(), relaxations);
+}
+
 void IndexAnalysis::run(const TranslationUnit& translationUnit) {
     relAnalysis = &translationUnit.getAnalysis<RelationAnalysis>();
 
@@ -391,6 +509,11 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
     // 0-arity relation in a provenance program still need to be revisited.
     // visit all nodes to collect searches of each relation
 
+    // the partners of index intersections are searched in the order of their shared attribute
+    visit(translationUnit.getProgram(), [&](const IndexIntersect& intersect) {
+        intersectPartners[&intersect.getPartner()] = intersect.getPartnerElement();
+    });
+
     // visit all nodes to collect searches of each relation
     visit(translationUnit.getProgram(), [&](const Node& node) {
         if (const auto* indexSearch = as<IndexOperation>(node)) {
@@ -401,6 +524,9 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
             relationToSearches[provExists->getRelation()].insert(getSearchSignature(provExists));
         } else if (const auto* ramRel = as<Relation>(node)) {
             relationToSearches[ramRel->getName()].insert(getSearchSignature(ramRel));
+            if (ramRel->isLattice()) {
+                relationToSearches[ramRel->getName()].insert(getLatticeSearchSignature(ramRel));
+            }
         }
     });
 
@@ -434,12 +560,403 @@ void IndexAnalysis::run(const TranslationUnit& translationUnit) {
         }
     }
 
+    // the cost-based index selection is chosen by the pragma index-selection
+    const bool costBased = Global::config().has("index-selection") &&
+                           Global::config().get("index-selection") == "cost" &&
+                           !Global::config().has("provenance");
+    if (costBased) {
+        estimateWeights(translationUnit);
+    }
+
     // find optimal indexes for relations
     for (auto& relToSearch : relationToSearches) {
         const std::string& relation = relToSearch.first;
         auto& searches = relToSearch.second;
-        indexCover.insert({relation, solver->solve(searches)});
+        if (costBased) {
+            SearchSet relaxable;
+            for (const auto& search : searches) {
+                if (!contains(relationToFixedSearches[relation], search)) {
+                    relaxable.insert(search);
+                }
+            }
+            CostIndexSelectionStrategy strategy(
+                    relationToWeights[relation], relaxable, getSizeEstimate(relation));
+            indexCover.insert({relation, strategy.solve(searches)});
+        } else {
+            indexCover.insert({relation, solver->solve(searches)});
+        }
+    }
+
+    if (Global::config().has("on-demand-indexes") && !Global::config().has("provenance")) {
+        selectOnDemandIndexes(translationUnit);
+    }
+    if (Global::config().has("bloom-filters") && !Global::config().has("provenance")) {
+        selectFilteredRelations(translationUnit);
+    }
+    if (Global::config().has("narrow-columns") && !Global::config().has("provenance")) {
+        selectBoundedAttributes(translationUnit);
+    }
+}
+
+namespace {
+
+/** Visit the main program and the subroutines of a program, i.e., its strata; the main program is named "" */
+void visitStrata(const Program& program, const std::function<void(const std::string&, const Node&)>& visitor) {
+    visit(program.getMain(), [&](const Node& node) { visitor("", node); });
+    for (const auto& [name, stratum] : program.getSubroutines()) {
+        visit(*stratum, [&, name = name](const Node& node) { visitor(name, node); });
+    }
+}
+
+/** Get the strata writing each relation of a program */
+std::map<std::string, std::set<std::string>> getWriters(const Program& program) {
+    std::map<std::string, std::set<std::string>> writers;
+    visitStrata(program, [&](const std::string& stratum, const Node& node) {
+        if (const auto* insert = as<Insert>(node)) {
+            writers[insert->getRelation()].insert(stratum);
+        } else if (const auto* erase = as<Erase>(node)) {
+            writers[erase->getRelation()].insert(stratum);
+        } else if (const auto* io = as<IO>(node)) {
+            writers[io->getRelation()].insert(stratum);
+        } else if (const auto* binary = as<BinRelationStatement>(node)) {
+            writers[binary->getFirstRelation()].insert(stratum);
+            writers[binary->getSecondRelation()].insert(stratum);
+        }
+    });
+    return writers;
+}
+
+}  // namespace
+
+void IndexAnalysis::selectOnDemandIndexes(const TranslationUnit& translationUnit) {
+    // the strata, i.e., subroutines, writing each relation and searching each index of a relation
+    auto writers = getWriters(translationUnit.getProgram());
+    std::map<std::string, std::map<std::size_t, std::set<std::string>>> readers;
+    auto search = [&](const std::string& stratum, const std::string& relation, SearchSignature signature) {
+        if (signature.empty()) {
+            signature = SearchSignature::getFullSearchSignature(signature.arity());
+        }
+        readers[relation][indexCover.at(relation).getLexOrderNum(signature)].insert(stratum);
+    };
+    visitStrata(translationUnit.getProgram(), [&](const std::string& stratum, const Node& node) {
+        if (const auto* indexSearch = as<IndexOperation>(node)) {
+            search(stratum, indexSearch->getRelation(), getSearchSignature(indexSearch));
+        } else if (const auto* exists = as<ExistenceCheck>(node)) {
+            search(stratum, exists->getRelation(), getSearchSignature(exists));
+        }
+    });
+
+    // an index is not maintained on insertion until the relation is searched on it after its stratum
+    for (auto& [relation, cluster] : indexCover) {
+        const auto& rel = relAnalysis->lookup(relation);
+        const auto representation = rel.getRepresentation();
+        // lattice relations search the index of their key on insertion
+        if (representation == RelationRepresentation::EQREL ||
+                representation == RelationRepresentation::INFO || rel.isLattice()) {
+            continue;
+        }
+        const auto& written = writers[relation];
+        for (const auto& [indexPos, strata] : readers[relation]) {
+            // the first index is the main index, holding the tuples the others are built from
+            if (indexPos == 0) {
+                continue;
+            }
+            if (std::none_of(strata.begin(), strata.end(),
+                        [&](const std::string& stratum) { return contains(written, stratum); })) {
+                cluster.setOnDemand(indexPos);
+            }
+        }
+    }
+}
+
+void IndexAnalysis::selectFilteredRelations(const TranslationUnit& translationUnit) {
+    // the strata checking whether a relation contains a tuple
+    auto writers = getWriters(translationUnit.getProgram());
+    std::map<std::string, std::set<std::string>> checkers;
+    visitStrata(translationUnit.getProgram(), [&](const std::string& stratum, const Node& node) {
+        if (const auto* exists = as<ExistenceCheck>(node)) {
+            if (isTotalSignature(exists)) {
+                checkers[exists->getRelation()].insert(stratum);
+            }
+        }
+    });
+
+    // a relation checked once it is stable, i.e., after its stratum, is filtered
+    for (const auto& [relation, strata] : checkers) {
+        const auto& rel = relAnalysis->lookup(relation);
+        const auto representation = rel.getRepresentation();
+        // equivalence relations insert implied tuples and tuples cannot be erased from filters
+        if (rel.isTemp() || representation == RelationRepresentation::EQREL ||
+                representation == RelationRepresentation::BTREE_DELETE ||
+                representation == RelationRepresentation::INFO) {
+            continue;
+        }
+        const auto& written = writers[relation];
+        if (std::none_of(strata.begin(), strata.end(),
+                    [&](const std::string& stratum) { return contains(written, stratum); })) {
+            indexCover.at(relation).setFiltered();
+        }
+    }
+}
+
+namespace {
+
+/** The values of an attribute, as an interval of the values fitting into 16 bits or as unbounded */
+struct ValueBounds {
+    /** Least and greatest values tracked; values beyond them cannot be stored in fewer bits */
+    static constexpr RamSigned MIN_TRACKED = -(1 << 15);
+    static constexpr RamSigned MAX_TRACKED = (1 << 16) - 1;
+
+    bool empty = true;
+    bool unbounded = false;
+    RamSigned lower = 0;
+    RamSigned upper = 0;
+
+    static ValueBounds all() {
+        ValueBounds res;
+        res.empty = false;
+        res.unbounded = true;
+        return res;
+    }
+
+    static ValueBounds of(RamSigned value) {
+        if (value < MIN_TRACKED || value > MAX_TRACKED) {
+            return all();
+        }
+        ValueBounds res;
+        res.empty = false;
+        res.lower = value;
+        res.upper = value;
+        return res;
+    }
+
+    /** Extend the bounds to the values of other bounds, returning whether they changed */
+    bool extend(const ValueBounds& other) {
+        if (other.empty || unbounded) {
+            return false;
+        }
+        if (other.unbounded) {
+            *this = all();
+            return true;
+        }
+        if (empty) {
+            *this = other;
+            return true;
+        }
+        if (other.lower >= lower && other.upper <= upper) {
+            return false;
+        }
+        lower = std::min(lower, other.lower);
+        upper = std::max(upper, other.upper);
+        return true;
+    }
+};
+
+}  // namespace
+
+void IndexAnalysis::selectBoundedAttributes(const TranslationUnit& translationUnit) {
+    const Program& program = translationUnit.getProgram();
+
+    // only attributes of numbers and unsigned numbers are bounded; all others take any value, as do the
+    // relations of code generated for a host program, which may insert any tuple through the interface
+    const bool embedded = Global::config().has("generate") || Global::config().has("swig");
+    std::map<std::string, std::vector<ValueBounds>> bounds;
+    for (const auto* rel : program.getRelations()) {
+        auto& attributes = bounds[rel->getName()];
+        attributes.resize(rel->getArity());
+        for (std::size_t i = 0; i < rel->getArity(); ++i) {
+            const char type = rel->getAttributeTypes()[i][0];
+            if ((type != 'i' && type != 'u') || (embedded && !rel->isTemp())) {
+                attributes[i] = ValueBounds::all();
+            }
+        }
+    }
+
+    // loaded relations take any values, except the tables of facts embedded in the program
+    visit(program, [&](const IO& io) {
+        if (io.get("operation") != "input") {
+            return;
+        }
+        auto& attributes = bounds[io.getRelation()];
+        const auto& types = relAnalysis->lookup(io.getRelation()).getAttributeTypes();
+        const auto& directives = io.getDirectives();
+        if (io.get("IO") != "inline" || !contains(directives, "data")) {
+            for (auto& attribute : attributes) {
+                attribute = ValueBounds::all();
+            }
+            return;
+        }
+        for (const auto& line : splitString(directives.at("data"), '\n')) {
+            if (line.empty()) {
+                continue;
+            }
+            const auto fields = splitString(line, '\t');
+            for (std::size_t i = 0; i < attributes.size(); ++i) {
+                if (attributes[i].unbounded) {
+                    continue;
+                }
+                ValueBounds value = ValueBounds::all();
+                try {
+                    if (types[i][0] == 'u') {
+                        const RamUnsigned number = RamUnsignedFromString(fields.at(i));
+                        if (number <= static_cast<RamUnsigned>(ValueBounds::MAX_TRACKED)) {
+                            value = ValueBounds::of(static_cast<RamSigned>(number));
+                        }
+                    } else {
+                        value = ValueBounds::of(RamSignedFromString(fields.at(i)));
+                    }
+                } catch (...) {
+                    // malformed values are reported when the table is loaded
+                }
+                attributes[i].extend(value);
+            }
+        }
+    });
+
+    // the inserted values are constants or values of attributes of the tuples of relations, until the
+    // bounds of no attribute change anymore
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        visit(program, [&](const Query& query) {
+            std::map<std::size_t, std::string> tupleRelations;
+            visit(query, [&](const RelationOperation& operation) {
+                // the tuple of an aggregate holds its result
+                if (as<AbstractAggregate, AllowCrossCast>(operation) == nullptr) {
+                    tupleRelations[operation.getTupleId()] = operation.getRelation();
+                }
+            });
+            auto valueBounds = [&](const Expression& value) {
+                if (const auto* constant = as<SignedConstant>(value)) {
+                    return ValueBounds::of(constant->getConstant());
+                } else if (const auto* constant = as<UnsignedConstant>(value)) {
+                    const auto number = ramBitCast<RamUnsigned>(constant->getConstant());
+                    if (number <= static_cast<RamUnsigned>(ValueBounds::MAX_TRACKED)) {
+                        return ValueBounds::of(static_cast<RamSigned>(number));
+                    }
+                } else if (const auto* element = as<TupleElement>(value)) {
+                    auto pos = tupleRelations.find(element->getTupleId());
+                    if (pos != tupleRelations.end()) {
+                        return bounds[pos->second][element->getElement()];
+                    }
+                }
+                return ValueBounds::all();
+            };
+            visit(query, [&](const Insert& insert) {
+                const auto values = insert.getValues();
+                std::vector<std::string> targets{insert.getRelation()};
+                if (const auto* novelty = as<NoveltyInsert>(insert)) {
+                    targets.push_back(novelty->getNewRelation());
+                }
+                for (const auto& target : targets) {
+                    auto& attributes = bounds[target];
+                    for (std::size_t i = 0; i < values.size() && i < attributes.size(); ++i) {
+                        changed |= attributes[i].extend(valueBounds(*values[i]));
+                    }
+                }
+            });
+        });
+
+        // swapped relations exchange their tuples, and merged relations receive the tuples of others
+        auto merge = [&](const std::string& source, const std::string& target) {
+            auto& sourceAttributes = bounds[source];
+            auto& targetAttributes = bounds[target];
+            for (std::size_t i = 0; i < sourceAttributes.size() && i < targetAttributes.size(); ++i) {
+                changed |= targetAttributes[i].extend(sourceAttributes[i]);
+            }
+        };
+        visit(program, [&](const Swap& swap) {
+            merge(swap.getFirstRelation(), swap.getSecondRelation());
+            merge(swap.getSecondRelation(), swap.getFirstRelation());
+        });
+        visit(program, [&](const MergeExtend& extend) {
+            merge(extend.getSourceRelation(), extend.getTargetRelation());
+        });
+    }
+
+    for (auto& [relation, cluster] : indexCover) {
+        const auto& attributes = bounds[relation];
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            if (!attributes[i].empty && !attributes[i].unbounded) {
+                cluster.setBounds(i, attributes[i].lower, attributes[i].upper);
+            }
+        }
+    }
+}
+
+void IndexAnalysis::estimateWeights(const TranslationUnit& translationUnit) {
+    if (Global::config().has("profile-use")) {
+        auto run = std::make_shared<profile::ProgramRun>();
+        profile::Reader(Global::config().get("profile-use"), run).processFile();
+        for (const auto& [name, rel] : run->getRelationMap()) {
+            profiledSizes[rel->getName()] = rel->size();
+        }
+    }
+
+    // only index scans can be rewritten to search on the index of another search
+    visit(translationUnit.getProgram(), [&](const Node& node) {
+        if (const auto* indexSearch = as<IndexOperation>(node)) {
+            if (typeid(*indexSearch) != typeid(IndexScan)) {
+                relationToFixedSearches[indexSearch->getRelation()].insert(getSearchSignature(indexSearch));
+            }
+        } else if (const auto* exists = as<ExistenceCheck>(node)) {
+            relationToFixedSearches[exists->getRelation()].insert(getSearchSignature(exists));
+        } else if (const auto* provExists = as<ProvenanceExistenceCheck>(node)) {
+            relationToFixedSearches[provExists->getRelation()].insert(getSearchSignature(provExists));
+        } else if (const auto* ramRel = as<Relation>(node)) {
+            relationToFixedSearches[ramRel->getName()].insert(getSearchSignature(ramRel));
+            if (ramRel->isLattice()) {
+                relationToFixedSearches[ramRel->getName()].insert(getLatticeSearchSignature(ramRel));
+            }
+        }
+    });
+
+    // an inner search is evaluated for each tuple of the outermost scan of its query
+    visit(translationUnit.getProgram(), [&](const Query& query) {
+        const Operation* outer = &query.getOperation();
+        while (const auto* filter = as<Filter>(outer)) {
+            outer = &filter->getOperation();
+        }
+        const auto* outerScan = as<RelationOperation>(outer);
+        const double outerSize = outerScan != nullptr ? getSizeEstimate(outerScan->getRelation()) : 1;
+        visit(query, [&](const IndexOperation& indexSearch) {
+            const double frequency = (&indexSearch == outer) ? 1 : outerSize;
+            relationToWeights[indexSearch.getRelation()][getSearchSignature(&indexSearch)] += frequency;
+        });
+    });
+
+    // swapped relations share their indexes
+    visit(translationUnit.getProgram(), [&](const Swap& swap) {
+        auto& weightsA = relationToWeights[swap.getFirstRelation()];
+        auto& weightsB = relationToWeights[swap.getSecondRelation()];
+        SearchWeightMap weights = weightsA;
+        for (const auto& [search, weight] : weightsB) {
+            weights[search] += weight;
+        }
+        weightsA = weights;
+        weightsB = weights;
+
+        auto& fixedA = relationToFixedSearches[swap.getFirstRelation()];
+        auto& fixedB = relationToFixedSearches[swap.getSecondRelation()];
+        fixedA.insert(fixedB.begin(), fixedB.end());
+        fixedB.insert(fixedA.begin(), fixedA.end());
+    });
+}
+
+double IndexAnalysis::getSizeEstimate(const std::string& relation) const {
+    // relations missing from the profile are assumed to be of moderate size
+    constexpr double defaultSize = 1000;
+
+    // auxiliary relations, e.g., @delta_A and @new_A, are estimated by their relation
+    std::string name = relation;
+    if (!name.empty() && name[0] == '@' && name.find('_') != std::string::npos) {
+        name = name.substr(name.find('_') + 1);
+    }
+    auto pos = profiledSizes.find(name);
+    if (pos == profiledSizes.end()) {
+        return defaultSize;
     }
+    return std::max(1.0, static_cast<double>(pos->second));
 }
 
 void IndexAnalysis::print(std::ostream& os) const {
@@ -457,13 +974,32 @@ void IndexAnalysis::print(std::ostream& os) const {
             os << "\n";
         }
 
+        /* print searches that gave up their indexes */
+        for (auto& search : selection.getSearches()) {
+            if (selection.isRelaxed(search)) {
+                os << "\tRelaxed: " << search << " to " << selection.getRelaxedSearch(search) << "\n";
+            }
+        }
+
         /* print indexes */
         os << "\tNumber of Indexes: " << selection.getAllOrders().size() << "\n";
-        for (auto& order : selection.getAllOrders()) {
+        const auto orders = selection.getAllOrders();
+        for (std::size_t i = 0; i < orders.size(); ++i) {
             os << "\t\t";
-            os << join(order, "<") << "\n";
+            os << join(orders[i], "<");
+            if (selection.isOnDemand(i)) {
+                os << " (on demand)";
+            }
+            os << "\n";
             os << "\n";
         }
+        if (selection.isFiltered()) {
+            os << "\tBloom filter\n";
+        }
+        for (const auto& [attribute, bounds] : selection.getBounds()) {
+            os << "\tBounds of attribute " << attribute << ": [" << bounds.first << ", " << bounds.second
+               << "]\n";
+        }
     }
 }
 
@@ -506,6 +1042,16 @@ SearchSignature IndexAnalysis::getSearchSignature(const IndexOperation* search)
             keys[i] = AttributeConstraint::Inequal;
         }
     }
+    // an index intersection seeks the values of the shared attribute in order
+    if (const auto* intersect = as<IndexIntersect>(search)) {
+        keys[intersect->getElement()] = AttributeConstraint::Inequal;
+    }
+    // the outer loop of a merge join scans in the order of the join attribute
+    if (const auto* join = as<MergeJoin>(search)) {
+        keys[join->getElement()] = AttributeConstraint::Inequal;
+    } else if (const auto* join = as<ParallelMergeJoin>(search)) {
+        keys[join->getElement()] = AttributeConstraint::Inequal;
+    }
     return keys;
 }
 
@@ -533,13 +1079,26 @@ SearchSignature IndexAnalysis::getSearchSignature(const ProvenanceExistenceCheck
 
 SearchSignature IndexAnalysis::getSearchSignature(const ExistenceCheck* existCheck) const {
     const Relation* rel = &relAnalysis->lookup(existCheck->getRelation());
-    return searchSignature(rel->getArity(), existCheck->getValues());
+    auto keys = searchSignature(rel->getArity(), existCheck->getValues());
+    auto partner = intersectPartners.find(existCheck);
+    if (partner != intersectPartners.end()) {
+        keys[partner->second] = AttributeConstraint::Inequal;
+    }
+    return keys;
 }
 
 SearchSignature IndexAnalysis::getSearchSignature(const Relation* ramRel) const {
     return SearchSignature::getFullSearchSignature(ramRel->getArity());
 }
 
+SearchSignature IndexAnalysis::getLatticeSearchSignature(const Relation* ramRel) const {
+    SearchSignature keys(ramRel->getArity());
+    for (std::size_t i = 0; i + 1 < ramRel->getArity(); ++i) {
+        keys[i] = AttributeConstraint::Equal;
+    }
+    return keys;
+}
+
 bool IndexAnalysis::isTotalSignature(const AbstractExistenceCheck* existCheck) const {
     for (const auto& cur : existCheck->getValues()) {
         if (isUndefValue(cur)) {
@@ -23,6 +23,7 @@
 #include "ram/Relation.h"
 #include "ram/TranslationUnit.h"
 #include "ram/analysis/Relation.h"
+#include "souffle/RamTypes.h"
 #include "souffle/utility/MiscUtil.h"
 #include <algorithm>
 #include <cassert>
@@ -311,6 +312,7 @@ using SearchCollection = std::vector<SearchSignature>;
 using Chain = std::vector<SearchSignature>;
 using ChainOrderMap = std::vector<Chain>;
 using SignatureOrderMap = std::unordered_map<SearchSignature, LexOrder, SearchSignature::Hasher>;
+using SearchWeightMap = std::unordered_map<SearchSignature, double, SearchSignature::Hasher>;
 
 class SearchComparator {
 public:
@@ -442,6 +444,48 @@ protected:
     }
 };
 
+/**
+ * @class CostIndexSelectionStrategy
+ * @Brief computes an index cover weighing the cost of each index against the searches it serves
+ *
+ * The minimal index cover gives all searches equal weight. Here, each search is weighted by
+ * its estimated frequency, and each index costs the insertions into it and its memory, both
+ * growing with the size of the relation. A rare search adding equalities to another search
+ * of the relation gives up its index if scanning the extra tuples matched by the other
+ * search costs less than the index. Such a search is relaxed to the other search, whose
+ * index has to be used with the relaxed equalities checked by a filter, e.g., by the
+ * RelaxSearchTransformer.
+ *
+ * Only the relaxable searches may give up their indexes, i.e., index scans that can be
+ * rewritten, as opposed to existence checks.
+ */
+class CostIndexSelectionStrategy : public MinIndexSelectionStrategy {
+public:
+    CostIndexSelectionStrategy(SearchWeightMap weights, SearchSet relaxable, double size)
+            : weights(std::move(weights)), relaxable(std::move(relaxable)), size(std::max(size, 1.0)) {}
+
+    IndexCluster solve(const SearchSet& searches) const override;
+
+    /** @Brief check whether a search only adds equalities to another non-empty search */
+    static bool relaxes(const SearchSignature& search, const SearchSignature& other);
+
+protected:
+    /** @Brief estimated number of tuples matched by a search */
+    double getMatches(const SearchSignature& search) const;
+
+    /** @Brief number of indexes covering a set of searches */
+    std::size_t getNumIndexes(const SearchSet& searches) const;
+
+    /** estimated frequency of the searches */
+    SearchWeightMap weights;
+
+    /** searches that may give up their indexes */
+    SearchSet relaxable;
+
+    /** estimated size of the relation */
+    double size;
+};
+
 /**
  * @class IndexCluster
  * @Brief Encapsulates the result of the IndexAnalysis
@@ -450,8 +494,9 @@ protected:
 class IndexCluster {
 public:
     IndexCluster(const SignatureOrderMap& indexSelection, const SearchSet& searchSet,
-            const OrderCollection& orders)
-            : indexSelection(indexSelection), searches(searchSet.begin(), searchSet.end()), orders(orders) {}
+            const OrderCollection& orders, const SignatureMap& relaxations = {})
+            : indexSelection(indexSelection), searches(searchSet.begin(), searchSet.end()), orders(orders),
+              relaxations(relaxations) {}
 
     const OrderCollection getAllOrders() const {
         return orders;
@@ -472,10 +517,105 @@ public:
         return std::distance(orders.begin(), it);
     }
 
+    /**
+     * @Brief Find the search for equal values with the most attributes, all of which are bound
+     * @param bound Attributes bound to values, e.g., by outer loops
+     * @result the attributes of the search in ascending order; empty if there is no such search
+     */
+    std::vector<std::size_t> getLargestEqualitySearch(const std::vector<std::size_t>& bound) const {
+        std::vector<std::size_t> res;
+        for (const auto& search : searches) {
+            std::vector<std::size_t> equal;
+            bool usable = true;
+            for (std::size_t i = 0; i < search.arity() && usable; ++i) {
+                if (search[i] == AttributeConstraint::Equal) {
+                    equal.push_back(i);
+                    usable = std::find(bound.begin(), bound.end(), i) != bound.end();
+                } else if (search[i] == AttributeConstraint::Inequal) {
+                    usable = false;
+                }
+            }
+            if (usable && equal.size() > res.size()) {
+                res = std::move(equal);
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @Brief Check whether an index is only searched for equal values of all of its attributes
+     * @param order Lex-order of the index
+     * @result true if no search on the index has inequalities or leaves one of its attributes free
+     */
+    bool isEqualityIndex(const LexOrder& order) const {
+        bool used = false;
+        for (const auto& [search, lexOrder] : indexSelection) {
+            if (lexOrder != order) {
+                continue;
+            }
+            std::size_t numEqual = 0;
+            for (auto constraint : search) {
+                if (constraint == AttributeConstraint::Inequal) {
+                    return false;
+                }
+                numEqual += (constraint == AttributeConstraint::Equal) ? 1 : 0;
+            }
+            if (numEqual != order.size()) {
+                return false;
+            }
+            used = true;
+        }
+        return used;
+    }
+
+    /** @Brief Check whether a search gave up its index */
+    bool isRelaxed(SearchSignature cols) const {
+        return relaxations.count(cols) > 0;
+    }
+
+    /** @Brief Get the search whose index serves a relaxed search */
+    SearchSignature getRelaxedSearch(SearchSignature cols) const {
+        return relaxations.at(cols);
+    }
+
+    /** @Brief Build the index at the given position on demand, i.e., by the first search on it */
+    void setOnDemand(std::size_t indexPos) {
+        onDemand.insert(indexPos);
+    }
+
+    /** @Brief Check whether the index at the given position is built on demand */
+    bool isOnDemand(std::size_t indexPos) const {
+        return onDemand.count(indexPos) > 0;
+    }
+
+    /** @Brief Check the relation against a Bloom filter before searching it for a tuple */
+    void setFiltered() {
+        filtered = true;
+    }
+
+    /** @Brief Check whether the relation is checked against a Bloom filter */
+    bool isFiltered() const {
+        return filtered;
+    }
+
+    /** @Brief Bound the values of an attribute, such that it may be stored in fewer bits */
+    void setBounds(std::size_t attribute, RamSigned lower, RamSigned upper) {
+        bounds[attribute] = {lower, upper};
+    }
+
+    /** @Brief Get the least and greatest values of the bounded attributes */
+    const std::map<std::size_t, std::pair<RamSigned, RamSigned>>& getBounds() const {
+        return bounds;
+    }
+
 private:
     SignatureOrderMap indexSelection;
     SearchCollection searches;
     OrderCollection orders;
+    SignatureMap relaxations;
+    std::set<std::size_t> onDemand;
+    bool filtered = false;
+    std::map<std::size_t, std::pair<RamSigned, RamSigned>> bounds;
 };
 
 /**
@@ -524,6 +664,13 @@ public:
      */
     SearchSignature getSearchSignature(const Relation* ramRel) const;
 
+    /**
+     * @Brief Get the index signature of a lattice relation for its key, searched on insertion
+     * @param ramRel RAM-relation
+     * @result signature with equalities on all attributes but the last
+     */
+    SearchSignature getLatticeSearchSignature(const Relation* ramRel) const;
+
     /**
      * @Brief index signature of existence check resembles a total index
      * @param (provenance) existence check
@@ -543,6 +690,33 @@ private:
     Own<IndexSelectionStrategy> solver;
     std::map<std::string, IndexCluster> indexCover;
     std::map<std::string, SearchSet> relationToSearches;
+
+    /** estimated frequencies of the searches of relations, for the cost-based index selection */
+    std::map<std::string, SearchWeightMap> relationToWeights;
+
+    /** searches of relations that are not only used by index scans and hence keep their indexes */
+    std::map<std::string, SearchSet> relationToFixedSearches;
+
+    /** @Brief estimate the frequencies of the searches for the cost-based index selection */
+    void estimateWeights(const TranslationUnit& translationUnit);
+
+    /** @Brief estimated size of a relation, taken from the profile of --profile-use if available */
+    double getSizeEstimate(const std::string& relation) const;
+
+    /** relation sizes of the profile of --profile-use */
+    std::map<std::string, std::size_t> profiledSizes;
+
+    /** @Brief mark the secondary indexes only searched by strata not writing their relation as on demand */
+    void selectOnDemandIndexes(const TranslationUnit& translationUnit);
+
+    /** @Brief mark the relations checked for tuples only by strata not writing them as filtered */
+    void selectFilteredRelations(const TranslationUnit& translationUnit);
+
+    /** @Brief bound the attributes of relations only taking values of 8 or 16 bits */
+    void selectBoundedAttributes(const TranslationUnit& translationUnit);
+
+    /** partners of index intersections, mapped to the attribute shared with the scanned tuple */
+    std::map<const ExistenceCheck*, std::size_t> intersectPartners;
 };
 
 }  // namespace souffle::ram::analysis
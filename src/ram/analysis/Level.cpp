@@ -17,6 +17,7 @@
 #include "ram/analysis/Level.h"
 #include "ram/Aggregate.h"
 #include "ram/AutoIncrement.h"
+#include "ram/Branches.h"
 #include "ram/Break.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
@@ -29,6 +30,7 @@
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
+#include "ram/IndexIntersect.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
@@ -104,6 +106,25 @@ int LevelAnalysis::getLevel(const Node* node) const {
             return level;
         }
 
+        // index intersection
+        int visit_(type_identity<IndexIntersect>, const IndexIntersect& intersect) override {
+            int level = -1;
+            for (auto& index : intersect.getRangePattern().first) {
+                level = std::max(level, dispatch(*index));
+            }
+            for (auto& index : intersect.getRangePattern().second) {
+                level = std::max(level, dispatch(*index));
+            }
+            // the shared attribute of the partner refers to the scanned tuple itself
+            const auto& values = intersect.getPartner().getValues();
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                if (i != intersect.getPartnerElement()) {
+                    level = std::max(level, dispatch(*values[i]));
+                }
+            }
+            return level;
+        }
+
         // choice
         int visit_(type_identity<IfExists>, const IfExists& choice) override {
             return std::max(-1, dispatch(choice.getCondition()));
@@ -154,6 +175,11 @@ int LevelAnalysis::getLevel(const Node* node) const {
             return dispatch(b.getCondition());
         }
 
+        // branches
+        int visit_(type_identity<Branches>, const Branches&) override {
+            return -1;
+        }
+
         // guarded insert
         int visit_(type_identity<GuardedInsert>, const GuardedInsert& guardedInsert) override {
             int level = -1;
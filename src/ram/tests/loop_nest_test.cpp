@@ -0,0 +1,188 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file loop_nest_test.cpp
+ *
+ * Tests the reordering of the loop nests of queries.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "RelationTag.h"
+#include "ram/Constraint.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Negation.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/HoistScans.h"
+#include "ram/utility/LoopNest.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::test {
+
+namespace {
+
+Own<TranslationUnit> makeProgram(
+        ErrorReport& errorReport, DebugReport& debugReport, Own<Statement> main = mk<Sequence>()) {
+    VecOwn<Relation> rels;
+    for (const std::string name : {"A", "B", "C", "D"}) {
+        rels.push_back(mk<Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+                std::vector<std::string>{"i:number", "i:number"}, RelationRepresentation::BTREE));
+    }
+    auto prog = mk<Program>(std::move(rels), std::move(main), std::map<std::string, Own<Statement>>());
+    return mk<TranslationUnit>(std::move(prog), errorReport, debugReport);
+}
+
+RamPattern equalTo(Own<Expression> first, Own<Expression> second) {
+    RamPattern pattern;
+    pattern.first.push_back(clone(first));
+    pattern.first.push_back(clone(second));
+    pattern.second.push_back(std::move(first));
+    pattern.second.push_back(std::move(second));
+    return pattern;
+}
+
+Own<Condition> notInC(Own<Expression> value) {
+    return mk<Negation>(
+            mk<ExistenceCheck>("C", toVector<Own<Expression>>(std::move(value), mk<UndefValue>())));
+}
+
+}  // namespace
+
+TEST(LoopNest, Reorder) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    auto tUnit = makeProgram(errorReport, debugReport);
+    const auto& relAnalysis = tUnit->getAnalysis<analysis::RelationAnalysis>();
+
+    // D(x, w) :- A(x, y), B(y, w), !C(w), x != 5.
+    Query query(mk<Scan>("A", 0,
+            mk<IndexScan>("B", 1, equalTo(mk<TupleElement>(0, 1), mk<UndefValue>()),
+                    mk<Filter>(mk<Conjunction>(notInC(mk<TupleElement>(1, 1)),
+                                       mk<Constraint>(BinaryConstraintOp::NE, mk<TupleElement>(0, 0),
+                                               mk<SignedConstant>(5))),
+                            mk<Insert>("D", toVector<Own<Expression>>(
+                                                    mk<TupleElement>(0, 0), mk<TupleElement>(1, 1)))))));
+
+    auto nest = LoopNest::flatten(query, relAnalysis);
+    ASSERT_TRUE(nest != nullptr);
+    EXPECT_EQ(2u, nest->size());
+    EXPECT_EQ("A", nest->getRelation(0));
+    EXPECT_EQ("B", nest->getRelation(1));
+
+    // B is bound by A and vice versa
+    EXPECT_EQ(std::vector<std::size_t>({0}), nest->getBoundElements(1, {true, false}));
+    EXPECT_EQ(std::vector<std::size_t>({1}), nest->getBoundElements(0, {false, true}));
+    EXPECT_TRUE(nest->getBoundElements(1, {false, false}).empty());
+    EXPECT_EQ(1u, nest->getConditions(1, {false, false}).size());
+    EXPECT_EQ(1u, nest->getConditions(0, {false, true}).size());
+
+    // the conditions are checked as early as possible
+    auto all = [](std::size_t, const std::vector<std::size_t>& bound) { return bound; };
+    Query original(mk<Scan>("A", 0,
+            mk<Filter>(mk<Constraint>(BinaryConstraintOp::NE, mk<TupleElement>(0, 0), mk<SignedConstant>(5)),
+                    mk<IndexScan>("B", 1, equalTo(mk<TupleElement>(0, 1), mk<UndefValue>()),
+                            mk<Filter>(notInC(mk<TupleElement>(1, 1)),
+                                    mk<Insert>("D", toVector<Own<Expression>>(mk<TupleElement>(0, 0),
+                                                            mk<TupleElement>(1, 1))))))));
+    EXPECT_EQ(original, *nest->reorder({0, 1}, all));
+
+    Query expected(mk<Scan>("B", 0,
+            mk<Filter>(notInC(mk<TupleElement>(0, 1)),
+                    mk<IndexScan>("A", 1, equalTo(mk<UndefValue>(), mk<TupleElement>(0, 0)),
+                            mk<Filter>(mk<Constraint>(BinaryConstraintOp::NE, mk<TupleElement>(1, 0),
+                                               mk<SignedConstant>(5)),
+                                    mk<Insert>("D", toVector<Own<Expression>>(mk<TupleElement>(1, 0),
+                                                            mk<TupleElement>(0, 1))))))));
+    EXPECT_EQ(expected, *nest->reorder({1, 0}, all));
+
+    // bound attributes not searched on an index are filtered
+    auto none = [](std::size_t, const std::vector<std::size_t>&) { return std::vector<std::size_t>(); };
+    auto filtered = nest->reorder({1, 0}, none);
+    const auto* outerFilter = as<Filter>(as<Scan>(filtered->getOperation())->getOperation());
+    ASSERT_TRUE(outerFilter != nullptr);
+    const auto* inner = as<Scan>(outerFilter->getOperation());
+    ASSERT_TRUE(inner != nullptr);
+    EXPECT_EQ("A", inner->getRelation());
+    const auto* check = as<Filter>(inner->getOperation());
+    ASSERT_TRUE(check != nullptr);
+    EXPECT_EQ(Constraint(BinaryConstraintOp::EQ, mk<TupleElement>(1, 1), mk<TupleElement>(0, 0)),
+            *findConjunctiveTerms(&check->getCondition())[0]);
+}
+
+TEST(LoopNest, RangesAreNotFlattened) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    auto tUnit = makeProgram(errorReport, debugReport);
+    const auto& relAnalysis = tUnit->getAnalysis<analysis::RelationAnalysis>();
+
+    RamPattern range;
+    range.first.push_back(mk<TupleElement>(0, 1));
+    range.first.push_back(mk<UndefValue>());
+    range.second.push_back(mk<SignedConstant>(10));
+    range.second.push_back(mk<UndefValue>());
+    Query query(mk<Scan>("A", 0,
+            mk<IndexScan>("B", 1, std::move(range),
+                    mk<Insert>("D", toVector<Own<Expression>>(
+                                            mk<TupleElement>(0, 0), mk<TupleElement>(1, 1))))));
+    EXPECT_TRUE(LoopNest::flatten(query, relAnalysis) == nullptr);
+
+    // a single scan is no join
+    Query scan(mk<Scan>("A", 0,
+            mk<Insert>("D", toVector<Own<Expression>>(mk<TupleElement>(0, 0), mk<TupleElement>(0, 1)))));
+    EXPECT_TRUE(LoopNest::flatten(scan, relAnalysis) == nullptr);
+}
+
+TEST(LoopNest, HoistScans) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+
+    // D(x, w) :- A(x, _), B(v, w), v < 10.
+    auto tUnit = makeProgram(errorReport, debugReport,
+            mk<Query>(mk<Scan>("A", 0,
+                    mk<Scan>("B", 1,
+                            mk<Filter>(mk<Constraint>(BinaryConstraintOp::LT, mk<TupleElement>(1, 0),
+                                               mk<SignedConstant>(10)),
+                                    mk<Insert>("D", toVector<Own<Expression>>(mk<TupleElement>(0, 0),
+                                                            mk<TupleElement>(1, 1))))))));
+    EXPECT_TRUE(transform::HoistScansTransformer().apply(*tUnit));
+
+    // the filtered scan of B does not depend on A
+    Query expected(mk<Scan>("B", 0,
+            mk<Filter>(mk<Constraint>(BinaryConstraintOp::LT, mk<TupleElement>(0, 0), mk<SignedConstant>(10)),
+                    mk<Scan>("A", 1,
+                            mk<Insert>("D", toVector<Own<Expression>>(
+                                                    mk<TupleElement>(1, 0), mk<TupleElement>(0, 1)))))));
+    EXPECT_EQ(expected, tUnit->getProgram().getMain());
+
+    // the scans stay in place once the filtered scan is outermost
+    EXPECT_FALSE(transform::HoistScansTransformer().apply(*tUnit));
+}
+
+}  // namespace souffle::ram::test
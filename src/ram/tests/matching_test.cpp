@@ -118,4 +118,50 @@ TEST(Matching, TestOver64BitSignature) {
     EXPECT_EQ(num, 2);
 }
 
+TEST(Matching, EqualityIndex) {
+    TestAutoIndex order;
+    std::size_t arity = 3;
+
+    SearchSignature inequal(arity);
+    inequal[1] = AttributeConstraint::Inequal;
+
+    SearchSet searches = {setBits(arity, 1), setBits(arity, 3), setBits(arity, 4), inequal};
+    auto selection = order.solve(searches);
+
+    // x0 and x0,x1 share an index that is not always searched on all of its attributes
+    EXPECT_FALSE(selection.isEqualityIndex(selection.getLexOrder(setBits(arity, 1))));
+    // x2 is searched on its own
+    EXPECT_TRUE(selection.isEqualityIndex(selection.getLexOrder(setBits(arity, 4))));
+    // inequalities need ordered indices
+    EXPECT_FALSE(selection.isEqualityIndex(selection.getLexOrder(inequal)));
+}
+
+TEST(Matching, CostBasedRelaxation) {
+    std::size_t arity = 3;
+    SearchSet searches;
+    for (uint64_t pattern : {1, 3, 5, 7}) {
+        searches.insert(setBits(arity, pattern));
+    }
+    SearchSet relaxable = {setBits(arity, 5)};
+
+    // a rare search gives up its index
+    SearchWeightMap rare = {{setBits(arity, 5), 1}};
+    auto selection = CostIndexSelectionStrategy(rare, relaxable, 1000).solve(searches);
+    EXPECT_EQ(selection.getAllOrders().size(), 1);
+    EXPECT_TRUE(selection.isRelaxed(setBits(arity, 5)));
+    EXPECT_EQ(selection.getRelaxedSearch(setBits(arity, 5)), setBits(arity, 1));
+    EXPECT_EQ(selection.getLexOrder(setBits(arity, 5)), selection.getLexOrder(setBits(arity, 1)));
+
+    // a frequent search keeps its index
+    SearchWeightMap frequent = {{setBits(arity, 5), 1e9}};
+    selection = CostIndexSelectionStrategy(frequent, relaxable, 1000).solve(searches);
+    EXPECT_EQ(selection.getAllOrders().size(), 2);
+    EXPECT_FALSE(selection.isRelaxed(setBits(arity, 5)));
+
+    // a search only relaxes to a search leaving out some of its equalities
+    EXPECT_TRUE(CostIndexSelectionStrategy::relaxes(setBits(arity, 5), setBits(arity, 4)));
+    EXPECT_FALSE(CostIndexSelectionStrategy::relaxes(setBits(arity, 5), setBits(arity, 3)));
+    EXPECT_FALSE(CostIndexSelectionStrategy::relaxes(setBits(arity, 5), setBits(arity, 0)));
+}
+
 }  // namespace souffle::ram
@@ -79,13 +79,13 @@ TEST(UserDefinedOperator, CloneAndEquals) {
     a_args.emplace_back(new SignedConstant(1));
     a_args.emplace_back(new SignedConstant(10));
     UserDefinedOperator a("NE", {TypeAttribute::Signed, TypeAttribute::Signed}, TypeAttribute::Signed, false,
-            std::move(a_args));
+            false, false, std::move(a_args));
 
     VecOwn<Expression> b_args;
     b_args.emplace_back(new SignedConstant(1));
     b_args.emplace_back(new SignedConstant(10));
     UserDefinedOperator b("NE", {TypeAttribute::Signed, TypeAttribute::Signed}, TypeAttribute::Signed, false,
-            std::move(b_args));
+            false, false, std::move(b_args));
     EXPECT_EQ(a, b);
     EXPECT_NE(&a, &b);
 
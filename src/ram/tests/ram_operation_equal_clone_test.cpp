@@ -19,6 +19,7 @@
 #include "AggregateOp.h"
 #include "RelationTag.h"
 #include "ram/Aggregate.h"
+#include "ram/Branches.h"
 #include "ram/Break.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
@@ -30,9 +31,12 @@
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
+#include "ram/IndexIntersect.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
+#include "ram/MergeJoin.h"
 #include "ram/Negation.h"
+#include "ram/NoveltyInsert.h"
 #include "ram/Operation.h"
 #include "ram/PackRecord.h"
 #include "ram/ParallelIfExists.h"
@@ -175,6 +179,96 @@ TEST(RamParallelIndexScan, CloneAndEquals) {
     delete c;
 }
 
+TEST(RamIndexIntersect, CloneAndEquals) {
+    Relation edge("edge", 2, 1, {"x", "y"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    Relation triangle("triangle", 3, 1, {"x", "y", "z"}, {"i", "i", "i"}, RelationRepresentation::DEFAULT);
+    // FOR t1 IN edge ON INDEX t1.x = t0.1 AND t1.y = ⊥ INTERSECT t1.1 WITH (t0.0, t1.1) IN edge
+    //  INSERT (t0.0, t0.1, t1.1) INTO triangle
+    VecOwn<Expression> a_insert_args;
+    a_insert_args.emplace_back(new TupleElement(0, 0));
+    a_insert_args.emplace_back(new TupleElement(0, 1));
+    a_insert_args.emplace_back(new TupleElement(1, 1));
+    auto a_insert = mk<Insert>("triangle", std::move(a_insert_args));
+    VecOwn<Expression> a_partner_args;
+    a_partner_args.emplace_back(new TupleElement(0, 0));
+    a_partner_args.emplace_back(new TupleElement(1, 1));
+    auto a_partner = mk<ExistenceCheck>("edge", std::move(a_partner_args));
+    RamPattern a_criteria;
+    a_criteria.first.emplace_back(new TupleElement(0, 1));
+    a_criteria.first.emplace_back(new UndefValue);
+    a_criteria.second.emplace_back(new TupleElement(0, 1));
+    a_criteria.second.emplace_back(new UndefValue);
+
+    IndexIntersect a("edge", 1, std::move(a_criteria), 1, std::move(a_partner), 1, std::move(a_insert),
+            "IndexIntersect test");
+
+    VecOwn<Expression> b_insert_args;
+    b_insert_args.emplace_back(new TupleElement(0, 0));
+    b_insert_args.emplace_back(new TupleElement(0, 1));
+    b_insert_args.emplace_back(new TupleElement(1, 1));
+    auto b_insert = mk<Insert>("triangle", std::move(b_insert_args));
+    VecOwn<Expression> b_partner_args;
+    b_partner_args.emplace_back(new TupleElement(0, 0));
+    b_partner_args.emplace_back(new TupleElement(1, 1));
+    auto b_partner = mk<ExistenceCheck>("edge", std::move(b_partner_args));
+    RamPattern b_criteria;
+    b_criteria.first.emplace_back(new TupleElement(0, 1));
+    b_criteria.first.emplace_back(new UndefValue);
+    b_criteria.second.emplace_back(new TupleElement(0, 1));
+    b_criteria.second.emplace_back(new UndefValue);
+
+    IndexIntersect b("edge", 1, std::move(b_criteria), 1, std::move(b_partner), 1, std::move(b_insert),
+            "IndexIntersect test");
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    IndexIntersect* c = a.cloning();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+}
+
+TEST(RamMergeJoin, CloneAndEquals) {
+    Relation edge("edge", 2, 1, {"x", "y"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    Relation path("path", 2, 1, {"x", "y"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    // FOR t0 IN edge MERGE ON t0.1
+    //  FOR t1 IN edge ON INDEX t1.x = t0.1
+    //   INSERT (t0.0, t1.1) INTO path
+    auto makeJoin = []() {
+        VecOwn<Expression> insert_args;
+        insert_args.emplace_back(new TupleElement(0, 0));
+        insert_args.emplace_back(new TupleElement(1, 1));
+        auto insert = mk<Insert>("path", std::move(insert_args));
+        RamPattern inner_criteria;
+        inner_criteria.first.emplace_back(new TupleElement(0, 1));
+        inner_criteria.first.emplace_back(new UndefValue);
+        inner_criteria.second.emplace_back(new TupleElement(0, 1));
+        inner_criteria.second.emplace_back(new UndefValue);
+        auto inner = mk<IndexScan>("edge", 1, std::move(inner_criteria), std::move(insert));
+        RamPattern criteria;
+        for (int i = 0; i < 2; ++i) {
+            criteria.first.emplace_back(new UndefValue);
+            criteria.second.emplace_back(new UndefValue);
+        }
+        return mk<MergeJoin>("edge", 0, std::move(criteria), 1, std::move(inner), "MergeJoin test");
+    };
+
+    auto a = makeJoin();
+    auto b = makeJoin();
+    EXPECT_EQ(*a, *b);
+    EXPECT_NE(a.get(), b.get());
+
+    MergeJoin* c = a->cloning();
+    EXPECT_EQ(*a, *c);
+    EXPECT_NE(a.get(), c);
+    delete c;
+
+    // a merge join is not equal to the index scan it orders
+    auto d = mk<IndexScan>(
+            "edge", 0, clone(a->getRangePattern()), clone(a->getOperation()), "MergeJoin test");
+    EXPECT_NE(*a, *d);
+}
+
 TEST(RamIfExists, CloneAndEquals) {
     Relation edge("edge", 2, 1, {"x", "y"}, {"i", "i"}, RelationRepresentation::DEFAULT);
     // choose an edge not adjcent to vertex 5
@@ -496,6 +590,35 @@ TEST(RamInsert, CloneAndEquals) {
     delete c;
 }
 
+TEST(RamNoveltyInsert, CloneAndEquals) {
+    Relation A("A", 2, 1, {"a", "b"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    Relation newA("@new_A", 2, 1, {"a", "b"}, {"i", "i"}, RelationRepresentation::DEFAULT);
+    // INSERT (t0.1, t0.3) INTO A RECORDING NEW IN @new_A
+    VecOwn<Expression> a_args;
+    a_args.emplace_back(new TupleElement(0, 1));
+    a_args.emplace_back(new TupleElement(0, 3));
+    NoveltyInsert a("A", std::move(a_args), "@new_A");
+
+    VecOwn<Expression> b_args;
+    b_args.emplace_back(new TupleElement(0, 1));
+    b_args.emplace_back(new TupleElement(0, 3));
+    NoveltyInsert b("A", std::move(b_args), "@new_A");
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    NoveltyInsert* c = a.cloning();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+
+    // INSERT (t0.1, t0.3) INTO A
+    VecOwn<Expression> d_args;
+    d_args.emplace_back(new TupleElement(0, 1));
+    d_args.emplace_back(new TupleElement(0, 3));
+    Insert d("A", std::move(d_args));
+    EXPECT_NE(a, d);
+}
+
 TEST(RamSubroutineReturn, CloneAndEquals) {
     // RETURN (t0.1, t0.2)
     VecOwn<Expression> a_args;
@@ -531,4 +654,38 @@ TEST(RamSubroutineReturn, CloneAndEquals) {
     EXPECT_NE(&d, f);
     delete f;
 }
+
+TEST(RamBranches, CloneAndEquals) {
+    // BRANCH
+    //  INSERT (t0.0) INTO A
+    // BRANCH
+    //  INSERT (t0.1) INTO B
+    auto mkBranches = []() {
+        VecOwn<Operation> branches;
+        VecOwn<Expression> a_args;
+        a_args.emplace_back(new TupleElement(0, 0));
+        branches.emplace_back(new Insert("A", std::move(a_args)));
+        VecOwn<Expression> b_args;
+        b_args.emplace_back(new TupleElement(0, 1));
+        branches.emplace_back(new Insert("B", std::move(b_args)));
+        return Branches(std::move(branches));
+    };
+    Branches a = mkBranches();
+    Branches b = mkBranches();
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    Branches* c = a.cloning();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+
+    // the order of the branches matters
+    VecOwn<Operation> d_branches;
+    for (auto* branch : a.getBranches()) {
+        d_branches.insert(d_branches.begin(), clone(branch));
+    }
+    Branches d(std::move(d_branches));
+    EXPECT_NE(a, d);
+}
 }  // namespace souffle::ram::test
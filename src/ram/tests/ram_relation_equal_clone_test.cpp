@@ -18,6 +18,7 @@
 
 #include "RelationTag.h"
 #include "ram/Relation.h"
+#include "souffle/BinaryConstraintOps.h"
 #include <string>
 
 namespace souffle::ram {
@@ -36,5 +37,25 @@ TEST(Relation, CloneAndEquals) {
     delete c;
 }
 
+TEST(Relation, LatticeCloneAndEquals) {
+    Relation a("A", 2, 0, {"k", "v"}, {"s", "i"}, RelationRepresentation::BTREE_DELETE,
+            BinaryConstraintOp::LT);
+    Relation b("A", 2, 0, {"k", "v"}, {"s", "i"}, RelationRepresentation::BTREE_DELETE,
+            BinaryConstraintOp::LT);
+    Relation d("A", 2, 0, {"k", "v"}, {"s", "i"}, RelationRepresentation::BTREE_DELETE,
+            BinaryConstraintOp::GT);
+    Relation e("A", 2, 0, {"k", "v"}, {"s", "i"}, RelationRepresentation::BTREE_DELETE);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, d);
+    EXPECT_NE(a, e);
+    EXPECT_TRUE(a.isLattice());
+    EXPECT_FALSE(e.isLattice());
+
+    Relation* c = a.cloning();
+    EXPECT_EQ(a, *c);
+    EXPECT_EQ(BinaryConstraintOp::LT, c->getLatticeOp());
+    delete c;
+}
+
 }  // end namespace test
 }  // namespace souffle::ram
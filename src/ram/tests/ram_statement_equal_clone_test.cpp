@@ -28,6 +28,7 @@
 #include "ram/Exit.h"
 #include "ram/Expression.h"
 #include "ram/Filter.h"
+#include "ram/Guard.h"
 #include "ram/IO.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
@@ -46,6 +47,7 @@
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
 #include "ram/Statement.h"
+#include "ram/StratumCache.h"
 #include "ram/SubroutineReturn.h"
 #include "ram/Swap.h"
 #include "ram/TupleElement.h"
@@ -434,5 +436,48 @@ TEST(LogSize, CloneAndEquals) {
     EXPECT_NE(&a, c);
     delete c;
 }
+
+TEST(StratumCache, CloneAndEquals) {
+    Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    Relation B("B", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    /*
+     * CACHE stratum_1 IN "cache" KEY 1f READING (A,B) COMPUTING (B)
+     *   CLEAR B
+     * END CACHE
+     * */
+    StratumCache a("cache", "stratum_1", "1f", {"A", "B"}, {"B"}, mk<Clear>("B"));
+    StratumCache b("cache", "stratum_1", "1f", {"A", "B"}, {"B"}, mk<Clear>("B"));
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    StratumCache* c = a.cloning();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+
+    StratumCache d("cache", "stratum_1", "2e", {"A", "B"}, {"B"}, mk<Clear>("B"));
+    EXPECT_NE(a, d);
+}
+
+TEST(Guard, CloneAndEquals) {
+    Relation A("A", 1, 1, {"x"}, {"i"}, RelationRepresentation::DEFAULT);
+    /*
+     * GUARD (NOT (A = ∅))
+     *   CLEAR A
+     * END GUARD
+     * */
+    Guard a(mk<Negation>(mk<EmptinessCheck>("A")), mk<Clear>("A"));
+    Guard b(mk<Negation>(mk<EmptinessCheck>("A")), mk<Clear>("A"));
+    EXPECT_EQ(a, b);
+    EXPECT_NE(&a, &b);
+
+    Guard* c = a.cloning();
+    EXPECT_EQ(a, *c);
+    EXPECT_NE(&a, c);
+    delete c;
+
+    Guard d(mk<EmptinessCheck>("A"), mk<Clear>("A"));
+    EXPECT_NE(a, d);
+}
 }  // end namespace test
 }  // namespace souffle::ram
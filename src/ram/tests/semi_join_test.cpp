@@ -0,0 +1,153 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file semi_join_test.cpp
+ *
+ * Tests the reduction of scans only used by inner existence checks to
+ * checks on semi-joins.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Clear.h"
+#include "ram/Constraint.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Filter.h"
+#include "ram/IndexIfExists.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Loop.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/TranslationUnit.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/transform/SemiJoin.h"
+#include "reports/DebugReport.h"
+#include "reports/ErrorReport.h"
+#include "souffle/BinaryConstraintOps.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::test {
+
+namespace {
+
+Own<TranslationUnit> makeProgram(ErrorReport& errorReport, DebugReport& debugReport, Own<Statement> main) {
+    VecOwn<Relation> rels;
+    for (const std::string name : {"A", "B", "C", "D"}) {
+        rels.push_back(mk<Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+                std::vector<std::string>{"i:number", "i:number"}, RelationRepresentation::BTREE));
+    }
+    auto prog = mk<Program>(std::move(rels), std::move(main), std::map<std::string, Own<Statement>>());
+    return mk<TranslationUnit>(std::move(prog), errorReport, debugReport);
+}
+
+RamPattern equalTo(Own<Expression> first, Own<Expression> second) {
+    RamPattern pattern;
+    pattern.first.push_back(clone(first));
+    pattern.first.push_back(clone(second));
+    pattern.second.push_back(std::move(first));
+    pattern.second.push_back(std::move(second));
+    return pattern;
+}
+
+/** D(x, y) :- A(x, y), B(x, z), C(z, w), w > 5, where C is searched on the given pattern */
+Own<Query> makeQuery(RamPattern innerPattern) {
+    return mk<Query>(mk<Scan>("A", 0,
+            mk<IndexScan>("B", 1, equalTo(mk<TupleElement>(0, 0), mk<UndefValue>()),
+                    mk<IndexIfExists>("C", 2,
+                            mk<Constraint>(BinaryConstraintOp::GT, mk<TupleElement>(2, 1),
+                                    mk<SignedConstant>(5)),
+                            std::move(innerPattern),
+                            mk<Insert>("D", toVector<Own<Expression>>(
+                                                    mk<TupleElement>(0, 0), mk<TupleElement>(0, 1)))))));
+}
+
+/** Whether the transformer changes the given main statement */
+bool reduces(Own<Statement> main) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    auto tUnit = makeProgram(errorReport, debugReport, std::move(main));
+    return transform::SemiJoinTransformer().apply(*tUnit);
+}
+
+}  // namespace
+
+TEST(SemiJoin, Reduce) {
+    ErrorReport errorReport;
+    DebugReport debugReport;
+    auto tUnit = makeProgram(
+            errorReport, debugReport, makeQuery(equalTo(mk<TupleElement>(1, 1), mk<UndefValue>())));
+
+    // the transformer is enabled by the pragma
+    EXPECT_FALSE(transform::SemiJoinTransformer().apply(*tUnit));
+    Global::config().set("semi-join");
+    EXPECT_TRUE(transform::SemiJoinTransformer().apply(*tUnit));
+
+    // the values of C passing the check are projected, and B stops at its first match; A is used by the
+    // insertion, hence scanned as it is
+    Sequence expected(
+            mk<Query>(mk<Scan>("C", 0,
+                    mk<Filter>(mk<Constraint>(BinaryConstraintOp::GT, mk<TupleElement>(0, 1),
+                                       mk<SignedConstant>(5)),
+                            mk<Insert>("@semijoin_0", toVector<Own<Expression>>(mk<TupleElement>(0, 0)))))),
+            mk<Query>(mk<Scan>("A", 0,
+                    mk<IndexIfExists>("B", 1,
+                            mk<ExistenceCheck>(
+                                    "@semijoin_0", toVector<Own<Expression>>(mk<TupleElement>(1, 1))),
+                            equalTo(mk<TupleElement>(0, 0), mk<UndefValue>()),
+                            mk<Insert>("D", toVector<Own<Expression>>(
+                                                    mk<TupleElement>(0, 0), mk<TupleElement>(0, 1)))))),
+            mk<Clear>("@semijoin_0"));
+    EXPECT_EQ(expected, tUnit->getProgram().getMain());
+
+    bool found = false;
+    for (const auto* rel : tUnit->getProgram().getRelations()) {
+        found = found || (rel->getName() == "@semijoin_0" && rel->getArity() == 1);
+    }
+    EXPECT_TRUE(found);
+
+    // the checks on semi-joins are not reduced again
+    EXPECT_FALSE(transform::SemiJoinTransformer().apply(*tUnit));
+    Global::config().unset("semi-join");
+}
+
+TEST(SemiJoin, Guards) {
+    Global::config().set("semi-join");
+    EXPECT_TRUE(reduces(makeQuery(equalTo(mk<TupleElement>(1, 1), mk<UndefValue>()))));
+
+    // the inner search is bound by a tuple of an outer scan, whose values the projection lacks
+    EXPECT_FALSE(reduces(makeQuery(equalTo(mk<TupleElement>(1, 1), mk<TupleElement>(0, 1)))));
+
+    // the inner search is a range of the values of the scan rather than a key
+    RamPattern range;
+    range.first.push_back(mk<TupleElement>(1, 1));
+    range.first.push_back(mk<UndefValue>());
+    range.second.push_back(mk<SignedConstant>(10));
+    range.second.push_back(mk<UndefValue>());
+    EXPECT_FALSE(reduces(makeQuery(std::move(range))));
+
+    // the relations of fixpoint loops change in each iteration
+    EXPECT_FALSE(reduces(mk<Loop>(makeQuery(equalTo(mk<TupleElement>(1, 1), mk<UndefValue>())))));
+    Global::config().unset("semi-join");
+}
+
+}  // namespace souffle::ram::test
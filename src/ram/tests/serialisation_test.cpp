@@ -0,0 +1,187 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file serialisation_test.cpp
+ *
+ * Tests the binary serialisation of RAM programs.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "AggregateOp.h"
+#include "FunctorOps.h"
+#include "RelationTag.h"
+#include "ram/Aggregate.h"
+#include "ram/AutoIncrement.h"
+#include "ram/Call.h"
+#include "ram/Clear.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Exit.h"
+#include "ram/False.h"
+#include "ram/Filter.h"
+#include "ram/FloatConstant.h"
+#include "ram/GuardedInsert.h"
+#include "ram/IO.h"
+#include "ram/IndexIntersect.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/IntrinsicOperator.h"
+#include "ram/LogRelationTimer.h"
+#include "ram/Loop.h"
+#include "ram/MergeExtend.h"
+#include "ram/Negation.h"
+#include "ram/PackRecord.h"
+#include "ram/ParallelMergeJoin.h"
+#include "ram/ParallelNestedIntrinsicOperator.h"
+#include "ram/ParallelScan.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/Sequence.h"
+#include "ram/SignedConstant.h"
+#include "ram/StringConstant.h"
+#include "ram/SubroutineArgument.h"
+#include "ram/SubroutineReturn.h"
+#include "ram/Swap.h"
+#include "ram/True.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/UnpackRecord.h"
+#include "ram/UnsignedConstant.h"
+#include "ram/UserDefinedOperator.h"
+#include "ram/utility/Serialisation.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/TypeAttribute.h"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::test {
+
+namespace {
+
+Own<Program> makeProgram() {
+    VecOwn<Relation> rels;
+    for (const std::string name : {"A", "B", "@delta_B", "@new_B"}) {
+        rels.push_back(mk<Relation>(name, 2, 0, std::vector<std::string>{"x", "y"},
+                std::vector<std::string>{"i:number", "s:symbol"}, RelationRepresentation::BTREE));
+    }
+    rels.push_back(mk<Relation>("L", 2, 0, std::vector<std::string>{"k", "v"},
+            std::vector<std::string>{"i:number", "f:float"}, RelationRepresentation::BTREE_DELETE,
+            BinaryConstraintOp::FLT));
+
+    RamPattern pattern;
+    pattern.first.push_back(mk<TupleElement>(0, 0));
+    pattern.first.push_back(mk<UndefValue>());
+    pattern.second.push_back(mk<TupleElement>(0, 0));
+    pattern.second.push_back(mk<UndefValue>());
+
+    // B(x, y) :- A(x, y), @delta_B(x, _), x < 3, !A(x, "a").
+    auto query = mk<Query>(mk<ParallelScan>("A", 0,
+            mk<IndexIntersect>("@delta_B", 1, std::move(pattern), 1,
+                    mk<ExistenceCheck>("A", toVector<Own<Expression>>(mk<TupleElement>(0, 0),
+                                                    mk<UndefValue>())),
+                    1,
+                    mk<Filter>(mk<Conjunction>(mk<Constraint>(BinaryConstraintOp::LT, mk<TupleElement>(0, 0),
+                                                       mk<SignedConstant>(-3)),
+                                       mk<Negation>(mk<ExistenceCheck>(
+                                               "A", toVector<Own<Expression>>(mk<TupleElement>(0, 0),
+                                                            mk<StringConstant>("a"))))),
+                            mk<GuardedInsert>("@new_B",
+                                    toVector<Own<Expression>>(mk<TupleElement>(0, 0),
+                                            mk<IntrinsicOperator>(FunctorOp::ADD,
+                                                    toVector<Own<Expression>>(mk<TupleElement>(0, 1),
+                                                            mk<UnsignedConstant>(7)))),
+                                    mk<Negation>(mk<EmptinessCheck>("A")))),
+                    "rule"),
+            "B(x,y) :- A(x,y)."));
+
+    auto aggregate = mk<Query>(mk<Aggregate>(
+            mk<UnpackRecord>(mk<Insert>("L", toVector<Own<Expression>>(mk<TupleElement>(1, 0),
+                                                     mk<UserDefinedOperator>("f",
+                                                             std::vector<TypeAttribute>{TypeAttribute::Float},
+                                                             TypeAttribute::Float, true, true, false,
+                                                             toVector<Own<Expression>>(mk<FloatConstant>(
+                                                                     RamFloat(1.5)))))),
+                    1, mk<PackRecord>(toVector<Own<Expression>>(mk<TupleElement>(0, 0))), 1),
+            AggregateOp::MIN, "A", mk<TupleElement>(0, 0), mk<True>(), 0));
+
+    auto main = mk<Sequence>(mk<IO>("A", std::map<std::string, std::string>{{"operation", "input"}}),
+            mk<Loop>(mk<Sequence>(std::move(query), mk<Exit>(mk<EmptinessCheck>("@new_B")),
+                    mk<MergeExtend>("B", "@new_B"), mk<Swap>("@delta_B", "@new_B"), mk<Clear>("@new_B"))),
+            mk<LogRelationTimer>(std::move(aggregate), "@t-relation;L", "L"), mk<Call>("stratum_1"));
+
+    std::map<std::string, Own<Statement>> subroutines;
+    subroutines["query"] = mk<Query>(mk<Filter>(mk<False>(),
+            mk<SubroutineReturn>(toVector<Own<Expression>>(mk<SubroutineArgument>(0), mk<AutoIncrement>()))));
+
+    // the second attributes of B joined with A on its second attribute
+    RamPattern scanPattern;
+    RamPattern joinPattern;
+    for (std::size_t i = 0; i < 2; ++i) {
+        scanPattern.first.push_back(mk<UndefValue>());
+        scanPattern.second.push_back(mk<UndefValue>());
+    }
+    joinPattern.first.push_back(mk<TupleElement>(0, 1));
+    joinPattern.first.push_back(mk<UndefValue>());
+    joinPattern.second.push_back(mk<TupleElement>(0, 1));
+    joinPattern.second.push_back(mk<UndefValue>());
+    subroutines["join"] = mk<Query>(mk<ParallelMergeJoin>("A", 0, std::move(scanPattern), 1,
+            mk<IndexScan>("B", 1, std::move(joinPattern),
+                    mk<SubroutineReturn>(toVector<Own<Expression>>(mk<TupleElement>(1, 1))))));
+    subroutines["range"] = mk<Query>(mk<ParallelNestedIntrinsicOperator>(NestedIntrinsicOp::RANGE,
+            toVector<Own<Expression>>(mk<SignedConstant>(0), mk<SubroutineArgument>(0)),
+            mk<SubroutineReturn>(toVector<Own<Expression>>(mk<TupleElement>(0, 0))), 0));
+    return mk<Program>(std::move(rels), std::move(main), std::move(subroutines));
+}
+
+bool isRejected(const std::string& bytes) {
+    std::stringstream stream(bytes);
+    try {
+        deserialise(stream);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(Serialisation, RoundTrip) {
+    auto program = makeProgram();
+    std::stringstream stream;
+    serialise(stream, *program);
+    auto loaded = deserialise(stream);
+
+    EXPECT_EQ(*program, *loaded);
+    EXPECT_EQ(toString(*program), toString(*loaded));
+}
+
+TEST(Serialisation, RejectsCorruptInput) {
+    std::stringstream stream;
+    serialise(stream, *makeProgram());
+    const std::string bytes = stream.str();
+
+    EXPECT_FALSE(isRejected(bytes));
+    EXPECT_TRUE(isRejected("X" + bytes.substr(1)));
+    EXPECT_TRUE(isRejected(bytes.substr(0, bytes.size() / 2)));
+    EXPECT_TRUE(isRejected(""));
+}
+
+}  // namespace souffle::ram::test
@@ -0,0 +1,145 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file DeltaVariants.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/DeltaVariants.h"
+#include "Global.h"
+#include "ram/Condition.h"
+#include "ram/Conjunction.h"
+#include "ram/Constraint.h"
+#include "ram/Filter.h"
+#include "ram/Loop.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/RelationSize.h"
+#include "ram/Sequence.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/MiscUtil.h"
+#include <utility>
+
+namespace souffle::ram::transform {
+
+std::vector<std::size_t> DeltaVariantsTransformer::selectIndex(
+        const LoopNest& nest, std::size_t atom, const std::vector<std::size_t>& bound) const {
+    // only the searches of the program are mapped to indexes
+    return idxAnalysis->getIndexSelection(nest.getRelation(atom)).getLargestEqualitySearch(bound);
+}
+
+std::vector<std::size_t> DeltaVariantsTransformer::getDrivenOrder(
+        const LoopNest& nest, std::size_t driver) const {
+    std::vector<std::size_t> order{driver};
+    std::vector<bool> placed(nest.size(), false);
+    placed[driver] = true;
+
+    // the next atom is the one searched on the most attributes
+    while (order.size() < nest.size()) {
+        std::size_t best = nest.size();
+        std::size_t bestIndexed = 0;
+        for (std::size_t atom = 0; atom < nest.size(); ++atom) {
+            if (placed[atom]) {
+                continue;
+            }
+            const auto bound = nest.getBoundElements(atom, placed);
+            const std::size_t indexed = bound.empty() ? 0 : selectIndex(nest, atom, bound).size();
+            if (indexed > bestIndexed) {
+                best = atom;
+                bestIndexed = indexed;
+            }
+        }
+        if (best == nest.size()) {
+            return {};
+        }
+        order.push_back(best);
+        placed[best] = true;
+    }
+    return order;
+}
+
+Own<Statement> DeltaVariantsTransformer::createVariants(const Query& query) {
+    auto nest = LoopNest::flatten(query, *relAnalysis);
+    if (nest == nullptr || nest->size() > MAX_ATOMS) {
+        return nullptr;
+    }
+
+    // the original query is the variant driven by its first atom
+    VecOwn<Query> variants;
+    std::vector<std::string> drivers{nest->getRelation(0)};
+    variants.push_back(clone(query));
+    for (std::size_t driver = 1; driver < nest->size(); ++driver) {
+        // variants driven by the same relation would be selected by the same size
+        if (contains(drivers, nest->getRelation(driver))) {
+            continue;
+        }
+        const auto order = getDrivenOrder(*nest, driver);
+        if (order.empty()) {
+            continue;
+        }
+        variants.push_back(nest->reorder(order, [&](std::size_t atom, const std::vector<std::size_t>& bound) {
+            return selectIndex(*nest, atom, bound);
+        }));
+        drivers.push_back(nest->getRelation(driver));
+    }
+    if (variants.size() < 2) {
+        return nullptr;
+    }
+
+    // evaluate the variant driven by the smallest relation, preferring the earlier variants on ties
+    VecOwn<Statement> res;
+    for (std::size_t v = 0; v < variants.size(); ++v) {
+        VecOwn<Condition> selector;
+        for (std::size_t w = 0; w < variants.size(); ++w) {
+            if (w != v) {
+                selector.push_back(mk<Constraint>(w < v ? BinaryConstraintOp::LT : BinaryConstraintOp::LE,
+                        mk<RelationSize>(drivers[v]), mk<RelationSize>(drivers[w])));
+            }
+        }
+
+        // the checks of the query guard the counting of the relations
+        const Operation& op = variants[v]->getOperation();
+        if (const auto* filter = as<Filter>(op)) {
+            res.push_back(mk<Query>(mk<Filter>(
+                    mk<Conjunction>(clone(filter->getCondition()), toCondition(selector)),
+                    clone(filter->getOperation()), filter->getProfileText())));
+        } else {
+            res.push_back(mk<Query>(mk<Filter>(toCondition(selector), clone(op))));
+        }
+    }
+    return mk<Sequence>(std::move(res));
+}
+
+bool DeltaVariantsTransformer::createVariants(Program& program) {
+    if (Global::config().has("provenance")) {
+        return false;
+    }
+
+    bool changed = false;
+    visit(program, [&](Loop& loop) {
+        loop.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+            if (const Query* query = as<Query>(node)) {
+                if (Own<Statement> variants = createVariants(*query)) {
+                    changed = true;
+                    return variants;
+                }
+                return node;
+            }
+            node->apply(go);
+            return node;
+        }));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
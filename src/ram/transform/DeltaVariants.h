@@ -0,0 +1,113 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file DeltaVariants.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Index.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include "ram/utility/LoopNest.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class DeltaVariantsTransformer
+ * @brief Evaluate the queries of fixpoint loops in join orders chosen by
+ * the sizes of their relations in each iteration
+ *
+ * The sizes of the delta relations change by orders of magnitude between
+ * the iterations of a fixpoint loop. A query of the loop is hence replaced
+ * by variants driven by different atoms, i.e., scanning the relation of
+ * the atom in the outermost loop, of which the variant driven by the
+ * smallest relation is evaluated.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN @delta_A
+ *    FOR t1 IN B ON INDEX t1.0 = t0.1
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   IF (SIZE(@delta_A) <= SIZE(B))
+ *    FOR t0 IN @delta_A
+ *     FOR t1 IN B ON INDEX t1.0 = t0.1
+ *      ...
+ *  QUERY
+ *   IF (SIZE(B) < SIZE(@delta_A))
+ *    FOR t0 IN B
+ *     FOR t1 IN @delta_A ON INDEX t1.1 = t0.0
+ *      ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * A variant is only created if all of its inner atoms are searched on an
+ * existing index, such that no index is added for the variants.
+ */
+class DeltaVariantsTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "DeltaVariantsTransformer";
+    }
+
+    /**
+     * @brief Create the variants of a query
+     * @param query The query of a fixpoint loop
+     * @result the sequence of variants, or nullptr if there is no variant besides the given query
+     */
+    Own<Statement> createVariants(const Query& query);
+
+    /**
+     * @brief Replace the queries of fixpoint loops by their variants
+     * @param program Program that is transformed
+     * @return Flag showing whether the program has been changed by the transformation
+     */
+    bool createVariants(Program& program);
+
+protected:
+    /** @brief Return the bound attributes of an atom searched on an existing index */
+    std::vector<std::size_t> selectIndex(
+            const LoopNest& nest, std::size_t atom, const std::vector<std::size_t>& bound) const;
+
+    /**
+     * @brief Return the order of the loop nest driven by the given atom
+     * @result the atoms in the greedy order of their bound attributes, or empty if an inner atom
+     * would not be searched on an index
+     */
+    std::vector<std::size_t> getDrivenOrder(const LoopNest& nest, std::size_t driver) const;
+
+    /** Maximal number of atoms of a query for which variants are created */
+    static constexpr std::size_t MAX_ATOMS = 4;
+
+    analysis::IndexAnalysis* idxAnalysis{nullptr};
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+    bool transform(TranslationUnit& translationUnit) override {
+        idxAnalysis = &translationUnit.getAnalysis<analysis::IndexAnalysis>();
+        relAnalysis = &translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return createVariants(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,226 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FuseSharedScans.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/FuseSharedScans.h"
+#include "ram/AbstractExistenceCheck.h"
+#include "ram/Branches.h"
+#include "ram/Break.h"
+#include "ram/DebugInfo.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/Erase.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
+#include "ram/Operation.h"
+#include "ram/Query.h"
+#include "ram/RelationOperation.h"
+#include "ram/RelationSize.h"
+#include "ram/Scan.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/StreamUtil.h"
+#include <optional>
+#include <set>
+#include <sstream>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** A query split into its outer filters and scan, and the loop nest of the scan */
+struct SplitQuery {
+    /** Outer filters and scan, nesting an empty Branches operation */
+    Own<Operation> skeleton;
+
+    /** Loop nest of the scan */
+    Own<Operation> body;
+
+    /** Relations read or erased by the query */
+    std::set<std::string> reads;
+
+    /** Relations written by the query */
+    std::set<std::string> writes;
+
+    /** Debug message of the query, if any */
+    const DebugInfo* debug = nullptr;
+};
+
+/** Replace the loop nest of the outer scan below the outer filters */
+void setNested(Operation& op, Own<Operation> nested) {
+    Operation* scan = &op;
+    while (const auto* filter = as<Filter>(scan)) {
+        scan = &filter->getOperation();
+    }
+    scan->apply(nodeMapper<Node>([&](auto&&, Own<Node> node) -> Own<Node> {
+        if (isA<Operation>(node)) {
+            return std::move(nested);
+        }
+        return node;
+    }));
+}
+
+/** Split a query of a sequence, or return std::nullopt if it cannot be fused */
+std::optional<SplitQuery> split(const Statement& stmt) {
+    SplitQuery res;
+    const Query* query = nullptr;
+    if (const auto* debug = as<DebugInfo>(stmt)) {
+        res.debug = debug;
+        query = as<Query>(debug->getStatement());
+    } else {
+        query = as<Query>(stmt);
+    }
+    if (query == nullptr) {
+        return std::nullopt;
+    }
+
+    const Operation* op = &query->getOperation();
+    while (const auto* filter = as<Filter>(op)) {
+        op = &filter->getOperation();
+    }
+    const auto* scan = as<RelationOperation>(op);
+    if (scan == nullptr || (!isA<Scan>(scan) && !isA<IndexScan>(scan))) {
+        return std::nullopt;
+    }
+
+    // plain copies are evaluated as bulk insertions by the interpreter
+    const auto& nested = scan->getOperation();
+    if (isA<Scan>(scan) && typeid(nested) == typeid(Insert)) {
+        return std::nullopt;
+    }
+
+    // a branch breaking the shared loop would cut off the other branches
+    bool hasBreak = false;
+    visit(*query, [&](const Break&) { hasBreak = true; });
+    if (hasBreak) {
+        return std::nullopt;
+    }
+
+    visit(*query, [&](const RelationOperation& search) { res.reads.insert(search.getRelation()); });
+    visit(*query, [&](const AbstractExistenceCheck& exists) { res.reads.insert(exists.getRelation()); });
+    visit(*query, [&](const EmptinessCheck& emptiness) { res.reads.insert(emptiness.getRelation()); });
+    visit(*query, [&](const RelationSize& size) { res.reads.insert(size.getRelation()); });
+    visit(*query, [&](const Insert& insert) { res.writes.insert(insert.getRelation()); });
+    visit(*query, [&](const NoveltyInsert& insert) { res.writes.insert(insert.getNewRelation()); });
+    visit(*query, [&](const Erase& erase) {
+        res.reads.insert(erase.getRelation());
+        res.writes.insert(erase.getRelation());
+    });
+
+    res.body = clone(nested);
+    res.skeleton = clone(query->getOperation());
+    setNested(*res.skeleton, mk<Branches>(VecOwn<Operation>()));
+    return res;
+}
+
+/** Check whether a relation of one set is contained in the other set */
+bool intersects(const std::set<std::string>& a, const std::set<std::string>& b) {
+    return any_of(a, [&](const std::string& rel) { return contains(b, rel); });
+}
+
+/** Fuse a group of split queries sharing their skeleton */
+Own<Statement> fuse(std::vector<SplitQuery>& group) {
+    VecOwn<Operation> bodies;
+    std::vector<std::string> messages;
+    for (auto& query : group) {
+        bodies.push_back(std::move(query.body));
+        if (query.debug != nullptr) {
+            messages.push_back(query.debug->getMessage());
+        }
+    }
+
+    Own<Operation> op = std::move(group.front().skeleton);
+    setNested(*op, mk<Branches>(std::move(bodies)));
+
+    Own<Statement> res = mk<Query>(std::move(op));
+    if (!messages.empty()) {
+        std::stringstream message;
+        message << join(messages, "\n");
+        res = mk<DebugInfo>(std::move(res), message.str());
+    }
+    return res;
+}
+
+}  // namespace
+
+Own<Statement> FuseSharedScansTransformer::fuseQueries(const Sequence& sequence) {
+    VecOwn<Statement> statements;
+    std::vector<SplitQuery> group;
+    const Statement* first = nullptr;
+    std::set<std::string> reads;
+    std::set<std::string> writes;
+    bool changed = false;
+
+    auto flush = [&]() {
+        if (group.size() > 1) {
+            statements.push_back(fuse(group));
+            changed = true;
+        } else if (first != nullptr) {
+            statements.push_back(clone(first));
+        }
+        group.clear();
+        first = nullptr;
+        reads.clear();
+        writes.clear();
+    };
+
+    for (const Statement* stmt : sequence.getStatements()) {
+        auto query = split(*stmt);
+        if (!query) {
+            flush();
+            statements.push_back(clone(stmt));
+            continue;
+        }
+
+        // the queries of a group interleave their reads and writes
+        if (!group.empty() && (*group.front().skeleton != *query->skeleton ||
+                                      intersects(query->writes, reads) || intersects(writes, query->reads))) {
+            flush();
+        }
+        if (group.empty()) {
+            first = stmt;
+        }
+        reads.insert(query->reads.begin(), query->reads.end());
+        writes.insert(query->writes.begin(), query->writes.end());
+        group.push_back(std::move(*query));
+    }
+    flush();
+
+    if (!changed) {
+        return nullptr;
+    }
+    return mk<Sequence>(std::move(statements));
+}
+
+bool FuseSharedScansTransformer::fuseQueries(Program& program) {
+    bool changed = false;
+    program.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        node->apply(go);
+        if (const auto* sequence = as<Sequence>(node)) {
+            if (Own<Statement> fused = fuseQueries(*sequence)) {
+                changed = true;
+                return fused;
+            }
+        }
+        return node;
+    }));
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
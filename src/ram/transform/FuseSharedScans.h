@@ -0,0 +1,91 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FuseSharedScans.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Program.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/transform/Transformer.h"
+#include "souffle/utility/MiscUtil.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class FuseSharedScansTransformer
+ * @brief Fuse consecutive queries of a sequence sharing their outer scan
+ *
+ * Rules of a stratum often share their first atom and its constraints,
+ * e.g., several rules driven by the same delta relation. Their queries
+ * scan the same relation one after the other. Consecutive queries with
+ * equal outer filters and scan are fused into a single query evaluating
+ * the remaining loop nests of the queries as branches of the shared scan.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN @delta_A
+ *    INSERT (t0.0) INTO B
+ *  QUERY
+ *   FOR t0 IN @delta_A
+ *    FOR t1 IN C ON INDEX t1.0 = t0.1
+ *     INSERT (t1.1) INTO D
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN @delta_A
+ *    BRANCH
+ *     INSERT (t0.0) INTO B
+ *    BRANCH
+ *     FOR t1 IN C ON INDEX t1.0 = t0.1
+ *      INSERT (t1.1) INTO D
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Queries are only fused if none of them writes a relation read or erased
+ * by another, since the branches interleave the insertions of the queries.
+ * Queries breaking their loops and plain copies of a relation are kept.
+ */
+class FuseSharedScansTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "FuseSharedScansTransformer";
+    }
+
+    /**
+     * @brief Fuse the consecutive queries of a sequence sharing their outer scan
+     * @param sequence Sequence of statements
+     * @result the sequence of fused queries, or nullptr if no queries have been fused
+     */
+    Own<Statement> fuseQueries(const Sequence& sequence);
+
+    /**
+     * @brief Fuse the queries of all sequences of the program
+     * @param program Program that is transformed
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool fuseQueries(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        return fuseQueries(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
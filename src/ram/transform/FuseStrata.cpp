@@ -0,0 +1,268 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FuseStrata.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/FuseStrata.h"
+#include "Global.h"
+#include "ram/AbstractExistenceCheck.h"
+#include "ram/AutoIncrement.h"
+#include "ram/BinRelationStatement.h"
+#include "ram/Break.h"
+#include "ram/Call.h"
+#include "ram/Clear.h"
+#include "ram/Condition.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/Erase.h"
+#include "ram/Filter.h"
+#include "ram/GuardedInsert.h"
+#include "ram/Insert.h"
+#include "ram/Loop.h"
+#include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
+#include "ram/RelationOperation.h"
+#include "ram/RelationSize.h"
+#include "ram/RelationStatement.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/TupleElement.h"
+#include "ram/TupleOperation.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/NodeMapper.h"
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** Count the references of a node to each relation, except by clearing it */
+std::map<std::string, std::size_t> countReferences(const Node& node) {
+    std::map<std::string, std::size_t> references;
+    visit(node, [&](const Node& cur) {
+        if (const auto* operation = as<RelationOperation>(cur)) {
+            references[operation->getRelation()]++;
+        } else if (const auto* exists = as<AbstractExistenceCheck>(cur)) {
+            references[exists->getRelation()]++;
+        } else if (const auto* emptiness = as<EmptinessCheck>(cur)) {
+            references[emptiness->getRelation()]++;
+        } else if (const auto* size = as<RelationSize>(cur)) {
+            references[size->getRelation()]++;
+        } else if (const auto* insert = as<Insert>(cur)) {
+            references[insert->getRelation()]++;
+            if (const auto* novelty = as<NoveltyInsert>(cur)) {
+                references[novelty->getNewRelation()]++;
+            }
+        } else if (const auto* erase = as<Erase>(cur)) {
+            references[erase->getRelation()]++;
+        } else if (const auto* statement = as<RelationStatement>(cur)) {
+            if (!isA<Clear>(statement)) {
+                references[statement->getRelation()]++;
+            }
+        } else if (const auto* statement = as<BinRelationStatement>(cur)) {
+            references[statement->getFirstRelation()]++;
+            references[statement->getSecondRelation()]++;
+        }
+    });
+    return references;
+}
+
+std::size_t countReferences(const Node& node, const std::string& relation) {
+    const auto references = countReferences(node);
+    auto it = references.find(relation);
+    return it == references.end() ? 0 : it->second;
+}
+
+/** Return whether an operation only inserts into relations, and evaluates the same for each derivation */
+bool isIdempotent(const Node& node) {
+    return !visitExists(node, [](const Node& cur) {
+        return isA<Erase>(cur) || isA<Break>(cur) || isA<AutoIncrement>(cur) || isA<NoveltyInsert>(cur);
+    });
+}
+
+}  // namespace
+
+Own<Query> FuseStrataTransformer::fuseQuery(
+        const Query& query, const Scan& scan, const VecOwn<Condition>& conditions) {
+    const int identifier = scan.getTupleId();
+    int maxIdentifier = -1;
+    visit(query, [&](const TupleOperation& operation) {
+        maxIdentifier = std::max(maxIdentifier, operation.getTupleId());
+    });
+
+    // the tuples of the loop nest follow the tuples of the query
+    auto shift = [&](int other) { return other - identifier + maxIdentifier; };
+
+    auto fused = clone(query);
+    fused->apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        const auto* insert = as<Insert>(node);
+        if (insert == nullptr) {
+            node->apply(go);
+            return node;
+        }
+
+        // the tuple of the scan is the inserted tuple
+        const auto values = insert->getValues();
+        auto rebind = nodeMapper<Node>([&](auto&& rebindChildren, Own<Node> cur) -> Own<Node> {
+            if (const auto* element = as<TupleElement>(cur)) {
+                if (element->getTupleId() == identifier) {
+                    return clone(values[element->getElement()]);
+                }
+                return mk<TupleElement>(shift(element->getTupleId()), element->getElement());
+            }
+            if (auto* operation = as<TupleOperation>(cur)) {
+                operation->setTupleId(shift(operation->getTupleId()));
+            }
+            cur->apply(rebindChildren);
+            return cur;
+        });
+        return rebind(clone(scan.getOperation()));
+    }));
+
+    if (conditions.empty()) {
+        return fused;
+    }
+    return mk<Query>(mk<Filter>(toCondition(conditions), clone(fused->getOperation())));
+}
+
+bool FuseStrataTransformer::fuseRelation(
+        Program& program, const std::string& relation, Statement& producer, Statement& consumer) {
+    // the queries computing the relation only insert into it
+    std::set<const Query*> producers;
+    bool fusible =
+            !visitExists(producer, [&](const Clear& clear) { return clear.getRelation() == relation; });
+    visit(producer, [&](const Query& query) {
+        if (countReferences(query, relation) == 0) {
+            return;
+        }
+        std::size_t insertions = 0;
+        visit(query, [&](const Insert& insert) {
+            insertions++;
+            fusible = fusible && insert.getRelation() == relation && typeid(insert) == typeid(Insert);
+        });
+        fusible = fusible && insertions == 1 && countReferences(query, relation) == 1 && isIdempotent(query);
+        producers.insert(&query);
+    });
+
+    // a single query reads the relation, by an outer scan under conditions on no tuple
+    const Query* reader = nullptr;
+    visit(consumer, [&](const Query& query) {
+        if (countReferences(query, relation) != 0) {
+            fusible = fusible && reader == nullptr;
+            reader = &query;
+        }
+    });
+    if (!fusible || producers.empty() || reader == nullptr) {
+        return false;
+    }
+    VecOwn<Condition> conditions;
+    const Operation* operation = &reader->getOperation();
+    while (const auto* filter = as<Filter>(operation)) {
+        for (auto& condition : toConjunctionList(&filter->getCondition())) {
+            const auto* emptiness = as<EmptinessCheck>(condition);
+            if (emptiness == nullptr || emptiness->getRelation() != relation) {
+                conditions.push_back(std::move(condition));
+            }
+        }
+        operation = &filter->getOperation();
+    }
+    const auto* scan = as<Scan>(operation);
+    if (scan == nullptr || typeid(*scan) != typeid(Scan) || scan->getRelation() != relation ||
+            countReferences(scan->getOperation(), relation) != 0 || !isIdempotent(scan->getOperation()) ||
+            any_of(conditions, [&](const Own<Condition>& condition) {
+                return countReferences(*condition, relation) != 0 ||
+                       visitExists(*condition, [](const TupleElement&) { return true; });
+            }) ||
+            visitExists(scan->getOperation(), [&](const TupleOperation& inner) {
+                return inner.getTupleId() <= scan->getTupleId();
+            })) {
+        return false;
+    }
+
+    // no other statement of the program refers to the relation
+    if (countReferences(program, relation) != producers.size() + countReferences(*reader, relation)) {
+        return false;
+    }
+
+    producer.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        if (const auto* query = as<Query>(node)) {
+            if (contains(producers, query)) {
+                return fuseQuery(*query, *scan, conditions);
+            }
+            return node;
+        }
+        node->apply(go);
+        return node;
+    }));
+    consumer.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        if (node.get() == reader) {
+            return mk<Sequence>();
+        }
+        node->apply(go);
+        return node;
+    }));
+    return true;
+}
+
+bool FuseStrataTransformer::fuseStrata(Program& program) {
+    // strata are evaluated, profiled, cached and resumed as translated by these
+    const auto& config = Global::config();
+    if (!config.has("fuse-strata") || config.has("provenance") || config.has("profile") ||
+            config.has("incremental") || config.has("stratum-cache") || config.has("checkpoint-dir") ||
+            config.has("resume-from") || config.has("emit-plans") || config.has("adaptive-join-order") ||
+            config.has("native-strata") || config.has("native-library")) {
+        return false;
+    }
+
+    // subroutines of strata called one after the other
+    std::vector<std::pair<std::string, std::string>> successions;
+    visit(program.getMain(), [&](const Sequence& sequence) {
+        const auto statements = sequence.getStatements();
+        for (std::size_t i = 0; i + 1 < statements.size(); i++) {
+            const auto* first = as<Call>(statements[i]);
+            const auto* second = as<Call>(statements[i + 1]);
+            if (first != nullptr && second != nullptr) {
+                successions.emplace_back(first->getName(), second->getName());
+            }
+        }
+    });
+
+    // later strata first, such that a chain of relations is pipelined into its first stratum
+    bool changed = false;
+    const auto subroutines = program.getSubroutines();
+    for (auto it = successions.rbegin(); it != successions.rend(); ++it) {
+        Statement& producer = *subroutines.at(it->first);
+        Statement& consumer = *subroutines.at(it->second);
+
+        // recursive strata compute their relations in fixpoint loops
+        if (visitExists(producer, [](const Loop&) { return true; })) {
+            continue;
+        }
+        std::set<std::string> computed;
+        visit(producer, [&](const Insert& insert) { computed.insert(insert.getRelation()); });
+        for (const auto& relation : computed) {
+            changed |= fuseRelation(program, relation, producer, consumer);
+        }
+    }
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
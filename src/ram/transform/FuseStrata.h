@@ -0,0 +1,110 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file FuseStrata.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Condition.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Scan.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/transform/Transformer.h"
+#include "souffle/utility/MiscUtil.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class FuseStrataTransformer
+ * @brief Pipeline the tuples of a relation into the only query reading it
+ * in the next stratum
+ *
+ * A relation computed by a non-recursive stratum and scanned by a single
+ * query of the stratum evaluated right after it is materialised, with all
+ * of its indexes, only to be scanned once. Instead, each query computing
+ * the relation evaluates the loop nest of the query reading it in place of
+ * its insertion, and the query reading it is dropped.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  SUBROUTINE stratum_1
+ *   QUERY
+ *    FOR t0 IN A
+ *     INSERT (t0.1, t0.0) INTO B
+ *  SUBROUTINE stratum_2
+ *   QUERY
+ *    FOR t0 IN B
+ *     FOR t1 IN C ON INDEX t1.0 = t0.1
+ *      INSERT (t0.0, t1.1) INTO D
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  SUBROUTINE stratum_1
+ *   QUERY
+ *    FOR t0 IN A
+ *     FOR t1 IN C ON INDEX t1.0 = t0.0
+ *      INSERT (t0.1, t1.1) INTO D
+ *  SUBROUTINE stratum_2
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * Since the query reading the relation only inserts into other relations,
+ * evaluating it once per derivation rather than once per distinct tuple
+ * computes the same relations. The relation must neither be an input nor
+ * an output, nor be referred to by any other statement. The transformer is
+ * enabled by the pragma fuse-strata.
+ */
+class FuseStrataTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "FuseStrataTransformer";
+    }
+
+    /**
+     * @brief Fuse the strata of the program evaluated one after the other
+     * @param program The RAM program
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool fuseStrata(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        return fuseStrata(translationUnit.getProgram());
+    }
+
+    /**
+     * @brief Pipeline a relation of a stratum into the next stratum
+     * @param program The RAM program
+     * @param relation The relation computed by the producing stratum
+     * @param producer The subroutine of the producing stratum
+     * @param consumer The subroutine of the stratum evaluated right after it
+     * @result A flag indicating whether the relation has been pipelined
+     */
+    bool fuseRelation(
+            Program& program, const std::string& relation, Statement& producer, Statement& consumer);
+
+    /**
+     * @brief Evaluate the loop nest reading a relation in place of an insertion into it
+     * @param query The query inserting into the relation
+     * @param scan The outer scan of the query reading the relation
+     * @param conditions The conditions of the query reading the relation outside of its scan
+     * @result The query evaluating the loop nest instead of the insertion
+     */
+    Own<Query> fuseQuery(const Query& query, const Scan& scan, const VecOwn<Condition>& conditions);
+};
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,133 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HoistScans.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/HoistScans.h"
+#include "Global.h"
+#include "ram/Filter.h"
+#include "ram/IndexScan.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/RelationOperation.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace souffle::ram::transform {
+
+bool HoistScansTransformer::dependsOn(const LoopNest& nest, std::size_t atom, const std::vector<bool>& outer,
+        const std::vector<bool>& remaining) {
+    return nest.getBoundElements(atom, outer) != nest.getBoundElements(atom, remaining) ||
+           nest.getConditions(atom, outer).size() != nest.getConditions(atom, remaining).size();
+}
+
+Own<Query> HoistScansTransformer::hoistScans(const Query& query) const {
+    auto nest = LoopNest::flatten(query, *relAnalysis);
+    if (nest == nullptr) {
+        return nullptr;
+    }
+    const std::size_t numAtoms = nest->size();
+
+    // the attributes each scan searches on its index are kept
+    std::vector<std::vector<std::size_t>> indexed;
+    const Operation* op = &query.getOperation();
+    while (indexed.size() < numAtoms) {
+        if (const auto* filter = as<Filter>(op)) {
+            op = &filter->getOperation();
+            continue;
+        }
+        std::vector<std::size_t> attributes;
+        if (const auto* indexScan = as<IndexScan>(op)) {
+            const auto pattern = indexScan->getRangePattern();
+            for (std::size_t i = 0; i < pattern.first.size(); ++i) {
+                if (!isUndefValue(pattern.first[i])) {
+                    attributes.push_back(i);
+                }
+            }
+        }
+        indexed.push_back(std::move(attributes));
+        op = &as<RelationOperation>(op)->getOperation();
+    }
+
+    std::vector<std::size_t> order(numAtoms);
+    std::iota(order.begin(), order.end(), 0);
+    bool changed = false;
+    for (std::size_t level = 1; level < numAtoms; ++level) {
+        const std::size_t atom = order[level];
+        std::vector<bool> outer(numAtoms, false);
+        for (std::size_t i = 0; i < level; ++i) {
+            outer[order[i]] = true;
+        }
+
+        // only a filtered scan filters fewer tuples once hoisted
+        if (nest->getConditions(atom, outer).empty()) {
+            continue;
+        }
+
+        // hoist the scan above the unfiltered scans it does not depend on
+        std::size_t target = level;
+        std::vector<bool> remaining = outer;
+        while (target > 0) {
+            const std::size_t above = order[target - 1];
+            remaining[above] = false;
+            if (!nest->getConditions(above, remaining).empty() ||
+                    dependsOn(*nest, atom, outer, remaining)) {
+                break;
+            }
+            --target;
+        }
+        if (target < level) {
+            std::rotate(order.begin() + target, order.begin() + level, order.begin() + level + 1);
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return nullptr;
+    }
+
+    return nest->reorder(order, [&](std::size_t atom, const std::vector<std::size_t>& bound) {
+        std::vector<std::size_t> res;
+        for (std::size_t i : indexed[atom]) {
+            if (contains(bound, i)) {
+                res.push_back(i);
+            }
+        }
+        return res;
+    });
+}
+
+bool HoistScansTransformer::hoistScans(Program& program) const {
+    if (Global::config().has("provenance")) {
+        return false;
+    }
+
+    bool changed = false;
+    program.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        if (const auto* query = as<Query>(node)) {
+            if (Own<Query> hoisted = hoistScans(*query)) {
+                changed = true;
+                return hoisted;
+            }
+            return node;
+        }
+        node->apply(go);
+        return node;
+    }));
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,95 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HoistScans.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include "ram/utility/LoopNest.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class HoistScansTransformer
+ * @brief Hoist filtered scans that do not depend on the tuples of outer
+ * scans above these scans
+ *
+ * A scan whose search and filters do not refer to the tuples of the scans
+ * it is nested in scans and filters the same tuples for each of their
+ * tuples. If the outer scans are not filtered themselves, the scan is
+ * hoisted above them, such that its filters are evaluated once per tuple
+ * of its relation, instead of once per tuple of the cross product.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B
+ *     IF (t1.0 < 10)
+ *      INSERT (t0.0, t1.1) INTO C
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN B
+ *    IF (t0.0 < 10)
+ *     FOR t1 IN A
+ *      INSERT (t1.0, t0.1) INTO C
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The searches of the scans are kept, so no index is added.
+ */
+class HoistScansTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "HoistScansTransformer";
+    }
+
+    /**
+     * @brief Hoist the independent filtered scans of a query
+     * @param query The query
+     * @result The rewritten query, or nullptr if no scan is hoisted
+     */
+    Own<Query> hoistScans(const Query& query) const;
+
+    /**
+     * @brief Apply hoistScans to the whole program
+     * @param program The RAM program
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool hoistScans(Program& program) const;
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        relAnalysis = &translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return hoistScans(translationUnit.getProgram());
+    }
+
+    /** @brief Check whether an atom nested in the outer atoms depends on the atoms left out */
+    static bool dependsOn(const LoopNest& nest, std::size_t atom, const std::vector<bool>& outer,
+            const std::vector<bool>& remaining);
+
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+};
+
+}  // namespace souffle::ram::transform
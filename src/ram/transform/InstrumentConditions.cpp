@@ -0,0 +1,70 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InstrumentConditions.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/InstrumentConditions.h"
+#include "ram/Condition.h"
+#include "ram/Filter.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/True.h"
+#include "ram/analysis/Complexity.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "souffle/utility/MiscUtil.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** Label of a filter counting the passes of one condition, which are the evaluations of the next one */
+std::string getFrequencyLabel(const std::string& passed, const std::string& evaluated) {
+    return "@frequency-condition;" + passed + ";" + evaluated + ";";
+}
+
+}  // namespace
+
+bool InstrumentConditionsTransformer::transform(TranslationUnit& translationUnit) {
+    bool changed = false;
+    forEachQuery(translationUnit.getProgram(), [&](Query& query) {
+        const Node* outermost = &query.getOperation();
+        query.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+            node->apply(go);
+            const auto* filter = as<Filter>(node);
+            if (filter == nullptr || node.get() == outermost || !filter->getProfileText().empty()) {
+                return node;
+            }
+
+            VecOwn<Condition> conditions = toConjunctionList(&filter->getCondition());
+            std::vector<std::string> keys;
+            for (const auto& condition : conditions) {
+                keys.push_back(analysis::ComplexityAnalysis::getProfileKey(*condition));
+            }
+            Own<Operation> op = clone(filter->getOperation());
+            for (std::size_t i = conditions.size(); i-- > 0;) {
+                const std::string next = i + 1 < keys.size() ? keys[i + 1] : "";
+                op = mk<Filter>(std::move(conditions[i]), std::move(op), getFrequencyLabel(keys[i], next));
+            }
+            changed = true;
+            return mk<Filter>(mk<True>(), std::move(op), getFrequencyLabel("", keys.front()));
+        }));
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
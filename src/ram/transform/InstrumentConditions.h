@@ -0,0 +1,61 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file InstrumentConditions.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/TranslationUnit.h"
+#include "ram/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class InstrumentConditionsTransformer
+ * @brief Counts the tuples each condition of a filter is evaluated on and passes in profile mode
+ *
+ * For example ..
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    IF C1 /\ C2
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    IF true        -- counts the evaluations of C1
+ *     IF C1         -- counts the passes of C1, i.e., the evaluations of C2
+ *      IF C2        -- counts the passes of C2
+ *       ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * whose frequency counters are read back by the complexity analysis with
+ * `--profile-use`. Outermost filters of queries are evaluated once per query
+ * and are not instrumented.
+ */
+class InstrumentConditionsTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "InstrumentConditionsTransformer";
+    }
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override;
+};
+
+}  // namespace souffle::ram::transform
@@ -0,0 +1,151 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IntersectConversion.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/IntersectConversion.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Break.h"
+#include "ram/Condition.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IndexIntersect.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Relation.h"
+#include "ram/TupleElement.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** Relations whose indexes are b-trees ordered by the attributes of the index */
+bool isOrderedRelation(const Relation& rel) {
+    const auto rep = rel.getRepresentation();
+    // vector relations are b-trees when searched, and small relations keep the order of their b-trees
+    return rep == RelationRepresentation::BTREE || rep == RelationRepresentation::DEFAULT ||
+           rep == RelationRepresentation::VECTOR || rep == RelationRepresentation::SMALL;
+}
+
+}  // namespace
+
+Own<Operation> IntersectConversionTransformer::rewriteIndexScan(const IndexScan* indexScan) {
+    const int identifier = indexScan->getTupleId();
+    const auto* filter = as<Filter>(indexScan->getOperation());
+
+    // the outermost loop is left to the parallel transformer
+    if (filter == nullptr || identifier == 0 || Global::config().has("provenance")) {
+        return nullptr;
+    }
+
+    const Relation& rel = relAnalysis->lookup(indexScan->getRelation());
+    if (!isOrderedRelation(rel)) {
+        return nullptr;
+    }
+
+    // the scan may only search for equal values
+    const auto pattern = indexScan->getRangePattern();
+    const auto& lower = pattern.first;
+    const auto& upper = pattern.second;
+    for (std::size_t i = 0; i < rel.getArity(); ++i) {
+        if (isUndefValue(lower[i]) != isUndefValue(upper[i]) ||
+                (!isUndefValue(lower[i]) && *lower[i] != *upper[i])) {
+            return nullptr;
+        }
+    }
+
+    // the nested loops must not break out of the scan
+    bool hasBreak = false;
+    visit(filter->getOperation(), [&](const Break&) { hasBreak = true; });
+    if (hasBreak) {
+        return nullptr;
+    }
+
+    // find a partner referring to the scanned tuple by a single free attribute only
+    auto conditions = toConjunctionList(&filter->getCondition());
+    for (auto cur = conditions.begin(); cur != conditions.end(); ++cur) {
+        const auto* partner = as<ExistenceCheck>(*cur);
+        if (partner == nullptr) {
+            continue;
+        }
+
+        const Relation& partnerRel = relAnalysis->lookup(partner->getRelation());
+        if (!isOrderedRelation(partnerRel) || partnerRel.getArity() != rel.getArity()) {
+            continue;
+        }
+
+        std::optional<std::pair<std::size_t, std::size_t>> shared;
+        bool viable = true;
+        const auto values = partner->getValues();
+        for (std::size_t i = 0; i < values.size() && viable; ++i) {
+            const auto* element = as<TupleElement>(values[i]);
+            if (element != nullptr && element->getTupleId() == identifier && !shared.has_value()) {
+                shared = std::make_pair(element->getElement(), i);
+            } else if (rla->getLevel(values[i]) >= identifier) {
+                viable = false;
+            }
+        }
+        if (!viable || !shared.has_value()) {
+            continue;
+        }
+
+        const auto [element, partnerElement] = *shared;
+        const auto& type = rel.getAttributeTypes()[element];
+        const auto& partnerType = partnerRel.getAttributeTypes()[partnerElement];
+        if (!isUndefValue(lower[element]) || type[0] != partnerType[0] || type[0] == 'f') {
+            continue;
+        }
+
+        // the remaining conditions stay with the nested operation
+        Own<ExistenceCheck> intersectPartner = clone(partner);
+        conditions.erase(cur);
+        Own<Operation> nested = clone(filter->getOperation());
+        if (!conditions.empty()) {
+            nested = mk<Filter>(toCondition(conditions), std::move(nested), filter->getProfileText());
+        }
+        return mk<IndexIntersect>(indexScan->getRelation(), identifier,
+                make_pair(clone(lower), clone(upper)), element,
+                std::move(intersectPartner), partnerElement, std::move(nested), indexScan->getProfileText());
+    }
+
+    return nullptr;
+}
+
+bool IntersectConversionTransformer::convertScans(Program& program) {
+    bool changed = false;
+    forEachQueryMap(program, [&](auto&& go, Own<Node> node) -> Own<Node> {
+        if (const IndexScan* indexScan = as<IndexScan>(node)) {
+            if (auto op = rewriteIndexScan(indexScan)) {
+                changed = true;
+                node = std::move(op);
+            }
+        }
+
+        node->apply(go);
+        return node;
+    });
+
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
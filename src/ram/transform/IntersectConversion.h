@@ -0,0 +1,92 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file IntersectConversion.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/IndexScan.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Level.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include <memory>
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class IntersectConversionTransformer
+ * @brief Convert IndexScan/Filter pairs probing another relation on a
+ * single attribute of the scanned tuple to IndexIntersect operations
+ *
+ * Cyclic rule bodies, e.g., triangle queries, scan a relation whose tuples
+ * are only kept if some attribute is found in another relation as well.
+ * Rather than probing the other relation for each tuple of the scan, both
+ * relations are traversed in the order of the shared attribute.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    FOR t1 IN B ON INDEX t1.0 = t0.1
+ *     IF (t0.0, t1.1) IN C
+ *      ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   ...
+ *    FOR t1 IN B ON INDEX t1.0 = t0.1 INTERSECT t1.1 WITH (t0.0, t1.1) IN C
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The conversion is restricted to inner loops over b-tree relations whose
+ * shared attributes have the same, non-float type, since both indexes have
+ * to order the shared attribute alike.
+ */
+class IntersectConversionTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "IntersectConversionTransformer";
+    }
+
+    /**
+     * @brief Rewrite IndexScan operations
+     * @param An index scan operation
+     * @result nullptr if the conversion fails; otherwise the IndexIntersect operation
+     */
+    Own<Operation> rewriteIndexScan(const IndexScan* indexScan);
+
+    /**
+     * @brief Apply intersect conversion to the whole program
+     * @param RAM program
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool convertScans(Program& program);
+
+protected:
+    analysis::LevelAnalysis* rla{nullptr};
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+    bool transform(TranslationUnit& translationUnit) override {
+        rla = &translationUnit.getAnalysis<analysis::LevelAnalysis>();
+        relAnalysis = &translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return convertScans(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
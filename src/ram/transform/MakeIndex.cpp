@@ -94,7 +94,9 @@ ExpressionPair MakeIndexTransformer::getLowerUpperExpression(
                            !Global::config().has("generate") && !Global::config().has("swig");
         bool provenance = Global::config().has("provenance");
         bool btree = (rep == RelationRepresentation::BTREE || rep == RelationRepresentation::DEFAULT ||
-                      rep == RelationRepresentation::BTREE_DELETE);
+                      rep == RelationRepresentation::BTREE_DELETE ||
+                      rep == RelationRepresentation::COLUMNAR || rep == RelationRepresentation::VECTOR ||
+                      rep == RelationRepresentation::SMALL);
         auto op = binRelOp->getOperator();
 
         // don't index FEQ in interpreter mode
@@ -0,0 +1,156 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MergeConversion.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/MergeConversion.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/Expression.h"
+#include "ram/IndexOperation.h"
+#include "ram/IndexScan.h"
+#include "ram/MergeJoin.h"
+#include "ram/Node.h"
+#include "ram/Operation.h"
+#include "ram/ParallelIndexScan.h"
+#include "ram/ParallelScan.h"
+#include "ram/Program.h"
+#include "ram/Relation.h"
+#include "ram/Scan.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "souffle/utility/MiscUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** Relations whose indexes are b-trees ordered by the attributes of the index */
+bool isOrderedRelation(const Relation& rel) {
+    const auto rep = rel.getRepresentation();
+    // vector relations are b-trees when searched, and small relations keep the order of their b-trees
+    return rep == RelationRepresentation::BTREE || rep == RelationRepresentation::DEFAULT ||
+           rep == RelationRepresentation::VECTOR || rep == RelationRepresentation::SMALL;
+}
+
+/** Whether the pattern of an index operation only searches for equal values */
+bool isEqualityPattern(const IndexOperation& search) {
+    const auto pattern = search.getRangePattern();
+    for (std::size_t i = 0; i < pattern.first.size(); ++i) {
+        const Expression* lower = pattern.first[i];
+        const Expression* upper = pattern.second[i];
+        if (isUndefValue(lower) != isUndefValue(upper) || (!isUndefValue(lower) && *lower != *upper)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+Own<Operation> MergeConversionTransformer::rewriteScan(const RelationOperation* scan) {
+    const int identifier = scan->getTupleId();
+    const auto* inner = as<IndexScan>(scan->getOperation());
+    if (inner == nullptr || isA<MergeJoin>(inner) || Global::config().has("provenance")) {
+        return nullptr;
+    }
+
+    const Relation& rel = relAnalysis->lookup(scan->getRelation());
+    const Relation& innerRel = relAnalysis->lookup(inner->getRelation());
+    if (!isOrderedRelation(rel) || !isOrderedRelation(innerRel) || rel.getArity() == 0) {
+        return nullptr;
+    }
+
+    // the scan may only search for equal values
+    RamPattern pattern;
+    if (const auto* indexScan = as<IndexScan>(scan)) {
+        if (!isEqualityPattern(*indexScan)) {
+            return nullptr;
+        }
+        pattern = clone(indexScan->getRangePattern());
+    } else {
+        for (std::size_t i = 0; i < rel.getArity(); ++i) {
+            pattern.first.push_back(mk<UndefValue>());
+            pattern.second.push_back(mk<UndefValue>());
+        }
+    }
+
+    // the inner scan must refer to the scanned tuple by a single equality with a free attribute
+    if (!isEqualityPattern(*inner)) {
+        return nullptr;
+    }
+    std::optional<std::size_t> element;
+    for (const Expression* value : inner->getRangePattern().first) {
+        const auto* tupleElement = as<TupleElement>(value);
+        if (tupleElement != nullptr && tupleElement->getTupleId() == identifier && !element.has_value()) {
+            element = tupleElement->getElement();
+        } else if (!isUndefValue(value) && rla->getLevel(value) >= identifier) {
+            return nullptr;
+        }
+    }
+    if (!element.has_value() || !isUndefValue(pattern.first[*element].get())) {
+        return nullptr;
+    }
+
+    // an index of the relation must already order the join attribute after the equalities
+    std::set<std::size_t> equalities;
+    for (std::size_t i = 0; i < pattern.first.size(); ++i) {
+        if (!isUndefValue(pattern.first[i].get())) {
+            equalities.insert(i);
+        }
+    }
+    bool compatible = false;
+    for (const auto& order : idxAnalysis->getIndexSelection(scan->getRelation()).getAllOrders()) {
+        if (order.size() > equalities.size() && order[equalities.size()] == *element &&
+                std::all_of(order.begin(), order.begin() + equalities.size(),
+                        [&](std::size_t attr) { return equalities.count(attr) > 0; })) {
+            compatible = true;
+        }
+    }
+    if (!compatible) {
+        return nullptr;
+    }
+
+    return mk<MergeJoin>(scan->getRelation(), identifier, std::move(pattern), *element,
+            clone(scan->getOperation()), scan->getProfileText());
+}
+
+bool MergeConversionTransformer::convertScans(Program& program) {
+    bool changed = false;
+    forEachQueryMap(program, [&](auto&& go, Own<Node> node) -> Own<Node> {
+        const auto* scan = as<RelationOperation>(node);
+        const bool isScan = isA<Scan>(scan) && !isA<ParallelScan>(scan);
+        const bool isIndexScan =
+                isA<IndexScan>(scan) && !isA<ParallelIndexScan>(scan) && !isA<MergeJoin>(scan);
+        if (isScan || isIndexScan) {
+            if (auto op = rewriteScan(scan)) {
+                changed = true;
+                node = std::move(op);
+            }
+        }
+
+        node->apply(go);
+        return node;
+    });
+
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
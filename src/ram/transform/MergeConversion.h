@@ -0,0 +1,95 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file MergeConversion.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/RelationOperation.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Index.h"
+#include "ram/analysis/Level.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include <memory>
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class MergeConversionTransformer
+ * @brief Convert scans whose nested index scan probes another relation on
+ * a single attribute of the scanned tuple to MergeJoin operations
+ *
+ * An equi-join of two atoms is evaluated as a scan of the outer relation
+ * that probes the index of the inner relation for each scanned tuple. If
+ * the outer relation is scanned in the order of the join attribute, the
+ * probes arrive in the order of the inner index as well, and each of them
+ * continues where the previous one ended.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B ON INDEX t1.0 = t0.1
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A MERGE ON t0.1
+ *    FOR t1 IN B ON INDEX t1.0 = t0.1
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The conversion is restricted to b-tree relations and to outer relations
+ * which already have an index ordered by the join attribute after the
+ * equalities of the scan, such that no index is added for the join.
+ */
+class MergeConversionTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "MergeConversionTransformer";
+    }
+
+    /**
+     * @brief Rewrite Scan/IndexScan operations
+     * @param A scan or an index scan operation
+     * @result nullptr if the conversion fails; otherwise the MergeJoin operation
+     */
+    Own<Operation> rewriteScan(const RelationOperation* scan);
+
+    /**
+     * @brief Apply merge conversion to the whole program
+     * @param RAM program
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool convertScans(Program& program);
+
+protected:
+    analysis::IndexAnalysis* idxAnalysis{nullptr};
+    analysis::LevelAnalysis* rla{nullptr};
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+    bool transform(TranslationUnit& translationUnit) override {
+        idxAnalysis = &translationUnit.getAnalysis<analysis::IndexAnalysis>();
+        rla = &translationUnit.getAnalysis<analysis::LevelAnalysis>();
+        relAnalysis = &translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return convertScans(translationUnit.getProgram());
+    }
+};
+
+}  // namespace souffle::ram::transform
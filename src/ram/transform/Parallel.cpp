@@ -38,16 +38,16 @@ bool ParallelTransformer::parallelizeOperations(Program& program) {
     // parallelize the most outer loop only
     // most outer loops can be scan/if-exists/indexScan/indexIfExists
     forEachQuery(program, [&](Query& query) {
-        // guardedInsert cannot be parallelized
-        if (visitExists(query, [&](const GuardedInsert&) { return true; })) return;
-        // erase cannot be parallelized
+        // erase cannot be parallelized, guarded insertions are serialised by the evaluators
         if (visitExists(query, [&](const Erase&) { return true; })) return;
 
         query.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
             if (const Scan* scan = as<Scan>(node)) {
                 const Relation& rel = relAnalysis->lookup(scan->getRelation());
                 if (scan->getTupleId() == 0 && rel.getArity() > 0) {
-                    if (!isA<Insert>(&scan->getOperation())) {
+                    // plain copies stay sequential, unlike copies recording new tuples of recursive rules
+                    const Operation& nested = scan->getOperation();
+                    if (!isA<Insert>(&nested) || isA<NoveltyInsert>(&nested)) {
                         changed = true;
                         return mk<ParallelScan>(scan->getRelation(), scan->getTupleId(),
                                 clone(scan->getOperation()), scan->getProfileText());
@@ -60,6 +60,14 @@ bool ParallelTransformer::parallelizeOperations(Program& program) {
                             clone(ifexists->getCondition()), clone(ifexists->getOperation()),
                             ifexists->getProfileText());
                 }
+            } else if (const MergeJoin* join = as<MergeJoin>(node)) {
+                if (join->getTupleId() == 0) {
+                    changed = true;
+                    RamPattern queryPattern = clone(join->getRangePattern());
+                    return mk<ParallelMergeJoin>(join->getRelation(), join->getTupleId(),
+                            std::move(queryPattern), join->getElement(), clone(join->getOperation()),
+                            join->getProfileText());
+                }
             } else if (const IndexScan* indexScan = as<IndexScan>(node)) {
                 if (indexScan->getTupleId() == 0) {
                     changed = true;
@@ -95,6 +103,13 @@ bool ParallelTransformer::parallelizeOperations(Program& program) {
                             clone(indexAggregate->getExpression()), clone(indexAggregate->getCondition()),
                             std::move(queryPattern), indexAggregate->getTupleId());
                 }
+            } else if (const NestedIntrinsicOperator* range = as<NestedIntrinsicOperator>(node)) {
+                // float ranges accumulate their steps, hence their values depend on running them in order
+                if (range->getTupleId() == 0 && range->getFunction() != NestedIntrinsicOp::FRANGE) {
+                    changed = true;
+                    return mk<ParallelNestedIntrinsicOperator>(range->getFunction(),
+                            clone(range->getArguments()), clone(range->getOperation()), range->getTupleId());
+                }
             }
 
             node->apply(go);
@@ -0,0 +1,82 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RelaxSearch.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/RelaxSearch.h"
+#include "ram/Condition.h"
+#include "ram/Constraint.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/Node.h"
+#include "ram/Relation.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <typeinfo>
+#include <utility>
+
+namespace souffle::ram::transform {
+
+Own<Operation> RelaxSearchTransformer::relaxIndexScan(const IndexScan& indexScan) {
+    const auto search = idxAnalysis->getSearchSignature(&indexScan);
+    const auto& cluster = idxAnalysis->getIndexSelection(indexScan.getRelation());
+    if (!cluster.isRelaxed(search)) {
+        return nullptr;
+    }
+    const auto target = cluster.getRelaxedSearch(search);
+    const Relation& rel = relAnalysis->lookup(indexScan.getRelation());
+    const int identifier = indexScan.getTupleId();
+
+    // the equalities left out by the target search are checked by a filter
+    const auto pattern = indexScan.getRangePattern();
+    RamPattern queryPattern;
+    VecOwn<Condition> conditions;
+    for (std::size_t i = 0; i < rel.getArity(); ++i) {
+        if (search[i] != target[i]) {
+            conditions.push_back(mk<Constraint>(getEqConstraint(rel.getAttributeTypes()[i]),
+                    mk<TupleElement>(identifier, i), clone(pattern.first[i])));
+            queryPattern.first.push_back(mk<UndefValue>());
+            queryPattern.second.push_back(mk<UndefValue>());
+        } else {
+            queryPattern.first.push_back(clone(pattern.first[i]));
+            queryPattern.second.push_back(clone(pattern.second[i]));
+        }
+    }
+
+    return mk<IndexScan>(rel.getName(), identifier, std::move(queryPattern),
+            mk<Filter>(toCondition(conditions), clone(indexScan.getOperation())),
+            indexScan.getProfileText());
+}
+
+bool RelaxSearchTransformer::relaxSearches(Program& program) {
+    bool changed = false;
+    forEachQueryMap(program, [&](auto&& go, Own<Node> node) -> Own<Node> {
+        if (const auto* indexScan = as<IndexScan>(node)) {
+            if (typeid(*indexScan) == typeid(IndexScan)) {
+                if (Own<Operation> relaxed = relaxIndexScan(*indexScan)) {
+                    changed = true;
+                    node = std::move(relaxed);
+                }
+            }
+        }
+        node->apply(go);
+        return node;
+    });
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
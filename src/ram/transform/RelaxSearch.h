@@ -0,0 +1,84 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file RelaxSearch.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/IndexScan.h"
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Index.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class RelaxSearchTransformer
+ * @brief Search on the index of another search if the cost-based index
+ * selection gave up the index of a search
+ *
+ * The equalities the index does not cover are checked by a filter instead.
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A ON INDEX t0.0 = 1 AND t0.1 = 2
+ *    ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A ON INDEX t0.0 = 1
+ *    IF (t0.1 = 2)
+ *     ...
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * if the search on both attributes of A is too rare to be worth an index.
+ */
+class RelaxSearchTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "RelaxSearchTransformer";
+    }
+
+    /**
+     * @brief Relax an index scan whose search gave up its index
+     * @param indexScan Index scan
+     * @result the relaxed index scan, or nullptr if the search keeps its index
+     */
+    Own<Operation> relaxIndexScan(const IndexScan& indexScan);
+
+    /**
+     * @brief Relax the index scans of the program
+     * @param program Program that is transformed
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool relaxSearches(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        idxAnalysis = &translationUnit.getAnalysis<analysis::IndexAnalysis>();
+        relAnalysis = &translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return relaxSearches(translationUnit.getProgram());
+    }
+
+    analysis::IndexAnalysis* idxAnalysis{nullptr};
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+};
+
+}  // namespace souffle::ram::transform
@@ -42,7 +42,7 @@ bool ReorderConditionsTransformer::transform(TranslationUnit& tu) {
                 sortedConds.emplace_back(cond->cloning());
             }
             std::sort(sortedConds.begin(), sortedConds.end(), [&](Own<Condition>& a, Own<Condition>& b) {
-                return rca.getComplexity(a.get()) < rca.getComplexity(b.get());
+                return rca.getRank(a.get()) < rca.getRank(b.get());
             });
             auto sorted_node = toCondition(sortedConds);
 
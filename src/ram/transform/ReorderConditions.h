@@ -47,7 +47,8 @@ namespace souffle::ram::transform {
  *
  *  where C(i(1)) <= C(i(2)) <= ....   <= C(i(N)).
  *
- * The terms are sorted according to their complexity class.
+ * The terms are sorted according to their complexity class, or with
+ * `--profile-use` by the expected cost of rejecting a tuple.
  *
  */
 
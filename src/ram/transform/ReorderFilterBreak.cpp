@@ -36,7 +36,8 @@ bool ReorderFilterBreak::reorderFilterBreak(Program& program) {
                 changed = true;
                 // convert to break-filter nesting
                 node = mk<Break>(clone(br->getCondition()),
-                        mk<Filter>(clone(filter->getCondition()), clone(br->getOperation())));
+                        mk<Filter>(clone(filter->getCondition()), clone(br->getOperation()),
+                                filter->getProfileText()));
             }
         }
 
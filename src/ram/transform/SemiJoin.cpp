@@ -0,0 +1,267 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SemiJoin.cpp
+ *
+ ***********************************************************************/
+
+#include "ram/transform/SemiJoin.h"
+#include "Global.h"
+#include "RelationTag.h"
+#include "ram/AbstractExistenceCheck.h"
+#include "ram/AutoIncrement.h"
+#include "ram/Clear.h"
+#include "ram/Condition.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/Erase.h"
+#include "ram/ExistenceCheck.h"
+#include "ram/Expression.h"
+#include "ram/Filter.h"
+#include "ram/IfExists.h"
+#include "ram/IndexIfExists.h"
+#include "ram/IndexScan.h"
+#include "ram/Insert.h"
+#include "ram/Loop.h"
+#include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
+#include "ram/RelationSize.h"
+#include "ram/Scan.h"
+#include "ram/Sequence.h"
+#include "ram/True.h"
+#include "ram/TupleElement.h"
+#include "ram/UndefValue.h"
+#include "ram/utility/NodeMapper.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/NodeMapper.h"
+#include "souffle/utility/StringUtil.h"
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram::transform {
+
+namespace {
+
+/** Return whether a node refers to the tuple of the given identifier */
+bool refersTo(const Node& node, int identifier) {
+    bool res = false;
+    visit(node, [&](const TupleElement& element) { res = res || element.getTupleId() == identifier; });
+    return res;
+}
+
+}  // namespace
+
+Own<Operation> SemiJoinTransformer::reduceScan(
+        const RelationOperation& scan, const std::set<std::string>& written) {
+    if (typeid(scan) != typeid(Scan) && typeid(scan) != typeid(IndexScan)) {
+        return nullptr;
+    }
+    const int identifier = scan.getTupleId();
+
+    // the filters of the scan are checked along with the semi-join
+    VecOwn<Condition> conditions;
+    const Operation* op = &scan.getOperation();
+    while (const auto* filter = as<Filter>(op)) {
+        conditions.push_back(clone(filter->getCondition()));
+        op = &filter->getOperation();
+    }
+    if (typeid(*op) != typeid(IfExists) && typeid(*op) != typeid(IndexIfExists)) {
+        return nullptr;
+    }
+    const auto& inner = *as<RelationOperation>(op);
+    const int innerIdentifier = inner.getTupleId();
+    const Condition& where = as<AbstractIfExists, AllowCrossCast>(op)->getCondition();
+
+    // the nested operation must yield the same result for all tuples of the scan
+    if (refersTo(inner.getOperation(), identifier) || refersTo(inner.getOperation(), innerIdentifier)) {
+        return nullptr;
+    }
+
+    // the semi-join can only be computed before the query if the inner check only depends on the scan
+    bool dependent = false;
+    visit(where, [&](const TupleElement& element) {
+        dependent = dependent || element.getTupleId() != innerIdentifier;
+    });
+    visit(where, [&](const AutoIncrement&) { dependent = true; });
+    std::set<std::string> read{inner.getRelation()};
+    visit(where, [&](const Node& node) {
+        if (const auto* exists = as<AbstractExistenceCheck>(node)) {
+            read.insert(exists->getRelation());
+        } else if (const auto* emptiness = as<EmptinessCheck>(node)) {
+            read.insert(emptiness->getRelation());
+        } else if (const auto* size = as<RelationSize>(node)) {
+            read.insert(size->getRelation());
+        }
+    });
+    for (const auto& rel : read) {
+        dependent = dependent || contains(written, rel);
+    }
+    if (dependent) {
+        return nullptr;
+    }
+
+    // the attributes of the scan searched by the inner check are the keys of the semi-join
+    const Relation& innerRel = relAnalysis->lookup(inner.getRelation());
+    std::vector<std::size_t> keys;
+    std::vector<std::size_t> innerKeys;
+    RamPattern innerPattern;
+    for (std::size_t i = 0; i < innerRel.getArity(); ++i) {
+        innerPattern.first.push_back(mk<UndefValue>());
+        innerPattern.second.push_back(mk<UndefValue>());
+    }
+    if (const auto* indexInner = as<IndexIfExists>(op)) {
+        const auto pattern = indexInner->getRangePattern();
+        for (std::size_t i = 0; i < pattern.first.size(); ++i) {
+            const auto* lower = as<TupleElement>(pattern.first[i]);
+            const auto* upper = as<TupleElement>(pattern.second[i]);
+            if (refersTo(*pattern.first[i], identifier) || refersTo(*pattern.second[i], identifier)) {
+                if (lower == nullptr || upper == nullptr || *lower != *upper ||
+                        contains(keys, lower->getElement())) {
+                    return nullptr;
+                }
+                keys.push_back(lower->getElement());
+                innerKeys.push_back(i);
+            } else {
+                // constant bounds also restrict the semi-join, bounds by outer tuples prevent it
+                bool tuples = false;
+                visit(*pattern.first[i], [&](const TupleElement&) { tuples = true; });
+                visit(*pattern.second[i], [&](const TupleElement&) { tuples = true; });
+                if (tuples) {
+                    return nullptr;
+                }
+                innerPattern.first[i] = clone(pattern.first[i]);
+                innerPattern.second[i] = clone(pattern.second[i]);
+            }
+        }
+    }
+    if (keys.empty()) {
+        return nullptr;
+    }
+
+    // project the values of the inner relation passing its check into a temporary relation
+    const std::string name = "@semijoin_" + toString(numSemiJoins++);
+    std::vector<std::string> attributeNames;
+    std::vector<std::string> attributeTypes;
+    VecOwn<Expression> projected;
+    VecOwn<Expression> checked;
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+        attributeNames.push_back(innerRel.getAttributeNames()[innerKeys[k]]);
+        attributeTypes.push_back(innerRel.getAttributeTypes()[innerKeys[k]]);
+        projected.push_back(mk<TupleElement>(0, innerKeys[k]));
+        checked.push_back(mk<TupleElement>(identifier, keys[k]));
+    }
+    semiJoins.push_back(mk<Relation>(name, keys.size(), 0, std::move(attributeNames),
+            std::move(attributeTypes), RelationRepresentation::DEFAULT));
+
+    Own<Operation> projection = mk<Insert>(name, std::move(projected));
+    if (!isTrue(&where)) {
+        projection = mk<Filter>(mapPre(clone(where),
+                                        [&](Own<TupleElement> element) -> Own<TupleElement> {
+                                            return mk<TupleElement>(0, element->getElement());
+                                        }),
+                std::move(projection));
+    }
+    bool indexed = false;
+    for (const auto& value : innerPattern.first) {
+        indexed = indexed || !isUndefValue(value.get());
+    }
+    if (indexed) {
+        projection = mk<IndexScan>(inner.getRelation(), 0, std::move(innerPattern), std::move(projection),
+                inner.getProfileText());
+    } else {
+        projection = mk<Scan>(inner.getRelation(), 0, std::move(projection), inner.getProfileText());
+    }
+    projections.push_back(mk<Query>(std::move(projection)));
+
+    // the scan stops at its first tuple in the semi-join
+    conditions.push_back(mk<ExistenceCheck>(name, std::move(checked)));
+    if (const auto* indexScan = as<IndexScan>(scan)) {
+        const auto pattern = indexScan->getRangePattern();
+        return mk<IndexIfExists>(scan.getRelation(), identifier, toCondition(conditions),
+                make_pair(clone(pattern.first), clone(pattern.second)), clone(inner.getOperation()),
+                scan.getProfileText());
+    }
+    return mk<IfExists>(scan.getRelation(), identifier, toCondition(conditions), clone(inner.getOperation()),
+            scan.getProfileText());
+}
+
+Own<Statement> SemiJoinTransformer::reduceQuery(const Query& query) {
+    std::set<std::string> written;
+    visit(query, [&](const Insert& insert) { written.insert(insert.getRelation()); });
+    visit(query, [&](const NoveltyInsert& insert) { written.insert(insert.getNewRelation()); });
+    visit(query, [&](const Erase& erase) { written.insert(erase.getRelation()); });
+
+    // inner scans are reduced first, such that the reduced scans may in turn be checked by outer scans
+    projections.clear();
+    auto reduced = clone(query);
+    reduced->apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        node->apply(go);
+        if (const auto* scan = as<RelationOperation>(node)) {
+            if (Own<Operation> ifExists = reduceScan(*scan, written)) {
+                return ifExists;
+            }
+        }
+        return node;
+    }));
+    if (projections.empty()) {
+        return nullptr;
+    }
+
+    VecOwn<Statement> statements = std::move(projections);
+    projections.clear();
+    std::vector<std::string> names;
+    for (const auto& stmt : statements) {
+        visit(*stmt, [&](const Insert& insert) { names.push_back(insert.getRelation()); });
+    }
+    statements.push_back(std::move(reduced));
+    for (const auto& name : names) {
+        statements.push_back(mk<Clear>(name));
+    }
+    return mk<Sequence>(std::move(statements));
+}
+
+bool SemiJoinTransformer::reduceQueries(Program& program) {
+    if (!Global::config().has("semi-join") || Global::config().has("provenance")) {
+        return false;
+    }
+    for (const auto* rel : program.getRelations()) {
+        if (isPrefix("@semijoin_", rel->getName())) {
+            ++numSemiJoins;
+        }
+    }
+
+    bool changed = false;
+    program.apply(nodeMapper<Node>([&](auto&& go, Own<Node> node) -> Own<Node> {
+        // the relations of fixpoint loops change in each iteration
+        if (isA<Loop>(node)) {
+            return node;
+        }
+        if (const auto* query = as<Query>(node)) {
+            if (Own<Statement> reduced = reduceQuery(*query)) {
+                changed = true;
+                return reduced;
+            }
+            return node;
+        }
+        node->apply(go);
+        return node;
+    }));
+
+    for (auto& rel : semiJoins) {
+        program.addRelation(std::move(rel));
+    }
+    semiJoins.clear();
+    return changed;
+}
+
+}  // namespace souffle::ram::transform
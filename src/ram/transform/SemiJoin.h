@@ -0,0 +1,118 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SemiJoin.h
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Operation.h"
+#include "ram/Program.h"
+#include "ram/Query.h"
+#include "ram/Relation.h"
+#include "ram/RelationOperation.h"
+#include "ram/Statement.h"
+#include "ram/TranslationUnit.h"
+#include "ram/analysis/Relation.h"
+#include "ram/transform/Transformer.h"
+#include <cstddef>
+#include <set>
+#include <string>
+
+namespace souffle::ram::transform {
+
+/**
+ * @class SemiJoinTransformer
+ * @brief Turn scans only used by the existence check of an inner relation
+ * into existence checks on a semi-join of the inner relation
+ *
+ * A scan whose tuple is only used to search an inner if-exists operation
+ * enumerates all of its matching tuples, although the operation nested in
+ * the if-exists operation yields the same result for each of them. The
+ * values of the inner relation whose check succeeds are hence projected
+ * into a temporary relation before the query, which the scan checks for
+ * the first match instead.
+ *
+ * For example,
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B ON INDEX t1.0 = t0.0
+ *     IF ∃t2 IN C ON INDEX t2.0 = t1.1 WHERE (t2.1 > 5)
+ *      INSERT (t0.0) INTO D
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * will be rewritten to
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN C
+ *    IF (t0.1 > 5)
+ *     INSERT (t0.0) INTO @semijoin_0
+ *  QUERY
+ *   FOR t0 IN A
+ *    IF ∃t1 IN B ON INDEX t1.0 = t0.0 WHERE (t1.1) IN @semijoin_0
+ *     INSERT (t0.0) INTO D
+ *  CLEAR @semijoin_0
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The semi-join is computed once per evaluation of the query, so queries
+ * of fixpoint loops are left as they are. The transformer is enabled by
+ * the pragma semi-join.
+ */
+class SemiJoinTransformer : public Transformer {
+public:
+    std::string getName() const override {
+        return "SemiJoinTransformer";
+    }
+
+    /**
+     * @brief Apply the semi-join reduction to the queries outside of fixpoint loops
+     * @param program The RAM program
+     * @result A flag indicating whether the RAM program has been changed.
+     */
+    bool reduceQueries(Program& program);
+
+protected:
+    bool transform(TranslationUnit& translationUnit) override {
+        relAnalysis = &translationUnit.getAnalysis<analysis::RelationAnalysis>();
+        return reduceQueries(translationUnit.getProgram());
+    }
+
+    /**
+     * @brief Reduce the scans of a query
+     * @result the query evaluating the semi-joins before and clearing them after it,
+     * or nullptr if no scan is reduced
+     */
+    Own<Statement> reduceQuery(const Query& query);
+
+    /**
+     * @brief Turn a scan only used by an inner if-exists operation into an if-exists operation
+     * @param scan The scan or index scan
+     * @param written The relations written by the query, which cannot be projected before it
+     * @result The if-exists operation, or nullptr if the scan is not reduced
+     */
+    Own<Operation> reduceScan(const RelationOperation& scan, const std::set<std::string>& written);
+
+    analysis::RelationAnalysis* relAnalysis{nullptr};
+
+    /** Temporary relations of the semi-joins, added to the program once it is transformed */
+    VecOwn<Relation> semiJoins;
+
+    /** Queries evaluating the semi-joins of the query being reduced */
+    VecOwn<Statement> projections;
+
+    /** Number of temporary relations of the program */
+    std::size_t numSemiJoins = 0;
+};
+
+}  // namespace souffle::ram::transform
@@ -40,8 +40,9 @@ bool Transformer::apply(TranslationUnit& translationUnit) {
     bool changed = transform(translationUnit);
     auto end = std::chrono::high_resolution_clock::now();
 
-    // invalidate analyses in case the program has changed
-    if (changed) {
+    // invalidate analyses in case the program has changed; meta-transformers leave the invalidation to
+    // their sub-transformers
+    if (changed && !isA<MetaTransformer>(this)) {
         translationUnit.invalidateAnalyses();
     }
 
@@ -0,0 +1,79 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file DeferredInserts.h
+ *
+ * Determines the insertions of a parallel operation whose tuples the
+ * threads may collect and insert at the end of the operation.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/AbstractExistenceCheck.h"
+#include "ram/EmptinessCheck.h"
+#include "ram/Erase.h"
+#include "ram/GuardedInsert.h"
+#include "ram/Insert.h"
+#include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
+#include "ram/Operation.h"
+#include "ram/RelationOperation.h"
+#include "ram/RelationSize.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @brief Return the insertions nested in a parallel operation whose tuples the threads may collect
+ * and insert at the end of the operation
+ *
+ * These are the unguarded insertions into relations of a positive arity which the operation does not
+ * access otherwise, such that the operation cannot observe whether their tuples were inserted yet.
+ * Each thread collects the tuples in a buffer of its own rather than inserting them into the shared
+ * relation, and the sorted buffers are merged into the relation once all threads have finished.
+ */
+inline std::vector<const Insert*> getDeferrableInserts(const Operation& op) {
+    std::map<std::string, std::size_t> accesses;
+    visit(op, [&](const Node& node) {
+        if (const auto* cur = as<RelationOperation>(node)) {
+            ++accesses[cur->getRelation()];
+        } else if (const auto* cur = as<AbstractExistenceCheck>(node)) {
+            ++accesses[cur->getRelation()];
+        } else if (const auto* cur = as<EmptinessCheck>(node)) {
+            ++accesses[cur->getRelation()];
+        } else if (const auto* cur = as<RelationSize>(node)) {
+            ++accesses[cur->getRelation()];
+        } else if (const auto* cur = as<Erase>(node)) {
+            ++accesses[cur->getRelation()];
+        } else if (const auto* cur = as<NoveltyInsert>(node)) {
+            ++accesses[cur->getRelation()];
+            ++accesses[cur->getNewRelation()];
+        } else if (const auto* cur = as<Insert>(node)) {
+            ++accesses[cur->getRelation()];
+        }
+    });
+
+    std::vector<const Insert*> inserts;
+    visit(op, [&](const Insert& insert) {
+        if (!isA<GuardedInsert>(insert) && !isA<NoveltyInsert>(insert) && !insert.getValues().empty() &&
+                accesses[insert.getRelation()] == 1) {
+            inserts.push_back(&insert);
+        }
+    });
+    return inserts;
+}
+
+}  // namespace souffle::ram
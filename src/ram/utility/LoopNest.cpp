@@ -0,0 +1,381 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LoopNest.cpp
+ *
+ * Implementation of the flattened loop nest of a query
+ *
+ ***********************************************************************/
+
+#include "ram/utility/LoopNest.h"
+#include "ram/AutoIncrement.h"
+#include "ram/Break.h"
+#include "ram/Constraint.h"
+#include "ram/Filter.h"
+#include "ram/IndexIntersect.h"
+#include "ram/IndexScan.h"
+#include "ram/MergeJoin.h"
+#include "ram/ParallelIndexScan.h"
+#include "ram/ParallelMergeJoin.h"
+#include "ram/ParallelScan.h"
+#include "ram/Scan.h"
+#include "ram/TupleElement.h"
+#include "ram/TupleOperation.h"
+#include "ram/analysis/Relation.h"
+#include "ram/utility/Utils.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/NodeMapper.h"
+#include <numeric>
+#include <optional>
+#include <utility>
+
+namespace souffle::ram {
+
+namespace {
+
+/** Renumber the tuples of the atoms in a clone of the given node */
+template <typename T>
+Own<T> renumber(const T& node, const std::vector<std::size_t>& position) {
+    return mapPre(clone(node), [&](Own<TupleElement> element) -> Own<TupleElement> {
+        const auto id = static_cast<std::size_t>(element->getTupleId());
+        if (id < position.size()) {
+            return mk<TupleElement>(position[id], element->getElement());
+        }
+        return element;
+    });
+}
+
+/** Return whether the first set of atoms is contained in the second one */
+bool isSubset(const std::vector<bool>& lhs, const std::vector<bool>& rhs) {
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i] && !rhs[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+std::vector<bool> LoopNest::getReferencedAtoms(const Node& node) const {
+    std::vector<bool> res(atoms.size(), false);
+    visit(node, [&](const TupleElement& element) {
+        const auto id = static_cast<std::size_t>(element.getTupleId());
+        if (id < atoms.size()) {
+            res[id] = true;
+        }
+    });
+    return res;
+}
+
+Own<LoopNest> LoopNest::flatten(const Query& query, const analysis::RelationAnalysis& relAnalysis) {
+    // reordering must neither change where a break leaves the loops, nor the values of a counter
+    bool fixed = false;
+    visit(query, [&](const Break&) { fixed = true; });
+    visit(query, [&](const AutoIncrement&) { fixed = true; });
+    visit(query, [&](const IndexIntersect&) { fixed = true; });
+    visit(query, [&](const MergeJoin&) { fixed = true; });
+    visit(query, [&](const ParallelMergeJoin&) { fixed = true; });
+    if (fixed) {
+        return nullptr;
+    }
+
+    Own<LoopNest> nest(new LoopNest());
+    std::vector<const Condition*> conditions;
+    // equalities of each atom's attributes with outer values
+    std::vector<std::vector<const Expression*>> equalities;
+
+    const Operation* op = &query.getOperation();
+    while (true) {
+        if (const auto* filter = as<Filter>(op)) {
+            for (const auto* cond : findConjunctiveTerms(&filter->getCondition())) {
+                conditions.push_back(cond);
+            }
+            op = &filter->getOperation();
+            continue;
+        }
+        const auto* scan = as<RelationOperation>(op);
+        if (scan == nullptr || (!isA<Scan>(scan) && !isA<IndexScan>(scan)) ||
+                static_cast<std::size_t>(scan->getTupleId()) != nest->atoms.size()) {
+            break;
+        }
+        if (isA<ParallelScan>(scan) || isA<ParallelIndexScan>(scan)) {
+            if (!nest->atoms.empty()) {
+                return nullptr;
+            }
+            nest->parallel = true;
+        }
+
+        std::vector<const Expression*> values;
+        if (const auto* indexScan = as<IndexScan>(scan)) {
+            const auto pattern = indexScan->getRangePattern();
+            for (std::size_t i = 0; i < pattern.first.size(); ++i) {
+                const Expression* lower = pattern.first[i];
+                const Expression* upper = pattern.second[i];
+                if (isUndefValue(lower) != isUndefValue(upper) ||
+                        (!isUndefValue(lower) && *lower != *upper)) {
+                    return nullptr;
+                }
+                values.push_back(isUndefValue(lower) ? nullptr : lower);
+            }
+        }
+        equalities.push_back(std::move(values));
+        nest->atoms.push_back({scan->getRelation(), 0, scan->getProfileText(), {}});
+        op = &scan->getOperation();
+    }
+
+    const std::size_t numAtoms = nest->atoms.size();
+    if (numAtoms < 2) {
+        return nullptr;
+    }
+
+    // the tuples of the nested operation must be numbered after the ones of the atoms
+    visit(*op, [&](const TupleOperation& nestedOp) {
+        if (static_cast<std::size_t>(nestedOp.getTupleId()) < numAtoms) {
+            fixed = true;
+        }
+    });
+    if (fixed) {
+        return nullptr;
+    }
+    nest->nested = clone(op);
+
+    for (auto& atom : nest->atoms) {
+        atom.arity = relAnalysis.lookup(atom.relation).getArity();
+    }
+    for (std::size_t i = 0; i < numAtoms; ++i) {
+        equalities[i].resize(nest->atoms[i].arity, nullptr);
+    }
+
+    // join the attributes equal to each other into classes
+    std::vector<std::size_t> offset(numAtoms + 1, 0);
+    for (std::size_t i = 0; i < numAtoms; ++i) {
+        offset[i + 1] = offset[i] + nest->atoms[i].arity;
+    }
+    std::vector<std::size_t> parent(offset[numAtoms]);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](std::size_t x) {
+        while (parent[x] != x) {
+            x = parent[x] = parent[parent[x]];
+        }
+        return x;
+    };
+    for (std::size_t i = 0; i < numAtoms; ++i) {
+        for (std::size_t j = 0; j < equalities[i].size(); ++j) {
+            if (const auto* element = as<TupleElement>(equalities[i][j])) {
+                const auto id = static_cast<std::size_t>(element->getTupleId());
+                if (id < i) {
+                    parent[find(offset[i] + j)] = find(offset[id] + element->getElement());
+                }
+            }
+        }
+    }
+    std::vector<std::optional<std::size_t>> classIds(parent.size());
+    for (std::size_t i = 0; i < numAtoms; ++i) {
+        for (std::size_t j = 0; j < nest->atoms[i].arity; ++j) {
+            auto& classId = classIds[find(offset[i] + j)];
+            if (!classId.has_value()) {
+                classId = nest->numClasses++;
+            }
+            nest->atoms[i].classes.push_back(*classId);
+        }
+    }
+
+    // all other equalities bind a class to an expression
+    for (std::size_t i = 0; i < numAtoms; ++i) {
+        for (std::size_t j = 0; j < equalities[i].size(); ++j) {
+            const Expression* value = equalities[i][j];
+            const auto* element = as<TupleElement>(value);
+            if (value == nullptr ||
+                    (element != nullptr && static_cast<std::size_t>(element->getTupleId()) < i)) {
+                continue;
+            }
+            nest->bindings.push_back(
+                    {nest->atoms[i].classes[j], clone(value), nest->getReferencedAtoms(*value)});
+        }
+    }
+    for (const auto* cond : conditions) {
+        nest->terms.push_back({clone(cond), nest->getReferencedAtoms(*cond)});
+    }
+
+    return nest;
+}
+
+std::vector<std::size_t> LoopNest::getBoundElements(std::size_t atom, const std::vector<bool>& outer) const {
+    std::vector<bool> bound(numClasses, false);
+    for (std::size_t i = 0; i < atoms.size(); ++i) {
+        if (outer[i] && i != atom) {
+            for (std::size_t cls : atoms[i].classes) {
+                bound[cls] = true;
+            }
+        }
+    }
+    for (const auto& binding : bindings) {
+        if (!binding.atoms[atom] && isSubset(binding.atoms, outer)) {
+            bound[binding.attributeClass] = true;
+        }
+    }
+
+    std::vector<std::size_t> res;
+    for (std::size_t i = 0; i < atoms[atom].arity; ++i) {
+        if (bound[atoms[atom].classes[i]]) {
+            res.push_back(i);
+        }
+    }
+    return res;
+}
+
+std::vector<const Condition*> LoopNest::getConditions(
+        std::size_t atom, const std::vector<bool>& outer) const {
+    std::vector<bool> placed = outer;
+    placed[atom] = true;
+    std::vector<const Condition*> res;
+    for (const auto& term : terms) {
+        if (term.atoms[atom] && isSubset(term.atoms, placed)) {
+            res.push_back(term.condition.get());
+        }
+    }
+    return res;
+}
+
+Own<Query> LoopNest::reorder(const std::vector<std::size_t>& order, const IndexSelector& selector) const {
+    const std::size_t numAtoms = atoms.size();
+    assert(order.size() == numAtoms && "order does not cover all atoms");
+    std::vector<std::size_t> position(numAtoms);
+    for (std::size_t i = 0; i < numAtoms; ++i) {
+        position[order[i]] = i;
+    }
+
+    // the value each class of attributes is bound to, in terms of the original tuples
+    std::vector<const Expression*> classValues(numClasses, nullptr);
+    VecOwn<Expression> classElements(numClasses);
+    std::vector<bool> usedBindings(bindings.size(), false);
+    std::vector<bool> usedTerms(terms.size(), false);
+    std::vector<bool> placed(numAtoms, false);
+
+    // the patterns and conditions of each level, the outermost level being the one before all atoms
+    std::vector<RamPattern> patterns(numAtoms);
+    std::vector<VecOwn<Condition>> levelConditions(numAtoms + 1);
+
+    auto addConditions = [&](VecOwn<Condition>& conds) {
+        for (std::size_t i = 0; i < bindings.size(); ++i) {
+            const Expression* value = classValues[bindings[i].attributeClass];
+            if (!usedBindings[i] && value != nullptr && isSubset(bindings[i].atoms, placed)) {
+                usedBindings[i] = true;
+                conds.push_back(mk<Constraint>(BinaryConstraintOp::EQ, renumber(*value, position),
+                        renumber(*bindings[i].expression, position)));
+            }
+        }
+        for (std::size_t i = 0; i < terms.size(); ++i) {
+            if (!usedTerms[i] && isSubset(terms[i].atoms, placed)) {
+                usedTerms[i] = true;
+                conds.push_back(renumber(*terms[i].condition, position));
+            }
+        }
+    };
+    addConditions(levelConditions[0]);
+
+    for (std::size_t level = 0; level < numAtoms; ++level) {
+        const std::size_t atom = order[level];
+        const auto& classes = atoms[atom].classes;
+        auto& conds = levelConditions[level + 1];
+
+        // bind the attributes to the values of their classes
+        std::vector<const Expression*> values(atoms[atom].arity, nullptr);
+        std::vector<std::size_t> bound;
+        for (std::size_t i = 0; i < atoms[atom].arity; ++i) {
+            const std::size_t cls = classes[i];
+            if (classValues[cls] == nullptr) {
+                for (std::size_t j = 0; j < bindings.size(); ++j) {
+                    if (!usedBindings[j] && bindings[j].attributeClass == cls &&
+                            isSubset(bindings[j].atoms, placed)) {
+                        usedBindings[j] = true;
+                        classValues[cls] = bindings[j].expression.get();
+                        break;
+                    }
+                }
+            }
+            if (classValues[cls] != nullptr) {
+                values[i] = classValues[cls];
+                bound.push_back(i);
+            }
+        }
+
+        auto& pattern = patterns[level];
+        for (std::size_t i = 0; i < atoms[atom].arity; ++i) {
+            pattern.first.push_back(mk<UndefValue>());
+            pattern.second.push_back(mk<UndefValue>());
+        }
+        const std::vector<std::size_t> indexed = bound.empty() ? bound : selector(atom, bound);
+        for (std::size_t i : bound) {
+            auto value = renumber(*values[i], position);
+            if (contains(indexed, i)) {
+                pattern.first[i] = clone(value);
+                pattern.second[i] = std::move(value);
+            } else {
+                conds.push_back(mk<Constraint>(
+                        BinaryConstraintOp::EQ, mk<TupleElement>(level, i), std::move(value)));
+            }
+        }
+
+        // the remaining attributes of a class are equal to the first one of the atom
+        for (std::size_t i = 0; i < atoms[atom].arity; ++i) {
+            const std::size_t cls = classes[i];
+            if (values[i] != nullptr) {
+                continue;
+            }
+            if (classValues[cls] == nullptr) {
+                classElements[cls] = mk<TupleElement>(atom, i);
+                classValues[cls] = classElements[cls].get();
+            } else {
+                conds.push_back(mk<Constraint>(BinaryConstraintOp::EQ, mk<TupleElement>(level, i),
+                        renumber(*classValues[cls], position)));
+            }
+        }
+
+        placed[atom] = true;
+        addConditions(conds);
+    }
+
+    // rebuild the loops from the innermost one
+    Own<Operation> op = renumber(*nested, position);
+    for (std::size_t level = numAtoms; level-- > 0;) {
+        if (!levelConditions[level + 1].empty()) {
+            op = mk<Filter>(toCondition(levelConditions[level + 1]), std::move(op));
+        }
+
+        const Atom& atom = atoms[order[level]];
+        auto& pattern = patterns[level];
+        const int id = static_cast<int>(level);
+        bool indexed = false;
+        for (const auto& value : pattern.first) {
+            indexed = indexed || !isUndefValue(value.get());
+        }
+        const bool isParallel = parallel && level == 0;
+        if (!indexed && isParallel) {
+            op = mk<ParallelScan>(atom.relation, id, std::move(op), atom.profileText);
+        } else if (!indexed) {
+            op = mk<Scan>(atom.relation, id, std::move(op), atom.profileText);
+        } else if (isParallel) {
+            op = mk<ParallelIndexScan>(
+                    atom.relation, id, std::move(pattern), std::move(op), atom.profileText);
+        } else {
+            op = mk<IndexScan>(atom.relation, id, std::move(pattern), std::move(op), atom.profileText);
+        }
+    }
+    if (!levelConditions[0].empty()) {
+        op = mk<Filter>(toCondition(levelConditions[0]), std::move(op));
+    }
+    return mk<Query>(std::move(op));
+}
+
+}  // namespace souffle::ram
@@ -0,0 +1,157 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file LoopNest.h
+ *
+ * Defines a flattened representation of the loop nest of a query, which
+ * can be rebuilt with its scans nested in a different order
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Condition.h"
+#include "ram/Expression.h"
+#include "ram/Operation.h"
+#include "ram/Query.h"
+#include "ram/analysis/Relation.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace souffle::ram {
+
+/**
+ * @class LoopNest
+ * @brief The scans of a query, the equalities binding their attributes,
+ * and the conditions filtering their tuples
+ *
+ * A query whose operation nests scans and index scans of equal values,
+ * interleaved with filters, is a join of the scanned relations; the order
+ * in which the scans are nested is arbitrary. The loop nest records the
+ * scans as atoms, the equalities of the index searches as classes of equal
+ * attributes, and the conjuncts of the filters as conditions, such that the
+ * query can be rebuilt for any order of its atoms.
+ *
+ * For example, the query
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN A
+ *    FOR t1 IN B ON INDEX t1.0 = t0.1
+ *     IF (t1.1) NOT IN C
+ *      INSERT (t0.0, t1.1) INTO D
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * nested in the order (1, 0) becomes
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  QUERY
+ *   FOR t0 IN B
+ *    IF (t0.1) NOT IN C
+ *     FOR t1 IN A ON INDEX t1.1 = t0.0
+ *      INSERT (t1.0, t0.1) INTO D
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The operation nested in the innermost scan is kept as is, apart from the
+ * renumbered tuples. Queries with searches for ranges of values, breaks,
+ * or auto-increments are not flattened, since reordering their scans would
+ * change their result.
+ */
+class LoopNest {
+public:
+    /**
+     * @brief Select the bound attributes of an atom that are searched on an index
+     * @param atom The atom
+     * @param bound The attributes of the atom bound by outer atoms, in ascending order
+     * @result A subset of the bound attributes; the other ones are checked by filters
+     */
+    using IndexSelector =
+            std::function<std::vector<std::size_t>(std::size_t atom, const std::vector<std::size_t>& bound)>;
+
+    /**
+     * @brief Flatten the loop nest of a query
+     * @result nullptr if the query does not join at least two relations
+     * or its scans cannot be reordered
+     */
+    static Own<LoopNest> flatten(const Query& query, const analysis::RelationAnalysis& relAnalysis);
+
+    /** @brief Get the number of atoms */
+    std::size_t size() const {
+        return atoms.size();
+    }
+
+    /** @brief Get the relation scanned by an atom */
+    const std::string& getRelation(std::size_t atom) const {
+        return atoms[atom].relation;
+    }
+
+    /** @brief Get the profile text of the scan of an atom */
+    const std::string& getProfileText(std::size_t atom) const {
+        return atoms[atom].profileText;
+    }
+
+    /** @brief Get the attributes of an atom bound if it is nested in the given outer atoms */
+    std::vector<std::size_t> getBoundElements(std::size_t atom, const std::vector<bool>& outer) const;
+
+    /** @brief Get the conditions decided once the atom is nested in the given outer atoms */
+    std::vector<const Condition*> getConditions(std::size_t atom, const std::vector<bool>& outer) const;
+
+    /**
+     * @brief Build the query nesting the atoms in the given order
+     * @param order The atoms from the outermost to the innermost one
+     * @param selector Selects the attributes searched on an index
+     */
+    Own<Query> reorder(const std::vector<std::size_t>& order, const IndexSelector& selector) const;
+
+private:
+    LoopNest() = default;
+
+    /** A scan of the nest */
+    struct Atom {
+        std::string relation;
+        std::size_t arity;
+        std::string profileText;
+        /** Class of equal attributes of each attribute */
+        std::vector<std::size_t> classes;
+    };
+
+    /** An expression an attribute class is equal to */
+    struct Binding {
+        std::size_t attributeClass;
+        Own<Expression> expression;
+        /** Atoms referenced by the expression */
+        std::vector<bool> atoms;
+    };
+
+    /** A conjunct of a filter */
+    struct Term {
+        Own<Condition> condition;
+        /** Atoms referenced by the condition */
+        std::vector<bool> atoms;
+    };
+
+    /** Return the atoms referenced by a node */
+    std::vector<bool> getReferencedAtoms(const Node& node) const;
+
+    std::vector<Atom> atoms;
+    std::vector<Binding> bindings;
+    std::vector<Term> terms;
+    /** Number of attribute classes */
+    std::size_t numClasses = 0;
+    /** The operation of the innermost scan */
+    Own<Operation> nested;
+    /** Whether the outermost scan is parallel */
+    bool parallel = false;
+};
+
+}  // namespace souffle::ram
@@ -0,0 +1,1087 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Serialisation.cpp
+ *
+ * Implementation of the binary serialisation of RAM programs
+ *
+ * Each node is written as a tag naming its type followed by its fields
+ * and children, in the order of the arguments of its constructor. Integers
+ * are written little-endian with 64 bits, strings and lists are prefixed
+ * by their length.
+ *
+ ***********************************************************************/
+
+#include "ram/utility/Serialisation.h"
+#include "AggregateOp.h"
+#include "FunctorOps.h"
+#include "RelationTag.h"
+#include "ram/Node.h"
+#include "ram/utility/Visitor.h"
+#include "souffle/BinaryConstraintOps.h"
+#include "souffle/RamTypes.h"
+#include "souffle/TypeAttribute.h"
+#include "souffle/utility/DynamicCasting.h"
+#include "souffle/utility/MiscUtil.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle::ram {
+
+namespace {
+
+/** Leading bytes of a serialised program */
+constexpr char magic[] = "SOUFFLE-RAM";
+
+/** Version of the format, to be bumped whenever a RAM node changes */
+constexpr std::uint64_t version = 5;
+
+/** Type of a serialised node */
+enum class Tag : std::uint8_t {
+    TupleElement,
+    SignedConstant,
+    UnsignedConstant,
+    FloatConstant,
+    StringConstant,
+    IntrinsicOperator,
+    UserDefinedOperator,
+    AutoIncrement,
+    PackRecord,
+    SubroutineArgument,
+    UndefValue,
+    RelationSize,
+    True,
+    False,
+    EmptinessCheck,
+    ProvenanceExistenceCheck,
+    ExistenceCheck,
+    Conjunction,
+    Negation,
+    Constraint,
+    Filter,
+    Break,
+    GuardedInsert,
+    NoveltyInsert,
+    Insert,
+    Erase,
+    SubroutineReturn,
+    Branches,
+    UnpackRecord,
+    ParallelNestedIntrinsicOperator,
+    NestedIntrinsicOperator,
+    ParallelScan,
+    Scan,
+    ParallelIndexScan,
+    IndexScan,
+    IndexIntersect,
+    ParallelMergeJoin,
+    MergeJoin,
+    ParallelIfExists,
+    IfExists,
+    ParallelIndexIfExists,
+    IndexIfExists,
+    ParallelAggregate,
+    Aggregate,
+    ParallelIndexAggregate,
+    IndexAggregate,
+    IO,
+    Query,
+    Clear,
+    LogSize,
+    Swap,
+    MergeExtend,
+    Sequence,
+    Loop,
+    Parallel,
+    Exit,
+    LogTimer,
+    LogRelationTimer,
+    DebugInfo,
+    Call,
+    CompactTables,
+    Checkpoint,
+    StratumCache,
+    Guard,
+    // must be last
+    Count
+};
+
+class Writer : public Visitor<void> {
+public:
+    explicit Writer(std::ostream& os) : os(os) {}
+
+    void writeHeader() {
+        os.write(magic, sizeof(magic));
+        writeInt(version);
+        writeInt(RAM_DOMAIN_SIZE);
+    }
+
+    void writeProgram(const Program& program) {
+        const auto relations = program.getRelations();
+        writeInt(relations.size());
+        for (const Relation* rel : relations) {
+            writeRelation(*rel);
+        }
+        writeNode(program.getMain());
+        const auto subroutines = program.getSubroutines();
+        writeInt(subroutines.size());
+        for (const auto& [name, sub] : subroutines) {
+            writeString(name);
+            writeNode(*sub);
+        }
+    }
+
+    void writeInt(std::uint64_t value) {
+        char bytes[8];
+        for (std::size_t i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+        os.write(bytes, 8);
+    }
+
+    void writeString(const std::string& str) {
+        writeInt(str.size());
+        os.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+
+    void writeStrings(const std::vector<std::string>& strs) {
+        writeInt(strs.size());
+        for (const auto& str : strs) {
+            writeString(str);
+        }
+    }
+
+    template <typename E>
+    void writeEnum(E value) {
+        writeInt(static_cast<std::uint64_t>(value));
+    }
+
+    void writeTag(Tag tag) {
+        writeEnum(tag);
+    }
+
+    void writeNode(const Node& node) {
+        dispatch(node);
+    }
+
+    template <typename T>
+    void writeNodes(const std::vector<T*>& nodes) {
+        writeInt(nodes.size());
+        for (const T* node : nodes) {
+            writeNode(*node);
+        }
+    }
+
+    void writeRelation(const Relation& rel) {
+        writeString(rel.getName());
+        writeInt(rel.getArity());
+        writeInt(rel.getAuxiliaryArity());
+        writeStrings(rel.getAttributeNames());
+        writeStrings(rel.getAttributeTypes());
+        writeEnum(rel.getRepresentation());
+        writeInt(rel.isLattice() ? 1 : 0);
+        if (rel.isLattice()) {
+            writeEnum(rel.getLatticeOp());
+        }
+    }
+
+    void writePattern(const IndexOperation& op) {
+        const auto pattern = op.getRangePattern();
+        writeNodes(pattern.first);
+        writeNodes(pattern.second);
+    }
+
+    /** Write the fields shared by all nested operations, which are read back in the same order */
+    void writeNested(const NestedOperation& op) {
+        writeNode(op.getOperation());
+        writeString(op.getProfileText());
+    }
+
+    // -- expressions --
+
+    void visit_(type_identity<TupleElement>, const TupleElement& elem) override {
+        writeTag(Tag::TupleElement);
+        writeInt(elem.getTupleId());
+        writeInt(elem.getElement());
+    }
+
+    void visit_(type_identity<SignedConstant>, const SignedConstant& constant) override {
+        writeTag(Tag::SignedConstant);
+        writeInt(static_cast<std::uint64_t>(constant.getConstant()));
+    }
+
+    void visit_(type_identity<UnsignedConstant>, const UnsignedConstant& constant) override {
+        writeTag(Tag::UnsignedConstant);
+        writeInt(static_cast<std::uint64_t>(constant.getConstant()));
+    }
+
+    void visit_(type_identity<FloatConstant>, const FloatConstant& constant) override {
+        writeTag(Tag::FloatConstant);
+        writeInt(static_cast<std::uint64_t>(constant.getConstant()));
+    }
+
+    void visit_(type_identity<StringConstant>, const StringConstant& constant) override {
+        writeTag(Tag::StringConstant);
+        writeString(constant.getConstant());
+    }
+
+    void visit_(type_identity<IntrinsicOperator>, const IntrinsicOperator& op) override {
+        writeTag(Tag::IntrinsicOperator);
+        writeEnum(op.getOperator());
+        writeNodes(op.getArguments());
+    }
+
+    void visit_(type_identity<UserDefinedOperator>, const UserDefinedOperator& op) override {
+        writeTag(Tag::UserDefinedOperator);
+        writeString(op.getName());
+        writeInt(op.getArgsTypes().size());
+        for (TypeAttribute type : op.getArgsTypes()) {
+            writeEnum(type);
+        }
+        writeEnum(op.getReturnType());
+        writeInt(op.isStateful() ? 1 : 0);
+        writeInt(op.isThreadLocal() ? 1 : 0);
+        writeInt(op.isCached() ? 1 : 0);
+        writeNodes(op.getArguments());
+    }
+
+    void visit_(type_identity<AutoIncrement>, const AutoIncrement&) override {
+        writeTag(Tag::AutoIncrement);
+    }
+
+    void visit_(type_identity<PackRecord>, const PackRecord& pack) override {
+        writeTag(Tag::PackRecord);
+        writeNodes(pack.getArguments());
+    }
+
+    void visit_(type_identity<SubroutineArgument>, const SubroutineArgument& arg) override {
+        writeTag(Tag::SubroutineArgument);
+        writeInt(arg.getArgument());
+    }
+
+    void visit_(type_identity<UndefValue>, const UndefValue&) override {
+        writeTag(Tag::UndefValue);
+    }
+
+    void visit_(type_identity<RelationSize>, const RelationSize& size) override {
+        writeTag(Tag::RelationSize);
+        writeString(size.getRelation());
+    }
+
+    // -- conditions --
+
+    void visit_(type_identity<True>, const True&) override {
+        writeTag(Tag::True);
+    }
+
+    void visit_(type_identity<False>, const False&) override {
+        writeTag(Tag::False);
+    }
+
+    void visit_(type_identity<EmptinessCheck>, const EmptinessCheck& check) override {
+        writeTag(Tag::EmptinessCheck);
+        writeString(check.getRelation());
+    }
+
+    void visit_(type_identity<ProvenanceExistenceCheck>, const ProvenanceExistenceCheck& check) override {
+        writeTag(Tag::ProvenanceExistenceCheck);
+        writeString(check.getRelation());
+        writeNodes(check.getValues());
+    }
+
+    void visit_(type_identity<ExistenceCheck>, const ExistenceCheck& check) override {
+        writeTag(Tag::ExistenceCheck);
+        writeString(check.getRelation());
+        writeNodes(check.getValues());
+    }
+
+    void visit_(type_identity<Conjunction>, const Conjunction& conj) override {
+        writeTag(Tag::Conjunction);
+        writeNode(conj.getLHS());
+        writeNode(conj.getRHS());
+    }
+
+    void visit_(type_identity<Negation>, const Negation& neg) override {
+        writeTag(Tag::Negation);
+        writeNode(neg.getOperand());
+    }
+
+    void visit_(type_identity<Constraint>, const Constraint& constraint) override {
+        writeTag(Tag::Constraint);
+        writeEnum(constraint.getOperator());
+        writeNode(constraint.getLHS());
+        writeNode(constraint.getRHS());
+    }
+
+    // -- operations --
+
+    void visit_(type_identity<Filter>, const Filter& filter) override {
+        writeTag(Tag::Filter);
+        writeNode(filter.getCondition());
+        writeNested(filter);
+    }
+
+    void visit_(type_identity<Break>, const Break& breakOp) override {
+        writeTag(Tag::Break);
+        writeNode(breakOp.getCondition());
+        writeNested(breakOp);
+    }
+
+    void visit_(type_identity<GuardedInsert>, const GuardedInsert& insert) override {
+        writeTag(Tag::GuardedInsert);
+        writeString(insert.getRelation());
+        writeNodes(insert.getValues());
+        writeNode(*insert.getCondition());
+    }
+
+    void visit_(type_identity<NoveltyInsert>, const NoveltyInsert& insert) override {
+        writeTag(Tag::NoveltyInsert);
+        writeString(insert.getRelation());
+        writeNodes(insert.getValues());
+        writeString(insert.getNewRelation());
+    }
+
+    void visit_(type_identity<Insert>, const Insert& insert) override {
+        writeTag(Tag::Insert);
+        writeString(insert.getRelation());
+        writeNodes(insert.getValues());
+    }
+
+    void visit_(type_identity<Erase>, const Erase& erase) override {
+        writeTag(Tag::Erase);
+        writeString(erase.getRelation());
+        writeNodes(erase.getValues());
+    }
+
+    void visit_(type_identity<SubroutineReturn>, const SubroutineReturn& ret) override {
+        writeTag(Tag::SubroutineReturn);
+        writeNodes(ret.getValues());
+    }
+
+    void visit_(type_identity<Branches>, const Branches& branches) override {
+        writeTag(Tag::Branches);
+        writeNodes(branches.getBranches());
+    }
+
+    void visit_(type_identity<UnpackRecord>, const UnpackRecord& unpack) override {
+        writeTag(Tag::UnpackRecord);
+        writeInt(unpack.getTupleId());
+        writeNode(unpack.getExpression());
+        writeInt(unpack.getArity());
+        writeNode(unpack.getOperation());
+    }
+
+    void visit_(type_identity<ParallelNestedIntrinsicOperator>,
+            const ParallelNestedIntrinsicOperator& op) override {
+        writeTag(Tag::ParallelNestedIntrinsicOperator);
+        writeNestedIntrinsicOperator(op);
+    }
+
+    void visit_(type_identity<NestedIntrinsicOperator>, const NestedIntrinsicOperator& op) override {
+        writeTag(Tag::NestedIntrinsicOperator);
+        writeNestedIntrinsicOperator(op);
+    }
+
+    void visit_(type_identity<ParallelScan>, const ParallelScan& scan) override {
+        writeTag(Tag::ParallelScan);
+        writeScan(scan);
+    }
+
+    void visit_(type_identity<Scan>, const Scan& scan) override {
+        writeTag(Tag::Scan);
+        writeScan(scan);
+    }
+
+    void visit_(type_identity<ParallelIndexScan>, const ParallelIndexScan& scan) override {
+        writeTag(Tag::ParallelIndexScan);
+        writeIndexScan(scan);
+    }
+
+    void visit_(type_identity<IndexScan>, const IndexScan& scan) override {
+        writeTag(Tag::IndexScan);
+        writeIndexScan(scan);
+    }
+
+    void visit_(type_identity<IndexIntersect>, const IndexIntersect& intersect) override {
+        writeTag(Tag::IndexIntersect);
+        writeIndexScan(intersect);
+        writeInt(intersect.getElement());
+        writeNode(intersect.getPartner());
+        writeInt(intersect.getPartnerElement());
+    }
+
+    void visit_(type_identity<ParallelMergeJoin>, const ParallelMergeJoin& join) override {
+        writeTag(Tag::ParallelMergeJoin);
+        writeIndexScan(join);
+        writeInt(join.getElement());
+    }
+
+    void visit_(type_identity<MergeJoin>, const MergeJoin& join) override {
+        writeTag(Tag::MergeJoin);
+        writeIndexScan(join);
+        writeInt(join.getElement());
+    }
+
+    void visit_(type_identity<ParallelIfExists>, const ParallelIfExists& ifExists) override {
+        writeTag(Tag::ParallelIfExists);
+        writeIfExists(ifExists);
+    }
+
+    void visit_(type_identity<IfExists>, const IfExists& ifExists) override {
+        writeTag(Tag::IfExists);
+        writeIfExists(ifExists);
+    }
+
+    void visit_(type_identity<ParallelIndexIfExists>, const ParallelIndexIfExists& ifExists) override {
+        writeTag(Tag::ParallelIndexIfExists);
+        writeIndexIfExists(ifExists);
+    }
+
+    void visit_(type_identity<IndexIfExists>, const IndexIfExists& ifExists) override {
+        writeTag(Tag::IndexIfExists);
+        writeIndexIfExists(ifExists);
+    }
+
+    void visit_(type_identity<ParallelAggregate>, const ParallelAggregate& aggregate) override {
+        writeTag(Tag::ParallelAggregate);
+        writeAggregate(aggregate);
+    }
+
+    void visit_(type_identity<Aggregate>, const Aggregate& aggregate) override {
+        writeTag(Tag::Aggregate);
+        writeAggregate(aggregate);
+    }
+
+    void visit_(type_identity<ParallelIndexAggregate>, const ParallelIndexAggregate& aggregate) override {
+        writeTag(Tag::ParallelIndexAggregate);
+        writeIndexAggregate(aggregate);
+    }
+
+    void visit_(type_identity<IndexAggregate>, const IndexAggregate& aggregate) override {
+        writeTag(Tag::IndexAggregate);
+        writeIndexAggregate(aggregate);
+    }
+
+    // -- statements --
+
+    void visit_(type_identity<IO>, const IO& io) override {
+        writeTag(Tag::IO);
+        writeString(io.getRelation());
+        writeInt(io.getDirectives().size());
+        for (const auto& [key, value] : io.getDirectives()) {
+            writeString(key);
+            writeString(value);
+        }
+    }
+
+    void visit_(type_identity<Query>, const Query& query) override {
+        writeTag(Tag::Query);
+        writeNode(query.getOperation());
+    }
+
+    void visit_(type_identity<Clear>, const Clear& clear) override {
+        writeTag(Tag::Clear);
+        writeString(clear.getRelation());
+    }
+
+    void visit_(type_identity<LogSize>, const LogSize& size) override {
+        writeTag(Tag::LogSize);
+        writeString(size.getRelation());
+        writeString(size.getMessage());
+    }
+
+    void visit_(type_identity<Swap>, const Swap& swap) override {
+        writeTag(Tag::Swap);
+        writeString(swap.getFirstRelation());
+        writeString(swap.getSecondRelation());
+    }
+
+    void visit_(type_identity<MergeExtend>, const MergeExtend& merge) override {
+        writeTag(Tag::MergeExtend);
+        writeString(merge.getTargetRelation());
+        writeString(merge.getSourceRelation());
+    }
+
+    void visit_(type_identity<Sequence>, const Sequence& seq) override {
+        writeTag(Tag::Sequence);
+        writeNodes(seq.getStatements());
+    }
+
+    void visit_(type_identity<Loop>, const Loop& loop) override {
+        writeTag(Tag::Loop);
+        writeNode(loop.getBody());
+    }
+
+    void visit_(type_identity<Parallel>, const Parallel& parallel) override {
+        writeTag(Tag::Parallel);
+        writeNodes(parallel.getStatements());
+    }
+
+    void visit_(type_identity<Exit>, const Exit& exit) override {
+        writeTag(Tag::Exit);
+        writeNode(exit.getCondition());
+    }
+
+    void visit_(type_identity<LogTimer>, const LogTimer& timer) override {
+        writeTag(Tag::LogTimer);
+        writeNode(timer.getStatement());
+        writeString(timer.getMessage());
+    }
+
+    void visit_(type_identity<LogRelationTimer>, const LogRelationTimer& timer) override {
+        writeTag(Tag::LogRelationTimer);
+        writeNode(timer.getStatement());
+        writeString(timer.getMessage());
+        writeString(timer.getRelation());
+    }
+
+    void visit_(type_identity<DebugInfo>, const DebugInfo& info) override {
+        writeTag(Tag::DebugInfo);
+        writeNode(info.getStatement());
+        writeString(info.getMessage());
+    }
+
+    void visit_(type_identity<Call>, const Call& call) override {
+        writeTag(Tag::Call);
+        writeString(call.getName());
+    }
+
+    void visit_(type_identity<CompactTables>, const CompactTables& compact) override {
+        writeTag(Tag::CompactTables);
+        writeString(compact.getTypes());
+    }
+
+    void visit_(type_identity<Checkpoint>, const Checkpoint& checkpoint) override {
+        writeTag(Tag::Checkpoint);
+        writeString(checkpoint.getDirectory());
+        writeInt(checkpoint.getStep());
+        writeInt(checkpoint.isResume() ? 1 : 0);
+        if (!checkpoint.isResume()) {
+            writeInt(checkpoint.getSteps());
+            writeStrings(checkpoint.getFiles());
+        }
+    }
+
+    void visit_(type_identity<StratumCache>, const StratumCache& cache) override {
+        writeTag(Tag::StratumCache);
+        writeString(cache.getDirectory());
+        writeString(cache.getName());
+        writeString(cache.getKey());
+        writeStrings(cache.getInputs());
+        writeStrings(cache.getOutputs());
+        writeNode(cache.getBody());
+    }
+
+    void visit_(type_identity<Guard>, const Guard& guard) override {
+        writeTag(Tag::Guard);
+        writeNode(guard.getCondition());
+        writeNode(guard.getStatement());
+    }
+
+    void visit_(type_identity<Node>, const Node& node) override {
+        fatal("cannot serialise RAM node: %s", node);
+    }
+
+private:
+    std::ostream& os;
+
+    void writeNestedIntrinsicOperator(const NestedIntrinsicOperator& op) {
+        writeEnum(op.getFunction());
+        writeNodes(op.getArguments());
+        writeInt(op.getTupleId());
+        writeNode(op.getOperation());
+    }
+
+    void writeScan(const Scan& scan) {
+        writeString(scan.getRelation());
+        writeInt(scan.getTupleId());
+        writeNested(scan);
+    }
+
+    void writeIndexScan(const IndexOperation& scan) {
+        writeString(scan.getRelation());
+        writeInt(scan.getTupleId());
+        writePattern(scan);
+        writeNested(scan);
+    }
+
+    void writeIfExists(const IfExists& ifExists) {
+        writeString(ifExists.getRelation());
+        writeInt(ifExists.getTupleId());
+        writeNode(ifExists.getCondition());
+        writeNested(ifExists);
+    }
+
+    void writeIndexIfExists(const IndexIfExists& ifExists) {
+        writeString(ifExists.getRelation());
+        writeInt(ifExists.getTupleId());
+        writeNode(ifExists.getCondition());
+        writePattern(ifExists);
+        writeNested(ifExists);
+    }
+
+    void writeAggregate(const Aggregate& aggregate) {
+        writeEnum(aggregate.getFunction());
+        writeString(aggregate.getRelation());
+        writeNode(aggregate.getExpression());
+        writeNode(aggregate.getCondition());
+        writeInt(aggregate.getTupleId());
+        writeNode(aggregate.getOperation());
+    }
+
+    void writeIndexAggregate(const IndexAggregate& aggregate) {
+        writeEnum(aggregate.getFunction());
+        writeString(aggregate.getRelation());
+        writeNode(aggregate.getExpression());
+        writeNode(aggregate.getCondition());
+        writePattern(aggregate);
+        writeInt(aggregate.getTupleId());
+        writeNode(aggregate.getOperation());
+    }
+};
+
+class Reader {
+public:
+    explicit Reader(std::istream& is) : is(is) {}
+
+    void readHeader() {
+        char bytes[sizeof(magic)];
+        if (!is.read(bytes, sizeof(magic)) ||
+                std::string(bytes, sizeof(magic)) != std::string(magic, sizeof(magic))) {
+            throw std::runtime_error("not a serialised RAM program");
+        }
+        if (readInt() != version) {
+            throw std::runtime_error("serialised RAM program of a different version");
+        }
+        if (readInt() != RAM_DOMAIN_SIZE) {
+            throw std::runtime_error("serialised RAM program of a different domain size");
+        }
+    }
+
+    Own<Program> readProgram() {
+        VecOwn<Relation> relations;
+        for (std::size_t n = readSize(); n > 0; --n) {
+            relations.push_back(readRelation());
+        }
+        auto main = readNode<Statement>();
+        std::map<std::string, Own<Statement>> subroutines;
+        for (std::size_t n = readSize(); n > 0; --n) {
+            std::string name = readString();
+            subroutines[name] = readNode<Statement>();
+        }
+        return mk<Program>(std::move(relations), std::move(main), std::move(subroutines));
+    }
+
+private:
+    std::istream& is;
+
+    [[noreturn]] static void corrupt() {
+        throw std::runtime_error("corrupt serialised RAM program");
+    }
+
+    std::uint64_t readInt() {
+        unsigned char bytes[8];
+        if (!is.read(reinterpret_cast<char*>(bytes), 8)) {
+            corrupt();
+        }
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < 8; ++i) {
+            value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    /** Read a length, which is bounded to fail on corrupt input before allocating */
+    std::size_t readSize() {
+        const std::uint64_t size = readInt();
+        if (size > (std::uint64_t(1) << 32)) {
+            corrupt();
+        }
+        return static_cast<std::size_t>(size);
+    }
+
+    RamDomain readDomain() {
+        return static_cast<RamDomain>(readInt());
+    }
+
+    std::string readString() {
+        std::string str(readSize(), '\0');
+        if (!is.read(str.data(), static_cast<std::streamsize>(str.size()))) {
+            corrupt();
+        }
+        return str;
+    }
+
+    std::vector<std::string> readStrings() {
+        std::vector<std::string> strs(readSize());
+        for (auto& str : strs) {
+            str = readString();
+        }
+        return strs;
+    }
+
+    template <typename E>
+    E readEnum() {
+        return static_cast<E>(readInt());
+    }
+
+    Own<Relation> readRelation() {
+        std::string name = readString();
+        std::size_t arity = readSize();
+        std::size_t auxiliaryArity = readSize();
+        auto attributeNames = readStrings();
+        auto attributeTypes = readStrings();
+        auto representation = readEnum<RelationRepresentation>();
+        std::optional<BinaryConstraintOp> latticeOp;
+        if (readInt() != 0) {
+            latticeOp = readEnum<BinaryConstraintOp>();
+        }
+        if (attributeNames.size() != arity || attributeTypes.size() != arity) {
+            corrupt();
+        }
+        return mk<Relation>(std::move(name), arity, auxiliaryArity, std::move(attributeNames),
+                std::move(attributeTypes), representation, latticeOp);
+    }
+
+    template <typename T>
+    Own<T> readNode() {
+        Own<Node> node = readAnyNode();
+        if (!isA<T>(node.get())) {
+            corrupt();
+        }
+        return UNSAFE_cast<T>(std::move(node));
+    }
+
+    template <typename T>
+    VecOwn<T> readNodes() {
+        VecOwn<T> nodes;
+        for (std::size_t n = readSize(); n > 0; --n) {
+            nodes.push_back(readNode<T>());
+        }
+        return nodes;
+    }
+
+    RamPattern readPattern() {
+        RamPattern pattern;
+        pattern.first = readNodes<Expression>();
+        pattern.second = readNodes<Expression>();
+        if (pattern.first.size() != pattern.second.size()) {
+            corrupt();
+        }
+        return pattern;
+    }
+
+    Own<Node> readAnyNode() {
+        const auto tag = readInt();
+        if (tag >= static_cast<std::uint64_t>(Tag::Count)) {
+            corrupt();
+        }
+        switch (static_cast<Tag>(tag)) {
+            // -- expressions --
+            case Tag::TupleElement: {
+                std::size_t ident = readSize();
+                return mk<TupleElement>(ident, readSize());
+            }
+            case Tag::SignedConstant: return mk<SignedConstant>(readDomain());
+            case Tag::UnsignedConstant: return mk<UnsignedConstant>(ramBitCast<RamUnsigned>(readDomain()));
+            case Tag::FloatConstant: return mk<FloatConstant>(ramBitCast<RamFloat>(readDomain()));
+            case Tag::StringConstant: return mk<StringConstant>(readString());
+            case Tag::IntrinsicOperator: {
+                auto op = readEnum<FunctorOp>();
+                return mk<IntrinsicOperator>(op, readNodes<Expression>());
+            }
+            case Tag::UserDefinedOperator: {
+                std::string name = readString();
+                std::vector<TypeAttribute> argsTypes(readSize());
+                for (auto& type : argsTypes) {
+                    type = readEnum<TypeAttribute>();
+                }
+                auto returnType = readEnum<TypeAttribute>();
+                bool stateful = readInt() != 0;
+                bool threadLocal = readInt() != 0;
+                bool cached = readInt() != 0;
+                return mk<UserDefinedOperator>(std::move(name), std::move(argsTypes), returnType, stateful,
+                        threadLocal, cached, readNodes<Expression>());
+            }
+            case Tag::AutoIncrement: return mk<AutoIncrement>();
+            case Tag::PackRecord: return mk<PackRecord>(readNodes<Expression>());
+            case Tag::SubroutineArgument: return mk<SubroutineArgument>(readSize());
+            case Tag::UndefValue: return mk<UndefValue>();
+            case Tag::RelationSize: return mk<RelationSize>(readString());
+
+            // -- conditions --
+            case Tag::True: return mk<True>();
+            case Tag::False: return mk<False>();
+            case Tag::EmptinessCheck: return mk<EmptinessCheck>(readString());
+            case Tag::ProvenanceExistenceCheck: {
+                std::string rel = readString();
+                return mk<ProvenanceExistenceCheck>(std::move(rel), readNodes<Expression>());
+            }
+            case Tag::ExistenceCheck: {
+                std::string rel = readString();
+                return mk<ExistenceCheck>(std::move(rel), readNodes<Expression>());
+            }
+            case Tag::Conjunction: {
+                auto lhs = readNode<Condition>();
+                return mk<Conjunction>(std::move(lhs), readNode<Condition>());
+            }
+            case Tag::Negation: return mk<Negation>(readNode<Condition>());
+            case Tag::Constraint: {
+                auto op = readEnum<BinaryConstraintOp>();
+                auto lhs = readNode<Expression>();
+                return mk<Constraint>(op, std::move(lhs), readNode<Expression>());
+            }
+
+            // -- operations --
+            case Tag::Filter: {
+                auto cond = readNode<Condition>();
+                auto nested = readNode<Operation>();
+                return mk<Filter>(std::move(cond), std::move(nested), readString());
+            }
+            case Tag::Break: {
+                auto cond = readNode<Condition>();
+                auto nested = readNode<Operation>();
+                return mk<Break>(std::move(cond), std::move(nested), readString());
+            }
+            case Tag::GuardedInsert: {
+                std::string rel = readString();
+                auto values = readNodes<Expression>();
+                return mk<GuardedInsert>(std::move(rel), std::move(values), readNode<Condition>());
+            }
+            case Tag::NoveltyInsert: {
+                std::string rel = readString();
+                auto values = readNodes<Expression>();
+                return mk<NoveltyInsert>(std::move(rel), std::move(values), readString());
+            }
+            case Tag::Insert: {
+                std::string rel = readString();
+                return mk<Insert>(std::move(rel), readNodes<Expression>());
+            }
+            case Tag::Erase: {
+                std::string rel = readString();
+                return mk<Erase>(std::move(rel), readNodes<Expression>());
+            }
+            case Tag::SubroutineReturn: return mk<SubroutineReturn>(readNodes<Expression>());
+            case Tag::Branches: return mk<Branches>(readNodes<Operation>());
+            case Tag::UnpackRecord: {
+                int ident = static_cast<int>(readSize());
+                auto expr = readNode<Expression>();
+                std::size_t arity = readSize();
+                return mk<UnpackRecord>(readNode<Operation>(), ident, std::move(expr), arity);
+            }
+            case Tag::ParallelNestedIntrinsicOperator:
+                return readNestedIntrinsicOperator<ParallelNestedIntrinsicOperator>();
+            case Tag::NestedIntrinsicOperator: return readNestedIntrinsicOperator<NestedIntrinsicOperator>();
+            case Tag::ParallelScan: return readScan<ParallelScan>();
+            case Tag::Scan: return readScan<Scan>();
+            case Tag::ParallelIndexScan: return readIndexScan<ParallelIndexScan>();
+            case Tag::IndexScan: return readIndexScan<IndexScan>();
+            case Tag::IndexIntersect: {
+                std::string rel = readString();
+                int ident = static_cast<int>(readSize());
+                auto pattern = readPattern();
+                auto nested = readNode<Operation>();
+                std::string profileText = readString();
+                std::size_t element = readSize();
+                auto partner = readNode<ExistenceCheck>();
+                std::size_t partnerElement = readSize();
+                if (element >= pattern.first.size() || partnerElement >= partner->getValues().size()) {
+                    corrupt();
+                }
+                return mk<IndexIntersect>(std::move(rel), ident, std::move(pattern), element,
+                        std::move(partner), partnerElement, std::move(nested), std::move(profileText));
+            }
+            case Tag::ParallelMergeJoin: return readMergeJoin<ParallelMergeJoin>();
+            case Tag::MergeJoin: return readMergeJoin<MergeJoin>();
+            case Tag::ParallelIfExists: return readIfExists<ParallelIfExists>();
+            case Tag::IfExists: return readIfExists<IfExists>();
+            case Tag::ParallelIndexIfExists: return readIndexIfExists<ParallelIndexIfExists>();
+            case Tag::IndexIfExists: return readIndexIfExists<IndexIfExists>();
+            case Tag::ParallelAggregate: return readAggregate<ParallelAggregate>();
+            case Tag::Aggregate: return readAggregate<Aggregate>();
+            case Tag::ParallelIndexAggregate: return readIndexAggregate<ParallelIndexAggregate>();
+            case Tag::IndexAggregate: return readIndexAggregate<IndexAggregate>();
+
+            // -- statements --
+            case Tag::IO: {
+                std::string rel = readString();
+                std::map<std::string, std::string> directives;
+                for (std::size_t n = readSize(); n > 0; --n) {
+                    std::string key = readString();
+                    directives[key] = readString();
+                }
+                return mk<IO>(std::move(rel), std::move(directives));
+            }
+            case Tag::Query: return mk<Query>(readNode<Operation>());
+            case Tag::Clear: return mk<Clear>(readString());
+            case Tag::LogSize: {
+                std::string rel = readString();
+                return mk<LogSize>(std::move(rel), readString());
+            }
+            case Tag::Swap: {
+                std::string first = readString();
+                return mk<Swap>(std::move(first), readString());
+            }
+            case Tag::MergeExtend: {
+                std::string target = readString();
+                return mk<MergeExtend>(std::move(target), readString());
+            }
+            case Tag::Sequence: return mk<Sequence>(readNodes<Statement>());
+            case Tag::Loop: return mk<Loop>(readNode<Statement>());
+            case Tag::Parallel: return mk<Parallel>(readNodes<Statement>());
+            case Tag::Exit: return mk<Exit>(readNode<Condition>());
+            case Tag::LogTimer: {
+                auto stmt = readNode<Statement>();
+                return mk<LogTimer>(std::move(stmt), readString());
+            }
+            case Tag::LogRelationTimer: {
+                auto stmt = readNode<Statement>();
+                std::string message = readString();
+                return mk<LogRelationTimer>(std::move(stmt), std::move(message), readString());
+            }
+            case Tag::DebugInfo: {
+                auto stmt = readNode<Statement>();
+                return mk<DebugInfo>(std::move(stmt), readString());
+            }
+            case Tag::Call: return mk<Call>(readString());
+            case Tag::CompactTables: return mk<CompactTables>(readString());
+            case Tag::Checkpoint: {
+                std::string directory = readString();
+                std::size_t step = readSize();
+                if (readInt() != 0) {
+                    return mk<Checkpoint>(std::move(directory), step);
+                }
+                std::size_t steps = readSize();
+                return mk<Checkpoint>(std::move(directory), step, steps, readStrings());
+            }
+            case Tag::StratumCache: {
+                std::string directory = readString();
+                std::string name = readString();
+                std::string key = readString();
+                auto inputs = readStrings();
+                auto outputs = readStrings();
+                return mk<StratumCache>(std::move(directory), std::move(name), std::move(key),
+                        std::move(inputs), std::move(outputs), readNode<Statement>());
+            }
+            case Tag::Guard: {
+                auto cond = readNode<Condition>();
+                return mk<Guard>(std::move(cond), readNode<Statement>());
+            }
+            case Tag::Count: break;
+        }
+        corrupt();
+    }
+
+    template <typename T>
+    Own<Node> readNestedIntrinsicOperator() {
+        auto op = readEnum<NestedIntrinsicOp>();
+        auto args = readNodes<Expression>();
+        int ident = static_cast<int>(readSize());
+        return mk<T>(op, std::move(args), readNode<Operation>(), ident);
+    }
+
+    template <typename T>
+    Own<Node> readScan() {
+        std::string rel = readString();
+        int ident = static_cast<int>(readSize());
+        auto nested = readNode<Operation>();
+        return mk<T>(std::move(rel), ident, std::move(nested), readString());
+    }
+
+    template <typename T>
+    Own<Node> readIndexScan() {
+        std::string rel = readString();
+        int ident = static_cast<int>(readSize());
+        auto pattern = readPattern();
+        auto nested = readNode<Operation>();
+        return mk<T>(std::move(rel), ident, std::move(pattern), std::move(nested), readString());
+    }
+
+    template <typename T>
+    Own<Node> readMergeJoin() {
+        std::string rel = readString();
+        int ident = static_cast<int>(readSize());
+        auto pattern = readPattern();
+        auto nested = readNode<Operation>();
+        std::string profileText = readString();
+        std::size_t element = readSize();
+        if (element >= pattern.first.size()) {
+            corrupt();
+        }
+        return mk<T>(std::move(rel), ident, std::move(pattern), element, std::move(nested),
+                std::move(profileText));
+    }
+
+    template <typename T>
+    Own<Node> readIfExists() {
+        std::string rel = readString();
+        int ident = static_cast<int>(readSize());
+        auto cond = readNode<Condition>();
+        auto nested = readNode<Operation>();
+        return mk<T>(std::move(rel), ident, std::move(cond), std::move(nested), readString());
+    }
+
+    template <typename T>
+    Own<Node> readIndexIfExists() {
+        std::string rel = readString();
+        int ident = static_cast<int>(readSize());
+        auto cond = readNode<Condition>();
+        auto pattern = readPattern();
+        auto nested = readNode<Operation>();
+        return mk<T>(std::move(rel), ident, std::move(cond), std::move(pattern), std::move(nested),
+                readString());
+    }
+
+    template <typename T>
+    Own<Node> readAggregate() {
+        auto fun = readEnum<AggregateOp>();
+        std::string rel = readString();
+        auto expr = readNode<Expression>();
+        auto cond = readNode<Condition>();
+        int ident = static_cast<int>(readSize());
+        auto nested = readNode<Operation>();
+        return mk<T>(std::move(nested), fun, std::move(rel), std::move(expr), std::move(cond), ident);
+    }
+
+    template <typename T>
+    Own<Node> readIndexAggregate() {
+        auto fun = readEnum<AggregateOp>();
+        std::string rel = readString();
+        auto expr = readNode<Expression>();
+        auto cond = readNode<Condition>();
+        auto pattern = readPattern();
+        int ident = static_cast<int>(readSize());
+        auto nested = readNode<Operation>();
+        return mk<T>(std::move(nested), fun, std::move(rel), std::move(expr), std::move(cond),
+                std::move(pattern), ident);
+    }
+};
+
+}  // namespace
+
+void serialise(std::ostream& os, const Program& program) {
+    Writer writer(os);
+    writer.writeHeader();
+    writer.writeProgram(program);
+}
+
+Own<Program> deserialise(std::istream& is) {
+    Reader reader(is);
+    reader.readHeader();
+    return reader.readProgram();
+}
+
+}  // namespace souffle::ram
@@ -0,0 +1,43 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file Serialisation.h
+ *
+ * Defines a binary serialisation of RAM programs, such that an optimised
+ * program can be stored and evaluated later without translating it again
+ *
+ * The serialisation starts with a header naming the version of the format
+ * and the size of the RAM domain; programs are only read back by builds
+ * agreeing on both. The version is to be bumped whenever a RAM node gains,
+ * loses or reorders a field.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "ram/Program.h"
+#include "souffle/utility/ContainerUtil.h"
+#include <istream>
+#include <ostream>
+
+namespace souffle::ram {
+
+/** Write the program to the stream */
+void serialise(std::ostream& os, const Program& program);
+
+/**
+ * Read a program written by serialise() from the stream
+ *
+ * Throws a std::runtime_error if the stream does not hold a program of
+ * the same version of the format.
+ */
+Own<Program> deserialise(std::istream& is);
+
+}  // namespace souffle::ram
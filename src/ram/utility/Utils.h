@@ -19,6 +19,9 @@
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
 #include "ram/Expression.h"
+#include "ram/IO.h"
+#include "ram/Sequence.h"
+#include "ram/Statement.h"
 #include "ram/True.h"
 #include "ram/UndefValue.h"
 #include "souffle/utility/MiscUtil.h"
@@ -40,6 +43,24 @@ inline bool isTrue(const Condition* cond) {
     return isA<True>(cond);
 }
 
+/**
+ * @brief Determines if a statement only loads input relations
+ *
+ * The loads of distinct relations are independent of each other, such that
+ * statements of this kind may be executed concurrently.
+ */
+inline bool isInputOnly(const Statement& stmt) {
+    if (const auto* io = as<IO>(stmt)) {
+        return io->get("operation") == "input";
+    }
+    if (const auto* seq = as<Sequence>(stmt)) {
+        const auto& stmts = seq->getStatements();
+        return !stmts.empty() && std::all_of(stmts.begin(), stmts.end(),
+                                         [](const Statement* cur) { return isInputOnly(*cur); });
+    }
+    return false;
+}
+
 /**
  * @brief Convert terms of a conjunction to a list
  * @param conds A RAM condition
@@ -23,9 +23,12 @@
 #include "ram/Aggregate.h"
 #include "ram/AutoIncrement.h"
 #include "ram/BinRelationStatement.h"
+#include "ram/Branches.h"
 #include "ram/Break.h"
 #include "ram/Call.h"
+#include "ram/Checkpoint.h"
 #include "ram/Clear.h"
+#include "ram/CompactTables.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
 #include "ram/Constraint.h"
@@ -38,11 +41,13 @@
 #include "ram/False.h"
 #include "ram/Filter.h"
 #include "ram/FloatConstant.h"
+#include "ram/Guard.h"
 #include "ram/GuardedInsert.h"
 #include "ram/IO.h"
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
+#include "ram/IndexIntersect.h"
 #include "ram/IndexOperation.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
@@ -53,10 +58,12 @@
 #include "ram/LogTimer.h"
 #include "ram/Loop.h"
 #include "ram/MergeExtend.h"
+#include "ram/MergeJoin.h"
 #include "ram/Negation.h"
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/NestedOperation.h"
 #include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
 #include "ram/NumericConstant.h"
 #include "ram/Operation.h"
 #include "ram/PackRecord.h"
@@ -66,6 +73,8 @@
 #include "ram/ParallelIndexAggregate.h"
 #include "ram/ParallelIndexIfExists.h"
 #include "ram/ParallelIndexScan.h"
+#include "ram/ParallelMergeJoin.h"
+#include "ram/ParallelNestedIntrinsicOperator.h"
 #include "ram/ParallelScan.h"
 #include "ram/Program.h"
 #include "ram/ProvenanceExistenceCheck.h"
@@ -78,6 +87,7 @@
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
 #include "ram/Statement.h"
+#include "ram/StratumCache.h"
 #include "ram/StringConstant.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
@@ -143,15 +153,21 @@ struct Visitor : souffle::detail::VisitorBase<R, NodeType, Params...> {
         SOUFFLE_VISITOR_FORWARD(Filter);
         SOUFFLE_VISITOR_FORWARD(Break);
         SOUFFLE_VISITOR_FORWARD(GuardedInsert);
+        SOUFFLE_VISITOR_FORWARD(NoveltyInsert);
         SOUFFLE_VISITOR_FORWARD(Insert);
         SOUFFLE_VISITOR_FORWARD(Erase);
         SOUFFLE_VISITOR_FORWARD(SubroutineReturn);
+        SOUFFLE_VISITOR_FORWARD(Branches);
         SOUFFLE_VISITOR_FORWARD(UnpackRecord);
+        SOUFFLE_VISITOR_FORWARD(ParallelNestedIntrinsicOperator);
         SOUFFLE_VISITOR_FORWARD(NestedIntrinsicOperator);
         SOUFFLE_VISITOR_FORWARD(ParallelScan);
         SOUFFLE_VISITOR_FORWARD(Scan);
+        SOUFFLE_VISITOR_FORWARD(ParallelMergeJoin);
         SOUFFLE_VISITOR_FORWARD(ParallelIndexScan);
+        SOUFFLE_VISITOR_FORWARD(MergeJoin);
         SOUFFLE_VISITOR_FORWARD(IndexScan);
+        SOUFFLE_VISITOR_FORWARD(IndexIntersect);
         SOUFFLE_VISITOR_FORWARD(ParallelIfExists);
         SOUFFLE_VISITOR_FORWARD(IfExists);
         SOUFFLE_VISITOR_FORWARD(ParallelIndexIfExists);
@@ -180,6 +196,10 @@ struct Visitor : souffle::detail::VisitorBase<R, NodeType, Params...> {
         SOUFFLE_VISITOR_FORWARD(LogRelationTimer);
         SOUFFLE_VISITOR_FORWARD(DebugInfo);
         SOUFFLE_VISITOR_FORWARD(Call);
+        SOUFFLE_VISITOR_FORWARD(CompactTables);
+        SOUFFLE_VISITOR_FORWARD(Checkpoint);
+        SOUFFLE_VISITOR_FORWARD(StratumCache);
+        SOUFFLE_VISITOR_FORWARD(Guard);
 
         // did not work ...
         fatal("unsupported type: %s", typeid(node).name());
@@ -207,20 +227,30 @@ protected:
     SOUFFLE_VISITOR_LINK(LogRelationTimer, Statement);
     SOUFFLE_VISITOR_LINK(DebugInfo, Statement);
     SOUFFLE_VISITOR_LINK(Call, Statement);
+    SOUFFLE_VISITOR_LINK(CompactTables, Statement);
+    SOUFFLE_VISITOR_LINK(Checkpoint, Statement);
+    SOUFFLE_VISITOR_LINK(StratumCache, Statement);
+    SOUFFLE_VISITOR_LINK(Guard, Statement);
 
     SOUFFLE_VISITOR_LINK(Statement, Node);
 
     // -- operations --
     SOUFFLE_VISITOR_LINK(GuardedInsert, Insert);
+    SOUFFLE_VISITOR_LINK(NoveltyInsert, Insert);
     SOUFFLE_VISITOR_LINK(Insert, Operation);
     SOUFFLE_VISITOR_LINK(Erase, Operation);
     SOUFFLE_VISITOR_LINK(SubroutineReturn, Operation);
+    SOUFFLE_VISITOR_LINK(Branches, Operation);
     SOUFFLE_VISITOR_LINK(UnpackRecord, TupleOperation);
     SOUFFLE_VISITOR_LINK(NestedIntrinsicOperator, TupleOperation)
+    SOUFFLE_VISITOR_LINK(ParallelNestedIntrinsicOperator, NestedIntrinsicOperator);
     SOUFFLE_VISITOR_LINK(Scan, RelationOperation);
     SOUFFLE_VISITOR_LINK(ParallelScan, Scan);
     SOUFFLE_VISITOR_LINK(IndexScan, IndexOperation);
     SOUFFLE_VISITOR_LINK(ParallelIndexScan, IndexScan);
+    SOUFFLE_VISITOR_LINK(MergeJoin, IndexScan);
+    SOUFFLE_VISITOR_LINK(ParallelMergeJoin, ParallelIndexScan);
+    SOUFFLE_VISITOR_LINK(IndexIntersect, IndexOperation);
     SOUFFLE_VISITOR_LINK(IfExists, RelationOperation);
     SOUFFLE_VISITOR_LINK(ParallelIfExists, IfExists);
     SOUFFLE_VISITOR_LINK(IndexIfExists, IndexOperation);
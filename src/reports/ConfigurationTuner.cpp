@@ -0,0 +1,131 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ConfigurationTuner.cpp
+ *
+ * Defines the search of `--tune` for the fastest configuration of the
+ * options of a program.
+ *
+ ***********************************************************************/
+
+#include "reports/ConfigurationTuner.h"
+#include "souffle/profile/StringUtils.h"
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace souffle {
+
+namespace {
+/** The settings of a run as a line of options */
+std::string describe(const ConfigurationTuner::Settings& settings) {
+    std::string res;
+    for (const auto& [option, value] : settings) {
+        if (!value.empty()) {
+            res += (res.empty() ? "" : " ") + option + "=" + value;
+        }
+    }
+    return res.empty() ? "(untuned)" : res;
+}
+
+/** Whether a run is faster than another by more than the noise of the measurements, taken as 5% */
+bool isFaster(const TuningRun& run, const TuningRun& other) {
+    return run.runtime.count() * 20 < other.runtime.count() * 19;
+}
+}  // namespace
+
+ConfigurationTuner::Settings ConfigurationTuner::search(std::ostream& log, std::size_t maxRounds) {
+    Settings best;
+    for (const auto& dimension : dimensions) {
+        best[dimension.option] = dimension.values.front();
+    }
+    const auto baseline = measure(best, log);
+    if (!baseline) {
+        throw std::runtime_error("the run of the untuned program failed");
+    }
+    TuningRun fastest = *baseline;
+
+    const bool searchRules = baseline->ruleTime.count() * 10 >= baseline->runtime.count();
+    if (!searchRules) {
+        log << "The rules take less than a tenth of the runtime, their options are not searched\n";
+    }
+
+    for (std::size_t round = 0; round < maxRounds; ++round) {
+        bool improved = false;
+        for (const auto& dimension : dimensions) {
+            if (dimension.rules && !searchRules) {
+                continue;
+            }
+            for (const auto& value : dimension.values) {
+                Settings candidate = best;
+                candidate[dimension.option] = value;
+                auto run = measure(candidate, log);
+                if (run && isFaster(*run, fastest)) {
+                    best = std::move(candidate);
+                    fastest = *run;
+                    improved = true;
+                }
+            }
+        }
+        if (!improved) {
+            break;
+        }
+    }
+    log << "Fastest: " << profile::Tools::formatTime(fastest.runtime) << "  " << describe(best) << "\n";
+
+    Settings res;
+    for (const auto& dimension : dimensions) {
+        const std::string& value = best[dimension.option];
+        if (!value.empty() && value != dimension.values.front()) {
+            res[dimension.option] = value;
+        }
+    }
+    return res;
+}
+
+std::optional<TuningRun> ConfigurationTuner::measure(const Settings& settings, std::ostream& log) {
+    auto pos = runs.find(settings);
+    if (pos != runs.end()) {
+        return pos->second;
+    }
+    auto run = runner(settings);
+    log << std::setw(12) << (run ? profile::Tools::formatTime(run->runtime) : "failed") << "  "
+        << describe(settings) << std::endl;
+    runs[settings] = run;
+    return run;
+}
+
+void ConfigurationTuner::writePragmas(std::ostream& os, const Settings& settings) {
+    os << "// The options under which the program ran fastest, as found by souffle --tune\n";
+    for (const auto& [option, value] : settings) {
+        os << ".pragma \"" << option << "\" \"" << value << "\"\n";
+    }
+}
+
+std::vector<TuningDimension> ConfigurationTuner::getDefaultDimensions(
+        const std::string& jobs, std::size_t maxJobs, const std::string& profile) {
+    std::vector<TuningDimension> res;
+    res.push_back({"RamSIPS", {"", "max-bound", "max-ratio", "least-free", "least-free-vars", "input"}});
+    res.push_back({"profile-use", {"", profile}});
+    res.push_back({"magic-transform", {"", "auto"}});
+    res.push_back({"disable-transformers", {"", "InlineRelationsTransformer"}});
+
+    TuningDimension threads{"jobs", {jobs}, false};
+    for (std::size_t n = 1; n <= maxJobs; n *= 2) {
+        if (std::to_string(n) != jobs) {
+            threads.values.push_back(std::to_string(n));
+        }
+    }
+    res.push_back(std::move(threads));
+    return res;
+}
+
+}  // end of namespace souffle
@@ -0,0 +1,105 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file reports/ConfigurationTuner.h
+ *
+ * Defines the search of `--tune` for the configuration of the options
+ * under which a program runs fastest on sample facts.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * An option searched by the tuner, and the values tried for it. The first value is the one of the
+ * untuned program; an empty value leaves the option unset.
+ */
+struct TuningDimension {
+    std::string option;
+    std::vector<std::string> values;
+
+    /** Whether the option only changes the evaluation of rules, rather than their input and output */
+    bool rules = true;
+};
+
+/** The runtime of a run measured by its profile */
+struct TuningRun {
+    std::chrono::microseconds runtime{};
+
+    /** The time spent in the rules of the program */
+    std::chrono::microseconds ruleTime{};
+};
+
+/**
+ * Searches the values of the dimensions for the fastest run, one dimension at a time: each value of a
+ * dimension is tried with the best values found for the others, until a round over all dimensions does
+ * not improve the runtime.
+ */
+class ConfigurationTuner {
+public:
+    /** The options of a run, by option */
+    using Settings = std::map<std::string, std::string>;
+
+    /** Run the program with the given options, returning nothing if the run failed */
+    using Runner = std::function<std::optional<TuningRun>(const Settings&)>;
+
+    ConfigurationTuner(std::vector<TuningDimension> dimensions, Runner runner)
+            : dimensions(std::move(dimensions)), runner(std::move(runner)) {}
+
+    /**
+     * Search the fastest settings, logging the runs.
+     *
+     * The profile of the run of the untuned program prunes the search: if its rules take less than
+     * a tenth of its runtime, the dimensions of the evaluation of rules are not searched. A value is
+     * only preferred if it is faster by more than the noise of the measurements.
+     *
+     * @return the fastest settings, omitting the options left unset
+     */
+    Settings search(std::ostream& log, std::size_t maxRounds = 3);
+
+    /** Write the settings as pragmas of a Datalog program */
+    static void writePragmas(std::ostream& os, const Settings& settings);
+
+    /**
+     * The dimensions searched by `--tune`
+     *
+     * @param jobs the number of threads of the untuned program
+     * @param maxJobs the largest number of threads tried
+     * @param profile the file holding the profile of the untuned program once it ran, whose literal
+     *                orders are tried by `profile-use`
+     */
+    static std::vector<TuningDimension> getDefaultDimensions(
+            const std::string& jobs, std::size_t maxJobs, const std::string& profile);
+
+private:
+    /** Run the program with the given settings, once per distinct settings */
+    std::optional<TuningRun> measure(const Settings& settings, std::ostream& log);
+
+    std::vector<TuningDimension> dimensions;
+
+    Runner runner;
+
+    /** The runs of the settings tried so far */
+    std::map<Settings, std::optional<TuningRun>> runs;
+};
+
+}  // end of namespace souffle
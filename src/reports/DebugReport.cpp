@@ -27,7 +27,8 @@ namespace souffle {
 
 namespace {
 /**
- * Generate a full-content diff between two sources.
+ * Generate the hunks of a unified diff between two sources, with a few lines of context around each
+ * change, such that a stage is reported by what it changed rather than by the whole program.
  * Both arguments are passed into a `std::ostream` so you may exploit stream implementations.
  */
 template <typename A, typename B>
@@ -38,11 +39,14 @@ std::string generateDiff(const A& prev, const B& curr) {
     in_curr << curr;
     in_prev.flush();
     in_curr.flush();
-    std::string diff_cmd =
-            "diff --new-line-format='+%L' "
-            "     --old-line-format='-%L' "
-            "     --unchanged-line-format=' %L' ";
-    return execStdOut(diff_cmd + in_prev.getFileName() + " " + in_curr.getFileName()).str();
+    std::string diff =
+            execStdOut("diff -U 3 " + in_prev.getFileName() + " " + in_curr.getFileName()).str();
+    // drop the header naming the temporary files, the viewer names the files by their language
+    for (int i = 0; i < 2 && (diff.rfind("--- ", 0) == 0 || diff.rfind("+++ ", 0) == 0); ++i) {
+        const auto eol = diff.find('\n');
+        diff.erase(0, eol == std::string::npos ? diff.size() : eol + 1);
+    }
+    return diff;
 }
 
 std::string replaceAll(std::string_view text, std::string_view key, std::string_view replacement) {
@@ -57,6 +61,10 @@ std::string replaceAll(std::string_view text, std::string_view key, std::string_
     }
     return ss.str();
 }
+
+std::string escapeHtml(std::string_view text) {
+    return replaceAll(replaceAll(replaceAll(text, "&", "&amp;"), "<", "&lt;"), ">", "&gt;");
+}
 }  // namespace
 
 void DebugReportSection::printIndex(std::ostream& out) const {
@@ -104,14 +112,23 @@ DebugReport::~DebugReport() {
         endSection("forced-closed", "Forcing end of unknown section");
     }
 
-    flush();
+    if (file.is_open()) {
+        file << "</body>\n</html>\n";
+    }
 }
 
 void DebugReport::flush() {
-    auto&& dst = Global::config().get("debug-report");
-    if (dst.empty() || empty()) return;
+    if (file.is_open()) {
+        file.flush();
+    }
+}
 
-    std::ofstream(dst) << *this;
+void DebugReport::addSection(DebugReportSection section) {
+    if (!currentSubsections.empty()) {
+        currentSubsections.top().emplace_back(std::move(section));
+        return;
+    }
+    writePage(section);
 }
 
 void DebugReport::addSection(std::string id, std::string title, const std::string_view code) {
@@ -121,15 +138,10 @@ void DebugReport::addSection(std::string id, std::string title, const std::strin
 
 void DebugReport::addCodeSection(std::string id, std::string title, std::string_view language,
         std::string_view prev, std::string_view curr) {
-    auto diff =
-            replaceAll(replaceAll(prev.empty() ? curr : generateDiff(prev, curr), "\\", "\\\\"), "`", "\\`");
-    auto divId = nextUniqueId++;
-    auto html = R"(
-        <div id="code-id-%d"></div>
-        <script type="text/javascript"> renderDiff('%s', 'code-id-%d', `%s`) </script>
-    )";
-    addSection(DebugReportSection(
-            std::move(id), std::move(title), tfm::format(html, divId, language, divId, diff)));
+    // the diff is rendered by the viewer once the page of the section is shown
+    auto diff = escapeHtml(generateDiff(prev, curr));
+    auto html = tfm::format("<pre class='diff-source' data-lang='%s'>%s</pre>", language, diff);
+    addSection(DebugReportSection(std::move(id), std::move(title), std::move(html)));
 }
 
 void DebugReport::endSection(std::string currentSectionName, std::string currentSectionTitle) {
@@ -137,15 +149,34 @@ void DebugReport::endSection(std::string currentSectionName, std::string current
     currentSubsections.pop();
     addSection(DebugReportSection(
             std::move(currentSectionName), std::move(currentSectionTitle), std::move(subsections), ""));
-    flush();
 }
 
-void DebugReport::print(std::ostream& out) const {
+void DebugReport::writePage(const DebugReportSection& section) {
+    if (!file.is_open()) {
+        auto&& dst = Global::config().get("debug-report");
+        if (dst.empty()) return;
+        file.open(dst);
+        printHeader(file);
+    }
+
+    // the entries of the index are collected by the viewer, which finds the pages holding their targets
+    file << "<div class='index-entry'>\n";
+    section.printIndex(file);
+    file << "</div>\n";
+    file << "<template class='page'>\n";
+    section.printContent(file);
+    file << "</template>\n";
+
+    // the pages written so far remain readable if the compilation is aborted
+    file.flush();
+}
+
+void DebugReport::printHeader(std::ostream& out) {
     out << R"(
 <!DOCTYPE html>
 <html lang='en-AU'>
 <head>
-<meta charset=\"UTF-8\">
+<meta charset="UTF-8">
 <title>Souffle Debug Report ()";
     out << Global::config().get("") << R"()</title>
 <style>
@@ -160,6 +191,12 @@ void DebugReport::print(std::ostream& out) const {
         padding-top:3px; padding-bottom:3px; border-radius:5px }
     .headerdiv h1 { display:inline; }
     .headerdiv a { float:right; }
+    nav#index { position: fixed; top: 0; bottom: 0; left: 0; width: 22em; overflow: auto;
+        border-right: 1px solid lightgrey; }
+    nav#index ul { padding-left: 1em; }
+    body > div.headerdiv, main { margin-left: 23em; }
+    body > div.index-entry { display: none; }
+    div.pager { margin: 10px; }
 </style>
 
 <link rel="stylesheet" type="text/css" href=
@@ -255,15 +292,14 @@ void DebugReport::print(std::ostream& out) const {
   }
 
   if (typeof Diff2HtmlUI !== 'undefined' && typeof hljs !== 'undefined') {
-    function renderDiff(lang, id, diff) {
+    function renderDiff(lang, target, diff) {
       // file extension determines the language used for highlighting
       let file   = `Datalog.${lang}`
       let prefix = `diff ${file} ${file}
 --- ${file}
 +++ ${file}
-@@ -1 +1 @@
 `
-      new Diff2HtmlUI(document.getElementById(id), prefix + diff, {
+      new Diff2HtmlUI(target, prefix + diff, {
         drawFileList: false,
         highlight: true,
         matching: 'none',
@@ -272,24 +308,71 @@ void DebugReport::print(std::ostream& out) const {
       }, hljs).draw()
     }
   } else { // fallback to plain text
-    function renderDiff(lang, id, diff) {
-      document.getElementById(id).innerText = diff
+    function renderDiff(lang, target, diff) {
+      let pre = document.createElement('pre')
+      pre.innerText = diff
+      target.appendChild(pre)
     }
   }
+
+  // the pages, i.e., the top-level sections, are inert templates until shown, one at a time
+  let currentPage = null
+
+  function showPage(page) {
+    let container = document.getElementById('page')
+    container.replaceChildren(page.content.cloneNode(true))
+    for (let source of container.querySelectorAll('pre.diff-source')) {
+      let target = document.createElement('div')
+      source.replaceWith(target)
+      renderDiff(source.dataset.lang, target, source.textContent)
+    }
+    currentPage = page
+  }
+
+  function turnPage(step) {
+    let pages = Array.from(document.querySelectorAll('template.page'))
+    let next = pages.indexOf(currentPage) + step
+    if (next >= 0 && next < pages.length) {
+      showPage(pages[next])
+      window.scrollTo(0, 0)
+    }
+  }
+
+  function showAnchor() {
+    let id = decodeURIComponent(location.hash.substring(1))
+    if (id === '' || document.getElementById(id) !== null) {
+      return
+    }
+    for (let page of document.querySelectorAll('template.page')) {
+      if (page.content.getElementById(id) !== null) {
+        showPage(page)
+        document.getElementById(id).scrollIntoView()
+        return
+      }
+    }
+  }
+
+  window.addEventListener('hashchange', showAnchor)
+  document.addEventListener('DOMContentLoaded', function () {
+    document.getElementById('index').append(...document.querySelectorAll('body > div.index-entry'))
+    let first = document.querySelector('template.page')
+    if (first !== null) {
+      showPage(first)
+    }
+    showAnchor()
+  })
 </script>
 </head>
 <body>
+<nav id='index'></nav>
 <div class='headerdiv'><h1>Souffle Debug Report ()";
-    out << Global::config().get("") << ")</h1></div>\n";
-    for (const DebugReportSection& section : sections) {
-        section.printIndex(out);
-    }
-    for (const DebugReportSection& section : sections) {
-        section.printContent(out);
-    }
-    out << R"(<a href='#'>(return to top)</a>
-</body>
-</html>)";
+    out << Global::config().get("") << R"()</h1></div>
+<main>
+<div class='pager'><button onclick='turnPage(-1)'>previous page</button>
+<button onclick='turnPage(1)'>next page</button></div>
+<div id='page'></div>
+</main>
+)";
 }
 
 }  // end of namespace souffle
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <cstdint>
+#include <fstream>
 #include <ostream>
 #include <stack>
 #include <string>
@@ -77,17 +78,20 @@ private:
 
 /**
  * Class representing a HTML report, consisting of a list of sections.
+ *
+ * The report is streamed to the file given by the debug-report option: each top-level section is
+ * written as a page of its own once it is complete, and only the sections still open are kept in
+ * memory. The pages are inert templates, which the viewer in the report renders one at a time once
+ * they are shown, including the diffs of their code sections.
  */
 class DebugReport {
 public:
     ~DebugReport();
 
+    /** Flush the pages written so far to the report file */
     void flush();
 
-    void addSection(DebugReportSection section) {
-        auto& buf = currentSubsections.empty() ? sections : currentSubsections.top();
-        buf.emplace_back(std::move(section));
-    }
+    void addSection(DebugReportSection section);
 
     void addSection(std::string id, std::string title, std::string_view code);
     void addCodeSection(std::string id, std::string title, std::string_view language, std::string_view prev,
@@ -100,30 +104,26 @@ public:
     void endSection(std::string currentSectionName, std::string currentSectionTitle);
 
     /**
-     * Outputs a complete HTML document to the given stream,
-     * consisting of an index of all of the sections of the report,
-     * followed by the content of each section.
+     * Generate a debug report section for code (preserving formatting), with the given id and title.
      */
-    void print(std::ostream& out) const;
+    static DebugReportSection getCodeSection(const std::string& id, std::string title, std::string code);
 
+private:
     /**
-     * Generate a debug report section for code (preserving formatting), with the given id and title.
+     * Outputs the head of the HTML document and the viewer of its pages to the given stream.
      */
-    static DebugReportSection getCodeSection(const std::string& id, std::string title, std::string code);
+    static void printHeader(std::ostream& out);
 
-    friend std::ostream& operator<<(std::ostream& out, const DebugReport& report) {
-        report.print(out);
-        return out;
-    }
+    /**
+     * Write a complete top-level section to the report file as a page, preceded by its entry of the
+     * index, opening the file with the first page.
+     */
+    void writePage(const DebugReportSection& section);
 
-private:
-    std::vector<DebugReportSection> sections;
     std::stack<std::vector<DebugReportSection>> currentSubsections;
-    uint32_t nextUniqueId = 0;  // used for generating unique HTML `id` tags
 
-    bool empty() const {
-        return sections.empty();
-    }
+    // the report file, opened once the first page is written
+    std::ofstream file;
 };
 
 }  // end of namespace souffle
@@ -0,0 +1,221 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file EngineComparison.cpp
+ *
+ * Defines the comparison of runs of a program in several configurations
+ * of the engine by `--bench`.
+ *
+ ***********************************************************************/
+
+#include "reports/EngineComparison.h"
+#include "souffle/profile/Cell.h"
+#include "souffle/profile/Iteration.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/profile/Relation.h"
+#include "souffle/profile/Row.h"
+#include "souffle/profile/Rule.h"
+#include "souffle/profile/StringUtils.h"
+#include "souffle/profile/Table.h"
+#include "souffle/utility/StringUtil.h"
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace souffle {
+
+namespace {
+/**
+ * The names of the regular files in a directory.
+ */
+std::set<std::string> listFiles(const std::string& dir) {
+    std::set<std::string> files;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(d)) {
+            struct stat info;
+            std::string path = dir + "/" + entry->d_name;
+            if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+                files.insert(entry->d_name);
+            }
+        }
+        closedir(d);
+    }
+    return files;
+}
+
+/**
+ * The lines of a file in sorted order, such that files of the same tuples written in different
+ * orders, e.g. by parallel evaluations, compare equal.
+ */
+std::vector<std::string> sortedLines(const std::string& path) {
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(std::move(line));
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+}  // namespace
+
+std::vector<EngineConfiguration> EngineConfiguration::parseAll(const std::string& text) {
+    std::vector<EngineConfiguration> configurations;
+    for (const auto& entry : splitString(text, ';')) {
+        if (entry.empty()) {
+            continue;
+        }
+        EngineConfiguration configuration;
+        configuration.name = entry;
+        const std::size_t colon = entry.find(':');
+        const std::string engine = entry.substr(0, colon);
+        if (engine != "interpreter" && engine != "compiled") {
+            throw std::invalid_argument("invalid engine `" + engine + "` in --bench, expected " +
+                                        "`interpreter` or `compiled`");
+        }
+        configuration.compiled = engine == "compiled";
+        if (colon != std::string::npos) {
+            for (auto& option : splitString(entry.substr(colon + 1), ' ')) {
+                if (!option.empty()) {
+                    configuration.options.push_back(std::move(option));
+                }
+            }
+        }
+        configurations.push_back(std::move(configuration));
+    }
+    if (configurations.size() < 2) {
+        throw std::invalid_argument(
+                "--bench requires at least two configurations, e.g. `interpreter;compiled`");
+    }
+    return configurations;
+}
+
+void EngineComparison::addRun(
+        const std::string& configuration, const std::string& outputDir, const std::string& profile) {
+    auto program = std::make_shared<profile::ProgramRun>();
+    profile::Reader reader(profile, program);
+    reader.processFile();
+
+    Run run{configuration, outputDir, program->getEndtime() - program->getStarttime(), {}};
+    for (const auto& [name, relation] : program->getRelationMap()) {
+        for (const auto& entry : relation->getRuleMap()) {
+            run.rules[name + ": " + entry.second->getName()] += entry.second->getRuntime();
+        }
+        // the runtimes of recursive rules are summed over the iterations
+        for (const auto& iteration : relation->getIterations()) {
+            for (const auto& entry : iteration->getRules()) {
+                const auto& rule = *entry.second;
+                std::string key = name + ": " + rule.getName();
+                if (rule.getVersion() != 0) {
+                    key += " (version " + std::to_string(rule.getVersion()) + ")";
+                }
+                run.rules[key] += rule.getRuntime();
+            }
+        }
+    }
+    runs.push_back(std::move(run));
+}
+
+bool EngineComparison::checkOutputs(std::ostream& os) const {
+    bool agree = true;
+    if (runs.empty()) {
+        return agree;
+    }
+    const Run& expected = runs.front();
+    const std::set<std::string> expectedFiles = listFiles(expected.outputDir);
+    for (std::size_t i = 1; i < runs.size(); ++i) {
+        const Run& actual = runs[i];
+        std::set<std::string> files = expectedFiles;
+        for (const auto& file : listFiles(actual.outputDir)) {
+            files.insert(file);
+        }
+        for (const auto& file : files) {
+            if (sortedLines(expected.outputDir + "/" + file) != sortedLines(actual.outputDir + "/" + file)) {
+                os << "Output " << file << " of " << actual.configuration << " differs from "
+                   << expected.configuration << "\n";
+                agree = false;
+            }
+        }
+    }
+    return agree;
+}
+
+std::chrono::microseconds EngineComparison::getRuleTime(std::size_t i) const {
+    std::chrono::microseconds res{};
+    for (const auto& rule : runs[i].rules) {
+        res += rule.second;
+    }
+    return res;
+}
+
+void EngineComparison::print(std::ostream& os, std::size_t rules) const {
+    os << "Runtime of the configurations:\n";
+    for (const auto& run : runs) {
+        os << std::setw(12) << profile::Tools::formatTime(run.runtime) << "  " << run.configuration << "\n";
+    }
+
+    // a row per rule: the time the slowest run takes longer than the fastest, the time of each
+    // run, and the rule, such that the rows are sorted by the first column
+    std::set<std::string> keys;
+    for (const auto& run : runs) {
+        for (const auto& rule : run.rules) {
+            keys.insert(rule.first);
+        }
+    }
+    profile::Table table;
+    for (const auto& key : keys) {
+        auto row = std::make_shared<profile::Row>(runs.size() + 2);
+        double fastest = -1;
+        double slowest = 0;
+        for (std::size_t i = 0; i < runs.size(); ++i) {
+            auto rule = runs[i].rules.find(key);
+            if (rule == runs[i].rules.end()) {
+                continue;
+            }
+            (*row)[i + 1] = std::make_shared<profile::Cell<std::chrono::microseconds>>(rule->second);
+            const double time = (*row)[i + 1]->getDoubleVal();
+            fastest = fastest < 0 ? time : std::min(fastest, time);
+            slowest = std::max(slowest, time);
+        }
+        (*row)[0] = std::make_shared<profile::Cell<double>>(slowest - fastest);
+        (*row)[runs.size() + 1] = std::make_shared<profile::Cell<std::string>>(key);
+        table.addRow(row);
+    }
+    table.sort(0);
+
+    os << "\nRules by the time the slowest configuration takes longer than the fastest:\n";
+    os << std::setw(12) << "difference";
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        os << std::setw(12) << ("[" + std::to_string(i + 1) + "]");
+    }
+    os << "  rule\n";
+    const auto& rows = table.getRows();
+    for (std::size_t r = 0; r < rows.size() && r < rules; ++r) {
+        auto& row = *rows[r];
+        os << std::setw(12) << std::fixed << std::setprecision(3) << row[0]->getDoubleVal();
+        for (std::size_t i = 0; i < runs.size(); ++i) {
+            os << std::setw(12) << (row[i + 1] ? row[i + 1]->toString(0) : "-");
+        }
+        std::string rule = row[runs.size() + 1]->getStringVal();
+        std::replace(rule.begin(), rule.end(), '\n', ' ');
+        os << "  " << (rule.size() > 100 ? rule.substr(0, 97) + "..." : rule) << "\n";
+    }
+    os << "\n";
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        os << "[" << i + 1 << "] " << runs[i].configuration << "\n";
+    }
+}
+
+}  // end of namespace souffle
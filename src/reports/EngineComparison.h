@@ -0,0 +1,84 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file reports/EngineComparison.h
+ *
+ * Defines the comparison of runs of a program in several configurations
+ * of the engine by `--bench`: whether their outputs agree, and how the
+ * runtimes of their rules differ, as read from their profiles.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A configuration of the engine, given as `interpreter` or `compiled`, optionally followed by a
+ * colon and space-separated options of the runs in it, e.g. `compiled:-z MagicSetTransformer`.
+ */
+struct EngineConfiguration {
+    std::string name;
+    bool compiled = false;
+    std::vector<std::string> options;
+
+    /** Parse the `;`-separated configurations, throwing std::invalid_argument for invalid ones */
+    static std::vector<EngineConfiguration> parseAll(const std::string& text);
+};
+
+/**
+ * Collects the runs of a program in several configurations, and compares them to the run in the
+ * first configuration.
+ */
+class EngineComparison {
+public:
+    /**
+     * Add the run in the given configuration, reading its profile.
+     *
+     * @param configuration the name of the configuration
+     * @param outputDir the directory the run wrote its output relations to
+     * @param profile the profile written by the run
+     */
+    void addRun(const std::string& configuration, const std::string& outputDir, const std::string& profile);
+
+    /** Print the files of output relations that differ from the first run; return whether all agree */
+    bool checkOutputs(std::ostream& os) const;
+
+    /** Print the runtimes of the runs and of the rules whose runtimes differ the most between them */
+    void print(std::ostream& os, std::size_t rules = 20) const;
+
+    /** The runtime of the i-th run */
+    std::chrono::microseconds getRuntime(std::size_t i) const {
+        return runs[i].runtime;
+    }
+
+    /** The summed runtime of the rules of the i-th run */
+    std::chrono::microseconds getRuleTime(std::size_t i) const;
+
+private:
+    struct Run {
+        std::string configuration;
+        std::string outputDir;
+        std::chrono::microseconds runtime{};
+        /** runtime of each rule, by relation, rule, and version of recursive rules */
+        std::map<std::string, std::chrono::microseconds> rules;
+    };
+
+    std::vector<Run> runs;
+};
+
+}  // end of namespace souffle
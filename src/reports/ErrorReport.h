@@ -22,6 +22,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -181,11 +183,26 @@ public:
         diagnostics.insert(diagnostic);
     }
 
+    /** Adds the diagnostics of another report, e.g., of a part of the program parsed separately */
+    void addDiagnostics(const ErrorReport& other) {
+        diagnostics.insert(other.diagnostics.begin(), other.diagnostics.end());
+    }
+
+    /** Throw the errors as a std::runtime_error rather than exiting, e.g. in programs loaded at runtime */
+    void setThrowing(bool throwing) {
+        this->throwing = throwing;
+    }
+
     void exitIfErrors() {
         if (getNumErrors() == 0) {
             return;
         }
 
+        if (throwing) {
+            std::stringstream errors;
+            errors << *this << getNumErrors() << " errors generated, evaluation aborted";
+            throw std::runtime_error(errors.str());
+        }
         std::cerr << *this << getNumErrors() << " errors generated, evaluation aborted\n";
         exit(EXIT_FAILURE);
     }
@@ -204,6 +221,7 @@ public:
 private:
     std::set<Diagnostic> diagnostics;
     bool nowarn;
+    bool throwing = false;
 };
 
 }  // end of namespace souffle
@@ -7,15 +7,19 @@
  */
 
 #include "synthesiser/Relation.h"
+#include "Global.h"
 #include "RelationTag.h"
 #include "ram/analysis/Index.h"
+#include "souffle/BinaryConstraintOps.h"
 #include "souffle/SouffleInterface.h"
 #include "souffle/utility/MiscUtil.h"
 #include "souffle/utility/StreamUtil.h"
+#include "souffle/utility/StringUtil.h"
 #include <algorithm>
 #include <cassert>
 #include <functional>
 #include <map>
+#include <numeric>
 #include <set>
 #include <sstream>
 #include <vector>
@@ -27,6 +31,127 @@ using namespace ram;
 using ram::analysis::LexOrder;
 using ram::analysis::SearchSignature;
 
+namespace {
+
+/** Longest index prefix whose columns are all compared, rather than up to the first difference */
+constexpr std::size_t eagerComparisonColumns = 3;
+
+/**
+ * Generate the return statement of a three-way comparison of the first bound columns of an index
+ * order, where column(tuple, i) yields the comparable value of the i-th attribute of the tuple lhs or
+ * rhs.
+ *
+ * Short prefixes compare all columns and select the first non-zero result, which compiles to
+ * conditional moves instead of a branch per column.
+ */
+void genThreeWayComparison(std::ostream& out, const LexOrder& ind, std::size_t bound,
+        const std::function<std::string(const std::string&, std::size_t)>& column, const std::string& lhs,
+        const std::string& rhs) {
+    assert(bound > 0 && bound <= ind.size() && "invalid comparison bound");
+    if (bound <= eagerComparisonColumns) {
+        for (std::size_t i = 0; i < bound; ++i) {
+            const auto a = column(lhs, ind[i]);
+            const auto b = column(rhs, ind[i]);
+            out << "  const int c" << i << " = (" << a << " > " << b << ") - (" << a << " < " << b << ");\n";
+        }
+        out << "  return ";
+        for (std::size_t i = 0; i + 1 < bound; ++i) {
+            out << "c" << i << " != 0 ? c" << i << " : ";
+        }
+        out << "c" << bound - 1 << ";\n";
+        return;
+    }
+    out << "  return ";
+    for (std::size_t i = 0; i < bound; ++i) {
+        const auto a = column(lhs, ind[i]);
+        const auto b = column(rhs, ind[i]);
+        out << "(" << a << " < " << b << ") ? -1 : (" << a << " > " << b << ") ? 1 : (";
+    }
+    out << "0" << std::string(bound, ')') << ";\n";
+}
+
+/**
+ * Generate the return statement of a three-way comparison of tuples, casting their columns, where lhs
+ * and rhs prefix the column subscript of either tuple, e.g. "a[".
+ */
+void genThreeWayComparison(std::ostream& out, const LexOrder& ind, std::size_t bound,
+        const std::vector<std::string>& typecasts, const std::string& lhs, const std::string& rhs) {
+    auto column = [&](const std::string& tuple, std::size_t attrib) {
+        return typecasts[attrib] + "(" + tuple + std::to_string(attrib) + "])";
+    };
+    genThreeWayComparison(out, ind, bound, column, lhs, rhs);
+}
+
+/** An integer type storing the bounded attributes of packed relations */
+struct NarrowType {
+    const char* name;
+    RamSigned least;
+    RamSigned greatest;
+    std::size_t size;
+};
+
+/** The types of packed attributes, from the narrowest to the widest */
+const NarrowType narrowTypes[] = {{"uint8_t", 0, 0xff, 1}, {"int8_t", -0x80, 0x7f, 1},
+        {"uint16_t", 0, 0xffff, 2}, {"int16_t", -0x8000, 0x7fff, 2}};
+
+/** Get the narrowest type holding the bounds of each attribute of a relation, or nullptr if there is none */
+std::vector<const NarrowType*> getNarrowTypes(
+        const ram::Relation& rel, const ram::analysis::IndexCluster& indexSelection) {
+    std::vector<const NarrowType*> res(rel.getArity(), nullptr);
+    for (const auto& [attribute, bounds] : indexSelection.getBounds()) {
+        // unsigned attributes are compared as unsigned values, hence stored without sign
+        const bool isUnsigned = rel.getAttributeTypes()[attribute][0] == 'u';
+        for (const auto& type : narrowTypes) {
+            if (bounds.first >= type.least && bounds.second <= type.greatest &&
+                    (!isUnsigned || type.least == 0)) {
+                res[attribute] = &type;
+                break;
+            }
+        }
+    }
+    return res;
+}
+
+}  // namespace
+
+unsigned Relation::getNodeSize() const {
+    if (!Global::config().has("btree-node-size")) {
+        return 0;
+    }
+    // auxiliary relations, e.g. @delta_path, share the node size of their relation
+    std::string name = relation.getName();
+    if (name[0] == '@') {
+        name = name.substr(name.find('_') + 1);
+    }
+    unsigned res = 0;
+    for (const auto& entry : splitString(Global::config().get("btree-node-size"), ',')) {
+        auto pos = entry.find('=');
+        if (pos == std::string::npos) {
+            // an entry without relation selects the node size of all relations
+            res = res == 0 ? std::stoi(entry) : res;
+        } else if (entry.substr(0, pos) == name) {
+            return std::stoi(entry.substr(pos + 1));
+        }
+    }
+    return res;
+}
+
+std::string Relation::getNodeSizeArguments(const std::string& keyType) const {
+    unsigned nodeSize = getNodeSize();
+    if (nodeSize == 0) {
+        return "";
+    }
+    return ",std::allocator<" + keyType + ">," + std::to_string(nodeSize);
+}
+
+std::string Relation::getNodeSizeSuffix() const {
+    unsigned nodeSize = getNodeSize();
+    if (nodeSize == 0) {
+        return "";
+    }
+    return "__n" + std::to_string(nodeSize);
+}
+
 std::string Relation::getTypeAttributeString(const std::vector<std::string>& attributeTypes,
         const std::unordered_set<uint32_t>& attributesUsed) const {
     std::stringstream type;
@@ -52,16 +177,30 @@ Own<Relation> Relation::getSynthesiserRelation(
         rel = new DirectRelation(ramRel, indexSelection, isProvenance, false);
     } else if (ramRel.isNullary()) {
         rel = new NullaryRelation(ramRel, indexSelection, isProvenance);
+    } else if (PackedRelation::isPackable(ramRel, indexSelection)) {
+        rel = new PackedRelation(ramRel, indexSelection);
     } else if (ramRel.getRepresentation() == RelationRepresentation::BTREE) {
         rel = new DirectRelation(ramRel, indexSelection, isProvenance, false);
     } else if (ramRel.getRepresentation() == RelationRepresentation::BTREE_DELETE) {
         rel = new DirectRelation(ramRel, indexSelection, isProvenance, true);
     } else if (ramRel.getRepresentation() == RelationRepresentation::BRIE) {
         rel = new BrieRelation(ramRel, indexSelection, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::COLUMNAR) {
+        rel = new ColumnarRelation(ramRel, indexSelection, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::SMALL) {
+        rel = new DirectRelation(ramRel, indexSelection, isProvenance, false, true);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::SHARDED) {
+        rel = new DirectRelation(ramRel, indexSelection, isProvenance, false, false,
+                DirectRelation::isShardable(ramRel, indexSelection));
+    } else if (ramRel.getRepresentation() == RelationRepresentation::VECTOR &&
+               VectorRelation::isScanOnly(indexSelection)) {
+        rel = new VectorRelation(ramRel, indexSelection, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::EQREL) {
         rel = new EqrelRelation(ramRel, indexSelection, isProvenance);
     } else if (ramRel.getRepresentation() == RelationRepresentation::INFO) {
         rel = new InfoRelation(ramRel, indexSelection, isProvenance);
+    } else if (ramRel.getRepresentation() == RelationRepresentation::COUNTER) {
+        rel = new CounterRelation(ramRel, indexSelection, isProvenance);
     } else {
         // Handle the data structure command line flag
         if (ramRel.getArity() > 6) {
@@ -78,6 +217,55 @@ Own<Relation> Relation::getSynthesiserRelation(
     return Own<Relation>(rel);
 }
 
+bool Relation::providesSpans(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection,
+        bool isProvenance) {
+    // only direct relations whose master index is a b-tree, as selected by getSynthesiserRelation
+    if (isProvenance) {
+        return true;
+    }
+    if (ramRel.isNullary() || PackedRelation::isPackable(ramRel, indexSelection)) {
+        return false;
+    }
+    switch (ramRel.getRepresentation()) {
+        case RelationRepresentation::BTREE: return true;
+        case RelationRepresentation::SHARDED: return !DirectRelation::isShardable(ramRel, indexSelection);
+        case RelationRepresentation::VECTOR:
+            return !VectorRelation::isScanOnly(indexSelection) && ramRel.getArity() <= 6;
+        case RelationRepresentation::DEFAULT: return ramRel.getArity() <= 6;
+        default: return false;
+    }
+}
+
+bool Relation::providesPrefetch(const ram::Relation& ramRel, bool isProvenance) {
+    // only direct relations, as selected by getSynthesiserRelation
+    if (isProvenance) {
+        return true;
+    }
+    if (ramRel.isNullary()) {
+        return false;
+    }
+    switch (ramRel.getRepresentation()) {
+        case RelationRepresentation::BTREE:
+        case RelationRepresentation::BTREE_DELETE:
+        case RelationRepresentation::SMALL:
+        case RelationRepresentation::SHARDED: return true;
+        case RelationRepresentation::BRIE:
+        case RelationRepresentation::COLUMNAR:
+        case RelationRepresentation::EQREL:
+        case RelationRepresentation::INFO:
+        case RelationRepresentation::COUNTER: return false;
+        default: return ramRel.getArity() <= 6;
+    }
+}
+
+bool Relation::providesNodePartition(
+        const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance) {
+    // only sharded direct relations, as selected by getSynthesiserRelation
+    return !isProvenance && !ramRel.isNullary() &&
+           ramRel.getRepresentation() == RelationRepresentation::SHARDED &&
+           DirectRelation::isShardable(ramRel, indexSelection);
+}
+
 // -------- Info Relation --------
 
 /** Generate index set for a info relation, which should be empty */
@@ -96,6 +284,24 @@ void InfoRelation::generateTypeStruct(std::ostream&) {
     return;
 }
 
+// -------- Counter Relation --------
+
+/** Generate index set for a counter relation, which should be empty */
+void CounterRelation::computeIndices() {
+    computedIndices = {};
+}
+
+/** Generate type name of a counter relation */
+std::string CounterRelation::getTypeName() {
+    return "t_counter<" + std::to_string(getArity()) + ">";
+}
+
+/** Generate type struct of a counter relation, which is empty,
+ * the actual implementation is in CompiledSouffle.h */
+void CounterRelation::generateTypeStruct(std::ostream&) {
+    return;
+}
+
 // -------- Nullary Relation --------
 
 /** Generate index set for a nullary relation, which should be empty */
@@ -163,6 +369,48 @@ void DirectRelation::computeIndices() {
     computedIndices = inds;
 }
 
+bool DirectRelation::isHashIndex(std::size_t i) const {
+    // the master index provides ordered iteration and the erase and update operations need b-trees
+    if (isProvenance || hasErase || isSmall || isSharded || i == masterIndex) {
+        return false;
+    }
+    const auto& orders = indexSelection.getAllOrders();
+    if (i >= orders.size() || !indexSelection.isEqualityIndex(orders[i])) {
+        return false;
+    }
+    // floats that compare equal may differ in their bit patterns (e.g., 0.0 and -0.0)
+    const auto& types = relation.getAttributeTypes();
+    return std::none_of(
+            orders[i].begin(), orders[i].end(), [&](auto attr) { return types[attr][0] == 'f'; });
+}
+
+bool DirectRelation::isOnDemandIndex(std::size_t i) const {
+    // the master index holds the tuples the other indexes are built from; small and sharded indexes are
+    // not loaded
+    return !isProvenance && !hasErase && !isSmall && !isSharded && i != masterIndex &&
+           indexSelection.isOnDemand(i);
+}
+
+bool DirectRelation::isShardable(
+        const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection) {
+    if (ramRel.isLattice()) {
+        return false;
+    }
+    const auto& types = ramRel.getAttributeTypes();
+    const auto& orders = indexSelection.getAllOrders();
+    return std::none_of(orders.begin(), orders.end(),
+            [&](const auto& order) { return !order.empty() && types[order[0]][0] == 'f'; });
+}
+
+bool DirectRelation::hasOnDemandIndexes() const {
+    for (std::size_t i = 0; i < computedIndices.size(); i++) {
+        if (isOnDemandIndex(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /** Generate type name of a direct indexed relation */
 std::string DirectRelation::getTypeName() {
     // collect all attributes used in the lex-order
@@ -176,6 +424,10 @@ std::string DirectRelation::getTypeName() {
     std::stringstream res;
     if (hasErase) {
         res << "t_btree_delete_";
+    } else if (isSmall) {
+        res << "t_small_";
+    } else if (isSharded) {
+        res << "t_sharded_";
     } else {
         res << "t_btree_";
     }
@@ -189,6 +441,22 @@ std::string DirectRelation::getTypeName() {
         res << "__" << search;
     }
 
+    res << getNodeSizeSuffix();
+
+    if (isFiltered()) {
+        res << "__filtered";
+    }
+
+    for (std::size_t i = 0; i < getIndices().size(); i++) {
+        if (isOnDemandIndex(i)) {
+            res << "__ondemand_" << i;
+        }
+    }
+
+    if (relation.isLattice()) {
+        res << (isLessThan(relation.getLatticeOp()) ? "__lattice_min" : "__lattice_max");
+    }
+
     return res.str();
 }
 
@@ -243,23 +511,8 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         auto genstruct = [&](std::string name, std::size_t bound) {
             out << "struct " << name << "{\n";
             out << " int operator()(const t_tuple& a, const t_tuple& b) const {\n";
-            out << "  return ";
-            std::function<void(std::size_t)> gencmp = [&](std::size_t i) {
-                std::size_t attrib = ind[i];
-                const auto& typecast = typecasts[attrib];
-
-                out << "(" << typecast << "(a[" << attrib << "]) < " << typecast << "(b[" << attrib
-                    << "])) ? -1 : (" << typecast << "(a[" << attrib << "]) > " << typecast << "(b[" << attrib
-                    << "])) ? 1 :(";
-                if (i + 1 < bound) {
-                    gencmp(i + 1);
-                } else {
-                    out << "0";
-                }
-                out << ")";
-            };
-            gencmp(0);
-            out << ";\n }\n";
+            genThreeWayComparison(out, ind, bound, typecasts, "a[", "b[");
+            out << " }\n";
             out << "bool less(const t_tuple& a, const t_tuple& b) const {\n";
             out << "  return ";
             std::function<void(std::size_t)> genless = [&](std::size_t i) {
@@ -299,7 +552,21 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         // for provenance, all indices must be full so we use btree_set
         // also strong/weak comparators and updater methods
 
-        if (isProvenance) {
+        if (isHashIndex(i)) {
+            // indices only searched for equal values are hashed on their attributes
+            std::string hash = "t_hash_" + std::to_string(i);
+            out << "struct " << hash << "{\n";
+            out << " std::size_t operator()(const t_tuple& t) const {\n";
+            out << "  std::size_t seed = 0;\n";
+            for (auto attrib : ind) {
+                out << "  seed ^= std::hash<RamDomain>()(t[" << attrib
+                    << "]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);\n";
+            }
+            out << "  return seed;\n";
+            out << " }\n";
+            out << "};\n";
+            out << "using t_ind_" << i << " = HashIndex<t_tuple," << hash << "," << comparator << ">;\n";
+        } else if (isProvenance) {
             std::string comparator_aux;
             if (provenanceIndexNumbers.find(i) == provenanceIndexNumbers.end()) {
                 // index for bottom up phase
@@ -309,31 +576,53 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
                 // index for top down phase
                 comparator_aux = comparator;
             }
-            out << "using t_ind_" << i << " = btree_set<t_tuple," << comparator
-                << ",std::allocator<t_tuple>,256,typename "
-                   "souffle::detail::default_strategy<t_tuple>::type,"
+            std::string nodeSize = getNodeSize() == 0 ? "souffle::detail::default_block_size<t_tuple>::value"
+                                                      : std::to_string(getNodeSize());
+            out << "using t_ind_" << i << " = btree_set<t_tuple," << comparator << ",std::allocator<t_tuple>,"
+                << nodeSize << ",typename souffle::detail::default_strategy<t_tuple>::type,"
                 << comparator_aux << ",updater_" << getTypeName() << ">;\n";
+        } else if (isSmall) {
+            // small indexes keep their tuples inline until they outgrow them and move into a b-tree
+            const std::string kind = ind.size() == arity ? "set" : "multiset";
+            out << "using t_ind_" << i << " = small_" << kind << "<t_tuple," << comparator << ",btree_"
+                << kind << "<t_tuple," << comparator << getNodeSizeArguments("t_tuple") << ">>;\n";
+        } else if (isSharded) {
+            // sharded indexes hash their tuples by the first attribute of the index into a b-tree per node
+            const std::string kind = ind.size() == arity ? "set" : "multiset";
+            out << "using t_ind_" << i << " = sharded_set<t_tuple,btree_" << kind << "<t_tuple," << comparator
+                << getNodeSizeArguments("t_tuple") << ">," << ind[0] << ">;\n";
         } else {
             std::string btree_name = "btree";
             if (hasErase) {
                 btree_name = "btree_delete";
             }
             if (ind.size() == arity) {
-                out << "using t_ind_" << i << " = " << btree_name << "_set<t_tuple," << comparator << ">;\n";
+                out << "using t_ind_" << i << " = " << btree_name << "_set<t_tuple," << comparator
+                    << getNodeSizeArguments("t_tuple") << ">;\n";
             } else {
                 // without provenance, some indices may be not full, so we use btree_multiset for those
                 out << "using t_ind_" << i << " = " << btree_name << "_multiset<t_tuple," << comparator
-                    << ">;\n";
+                    << getNodeSizeArguments("t_tuple") << ">;\n";
             }
         }
         out << "t_ind_" << i << " ind_" << i << ";\n";
     }
 
+    // total existence checks of stable relations consult a Bloom filter before the master index
+    if (isFiltered()) {
+        out << "BloomFilter filter;\n";
+    }
+
+    // the indexes built on demand are not maintained on insertion until they are built
+    if (hasOnDemandIndexes()) {
+        out << "bool indexesBuilt = false;\n";
+    }
+
     // typedef master index iterator to be struct iterator
     out << "using iterator = t_ind_" << masterIndex << "::iterator;\n";
 
     // create a struct storing hints for each btree
-    out << "struct context {\n";
+    out << "struct context_hints {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         out << "t_ind_" << i << "::operation_hints hints_" << i << "_lower"
             << ";\n";
@@ -341,7 +630,28 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
             << ";\n";
     }
     out << "};\n";
-    out << "context createContext() { return context(); }\n";
+
+    // the hints of a context are retained by its thread for the next context, unless nodes may be erased
+    const std::string retained = hasErase ? "nullptr" : "&retained";
+    if (!hasErase) {
+        out << "RetainedHints<context_hints> retained;\n";
+    }
+    out << "struct context : context_hints {\n";
+    out << "RetainedHints<context_hints>* owner = nullptr;\n";
+    out << "context() = default;\n";
+    out << "explicit context(RetainedHints<context_hints>* owner) : owner(owner) {\n";
+    out << "if (owner != nullptr) owner->restore(*this);\n";
+    out << "}\n";
+    out << "context(context&& other) : context_hints(other), owner(other.owner) {\n";
+    out << "other.owner = nullptr;\n";
+    out << "}\n";
+    out << "context(const context&) = delete;\n";
+    out << "context& operator=(const context&) = delete;\n";
+    out << "~context() {\n";
+    out << "if (owner != nullptr) owner->retain(*this);\n";
+    out << "}\n";
+    out << "};\n";
+    out << "context createContext() { return context(" << retained << "); }\n";
 
     // erase method
     if (hasErase) {
@@ -356,6 +666,28 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         out << "return true;\n";
         out << "} else return false;\n";
         out << "}\n";  // end of erase(t_tuple&)
+
+        // batches are sorted into the order of each index, which erases them in a single pass
+        out << "template <typename T>\n";
+        out << "void eraseAll(const T& other) {\n";
+        out << "std::vector<t_tuple> tuples(other.begin(), other.end());\n";
+        if (numIndexes > 1) {
+            // the other indexes only erase the tuples of the master index, like erase(t_tuple&)
+            out << "tuples.erase(std::remove_if(tuples.begin(), tuples.end(), [&](const t_tuple& t) { "
+                   "return !ind_"
+                << masterIndex << ".contains(t); }), tuples.end());\n";
+        }
+        for (std::size_t i = 0; i < numIndexes; i++) {
+            if (provenanceIndexNumbers.find(i) == provenanceIndexNumbers.end()) {
+                out << "{\n";
+                out << "t_comparator_" << i << " comparator;\n";
+                out << "std::sort(tuples.begin(), tuples.end(), [&](const t_tuple& a, const t_tuple& b) { "
+                       "return comparator.less(a, b); });\n";
+                out << "ind_" << i << ".eraseAll(tuples.begin(), tuples.end());\n";
+                out << "}\n";
+            }
+        }
+        out << "}\n";  // end of eraseAll(const T&)
     }
 
     // insert methods
@@ -364,15 +696,54 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "return insert(t, h);\n";
     out << "}\n";  // end of insert(t_tuple&)
 
+    // lattice relations replace the tuple with the same key if the inserted tuple is better
+    if (relation.isLattice()) {
+        out << "Lock insert_lock;\n";
+    }
     out << "bool insert(const t_tuple& t, context& h) {\n";
+    if (relation.isLattice()) {
+        std::size_t value = arity - 1;
+        SearchSignature key(arity);
+        for (std::size_t i = 0; i < value; i++) {
+            key[i] = analysis::AttributeConstraint::Equal;
+        }
+        std::string typecast = "ramBitCast<RamSigned>";
+        std::string limit = "RAM_SIGNED";
+        if (types[value][0] == 'f') {
+            typecast = "ramBitCast<RamFloat>";
+            limit = "RAM_FLOAT";
+        } else if (types[value][0] == 'u') {
+            typecast = "ramBitCast<RamUnsigned>";
+            limit = "RAM_UNSIGNED";
+        }
+        const char* better = isLessThan(relation.getLatticeOp()) ? " < " : " > ";
+        out << "auto lease = insert_lock.acquire();\n";
+        out << "t_tuple lower(t);\n";
+        out << "t_tuple upper(t);\n";
+        out << "lower[" << value << "] = ramBitCast<RamDomain>(MIN_" << limit << ");\n";
+        out << "upper[" << value << "] = ramBitCast<RamDomain>(MAX_" << limit << ");\n";
+        out << "auto current = lowerUpperRange_" << key << "(lower, upper, h);\n";
+        out << "if (!current.empty()) {\n";
+        out << "const t_tuple old = *current.begin();\n";
+        out << "if (!(" << typecast << "(t[" << value << "])" << better << typecast << "(old[" << value
+            << "]))) return false;\n";
+        out << "erase(old);\n";
+        out << "}\n";
+    }
     out << "if (ind_" << masterIndex << ".insert(t, h.hints_" << masterIndex << "_lower"
         << ")) {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         if (i != masterIndex && provenanceIndexNumbers.find(i) == provenanceIndexNumbers.end()) {
+            if (isOnDemandIndex(i)) {
+                out << "if (indexesBuilt) ";
+            }
             out << "ind_" << i << ".insert(t, h.hints_" << i << "_lower"
                 << ");\n";
         }
     }
+    if (isFiltered()) {
+        out << "filter.insert(t);\n";
+    }
     out << "return true;\n";
     out << "} else return false;\n";
     out << "}\n";  // end of insert(t_tuple&, context&)
@@ -398,6 +769,9 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
 
     // contains methods
     out << "bool contains(const t_tuple& t, context& h) const {\n";
+    if (isFiltered()) {
+        out << "if (!filter.mayContain(t)) return false;\n";
+    }
     out << "return ind_" << masterIndex << ".contains(t, h.hints_" << masterIndex << "_lower"
         << ");\n";
     out << "}\n";
@@ -407,6 +781,22 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "return contains(t, h);\n";
     out << "}\n";
 
+    // the primary attributes precede the annotations in all provenance indexes, hence the tuple of
+    // given primary attributes is the least one not less than it with the least annotations
+    if (isProvenance) {
+        const std::size_t primaryArity = arity - auxiliaryArity;
+        out << "iterator findPrimary(const t_tuple& t) const {\n";
+        out << "t_tuple low(t);\n";
+        for (std::size_t i = primaryArity; i < arity; i++) {
+            out << "low[" << i << "] = MIN_RAM_SIGNED;\n";
+        }
+        out << "auto pos = ind_" << masterIndex << ".lower_bound(low);\n";
+        out << "if (pos != ind_" << masterIndex << ".end() && std::equal(t.begin(), t.begin() + "
+            << primaryArity << ", (*pos).begin())) return pos;\n";
+        out << "return ind_" << masterIndex << ".end();\n";
+        out << "}\n";
+    }
+
     // size method
     out << "std::size_t size() const {\n";
     out << "return ind_" << masterIndex << ".size();\n";
@@ -424,15 +814,938 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "}\n";
 
     // empty lowerUpperRange method
-    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
-        << "(const t_tuple& /* lower */, const t_tuple& /* upper */, context& /* h */) const "
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */, context& /* h */) const "
+           "{\n";
+
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */) const {\n";
+
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    // lowerUpperRange methods for each pattern which is used to search this relation
+    for (auto search : indexSelection.getSearches()) {
+        auto& lexOrder = indexSelection.getLexOrder(search);
+        std::size_t indNum = indexToNumMap[lexOrder];
+
+        out << "range<t_ind_" << indNum << "::iterator> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
+
+        // count size of search pattern
+        std::size_t eqSize = 0;
+        for (std::size_t column = 0; column < arity; column++) {
+            if (search[column] == analysis::AttributeConstraint::Equal) {
+                eqSize++;
+            }
+        }
+
+        // hash indices are only searched for equal values, i.e., lower and upper agree on the index
+        if (isHashIndex(indNum)) {
+            out << "return ind_" << indNum << ".equal_range(lower, h.hints_" << indNum << "_lower);\n";
+        } else {
+            out << "t_comparator_" << indNum << " comparator;\n";
+            out << "int cmp = comparator(lower, upper);\n";
+
+            // if search signature is full we can apply this specialization
+            if (eqSize == arity) {
+                // use the more efficient find() method if lower == upper
+                out << "if (cmp == 0) {\n";
+                out << "    auto pos = ind_" << indNum << ".find(lower, h.hints_" << indNum << "_lower);\n";
+                out << "    auto fin = ind_" << indNum << ".end();\n";
+                out << "    if (pos != fin) {fin = pos; ++fin;}\n";
+                out << "    return make_range(pos, fin);\n";
+                out << "}\n";
+            }
+            // if lower_bound > upper_bound then we return an empty range
+            out << "if (cmp > 0) {\n";
+            out << "    return make_range(ind_" << indNum << ".end(), ind_" << indNum << ".end());\n";
+            out << "}\n";
+            // otherwise use the general method
+            if (isSharded) {
+                // the bounds are searched in the shard of the first attribute, or in all shards if unbound
+                out << "return ind_" << indNum << ".lower_upper_range(lower, upper, h.hints_" << indNum
+                    << "_lower, h.hints_" << indNum << "_upper);\n";
+            } else {
+                out << "return make_range(ind_" << indNum << ".lower_bound(lower, h.hints_" << indNum
+                    << "_lower), ind_" << indNum << ".upper_bound(upper, h.hints_" << indNum << "_upper));\n";
+            }
+        }
+
+        out << "}\n";
+
+        out << "range<t_ind_" << indNum << "::iterator> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper) const {\n";
+
+        out << "context h;\n";
+        out << "return lowerUpperRange_" << search << "(lower,upper,h);\n";
+        out << "}\n";
+
+        // load the leaf a search would start in ahead of the search; hash indices are not prefetched
+        if (isHashIndex(indNum)) {
+            out << "void prefetch_" << search << "(const t_tuple& /* lower */) const {}\n";
+        } else {
+            out << "void prefetch_" << search << "(const t_tuple& lower) const {\n";
+            out << "ind_" << indNum << ".prefetch(lower);\n";
+            out << "}\n";
+        }
+
+        // count the elements of the range, by the subtree sizes of the b-tree if it supports it
+        out << "std::size_t countRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
+        if (isHashIndex(indNum) || hasErase) {
+            out << "auto r = lowerUpperRange_" << search << "(lower, upper, h);\n";
+            out << "return std::distance(r.begin(), r.end());\n";
+        } else {
+            out << "t_comparator_" << indNum << " comparator;\n";
+            out << "if (comparator(lower, upper) > 0) {\n";
+            out << "    return 0;\n";
+            out << "}\n";
+            out << "return ind_" << indNum << ".countRange(lower, upper);\n";
+        }
+        out << "}\n";
+    }
+
+    // empty method
+    out << "bool empty() const {\n";
+    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "}\n";
+
+    // partition method for parallelism
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "return ind_" << masterIndex << ".getChunks(400);\n";
+    out << "}\n";
+
+    // the chunks of the master index grouped by the node of their shard, see providesNodePartition
+    if (isSharded) {
+        out << "std::unique_ptr<t_ind_" << masterIndex << "::node_chunks> partitionByNode() const {\n";
+        out << "return ind_" << masterIndex << ".getNodeChunks(400);\n";
+        out << "}\n";
+    }
+
+    // purge method
+    out << "void purge() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".clear();\n";
+    }
+    if (isFiltered()) {
+        out << "filter.clear();\n";
+    }
+    if (hasOnDemandIndexes()) {
+        out << "indexesBuilt = false;\n";
+    }
+    if (!hasErase) {
+        out << "retained.invalidate();\n";
+    }
+    out << "}\n";
+
+    // buildIndexes method, building the indexes not maintained on insertion, one index per thread
+    if (hasOnDemandIndexes()) {
+        std::vector<std::size_t> onDemand;
+        for (std::size_t i = 0; i < numIndexes; i++) {
+            if (isOnDemandIndex(i)) {
+                onDemand.push_back(i);
+            }
+        }
+        out << "void buildIndexes() {\n";
+        out << "if (indexesBuilt) return;\n";
+        out << "const std::vector<t_tuple> tuples(ind_" << masterIndex << ".begin(), ind_" << masterIndex
+            << ".end());\n";
+        out << "PARALLEL_START\n";
+        out << "pfor(std::size_t i = 0; i < " << onDemand.size() << "; ++i) {\n";
+        out << "switch (i) {\n";
+        for (std::size_t k = 0; k < onDemand.size(); k++) {
+            const std::size_t i = onDemand[k];
+            out << "case " << k << ": {\n";
+            if (isHashIndex(i)) {
+                out << "for (const auto& t : tuples) ind_" << i << ".insert(t);\n";
+            } else {
+                // b-trees are built bottom-up from the tuples sorted into their order
+                out << "std::vector<t_tuple> sorted(tuples);\n";
+                out << "t_comparator_" << i << " comparator;\n";
+                out << "std::sort(sorted.begin(), sorted.end(), [&](const t_tuple& a, const t_tuple& b) { "
+                       "return comparator.less(a, b); });\n";
+                out << "auto loaded = t_ind_" << i << "::load(sorted.begin(), sorted.end());\n";
+                out << "ind_" << i << ".swap(loaded);\n";
+            }
+            out << "break;\n";
+            out << "}\n";
+        }
+        out << "}\n";  // end of switch
+        out << "}\n";  // end of pfor
+        out << "PARALLEL_END\n";
+        out << "indexesBuilt = true;\n";
+        out << "}\n";
+    }
+
+    // place method, storing the shards in the memory of their nodes once the stratum computing the
+    // relation completes
+    if (isSharded) {
+        out << "void place() {\n";
+        for (std::size_t i = 0; i < numIndexes; i++) {
+            out << "ind_" << i << ".place();\n";
+        }
+        out << "retained.invalidate();\n";
+        out << "}\n";
+    }
+
+    // freeze method, once the stratum computing the relation completes
+    if (isFreezable()) {
+        out << "void freeze() const {\n";
+        for (std::size_t i = 0; i < numIndexes; i++) {
+            if (!isHashIndex(i)) {
+                out << "ind_" << i << ".freeze();\n";
+            }
+        }
+        out << "}\n";
+    }
+
+    // buildFilter method, filling the filter once the stratum computing the relation completes
+    if (isFiltered()) {
+        out << "void buildFilter() {\n";
+        out << "filter.reset(size());\n";
+        out << "for (const auto& t : ind_" << masterIndex << ") {\n";
+        out << "filter.insert(t);\n";
+        out << "}\n";
+        out << "}\n";
+    }
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return ind_" << masterIndex << ".end();\n";
+    out << "}\n";
+
+    // the spans of tuples stored consecutively in the master index, see providesSpans
+    if (!hasErase && !isSmall && !isSharded) {
+        out << "template <typename Op>\n";
+        out << "void forEachSpan(Op&& op) const {\n";
+        out << "ind_" << masterIndex << ".forEachSpan(std::forward<Op>(op));\n";
+        out << "}\n";
+    }
+
+    // compact method
+    out << "void compact() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        if (!isHashIndex(i)) {
+            out << "ind_" << i << ".compact();\n";
+        }
+    }
+    if (!hasErase) {
+        out << "retained.invalidate();\n";
+    }
+    out << "}\n";
+
+    // copyIndex method
+    if (!provenanceIndexNumbers.empty()) {
+        out << "void copyIndex() {\n";
+        out << "for (auto const &cur : ind_" << masterIndex << ") {\n";
+        for (auto const i : provenanceIndexNumbers) {
+            out << "ind_" << i << ".insert(cur);\n";
+        }
+        out << "}\n";
+        out << "}\n";
+    }
+
+    // printStatistics method
+    out << "void printStatistics(std::ostream& o) const {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "o << \" arity " << arity << " direct "
+            << (isHashIndex(i) ? "hash" : (isSmall ? "small" : (isSharded ? "sharded" : "b-tree")))
+            << " index " << i << " lex-order " << inds[i] << "\\n\";\n";
+        out << "ind_" << i << ".printStats(o);\n";
+    }
+    out << "}\n";
+
+    // end struct
+    out << "};\n";
+}  // namespace souffle
+
+// -------- Packed B-Tree Relation --------
+
+bool PackedRelation::isPackable(
+        const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection) {
+    // only relations otherwise stored in direct b-trees
+    const auto representation = ramRel.getRepresentation();
+    const bool isDirect = representation == RelationRepresentation::BTREE ||
+                          ((representation == RelationRepresentation::DEFAULT ||
+                                   (representation == RelationRepresentation::VECTOR &&
+                                           !VectorRelation::isScanOnly(indexSelection))) &&
+                                  ramRel.getArity() <= 6);
+    if (!isDirect || ramRel.isNullary() || ramRel.isLattice() || ramRel.getAuxiliaryArity() > 0) {
+        return false;
+    }
+    // the bounds of searches for floats are not packed
+    const auto& types = ramRel.getAttributeTypes();
+    if (std::any_of(types.begin(), types.end(), [](const auto& type) { return type[0] == 'f'; })) {
+        return false;
+    }
+
+    // the fields of packed tuples are aligned to the widest of them
+    std::size_t size = 0;
+    std::size_t alignment = 1;
+    for (const auto* type : getNarrowTypes(ramRel, indexSelection)) {
+        const std::size_t fieldSize = type != nullptr ? type->size : sizeof(RamDomain);
+        size += fieldSize;
+        alignment = std::max(alignment, fieldSize);
+    }
+    size = (size + alignment - 1) / alignment * alignment;
+    return size < ramRel.getArity() * sizeof(RamDomain);
+}
+
+void PackedRelation::computeIndices() {
+    auto inds = indexSelection.getAllOrders();
+    assert(!inds.empty() && "no full index in relation");
+
+    for (std::size_t i = 0; i < inds.size(); i++) {
+        if (inds[i].size() == getArity()) {
+            masterIndex = i;
+            break;
+        }
+    }
+    assert(masterIndex < inds.size() && "no full index in relation");
+    computedIndices = inds;
+}
+
+/** Generate type name of a packed b-tree relation */
+std::string PackedRelation::getTypeName() {
+    std::unordered_set<uint32_t> attributesUsed;
+    for (auto& ind : getIndices()) {
+        for (auto& attr : ind) {
+            attributesUsed.insert(attr);
+        }
+    }
+
+    std::stringstream res;
+    res << "t_packed_" << getTypeAttributeString(relation.getAttributeTypes(), attributesUsed);
+
+    for (auto& ind : getIndices()) {
+        res << "__" << join(ind, "_");
+    }
+
+    for (auto& search : indexSelection.getSearches()) {
+        res << "__" << search;
+    }
+
+    res << getNodeSizeSuffix();
+
+    // the storage type of each attribute, e.g., __uint8_t_RamDomain
+    res << "__" << join(getNarrowTypes(relation, indexSelection), "_", [](auto& out, const auto* type) {
+        out << (type != nullptr ? type->name : "RamDomain");
+    });
+
+    return res.str();
+}
+
+/** Generate type struct of a packed b-tree relation */
+void PackedRelation::generateTypeStruct(std::ostream& out) {
+    std::size_t arity = getArity();
+    const auto& inds = getIndices();
+    auto types = relation.getAttributeTypes();
+    const auto narrow = getNarrowTypes(relation, indexSelection);
+    std::size_t numIndexes = inds.size();
+    std::map<LexOrder, int> indexToNumMap;
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+    out << "static constexpr Relation::arity_type Arity = " << arity << ";\n";
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+
+    // stored tuple type, whose fields are ordered from the widest to the narrowest to avoid padding
+    std::vector<std::size_t> fields(arity);
+    std::iota(fields.begin(), fields.end(), 0);
+    std::stable_sort(fields.begin(), fields.end(), [&](std::size_t a, std::size_t b) {
+        auto size = [&](std::size_t i) { return narrow[i] != nullptr ? narrow[i]->size : sizeof(RamDomain); };
+        return size(a) > size(b);
+    });
+    out << "struct t_packed {\n";
+    for (auto i : fields) {
+        out << (narrow[i] != nullptr ? narrow[i]->name : "RamDomain") << " a" << i << ";\n";
+    }
+    out << "};\n";
+
+    // the tuples of the iterators are widened from the stored tuples
+    out << "struct t_unpack {\n";
+    out << "t_tuple operator()(const t_packed& p) const {\n";
+    out << "t_tuple t;\n";
+    for (std::size_t i = 0; i < arity; i++) {
+        out << "t[" << i << "] = static_cast<RamDomain>(p.a" << i << ");\n";
+    }
+    out << "return t;\n";
+    out << "}\n";
+    out << "};\n";
+
+    std::vector<std::string> typecasts;
+    typecasts.reserve(types.size());
+    for (auto type : types) {
+        switch (type[0]) {
+            case 'u': typecasts.push_back("ramBitCast<RamUnsigned>"); break;
+            default: typecasts.push_back("ramBitCast<RamSigned>");
+        }
+    }
+
+    // packed attributes are compared as they are, since their types order their values as the attributes
+    auto field = [&](const std::string& tuple, std::size_t attrib) {
+        const std::string value = tuple + ".a" + std::to_string(attrib);
+        return narrow[attrib] != nullptr ? value : typecasts[attrib] + "(" + value + ")";
+    };
+
+    // the least and greatest value of the field of an attribute in the order of the indexes
+    auto limit = [&](std::size_t attrib, bool greatest) -> std::string {
+        if (narrow[attrib] != nullptr) {
+            return std::to_string(greatest ? narrow[attrib]->greatest : narrow[attrib]->least);
+        }
+        if (types[attrib][0] == 'u') {
+            return greatest ? "ramBitCast<RamDomain>(MAX_RAM_UNSIGNED)" : "0";
+        }
+        return greatest ? "MAX_RAM_SIGNED" : "MIN_RAM_SIGNED";
+    };
+
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        const auto& ind = inds[i];
+
+        if (i < indexSelection.getAllOrders().size()) {
+            indexToNumMap[indexSelection.getAllOrders()[i]] = i;
+        }
+
+        std::string comparator = "t_comparator_" + std::to_string(i);
+        out << "struct " << comparator << "{\n";
+        out << " int operator()(const t_packed& a, const t_packed& b) const {\n";
+        genThreeWayComparison(out, ind, ind.size(), field, "a", "b");
+        out << " }\n";
+        out << "bool less(const t_packed& a, const t_packed& b) const {\n";
+        out << "  return ";
+        std::function<void(std::size_t)> genless = [&](std::size_t i) {
+            std::size_t attrib = ind[i];
+            out << "(" << field("a", attrib) << " < " << field("b", attrib) << ")";
+            if (i + 1 < ind.size()) {
+                out << "|| (" << field("a", attrib) << " == " << field("b", attrib) << ") && (";
+                genless(i + 1);
+                out << ")";
+            }
+        };
+        genless(0);
+        out << ";\n }\n";
+        out << "bool equal(const t_packed& a, const t_packed& b) const {\n";
+        out << "return ";
+        std::function<void(std::size_t)> geneq = [&](std::size_t i) {
+            std::size_t attrib = ind[i];
+            out << "(" << field("a", attrib) << " == " << field("b", attrib) << ")";
+            if (i + 1 < ind.size()) {
+                out << "&&";
+                geneq(i + 1);
+            }
+        };
+        geneq(0);
+        out << ";\n }\n";
+        out << "};\n";
+
+        // the bounds of searches are compared before they are packed
+        out << "struct t_order_" << i << "{\n";
+        out << " int operator()(const t_tuple& a, const t_tuple& b) const {\n";
+        genThreeWayComparison(out, ind, ind.size(), typecasts, "a[", "b[");
+        out << " }\n";
+        out << "};\n";
+
+        // Pack a bound of a search on the index, returning 0 if it fits into the fields. Otherwise, the
+        // fields from its first attribute out of bounds on are the least (greatest) values, and -1 (1)
+        // is returned since the bound is less (greater) than any stored tuple with the packed prefix.
+        out << "static int packBound_" << i << "(const t_tuple& t, t_packed& p) {\n";
+        auto fill = [&](std::size_t from, bool greatest) {
+            for (std::size_t k = from; k < ind.size(); k++) {
+                out << "p.a" << ind[k] << " = " << limit(ind[k], greatest) << ";\n";
+            }
+        };
+        for (std::size_t k = 0; k < ind.size(); k++) {
+            const std::size_t attrib = ind[k];
+            if (narrow[attrib] != nullptr) {
+                const std::string value = typecasts[attrib] + "(t[" + std::to_string(attrib) + "])";
+                if (types[attrib][0] != 'u' || narrow[attrib]->least != 0) {
+                    out << "if (" << value << " < " << narrow[attrib]->least << ") {\n";
+                    fill(k, false);
+                    out << "return -1;\n";
+                    out << "}\n";
+                }
+                out << "if (" << value << " > " << narrow[attrib]->greatest << ") {\n";
+                fill(k, true);
+                out << "return 1;\n";
+                out << "}\n";
+            }
+            out << "p.a" << attrib << " = static_cast<" << (narrow[attrib] != nullptr ? narrow[attrib]->name
+                                                                                  : "RamDomain")
+                << ">(t[" << attrib << "]);\n";
+        }
+        out << "return 0;\n";
+        out << "}\n";
+
+        if (ind.size() == arity) {
+            out << "using t_ind_" << i << " = btree_set<t_packed," << comparator
+                << getNodeSizeArguments("t_packed") << ">;\n";
+        } else {
+            out << "using t_ind_" << i << " = btree_multiset<t_packed," << comparator
+                << getNodeSizeArguments("t_packed") << ">;\n";
+        }
+        out << "t_ind_" << i << " ind_" << i << ";\n";
+        out << "using iterator_" << i << " = TransformIterator<t_ind_" << i << "::iterator, t_unpack>;\n";
+    }
+    out << "using iterator = iterator_" << masterIndex << ";\n";
+
+    // Create a struct storing the context hints for each index
+    out << "struct context {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "t_ind_" << i << "::operation_hints hints_" << i << "_lower;\n";
+        out << "t_ind_" << i << "::operation_hints hints_" << i << "_upper;\n";
+    }
+    out << "};\n";
+    out << "context createContext() { return context(); }\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "context h;\n";
+    out << "return insert(t, h);\n";
+    out << "}\n";
+
+    // the bounds hold for all tuples the program inserts; others are rejected rather than truncated, which
+    // only tuples inserted through the interface of an executable may be, see --narrow-columns
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "t_packed p{};\n";
+    out << "if (packBound_" << masterIndex << "(t, p) != 0) {\n";
+    out << "fatal(\"value out of the bounds of the packed attributes of relation " << relation.getName()
+        << "\");\n";
+    out << "}\n";
+    out << "if (ind_" << masterIndex << ".insert(p, h.hints_" << masterIndex << "_lower)) {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        if (i != masterIndex) {
+            out << "ind_" << i << ".insert(p, h.hints_" << i << "_lower);\n";
+        }
+    }
+    out << "return true;\n";
+    out << "} else return false;\n";
+    out << "}\n";
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "context h;\n";
+    out << "return insert(tuple, h);\n";
+    out << "}\n";
+
+    std::vector<std::string> decls;
+    std::vector<std::string> params;
+    for (std::size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";
+
+    // contains methods; tuples out of bounds are not stored
+    out << "bool contains(const t_tuple& t, context& h) const {\n";
+    out << "t_packed p{};\n";
+    out << "return packBound_" << masterIndex << "(t, p) == 0 && ind_" << masterIndex
+        << ".contains(p, h.hints_" << masterIndex << "_lower);\n";
+    out << "}\n";
+
+    out << "bool contains(const t_tuple& t) const {\n";
+    out << "context h;\n";
+    out << "return contains(t, h);\n";
+    out << "}\n";
+
+    // size method
+    out << "std::size_t size() const {\n";
+    out << "return ind_" << masterIndex << ".size();\n";
+    out << "}\n";
+
+    // empty lowerUpperRange method
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */, context& /* h */) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(), ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */) const {\n";
+    out << "return range<iterator>(ind_" << masterIndex << ".begin(), ind_" << masterIndex << ".end());\n";
+    out << "}\n";
+
+    // lowerUpperRange methods for each pattern which is used to search this relation
+    for (auto search : indexSelection.getSearches()) {
+        auto& lexOrder = indexSelection.getLexOrder(search);
+        std::size_t indNum = indexToNumMap[lexOrder];
+        const std::string num = std::to_string(indNum);
+        const std::string iter = "iterator_" + num;
+        const std::string index = "ind_" + num;
+
+        // the range of the b-tree from the first stored tuple not less than the lower bound to the first
+        // one greater than the upper bound, where a packed bound less (greater) than its bound excludes
+        // (includes) the stored tuples equal to it
+        auto genBounds = [&]() {
+            out << "t_packed packedLower{};\n";
+            out << "t_packed packedUpper{};\n";
+            out << "const int lowerFit = packBound_" << num << "(lower, packedLower);\n";
+            out << "const int upperFit = packBound_" << num << "(upper, packedUpper);\n";
+            out << "auto begin = lowerFit > 0 ? " << index << ".upper_bound(packedLower, h.hints_" << num
+                << "_lower) : " << index << ".lower_bound(packedLower, h.hints_" << num << "_lower);\n";
+            out << "auto end = upperFit < 0 ? " << index << ".lower_bound(packedUpper, h.hints_" << num
+                << "_upper) : " << index << ".upper_bound(packedUpper, h.hints_" << num << "_upper);\n";
+        };
+
+        // count size of search pattern
+        std::size_t eqSize = 0;
+        for (std::size_t column = 0; column < arity; column++) {
+            if (search[column] == analysis::AttributeConstraint::Equal) {
+                eqSize++;
+            }
+        }
+
+        out << "range<" << iter << "> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
+        out << "int cmp = t_order_" << num << "{}(lower, upper);\n";
+
+        // use the more efficient find() method if the search pattern is full
+        if (eqSize == arity) {
+            out << "if (cmp == 0) {\n";
+            out << "    t_packed p{};\n";
+            out << "    if (packBound_" << num << "(lower, p) != 0) {\n";
+            out << "        return range<" << iter << ">(" << index << ".end(), " << index << ".end());\n";
+            out << "    }\n";
+            out << "    auto pos = " << index << ".find(p, h.hints_" << num << "_lower);\n";
+            out << "    auto fin = " << index << ".end();\n";
+            out << "    if (pos != fin) {fin = pos; ++fin;}\n";
+            out << "    return range<" << iter << ">(pos, fin);\n";
+            out << "}\n";
+        }
+        // if lower > upper then we have an empty range
+        out << "if (cmp > 0) {\n";
+        out << "    return range<" << iter << ">(" << index << ".end(), " << index << ".end());\n";
+        out << "}\n";
+
+        // otherwise do the default method
+        genBounds();
+        out << "return range<" << iter << ">(begin, end);\n";
+        out << "}\n";
+
+        out << "range<" << iter << "> lowerUpperRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper) const {\n";
+        out << "context h;\n";
+        out << "return lowerUpperRange_" << search << "(lower, upper, h);\n";
+        out << "}\n";
+
+        // load the leaf a search would start in ahead of the search
+        out << "void prefetch_" << search << "(const t_tuple& lower) const {\n";
+        out << "t_packed p{};\n";
+        out << "packBound_" << num << "(lower, p);\n";
+        out << index << ".prefetch(p);\n";
+        out << "}\n";
+
+        // count the elements of the range, by the subtree sizes of the b-tree if both bounds fit
+        out << "std::size_t countRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
+        out << "if (t_order_" << num << "{}(lower, upper) > 0) {\n";
+        out << "    return 0;\n";
+        out << "}\n";
+        genBounds();
+        out << "if (lowerFit == 0 && upperFit == 0) {\n";
+        out << "    return " << index << ".countRange(packedLower, packedUpper);\n";
+        out << "}\n";
+        out << "std::size_t count = 0;\n";
+        out << "for (; begin != end; ++begin) ++count;\n";
+        out << "return count;\n";
+        out << "}\n";
+    }
+
+    // empty method
+    out << "bool empty() const {\n";
+    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "}\n";
+
+    // partition method for parallelism
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "std::vector<range<iterator>> res;\n";
+    out << "for (const auto& chunk : ind_" << masterIndex << ".getChunks(400)) {\n";
+    out << "res.push_back(range<iterator>(chunk.begin(), chunk.end()));\n";
+    out << "}\n";
+    out << "return res;\n";
+    out << "}\n";
+
+    // purge method
+    out << "void purge() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".clear();\n";
+    }
+    out << "}\n";
+
+    // freeze method, once the stratum computing the relation completes
+    out << "void freeze() const {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".freeze();\n";
+    }
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return ind_" << masterIndex << ".end();\n";
+    out << "}\n";
+
+    // compact method
+    out << "void compact() {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "ind_" << i << ".compact();\n";
+    }
+    out << "}\n";
+
+    // printStatistics method
+    out << "void printStatistics(std::ostream& o) const {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "o << \" arity " << arity << " packed b-tree index " << i << " lex-order " << inds[i]
+            << "\\n\";\n";
+        out << "ind_" << i << ".printStats(o);\n";
+    }
+    out << "}\n";
+
+    // end struct
+    out << "};\n";
+}
+
+// -------- Indirect Indexed B-Tree Relation --------
+
+/** Generate index set for a indirect indexed relation */
+void IndirectRelation::computeIndices() {
+    assert(!isProvenance && "indirect indexes cannot used for provenance");
+
+    // Generate and set indices
+    auto inds = indexSelection.getAllOrders();
+
+    // generate a full index if no indices exist
+    assert(!inds.empty() && "no full index in relation");
+
+    // check for full index
+    for (std::size_t i = 0; i < inds.size(); i++) {
+        auto& ind = inds[i];
+        if (ind.size() == getArity()) {
+            masterIndex = i;
+            break;
+        }
+    }
+    assert(masterIndex < inds.size() && "no full index in relation");
+    computedIndices = inds;
+}
+
+/** Generate type name of a indirect indexed relation */
+std::string IndirectRelation::getTypeName() {
+    // collect all attributes used in the lex-order
+    std::unordered_set<uint32_t> attributesUsed;
+    for (auto& ind : getIndices()) {
+        for (auto& attr : ind) {
+            attributesUsed.insert(attr);
+        }
+    }
+
+    std::stringstream res;
+    res << "t_btree_" << getTypeAttributeString(relation.getAttributeTypes(), attributesUsed);
+
+    for (auto& ind : getIndices()) {
+        res << "__" << join(ind, "_");
+    }
+
+    for (auto& search : indexSelection.getSearches()) {
+        res << "__" << search;
+    }
+
+    res << getNodeSizeSuffix();
+
+    return res.str();
+}
+
+/** Generate type struct of a indirect indexed relation */
+void IndirectRelation::generateTypeStruct(std::ostream& out) {
+    std::size_t arity = getArity();
+    const auto& inds = getIndices();
+    auto types = relation.getAttributeTypes();
+    std::size_t numIndexes = inds.size();
+    std::map<LexOrder, int> indexToNumMap;
+
+    // struct definition
+    out << "struct " << getTypeName() << " {\n";
+    out << "static constexpr Relation::arity_type Arity = " << arity << ";\n";
+
+    // stored tuple type
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+
+    // table and lock required for storing actual data for indirect indices
+    out << "Table<t_tuple> dataTable;\n";
+    out << "Lock insert_lock;\n";
+
+    // btree types
+    for (std::size_t i = 0; i < inds.size(); i++) {
+        auto ind = inds[i];
+
+        if (i < indexSelection.getAllOrders().size()) {
+            indexToNumMap[indexSelection.getAllOrders()[i]] = i;
+        }
+
+        std::vector<std::string> typecasts;
+        typecasts.reserve(types.size());
+
+        for (auto type : types) {
+            switch (type[0]) {
+                case 'f': typecasts.push_back("ramBitCast<RamFloat>"); break;
+                case 'u': typecasts.push_back("ramBitCast<RamUnsigned>"); break;
+                default: typecasts.push_back("ramBitCast<RamSigned>");
+            }
+        }
+
+        std::string comparator = "t_comparator_" + std::to_string(i);
+
+        out << "struct " << comparator << "{\n";
+        out << " int operator()(const t_tuple *a, const t_tuple *b) const {\n";
+        genThreeWayComparison(out, ind, ind.size(), typecasts, "(*a)[", "(*b)[");
+        out << " }\n";
+        out << "bool less(const t_tuple *a, const t_tuple *b) const {\n";
+        out << "  return ";
+        std::function<void(std::size_t)> genless = [&](std::size_t i) {
+            std::size_t attrib = ind[i];
+            const auto& typecast = typecasts[attrib];
+            out << typecast << " ((*a)[" << attrib << "]) < " << typecast << "((*b)[" << attrib << "])";
+            if (i + 1 < ind.size()) {
+                out << "|| (" << typecast << "((*a)[" << attrib << "]) == " << typecast << "((*b)[" << attrib
+                    << "]) && (";
+                genless(i + 1);
+                out << "))";
+            }
+        };
+        genless(0);
+        out << ";\n }\n";
+        out << "bool equal(const t_tuple *a, const t_tuple *b) const {\n";
+        out << "return ";
+        std::function<void(std::size_t)> geneq = [&](std::size_t i) {
+            std::size_t attrib = ind[i];
+            const auto& typecast = typecasts[attrib];
+            out << typecast << "((*a)[" << attrib << "]) == " << typecast << "((*b)[" << attrib << "])";
+            if (i + 1 < ind.size()) {
+                out << "&&";
+                geneq(i + 1);
+            }
+        };
+        geneq(0);
+        out << ";\n }\n";
+        out << "};\n";
+
+        if (ind.size() == arity) {
+            out << "using t_ind_" << i << " = btree_set<const t_tuple*," << comparator
+                << getNodeSizeArguments("const t_tuple*") << ">;\n";
+        } else {
+            out << "using t_ind_" << i << " = btree_multiset<const t_tuple*," << comparator
+                << getNodeSizeArguments("const t_tuple*") << ">;\n";
+        }
+
+        out << "t_ind_" << i << " ind_" << i << ";\n";
+    }
+
+    // typedef deref iterators
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "using iterator_" << i << " = IterDerefWrapper<typename t_ind_" << i << "::iterator>;\n";
+    }
+    out << "using iterator = iterator_" << masterIndex << ";\n";
+
+    // Create a struct storing the context hints for each index
+    out << "struct context {\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        out << "t_ind_" << i << "::operation_hints hints_" << i << "_lower;\n";
+        out << "t_ind_" << i << "::operation_hints hints_" << i << "_upper;\n";
+    }
+    out << "};\n";
+    out << "context createContext() { return context(); }\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "context h;\n";
+    out << "return insert(t, h);\n";
+    out << "}\n";
+
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "const t_tuple* masterCopy = nullptr;\n";
+    out << "{\n";
+    out << "auto lease = insert_lock.acquire();\n";
+    out << "if (contains(t, h)) return false;\n";
+    out << "masterCopy = &dataTable.insert(t);\n";
+    out << "ind_" << masterIndex << ".insert(masterCopy, h.hints_" << masterIndex << "_lower);\n";
+    out << "}\n";
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        if (i != masterIndex) {
+            out << "ind_" << i << ".insert(masterCopy, h.hints_" << i << "_lower"
+                << ");\n";
+        }
+    }
+    out << "return true;\n";
+    out << "}\n";
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
+    out << "context h;\n";
+    out << "return insert(tuple, h);\n";
+    out << "}\n";  // end of insert(RamDomain*)
+
+    std::vector<std::string> decls;
+    std::vector<std::string> params;
+    for (std::size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
+
+    // contains methods
+    out << "bool contains(const t_tuple& t, context& h) const {\n";
+    out << "return ind_" << masterIndex << ".contains(&t, h.hints_" << masterIndex << "_lower"
+        << ");\n";
+    out << "}\n";
+
+    out << "bool contains(const t_tuple& t) const {\n";
+    out << "context h;\n";
+    out << "return contains(t, h);\n";
+    out << "}\n";
+
+    // size method
+    out << "std::size_t size() const {\n";
+    out << "return ind_" << masterIndex << ".size();\n";
+    out << "}\n";
+
+    // find methods
+    out << "iterator find(const t_tuple& t, context& h) const {\n";
+    out << "return ind_" << masterIndex << ".find(&t, h.hints_" << masterIndex << "_lower"
+        << ");\n";
+    out << "}\n";
+
+    out << "iterator find(const t_tuple& t) const {\n";
+    out << "context h;\n";
+    out << "return find(t, h);\n";
+    out << "}\n";
+
+    // empty lowerUpperRange method
+    out << "range<iterator> lowerUpperRange_0(const t_tuple& lower, const t_tuple& upper, context& h) const "
            "{\n";
 
     out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
     out << "}\n";
 
-    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
-        << "(const t_tuple& /* lower */, const t_tuple& /* upper */) const {\n";
+    out << "range<iterator> lowerUpperRange_0(const t_tuple& lower, const t_tuple& upper) const {\n";
 
     out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
     out << "}\n";
@@ -442,7 +1755,7 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         auto& lexOrder = indexSelection.getLexOrder(search);
         std::size_t indNum = indexToNumMap[lexOrder];
 
-        out << "range<t_ind_" << indNum << "::iterator> lowerUpperRange_" << search;
+        out << "range<iterator_" << indNum << "> lowerUpperRange_" << search;
         out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
 
         // count size of search pattern
@@ -454,34 +1767,47 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
         }
 
         out << "t_comparator_" << indNum << " comparator;\n";
-        out << "int cmp = comparator(lower, upper);\n";
+        out << "int cmp = comparator(&lower, &upper);\n";
 
-        // if search signature is full we can apply this specialization
+        // use the more efficient find() method if the search pattern is full
         if (eqSize == arity) {
-            // use the more efficient find() method if lower == upper
+            // if lower == upper we can just do a find
             out << "if (cmp == 0) {\n";
-            out << "    auto pos = ind_" << indNum << ".find(lower, h.hints_" << indNum << "_lower);\n";
+            out << "    auto pos = ind_" << indNum << ".find(&lower, h.hints_" << indNum << "_lower);\n";
             out << "    auto fin = ind_" << indNum << ".end();\n";
             out << "    if (pos != fin) {fin = pos; ++fin;}\n";
-            out << "    return make_range(pos, fin);\n";
+            out << "    return range<iterator_" << indNum << ">(pos, fin);\n";
             out << "}\n";
         }
-        // if lower_bound > upper_bound then we return an empty range
+        // if lower > upper then we have an empty range
         out << "if (cmp > 0) {\n";
-        out << "    return make_range(ind_" << indNum << ".end(), ind_" << indNum << ".end());\n";
+        out << "    return range<iterator_" << indNum << ">(ind_" << indNum << ".end(), ind_" << indNum
+            << ".end());\n";
         out << "}\n";
-        // otherwise use the general method
-        out << "return make_range(ind_" << indNum << ".lower_bound(lower, h.hints_" << indNum << "_lower"
-            << "), ind_" << indNum << ".upper_bound(upper, h.hints_" << indNum << "_upper"
+
+        // otherwise do the default method
+        out << "return range<iterator_" << indNum << ">(ind_" << indNum << ".lower_bound(&lower, h.hints_"
+            << indNum << "_lower"
+            << "), ind_" << indNum << ".upper_bound(&upper, h.hints_" << indNum << "_upper"
             << "));\n";
 
         out << "}\n";
 
-        out << "range<t_ind_" << indNum << "::iterator> lowerUpperRange_" << search;
+        out << "range<iterator_" << indNum << "> lowerUpperRange_" << search;
         out << "(const t_tuple& lower, const t_tuple& upper) const {\n";
 
         out << "context h;\n";
-        out << "return lowerUpperRange_" << search << "(lower,upper,h);\n";
+        out << "return lowerUpperRange_" << search << "(lower, upper, h);\n";
+        out << "}\n";
+
+        // count the elements of the range by the subtree sizes of the b-tree
+        out << "std::size_t countRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& /* h */) const {\n";
+        out << "t_comparator_" << indNum << " comparator;\n";
+        out << "if (comparator(&lower, &upper) > 0) {\n";
+        out << "    return 0;\n";
+        out << "}\n";
+        out << "return ind_" << indNum << ".countRange(&lower, &upper);\n";
         out << "}\n";
     }
 
@@ -490,9 +1816,13 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "return ind_" << masterIndex << ".empty();\n";
     out << "}\n";
 
-    // partition method for parallelism
+    // partition method
     out << "std::vector<range<iterator>> partition() const {\n";
-    out << "return ind_" << masterIndex << ".getChunks(400);\n";
+    out << "std::vector<range<iterator>> res;\n";
+    out << "for (const auto& cur : ind_" << masterIndex << ".getChunks(400)) {\n";
+    out << "    res.push_back(make_range(derefIter(cur.begin()), derefIter(cur.end())));\n";
+    out << "}\n";
+    out << "return res;\n";
     out << "}\n";
 
     // purge method
@@ -500,6 +1830,7 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     for (std::size_t i = 0; i < numIndexes; i++) {
         out << "ind_" << i << ".clear();\n";
     }
+    out << "dataTable.clear();\n";
     out << "}\n";
 
     // begin and end iterators
@@ -511,21 +1842,10 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
     out << "return ind_" << masterIndex << ".end();\n";
     out << "}\n";
 
-    // copyIndex method
-    if (!provenanceIndexNumbers.empty()) {
-        out << "void copyIndex() {\n";
-        out << "for (auto const &cur : ind_" << masterIndex << ") {\n";
-        for (auto const i : provenanceIndexNumbers) {
-            out << "ind_" << i << ".insert(cur);\n";
-        }
-        out << "}\n";
-        out << "}\n";
-    }
-
     // printStatistics method
     out << "void printStatistics(std::ostream& o) const {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
-        out << "o << \" arity " << arity << " direct b-tree index " << i << " lex-order " << inds[i]
+        out << "o << \" arity " << arity << " indirect b-tree index " << i << " lex-order " << inds[i]
             << "\\n\";\n";
         out << "ind_" << i << ".printStats(o);\n";
     }
@@ -533,24 +1853,20 @@ void DirectRelation::generateTypeStruct(std::ostream& out) {
 
     // end struct
     out << "};\n";
-}  // namespace souffle
+}
 
-// -------- Indirect Indexed B-Tree Relation --------
+// -------- Columnar Relation --------
 
-/** Generate index set for a indirect indexed relation */
-void IndirectRelation::computeIndices() {
-    assert(!isProvenance && "indirect indexes cannot used for provenance");
+/** Generate index set for a columnar relation */
+void ColumnarRelation::computeIndices() {
+    assert(!isProvenance && "columnar relations cannot used for provenance");
 
-    // Generate and set indices
     auto inds = indexSelection.getAllOrders();
-
-    // generate a full index if no indices exist
     assert(!inds.empty() && "no full index in relation");
 
-    // check for full index
+    // the index covering all attributes ensures that each row is stored once
     for (std::size_t i = 0; i < inds.size(); i++) {
-        auto& ind = inds[i];
-        if (ind.size() == getArity()) {
+        if (inds[i].size() == getArity()) {
             masterIndex = i;
             break;
         }
@@ -559,9 +1875,8 @@ void IndirectRelation::computeIndices() {
     computedIndices = inds;
 }
 
-/** Generate type name of a indirect indexed relation */
-std::string IndirectRelation::getTypeName() {
-    // collect all attributes used in the lex-order
+/** Generate type name of a columnar relation */
+std::string ColumnarRelation::getTypeName() {
     std::unordered_set<uint32_t> attributesUsed;
     for (auto& ind : getIndices()) {
         for (auto& attr : ind) {
@@ -570,7 +1885,7 @@ std::string IndirectRelation::getTypeName() {
     }
 
     std::stringstream res;
-    res << "t_btree_" << getTypeAttributeString(relation.getAttributeTypes(), attributesUsed);
+    res << "t_columnar_" << getTypeAttributeString(relation.getAttributeTypes(), attributesUsed);
 
     for (auto& ind : getIndices()) {
         res << "__" << join(ind, "_");
@@ -580,11 +1895,13 @@ std::string IndirectRelation::getTypeName() {
         res << "__" << search;
     }
 
+    res << getNodeSizeSuffix();
+
     return res.str();
 }
 
-/** Generate type struct of a indirect indexed relation */
-void IndirectRelation::generateTypeStruct(std::ostream& out) {
+/** Generate type struct of a columnar relation */
+void ColumnarRelation::generateTypeStruct(std::ostream& out) {
     std::size_t arity = getArity();
     const auto& inds = getIndices();
     auto types = relation.getAttributeTypes();
@@ -594,44 +1911,44 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     // struct definition
     out << "struct " << getTypeName() << " {\n";
     out << "static constexpr Relation::arity_type Arity = " << arity << ";\n";
-
-    // stored tuple type
     out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
 
-    // table and lock required for storing actual data for indirect indices
-    out << "Table<t_tuple> dataTable;\n";
+    // the rows are stored column by column; the indexes hold keys of rows
+    out << "using t_table = ColumnTable<" << arity << ">;\n";
+    out << "using t_key = t_table::key_type;\n";
+    out << "t_table dataTable;\n";
     out << "Lock insert_lock;\n";
 
-    // btree types
-    for (std::size_t i = 0; i < inds.size(); i++) {
-        auto ind = inds[i];
+    std::vector<std::string> typecasts;
+    typecasts.reserve(types.size());
+    for (auto type : types) {
+        switch (type[0]) {
+            case 'f': typecasts.push_back("ramBitCast<RamFloat>"); break;
+            case 'u': typecasts.push_back("ramBitCast<RamUnsigned>"); break;
+            default: typecasts.push_back("ramBitCast<RamSigned>");
+        }
+    }
+
+    for (std::size_t i = 0; i < numIndexes; i++) {
+        const auto& ind = inds[i];
 
         if (i < indexSelection.getAllOrders().size()) {
             indexToNumMap[indexSelection.getAllOrders()[i]] = i;
         }
 
-        std::vector<std::string> typecasts;
-        typecasts.reserve(types.size());
-
-        for (auto type : types) {
-            switch (type[0]) {
-                case 'f': typecasts.push_back("ramBitCast<RamFloat>"); break;
-                case 'u': typecasts.push_back("ramBitCast<RamUnsigned>"); break;
-                default: typecasts.push_back("ramBitCast<RamSigned>");
-            }
-        }
+        auto value = [&](const std::string& key, std::size_t attrib) {
+            return typecasts[attrib] + "(table->get(" + key + ", " + std::to_string(attrib) + "))";
+        };
 
         std::string comparator = "t_comparator_" + std::to_string(i);
-
         out << "struct " << comparator << "{\n";
-        out << " int operator()(const t_tuple *a, const t_tuple *b) const {\n";
+        out << "const t_table* table = nullptr;\n";
+        out << " int operator()(t_key a, t_key b) const {\n";
         out << "  return ";
         std::function<void(std::size_t)> gencmp = [&](std::size_t i) {
             std::size_t attrib = ind[i];
-            const auto& typecast = typecasts[attrib];
-            out << "(" << typecast << "((*a)[" << attrib << "]) <" << typecast << " ((*b)[" << attrib
-                << "])) ? -1 : ((" << typecast << "((*a)[" << attrib << "]) > " << typecast << "((*b)["
-                << attrib << "])) ? 1 :(";
+            out << "(" << value("a", attrib) << " < " << value("b", attrib) << ") ? -1 : ((";
+            out << value("a", attrib) << " > " << value("b", attrib) << ") ? 1 :(";
             if (i + 1 < ind.size()) {
                 gencmp(i + 1);
             } else {
@@ -641,27 +1958,24 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
         };
         gencmp(0);
         out << ";\n }\n";
-        out << "bool less(const t_tuple *a, const t_tuple *b) const {\n";
+        out << "bool less(t_key a, t_key b) const {\n";
         out << "  return ";
         std::function<void(std::size_t)> genless = [&](std::size_t i) {
             std::size_t attrib = ind[i];
-            const auto& typecast = typecasts[attrib];
-            out << typecast << " ((*a)[" << attrib << "]) < " << typecast << "((*b)[" << attrib << "])";
+            out << value("a", attrib) << " < " << value("b", attrib);
             if (i + 1 < ind.size()) {
-                out << "|| (" << typecast << "((*a)[" << attrib << "]) == " << typecast << "((*b)[" << attrib
-                    << "]) && (";
+                out << "|| (" << value("a", attrib) << " == " << value("b", attrib) << " && (";
                 genless(i + 1);
                 out << "))";
             }
         };
         genless(0);
         out << ";\n }\n";
-        out << "bool equal(const t_tuple *a, const t_tuple *b) const {\n";
+        out << "bool equal(t_key a, t_key b) const {\n";
         out << "return ";
         std::function<void(std::size_t)> geneq = [&](std::size_t i) {
             std::size_t attrib = ind[i];
-            const auto& typecast = typecasts[attrib];
-            out << typecast << "((*a)[" << attrib << "]) == " << typecast << "((*b)[" << attrib << "])";
+            out << value("a", attrib) << " == " << value("b", attrib);
             if (i + 1 < ind.size()) {
                 out << "&&";
                 geneq(i + 1);
@@ -672,19 +1986,21 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
         out << "};\n";
 
         if (ind.size() == arity) {
-            out << "using t_ind_" << i << " = btree_set<const t_tuple*," << comparator << ">;\n";
+            out << "using t_ind_" << i << " = btree_set<t_key," << comparator << getNodeSizeArguments("t_key")
+                << ">;\n";
         } else {
-            out << "using t_ind_" << i << " = btree_multiset<const t_tuple*," << comparator << ">;\n";
+            out << "using t_ind_" << i << " = btree_multiset<t_key," << comparator
+                << getNodeSizeArguments("t_key") << ">;\n";
         }
-
-        out << "t_ind_" << i << " ind_" << i << ";\n";
+        out << "t_ind_" << i << " ind_" << i << "{" << comparator << "{&dataTable}, " << comparator
+            << "{&dataTable}};\n";
     }
 
-    // typedef deref iterators
+    // index iterators assemble tuples from the columns; scans iterate the table itself
     for (std::size_t i = 0; i < numIndexes; i++) {
-        out << "using iterator_" << i << " = IterDerefWrapper<typename t_ind_" << i << "::iterator>;\n";
+        out << "using iterator_" << i << " = t_table::index_iterator<t_ind_" << i << "::iterator>;\n";
     }
-    out << "using iterator = iterator_" << masterIndex << ";\n";
+    out << "using iterator = t_table::iterator;\n";
 
     // Create a struct storing the context hints for each index
     out << "struct context {\n";
@@ -702,17 +2018,16 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "}\n";
 
     out << "bool insert(const t_tuple& t, context& h) {\n";
-    out << "const t_tuple* masterCopy = nullptr;\n";
+    out << "t_key key;\n";
     out << "{\n";
     out << "auto lease = insert_lock.acquire();\n";
     out << "if (contains(t, h)) return false;\n";
-    out << "masterCopy = &dataTable.insert(t);\n";
-    out << "ind_" << masterIndex << ".insert(masterCopy, h.hints_" << masterIndex << "_lower);\n";
+    out << "key = t_table::rowKey(dataTable.append(t));\n";
+    out << "ind_" << masterIndex << ".insert(key, h.hints_" << masterIndex << "_lower);\n";
     out << "}\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
         if (i != masterIndex) {
-            out << "ind_" << i << ".insert(masterCopy, h.hints_" << i << "_lower"
-                << ");\n";
+            out << "ind_" << i << ".insert(key, h.hints_" << i << "_lower);\n";
         }
     }
     out << "return true;\n";
@@ -724,7 +2039,7 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "const t_tuple& tuple = reinterpret_cast<const t_tuple&>(data);\n";
     out << "context h;\n";
     out << "return insert(tuple, h);\n";
-    out << "}\n";  // end of insert(RamDomain*)
+    out << "}\n";
 
     std::vector<std::string> decls;
     std::vector<std::string> params;
@@ -735,12 +2050,12 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "bool insert(" << join(decls, ",") << ") {\n";
     out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
     out << "return insert(data);\n";
-    out << "}\n";  // end of insert(RamDomain x1, RamDomain x2, ...)
+    out << "}\n";
 
     // contains methods
     out << "bool contains(const t_tuple& t, context& h) const {\n";
-    out << "return ind_" << masterIndex << ".contains(&t, h.hints_" << masterIndex << "_lower"
-        << ");\n";
+    out << "return ind_" << masterIndex << ".contains(t_table::probeKey(t), h.hints_" << masterIndex
+        << "_lower);\n";
     out << "}\n";
 
     out << "bool contains(const t_tuple& t) const {\n";
@@ -750,38 +2065,27 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
 
     // size method
     out << "std::size_t size() const {\n";
-    out << "return ind_" << masterIndex << ".size();\n";
-    out << "}\n";
-
-    // find methods
-    out << "iterator find(const t_tuple& t, context& h) const {\n";
-    out << "return ind_" << masterIndex << ".find(&t, h.hints_" << masterIndex << "_lower"
-        << ");\n";
-    out << "}\n";
-
-    out << "iterator find(const t_tuple& t) const {\n";
-    out << "context h;\n";
-    out << "return find(t, h);\n";
+    out << "return dataTable.size();\n";
     out << "}\n";
 
     // empty lowerUpperRange method
     out << "range<iterator> lowerUpperRange_0(const t_tuple& lower, const t_tuple& upper, context& h) const "
            "{\n";
-
-    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "return range<iterator>(dataTable.begin(), dataTable.end());\n";
     out << "}\n";
 
     out << "range<iterator> lowerUpperRange_0(const t_tuple& lower, const t_tuple& upper) const {\n";
-
-    out << "return range<iterator>(ind_" << masterIndex << ".begin(),ind_" << masterIndex << ".end());\n";
+    out << "return range<iterator>(dataTable.begin(), dataTable.end());\n";
     out << "}\n";
 
     // lowerUpperRange methods for each pattern which is used to search this relation
     for (auto search : indexSelection.getSearches()) {
         auto& lexOrder = indexSelection.getLexOrder(search);
         std::size_t indNum = indexToNumMap[lexOrder];
+        std::string iter = "iterator_" + std::to_string(indNum);
+        std::string index = "ind_" + std::to_string(indNum);
 
-        out << "range<iterator_" << indNum << "> lowerUpperRange_" << search;
+        out << "range<" << iter << "> lowerUpperRange_" << search;
         out << "(const t_tuple& lower, const t_tuple& upper, context& h) const {\n";
 
         // count size of search pattern
@@ -792,53 +2096,58 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
             }
         }
 
-        out << "t_comparator_" << indNum << " comparator;\n";
-        out << "int cmp = comparator(&lower, &upper);\n";
+        out << "t_key lowerKey = t_table::probeKey(lower);\n";
+        out << "t_key upperKey = t_table::probeKey(upper);\n";
+        out << "int cmp = t_comparator_" << indNum << "{&dataTable}(lowerKey, upperKey);\n";
 
         // use the more efficient find() method if the search pattern is full
         if (eqSize == arity) {
-            // if lower == upper we can just do a find
             out << "if (cmp == 0) {\n";
-            out << "    auto pos = ind_" << indNum << ".find(&lower, h.hints_" << indNum << "_lower);\n";
-            out << "    auto fin = ind_" << indNum << ".end();\n";
+            out << "    auto pos = " << index << ".find(lowerKey, h.hints_" << indNum << "_lower);\n";
+            out << "    auto fin = " << index << ".end();\n";
             out << "    if (pos != fin) {fin = pos; ++fin;}\n";
-            out << "    return range<iterator_" << indNum << ">(pos, fin);\n";
+            out << "    return range<" << iter << ">(" << iter << "(&dataTable, pos), " << iter
+                << "(&dataTable, fin));\n";
             out << "}\n";
         }
         // if lower > upper then we have an empty range
         out << "if (cmp > 0) {\n";
-        out << "    return range<iterator_" << indNum << ">(ind_" << indNum << ".end(), ind_" << indNum
-            << ".end());\n";
+        out << "    return range<" << iter << ">(" << iter << "(&dataTable, " << index << ".end()), " << iter
+            << "(&dataTable, " << index << ".end()));\n";
         out << "}\n";
 
         // otherwise do the default method
-        out << "return range<iterator_" << indNum << ">(ind_" << indNum << ".lower_bound(&lower, h.hints_"
-            << indNum << "_lower"
-            << "), ind_" << indNum << ".upper_bound(&upper, h.hints_" << indNum << "_upper"
-            << "));\n";
-
+        out << "return range<" << iter << ">(" << iter << "(&dataTable, " << index
+            << ".lower_bound(lowerKey, h.hints_" << indNum << "_lower)), " << iter << "(&dataTable, "
+            << index << ".upper_bound(upperKey, h.hints_" << indNum << "_upper)));\n";
         out << "}\n";
 
-        out << "range<iterator_" << indNum << "> lowerUpperRange_" << search;
+        out << "range<" << iter << "> lowerUpperRange_" << search;
         out << "(const t_tuple& lower, const t_tuple& upper) const {\n";
-
         out << "context h;\n";
         out << "return lowerUpperRange_" << search << "(lower, upper, h);\n";
         out << "}\n";
+
+        // count the elements of the range by the subtree sizes of the b-tree
+        out << "std::size_t countRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& upper, context& /* h */) const {\n";
+        out << "t_key lowerKey = t_table::probeKey(lower);\n";
+        out << "t_key upperKey = t_table::probeKey(upper);\n";
+        out << "if (t_comparator_" << indNum << "{&dataTable}(lowerKey, upperKey) > 0) {\n";
+        out << "    return 0;\n";
+        out << "}\n";
+        out << "return " << index << ".countRange(lowerKey, upperKey);\n";
+        out << "}\n";
     }
 
     // empty method
     out << "bool empty() const {\n";
-    out << "return ind_" << masterIndex << ".empty();\n";
+    out << "return dataTable.empty();\n";
     out << "}\n";
 
     // partition method
     out << "std::vector<range<iterator>> partition() const {\n";
-    out << "std::vector<range<iterator>> res;\n";
-    out << "for (const auto& cur : ind_" << masterIndex << ".getChunks(400)) {\n";
-    out << "    res.push_back(make_range(derefIter(cur.begin()), derefIter(cur.end())));\n";
-    out << "}\n";
-    out << "return res;\n";
+    out << "return dataTable.getChunks(400);\n";
     out << "}\n";
 
     // purge method
@@ -851,17 +2160,17 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
 
     // begin and end iterators
     out << "iterator begin() const {\n";
-    out << "return ind_" << masterIndex << ".begin();\n";
+    out << "return dataTable.begin();\n";
     out << "}\n";
 
     out << "iterator end() const {\n";
-    out << "return ind_" << masterIndex << ".end();\n";
+    out << "return dataTable.end();\n";
     out << "}\n";
 
     // printStatistics method
     out << "void printStatistics(std::ostream& o) const {\n";
     for (std::size_t i = 0; i < numIndexes; i++) {
-        out << "o << \" arity " << arity << " indirect b-tree index " << i << " lex-order " << inds[i]
+        out << "o << \" arity " << arity << " columnar b-tree index " << i << " lex-order " << inds[i]
             << "\\n\";\n";
         out << "ind_" << i << ".printStats(o);\n";
     }
@@ -871,6 +2180,147 @@ void IndirectRelation::generateTypeStruct(std::ostream& out) {
     out << "};\n";
 }
 
+// -------- Vector Relation --------
+
+bool VectorRelation::isScanOnly(const ram::analysis::IndexCluster& indexSelection) {
+    const auto searches = indexSelection.getSearches();
+    return std::all_of(searches.begin(), searches.end(), [](const auto& search) { return search.empty(); });
+}
+
+/** Generate index set for a vector relation, which has no indexes */
+void VectorRelation::computeIndices() {
+    assert(!isProvenance && "vector relations cannot be used for provenance");
+    computedIndices = {};
+}
+
+/** Generate type name of a vector relation, which only depends on its arity */
+std::string VectorRelation::getTypeName() {
+    return "t_vector_" + std::to_string(getArity());
+}
+
+/** Generate type struct of a vector relation */
+void VectorRelation::generateTypeStruct(std::ostream& out) {
+    std::size_t arity = getArity();
+    const std::string name = getTypeName();
+
+    // struct definition
+    out << "struct " << name << " {\n";
+    out << "static constexpr Relation::arity_type Arity = " << arity << ";\n";
+    out << "using t_tuple = Tuple<RamDomain, " << arity << ">;\n";
+    out << "using iterator = std::vector<t_tuple>::const_iterator;\n";
+
+    // the tuples are distinct by construction, so insertions append without any search
+    out << "std::vector<t_tuple> data;\n";
+    out << "Lock insert_lock;\n";
+
+    // each thread buffers its insertions in its context, appended to the relation when the context ends
+    out << "struct context {\n";
+    out << name << "* owner = nullptr;\n";
+    out << "std::vector<t_tuple> buffer;\n";
+    out << "context() = default;\n";
+    out << "explicit context(" << name << "* owner) : owner(owner) {}\n";
+    out << "context(context&& other) : owner(other.owner), buffer(std::move(other.buffer)) {\n";
+    out << "other.owner = nullptr;\n";
+    out << "}\n";
+    out << "context(const context&) = delete;\n";
+    out << "context& operator=(const context&) = delete;\n";
+    out << "~context() {\n";
+    out << "if (owner != nullptr) owner->append(buffer);\n";
+    out << "}\n";
+    out << "};\n";
+    out << "context createContext() { return context(this); }\n";
+
+    out << "void append(std::vector<t_tuple>& tuples) {\n";
+    out << "if (tuples.empty()) return;\n";
+    out << "auto lease = insert_lock.acquire();\n";
+    out << "data.insert(data.end(), tuples.begin(), tuples.end());\n";
+    out << "tuples.clear();\n";
+    out << "}\n";
+
+    // insert methods
+    out << "bool insert(const t_tuple& t) {\n";
+    out << "auto lease = insert_lock.acquire();\n";
+    out << "data.push_back(t);\n";
+    out << "return true;\n";
+    out << "}\n";
+
+    out << "bool insert(const t_tuple& t, context& h) {\n";
+    out << "if (h.owner != this) return insert(t);\n";
+    out << "h.buffer.push_back(t);\n";
+    out << "return true;\n";
+    out << "}\n";
+
+    out << "bool insert(const RamDomain* ramDomain) {\n";
+    out << "RamDomain data[" << arity << "];\n";
+    out << "std::copy(ramDomain, ramDomain + " << arity << ", data);\n";
+    out << "return insert(reinterpret_cast<const t_tuple&>(data));\n";
+    out << "}\n";
+
+    std::vector<std::string> decls;
+    std::vector<std::string> params;
+    for (std::size_t i = 0; i < arity; i++) {
+        decls.push_back("RamDomain a" + std::to_string(i));
+        params.push_back("a" + std::to_string(i));
+    }
+    out << "bool insert(" << join(decls, ",") << ") {\n";
+    out << "RamDomain data[" << arity << "] = {" << join(params, ",") << "};\n";
+    out << "return insert(data);\n";
+    out << "}\n";
+
+    // size method
+    out << "std::size_t size() const {\n";
+    out << "return data.size();\n";
+    out << "}\n";
+
+    // empty lowerUpperRange method
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */, context& /* h */) const {\n";
+    out << "return range<iterator>(data.begin(), data.end());\n";
+    out << "}\n";
+
+    out << "range<iterator> lowerUpperRange_" << SearchSignature(arity)
+        << "(const t_tuple& /* lower */, const t_tuple& /* upper */) const {\n";
+    out << "return range<iterator>(data.begin(), data.end());\n";
+    out << "}\n";
+
+    // empty method
+    out << "bool empty() const {\n";
+    out << "return data.empty();\n";
+    out << "}\n";
+
+    // partition method
+    out << "std::vector<range<iterator>> partition() const {\n";
+    out << "std::vector<range<iterator>> res;\n";
+    out << "const std::size_t step = std::max<std::size_t>(data.size() / 400, 1);\n";
+    out << "for (std::size_t i = 0; i < data.size(); i += step) {\n";
+    out << "res.emplace_back(data.begin() + i, data.begin() + std::min(data.size(), i + step));\n";
+    out << "}\n";
+    out << "return res;\n";
+    out << "}\n";
+
+    // purge method, keeping the capacity for the next iteration
+    out << "void purge() {\n";
+    out << "data.clear();\n";
+    out << "}\n";
+
+    // begin and end iterators
+    out << "iterator begin() const {\n";
+    out << "return data.begin();\n";
+    out << "}\n";
+
+    out << "iterator end() const {\n";
+    out << "return data.end();\n";
+    out << "}\n";
+
+    // printStatistics method
+    out << "void printStatistics(std::ostream& o) const {\n";
+    out << "o << \" arity " << arity << " vector of \" << data.size() << \" tuples\\n\";\n";
+    out << "}\n";
+
+    // end struct
+    out << "};\n";
+}
+
 // -------- Brie Relation --------
 
 /** Generate index set for a brie relation */
@@ -1100,6 +2550,13 @@ void BrieRelation::generateTypeStruct(std::ostream& out) {
         out << "(const t_tuple& lower, const t_tuple& upper) const {\n";
         out << "context h; return lowerUpperRange_" << search << "(lower,upper, h);\n";
         out << "}\n";
+
+        // count the elements of the range without enumerating them
+        out << "std::size_t countRange_" << search;
+        out << "(const t_tuple& lower, const t_tuple& /* upper */, context& h) const {\n";
+        out << "return ind_" << indNum << ".template countBoundaries<" << indSize << ">(orderIn_" << indNum
+            << "(lower), h.hints_" << indNum << ");\n";
+        out << "}\n";
     }
 
     // empty method
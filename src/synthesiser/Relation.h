@@ -68,11 +68,63 @@ public:
     /** Generate relation type struct */
     virtual void generateTypeStruct(std::ostream& out) = 0;
 
+    /** Check whether the relation type struct provides a compact() method */
+    virtual bool isCompactable() const {
+        return false;
+    }
+
+    /** Check whether the relation type struct checks a Bloom filter and provides a buildFilter() method */
+    virtual bool isFiltered() const {
+        return false;
+    }
+
+    /** Check whether the relation type struct provides a freeze() method */
+    virtual bool isFreezable() const {
+        return false;
+    }
+
+    /** Check whether the relation type struct builds indexes on demand by a buildIndexes() method */
+    virtual bool hasOnDemandIndexes() const {
+        return false;
+    }
+
+    /** Check whether the relation type struct provides a place() method, storing its tuples by NUMA node */
+    virtual bool isPlaceable() const {
+        return false;
+    }
+
+    /** Get the node size in bytes of the b-trees of the relation selected by --btree-node-size,
+     * or 0 if the node size is derived from the tuple width */
+    unsigned getNodeSize() const;
+
     /** Factory method to generate a SynthesiserRelation */
     static Own<Relation> getSynthesiserRelation(const ram::Relation& ramRel,
             const ram::analysis::IndexCluster& indexSelection, bool isProvenance);
 
+    /**
+     * Check whether the relation type struct of the relation provides a forEachSpan() method,
+     * handing the tuples of its master index to an operation as spans of consecutive tuples
+     */
+    static bool providesSpans(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection,
+            bool isProvenance);
+
+    /** Check whether the relation type struct of the relation provides prefetch_<search>() methods */
+    static bool providesPrefetch(const ram::Relation& ramRel, bool isProvenance);
+
+    /**
+     * Check whether the relation type struct of the relation provides a partitionByNode() method,
+     * handing the threads the chunks of tuples stored in the memory of their NUMA node first
+     */
+    static bool providesNodePartition(const ram::Relation& ramRel,
+            const ram::analysis::IndexCluster& indexSelection, bool isProvenance);
+
 protected:
+    /** Print the template arguments selecting the node size of a b-tree over the given key type */
+    std::string getNodeSizeArguments(const std::string& keyType) const;
+
+    /** Print the suffix distinguishing type names of relations with a selected node size */
+    std::string getNodeSizeSuffix() const;
+
     /** Ram relation referred to by this */
     const ram::Relation& relation;
 
@@ -117,18 +169,91 @@ public:
     void generateTypeStruct(std::ostream& out) override;
 };
 
+class CounterRelation : public Relation {
+public:
+    CounterRelation(
+            const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance)
+            : Relation(ramRel, indexSelection, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+};
+
 class DirectRelation : public Relation {
 public:
     DirectRelation(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection,
-            bool isProvenance, bool hasErase)
-            : Relation(ramRel, indexSelection, isProvenance), hasErase(hasErase) {}
+            bool isProvenance, bool hasErase, bool isSmall = false, bool isSharded = false)
+            : Relation(ramRel, indexSelection, isProvenance), hasErase(hasErase), isSmall(isSmall),
+              isSharded(isSharded) {}
 
     void computeIndices() override;
     std::string getTypeName() override;
     void generateTypeStruct(std::ostream& out) override;
 
+    bool isCompactable() const override {
+        return true;
+    }
+
+    bool isFiltered() const override {
+        return indexSelection.isFiltered() && !isProvenance && !hasErase && !isSmall && !isSharded;
+    }
+
+    bool isFreezable() const override {
+        return !hasErase;
+    }
+
+    bool hasOnDemandIndexes() const override;
+
+    bool isPlaceable() const override {
+        return isSharded;
+    }
+
+    /**
+     * Check whether the indexes of a relation can be sharded by the first attribute of their order,
+     * which must not be a float, since floats that compare equal may differ in their bit patterns
+     */
+    static bool isShardable(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection);
+
 private:
+    /** Check whether the i-th index is a hash index, i.e., only ever searched for equal values */
+    bool isHashIndex(std::size_t i) const;
+
+    /** Check whether the i-th index is not maintained on insertion, but built once the relation is read */
+    bool isOnDemandIndex(std::size_t i) const;
+
     const bool hasErase;
+
+    /** Whether the indexes store their tuples in inline arrays until they outgrow them */
+    const bool isSmall;
+
+    /** Whether the indexes hash their tuples into a b-tree per NUMA node */
+    const bool isSharded;
+};
+
+/**
+ * B-tree relation storing its bounded attributes in 8 or 16 bits (see IndexCluster::getBounds),
+ * whose tuples are widened on access
+ */
+class PackedRelation : public Relation {
+public:
+    PackedRelation(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection)
+            : Relation(ramRel, indexSelection, false) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+
+    bool isCompactable() const override {
+        return true;
+    }
+
+    bool isFreezable() const override {
+        return true;
+    }
+
+    /** Check whether a b-tree relation stores its tuples in fewer bytes by packing its bounded attributes */
+    static bool isPackable(const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection);
 };
 
 class IndirectRelation : public Relation {
@@ -142,6 +267,32 @@ public:
     void generateTypeStruct(std::ostream& out) override;
 };
 
+class ColumnarRelation : public Relation {
+public:
+    ColumnarRelation(
+            const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance)
+            : Relation(ramRel, indexSelection, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+};
+
+/** Append-only vector of distinct tuples, for delta relations only ever scanned in full */
+class VectorRelation : public Relation {
+public:
+    VectorRelation(
+            const ram::Relation& ramRel, const ram::analysis::IndexCluster& indexSelection, bool isProvenance)
+            : Relation(ramRel, indexSelection, isProvenance) {}
+
+    void computeIndices() override;
+    std::string getTypeName() override;
+    void generateTypeStruct(std::ostream& out) override;
+
+    /** Check whether a relation with the given indexes is only ever scanned in full */
+    static bool isScanOnly(const ram::analysis::IndexCluster& indexSelection);
+};
+
 class BrieRelation : public Relation {
 public:
     BrieRelation(
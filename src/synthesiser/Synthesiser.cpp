@@ -19,12 +19,17 @@
 #include "FunctorOps.h"
 #include "Global.h"
 #include "RelationTag.h"
+#include "ram/AbstractExistenceCheck.h"
 #include "ram/AbstractParallel.h"
 #include "ram/Aggregate.h"
 #include "ram/AutoIncrement.h"
+#include "ram/BinRelationStatement.h"
+#include "ram/Branches.h"
 #include "ram/Break.h"
 #include "ram/Call.h"
+#include "ram/Checkpoint.h"
 #include "ram/Clear.h"
+#include "ram/CompactTables.h"
 #include "ram/Condition.h"
 #include "ram/Conjunction.h"
 #include "ram/Constraint.h"
@@ -36,11 +41,13 @@
 #include "ram/Expression.h"
 #include "ram/False.h"
 #include "ram/Filter.h"
+#include "ram/Guard.h"
 #include "ram/FloatConstant.h"
 #include "ram/IO.h"
 #include "ram/IfExists.h"
 #include "ram/IndexAggregate.h"
 #include "ram/IndexIfExists.h"
+#include "ram/IndexIntersect.h"
 #include "ram/IndexScan.h"
 #include "ram/Insert.h"
 #include "ram/IntrinsicOperator.h"
@@ -53,6 +60,7 @@
 #include "ram/NestedIntrinsicOperator.h"
 #include "ram/NestedOperation.h"
 #include "ram/Node.h"
+#include "ram/NoveltyInsert.h"
 #include "ram/Operation.h"
 #include "ram/PackRecord.h"
 #include "ram/Parallel.h"
@@ -61,6 +69,7 @@
 #include "ram/ParallelIndexAggregate.h"
 #include "ram/ParallelIndexIfExists.h"
 #include "ram/ParallelIndexScan.h"
+#include "ram/ParallelNestedIntrinsicOperator.h"
 #include "ram/ParallelScan.h"
 #include "ram/Program.h"
 #include "ram/ProvenanceExistenceCheck.h"
@@ -72,6 +81,8 @@
 #include "ram/Sequence.h"
 #include "ram/SignedConstant.h"
 #include "ram/Statement.h"
+#include "ram/StratumCache.h"
+#include "ram/StringConstant.h"
 #include "ram/SubroutineArgument.h"
 #include "ram/SubroutineReturn.h"
 #include "ram/Swap.h"
@@ -84,11 +95,15 @@
 #include "ram/UnsignedConstant.h"
 #include "ram/UserDefinedOperator.h"
 #include "ram/analysis/Index.h"
+#include "ram/utility/DeferredInserts.h"
 #include "ram/utility/Utils.h"
 #include "ram/utility/Visitor.h"
 #include "souffle/BinaryConstraintOps.h"
 #include "souffle/RamTypes.h"
 #include "souffle/TypeAttribute.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/profile/Relation.h"
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/FileUtil.h"
 #include "souffle/utility/MiscUtil.h"
@@ -105,6 +120,7 @@
 #include <iterator>
 #include <limits>
 #include <map>
+#include <set>
 #include <sstream>
 #include <tuple>
 #include <type_traits>
@@ -119,6 +135,40 @@ using ram::analysis::IndexAnalysis;
 using namespace ram;
 using namespace stream_write_qualified_char_as_number;
 
+/** The number of tuples by which a loop prefetches the probes of its nested index scan ahead */
+constexpr std::size_t prefetchDistance = 8;
+
+/** The number of bytes of facts per string literal, within the limits of compilers on their length */
+constexpr std::size_t inlineFactsChunkSize = 16000;
+
+namespace {
+
+/** Collect the relations a stratum reads from earlier strata, and the relations it computes or loads */
+void getStratumRelations(
+        const Statement& stratum, std::set<std::string>& read, std::set<std::string>& written) {
+    visit(stratum, [&](const RelationOperation& op) { read.insert(op.getRelation()); });
+    visit(stratum, [&](const AbstractExistenceCheck& op) { read.insert(op.getRelation()); });
+    visit(stratum, [&](const EmptinessCheck& op) { read.insert(op.getRelation()); });
+    visit(stratum, [&](const RelationSize& op) { read.insert(op.getRelation()); });
+    visit(stratum, [&](const Insert& op) { written.insert(op.getRelation()); });
+    visit(stratum, [&](const Erase& op) { written.insert(op.getRelation()); });
+    visit(stratum, [&](const Clear& op) { written.insert(op.getRelation()); });
+    visit(stratum, [&](const BinRelationStatement& op) {
+        written.insert(op.getFirstRelation());
+        written.insert(op.getSecondRelation());
+    });
+    visit(stratum, [&](const IO& io) {
+        if (io.get("operation") == "input") {
+            written.insert(io.getRelation());
+        }
+    });
+    for (const auto& name : written) {
+        read.erase(name);
+    }
+}
+
+}  // namespace
+
 /** Lookup frequency counter */
 unsigned Synthesiser::lookupFreqIdx(const std::string& txt) {
     static unsigned ctr;
@@ -130,6 +180,26 @@ unsigned Synthesiser::lookupFreqIdx(const std::string& txt) {
     }
 }
 
+std::size_t Synthesiser::getIndexAccessCount() {
+    if (indexAccessIdxMap.empty()) {
+        // all indexes have counters, such that the indexes never accessed are reported too
+        auto& idxAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+        for (const auto* rel : translationUnit.getProgram().getRelations()) {
+            indexAccessIdxMap[rel->getName()] = numIndexAccesses;
+            // nullary relations have no orders, but count the inserted tuples
+            numIndexAccesses += std::max<std::size_t>(
+                    idxAnalysis.getIndexSelection(rel->getName()).getAllOrders().size(), 1);
+        }
+    }
+    return numIndexAccesses;
+}
+
+/** Lookup index access counter */
+std::size_t Synthesiser::lookupIndexAccessIdx(const std::string& relation, std::size_t index) {
+    getIndexAccessCount();
+    return indexAccessIdxMap.at(relation) + index;
+}
+
 /** Lookup frequency counter */
 std::size_t Synthesiser::lookupReadIdx(const std::string& txt) {
     std::string modifiedTxt = txt;
@@ -216,6 +286,9 @@ std::set<const ram::Relation*> Synthesiser::getReferencedRelations(const Operati
             res.insert(lookup(provExists->getRelation()));
         } else if (auto insert = as<Insert>(node)) {
             res.insert(lookup(insert->getRelation()));
+            if (auto noveltyInsert = as<NoveltyInsert>(node)) {
+                res.insert(lookup(noveltyInsert->getNewRelation()));
+            }
         }
     });
     return res;
@@ -249,6 +322,136 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
         std::ostringstream preamble;
         bool preambleIssued = false;
 
+        /** Code following the parallel region of the current query */
+        std::ostringstream epilogue;
+
+        /** Insertions of the parallel loop of the current query which the threads may defer */
+        std::vector<const Insert*> deferredInserts;
+
+        /** Tuple elements bound to locals in the current loop nest, by tuple id and element */
+        std::set<std::pair<int, std::size_t>> boundElements;
+
+        /** Declare the logger of the rule the chunks of a parallel loop are timed for, if profiling */
+        static std::string chunkLogger() {
+            return Global::config().has("profile") ? "Logger* chunkLogger = Logger::current();\n" : "";
+        }
+
+        /** Time a chunk, i.e., a partition, of a parallel loop, if profiling */
+        static std::string chunkTimer() {
+            return Global::config().has("profile") ? "Logger::ChunkTimer chunkTimer(chunkLogger);\n" : "";
+        }
+
+        /**
+         * The expression counting an access of an index of the relation, if the index accesses are
+         * profiled: an existence check, a range scan, a tuple returned by a scan, or an insertion,
+         * which the generated program counts in the columns 0 to 3 of the counters of the index
+         */
+        std::string indexAccessCounter(const ram::Relation& rel, std::size_t index, std::size_t column) {
+            if (!Global::config().has("profile") || !Global::config().has("profile-frequency")) {
+                return "";
+            }
+            return "indexAccesses[" + std::to_string(synthesiser.lookupIndexAccessIdx(rel.getName(), index)) +
+                   "][" + std::to_string(column) + "].fetch_add(1, std::memory_order_relaxed)";
+        }
+
+        void emitIndexAccess(
+                const ram::Relation& rel, std::size_t index, std::size_t column, std::ostream& out) {
+            auto counter = indexAccessCounter(rel, index, column);
+            if (!counter.empty()) {
+                out << counter << ";\n";
+            }
+        }
+
+        /** The position of the index of the relation searched with the signature */
+        std::size_t searchIndex(const ram::Relation& rel, const ram::analysis::SearchSignature& keys) {
+            return isa->getIndexSelection(rel.getName()).getLexOrderNum(keys);
+        }
+
+        /**
+         * Declare the runs of the insertions of a parallel loop over the given number of tuples which
+         * the threads may defer, and decide whether they defer them. Each thread collects the tuples
+         * of an insertion into a relation that is small compared to the loop in a buffer, sorts the
+         * buffer once the loop is done, and the sorted runs are merged into the relation at the end of
+         * the parallel region.
+         */
+        std::string deferInserts(const TupleOperation& loop, const std::string& size) {
+            std::ostringstream out;
+            if (Global::config().has("provenance")) {
+                return out.str();
+            }
+            for (const Insert* insert : getDeferrableInserts(loop.getOperation())) {
+                const std::size_t id = deferredInserts.size();
+                deferredInserts.push_back(insert);
+                const auto* rel = synthesiser.lookup(insert->getRelation());
+                const auto& relName = synthesiser.getRelationName(rel);
+                const auto tupleType = "Tuple<RamDomain," + std::to_string(rel->getArity()) + ">";
+                out << "const bool deferInsert" << id << " = souffle::deferInserts(souffle::parallel_threads("
+                    << size << "), " << size << ", " << relName << "->size());\n";
+                out << "std::vector<std::vector<" << tupleType << ">> insertRuns" << id << ";\n";
+                out << "std::mutex insertRunsLock" << id << ";\n";
+                epilogue << "souffle::mergeRuns(insertRuns" << id << ", [&](auto begin, auto end) {\n";
+                epilogue << "auto insertContext = " << relName << "->createContext();\n";
+                epilogue << "for (auto it = begin; it != end; ++it) {\n";
+                epilogue << relName << "->insert(*it, insertContext);\n";
+                epilogue << "}\n";
+                epilogue << "});\n";
+            }
+            return out.str();
+        }
+
+        /** Declare the buffers of the deferred insertions in the parallel region of a thread */
+        std::string insertBuffers() {
+            std::ostringstream out;
+            for (std::size_t id = 0; id < deferredInserts.size(); ++id) {
+                const auto* rel = synthesiser.lookup(deferredInserts[id]->getRelation());
+                out << "std::vector<Tuple<RamDomain," << rel->getArity() << ">> insertBuffer" << id << ";\n";
+            }
+            return out.str();
+        }
+
+        /** Sort the buffers of a thread whose parallel loop is done, and add them to the runs */
+        std::string collectInsertBuffers() {
+            std::ostringstream out;
+            for (std::size_t id = 0; id < deferredInserts.size(); ++id) {
+                out << "if (deferInsert" << id << ") {\n";
+                out << "std::sort(insertBuffer" << id << ".begin(), insertBuffer" << id << ".end());\n";
+                out << "std::lock_guard<std::mutex> guard(insertRunsLock" << id << ");\n";
+                out << "insertRuns" << id << ".push_back(std::move(insertBuffer" << id << "));\n";
+                out << "}\n";
+            }
+            return out.str();
+        }
+
+        /** Start a parallel region over the relation, with the number of threads selected by
+         * --relation-threads, or else by the size of the relation at run time */
+        std::string parallelStart(const ram::Relation& rel) {
+            // auxiliary relations, e.g. @delta_path, are processed as their relation
+            std::string name = rel.getName();
+            if (name[0] == '@') {
+                name = name.substr(name.find('_') + 1);
+            }
+            return parallelStart(name, synthesiser.getRelationName(rel) + "->size()");
+        }
+
+        /** Start a parallel region over the given number of items, with the number of threads selected
+         * by --relation-threads for the named relation, or the default entry if the name is empty */
+        std::string parallelStart(const std::string& name, const std::string& size) {
+            std::string threads = "0";
+            const std::string& relationThreads =
+                    Global::config().has("relation-threads") ? Global::config().get("relation-threads") : "";
+            for (const auto& entry : splitString(relationThreads, ',')) {
+                auto pos = entry.find('=');
+                if (pos == std::string::npos) {
+                    // an entry without relation selects the number of threads of all relations
+                    threads = threads == "0" ? entry : threads;
+                } else if (entry.substr(0, pos) == name) {
+                    threads = entry.substr(pos + 1);
+                    break;
+                }
+            }
+            return "PARALLEL_START_THREADS(souffle::parallel_threads(" + size + ", " + threads + "))\n";
+        }
+
     public:
         CodeEmitter(Synthesiser& syn) : synthesiser(syn) {
             rec = [&](auto& out, const auto* value) {
@@ -324,6 +527,70 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             return std::make_pair(std::move(low), std::move(high));
         }
 
+        /**
+         * Return the index scan probed once per iteration of the given loop, if the probe may be
+         * prefetched ahead of the loop, i.e., its relation provides prefetches and its bounds only
+         * depend on the elements of the enclosing tuples and on constants; otherwise return null.
+         */
+        const IndexScan* getPrefetchedScan(const TupleOperation& loop) {
+            const Operation* op = &loop.getOperation();
+            while (const auto* filter = as<Filter>(op)) {
+                op = &filter->getOperation();
+            }
+            const auto* iscan = as<IndexScan>(op);
+            if (iscan == nullptr || isA<ParallelIndexScan>(iscan)) {
+                return nullptr;
+            }
+            const auto* rel = synthesiser.lookup(iscan->getRelation());
+            bool isProvenance = Global::config().has("provenance") &&
+                                rel->getRepresentation() != RelationRepresentation::INFO;
+            if (!Relation::providesPrefetch(*rel, isProvenance) || isa->getSearchSignature(iscan).empty()) {
+                return nullptr;
+            }
+            bool isSimple = true;
+            for (const auto* bound : iscan->getRangePattern().first) {
+                visit(*bound, [&](const Node& node) {
+                    isSimple = isSimple && (isA<TupleElement>(node) || isA<SignedConstant>(node) ||
+                                                   isA<UnsignedConstant>(node) || isA<FloatConstant>(node) ||
+                                                   isA<StringConstant>(node) || isA<UndefValue>(node));
+                });
+            }
+            return isSimple ? iscan : nullptr;
+        }
+
+        /**
+         * Emit the head of a loop over the given range, which prefetches the probe of the nested index
+         * scan for the tuple a fixed distance ahead of the current one, such that the loads of the
+         * b-tree nodes of successive probes overlap.
+         */
+        void genLoopHead(const TupleOperation& loop, const std::string& range, std::ostream& out) {
+            const auto id = loop.getTupleId();
+            const auto* iscan = getPrefetchedScan(loop);
+            if (iscan == nullptr) {
+                out << "for(const auto& env" << id << " : " << range << ") {\n";
+                return;
+            }
+
+            const auto* rel = synthesiser.lookup(iscan->getRelation());
+            const auto& rangePattern = iscan->getRangePattern();
+            auto rangeBounds = getPaddedRangeBounds(*rel, rangePattern.first, rangePattern.second);
+            out << "auto prefetch" << id << " = [&](const auto& env" << id << ") {\n";
+            out << synthesiser.getRelationName(rel) << "->prefetch_" << isa->getSearchSignature(iscan) << "("
+                << rangeBounds.first.str() << ");\n";
+            out << "};\n";
+            out << "auto ahead" << id << " = (" << range << ").begin();\n";
+            out << "const auto aheadEnd" << id << " = (" << range << ").end();\n";
+            out << "for(std::size_t i = 0; i < " << prefetchDistance << " && ahead" << id << " != aheadEnd"
+                << id << "; ++i, ++ahead" << id << ") {\n";
+            out << "prefetch" << id << "(*ahead" << id << ");\n";
+            out << "}\n";
+            out << "for(const auto& env" << id << " : " << range << ") {\n";
+            out << "if (ahead" << id << " != aheadEnd" << id << ") {\n";
+            out << "prefetch" << id << "(*ahead" << id << ");\n";
+            out << "++ahead" << id << ";\n";
+            out << "}\n";
+        }
+
         // -- relation statements --
 
         void visit_(type_identity<IO>, const IO& io, std::ostream& out) override {
@@ -345,6 +612,61 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
             const auto& directives = io.getDirectives();
             const std::string& op = io.get("operation");
+            const std::string relName = synthesiser.getRelationName(synthesiser.lookup(io.getRelation()));
+            if (op == "spill" || op == "restore") {
+                // spilled relations are cleared along with intermediate relations, regardless of IO
+                out << "if (pruneImdtRels) {\n";
+                out << "std::map<std::string, std::string> directiveMap(";
+                printDirectives(directives);
+                out << ");\n";
+                if (op == "spill") {
+                    out << "IOSystem::getInstance().getWriter(directiveMap, symTable, recordTable)";
+                    out << "->writeAll(*" << relName << ");\n";
+                } else {
+                    out << "try {";
+                    out << "IOSystem::getInstance().getReader(directiveMap, symTable, recordTable)";
+                    out << "->readAll(*" << relName << ");\n";
+                    out << "} catch (std::exception& e) {std::cerr << \"Error loading " << io.getRelation()
+                        << " data: \" << e.what() << '\\n';}\n";
+                }
+                out << "}\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
+            if (io.get("IO") == "inline") {
+                // the facts of the program are loaded regardless of IO, from raw string literals
+                // small enough for any compiler
+                const std::string& data = io.get("data");
+                out << "{\n";
+                out << "static const char* const facts[] = {\n";
+                for (std::size_t pos = 0; pos < data.size();) {
+                    std::size_t end = data.rfind('\n', pos + inlineFactsChunkSize);
+                    if (end == std::string::npos || end < pos) {
+                        end = data.find('\n', pos);
+                    }
+                    end = (end == std::string::npos) ? data.size() : end + 1;
+                    out << "R\"_(" << data.substr(pos, end - pos) << ")_\",\n";
+                    pos = end;
+                }
+                out << "};\n";
+                auto registry = directives;
+                registry.erase("data");
+                out << "try {";
+                out << "std::map<std::string, std::string> directiveMap(";
+                printDirectives(registry);
+                out << ");\n";
+                out << "std::string& data = directiveMap[\"data\"];\n";
+                out << "for (const char* chunk : facts) {\n";
+                out << "data += chunk;\n";
+                out << "}\n";
+                out << "IOSystem::getInstance().getReader(directiveMap, symTable, recordTable)";
+                out << "->readAll(*" << relName << ");\n";
+                out << "} catch (std::exception& e) {std::cerr << \"Error loading " << io.getRelation()
+                    << " data: \" << e.what() << '\\n';}\n";
+                out << "}\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
             out << "if (performIO) {\n";
 
             // get some table details
@@ -364,6 +686,19 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     << " data: \" << e.what() "
                        "<< "
                        "'\\n';}\n";
+            } else if (op == "output" && synthesiser.asyncOutput &&
+                       directives.at("IO").compare(0, 6, "stdout") != 0) {
+                // the relation is final, and written while later strata are evaluated
+                out << "std::map<std::string, std::string> directiveMap(";
+                printDirectives(directives);
+                out << ");\n";
+                out << R"_(if (!outputDirectory.empty()) {)_";
+                out << R"_(directiveMap["output-dir"] = outputDirectory;)_";
+                out << "}\n";
+                out << "asyncOutput.submit(" << relName << ", [this, directiveMap]() {";
+                out << "IOSystem::getInstance().getWriter(directiveMap, symTable, recordTable)";
+                out << "->writeAll(*" << relName << ");\n";
+                out << "});\n";
             } else if (op == "output" || op == "printsize") {
                 out << "try {";
                 out << "std::map<std::string, std::string> directiveMap(";
@@ -384,8 +719,48 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        /** The erasure of a query of the form FOR t IN src ERASE (t.0, ..., t.n) FROM trg, or nullptr */
+        const Erase* getBulkErase(const Query& query) {
+            const auto* scan = as<Scan>(query.getOperation());
+            if (scan == nullptr || !scan->getProfileText().empty()) {
+                return nullptr;
+            }
+            const auto* erase = as<Erase>(scan->getOperation());
+            if (erase == nullptr || erase->getRelation() == scan->getRelation()) {
+                return nullptr;
+            }
+            const auto* src = synthesiser.lookup(scan->getRelation());
+            const auto* trg = synthesiser.lookup(erase->getRelation());
+            const auto& values = erase->getValues();
+            if (src->getArity() != trg->getArity() || values.size() != trg->getArity() ||
+                    trg->getRepresentation() != RelationRepresentation::BTREE_DELETE) {
+                return nullptr;
+            }
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                const auto* element = as<TupleElement>(values[i]);
+                if (element == nullptr || element->getTupleId() != scan->getTupleId() ||
+                        element->getElement() != i) {
+                    return nullptr;
+                }
+            }
+            return erase;
+        }
+
         void visit_(type_identity<Query>, const Query& query, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
+            // the tuples of one relation erased from another, e.g., the subsumed tuples of an
+            // iteration, are erased as a batch rather than tuple by tuple
+            if (const auto* erase = getBulkErase(query)) {
+                const auto* scan = as<Scan>(query.getOperation());
+                out << synthesiser.getRelationName(synthesiser.lookup(erase->getRelation()))
+                    << "->eraseAll(*" << synthesiser.getRelationName(synthesiser.lookup(scan->getRelation()))
+                    << ");\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
+            // rules are skipped once the evaluation is cancelled
+            out << "if (!isCancelled()) {\n";
 
             // split terms of conditions of outer filter operation
             // into terms that require a context and terms that
@@ -429,6 +804,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             preamble.str("");
             preamble.clear();
             preambleIssued = false;
+            epilogue.str("");
+            epilogue.clear();
+            deferredInserts.clear();
 
             // create operation contexts for this operation
             for (const ram::Relation* rel : synthesiser.getReferencedRelations(query.getOperation())) {
@@ -463,6 +841,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
             if (isParallel) {
                 out << "PARALLEL_END\n";  // end parallel
+                out << epilogue.str();
             }
 
             out << "}\n";
@@ -471,6 +850,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             if (freeOfCtx.size() > 0) {
                 out << "}\n";
             }
+            out << "}\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -478,11 +858,19 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
         void visit_(type_identity<Clear>, const Clear& clear, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
 
+            const std::string relName = synthesiser.getRelationName(synthesiser.lookup(clear.getRelation()));
+            if (synthesiser.asyncOutput) {
+                out << "asyncOutput.wait(" << relName << ");\n";
+            }
             if (!synthesiser.lookup(clear.getRelation())->isTemp()) {
-                out << "if (pruneImdtRels) ";
+                // expired relations hand their freed nodes back to the system
+                out << "if (pruneImdtRels) {\n";
+                out << relName << "->purge();\n";
+                out << "souffle::NodePools::trim();\n";
+                out << "}\n";
+            } else {
+                out << relName << "->purge();\n";
             }
-            out << synthesiser.getRelationName(synthesiser.lookup(clear.getRelation())) << "->"
-                << "purge();\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -522,6 +910,24 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 return;
             }
 
+            // independent subroutines or loads of input relations => sections that are evaluated concurrently
+            if (all_of(stmts, [](const Statement* stmt) { return isA<Call>(stmt) || isInputOnly(*stmt); })) {
+                // the threads are divided among the sections for the parallel operations they start
+                out << "{\n";
+                out << "souffle::NestedParallelism nestedParallelism(MAX_THREADS, " << stmts.size() << ");\n";
+                out << "PARALLEL_SECTIONS_START\n";
+                for (std::size_t i = 0; i < stmts.size(); ++i) {
+                    out << "PARALLEL_SECTION_START\n";
+                    out << "nestedParallelism.budget(" << i << ");\n";
+                    dispatch(*stmts[i], out);
+                    out << "PARALLEL_SECTION_END\n";
+                }
+                out << "PARALLEL_SECTIONS_END\n";
+                out << "}\n";
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
             // more than one => parallel sections
 
             // start parallel section
@@ -543,6 +949,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_BEGIN_COMMENT(out);
             out << "iter = 0;\n";
             out << "for(;;) {\n";
+            out << "if (isCancelled()) break;\n";
             dispatch(loop.getBody(), out);
             out << "iter++;\n";
             out << "}\n";
@@ -578,13 +985,130 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visit_(type_identity<Guard>, const Guard& guard, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            out << "if(";
+            dispatch(guard.getCondition(), out);
+            out << ") {\n";
+            dispatch(guard.getStatement(), out);
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
+        void visit_(type_identity<CompactTables>, const CompactTables&, std::ostream&) override {
+            // the tables of synthesised programs are not compacted
+        }
+
+        void visit_(type_identity<Checkpoint>, const Checkpoint& checkpoint, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            const std::string directory = "R\"_(" + checkpoint.getDirectory() + ")_\"";
+            if (checkpoint.isResume()) {
+                out << "souffle::checkpoint::restore(" << directory << ", " << checkpoint.getStep()
+                    << ", symTable, recordTable);\n";
+            } else {
+                // the strata of a cancelled evaluation may be incomplete, thus the previous checkpoint stays
+                out << "if (!isCancelled()) souffle::checkpoint::save(" << directory << ", "
+                    << checkpoint.getStep() << ", " << checkpoint.getSteps() << ", {";
+                out << join(checkpoint.getFiles(), ", ",
+                        [](std::ostream& os, const std::string& file) { os << "R\"_(" << file << ")_\""; });
+                out << "}, symTable, recordTable);\n";
+            }
+            PRINT_END_COMMENT(out);
+        }
+
+        void visit_(type_identity<StratumCache>, const StratumCache& cache, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            const std::string directory = "R\"_(" + cache.getDirectory() + ")_\"";
+            const std::string name = "R\"_(" + cache.getName() + ")_\"";
+            auto printTypes = [&](const ram::Relation& rel) {
+                out << "{";
+                out << join(rel.getAttributeTypes(), ", ",
+                        [](std::ostream& os, const std::string& type) { os << "R\"_(" << type << ")_\""; });
+                out << "}";
+            };
+            auto printDirectives = [&](const ram::Relation& rel) {
+                out << "souffle::stratum_cache::snapshotDirectives(" << directory << ", " << name << ", R\"_("
+                    << rel.getName() << ")_\", ";
+                printTypes(rel);
+                out << ")";
+            };
+
+            out << "{\n";
+            out << "souffle::stratum_cache::Fingerprint fingerprint(R\"_(" << cache.getKey() << ")_\");\n";
+            for (const auto& input : cache.getInputs()) {
+                const auto* rel = synthesiser.lookup(input);
+                out << "fingerprint.add(R\"_(" << input << ")_\", *" << synthesiser.getRelationName(rel)
+                    << ", ";
+                printTypes(*rel);
+                out << ", symTable);\n";
+            }
+
+            // load the computed relations from the cache, or evaluate them if the entry is incomplete
+            out << "bool cached = souffle::stratum_cache::isCached(" << directory << ", " << name
+                << ", fingerprint);\n";
+            out << "if (cached) {\n";
+            out << "try {\n";
+            for (const auto& output : cache.getOutputs()) {
+                const auto* rel = synthesiser.lookup(output);
+                out << "IOSystem::getInstance().getReader(";
+                printDirectives(*rel);
+                out << ", symTable, recordTable)->readAll(*" << synthesiser.getRelationName(rel) << ");\n";
+            }
+            out << "} catch (std::exception&) {\n";
+            out << "cached = false;\n";
+            for (const auto& output : cache.getOutputs()) {
+                out << synthesiser.getRelationName(synthesiser.lookup(output)) << "->purge();\n";
+            }
+            out << "}\n";
+            out << "}\n";
+
+            out << "if (!cached) {\n";
+            out << "souffle::stratum_cache::invalidate(" << directory << ", " << name << ");\n";
+            dispatch(cache.getBody(), out);
+            out << "if (!isCancelled()) {\n";
+            out << "try {\n";
+            for (const auto& output : cache.getOutputs()) {
+                const auto* rel = synthesiser.lookup(output);
+                out << "IOSystem::getInstance().getWriter(";
+                printDirectives(*rel);
+                out << ", symTable, recordTable)->writeAll(*" << synthesiser.getRelationName(rel) << ");\n";
+            }
+            out << "souffle::stratum_cache::markCached(" << directory << ", " << name << ", fingerprint);\n";
+            out << "} catch (std::exception& e) {\n";
+            out << "std::cerr << \"Warning: cannot cache " << cache.getName()
+                << ": \" << e.what() << '\\n';\n";
+            out << "}\n";
+            out << "}\n";
+            out << "}\n";
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
         void visit_(type_identity<Call>, const Call& call, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             const Program& prog = synthesiser.getTranslationUnit().getProgram();
             const auto& subs = prog.getSubroutines();
-            out << "{\n";
+            if (isPrefix("stratum_", call.getName())) {
+                // the strata not needed by the requested relations are skipped
+                const std::string stratum = call.getName().substr(8);
+                out << "if (!isCancelled() && (selectedStrata.empty() || selectedStrata[" << stratum
+                    << "])) {\n";
+            } else {
+                out << "if (!isCancelled()) {\n";
+            }
             out << " std::vector<RamDomain> args, ret;\n";
+            if (Global::config().has("profile-stream")) {
+                out << "ProfileEventSingleton::instance().makeStratumEvent(R\"_(" << call.getName()
+                    << ")_\");\n";
+            }
             out << "subroutine_" << distance(subs.begin(), subs.find(call.getName())) << "(args, ret);\n";
+            if (Global::config().has("profile")) {
+                // record the events buffered by the threads at the end of each stratum
+                out << "ProfileEventSingleton::instance().flush();\n";
+            }
+            if (isPrefix("stratum_", call.getName())) {
+                out << "if (!isCancelled()) completeStratum(" << call.getName().substr(8) << ");\n";
+            }
             out << "}\n";
             PRINT_END_COMMENT(out);
         }
@@ -645,13 +1169,33 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             dispatch(nested.getOperation(), out);
             if (Global::config().has("profile") && Global::config().has("profile-frequency") &&
                     !nested.getProfileText().empty()) {
-                out << "freqs[" << synthesiser.lookupFreqIdx(nested.getProfileText()) << "]++;\n";
+                out << "freqs[" << synthesiser.lookupFreqIdx(nested.getProfileText())
+                    << "].fetch_add(1, std::memory_order_relaxed);\n";
             }
         }
 
         void visit_(type_identity<TupleOperation>, const TupleOperation& search, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
+            // bind the accessed elements of the tuple to locals once per iteration, since compilers often
+            // fail to keep them in registers across deeply nested loops
+            const auto id = search.getTupleId();
+            std::set<std::size_t> elements;
+            visit(search.getOperation(), [&](const TupleElement& access) {
+                if (access.getTupleId() == id) {
+                    elements.insert(access.getElement());
+                }
+            });
+            for (std::size_t element : elements) {
+                out << "[[maybe_unused]] const RamDomain env" << id << "_" << element << " = env" << id << "["
+                    << element << "];\n";
+                boundElements.emplace(id, element);
+            }
+
             visit_(type_identity<NestedOperation>(), search, out);
+
+            for (std::size_t element : elements) {
+                boundElements.erase({id, element});
+            }
             PRINT_END_COMMENT(out);
         }
 
@@ -668,18 +1212,35 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
             PRINT_BEGIN_COMMENT(out);
 
-            out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START\n";
+            // the threads of sharded relations scan the chunks stored in the memory of their node first
+            bool isProvenance = Global::config().has("provenance") &&
+                                rel->getRepresentation() != RelationRepresentation::INFO;
+            const bool byNode = Relation::providesNodePartition(
+                    *rel, isa->getIndexSelection(rel->getName()), isProvenance);
+
+            out << "auto part = " << relName << (byNode ? "->partitionByNode();\n" : "->partition();\n");
+            out << deferInserts(pscan, relName + "->size()");
+            out << chunkLogger();
+            out << parallelStart(*rel);
             out << preamble.str();
-            out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
+            out << insertBuffers();
+            if (byNode) {
+                out << "pfor(std::size_t slot = 0; slot < part->size(); ++slot){\n";
+                out << "const auto chunk = part->take();\n";
+                out << "const auto* it = &chunk;\n";
+            } else {
+                out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
+            }
+            out << chunkTimer();
             out << "try{\n";
-            out << "for(const auto& env0 : *it) {\n";
+            genLoopHead(pscan, "*it", out);
 
             visit_(type_identity<TupleOperation>(), pscan, out);
 
             out << "}\n";
             out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
             out << "}\n";
+            out << collectInsertBuffers();
 
             PRINT_END_COMMENT(out);
         }
@@ -687,14 +1248,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
         void visit_(type_identity<Scan>, const Scan& scan, std::ostream& out) override {
             const auto* rel = synthesiser.lookup(scan.getRelation());
             auto relName = synthesiser.getRelationName(rel);
-            auto id = scan.getTupleId();
 
             PRINT_BEGIN_COMMENT(out);
 
             assert(rel->getArity() > 0 && "AstToRamTranslator failed/no scans for nullaries");
 
-            out << "for(const auto& env" << id << " : "
-                << "*" << relName << ") {\n";
+            genLoopHead(scan, "*" + relName, out);
 
             visit_(type_identity<TupleOperation>(), scan, out);
 
@@ -744,9 +1303,11 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_BEGIN_COMMENT(out);
 
             out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START\n";
+            out << chunkLogger();
+            out << parallelStart(*rel);
             out << preamble.str();
             out << "pfor(auto it = part.begin(); it<part.end();++it){\n";
+            out << chunkTimer();
             out << "try{\n";
             out << "for(const auto& env0 : *it) {\n";
             out << "if( ";
@@ -784,7 +1345,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "auto range = " << relName << "->"
                 << "lowerUpperRange_" << keys << "(" << rangeBounds.first.str() << ","
                 << rangeBounds.second.str() << "," << ctxName << ");\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 1, out);
             out << "for(const auto& env" << identifier << " : range) {\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 2, out);
 
             visit_(type_identity<TupleOperation>(), iscan, out);
 
@@ -792,6 +1355,67 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visit_(type_identity<IndexIntersect>, const IndexIntersect& intersect,
+                std::ostream& out) override {
+            const auto* rel = synthesiser.lookup(intersect.getRelation());
+            auto relName = synthesiser.getRelationName(rel);
+            auto identifier = intersect.getTupleId();
+            auto keys = isa->getSearchSignature(&intersect);
+            auto element = intersect.getElement();
+
+            const auto& partner = intersect.getPartner();
+            const auto* partnerRel = synthesiser.lookup(partner.getRelation());
+            auto partnerName = synthesiser.getRelationName(partnerRel);
+            auto partnerKeys = isa->getSearchSignature(&partner);
+            auto partnerElement = intersect.getPartnerElement();
+
+            PRINT_BEGIN_COMMENT(out);
+            auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*rel) + ")";
+            auto partnerCtxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*partnerRel) + ")";
+            auto rangeBounds = getPaddedRangeBounds(
+                    *rel, intersect.getRangePattern().first, intersect.getRangePattern().second);
+
+            // the partner is searched for all values of the shared attribute
+            auto values = partner.getValues();
+            UndefValue undef;
+            values[partnerElement] = &undef;
+            auto partnerBounds = getPaddedRangeBounds(*partnerRel, values, values);
+
+            out << "{\n";
+            out << "auto lower = " << rangeBounds.first.str() << ";\n";
+            out << "const auto upper = " << rangeBounds.second.str() << ";\n";
+            out << "auto partnerLower = " << partnerBounds.first.str() << ";\n";
+            out << "const auto partnerUpper = " << partnerBounds.second.str() << ";\n";
+            out << "auto range = " << relName << "->lowerUpperRange_" << keys << "(lower,upper," << ctxName
+                << ");\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 1, out);
+            out << "auto it = range.begin();\n";
+            out << "while(it != range.end()) {\n";
+            out << "const RamDomain value = (*it)[" << element << "];\n";
+            out << "partnerLower[" << partnerElement << "] = value;\n";
+            out << "auto partners = " << partnerName << "->lowerUpperRange_" << partnerKeys
+                << "(partnerLower,partnerUpper," << partnerCtxName << ");\n";
+            out << "if(partners.empty()) break;\n";
+            out << "const RamDomain next = (*partners.begin())[" << partnerElement << "];\n";
+            // leapfrog over the values absent in the partner
+            out << "if(next != value) {\n";
+            out << "lower[" << element << "] = next;\n";
+            out << "it = " << relName << "->lowerUpperRange_" << keys << "(lower,upper," << ctxName
+                << ").begin();\n";
+            out << "continue;\n";
+            out << "}\n";
+            out << "for(; it != range.end() && (*it)[" << element << "] == value; ++it) {\n";
+            out << "const auto& env" << identifier << " = *it;\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 2, out);
+
+            visit_(type_identity<TupleOperation>(), intersect, out);
+
+            out << "}\n";
+            out << "}\n";
+            out << "}\n";
+            PRINT_END_COMMENT(out);
+        }
+
         void visit_(type_identity<ParallelIndexScan>, const ParallelIndexScan& piscan,
                 std::ostream& out) override {
             const auto* rel = synthesiser.lookup(piscan.getRelation());
@@ -816,17 +1440,25 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 << "lowerUpperRange_" << keys << "(" << rangeBounds.first.str() << ","
                 << rangeBounds.second.str() << ");\n";
             out << "auto part = range.partition();\n";
-            out << "PARALLEL_START\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 1, out);
+            // the range is bounded by the size of the scanned relation
+            out << deferInserts(piscan, relName + "->size()");
+            out << chunkLogger();
+            out << parallelStart(*rel);
             out << preamble.str();
+            out << insertBuffers();
             out << "pfor(auto it = part.begin(); it<part.end(); ++it) { \n";
+            out << chunkTimer();
             out << "try{\n";
             out << "for(const auto& env0 : *it) {\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 2, out);
 
             visit_(type_identity<TupleOperation>(), piscan, out);
 
             out << "}\n";
             out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
             out << "}\n";
+            out << collectInsertBuffers();
 
             PRINT_END_COMMENT(out);
         }
@@ -849,7 +1481,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "auto range = " << relName << "->"
                 << "lowerUpperRange_" << keys << "(" << rangeBounds.first.str() << ","
                 << rangeBounds.second.str() << "," << ctxName << ");\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 1, out);
             out << "for(const auto& env" << identifier << " : range) {\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 2, out);
             out << "if( ";
 
             dispatch(iifexists.getCondition(), out);
@@ -887,11 +1521,15 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 << "lowerUpperRange_" << keys << "(" << rangeBounds.first.str() << ","
                 << rangeBounds.second.str() << ");\n";
             out << "auto part = range.partition();\n";
-            out << "PARALLEL_START\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 1, out);
+            out << chunkLogger();
+            out << parallelStart(*rel);
             out << preamble.str();
             out << "pfor(auto it = part.begin(); it<part.end(); ++it) { \n";
+            out << chunkTimer();
             out << "try{";
             out << "for(const auto& env0 : *it) {\n";
+            emitIndexAccess(*rel, searchIndex(*rel, keys), 2, out);
             out << "if( ";
 
             dispatch(piifexists.getCondition(), out);
@@ -973,6 +1611,16 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 return;
             }
 
+            // special case: counting the elements of a range, which is done without enumerating them
+            if (isRangeCount(aggregate)) {
+                out << "{\n";  // to match PARALLEL_END closing bracket
+                out << preamble.str();
+                emitRangeCount(aggregate, out);
+                visit_(type_identity<TupleOperation>(), aggregate, out);
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
             out << "bool shouldRunNested = false;\n";
 
             // init result and reduction operation
@@ -985,6 +1633,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 case AggregateOp::FMAX: init = "MIN_RAM_FLOAT"; break;
                 case AggregateOp::UMAX: init = "MIN_RAM_UNSIGNED"; break;
                 case AggregateOp::COUNT:
+                case AggregateOp::COUNT_APPROX:
                     init = "0";
                     out << "shouldRunNested = true;\n";
                     break;
@@ -1022,6 +1671,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     op = "+";
                     break;
                 }
+
+                // the sketches of the threads are merged
+                case AggregateOp::COUNT_APPROX: {
+                    op = "hll_merge";
+                    break;
+                }
                 default: fatal("Unhandled aggregate operation");
             }
             // res0 stores the aggregate result
@@ -1042,9 +1697,17 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "RamUnsigned res1 = 0;\n";
                 sharedVariable += ", res1";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "HyperLogLog sketch0;\n";
+                sharedVariable = "sketch0";
+                synthesiser.UsingHyperLogLog = true;
+            }
 
             out << preamble.str();
-            out << "PARALLEL_START\n";
+            if (!keys.empty()) {
+                out << chunkLogger();
+            }
+            out << parallelStart(*rel);
             // check whether there is an index to use
             if (keys.empty()) {
                 out << "#pragma omp for reduction(" << op << ":" << sharedVariable << ")\n";
@@ -1063,6 +1726,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "#pragma omp for reduction(" << op << ":" << sharedVariable << ")\n";
                 // iterate over each part
                 out << "for (auto it = part.begin(); it < part.end(); ++it) {\n";
+                out << chunkTimer();
                 // iterate over tuples in each part
                 out << "for (const auto& env" << identifier << ": *it) {\n";
             }
@@ -1107,6 +1771,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     out << ");\n";
                     out << "++res1;\n";
                     break;
+
+                case AggregateOp::COUNT_APPROX:
+                    out << "sketch0.insert(";
+                    dispatch(aggregate.getExpression(), out);
+                    out << ");\n";
+                    break;
             }
 
             // end if statement
@@ -1128,6 +1798,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "res0 = res0 / res1;\n";
                 out << "}\n";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "res0 = sketch0.estimate();\n";
+            }
 
             // write result into environment tuple
             out << "env" << identifier << "[0] = ramBitCast(res0);\n";
@@ -1141,6 +1814,33 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        /**
+         * Whether the aggregate counts a range which the relation counts without enumerating it, i.e.,
+         * any range except those of equivalence relations and brie ranges bound by inequalities
+         */
+        bool isRangeCount(const IndexAggregate& aggregate) {
+            auto keys = isa->getSearchSignature(&aggregate);
+            RelationRepresentation repr = synthesiser.lookup(aggregate.getRelation())->getRepresentation();
+            bool hasInequality = std::any_of(keys.begin(), keys.end(), [](auto constraint) {
+                return constraint == ram::analysis::AttributeConstraint::Inequal;
+            });
+            return aggregate.getFunction() == AggregateOp::COUNT && isTrue(&aggregate.getCondition()) &&
+                   !keys.empty() && repr != RelationRepresentation::EQREL &&
+                   !(repr == RelationRepresentation::BRIE && hasInequality);
+        }
+
+        /** Emits the count of the aggregate's range into the aggregate's environment */
+        void emitRangeCount(const IndexAggregate& aggregate, std::ostream& out) {
+            const auto* rel = synthesiser.lookup(aggregate.getRelation());
+            auto relName = synthesiser.getRelationName(rel);
+            auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*rel) + ")";
+            auto keys = isa->getSearchSignature(&aggregate);
+            auto rangeBounds = getPaddedRangeBounds(
+                    *rel, aggregate.getRangePattern().first, aggregate.getRangePattern().second);
+            out << "env" << aggregate.getTupleId() << "[0] = " << relName << "->countRange_" << keys << "("
+                << rangeBounds.first.str() << "," << rangeBounds.second.str() << "," << ctxName << ");\n";
+        }
+
         bool isGuaranteedToBeMinimum(const IndexAggregate& aggregate) {
             auto identifier = aggregate.getTupleId();
             auto keys = isa->getSearchSignature(&aggregate);
@@ -1149,7 +1849,8 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             const auto* tupleElem = as<TupleElement>(aggregate.getExpression());
             return tupleElem && tupleElem->getTupleId() == identifier &&
                    keys[tupleElem->getElement()] != ram::analysis::AttributeConstraint::None &&
-                   (repr == RelationRepresentation::BTREE || repr == RelationRepresentation::DEFAULT);
+                   (repr == RelationRepresentation::BTREE || repr == RelationRepresentation::DEFAULT ||
+                           repr == RelationRepresentation::COLUMNAR || repr == RelationRepresentation::SMALL);
         }
 
         void visit_(
@@ -1182,6 +1883,14 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 return;
             }
 
+            // special case: counting the elements of a range, which is done without enumerating them
+            if (isRangeCount(aggregate)) {
+                emitRangeCount(aggregate, out);
+                visit_(type_identity<TupleOperation>(), aggregate, out);
+                PRINT_END_COMMENT(out);
+                return;
+            }
+
             out << "bool shouldRunNested = false;\n";
 
             // init result
@@ -1194,6 +1903,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 case AggregateOp::FMAX: init = "MIN_RAM_FLOAT"; break;
                 case AggregateOp::UMAX: init = "MIN_RAM_UNSIGNED"; break;
                 case AggregateOp::COUNT:
+                case AggregateOp::COUNT_APPROX:
                     init = "0";
                     out << "shouldRunNested = true;\n";
                     break;
@@ -1221,6 +1931,10 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             if (aggregate.getFunction() == AggregateOp::MEAN) {
                 out << "RamUnsigned res1 = 0;\n";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "HyperLogLog sketch0;\n";
+                synthesiser.UsingHyperLogLog = true;
+            }
 
             // check whether there is an index to use
             if (keys.empty()) {
@@ -1283,6 +1997,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     out << ");\n";
                     out << "++res1;\n";
                     break;
+
+                case AggregateOp::COUNT_APPROX:
+                    out << "sketch0.insert(";
+                    dispatch(aggregate.getExpression(), out);
+                    out << ");\n";
+                    break;
             }
 
             out << "}\n";
@@ -1295,6 +2015,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "res0 = res0 / res1;\n";
                 out << "}\n";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "res0 = sketch0.estimate();\n";
+            }
 
             // write result into environment tuple
             out << "env" << identifier << "[0] = ramBitCast(res0);\n";
@@ -1347,6 +2070,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 case AggregateOp::FMAX: init = "MIN_RAM_FLOAT"; break;
                 case AggregateOp::UMAX: init = "MIN_RAM_UNSIGNED"; break;
                 case AggregateOp::COUNT:
+                case AggregateOp::COUNT_APPROX:
                     init = "0";
                     out << "shouldRunNested = true;\n";
                     break;
@@ -1387,6 +2111,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     break;
                 }
 
+                // the sketches of the threads are merged
+                case AggregateOp::COUNT_APPROX: {
+                    op = "hll_merge";
+                    break;
+                }
+
                 default: fatal("Unhandled aggregate operation");
             }
 
@@ -1408,15 +2138,22 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "RamUnsigned res1 = " << init << ";\n";
                 sharedVariable += ", res1";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "HyperLogLog sketch0;\n";
+                sharedVariable = "sketch0";
+                synthesiser.UsingHyperLogLog = true;
+            }
 
             // create a partitioning of the relation to iterate over simeltaneously
             out << "auto part = " << relName << "->partition();\n";
-            out << "PARALLEL_START\n";
+            out << chunkLogger();
+            out << parallelStart(*rel);
             out << preamble.str();
             // pragma statement
             out << "#pragma omp for reduction(" << op << ":" << sharedVariable << ")\n";
             // iterate over each part
             out << "for (auto it = part.begin(); it < part.end(); ++it) {\n";
+            out << chunkTimer();
             // iterate over tuples in each part
             out << "for (const auto& env" << identifier << ": *it) {\n";
 
@@ -1457,6 +2194,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     out << ");\n";
                     out << "++res1;\n";
                     break;
+
+                case AggregateOp::COUNT_APPROX:
+                    out << "sketch0.insert(";
+                    dispatch(aggregate.getExpression(), out);
+                    out << ");\n";
+                    break;
             }
 
             out << "}\n";
@@ -1474,6 +2217,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 out << "res0 = res0 / res1;\n";
                 out << "}\n";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "res0 = sketch0.estimate();\n";
+            }
 
             // write result into environment tuple
             out << "env" << identifier << "[0] = ramBitCast(res0);\n";
@@ -1518,6 +2264,7 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 case AggregateOp::FMAX: init = "MIN_RAM_FLOAT"; break;
                 case AggregateOp::UMAX: init = "MIN_RAM_UNSIGNED"; break;
                 case AggregateOp::COUNT:
+                case AggregateOp::COUNT_APPROX:
                     init = "0";
                     out << "shouldRunNested = true;\n";
                     break;
@@ -1548,10 +2295,25 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             if (aggregate.getFunction() == AggregateOp::MEAN) {
                 out << "RamUnsigned res1 = 0;\n";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "HyperLogLog sketch0;\n";
+                synthesiser.UsingHyperLogLog = true;
+            }
 
-            // check whether there is an index to use
-            out << "for(const auto& env" << identifier << " : "
-                << "*" << relName << ") {\n";
+            // the loop over the spans of consecutive tuples of a b-tree is free of the node traversal of
+            // the iterators, such that the compiler may vectorise the aggregation
+            bool isProvenance = Global::config().has("provenance") &&
+                                rel->getRepresentation() != RelationRepresentation::INFO;
+            const bool spans =
+                    Relation::providesSpans(*rel, isa->getIndexSelection(rel->getName()), isProvenance);
+            if (spans) {
+                out << relName << "->forEachSpan([&](const auto* first, const auto* last) {\n";
+                out << "for (auto it = first; it != last; ++it) {\n";
+                out << "const auto& env" << identifier << " = *it;\n";
+            } else {
+                out << "for(const auto& env" << identifier << " : "
+                    << "*" << relName << ") {\n";
+            }
 
             // produce condition inside the loop
             out << "if( ";
@@ -1593,16 +2355,28 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                     out << ");\n";
                     out << "++res1;\n";
                     break;
+
+                case AggregateOp::COUNT_APPROX:
+                    out << "sketch0.insert(";
+                    dispatch(aggregate.getExpression(), out);
+                    out << ");\n";
+                    break;
             }
 
             out << "}\n";
 
             // end aggregator loop
             out << "}\n";
+            if (spans) {
+                out << "});\n";
+            }
 
             if (aggregate.getFunction() == AggregateOp::MEAN) {
                 out << "res0 = res0 / res1;\n";
             }
+            if (aggregate.getFunction() == AggregateOp::COUNT_APPROX) {
+                out << "res0 = sketch0.estimate();\n";
+            }
 
             // write result into environment tuple
             out << "env" << identifier << "[0] = ramBitCast(res0);\n";
@@ -1625,6 +2399,16 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             PRINT_END_COMMENT(out);
         }
 
+        void visit_(type_identity<Branches>, const Branches& branches, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            for (const auto* branch : branches.getBranches()) {
+                out << "{\n";
+                dispatch(*branch, out);
+                out << "}\n";
+            }
+            PRINT_END_COMMENT(out);
+        }
+
         void visit_(type_identity<Break>, const Break& breakOp, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
             out << "if( ";
@@ -1643,6 +2427,9 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*rel) + ")";
 
             auto condition = guardedInsert.getCondition();
+            // threads of a parallel query must not interleave between checking the guard and inserting
+            out << "{\n";
+            out << "auto guardLease = guard_" << relName << ".acquire();\n";
             // guarded conditions
             out << "if( ";
             dispatch(*condition, out);
@@ -1655,9 +2442,11 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             // insert tuple
             out << relName << "->"
                 << "insert(tuple," << ctxName << ");\n";
+            emitIndexAccess(*rel, 0, 3, out);
 
             // end of conseq body.
             out << "}\n";
+            out << "}\n";
 
             PRINT_END_COMMENT(out);
         }
@@ -1673,9 +2462,41 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             out << "Tuple<RamDomain," << arity << "> tuple{{" << join(insert.getValues(), ",", rec)
                 << "}};\n";
 
-            // insert tuple
+            // insert tuple, or collect it if the threads of the parallel loop defer the insertion
+            auto deferred = std::find(deferredInserts.begin(), deferredInserts.end(), &insert);
+            const auto id = std::distance(deferredInserts.begin(), deferred);
+            if (deferred != deferredInserts.end()) {
+                out << "if (deferInsert" << id << ") {\n";
+                out << "insertBuffer" << id << ".push_back(tuple);\n";
+                out << "} else {\n";
+            }
             out << relName << "->"
                 << "insert(tuple," << ctxName << ");\n";
+            if (deferred != deferredInserts.end()) {
+                out << "}\n";
+            }
+            emitIndexAccess(*rel, 0, 3, out);
+
+            PRINT_END_COMMENT(out);
+        }
+
+        void visit_(type_identity<NoveltyInsert>, const NoveltyInsert& insert, std::ostream& out) override {
+            PRINT_BEGIN_COMMENT(out);
+            const auto* rel = synthesiser.lookup(insert.getRelation());
+            const auto* newRel = synthesiser.lookup(insert.getNewRelation());
+            auto arity = rel->getArity();
+            auto ctxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*rel) + ")";
+            auto newCtxName = "READ_OP_CONTEXT(" + synthesiser.getOpContextName(*newRel) + ")";
+
+            // create inserted tuple
+            out << "Tuple<RamDomain," << arity << "> tuple{{" << join(insert.getValues(), ",", rec)
+                << "}};\n";
+
+            // the insertion into the target relation reports whether the tuple is new to it
+            out << "if (" << synthesiser.getRelationName(rel) << "->insert(tuple," << ctxName << ")) {\n";
+            out << synthesiser.getRelationName(newRel) << "->insert(tuple," << newCtxName << ");\n";
+            out << "}\n";
+            emitIndexAccess(*rel, 0, 3, out);
 
             PRINT_END_COMMENT(out);
         }
@@ -1736,12 +2557,12 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
     EVAL_CHILD(ty, getRHS);     \
     out << ")";                 \
     break
-#define COMPARE_STRING(op)                \
-    out << "(symTable.decode(";           \
-    EVAL_CHILD(RamDomain, getLHS);        \
-    out << ") " #op " symTable.decode(";  \
-    EVAL_CHILD(RamDomain, getRHS);        \
-    out << "))";                          \
+#define COMPARE_STRING(op)             \
+    out << "(symTable.compare(";       \
+    EVAL_CHILD(RamDomain, getLHS);     \
+    out << ", ";                       \
+    EVAL_CHILD(RamDomain, getRHS);     \
+    out << ") " #op " 0)";             \
     break
 #define COMPARE_EQ_NE(opCode, op)                                         \
     case BinaryConstraintOp::   opCode: COMPARE_NUMERIC(RamDomain  , op); \
@@ -1765,20 +2586,24 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 COMPARE(GE, >=)
 
                 // strings
-                case BinaryConstraintOp::MATCH: {
-                    synthesiser.UsingStdRegex = true;
-                    out << "regex_wrapper(symTable.decode(";
-                    dispatch(rel.getLHS(), out);
-                    out << "),symTable.decode(";
-                    dispatch(rel.getRHS(), out);
-                    out << "))";
-                    break;
-                }
+                case BinaryConstraintOp::MATCH:
                 case BinaryConstraintOp::NOT_MATCH: {
                     synthesiser.UsingStdRegex = true;
-                    out << "!regex_wrapper(symTable.decode(";
-                    dispatch(rel.getLHS(), out);
-                    out << "),symTable.decode(";
+                    if (rel.getOperator() == BinaryConstraintOp::NOT_MATCH) {
+                        out << "!";
+                    }
+                    // constant patterns are compiled once, others are cached per thread
+                    if (const auto* pattern = as<StringConstant>(rel.getLHS())) {
+                        auto& regexes = synthesiser.regexPatterns;
+                        const auto pos = regexes.emplace(pattern->getConstant(), regexes.size()).first;
+                        out << "regex_wrapper(regex_" << pos->second << ",";
+                        dispatch(rel.getLHS(), out);
+                    } else {
+                        out << "regex_wrapper(symTable.decode(";
+                        dispatch(rel.getLHS(), out);
+                        out << ")";
+                    }
+                    out << ",symTable.decode(";
                     dispatch(rel.getRHS(), out);
                     out << "))";
                     break;
@@ -1837,9 +2662,15 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             std::string after;
             if (Global::config().has("profile") && Global::config().has("profile-frequency") &&
                     !synthesiser.lookup(exists.getRelation())->isTemp()) {
-                out << R"_((reads[)_" << synthesiser.lookupReadIdx(rel->getName()) << R"_(]++,)_";
+                out << R"_((reads[)_" << synthesiser.lookupReadIdx(rel->getName())
+                    << R"_(].fetch_add(1, std::memory_order_relaxed),)_";
                 after = ")";
             }
+            const auto index = searchIndex(*rel, isa->getSearchSignature(&exists));
+            if (auto probe = indexAccessCounter(*rel, index, 0); !probe.empty()) {
+                out << "(" << probe << ",";
+                after += ")";
+            }
 
             // if it is total we use the contains function
             if (isa->isTotalSignature(&exists)) {
@@ -1948,13 +2779,17 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
         void visit_(type_identity<TupleElement>, const TupleElement& access, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
-            out << "env" << access.getTupleId() << "[" << access.getElement() << "]";
+            if (contains(boundElements, std::make_pair(access.getTupleId(), access.getElement()))) {
+                out << "env" << access.getTupleId() << "_" << access.getElement();
+            } else {
+                out << "env" << access.getTupleId() << "[" << access.getElement() << "]";
+            }
             PRINT_END_COMMENT(out);
         }
 
         void visit_(type_identity<AutoIncrement>, const AutoIncrement& /*inc*/, std::ostream& out) override {
             PRINT_BEGIN_COMMENT(out);
-            out << "(ctr++)";
+            out << "(ctr.next())";
             PRINT_END_COMMENT(out);
         }
 
@@ -2046,11 +2881,11 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
     NARY_OP(F##opcode, RamFloat   , op)
 
 
-#define CONV_TO_STRING(opcode, ty)                \
-    case FunctorOp::opcode: {                     \
-        out << "symTable.encode(std::to_string("; \
-        dispatch(*args[0], out);                  \
-        out << "))";                              \
+#define CONV_TO_STRING(opcode, ty)                                                       \
+    case FunctorOp::opcode: {                                                            \
+        out << "symTable.encode(souffle::evaluator::StringBuilder().appendNumber(";      \
+        dispatch(*args[0], out);                                                         \
+        out << ").view())";                                                              \
     } break;
 #define CONV_FROM_STRING(opcode, ty)                                            \
     case FunctorOp::opcode: {                                                   \
@@ -2154,17 +2989,24 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
 
                 // strings
                 case FunctorOp::CAT: {
-                    out << "symTable.encode(";
-                    std::size_t i = 0;
-                    while (i < args.size() - 1) {
-                        out << "symTable.decode(";
-                        dispatch(*args[i], out);
-                        out << ") + ";
-                        i++;
-                    }
-                    out << "symTable.decode(";
-                    dispatch(*args[i], out);
-                    out << "))";
+                    // the string is built in a buffer of the thread, into which the arguments of
+                    // nested concatenations are appended as well, rather than encoded separately
+                    out << "symTable.encode(souffle::evaluator::StringBuilder()";
+                    std::function<void(const IntrinsicOperator&)> appendArguments =
+                            [&](const IntrinsicOperator& cur) {
+                                for (const auto& arg : cur.getArguments()) {
+                                    const auto* nested = as<IntrinsicOperator>(arg);
+                                    if (nested != nullptr && nested->getOperator() == FunctorOp::CAT) {
+                                        appendArguments(*nested);
+                                        continue;
+                                    }
+                                    out << ".append(symTable.decode(";
+                                    dispatch(*arg, out);
+                                    out << "))";
+                                }
+                            };
+                    appendArguments(op);
+                    out << ".view())";
                     break;
                 }
 
@@ -2218,16 +3060,113 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
             UNREACHABLE_BAD_CASE_ANALYSIS
         }
 
+        void visit_(type_identity<ParallelNestedIntrinsicOperator>, const ParallelNestedIntrinsicOperator& op,
+                std::ostream& out) override {
+            assert(op.getTupleId() == 0 && "not outer-most loop");
+
+            assert(!preambleIssued && "only first loop can be made parallel");
+            preambleIssued = true;
+
+            PRINT_BEGIN_COMMENT(out);
+
+            const char* ty = nullptr;
+            switch (op.getFunction()) {
+                case NestedIntrinsicOp::RANGE: ty = "RamSigned"; break;
+                case NestedIntrinsicOp::URANGE: ty = "RamUnsigned"; break;
+                case NestedIntrinsicOp::FRANGE: fatal("ICE: float ranges are not run in parallel");
+            }
+
+            // the bounds are evaluated once, and the positions of the values are split into parts
+            const auto args = op.getArguments();
+            out << "const " << ty << " rangeFrom = ";
+            dispatch(*args[0], out);
+            out << ";\n";
+            out << "const " << ty << " rangeTo = ";
+            dispatch(*args[1], out);
+            out << ";\n";
+            out << "const " << ty << " rangeStep = ";
+            if (args.size() == 3) {
+                dispatch(*args[2], out);
+            } else {
+                out << "souffle::evaluator::rangeStep(rangeFrom, rangeTo)";
+            }
+            out << ";\n";
+            out << "const std::size_t rangeSize = "
+                   "souffle::evaluator::rangeSize(rangeFrom, rangeTo, rangeStep);\n";
+            out << "const std::size_t rangeParts = souffle::evaluator::rangePartCount(rangeSize);\n";
+            out << chunkLogger();
+            out << parallelStart("", "rangeSize");
+            out << preamble.str();
+            out << "pfor(std::size_t part = 0; part < rangeParts; ++part){\n";
+            out << chunkTimer();
+            out << "try{\n";
+            tfm::format(out,
+                    "souffle::evaluator::runRangePart<%s>(rangeFrom, rangeStep, rangeSize, part, rangeParts, "
+                    "[&](auto&& env%d) {\n",
+                    ty, op.getTupleId());
+            visit_(type_identity<TupleOperation>(), op, out);
+            out << "});\n";
+            out << "} catch(std::exception &e) { signalHandler->error(e.what());}\n";
+            out << "}\n";
+
+            PRINT_END_COMMENT(out);
+        }
+
         void visit_(type_identity<UserDefinedOperator>, const UserDefinedOperator& op,
                 std::ostream& out) override {
+            auto args = op.getArguments();
+            if (!op.isCached()) {
+                emitFunctorCall(op, out, [&](std::size_t i, const char*) { dispatch(*args[i], out); });
+                return;
+            }
+
+            // the arguments are evaluated into the key of the cache, from which a miss calls the functor
+            const char* returnType = "RamDomain";
+            if (!op.isStateful()) {
+                switch (op.getReturnType()) {
+                    case TypeAttribute::Signed: returnType = "RamSigned"; break;
+                    case TypeAttribute::Unsigned: returnType = "RamUnsigned"; break;
+                    case TypeAttribute::Float: returnType = "RamFloat"; break;
+                    case TypeAttribute::Symbol: break;
+                    case TypeAttribute::ADT:
+                    case TypeAttribute::Record: fatal("unhandled type");
+                }
+            }
+            out << "ramBitCast<" << returnType << ">(functorCache_" << op.getName()
+                << ".lookup(std::array<RamDomain, " << args.size() << ">{";
+            out << join(args, ",", [&](auto& os, auto* arg) {
+                os << "ramBitCast(";
+                dispatch(*arg, os);
+                os << ")";
+            });
+            out << "}, [&](const auto& key) -> RamDomain { return ramBitCast(";
+            emitFunctorCall(op, out, [&](std::size_t i, const char* type) {
+                if (type != nullptr) {
+                    out << "ramBitCast<" << type << ">(key[" << i << "])";
+                } else {
+                    out << "key[" << i << "]";
+                }
+            });
+            out << "); }))";
+        }
+
+        /**
+         * Emit the call of a user-defined functor, whose i-th argument is emitted by emitArg(i, type),
+         * where type is the C++ type the argument is passed as, or null for arguments of the domain
+         */
+        void emitFunctorCall(const UserDefinedOperator& op, std::ostream& out,
+                const std::function<void(std::size_t, const char*)>& emitArg) {
             const std::string& name = op.getName();
 
-            auto args = op.getArguments();
+            const std::size_t arity = op.getArguments().size();
             if (op.isStateful()) {
                 out << name << "(&symTable, &recordTable";
-                for (auto& arg : args) {
+                if (op.isThreadLocal()) {
+                    out << ", functorContexts_" << name << ".get()";
+                }
+                for (std::size_t i = 0; i < arity; i++) {
                     out << ",";
-                    dispatch(*arg, out);
+                    emitArg(i, nullptr);
                 }
                 out << ")";
             } else {
@@ -2238,29 +3177,29 @@ void Synthesiser::emitCode(std::ostream& out, const Statement& stmt) {
                 }
                 out << name << "(";
 
-                for (std::size_t i = 0; i < args.size(); i++) {
+                for (std::size_t i = 0; i < arity; i++) {
                     if (i > 0) {
                         out << ",";
                     }
                     switch (argTypes[i]) {
                         case TypeAttribute::Signed:
                             out << "((RamSigned)";
-                            dispatch(*args[i], out);
+                            emitArg(i, "RamSigned");
                             out << ")";
                             break;
                         case TypeAttribute::Unsigned:
                             out << "((RamUnsigned)";
-                            dispatch(*args[i], out);
+                            emitArg(i, "RamUnsigned");
                             out << ")";
                             break;
                         case TypeAttribute::Float:
                             out << "((RamFloat)";
-                            dispatch(*args[i], out);
+                            emitArg(i, "RamFloat");
                             out << ")";
                             break;
                         case TypeAttribute::Symbol:
                             out << "symTable.decode(";
-                            dispatch(*args[i], out);
+                            emitArg(i, nullptr);
                             out << ").c_str()";
                             break;
                         case TypeAttribute::ADT:
@@ -2385,7 +3324,8 @@ private:
     std::shared_ptr<std::ostream> current_stream;
 };
 
-void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& withSharedLibrary) {
+void Synthesiser::generateCode(
+        std::ostream& sos, const std::string& id, bool& withSharedLibrary, SplitSources* split) {
     // ---------------------------------------------------------------
     //                      Auto-Index Generation
     // ---------------------------------------------------------------
@@ -2401,6 +3341,18 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
 
     std::string classname = "Sf_" + id;
 
+    // a library of native strata holds the selected strata, and shares the tables of the interpreter
+    const bool native = Global::config().has("native-strata");
+    std::set<std::string> nativeStrata;
+    if (native) {
+        for (const auto& stratum : splitString(Global::config().get("native-strata"), ',')) {
+            nativeStrata.insert("stratum_" + stratum);
+        }
+    }
+
+    // the strata of a native library are run by the interpreter, whose writes they cannot wait for
+    asyncOutput = Global::config().has("async-output") && !native;
+
     // generate C++ program
 
     if (Global::config().has("verbose")) {
@@ -2408,6 +3360,21 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
         os << "#include \"souffle/profile/ProfileEvent.h\"";
     }
     os << "\n#include \"souffle/CompiledSouffle.h\"\n";
+    if (native) {
+        os << "#include \"souffle/NativeStrata.h\"\n";
+    }
+    if (Global::config().has("shared-library")) {
+        os << "#include \"souffle/ProgramLibrary.h\"\n";
+    }
+    if (Global::config().has("checkpoint-dir") || Global::config().has("resume-from")) {
+        os << "#include \"souffle/io/Checkpoint.h\"\n";
+    }
+    if (Global::config().has("stratum-cache")) {
+        os << "#include \"souffle/io/StratumCache.h\"\n";
+    }
+    if (asyncOutput) {
+        os << "#include \"souffle/io/AsyncOutput.h\"\n";
+    }
     if (Global::config().has("provenance")) {
         os << "#include <mutex>\n";
         os << "#include \"souffle/provenance/Explain.h\"\n";
@@ -2420,22 +3387,45 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
 
     {
         auto _os = os.delayed_if(UsingStdRegex);
-        *_os << "#include <regex>\n";
+        *_os << "#include \"souffle/utility/RegexUtil.h\"\n";
+    }
+
+    {
+        auto _os = os.delayed_if(UsingHyperLogLog);
+        *_os << "#include \"souffle/datastructure/HyperLogLog.h\"\n";
     }
 
     if (Global::config().has("profile") || Global::config().has("live-profile")) {
+        os << "#include \"souffle/profile/Logger.h\"\n";
         os << "#include \"souffle/profile/ProfileEvent.h\"";
     }
 
     os << "\n";
     // produce external definitions for user-defined functors
     std::map<std::string, std::tuple<TypeAttribute, std::vector<TypeAttribute>, bool>> functors;
+    // functors whose calls receive a context per thread
+    std::set<std::string> threadLocalFunctors;
+    // functors whose results are cached, with their arity
+    std::map<std::string, std::size_t> cachedFunctors;
     visit(prog, [&](const UserDefinedOperator& op) {
         if (functors.find(op.getName()) == functors.end()) {
             functors[op.getName()] = std::make_tuple(op.getReturnType(), op.getArgsTypes(), op.isStateful());
         }
+        if (op.isThreadLocal()) {
+            threadLocalFunctors.insert(op.getName());
+        }
+        if (op.isCached()) {
+            cachedFunctors[op.getName()] = op.getArguments().size();
+        }
         withSharedLibrary = true;
     });
+    if (!threadLocalFunctors.empty()) {
+        os << "#include \"souffle/FunctorContexts.h\"\n";
+    }
+    if (!cachedFunctors.empty()) {
+        os << "#include \"souffle/FunctorCache.h\"\n";
+        os << "#include <array>\n";
+    }
     os << "extern \"C\" {\n";
     for (const auto& f : functors) {
         //        std::size_t arity = f.second.length() - 1;
@@ -2459,8 +3449,15 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
             UNREACHABLE_BAD_CASE_ANALYSIS
         };
 
+        if (contains(threadLocalFunctors, name)) {
+            os << "void* " << name << "_init();\n";
+            os << "void " << name << "_fini(void*);\n";
+        }
         if (stateful) {
             os << "souffle::RamDomain " << name << "(souffle::SymbolTable *, souffle::RecordTable *";
+            if (contains(threadLocalFunctors, name)) {
+                os << ", void *";
+            }
             for (std::size_t i = 0; i < argsTypes.size(); i++) {
                 os << ",souffle::RamDomain";
             }
@@ -2486,6 +3483,9 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
     }
     os << '\n';
 
+    // the string constants of the symbol table, known once the code is generated
+    auto symbols_os = os.delayed();
+
     os << "class " << classname << " : public SouffleProgram {\n";
 
     {
@@ -2493,26 +3493,54 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
         auto osp = os.delayed_if(UsingStdRegex);
         auto& _os = *osp;
         _os << "private:\n";
+        _os << "SOUFFLE_COLD static void regex_warning(const std::string& pattern, "
+               "const std::string& text) {\n";
+        _os << "   std::cerr << \"warning: wrong pattern provided for match(\\\"\" << pattern << "
+               "\"\\\",\\\"\" "
+               "<< text << \"\\\").\\n\";\n";
+        _os << "}\n";
         _os << "static inline bool regex_wrapper(const std::string& pattern, const std::string& text) {\n";
         _os << "   bool result = false; \n";
-        _os << "   try { result = std::regex_match(text, std::regex(pattern)); } catch(...) { \n";
-        _os << "     std::cerr << \"warning: wrong pattern provided for match(\\\"\" << pattern << "
-               "\"\\\",\\\"\" "
-               "<< text << \"\\\").\\n\";\n}\n";
+        _os << "   try {\n";
+        _os << "     const auto& regex = souffle::evaluator::getCachedRegex(pattern);\n";
+        _os << "     if (regex) { result = std::regex_match(text, *regex); } else { "
+               "regex_warning(pattern, text); }\n";
+        _os << "   } catch(...) { \n";
+        _os << "     regex_warning(pattern, text);\n}\n";
+        _os << "   return result;\n";
+        _os << "}\n";
+        // the pattern of a compiled regex is only decoded for the warning
+        _os << "inline bool regex_wrapper(const souffle::evaluator::CompiledRegex& regex, RamDomain pattern, "
+               "const std::string& text) {\n";
+        _os << "   bool result = false; \n";
+        _os << "   try {\n";
+        _os << "     if (regex) { result = std::regex_match(text, *regex); } else { "
+               "regex_warning(symTable.decode(pattern), text); }\n";
+        _os << "   } catch(...) { \n";
+        _os << "     regex_warning(symTable.decode(pattern), text);\n}\n";
         _os << "   return result;\n";
         _os << "}\n";
     }
 
+    // the compiled constant patterns, known once the code is generated
+    auto regex_os = os.delayed();
+
     // substring wrapper
+    // the warnings are cold paths, which are kept out of line of the evaluation
     os << "private:\n";
-    os << "static inline std::string substr_wrapper(const std::string& str, std::size_t idx, "
-          "std::size_t "
-          "len) {\n";
-    os << "   std::string result; \n";
-    os << "   try { result = str.substr(idx,len); } catch(...) { \n";
+    os << "SOUFFLE_COLD static void substr_warning(const std::string& str, std::size_t idx, "
+          "std::size_t len) {\n";
     os << "     std::cerr << \"warning: wrong index position provided by substr(\\\"\";\n";
     os << "     std::cerr << str << \"\\\",\" << (int32_t)idx << \",\" << (int32_t)len << \") "
           "functor.\\n\";\n";
+    os << "}\n";
+    // the substring is a view of the decoded string, which is encoded without a copy
+    os << "static inline std::string_view substr_wrapper(const std::string& str, std::size_t idx, "
+          "std::size_t "
+          "len) {\n";
+    os << "   std::string_view result; \n";
+    os << "   try { result = std::string_view(str).substr(idx,len); } catch(...) { \n";
+    os << "     substr_warning(str, idx, len);\n";
     os << "   } return result;\n";
     os << "}\n";
 
@@ -2527,33 +3555,68 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
 
     // issue symbol table with string constants
     visit(prog, [&](const StringConstant& sc) { convertSymbol2Idx(sc.getConstant()); });
-    os << "SymbolTable symTable";
+    // the constants are views of string literals, which are initialised statically rather than constructed
+    // as strings, and are encoded in bulk with the indices assigned to them by the synthesiser
+    std::stringstream symbolConstants;
+    std::stringstream symbolInit;
     if (!symbolMap.empty()) {
-        os << "{\n";
+        symbolConstants << "static constexpr std::string_view symbolConstants[] = {\n";
         for (const auto& x : symbolIndex) {
-            os << "\tR\"_(" << x << ")_\",\n";
+            symbolConstants << "\tstd::string_view(R\"_(" << x << ")_\", " << x.size() << "),\n";
         }
-        os << "}";
+        symbolConstants << "};\n";
+        symbolInit << "{symbolConstants, " << symbolIndex.size() << "}";
+        if (split == nullptr && !native) {
+            *symbols_os << symbolConstants.str();
+        }
+    }
+    if (native) {
+        os << "SymbolTable& symTable;";
+    } else {
+        os << "SymbolTable symTable" << (split == nullptr ? symbolInit.str() : "") << ";";
     }
-    os << ";";
 
     // declare record table
     os << "// -- initialize record table --\n";
 
     auto recordTable_os = os.delayed();
 
+    // declare the per-thread contexts of functors, destroyed with the program
+    for (const auto& name : threadLocalFunctors) {
+        os << "FunctorContexts functorContexts_" << name << "{&" << name << "_init, &" << name << "_fini};\n";
+    }
+
+    // declare the result caches of functors, shared by all threads
+    for (const auto& [name, arity] : cachedFunctors) {
+        os << "FunctorCache<std::array<RamDomain, " << arity << ">> functorCache_" << name;
+        if (Global::config().has("functor-cache")) {
+            os << "{" << Global::config().get("functor-cache") << "}";
+        }
+        os << ";\n";
+    }
+
+    // declare the writer of output relations
+    if (asyncOutput) {
+        os << "AsyncOutput asyncOutput{" << std::stoul(Global::config().get("async-output")) << "};\n";
+    }
+
     if (Global::config().has("profile")) {
         os << "private:\n";
         std::size_t numFreq = 0;
         visit(prog, [&](const Statement&) { numFreq++; });
-        os << "  std::size_t freqs[" << numFreq << "]{};\n";
+        // counters are incremented by the threads of parallel loops without locks
+        os << "  std::atomic<std::size_t> freqs[" << numFreq << "]{};\n";
         std::size_t numRead = 0;
         for (auto rel : prog.getRelations()) {
             if (!rel->isTemp()) {
                 numRead++;
             }
         }
-        os << "  std::size_t reads[" << numRead << "]{};\n";
+        os << "  std::atomic<std::size_t> reads[" << numRead << "]{};\n";
+        if (Global::config().has("profile-frequency")) {
+            // existence checks, range scans, tuples returned by the scans and inserted tuples of each index
+            os << "  std::atomic<std::size_t> indexAccesses[" << getIndexAccessCount() << "][4]{};\n";
+        }
     }
 
     // print relation definitions
@@ -2569,6 +3632,17 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
     if (Global::config().has("profile")) {
         initConsSep() << "profiling_fname(std::move(pf))";
     }
+    if (split != nullptr && !symbolMap.empty()) {
+        initConsSep() << "symTable" << symbolInit.str();
+    }
+    if (native) {
+        initConsSep() << "symTable(symTableArg)";
+        initConsSep() << "recordTable(recordTableArg)";
+    }
+
+    // relations with guarded insertions, which are serialised by a lock of the relation
+    std::set<std::string> guardedRelations;
+    visit(prog, [&](const GuardedInsert& insert) { guardedRelations.insert(insert.getRelation()); });
 
     int relCtr = 0;
     std::set<std::string> storeRelations;
@@ -2579,6 +3653,10 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
     // collect load/store operations/relations
     visit(prog, [&](const IO& io) {
         auto op = io.get("operation");
+        if (op == "input" && io.get("IO") == "inline") {
+            // the facts of the program are not loaded through its interface
+            return;
+        }
         if (op == "input") {
             loadRelations.insert(io.getRelation());
             loadIOs.insert(&io);
@@ -2604,7 +3682,11 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
         os << "// -- Table: " << datalogName << "\n";
 
         os << "Own<" << type << "> " << cppName << " = mk<" << type << ">();\n";
-        if (!rel->isTemp()) {
+        if (contains(guardedRelations, datalogName)) {
+            os << "Lock guard_" << cppName << ";\n";
+        }
+        // counted relations hold no tuples to access through the interface
+        if (!rel->isTemp() && rel->getRepresentation() != RelationRepresentation::COUNTER) {
             tfm::format(os, "souffle::RelationWrapper<%s> wrapper_%s;\n", type, cppName);
 
             auto strLitAry = [](auto&& xs) {
@@ -2625,17 +3707,44 @@ void Synthesiser::generateCode(std::ostream& sos, const std::string& id, bool& w
     }
     os << "public:\n";
 
+    // When splitting, the constructor and the evaluation are declared in the class and defined in the main
+    // translation unit, since they change with the constants and the strata of the program. The header
+    // then stays the same, and the other translation units are not recompiled, unless relations change.
+    std::stringstream mainDefinitions;
+    std::ostream& defs = (split == nullptr) ? static_cast<std::ostream&>(os) : mainDefinitions;
+    if (split != nullptr && !native) {
+        mainDefinitions << symbolConstants.str();
+    }
+    const std::string scope = (split == nullptr) ? "" : classname + "::";
+
     // -- constructor --
 
-    os << classname;
-    os << (Global::config().has("profile") ? "(std::string pf=\"profile.log\")" : "()");
-    os << initCons.str() << '\n';
-    os << "{\n";
+    if (split != nullptr) {
+        os << classname << (Global::config().has("profile") ? "(std::string pf=\"profile.log\")" : "()")
+           << ";\n";
+    }
+    defs << scope << classname;
+    if (native) {
+        defs << "(SymbolTable& symTableArg, RecordTable& recordTableArg)";
+    } else if (Global::config().has("profile")) {
+        defs << (split == nullptr ? "(std::string pf=\"profile.log\")" : "(std::string pf)");
+    } else {
+        defs << "()";
+    }
+    defs << initCons.str() << '\n';
+    defs << "{\n";
     if (Global::config().has("profile")) {
-        os << "ProfileEventSingleton::instance().setOutputFile(profiling_fname);\n";
+        defs << "ProfileEventSingleton::instance().setOutputFile(profiling_fname);\n";
+        if (Global::config().has("profile-counters")) {
+            defs << "ProfileEventSingleton::instance().enableCounters();\n";
+        }
+        if (Global::config().has("profile-stream")) {
+            defs << "ProfileEventSingleton::instance().setStreamFile(R\"_("
+                 << Global::config().get("profile-stream") << ")_\");\n";
+        }
     }
-    os << registerRel.str();
-    os << "}\n";
+    defs << registerRel.str();
+    defs << "}\n";
     // -- destructor --
 
     os << "~" << classname << "() {\n";
@@ -2651,13 +3760,22 @@ private:
 std::string             inputDirectory;
 std::string             outputDirectory;
 SignalHandler*          signalHandler {SignalHandler::instance()};
-std::atomic<RamDomain>  ctr {};
 std::atomic<std::size_t>     iter {};
-
-void runFunction(std::string  inputDirectoryArg,
-                 std::string  outputDirectoryArg,
-                 bool         performIOArg,
-                 bool         pruneImdtRelsArg) {
+)_";
+    // the auto-increment values are reserved in blocks per thread if selected
+    os << "BlockCounter ctr {"
+       << (Global::config().has("autoinc-block") ? Global::config().get("autoinc-block") : "1") << "};\n";
+    // the strata computing the requested relations, or empty if all are evaluated
+    os << "std::vector<bool> selectedStrata;\n";
+
+    const std::string runSignature =
+            "runFunction(std::string inputDirectoryArg, std::string outputDirectoryArg, bool performIOArg, "
+            "bool pruneImdtRelsArg)";
+    if (split != nullptr) {
+        os << "void " << runSignature << ";\n";
+    }
+    defs << "void " << scope << runSignature << " {\n";
+    defs << R"_(
     this->inputDirectory  = std::move(inputDirectoryArg);
     this->outputDirectory = std::move(outputDirectoryArg);
     this->performIO       = performIOArg;
@@ -2672,16 +3790,50 @@ void runFunction(std::string  inputDirectoryArg,
     signalHandler->set();
 )_";
     if (Global::config().has("verbose")) {
-        os << "signalHandler->enableLogging();\n";
+        defs << "signalHandler->enableLogging();\n";
+    }
+    if (Global::config().has("pin-threads")) {
+        defs << "souffle::pin_threads();\n";
+    }
+
+    // select the strata needed by the requested relations from the relations each stratum reads and writes
+    std::vector<std::set<std::string>> stratumReads;
+    std::vector<std::set<std::string>> stratumWrites;
+    for (const auto& sub : prog.getSubroutines()) {
+        if (isPrefix("stratum_", sub.first)) {
+            const std::size_t stratum = std::stoul(sub.first.substr(8));
+            stratumReads.resize(std::max(stratumReads.size(), stratum + 1));
+            stratumWrites.resize(std::max(stratumWrites.size(), stratum + 1));
+            getStratumRelations(*sub.second, stratumReads[stratum], stratumWrites[stratum]);
+        }
+    }
+    if (!native && !stratumWrites.empty()) {
+        auto printNames = [&](const std::vector<std::set<std::string>>& strata) {
+            defs << "{";
+            for (const auto& names : strata) {
+                defs << "{" << join(names, ",", [](auto& out, const auto& name) {
+                    out << "R\"_(" << name << ")_\"";
+                }) << "},\n";
+            }
+            defs << "}";
+        };
+        defs << "selectedStrata.clear();\n";
+        defs << "if (!requestedRelations.empty()) {\n";
+        defs << "selectedStrata = selectStrata(requestedRelations, ";
+        printNames(stratumReads);
+        defs << ", ";
+        printNames(stratumWrites);
+        defs << ");\n";
+        defs << "}\n";
     }
 
     // add actual program body
-    os << "// -- query evaluation --\n";
+    defs << "// -- query evaluation --\n";
     if (Global::config().has("profile")) {
-        os << "ProfileEventSingleton::instance().startTimer();\n";
-        os << R"_(ProfileEventSingleton::instance().makeTimeEvent("@time;starttime");)_" << '\n';
-        os << "{\n"
-           << R"_(Logger logger("@runtime;", 0);)_" << '\n';
+        defs << "ProfileEventSingleton::instance().startTimer();\n";
+        defs << R"_(ProfileEventSingleton::instance().makeTimeEvent("@time;starttime");)_" << '\n';
+        defs << "{\n"
+             << R"_(Logger logger("@runtime;", 0);)_" << '\n';
         // Store count of relations
         std::size_t relationCount = 0;
         for (auto rel : prog.getRelations()) {
@@ -2690,37 +3842,45 @@ void runFunction(std::string  inputDirectoryArg,
             }
         }
         // Store configuration
-        os << R"_(ProfileEventSingleton::instance().makeConfigRecord("relationCount", std::to_string()_"
-           << relationCount << "));";
+        defs << R"_(ProfileEventSingleton::instance().makeConfigRecord("relationCount", std::to_string()_"
+             << relationCount << "));";
     }
 
-    // emit code
-    emitCode(os, prog.getMain());
+    // emit code; the strata of a native library are run by the interpreter
+    if (native) {
+        defs << "fatal(\"the strata of a native library are run by the interpreter\");\n";
+    } else {
+        emitCode(defs, prog.getMain());
+    }
+    if (asyncOutput) {
+        defs << "asyncOutput.wait();\n";
+    }
 
     if (Global::config().has("profile")) {
-        os << "}\n";
-        os << "ProfileEventSingleton::instance().stopTimer();\n";
-        os << "dumpFreqs();\n";
+        defs << "}\n";
+        defs << "ProfileEventSingleton::instance().stopTimer();\n";
+        defs << "dumpFreqs();\n";
     }
 
     // add code printing hint statistics
-    os << "\n// -- relation hint statistics --\n";
+    defs << "\n// -- relation hint statistics --\n";
 
     if (Global::config().has("verbose")) {
         for (auto rel : prog.getRelations()) {
             auto name = getRelationName(*rel);
-            os << "std::cout << \"Statistics for Relation " << name << ":\\n\";\n";
-            os << name << "->printStatistics(std::cout);\n";
-            os << "std::cout << \"\\n\";\n";
+            defs << "std::cout << \"Statistics for Relation " << name << ":\\n\";\n";
+            defs << name << "->printStatistics(std::cout);\n";
+            defs << "std::cout << \"\\n\";\n";
         }
     }
 
-    os << "signalHandler->reset();\n";
+    defs << "signalHandler->reset();\n";
 
-    os << "}\n";  // end of runFunction() method
+    defs << "}\n";  // end of runFunction() method
 
     // add methods to run with and without performing IO (mainly for the interface)
-    os << "public:\nvoid run() override { runFunction(\"\", \"\", "
+    os << "public:\nusing SouffleProgram::run;\n";
+    os << "void run() override { runFunction(\"\", \"\", "
           "false, false); }\n";
     os << "public:\nvoid runAll(std::string inputDirectoryArg = \"\", std::string outputDirectoryArg = \"\", "
           "bool performIOArg=true, bool pruneImdtRelsArg=true) override { ";
@@ -2732,6 +3892,16 @@ void runFunction(std::string  inputDirectoryArg,
         os << "if (profiler.joinable()) { profiler.join(); }\n";
     }
     os << "}\n";
+    if (native) {
+        // the strata of a native library perform their IO, as the interpreted strata do
+        os << "public:\n";
+        os << "void setDirectories(std::string inputDirectoryArg, std::string outputDirectoryArg) {\n";
+        os << "inputDirectory = std::move(inputDirectoryArg);\n";
+        os << "outputDirectory = std::move(outputDirectoryArg);\n";
+        os << "performIO = true;\n";
+        os << "pruneImdtRels = true;\n";
+        os << "}\n";
+    }
     // issue printAll method
     os << "public:\n";
     os << "void printAll(std::string outputDirectoryArg = \"\") override {\n";
@@ -2789,6 +3959,22 @@ void runFunction(std::string  inputDirectoryArg,
     }
 
     os << "}\n";  // end of loadAll() method
+
+    // issue compactInputs method, which lays out the loaded b-trees densely before serving requests
+    os << "public:\n";
+    os << "void compactInputs() {\n";
+    std::set<std::string> loaded;
+    for (auto load : loadIOs) {
+        const ram::Relation* rel = lookup(load->getRelation());
+        bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
+        auto relationType = Relation::getSynthesiserRelation(*rel,
+                idxAnalysis.getIndexSelection(rel->getName()),
+                Global::config().has("provenance") && !isProvInfo);
+        if (loaded.insert(rel->getName()).second && relationType->isCompactable()) {
+            os << getRelationName(*rel) << "->compact();\n";
+        }
+    }
+    os << "}\n";  // end of compactInputs() method
     // issue dump methods
     auto dumpRelation = [&](const ram::Relation& ramRelation) {
         const auto& relName = getRelationName(ramRelation);
@@ -2845,6 +4031,9 @@ void runFunction(std::string  inputDirectoryArg,
     os << "recordTable.setNumLanes(getNumThreads());\n";
     os << "}\n";  // end of setNumThreads
 
+    // definitions of the subroutines in separate translation units
+    std::vector<std::string> definitions;
+
     if (!prog.getSubroutines().empty()) {
         // generate subroutine adapter
         os << "void executeSubroutine(std::string name, const std::vector<RamDomain>& args, "
@@ -2852,6 +4041,10 @@ void runFunction(std::string  inputDirectoryArg,
         // subroutine number
         std::size_t subroutineNum = 0;
         for (auto& sub : prog.getSubroutines()) {
+            if (native && !contains(nativeStrata, sub.first)) {
+                subroutineNum++;
+                continue;
+            }
             os << "if (name == \"" << sub.first << "\") {\n"
                << "subroutine_" << subroutineNum
                << "(args, ret);\n"  // subroutine_<i> to deal with special characters in relation names
@@ -2863,36 +4056,138 @@ void runFunction(std::string  inputDirectoryArg,
         os << "}\n";  // end of executeSubroutine
 
         // generate method for each subroutine
+        const auto temperatures = getStratumTemperatures();
         subroutineNum = 0;
         for (auto& sub : prog.getSubroutines()) {
+            if (native && !contains(nativeStrata, sub.first)) {
+                subroutineNum++;
+                continue;
+            }
+            // the method is defined in the class, or declared in the class and defined in a separate
+            // translation unit when splitting
+            std::stringstream definition;
+            auto& out = (split == nullptr) ? static_cast<std::ostream&>(os) : definition;
+            const std::string signature = "subroutine_" + std::to_string(subroutineNum) +
+                                          "(const std::vector<RamDomain>& args, std::vector<RamDomain>& ret)";
+            auto temperature = temperatures.find(sub.first);
+            const std::string attribute = temperature == temperatures.end() ? "" : temperature->second + " ";
+            if (split != nullptr) {
+                os << attribute << "void " << signature << ";\n";
+            }
+
             // silence unused argument warnings on MSVC
-            os << "#ifdef _MSC_VER\n";
-            os << "#pragma warning(disable: 4100)\n";
-            os << "#endif // _MSC_VER\n";
+            out << "#ifdef _MSC_VER\n";
+            out << "#pragma warning(disable: 4100)\n";
+            out << "#endif // _MSC_VER\n";
 
             // issue method header
-            os << "void "
-               << "subroutine_" << subroutineNum
-               << "(const std::vector<RamDomain>& args, "
-                  "std::vector<RamDomain>& ret) {\n";
+            if (split == nullptr) {
+                out << attribute << "void " << signature << " {\n";
+            } else {
+                out << "void " << classname << "::" << signature << " {\n";
+            }
 
             // issue lock variable for return statements
             bool needLock = false;
             visit(*sub.second, [&](const SubroutineReturn&) { needLock = true; });
             if (needLock) {
-                os << "std::mutex lock;\n";
+                out << "std::mutex lock;\n";
+            }
+
+            // build the indexes not maintained while the relations read by a stratum were computed
+            if (isPrefix("stratum_", sub.first)) {
+                std::set<std::string> read;
+                std::set<std::string> written;
+                visit(*sub.second, [&](const RelationOperation& op) { read.insert(op.getRelation()); });
+                visit(*sub.second, [&](const AbstractExistenceCheck& op) { read.insert(op.getRelation()); });
+                visit(*sub.second, [&](const Insert& insert) { written.insert(insert.getRelation()); });
+                for (const auto& name : read) {
+                    const ram::Relation* rel = lookup(name);
+                    bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
+                    auto relationType = Relation::getSynthesiserRelation(*rel,
+                            idxAnalysis.getIndexSelection(name),
+                            Global::config().has("provenance") && !isProvInfo);
+                    if (!contains(written, name) && relationType->hasOnDemandIndexes()) {
+                        out << getRelationName(*rel) << "->buildIndexes();\n";
+                    }
+                }
             }
 
             // emit code for subroutine
-            emitCode(os, *sub.second);
+            emitCode(out, *sub.second);
+
+            // rebuild the b-trees of the relations computed by a stratum densely
+            if (Global::config().has("compact-relations") && isPrefix("stratum_", sub.first)) {
+                std::set<std::string> written;
+                visit(*sub.second, [&](const Insert& insert) { written.insert(insert.getRelation()); });
+                for (const auto& name : written) {
+                    const ram::Relation* rel = lookup(name);
+                    bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
+                    auto relationType = Relation::getSynthesiserRelation(*rel,
+                            idxAnalysis.getIndexSelection(name),
+                            Global::config().has("provenance") && !isProvInfo);
+                    if (!rel->isTemp() && relationType->isCompactable()) {
+                        out << getRelationName(*rel) << "->compact();\n";
+                    }
+                }
+            }
+
+            // place the sharded relations computed by a stratum in the memory of their nodes, and freeze
+            // their b-trees, which the remaining strata only read
+            if (isPrefix("stratum_", sub.first)) {
+                std::set<std::string> written;
+                visit(*sub.second, [&](const Insert& insert) { written.insert(insert.getRelation()); });
+                visit(*sub.second, [&](const IO& io) {
+                    if (io.get("operation") == "input") {
+                        written.insert(io.getRelation());
+                    }
+                });
+                for (const auto& name : written) {
+                    const ram::Relation* rel = lookup(name);
+                    bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
+                    auto relationType = Relation::getSynthesiserRelation(*rel,
+                            idxAnalysis.getIndexSelection(name),
+                            Global::config().has("provenance") && !isProvInfo);
+                    if (!rel->isTemp() && relationType->isPlaceable()) {
+                        out << getRelationName(*rel) << "->place();\n";
+                    }
+                    if (!rel->isTemp() && relationType->isFreezable()) {
+                        out << getRelationName(*rel) << "->freeze();\n";
+                    }
+                }
+            }
+
+            // fill the Bloom filters of the stable relations computed by a stratum
+            if (Global::config().has("bloom-filters") && isPrefix("stratum_", sub.first)) {
+                std::set<std::string> written;
+                visit(*sub.second, [&](const Insert& insert) { written.insert(insert.getRelation()); });
+                visit(*sub.second, [&](const IO& io) {
+                    if (io.get("operation") == "input") {
+                        written.insert(io.getRelation());
+                    }
+                });
+                for (const auto& name : written) {
+                    const ram::Relation* rel = lookup(name);
+                    bool isProvInfo = rel->getRepresentation() == RelationRepresentation::INFO;
+                    auto relationType = Relation::getSynthesiserRelation(*rel,
+                            idxAnalysis.getIndexSelection(name),
+                            Global::config().has("provenance") && !isProvInfo);
+                    if (relationType->isFiltered()) {
+                        out << getRelationName(*rel) << "->buildFilter();\n";
+                    }
+                }
+            }
 
             // issue end of subroutine
-            os << "}\n";
+            out << "}\n";
 
             // restore unused argument warning
-            os << "#ifdef _MSC_VER\n";
-            os << "#pragma warning(default: 4100)\n";
-            os << "#endif // _MSC_VER\n";
+            out << "#ifdef _MSC_VER\n";
+            out << "#pragma warning(default: 4100)\n";
+            out << "#endif // _MSC_VER\n";
+            if (split != nullptr) {
+                definitions.push_back(definition.str());
+            }
             subroutineNum++;
         }
     }
@@ -2904,21 +4199,126 @@ void runFunction(std::string  inputDirectoryArg,
         os << "void dumpFreqs() {\n";
         for (auto const& cur : idxMap) {
             os << "\tProfileEventSingleton::instance().makeQuantityEvent(R\"_(" << cur.first << ")_\", freqs["
-               << cur.second << "],0);\n";
+               << cur.second << "].load(),0);\n";
         }
         for (auto const& cur : neIdxMap) {
             os << "\tProfileEventSingleton::instance().makeQuantityEvent(R\"_(@relation-reads;" << cur.first
-               << ")_\", reads[" << cur.second << "],0);\n";
+               << ")_\", reads[" << cur.second << "].load(),0);\n";
         }
+        if (Global::config().has("profile-frequency")) {
+            auto& idxAnalysis = translationUnit.getAnalysis<IndexAnalysis>();
+            for (const auto* rel : prog.getRelations()) {
+                const std::size_t first = lookupIndexAccessIdx(rel->getName(), 0);
+                const auto orders = idxAnalysis.getIndexSelection(rel->getName()).getAllOrders();
+                for (std::size_t i = 0; i < orders.size(); ++i) {
+                    // the tuples are inserted into the first index, and into the others if they are new
+                    const std::string counters = "indexAccesses[" + std::to_string(first + i) + "]";
+                    os << "\tProfileEventSingleton::instance().makeIndexAccessEvent(R\"_(" << rel->getName()
+                       << ")_\", \"[" << join(orders[i]) << "]\", " << counters << "[0].load(), " << counters
+                       << "[1].load(), " << counters << "[2].load(), indexAccesses[" << first
+                       << "][3].load());\n";
+                }
+            }
+        }
+        os << "\tProfileEventSingleton::instance().makeAllocatorEvents();\n";
+        os << "\tProfileEventSingleton::instance().makeLockEvents();\n";
         os << "}\n";  // end of dumpFreqs() method
     }
+
+    if (native) {
+        *recordTable_os << "RecordTable& recordTable;\n";
+    } else {
+        *recordTable_os << "SpecializedRecordTable<0";
+        for (std::size_t arity : arities) {
+            if (arity > 0) {
+                *recordTable_os << "," << arity;
+            }
+        }
+        *recordTable_os << "> recordTable{};\n";
+    }
+
+    for (const auto& [pattern, number] : regexPatterns) {
+        *regex_os << "const souffle::evaluator::CompiledRegex regex_" << number
+                  << " = souffle::evaluator::compileRegex(R\"_(" << pattern << ")_\");\n";
+    }
+
     os << "};\n";  // end of class declaration
 
+    if (split != nullptr) {
+        // the class goes to the header, the remaining entry points to the main translation unit
+        os << "}  // namespace souffle\n";
+        std::stringstream header;
+        header << "#pragma once\n";
+        os.flushAll(header);
+        split->header = header.str();
+        os << "#include \"" << split->headerName << "\"\n";
+        os << "namespace souffle {\n";
+        os << mainDefinitions.str();
+
+        // Group consecutive subroutines into translation units. A unit ends after a subroutine whose code
+        // hashes to a multiple of the expected number of subroutines per unit, rather than at a given size,
+        // such that editing a stratum only changes the unit holding it, and the others are not recompiled.
+        // Units are capped at twice the average size.
+        std::size_t totalSize = 0;
+        for (const auto& definition : definitions) {
+            totalSize += definition.size();
+        }
+        assert(split->count > 0 && "no translation units");
+        const std::size_t maxSize = 2 * ((totalSize + split->count - 1) / split->count);
+        const std::size_t perUnit = std::max<std::size_t>(1, definitions.size() / split->count);
+        auto hashCode = [](const std::string& code) {
+            // FNV-1a, which is stable across compilers and runs
+            uint64_t hash = 14695981039346656037ull;
+            for (char c : code) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+            return hash;
+        };
+        std::stringstream unit;
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < definitions.size(); ++i) {
+            if (size == 0) {
+                unit << "#include \"" << split->headerName << "\"\n";
+                unit << "namespace souffle {\n";
+            }
+            unit << definitions[i];
+            size += definitions[i].size();
+            if (hashCode(definitions[i]) % perUnit == 0 || size >= maxSize || i + 1 == definitions.size()) {
+                unit << "}  // namespace souffle\n";
+                split->units.push_back(unit.str());
+                unit.str("");
+                size = 0;
+            }
+        }
+    }
+
+    if (native) {
+        generateNativeInterface(os, classname, nativeStrata);
+        os.flushAll(sos);
+        return;
+    }
+
     // hidden hooks
     os << "SouffleProgram *newInstance_" << id << "(){return new " << classname << ";}\n";
     os << "SymbolTable *getST_" << id << "(SouffleProgram *p){return &reinterpret_cast<" << classname
        << "*>(p)->getSymbolTable();}\n";
 
+    // a shared library is loaded by the application, which creates independent instances by its entry
+    // points rather than by the factories registered process-wide
+    if (Global::config().has("shared-library")) {
+        os << "}  // namespace souffle\n";
+        os << "extern \"C\" {\n";
+        os << "souffle::SouffleProgram* souffle_program_create() {\n";
+        os << "return new souffle::" << classname << "();\n";
+        os << "}\n";
+        os << "void souffle_program_destroy(souffle::SouffleProgram* program) {\n";
+        os << "delete program;\n";
+        os << "}\n";
+        os << "}\n";
+        os.flushAll(sos);
+        return;
+    }
+
     os << "\n#ifdef __EMBEDDED_SOUFFLE__\n";
     os << "class factory_" << classname << ": public souffle::ProgramFactory {\n";
     os << "SouffleProgram *newInstance() {\n";
@@ -2949,6 +4349,9 @@ void runFunction(std::string  inputDirectoryArg,
         os << "R\"()\",\n";
     }
     os << std::stoi(Global::config().get("jobs"));
+    if (Global::config().has("only-relations")) {
+        os << ",\nR\"(" << Global::config().get("only-relations") << ")\"";
+    }
     os << ");\n";
 
     os << "if (!opt.parse(argc,argv)) return 1;\n";
@@ -2976,6 +4379,10 @@ void runFunction(std::string  inputDirectoryArg,
         os << R"_(souffle::ProfileEventSingleton::instance().makeConfigRecord("version", ")_"
            << Global::config().get("version") << R"_(");)_" << '\n';
     }
+    os << "if (!opt.getServeSocket().empty()) {\n";
+    os << "return souffle::serveRequests(obj, opt);\n";
+    os << "}\n";
+    os << "obj.setRequestedRelations(opt.getOnlyRelations());\n";
     os << "obj.runAll(opt.getInputFileDir(), opt.getOutputFileDir());\n";
 
     if (Global::config().get("provenance") == "explain") {
@@ -2988,15 +4395,129 @@ void runFunction(std::string  inputDirectoryArg,
     os << "}\n";
     os << "\n#endif\n";
 
-    *recordTable_os << "SpecializedRecordTable<0";
-    for (std::size_t arity : arities) {
-        if (arity > 0) {
-            *recordTable_os << "," << arity;
+    os.flushAll(sos);
+}
+
+std::map<std::string, std::string> Synthesiser::getStratumTemperatures() {
+    std::map<std::string, std::string> temperatures;
+    if (!Global::config().has("profile-use")) {
+        return temperatures;
+    }
+    auto run = std::make_shared<profile::ProgramRun>();
+    profile::Reader(Global::config().get("profile-use"), run).processFile();
+
+    // the time of a stratum is the time evaluating the relations it computes
+    std::vector<std::pair<long, std::string>> times;
+    long total = 0;
+    for (const auto& [name, stratum] : translationUnit.getProgram().getSubroutines()) {
+        if (!isPrefix("stratum_", name)) {
+            continue;
+        }
+        std::set<std::string> computed;
+        visit(*stratum, [&](const Insert& insert) { computed.insert(insert.getRelation()); });
+        long time = 0;
+        for (const auto& relation : computed) {
+            if (const auto* profile = run->getRelation(relation)) {
+                time += (profile->getNonRecTime() + profile->getRecTime()).count();
+            }
+        }
+        times.emplace_back(time, name);
+        total += time;
+    }
+    if (total == 0) {
+        return temperatures;
+    }
+
+    // the strata taking most of the time are hot, the ones taking a negligible share of it are cold
+    std::sort(times.rbegin(), times.rend());
+    long covered = 0;
+    for (const auto& [time, name] : times) {
+        if (covered < total / 10 * 9) {
+            temperatures[name] = "SOUFFLE_HOT";
+        } else if (time * 1000 < total) {
+            temperatures[name] = "SOUFFLE_COLD";
         }
+        covered += time;
     }
-    *recordTable_os << "> recordTable{};\n";
+    return temperatures;
+}
 
-    os.flushAll(sos);
+void Synthesiser::generateNativeInterface(
+        std::ostream& os, const std::string& classname, const std::set<std::string>& strata) {
+    os << "}  // namespace souffle\n";
+    os << "extern \"C\" {\n";
+    os << "using namespace souffle;\n";
+
+    os << "const char* souffle_native_symbol(std::size_t index) {\n";
+    if (symbolIndex.empty()) {
+        os << "return nullptr;\n";
+    } else {
+        os << "static const char* const symbols[] = {\n";
+        for (const auto& symbol : symbolIndex) {
+            os << "\tR\"_(" << symbol << ")_\",\n";
+        }
+        os << "};\n";
+        os << "return index < " << symbolIndex.size() << " ? symbols[index] : nullptr;\n";
+    }
+    os << "}\n";
+
+    os << "void* souffle_native_create(void* symbolTable, void* recordTable, const char* inputDirectory, "
+          "const char* outputDirectory, std::size_t numThreads) {\n";
+    os << "auto* program = new " << classname
+       << "(*static_cast<SymbolTable*>(symbolTable), *static_cast<RecordTable*>(recordTable));\n";
+    // the lanes of the tables are set by the interpreter
+    os << "program->SouffleProgram::setNumThreads(numThreads);\n";
+    os << "program->setDirectories(inputDirectory, outputDirectory);\n";
+    os << "return program;\n";
+    os << "}\n";
+
+    os << "void souffle_native_destroy(void* program) {\n";
+    os << "delete static_cast<" << classname << "*>(program);\n";
+    os << "}\n";
+
+    os << "int souffle_native_provides(const char* stratum) {\n";
+    os << "const std::string name(stratum);\n";
+    os << "return " << (strata.empty() ? "0" : "");
+    os << join(strata, " || ", [](auto&& out, auto&& name) { out << "name == \"" << name << "\""; });
+    os << ";\n";
+    os << "}\n";
+
+    os << "void souffle_native_run(void* program, const char* stratum) {\n";
+    os << "std::vector<RamDomain> args, ret;\n";
+    os << "static_cast<" << classname << "*>(program)->executeSubroutine(stratum, args, ret);\n";
+    os << "}\n";
+
+    os << "int souffle_native_insert(void* program, const char* relation, const RamDomain* tuples, "
+          "std::size_t count) {\n";
+    os << "Relation* rel = static_cast<" << classname << "*>(program)->getRelation(relation);\n";
+    os << "if (rel == nullptr) { return 0; }\n";
+    os << "const std::size_t arity = rel->getArity();\n";
+    os << "tuple t(rel);\n";
+    os << "for (std::size_t i = 0; i < count; ++i) {\n";
+    os << "for (std::size_t j = 0; j < arity; ++j) { t[j] = tuples[i * arity + j]; }\n";
+    os << "rel->insert(t);\n";
+    os << "}\n";
+    os << "return 1;\n";
+    os << "}\n";
+
+    os << "int souffle_native_scan(void* program, const char* relation, "
+          "void (*visitor)(void* context, const RamDomain* tuple), void* context) {\n";
+    os << "Relation* rel = static_cast<" << classname << "*>(program)->getRelation(relation);\n";
+    os << "if (rel == nullptr) { return 0; }\n";
+    os << "std::vector<RamDomain> values(rel->getArity());\n";
+    os << "for (const tuple& t : *rel) {\n";
+    os << "for (std::size_t j = 0; j < values.size(); ++j) { values[j] = t[j]; }\n";
+    os << "visitor(context, values.data());\n";
+    os << "}\n";
+    os << "return 1;\n";
+    os << "}\n";
+
+    os << "void souffle_native_purge(void* program, const char* relation) {\n";
+    os << "if (Relation* rel = static_cast<" << classname << "*>(program)->getRelation(relation)) {\n";
+    os << "rel->purge();\n";
+    os << "}\n";
+    os << "}\n";
+    os << "}\n";
 }
 
 }  // namespace souffle::synthesiser
@@ -30,9 +30,30 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace souffle::synthesiser {
 
+/**
+ * Generated code split into several translation units, which are compiled in parallel.
+ *
+ * The program class is declared in a header included by all translation units, and its
+ * subroutines, i.e. the strata, are defined in separate translation units.
+ */
+struct SplitSources {
+    /** Name of the header, as included by the translation units */
+    std::string headerName;
+
+    /** Maximum number of translation units defining the subroutines */
+    std::size_t count = 1;
+
+    /** The header declaring the program class */
+    std::string header;
+
+    /** The translation units defining the subroutines */
+    std::vector<std::string> units;
+};
+
 /**
  * A RAM synthesiser: synthesises a C++ program from a RAM program.
  */
@@ -52,6 +73,12 @@ private:
     /** Frequency profiling of non-existence checks */
     std::map<std::string, std::size_t> neIdxMap;
 
+    /** Index access profiling, the first counter of the indexes of each relation */
+    std::map<std::string, std::size_t> indexAccessIdxMap;
+
+    /** Number of index access counters */
+    std::size_t numIndexAccesses = 0;
+
     /** Cache for generated types for relations */
     std::set<std::string> typeCache;
 
@@ -67,6 +94,15 @@ private:
     /** Is set to true if there is a need to include std::regex */
     bool UsingStdRegex = false;
 
+    /** Is set to true if there is a need to include the sketches of approximate counts */
+    bool UsingHyperLogLog = false;
+
+    /** Constant patterns of match constraints, compiled once by the program, and their numbers */
+    std::map<std::string, std::size_t> regexPatterns;
+
+    /** Is set to true if output relations are written in the background */
+    bool asyncOutput = false;
+
     /** Set of packed and unpacked records arities */
     std::set<std::size_t> arities;
 
@@ -90,12 +126,28 @@ protected:
     /** Generate code */
     void emitCode(std::ostream& out, const ram::Statement& stmt);
 
+    /**
+     * Return the attributes marking the stratum subroutines hot or cold by the time spent in them in the
+     * profile given by `profile-use`, such that the compiler groups the hot code of the program
+     */
+    std::map<std::string, std::string> getStratumTemperatures();
+
+    /** Generate the C interface of a library of the given native strata, see souffle/NativeStrata.h */
+    void generateNativeInterface(
+            std::ostream& os, const std::string& classname, const std::set<std::string>& strata);
+
     /** Lookup frequency counter */
     unsigned lookupFreqIdx(const std::string& txt);
 
     /** Lookup read counter */
     std::size_t lookupReadIdx(const std::string& txt);
 
+    /** Lookup index access counter of an index of a relation */
+    std::size_t lookupIndexAccessIdx(const std::string& relation, std::size_t index);
+
+    /** Return the number of index access counters, one per index of each relation */
+    std::size_t getIndexAccessCount();
+
     /** Lookup relation by relation name */
     const ram::Relation* lookup(const std::string& relName) {
         auto it = relationMap.find(relName);
@@ -130,7 +182,13 @@ public:
         return translationUnit;
     }
 
-    /** Generate code */
-    void generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary);
+    /**
+     * Generate code
+     *
+     * If split sources are given, the subroutines are defined in their translation units, and
+     * os receives the translation unit defining the entry points of the program.
+     */
+    void generateCode(std::ostream& os, const std::string& id, bool& withSharedLibrary,
+            SplitSources* split = nullptr);
 };
 }  // namespace souffle::synthesiser
@@ -0,0 +1,156 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file arrow_stream_test.cpp
+ *
+ * Test cases for writing and reading relations as Parquet and Arrow IPC files.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/IOSystem.h"
+#include "souffle/utility/FileUtil.h"
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+using Tuple = std::array<RamDomain, 2>;
+
+/** A relation of the tuples written, and recording the tuples read in order */
+struct Relation {
+    std::vector<Tuple> tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.push_back({tuple[0], tuple[1]});
+    }
+
+    std::size_t size() const {
+        return tuples.size();
+    }
+
+    std::vector<Tuple>::const_iterator begin() const {
+        return tuples.begin();
+    }
+
+    std::vector<Tuple>::const_iterator end() const {
+        return tuples.end();
+    }
+};
+
+std::map<std::string, std::string> makeDirective(const std::string& io, const std::string& fileName) {
+    return {{"IO", io}, {"name", "rel"}, {"filename", fileName},
+            {"types", R"({"relation": {"arity": 2, "types": ["s:symbol", "i:number"]}})"},
+            {"params", R"({"relation": {"arity": 2, "params": ["key", "value"]}})"}};
+}
+
+/** The relation of the given number of tuples, with symbols repeated as in dictionaries */
+Relation makeRelation(SymbolTable& symbolTable, RamDomain count) {
+    Relation relation;
+    for (RamDomain i = 0; i < count; ++i) {
+        relation.tuples.push_back({symbolTable.encode("key" + std::to_string(i % 7)), i - count / 2});
+    }
+    return relation;
+}
+
+/** Write the relation and read it back, into a new symbol table */
+Relation roundTrip(const std::string& io, const Relation& relation, const SymbolTable& symbolTable,
+        SymbolTable& readSymbolTable) {
+    const std::string fileName = tempFile();
+    const auto directive = makeDirective(io, fileName);
+    SpecializedRecordTable<0> recordTable;
+    // the file is completed when the writer is destroyed
+    IOSystem::getInstance().getWriter(directive, symbolTable, recordTable)->writeAll(relation);
+
+    Relation result;
+    IOSystem::getInstance().getReader(directive, readSymbolTable, recordTable)->readAll(result);
+    std::remove(fileName.c_str());
+    return result;
+}
+
+/** Whether the relations hold the same values in the same order */
+bool isEqual(const Relation& lhs, const SymbolTable& lhsSymbols, const Relation& rhs,
+        const SymbolTable& rhsSymbols) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhsSymbols.decode(lhs.tuples[i][0]) != rhsSymbols.decode(rhs.tuples[i][0]) ||
+                lhs.tuples[i][1] != rhs.tuples[i][1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(ArrowStream, RoundTrip) {
+    for (const std::string io : {"parquet", "arrow"}) {
+        // more tuples than fit into a batch, and none
+        for (RamDomain count : {0, 1, 1000, 70000}) {
+            SymbolTable symbolTable;
+            const Relation relation = makeRelation(symbolTable, count);
+            SymbolTable readSymbolTable;
+            const Relation result = roundTrip(io, relation, symbolTable, readSymbolTable);
+            EXPECT_TRUE(isEqual(relation, symbolTable, result, readSymbolTable));
+        }
+    }
+}
+
+TEST(ArrowStream, Columns) {
+    for (const std::string io : {"parquet", "arrow"}) {
+        const std::string fileName = tempFile();
+        SymbolTable symbolTable;
+        SpecializedRecordTable<0> recordTable;
+        IOSystem::getInstance()
+                .getWriter(makeDirective(io, fileName), symbolTable, recordTable)
+                ->writeAll(makeRelation(symbolTable, 100));
+
+        // the columns are read by the names of the attributes, in the order of the relation
+        auto directive = makeDirective(io, fileName);
+        directive["types"] = R"({"relation": {"arity": 2, "types": ["i:number", "s:symbol"]}})";
+        directive["params"] = R"({"relation": {"arity": 2, "params": ["value", "key"]}})";
+        Relation result;
+        IOSystem::getInstance().getReader(directive, symbolTable, recordTable)->readAll(result);
+        EXPECT_EQ(100, result.size());
+        for (RamDomain i = 0; i < 100; ++i) {
+            EXPECT_EQ(i - 50, result.tuples[i][0]);
+            EXPECT_EQ("key" + std::to_string(i % 7), symbolTable.decode(result.tuples[i][1]));
+        }
+
+        // files without a column of an attribute are rejected
+        directive["params"] = R"({"relation": {"arity": 2, "params": ["value", "missing"]}})";
+        bool thrown = false;
+        try {
+            IOSystem::getInstance().getReader(directive, symbolTable, recordTable)->readAll(result);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        EXPECT_TRUE(thrown);
+        std::remove(fileName.c_str());
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,63 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file async_output_test.cpp
+ *
+ * Test cases for the background writer of output relations.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/io/AsyncOutput.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+namespace souffle {
+
+namespace test {
+
+TEST(AsyncOutput, WaitForRelation) {
+    int a = 0;
+    int b = 0;
+    std::atomic<std::size_t> writesOfA{0};
+    std::atomic<std::size_t> writesOfB{0};
+
+    AsyncOutput output(2);
+    for (std::size_t i = 0; i < 8; i++) {
+        output.submit(&a, [&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++writesOfA;
+        });
+        output.submit(&b, [&]() { ++writesOfB; });
+    }
+
+    // waiting for a relation completes all of its writes
+    output.wait(&a);
+    EXPECT_EQ(writesOfA, 8);
+
+    output.wait();
+    EXPECT_EQ(writesOfB, 8);
+
+    // a relation without writes is not waited for
+    output.wait(&a);
+    EXPECT_EQ(writesOfA, 8);
+}
+
+TEST(AsyncOutput, Unused) {
+    // no threads are started without writes
+    AsyncOutput output(4);
+    output.wait();
+}
+
+}  // namespace test
+}  // namespace souffle
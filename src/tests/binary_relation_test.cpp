@@ -525,6 +525,72 @@ TEST(EqRelTest, IterPartition) {
     EXPECT_EQ(br.size(), values.size());
 }
 
+TEST(EqRelTest, IterIncremental) {
+    EqRel br;
+
+    // interleave batches of insertions with scans, so that the cached partition is updated
+    // incrementally: new elements, new classes, and classes merging with each other
+    const std::size_t N = 64;
+    for (std::size_t batch = 0; batch < 4; ++batch) {
+        for (std::size_t i = 0; i < N; ++i) {
+            br.insert(batch * N + i, batch * N + (i % (batch + 1)));
+        }
+        if (batch == 3) {
+            br.insert(0, N);
+        }
+
+        std::size_t count = 0;
+        for (auto x : br) {
+            EXPECT_TRUE(br.contains(x[1], x[0]));
+            ++count;
+        }
+        EXPECT_EQ(count, br.size());
+
+        std::size_t expected = 0;
+        for (std::size_t b = 0; b <= batch; ++b) {
+            // each batch forms b + 1 classes of N / (b + 1) elements (rounded)
+            for (std::size_t c = 0; c <= b; ++c) {
+                const std::size_t s = (N - c + b) / (b + 1);
+                expected += s * s;
+            }
+        }
+        if (batch == 3) {
+            // merges the first two classes of size N and N / 2
+            expected += 2 * N * (N / 2);
+        }
+        EXPECT_EQ(expected, br.size());
+    }
+    EXPECT_FALSE(br.empty());
+    br.clear();
+    EXPECT_TRUE(br.empty());
+    EXPECT_EQ(0, br.size());
+}
+
+TEST(EqRelTest, BulkInsert) {
+    EqRel br;
+
+    // chains 0 - 1 - ... - N-1 and N - ... - 2N-1, inserted in a shuffled order
+    const std::size_t N = 1000;
+    std::vector<std::pair<RamDomain, RamDomain>> pairs;
+    for (std::size_t i = 1; i < N; ++i) {
+        pairs.emplace_back(i - 1, i);
+        pairs.emplace_back(N + i, N + i - 1);
+    }
+    std::mt19937 generator(3);
+    std::shuffle(pairs.begin(), pairs.end(), generator);
+    br.insertAll(pairs);
+
+    EXPECT_EQ(2 * N * N, br.size());
+    EXPECT_TRUE(br.contains(0, N - 1));
+    EXPECT_TRUE(br.contains(2 * N - 1, N));
+    EXPECT_FALSE(br.contains(0, N));
+
+    // inserting implied pairs reports them as already present
+    EXPECT_TRUE(br.insert(N - 1, 0));
+    EXPECT_FALSE(br.insert(N - 1, N));
+    EXPECT_EQ(4 * N * N, br.size());
+}
+
 TEST(EqRelTest, Scaling) {
     const int N = 100;
 
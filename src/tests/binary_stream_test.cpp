@@ -0,0 +1,194 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file binary_stream_test.cpp
+ *
+ * Test cases for writing and reading relations as binary snapshots.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/BinaryFormat.h"
+#include "souffle/io/IOSystem.h"
+#include "souffle/utility/FileUtil.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+using Tuple = std::array<RamDomain, 3>;
+
+/** A relation of the tuples written, and recording the tuples read in order */
+struct Relation {
+    std::vector<Tuple> tuples;
+
+    void insert(const RamDomain* tuple) {
+        tuples.push_back({tuple[0], tuple[1], tuple[2]});
+    }
+
+    std::size_t size() const {
+        return tuples.size();
+    }
+
+    std::vector<Tuple>::const_iterator begin() const {
+        return tuples.begin();
+    }
+
+    std::vector<Tuple>::const_iterator end() const {
+        return tuples.end();
+    }
+};
+
+std::map<std::string, std::string> makeDirective(const std::string& fileName,
+        const std::string& types = R"(["s:symbol", "i:number", "f:float"])") {
+    return {{"IO", "binary"}, {"name", "rel"}, {"filename", fileName},
+            {"types", R"({"relation": {"arity": 3, "types": )" + types + "}}"},
+            {"params", R"({"relation": {"arity": 3, "params": ["s", "n", "f"]}})"}};
+}
+
+/** The relation of the given number of tuples, with symbols repeated within a block and across blocks */
+Relation makeRelation(SymbolTable& symbolTable, RamDomain count) {
+    Relation relation;
+    for (RamDomain i = 0; i < count; ++i) {
+        relation.tuples.push_back({symbolTable.encode("symbol " + std::to_string(i % 5000)), i - count / 2,
+                ramBitCast(static_cast<RamFloat>(i) / 4)});
+    }
+    return relation;
+}
+
+void writeRelation(const std::string& fileName, const Relation& relation, const SymbolTable& symbolTable) {
+    SpecializedRecordTable<0> recordTable;
+    // the snapshot is completed when the writer is destroyed
+    IOSystem::getInstance().getWriter(makeDirective(fileName), symbolTable, recordTable)->writeAll(relation);
+}
+
+/** Read the snapshot, or return the message of the error it is rejected with */
+std::string readRelation(
+        const std::map<std::string, std::string>& directive, SymbolTable& symbolTable, Relation& result) {
+    SpecializedRecordTable<0> recordTable;
+    try {
+        IOSystem::getInstance().getReader(directive, symbolTable, recordTable)->readAll(result);
+    } catch (const std::invalid_argument& e) {
+        return e.what();
+    }
+    return "";
+}
+
+/** Whether the relations hold the same values in the same order */
+bool isEqual(const Relation& lhs, const SymbolTable& lhsSymbols, const Relation& rhs,
+        const SymbolTable& rhsSymbols) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhsSymbols.decode(lhs.tuples[i][0]) != rhsSymbols.decode(rhs.tuples[i][0]) ||
+                lhs.tuples[i][1] != rhs.tuples[i][1] || lhs.tuples[i][2] != rhs.tuples[i][2]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(BinaryStream, RoundTrip) {
+    // more tuples than fit into a block, and none
+    for (RamDomain count : {0, 1, 4096, 10000}) {
+        const std::string fileName = tempFile();
+        SymbolTable symbolTable;
+        const Relation relation = makeRelation(symbolTable, count);
+        writeRelation(fileName, relation, symbolTable);
+
+        // the symbols are encoded into the symbol table of the reader, which holds others already
+        SymbolTable readSymbolTable;
+        readSymbolTable.encode("other");
+        Relation result;
+        EXPECT_EQ("", readRelation(makeDirective(fileName), readSymbolTable, result));
+        EXPECT_TRUE(isEqual(relation, symbolTable, result, readSymbolTable));
+        std::remove(fileName.c_str());
+    }
+}
+
+TEST(BinaryStream, Errors) {
+    const std::string fileName = tempFile();
+    SymbolTable symbolTable;
+    writeRelation(fileName, makeRelation(symbolTable, 5000), symbolTable);
+    std::ifstream file(fileName, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    const std::string name = baseName(fileName);
+
+    Relation result;
+    auto directive = makeDirective(fileName);
+    directive["types"] = R"({"relation": {"arity": 2, "types": ["s:symbol", "i:number"]}})";
+    EXPECT_EQ("arity mismatch in binary file " + name + "\n", readRelation(directive, symbolTable, result));
+
+    // the size of RamDomain of the writer
+    std::string other = bytes;
+    const std::uint32_t domain = sizeof(RamDomain) == 4 ? 8 : 4;
+    std::memcpy(&other[16], &domain, sizeof(domain));
+    std::ofstream(fileName, std::ios::binary) << other;
+    EXPECT_EQ("RamDomain size mismatch in binary file " + name + "\n",
+            readRelation(makeDirective(fileName), symbolTable, result));
+
+    // snapshots cut off within the tuples lack their symbol section, or cut off within the symbols
+    const std::size_t cut = binary_format::HEADER_SIZE + 4500 * 3 * sizeof(RamDomain);
+    std::ofstream(fileName, std::ios::binary) << bytes.substr(0, cut);
+    EXPECT_EQ("unexpected end of binary file in binary file " + name + "\n",
+            readRelation(makeDirective(fileName), symbolTable, result));
+    std::ofstream(fileName, std::ios::binary) << bytes.substr(0, bytes.size() - 2);
+    EXPECT_EQ("truncated symbol section in binary file " + name + "\n",
+            readRelation(makeDirective(fileName), symbolTable, result));
+
+    // the tuples beyond those stored are read from the symbol section, and rejected
+    other = bytes;
+    const std::uint64_t count = 1 << 16;
+    std::memcpy(&other[binary_format::TUPLE_COUNT_OFFSET], &count, sizeof(count));
+    std::ofstream(fileName, std::ios::binary) << other;
+    result.tuples.clear();
+    EXPECT_EQ("Invalid symbol reference in binary file " + name + "\n",
+            readRelation(makeDirective(fileName), symbolTable, result));
+    EXPECT_EQ(0, result.size() % binary_format::BLOCK_SIZE);
+
+    // records are neither written nor read
+    const std::string recordTypes = R"(["s:symbol", "r:Pair", "f:float"])";
+    std::ofstream(fileName, std::ios::binary) << bytes;
+    EXPECT_EQ("unsupported attribute type r:Pair in binary file " + name + "\n",
+            readRelation(makeDirective(fileName, recordTypes), symbolTable, result));
+    bool thrown = false;
+    try {
+        SpecializedRecordTable<0> recordTable;
+        IOSystem::getInstance().getWriter(makeDirective(fileName, recordTypes), symbolTable, recordTable);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    std::remove(fileName.c_str());
+}
+
+}  // namespace test
+}  // namespace souffle
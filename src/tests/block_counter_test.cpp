@@ -0,0 +1,70 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file block_counter_test.cpp
+ *
+ * Test cases for the counter of the auto-increment values.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/BlockCounter.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(BlockCounter, Dense) {
+    BlockCounter counter;
+    for (RamDomain i = 0; i < 100; i++) {
+        EXPECT_EQ(i, counter.next());
+    }
+    EXPECT_EQ(100, counter.reserved());
+}
+
+TEST(BlockCounter, Blocks) {
+    BlockCounter counter(64);
+    // the values of a single thread are consecutive
+    for (RamDomain i = 0; i < 100; i++) {
+        EXPECT_EQ(i, counter.next());
+    }
+    EXPECT_EQ(128, counter.reserved());
+
+    // a thread switching counters reserves a new block
+    BlockCounter other(64);
+    EXPECT_EQ(0, other.next());
+    EXPECT_EQ(128, counter.next());
+    EXPECT_EQ(192, counter.reserved());
+}
+
+TEST(BlockCounter, Parallel) {
+    const std::size_t N = 100000;
+    BlockCounter counter(16);
+
+    std::vector<RamDomain> values(N);
+#pragma omp parallel for
+    for (std::size_t i = 0; i < N; i++) {
+        values[i] = counter.next();
+    }
+
+    // the values are unique, leaving at most the rest of a block per thread unused
+    std::sort(values.begin(), values.end());
+    EXPECT_TRUE(std::adjacent_find(values.begin(), values.end()) == values.end());
+    EXPECT_LT(values.back(), counter.reserved());
+    EXPECT_EQ(std::size_t(0), counter.reserved() % 16);
+}
+
+}  // namespace test
+}  // namespace souffle
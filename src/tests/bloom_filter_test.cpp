@@ -0,0 +1,76 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file bloom_filter_test.cpp
+ *
+ * Test cases for the BloomFilter data structure.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/BloomFilter.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <cstddef>
+
+namespace souffle {
+
+namespace test {
+
+using t_tuple = Tuple<RamDomain, 2>;
+
+TEST(BloomFilter, Basic) {
+    BloomFilter filter;
+    EXPECT_FALSE(filter.isActive());
+    // an inactive filter may contain any tuple
+    EXPECT_TRUE(filter.mayContain(t_tuple{{1, 2}}));
+
+    filter.reset(10);
+    EXPECT_TRUE(filter.isActive());
+    EXPECT_FALSE(filter.mayContain(t_tuple{{1, 2}}));
+
+    filter.insert(t_tuple{{1, 2}});
+    filter.insert(t_tuple{{3, 4}});
+    EXPECT_TRUE(filter.mayContain(t_tuple{{1, 2}}));
+    EXPECT_TRUE(filter.mayContain(t_tuple{{3, 4}}));
+
+    filter.clear();
+    EXPECT_FALSE(filter.isActive());
+    EXPECT_TRUE(filter.mayContain(t_tuple{{5, 6}}));
+}
+
+TEST(BloomFilter, FalsePositives) {
+    const int N = 100000;
+    BloomFilter filter;
+    filter.reset(N);
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++) {
+        filter.insert(t_tuple{{i, 2 * i}});
+    }
+
+    // there are no false negatives
+    for (int i = 0; i < N; i++) {
+        EXPECT_TRUE(filter.mayContain(t_tuple{{i, 2 * i}}));
+    }
+
+    // and few false positives
+    int positives = 0;
+    for (int i = 0; i < N; i++) {
+        if (filter.mayContain(t_tuple{{i, 2 * i + 1}})) {
+            positives++;
+        }
+    }
+    EXPECT_LT(positives, N / 50);
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -27,6 +27,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <random>
 #include <set>
 #include <string>
@@ -658,6 +659,27 @@ TEST(SparseBitMap, Size) {
     EXPECT_EQ(3, map.size());
 }
 
+TEST(SparseBitMap, Count) {
+    SparseBitMap<> map;
+    std::set<uint64_t> ref;
+    for (int i = 0; i < 2000; i++) {
+        uint64_t x = random() % 5000;
+        map.set(x);
+        ref.insert(x);
+    }
+
+    for (uint64_t lower : {0, 1, 63, 64, 65, 1000, 4999}) {
+        for (uint64_t upper : {0, 63, 64, 127, 128, 2500, 4999, 10000}) {
+            std::size_t should = 0;
+            for (auto x : ref) {
+                should += (lower <= x && x <= upper) ? 1 : 0;
+            }
+            EXPECT_EQ(should, map.count(lower, upper));
+        }
+    }
+    EXPECT_EQ(ref.size(), map.count(0, std::numeric_limits<uint64_t>::max()));
+}
+
 TEST(SparseBitMap, CopyAndMerge) {
     SparseBitMap<> mapA;
     SparseBitMap<> mapB;
@@ -1576,6 +1598,28 @@ TEST(Trie, Merge_Stress) {
     }
 }
 
+TEST(Trie, Merge_Parallel_4D) {
+    using entry_t = typename Trie<4>::entry_type;
+
+    // sparse and dense first columns, such that merges of clones, leaves, and nested tries all occur
+    for (RamDomain range : {64, 100000}) {
+        std::set<entry_t> ref;
+        Trie<4> a;
+        Trie<4> b;
+        for (int i = 0; i < 20000; i++) {
+            entry_t e{(RamDomain)rand(range), (RamDomain)rand(8), (RamDomain)rand(100), (RamDomain)rand(3)};
+            ((i % 3 == 0) ? a : b).insert(e);
+            ref.insert(e);
+        }
+
+        a.insertAll(b);
+
+        std::set<entry_t> is(a.begin(), a.end());
+        EXPECT_EQ(ref, is);
+        EXPECT_EQ(ref.size(), a.size());
+    }
+}
+
 TEST(Trie, Merge_Bug) {
     // having this set ...
     Trie<2> a;
@@ -1644,6 +1688,39 @@ TEST(Trie, Size) {
     EXPECT_EQ(5, t.size());
 }
 
+TEST(Trie, CountBoundaries) {
+    Trie<3> t;
+    std::map<RamDomain, std::size_t> first;
+    std::map<std::pair<RamDomain, RamDomain>, std::size_t> second;
+    for (int i = 0; i < 5000; i++) {
+        RamDomain x = rand(10);
+        RamDomain y = rand(100);
+        RamDomain z = rand(1000);
+        if (t.insert({x, y, z})) {
+            first[x]++;
+            second[{x, y}]++;
+        }
+    }
+
+    EXPECT_EQ(t.size(), t.countBoundaries<0>({0, 0, 0}));
+    for (RamDomain x = 0; x < 11; x++) {
+        EXPECT_EQ(first[x], t.countBoundaries<1>({x, 0, 0}));
+        for (RamDomain y = 0; y < 100; y += 7) {
+            EXPECT_EQ((second[{x, y}]), t.countBoundaries<2>({x, y, 0}));
+        }
+    }
+    for (const auto& cur : t) {
+        EXPECT_EQ(1, t.countBoundaries<3>(cur));
+    }
+    EXPECT_EQ(0, t.countBoundaries<3>({0, 0, 1000}));
+
+    Trie<1> u;
+    u.insert({5});
+    EXPECT_EQ(1, u.countBoundaries<1>({5}));
+    EXPECT_EQ(0, u.countBoundaries<1>({6}));
+    EXPECT_EQ(1, u.countBoundaries<0>({0}));
+}
+
 TEST(Trie, Limits) {
     Trie<2> data;
 
@@ -1671,6 +1748,23 @@ TEST(Trie, Limits) {
     EXPECT_EQ(2, counter);
 }
 
+TEST(Trie, NegativeValues) {
+    Trie<1> data;
+    data.insert({-12});
+    data.insert({12});
+    EXPECT_TRUE(data.contains({-12}));
+    EXPECT_TRUE(data.contains({12}));
+    EXPECT_FALSE(data.contains({-13}));
+    EXPECT_EQ(2, data.size());
+
+    Trie<2> pairs;
+    pairs.insert({-3, 4});
+    pairs.insert({-3, -4});
+    pairs.insert({3, 4});
+    EXPECT_TRUE(pairs.contains({-3, -4}));
+    EXPECT_EQ(2, pairs.countBoundaries<1>({-3, 0}));
+}
+
 TEST(Trie, Parallel) {
     const int N = 10000;
 
@@ -0,0 +1,169 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file btree_delete_test.cpp
+ *
+ * A test case testing the erase operations of the B-trees supporting deletion.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/datastructure/BTreeDelete.h"
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using test_set = btree_delete_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+using test_multiset = btree_delete_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+TEST(BTreeDelete, EraseRange) {
+    const int N = 10000;
+
+    // erase small and large ranges, such that both strategies are covered
+    for (int width : {10, 100, 5000}) {
+        test_set t;
+        std::set<int> ref;
+        for (int i = 0; i < N; i++) {
+            t.insert(i);
+            ref.insert(i);
+        }
+
+        for (int lower = 17; lower < N; lower += 2 * width) {
+            const int upper = lower + width - 1;
+            EXPECT_EQ(ref.size() - t.size(), std::size_t(0));
+            const std::size_t erased = t.eraseRange(lower, upper);
+            std::size_t expected = 0;
+            for (int i = lower; i <= upper && i < N; i++) {
+                expected += ref.erase(i);
+            }
+            EXPECT_EQ(expected, erased);
+        }
+
+        EXPECT_EQ(ref.size(), t.size());
+        EXPECT_TRUE(std::equal(ref.begin(), ref.end(), t.begin()));
+        for (int i = 0; i < N; i++) {
+            EXPECT_EQ(ref.count(i) > 0, t.contains(i));
+        }
+    }
+
+    // an empty range
+    test_set t;
+    t.insert(1);
+    EXPECT_EQ(std::size_t(0), t.eraseRange(2, 1));
+    EXPECT_EQ(std::size_t(0), t.eraseRange(2, 5));
+    EXPECT_EQ(std::size_t(1), t.eraseRange(0, 5));
+    EXPECT_TRUE(t.empty());
+}
+
+TEST(BTreeDelete, EraseAll) {
+    const int N = 10000;
+    std::mt19937 gen(3);
+
+    // erase small and large batches, such that both strategies are covered
+    for (int batch : {10, 1000, 8000}) {
+        test_set t;
+        std::set<int> ref;
+        for (int i = 0; i < N; i++) {
+            t.insert(i);
+            ref.insert(i);
+        }
+
+        std::vector<int> keys;
+        std::uniform_int_distribution<int> dist(-10, N + 10);
+        for (int i = 0; i < batch; i++) {
+            keys.push_back(dist(gen));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::size_t expected = 0;
+        for (int key : keys) {
+            expected += ref.erase(key);
+        }
+        EXPECT_EQ(expected, t.eraseAll(keys.begin(), keys.end()));
+        EXPECT_EQ(ref.size(), t.size());
+        EXPECT_TRUE(std::equal(ref.begin(), ref.end(), t.begin()));
+
+        // the tree remains usable for further updates
+        for (int i = 0; i < N; i += 7) {
+            EXPECT_EQ(ref.insert(i).second, t.insert(i));
+        }
+        EXPECT_EQ(ref.size(), t.size());
+        EXPECT_TRUE(std::equal(ref.begin(), ref.end(), t.begin()));
+    }
+}
+
+TEST(BTreeDelete, EraseAllMultiSet) {
+    const int N = 1000;
+
+    for (int step : {50, 2}) {
+        test_multiset t;
+        std::multiset<int> ref;
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < 3; j++) {
+                t.insert(i);
+                ref.insert(i);
+            }
+        }
+
+        // all copies of an erased key are erased
+        std::vector<int> keys;
+        for (int i = 0; i < N; i += step) {
+            keys.push_back(i);
+        }
+        std::size_t expected = 0;
+        for (int key : keys) {
+            expected += ref.erase(key);
+        }
+        EXPECT_EQ(expected, t.eraseAll(keys.begin(), keys.end()));
+        EXPECT_EQ(ref.size(), t.size());
+        EXPECT_TRUE(std::equal(ref.begin(), ref.end(), t.begin()));
+    }
+}
+
+TEST(BTreeDelete, CompactSparseNodes) {
+    const int N = 100000;
+
+    // nodes of the default size, which are merged down to a quarter of their capacity
+    btree_delete_set<int> t;
+    btree_delete_set<int> u;
+    for (int i = 0; i < N; i++) {
+        t.insert(i);
+        u.insert(i);
+    }
+
+    // erasing many small batches spread over the tree leaves sparse nodes, which are compacted
+    for (int round = 0; round < 4; round++) {
+        for (int i = round; i < N; i += 500) {
+            std::vector<int> keys;
+            for (int j = i; j < i + 500 && j < N; j += 5) {
+                keys.push_back(j);
+                u.erase(j);
+            }
+            t.eraseAll(keys.begin(), keys.end());
+        }
+    }
+
+    EXPECT_EQ(std::size_t(N / 5), t.size());
+    EXPECT_EQ(u.size(), t.size());
+    EXPECT_LT(t.getNumNodes(), u.getNumNodes());
+    for (int i = 0; i < N; i++) {
+        EXPECT_EQ(i % 5 == 4, t.contains(i));
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
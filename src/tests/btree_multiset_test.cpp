@@ -365,6 +365,31 @@ TEST(BTreeMultiSet, Load) {
     }
 }
 
+TEST(BTreeMultiSet, Compact) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    for (int N = 1; N < 2000; N += 7) {
+        test_set t;
+
+        // insert every element twice
+        for (int i = 0; i < N; i++) {
+            t.insert(i);
+            t.insert(N - i - 1);
+        }
+
+        t.compact();
+        EXPECT_EQ((std::size_t)(2 * N), t.size());
+        EXPECT_TRUE(t.check());
+
+        int i = 0;
+        for (int c : t) {
+            EXPECT_EQ(i / 2, c);
+            i++;
+        }
+        EXPECT_EQ(2 * N, i);
+    }
+}
+
 TEST(BTreeMultiSet, Clear) {
     using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -20,7 +20,9 @@
 #include "souffle/utility/ContainerUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstddef>
 #include <cstdlib>
 #include <functional>
 #include <iomanip>
@@ -367,6 +369,47 @@ TEST(BTreeSet, IteratorBasic) {
     EXPECT_EQ(last, N);
 }
 
+TEST(BTreeSet, Spans) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+    test_set t;
+
+    std::vector<int> data;
+    for (int i = 0; i < 1000; i++) {
+        data.push_back(i);
+    }
+    std::mt19937 generator(42);
+    shuffle(data.begin(), data.end(), generator);
+
+    std::size_t spans = 0;
+    t.forEachSpan([&](const int*, const int*) { ++spans; });
+    EXPECT_EQ(0, spans);
+
+    for (int i : data) {
+        t.insert(i);
+    }
+
+    // the spans cover all elements in order, and some hold whole leaves
+    std::vector<int> elements;
+    std::size_t longest = 0;
+    t.forEachSpan([&](const int* first, const int* last) {
+        EXPECT_LT(first, last);
+        elements.insert(elements.end(), first, last);
+        longest = std::max(longest, static_cast<std::size_t>(last - first));
+    });
+    EXPECT_EQ(std::vector<int>(t.begin(), t.end()), elements);
+    EXPECT_LT(1, longest);
+
+    // the spans of a range stop at its bounds
+    for (int lower : {0, 17, 500, 999}) {
+        for (int upper : {lower, lower + 1, lower + 40, 1000}) {
+            std::vector<int> range;
+            t.forEachSpan(t.lower_bound(lower), t.lower_bound(upper),
+                    [&](const int* first, const int* last) { range.insert(range.end(), first, last); });
+            EXPECT_EQ(std::vector<int>(t.lower_bound(lower), t.lower_bound(upper)), range);
+        }
+    }
+}
+
 TEST(BTreeSet, IteratorStress) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -484,6 +527,43 @@ TEST(BTreeSet, Load) {
     }
 }
 
+TEST(BTreeSet, Compact) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    for (int N = 1; N < 2000; N += 7) {
+        test_set t;
+
+        // insert some data in a random order
+        std::vector<int> data;
+        for (int i = 0; i < N; i++) {
+            data.push_back(i);
+        }
+        std::shuffle(data.begin(), data.end(), std::mt19937(N));
+        for (int x : data) {
+            t.insert(x);
+        }
+        auto nodes = t.getNumNodes();
+
+        t.compact();
+        EXPECT_EQ(data.size(), t.size());
+        EXPECT_TRUE(t.check());
+        EXPECT_TRUE(t.getNumNodes() <= nodes);
+
+        int last = -1;
+        for (int c : t) {
+            EXPECT_EQ(last + 1, c);
+            last = c;
+        }
+        EXPECT_EQ(last, N - 1);
+
+        // the tree remains usable
+        EXPECT_FALSE(t.insert(0));
+        EXPECT_TRUE(t.insert(N));
+        EXPECT_TRUE(t.contains(N));
+        EXPECT_TRUE(t.check());
+    }
+}
+
 TEST(BTreeSet, Clear) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -501,6 +581,177 @@ TEST(BTreeSet, Clear) {
     EXPECT_TRUE(t.empty());
 }
 
+TEST(BTreeSet, Recycle) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    t.recycle();
+    EXPECT_TRUE(t.empty());
+
+    // refill the tree from its retained nodes in every round
+    for (int N = 1; N < 2000; N += 97) {
+        std::vector<int> data;
+        for (int i = 0; i < N; i++) {
+            data.push_back(i);
+        }
+        std::shuffle(data.begin(), data.end(), std::mt19937(N));
+        for (int x : data) {
+            EXPECT_TRUE(t.insert(x));
+        }
+        EXPECT_EQ(data.size(), t.size());
+        EXPECT_TRUE(t.check());
+
+        int last = -1;
+        for (int c : t) {
+            EXPECT_EQ(last + 1, c);
+            last = c;
+        }
+        EXPECT_EQ(last, N - 1);
+
+        t.recycle();
+        EXPECT_TRUE(t.empty());
+        EXPECT_FALSE(t.contains(0));
+    }
+
+    t.insert(1);
+    t.clear();
+    EXPECT_TRUE(t.empty());
+}
+
+TEST(BTreeSet, CountRange) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    EXPECT_EQ(0, t.countRange(0, 10));
+
+    // insert the even numbers in a random order
+    const int N = 1000;
+    std::vector<int> data;
+    for (int i = 0; i < N; i++) {
+        data.push_back(2 * i);
+    }
+    std::shuffle(data.begin(), data.end(), std::mt19937(N));
+    for (int x : data) {
+        t.insert(x);
+    }
+
+    auto count = [&](int lower, int upper) {
+        return static_cast<std::size_t>(std::distance(t.lower_bound(lower), t.upper_bound(upper)));
+    };
+    for (int lower = -3; lower < 2 * N + 3; lower += 7) {
+        for (int upper = lower; upper < 2 * N + 3; upper += 11) {
+            EXPECT_EQ(count(lower, upper), t.countRange(lower, upper));
+        }
+    }
+    EXPECT_EQ(N, t.countRange(0, 2 * N));
+    EXPECT_EQ(0, t.countRange(5, 3));
+
+    // counts follow subsequent modifications
+    t.insert(1);
+    EXPECT_EQ(2, t.countRange(0, 1));
+    t.compact();
+    EXPECT_EQ(N + 1, t.countRange(0, 2 * N));
+    t.clear();
+    EXPECT_EQ(0, t.countRange(0, 2 * N));
+}
+
+TEST(BTreeMultiSet, CountRange) {
+    using test_set = btree_multiset<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    // insert i copies of each i in a random order
+    const int N = 100;
+    std::vector<int> data;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < i; j++) {
+            data.push_back(i);
+        }
+    }
+    std::shuffle(data.begin(), data.end(), std::mt19937(N));
+    test_set t;
+    for (int x : data) {
+        t.insert(x);
+    }
+
+    for (int lower = 0; lower < N; lower += 3) {
+        for (int upper = lower; upper < N; upper += 5) {
+            const auto expected = static_cast<std::size_t>((upper * (upper + 1) - lower * (lower - 1)) / 2);
+            EXPECT_EQ(expected, t.countRange(lower, upper));
+        }
+    }
+}
+
+TEST(BTreeSet, Freeze) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    test_set t;
+    t.freeze();
+    EXPECT_EQ(0, t.size());
+
+    // a frozen tree reports its size from the sub-tree counts, until the next insertion thaws it
+    const int N = 1000;
+    for (int i = 0; i < N; i++) {
+        t.insert(i);
+    }
+    t.freeze();
+    EXPECT_EQ(N, t.size());
+    EXPECT_EQ(N / 2, t.countRange(0, N / 2 - 1));
+    t.insert(N);
+    t.insert(0);
+    EXPECT_EQ(N + 1, t.size());
+    t.freeze();
+    EXPECT_EQ(N + 1, t.size());
+    t.clear();
+    EXPECT_EQ(0, t.size());
+}
+
+TEST(BTreeSet, Prefetch) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    // prefetches have no effect on the content, also for empty trees and keys beyond the bounds
+    test_set t;
+    t.prefetch(0);
+    const int N = 1000;
+    for (int i = 0; i < N; i++) {
+        t.insert(2 * i);
+    }
+    for (int k = -1; k < 2 * N + 1; k++) {
+        t.prefetch(k);
+    }
+    EXPECT_EQ(N, t.size());
+    EXPECT_EQ(1000, *t.lower_bound(999));
+}
+
+TEST(BTreeSet, FingerSearch) {
+    using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
+
+    const int N = 10000;
+    test_set t;
+    for (int i = 0; i < N; i++) {
+        t.insert(2 * i);
+    }
+
+    // searches with shared hints start at ancestors of the last leaf, in order and at growing distances
+    for (int step : {1, 7, 61, 997}) {
+        test_set::operation_hints hints;
+        for (int k = -1; k < 2 * N + 1; k += step) {
+            auto lower = t.lower_bound(k, hints);
+            auto upper = t.upper_bound(k, hints);
+            auto pos = t.find(k, hints);
+            if (k < 2 * N - 1) {
+                EXPECT_EQ(std::max(0, k + (k & 1)), *lower);
+            } else {
+                EXPECT_TRUE(lower == t.end());
+            }
+            if (k < 2 * N - 2) {
+                EXPECT_EQ(std::max(0, k + 2 - (k & 1)), *upper);
+            } else {
+                EXPECT_TRUE(upper == t.end());
+            }
+            EXPECT_EQ(k >= 0 && k < 2 * N && (k & 1) == 0, pos != t.end());
+        }
+    }
+}
+
 TEST(BTreeSet, ChunkSplit) {
     using test_set = btree_set<int, detail::comparator<int>, std::allocator<int>, 16>;
 
@@ -686,6 +937,50 @@ struct reserver<std::unordered_set<A, B, C, D>> {
         std::cout << "\tDone!\n\n";                                                    \
     }
 
+TEST(BTreeSet, VectorSearch) {
+    using Entry = std::array<int, 3>;
+    using test_set = btree_set<Entry, detail::comparator<Entry>, std::allocator<Entry>, 256,
+            detail::vector_search>;
+
+    // insert a grid of tuples with negative and duplicate columns in random order
+    std::vector<Entry> data;
+    for (int i = -5; i < 5; i++) {
+        for (int j = -5; j < 5; j++) {
+            for (int k = 0; k < 20; k += 2) {
+                data.push_back({i, j, k});
+            }
+        }
+    }
+    std::mt19937 generator(3);
+    std::shuffle(data.begin(), data.end(), generator);
+
+    test_set t;
+    std::set<Entry> reference;
+    for (const auto& cur : data) {
+        EXPECT_EQ(reference.insert(cur).second, t.insert(cur));
+    }
+    EXPECT_EQ(reference.size(), t.size());
+    EXPECT_TRUE(std::equal(t.begin(), t.end(), reference.begin(), reference.end()));
+
+    // boundaries of present and missing tuples
+    for (int i = -6; i < 6; i++) {
+        for (int k = -1; k < 21; k++) {
+            Entry key{i, 0, k};
+            auto lower = reference.lower_bound(key);
+            auto upper = reference.upper_bound(key);
+            EXPECT_EQ(lower == reference.end(), t.lower_bound(key) == t.end());
+            EXPECT_EQ(upper == reference.end(), t.upper_bound(key) == t.end());
+            if (lower != reference.end()) {
+                EXPECT_EQ(*lower, *t.lower_bound(key));
+            }
+            if (upper != reference.end()) {
+                EXPECT_EQ(*upper, *t.upper_bound(key));
+            }
+            EXPECT_EQ(reference.count(key) == 1, t.contains(key));
+        }
+    }
+}
+
 TEST(Performance, Basic) {
     //        int N = 1<<22;
     int N = 1 << 18;
@@ -712,6 +1007,29 @@ TEST(Performance, Basic) {
     checkPerformance(t3, "souffle btree_set - 256 - binary", in, out);
 }
 
+TEST(Performance, VectorSearch) {
+    int N = 1 << 18;
+
+    // get list of tuples to be inserted
+    using Entry = std::array<int, 2>;
+    std::vector<Entry> in;
+    std::vector<Entry> out;
+    time("generating data", [&]() {
+        for (int i = 0; i < N; i++) {
+            in.push_back({i % 512, i / 512});
+            out.push_back({i % 512, -1 - i / 512});
+        }
+        std::mt19937 generator(7);
+        std::shuffle(in.begin(), in.end(), generator);
+    });
+
+    using t1 = btree_set<Entry, detail::comparator<Entry>, std::allocator<Entry>, 256, detail::binary_search>;
+    checkPerformance(t1, "souffle btree_set - 256 - binary", in, out);
+
+    using t2 = btree_set<Entry, detail::comparator<Entry>, std::allocator<Entry>, 256, detail::vector_search>;
+    checkPerformance(t2, "souffle btree_set - 256 - vector", in, out);
+}
+
 TEST(Performance, Load) {
     //        int N = 1<<24;
     int N = 1 << 20;
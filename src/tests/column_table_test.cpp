@@ -0,0 +1,85 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file column_table_test.cpp
+ *
+ * Test cases for the ColumnTable data structure.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/ColumnTable.h"
+#include <cstddef>
+
+namespace souffle {
+
+namespace test {
+
+using t_table = ColumnTable<3>;
+using t_tuple = t_table::t_tuple;
+
+TEST(ColumnTable, Basic) {
+    t_table table;
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(0, table.size());
+    EXPECT_TRUE(table.begin() == table.end());
+
+    t_tuple t{{1, 2, 3}};
+    EXPECT_EQ(0, table.append(t));
+
+    EXPECT_FALSE(table.empty());
+    EXPECT_EQ(1, table.size());
+    EXPECT_EQ(t, *table.begin());
+    EXPECT_EQ(2, table.get(t_table::rowKey(0), 1));
+
+    table.clear();
+    EXPECT_TRUE(table.empty());
+}
+
+TEST(ColumnTable, ProbeKey) {
+    t_table table;
+    table.append(t_tuple{{1, 2, 3}});
+
+    t_tuple probe{{4, 5, 6}};
+    auto key = t_table::probeKey(probe);
+    EXPECT_EQ(4, table.get(key, 0));
+    EXPECT_EQ(6, table.get(key, 2));
+    EXPECT_EQ(probe, table.tuple(key));
+}
+
+TEST(ColumnTable, Stress) {
+    const RamDomain N = 100000;
+    t_table table;
+    for (RamDomain i = 0; i < N; ++i) {
+        EXPECT_EQ((std::size_t)i, table.append(t_tuple{{i, -i, i * 2}}));
+    }
+    EXPECT_EQ((std::size_t)N, table.size());
+
+    RamDomain i = 0;
+    for (const auto& cur : table) {
+        EXPECT_EQ((t_tuple{{i, -i, i * 2}}), cur);
+        i++;
+    }
+    EXPECT_EQ(N, i);
+
+    std::size_t rows = 0;
+    for (const auto& chunk : table.getChunks(7)) {
+        for (const auto& cur : chunk) {
+            EXPECT_EQ(-cur[0], cur[1]);
+            rows++;
+        }
+    }
+    EXPECT_EQ((std::size_t)N, rows);
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,103 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file configuration_tuner_test.cpp
+ *
+ * Test cases for the search of the fastest options of a program.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "reports/ConfigurationTuner.h"
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace souffle::test {
+
+namespace {
+/** Runtimes in milliseconds: magic sets halve them, and threads help only with magic sets */
+std::optional<TuningRun> simulate(const ConfigurationTuner::Settings& settings, std::size_t& runs) {
+    ++runs;
+    if (settings.at("RamSIPS") == "input") {
+        return std::nullopt;
+    }
+    long time = 1000;
+    if (settings.at("magic-transform") == "auto") {
+        time /= 2;
+        time /= std::stol(settings.at("jobs"));
+    }
+    if (settings.at("RamSIPS") == "max-ratio") {
+        time = time * 99 / 100;
+    }
+    using std::chrono::milliseconds;
+    return TuningRun{milliseconds(time), milliseconds(time / 2)};
+}
+
+std::vector<TuningDimension> makeDimensions() {
+    return {{"jobs", {"1", "2", "4"}, false}, {"RamSIPS", {"", "max-ratio", "input"}},
+            {"magic-transform", {"", "auto"}}};
+}
+}  // namespace
+
+TEST(ConfigurationTuner, Search) {
+    std::size_t runs = 0;
+    ConfigurationTuner tuner(
+            makeDimensions(), [&](const auto& settings) { return simulate(settings, runs); });
+    std::stringstream log;
+    const auto settings = tuner.search(log);
+
+    // threads are only found faster once magic sets are enabled, in the second round, while the
+    // difference of the SIPS heuristics is within the noise of the measurements
+    EXPECT_EQ(2, settings.size());
+    EXPECT_EQ("auto", settings.at("magic-transform"));
+    EXPECT_EQ("4", settings.at("jobs"));
+    EXPECT_NE(std::string::npos, log.str().find("failed  RamSIPS=input jobs=1"));
+
+    // each distinct setting is run once
+    EXPECT_EQ(10, runs);
+
+    std::stringstream pragmas;
+    ConfigurationTuner::writePragmas(pragmas, settings);
+    EXPECT_NE(std::string::npos, pragmas.str().find(".pragma \"jobs\" \"4\"\n"));
+    EXPECT_NE(std::string::npos, pragmas.str().find(".pragma \"magic-transform\" \"auto\"\n"));
+}
+
+TEST(ConfigurationTuner, PruneRules) {
+    std::size_t runs = 0;
+    ConfigurationTuner tuner(makeDimensions(), [&](const auto&) -> std::optional<TuningRun> {
+        ++runs;
+        using std::chrono::milliseconds;
+        return TuningRun{milliseconds(1000), milliseconds(10)};
+    });
+    std::stringstream log;
+    EXPECT_TRUE(tuner.search(log).empty());
+
+    // only the number of threads is searched, since the rules take little of the runtime
+    EXPECT_EQ(3, runs);
+}
+
+TEST(ConfigurationTuner, DefaultDimensions) {
+    const auto dimensions = ConfigurationTuner::getDefaultDimensions("2", 8, "p.json");
+    EXPECT_EQ("jobs", dimensions.back().option);
+    EXPECT_EQ((std::vector<std::string>{"2", "1", "4", "8"}), dimensions.back().values);
+    EXPECT_FALSE(dimensions.back().rules);
+    for (const auto& dimension : dimensions) {
+        if (dimension.option == "profile-use") {
+            EXPECT_EQ("p.json", dimension.values.back());
+        }
+    }
+}
+
+}  // namespace souffle::test
@@ -84,12 +84,30 @@ static void check_pr2b_undoes_b2r_b2p(souffle::DisjointSet& ds, souffle::PiggyLi
     }
 }
 
+// The cycle of a node's set visits exactly the nodes of the same root.
+static void check_set_cycles(souffle::DisjointSet& ds, souffle::PiggyList<parent_t>& nodes) {
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        const parent_t root = ds.findNode(nodes.get(i));
+        std::size_t visited = 0;
+        ds.forEachInSet(nodes.get(i), [&](parent_t node) {
+            LOCAL_ASSERT_EQ(ds.findNode(node), root);
+            ++visited;
+        });
+        std::size_t members = 0;
+        for (std::size_t j = 0; j < nodes.size(); ++j) {
+            members += ds.findNode(nodes.get(j)) == root ? 1 : 0;
+        }
+        LOCAL_ASSERT_EQ(visited, members);
+    }
+}
+
 // Check invariants
 static void check(souffle::DisjointSet& ds, souffle::PiggyList<parent_t>& nodes) {
     LOCAL_ASSERT_EQ(ds.size(), nodes.size());
     check_parent_rank(ds, nodes);
     check_max_rank(ds, nodes);
     check_pr2b_undoes_b2r_b2p(ds, nodes);
+    check_set_cycles(ds, nodes);
 }
 
 // Perform some number of randomized API calls to produce a random disjoint set.
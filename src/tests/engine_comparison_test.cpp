@@ -0,0 +1,103 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved.
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file engine_comparison_test.cpp
+ *
+ * Test cases for the comparison of runs in several engine configurations.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "reports/EngineComparison.h"
+#include "souffle/utility/FileUtil.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace souffle::test {
+
+namespace {
+/** Write a profile of a run whose only rule took the given time, both in microseconds */
+std::string writeProfile(const std::string& name, long runtime, long ruleTime) {
+    const std::string profile = name + ".json";
+    std::ofstream out(profile);
+    out << R"({"root": {"program": {"runtime": {"start": 0, "end": )" << runtime << "}, ";
+    out << R"("relation": {"path": {"non-recursive-rule": {"path(x,y) :- edge(x,y).": {)";
+    out << R"("source-locator": "p.dl [3:1-3:20]", "runtime": {"start": 0, "end": )" << ruleTime;
+    out << "}}}}}}}}\n";
+    return profile;
+}
+
+std::string makeDir(const std::string& name, const std::string& contents) {
+    mkdir(name.c_str(), 0755);
+    std::ofstream(name + "/path.csv") << contents;
+    return name;
+}
+}  // namespace
+
+TEST(EngineConfiguration, Parse) {
+    auto configurations = EngineConfiguration::parseAll("interpreter;compiled:-z MagicSetTransformer  -j4;");
+    EXPECT_EQ(2, configurations.size());
+    EXPECT_FALSE(configurations[0].compiled);
+    EXPECT_EQ(0, configurations[0].options.size());
+    EXPECT_TRUE(configurations[1].compiled);
+    EXPECT_EQ("compiled:-z MagicSetTransformer  -j4", configurations[1].name);
+    EXPECT_EQ(3, configurations[1].options.size());
+    EXPECT_EQ("MagicSetTransformer", configurations[1].options[1]);
+
+    bool failed = false;
+    try {
+        EngineConfiguration::parseAll("interpreter;synthesiser");
+    } catch (std::invalid_argument&) {
+        failed = true;
+    }
+    EXPECT_TRUE(failed);
+
+    failed = false;
+    try {
+        EngineConfiguration::parseAll("compiled");
+    } catch (std::invalid_argument&) {
+        failed = true;
+    }
+    EXPECT_TRUE(failed);
+}
+
+TEST(EngineComparison, Outputs) {
+    const std::string base = tempFile();
+    std::remove(base.c_str());
+
+    EngineComparison comparison;
+    comparison.addRun(
+            "interpreter", makeDir(base + "-1", "1\t2\n2\t3\n"), writeProfile(base + "-1", 900000, 500000));
+    // the same tuples in another order agree
+    comparison.addRun(
+            "compiled", makeDir(base + "-2", "2\t3\n1\t2\n"), writeProfile(base + "-2", 300000, 100000));
+    std::stringstream agree;
+    EXPECT_TRUE(comparison.checkOutputs(agree));
+    EXPECT_EQ("", agree.str());
+
+    std::stringstream report;
+    comparison.print(report);
+    EXPECT_NE(std::string::npos, report.str().find("0.400"));
+    EXPECT_NE(std::string::npos, report.str().find("path: path(x,y) :- edge(x,y)."));
+
+    comparison.addRun(
+            "compiled:-j2", makeDir(base + "-3", "1\t2\n"), writeProfile(base + "-3", 300000, 100000));
+    std::stringstream differ;
+    EXPECT_FALSE(comparison.checkOutputs(differ));
+    EXPECT_EQ("Output path.csv of compiled:-j2 differs from interpreter\n", differ.str());
+}
+
+}  // namespace souffle::test
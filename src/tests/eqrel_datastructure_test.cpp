@@ -724,5 +724,38 @@ TEST(EqRelTest, MergeExtendDisjoint) {
     EXPECT_EQ(eqrelOtherSize + eqrelNewSize, eqrelOther.size());
 }
 
+TEST(EqRelTest, MergeExtendManySets) {
+    souffle::EquivalenceRelation<Tuple<std::size_t, 2>> eqrelOther;
+    souffle::EquivalenceRelation<Tuple<std::size_t, 2>> eqrelNew;
+
+    // sets {4i, 4i+1, 4i+2}, of which the new knowledge touches every other set
+    const std::size_t N = 1000;
+    for (std::size_t i = 0; i < N; ++i) {
+        eqrelOther.insert(4 * i, 4 * i + 1);
+        eqrelOther.insert(4 * i + 1, 4 * i + 2);
+        if (i % 2 == 0) {
+            eqrelNew.insert(4 * i + 2, 4 * i + 3);
+        }
+    }
+
+    eqrelNew.extendAndInsert(eqrelOther);
+
+    EXPECT_EQ(N / 2 * 16, eqrelNew.size());
+    EXPECT_EQ(N / 2 * 16 + N / 2 * 9, eqrelOther.size());
+    EXPECT_TRUE(eqrelNew.contains(0, 3));
+    EXPECT_FALSE(eqrelNew.contains(4, 5));
+    EXPECT_TRUE(eqrelOther.contains(4, 6));
+}
+
+TEST(EqRelTest, MemoryUsage) {
+    souffle::EquivalenceRelation<Tuple<std::size_t, 2>> eqrel;
+    const std::size_t empty = eqrel.getMemoryUsage();
+
+    for (std::size_t i = 0; i < 1000; ++i) {
+        eqrel.insert(i, i + 1);
+    }
+    EXPECT_LT(empty, eqrel.getMemoryUsage());
+}
+
 }  // namespace test
 }  // namespace souffle
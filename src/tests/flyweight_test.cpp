@@ -17,6 +17,7 @@
 #include "tests/test.h"
 
 #include "souffle/datastructure/ConcurrentFlyweight.h"
+#include "souffle/datastructure/FrontCodedFlyweight.h"
 #include "souffle/utility/MiscUtil.h"
 #include <algorithm>
 #include <cstddef>
@@ -262,6 +263,39 @@ DERIVED_TEST(Flyweight, FindOrInsertCopy_OneLanePerThread_ManyThreads_HighCapaci
 }
 #endif
 
+// Insert many keys concurrently, such that the index grows while lanes insert
+TEST(Flyweight, ConcurrentGrowth) {
+    const std::size_t N = 100000;
+    for (const bool reserved : {false, true}) {
+        FlyweightImpl<std::string> flyweight{4};
+        if (reserved) {
+            flyweight.reserve(N);
+        }
+        std::vector<FlyweightImpl<std::string>::index_type> indices(N);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (std::size_t i = 0; i < 2 * N; ++i) {
+            // every key is inserted twice, possibly by different threads
+            const auto res = flyweight.findOrInsert(std::to_string(i % N));
+            if (i >= N) {
+                indices[i - N] = res.first;
+            }
+        }
+        EXPECT_EQ(N, flyweight.size());
+        for (std::size_t i = 0; i < N; ++i) {
+            EXPECT_EQ(std::to_string(i), flyweight.fetch(indices[i]));
+            EXPECT_TRUE(flyweight.weakContains(std::to_string(i)));
+        }
+        EXPECT_FALSE(flyweight.weakContains(std::to_string(N)));
+
+        // indices are unique, leaving at most the slot reserved by each lane unused
+        std::sort(indices.begin(), indices.end());
+        EXPECT_TRUE(std::adjacent_find(indices.begin(), indices.end()) == indices.end());
+        EXPECT_LT(indices.back(), N + 4);
+    }
+}
+
 TEST(Flyweight, IteratorEmptyBeginEnd) {
     FlyweightImpl<std::string> flyweight{1};
     EXPECT_EQ(flyweight.begin(), flyweight.begin());
@@ -273,4 +307,80 @@ TEST(Flyweight, IteratorEmptyBeginEnd) {
     }
 }
 
+TEST(FrontCodedFlyweight, Inserts) {
+    // strings sharing prefixes within and across buckets, empty strings, and strings larger than a page
+    std::vector<std::string> strings;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        strings.push_back("/home/user/project/src/file" + std::to_string(i % 300) + ".dl");
+        strings.push_back(i % 7 == 0 ? "" : "https://example.org/" + std::to_string(i));
+        if (i % 250 == 0) {
+            strings.push_back(std::string(100000 + i, static_cast<char>('a' + i % 26)));
+        }
+    }
+
+    FrontCodedFlyweight flyweight{1};
+    std::vector<FrontCodedFlyweight::index_type> indices;
+    std::size_t inserted = 0;
+    for (const auto& str : strings) {
+        const auto res = flyweight.findOrInsert(str);
+        inserted += res.second ? 1 : 0;
+        indices.push_back(res.first);
+    }
+    EXPECT_EQ(inserted, flyweight.size());
+    for (std::size_t i = 0; i < strings.size(); ++i) {
+        EXPECT_EQ(strings[i], flyweight.fetch(indices[i]));
+        EXPECT_EQ(indices[i], flyweight.findOrInsert(strings[i]).first);
+    }
+    EXPECT_FALSE(flyweight.weakContains("/home/user/project/src/file300.dl"));
+
+    // the indices are consecutive and iterated in order
+    std::size_t next = 0;
+    for (const auto& entry : flyweight) {
+        EXPECT_EQ(next, entry.second);
+        EXPECT_EQ(entry.first, flyweight.fetch(next));
+        ++next;
+    }
+    EXPECT_EQ(flyweight.size(), next);
+}
+
+TEST(FrontCodedFlyweight, Swap) {
+    FrontCodedFlyweight x{1};
+    FrontCodedFlyweight y{1};
+    x.findOrInsert("a");
+    x.findOrInsert("ab");
+    y.findOrInsert("b");
+    x.swap(y);
+    EXPECT_EQ(1, x.size());
+    EXPECT_EQ(2, y.size());
+    EXPECT_EQ("b", x.fetch(0));
+    EXPECT_EQ("ab", y.fetch(1));
+    EXPECT_EQ(1, x.findOrInsert("c").first);
+    EXPECT_EQ(2, y.findOrInsert("c").first);
+}
+
+// Insert and fetch concurrently, such that the table and the pages grow while threads fetch
+TEST(FrontCodedFlyweight, ConcurrentGrowth) {
+    const std::size_t N = 100000;
+    FrontCodedFlyweight flyweight{4};
+    std::vector<FrontCodedFlyweight::index_type> indices(N);
+    std::size_t mismatches = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+ : mismatches)
+#endif
+    for (std::size_t i = 0; i < 2 * N; ++i) {
+        // every string is inserted twice, possibly by different threads
+        const std::string str = "/data/" + std::to_string(i % N);
+        const auto res = flyweight.findOrInsert(str);
+        mismatches += flyweight.fetch(res.first) == str ? 0 : 1;
+        if (i >= N) {
+            indices[i - N] = res.first;
+        }
+    }
+    EXPECT_EQ(0, mismatches);
+    EXPECT_EQ(N, flyweight.size());
+    for (std::size_t i = 0; i < N; ++i) {
+        EXPECT_EQ("/data/" + std::to_string(i), flyweight.fetch(indices[i]));
+    }
+}
+
 }  // namespace souffle::test
@@ -0,0 +1,132 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file fork_server_test.cpp
+ *
+ * Test cases for serving the requests to a program by forked processes.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/CompiledOptions.h"
+#include "souffle/ForkServer.h"
+#include "souffle/utility/FileUtil.h"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+/** A program reporting the inputs loaded by the server and the runs of its requests */
+class Program {
+public:
+    void loadAll(const std::string& inputDirectory) {
+        loaded += inputDirectory;
+    }
+
+    void compactInputs() {
+        compacted = true;
+    }
+
+    void runAll(const std::string& inputDirectory, const std::string& outputDirectory) {
+        if (inputDirectory == "broken") {
+            throw std::runtime_error("cannot read " + inputDirectory);
+        }
+        ++runs;
+        loaded += " " + inputDirectory;
+        std::cout << loaded << " -> " << outputDirectory << (compacted ? " compacted" : "") << " run "
+                  << runs << "\n";
+    }
+
+private:
+    std::string loaded;
+    bool compacted = false;
+    int runs = 0;
+};
+
+/** Send a request to the server, and return all it answers until closing the connection */
+std::string request(const std::string& path, const std::string& line) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    const int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    // the server may not listen yet
+    for (int i = 0; ::connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0; ++i) {
+        if (i == 500) {
+            ::close(client);
+            return "unreachable";
+        }
+        ::usleep(10000);
+    }
+    const std::string message = line + "\n";
+    if (::write(client, message.data(), message.size()) != static_cast<ssize_t>(message.size())) {
+        ::close(client);
+        return "unwritten";
+    }
+    std::string res;
+    char buffer[256];
+    ssize_t n;
+    while ((n = ::read(client, buffer, sizeof(buffer))) > 0) {
+        res.append(buffer, n);
+    }
+    ::close(client);
+    return res;
+}
+
+}  // namespace
+
+TEST(ForkServer, Requests) {
+    const std::string path = tempFile();
+    std::remove(path.c_str());
+
+    std::string arg0 = "program";
+    std::string arg1 = "--serve=" + path;
+    std::string arg2 = "--facts=/";
+    char* argv[] = {arg0.data(), arg1.data(), arg2.data()};
+    CmdOptions opt("program.dl", ".", "out", false, "", 1);
+    EXPECT_TRUE(opt.parse(3, argv));
+    EXPECT_EQ(path, opt.getServeSocket());
+
+    std::cout.flush();
+    const pid_t server = ::fork();
+    if (server == 0) {
+        Program prog;
+        ::_exit(serveRequests(prog, opt));
+    }
+    EXPECT_TRUE(server > 0);
+
+    // each request is run by a child of the loaded program, and its changes are discarded
+    EXPECT_EQ("/ a -> out compacted run 1\n", request(path, "a"));
+    EXPECT_EQ("/ b -> other compacted run 1\n", request(path, "b\tother"));
+    EXPECT_EQ("/ a -> out compacted run 1\n", request(path, "a"));
+
+    // the errors of a request are sent to its client
+    EXPECT_EQ("cannot read broken\n", request(path, "broken"));
+
+    ::kill(server, SIGTERM);
+    int status;
+    EXPECT_EQ(server, ::waitpid(server, &status, 0));
+    std::remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace souffle
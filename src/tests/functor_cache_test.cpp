@@ -0,0 +1,97 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file functor_cache_test.cpp
+ *
+ * Test cases for the result cache of user-defined functors.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/FunctorCache.h"
+#include "souffle/RamTypes.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+TEST(FunctorCache, Hits) {
+    FunctorCache<std::array<RamDomain, 2>> cache;
+    int calls = 0;
+    auto add = [&](const std::array<RamDomain, 2>& args) {
+        calls++;
+        return args[0] + args[1];
+    };
+
+    EXPECT_EQ(3, cache.lookup({1, 2}, add));
+    EXPECT_EQ(3, cache.lookup({1, 2}, add));
+    EXPECT_EQ(1, calls);
+
+    // the order of the arguments matters
+    EXPECT_EQ(3, cache.lookup({2, 1}, add));
+    EXPECT_EQ(2, calls);
+    EXPECT_EQ(std::size_t(2), cache.size());
+}
+
+TEST(FunctorCache, Arities) {
+    FunctorCache<std::vector<RamDomain>> cache;
+    auto count = [](const std::vector<RamDomain>& args) { return RamDomain(args.size()); };
+
+    EXPECT_EQ(0, cache.lookup({}, count));
+    EXPECT_EQ(1, cache.lookup({0}, count));
+    EXPECT_EQ(2, cache.lookup({0, 0}, count));
+    EXPECT_EQ(std::size_t(3), cache.size());
+}
+
+TEST(FunctorCache, Capacity) {
+    const std::size_t capacity = 256;
+    FunctorCache<std::array<RamDomain, 1>> cache(capacity);
+    auto square = [](const std::array<RamDomain, 1>& args) { return args[0] * args[0]; };
+
+    // the cache holds at most its capacity, while still returning the results of evicted arguments
+    for (RamDomain i = 0; i < 10000; i++) {
+        EXPECT_EQ(i % 100 * (i % 100), cache.lookup({i % 100}, square));
+        EXPECT_EQ(i * i, cache.lookup({i}, square));
+        EXPECT_TRUE(cache.size() <= capacity);
+    }
+}
+
+TEST(FunctorCache, Parallel) {
+    const RamDomain N = 100000;
+    FunctorCache<std::array<RamDomain, 1>> cache(1 << 20);
+    std::atomic<int> calls{0};
+    auto negate = [&](const std::array<RamDomain, 1>& args) {
+        calls++;
+        return -args[0];
+    };
+
+    std::vector<RamDomain> results(N);
+#pragma omp parallel for
+    for (RamDomain i = 0; i < N; i++) {
+        results[i] = cache.lookup({i % 1000}, negate);
+    }
+
+    bool correct = true;
+    for (RamDomain i = 0; i < N; i++) {
+        correct = correct && results[i] == -(i % 1000);
+    }
+    EXPECT_TRUE(correct);
+    // concurrent misses of the same arguments may each call the functor, but most calls are hits
+    EXPECT_LT(calls.load(), N / 10);
+    EXPECT_EQ(std::size_t(1000), cache.size());
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,124 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file gzfstream_test.cpp
+ *
+ * Test cases for the block-compressed file streams.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/io/gzfstream.h"
+#include "souffle/utility/FileUtil.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <zlib.h>
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+/** Text of several blocks */
+std::string makeText() {
+    std::string text;
+    for (std::size_t i = 0; i < 200000; ++i) {
+        text += std::to_string(i * 7919 % 1000003) + "\tsymbol" + std::to_string(i % 977) + "\n";
+    }
+    return text;
+}
+
+std::string readAll(const std::string& fileName) {
+    gzfstream::igzfstream file(fileName);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+}  // namespace
+
+TEST(GZFStream, Blocks) {
+    const std::string fileName = tempFile();
+    const std::string text = makeText();
+    {
+        gzfstream::ogzfstream file(fileName);
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    EXPECT_TRUE(readAll(fileName) == text);
+    std::remove(fileName.c_str());
+}
+
+TEST(GZFStream, Empty) {
+    const std::string fileName = tempFile();
+    { gzfstream::ogzfstream file(fileName); }
+    EXPECT_EQ(readAll(fileName), "");
+    std::remove(fileName.c_str());
+}
+
+TEST(GZFStream, PlainGZip) {
+    const std::string fileName = tempFile();
+    const std::string text = makeText();
+    gzFile file = gzopen(fileName.c_str(), "wb");
+    gzwrite(file, text.data(), static_cast<unsigned>(text.size()));
+    gzclose(file);
+    EXPECT_TRUE(readAll(fileName) == text);
+    std::remove(fileName.c_str());
+}
+
+TEST(GZFStream, Uncompressed) {
+    const std::string fileName = tempFile();
+    const std::string text = makeText();
+    std::ofstream(fileName) << text;
+    EXPECT_TRUE(readAll(fileName) == text);
+    std::remove(fileName.c_str());
+}
+
+#ifdef USE_ZSTD
+TEST(GZFStream, ZstdBlocks) {
+    const std::string fileName = tempFile();
+    const std::string text = makeText();
+    {
+        gzfstream::ogzfstream file(fileName, std::ios::out, gzfstream::Format::Zstd);
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    EXPECT_TRUE(readAll(fileName) == text);
+    std::remove(fileName.c_str());
+}
+
+TEST(GZFStream, ZstdEmpty) {
+    const std::string fileName = tempFile();
+    { gzfstream::ogzfstream file(fileName, std::ios::out, gzfstream::Format::Zstd); }
+    EXPECT_EQ(readAll(fileName), "");
+    std::remove(fileName.c_str());
+}
+
+TEST(GZFStream, PlainZstd) {
+    const std::string fileName = tempFile();
+    const std::string text = makeText();
+    std::string bytes(ZSTD_compressBound(text.size()), '\0');
+    const std::size_t size =
+            ZSTD_compress(&bytes[0], bytes.size(), text.data(), text.size(), ZSTD_CLEVEL_DEFAULT);
+    EXPECT_FALSE(ZSTD_isError(size));
+    std::ofstream(fileName, std::ios::binary) << bytes.substr(0, size);
+    EXPECT_TRUE(readAll(fileName) == text);
+    std::remove(fileName.c_str());
+}
+#endif
+
+}  // namespace test
+}  // namespace souffle
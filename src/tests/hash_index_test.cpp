@@ -0,0 +1,103 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file hash_index_test.cpp
+ *
+ * Test cases for the HashIndex data structure.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/HashIndex.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <cstddef>
+#include <functional>
+
+namespace souffle {
+
+namespace test {
+
+using t_tuple = Tuple<RamDomain, 2>;
+
+/** Index on the second attribute */
+struct Hash {
+    std::size_t operator()(const t_tuple& t) const {
+        return std::hash<RamDomain>()(t[1]);
+    }
+};
+
+struct Comparator {
+    bool equal(const t_tuple& a, const t_tuple& b) const {
+        return a[1] == b[1];
+    }
+};
+
+using t_index = HashIndex<t_tuple, Hash, Comparator>;
+
+template <typename R>
+std::size_t count(const R& r) {
+    std::size_t res = 0;
+    for (auto it = r.begin(); it != r.end(); ++it) {
+        res++;
+    }
+    return res;
+}
+
+TEST(HashIndex, Basic) {
+    t_index index;
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(0, count(index.equal_range(t_tuple{{1, 2}})));
+
+    index.insert(t_tuple{{1, 2}});
+    index.insert(t_tuple{{3, 2}});
+    index.insert(t_tuple{{1, 4}});
+
+    EXPECT_EQ(3, index.size());
+    EXPECT_EQ(2, count(index.equal_range(t_tuple{{0, 2}})));
+    EXPECT_EQ(1, count(index.equal_range(t_tuple{{0, 4}})));
+    EXPECT_EQ(0, count(index.equal_range(t_tuple{{1, 3}})));
+
+    for (const auto& t : index.equal_range(t_tuple{{0, 4}})) {
+        EXPECT_EQ((t_tuple{{1, 4}}), t);
+    }
+
+    index.clear();
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(0, count(index.equal_range(t_tuple{{0, 2}})));
+}
+
+TEST(HashIndex, Parallel) {
+    const int N = 100000;
+    const int K = 97;
+    t_index index;
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++) {
+        index.insert(t_tuple{{i, i % K}});
+    }
+
+    EXPECT_EQ((std::size_t)N, index.size());
+    std::size_t total = 0;
+    for (int k = 0; k < K; k++) {
+        std::size_t num = 0;
+        for (const auto& t : index.equal_range(t_tuple{{0, k}})) {
+            EXPECT_EQ(k, t[0] % K);
+            num++;
+        }
+        EXPECT_EQ((std::size_t)(N / K + (k < N % K ? 1 : 0)), num);
+        total += num;
+    }
+    EXPECT_EQ((std::size_t)N, total);
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,91 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file hyperloglog_test.cpp
+ *
+ * Test cases for the HyperLogLog sketch of approximate counts.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/datastructure/HyperLogLog.h"
+#include <cstdlib>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+/** Whether the estimate is within the given percentage of the exact count */
+bool isClose(RamSigned estimate, RamSigned exact, RamSigned percent) {
+    return std::abs(estimate - exact) * 100 <= exact * percent;
+}
+
+TEST(HyperLogLog, Empty) {
+    HyperLogLog sketch;
+    EXPECT_EQ(0, sketch.estimate());
+}
+
+TEST(HyperLogLog, Estimate) {
+    for (RamDomain n : {10, 1000, 20000, 1000000}) {
+        HyperLogLog sketch;
+        for (RamDomain i = 0; i < n; i++) {
+            sketch.insert(i);
+        }
+        EXPECT_TRUE(isClose(sketch.estimate(), n, 5));
+    }
+}
+
+TEST(HyperLogLog, Duplicates) {
+    HyperLogLog once;
+    HyperLogLog repeated;
+    for (RamDomain i = 0; i < 5000; i++) {
+        once.insert(-i);
+        for (int j = 0; j < 3; j++) {
+            repeated.insert(-i);
+        }
+    }
+    EXPECT_EQ(once.estimate(), repeated.estimate());
+}
+
+TEST(HyperLogLog, Merge) {
+    const RamDomain N = 100000;
+    const int parts = 8;
+
+    // the values of the parts overlap, such that duplicates across the parts are counted once
+    std::vector<HyperLogLog> sketches(parts);
+    HyperLogLog all;
+    for (int p = 0; p < parts; p++) {
+        for (RamDomain i = p * N / parts; i < (p + 2) * N / parts && i < N; i++) {
+            sketches[p].insert(i);
+            all.insert(i);
+        }
+    }
+
+    HyperLogLog merged;
+    for (const auto& sketch : sketches) {
+        merged.merge(sketch);
+    }
+    EXPECT_EQ(all.estimate(), merged.estimate());
+    EXPECT_TRUE(isClose(merged.estimate(), N, 5));
+
+    // the reduction of a parallel loop merges the sketches of the threads
+    HyperLogLog reduced;
+#pragma omp parallel for reduction(hll_merge : reduced)
+    for (RamDomain i = 0; i < N; i++) {
+        reduced.insert(i);
+    }
+    EXPECT_EQ(all.estimate(), reduced.estimate());
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,138 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file node_pool_test.cpp
+ *
+ * Test cases for the NodePool allocator.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/datastructure/NodePool.h"
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using t_pool = NodePool<40, 16>;
+
+TEST(NodePool, Alignment) {
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10000; i++) {
+        void* p = t_pool::allocate();
+        EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(p) % 16);
+        blocks.push_back(p);
+    }
+
+    // all blocks are distinct and do not overlap
+    std::set<std::uintptr_t> addresses;
+    for (void* p : blocks) {
+        addresses.insert(reinterpret_cast<std::uintptr_t>(p));
+    }
+    EXPECT_EQ(blocks.size(), addresses.size());
+    std::uintptr_t last = 0;
+    for (auto a : addresses) {
+        EXPECT_TRUE(last == 0 || a - last >= 40);
+        last = a;
+    }
+
+    for (void* p : blocks) {
+        t_pool::deallocate(p);
+    }
+}
+
+TEST(NodePool, Reuse) {
+    void* a = t_pool::allocate();
+    t_pool::deallocate(a);
+    void* b = t_pool::allocate();
+    EXPECT_EQ(a, b);
+    t_pool::deallocate(b);
+}
+
+TEST(NodePool, Parallel) {
+    const int N = 100000;
+    std::vector<std::uint64_t*> blocks(N);
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++) {
+        blocks[i] = static_cast<std::uint64_t*>(t_pool::allocate());
+        *blocks[i] = i;
+    }
+
+    std::set<std::uint64_t*> distinct(blocks.begin(), blocks.end());
+    EXPECT_EQ((std::size_t)N, distinct.size());
+    for (int i = 0; i < N; i++) {
+        EXPECT_EQ((std::uint64_t)i, *blocks[i]);
+    }
+
+    // release the blocks on other threads than the ones allocating them
+#pragma omp parallel for schedule(static, 1)
+    for (int i = N - 1; i >= 0; i--) {
+        t_pool::deallocate(blocks[i]);
+    }
+}
+
+TEST(NodePool, Trim) {
+    using pool = NodePool<72, 8>;
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10000; i++) {
+        blocks.push_back(pool::allocate());
+    }
+    EXPECT_LT(1u, pool::getNumSlabs());
+
+    // slabs with blocks in use are retained
+    for (std::size_t i = 1; i < blocks.size(); i++) {
+        pool::deallocate(blocks[i]);
+    }
+    NodePools::trim();
+    EXPECT_EQ(1u, pool::getNumSlabs());
+
+    pool::deallocate(blocks[0]);
+    NodePools::trim();
+    EXPECT_EQ(0u, pool::getNumSlabs());
+
+    // the pool is still usable
+    void* a = pool::allocate();
+    EXPECT_EQ(1u, pool::getNumSlabs());
+    pool::deallocate(a);
+}
+
+TEST(NodePool, Statistics) {
+    using pool = NodePool<136, 8>;
+    const auto before = NodePools::getStatistics();
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10000; i++) {
+        blocks.push_back(pool::allocate());
+    }
+    const auto during = NodePools::getStatistics();
+    EXPECT_EQ(before.slabs + pool::getNumSlabs(), during.slabs);
+    EXPECT_TRUE(before.used + 10000 * 136 <= during.used);
+    EXPECT_TRUE(during.used <= during.reserved);
+
+    for (void* block : blocks) {
+        pool::deallocate(block);
+    }
+    NodePools::trim();
+    const auto after = NodePools::getStatistics();
+    EXPECT_EQ(before.slabs, after.slabs);
+    EXPECT_EQ(before.used, after.used);
+    // an arena of huge pages retains the released slabs for the pools
+    if (!after.hugePages) {
+        EXPECT_EQ(before.reserved, after.reserved);
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,340 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file object_storage_test.cpp
+ *
+ * Test cases for reading and writing objects, served from memory by a transport in place of a
+ * server.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/io/ObjectStorage.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <istream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+using object::Codec;
+using object::Location;
+using object::ReadBuffer;
+using object::Request;
+using object::Response;
+using object::Upload;
+
+/** A store of objects by their URLs, answering requests as S3 does */
+class Store {
+public:
+    Store() {
+        Location::setTransport([this](const Request& request, Response& response, std::string& error) {
+            return serve(request, response, error);
+        });
+    }
+
+    ~Store() {
+        Location::setTransport(nullptr);
+    }
+
+    std::map<std::string, std::string> objects;
+
+    /** Whether ranges are ignored, answering with the whole object */
+    bool ignoreRanges = false;
+
+    /** Number of requests to answer by an error of the server before serving them again */
+    int failures = 0;
+
+    /** Number of requests to fail as if the server was unreachable */
+    int disconnections = 0;
+
+    /** The status all requests are refused with, if not zero */
+    long refusal = 0;
+
+    /** The requests served, by their method */
+    std::map<std::string, std::size_t> requests;
+
+    std::vector<std::string> urls;
+
+private:
+    bool serve(const Request& request, Response& response, std::string& error) {
+        std::lock_guard<std::mutex> guard(lock);
+        urls.push_back(request.url);
+        if (disconnections > 0) {
+            --disconnections;
+            error = "unreachable";
+            return false;
+        }
+        if (failures > 0) {
+            --failures;
+            response.status = 503;
+            return true;
+        }
+        ++requests[request.method];
+        if (refusal != 0) {
+            response.status = refusal;
+            return true;
+        }
+        const std::size_t mark = request.url.find('?');
+        const std::string url = request.url.substr(0, mark);
+        const std::string query = mark == std::string::npos ? "" : request.url.substr(mark + 1);
+        const std::string payload = request.payload == nullptr ? "" : std::string(*request.payload);
+
+        if (request.method == "GET") {
+            get(url, request.range, response);
+        } else if (request.method == "PUT" && query.empty()) {
+            objects[url] = payload;
+            response.status = 200;
+        } else if (request.method == "POST" && query == "uploads") {
+            response.status = 200;
+            response.body = "<InitiateMultipartUploadResult><UploadId>upload" + std::to_string(++uploads) +
+                            "</UploadId></InitiateMultipartUploadResult>";
+        } else if (request.method == "PUT") {
+            // partNumber=<n>&uploadId=<id>
+            const std::size_t amp = query.find('&');
+            const std::string number = query.substr(11, amp - 11);
+            parts[query.substr(amp + 10)][std::stoul(number)] = payload;
+            response.status = 200;
+            response.etag = "\"etag" + number + "\"";
+        } else if (request.method == "POST") {
+            // the parts are completed in order of their numbers, by their tags
+            std::string object;
+            std::string expected = "<CompleteMultipartUpload>";
+            for (const auto& [number, part] : parts[query.substr(9)]) {
+                object += part;
+                expected += "<Part><PartNumber>" + std::to_string(number) + "</PartNumber><ETag>\"etag" +
+                            std::to_string(number) + "\"</ETag></Part>";
+            }
+            expected += "</CompleteMultipartUpload>";
+            response.status = 200;
+            if (payload == expected) {
+                objects[url] = object;
+            } else {
+                response.body = "<Error><Code>InvalidPart</Code></Error>";
+            }
+        } else {
+            response.status = 405;
+        }
+        return true;
+    }
+
+    void get(const std::string& url, const std::string& range, Response& response) const {
+        auto it = objects.find(url);
+        if (it == objects.end()) {
+            response.status = 404;
+            return;
+        }
+        const std::string& object = it->second;
+        if (range.empty() || ignoreRanges) {
+            response.status = 200;
+            response.body = object;
+            return;
+        }
+        const std::size_t dash = range.find('-');
+        const std::size_t first = std::stoull(range.substr(0, dash));
+        const std::size_t last =
+                std::min<std::size_t>(std::stoull(range.substr(dash + 1)), object.size() - 1);
+        if (first >= object.size()) {
+            response.status = 416;
+            return;
+        }
+        response.status = 206;
+        response.body = object.substr(first, last - first + 1);
+        response.contentRange = "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" +
+                                std::to_string(object.size());
+    }
+
+    std::mutex lock;
+    std::size_t uploads = 0;
+
+    /** The parts of the uploads in progress, by their numbers */
+    std::map<std::string, std::map<std::size_t, std::string>> parts;
+};
+
+/** Bytes of the given size, not repeating at the boundaries of parts */
+std::string makeBytes(std::size_t size) {
+    std::string res;
+    res.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        res += static_cast<char>((i * 7919 + i / 251) % 256);
+    }
+    return res;
+}
+
+/** Read the whole object, or throw std::runtime_error if it does not exist */
+std::string read(const std::string& uri, std::size_t partSize, std::size_t parallelParts = 3) {
+    ReadBuffer buffer(uri, partSize, parallelParts);
+    if (!buffer.open()) {
+        throw std::runtime_error("missing object " + uri);
+    }
+    std::istream in(&buffer);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write(const std::string& uri, const std::string& bytes, Codec codec = Codec::Plain) {
+    Upload upload(uri, codec, 0, 2);
+    // written in pieces not aligned with the parts
+    constexpr std::size_t piece = 1000003;
+    for (std::size_t i = 0; i < bytes.size(); i += piece) {
+        upload.write(bytes.data() + i, std::min(piece, bytes.size() - i));
+    }
+    upload.close();
+}
+
+const std::string s3Url = "https://bucket.s3.us-east-1.amazonaws.com/";
+
+}  // namespace
+
+TEST(ObjectStorage, Locations) {
+    unsetenv("AWS_ENDPOINT_URL");
+    unsetenv("AWS_REGION");
+    unsetenv("AWS_DEFAULT_REGION");
+    Store store;
+    Location("s3://bucket/dir/a b+c.csv").perform("GET", "", "", nullptr);
+    Location("gs://bucket/dir/a.csv").perform("GET", "uploads", "", nullptr);
+    Location("http://localhost:8080/a.csv?sig=1").perform("GET", "", "", nullptr);
+    setenv("AWS_ENDPOINT_URL", "http://localhost:9000/", 1);
+    Location("s3://bucket/a.csv").perform("GET", "", "", nullptr);
+    unsetenv("AWS_ENDPOINT_URL");
+
+    EXPECT_EQ(4, store.urls.size());
+    EXPECT_EQ(s3Url + "dir/a%20b%2Bc.csv", store.urls[0]);
+    EXPECT_EQ("https://storage.googleapis.com/bucket/dir/a.csv?uploads", store.urls[1]);
+    EXPECT_EQ("http://localhost:8080/a.csv?sig=1", store.urls[2]);
+    EXPECT_EQ("http://localhost:9000/bucket/a.csv", store.urls[3]);
+
+    EXPECT_TRUE(Location("s3://bucket/a").hasMultipartUpload());
+    EXPECT_FALSE(Location("https://host/a").hasMultipartUpload());
+
+    for (const std::string uri : {"ftp://host/a", "s3://bucket", "s3://bucket/", "gs:///key"}) {
+        bool thrown = false;
+        try {
+            Location location(uri);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        EXPECT_TRUE(thrown);
+    }
+}
+
+TEST(ObjectStorage, Read) {
+    Store store;
+    const std::string bytes = makeBytes(1000000);
+    store.objects[s3Url + "a"] = bytes;
+    store.objects[s3Url + "empty"] = "";
+
+    // the parts are read by ranges, several at a time, and joined in order
+    for (std::size_t partSize : {4096, 65536, 999999, 1000000, 1 << 20}) {
+        store.requests.clear();
+        EXPECT_EQ(bytes, read("s3://bucket/a", partSize));
+        EXPECT_EQ((bytes.size() + partSize - 1) / partSize, store.requests["GET"]);
+    }
+    EXPECT_EQ(bytes, read("s3://bucket/a", 4096, 1));
+    EXPECT_EQ("", read("s3://bucket/empty", 4096));
+
+    // servers ignoring ranges send the whole object at once
+    store.ignoreRanges = true;
+    store.requests.clear();
+    EXPECT_EQ(bytes, read("s3://bucket/a", 4096));
+    EXPECT_EQ(1, store.requests["GET"]);
+
+    ReadBuffer missing("s3://bucket/missing", 4096, 3);
+    EXPECT_FALSE(missing.open());
+}
+
+TEST(ObjectStorage, Write) {
+    Store store;
+
+    // objects larger than a part are uploaded in parts of the smallest size
+    const std::string bytes = makeBytes(2 * object::MIN_UPLOAD_PART_SIZE + 12345);
+    write("s3://bucket/large", bytes);
+    EXPECT_EQ(bytes, store.objects[s3Url + "large"]);
+    EXPECT_EQ(2, store.requests["POST"]);
+    EXPECT_EQ(3, store.requests["PUT"]);
+    EXPECT_EQ(bytes, read("s3://bucket/large", 1 << 20));
+
+    // smaller objects, and objects of HTTP servers, are uploaded at once
+    store.requests.clear();
+    write("s3://bucket/small", "a\tb\n");
+    write("http://localhost/large", bytes);
+    write("s3://bucket/empty", "");
+    EXPECT_EQ(0, store.requests["POST"]);
+    EXPECT_EQ(3, store.requests["PUT"]);
+    EXPECT_EQ("a\tb\n", store.objects[s3Url + "small"]);
+    EXPECT_EQ(bytes, store.objects["http://localhost/large"]);
+    EXPECT_EQ("", store.objects[s3Url + "empty"]);
+}
+
+TEST(ObjectStorage, Compression) {
+    Store store;
+    const std::string bytes = makeBytes(3 * object::MIN_UPLOAD_PART_SIZE);
+    std::vector<Codec> codecs;
+#ifdef USE_LIBZ
+    codecs.push_back(Codec::GZip);
+#endif
+#ifdef USE_ZSTD
+    codecs.push_back(Codec::Zstd);
+#endif
+    for (Codec codec : codecs) {
+        write("s3://bucket/compressed", bytes, codec);
+        EXPECT_TRUE(store.objects[s3Url + "compressed"] != bytes);
+
+        // the compression is detected from the first part, and its frames may span parts
+        EXPECT_EQ(bytes, read("s3://bucket/compressed", 65536));
+        EXPECT_EQ(bytes, read("s3://bucket/compressed", 1 << 20));
+    }
+}
+
+TEST(ObjectStorage, Failures) {
+    Store store;
+    const std::string bytes = makeBytes(100000);
+    store.objects[s3Url + "a"] = bytes;
+
+    // errors of the server and of the connection are retried a few times
+    store.failures = 2;
+    store.disconnections = 1;
+    EXPECT_EQ(bytes, read("s3://bucket/a", 4096));
+
+    store.failures = 4;
+    bool thrown = false;
+    try {
+        read("s3://bucket/a", 4096);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+
+    // errors of the client are not retried
+    store.refusal = 403;
+    store.requests.clear();
+    thrown = false;
+    try {
+        write("s3://bucket/b", "a\tb\n");
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_EQ(1, store.requests["PUT"]);
+    EXPECT_EQ(0, store.objects.count(s3Url + "b"));
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -17,7 +17,12 @@
 #include "tests/test.h"
 
 #include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace souffle {
 
@@ -99,5 +104,116 @@ TEST(ParallelUtils, OptimisticReadWriteLock) {
 
     EXPECT_EQ(2 * (N / K), c);
 }
+
+TEST(ParallelUtils, LockProfile) {
+    LockSite* site = LockProfile::getSite("test");
+    if (!LockProfile::enabled) {
+        // the locks are only counted by builds defining USE_LOCK_PROFILING
+        EXPECT_TRUE(site == nullptr);
+        return;
+    }
+    const int N = 100000;
+
+    SpinLock lock;
+
+    volatile int c = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(4)
+#endif
+    for (int i = 0; i < N; i++) {
+        LockSiteScope scope(site);
+        lock.lock();
+        c++;
+        lock.unlock();
+    }
+    EXPECT_EQ(N, site->getTotals(LockKind::SpinLock).acquisitions);
+
+    OptimisticReadWriteLock rw;
+    {
+        LockSiteScope scope(site);
+        auto lease = rw.start_read();
+        rw.start_write();
+        rw.end_write();
+        EXPECT_FALSE(rw.validate(lease));
+    }
+    const auto optimistic = site->getTotals(LockKind::OptimisticReadWriteLock);
+    EXPECT_EQ(2, optimistic.acquisitions);
+    EXPECT_EQ(1, optimistic.failures);
+
+    // outside of any scope, the locks are attributed to the untagged site
+    rw.start_write();
+    rw.end_write();
+    EXPECT_EQ(2, site->getTotals(LockKind::OptimisticReadWriteLock).acquisitions);
+    const auto untagged = LockProfile::getSite("(untagged)")->getTotals(LockKind::OptimisticReadWriteLock);
+    EXPECT_LT(0, untagged.acquisitions);
+}
+
+TEST(ParallelUtils, MergeRuns) {
+    // overlapping runs of distinct lengths, one of them empty
+    std::vector<std::vector<int>> runs(5);
+    for (int i = 0; i < 20000; ++i) {
+        runs[i % 3].push_back(i);
+        if (i % 7 == 0) {
+            runs[3].push_back(i);
+        }
+    }
+
+    std::mutex lock;
+    std::vector<std::vector<int>> chunks;
+    mergeRuns(runs, [&](auto begin, auto end) {
+        std::lock_guard<std::mutex> guard(lock);
+        chunks.emplace_back(begin, end);
+    });
+    EXPECT_TRUE(std::all_of(runs.begin(), runs.end(), [](const auto& run) { return run.empty(); }));
+
+    // the chunks are consecutive ranges of the distinct tuples
+    EXPECT_TRUE(std::none_of(chunks.begin(), chunks.end(), [](const auto& chunk) { return chunk.empty(); }));
+    std::sort(chunks.begin(), chunks.end(),
+            [](const auto& a, const auto& b) { return a.front() < b.front(); });
+    std::vector<int> merged;
+    for (const auto& chunk : chunks) {
+        merged.insert(merged.end(), chunk.begin(), chunk.end());
+    }
+    EXPECT_EQ(20000, merged.size());
+    for (std::size_t i = 0; i < merged.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(i), merged[i]);
+    }
+}
+
+TEST(ParallelUtils, WorkQueues) {
+    // each number below N produces its two successors in a binary tree, from a single root
+    const int N = 100000;
+    const std::size_t threads = 4;
+    WorkQueues<int> queues(threads);
+    queues.push(0, 1);
+    std::atomic<int> processed{0};
+    std::atomic<long> sum{0};
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads)
+#endif
+    {
+#ifdef _OPENMP
+        const auto thread = static_cast<std::size_t>(omp_get_thread_num());
+#else
+        const std::size_t thread = 0;
+#endif
+        int item = 0;
+        while (queues.pop(thread, item)) {
+            ++processed;
+            sum += item;
+            for (int next : {2 * item, 2 * item + 1}) {
+                if (next < N) {
+                    queues.push(thread, next);
+                }
+            }
+            queues.done();
+        }
+    }
+
+    EXPECT_EQ(N - 1, processed);
+    EXPECT_EQ(static_cast<long>(N) * (N - 1) / 2, sum);
+}
 }  // namespace test
 }  // end namespace souffle
@@ -0,0 +1,120 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file partitioned_output_test.cpp
+ *
+ * Test cases for writing relations to partitioned files.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/datastructure/BTree.h"
+#include "souffle/io/IOSystem.h"
+#include "souffle/utility/FileUtil.h"
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+using Tuple = std::array<RamDomain, 2>;
+
+std::map<std::string, std::string> makeDirective(const std::string& stem) {
+    return {{"IO", "file"}, {"name", "rel"}, {"filename", stem + ".csv"}, {"partitions", "4"},
+            {"types", R"({"relation": {"arity": 2, "types": ["s:symbol", "i:number"]}})"},
+            {"params", R"({"relation": {"arity": 2, "params": ["key", "value"]}})"}};
+}
+
+/** Read and remove the lines of the files of the partitions */
+std::vector<std::vector<std::string>> readPartitions(const std::string& stem) {
+    std::vector<std::vector<std::string>> partitions;
+    for (std::string suffix : {"-00000.csv", "-00001.csv", "-00002.csv", "-00003.csv"}) {
+        std::ifstream file(stem + suffix);
+        partitions.emplace_back();
+        for (std::string line; std::getline(file, line);) {
+            partitions.back().push_back(line);
+        }
+        std::remove((stem + suffix).c_str());
+    }
+    return partitions;
+}
+
+}  // namespace
+
+TEST(WritePartitioned, Ranges) {
+    SymbolTable symbolTable;
+    SpecializedRecordTable<0> recordTable;
+    btree_set<Tuple> relation;
+    for (RamDomain i = 0; i < 10000; ++i) {
+        relation.insert({symbolTable.encode("key" + std::to_string(i % 10)), i});
+    }
+
+    const std::string stem = tempFile();
+    IOSystem::getInstance().getWriter(makeDirective(stem), symbolTable, recordTable)->writeAll(relation);
+    std::remove(stem.c_str());
+
+    // the files hold consecutive ranges of the relation, in order
+    std::vector<std::string> lines;
+    for (const auto& partition : readPartitions(stem)) {
+        lines.insert(lines.end(), partition.begin(), partition.end());
+    }
+    EXPECT_EQ(lines.size(), relation.size());
+    auto line = lines.begin();
+    for (const auto& tuple : relation) {
+        EXPECT_EQ(*line++, symbolTable.decode(tuple[0]) + "\t" + std::to_string(tuple[1]));
+    }
+}
+
+TEST(WritePartitioned, Hashed) {
+    SymbolTable symbolTable;
+    SpecializedRecordTable<0> recordTable;
+    btree_set<Tuple> relation;
+    for (RamDomain i = 0; i < 10000; ++i) {
+        relation.insert({symbolTable.encode("key" + std::to_string(i % 100)), i});
+    }
+
+    const std::string stem = tempFile();
+    auto directive = makeDirective(stem);
+    directive["partition_by"] = "key";
+    IOSystem::getInstance().getWriter(directive, symbolTable, recordTable)->writeAll(relation);
+    std::remove(stem.c_str());
+
+    // each key is written to a single file
+    std::size_t count = 0;
+    std::set<std::string> keys;
+    for (const auto& partition : readPartitions(stem)) {
+        std::set<std::string> partitionKeys;
+        for (const auto& line : partition) {
+            partitionKeys.insert(line.substr(0, line.find('\t')));
+        }
+        for (const auto& key : partitionKeys) {
+            EXPECT_TRUE(keys.insert(key).second);
+        }
+        count += partition.size();
+    }
+    EXPECT_EQ(count, relation.size());
+    EXPECT_EQ(keys.size(), 100);
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -0,0 +1,169 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file preprocessor_test.cpp
+ *
+ * Test cases for the built-in pre-processor.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "parser/Preprocessor.h"
+#include "souffle/utility/FileUtil.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+/** A file with the given contents, removed at the end of the test */
+class TempFile {
+public:
+    explicit TempFile(const std::string& contents) : path(tempFile()) {
+        write(contents);
+    }
+
+    ~TempFile() {
+        std::remove(path.c_str());
+    }
+
+    void write(const std::string& contents) const {
+        std::ofstream(path) << contents;
+    }
+
+    /** The name of the file for an #include in a file of the same directory */
+    std::string name() const {
+        return baseName(path);
+    }
+
+    const std::string path;
+};
+
+/** The lines of the fragments other than linemarkers and blank lines */
+std::string code(const std::vector<std::string>& fragments) {
+    std::string res;
+    for (const std::string& fragment : fragments) {
+        std::stringstream lines(fragment);
+        for (std::string line; std::getline(lines, line);) {
+            if (!line.empty() && line[0] != '#' && line.find_first_not_of(' ') != std::string::npos) {
+                res += line + "\n";
+            }
+        }
+    }
+    return res;
+}
+
+std::string preprocess(const std::string& program) {
+    TempFile file(program);
+    return code(Preprocessor({"."}).process(file.path));
+}
+
+bool fails(const std::string& program) {
+    try {
+        preprocess(program);
+    } catch (std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(Preprocessor, Macros) {
+    EXPECT_EQ("a(1, 2).\n", preprocess("#define N 1\n#define M N, 2\na(M).\n"));
+    EXPECT_EQ("a(3 + 1).\n", preprocess("#define INC(x) x + 1\na(INC(3)).\n"));
+    EXPECT_EQ("a(\"x + \\\"y\\\"\").\n", preprocess("#define STR(x) #x\na(STR(x  +  \"y\")).\n"));
+    EXPECT_EQ("ab(1).\n", preprocess("#define CAT(x, y) x ## y\nCAT(a, b)(1).\n"));
+    EXPECT_EQ("a(1, 2, 3).\n", preprocess("#define A(x, ...) a(x, __VA_ARGS__)\nA(1, 2, 3).\n"));
+
+    // macros are not expanded again within their own expansion, but rescanned with what follows
+    EXPECT_EQ("a(b + 1).\n", preprocess("#define b b + 1\na(b).\n"));
+    EXPECT_EQ("a(2).\n", preprocess("#define F G\n#define G(x) x\na(F(2)).\n"));
+
+    // the arguments of an invocation may span lines, which are kept after the expansion
+    EXPECT_EQ("a(1 + 2).\nb(3).\n", preprocess("#define ADD(x, y) x + y\na(ADD(1,\n2)).\nb(3).\n"));
+
+    EXPECT_EQ("a(N).\n", preprocess("#define N 1\n#undef N\na(N).\n"));
+    EXPECT_EQ("\"// no comment\"  .\n", preprocess("\"// no comment\" /* comment */.\n"));
+
+    Preprocessor pp({"."});
+    pp.defineAll("-DN=4 -D'F(x)=x * N' -DM -UM");
+    TempFile file("a(F(2)).\n#ifndef M\nb(M).\n#endif\n");
+    EXPECT_EQ("a(2 * 4).\nb(M).\n", code(pp.process(file.path)));
+}
+
+TEST(Preprocessor, Conditionals) {
+    EXPECT_EQ("b.\n", preprocess("#if 0\na.\n#else\nb.\n#endif\n"));
+    EXPECT_EQ("b.\n", preprocess("#define N 3\n#if N > 4\na.\n#elif N * 2 == 6 && defined(N)\nb.\n"
+                                  "#else\nc.\n#endif\n"));
+    EXPECT_EQ("c.\n", preprocess("#ifdef X\n#if 1\na.\n#endif\n#elif defined X\nb.\n#else\nc.\n#endif\n"));
+    EXPECT_EQ("a.\n", preprocess("#if (1 ? 2 : 0) % 2 == 0 && !UNDEFINED\na.\n#endif\n"));
+
+    EXPECT_TRUE(fails("#if 1\na.\n"));
+    EXPECT_TRUE(fails("#endif\n"));
+    EXPECT_TRUE(fails("#error stop\n"));
+    EXPECT_TRUE(fails("#include \"missing.dl\"\n"));
+    EXPECT_FALSE(fails("#if 0\n#error skipped\n#endif\n"));
+}
+
+TEST(Preprocessor, Includes) {
+    TempFile guarded("#ifndef GUARD\n#define GUARD\n.decl b(x:number)\nb(N).\n#endif\n");
+    TempFile once("#pragma once\n.decl c(x:number)\n");
+    TempFile attributes("x:number, y:number\n");
+    TempFile program("#define N 7\n.decl a(x:number)\n#include \"" + guarded.name() + "\"\n#include \"" +
+                     guarded.name() + "\"\n#include \"" + once.name() + "\"\n#include \"" + once.name() +
+                     "\"\n.decl d(\n#include \"" + attributes.name() + "\"\n)\na(1).\n");
+
+    const auto fragments = Preprocessor({"."}).process(program.path);
+    EXPECT_EQ(".decl a(x:number)\n.decl b(x:number)\nb(7).\n.decl c(x:number)\n"
+              ".decl d(\nx:number, y:number\n)\na(1).\n",
+            code(fragments));
+
+    // the files between declarations are fragments of their own, unlike the file within the declaration
+    EXPECT_EQ(4, fragments.size());
+    EXPECT_TRUE(fragments[1].find("# 1 \"" + program.path + "\"\n# 1 \"" + guarded.name() + "\"") == 0);
+    EXPECT_TRUE(fragments[3].find("x:number, y:number") != std::string::npos);
+
+    // the lines after an include continue at a linemarker
+    EXPECT_TRUE(fragments[3].find("# 9 \"" + program.path + "\"\n)\na(1).") != std::string::npos);
+}
+
+TEST(Preprocessor, Cache) {
+    const std::string dir = tempFile();
+    std::remove(dir.c_str());
+    EXPECT_TRUE(mkdir(dir.c_str(), 0755) == 0);
+
+    TempFile included("b(N).\n");
+    TempFile program("#include \"" + included.name() + "\"\na(N).\n");
+    auto run = [&]() {
+        Preprocessor pp({"."}, dir);
+        pp.define("N=1");
+        return code(pp.process(program.path));
+    };
+    EXPECT_EQ("b(1).\na(1).\n", run());
+    EXPECT_EQ("b(1).\na(1).\n", run());
+
+    // changes of included files invalidate the entries of the files including them
+    included.write("b(N + 1).\n");
+    EXPECT_EQ("b(1 + 1).\na(1).\n", run());
+
+    execStdOut(("rm -rf '" + dir + "'").c_str());
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -17,10 +17,22 @@
 #include "tests/test.h"
 
 #include "souffle/profile/CellInterface.h"
+#include "souffle/profile/Logger.h"
+#include "souffle/profile/OutputProcessor.h"
+#include "souffle/profile/ProfileDatabase.h"
+#include "souffle/profile/ProfileEvent.h"
+#include "souffle/profile/ProgramRun.h"
+#include "souffle/profile/Reader.h"
+#include "souffle/profile/Rule.h"
 #include "souffle/profile/StringUtils.h"
+#include "souffle/utility/FileUtil.h"
 #include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iosfwd>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -138,3 +150,190 @@ TEST(StringUtil, cleanJsonOutDouble) {
     EXPECT_EQ("NaN", Tools::cleanJsonOut(NAN));
     EXPECT_EQ("1.234567e+02", Tools::cleanJsonOut(123.4567));
 }
+
+namespace {
+/** Fill a database with entries of each kind */
+void fillDatabase(ProfileDatabase& db) {
+    db.addDurationEntry(
+            {"program", "runtime"}, std::chrono::microseconds(10), std::chrono::microseconds(990));
+    db.addTextEntry({"program", "relation", "path", "source-locator"}, "path.dl [3:1-3:20]");
+    db.addSizeEntry({"program", "relation", "path", "num-tuples"}, 1234567890123);
+    db.addDurationEntry({"program", "relation", "path", "iteration", "0", "runtime"},
+            std::chrono::microseconds(20), std::chrono::microseconds(500));
+    db.addTimeEntry({"program", "starttime"}, std::chrono::microseconds(5));
+}
+
+std::string printDatabase(const ProfileDatabase& db) {
+    std::stringstream out;
+    db.print(out);
+    return out.str();
+}
+TEST(ProfileEvent, IndexAccess) {
+    ProfileEventSingleton::instance().makeIndexAccessEvent("edge", "[0,1]", 0, 12, 40, 10);
+    ProfileEventSingleton::instance().makeIndexAccessEvent("edge", "[1,0]", 0, 0, 0, 10);
+    ProfileEventSingleton::instance().flush();
+
+    const std::string filename = tempFile();
+    {
+        std::ofstream file(filename);
+        ProfileEventSingleton::instance().getDB().print(file);
+    }
+    OutputProcessor out;
+    Reader reader(filename, out.getProgramRun());
+    reader.processFile();
+    std::remove(filename.c_str());
+
+    Table table = out.getIndexAccessTable();
+    EXPECT_EQ(2, table.getRows().size());
+    auto& used = *table.getRows()[0];
+    EXPECT_EQ("[0,1]", used[2]->getStringVal());
+    EXPECT_EQ(40, used[5]->getLongVal());
+    EXPECT_EQ(10, used[6]->getLongVal());
+    EXPECT_LT(std::fabs(used[7]->getDoubleVal() - 1.2), 1e-9);
+    auto& unused = *table.getRows()[1];
+    EXPECT_EQ("[1,0]", unused[2]->getStringVal());
+    EXPECT_EQ(0, unused[7]->getDoubleVal());
+}
+
+TEST(ProfileEvent, Operators) {
+    using namespace std::chrono_literals;
+    const std::string nonRecursive = "@t-nonrecursive-rule;reach;p.dl [3:1-3:20];reach(x) :- start(x).";
+    ProfileEventSingleton::instance().makeOperatorEvent(nonRecursive, 0, 0, "FOR t0 IN start", 1, 5000ns, 0);
+    ProfileEventSingleton::instance().makeOperatorEvent(
+            nonRecursive, 1, 1, "INSERT (t0.0) INTO reach", 10, 3000ns, 0);
+    const std::string recursive =
+            "@t-recursive-rule;reach;0;p.dl [4:1-4:30];reach(y) :- reach(x), edge(x,y).";
+    for (std::size_t iteration = 0; iteration < 2; ++iteration) {
+        ProfileEventSingleton::instance().makeOperatorEvent(
+                recursive, 0, 0, "FOR t0 IN @delta_reach", 1, 9000ns, iteration);
+        ProfileEventSingleton::instance().makeOperatorEvent(
+                recursive, 1, 1, "FOR t1 IN edge ON INDEX t1.0 = t0.0", 4, 8000ns, iteration);
+        ProfileEventSingleton::instance().makeOperatorEvent(
+                recursive, 2, 2, "INSERT (t1.1) INTO @new_reach", 6 + iteration, 2000ns, iteration);
+    }
+    // only the operators of timed rules are recorded
+    ProfileEventSingleton::instance().makeOperatorEvent("@t-relation-savetime;reach", 0, 0, "", 1, 1ns, 0);
+    ProfileEventSingleton::instance().flush();
+
+    const std::string filename = tempFile();
+    {
+        std::ofstream file(filename);
+        ProfileEventSingleton::instance().getDB().print(file);
+    }
+    OutputProcessor out;
+    Reader reader(filename, out.getProgramRun());
+    reader.processFile();
+    std::remove(filename.c_str());
+
+    const auto& relation = *out.getProgramRun()->getRelation("reach");
+    EXPECT_EQ(1, relation.getRuleMap().size());
+    auto executions = out.getPlanExecutions(relation.getRuleMap().begin()->second->getId());
+    EXPECT_EQ(1, executions.size());
+    const auto& operators = executions[0].second->getOperators();
+    EXPECT_EQ(2, operators.size());
+    EXPECT_EQ("INSERT (t0.0) INTO reach", operators.at(1).text);
+    EXPECT_EQ(1, operators.at(1).depth);
+    EXPECT_EQ(10, operators.at(1).calls);
+    EXPECT_EQ(3000, operators.at(1).time.count());
+
+    EXPECT_EQ(2, relation.getIterations().size());
+    const auto& rule = *relation.getIterations()[0]->getRules().begin()->second;
+    executions = out.getPlanExecutions(rule.getId());
+    EXPECT_EQ(2, executions.size());
+    std::size_t inserted = 0;
+    for (const auto& execution : executions) {
+        EXPECT_EQ(3, execution.second->getOperators().size());
+        inserted += execution.second->getOperators().at(2).calls;
+    }
+    EXPECT_EQ(13, inserted);
+}
+
+}  // namespace
+
+TEST(ProfileDatabase, ReadJson) {
+    ProfileDatabase db;
+    fillDatabase(db);
+    const std::string filename = tempFile();
+    {
+        std::ofstream file(filename);
+        db.print(file);
+    }
+    ProfileDatabase read(filename);
+    EXPECT_EQ(printDatabase(db), printDatabase(read));
+    std::remove(filename.c_str());
+}
+
+TEST(ProfileDatabase, ReadLog) {
+    const std::string base = tempFile();
+    const std::string filename = base + ".bin";
+    ProfileDatabase db;
+    // entries added before and after the log is started are written
+    db.addSizeEntry({"program", "relation", "edge", "num-tuples"}, 3);
+    db.startLog(filename);
+    fillDatabase(db);
+    db.flushLog();
+
+    ProfileDatabase read(filename);
+    EXPECT_EQ(printDatabase(db), printDatabase(read));
+
+    // a log cut short is read up to its last complete record, and the rest once it is appended
+    std::string contents;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    std::ofstream(filename, std::ios::binary) << contents.substr(0, contents.size() - 3);
+    ProfileDatabase partial(filename);
+    EXPECT_EQ(nullptr, partial.lookupEntry({"program", "starttime"}));
+    EXPECT_NE(nullptr, partial.lookupEntry({"program", "relation", "path", "num-tuples"}));
+    EXPECT_FALSE(partial.update(filename));
+    std::ofstream(filename, std::ios::binary) << contents;
+    EXPECT_TRUE(partial.update(filename));
+    EXPECT_EQ(printDatabase(db), printDatabase(partial));
+    std::remove(filename.c_str());
+    std::remove(base.c_str());
+}
+
+TEST(Logger, ThreadUtilisation) {
+    auto at = [](long us) { return time_point(std::chrono::microseconds(us)); };
+    {
+        Logger logger("@t-nonrecursive-rule;path;path.dl [3:1-3:20];path(x,y) :- edge(x,y).", 0);
+        EXPECT_EQ(&logger, Logger::current());
+        // the first two chunks of thread 0 are back to back, and hence one interval of its timeline
+        logger.addChunk(0, at(0), at(100));
+        logger.addChunk(0, at(150), at(250));
+        logger.addChunk(0, at(1000), at(1100));
+        logger.addChunk(1, at(0), at(400));
+    }
+    EXPECT_EQ(nullptr, Logger::current());
+    ProfileEventSingleton::instance().flush();
+
+    const std::string filename = tempFile();
+    {
+        std::ofstream file(filename);
+        ProfileEventSingleton::instance().getDB().print(file);
+    }
+    OutputProcessor out;
+    Reader reader(filename, out.getProgramRun());
+    reader.processFile();
+    std::remove(filename.c_str());
+
+    auto executions = out.getThreadExecutions("N1.1");
+    EXPECT_EQ(1, executions.size());
+    const Rule& rule = *executions[0].second;
+    EXPECT_EQ(2, rule.getThreads().size());
+    const ThreadUsage& thread = rule.getThreads().at(0);
+    EXPECT_EQ(300, thread.busy.count());
+    EXPECT_EQ(3, thread.chunks);
+    EXPECT_EQ(2, thread.timeline.size());
+    EXPECT_EQ(250, thread.timeline[0].second.count());
+    EXPECT_EQ(1100, rule.getThreadSpan().second.count());
+    EXPECT_EQ(2 * 1100 - 700, rule.getIdletime().count());
+
+    Table table = out.getThreadTable();
+    EXPECT_EQ(1, table.getRows().size());
+    auto& row = *table.getRows()[0];
+    EXPECT_EQ(2, row[2]->getLongVal());
+    // the busiest thread took 400us, where equally busy threads would take 350us
+    EXPECT_LT(std::fabs(row[5]->getDoubleVal() - 400.0 / 350.0), 1e-9);
+}
@@ -0,0 +1,220 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file read_stream_test.cpp
+ *
+ * Test cases for reading the tuples of input files in blocks.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/io/IOSystem.h"
+#include "souffle/utility/FileUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+namespace {
+
+using Tuple = std::array<RamDomain, 2>;
+
+/** A relation recording the inserted tuples in order */
+struct Recorder {
+    std::vector<Tuple> tuples;
+    void insert(const RamDomain* tuple) {
+        tuples.push_back({tuple[0], tuple[1]});
+    }
+};
+
+std::map<std::string, std::string> makeDirective(const std::string& io, const std::string& fileName) {
+    return {{"IO", io}, {"name", "rel"}, {"filename", fileName},
+            {"types", R"({"relation": {"arity": 2, "types": ["s:symbol", "i:number"]}})"},
+            {"params", R"({"relation": {"arity": 2, "params": ["key", "value"]}})"}};
+}
+
+/** Read the given file into a recorder, and remove the file */
+Recorder read(const std::map<std::string, std::string>& directive, SymbolTable& symbolTable) {
+    SpecializedRecordTable<0> recordTable;
+    Recorder relation;
+    IOSystem::getInstance().getReader(directive, symbolTable, recordTable)->readAll(relation);
+    std::remove(directive.at("filename").c_str());
+    return relation;
+}
+
+/** Whether the tuples are the sequence written by the tests, in order */
+bool isSequence(const Recorder& relation, const SymbolTable& symbolTable, RamDomain count) {
+    if (relation.tuples.size() != static_cast<std::size_t>(count)) {
+        return false;
+    }
+    for (RamDomain i = 0; i < count; ++i) {
+        const Tuple& tuple = relation.tuples[i];
+        if (symbolTable.decode(tuple[0]) != "key" + std::to_string(i % 7) || tuple[1] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(ReadStream, CSV) {
+    // more tuples than fit into a block, and exactly a block
+    for (RamDomain count : {0, 1, 1024, 3000}) {
+        const std::string fileName = tempFile();
+        {
+            std::ofstream file(fileName);
+            for (RamDomain i = 0; i < count; ++i) {
+                file << "key" << i % 7 << "\t" << i << "\n";
+            }
+        }
+        SymbolTable symbolTable;
+        EXPECT_TRUE(isSequence(read(makeDirective("file", fileName), symbolTable), symbolTable, count));
+    }
+}
+
+TEST(ReadStream, CSVParallel) {
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    // the lines are split into chunks parsed by several threads, and kept in order; the last line
+    // may lack its newline, and lines may end as on Windows
+    const RamDomain count = 200000;
+    for (const std::string ending : {"\n", "\r\n"}) {
+        for (const bool lastNewline : {true, false}) {
+            const std::string fileName = tempFile();
+            {
+                std::ofstream file(fileName, std::ios::binary);
+                for (RamDomain i = 0; i < count; ++i) {
+                    file << "key" << i % 7 << "\t" << i << (i + 1 < count || lastNewline ? ending : "");
+                }
+            }
+            SymbolTable symbolTable;
+            EXPECT_TRUE(isSequence(read(makeDirective("file", fileName), symbolTable), symbolTable, count));
+        }
+    }
+
+    // numbers other than plain decimals are converted as by the sequential reader
+    const std::string fileName = tempFile();
+    {
+        std::ofstream file(fileName);
+        for (RamDomain i = 0; i < count; ++i) {
+            file << "key" << i % 7 << "\t" << (i % 2 == 0 ? "+" : "") << i << "\n";
+        }
+    }
+    auto directive = makeDirective("file", fileName);
+    SymbolTable symbolTable;
+    EXPECT_TRUE(isSequence(read(directive, symbolTable), symbolTable, count));
+
+    // errors name the line in the file rather than in the chunk
+    {
+        std::ofstream file(fileName);
+        for (RamDomain i = 0; i < count; ++i) {
+            file << "key" << i % 7 << "\t" << (i == 150000 ? "x" : std::to_string(i)) << "\n";
+        }
+    }
+    std::string error;
+    try {
+        read(directive, symbolTable);
+    } catch (const std::invalid_argument& e) {
+        error = e.what();
+    }
+    EXPECT_EQ("Error converting <x> in column 2 in line 150001; cannot parse fact file " +
+                      baseName(fileName) + "!\n",
+            error);
+    std::remove(fileName.c_str());
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+}
+
+TEST(ReadStream, CSVPushdown) {
+    const std::string fileName = tempFile();
+    {
+        std::ofstream file(fileName);
+        for (RamDomain i = 0; i < 3000; ++i) {
+            file << "key" << i % 7 << "\t" << i << "\n";
+        }
+    }
+
+    // lines outside the filter do not take a place in the block
+    SymbolTable symbolTable;
+    auto directive = makeDirective("file", fileName);
+    directive["params"] = R"({"relation": {"arity": 2, "params": ["key", "value"]}, "pushdown": )"
+                          R"({"columns": [true, true], "filters": [{"column": 0, "values": ["key3"]}]}})";
+    const Recorder relation = read(directive, symbolTable);
+    EXPECT_EQ(429, relation.tuples.size());
+    for (const auto& tuple : relation.tuples) {
+        EXPECT_EQ("key3", symbolTable.decode(tuple[0]));
+        EXPECT_EQ(3, tuple[1] % 7);
+    }
+}
+
+TEST(ReadStream, Inline) {
+    const RamDomain count = 3000;
+    std::string data;
+    for (RamDomain i = 0; i < count; ++i) {
+        data += "key" + std::to_string(i % 7) + "\t" + std::to_string(i) + "\n";
+    }
+    auto directive = makeDirective("inline", "");
+    directive.erase("filename");
+    directive["data"] = data;
+
+    SymbolTable symbolTable;
+    SpecializedRecordTable<0> recordTable;
+    Recorder relation;
+    IOSystem::getInstance().getReader(directive, symbolTable, recordTable)->readAll(relation);
+    EXPECT_TRUE(isSequence(relation, symbolTable, count));
+}
+
+TEST(ReadStream, JSON) {
+    const RamDomain count = 2500;
+    for (const bool ndjson : {false, true}) {
+        const std::string fileName = tempFile();
+        {
+            std::ofstream file(fileName);
+            file << (ndjson ? "" : "[");
+            for (RamDomain i = 0; i < count; ++i) {
+                if (!ndjson && i > 0) {
+                    file << ",";
+                }
+                // tuples as arrays and as objects of their attributes
+                if (i % 2 == 0) {
+                    file << "[\"key" << i % 7 << "\", " << i << "]";
+                } else {
+                    file << "{\"value\": " << i << ", \"key\": \"key" << i % 7 << "\"}";
+                }
+                file << (ndjson ? "\n" : "");
+            }
+            file << (ndjson ? "" : "]");
+        }
+        auto directive = makeDirective("jsonfile", fileName);
+        directive["ndjson"] = ndjson ? "true" : "false";
+        SymbolTable symbolTable;
+        EXPECT_TRUE(isSequence(read(directive, symbolTable), symbolTable, count));
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -187,4 +187,53 @@ INSTANTIATE_TEMPLATE_TEST(PackUnpack, Vector, 11);
 INSTANTIATE_TEMPLATE_TEST(PackUnpack, Vector, 23);
 INSTANTIATE_TEMPLATE_TEST(PackUnpack, Vector, 59);
 
+TEST(PackUnpack, Many) {
+    SpecializedRecordTable<2> recordTable;
+    const RamDomain N = 100000;
+
+    std::vector<RamDomain> refs(N);
+#pragma omp parallel for
+    for (RamDomain i = 0; i < N; ++i) {
+        refs[i] = recordTable.pack({i, -i});
+    }
+    EXPECT_EQ(recordTable.size(), static_cast<std::size_t>(N));
+
+    // references are dense, starting at 1
+    std::vector<RamDomain> sorted(refs);
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(sorted.front(), 1);
+    EXPECT_EQ(sorted.back(), N);
+    EXPECT_TRUE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+    // packing again yields the same references
+    std::vector<RamDomain> again(N);
+#pragma omp parallel for
+    for (RamDomain i = 0; i < N; ++i) {
+        again[i] = recordTable.pack({i, -i});
+    }
+    EXPECT_TRUE(again == refs);
+    EXPECT_EQ(recordTable.size(), static_cast<std::size_t>(N));
+
+    for (RamDomain i = 0; i < N; ++i) {
+        const RamDomain* ptr = recordTable.unpack(refs[i], 2);
+        EXPECT_EQ(ptr[0], i);
+        EXPECT_EQ(ptr[1], -i);
+    }
+}
+
+TEST(PackUnpack, Swap) {
+    SpecializedRecordTable<2> X;
+    SpecializedRecordTable<2> Y;
+    const RamDomain ref = X.pack({1, 2});
+    X.pack({1, 2, 3});
+    X.swap(Y);
+
+    EXPECT_EQ(X.size(), 0);
+    EXPECT_EQ(Y.size(), 2);
+    EXPECT_EQ(Y.pack({1, 2}), ref);
+    EXPECT_EQ(Y.unpack(ref, 2)[1], 2);
+    EXPECT_EQ(X.pack({3, 4}), 1);
+    EXPECT_EQ(X.pack({3, 4, 5}), 1);
+}
+
 }  // namespace souffle::test
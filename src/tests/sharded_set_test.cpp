@@ -0,0 +1,151 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file sharded_set_test.cpp
+ *
+ * Test cases for the sets sharded over the NUMA nodes.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/datastructure/ShardedSet.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using t_tuple = std::array<int, 2>;
+using t_set = sharded_set<t_tuple, btree_set<t_tuple>, 0>;
+using t_multiset = sharded_set<t_tuple, btree_multiset<t_tuple, detail::comparator<t_tuple>>, 0>;
+
+TEST(ShardedSet, Basic) {
+    t_set set(4);
+    EXPECT_EQ(4, set.getNumShards());
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(set.begin() == set.end());
+
+    std::set<t_tuple> expected;
+    for (int i = 0; i < 100; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            EXPECT_TRUE(set.insert({i, j}));
+            expected.insert({i, j});
+        }
+    }
+    EXPECT_FALSE(set.insert({5, 5}));
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(expected.size(), set.size());
+    EXPECT_TRUE(set.contains({7, 3}));
+    EXPECT_FALSE(set.contains({7, 10}));
+    EXPECT_TRUE(set.find({100, 0}) == set.end());
+
+    // the elements of all shards are visited once
+    std::vector<t_tuple> elements(set.begin(), set.end());
+    std::sort(elements.begin(), elements.end());
+    EXPECT_EQ(std::vector<t_tuple>(expected.begin(), expected.end()), elements);
+
+    // iterating from a found element continues over the following shards
+    auto pos = set.find(*set.begin());
+    EXPECT_EQ(expected.size(), static_cast<std::size_t>(std::distance(pos, set.end())));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(set.begin() == set.end());
+}
+
+TEST(ShardedSet, Ranges) {
+    t_multiset set(3);
+    for (int i = 0; i < 50; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            set.insert({i, j});
+            set.insert({i, j});
+        }
+    }
+    t_multiset::operation_hints lower;
+    t_multiset::operation_hints upper;
+
+    // a bound first column selects a single shard
+    auto r = set.lower_upper_range({7, 5}, {7, 9}, lower, upper);
+    std::vector<t_tuple> elements(r.begin(), r.end());
+    EXPECT_EQ(10, elements.size());
+    for (const auto& t : elements) {
+        EXPECT_EQ(7, t[0]);
+        EXPECT_TRUE(t[1] >= 5 && t[1] <= 9);
+    }
+    EXPECT_EQ(10, set.countRange({7, 5}, {7, 9}));
+
+    // other ranges are collected from all shards
+    r = set.lower_upper_range({10, 0}, {19, 19}, lower, upper);
+    EXPECT_EQ(400, std::distance(r.begin(), r.end()));
+    EXPECT_EQ(400, set.countRange({10, 0}, {19, 19}));
+
+    r = set.lower_upper_range({60, 0}, {70, 0}, lower, upper);
+    EXPECT_TRUE(r.begin() == r.end());
+}
+
+TEST(ShardedSet, Chunks) {
+    t_set set(4);
+    for (int i = 0; i < 1000; ++i) {
+        set.insert({i, i});
+    }
+
+    std::size_t count = 0;
+    for (const auto& chunk : set.getChunks(20)) {
+        count += std::distance(chunk.begin(), chunk.end());
+    }
+    EXPECT_EQ(1000, count);
+
+    // every chunk grouped by node is taken once, also by threads of other nodes
+    auto part = set.getNodeChunks(20);
+    std::vector<int> seen(1000, 0);
+    for (std::size_t i = 0; i < part->size(); ++i) {
+        for (const auto& t : part->take()) {
+            ++seen[t[0]];
+        }
+    }
+    EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+}
+
+TEST(ShardedSet, Place) {
+    t_set set(2);
+    std::set<t_tuple> expected;
+    for (int i = 0; i < 5000; ++i) {
+        set.insert({i % 97, i});
+        expected.insert({i % 97, i});
+    }
+    set.place();
+    EXPECT_EQ(expected.size(), set.size());
+    std::vector<t_tuple> elements(set.begin(), set.end());
+    std::sort(elements.begin(), elements.end());
+    EXPECT_EQ(std::vector<t_tuple>(expected.begin(), expected.end()), elements);
+    EXPECT_TRUE(set.contains({3, 3}));
+}
+
+TEST(ShardedSet, ParallelInsert) {
+    t_set set(4);
+    PARALLEL_START
+        t_set::operation_hints hints;
+        pfor(int i = 0; i < 10000; ++i) {
+            set.insert({i % 31, i}, hints);
+        }
+    PARALLEL_END
+    EXPECT_EQ(10000, set.size());
+}
+
+}  // namespace test
+}  // namespace souffle
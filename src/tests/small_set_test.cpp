@@ -0,0 +1,112 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file small_set_test.cpp
+ *
+ * Test cases for the small set and multiset data structures.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/datastructure/SmallSet.h"
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <vector>
+
+namespace souffle {
+
+namespace test {
+
+using t_set = small_set<int, detail::comparator<int>, btree_set<int>, 4>;
+using t_multiset = small_multiset<int, detail::comparator<int>, btree_multiset<int>, 4>;
+
+TEST(SmallSet, Basic) {
+    t_set set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(0, set.size());
+    EXPECT_TRUE(set.begin() == set.end());
+
+    EXPECT_TRUE(set.insert(3));
+    EXPECT_TRUE(set.insert(1));
+    EXPECT_FALSE(set.insert(3));
+    EXPECT_TRUE(set.insert(2));
+
+    EXPECT_FALSE(set.empty());
+    EXPECT_EQ(3, set.size());
+    EXPECT_TRUE(set.contains(1));
+    EXPECT_FALSE(set.contains(4));
+    EXPECT_EQ(2, *set.find(2));
+    EXPECT_TRUE(set.find(0) == set.end());
+    EXPECT_EQ(2, *set.lower_bound(2));
+    EXPECT_EQ(3, *set.upper_bound(2));
+    EXPECT_EQ(2, set.countRange(2, 5));
+
+    std::vector<int> elements(set.begin(), set.end());
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), elements);
+}
+
+TEST(SmallSet, Upgrade) {
+    const int N = 1000;
+    t_set set;
+    std::set<int> expected;
+    for (int i = 0; i < N; ++i) {
+        int value = (i * 7919) % 257;
+        EXPECT_EQ(expected.insert(value).second, set.insert(value));
+        EXPECT_EQ(expected.size(), set.size());
+    }
+    EXPECT_TRUE(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+    EXPECT_EQ(*expected.lower_bound(100), *set.lower_bound(100));
+    EXPECT_EQ(static_cast<std::size_t>(std::distance(expected.lower_bound(10), expected.upper_bound(20))),
+            set.countRange(10, 20));
+
+    std::size_t count = 0;
+    for (const auto& chunk : set.getChunks(5)) {
+        count += std::distance(chunk.begin(), chunk.end());
+    }
+    EXPECT_EQ(expected.size(), count);
+
+    // a cleared set stores its elements inline again
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_TRUE(set.insert(5));
+    EXPECT_EQ(1, set.size());
+    EXPECT_EQ(5, *set.begin());
+}
+
+TEST(SmallMultiset, Basic) {
+    t_multiset set;
+    std::multiset<int> expected;
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(set.insert(i % 3));
+        expected.insert(i % 3);
+        EXPECT_TRUE(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+    }
+    EXPECT_EQ(expected.count(1), set.countRange(1, 1));
+}
+
+TEST(SmallSet, Parallel) {
+    const int N = 10000;
+    t_set set;
+#pragma omp parallel for
+    for (int i = 0; i < N; ++i) {
+        set.insert(i % 5000);
+    }
+    EXPECT_EQ(5000, set.size());
+    int i = 0;
+    for (const auto& cur : set) {
+        EXPECT_EQ(i, cur);
+        i++;
+    }
+}
+
+}  // namespace test
+}  // namespace souffle
@@ -17,12 +17,15 @@
 #include "tests/test.h"
 
 #include "souffle/SymbolTable.h"
+#include "souffle/utility/FileUtil.h"
 #include "souffle/utility/MiscUtil.h"
 #include <algorithm>
 #include <cstddef>
+#include <cstdio>
 #include <iostream>
 #include <random>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #ifdef _OPENMP
@@ -110,4 +113,152 @@ TEST(SymbolTable, Inserts) {
     }
 }
 
+TEST(SymbolTable, Constants) {
+    static constexpr std::string_view constants[] = {
+            std::string_view("a", 1), std::string_view("", 0), std::string_view("b\0c", 3)};
+    SymbolTable X(constants, 3);
+    EXPECT_EQ(3, X.size());
+    EXPECT_EQ(0, X.encode("a"));
+    EXPECT_EQ(1, X.encode(""));
+    EXPECT_EQ(2, X.encode(std::string("b\0c", 3)));
+    EXPECT_EQ(3, X.encode("c"));
+}
+
+TEST(SymbolTable, MemoryUsage) {
+    SymbolTable X;
+    EXPECT_EQ(0, X.size());
+    const std::size_t empty = X.getMemoryUsage();
+
+    // long symbols are accounted for, short symbols are stored within the table
+    X.encode("a");
+    EXPECT_EQ(1, X.size());
+    const std::size_t shortSymbol = X.getMemoryUsage();
+    EXPECT_LT(empty, shortSymbol);
+    const std::string symbol(1000, 'x');
+    X.encode(symbol);
+    EXPECT_EQ(2, X.size());
+#ifdef USE_COMPRESSED_SYMBOLS
+    // the symbols are coded into pages, whose first one holds both symbols
+    EXPECT_TRUE(shortSymbol <= X.getMemoryUsage());
+#else
+    EXPECT_LT(shortSymbol + symbol.size(), X.getMemoryUsage());
+#endif
+}
+
+TEST(SymbolTable, EncodeBatch) {
+    SymbolTable X;
+    const std::string line = "alpha,beta,alpha,gamma";
+
+    // views into a larger buffer are encoded like the strings they refer to
+    std::vector<std::string_view> symbols;
+    std::size_t start = 0;
+    for (std::size_t end = line.find(','); start <= line.size(); end = line.find(',', start)) {
+        end = std::min(end, line.size());
+        symbols.push_back(std::string_view(line).substr(start, end - start));
+        start = end + 1;
+    }
+    std::vector<RamDomain> indices(symbols.size());
+    X.encodeBatch(symbols.begin(), symbols.end(), indices.begin());
+
+    EXPECT_EQ(3, X.size());
+    EXPECT_EQ(indices[0], indices[2]);
+    EXPECT_NE(indices[0], indices[1]);
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        EXPECT_EQ(std::string(symbols[i]), X.decode(indices[i]));
+        EXPECT_EQ(indices[i], X.encode(std::string(symbols[i])));
+    }
+    EXPECT_TRUE(X.weakContains(std::string_view("beta")));
+    EXPECT_FALSE(X.weakContains(std::string_view("delta")));
+}
+
+TEST(SymbolTable, SaveAttach) {
+    const std::string fileName = tempFile();
+    SymbolTable X({"a", "b", "c"});
+    X.save(fileName);
+
+    // a fresh table keeps the indices of the file
+    SymbolTable Y;
+    const auto& identity = Y.attach(fileName);
+    EXPECT_EQ(3, identity.size());
+    for (RamDomain i = 0; i < 3; ++i) {
+        EXPECT_EQ(i, identity[i]);
+        EXPECT_EQ(X.decode(i), Y.decode(i));
+    }
+
+    // other tables translate the indices of the file
+    SymbolTable Z({"c", "d"});
+    const auto& translation = Z.attach(fileName);
+    EXPECT_EQ(4, Z.size());
+    for (RamDomain i = 0; i < 3; ++i) {
+        EXPECT_EQ(X.decode(i), Z.decode(translation[i]));
+    }
+    EXPECT_EQ(Z.encode("c"), translation[2]);
+    EXPECT_EQ(&translation, &Z.attach(fileName));
+
+    std::remove(fileName.c_str());
+}
+
+TEST(SymbolTable, Swap) {
+    SymbolTable X({"a", "b", "c"});
+    SymbolTable Y({"c"});
+    X.swap(Y);
+
+    EXPECT_EQ(1, X.size());
+    EXPECT_EQ(3, Y.size());
+    EXPECT_EQ("c", X.decode(0));
+    EXPECT_EQ(2, Y.encode("c"));
+    EXPECT_TRUE(Y.weakContains("a"));
+    EXPECT_FALSE(X.weakContains("a"));
+
+    // both tables keep growing after the swap
+    EXPECT_EQ(1, X.encode("d"));
+    EXPECT_EQ(3, Y.encode("d"));
+    EXPECT_EQ("d", X.decode(1));
+}
+
+TEST(SymbolTable, Compare) {
+    // symbols sharing the bytes of their sort keys, of bytes above 0x7f, and holding zero bytes
+    std::vector<std::string> symbols = {"", "a", "ab", "abcdefg", "abcdefgh", "abcdefgi", "abcdefg\xff",
+            "b", "\xe9t\xe9", "z", std::string("a\0", 2), std::string("a\0b", 3), "abcdef", "abcdeg"};
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> length(0, 12);
+    std::uniform_int_distribution<int> letter('a', 'c');
+    for (int i = 0; i < 200; ++i) {
+        std::string symbol(length(gen), ' ');
+        for (auto& c : symbol) {
+            c = static_cast<char>(letter(gen));
+        }
+        symbols.push_back(symbol);
+    }
+
+    SymbolTable X;
+    std::vector<RamDomain> indices;
+    for (const auto& symbol : symbols) {
+        indices.push_back(X.encode(symbol));
+    }
+    auto sign = [](int x) { return (x > 0) - (x < 0); };
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        for (std::size_t j = 0; j < symbols.size(); ++j) {
+            EXPECT_EQ(sign(symbols[i].compare(symbols[j])), sign(X.compare(indices[i], indices[j])));
+        }
+    }
+}
+
+TEST(SymbolTable, ParallelCompare) {
+    SymbolTable X;
+    const RamDomain N = 3000;
+    for (RamDomain i = 0; i < N; ++i) {
+        // in the reverse order of their indices
+        X.encode(std::to_string(2 * N - i));
+    }
+    std::size_t failures = 0;
+#pragma omp parallel for reduction(+ : failures)
+    for (RamDomain i = 0; i < N - 1; ++i) {
+        if (X.compare(i, i + 1) <= 0 || X.compare(i + 1, i) >= 0) {
+            ++failures;
+        }
+    }
+    EXPECT_EQ(0, failures);
+}
+
 }  // namespace souffle::test
@@ -16,12 +16,17 @@
 
 #include "tests/test.h"
 
+#include "souffle/RamTypes.h"
 #include "souffle/utility/CacheUtil.h"
 #include "souffle/utility/ContainerUtil.h"
+#include "souffle/utility/EvaluatorUtil.h"
 #include "souffle/utility/FunctionalUtil.h"
+#include "souffle/utility/RegexUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include "souffle/utility/StringUtil.h"
 #include <algorithm>
+#include <cstddef>
+#include <limits>
 #include <map>
 #include <set>
 #include <string>
@@ -257,3 +262,69 @@ TEST(Util, Range) {
         EXPECT_EQ(last, 8);
     }
 }
+
+TEST(Util, StringBuilder) {
+    using souffle::evaluator::StringBuilder;
+
+    // a builder used within the construction of another one keeps the content of the outer one
+    auto inner = [](std::string_view str) {
+        StringBuilder builder;
+        return std::string(builder.append("<").append(str).append(">").view());
+    };
+    StringBuilder outer;
+    outer.append("a").append(inner("b")).appendNumber(-42).appendNumber(7u);
+    EXPECT_EQ("a<b>-427", std::string(outer.view()));
+    outer.appendNumber(true).appendNumber(0.5);
+    EXPECT_EQ("a<b>-4271" + std::to_string(0.5), std::string(outer.view()));
+
+    // a builder starts empty, following the content of the enclosing builders
+    EXPECT_EQ("", std::string(StringBuilder().view()));
+}
+
+TEST(Util, CachedRegex) {
+    using namespace souffle::evaluator;
+
+    const CompiledRegex& regex = getCachedRegex("a(b|c)*");
+    EXPECT_TRUE(regex.has_value());
+    EXPECT_TRUE(std::regex_match("abcb", *regex));
+    EXPECT_FALSE(std::regex_match("abd", *regex));
+
+    // the same pattern is compiled once per thread
+    EXPECT_EQ(&regex, &getCachedRegex("a(b|c)*"));
+
+    // malformed patterns are cached as well
+    EXPECT_FALSE(getCachedRegex("a(b").has_value());
+    EXPECT_FALSE(compileRegex("*").has_value());
+    EXPECT_TRUE(compileRegex("[0-9]+").has_value());
+}
+
+/** Whether the values of a range equal the values of all parts of the range in order */
+template <typename A>
+bool rangePartsMatch(A from, A to, A step) {
+    using namespace souffle::evaluator;
+
+    std::vector<A> expected;
+    runRange(from, to, step, [&](auto&& tuple) { expected.push_back(ramBitCast<A>(tuple[0])); });
+    const std::size_t size = rangeSize(from, to, step);
+
+    const std::size_t parts = rangePartCount(size);
+    std::vector<A> values;
+    for (std::size_t part = 0; part < parts; ++part) {
+        runRangePart(from, step, size, part, parts,
+                [&](auto&& tuple) { values.push_back(ramBitCast<A>(tuple[0])); });
+    }
+    return expected.size() == size && parts <= RANGE_PARTS && expected == values;
+}
+
+TEST(Util, RangeParts) {
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(0, 10, 1));
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(0, 10, 3));
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(10, -5, -4));
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(5, 5, 1));
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(0, 10, -1));
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(-3, 100000, 7));
+    const RamSigned max = std::numeric_limits<RamSigned>::max();
+    EXPECT_TRUE(rangePartsMatch<RamSigned>(max - 10, max, 5));
+    EXPECT_TRUE(rangePartsMatch<RamUnsigned>(0, 5000, 2));
+    EXPECT_TRUE(rangePartsMatch<RamUnsigned>(20, 2, RamUnsigned(-3)));
+}
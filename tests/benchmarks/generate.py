@@ -0,0 +1,166 @@
+"""
+Souffle - A Datalog Compiler
+Copyright (c) 2021, The Souffle Developers. All rights reserved
+Licensed under the Universal Permissive License v 1.0 as shown at:
+- https://opensource.org/licenses/UPL
+- <souffle root>/licenses/SOUFFLE-UPL.txt
+
+Generates the input facts of the evaluation benchmarks.
+
+Usage: generate.py [--scale N] [--seed S] [--benchmarks a,b,...] OUTPUT_DIR
+
+The facts of each benchmark are written to OUTPUT_DIR/<benchmark>/, and
+grow linearly with the scale factor. The generators are deterministic for
+a seed, such that results of different Souffle versions are comparable.
+"""
+
+import argparse
+import os
+import random
+
+
+def skewed(rng, n, exponent=3.0):
+    """A value in [0, n) following a power law, such that small values are frequent"""
+    return min(int(n * rng.random() ** exponent), n - 1)
+
+
+def write(directory, name, rows):
+    with open(os.path.join(directory, name + ".facts"), "w") as facts:
+        for row in rows:
+            facts.write("\t".join(str(value) for value in row) + "\n")
+
+
+def points_to(rng, scale, directory):
+    """A program of methods whose variables are assigned within and passed across methods"""
+    variables = 20000 * scale
+    heaps = 2000 * scale
+    fields = 50
+    var = lambda i: "v%d" % i
+    write(directory, "New", ((var(rng.randrange(variables)), "h%d" % h) for h in range(heaps)))
+    # assignments are mostly local, within blocks of variables of a method
+    assign = set()
+    for _ in range(3 * variables // 2):
+        source = rng.randrange(variables)
+        target = source + rng.randrange(-30, 30) if rng.random() < 0.9 else rng.randrange(variables)
+        assign.add((var(min(max(target, 0), variables - 1)), var(source)))
+    write(directory, "Assign", sorted(assign))
+    field = lambda: "f%d" % skewed(rng, fields)
+    write(directory, "Load",
+            ((var(rng.randrange(variables)), var(rng.randrange(variables)), field()) for _ in range(variables // 4)))
+    write(directory, "Store",
+            ((var(rng.randrange(variables)), field(), var(rng.randrange(variables))) for _ in range(variables // 4)))
+
+
+def transitive_closure(rng, scale, directory):
+    """A mostly acyclic graph whose edges mostly lead from and to hubs"""
+    nodes = 1500 * scale
+    edges = set()
+    while len(edges) < 3 * nodes:
+        a = skewed(rng, nodes)
+        b = rng.randrange(nodes)
+        # few edges lead backwards, such that cycles are rare
+        if a < b or rng.random() < 0.001:
+            edges.add((a, b))
+    write(directory, "Edge", sorted(edges))
+
+
+def unification(rng, scale, directory):
+    """Terms of a few constructors, with constraints between terms of small classes"""
+    terms = 40000 * scale
+    constructors = ["f", "g", "h", "pair", "list"]
+    write(directory, "Constructor", ((t, rng.choice(constructors)) for t in range(terms)))
+    # terms have arguments among the smaller terms, such that terms form trees
+    args = []
+    for t in range(terms // 2, terms):
+        for position in range(rng.randrange(3)):
+            args.append((t, position, rng.randrange(t)))
+    write(directory, "Arg", args)
+    # constraints unify terms within groups of neighbouring terms, keeping classes small
+    write(directory, "Constraint",
+            ((t, min(t + rng.randrange(1, 8), terms - 1)) for t in rng.sample(range(terms), terms // 10)))
+
+
+def shortest_paths(rng, scale, directory):
+    """A road network like grid with random weights and a few long shortcuts"""
+    side = int(100 * scale ** 0.5)
+    node = lambda x, y: x * side + y
+    edges = []
+    for x in range(side):
+        for y in range(side):
+            if x + 1 < side:
+                edges.append((node(x, y), node(x + 1, y), rng.randrange(1, 100)))
+                edges.append((node(x + 1, y), node(x, y), rng.randrange(1, 100)))
+            if y + 1 < side:
+                edges.append((node(x, y), node(x, y + 1), rng.randrange(1, 100)))
+                edges.append((node(x, y + 1), node(x, y), rng.randrange(1, 100)))
+    for _ in range(side * side // 50):
+        edges.append((rng.randrange(side * side), rng.randrange(side * side), rng.randrange(200, 2000)))
+    write(directory, "Edge", edges)
+    write(directory, "Source", [(node(0, 0),), (node(side // 2, side // 2),)])
+
+
+def aggregates(rng, scale, directory):
+    """Sales of items at stores over days, with popular items and busy stores"""
+    stores = 200 * scale
+    items = 5000
+    days = 365
+    write(directory, "Region", ((s, "r%d" % (s % 17)) for s in range(stores)))
+    write(directory, "Sale",
+            ((skewed(rng, stores, 2.0), skewed(rng, items), rng.randrange(days), rng.randrange(1, 1000))
+                    for _ in range(200000 * scale)))
+
+
+def adt_records(rng, scale, directory):
+    """Expression trees of shared subexpressions, over few variables"""
+    nodes = 30000 * scale
+    variables = 100
+    rows = []
+    for i in range(nodes):
+        leaf = i < nodes // 10 or rng.random() < 0.3
+        if leaf:
+            # constants 0 and 1 are frequent, such that expressions simplify
+            if rng.random() < 0.5:
+                rows.append((i, "num", rng.choice([0, 1, rng.randrange(100)]), 0))
+            else:
+                rows.append((i, "var", rng.randrange(variables), 0))
+        else:
+            # operands are recent nodes, such that trees stay shallow but large
+            a = max(i - 1 - skewed(rng, min(i, 1000)), 0)
+            b = max(i - 1 - skewed(rng, min(i, 1000)), 0)
+            rows.append((i, rng.choice(["add", "mul"]), a, b))
+    write(directory, "Node", rows)
+    write(directory, "Binding", ((v, rng.randrange(-10, 10)) for v in range(variables)))
+
+
+GENERATORS = {
+    "points_to": points_to,
+    "transitive_closure": transitive_closure,
+    "unification": unification,
+    "shortest_paths": shortest_paths,
+    "aggregates": aggregates,
+    "adt_records": adt_records,
+}
+
+
+def generate(benchmark, scale, seed, output):
+    directory = os.path.join(output, benchmark)
+    os.makedirs(directory, exist_ok=True)
+    GENERATORS[benchmark](random.Random("%s-%d" % (benchmark, seed)), scale, directory)
+    return directory
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the facts of the evaluation benchmarks")
+    parser.add_argument("output", help="directory to write the facts of each benchmark to")
+    parser.add_argument("--scale", type=int, default=1, help="scale factor of the facts (default 1)")
+    parser.add_argument("--seed", type=int, default=0, help="seed of the generators (default 0)")
+    parser.add_argument("--benchmarks", default=",".join(GENERATORS), help="comma separated benchmarks")
+    args = parser.parse_args()
+    for benchmark in args.benchmarks.split(","):
+        if benchmark not in GENERATORS:
+            parser.error("unknown benchmark " + benchmark)
+        print(generate(benchmark, args.scale, args.seed, args.output))
+
+
+if __name__ == "__main__":
+    main()
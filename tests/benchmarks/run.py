@@ -0,0 +1,188 @@
+"""
+Souffle - A Datalog Compiler
+Copyright (c) 2021, The Souffle Developers. All rights reserved
+Licensed under the Universal Permissive License v 1.0 as shown at:
+- https://opensource.org/licenses/UPL
+- <souffle root>/licenses/SOUFFLE-UPL.txt
+
+Runs the evaluation benchmarks and tracks their performance.
+
+Usage: run.py --souffle PATH [--benchmarks a,b,...] [--scales 1,2,4]
+              [--modes interpreter,compiled] [--jobs N] [--repetitions N]
+              [--work DIR] [--out FILE] [--compare FILE] [--threshold X]
+
+Each benchmark is run on the facts generated at each scale factor, by the
+interpreter and as a compiled program. A run records its wall time, the
+peak resident memory of the evaluating process, the sizes of the printed
+relations, and, from its profile, the time of each stratum. The median of
+the repetitions is reported on the console and written as JSON to --out.
+
+Given --compare with the results of an earlier run, e.g. of the previous
+release, runs that became slower, or took more memory, by more than the
+threshold (default 0.1, i.e. 10%), or whose relation sizes changed are
+reported, and the script exits with an error.
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+import time
+
+import generate
+
+BENCHMARKS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def execute(command, cwd):
+    """Run the command, returning its output, wall time in seconds and peak resident memory in kilobytes"""
+    with open(os.path.join(cwd, "stdout.txt"), "w+") as stdout, open(os.path.join(cwd, "stderr.txt"), "w+") as stderr:
+        start = time.monotonic()
+        process = subprocess.Popen(command, cwd=cwd, stdout=stdout, stderr=stderr)
+        _, status, usage = os.wait4(process.pid, 0)
+        wall = time.monotonic() - start
+        process.returncode = os.waitstatus_to_exitcode(status)
+        stdout.seek(0)
+        stderr.seek(0)
+        if process.returncode != 0:
+            sys.exit("Command %s failed:\n%s" % (" ".join(command), stderr.read()))
+        # ru_maxrss is in kilobytes on Linux, but in bytes on macOS
+        rss = usage.ru_maxrss // 1024 if platform.system() == "Darwin" else usage.ru_maxrss
+        return stdout.read(), wall, rss
+
+
+def sizes(output):
+    """The sizes of the relations printed by .printsize"""
+    return {name: int(size) for name, size in re.findall(r"^(\S+)\t(\d+)$", output, re.MULTILINE)}
+
+
+def strata(profile):
+    """
+    The strata of a profile, as the relations evaluated together and the time
+    of their evaluation in seconds.
+
+    Profiles record the evaluation time of each relation, and of each
+    iteration of recursive relations, but not their strata. As strata are
+    evaluated one after the other, relations whose evaluation overlaps in
+    time are of the same stratum.
+    """
+    spans = []
+    for name, relation in profile["root"]["program"].get("relation", {}).items():
+        times = [relation["runtime"]] if "runtime" in relation else []
+        times += [i["runtime"] for i in relation.get("iteration", {}).values() if "runtime" in i]
+        if times:
+            spans.append((min(t["start"] for t in times), max(t["end"] for t in times), name))
+    result = []
+    for start, end, name in sorted(spans):
+        if result and start < result[-1]["end"]:
+            result[-1]["end"] = max(result[-1]["end"], end)
+            result[-1]["relations"].append(name)
+        else:
+            result.append({"start": start, "end": end, "relations": [name]})
+    return [{"relations": sorted(s["relations"]), "time": (s["end"] - s["start"]) / 1e6} for s in result]
+
+
+def run(args, benchmark, scale, mode, facts):
+    """Run a benchmark in a mode, returning the median of its repetitions"""
+    work = os.path.join(args.work, "%s-%d-%s" % (benchmark, scale, mode))
+    os.makedirs(work, exist_ok=True)
+    program = os.path.join(BENCHMARKS_DIR, benchmark, benchmark + ".dl")
+    profile = os.path.join(work, "profile.json")
+    jobs = "-j%d" % args.jobs
+    if mode == "compiled":
+        executable = os.path.join(work, benchmark)
+        execute([args.souffle, "-p", profile, "-o", executable, program], work)
+        command = [executable, "-F", facts, "-D", work, "-p", profile, jobs]
+    else:
+        command = [args.souffle, "-F", facts, "-D", work, "-p", profile, jobs, program]
+
+    runs = []
+    for _ in range(args.repetitions):
+        output, wall, rss = execute(command, work)
+        with open(profile) as file:
+            runs.append({"wall": wall, "rss": rss, "sizes": sizes(output), "strata": strata(json.load(file))})
+    median = sorted(runs, key=lambda r: r["wall"])[len(runs) // 2]
+    return {
+        "benchmark": benchmark,
+        "scale": scale,
+        "mode": mode,
+        "repetitions": args.repetitions,
+        "wall": median["wall"],
+        "rss": int(statistics.median(r["rss"] for r in runs)),
+        "sizes": median["sizes"],
+        "strata": median["strata"],
+    }
+
+
+def key(result):
+    return "%s/scale:%d/%s" % (result["benchmark"], result["scale"], result["mode"])
+
+
+def compare(results, baseline, threshold):
+    """Report the regressions of the results against the baseline, returning whether there are none"""
+    previous = {key(r): r for r in baseline["results"]}
+    passed = True
+    for result in results:
+        if key(result) not in previous:
+            continue
+        old = previous[key(result)]
+        for metric, unit in (("wall", "s"), ("rss", "kB")):
+            if result[metric] > old[metric] * (1 + threshold):
+                print("REGRESSION %s: %s %.2f%s -> %.2f%s (%+.1f%%)" % (key(result), metric, old[metric], unit,
+                        result[metric], unit, 100 * (result[metric] / old[metric] - 1)))
+                passed = False
+        if result["sizes"] != old["sizes"]:
+            print("MISMATCH %s: relation sizes %s -> %s" % (key(result), old["sizes"], result["sizes"]))
+            passed = False
+    return passed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the evaluation benchmarks")
+    parser.add_argument("--souffle", required=True, help="the souffle executable")
+    parser.add_argument("--benchmarks", default=",".join(generate.GENERATORS), help="comma separated benchmarks")
+    parser.add_argument("--scales", default="1,2,4", help="comma separated scale factors (default 1,2,4)")
+    parser.add_argument("--modes", default="interpreter,compiled", help="interpreter and/or compiled")
+    parser.add_argument("--jobs", type=int, default=1, help="number of threads of the evaluation (default 1)")
+    parser.add_argument("--repetitions", type=int, default=3, help="number of runs per benchmark (default 3)")
+    parser.add_argument("--work", default="benchmark-work", help="directory of facts, programs and outputs")
+    parser.add_argument("--out", help="file to write the results to as JSON")
+    parser.add_argument("--compare", help="results of an earlier run to detect regressions against")
+    parser.add_argument("--threshold", type=float, default=0.1, help="tolerated relative slowdown (default 0.1)")
+    args = parser.parse_args()
+    args.souffle = os.path.abspath(args.souffle)
+    args.work = os.path.abspath(args.work)
+
+    results = []
+    for benchmark in args.benchmarks.split(","):
+        if benchmark not in generate.GENERATORS:
+            parser.error("unknown benchmark " + benchmark)
+        for scale in (int(s) for s in args.scales.split(",")):
+            facts = generate.generate(benchmark, scale, 0, os.path.join(args.work, "facts-%d" % scale))
+            for mode in args.modes.split(","):
+                if mode not in ("interpreter", "compiled"):
+                    parser.error("unknown mode " + mode)
+                result = run(args, benchmark, scale, mode, facts)
+                results.append(result)
+                slowest = max(result["strata"], key=lambda s: s["time"], default=None)
+                print("%-48s %10.3f s %10d kB   slowest stratum: %s" % (key(result), result["wall"], result["rss"],
+                        "%s (%.3f s)" % (",".join(slowest["relations"]), slowest["time"]) if slowest else "-"))
+                sys.stdout.flush()
+
+    if args.out:
+        context = {"date": time.strftime("%Y-%m-%dT%H:%M:%S"), "host": platform.node(), "jobs": args.jobs,
+                "souffle": subprocess.run([args.souffle, "--version"], capture_output=True, text=True).stdout.strip()}
+        with open(args.out, "w") as file:
+            json.dump({"context": context, "results": results}, file, indent=2)
+    if args.compare:
+        with open(args.compare) as file:
+            if not compare(results, json.load(file), args.threshold):
+                sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
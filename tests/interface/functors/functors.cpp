@@ -20,6 +20,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <unordered_map>
 
 #if RAM_DOMAIN_SIZE == 64
 using FF_int = int64_t;
@@ -135,4 +136,41 @@ souffle::RamDomain my_to_number_fun(
 souffle::RamDomain my_identity(souffle::SymbolTable*, souffle::RecordTable*, souffle::RamDomain arg) {
     return arg;
 }
+
+// Squares remembered by a thread, such that repeated arguments are looked up
+using SquareCache = std::unordered_map<souffle::RamDomain, souffle::RamDomain>;
+
+void* memo_square_init() {
+    return new SquareCache();
+}
+
+void memo_square_fini(void* context) {
+    delete static_cast<SquareCache*>(context);
+}
+
+souffle::RamDomain memo_square(
+        souffle::SymbolTable*, souffle::RecordTable*, void* context, souffle::RamDomain arg) {
+    assert(context && "NULL functor context");
+    auto& cache = *static_cast<SquareCache*>(context);
+    auto pos = cache.find(arg);
+    if (pos == cache.end()) {
+        pos = cache.emplace(arg, arg * arg).first;
+    }
+    return pos->second;
+}
+
+// Functors whose results are cached
+FF_float cached_scale(FF_float x, FF_int n) {
+    return x * n;
+}
+
+const char* cached_parity(const char* s) {
+    return (s[strlen(s) - 1] - '0') % 2 == 0 ? "even" : "odd";
+}
+
+souffle::RamDomain cached_cat(souffle::SymbolTable* symbolTable, souffle::RecordTable*,
+        souffle::RamDomain arg1, souffle::RamDomain arg2) {
+    assert(symbolTable && "NULL symbol table");
+    return symbolTable->encode(symbolTable->decode(arg1) + symbolTable->decode(arg2));
+}
 }  // end of extern "C"
@@ -0,0 +1,58 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2021, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file driver.cpp
+ *
+ * Driver program inserting values beyond the bounds of the program into
+ * relations of a program compiled with narrow columns
+ *
+ ***********************************************************************/
+
+#include "souffle/SouffleInterface.h"
+#include <iostream>
+#include <string>
+
+using namespace souffle;
+
+/**
+ * Error handler
+ */
+void error(std::string txt) {
+    std::cerr << "error: " << txt << "\n";
+    exit(1);
+}
+
+/**
+ * Main program
+ */
+int main(int /* argc */, char** /* argv */) {
+    if (SouffleProgram* prog = ProgramFactory::newInstance("insert_narrow")) {
+        Relation* base = prog->getRelation("base");
+        Relation* path = prog->getRelation("path");
+        if (base == nullptr || path == nullptr) {
+            error("cannot find relations base and path");
+        }
+
+        // a relation read by the program, and one derived by it
+        tuple edge(base);
+        edge << 3 << 70000;
+        base->insert(edge);
+        tuple negative(path);
+        negative << 100000 << -5;
+        path->insert(negative);
+
+        prog->run();
+        prog->printAll();
+
+        delete prog;
+    } else {
+        error("cannot find program insert_narrow");
+    }
+}